@@ -0,0 +1,102 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+
+#include "Eigen/Core"
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/formats/matrix.h"
+#include "mediapipe/framework/formats/time_series_header.pb.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/util/calculator_benchmark.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr double kSampleRate = 48000.0;
+constexpr int kPacketSamples = 4800;  // 100ms packets.
+constexpr int kNumPackets = 50;
+constexpr int64 kPacketPeriodUsec = 100000;
+
+// Feeds "num_channels" channels of noise at kSampleRate to the calculator.
+void AddAudioInputs(int num_channels, CalculatorBenchmark* benchmark) {
+  auto header = absl::make_unique<TimeSeriesHeader>();
+  header->set_sample_rate(kSampleRate);
+  header->set_num_channels(num_channels);
+  benchmark->runner()->MutableInputs()->Index(0).header =
+      Adopt(header.release());
+  benchmark->GenerateInputs("", 0, kNumPackets, kPacketPeriodUsec,
+                            [num_channels](int i) {
+                              return MakePacket<Matrix>(Matrix::Random(
+                                  num_channels, kPacketSamples));
+                            });
+}
+
+// The argument is the number of channels.
+void BM_Spectrogram(benchmark::State& state) {
+  CalculatorBenchmark benchmark(R"(
+      calculator: "SpectrogramCalculator"
+      input_stream: "input_audio"
+      output_stream: "spectrogram"
+      options {
+        [mediapipe.SpectrogramCalculatorOptions.ext] {
+          frame_duration_seconds: 0.025
+          frame_overlap_seconds: 0.015
+          pad_final_packet: false
+          allow_multichannel_input: true
+        }
+      })");
+  AddAudioInputs(state.range(0), &benchmark);
+  benchmark.Run(state);
+}
+BENCHMARK(BM_Spectrogram)->Arg(1)->Arg(2);
+
+// Resamples to 16kHz, as done before most audio models. The argument is the
+// number of channels.
+void BM_RationalFactorResample(benchmark::State& state) {
+  CalculatorBenchmark benchmark(R"(
+      calculator: "RationalFactorResampleCalculator"
+      input_stream: "input_audio"
+      output_stream: "resampled_audio"
+      options {
+        [mediapipe.RationalFactorResampleCalculatorOptions.ext] {
+          target_sample_rate: 16000
+        }
+      })");
+  AddAudioInputs(state.range(0), &benchmark);
+  benchmark.Run(state);
+}
+BENCHMARK(BM_RationalFactorResample)->Arg(1)->Arg(2);
+
+void BM_TimeSeriesFramer(benchmark::State& state) {
+  CalculatorBenchmark benchmark(R"(
+      calculator: "TimeSeriesFramerCalculator"
+      input_stream: "input_audio"
+      output_stream: "frames"
+      options {
+        [mediapipe.TimeSeriesFramerCalculatorOptions.ext] {
+          frame_duration_seconds: 0.025
+          frame_overlap_seconds: 0.015
+          window_function: HANN
+        }
+      })");
+  AddAudioInputs(1, &benchmark);
+  benchmark.Run(state);
+}
+BENCHMARK(BM_TimeSeriesFramer);
+
+}  // namespace
+}  // namespace mediapipe
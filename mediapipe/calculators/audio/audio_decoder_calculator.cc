@@ -45,6 +45,12 @@ namespace mediapipe {
 //   }
 // }
 //
+// The file is decoded incrementally, one packet per Process() call, so memory
+// use does not grow with the file length. Since this is a source calculator,
+// the graph's max_queue_size throttles it when downstream nodes fall behind.
+// Set audio_stream.output_chunk_samples to get fixed size packets, and
+// seek_to_start_time to skip decoding the audio before start_time.
+//
 // TODO: support decoding multiple streams.
 class AudioDecoderCalculator : public CalculatorBase {
  public:
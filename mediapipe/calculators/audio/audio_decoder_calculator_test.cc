@@ -14,9 +14,11 @@
 
 #include "mediapipe/framework/calculator_runner.h"
 #include "mediapipe/framework/deps/file_path.h"
+#include "mediapipe/framework/formats/matrix.h"
 #include "mediapipe/framework/formats/time_series_header.pb.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/parse_text_proto.h"
 #include "mediapipe/framework/port/status_matchers.h"
 
@@ -146,4 +148,71 @@ TEST(AudioDecoderCalculatorTest, TestAAC) {
               std::ceil(44100.0 * 2 / 1024));
 }
 
+TEST(AudioDecoderCalculatorTest, TestFixedSizeChunks) {
+  CalculatorGraphConfig::Node node_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+        calculator: "AudioDecoderCalculator"
+        input_side_packet: "INPUT_FILE_PATH:input_file_path"
+        output_stream: "AUDIO:audio"
+        node_options {
+          [type.googleapis.com/mediapipe.AudioDecoderOptions]: {
+            audio_stream { stream_index: 0 output_chunk_samples: 1000 }
+          }
+        })");
+  CalculatorRunner runner(node_config);
+  runner.MutableSidePackets()->Tag("INPUT_FILE_PATH") = MakePacket<std::string>(
+      file::JoinPath("./",
+                     "/mediapipe/calculators/audio/"
+                     "testdata/sine_wave_1k_44100_mono_2_sec_wav.audio"));
+  MP_ASSERT_OK(runner.Run());
+  const std::vector<Packet>& packets = runner.Outputs().Tag("AUDIO").packets;
+  ASSERT_FALSE(packets.empty());
+  int64 num_samples = 0;
+  for (int i = 0; i < packets.size(); ++i) {
+    const Matrix& audio = packets[i].Get<Matrix>();
+    EXPECT_EQ(1, audio.rows());
+    if (i + 1 < packets.size()) {
+      EXPECT_EQ(1000, audio.cols());
+    } else {
+      EXPECT_GT(audio.cols(), 0);
+      EXPECT_LE(audio.cols(), 1000);
+    }
+    EXPECT_EQ(packets[0].Timestamp() +
+                  std::round(num_samples *
+                             Timestamp::kTimestampUnitsPerSecond / 44100.0),
+              packets[i].Timestamp());
+    num_samples += audio.cols();
+  }
+  EXPECT_NEAR(44100 * 2, num_samples, 1024);
+}
+
+TEST(AudioDecoderCalculatorTest, TestSeekToStartTime) {
+  CalculatorGraphConfig::Node node_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+        calculator: "AudioDecoderCalculator"
+        input_side_packet: "INPUT_FILE_PATH:input_file_path"
+        output_stream: "AUDIO:audio"
+        node_options {
+          [type.googleapis.com/mediapipe.AudioDecoderOptions]: {
+            audio_stream { stream_index: 0 }
+            start_time: 1.0
+            end_time: 1.5
+            seek_to_start_time: true
+          }
+        })");
+  CalculatorRunner runner(node_config);
+  runner.MutableSidePackets()->Tag("INPUT_FILE_PATH") = MakePacket<std::string>(
+      file::JoinPath("./",
+                     "/mediapipe/calculators/audio/"
+                     "testdata/sine_wave_1k_44100_mono_2_sec_wav.audio"));
+  MP_ASSERT_OK(runner.Run());
+  const std::vector<Packet>& packets = runner.Outputs().Tag("AUDIO").packets;
+  ASSERT_FALSE(packets.empty());
+  EXPECT_LT(packets.front().Timestamp(), Timestamp::FromSeconds(1.1));
+  for (const Packet& packet : packets) {
+    EXPECT_GE(packet.Timestamp(), Timestamp::FromSeconds(1.0));
+    EXPECT_LE(packet.Timestamp(), Timestamp::FromSeconds(1.5));
+  }
+}
+
 }  // namespace mediapipe
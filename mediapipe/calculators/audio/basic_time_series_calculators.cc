@@ -21,6 +21,8 @@
 #include "Eigen/Core"
 #include "absl/strings/str_cat.h"
 #include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/port/statusor.h"
 #include "mediapipe/util/time_series_util.h"
 
 namespace mediapipe {
@@ -79,6 +81,32 @@ static bool SafeMultiply(int x, int y, int* result) {
   return ::mediapipe::OkStatus();
 }
 
+::mediapipe::Status InPlaceTimeSeriesCalculatorBase::Process(
+    CalculatorContext* cc) {
+  Packet& input_packet = cc->Inputs().Index(0).Value();
+  MP_RETURN_IF_ERROR(time_series_util::IsMatrixShapeConsistentWithHeader(
+      input_packet.Get<Matrix>(),
+      cc->Inputs().Index(0).Header().Get<TimeSeriesHeader>()));
+
+  // Takes ownership of the input Matrix unless another calculator or sink
+  // also holds the packet.
+  ASSIGN_OR_RETURN(std::unique_ptr<Matrix> output,
+                   input_packet.ConsumeOrCopy<Matrix>());
+  ProcessMatrixInPlace(output.get());
+  MP_RETURN_IF_ERROR(time_series_util::IsMatrixShapeConsistentWithHeader(
+      *output, cc->Outputs().Index(0).Header().Get<TimeSeriesHeader>()));
+
+  cc->Outputs().Index(0).Add(output.release(), cc->InputTimestamp());
+  return ::mediapipe::OkStatus();
+}
+
+Matrix InPlaceTimeSeriesCalculatorBase::ProcessMatrix(
+    const Matrix& input_matrix) {
+  Matrix output = input_matrix;
+  ProcessMatrixInPlace(&output);
+  return output;
+}
+
 // Calculator to sum an input time series across channels.  This is
 // useful for e.g. computing 'summary SAI' pitchogram features.
 //
@@ -145,10 +173,10 @@ REGISTER_CALCULATOR(SummarySaiToPitchogramCalculator);
 // opposite convention to the hearing filterbanks.
 //
 // Options proto: None.
-class ReverseChannelOrderCalculator : public BasicTimeSeriesCalculatorBase {
+class ReverseChannelOrderCalculator : public InPlaceTimeSeriesCalculatorBase {
  protected:
-  Matrix ProcessMatrix(const Matrix& input_matrix) final {
-    return input_matrix.colwise().reverse();
+  void ProcessMatrixInPlace(Matrix* matrix) final {
+    matrix->colwise().reverseInPlace();
   }
 };
 REGISTER_CALCULATOR(ReverseChannelOrderCalculator);
@@ -195,11 +223,11 @@ REGISTER_CALCULATOR(FlattenPacketCalculator);
 // corresponding channel.
 //
 // Options proto: None.
-class SubtractMeanCalculator : public BasicTimeSeriesCalculatorBase {
+class SubtractMeanCalculator : public InPlaceTimeSeriesCalculatorBase {
  protected:
-  Matrix ProcessMatrix(const Matrix& input_matrix) final {
-    Matrix mean = input_matrix.rowwise().mean();
-    return input_matrix - mean.replicate(1, input_matrix.cols());
+  void ProcessMatrixInPlace(Matrix* matrix) final {
+    const Eigen::VectorXf mean = matrix->rowwise().mean();
+    matrix->colwise() -= mean;
   }
 };
 REGISTER_CALCULATOR(SubtractMeanCalculator);
@@ -209,11 +237,11 @@ REGISTER_CALCULATOR(SubtractMeanCalculator);
 //
 // Options proto: None.
 class SubtractMeanAcrossChannelsCalculator
-    : public BasicTimeSeriesCalculatorBase {
+    : public InPlaceTimeSeriesCalculatorBase {
  protected:
-  Matrix ProcessMatrix(const Matrix& input_matrix) final {
-    auto mean = input_matrix.mean();
-    return (input_matrix.array() - mean).matrix();
+  void ProcessMatrixInPlace(Matrix* matrix) final {
+    const float mean = matrix->mean();
+    matrix->array() -= mean;
   }
 };
 REGISTER_CALCULATOR(SubtractMeanAcrossChannelsCalculator);
@@ -228,13 +256,13 @@ REGISTER_CALCULATOR(SubtractMeanAcrossChannelsCalculator);
 //
 // Options proto: None.
 class DivideByMeanAcrossChannelsCalculator
-    : public BasicTimeSeriesCalculatorBase {
+    : public InPlaceTimeSeriesCalculatorBase {
  protected:
-  Matrix ProcessMatrix(const Matrix& input_matrix) final {
-    auto mean = input_matrix.mean();
+  void ProcessMatrixInPlace(Matrix* matrix) final {
+    const float mean = matrix->mean();
 
     if (mean != 0) {
-      return input_matrix / mean;
+      *matrix /= mean;
 
       // When used with nonnegative matrices, the mean will only be zero if the
       // entire matrix is exactly zero. If mean is exactly zero, the output will
@@ -242,7 +270,7 @@ class DivideByMeanAcrossChannelsCalculator
       // where
       // all values are equal.
     } else {
-      return Matrix::Ones(input_matrix.rows(), input_matrix.cols());
+      matrix->setOnes();
     }
   }
 };
@@ -327,10 +355,10 @@ REGISTER_CALCULATOR(L2NormCalculator);
 // Calculator to convert each column of a matrix to a unit vector.
 //
 // Options proto: None.
-class L2NormalizeColumnCalculator : public BasicTimeSeriesCalculatorBase {
+class L2NormalizeColumnCalculator : public InPlaceTimeSeriesCalculatorBase {
  protected:
-  Matrix ProcessMatrix(const Matrix& input_matrix) final {
-    return input_matrix.colwise().normalized();
+  void ProcessMatrixInPlace(Matrix* matrix) final {
+    matrix->colwise().normalize();
   }
 };
 REGISTER_CALCULATOR(L2NormalizeColumnCalculator);
@@ -339,15 +367,15 @@ REGISTER_CALCULATOR(L2NormalizeColumnCalculator);
 //
 // Returns the matrix as is if the RMS is <= 1E-8.
 // Options proto: None.
-class L2NormalizeCalculator : public BasicTimeSeriesCalculatorBase {
+class L2NormalizeCalculator : public InPlaceTimeSeriesCalculatorBase {
  protected:
-  Matrix ProcessMatrix(const Matrix& input_matrix) final {
+  void ProcessMatrixInPlace(Matrix* matrix) final {
     constexpr double kEpsilon = 1e-8;
-    double rms = std::sqrt(input_matrix.array().square().mean());
+    double rms = std::sqrt(matrix->array().square().mean());
     if (rms <= kEpsilon) {
-      return input_matrix;
+      return;
     }
-    return input_matrix / rms;
+    *matrix /= rms;
   }
 };
 REGISTER_CALCULATOR(L2NormalizeCalculator);
@@ -356,15 +384,15 @@ REGISTER_CALCULATOR(L2NormalizeCalculator);
 //
 // Returns the matrix as is if the peak is <= 1E-8.
 // Options proto: None.
-class PeakNormalizeCalculator : public BasicTimeSeriesCalculatorBase {
+class PeakNormalizeCalculator : public InPlaceTimeSeriesCalculatorBase {
  protected:
-  Matrix ProcessMatrix(const Matrix& input_matrix) final {
+  void ProcessMatrixInPlace(Matrix* matrix) final {
     constexpr double kEpsilon = 1e-8;
-    double max_pcm = input_matrix.cwiseAbs().maxCoeff();
+    double max_pcm = matrix->cwiseAbs().maxCoeff();
     if (max_pcm <= kEpsilon) {
-      return input_matrix;
+      return;
     }
-    return input_matrix / max_pcm;
+    *matrix /= max_pcm;
   }
 };
 REGISTER_CALCULATOR(PeakNormalizeCalculator);
@@ -372,10 +400,10 @@ REGISTER_CALCULATOR(PeakNormalizeCalculator);
 // Calculator to compute the elementwise square of an input time series.
 //
 // Options proto: None.
-class ElementwiseSquareCalculator : public BasicTimeSeriesCalculatorBase {
+class ElementwiseSquareCalculator : public InPlaceTimeSeriesCalculatorBase {
  protected:
-  Matrix ProcessMatrix(const Matrix& input_matrix) final {
-    return input_matrix.array().square();
+  void ProcessMatrixInPlace(Matrix* matrix) final {
+    matrix->array() = matrix->array().square();
   }
 };
 REGISTER_CALCULATOR(ElementwiseSquareCalculator);
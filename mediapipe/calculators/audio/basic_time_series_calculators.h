@@ -15,7 +15,8 @@
 // Abstract base class for basic MediaPipe calculators that operate on
 // TimeSeries streams and don't require any Options protos.
 // Subclasses must override ProcessMatrix, and optionally
-// MutateHeader.
+// MutateHeader. Subclasses whose output has the shape of their input can
+// derive from InPlaceTimeSeriesCalculatorBase instead.
 
 #ifndef MEDIAPIPE_CALCULATORS_AUDIO_BASIC_TIME_SERIES_CALCULATORS_H_
 #define MEDIAPIPE_CALCULATORS_AUDIO_BASIC_TIME_SERIES_CALCULATORS_H_
@@ -43,6 +44,23 @@ class BasicTimeSeriesCalculatorBase : public CalculatorBase {
   virtual Matrix ProcessMatrix(const Matrix& input_matrix) = 0;
 };
 
+// Abstract base class for basic calculators whose output Matrix has the same
+// shape as the input Matrix. When this calculator holds the only reference to
+// an input packet, its Matrix is transformed in place and sent downstream, so
+// no new Matrix is allocated. Otherwise the input is copied first.
+// Subclasses must override ProcessMatrixInPlace, and optionally MutateHeader.
+class InPlaceTimeSeriesCalculatorBase : public BasicTimeSeriesCalculatorBase {
+ public:
+  ::mediapipe::Status Process(CalculatorContext* cc) override;
+
+ protected:
+  // Applies ProcessMatrixInPlace to a copy of input_matrix.
+  Matrix ProcessMatrix(const Matrix& input_matrix) final;
+
+  // Process() calls this method on each packet to transform the matrix.
+  virtual void ProcessMatrixInPlace(Matrix* matrix) = 0;
+};
+
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_CALCULATORS_AUDIO_BASIC_TIME_SERIES_CALCULATORS_H_
@@ -25,6 +25,8 @@
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/tool/sink.h"
 #include "mediapipe/util/time_series_test_util.h"
 
 namespace mediapipe {
@@ -451,6 +453,65 @@ TEST_F(ElementwiseSquareCalculatorTest, SinglePacket) {
   Test(input_header, {input}, output_header, {output});
 }
 
+// Runs ElementwiseSquareCalculator on a packet whose Matrix is only referenced
+// by the graph, optionally also sending the input stream to a sink.
+void RunElementwiseSquareGraph(bool sink_input, Matrix* input_matrix,
+                               std::vector<Packet>* input_packets,
+                               std::vector<Packet>* output_packets) {
+  auto config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+    input_stream: "input"
+    node {
+      calculator: "ElementwiseSquareCalculator"
+      input_stream: "input"
+      output_stream: "output"
+    }
+  )");
+  if (sink_input) {
+    tool::AddVectorSink("input", &config, input_packets);
+  }
+  tool::AddVectorSink("output", &config, output_packets);
+  const TimeSeriesHeader header = ParseTextProtoOrDie<TimeSeriesHeader>(
+      "sample_rate: 8000.0  num_channels: 2  num_samples: 3");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(
+      graph.StartRun({}, {{"input", Adopt(new TimeSeriesHeader(header))}}));
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "input", Adopt(input_matrix).At(Timestamp(0))));
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+}
+
+TEST(InPlaceTimeSeriesCalculatorTest, ReusesUniquelyOwnedInput) {
+  Matrix* input = new Matrix(2, 3);
+  *input << 3, 5, 8, 4, 12, -15;
+  std::vector<Packet> output_packets;
+  RunElementwiseSquareGraph(/*sink_input=*/false, input, nullptr,
+                            &output_packets);
+  ASSERT_EQ(1, output_packets.size());
+  const Matrix& output = output_packets[0].Get<Matrix>();
+  EXPECT_EQ(input, &output);
+  Matrix expected(2, 3);
+  expected << 9, 25, 64, 16, 144, 225;
+  EXPECT_TRUE(output.isApprox(expected));
+}
+
+TEST(InPlaceTimeSeriesCalculatorTest, CopiesSharedInput) {
+  Matrix* input = new Matrix(2, 3);
+  *input << 3, 5, 8, 4, 12, -15;
+  const Matrix original = *input;
+  std::vector<Packet> input_packets;
+  std::vector<Packet> output_packets;
+  RunElementwiseSquareGraph(/*sink_input=*/true, input, &input_packets,
+                            &output_packets);
+  ASSERT_EQ(1, input_packets.size());
+  ASSERT_EQ(1, output_packets.size());
+  // The sink's packet must not be modified.
+  EXPECT_TRUE(input_packets[0].Get<Matrix>() == original);
+  EXPECT_TRUE(output_packets[0].Get<Matrix>().isApprox(
+      original.array().square().matrix()));
+}
+
 class FirstHalfSlicerCalculatorTest : public BasicTimeSeriesCalculatorTestBase {
  protected:
   void SetUp() override { calculator_name_ = "FirstHalfSlicerCalculator"; }
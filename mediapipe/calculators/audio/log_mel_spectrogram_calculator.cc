@@ -0,0 +1,269 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Defines LogMelSpectrogramCalculator.
+#include <math.h>
+
+#include <memory>
+#include <vector>
+
+#include "Eigen/Core"
+#include "absl/memory/memory.h"
+#include "audio/dsp/mfcc/mel_filterbank.h"
+#include "audio/dsp/spectrogram/spectrogram.h"
+#include "audio/dsp/window_functions.h"
+#include "mediapipe/calculators/audio/log_mel_spectrogram_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/matrix.h"
+#include "mediapipe/framework/formats/time_series_header.pb.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/util/time_series_util.h"
+
+namespace mediapipe {
+
+// Computes the log Mel spectrum of a single-channel waveform in one node. It
+// produces the same packets, timestamps and header as the chain
+//
+//   SpectrogramCalculator (SQUARED_MAGNITUDE)
+//     -> MelSpectrumCalculator -> StabilizedLogCalculator
+//
+// configured with spectrogram_params, mel_spectrum_params and log_params, but
+// without the two intermediate packets. Spectrogram frames go straight into
+// reused Mel filterbank buffers, each Mel frame is written into the output
+// Matrix, and the stabilized log is applied to that Matrix in place.
+//
+// Resample the waveform with RationalFactorResampleCalculator upstream if
+// needed; resampling changes the packet timing and is not fused.
+//
+// Example config:
+// node {
+//   calculator: "LogMelSpectrogramCalculator"
+//   input_stream: "resampled_waveform"
+//   output_stream: "log_mel_spectrum_magnitude"
+//   options {
+//     [mediapipe.LogMelSpectrogramCalculatorOptions.ext] {
+//       spectrogram_params {
+//         frame_duration_seconds: 0.025
+//         frame_overlap_seconds: 0.015
+//       }
+//       mel_spectrum_params {
+//         channel_count: 64
+//         min_frequency_hertz: 125.0
+//         max_frequency_hertz: 7500.0
+//       }
+//       log_params { stabilizer: 0.01 }
+//     }
+//   }
+// }
+class LogMelSpectrogramCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<Matrix>(
+        // Single-channel waveform with TimeSeriesHeader.
+    );
+    cc->Outputs().Index(0).Set<Matrix>(
+        // Log Mel spectrum frames with TimeSeriesHeader.
+    );
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override;
+  ::mediapipe::Status Process(CalculatorContext* cc) override;
+  ::mediapipe::Status Close(CalculatorContext* cc) override;
+
+ private:
+  // Same as SpectrogramCalculator::CurrentOutputTimestamp().
+  Timestamp CurrentOutputTimestamp() {
+    return initial_input_timestamp_ +
+           round(cumulative_completed_frames_ * frame_step_samples_ *
+                 Timestamp::kTimestampUnitsPerSecond / input_sample_rate_);
+  }
+
+  // Frames the samples and emits at most one packet of log Mel frames.
+  ::mediapipe::Status ProcessSamples(const Matrix& input_stream,
+                                     CalculatorContext* cc);
+
+  double input_sample_rate_;
+  int frame_duration_samples_;
+  int frame_step_samples_;
+  bool pad_final_packet_;
+  float spectrogram_scale_;
+  int num_mel_channels_;
+  float stabilizer_;
+  bool check_nonnegativity_;
+  double log_scale_;
+
+  int64 cumulative_input_samples_;
+  int64 cumulative_completed_frames_;
+  Timestamp initial_input_timestamp_;
+
+  std::unique_ptr<audio_dsp::Spectrogram> spectrogram_;
+  std::unique_ptr<audio_dsp::MelFilterbank> mel_filterbank_;
+  // Buffers reused across packets.
+  std::vector<float> input_samples_;
+  std::vector<std::vector<float>> spectrogram_frames_;
+  std::vector<double> mel_input_;
+  std::vector<double> mel_output_;
+};
+REGISTER_CALCULATOR(LogMelSpectrogramCalculator);
+
+::mediapipe::Status LogMelSpectrogramCalculator::Open(CalculatorContext* cc) {
+  const auto& options = cc->Options<LogMelSpectrogramCalculatorOptions>();
+  const SpectrogramCalculatorOptions& spectrogram_options =
+      options.spectrogram_params();
+  const MelSpectrumCalculatorOptions& mel_options =
+      options.mel_spectrum_params();
+  const StabilizedLogCalculatorOptions& log_options = options.log_params();
+
+  RET_CHECK_GT(spectrogram_options.frame_duration_seconds(), 0.0)
+      << "Invalid or missing frame_duration_seconds.";
+  RET_CHECK_GE(spectrogram_options.frame_overlap_seconds(), 0.0);
+  RET_CHECK_LT(spectrogram_options.frame_overlap_seconds(),
+               spectrogram_options.frame_duration_seconds());
+  RET_CHECK_EQ(spectrogram_options.output_type(),
+               SpectrogramCalculatorOptions::SQUARED_MAGNITUDE)
+      << "The Mel filterbank expects squared magnitudes.";
+  RET_CHECK(!spectrogram_options.allow_multichannel_input() &&
+            !spectrogram_options.batch_channels())
+      << "Only single-channel input is supported.";
+  RET_CHECK_GE(log_options.stabilizer(), 0.0);
+
+  TimeSeriesHeader input_header;
+  MP_RETURN_IF_ERROR(time_series_util::FillTimeSeriesHeaderIfValid(
+      cc->Inputs().Index(0).Header(), &input_header));
+  RET_CHECK_EQ(input_header.num_channels(), 1)
+      << "Only single-channel input is supported.";
+  input_sample_rate_ = input_header.sample_rate();
+
+  frame_duration_samples_ =
+      round(spectrogram_options.frame_duration_seconds() * input_sample_rate_);
+  frame_step_samples_ =
+      frame_duration_samples_ -
+      round(spectrogram_options.frame_overlap_seconds() * input_sample_rate_);
+  pad_final_packet_ = spectrogram_options.pad_final_packet();
+  spectrogram_scale_ = spectrogram_options.output_scale();
+  stabilizer_ = log_options.stabilizer();
+  check_nonnegativity_ = log_options.check_nonnegativity();
+  log_scale_ = log_options.output_scale();
+
+  std::vector<double> window;
+  switch (spectrogram_options.window_type()) {
+    case SpectrogramCalculatorOptions::COSINE:
+      audio_dsp::CosineWindow().GetPeriodicSamples(frame_duration_samples_,
+                                                   &window);
+      break;
+    case SpectrogramCalculatorOptions::HANN:
+      audio_dsp::HannWindow().GetPeriodicSamples(frame_duration_samples_,
+                                                 &window);
+      break;
+    case SpectrogramCalculatorOptions::HAMMING:
+      audio_dsp::HammingWindow().GetPeriodicSamples(frame_duration_samples_,
+                                                    &window);
+      break;
+  }
+  spectrogram_ = absl::make_unique<audio_dsp::Spectrogram>();
+  RET_CHECK(spectrogram_->Initialize(window, frame_step_samples_))
+      << "Spectrogram::Initialize failed.";
+  const int num_frequency_bins = spectrogram_->output_frequency_channels();
+
+  num_mel_channels_ = mel_options.channel_count();
+  mel_filterbank_ = absl::make_unique<audio_dsp::MelFilterbank>();
+  RET_CHECK(mel_filterbank_->Initialize(
+      num_frequency_bins, input_sample_rate_, num_mel_channels_,
+      mel_options.min_frequency_hertz(), mel_options.max_frequency_hertz()))
+      << "MelFilterbank::Initialize failed.";
+  mel_input_.resize(num_frequency_bins);
+  mel_output_.resize(num_mel_channels_);
+
+  // The header the chained calculators would produce.
+  auto output_header = absl::make_unique<TimeSeriesHeader>(input_header);
+  output_header->set_audio_sample_rate(input_sample_rate_);
+  output_header->set_num_channels(num_mel_channels_);
+  output_header->set_sample_rate(input_sample_rate_ / frame_step_samples_);
+  output_header->clear_packet_rate();
+  output_header->clear_num_samples();
+  cc->Outputs().Index(0).SetHeader(Adopt(output_header.release()));
+
+  cumulative_input_samples_ = 0;
+  cumulative_completed_frames_ = 0;
+  initial_input_timestamp_ = Timestamp::Unstarted();
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status LogMelSpectrogramCalculator::Process(
+    CalculatorContext* cc) {
+  if (initial_input_timestamp_ == Timestamp::Unstarted()) {
+    initial_input_timestamp_ = cc->InputTimestamp();
+  }
+  const Matrix& input_stream = cc->Inputs().Index(0).Get<Matrix>();
+  RET_CHECK_EQ(input_stream.rows(), 1);
+  cumulative_input_samples_ += input_stream.cols();
+  return ProcessSamples(input_stream, cc);
+}
+
+::mediapipe::Status LogMelSpectrogramCalculator::ProcessSamples(
+    const Matrix& input_stream, CalculatorContext* cc) {
+  input_samples_.resize(input_stream.cols());
+  Eigen::Map<Matrix>(input_samples_.data(), 1, input_samples_.size()) =
+      input_stream;
+  if (!spectrogram_->ComputeSpectrogram(input_samples_,
+                                        &spectrogram_frames_)) {
+    return ::mediapipe::InternalError("Spectrogram returned failure");
+  }
+  if (spectrogram_frames_.empty()) {
+    return ::mediapipe::OkStatus();
+  }
+
+  const int num_frames = spectrogram_frames_.size();
+  auto output = absl::make_unique<Matrix>(num_mel_channels_, num_frames);
+  for (int frame = 0; frame < num_frames; ++frame) {
+    // Round through float like the Matrix packets between the chained
+    // calculators do, so the results are identical.
+    Eigen::Map<Eigen::VectorXd>(mel_input_.data(), mel_input_.size()) =
+        (spectrogram_scale_ *
+         Eigen::Map<const Eigen::VectorXf>(spectrogram_frames_[frame].data(),
+                                           spectrogram_frames_[frame].size()))
+            .cast<double>();
+    mel_filterbank_->Compute(mel_input_, &mel_output_);
+    output->col(frame) =
+        Eigen::Map<const Eigen::VectorXd>(mel_output_.data(),
+                                          mel_output_.size())
+            .cast<float>();
+  }
+  if (check_nonnegativity_) {
+    RET_CHECK_GE(output->minCoeff(), 0);
+  }
+  *output = log_scale_ * (output->array() + stabilizer_).log().matrix();
+
+  cc->Outputs().Index(0).Add(output.release(), CurrentOutputTimestamp());
+  cumulative_completed_frames_ += num_frames;
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status LogMelSpectrogramCalculator::Close(CalculatorContext* cc) {
+  // Same flushing as SpectrogramCalculator::Close().
+  if (cumulative_input_samples_ > 0 && pad_final_packet_) {
+    int required_padding_samples = frame_step_samples_ - 1;
+    if (cumulative_input_samples_ < frame_duration_samples_) {
+      required_padding_samples =
+          frame_duration_samples_ - cumulative_input_samples_;
+    }
+    return ProcessSamples(Matrix::Zero(1, required_padding_samples), cc);
+  }
+  return ::mediapipe::OkStatus();
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,158 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include "Eigen/Core"
+#include "absl/memory/memory.h"
+#include "mediapipe/calculators/audio/log_mel_spectrogram_calculator.pb.h"
+#include "mediapipe/calculators/audio/mfcc_mel_calculators.pb.h"
+#include "mediapipe/calculators/audio/spectrogram_calculator.pb.h"
+#include "mediapipe/calculators/audio/stabilized_log_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/matrix.h"
+#include "mediapipe/framework/formats/time_series_header.pb.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/tool/sink.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr double kSampleRate = 16000.0;
+
+// Runs the fused calculator and the chained calculators side by side.
+class LogMelSpectrogramCalculatorTest : public ::testing::Test {
+ protected:
+  void RunGraphs(bool pad_final_packet, const std::vector<int>& packet_sizes) {
+    auto config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+      input_stream: "audio"
+      node {
+        calculator: "SpectrogramCalculator"
+        input_stream: "audio"
+        output_stream: "spectrogram"
+        options {
+          [mediapipe.SpectrogramCalculatorOptions.ext] {
+            frame_duration_seconds: 0.025
+            frame_overlap_seconds: 0.015
+            output_type: SQUARED_MAGNITUDE
+          }
+        }
+      }
+      node {
+        calculator: "MelSpectrumCalculator"
+        input_stream: "spectrogram"
+        output_stream: "mel"
+        options {
+          [mediapipe.MelSpectrumCalculatorOptions.ext] {
+            channel_count: 64
+            min_frequency_hertz: 125.0
+            max_frequency_hertz: 7500.0
+          }
+        }
+      }
+      node {
+        calculator: "StabilizedLogCalculator"
+        input_stream: "mel"
+        output_stream: "chained"
+        options {
+          [mediapipe.StabilizedLogCalculatorOptions.ext] { stabilizer: 0.01 }
+        }
+      }
+      node {
+        calculator: "LogMelSpectrogramCalculator"
+        input_stream: "audio"
+        output_stream: "fused"
+        options {
+          [mediapipe.LogMelSpectrogramCalculatorOptions.ext] {
+            spectrogram_params {
+              frame_duration_seconds: 0.025
+              frame_overlap_seconds: 0.015
+            }
+            mel_spectrum_params {
+              channel_count: 64
+              min_frequency_hertz: 125.0
+              max_frequency_hertz: 7500.0
+            }
+            log_params { stabilizer: 0.01 }
+          }
+        }
+      }
+    )");
+    for (auto* node : {config.mutable_node(0), config.mutable_node(3)}) {
+      auto* options = node->mutable_options();
+      if (options->HasExtension(SpectrogramCalculatorOptions::ext)) {
+        options->MutableExtension(SpectrogramCalculatorOptions::ext)
+            ->set_pad_final_packet(pad_final_packet);
+      } else {
+        options->MutableExtension(LogMelSpectrogramCalculatorOptions::ext)
+            ->mutable_spectrogram_params()
+            ->set_pad_final_packet(pad_final_packet);
+      }
+    }
+    tool::AddVectorSink("chained", &config, &chained_packets_);
+    tool::AddVectorSink("fused", &config, &fused_packets_);
+
+    auto header = absl::make_unique<TimeSeriesHeader>();
+    header->set_sample_rate(kSampleRate);
+    header->set_num_channels(1);
+    CalculatorGraph graph;
+    MP_ASSERT_OK(graph.Initialize(config));
+    MP_ASSERT_OK(graph.StartRun({}, {{"audio", Adopt(header.release())}}));
+    int64 num_samples = 0;
+    for (int packet_size : packet_sizes) {
+      const Timestamp timestamp(static_cast<int64>(
+          num_samples * Timestamp::kTimestampUnitsPerSecond / kSampleRate));
+      MP_ASSERT_OK(graph.AddPacketToInputStream(
+          "audio",
+          Adopt(new Matrix(Matrix::Random(1, packet_size))).At(timestamp)));
+      num_samples += packet_size;
+    }
+    MP_ASSERT_OK(graph.CloseAllInputStreams());
+    MP_ASSERT_OK(graph.WaitUntilDone());
+  }
+
+  void ExpectIdenticalOutputs() {
+    ASSERT_EQ(chained_packets_.size(), fused_packets_.size());
+    for (int i = 0; i < chained_packets_.size(); ++i) {
+      EXPECT_EQ(chained_packets_[i].Timestamp(), fused_packets_[i].Timestamp());
+      const Matrix& chained = chained_packets_[i].Get<Matrix>();
+      const Matrix& fused = fused_packets_[i].Get<Matrix>();
+      ASSERT_EQ(chained.rows(), fused.rows());
+      ASSERT_EQ(chained.cols(), fused.cols());
+      EXPECT_TRUE(chained == fused) << "Packet " << i;
+    }
+  }
+
+  std::vector<Packet> chained_packets_;
+  std::vector<Packet> fused_packets_;
+};
+
+TEST_F(LogMelSpectrogramCalculatorTest, MatchesChainedCalculators) {
+  RunGraphs(/*pad_final_packet=*/false, {1600, 1600, 1600});
+  ASSERT_FALSE(fused_packets_.empty());
+  EXPECT_EQ(64, fused_packets_[0].Get<Matrix>().rows());
+  ExpectIdenticalOutputs();
+}
+
+TEST_F(LogMelSpectrogramCalculatorTest, MatchesChainedCalculatorsWithPadding) {
+  // Packets shorter than a frame, and trailing samples to pad.
+  RunGraphs(/*pad_final_packet=*/true, {100, 250, 1234, 77});
+  ExpectIdenticalOutputs();
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -19,20 +19,22 @@
 // commonly used as acoustic features in speech and other audio tasks.
 // Both calculators expect as input the SQUARED_MAGNITUDE-domain outputs
 // from the MediaPipe SpectrogramCalculator object.
+#include <functional>
 #include <memory>
 #include <vector>
 
 #include "Eigen/Core"
+#include "Eigen/SparseCore"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "audio/dsp/mfcc/mel_filterbank.h"
-#include "audio/dsp/mfcc/mfcc.h"
+#include "audio/dsp/mfcc/mfcc_dct.h"
 #include "mediapipe/calculators/audio/mfcc_mel_calculators.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/matrix.h"
 #include "mediapipe/framework/formats/time_series_header.pb.h"
-#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/util/time_series_util.h"
 
@@ -54,16 +56,56 @@ std::string PortableDebugString(const TimeSeriesHeader& header) {
                           header.packet_rate(), header.audio_sample_rate());
 }
 
+// The floor audio_dsp::Mfcc applies to the Mel spectrum before its log.
+constexpr float kFilterbankFloor = 1e-12f;
+
+// Returns the matrix of the linear map "transform" from vectors of length
+// "input_length" to vectors of length "output_length", by applying it to
+// each unit vector.
+Eigen::MatrixXf LinearMapMatrix(
+    int input_length, int output_length,
+    const std::function<void(const std::vector<double>&,
+                             std::vector<double>*)>& transform) {
+  Eigen::MatrixXf result(output_length, input_length);
+  std::vector<double> input(input_length, 0.0);
+  std::vector<double> output;
+  for (int i = 0; i < input_length; ++i) {
+    input[i] = 1.0;
+    transform(input, &output);
+    input[i] = 0.0;
+    result.col(i) =
+        Eigen::Map<const Eigen::VectorXd>(output.data(), output_length)
+            .cast<float>();
+  }
+  return result;
+}
+
+// Returns the weights of "mel_filterbank" as a sparse matrix F, such that
+// the Mel spectrum of a squared magnitude spectrum x is F * sqrt(x). Each
+// spectrum bin contributes to at most two Mel channels.
+Eigen::SparseMatrix<float, Eigen::RowMajor> FilterbankMatrix(
+    const audio_dsp::MelFilterbank& mel_filterbank, int input_length,
+    int num_channels) {
+  // Unit vectors are their own square roots, so this recovers F.
+  return LinearMapMatrix(input_length, num_channels,
+                         [&mel_filterbank](const std::vector<double>& input,
+                                           std::vector<double>* output) {
+                           mel_filterbank.Compute(input, output);
+                         })
+      .sparseView();
+}
+
 }  // namespace
 
 // Abstract base class for Calculators that transform feature vectors on a
 // frame-by-frame basis.
 // Subclasses must override pure virtual methods ConfigureTransform and
-// TransformFrame.
+// TransformFrames.
 // Input and output MediaPipe packets are matrices with one column per frame,
 // and one row per feature dimension.  Each input packet results in an
 // output packet with the same number of columns (but differing numbers of
-// rows corresponding to the new feature space).
+// rows corresponding to the new feature space). Subclasses transform all the
+// frames of a packet at once, as matrix products.
 class FramewiseTransformCalculatorBase : public CalculatorBase {
  public:
   static ::mediapipe::Status GetContract(CalculatorContract* cc) {
@@ -93,12 +135,12 @@ class FramewiseTransformCalculatorBase : public CalculatorBase {
   virtual ::mediapipe::Status ConfigureTransform(const TimeSeriesHeader& header,
                                                  CalculatorContext* cc) = 0;
 
-  // Takes a vector<double> corresponding to an input frame, and
-  // perform the specific transformation to produce an output frame.
-  virtual void TransformFrame(const std::vector<double>& input,
-                              std::vector<double>* output) const = 0;
+  // Transforms "input", which has one column per frame, into "output",
+  // which has num_output_channels() rows and as many columns.
+  virtual void TransformFrames(const Matrix& input, Matrix* output) const = 0;
 
  private:
+  int num_input_channels_;
   int num_output_channels_;
 };
 
@@ -108,6 +150,7 @@ class FramewiseTransformCalculatorBase : public CalculatorBase {
   MP_RETURN_IF_ERROR(time_series_util::FillTimeSeriesHeaderIfValid(
       cc->Inputs().Index(0).Header(), &input_header));
 
+  num_input_channels_ = input_header.num_channels();
   ::mediapipe::Status status = ConfigureTransform(input_header, cc);
 
   auto output_header = new TimeSeriesHeader(input_header);
@@ -120,29 +163,10 @@ class FramewiseTransformCalculatorBase : public CalculatorBase {
 ::mediapipe::Status FramewiseTransformCalculatorBase::Process(
     CalculatorContext* cc) {
   const Matrix& input = cc->Inputs().Index(0).Get<Matrix>();
-  const int num_frames = input.cols();
-  std::unique_ptr<Matrix> output(new Matrix(num_output_channels_, num_frames));
-  // The main work here is converting each column of the float Matrix
-  // into a vector of doubles, which is what our target functions from
-  // dsp_core consume, and doing the reverse with their output.
-  std::vector<double> input_frame(input.rows());
-  std::vector<double> output_frame(num_output_channels_);
-
-  for (int frame = 0; frame < num_frames; ++frame) {
-    // Copy input from Eigen::Matrix column to vector<float>.
-    Eigen::Map<Eigen::MatrixXd> input_frame_map(&input_frame[0],
-                                                input_frame.size(), 1);
-    input_frame_map = input.col(frame).cast<double>();
-
-    // Perform the actual transformation.
-    TransformFrame(input_frame, &output_frame);
-
-    // Copy output from vector<float> to Eigen::Vector.
-    CHECK_EQ(output_frame.size(), num_output_channels_);
-    Eigen::Map<const Eigen::MatrixXd> output_frame_map(&output_frame[0],
-                                                       output_frame.size(), 1);
-    output->col(frame) = output_frame_map.cast<float>();
-  }
+  RET_CHECK_EQ(input.rows(), num_input_channels_);
+  std::unique_ptr<Matrix> output(
+      new Matrix(num_output_channels_, input.cols()));
+  TransformFrames(input, output.get());
   cc->Outputs().Index(0).Add(output.release(), cc->InputTimestamp());
 
   return ::mediapipe::OkStatus();
@@ -178,17 +202,9 @@ class MfccCalculator : public FramewiseTransformCalculatorBase {
   ::mediapipe::Status ConfigureTransform(const TimeSeriesHeader& header,
                                          CalculatorContext* cc) override {
     MfccCalculatorOptions mfcc_options = cc->Options<MfccCalculatorOptions>();
-    mfcc_.reset(new audio_dsp::Mfcc());
     int input_length = header.num_channels();
-    // Set up the parameters to the Mfcc object.
+    int channel_count = mfcc_options.mel_spectrum_params().channel_count();
     set_num_output_channels(mfcc_options.mfcc_count());
-    mfcc_->set_dct_coefficient_count(num_output_channels());
-    mfcc_->set_upper_frequency_limit(
-        mfcc_options.mel_spectrum_params().max_frequency_hertz());
-    mfcc_->set_lower_frequency_limit(
-        mfcc_options.mel_spectrum_params().min_frequency_hertz());
-    mfcc_->set_filterbank_channel_count(
-        mfcc_options.mel_spectrum_params().channel_count());
     // An upstream calculator (such as SpectrogramCalculator) must store
     // the sample rate of its input audio waveform in the TimeSeries Header.
     // audio_dsp::MelFilterBank needs to know this to
@@ -198,11 +214,25 @@ class MfccCalculator : public FramewiseTransformCalculatorBase {
           absl::StrCat("No audio_sample_rate in input TimeSeriesHeader ",
                        PortableDebugString(header)));
     }
-    // Now we can initialize the Mfcc object.
+    // Now we can initialize the Mel filterbank and the DCT, as
+    // audio_dsp::Mfcc does, and capture them as matrices.
+    audio_dsp::MelFilterbank mel_filterbank;
+    audio_dsp::MfccDct dct;
     bool initialized =
-        mfcc_->Initialize(input_length, header.audio_sample_rate());
+        mel_filterbank.Initialize(
+            input_length, header.audio_sample_rate(), channel_count,
+            mfcc_options.mel_spectrum_params().min_frequency_hertz(),
+            mfcc_options.mel_spectrum_params().max_frequency_hertz()) &&
+        dct.Initialize(channel_count, num_output_channels());
 
     if (initialized) {
+      filterbank_ =
+          FilterbankMatrix(mel_filterbank, input_length, channel_count);
+      dct_ = LinearMapMatrix(channel_count, num_output_channels(),
+                             [&dct](const std::vector<double>& input,
+                                    std::vector<double>* output) {
+                               dct.Compute(input, output);
+                             });
       return ::mediapipe::OkStatus();
     } else {
       return ::mediapipe::Status(mediapipe::StatusCode::kInternal,
@@ -210,13 +240,17 @@ class MfccCalculator : public FramewiseTransformCalculatorBase {
     }
   }
 
-  void TransformFrame(const std::vector<double>& input,
-                      std::vector<double>* output) const override {
-    mfcc_->Compute(input, output);
+  void TransformFrames(const Matrix& input, Matrix* output) const override {
+    Matrix mel_spectrum = filterbank_ * input.cwiseSqrt();
+    output->noalias() =
+        dct_ * mel_spectrum.array().max(kFilterbankFloor).log().matrix();
   }
 
  private:
-  std::unique_ptr<audio_dsp::Mfcc> mfcc_;
+  // The Mel filterbank weights, one row per Mel channel.
+  Eigen::SparseMatrix<float, Eigen::RowMajor> filterbank_;
+  // The DCT of the log Mel spectrum, one row per coefficient.
+  Eigen::MatrixXf dct_;
 };
 REGISTER_CALCULATOR(MfccCalculator);
 
@@ -237,7 +271,7 @@ class MelSpectrumCalculator : public FramewiseTransformCalculatorBase {
                                          CalculatorContext* cc) override {
     MelSpectrumCalculatorOptions mel_spectrum_options =
         cc->Options<MelSpectrumCalculatorOptions>();
-    mel_filterbank_.reset(new audio_dsp::MelFilterbank());
+    audio_dsp::MelFilterbank mel_filterbank;
     int input_length = header.num_channels();
     set_num_output_channels(mel_spectrum_options.channel_count());
     // An upstream calculator (such as SpectrogramCalculator) must store
@@ -249,12 +283,14 @@ class MelSpectrumCalculator : public FramewiseTransformCalculatorBase {
           absl::StrCat("No audio_sample_rate in input TimeSeriesHeader ",
                        PortableDebugString(header)));
     }
-    bool initialized = mel_filterbank_->Initialize(
+    bool initialized = mel_filterbank.Initialize(
         input_length, header.audio_sample_rate(), num_output_channels(),
         mel_spectrum_options.min_frequency_hertz(),
         mel_spectrum_options.max_frequency_hertz());
 
     if (initialized) {
+      filterbank_ = FilterbankMatrix(mel_filterbank, input_length,
+                                     num_output_channels());
       return ::mediapipe::OkStatus();
     } else {
       return ::mediapipe::Status(mediapipe::StatusCode::kInternal,
@@ -262,13 +298,13 @@ class MelSpectrumCalculator : public FramewiseTransformCalculatorBase {
     }
   }
 
-  void TransformFrame(const std::vector<double>& input,
-                      std::vector<double>* output) const override {
-    mel_filterbank_->Compute(input, output);
+  void TransformFrames(const Matrix& input, Matrix* output) const override {
+    output->noalias() = filterbank_ * input.cwiseSqrt();
   }
 
  private:
-  std::unique_ptr<audio_dsp::MelFilterbank> mel_filterbank_;
+  // The Mel filterbank weights, one row per Mel channel.
+  Eigen::SparseMatrix<float, Eigen::RowMajor> filterbank_;
 };
 REGISTER_CALCULATOR(MelSpectrumCalculator);
 
@@ -13,7 +13,14 @@
 // limitations under the License.
 #include <vector>
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
 #include "Eigen/Core"
+#include "audio/dsp/mfcc/mel_filterbank.h"
+#include "audio/dsp/mfcc/mfcc.h"
 #include "mediapipe/calculators/audio/mfcc_mel_calculators.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/matrix.h"
@@ -99,6 +106,31 @@ class FramewiseTransformCalculatorTest
     }
   }
 
+  // Checks that each output frame matches "transform" applied to the input
+  // frame, as audio_dsp computes it one frame at a time.
+  void CheckFramesMatch(
+      const std::function<void(const std::vector<double>&,
+                               std::vector<double>*)>& transform) {
+    ASSERT_EQ(this->input().packets.size(), this->output().packets.size());
+    for (int i = 0; i < this->output().packets.size(); ++i) {
+      const Matrix& input = this->input().packets[i].template Get<Matrix>();
+      const Matrix& output = this->output().packets[i].template Get<Matrix>();
+      for (int frame = 0; frame < input.cols(); ++frame) {
+        std::vector<double> input_frame(input.rows());
+        for (int row = 0; row < input.rows(); ++row) {
+          input_frame[row] = input(row, frame);
+        }
+        std::vector<double> expected;
+        transform(input_frame, &expected);
+        ASSERT_EQ(expected.size(), output.rows());
+        for (int row = 0; row < output.rows(); ++row) {
+          EXPECT_NEAR(expected[row], output(row, frame),
+                      1e-4 * std::max(1.0, std::abs(expected[row])));
+        }
+      }
+    }
+  }
+
   // Allows SetupRandomInputPackets() to inform CheckResults() about how
   // big the packets are supposed to be.
   int num_samples_per_packet_;
@@ -116,6 +148,27 @@ TEST_F(MfccCalculatorTest, AudioSampleRateFromInputHeader) {
 
   CheckResults(options_.mfcc_count());
 }
+TEST_F(MfccCalculatorTest, MatchesFramewiseMfcc) {
+  audio_sample_rate_ = kAudioSampleRate;
+  SetupGraphAndHeader();
+  SetupRandomInputPackets();
+
+  MP_ASSERT_OK(Run());
+
+  audio_dsp::Mfcc mfcc;
+  mfcc.set_dct_coefficient_count(options_.mfcc_count());
+  mfcc.set_upper_frequency_limit(
+      options_.mel_spectrum_params().max_frequency_hertz());
+  mfcc.set_lower_frequency_limit(
+      options_.mel_spectrum_params().min_frequency_hertz());
+  mfcc.set_filterbank_channel_count(
+      options_.mel_spectrum_params().channel_count());
+  ASSERT_TRUE(mfcc.Initialize(num_input_channels_, kAudioSampleRate));
+  CheckFramesMatch(
+      [&mfcc](const std::vector<double>& input, std::vector<double>* output) {
+        mfcc.Compute(input, output);
+      });
+}
 TEST_F(MfccCalculatorTest, NoAudioSampleRate) {
   // Leave audio_sample_rate_ == kUnset, so it is not present in the
   // input TimeSeriesHeader; expect failure.
@@ -138,6 +191,22 @@ TEST_F(MelSpectrumCalculatorTest, AudioSampleRateFromInputHeader) {
 
   CheckResults(options_.channel_count());
 }
+TEST_F(MelSpectrumCalculatorTest, MatchesFramewiseMelFilterbank) {
+  audio_sample_rate_ = kAudioSampleRate;
+  SetupGraphAndHeader();
+  SetupRandomInputPackets();
+
+  MP_ASSERT_OK(Run());
+
+  audio_dsp::MelFilterbank mel_filterbank;
+  ASSERT_TRUE(mel_filterbank.Initialize(
+      num_input_channels_, kAudioSampleRate, options_.channel_count(),
+      options_.min_frequency_hertz(), options_.max_frequency_hertz()));
+  CheckFramesMatch([&mel_filterbank](const std::vector<double>& input,
+                                     std::vector<double>* output) {
+    mel_filterbank.Compute(input, output);
+  });
+}
 TEST_F(MelSpectrumCalculatorTest, NoAudioSampleRate) {
   // Leave audio_sample_rate_ == kUnset, so it is not present in the
   // input TimeSeriesHeader; expect failure.
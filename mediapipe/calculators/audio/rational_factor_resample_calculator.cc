@@ -16,7 +16,9 @@
 
 #include "mediapipe/calculators/audio/rational_factor_resample_calculator.h"
 
+#include "absl/memory/memory.h"
 #include "audio/dsp/resampler_rational_factor.h"
+#include "mediapipe/framework/port/status_macros.h"
 
 using audio_dsp::DefaultResamplingKernel;
 using audio_dsp::RationalFactorResampler;
@@ -25,6 +27,11 @@ using audio_dsp::Resampler;
 namespace mediapipe {
 ::mediapipe::Status RationalFactorResampleCalculator::Process(
     CalculatorContext* cc) {
+  if (int16_input_) {
+    Int16MatrixToMatrix(cc->Inputs().Tag("INT16_MATRIX").Get<Int16Matrix>(),
+                        &converted_input_frame_);
+    return ProcessInternal(converted_input_frame_, false, cc);
+  }
   return ProcessInternal(cc->Inputs().Index(0).Get<Matrix>(), false, cc);
 }
 
@@ -73,15 +80,26 @@ void CopyVectorToChannel(const std::vector<float>& vec, Matrix* matrix,
   }
   target_sample_rate_ = resample_options.target_sample_rate();
 
+  int16_input_ = cc->Inputs().HasTag("INT16_MATRIX");
   TimeSeriesHeader input_header;
   MP_RETURN_IF_ERROR(time_series_util::FillTimeSeriesHeaderIfValid(
-      cc->Inputs().Index(0).Header(), &input_header));
+      int16_input_ ? cc->Inputs().Tag("INT16_MATRIX").Header()
+                   : cc->Inputs().Index(0).Header(),
+      &input_header));
 
   source_sample_rate_ = input_header.sample_rate();
   num_channels_ = input_header.num_channels();
 
   // Don't create resamplers for pass-thru (sample rates are equal).
-  if (source_sample_rate_ != target_sample_rate_) {
+  polyphase_resampler_.reset();
+  if (source_sample_rate_ != target_sample_rate_ &&
+      resample_options.implementation() ==
+          RationalFactorResampleCalculatorOptions::POLYPHASE) {
+    ASSIGN_OR_RETURN(polyphase_resampler_,
+                     PolyphaseResamplerFromOptions(
+                         source_sample_rate_, target_sample_rate_,
+                         num_channels_, resample_options));
+  } else if (source_sample_rate_ != target_sample_rate_) {
     resampler_.resize(num_channels_);
     for (auto& r : resampler_) {
       r = ResamplerFromOptions(source_sample_rate_, target_sample_rate_,
@@ -126,7 +144,13 @@ void CopyVectorToChannel(const std::vector<float>& vec, Matrix* matrix,
 
   cumulative_input_samples_ += input_frame.cols();
   std::unique_ptr<Matrix> output_frame(new Matrix(num_channels_, 0));
-  if (resampler_.empty()) {
+  if (polyphase_resampler_) {
+    if (should_flush) {
+      polyphase_resampler_->Flush(output_frame.get());
+    } else {
+      polyphase_resampler_->ProcessSamples(input_frame, output_frame.get());
+    }
+  } else if (resampler_.empty()) {
     // Sample rates were same for input and output; pass-thru.
     *output_frame = input_frame;
   } else {
@@ -192,6 +216,33 @@ RationalFactorResampleCalculator::ResamplerFromOptions(
   return resampler;
 }
 
+// static
+::mediapipe::StatusOr<std::unique_ptr<PolyphaseResampler>>
+RationalFactorResampleCalculator::PolyphaseResamplerFromOptions(
+    const double source_sample_rate, const double target_sample_rate,
+    const int num_channels,
+    const RationalFactorResampleCalculatorOptions& options) {
+  const auto& rational_factor_options =
+      options.resampler_rational_factor_options();
+  // The kernel spans the same number of periods of the lower rate whichever
+  // way we resample, so express the radius at that rate in input samples.
+  const double min_sample_rate =
+      std::min(source_sample_rate, target_sample_rate);
+  double radius = (options.low_latency() ? 5.0 : 17.0) * source_sample_rate /
+                  min_sample_rate;
+  double cutoff = 0.45 * min_sample_rate;
+  if (rational_factor_options.has_radius() &&
+      rational_factor_options.has_cutoff()) {
+    radius = rational_factor_options.radius();
+    cutoff = rational_factor_options.cutoff();
+  }
+  auto resampler = absl::make_unique<PolyphaseResampler>();
+  MP_RETURN_IF_ERROR(resampler->Initialize(
+      source_sample_rate, target_sample_rate, num_channels, radius, cutoff,
+      rational_factor_options.kaiser_beta()));
+  return std::move(resampler);
+}
+
 REGISTER_CALCULATOR(RationalFactorResampleCalculator);
 
 }  // namespace mediapipe
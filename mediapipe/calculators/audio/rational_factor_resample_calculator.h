@@ -24,10 +24,14 @@
 #include "audio/dsp/resampler.h"
 #include "mediapipe/calculators/audio/rational_factor_resample_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/int16_matrix.h"
 #include "mediapipe/framework/formats/matrix.h"
 #include "mediapipe/framework/formats/time_series_header.pb.h"
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mediapipe/util/polyphase_resampler.h"
 #include "mediapipe/util/time_series_util.h"
 
 namespace mediapipe {
@@ -36,14 +40,29 @@ namespace mediapipe {
 // stream's sampling rate is specified by target_sample_rate in the
 // RationalFactorResampleCalculatorOptions.  The output time series may have
 // a varying number of samples per frame.
+//
+// By default each channel is resampled by its own
+// audio_dsp::RationalFactorResampler. With implementation: POLYPHASE, all
+// channels go through one PolyphaseResampler, which evaluates the filter for
+// every channel at once.
+//
+// The input may instead be given as 16-bit samples on an INT16_MATRIX stream
+// (an Int16Matrix with the same TimeSeriesHeader). Each packet is converted
+// to float in one pass into a buffer that is reused across packets.
 class RationalFactorResampleCalculator : public CalculatorBase {
  public:
   struct TestAccess;
 
   static ::mediapipe::Status GetContract(CalculatorContract* cc) {
-    cc->Inputs().Index(0).Set<Matrix>(
-        // Single input stream with TimeSeriesHeader.
-    );
+    if (cc->Inputs().HasTag("INT16_MATRIX")) {
+      cc->Inputs().Tag("INT16_MATRIX").Set<Int16Matrix>(
+          // Single input stream of 16-bit samples with TimeSeriesHeader.
+      );
+    } else {
+      cc->Inputs().Index(0).Set<Matrix>(
+          // Single input stream with TimeSeriesHeader.
+      );
+    }
     cc->Outputs().Index(0).Set<Matrix>(
         // Resampled stream with TimeSeriesHeader.
     );
@@ -69,6 +88,14 @@ class RationalFactorResampleCalculator : public CalculatorBase {
       const double source_sample_rate, const double target_sample_rate,
       const RationalFactorResampleCalculatorOptions& options);
 
+  // Returns an initialized PolyphaseResampler for the options, or an error if
+  // the options or sample rates are not supported by it.
+  static ::mediapipe::StatusOr<std::unique_ptr<PolyphaseResampler>>
+  PolyphaseResamplerFromOptions(
+      const double source_sample_rate, const double target_sample_rate,
+      const int num_channels,
+      const RationalFactorResampleCalculatorOptions& options);
+
   // Does Timestamp bookkeeping and resampling common to Process() and
   // Close().  Returns FAIL if the resampler state becomes
   // inconsistent.
@@ -89,6 +116,12 @@ class RationalFactorResampleCalculator : public CalculatorBase {
   bool check_inconsistent_timestamps_;
   int num_channels_;
   std::vector<std::unique_ptr<ResamplerType>> resampler_;
+  // Used instead of resampler_ for the POLYPHASE implementation.
+  std::unique_ptr<PolyphaseResampler> polyphase_resampler_;
+  // Whether the input is an INT16_MATRIX stream, and the float samples of
+  // the current INT16_MATRIX packet.
+  bool int16_input_ = false;
+  Matrix converted_input_frame_;
 };
 
 // Test-only access to RationalFactorResampleCalculator methods.
@@ -99,6 +132,14 @@ struct RationalFactorResampleCalculator::TestAccess {
     return RationalFactorResampleCalculator::ResamplerFromOptions(
         source_sample_rate, target_sample_rate, options);
   }
+  static ::mediapipe::StatusOr<std::unique_ptr<PolyphaseResampler>>
+  PolyphaseResamplerFromOptions(
+      const double source_sample_rate, const double target_sample_rate,
+      const int num_channels,
+      const RationalFactorResampleCalculatorOptions& options) {
+    return RationalFactorResampleCalculator::PolyphaseResamplerFromOptions(
+        source_sample_rate, target_sample_rate, num_channels, options);
+  }
 };
 
 }  // namespace mediapipe
@@ -26,6 +26,7 @@
 #include "mediapipe/framework//tool/validate_type.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/formats/int16_matrix.h"
 #include "mediapipe/framework/formats/matrix.h"
 #include "mediapipe/framework/formats/time_series_header.pb.h"
 #include "mediapipe/framework/port/gmock.h"
@@ -203,6 +204,35 @@ class RationalFactorResampleCalculatorTest
     }
   }
 
+  // Checks the output values against resampling the entire signal at once
+  // with a PolyphaseResampler.
+  void CheckPolyphaseOutputValues(double output_sample_rate) {
+    auto verification_resampler =
+        RationalFactorResampleCalculator::TestAccess::
+            PolyphaseResamplerFromOptions(input_sample_rate_,
+                                          output_sample_rate,
+                                          num_input_channels_, options_)
+                .ValueOrDie();
+    Matrix expected;
+    verification_resampler->ProcessSamples(concatenated_input_samples_,
+                                           &expected);
+    Matrix flushed;
+    verification_resampler->Flush(&flushed);
+    expected.conservativeResize(Eigen::NoChange,
+                                expected.cols() + flushed.cols());
+    expected.rightCols(flushed.cols()) = flushed;
+
+    int num_output_samples = 0;
+    for (const Packet& packet : output().packets) {
+      const Matrix& output_frame = packet.Get<Matrix>();
+      ASSERT_LE(num_output_samples + output_frame.cols(), expected.cols());
+      EXPECT_TRUE(output_frame.isApprox(
+          expected.middleCols(num_output_samples, output_frame.cols())));
+      num_output_samples += output_frame.cols();
+    }
+    EXPECT_EQ(expected.cols(), num_output_samples);
+  }
+
   int num_input_samples_;
   Matrix concatenated_input_samples_;
 };
@@ -225,6 +255,35 @@ TEST_F(RationalFactorResampleCalculatorTest, UsesRationalFactorResampler) {
   CheckOutput(kUpsampleRate);
 }
 
+TEST_F(RationalFactorResampleCalculatorTest, PolyphaseDownsample) {
+  const double kDownsampleRate = 1600.0;
+  options_.set_implementation(
+      RationalFactorResampleCalculatorOptions::POLYPHASE);
+  MP_ASSERT_OK(Run(kDownsampleRate));
+  CheckOutputLength(kDownsampleRate);
+  CheckOutputPacketTimestamps(kDownsampleRate);
+  CheckPolyphaseOutputValues(kDownsampleRate);
+  CheckOutputHeaders(kDownsampleRate);
+}
+
+TEST_F(RationalFactorResampleCalculatorTest, PolyphaseLowLatencyUpsample) {
+  const double kUpsampleRate = 11025.0;
+  options_.set_implementation(
+      RationalFactorResampleCalculatorOptions::POLYPHASE);
+  options_.set_low_latency(true);
+  MP_ASSERT_OK(Run(kUpsampleRate));
+  CheckOutputLength(kUpsampleRate);
+  CheckOutputPacketTimestamps(kUpsampleRate);
+  CheckPolyphaseOutputValues(kUpsampleRate);
+  CheckOutputHeaders(kUpsampleRate);
+}
+
+TEST_F(RationalFactorResampleCalculatorTest, PolyphaseFailsOnNonIntegerRate) {
+  options_.set_implementation(
+      RationalFactorResampleCalculatorOptions::POLYPHASE);
+  ASSERT_FALSE(Run(input_sample_rate_ / 1.9).ok());
+}
+
 TEST_F(RationalFactorResampleCalculatorTest, PassthroughIfSampleRateUnchanged) {
   const double kUpsampleRate = input_sample_rate_;
   MP_ASSERT_OK(Run(kUpsampleRate));
@@ -243,5 +302,71 @@ TEST_F(RationalFactorResampleCalculatorTest, DoesNotDieOnEmptyInput) {
   EXPECT_TRUE(output().packets.empty());
 }
 
+// Runs RationalFactorResampleCalculator on "input", split into packets of
+// packet_size_samples, as INT16_MATRIX packets if int16_input is set and as
+// Matrix packets otherwise. Returns the output packets.
+std::vector<Packet> RunResampler(
+    const RationalFactorResampleCalculatorOptions& options,
+    const Int16Matrix& input, int packet_size_samples, bool int16_input) {
+  CalculatorGraphConfig::Node node_config;
+  node_config.set_calculator("RationalFactorResampleCalculator");
+  node_config.add_input_stream(int16_input ? "INT16_MATRIX:input_audio"
+                                           : "input_audio");
+  node_config.add_output_stream("resampled_audio");
+  *node_config.mutable_options()->MutableExtension(
+      RationalFactorResampleCalculatorOptions::ext) = options;
+
+  const double sample_rate = 16000.0;
+  TimeSeriesHeader* header = new TimeSeriesHeader();
+  header->set_sample_rate(sample_rate);
+  header->set_num_channels(input.rows());
+
+  CalculatorRunner runner(node_config);
+  auto& input_stream =
+      runner.MutableInputs()->Get(int16_input ? "INT16_MATRIX" : "", 0);
+  input_stream.header = Adopt(header);
+  for (int start = 0; start < input.cols(); start += packet_size_samples) {
+    const int size = std::min<int>(packet_size_samples, input.cols() - start);
+    const Timestamp timestamp(
+        round(start / sample_rate * Timestamp::kTimestampUnitsPerSecond));
+    const Int16Matrix packet_samples = input.middleCols(start, size);
+    if (int16_input) {
+      input_stream.packets.push_back(
+          Adopt(new Int16Matrix(packet_samples)).At(timestamp));
+    } else {
+      Matrix* matrix = new Matrix;
+      Int16MatrixToMatrix(packet_samples, matrix);
+      input_stream.packets.push_back(Adopt(matrix).At(timestamp));
+    }
+  }
+  MEDIAPIPE_CHECK_OK(runner.Run());
+  return runner.Outputs().Index(0).packets;
+}
+
+TEST(RationalFactorResampleCalculatorInt16Test, Int16InputMatchesMatrixInput) {
+  const Int16Matrix input =
+      (Matrix::Random(2, 1600) * 32767.0f).cast<int16>();
+  for (double target_sample_rate : {8000.0, 16000.0}) {
+    for (auto implementation :
+         {RationalFactorResampleCalculatorOptions::RATIONAL_FACTOR,
+          RationalFactorResampleCalculatorOptions::POLYPHASE}) {
+      RationalFactorResampleCalculatorOptions options;
+      options.set_target_sample_rate(target_sample_rate);
+      options.set_implementation(implementation);
+      const std::vector<Packet> expected =
+          RunResampler(options, input, 320, false);
+      const std::vector<Packet> actual =
+          RunResampler(options, input, 320, true);
+
+      ASSERT_EQ(expected.size(), actual.size());
+      ASSERT_FALSE(actual.empty());
+      for (int i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(expected[i].Timestamp(), actual[i].Timestamp());
+        EXPECT_EQ(expected[i].Get<Matrix>(), actual[i].Get<Matrix>());
+      }
+    }
+  }
+}
+
 }  // anonymous namespace
 }  // namespace mediapipe
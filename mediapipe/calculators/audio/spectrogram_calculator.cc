@@ -15,17 +15,20 @@
 // Defines SpectrogramCalculator.
 #include <math.h>
 
+#include <algorithm>
 #include <complex>
 #include <deque>
 #include <memory>
 #include <string>
 
 #include "Eigen/Core"
+#include "absl/memory/memory.h"
 #include "absl/strings/string_view.h"
 #include "audio/dsp/spectrogram/spectrogram.h"
 #include "audio/dsp/window_functions.h"
 #include "mediapipe/calculators/audio/spectrogram_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/int16_matrix.h"
 #include "mediapipe/framework/formats/matrix.h"
 #include "mediapipe/framework/formats/time_series_header.pb.h"
 #include "mediapipe/framework/port/core_proto_inc.h"
@@ -35,6 +38,7 @@
 #include "mediapipe/framework/port/source_location.h"
 #include "mediapipe/framework/port/status_builder.h"
 #include "mediapipe/util/time_series_util.h"
+#include "unsupported/Eigen/FFT"
 
 namespace mediapipe {
 
@@ -64,12 +68,27 @@ namespace mediapipe {
 // rounded to the nearest integer number of samples.  Conseqently, all output
 // frames will be based on the same number of input samples, and each
 // analysis frame will advance from its predecessor by the same time step.
+//
+// With batch_channels set, the samples of all channels are buffered together,
+// windowed with a single Eigen expression per frame, and transformed with one
+// Eigen::FFT object whose plan is reused for every channel and frame. Spectral
+// values are written directly into preallocated output matrices.
+//
+// The input may instead be given as 16-bit samples on an INT16_MATRIX stream
+// (an Int16Matrix with the same TimeSeriesHeader). Each packet is converted
+// to float in one pass into a buffer that is reused across packets.
 class SpectrogramCalculator : public CalculatorBase {
  public:
   static ::mediapipe::Status GetContract(CalculatorContract* cc) {
-    cc->Inputs().Index(0).Set<Matrix>(
-        // Input stream with TimeSeriesHeader.
-    );
+    if (cc->Inputs().HasTag("INT16_MATRIX")) {
+      cc->Inputs().Tag("INT16_MATRIX").Set<Int16Matrix>(
+          // Input stream of 16-bit samples with TimeSeriesHeader.
+      );
+    } else {
+      cc->Inputs().Index(0).Set<Matrix>(
+          // Input stream with TimeSeriesHeader.
+      );
+    }
 
     SpectrogramCalculatorOptions spectrogram_options =
         cc->Options<SpectrogramCalculatorOptions>();
@@ -141,6 +160,23 @@ class SpectrogramCalculator : public CalculatorBase {
       const OutputMatrixType postprocess_output_fn(const OutputMatrixType&),
       CalculatorContext* cc);
 
+  // Counterpart of ProcessVectorToOutput() for batch_channels mode.
+  template <class OutputMatrixType>
+  ::mediapipe::Status ProcessBatchedToOutput(const Matrix& input_stream,
+                                             CalculatorContext* cc);
+
+  // Writes spectrum_, converted to the requested output type and scaled, into
+  // column "frame" of "output".
+  void SetOutputFrame(int frame, Matrix* output) const;
+  void SetOutputFrame(int frame, Eigen::MatrixXcf* output) const;
+
+  // Emits the per-channel spectrograms, as a vector or as a single matrix
+  // depending on allow_multichannel_input.
+  template <class OutputMatrixType>
+  void OutputSpectrograms(
+      std::unique_ptr<std::vector<OutputMatrixType>> spectrogram_matrices,
+      CalculatorContext* cc);
+
   double input_sample_rate_;
   bool pad_final_packet_;
   int frame_duration_samples_;
@@ -161,6 +197,25 @@ class SpectrogramCalculator : public CalculatorBase {
   std::vector<std::unique_ptr<audio_dsp::Spectrogram>> spectrogram_generators_;
   // Fixed scale factor applied to output values (regardless of type).
   double output_scale_;
+  // Whether the input is an INT16_MATRIX stream, and the float samples of
+  // the current INT16_MATRIX packet.
+  bool int16_input_;
+  Matrix converted_input_stream_;
+
+  // State for batch_channels mode.
+  bool batch_channels_;
+  // Analysis window, as a column vector of frame_duration_samples_ values.
+  Eigen::VectorXf window_;
+  int fft_length_;
+  // Unconsumed input samples, one column per channel so that each channel's
+  // frames are contiguous. Only the first num_batched_samples_ rows are valid.
+  Matrix batched_samples_;
+  int num_batched_samples_;
+  // Windowed, zero-padded frame for each channel, one column per channel.
+  Matrix windowed_frames_;
+  // Half spectrum (fft_length_ / 2 + 1 bins) of the current channel.
+  Eigen::VectorXcf spectrum_;
+  Eigen::FFT<float> fft_;
 
   static const float kLnPowerToDb;
 };
@@ -193,9 +248,12 @@ const float SpectrogramCalculator::kLnPowerToDb = 4.342944819032518;
         << spectrogram_options.frame_overlap_seconds();
   }
 
+  int16_input_ = cc->Inputs().HasTag("INT16_MATRIX");
   TimeSeriesHeader input_header;
   MP_RETURN_IF_ERROR(time_series_util::FillTimeSeriesHeaderIfValid(
-      cc->Inputs().Index(0).Header(), &input_header));
+      int16_input_ ? cc->Inputs().Tag("INT16_MATRIX").Header()
+                   : cc->Inputs().Index(0).Header(),
+      &input_header));
 
   input_sample_rate_ = input_header.sample_rate();
   num_input_channels_ = input_header.num_channels();
@@ -234,16 +292,33 @@ const float SpectrogramCalculator::kLnPowerToDb = 4.342944819032518;
       break;
   }
 
-  // Propagate settings down to the actual Spectrogram object.
+  batch_channels_ = spectrogram_options.batch_channels();
   spectrogram_generators_.clear();
-  for (int i = 0; i < num_input_channels_; i++) {
-    spectrogram_generators_.push_back(
-        std::unique_ptr<audio_dsp::Spectrogram>(new audio_dsp::Spectrogram()));
-    spectrogram_generators_[i]->Initialize(window, frame_step_samples());
+  if (batch_channels_) {
+    // Same DFT length as audio_dsp::Spectrogram: the smallest power of 2 that
+    // holds the window.
+    fft_length_ = 1;
+    while (fft_length_ < frame_duration_samples_) {
+      fft_length_ *= 2;
+    }
+    num_output_channels_ = fft_length_ / 2 + 1;
+    window_ = Eigen::Map<const Eigen::VectorXd>(window.data(), window.size())
+                  .cast<float>();
+    batched_samples_.resize(2 * frame_duration_samples_, num_input_channels_);
+    num_batched_samples_ = 0;
+    windowed_frames_.setZero(fft_length_, num_input_channels_);
+    spectrum_.resize(num_output_channels_);
+    fft_.SetFlag(Eigen::FFT<float>::HalfSpectrum);
+  } else {
+    // Propagate settings down to the actual Spectrogram object.
+    for (int i = 0; i < num_input_channels_; i++) {
+      spectrogram_generators_.push_back(std::unique_ptr<audio_dsp::Spectrogram>(
+          new audio_dsp::Spectrogram()));
+      spectrogram_generators_[i]->Initialize(window, frame_step_samples());
+    }
+    num_output_channels_ =
+        spectrogram_generators_[0]->output_frequency_channels();
   }
-
-  num_output_channels_ =
-      spectrogram_generators_[0]->output_frequency_channels();
   std::unique_ptr<TimeSeriesHeader> output_header(
       new TimeSeriesHeader(input_header));
   // Store the actual sample rate of the input audio in the TimeSeriesHeader
@@ -271,6 +346,7 @@ const float SpectrogramCalculator::kLnPowerToDb = 4.342944819032518;
     cc->Outputs().Index(0).SetHeader(
         Adopt(multichannel_output_header.release()));
   }
+  cumulative_input_samples_ = 0;
   cumulative_completed_frames_ = 0;
   initial_input_timestamp_ = Timestamp::Unstarted();
   return ::mediapipe::OkStatus();
@@ -281,7 +357,13 @@ const float SpectrogramCalculator::kLnPowerToDb = 4.342944819032518;
     initial_input_timestamp_ = cc->InputTimestamp();
   }
 
-  const Matrix& input_stream = cc->Inputs().Index(0).Get<Matrix>();
+  if (int16_input_) {
+    Int16MatrixToMatrix(cc->Inputs().Tag("INT16_MATRIX").Get<Int16Matrix>(),
+                        &converted_input_stream_);
+  }
+  const Matrix& input_stream = int16_input_
+                                   ? converted_input_stream_
+                                   : cc->Inputs().Index(0).Get<Matrix>();
   if (input_stream.rows() != num_input_channels_) {
     ::mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
         << "Number of input channels do not correspond to the number of rows "
@@ -349,21 +431,111 @@ template <class OutputMatrixType>
   if (!spectrogram_matrices->empty()) {
     RET_CHECK_EQ(spectrogram_matrices->size(), input_stream.rows())
         << "Inconsistent number of spectrogram channels.";
-    if (allow_multichannel_input_) {
-      cc->Outputs().Index(0).Add(spectrogram_matrices.release(),
-                                 CurrentOutputTimestamp());
-    } else {
-      cc->Outputs().Index(0).Add(
-          new OutputMatrixType(spectrogram_matrices->at(0)),
-          CurrentOutputTimestamp());
-    }
+    OutputSpectrograms(std::move(spectrogram_matrices), cc);
     cumulative_completed_frames_ += output_vectors.size();
   }
   return ::mediapipe::OkStatus();
 }
 
+template <class OutputMatrixType>
+void SpectrogramCalculator::OutputSpectrograms(
+    std::unique_ptr<std::vector<OutputMatrixType>> spectrogram_matrices,
+    CalculatorContext* cc) {
+  if (allow_multichannel_input_) {
+    cc->Outputs().Index(0).Add(spectrogram_matrices.release(),
+                               CurrentOutputTimestamp());
+  } else {
+    cc->Outputs().Index(0).Add(
+        new OutputMatrixType(std::move(spectrogram_matrices->at(0))),
+        CurrentOutputTimestamp());
+  }
+}
+
+template <class OutputMatrixType>
+::mediapipe::Status SpectrogramCalculator::ProcessBatchedToOutput(
+    const Matrix& input_stream, CalculatorContext* cc) {
+  // Append the new samples, transposed so that each channel is a column.
+  const int num_new_samples = input_stream.cols();
+  if (num_batched_samples_ + num_new_samples > batched_samples_.rows()) {
+    batched_samples_.conservativeResize(
+        std::max<int>(2 * batched_samples_.rows(),
+                      num_batched_samples_ + num_new_samples),
+        Eigen::NoChange);
+  }
+  batched_samples_.middleRows(num_batched_samples_, num_new_samples) =
+      input_stream.transpose();
+  num_batched_samples_ += num_new_samples;
+
+  // As with the per-channel path, too few samples for a frame emits nothing.
+  if (num_batched_samples_ < frame_duration_samples_) {
+    return ::mediapipe::OkStatus();
+  }
+  const int num_frames =
+      (num_batched_samples_ - frame_duration_samples_) / frame_step_samples() +
+      1;
+
+  auto spectrogram_matrices = absl::make_unique<std::vector<OutputMatrixType>>(
+      num_input_channels_, OutputMatrixType(num_output_channels_, num_frames));
+  for (int frame = 0; frame < num_frames; ++frame) {
+    // Window all channels at once; the padding rows stay zero.
+    windowed_frames_.topRows(frame_duration_samples_) =
+        batched_samples_
+            .middleRows(frame * frame_step_samples(), frame_duration_samples_)
+            .array()
+            .colwise() *
+        window_.array();
+    for (int channel = 0; channel < num_input_channels_; ++channel) {
+      fft_.fwd(spectrum_.data(), windowed_frames_.col(channel).data(),
+               fft_length_);
+      SetOutputFrame(frame, &(*spectrogram_matrices)[channel]);
+    }
+  }
+
+  // Keep the samples that later frames still need.
+  const int num_consumed_samples = num_frames * frame_step_samples();
+  num_batched_samples_ -= num_consumed_samples;
+  batched_samples_.topRows(num_batched_samples_) =
+      batched_samples_.middleRows(num_consumed_samples, num_batched_samples_)
+          .eval();
+
+  OutputSpectrograms(std::move(spectrogram_matrices), cc);
+  cumulative_completed_frames_ += num_frames;
+  return ::mediapipe::OkStatus();
+}
+
+void SpectrogramCalculator::SetOutputFrame(int frame, Matrix* output) const {
+  const float scale = output_scale_;
+  const auto squared_magnitude = spectrum_.array().abs2();
+  switch (output_type_) {
+    case SpectrogramCalculatorOptions::LINEAR_MAGNITUDE:
+      output->col(frame) = scale * squared_magnitude.sqrt().matrix();
+      break;
+    case SpectrogramCalculatorOptions::DECIBELS:
+      output->col(frame) =
+          (scale * kLnPowerToDb) * squared_magnitude.log().matrix();
+      break;
+    default:
+      output->col(frame) = scale * squared_magnitude.matrix();
+      break;
+  }
+}
+
+void SpectrogramCalculator::SetOutputFrame(int frame,
+                                           Eigen::MatrixXcf* output) const {
+  // audio_dsp::Spectrogram returns the conjugate of Eigen's forward transform
+  // (it uses the exp(+i) kernel), so match it here.
+  const float scale = output_scale_;
+  output->col(frame) = scale * spectrum_.conjugate();
+}
+
 ::mediapipe::Status SpectrogramCalculator::ProcessVector(
     const Matrix& input_stream, CalculatorContext* cc) {
+  if (batch_channels_) {
+    if (output_type_ == SpectrogramCalculatorOptions::COMPLEX) {
+      return ProcessBatchedToOutput<Eigen::MatrixXcf>(input_stream, cc);
+    }
+    return ProcessBatchedToOutput<Matrix>(input_stream, cc);
+  }
   switch (output_type_) {
     // These blocks deliberately ignore clang-format to preserve the
     // "silhouette" of the different cases.
@@ -14,6 +14,7 @@
 
 #include <math.h>
 
+#include <algorithm>
 #include <cmath>
 #include <complex>
 #include <memory>
@@ -26,6 +27,7 @@
 #include "mediapipe/calculators/audio/spectrogram_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/formats/int16_matrix.h"
 #include "mediapipe/framework/formats/matrix.h"
 #include "mediapipe/framework/formats/time_series_header.pb.h"
 #include "mediapipe/framework/port/benchmark.h"
@@ -846,6 +848,165 @@ TEST_F(SpectrogramCalculatorTest,
   }
 }
 
+// Runs SpectrogramCalculator on "input", split into packets of
+// packet_size_samples, and returns the output packets.
+//
+// With int16_input set, "input" is passed as INT16_MATRIX packets of its
+// values times 32768, so it should hold multiples of 1 / 32768.
+std::vector<Packet> RunSpectrogram(const SpectrogramCalculatorOptions& options,
+                                   const Matrix& input, int packet_size_samples,
+                                   bool int16_input = false) {
+  CalculatorGraphConfig::Node node_config;
+  node_config.set_calculator("SpectrogramCalculator");
+  node_config.add_input_stream(int16_input ? "INT16_MATRIX:input_audio"
+                                           : "input_audio");
+  node_config.add_output_stream("output_spectrogram");
+  *node_config.mutable_options()->MutableExtension(
+      SpectrogramCalculatorOptions::ext) = options;
+
+  const double sample_rate = 4000.0;
+  TimeSeriesHeader* header = new TimeSeriesHeader();
+  header->set_sample_rate(sample_rate);
+  header->set_num_channels(input.rows());
+
+  CalculatorRunner runner(node_config);
+  auto& input_stream =
+      runner.MutableInputs()->Get(int16_input ? "INT16_MATRIX" : "", 0);
+  input_stream.header = Adopt(header);
+  for (int start = 0; start < input.cols(); start += packet_size_samples) {
+    const int size = std::min<int>(packet_size_samples, input.cols() - start);
+    const int64 timestamp =
+        round(start / sample_rate * Timestamp::kTimestampUnitsPerSecond);
+    if (int16_input) {
+      input_stream.packets.push_back(
+          Adopt(new Int16Matrix(
+                    (input.middleCols(start, size) * 32768.0f).cast<int16>()))
+              .At(Timestamp(timestamp)));
+    } else {
+      input_stream.packets.push_back(
+          Adopt(new Matrix(input.middleCols(start, size)))
+              .At(Timestamp(timestamp)));
+    }
+  }
+  MEDIAPIPE_CHECK_OK(runner.Run());
+  return runner.Outputs().Index(0).packets;
+}
+
+TEST(SpectrogramCalculatorBatchTest, BatchedMatchesPerChannel) {
+  const Matrix input = Matrix::Random(3, 1013);
+  for (auto output_type : {SpectrogramCalculatorOptions::SQUARED_MAGNITUDE,
+                           SpectrogramCalculatorOptions::DECIBELS,
+                           SpectrogramCalculatorOptions::COMPLEX}) {
+    SpectrogramCalculatorOptions options;
+    options.set_frame_duration_seconds(100.0 / 4000.0);
+    options.set_frame_overlap_seconds(60.0 / 4000.0);
+    options.set_allow_multichannel_input(true);
+    options.set_output_type(output_type);
+    options.set_output_scale(2.0);
+    // Packet sizes that leave partial frames between packets.
+    const std::vector<Packet> expected = RunSpectrogram(options, input, 130);
+    options.set_batch_channels(true);
+    const std::vector<Packet> actual = RunSpectrogram(options, input, 130);
+
+    ASSERT_EQ(expected.size(), actual.size());
+    for (int i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(expected[i].Timestamp(), actual[i].Timestamp());
+      if (output_type == SpectrogramCalculatorOptions::COMPLEX) {
+        const auto& expected_matrices =
+            expected[i].Get<std::vector<Eigen::MatrixXcf>>();
+        const auto& actual_matrices =
+            actual[i].Get<std::vector<Eigen::MatrixXcf>>();
+        ASSERT_EQ(expected_matrices.size(), actual_matrices.size());
+        for (int channel = 0; channel < expected_matrices.size(); ++channel) {
+          EXPECT_TRUE(actual_matrices[channel].isApprox(
+              expected_matrices[channel], 1e-4));
+        }
+      } else {
+        const auto& expected_matrices = expected[i].Get<std::vector<Matrix>>();
+        const auto& actual_matrices = actual[i].Get<std::vector<Matrix>>();
+        ASSERT_EQ(expected_matrices.size(), actual_matrices.size());
+        for (int channel = 0; channel < expected_matrices.size(); ++channel) {
+          EXPECT_TRUE(actual_matrices[channel].isApprox(
+              expected_matrices[channel], 1e-4));
+        }
+      }
+    }
+  }
+}
+
+TEST(SpectrogramCalculatorInt16Test, Int16InputMatchesMatrixInput) {
+  const Int16Matrix pcm = (Matrix::Random(2, 1013) * 32767.0f).cast<int16>();
+  Matrix input;
+  Int16MatrixToMatrix(pcm, &input);
+  for (bool batch_channels : {false, true}) {
+    SpectrogramCalculatorOptions options;
+    options.set_frame_duration_seconds(100.0 / 4000.0);
+    options.set_frame_overlap_seconds(60.0 / 4000.0);
+    options.set_allow_multichannel_input(true);
+    options.set_batch_channels(batch_channels);
+    const std::vector<Packet> expected = RunSpectrogram(options, input, 130);
+    const std::vector<Packet> actual =
+        RunSpectrogram(options, input, 130, /*int16_input=*/true);
+
+    ASSERT_EQ(expected.size(), actual.size());
+    ASSERT_FALSE(actual.empty());
+    for (int i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(expected[i].Timestamp(), actual[i].Timestamp());
+      EXPECT_EQ(expected[i].Get<std::vector<Matrix>>(),
+                actual[i].Get<std::vector<Matrix>>());
+    }
+  }
+}
+
+// Reports the real-time factor, i.e. seconds of audio processed per second,
+// as the "audio_seconds" rate. Arguments are the number of channels and
+// whether batch_channels is set.
+void BM_RealTimeFactor(benchmark::State& state) {
+  const int num_input_channels = state.range(0);
+  const double sample_rate = 16000.0;
+  const int packet_size_samples = 1600;  // 100ms packets.
+  const int num_packets = 100;
+
+  CalculatorGraphConfig::Node node_config;
+  node_config.set_calculator("SpectrogramCalculator");
+  node_config.add_input_stream("input_audio");
+  node_config.add_output_stream("output_spectrogram");
+  SpectrogramCalculatorOptions* options =
+      node_config.mutable_options()->MutableExtension(
+          SpectrogramCalculatorOptions::ext);
+  options->set_frame_duration_seconds(0.025);
+  options->set_frame_overlap_seconds(0.015);
+  options->set_pad_final_packet(false);
+  options->set_allow_multichannel_input(true);
+  options->set_batch_channels(state.range(1));
+
+  TimeSeriesHeader* header = new TimeSeriesHeader();
+  header->set_sample_rate(sample_rate);
+  header->set_num_channels(num_input_channels);
+  CalculatorRunner runner(node_config);
+  runner.MutableInputs()->Index(0).header = Adopt(header);
+  for (int i = 0; i < num_packets; ++i) {
+    runner.MutableInputs()->Index(0).packets.push_back(
+        Adopt(new Matrix(
+                  Matrix::Random(num_input_channels, packet_size_samples)))
+            .At(Timestamp(i * 100000)));
+  }
+
+  for (auto _ : state) {
+    ASSERT_TRUE(runner.Run().ok());
+  }
+  state.counters["audio_seconds"] = benchmark::Counter(
+      num_packets * packet_size_samples / sample_rate,
+      benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_RealTimeFactor)
+    ->ArgPair(1, false)
+    ->ArgPair(1, true)
+    ->ArgPair(2, false)
+    ->ArgPair(2, true)
+    ->ArgPair(8, false)
+    ->ArgPair(8, true);
+
 void BM_ProcessDC(benchmark::State& state) {
   CalculatorGraphConfig::Node node_config;
   node_config.set_calculator("SpectrogramCalculator");
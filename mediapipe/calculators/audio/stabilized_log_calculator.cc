@@ -23,6 +23,8 @@
 #include "mediapipe/framework/formats/matrix.h"
 #include "mediapipe/framework/formats/time_series_header.pb.h"
 #include "mediapipe/framework/port/proto_ns.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/port/statusor.h"
 #include "mediapipe/util/time_series_util.h"
 
 namespace mediapipe {
@@ -74,12 +76,15 @@ class StabilizedLogCalculator : public CalculatorBase {
   }
 
   ::mediapipe::Status Process(CalculatorContext* cc) override {
-    auto input_matrix = cc->Inputs().Index(0).Get<Matrix>();
+    // Computes the log in place when this calculator holds the only reference
+    // to the input packet, and on a copy of the input otherwise.
+    ASSIGN_OR_RETURN(std::unique_ptr<Matrix> output_frame,
+                     cc->Inputs().Index(0).Value().ConsumeOrCopy<Matrix>());
     if (check_nonnegativity_) {
-      CHECK_GE(input_matrix.minCoeff(), 0);
+      CHECK_GE(output_frame->minCoeff(), 0);
     }
-    std::unique_ptr<Matrix> output_frame(new Matrix(
-        output_scale_ * (input_matrix.array() + stabilizer_).log().matrix()));
+    output_frame->array() =
+        output_scale_ * (output_frame->array() + stabilizer_).log();
     cc->Outputs().Index(0).Add(output_frame.release(), cc->InputTimestamp());
     return ::mediapipe::OkStatus();
   }
@@ -15,7 +15,7 @@
 // Defines TimeSeriesFramerCalculator.
 #include <math.h>
 
-#include <deque>
+#include <algorithm>
 #include <memory>
 #include <string>
 
@@ -23,15 +23,23 @@
 #include "audio/dsp/window_functions.h"
 #include "mediapipe/calculators/audio/time_series_framer_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/int16_matrix.h"
 #include "mediapipe/framework/formats/matrix.h"
 #include "mediapipe/framework/formats/time_series_header.pb.h"
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
 #include "mediapipe/util/time_series_util.h"
 
 namespace mediapipe {
 
+namespace {
+
+constexpr char kInt16MatrixTag[] = "INT16_MATRIX";
+
+}  // namespace
+
 // MediaPipe Calculator for framing a (vector-valued) input time series,
 // i.e. for breaking an input time series into fixed-size, possibly
 // overlapping, frames.  The output stream's frame duration is
@@ -56,12 +64,23 @@ namespace mediapipe {
 // If pad_final_packet is true, all input samples will be emitted and the final
 // packet will be zero padded as necessary.  If pad_final_packet is false, some
 // samples may be dropped at the end of the stream.
+//
+// The input may instead be given as 16-bit samples on an INT16_MATRIX stream
+// (an Int16Matrix with the same TimeSeriesHeader). The samples are converted
+// to float as they are copied into the frame buffer, so no float copy of the
+// input packet is made.
 class TimeSeriesFramerCalculator : public CalculatorBase {
  public:
   static ::mediapipe::Status GetContract(CalculatorContract* cc) {
-    cc->Inputs().Index(0).Set<Matrix>(
-        // Input stream with TimeSeriesHeader.
-    );
+    if (cc->Inputs().HasTag(kInt16MatrixTag)) {
+      cc->Inputs().Tag(kInt16MatrixTag).Set<Int16Matrix>(
+          // Input stream of 16-bit samples with TimeSeriesHeader.
+      );
+    } else {
+      cc->Inputs().Index(0).Set<Matrix>(
+          // Input stream with TimeSeriesHeader.
+      );
+    }
     cc->Outputs().Index(0).Set<Matrix>(
         // Fixed length time series Packets with TimeSeriesHeader.
     );
@@ -72,7 +91,7 @@ class TimeSeriesFramerCalculator : public CalculatorBase {
   ::mediapipe::Status Open(CalculatorContext* cc) override;
 
   // Outputs as many framed packets as possible given the accumulated
-  // input.  Always returns OK.
+  // input.  Returns an error if the input has the wrong number of channels.
   ::mediapipe::Status Process(CalculatorContext* cc) override;
 
   // Flushes any remaining samples in a zero-padded packet.  Always
@@ -80,11 +99,24 @@ class TimeSeriesFramerCalculator : public CalculatorBase {
   ::mediapipe::Status Close(CalculatorContext* cc) override;
 
  private:
-  // Adds input data to the internal buffer.
-  void EnqueueInput(CalculatorContext* cc);
+  // Adds input data to the internal buffer. Returns an error if the input
+  // does not have num_channels_ rows.
+  ::mediapipe::Status EnqueueInput(CalculatorContext* cc);
+  // Copies num_samples input samples, starting at input_start, into the
+  // sample buffer at column buffer_start.
+  void CopyInputSamples(const Matrix& input, int input_start,
+                        int buffer_start, int num_samples);
+  void CopyInputSamples(const Int16Matrix& input, int input_start,
+                        int buffer_start, int num_samples);
   // Constructs and emits framed output packets.
   void FrameOutput(CalculatorContext* cc);
 
+  // Copies the first num_samples buffered samples into the leading columns of
+  // "output", with at most two block copies.
+  void CopyBufferedSamples(int num_samples, Matrix* output) const;
+  // Removes the first num_samples buffered samples.
+  void DropBufferedSamples(int num_samples);
+
   Timestamp CurrentOutputTimestamp() {
     return initial_input_timestamp_ +
            round(cumulative_completed_samples_ / sample_rate_ *
@@ -119,53 +151,120 @@ class TimeSeriesFramerCalculator : public CalculatorBase {
   int64 cumulative_completed_samples_;
   Timestamp initial_input_timestamp_;
   int num_channels_;
+  // Whether the input is an INT16_MATRIX stream.
+  bool int16_input_;
 
-  // Each entry in this deque consists of a single sample, i.e. a
-  // single column vector.
-  std::deque<Matrix> sample_buffer_;
+  // Circular buffer of samples, one column per sample. The buffered samples
+  // start at column sample_buffer_start_ and wrap around at the end of the
+  // matrix. It only grows, so steady state framing does not allocate.
+  Matrix sample_buffer_;
+  int sample_buffer_start_ = 0;
+  int sample_buffer_size_ = 0;
 
   bool use_window_;
   Matrix window_;
 };
 REGISTER_CALCULATOR(TimeSeriesFramerCalculator);
 
-void TimeSeriesFramerCalculator::EnqueueInput(CalculatorContext* cc) {
-  const Matrix& input_frame = cc->Inputs().Index(0).Get<Matrix>();
+void TimeSeriesFramerCalculator::CopyInputSamples(const Matrix& input,
+                                                  int input_start,
+                                                  int buffer_start,
+                                                  int num_samples) {
+  sample_buffer_.middleCols(buffer_start, num_samples) =
+      input.middleCols(input_start, num_samples);
+}
+
+void TimeSeriesFramerCalculator::CopyInputSamples(const Int16Matrix& input,
+                                                  int input_start,
+                                                  int buffer_start,
+                                                  int num_samples) {
+  // Both matrices are column-major with num_channels_ rows, so each block is
+  // one contiguous run of values.
+  Int16ToFloat(input.data() + input_start * num_channels_,
+               num_samples * num_channels_,
+               sample_buffer_.data() + buffer_start * num_channels_);
+}
+
+::mediapipe::Status TimeSeriesFramerCalculator::EnqueueInput(
+    CalculatorContext* cc) {
+  const Matrix* input_frame = nullptr;
+  const Int16Matrix* int16_input_frame = nullptr;
+  int num_input_samples;
+  if (int16_input_) {
+    int16_input_frame = &cc->Inputs().Tag(kInt16MatrixTag).Get<Int16Matrix>();
+    RET_CHECK_EQ(int16_input_frame->rows(), num_channels_);
+    num_input_samples = int16_input_frame->cols();
+  } else {
+    input_frame = &cc->Inputs().Index(0).Get<Matrix>();
+    RET_CHECK_EQ(input_frame->rows(), num_channels_);
+    num_input_samples = input_frame->cols();
+  }
+
+  const int capacity = sample_buffer_.cols();
+  if (sample_buffer_size_ + num_input_samples > capacity) {
+    // Grow geometrically, unwrapping the buffered samples to the front.
+    Matrix grown(num_channels_, std::max(2 * capacity, sample_buffer_size_ +
+                                                           num_input_samples));
+    CopyBufferedSamples(sample_buffer_size_, &grown);
+    sample_buffer_.swap(grown);
+    sample_buffer_start_ = 0;
+  }
 
-  for (int i = 0; i < input_frame.cols(); ++i) {
-    sample_buffer_.emplace_back(input_frame.col(i));
+  // Copy into the free space after the buffered samples, in at most two
+  // blocks.
+  const int end = (sample_buffer_start_ + sample_buffer_size_) %
+                  sample_buffer_.cols();
+  const int first_block =
+      std::min<int>(num_input_samples, sample_buffer_.cols() - end);
+  if (int16_input_) {
+    CopyInputSamples(*int16_input_frame, 0, end, first_block);
+    CopyInputSamples(*int16_input_frame, first_block, 0,
+                     num_input_samples - first_block);
+  } else {
+    CopyInputSamples(*input_frame, 0, end, first_block);
+    CopyInputSamples(*input_frame, first_block, 0,
+                     num_input_samples - first_block);
   }
+  sample_buffer_size_ += num_input_samples;
+
+  cumulative_input_samples_ += num_input_samples;
+  return ::mediapipe::OkStatus();
+}
 
-  cumulative_input_samples_ += input_frame.cols();
+void TimeSeriesFramerCalculator::CopyBufferedSamples(int num_samples,
+                                                     Matrix* output) const {
+  const int first_block = std::min<int>(
+      num_samples, sample_buffer_.cols() - sample_buffer_start_);
+  output->leftCols(first_block) =
+      sample_buffer_.middleCols(sample_buffer_start_, first_block);
+  output->middleCols(first_block, num_samples - first_block) =
+      sample_buffer_.leftCols(num_samples - first_block);
+}
+
+void TimeSeriesFramerCalculator::DropBufferedSamples(int num_samples) {
+  sample_buffer_start_ =
+      (sample_buffer_start_ + num_samples) % sample_buffer_.cols();
+  sample_buffer_size_ -= num_samples;
 }
 
 void TimeSeriesFramerCalculator::FrameOutput(CalculatorContext* cc) {
-  while (sample_buffer_.size() >=
+  while (sample_buffer_size_ >=
          frame_duration_samples_ + samples_still_to_drop_) {
-    while (samples_still_to_drop_ > 0) {
-      sample_buffer_.pop_front();
-      --samples_still_to_drop_;
-    }
+    DropBufferedSamples(samples_still_to_drop_);
+    samples_still_to_drop_ = 0;
     const int frame_step_samples = next_frame_step_samples();
     std::unique_ptr<Matrix> output_frame(
         new Matrix(num_channels_, frame_duration_samples_));
-    for (int i = 0; i < std::min(frame_step_samples, frame_duration_samples_);
-         ++i) {
-      output_frame->col(i) = sample_buffer_.front();
-      sample_buffer_.pop_front();
-    }
+    CopyBufferedSamples(frame_duration_samples_, output_frame.get());
+    DropBufferedSamples(std::min(frame_step_samples, frame_duration_samples_));
     const int frame_overlap_samples =
         frame_duration_samples_ - frame_step_samples;
-    if (frame_overlap_samples > 0) {
-      for (int i = 0; i < frame_overlap_samples; ++i) {
-        output_frame->col(i + frame_step_samples) = sample_buffer_[i];
-      }
-    } else {
+    if (frame_overlap_samples < 0) {
       samples_still_to_drop_ = -frame_overlap_samples;
     }
 
     if (use_window_) {
-      *output_frame = (output_frame->array() * window_.array()).matrix();
+      output_frame->array() *= window_.array();
     }
 
     cc->Outputs().Index(0).Add(output_frame.release(),
@@ -180,23 +279,22 @@ void TimeSeriesFramerCalculator::FrameOutput(CalculatorContext* cc) {
     initial_input_timestamp_ = cc->InputTimestamp();
   }
 
-  EnqueueInput(cc);
+  MP_RETURN_IF_ERROR(EnqueueInput(cc));
   FrameOutput(cc);
 
   return ::mediapipe::OkStatus();
 }
 
 ::mediapipe::Status TimeSeriesFramerCalculator::Close(CalculatorContext* cc) {
-  while (samples_still_to_drop_ > 0 && !sample_buffer_.empty()) {
-    sample_buffer_.pop_front();
-    --samples_still_to_drop_;
+  const int num_dropped = std::min(samples_still_to_drop_, sample_buffer_size_);
+  if (num_dropped > 0) {
+    DropBufferedSamples(num_dropped);
+    samples_still_to_drop_ -= num_dropped;
   }
-  if (!sample_buffer_.empty() && pad_final_packet_) {
+  if (sample_buffer_size_ > 0 && pad_final_packet_) {
     std::unique_ptr<Matrix> output_frame(new Matrix);
     output_frame->setZero(num_channels_, frame_duration_samples_);
-    for (int i = 0; i < sample_buffer_.size(); ++i) {
-      output_frame->col(i) = sample_buffer_[i];
-    }
+    CopyBufferedSamples(sample_buffer_size_, output_frame.get());
 
     cc->Outputs().Index(0).Add(output_frame.release(),
                                CurrentOutputTimestamp());
@@ -218,9 +316,12 @@ void TimeSeriesFramerCalculator::FrameOutput(CalculatorContext* cc) {
       << "Invalid frame_overlap_seconds. framer_overlap_seconds: \n"
       << framer_options.frame_overlap_seconds();
 
+  int16_input_ = cc->Inputs().HasTag(kInt16MatrixTag);
   TimeSeriesHeader input_header;
   MP_RETURN_IF_ERROR(time_series_util::FillTimeSeriesHeaderIfValid(
-      cc->Inputs().Index(0).Header(), &input_header));
+      int16_input_ ? cc->Inputs().Tag(kInt16MatrixTag).Header()
+                   : cc->Inputs().Index(0).Header(),
+      &input_header));
 
   sample_rate_ = input_header.sample_rate();
   num_channels_ = input_header.num_channels();
@@ -258,6 +359,11 @@ void TimeSeriesFramerCalculator::FrameOutput(CalculatorContext* cc) {
   cumulative_output_frames_ = 0;
   samples_still_to_drop_ = 0;
   initial_input_timestamp_ = Timestamp::Unstarted();
+  // Room for two frames up front; EnqueueInput() grows it if packets are
+  // larger.
+  sample_buffer_.resize(num_channels_, 2 * frame_duration_samples_);
+  sample_buffer_start_ = 0;
+  sample_buffer_size_ = 0;
 
   std::vector<double> window_vector;
   use_window_ = false;
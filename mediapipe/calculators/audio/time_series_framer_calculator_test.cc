@@ -14,6 +14,7 @@
 
 #include <math.h>
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
@@ -23,6 +24,7 @@
 #include "mediapipe/calculators/audio/time_series_framer_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/formats/int16_matrix.h"
 #include "mediapipe/framework/formats/matrix.h"
 #include "mediapipe/framework/formats/time_series_header.pb.h"
 #include "mediapipe/framework/port/gmock.h"
@@ -391,5 +393,66 @@ TEST_F(TimeSeriesFramerCalculatorWindowingSanityTest, HannWindowSanityCheck) {
   RunAndTestSinglePacketAverage(0.5f);
 }
 
+// Runs TimeSeriesFramerCalculator on "input", split into packets of
+// packet_size_samples, as INT16_MATRIX packets if int16_input is set and as
+// Matrix packets otherwise. Returns the output packets.
+std::vector<Packet> RunFramer(const TimeSeriesFramerCalculatorOptions& options,
+                              const Int16Matrix& input, int packet_size_samples,
+                              bool int16_input) {
+  CalculatorGraphConfig::Node node_config;
+  node_config.set_calculator("TimeSeriesFramerCalculator");
+  node_config.add_input_stream(int16_input ? "INT16_MATRIX:input_audio"
+                                           : "input_audio");
+  node_config.add_output_stream("framed_audio");
+  *node_config.mutable_options()->MutableExtension(
+      TimeSeriesFramerCalculatorOptions::ext) = options;
+
+  const double sample_rate = 4000.0;
+  TimeSeriesHeader* header = new TimeSeriesHeader();
+  header->set_sample_rate(sample_rate);
+  header->set_num_channels(input.rows());
+
+  CalculatorRunner runner(node_config);
+  auto& input_stream =
+      runner.MutableInputs()->Get(int16_input ? "INT16_MATRIX" : "", 0);
+  input_stream.header = Adopt(header);
+  for (int start = 0; start < input.cols(); start += packet_size_samples) {
+    const int size = std::min<int>(packet_size_samples, input.cols() - start);
+    const Timestamp timestamp(
+        round(start / sample_rate * Timestamp::kTimestampUnitsPerSecond));
+    const Int16Matrix packet_samples = input.middleCols(start, size);
+    if (int16_input) {
+      input_stream.packets.push_back(
+          Adopt(new Int16Matrix(packet_samples)).At(timestamp));
+    } else {
+      Matrix* matrix = new Matrix;
+      Int16MatrixToMatrix(packet_samples, matrix);
+      input_stream.packets.push_back(Adopt(matrix).At(timestamp));
+    }
+  }
+  MEDIAPIPE_CHECK_OK(runner.Run());
+  return runner.Outputs().Index(0).packets;
+}
+
+TEST(TimeSeriesFramerCalculatorInt16Test, Int16InputMatchesMatrixInput) {
+  const Int16Matrix input =
+      (Matrix::Random(2, 1013) * 32767.0f).cast<int16>();
+  TimeSeriesFramerCalculatorOptions options;
+  options.set_frame_duration_seconds(100.0 / 4000.0);
+  options.set_frame_overlap_seconds(30.0 / 4000.0);
+  options.set_pad_final_packet(true);
+  options.set_window_function(TimeSeriesFramerCalculatorOptions::HANN);
+  // Packet sizes that wrap the frame buffer and leave partial frames.
+  const std::vector<Packet> expected = RunFramer(options, input, 130, false);
+  const std::vector<Packet> actual = RunFramer(options, input, 130, true);
+
+  ASSERT_EQ(expected.size(), actual.size());
+  ASSERT_FALSE(actual.empty());
+  for (int i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i].Timestamp(), actual[i].Timestamp());
+    EXPECT_EQ(expected[i].Get<Matrix>(), actual[i].Get<Matrix>());
+  }
+}
+
 }  // anonymous namespace
 }  // namespace mediapipe
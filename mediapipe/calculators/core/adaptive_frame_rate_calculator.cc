@@ -0,0 +1,217 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <vector>
+
+#include "mediapipe/calculators/core/adaptive_frame_rate_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/util/header_util.h"
+
+namespace mediapipe {
+
+namespace {
+
+// The frame rates at thermal statuses LIGHT to CRITICAL if none are
+// configured.
+constexpr double kDefaultThrottledFrameRates[] = {24, 15, 10, 5};
+
+// The fraction of a frame period by which a frame may arrive early and still
+// be kept, to tolerate jitter in the input timestamps.
+constexpr double kJitterTolerance = 0.1;
+
+}  // namespace
+
+// Lowers the frame rate of a stream while the device is hot or saving power,
+// so that a graph settles at a frame rate it can sustain instead of running
+// at full speed until the platform throttles it, and then oscillating between
+// full and throttled speed.
+//
+// The platform state is sent to the graph by the application:
+// - THERMAL_STATUS follows Android's PowerManager.THERMAL_STATUS_* values,
+//   from NONE (0) to SHUTDOWN (6).  On iOS, ProcessInfo.ThermalState nominal,
+//   fair, serious and critical map to 0, 1, 2 and 4.
+// - LOW_POWER is PowerManager.isPowerSaveMode() on Android, and
+//   ProcessInfo.isLowPowerModeEnabled on iOS.
+// Each status selects a frame rate from the options, and the lowest applies.
+// A lower frame rate takes effect at once, but a higher one only after it has
+// been selected for recovery_delay_usec, so that a device hovering around a
+// thermal threshold does not flip between frame rates.
+//
+// Frames are dropped to stay under the frame rate.  Since the calculator
+// decides from input timestamps, it is deterministic and can be placed in
+// front of a FlowLimiterCalculator, which in adaptive mode still bounds the
+// latency of the frames that are kept.
+//
+// Inputs:
+//   The stream to throttle, usually of video frames.
+//   THERMAL_STATUS (optional): An int, the thermal status of the device.
+//   LOW_POWER (optional): A bool, true while the device is saving power.
+// Outputs:
+//   The kept packets of the input stream.
+//   FRAME_RATE (optional): A double, the current frame rate, output whenever
+//     it changes.  Its timestamps count the changes.
+//
+// Example config:
+//   node {
+//     calculator: "AdaptiveFrameRateCalculator"
+//     input_stream: "input_video"
+//     input_stream: "THERMAL_STATUS:thermal_status"
+//     input_stream: "LOW_POWER:low_power"
+//     output_stream: "throttled_video"
+//     options {
+//       [mediapipe.AdaptiveFrameRateCalculatorOptions.ext] {
+//         max_frame_rate: 30
+//         throttled_frame_rate: [ 24, 20, 15, 10 ]
+//       }
+//     }
+//   }
+class AdaptiveFrameRateCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    RET_CHECK_EQ(cc->Inputs().NumEntries(""), 1);
+    RET_CHECK_EQ(cc->Outputs().NumEntries(""), 1);
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).SetSameAs(&cc->Inputs().Index(0));
+    if (cc->Inputs().HasTag("THERMAL_STATUS")) {
+      cc->Inputs().Tag("THERMAL_STATUS").Set<int>();
+    }
+    if (cc->Inputs().HasTag("LOW_POWER")) {
+      cc->Inputs().Tag("LOW_POWER").Set<bool>();
+    }
+    if (cc->Outputs().HasTag("FRAME_RATE")) {
+      cc->Outputs().Tag("FRAME_RATE").Set<double>();
+    }
+    // The platform state arrives independently of the frames.
+    cc->SetInputStreamHandler("ImmediateInputStreamHandler");
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) final {
+    options_ = cc->Options<AdaptiveFrameRateCalculatorOptions>();
+    RET_CHECK_GT(options_.max_frame_rate(), 0);
+    RET_CHECK_GT(options_.low_power_frame_rate(), 0);
+    RET_CHECK_GE(options_.recovery_delay_usec(), 0);
+    throttled_frame_rates_.assign(options_.throttled_frame_rate().begin(),
+                                  options_.throttled_frame_rate().end());
+    if (throttled_frame_rates_.empty()) {
+      throttled_frame_rates_.assign(std::begin(kDefaultThrottledFrameRates),
+                                    std::end(kDefaultThrottledFrameRates));
+    }
+    for (double frame_rate : throttled_frame_rates_) {
+      RET_CHECK_GT(frame_rate, 0);
+    }
+    frame_rate_ = options_.max_frame_rate();
+    RET_CHECK_OK(CopyInputHeadersToOutputs(cc->Inputs(), &cc->Outputs()));
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) final {
+    if (cc->InputTimestamp().IsRangeValue()) {
+      now_ = std::max(now_, cc->InputTimestamp());
+    }
+    if (cc->Inputs().HasTag("THERMAL_STATUS") &&
+        !cc->Inputs().Tag("THERMAL_STATUS").IsEmpty()) {
+      thermal_status_ = cc->Inputs().Tag("THERMAL_STATUS").Get<int>();
+      RET_CHECK_GE(thermal_status_, 0);
+    }
+    if (cc->Inputs().HasTag("LOW_POWER") &&
+        !cc->Inputs().Tag("LOW_POWER").IsEmpty()) {
+      low_power_ = cc->Inputs().Tag("LOW_POWER").Get<bool>();
+    }
+    UpdateFrameRate(cc);
+
+    const Packet& packet = cc->Inputs().Index(0).Value();
+    if (packet.IsEmpty()) {
+      return ::mediapipe::OkStatus();
+    }
+    const double period = Timestamp::kTimestampUnitsPerSecond / frame_rate_;
+    const double time = packet.Timestamp().Value();
+    if (next_frame_time_set_ &&
+        time < next_frame_time_ - kJitterTolerance * period) {
+      cc->Outputs().Index(0).SetNextTimestampBound(packet.Timestamp() + 1);
+      return ::mediapipe::OkStatus();
+    }
+    // Frames are kept on a fixed schedule, so that the output frame rate
+    // does not round down to an integer fraction of the input frame rate,
+    // unless the input fell behind the schedule by a whole period.
+    if (!next_frame_time_set_ || time - next_frame_time_ > period) {
+      next_frame_time_ = time;
+      next_frame_time_set_ = true;
+    }
+    next_frame_time_ += period;
+    cc->Outputs().Index(0).AddPacket(packet);
+    return ::mediapipe::OkStatus();
+  }
+
+ private:
+  // Returns the frame rate selected by the current platform state.
+  double TargetFrameRate() const {
+    double frame_rate = options_.max_frame_rate();
+    if (thermal_status_ > 0) {
+      const int index = std::min<int>(thermal_status_,
+                                      throttled_frame_rates_.size()) -
+                        1;
+      frame_rate = std::min(frame_rate, throttled_frame_rates_[index]);
+    }
+    if (low_power_) {
+      frame_rate = std::min(frame_rate, options_.low_power_frame_rate());
+    }
+    return frame_rate;
+  }
+
+  // Moves frame_rate_ towards the target frame rate.
+  void UpdateFrameRate(CalculatorContext* cc) {
+    const double target = TargetFrameRate();
+    double frame_rate = frame_rate_;
+    if (target <= frame_rate_) {
+      frame_rate = target;
+      recovery_start_ = Timestamp::Unset();
+    } else if (recovery_start_ == Timestamp::Unset()) {
+      recovery_start_ = now_;
+    } else if ((now_ - recovery_start_).Value() >=
+               options_.recovery_delay_usec()) {
+      frame_rate = target;
+      recovery_start_ = Timestamp::Unset();
+    }
+    if (frame_rate == frame_rate_) {
+      return;
+    }
+    frame_rate_ = frame_rate;
+    if (cc->Outputs().HasTag("FRAME_RATE")) {
+      cc->Outputs()
+          .Tag("FRAME_RATE")
+          .AddPacket(MakePacket<double>(frame_rate_).At(++frame_rate_ctr_ts_));
+    }
+  }
+
+  AdaptiveFrameRateCalculatorOptions options_;
+  std::vector<double> throttled_frame_rates_;
+  int thermal_status_ = 0;
+  bool low_power_ = false;
+  // The current frame rate, and since when a higher one has been selected.
+  double frame_rate_ = 0;
+  Timestamp recovery_start_ = Timestamp::Unset();
+  // The latest input timestamp.
+  Timestamp now_ = Timestamp::Unset();
+  // The earliest time of the next kept frame.
+  double next_frame_time_ = 0;
+  bool next_frame_time_set_ = false;
+  Timestamp frame_rate_ctr_ts_ = Timestamp(0);
+};
+REGISTER_CALCULATOR(AdaptiveFrameRateCalculator);
+
+}  // namespace mediapipe
@@ -0,0 +1,175 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/tool/sink.h"
+
+namespace mediapipe {
+
+namespace {
+
+constexpr int64 kFramePeriod = 33333;
+// The time of 30 frames.
+constexpr int64 kSecond = 30 * kFramePeriod;
+
+// Runs the calculator on 30 fps frames for "num_frames" frames, with the
+// THERMAL_STATUS and LOW_POWER packets at the given timestamps, and returns
+// the timestamps of the kept frames.  The FRAME_RATE output is stored in
+// "frame_rates".
+std::vector<int64> RunCalculator(const std::string& options, int num_frames,
+                                 const std::map<int64, int>& thermal_statuses,
+                                 const std::map<int64, bool>& low_power,
+                                 std::vector<double>* frame_rates) {
+  CalculatorGraphConfig config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(absl::StrCat(R"(
+        input_stream: "frames"
+        input_stream: "thermal_status"
+        input_stream: "low_power"
+        node {
+          calculator: "AdaptiveFrameRateCalculator"
+          input_stream: "frames"
+          input_stream: "THERMAL_STATUS:thermal_status"
+          input_stream: "LOW_POWER:low_power"
+          output_stream: "kept_frames"
+          output_stream: "FRAME_RATE:frame_rate"
+          options {
+            [mediapipe.AdaptiveFrameRateCalculatorOptions.ext] {)",
+                                                              options, R"(}
+          }
+        }
+      )"));
+  std::vector<Packet> kept_frames;
+  std::vector<Packet> frame_rate_packets;
+  tool::AddVectorSink("kept_frames", &config, &kept_frames);
+  tool::AddVectorSink("frame_rate", &config, &frame_rate_packets);
+
+  CalculatorGraph graph;
+  MP_EXPECT_OK(graph.Initialize(config));
+  MP_EXPECT_OK(graph.StartRun({}));
+  // The packets are added in timestamp order, so that the calculator sees
+  // the platform state and the frames in that order.
+  auto thermal_it = thermal_statuses.begin();
+  auto low_power_it = low_power.begin();
+  for (int i = 0; i < num_frames; ++i) {
+    const int64 time = i * kFramePeriod;
+    for (; thermal_it != thermal_statuses.end() && thermal_it->first <= time;
+         ++thermal_it) {
+      MP_EXPECT_OK(graph.AddPacketToInputStream(
+          "thermal_status", MakePacket<int>(thermal_it->second)
+                                .At(Timestamp(thermal_it->first))));
+    }
+    for (; low_power_it != low_power.end() && low_power_it->first <= time;
+         ++low_power_it) {
+      MP_EXPECT_OK(graph.AddPacketToInputStream(
+          "low_power", MakePacket<bool>(low_power_it->second)
+                           .At(Timestamp(low_power_it->first))));
+    }
+    MP_EXPECT_OK(graph.AddPacketToInputStream(
+        "frames", MakePacket<int>(i).At(Timestamp(time))));
+  }
+  MP_EXPECT_OK(graph.CloseAllInputStreams());
+  MP_EXPECT_OK(graph.WaitUntilDone());
+
+  std::vector<int64> result;
+  for (const Packet& packet : kept_frames) {
+    result.push_back(packet.Timestamp().Value());
+  }
+  frame_rates->clear();
+  for (const Packet& packet : frame_rate_packets) {
+    frame_rates->push_back(packet.Get<double>());
+  }
+  return result;
+}
+
+// Returns the number of timestamps in [begin, end).
+int CountBetween(const std::vector<int64>& timestamps, int64 begin,
+                 int64 end) {
+  int count = 0;
+  for (int64 timestamp : timestamps) {
+    if (timestamp >= begin && timestamp < end) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+TEST(AdaptiveFrameRateCalculatorTest, KeepsAllFramesWhenNotThrottled) {
+  std::vector<double> frame_rates;
+  std::vector<int64> kept =
+      RunCalculator("", 30, {{0, 0}}, {{0, false}}, &frame_rates);
+  EXPECT_EQ(30, kept.size());
+  EXPECT_TRUE(frame_rates.empty());
+}
+
+TEST(AdaptiveFrameRateCalculatorTest, LowersFrameRateAtOnce) {
+  std::vector<double> frame_rates;
+  // Thermal status MODERATE selects 15 fps, and SEVERE 10 fps.
+  std::vector<int64> kept =
+      RunCalculator("", 90, {{0, 2}, {kSecond, 3}}, {}, &frame_rates);
+  EXPECT_EQ(15, CountBetween(kept, 0, kSecond));
+  EXPECT_EQ(10, CountBetween(kept, kSecond, 2 * kSecond));
+  EXPECT_EQ(10, CountBetween(kept, 2 * kSecond, 3 * kSecond));
+  EXPECT_THAT(frame_rates, testing::ElementsAre(15, 10));
+}
+
+TEST(AdaptiveFrameRateCalculatorTest, KeepsFractionalFrameRate) {
+  std::vector<double> frame_rates;
+  // Thermal status LIGHT selects 24 fps, which is not a fraction of 30 fps.
+  std::vector<int64> kept =
+      RunCalculator("", 60, {{0, 1}}, {}, &frame_rates);
+  EXPECT_EQ(48, kept.size());
+}
+
+TEST(AdaptiveFrameRateCalculatorTest, RaisesFrameRateAfterRecoveryDelay) {
+  std::vector<double> frame_rates;
+  std::vector<int64> kept =
+      RunCalculator(absl::StrCat("recovery_delay_usec: ", kSecond / 2), 90,
+                    {{0, 3}, {kSecond, 0}}, {}, &frame_rates);
+  EXPECT_EQ(10, CountBetween(kept, 0, kSecond));
+  // The rate stays at 10 fps for the recovery delay.
+  EXPECT_EQ(5, CountBetween(kept, kSecond, kSecond * 3 / 2));
+  EXPECT_EQ(15, CountBetween(kept, kSecond * 3 / 2, 2 * kSecond));
+  EXPECT_THAT(frame_rates, testing::ElementsAre(10, 30));
+}
+
+TEST(AdaptiveFrameRateCalculatorTest, IgnoresBriefRecovery) {
+  std::vector<double> frame_rates;
+  std::vector<int64> kept = RunCalculator(
+      "recovery_delay_usec: 500000", 60, {{0, 3}, {300000, 0}, {600000, 3}},
+      {}, &frame_rates);
+  EXPECT_EQ(20, kept.size());
+  EXPECT_THAT(frame_rates, testing::ElementsAre(10));
+}
+
+TEST(AdaptiveFrameRateCalculatorTest, CapsFrameRateInLowPowerMode) {
+  std::vector<double> frame_rates;
+  std::vector<int64> kept =
+      RunCalculator("max_frame_rate: 30 low_power_frame_rate: 10", 60,
+                    {{0, 1}}, {{0, true}}, &frame_rates);
+  EXPECT_EQ(20, kept.size());
+  EXPECT_THAT(frame_rates, testing::ElementsAre(10));
+}
+
+}  // namespace
+}  // namespace mediapipe
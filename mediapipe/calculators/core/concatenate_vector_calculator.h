@@ -15,6 +15,7 @@
 #ifndef MEDIAPIPE_CALCULATORS_CORE_CONCATENATE_VECTOR_CALCULATOR_H_
 #define MEDIAPIPE_CALCULATORS_CORE_CONCATENATE_VECTOR_CALCULATOR_H_
 
+#include <iterator>
 #include <vector>
 
 #include "mediapipe/calculators/core/concatenate_vector_calculator.pb.h"
@@ -29,6 +30,8 @@ namespace mediapipe {
 // assumes that every input stream contains the vector<T> type. To use this
 // class for a particular type T, regisiter a calculator using
 // ConcatenateVectorCalculator<T>.
+// Input vectors that are not shared with other readers are consumed, and their
+// elements are moved rather than copied.
 template <typename T>
 class ConcatenateVectorCalculator : public CalculatorBase {
  public:
@@ -59,12 +62,26 @@ class ConcatenateVectorCalculator : public CalculatorBase {
         if (cc->Inputs().Index(i).IsEmpty()) return ::mediapipe::OkStatus();
       }
     }
-    auto output = absl::make_unique<std::vector<T>>();
+    std::unique_ptr<std::vector<T>> output;
     for (int i = 0; i < cc->Inputs().NumEntries(); ++i) {
-      if (cc->Inputs().Index(i).IsEmpty()) continue;
-      const std::vector<T>& input = cc->Inputs().Index(i).Get<std::vector<T>>();
-      output->insert(output->end(), input.begin(), input.end());
+      auto& input_stream = cc->Inputs().Index(i);
+      if (input_stream.IsEmpty()) continue;
+      auto consumed = input_stream.Value().template Consume<std::vector<T>>();
+      if (consumed.ok()) {
+        auto input = consumed.ConsumeValueOrDie();
+        if (!output) {
+          output = std::move(input);
+        } else {
+          output->insert(output->end(), std::make_move_iterator(input->begin()),
+                         std::make_move_iterator(input->end()));
+        }
+      } else {
+        const std::vector<T>& input = input_stream.Get<std::vector<T>>();
+        if (!output) output = absl::make_unique<std::vector<T>>();
+        output->insert(output->end(), input.begin(), input.end());
+      }
     }
+    if (!output) output = absl::make_unique<std::vector<T>>();
     cc->Outputs().Index(0).Add(output.release(), cc->InputTimestamp());
     return ::mediapipe::OkStatus();
   }
@@ -13,10 +13,17 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
 #include <utility>
 #include <vector>
 
+#include "absl/time/time.h"
+#include "mediapipe/calculators/core/flow_limiter_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/deps/clock.h"
+#include "mediapipe/framework/deps/monotonic_clock.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/util/header_util.h"
@@ -36,8 +43,8 @@ namespace mediapipe {
 // input with a backwards edge, this allows FLC to keep track of how many
 // timestamps are currently being processed.
 //
-// The limit defaults to 1, and can be overridden with the MAX_IN_FLIGHT side
-// packet.
+// The limit defaults to 1, and can be overridden with the max_in_flight option
+// or the MAX_IN_FLIGHT side packet.
 //
 // As long as the number of timestamps being processed ("in flight") is below
 // the limit, FLC allows input to pass through. When the limit is reached,
@@ -53,6 +60,17 @@ namespace mediapipe {
 // the FINISHED stream. Dropping packets in the section between FLC and
 // FINISHED will make the in-flight count incorrect.
 //
+// In adaptive mode, enabled by setting the target_latency_usec option, FLC
+// measures the latency between forwarding each timestamp and receiving its
+// FINISHED packet, and adjusts the limit after every adaptation_window
+// FINISHED packets, much like TCP congestion control: if the latency at
+// latency_percentile exceeds target_latency_usec, the limit is halved;
+// otherwise, if the limit was reached during the window, it is raised by one.
+// The limit stays within [min_in_flight, max_adaptive_in_flight].  The
+// latency is measured with the std::shared_ptr<Clock> in the CLOCK side
+// packet, if any, or else with a monotonic wall clock.  The current limit is
+// reported on the optional MAX_IN_FLIGHT output stream whenever it changes.
+//
 // TODO: Remove this comment when graph-level ISH has been removed.
 // NOTE: this calculator should always use the ImmediateInputStreamHandler and
 // uses it by default. However, if the graph specifies a graph-level
@@ -89,9 +107,15 @@ class FlowLimiterCalculator : public CalculatorBase {
     if (cc->InputSidePackets().HasTag("MAX_IN_FLIGHT")) {
       cc->InputSidePackets().Tag("MAX_IN_FLIGHT").Set<int>();
     }
+    if (cc->InputSidePackets().HasTag("CLOCK")) {
+      cc->InputSidePackets().Tag("CLOCK").Set<std::shared_ptr<Clock>>();
+    }
     if (cc->Outputs().HasTag("ALLOW")) {
       cc->Outputs().Tag("ALLOW").Set<bool>();
     }
+    if (cc->Outputs().HasTag("MAX_IN_FLIGHT")) {
+      cc->Outputs().Tag("MAX_IN_FLIGHT").Set<int>();
+    }
 
     cc->SetInputStreamHandler("ImmediateInputStreamHandler");
 
@@ -99,18 +123,44 @@ class FlowLimiterCalculator : public CalculatorBase {
   }
 
   ::mediapipe::Status Open(CalculatorContext* cc) final {
+    options_ = cc->Options<FlowLimiterCalculatorOptions>();
     finished_id_ = cc->Inputs().GetId("FINISHED", 0);
-    max_in_flight_ = 1;
+    max_in_flight_ = options_.max_in_flight();
     if (cc->InputSidePackets().HasTag("MAX_IN_FLIGHT")) {
       max_in_flight_ = cc->InputSidePackets().Tag("MAX_IN_FLIGHT").Get<int>();
     }
     RET_CHECK_GE(max_in_flight_, 1);
     num_in_flight_ = 0;
+    dropped_packets_ = cc->GetCounter("DroppedPackets");
+
+    adaptive_ = options_.target_latency_usec() > 0;
+    if (adaptive_) {
+      RET_CHECK_GE(options_.min_in_flight(), 1);
+      RET_CHECK_GE(options_.max_adaptive_in_flight(), options_.min_in_flight());
+      RET_CHECK_GT(options_.latency_percentile(), 0.0);
+      RET_CHECK_LE(options_.latency_percentile(), 1.0);
+      RET_CHECK_GE(options_.adaptation_window(), 1);
+      max_in_flight_ =
+          std::min(std::max(max_in_flight_, options_.min_in_flight()),
+                   options_.max_adaptive_in_flight());
+      if (cc->InputSidePackets().HasTag("CLOCK")) {
+        clock_ =
+            cc->InputSidePackets().Tag("CLOCK").Get<std::shared_ptr<Clock>>();
+      } else {
+        clock_ = std::shared_ptr<Clock>(
+            MonotonicClock::CreateSynchronizedMonotonicClock());
+      }
+    }
+    limit_reached_ = false;
 
     allowed_id_ = cc->Outputs().GetId("ALLOW", 0);
     allow_ctr_ts_ = Timestamp(0);
+    max_in_flight_id_ = cc->Outputs().GetId("MAX_IN_FLIGHT", 0);
+    max_in_flight_ctr_ts_ = Timestamp(0);
 
     num_data_streams_ = cc->Inputs().NumEntries("");
+    data_input_id_ = cc->Inputs().BeginId("");
+    data_output_id_ = cc->Outputs().BeginId("");
     data_stream_bound_ts_.resize(num_data_streams_);
     RET_CHECK_OK(CopyInputHeadersToOutputs(cc->Inputs(), &(cc->Outputs())));
     return ::mediapipe::OkStatus();
@@ -127,12 +177,16 @@ class FlowLimiterCalculator : public CalculatorBase {
       RET_CHECK_GT(num_in_flight_, 0)
           << "Received a FINISHED packet, but we had none in flight.";
       --num_in_flight_;
+      if (adaptive_) {
+        RecordLatency(cc->Inputs().Get(finished_id_).Value().Timestamp());
+        MaybeAdaptLimit(cc);
+      }
     }
 
     // Process data streams.
     for (int i = 0; i < num_data_streams_; ++i) {
-      auto& stream = cc->Inputs().Get("", i);
-      auto& out = cc->Outputs().Get("", i);
+      auto& stream = cc->Inputs().Get(data_input_id_ + i);
+      auto& out = cc->Outputs().Get(data_output_id_ + i);
       Packet& packet = stream.Value();
       auto ts = packet.Timestamp();
       if (ts.IsRangeValue() && data_stream_bound_ts_[i] <= ts) {
@@ -163,9 +217,14 @@ class FlowLimiterCalculator : public CalculatorBase {
         out.AddPacket(std::move(packet));
         pending_ts_.insert(ts);
         ++num_in_flight_;
+        if (adaptive_) {
+          admit_time_.emplace(ts, clock_->TimeNow());
+          limit_reached_ = limit_reached_ || !Allow();
+        }
       } else {
         // Otherwise, we'll drop the packet.
         last_dropped_ts_ = std::max(last_dropped_ts_, ts);
+        dropped_packets_->Increment();
       }
     }
 
@@ -184,15 +243,77 @@ class FlowLimiterCalculator : public CalculatorBase {
   }
 
  private:
+  // Records the latency of the timestamp reported on FINISHED.  If that
+  // timestamp was not forwarded by FLC, the oldest one in flight is assumed.
+  void RecordLatency(Timestamp finished_ts) {
+    auto it = admit_time_.find(finished_ts);
+    if (it == admit_time_.end()) {
+      it = admit_time_.begin();
+    }
+    if (it == admit_time_.end()) {
+      return;
+    }
+    latencies_usec_.push_back(
+        absl::ToInt64Microseconds(clock_->TimeNow() - it->second));
+    admit_time_.erase(it);
+  }
+
+  // Adjusts max_in_flight_ once adaptation_window latencies are recorded.
+  void MaybeAdaptLimit(CalculatorContext* cc) {
+    if (latencies_usec_.size() <
+        static_cast<size_t>(options_.adaptation_window())) {
+      return;
+    }
+    int index = std::max(
+        0, static_cast<int>(std::ceil(options_.latency_percentile() *
+                                      latencies_usec_.size())) -
+               1);
+    std::nth_element(latencies_usec_.begin(), latencies_usec_.begin() + index,
+                     latencies_usec_.end());
+    int old_max_in_flight = max_in_flight_;
+    if (latencies_usec_[index] > options_.target_latency_usec()) {
+      max_in_flight_ = std::max(options_.min_in_flight(), max_in_flight_ / 2);
+    } else if (limit_reached_) {
+      max_in_flight_ =
+          std::min(options_.max_adaptive_in_flight(), max_in_flight_ + 1);
+    }
+    latencies_usec_.clear();
+    limit_reached_ = !Allow();
+    if (max_in_flight_ != old_max_in_flight && max_in_flight_id_.IsValid()) {
+      cc->Outputs()
+          .Get(max_in_flight_id_)
+          .AddPacket(
+              MakePacket<int>(max_in_flight_).At(++max_in_flight_ctr_ts_));
+    }
+  }
+
+  FlowLimiterCalculatorOptions options_;
   std::set<Timestamp> pending_ts_;
   Timestamp last_dropped_ts_;
   int num_data_streams_;
   int num_in_flight_;
   int max_in_flight_;
+  // Counts the dropped input packets, for monitoring.
+  Counter* dropped_packets_;
   CollectionItemId finished_id_;
+  // The ids of the first untagged input and output data streams.
+  CollectionItemId data_input_id_;
+  CollectionItemId data_output_id_;
   CollectionItemId allowed_id_;
   Timestamp allow_ctr_ts_;
   std::vector<Timestamp> data_stream_bound_ts_;
+
+  // Adaptive mode state.
+  bool adaptive_;
+  std::shared_ptr<Clock> clock_;
+  // The time at which each in-flight timestamp was forwarded.
+  std::map<Timestamp, absl::Time> admit_time_;
+  // The latencies measured in the current adaptation window.
+  std::vector<int64> latencies_usec_;
+  // Whether the limit was reached during the current adaptation window.
+  bool limit_reached_;
+  CollectionItemId max_in_flight_id_;
+  Timestamp max_in_flight_ctr_ts_;
 };
 REGISTER_CALCULATOR(FlowLimiterCalculator);
 
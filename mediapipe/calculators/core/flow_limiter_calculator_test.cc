@@ -17,10 +17,13 @@
 #include <string>
 #include <vector>
 
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/deps/clock.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
@@ -490,5 +493,128 @@ TEST(FlowLimiterCalculator, CanConsume) {
   MP_EXPECT_OK(graph_.WaitUntilDone());
 }
 
+// A clock that only advances when told to.
+class ManualClock : public Clock {
+ public:
+  absl::Time TimeNow() override {
+    absl::MutexLock lock(&mutex_);
+    return time_;
+  }
+  void Sleep(absl::Duration d) override { Advance(d); }
+  void SleepUntil(absl::Time wakeup_time) override {
+    absl::MutexLock lock(&mutex_);
+    time_ = std::max(time_, wakeup_time);
+  }
+  void Advance(absl::Duration d) {
+    absl::MutexLock lock(&mutex_);
+    time_ += d;
+  }
+
+ private:
+  absl::Mutex mutex_;
+  absl::Time time_ = absl::UnixEpoch();
+};
+
+// Runs a FlowLimiterCalculator in adaptive mode, feeding FINISHED from the
+// test with a controlled latency.
+class AdaptiveFlowLimiterTest : public testing::Test {
+ protected:
+  void StartGraph(const std::string& options) {
+    CalculatorGraphConfig graph_config =
+        ParseTextProtoOrDie<CalculatorGraphConfig>(absl::StrCat(
+            R"(
+              input_stream: 'in'
+              input_stream: 'finished'
+              node {
+                calculator: 'FlowLimiterCalculator'
+                input_side_packet: 'CLOCK:clock'
+                input_stream: 'in'
+                input_stream: 'FINISHED:finished'
+                output_stream: 'out'
+                output_stream: 'MAX_IN_FLIGHT:max_in_flight'
+                options {
+                  [mediapipe.FlowLimiterCalculatorOptions.ext] {)",
+            options, "}}}"));
+    tool::AddVectorSink("out", &graph_config, &out_packets_);
+    tool::AddVectorSink("max_in_flight", &graph_config,
+                        &max_in_flight_packets_);
+    clock_ = std::make_shared<ManualClock>();
+    MP_ASSERT_OK(graph_.Initialize(
+        graph_config,
+        {{"clock", MakePacket<std::shared_ptr<Clock>>(clock_)}}));
+    MP_ASSERT_OK(graph_.StartRun({}));
+  }
+
+  // Sends "count" timestamps and finishes them after "latency".
+  void SendRound(int count, absl::Duration latency) {
+    int first = next_timestamp_;
+    for (int i = 0; i < count; ++i) {
+      MP_ASSERT_OK(graph_.AddPacketToInputStream(
+          "in",
+          MakePacket<int>(next_timestamp_).At(Timestamp(next_timestamp_))));
+      ++next_timestamp_;
+    }
+    MP_ASSERT_OK(graph_.WaitUntilIdle());
+    clock_->Advance(latency);
+    for (int t = first; t < next_timestamp_; ++t) {
+      MP_ASSERT_OK(graph_.AddPacketToInputStream(
+          "finished", MakePacket<bool>(true).At(Timestamp(t))));
+    }
+    MP_ASSERT_OK(graph_.WaitUntilIdle());
+  }
+
+  void FinishGraph() {
+    MP_ASSERT_OK(graph_.CloseAllInputStreams());
+    MP_ASSERT_OK(graph_.WaitUntilDone());
+  }
+
+  CalculatorGraph graph_;
+  std::shared_ptr<ManualClock> clock_;
+  std::vector<Packet> out_packets_;
+  std::vector<Packet> max_in_flight_packets_;
+  int next_timestamp_ = 0;
+};
+
+// The limit grows while latency is within target, up to
+// max_adaptive_in_flight, and is halved when latency exceeds the target.
+TEST_F(AdaptiveFlowLimiterTest, AdaptsLimitToLatency) {
+  StartGraph(
+      "target_latency_usec: 1000 adaptation_window: 4 "
+      "max_adaptive_in_flight: 3");
+  for (int i = 0; i < 4; ++i) {
+    SendRound(1, absl::Microseconds(100));
+  }
+  EXPECT_EQ(PacketValues<int>(max_in_flight_packets_), std::vector<int>({2}));
+  for (int i = 0; i < 2; ++i) {
+    SendRound(2, absl::Microseconds(100));
+  }
+  EXPECT_EQ(PacketValues<int>(max_in_flight_packets_),
+            std::vector<int>({2, 3}));
+  for (int i = 0; i < 4; ++i) {
+    SendRound(3, absl::Microseconds(100));
+  }
+  EXPECT_EQ(PacketValues<int>(max_in_flight_packets_),
+            std::vector<int>({2, 3}));
+  for (int i = 0; i < 2; ++i) {
+    SendRound(2, absl::Microseconds(5000));
+  }
+  EXPECT_EQ(PacketValues<int>(max_in_flight_packets_),
+            std::vector<int>({2, 3, 1}));
+  FinishGraph();
+  // Every round stayed within the limit, so nothing was dropped.
+  EXPECT_EQ(out_packets_.size(), next_timestamp_);
+}
+
+// The limit is not raised while the section is not using it.
+TEST_F(AdaptiveFlowLimiterTest, GrowsOnlyWhenLimitIsReached) {
+  StartGraph(
+      "max_in_flight: 2 target_latency_usec: 1000 adaptation_window: 2");
+  for (int i = 0; i < 6; ++i) {
+    SendRound(1, absl::Microseconds(100));
+  }
+  EXPECT_TRUE(max_in_flight_packets_.empty());
+  FinishGraph();
+}
+
 }  // anonymous namespace
 }  // namespace mediapipe
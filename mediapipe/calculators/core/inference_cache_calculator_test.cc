@@ -0,0 +1,156 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/tool/sink.h"
+#include "mediapipe/util/inference_cache.h"
+
+namespace mediapipe {
+
+namespace {
+
+using ::testing::ElementsAre;
+
+// The number of packets processed by UpperCaseCalculator.
+std::atomic<int> num_upper_case_calls(0);
+
+// Stands in for inference: outputs its input string in upper case, and the
+// string "even" for inputs of even length.
+class UpperCaseCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<std::string>();
+    cc->Outputs().Index(0).Set<std::string>();
+    cc->Outputs().Index(1).Set<std::string>();
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    cc->SetOffset(TimestampDiff(0));
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    ++num_upper_case_calls;
+    const std::string& input = cc->Inputs().Index(0).Get<std::string>();
+    cc->Outputs().Index(0).Add(new std::string(absl::AsciiStrToUpper(input)),
+                               cc->InputTimestamp());
+    if (input.size() % 2 == 0) {
+      cc->Outputs().Index(1).Add(new std::string("even"),
+                                 cc->InputTimestamp());
+    }
+    return ::mediapipe::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(UpperCaseCalculator);
+
+class InferenceCacheCalculatorTest : public ::testing::Test {
+ protected:
+  void SetUp() override { num_upper_case_calls = 0; }
+
+  // Runs the graph on "inputs", and returns the values of the first output.
+  std::vector<std::string> Run(const std::vector<std::string>& inputs,
+                               const std::string& lookup_side_packets) {
+    CalculatorGraphConfig config =
+        ParseTextProtoOrDie<CalculatorGraphConfig>(absl::StrCat(R"(
+          input_stream: "input"
+          node {
+            calculator: "InferenceCacheLookupCalculator"
+            input_stream: "input"
+            output_stream: "MISS:miss"
+            output_stream: "KEY:key"
+            output_stream: "CACHED:0:cached_upper"
+            output_stream: "CACHED:1:cached_even"
+          )", lookup_side_packets, R"(
+          }
+          node {
+            calculator: "UpperCaseCalculator"
+            input_stream: "miss"
+            output_stream: "upper"
+            output_stream: "even"
+          }
+          node {
+            calculator: "InferenceCacheStoreCalculator"
+            input_stream: "KEY:key"
+            input_stream: "upper"
+            input_stream: "even"
+            input_stream: "CACHED:0:cached_upper"
+            input_stream: "CACHED:1:cached_even"
+            input_side_packet: "CACHE:cache"
+            output_stream: "output_upper"
+            output_stream: "output_even"
+          }
+        )"));
+    std::vector<Packet> upper_packets;
+    tool::AddVectorSink("output_upper", &config, &upper_packets);
+    tool::AddVectorSink("output_even", &config, &even_packets_);
+    CalculatorGraph graph;
+    MP_EXPECT_OK(graph.Initialize(config, side_packets_));
+    MP_EXPECT_OK(graph.StartRun({}));
+    for (int i = 0; i < inputs.size(); ++i) {
+      MP_EXPECT_OK(graph.AddPacketToInputStream(
+          "input", MakePacket<std::string>(inputs[i]).At(Timestamp(i))));
+      // Lets the outputs be stored before the next lookup.
+      MP_EXPECT_OK(graph.WaitUntilIdle());
+    }
+    MP_EXPECT_OK(graph.CloseAllInputStreams());
+    MP_EXPECT_OK(graph.WaitUntilDone());
+    std::vector<std::string> outputs;
+    for (const Packet& packet : upper_packets) {
+      EXPECT_EQ(Timestamp(outputs.size()), packet.Timestamp());
+      outputs.push_back(packet.Get<std::string>());
+    }
+    return outputs;
+  }
+
+  std::map<std::string, Packet> side_packets_;
+  std::vector<Packet> even_packets_;
+};
+
+TEST_F(InferenceCacheCalculatorTest, SkipsRepeatedInputs) {
+  EXPECT_THAT(Run({"ab", "c", "ab", "ab", "d", "c"},
+                  R"(output_side_packet: "CACHE:cache")"),
+              ElementsAre("AB", "C", "AB", "AB", "D", "C"));
+  EXPECT_EQ(3, num_upper_case_calls);
+  // The missing outputs are cached too.
+  ASSERT_EQ(3, even_packets_.size());
+  EXPECT_EQ(Timestamp(0), even_packets_[0].Timestamp());
+  EXPECT_EQ(Timestamp(2), even_packets_[1].Timestamp());
+  EXPECT_EQ(Timestamp(3), even_packets_[2].Timestamp());
+}
+
+TEST_F(InferenceCacheCalculatorTest, SharesCacheBetweenRuns) {
+  side_packets_["cache"] = MakePacket<std::shared_ptr<InferenceCache>>(
+      std::make_shared<InferenceCache>(InferenceCache::Options()));
+  EXPECT_THAT(Run({"a", "b"}, R"(input_side_packet: "CACHE:cache")"),
+              ElementsAre("A", "B"));
+  EXPECT_THAT(Run({"b", "c", "a"}, R"(input_side_packet: "CACHE:cache")"),
+              ElementsAre("B", "C", "A"));
+  EXPECT_EQ(3, num_upper_case_calls);
+}
+
+}  // namespace
+}  // namespace mediapipe
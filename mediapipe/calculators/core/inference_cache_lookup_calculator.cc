@@ -0,0 +1,147 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mediapipe/calculators/core/inference_cache_lookup_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/util/inference_cache.h"
+
+namespace mediapipe {
+
+// Skips an expensive branch of the graph, such as inference, for inputs whose
+// contents it has already processed, together with
+// InferenceCacheStoreCalculator.  The input packet is hashed, an ImageFrame
+// from its pixels and other types from their serialization, and looked up in
+// an InferenceCache.  On a miss, the input is sent on MISS to the branch and
+// its key on KEY to the store calculator, which stores the outputs of the
+// branch.  On a hit, the stored outputs are sent on CACHED:i at the input
+// timestamp, and the store calculator passes them on in place of the outputs
+// of the branch.  Only identical contents hit the cache, so the outputs are
+// the same as without it.  The branch should propagate timestamp bounds, e.g.
+// with SetOffset(0), so that the store calculator need not wait for the next
+// miss to pass on a hit.
+//
+// The cache is created from the options and shared with the store calculator
+// through the CACHE output side packet, unless it is passed in the CACHE
+// input side packet, e.g. to share it between graphs.  Hits and misses are
+// counted in the "Cache Hits" and "Cache Misses" counters.
+//
+// Example config:
+//   node {
+//     calculator: "InferenceCacheLookupCalculator"
+//     input_stream: "input_video"
+//     output_stream: "MISS:uncached_video"
+//     output_stream: "KEY:cache_key"
+//     output_stream: "CACHED:0:cached_detections"
+//     output_side_packet: "CACHE:detection_cache"
+//     options {
+//       [mediapipe.InferenceCacheLookupCalculatorOptions.ext] {
+//         max_entries: 4096
+//         directory: "/tmp/detection_cache"
+//       }
+//     }
+//   }
+//   ... detections from uncached_video ...
+//   node {
+//     calculator: "InferenceCacheStoreCalculator"
+//     input_stream: "KEY:cache_key"
+//     input_stream: "detections"
+//     input_stream: "CACHED:0:cached_detections"
+//     input_side_packet: "CACHE:detection_cache"
+//     output_stream: "output_detections"
+//   }
+class InferenceCacheLookupCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    RET_CHECK_EQ(cc->Inputs().NumEntries(""), 1);
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Tag("MISS").SetSameAs(&cc->Inputs().Index(0));
+    cc->Outputs().Tag("KEY").Set<std::string>();
+    for (CollectionItemId id = cc->Outputs().BeginId("CACHED");
+         id < cc->Outputs().EndId("CACHED"); ++id) {
+      cc->Outputs().Get(id).SetAny();
+    }
+    if (cc->InputSidePackets().HasTag("CACHE")) {
+      cc->InputSidePackets()
+          .Tag("CACHE")
+          .Set<std::shared_ptr<InferenceCache>>();
+    }
+    if (cc->OutputSidePackets().HasTag("CACHE")) {
+      cc->OutputSidePackets()
+          .Tag("CACHE")
+          .Set<std::shared_ptr<InferenceCache>>();
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    cc->SetOffset(TimestampDiff(0));
+    if (cc->InputSidePackets().HasTag("CACHE")) {
+      cache_ = cc->InputSidePackets()
+                   .Tag("CACHE")
+                   .Get<std::shared_ptr<InferenceCache>>();
+      RET_CHECK(cache_);
+    } else {
+      const auto& options =
+          cc->Options<InferenceCacheLookupCalculatorOptions>();
+      RET_CHECK_GE(options.max_entries(), 0);
+      InferenceCache::Options cache_options;
+      cache_options.max_entries = options.max_entries();
+      cache_options.directory = options.directory();
+      cache_ = std::make_shared<InferenceCache>(cache_options);
+    }
+    if (cc->OutputSidePackets().HasTag("CACHE")) {
+      cc->OutputSidePackets().Tag("CACHE").Set(
+          MakePacket<std::shared_ptr<InferenceCache>>(cache_));
+    }
+    num_cached_outputs_ = cc->Outputs().NumEntries("CACHED");
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    const Packet& input = cc->Inputs().Index(0).Value();
+    ASSIGN_OR_RETURN(std::string key, InferenceCache::ContentKey(input));
+    std::vector<Packet> outputs;
+    ASSIGN_OR_RETURN(bool hit, cache_->Lookup(key, &outputs));
+    if (!hit) {
+      cc->GetCounter("Cache Misses")->Increment();
+      cc->Outputs().Tag("MISS").AddPacket(input);
+      cc->Outputs().Tag("KEY").Add(new std::string(std::move(key)),
+                                   cc->InputTimestamp());
+      return ::mediapipe::OkStatus();
+    }
+    cc->GetCounter("Cache Hits")->Increment();
+    RET_CHECK_EQ(outputs.size(), num_cached_outputs_)
+        << "The cache entry does not match the CACHED output streams.";
+    for (int i = 0; i < num_cached_outputs_; ++i) {
+      if (!outputs[i].IsEmpty()) {
+        cc->Outputs().Get("CACHED", i).AddPacket(
+            outputs[i].At(cc->InputTimestamp()));
+      }
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+ private:
+  std::shared_ptr<InferenceCache> cache_;
+  int num_cached_outputs_ = 0;
+};
+REGISTER_CALCULATOR(InferenceCacheLookupCalculator);
+
+}  // namespace mediapipe
@@ -0,0 +1,94 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/util/inference_cache.h"
+
+namespace mediapipe {
+
+// Stores the outputs of a branch of the graph in the InferenceCache of an
+// InferenceCacheLookupCalculator, and merges them with the outputs the lookup
+// calculator found in the cache.  See InferenceCacheLookupCalculator.
+//
+// Inputs:
+//   KEY: The cache key of the inputs sent to the branch.
+//   The outputs of the branch, one stream per output.
+//   CACHED:i: The cached outputs, one stream per output.
+// Outputs:
+//   The outputs of the branch or from the cache, one stream per output.
+// Input side packets:
+//   CACHE: The std::shared_ptr<InferenceCache> of the lookup calculator.
+class InferenceCacheStoreCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    const int num_outputs = cc->Outputs().NumEntries("");
+    RET_CHECK_GT(num_outputs, 0);
+    RET_CHECK_EQ(cc->Inputs().NumEntries(""), num_outputs);
+    RET_CHECK_EQ(cc->Inputs().NumEntries("CACHED"), num_outputs);
+    cc->Inputs().Tag("KEY").Set<std::string>();
+    for (int i = 0; i < num_outputs; ++i) {
+      cc->Inputs().Get("", i).SetAny();
+      cc->Inputs().Get("CACHED", i).SetSameAs(&cc->Inputs().Get("", i));
+      cc->Outputs().Get("", i).SetSameAs(&cc->Inputs().Get("", i));
+    }
+    cc->InputSidePackets().Tag("CACHE").Set<std::shared_ptr<InferenceCache>>();
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    cc->SetOffset(TimestampDiff(0));
+    cache_ = cc->InputSidePackets()
+                 .Tag("CACHE")
+                 .Get<std::shared_ptr<InferenceCache>>();
+    RET_CHECK(cache_);
+    num_outputs_ = cc->Outputs().NumEntries("");
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    if (!cc->Inputs().Tag("KEY").IsEmpty()) {
+      // A miss: the outputs of the branch, including the missing ones, are
+      // stored under the key.
+      std::vector<Packet> outputs(num_outputs_);
+      for (int i = 0; i < num_outputs_; ++i) {
+        outputs[i] = cc->Inputs().Get("", i).Value();
+        if (!outputs[i].IsEmpty()) {
+          cc->Outputs().Get("", i).AddPacket(outputs[i]);
+        }
+      }
+      return cache_->Insert(cc->Inputs().Tag("KEY").Get<std::string>(),
+                            outputs);
+    }
+    for (int i = 0; i < num_outputs_; ++i) {
+      if (!cc->Inputs().Get("CACHED", i).IsEmpty()) {
+        cc->Outputs().Get("", i).AddPacket(
+            cc->Inputs().Get("CACHED", i).Value());
+      }
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+ private:
+  std::shared_ptr<InferenceCache> cache_;
+  int num_outputs_ = 0;
+};
+REGISTER_CALCULATOR(InferenceCacheStoreCalculator);
+
+}  // namespace mediapipe
@@ -0,0 +1,145 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+
+namespace mediapipe {
+
+// Forwards each input packet to the one of the n output streams "OUTPUT:0",
+// "OUTPUT:1", ..., whose branch has the fewest packets in flight, like
+// RoundRobinDemuxCalculator does in turn. A packet is in flight on a branch
+// from when it is sent on "OUTPUT:i" until a packet arrives on the
+// corresponding back edge "FINISHED:i", usually the output of the branch.
+// Ties go to the next branch after the last one selected, so branches with
+// equal latency are used round robin. The index of the selected output
+// stream is emitted to the optional output stream "SELECT".
+//
+// This keeps a slow branch, such as one running on a busier device, from
+// backing up while faster branches sit idle. Since branches finish out of
+// order, the outputs should be merged with ImmediateMuxCalculator, or with
+// MuxCalculator and the "SELECT" stream.
+//
+// Example config:
+//   node {
+//     calculator: "LeastLoadedDemuxCalculator"
+//     input_stream: "frames"
+//     input_stream: "FINISHED:0:detections0"
+//     input_stream: "FINISHED:1:detections1"
+//     input_stream_info: { tag_index: "FINISHED:0" back_edge: true }
+//     input_stream_info: { tag_index: "FINISHED:1" back_edge: true }
+//     output_stream: "OUTPUT:0:frames0"
+//     output_stream: "OUTPUT:1:frames1"
+//   }
+//   node {
+//     calculator: "GpuInferenceSubgraph"
+//     input_stream: "frames0"
+//     output_stream: "detections0"
+//   }
+//   node {
+//     calculator: "CpuInferenceSubgraph"
+//     input_stream: "frames1"
+//     output_stream: "detections1"
+//   }
+//   node {
+//     calculator: "ImmediateMuxCalculator"
+//     input_stream_handler {
+//       input_stream_handler: "ImmediateInputStreamHandler"
+//     }
+//     input_stream: "detections0"
+//     input_stream: "detections1"
+//     output_stream: "detections"
+//   }
+class LeastLoadedDemuxCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    RET_CHECK_EQ(cc->Inputs().NumEntries(""), 1);
+    RET_CHECK_GT(cc->Outputs().NumEntries("OUTPUT"), 0);
+    RET_CHECK_EQ(cc->Inputs().NumEntries("FINISHED"),
+                 cc->Outputs().NumEntries("OUTPUT"))
+        << "Each OUTPUT stream needs a corresponding FINISHED stream.";
+    cc->Inputs().Get("", 0).SetAny();
+    for (CollectionItemId id = cc->Inputs().BeginId("FINISHED");
+         id < cc->Inputs().EndId("FINISHED"); ++id) {
+      cc->Inputs().Get(id).SetAny();
+    }
+    for (CollectionItemId id = cc->Outputs().BeginId("OUTPUT");
+         id < cc->Outputs().EndId("OUTPUT"); ++id) {
+      cc->Outputs().Get(id).SetSameAs(&cc->Inputs().Get("", 0));
+    }
+    if (cc->Outputs().HasTag("SELECT")) {
+      cc->Outputs().Tag("SELECT").Set<int>();
+    }
+    cc->SetInputStreamHandler("ImmediateInputStreamHandler");
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    data_input_ = cc->Inputs().GetId("", 0);
+    finished_base_ = cc->Inputs().BeginId("FINISHED");
+    output_data_stream_base_ = cc->Outputs().BeginId("OUTPUT");
+    select_output_ = cc->Outputs().GetId("SELECT", 0);
+    num_in_flight_.assign(cc->Outputs().NumEntries("OUTPUT"), 0);
+    last_selected_ = num_in_flight_.size() - 1;
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    for (int i = 0; i < num_in_flight_.size(); ++i) {
+      if (!cc->Inputs().Get(finished_base_ + i).IsEmpty()) {
+        RET_CHECK_GT(num_in_flight_[i], 0)
+            << "Received a FINISHED packet for branch " << i
+            << ", but it had none in flight.";
+        --num_in_flight_[i];
+      }
+    }
+
+    const Packet& packet = cc->Inputs().Get(data_input_).Value();
+    if (packet.IsEmpty()) {
+      return ::mediapipe::OkStatus();
+    }
+    int selected = -1;
+    for (int n = 1; n <= num_in_flight_.size(); ++n) {
+      const int i = (last_selected_ + n) % num_in_flight_.size();
+      if (selected < 0 || num_in_flight_[i] < num_in_flight_[selected]) {
+        selected = i;
+      }
+    }
+    ++num_in_flight_[selected];
+    last_selected_ = selected;
+    cc->Outputs().Get(output_data_stream_base_ + selected).AddPacket(packet);
+    if (select_output_.IsValid()) {
+      cc->Outputs()
+          .Get(select_output_)
+          .Add(new int(selected), packet.Timestamp());
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+ private:
+  CollectionItemId data_input_;
+  CollectionItemId finished_base_;
+  CollectionItemId output_data_stream_base_;
+  CollectionItemId select_output_;
+  // The number of packets in flight on each branch.
+  std::vector<int> num_in_flight_;
+  int last_selected_;
+};
+
+REGISTER_CALCULATOR(LeastLoadedDemuxCalculator);
+
+}  // namespace mediapipe
@@ -0,0 +1,96 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+
+class LeastLoadedDemuxCalculatorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    MP_ASSERT_OK(graph_.Initialize(ParseTextProtoOrDie<CalculatorGraphConfig>(
+        R"(
+          input_stream: "input"
+          input_stream: "finished0"
+          input_stream: "finished1"
+          node {
+            calculator: "LeastLoadedDemuxCalculator"
+            input_stream: "input"
+            input_stream: "FINISHED:0:finished0"
+            input_stream: "FINISHED:1:finished1"
+            output_stream: "OUTPUT:0:output0"
+            output_stream: "OUTPUT:1:output1"
+            output_stream: "SELECT:select"
+          }
+        )")));
+    MP_ASSERT_OK(graph_.ObserveOutputStream("select", [this](const Packet& p) {
+      selected_.push_back(p.Get<int>());
+      return ::mediapipe::OkStatus();
+    }));
+    MP_ASSERT_OK(graph_.StartRun({}));
+  }
+
+  void AddPacket(const std::string& stream, int64 timestamp) {
+    MP_ASSERT_OK(graph_.AddPacketToInputStream(
+        stream, MakePacket<int>(0).At(Timestamp(timestamp))));
+    MP_ASSERT_OK(graph_.WaitUntilIdle());
+  }
+
+  CalculatorGraph graph_;
+  std::vector<int> selected_;
+};
+
+TEST_F(LeastLoadedDemuxCalculatorTest, AlternatesBetweenEquallyLoadedBranches) {
+  for (int64 ts = 1; ts <= 4; ++ts) {
+    AddPacket("input", ts);
+  }
+  MP_ASSERT_OK(graph_.CloseAllInputStreams());
+  MP_ASSERT_OK(graph_.WaitUntilDone());
+  EXPECT_THAT(selected_, ElementsAre(0, 1, 0, 1));
+}
+
+TEST_F(LeastLoadedDemuxCalculatorTest, SelectsTheBranchWithFewestInFlight) {
+  AddPacket("input", 1);      // 0 in flight: {1}.
+  AddPacket("input", 2);      // 1 in flight: {2}.
+  AddPacket("input", 3);      // 0 in flight: {1, 3}.
+  AddPacket("finished1", 2);  // 1 in flight: {}.
+  AddPacket("input", 4);      // 1 in flight: {4}.
+  AddPacket("input", 5);      // 1 in flight: {4, 5}.
+  AddPacket("finished0", 1);
+  AddPacket("finished0", 3);  // 0 in flight: {}.
+  AddPacket("input", 6);      // 0 in flight: {6}.
+  MP_ASSERT_OK(graph_.CloseAllInputStreams());
+  MP_ASSERT_OK(graph_.WaitUntilDone());
+  EXPECT_THAT(selected_, ElementsAre(0, 1, 0, 1, 1, 0));
+}
+
+TEST_F(LeastLoadedDemuxCalculatorTest, FailsOnUnexpectedFinishedPacket) {
+  MP_ASSERT_OK(graph_.AddPacketToInputStream(
+      "finished0", MakePacket<int>(0).At(Timestamp(1))));
+  MP_ASSERT_OK(graph_.CloseAllInputStreams());
+  EXPECT_FALSE(graph_.WaitUntilDone().ok());
+}
+
+}  // namespace
+}  // namespace mediapipe
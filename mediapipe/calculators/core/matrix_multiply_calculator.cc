@@ -12,21 +12,43 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <memory>
+#include <vector>
+
 #include "Eigen/Core"
+#include "absl/memory/memory.h"
+#include "mediapipe/calculators/core/matrix_multiply_calculator.pb.h"
+#include "mediapipe/calculators/core/matrix_output_pool.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/matrix.h"
+#include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
 
 namespace mediapipe {
 // Perform a (left) matrix multiply.  Meaning (output = A * input)
 // where A is the matrix which is provided as an input side packet.
 //
+// If batch_size is greater than 1 in MatrixMultiplyCalculatorOptions, the
+// inputs must be column vectors, and the columns of batch_size consecutive
+// packets are multiplied by A together, which is much faster than one at a
+// time. Each product is output at the timestamp of its input once the batch
+// is complete, so outputs lag the inputs by up to batch_size - 1 packets.
+//
+// With output_pool_size set, the storage of output matrices is reused once
+// downstream calculators release them.
+//
 // Example config:
 // node {
 //   calculator: "MatrixMultiplyCalculator"
 //   input_stream: "samples"
 //   output_stream: "multiplied_samples"
 //   input_side_packet: "multiplication_matrix"
+//   options {
+//     [mediapipe.MatrixMultiplyCalculatorOptions.ext] {
+//       batch_size: 16
+//       output_pool_size: 32
+//     }
+//   }
 // }
 class MatrixMultiplyCalculator : public CalculatorBase {
  public:
@@ -37,6 +59,20 @@ class MatrixMultiplyCalculator : public CalculatorBase {
 
   ::mediapipe::Status Open(CalculatorContext* cc) override;
   ::mediapipe::Status Process(CalculatorContext* cc) override;
+  ::mediapipe::Status Close(CalculatorContext* cc) override;
+
+ private:
+  // Multiplies the buffered columns, and outputs their products.
+  ::mediapipe::Status ProcessBatch(CalculatorContext* cc);
+
+  int batch_size_ = 1;
+  std::unique_ptr<MatrixOutputPool> output_pool_;
+  // The input packets of the current batch.
+  std::vector<Packet> batch_packets_;
+  // The columns of the current batch, and their products. Kept across
+  // batches to avoid reallocating them.
+  Matrix batch_input_;
+  Matrix batch_output_;
 };
 REGISTER_CALCULATOR(MatrixMultiplyCalculator);
 
@@ -50,16 +86,69 @@ REGISTER_CALCULATOR(MatrixMultiplyCalculator);
 }
 
 ::mediapipe::Status MatrixMultiplyCalculator::Open(CalculatorContext* cc) {
-  // The output is at the same timestamp as the input.
-  cc->SetOffset(TimestampDiff(0));
+  const auto& options = cc->Options<MatrixMultiplyCalculatorOptions>();
+  RET_CHECK_GE(options.batch_size(), 1);
+  RET_CHECK_GE(options.output_pool_size(), 0);
+  batch_size_ = options.batch_size();
+  output_pool_ =
+      absl::make_unique<MatrixOutputPool>(options.output_pool_size());
+  if (batch_size_ == 1) {
+    // The output is at the same timestamp as the input.
+    cc->SetOffset(TimestampDiff(0));
+  } else {
+    batch_packets_.reserve(batch_size_);
+  }
   return ::mediapipe::OkStatus();
 }
 
 ::mediapipe::Status MatrixMultiplyCalculator::Process(CalculatorContext* cc) {
-  Matrix* multiplied = new Matrix();
-  *multiplied = cc->InputSidePackets().Index(0).Get<Matrix>() *
-                cc->Inputs().Index(0).Get<Matrix>();
-  cc->Outputs().Index(0).Add(multiplied, cc->InputTimestamp());
+  const Matrix& side = cc->InputSidePackets().Index(0).Get<Matrix>();
+  if (batch_size_ == 1) {
+    const Matrix& input = cc->Inputs().Index(0).Get<Matrix>();
+    RET_CHECK_EQ(side.cols(), input.rows());
+    std::unique_ptr<Matrix> multiplied =
+        output_pool_->Acquire(side.rows(), input.cols());
+    multiplied->noalias() = side * input;
+    cc->Outputs().Index(0).AddPacket(
+        output_pool_->MakePacket(std::move(multiplied), cc->InputTimestamp()));
+    return ::mediapipe::OkStatus();
+  }
+
+  const Packet& packet = cc->Inputs().Index(0).Value();
+  const Matrix& input = packet.Get<Matrix>();
+  RET_CHECK_EQ(input.cols(), 1) << "Batched inputs must be column vectors.";
+  RET_CHECK_EQ(side.cols(), input.rows());
+  batch_packets_.push_back(packet);
+  if (batch_packets_.size() == static_cast<size_t>(batch_size_)) {
+    MP_RETURN_IF_ERROR(ProcessBatch(cc));
+  }
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status MatrixMultiplyCalculator::Close(CalculatorContext* cc) {
+  if (!batch_packets_.empty()) {
+    MP_RETURN_IF_ERROR(ProcessBatch(cc));
+  }
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status MatrixMultiplyCalculator::ProcessBatch(
+    CalculatorContext* cc) {
+  const Matrix& side = cc->InputSidePackets().Index(0).Get<Matrix>();
+  const int num_columns = batch_packets_.size();
+  batch_input_.resize(side.cols(), num_columns);
+  for (int i = 0; i < num_columns; ++i) {
+    batch_input_.col(i) = batch_packets_[i].Get<Matrix>();
+  }
+  batch_output_.resize(side.rows(), num_columns);
+  batch_output_.noalias() = side * batch_input_;
+  for (int i = 0; i < num_columns; ++i) {
+    std::unique_ptr<Matrix> multiplied = output_pool_->Acquire(side.rows(), 1);
+    *multiplied = batch_output_.col(i);
+    cc->Outputs().Index(0).AddPacket(output_pool_->MakePacket(
+        std::move(multiplied), batch_packets_[i].Timestamp()));
+  }
+  batch_packets_.clear();
   return ::mediapipe::OkStatus();
 }
 
@@ -16,12 +16,14 @@
 #include <vector>
 
 #include "Eigen/Core"
+#include "mediapipe/calculators/core/matrix_multiply_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_runner.h"
 #include "mediapipe/framework/formats/matrix.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
 #include "mediapipe/framework/port/status_matchers.h"
 #include "mediapipe/framework/tool/validate_type.h"
 
@@ -198,12 +200,11 @@ const char kExpectedText[] =
     "packed_data: 11295\n"
     "packed_data:  6360\n";
 
-// Send a number of samples through the MatrixMultiplyCalculator.
-TEST(MatrixMultiplyCalculatorTest, Multiply) {
-  CalculatorRunner runner("MatrixMultiplyCalculator", "", 1, 1, 1);
+// Sends a number of samples through runner, and checks the products.
+void RunAndCheckMultiply(CalculatorRunner* runner) {
   Matrix* matrix = new Matrix();
   MatrixFromTextProto(kMatrixText, matrix);
-  runner.MutableSidePackets()->Index(0) = Adopt(matrix);
+  runner->MutableSidePackets()->Index(0) = Adopt(matrix);
 
   Matrix samples;
   MatrixFromTextProto(kSamplesText, &samples);
@@ -215,16 +216,16 @@ TEST(MatrixMultiplyCalculatorTest, Multiply) {
     // Take a column from samples and produce a packet with just that
     // column in it as an input sample for the calculator.
     Eigen::MatrixXf* sample = new Eigen::MatrixXf(samples.block(0, i, 4, 1));
-    runner.MutableInputs()->Index(0).packets.push_back(
+    runner->MutableInputs()->Index(0).packets.push_back(
         Adopt(sample).At(Timestamp(i)));
   }
 
-  MP_ASSERT_OK(runner.Run());
-  EXPECT_EQ(runner.MutableInputs()->Index(0).packets.size(),
-            runner.Outputs().Index(0).packets.size());
+  MP_ASSERT_OK(runner->Run());
+  EXPECT_EQ(runner->MutableInputs()->Index(0).packets.size(),
+            runner->Outputs().Index(0).packets.size());
 
   int i = 0;
-  for (const Packet& output : runner.Outputs().Index(0).packets) {
+  for (const Packet& output : runner->Outputs().Index(0).packets) {
     EXPECT_EQ(Timestamp(i), output.Timestamp());
     const Eigen::MatrixXf& result = output.Get<Matrix>();
     ASSERT_EQ(3, result.rows());
@@ -235,5 +236,60 @@ TEST(MatrixMultiplyCalculatorTest, Multiply) {
   EXPECT_EQ(samples.cols(), i);
 }
 
+// Send a number of samples through the MatrixMultiplyCalculator.
+TEST(MatrixMultiplyCalculatorTest, Multiply) {
+  CalculatorRunner runner("MatrixMultiplyCalculator", "", 1, 1, 1);
+  RunAndCheckMultiply(&runner);
+}
+
+// Multiplies the samples in batches. The 20 samples leave a partial batch,
+// which is multiplied when the calculator is closed.
+TEST(MatrixMultiplyCalculatorTest, MultiplyBatched) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+    calculator: "MatrixMultiplyCalculator"
+    input_stream: "samples"
+    output_stream: "multiplied_samples"
+    input_side_packet: "multiplication_matrix"
+    options {
+      [mediapipe.MatrixMultiplyCalculatorOptions.ext] { batch_size: 6 }
+    }
+  )"));
+  RunAndCheckMultiply(&runner);
+}
+
+TEST(MatrixMultiplyCalculatorTest, MultiplyWithOutputPool) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+    calculator: "MatrixMultiplyCalculator"
+    input_stream: "samples"
+    output_stream: "multiplied_samples"
+    input_side_packet: "multiplication_matrix"
+    options {
+      [mediapipe.MatrixMultiplyCalculatorOptions.ext] {
+        batch_size: 4
+        output_pool_size: 2
+      }
+    }
+  )"));
+  RunAndCheckMultiply(&runner);
+}
+
+TEST(MatrixMultiplyCalculatorTest, BatchedInputsMustBeColumns) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+    calculator: "MatrixMultiplyCalculator"
+    input_stream: "samples"
+    output_stream: "multiplied_samples"
+    input_side_packet: "multiplication_matrix"
+    options {
+      [mediapipe.MatrixMultiplyCalculatorOptions.ext] { batch_size: 2 }
+    }
+  )"));
+  Matrix* matrix = new Matrix();
+  MatrixFromTextProto(kMatrixText, matrix);
+  runner.MutableSidePackets()->Index(0) = Adopt(matrix);
+  runner.MutableInputs()->Index(0).packets.push_back(
+      Adopt(new Matrix(Matrix::Zero(4, 2))).At(Timestamp(0)));
+  EXPECT_FALSE(runner.Run().ok());
+}
+
 }  // namespace
 }  // namespace mediapipe
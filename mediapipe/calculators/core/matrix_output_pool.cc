@@ -0,0 +1,50 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/core/matrix_output_pool.h"
+
+#include <utility>
+
+#include "absl/memory/memory.h"
+
+namespace mediapipe {
+
+std::unique_ptr<Matrix> MatrixOutputPool::Acquire(int rows, int cols) {
+  // The oldest packets are the most likely to have been released.
+  for (auto it = packets_.begin(); it != packets_.end(); ++it) {
+    auto matrix = it->Consume<Matrix>();
+    if (matrix.ok()) {
+      packets_.erase(it);
+      std::unique_ptr<Matrix> result = std::move(matrix).ValueOrDie();
+      // Keeps the allocation when the number of coefficients is unchanged.
+      result->resize(rows, cols);
+      return result;
+    }
+  }
+  return absl::make_unique<Matrix>(rows, cols);
+}
+
+Packet MatrixOutputPool::MakePacket(std::unique_ptr<Matrix> matrix,
+                                    Timestamp timestamp) {
+  Packet packet = Adopt(matrix.release()).At(timestamp);
+  if (max_size_ > 0) {
+    if (packets_.size() == static_cast<size_t>(max_size_)) {
+      packets_.pop_front();
+    }
+    packets_.push_back(packet);
+  }
+  return packet;
+}
+
+}  // namespace mediapipe
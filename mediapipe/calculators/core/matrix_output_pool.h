@@ -0,0 +1,61 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_CALCULATORS_CORE_MATRIX_OUTPUT_POOL_H_
+#define MEDIAPIPE_CALCULATORS_CORE_MATRIX_OUTPUT_POOL_H_
+
+#include <deque>
+#include <memory>
+
+#include "mediapipe/framework/formats/matrix.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/timestamp.h"
+
+namespace mediapipe {
+
+// Recycles the storage of the Matrix packets a calculator outputs.
+//
+// The pool keeps a reference to each of the last max_size packets it made.
+// Once every other reference to one of them is gone, i.e. downstream
+// calculators are done with it, Acquire() takes its Matrix back instead of
+// allocating a new one. Packets are never modified while still referenced.
+//
+// Not thread-safe; meant to be owned by a calculator and used from Process().
+//
+// Example usage:
+//   std::unique_ptr<Matrix> output = pool_.Acquire(rows, cols);
+//   output->noalias() = a * b;
+//   cc->Outputs().Index(0).AddPacket(
+//       pool_.MakePacket(std::move(output), cc->InputTimestamp()));
+class MatrixOutputPool {
+ public:
+  // If max_size is 0, Acquire() always allocates a new Matrix.
+  explicit MatrixOutputPool(int max_size = 0) : max_size_(max_size) {}
+
+  // Returns a Matrix with the given dimensions and unspecified contents.
+  std::unique_ptr<Matrix> Acquire(int rows, int cols);
+
+  // Returns a packet owning matrix at the given timestamp, and keeps a
+  // reference to it for a later Acquire() to reuse.
+  Packet MakePacket(std::unique_ptr<Matrix> matrix, Timestamp timestamp);
+
+ private:
+  const int max_size_;
+  // The packets made, oldest first.
+  std::deque<Packet> packets_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_CALCULATORS_CORE_MATRIX_OUTPUT_POOL_H_
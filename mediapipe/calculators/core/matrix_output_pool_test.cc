@@ -0,0 +1,65 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/core/matrix_output_pool.h"
+
+#include <memory>
+
+#include "mediapipe/framework/formats/matrix.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(MatrixOutputPoolTest, ReusesReleasedMatrix) {
+  MatrixOutputPool pool(2);
+  std::unique_ptr<Matrix> matrix = pool.Acquire(3, 4);
+  const float* data = matrix->data();
+  Packet packet = pool.MakePacket(std::move(matrix), Timestamp(0));
+  EXPECT_EQ(Timestamp(0), packet.Timestamp());
+  packet = Packet();
+
+  matrix = pool.Acquire(4, 3);
+  EXPECT_EQ(data, matrix->data());
+  EXPECT_EQ(4, matrix->rows());
+  EXPECT_EQ(3, matrix->cols());
+}
+
+TEST(MatrixOutputPoolTest, DoesNotReuseReferencedMatrix) {
+  MatrixOutputPool pool(2);
+  std::unique_ptr<Matrix> matrix = pool.Acquire(3, 4);
+  matrix->setConstant(1.0f);
+  Packet packet = pool.MakePacket(std::move(matrix), Timestamp(0));
+
+  matrix = pool.Acquire(3, 4);
+  EXPECT_NE(packet.Get<Matrix>().data(), matrix->data());
+  matrix->setConstant(2.0f);
+  EXPECT_EQ(1.0f, packet.Get<Matrix>()(0, 0));
+}
+
+TEST(MatrixOutputPoolTest, KeepsAtMostMaxSizePackets) {
+  MatrixOutputPool pool(1);
+  Packet first = pool.MakePacket(pool.Acquire(2, 2), Timestamp(0));
+  const float* first_data = first.Get<Matrix>().data();
+  Packet second = pool.MakePacket(pool.Acquire(2, 2), Timestamp(1));
+  first = Packet();
+
+  // The first matrix was released, but the pool no longer holds it.
+  std::unique_ptr<Matrix> matrix = pool.Acquire(2, 2);
+  EXPECT_NE(first_data, matrix->data());
+  EXPECT_NE(second.Get<Matrix>().data(), matrix->data());
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -12,7 +12,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <memory>
+
 #include "Eigen/Core"
+#include "absl/memory/memory.h"
+#include "mediapipe/calculators/core/matrix_output_pool.h"
+#include "mediapipe/calculators/core/matrix_subtract_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/matrix.h"
 #include "mediapipe/framework/port/status.h"
@@ -25,6 +30,9 @@ namespace mediapipe {
 // and input side packet can be either subtrahend or minuend. The output matrix
 // is generated by performing minuend matrix - subtrahend matrix.
 //
+// With output_pool_size set in MatrixSubtractCalculatorOptions, the storage of
+// output matrices is reused once downstream calculators release them.
+//
 // Example config:
 // node {
 //   calculator: "MatrixSubtractCalculator"
@@ -53,6 +61,7 @@ class MatrixSubtractCalculator : public CalculatorBase {
 
  private:
   bool subtract_from_input_ = false;
+  std::unique_ptr<MatrixOutputPool> output_pool_;
 };
 REGISTER_CALCULATOR(MatrixSubtractCalculator);
 
@@ -88,11 +97,18 @@ REGISTER_CALCULATOR(MatrixSubtractCalculator);
   if (cc->Inputs().HasTag("MINUEND")) {
     subtract_from_input_ = true;
   }
+  const int output_pool_size =
+      cc->Options<MatrixSubtractCalculatorOptions>().output_pool_size();
+  if (output_pool_size < 0) {
+    return ::mediapipe::InvalidArgumentError(
+        "output_pool_size must not be negative.");
+  }
+  output_pool_ = absl::make_unique<MatrixOutputPool>(output_pool_size);
   return ::mediapipe::OkStatus();
 }
 
 ::mediapipe::Status MatrixSubtractCalculator::Process(CalculatorContext* cc) {
-  Matrix* subtracted = new Matrix();
+  std::unique_ptr<Matrix> subtracted;
   if (subtract_from_input_) {
     const Matrix& input_matrix = cc->Inputs().Tag("MINUEND").Get<Matrix>();
     const Matrix& side_input_matrix =
@@ -103,6 +119,8 @@ REGISTER_CALCULATOR(MatrixSubtractCalculator);
           "Input matrix and the input side matrix must have the same "
           "dimension.");
     }
+    subtracted =
+        output_pool_->Acquire(input_matrix.rows(), input_matrix.cols());
     *subtracted = input_matrix - side_input_matrix;
   } else {
     const Matrix& input_matrix = cc->Inputs().Tag("SUBTRAHEND").Get<Matrix>();
@@ -114,9 +132,12 @@ REGISTER_CALCULATOR(MatrixSubtractCalculator);
           "Input matrix and the input side matrix must have the same "
           "dimension.");
     }
+    subtracted =
+        output_pool_->Acquire(input_matrix.rows(), input_matrix.cols());
     *subtracted = side_input_matrix - input_matrix;
   }
-  cc->Outputs().Index(0).Add(subtracted, cc->InputTimestamp());
+  cc->Outputs().Index(0).AddPacket(
+      output_pool_->MakePacket(std::move(subtracted), cc->InputTimestamp()));
   return ::mediapipe::OkStatus();
 }
 
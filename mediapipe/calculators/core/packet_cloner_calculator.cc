@@ -56,6 +56,9 @@ class PacketClonerCalculator : public CalculatorBase {
   }
 
   ::mediapipe::Status Open(CalculatorContext* cc) final {
+    // Outputs are only emitted at the input timestamp, so the output bounds
+    // can follow the input bounds without waiting for a tick.
+    cc->SetOffset(TimestampDiff(0));
     // Load options.
     const auto calculator_options =
         cc->Options<mediapipe::PacketClonerCalculatorOptions>();
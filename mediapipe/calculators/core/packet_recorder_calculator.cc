@@ -0,0 +1,97 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/time/clock.h"
+#include "mediapipe/calculators/core/packet_recorder_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/util/packet_log.h"
+
+namespace mediapipe {
+
+// Records every packet of its input streams, with the time it arrived, into
+// a packet log file that a PacketReplayCalculator can play back, e.g. to
+// benchmark a graph on recorded production traffic. The log is written
+// through a memory mapping, so recording costs about one copy of each
+// packet's data.
+//
+// The packet types need a PacketSerializer, such as the ones of
+// //mediapipe/framework/formats:image_frame_serializer and
+// //mediapipe/framework/formats:matrix_serializer, or MEDIAPIPE_REGISTER_TYPE
+// serialize functions.
+//
+// Inputs (any number, untagged): Packets of any type.
+//
+// Example config:
+//   node {
+//     calculator: "PacketRecorderCalculator"
+//     input_stream: "input_video"
+//     input_stream: "detections"
+//     options {
+//       [mediapipe.PacketRecorderCalculatorOptions.ext] {
+//         file_path: "/tmp/traffic.log"
+//       }
+//     }
+//   }
+class PacketRecorderCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    RET_CHECK_GT(cc->Inputs().NumEntries(), 0);
+    for (int i = 0; i < cc->Inputs().NumEntries(); ++i) {
+      cc->Inputs().Index(i).SetAny();
+    }
+    // Packets are recorded in the order they arrive.
+    cc->SetInputStreamHandler("ImmediateInputStreamHandler");
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    const auto& options = cc->Options<PacketRecorderCalculatorOptions>();
+    RET_CHECK(!options.file_path().empty());
+    std::vector<std::string> stream_names;
+    for (int i = 0; i < cc->Inputs().NumEntries(); ++i) {
+      stream_names.push_back(cc->Inputs().Index(i).Name());
+    }
+    ASSIGN_OR_RETURN(
+        writer_, PacketLogWriter::Create(options.file_path(), stream_names));
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    const absl::Time arrival_time = absl::Now();
+    for (int i = 0; i < cc->Inputs().NumEntries(); ++i) {
+      if (!cc->Inputs().Index(i).IsEmpty()) {
+        MP_RETURN_IF_ERROR(
+            writer_->Append(i, arrival_time, cc->Inputs().Index(i).Value()));
+      }
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Close(CalculatorContext* cc) override {
+    return writer_ ? writer_->Close() : ::mediapipe::OkStatus();
+  }
+
+ private:
+  std::unique_ptr<PacketLogWriter> writer_;
+};
+REGISTER_CALCULATOR(PacketRecorderCalculator);
+
+}  // namespace mediapipe
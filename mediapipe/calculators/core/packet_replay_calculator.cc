@@ -0,0 +1,128 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+
+#include "absl/time/time.h"
+#include "mediapipe/calculators/core/packet_replay_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/deps/clock.h"
+#include "mediapipe/framework/deps/monotonic_clock.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/tool/status_util.h"
+#include "mediapipe/util/packet_log.h"
+
+namespace mediapipe {
+
+// Plays back a packet log written by a PacketRecorderCalculator, emitting
+// the packets of each recorded stream at their original timestamps on the
+// output with the same index. Packets are emitted in the order they were
+// recorded, either as fast as possible or, with "realtime", at the intervals
+// at which they arrived. Packets whose serializer allows it, such as
+// ImageFrames, use the mapped log file in place.
+//
+// With "realtime", the intervals are measured with the std::shared_ptr<Clock>
+// in the CLOCK side packet, if any, or else with a monotonic wall clock. With
+// the clock of a SimulationClockExecutor running the graph, the log is
+// processed with its original timing as fast as the graph can run.
+//
+// The serializers of the recorded types must be linked in, as for the
+// recorder.
+//
+// Input side packets:
+//   CLOCK (optional): A std::shared_ptr<Clock> for realtime playback.
+//
+// Outputs (one per recorded stream, untagged): The recorded packets.
+//
+// Example config:
+//   node {
+//     calculator: "PacketReplayCalculator"
+//     output_stream: "input_video"
+//     output_stream: "detections"
+//     options {
+//       [mediapipe.PacketReplayCalculatorOptions.ext] {
+//         file_path: "/tmp/traffic.log"
+//         realtime: true
+//       }
+//     }
+//   }
+class PacketReplayCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    RET_CHECK_GT(cc->Outputs().NumEntries(), 0);
+    for (int i = 0; i < cc->Outputs().NumEntries(); ++i) {
+      cc->Outputs().Index(i).SetAny();
+    }
+    if (cc->InputSidePackets().HasTag("CLOCK")) {
+      cc->InputSidePackets().Tag("CLOCK").Set<std::shared_ptr<Clock>>();
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    const auto& options = cc->Options<PacketReplayCalculatorOptions>();
+    RET_CHECK(!options.file_path().empty());
+    realtime_ = options.realtime();
+    if (cc->InputSidePackets().HasTag("CLOCK")) {
+      clock_ =
+          cc->InputSidePackets().Tag("CLOCK").Get<std::shared_ptr<Clock>>();
+    } else {
+      clock_ = std::shared_ptr<Clock>(
+          MonotonicClock::CreateSynchronizedMonotonicClock());
+    }
+    ASSIGN_OR_RETURN(reader_, PacketLogReader::Open(options.file_path()));
+    RET_CHECK_EQ(static_cast<size_t>(cc->Outputs().NumEntries()),
+                 reader_->stream_names().size())
+        << "The log of " << options.file_path() << " has "
+        << reader_->stream_names().size() << " streams.";
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    int stream_index;
+    absl::Time arrival_time;
+    Packet packet;
+    ASSIGN_OR_RETURN(bool read,
+                     reader_->Next(&stream_index, &arrival_time, &packet));
+    if (!read) {
+      return tool::StatusStop();
+    }
+    if (realtime_) {
+      const absl::Time now = clock_->TimeNow();
+      if (first_arrival_time_ == absl::InfinitePast()) {
+        first_arrival_time_ = arrival_time;
+        replay_start_time_ = now;
+      }
+      const absl::Time emit_time =
+          replay_start_time_ + (arrival_time - first_arrival_time_);
+      if (emit_time > now) {
+        clock_->SleepUntil(emit_time);
+      }
+    }
+    cc->Outputs().Index(stream_index).AddPacket(packet);
+    return ::mediapipe::OkStatus();
+  }
+
+ private:
+  std::unique_ptr<PacketLogReader> reader_;
+  bool realtime_ = false;
+  std::shared_ptr<Clock> clock_;
+  absl::Time first_arrival_time_ = absl::InfinitePast();
+  absl::Time replay_start_time_;
+};
+REGISTER_CALCULATOR(PacketReplayCalculator);
+
+}  // namespace mediapipe
@@ -0,0 +1,164 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/substitute.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/deps/clock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/tool/simulation_clock_executor.h"
+
+namespace mediapipe {
+namespace {
+
+// Records two streams, with "gap" between the arrival of their packets.
+void RecordLog(const std::string& path, absl::Duration gap) {
+  CalculatorGraph graph(
+      ParseTextProtoOrDie<CalculatorGraphConfig>(absl::Substitute(R"(
+        input_stream: "strings"
+        input_stream: "floats"
+        node {
+          calculator: "PacketRecorderCalculator"
+          input_stream: "strings"
+          input_stream: "floats"
+          options {
+            [mediapipe.PacketRecorderCalculatorOptions.ext] {
+              file_path: "$0"
+            }
+          }
+        })",
+                                                                  path)));
+  MP_ASSERT_OK(graph.StartRun({}));
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "strings", MakePacket<std::string>("first").At(Timestamp(1))));
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+  absl::SleepFor(gap);
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "floats",
+      MakePacket<std::vector<float>>(std::vector<float>{1.5f}).At(
+          Timestamp(2))));
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "strings", MakePacket<std::string>("second").At(Timestamp(3))));
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+}
+
+// Replays the log and returns the packets of both streams. If "executor" is
+// set, the graph runs on it, and realtime playback uses its clock.
+void ReplayLog(const std::string& path, bool realtime,
+               std::shared_ptr<SimulationClockExecutor> executor,
+               std::vector<Packet>* strings, std::vector<Packet>* floats) {
+  CalculatorGraphConfig config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(absl::Substitute(R"(
+        node {
+          calculator: "PacketReplayCalculator"
+          output_stream: "strings"
+          output_stream: "floats"
+          options {
+            [mediapipe.PacketReplayCalculatorOptions.ext] {
+              file_path: "$0"
+              realtime: $1
+            }
+          }
+        })",
+                                                                  path,
+                                                                  realtime));
+  CalculatorGraph graph;
+  std::map<std::string, Packet> side_packets;
+  if (executor) {
+    config.mutable_node(0)->add_input_side_packet("CLOCK:clock");
+    side_packets["clock"] =
+        MakePacket<std::shared_ptr<Clock>>(executor->GetClock());
+    MP_ASSERT_OK(graph.SetExecutor("", executor));
+  }
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.ObserveOutputStream("strings", [strings](const Packet& p) {
+    strings->push_back(p);
+    return ::mediapipe::OkStatus();
+  }));
+  MP_ASSERT_OK(graph.ObserveOutputStream("floats", [floats](const Packet& p) {
+    floats->push_back(p);
+    return ::mediapipe::OkStatus();
+  }));
+  MP_ASSERT_OK(graph.Run(side_packets));
+}
+
+TEST(PacketReplayCalculatorTest, ReplaysRecordedStreams) {
+  const std::string path =
+      absl::StrCat("/tmp/packet_replay_calculator_test_", getpid(), ".log");
+  RecordLog(path, absl::ZeroDuration());
+
+  std::vector<Packet> strings;
+  std::vector<Packet> floats;
+  ReplayLog(path, /*realtime=*/false, nullptr, &strings, &floats);
+  ASSERT_EQ(strings.size(), 2);
+  EXPECT_EQ(strings[0].Get<std::string>(), "first");
+  EXPECT_EQ(strings[0].Timestamp(), Timestamp(1));
+  EXPECT_EQ(strings[1].Get<std::string>(), "second");
+  EXPECT_EQ(strings[1].Timestamp(), Timestamp(3));
+  ASSERT_EQ(floats.size(), 1);
+  EXPECT_EQ(floats[0].Get<std::vector<float>>(), std::vector<float>{1.5f});
+  EXPECT_EQ(floats[0].Timestamp(), Timestamp(2));
+  unlink(path.c_str());
+}
+
+TEST(PacketReplayCalculatorTest, KeepsOriginalTimingInRealtime) {
+  const std::string path =
+      absl::StrCat("/tmp/packet_replay_calculator_realtime_", getpid(), ".log");
+  const absl::Duration gap = absl::Milliseconds(100);
+  RecordLog(path, gap);
+
+  std::vector<Packet> strings;
+  std::vector<Packet> floats;
+  const absl::Time start = absl::Now();
+  ReplayLog(path, /*realtime=*/true, nullptr, &strings, &floats);
+  EXPECT_GE(absl::Now() - start, gap);
+  EXPECT_EQ(strings.size(), 2);
+  EXPECT_EQ(floats.size(), 1);
+  unlink(path.c_str());
+}
+
+TEST(PacketReplayCalculatorTest, KeepsOriginalTimingInSimulatedTime) {
+  const std::string path = absl::StrCat(
+      "/tmp/packet_replay_calculator_simulated_", getpid(), ".log");
+  const absl::Duration gap = absl::Milliseconds(100);
+  RecordLog(path, gap);
+
+  SimulationClock::Options clock_options;
+  clock_options.serialize_wakeups = false;
+  auto executor = std::make_shared<SimulationClockExecutor>(2, clock_options);
+  std::vector<Packet> strings;
+  std::vector<Packet> floats;
+  ReplayLog(path, /*realtime=*/true, executor, &strings, &floats);
+  // The clock jumped over the gap between the recorded packets.
+  EXPECT_GE(executor->GetClock()->TimeNow() - absl::UnixEpoch(), gap);
+  EXPECT_EQ(strings.size(), 2);
+  EXPECT_EQ(floats.size(), 1);
+  unlink(path.c_str());
+}
+
+}  // namespace
+}  // namespace mediapipe
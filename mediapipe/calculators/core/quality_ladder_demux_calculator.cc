@@ -0,0 +1,223 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "mediapipe/calculators/core/quality_ladder_demux_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/deps/clock.h"
+#include "mediapipe/framework/deps/monotonic_clock.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+
+namespace mediapipe {
+
+// Forwards each input packet to one of the n output streams "OUTPUT:0",
+// "OUTPUT:1", ..., which feed variants of the same model ordered from the
+// best and slowest to the cheapest, such as full and lite models or
+// decreasing input resolutions.  The calculator measures the latency of the
+// selected branch, from sending a packet on "OUTPUT:i" until a packet with the
+// same timestamp arrives on the back edge "FINISHED:i", and moves down the
+// ladder when the latency at latency_percentile exceeds target_latency_usec,
+// and back up when it falls below upgrade_latency_ratio of the budget.  A
+// decision is made after every adaptation_window latencies of one branch.
+//
+// Every branch is opened with the graph, so each TfLiteInferenceCalculator
+// keeps its interpreter loaded, and switching between branches costs nothing.
+// Slow devices thus trade model quality for latency instead of dropping
+// frames.  The index of the selected output stream is emitted to the
+// optional output stream "SELECT", and the outputs should be merged with
+// ImmediateMuxCalculator, or with MuxCalculator and the "SELECT" stream.  The
+// latency is measured with the std::shared_ptr<Clock> in the CLOCK side
+// packet, if any, or else with a monotonic wall clock.
+//
+// Example config:
+//   node {
+//     calculator: "QualityLadderDemuxCalculator"
+//     input_stream: "frames"
+//     input_stream: "FINISHED:0:detections_full"
+//     input_stream: "FINISHED:1:detections_lite"
+//     input_stream_info: { tag_index: "FINISHED:0" back_edge: true }
+//     input_stream_info: { tag_index: "FINISHED:1" back_edge: true }
+//     output_stream: "OUTPUT:0:frames_full"
+//     output_stream: "OUTPUT:1:frames_lite"
+//     options {
+//       [mediapipe.QualityLadderDemuxCalculatorOptions.ext] {
+//         target_latency_usec: 40000
+//       }
+//     }
+//   }
+//   node {
+//     calculator: "PalmDetectionFullSubgraph"
+//     input_stream: "frames_full"
+//     output_stream: "detections_full"
+//   }
+//   node {
+//     calculator: "PalmDetectionLiteSubgraph"
+//     input_stream: "frames_lite"
+//     output_stream: "detections_lite"
+//   }
+//   node {
+//     calculator: "ImmediateMuxCalculator"
+//     input_stream_handler {
+//       input_stream_handler: "ImmediateInputStreamHandler"
+//     }
+//     input_stream: "detections_full"
+//     input_stream: "detections_lite"
+//     output_stream: "detections"
+//   }
+class QualityLadderDemuxCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    RET_CHECK_EQ(cc->Inputs().NumEntries(""), 1);
+    RET_CHECK_GT(cc->Outputs().NumEntries("OUTPUT"), 0);
+    RET_CHECK_EQ(cc->Inputs().NumEntries("FINISHED"),
+                 cc->Outputs().NumEntries("OUTPUT"))
+        << "Each OUTPUT stream needs a corresponding FINISHED stream.";
+    cc->Inputs().Get("", 0).SetAny();
+    for (CollectionItemId id = cc->Inputs().BeginId("FINISHED");
+         id < cc->Inputs().EndId("FINISHED"); ++id) {
+      cc->Inputs().Get(id).SetAny();
+    }
+    for (CollectionItemId id = cc->Outputs().BeginId("OUTPUT");
+         id < cc->Outputs().EndId("OUTPUT"); ++id) {
+      cc->Outputs().Get(id).SetSameAs(&cc->Inputs().Get("", 0));
+    }
+    if (cc->Outputs().HasTag("SELECT")) {
+      cc->Outputs().Tag("SELECT").Set<int>();
+    }
+    if (cc->InputSidePackets().HasTag("CLOCK")) {
+      cc->InputSidePackets().Tag("CLOCK").Set<std::shared_ptr<Clock>>();
+    }
+    cc->SetInputStreamHandler("ImmediateInputStreamHandler");
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    options_ = cc->Options<QualityLadderDemuxCalculatorOptions>();
+    RET_CHECK_GT(options_.target_latency_usec(), 0);
+    RET_CHECK_GT(options_.latency_percentile(), 0.0);
+    RET_CHECK_LE(options_.latency_percentile(), 1.0);
+    RET_CHECK_GE(options_.adaptation_window(), 1);
+    RET_CHECK_GT(options_.upgrade_latency_ratio(), 0.0);
+    RET_CHECK_LT(options_.upgrade_latency_ratio(), 1.0);
+    data_input_ = cc->Inputs().GetId("", 0);
+    finished_base_ = cc->Inputs().BeginId("FINISHED");
+    output_data_stream_base_ = cc->Outputs().BeginId("OUTPUT");
+    select_output_ = cc->Outputs().GetId("SELECT", 0);
+    send_times_.resize(cc->Outputs().NumEntries("OUTPUT"));
+    RET_CHECK_GE(options_.initial_branch(), 0);
+    RET_CHECK_LT(options_.initial_branch(), send_times_.size());
+    selected_ = options_.initial_branch();
+    if (cc->InputSidePackets().HasTag("CLOCK")) {
+      clock_ =
+          cc->InputSidePackets().Tag("CLOCK").Get<std::shared_ptr<Clock>>();
+    } else {
+      clock_ = std::shared_ptr<Clock>(
+          MonotonicClock::CreateSynchronizedMonotonicClock());
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    for (int i = 0; i < send_times_.size(); ++i) {
+      const Packet& finished = cc->Inputs().Get(finished_base_ + i).Value();
+      if (!finished.IsEmpty()) {
+        MP_RETURN_IF_ERROR(RecordLatency(i, finished.Timestamp()));
+      }
+    }
+
+    const Packet& packet = cc->Inputs().Get(data_input_).Value();
+    if (packet.IsEmpty()) {
+      return ::mediapipe::OkStatus();
+    }
+    send_times_[selected_].emplace(packet.Timestamp(), clock_->TimeNow());
+    cc->Outputs().Get(output_data_stream_base_ + selected_).AddPacket(packet);
+    if (select_output_.IsValid()) {
+      cc->Outputs()
+          .Get(select_output_)
+          .Add(new int(selected_), packet.Timestamp());
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+ private:
+  // Records the latency of the packet of "branch" at "timestamp".  If no
+  // packet was sent at that timestamp, the oldest one in flight is assumed.
+  ::mediapipe::Status RecordLatency(int branch, Timestamp timestamp) {
+    auto& send_times = send_times_[branch];
+    auto it = send_times.find(timestamp);
+    if (it == send_times.end()) {
+      it = send_times.begin();
+    }
+    RET_CHECK(it != send_times.end())
+        << "Received a FINISHED packet for branch " << branch
+        << ", but it had none in flight.";
+    const int64 latency =
+        absl::ToInt64Microseconds(clock_->TimeNow() - it->second);
+    send_times.erase(it);
+    // Latencies of packets sent before the last switch are not counted.
+    if (branch == selected_) {
+      latencies_usec_.push_back(latency);
+      MaybeSwitchBranch();
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  // Moves along the ladder once adaptation_window latencies are recorded.
+  void MaybeSwitchBranch() {
+    if (latencies_usec_.size() <
+        static_cast<size_t>(options_.adaptation_window())) {
+      return;
+    }
+    const int index = std::max(
+        0, static_cast<int>(std::ceil(options_.latency_percentile() *
+                                      latencies_usec_.size())) -
+               1);
+    std::nth_element(latencies_usec_.begin(), latencies_usec_.begin() + index,
+                     latencies_usec_.end());
+    const int64 latency = latencies_usec_[index];
+    latencies_usec_.clear();
+    if (latency > options_.target_latency_usec() &&
+        selected_ + 1 < send_times_.size()) {
+      ++selected_;
+    } else if (latency < options_.upgrade_latency_ratio() *
+                             options_.target_latency_usec() &&
+               selected_ > 0) {
+      --selected_;
+    }
+  }
+
+  QualityLadderDemuxCalculatorOptions options_;
+  CollectionItemId data_input_;
+  CollectionItemId finished_base_;
+  CollectionItemId output_data_stream_base_;
+  CollectionItemId select_output_;
+  std::shared_ptr<Clock> clock_;
+  // The send time of each packet in flight on each branch.
+  std::vector<std::map<Timestamp, absl::Time>> send_times_;
+  // The latencies of the selected branch measured since the last decision.
+  std::vector<int64> latencies_usec_;
+  int selected_;
+};
+
+REGISTER_CALCULATOR(QualityLadderDemuxCalculator);
+
+}  // namespace mediapipe
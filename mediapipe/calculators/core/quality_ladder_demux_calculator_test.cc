@@ -0,0 +1,160 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/deps/clock.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+
+// A clock that only advances when told to.
+class ManualClock : public Clock {
+ public:
+  absl::Time TimeNow() override {
+    absl::MutexLock lock(&mutex_);
+    return time_;
+  }
+  void Sleep(absl::Duration d) override { Advance(d); }
+  void SleepUntil(absl::Time wakeup_time) override {
+    absl::MutexLock lock(&mutex_);
+    time_ = std::max(time_, wakeup_time);
+  }
+  void Advance(absl::Duration d) {
+    absl::MutexLock lock(&mutex_);
+    time_ += d;
+  }
+
+ private:
+  absl::Mutex mutex_;
+  absl::Time time_ = absl::UnixEpoch();
+};
+
+class QualityLadderDemuxCalculatorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    clock_ = std::make_shared<ManualClock>();
+    MP_ASSERT_OK(graph_.Initialize(
+        ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+          input_stream: "input"
+          input_stream: "finished0"
+          input_stream: "finished1"
+          input_stream: "finished2"
+          node {
+            calculator: "QualityLadderDemuxCalculator"
+            input_side_packet: "CLOCK:clock"
+            input_stream: "input"
+            input_stream: "FINISHED:0:finished0"
+            input_stream: "FINISHED:1:finished1"
+            input_stream: "FINISHED:2:finished2"
+            output_stream: "OUTPUT:0:output0"
+            output_stream: "OUTPUT:1:output1"
+            output_stream: "OUTPUT:2:output2"
+            output_stream: "SELECT:select"
+            options {
+              [mediapipe.QualityLadderDemuxCalculatorOptions.ext] {
+                target_latency_usec: 1000
+                latency_percentile: 1.0
+                adaptation_window: 2
+              }
+            }
+          }
+        )"),
+        {{"clock", MakePacket<std::shared_ptr<Clock>>(clock_)}}));
+    MP_ASSERT_OK(graph_.ObserveOutputStream("select", [this](const Packet& p) {
+      selected_.push_back(p.Get<int>());
+      return ::mediapipe::OkStatus();
+    }));
+    MP_ASSERT_OK(graph_.StartRun({}));
+  }
+
+  void AddPacket(const std::string& stream, int64 timestamp) {
+    MP_ASSERT_OK(graph_.AddPacketToInputStream(
+        stream, MakePacket<int>(0).At(Timestamp(timestamp))));
+    MP_ASSERT_OK(graph_.WaitUntilIdle());
+  }
+
+  // Sends "count" packets one at a time, each finishing on its branch after
+  // "latency_usec".
+  void RunPackets(int count, int64 latency_usec) {
+    for (int i = 0; i < count; ++i) {
+      ++timestamp_;
+      AddPacket("input", timestamp_);
+      ASSERT_FALSE(selected_.empty());
+      clock_->Advance(absl::Microseconds(latency_usec));
+      AddPacket(absl::StrCat("finished", selected_.back()), timestamp_);
+    }
+  }
+
+  CalculatorGraph graph_;
+  std::shared_ptr<ManualClock> clock_;
+  std::vector<int> selected_;
+  int64 timestamp_ = 0;
+};
+
+TEST_F(QualityLadderDemuxCalculatorTest, MovesDownAndUpTheLadder) {
+  RunPackets(2, 2000);  // Over budget: moves to branch 1.
+  RunPackets(2, 800);   // Within budget: stays.
+  RunPackets(2, 2000);  // Over budget: moves to branch 2.
+  RunPackets(2, 2000);  // Already the cheapest branch.
+  RunPackets(2, 100);   // Well within budget: moves back to branch 1.
+  RunPackets(1, 100);
+  MP_ASSERT_OK(graph_.CloseAllInputStreams());
+  MP_ASSERT_OK(graph_.WaitUntilDone());
+  EXPECT_THAT(selected_, ElementsAre(0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 1));
+}
+
+TEST_F(QualityLadderDemuxCalculatorTest, IgnoresLatencyOfPreviousBranch) {
+  // Two packets are in flight on branch 0 when it is abandoned.
+  AddPacket("input", 1);
+  AddPacket("input", 2);
+  AddPacket("input", 3);
+  AddPacket("input", 4);
+  clock_->Advance(absl::Microseconds(2000));
+  AddPacket("finished0", 1);
+  AddPacket("finished0", 2);
+  AddPacket("input", 5);
+  // Their latencies do not count against branch 1.
+  AddPacket("finished0", 3);
+  AddPacket("finished0", 4);
+  AddPacket("finished1", 5);
+  AddPacket("input", 6);
+  MP_ASSERT_OK(graph_.CloseAllInputStreams());
+  MP_ASSERT_OK(graph_.WaitUntilDone());
+  EXPECT_THAT(selected_, ElementsAre(0, 0, 0, 0, 1, 1));
+}
+
+TEST_F(QualityLadderDemuxCalculatorTest, FailsOnUnexpectedFinishedPacket) {
+  MP_ASSERT_OK(graph_.AddPacketToInputStream(
+      "finished1", MakePacket<int>(0).At(Timestamp(1))));
+  MP_ASSERT_OK(graph_.CloseAllInputStreams());
+  EXPECT_FALSE(graph_.WaitUntilDone().ok());
+}
+
+}  // namespace
+}  // namespace mediapipe
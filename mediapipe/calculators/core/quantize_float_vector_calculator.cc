@@ -12,11 +12,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <cfloat>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "absl/memory/memory.h"
 #include "mediapipe/calculators/core/quantize_float_vector_calculator.pb.h"
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/calculator_framework.h"
@@ -25,7 +27,8 @@
 
 // Quantizes a vector of floats to a std::string so that each float becomes a
 // byte in the [0, 255] range. Any value above max_quantized_value or below
-// min_quantized_value will be saturated to '/xFF' or '/0'.
+// min_quantized_value will be saturated to '/xFF' or '/0'. The output can be
+// decoded with DequantizeByteArrayCalculator.
 //
 // Example config:
 //   node {
@@ -65,29 +68,28 @@ class QuantizeFloatVectorCalculator : public CalculatorBase {
           "max_quantized_value must be greater than min_quantized_value.");
     }
     range_ = max_quantized_value_ - min_quantized_value_;
+    scale_ = 255.0 / range_;
     return ::mediapipe::OkStatus();
   }
 
   ::mediapipe::Status Process(CalculatorContext* cc) final {
     const std::vector<float>& float_vector =
         cc->Inputs().Tag("FLOAT_VECTOR").Value().Get<std::vector<float>>();
-    int feature_size = float_vector.size();
-    std::string encoded_features;
-    encoded_features.reserve(feature_size);
+    const int feature_size = float_vector.size();
+    auto encoded_features = absl::make_unique<std::string>(feature_size, '\0');
+    // The loop is branch-free and writes to a preallocated buffer, so that the
+    // compiler can vectorize it.
+    const float* input = float_vector.data();
+    char* output = &(*encoded_features)[0];
+    const float min_value = min_quantized_value_;
+    const float max_value = max_quantized_value_;
+    const double scale = scale_;
     for (int i = 0; i < feature_size; i++) {
-      float old_value = float_vector[i];
-      if (old_value < min_quantized_value_) {
-        old_value = min_quantized_value_;
-      }
-      if (old_value > max_quantized_value_) {
-        old_value = max_quantized_value_;
-      }
-      unsigned char encoded = static_cast<unsigned char>(
-          (old_value - min_quantized_value_) * (255.0 / range_));
-      encoded_features += encoded;
+      const float value = std::min(std::max(input[i], min_value), max_value);
+      output[i] = static_cast<unsigned char>((value - min_value) * scale);
     }
-    cc->Outputs().Tag("ENCODED").AddPacket(
-        MakePacket<std::string>(encoded_features).At(cc->InputTimestamp()));
+    cc->Outputs().Tag("ENCODED").Add(encoded_features.release(),
+                                     cc->InputTimestamp());
     return ::mediapipe::OkStatus();
   }
 
@@ -95,6 +97,7 @@ class QuantizeFloatVectorCalculator : public CalculatorBase {
   float max_quantized_value_;
   float min_quantized_value_;
   float range_;
+  double scale_;
 };
 
 REGISTER_CALCULATOR(QuantizeFloatVectorCalculator);
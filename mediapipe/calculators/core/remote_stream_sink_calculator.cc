@@ -0,0 +1,151 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/calculators/core/remote_stream_sink_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/util/remote_stream.h"
+
+namespace mediapipe {
+
+// Sends its input streams over TCP to a RemoteStreamSourceCalculator, which
+// emits them in a graph on another host, so that a pipeline can be split
+// between e.g. an edge device and a server. Packets keep their timestamps,
+// and the timestamp bound of the inputs is sent along with them, so the
+// receiving graph can proceed on timestamps without packets.
+//
+// Packets of up to max_batch_size input timestamps are sent in one message,
+// and ImageFrames may be compressed with PNG or JPEG. When the inputs close,
+// the remaining batch is sent and the source closes its outputs.
+//
+// The connection is neither authenticated nor encrypted, so it should only
+// cross trusted networks.
+//
+// Inputs (at least one; any number of indices per tag, matched by tag and
+// index to the outputs of the source):
+//   IMAGE: An ImageFrame.
+//   DATA: A std::string, such as a serialized proto.
+//
+// Example config:
+//   node {
+//     calculator: "RemoteStreamSinkCalculator"
+//     input_stream: "IMAGE:camera_frames"
+//     input_stream: "DATA:detections"
+//     options {
+//       [mediapipe.RemoteStreamSinkCalculatorOptions.ext] {
+//         host: "gpu-server"
+//         port: 9300
+//         image_encoding: JPEG
+//       }
+//     }
+//   }
+class RemoteStreamSinkCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    const int num_images = cc->Inputs().NumEntries("IMAGE");
+    const int num_data = cc->Inputs().NumEntries("DATA");
+    RET_CHECK_GT(num_images + num_data, 0);
+    RET_CHECK_EQ(num_images + num_data, cc->Inputs().NumEntries())
+        << "Only IMAGE and DATA inputs are supported.";
+    for (CollectionItemId id = cc->Inputs().BeginId("IMAGE");
+         id < cc->Inputs().EndId("IMAGE"); ++id) {
+      cc->Inputs().Get(id).Set<ImageFrame>();
+    }
+    for (CollectionItemId id = cc->Inputs().BeginId("DATA");
+         id < cc->Inputs().EndId("DATA"); ++id) {
+      cc->Inputs().Get(id).Set<std::string>();
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    const auto& options = cc->Options<RemoteStreamSinkCalculatorOptions>();
+    RET_CHECK(!options.host().empty());
+    RET_CHECK_GT(options.port(), 0);
+    RET_CHECK_GT(options.max_batch_size(), 0);
+    max_batch_size_ = options.max_batch_size();
+    max_batch_delay_ = absl::Microseconds(options.max_batch_delay_usec());
+    encoding_.codec = static_cast<RemoteStreamImageEncoding::Codec>(
+        options.image_encoding());
+    encoding_.jpeg_quality = options.jpeg_quality();
+    ASSIGN_OR_RETURN(connection_,
+                     RemoteStreamConnection::Connect(
+                         options.host(), options.port(),
+                         absl::Microseconds(options.connect_timeout_usec())));
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    if (batch_size_ == 0) {
+      batch_start_ = absl::Now();
+    }
+    for (CollectionItemId id = cc->Inputs().BeginId();
+         id < cc->Inputs().EndId(); ++id) {
+      if (!cc->Inputs().Get(id).IsEmpty()) {
+        batch_.packets.emplace_back(id.value(), cc->Inputs().Get(id).Value());
+      }
+    }
+    // Every input has settled the input timestamp.
+    batch_.next_timestamp_bound = cc->InputTimestamp().NextAllowedInStream();
+    ++batch_size_;
+    if (batch_size_ >= max_batch_size_ ||
+        absl::Now() - batch_start_ >= max_batch_delay_) {
+      MP_RETURN_IF_ERROR(SendBatch());
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Close(CalculatorContext* cc) override {
+    if (!connection_) {
+      return ::mediapipe::OkStatus();
+    }
+    if (batch_size_ > 0) {
+      MP_RETURN_IF_ERROR(SendBatch());
+    }
+    return connection_->Send(RemoteStreamConnection::kEnd, "");
+  }
+
+ private:
+  ::mediapipe::Status SendBatch() {
+    MP_RETURN_IF_ERROR(
+        SerializeRemoteStreamBatch(batch_, encoding_, &serialized_batch_));
+    MP_RETURN_IF_ERROR(
+        connection_->Send(RemoteStreamConnection::kBatch, serialized_batch_));
+    batch_.packets.clear();
+    batch_size_ = 0;
+    return ::mediapipe::OkStatus();
+  }
+
+  std::unique_ptr<RemoteStreamConnection> connection_;
+  RemoteStreamImageEncoding encoding_;
+  int max_batch_size_ = 1;
+  absl::Duration max_batch_delay_;
+  // The pending batch, holding the packets of batch_size_ input timestamps.
+  RemoteStreamBatch batch_;
+  int batch_size_ = 0;
+  absl::Time batch_start_;
+  // Reused to avoid reallocating the message buffer.
+  std::string serialized_batch_;
+};
+REGISTER_CALCULATOR(RemoteStreamSinkCalculator);
+
+}  // namespace mediapipe
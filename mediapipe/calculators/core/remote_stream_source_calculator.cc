@@ -0,0 +1,139 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+
+#include "absl/time/time.h"
+#include "mediapipe/calculators/core/remote_stream_source_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/tool/status_util.h"
+#include "mediapipe/util/remote_stream.h"
+
+namespace mediapipe {
+
+// Emits the streams a RemoteStreamSinkCalculator in another graph, usually on
+// another host, sends over TCP, at their original timestamps. The timestamp
+// bounds the sink sends are applied to every output, and the outputs close
+// when the sink's inputs do.
+//
+// The calculator listens on its port from Open(), and accepts one sink
+// connection. The connection is neither authenticated nor encrypted, so the
+// port should only be reachable from trusted networks.
+//
+// Outputs (at least one; any number of indices per tag, matched by tag and
+// index to the inputs of the sink, whose packets for missing outputs are
+// discarded):
+//   IMAGE: An ImageFrame.
+//   DATA: A std::string.
+//
+// Example config:
+//   node {
+//     calculator: "RemoteStreamSourceCalculator"
+//     output_stream: "IMAGE:camera_frames"
+//     output_stream: "DATA:detections"
+//     options {
+//       [mediapipe.RemoteStreamSourceCalculatorOptions.ext] {
+//         port: 9300
+//       }
+//     }
+//   }
+class RemoteStreamSourceCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    const int num_images = cc->Outputs().NumEntries("IMAGE");
+    const int num_data = cc->Outputs().NumEntries("DATA");
+    RET_CHECK_GT(num_images + num_data, 0);
+    RET_CHECK_EQ(num_images + num_data, cc->Outputs().NumEntries())
+        << "Only IMAGE and DATA outputs are supported.";
+    for (CollectionItemId id = cc->Outputs().BeginId("IMAGE");
+         id < cc->Outputs().EndId("IMAGE"); ++id) {
+      cc->Outputs().Get(id).Set<ImageFrame>();
+    }
+    for (CollectionItemId id = cc->Outputs().BeginId("DATA");
+         id < cc->Outputs().EndId("DATA"); ++id) {
+      cc->Outputs().Get(id).Set<std::string>();
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    const auto& options = cc->Options<RemoteStreamSourceCalculatorOptions>();
+    poll_timeout_ = absl::Microseconds(options.poll_timeout_usec());
+    ASSIGN_OR_RETURN(listener_, RemoteStreamListener::Listen(options.port()));
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    if (!connection_) {
+      ASSIGN_OR_RETURN(connection_, listener_->Accept(poll_timeout_));
+      if (!connection_) {
+        return ::mediapipe::OkStatus();
+      }
+      // Only one sink is served.
+      listener_.reset();
+    }
+    RemoteStreamConnection::MessageType type;
+    ASSIGN_OR_RETURN(bool received,
+                     connection_->Receive(poll_timeout_, &type, &message_));
+    if (!received) {
+      return ::mediapipe::OkStatus();
+    }
+    if (type == RemoteStreamConnection::kEnd) {
+      return tool::StatusStop();
+    }
+    RET_CHECK_EQ(type, RemoteStreamConnection::kBatch)
+        << "Unknown remote stream message type " << static_cast<int>(type);
+    RemoteStreamBatch batch;
+    MP_RETURN_IF_ERROR(ParseRemoteStreamBatch(message_, &batch));
+
+    const int num_outputs = cc->Outputs().NumEntries();
+    for (auto& stream_and_packet : batch.packets) {
+      const CollectionItemId id(stream_and_packet.first);
+      if (stream_and_packet.first < 0 ||
+          stream_and_packet.first >= num_outputs) {
+        continue;
+      }
+      const bool is_image_output = id >= cc->Outputs().BeginId("IMAGE") &&
+                                   id < cc->Outputs().EndId("IMAGE");
+      RET_CHECK_EQ(is_image_output,
+                   stream_and_packet.second.ValidateAsType<ImageFrame>().ok())
+          << "The outputs do not match the inputs of the sink.";
+      cc->Outputs().Get(id).AddPacket(std::move(stream_and_packet.second));
+    }
+    for (CollectionItemId id = cc->Outputs().BeginId();
+         id < cc->Outputs().EndId(); ++id) {
+      if (cc->Outputs().Get(id).NextTimestampBound() <
+          batch.next_timestamp_bound) {
+        cc->Outputs().Get(id).SetNextTimestampBound(
+            batch.next_timestamp_bound);
+      }
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+ private:
+  std::unique_ptr<RemoteStreamListener> listener_;
+  std::unique_ptr<RemoteStreamConnection> connection_;
+  absl::Duration poll_timeout_;
+  // Reused to avoid reallocating the message buffer.
+  std::string message_;
+};
+REGISTER_CALCULATOR(RemoteStreamSourceCalculator);
+
+}  // namespace mediapipe
@@ -0,0 +1,132 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/substitute.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+// Runs a RemoteStreamSinkCalculator and a RemoteStreamSourceCalculator in two
+// graphs, as they would on two hosts, connected over loopback.
+TEST(RemoteStreamSourceCalculatorTest, ReceivesPacketsFromSink) {
+  const int port = 20000 + getpid() % 20000;
+  CalculatorGraph source_graph(ParseTextProtoOrDie<CalculatorGraphConfig>(
+      absl::Substitute(R"(
+        node {
+          calculator: "RemoteStreamSourceCalculator"
+          output_stream: "IMAGE:images"
+          output_stream: "DATA:strings"
+          options {
+            [mediapipe.RemoteStreamSourceCalculatorOptions.ext] {
+              port: $0
+              poll_timeout_usec: 10000
+            }
+          }
+        })",
+                       port)));
+  CalculatorGraph sink_graph(ParseTextProtoOrDie<CalculatorGraphConfig>(
+      absl::Substitute(R"(
+        input_stream: "images"
+        input_stream: "strings"
+        node {
+          calculator: "RemoteStreamSinkCalculator"
+          input_stream: "IMAGE:images"
+          input_stream: "DATA:strings"
+          options {
+            [mediapipe.RemoteStreamSinkCalculatorOptions.ext] {
+              host: "localhost"
+              port: $0
+              max_batch_size: 2
+              image_encoding: PNG
+            }
+          }
+        })",
+                       port)));
+  absl::Mutex mutex;
+  std::vector<Packet> image_packets;
+  std::vector<Packet> string_packets;
+  MP_ASSERT_OK(source_graph.ObserveOutputStream(
+      "images", [&](const Packet& packet) {
+        absl::MutexLock lock(&mutex);
+        image_packets.push_back(packet);
+        return ::mediapipe::OkStatus();
+      }));
+  MP_ASSERT_OK(source_graph.ObserveOutputStream(
+      "strings", [&](const Packet& packet) {
+        absl::MutexLock lock(&mutex);
+        string_packets.push_back(packet);
+        return ::mediapipe::OkStatus();
+      }));
+  MP_ASSERT_OK(source_graph.StartRun({}));
+  MP_ASSERT_OK(sink_graph.StartRun({}));
+
+  // A frame with padded rows.
+  auto frame = absl::make_unique<ImageFrame>(ImageFormat::SRGB, 5, 3,
+                                             /*alignment_boundary=*/16);
+  for (int y = 0; y < frame->Height(); ++y) {
+    uint8* row = frame->MutablePixelData() + y * frame->WidthStep();
+    for (int x = 0; x < frame->Width() * frame->NumberOfChannels(); ++x) {
+      row[x] = y * 16 + x;
+    }
+  }
+  const Packet frame_packet = Adopt(frame.release()).At(Timestamp(1));
+  MP_ASSERT_OK(sink_graph.AddPacketToInputStream("images", frame_packet));
+  MP_ASSERT_OK(sink_graph.AddPacketToInputStream(
+      "strings", MakePacket<std::string>("first").At(Timestamp(1))));
+  MP_ASSERT_OK(sink_graph.AddPacketToInputStream(
+      "strings", MakePacket<std::string>("second").At(Timestamp(2))));
+  MP_ASSERT_OK(sink_graph.AddPacketToInputStream(
+      "strings", MakePacket<std::string>("third").At(Timestamp(3))));
+  MP_ASSERT_OK(sink_graph.CloseAllInputStreams());
+  MP_ASSERT_OK(sink_graph.WaitUntilDone());
+  // The source stops once the sink has closed.
+  MP_ASSERT_OK(source_graph.WaitUntilDone());
+
+  ASSERT_EQ(image_packets.size(), 1);
+  EXPECT_EQ(image_packets[0].Timestamp(), Timestamp(1));
+  const auto& sent = frame_packet.Get<ImageFrame>();
+  const auto& received = image_packets[0].Get<ImageFrame>();
+  ASSERT_EQ(received.Format(), sent.Format());
+  ASSERT_EQ(received.Width(), sent.Width());
+  ASSERT_EQ(received.Height(), sent.Height());
+  for (int y = 0; y < sent.Height(); ++y) {
+    EXPECT_EQ(memcmp(received.PixelData() + y * received.WidthStep(),
+                     sent.PixelData() + y * sent.WidthStep(),
+                     sent.Width() * sent.NumberOfChannels()),
+              0)
+        << "row " << y;
+  }
+  // The last packet is sent in a partial batch when the sink closes.
+  ASSERT_EQ(string_packets.size(), 3);
+  EXPECT_EQ(string_packets[0].Get<std::string>(), "first");
+  EXPECT_EQ(string_packets[1].Get<std::string>(), "second");
+  EXPECT_EQ(string_packets[2].Get<std::string>(), "third");
+  EXPECT_EQ(string_packets[2].Timestamp(), Timestamp(3));
+}
+
+}  // namespace
+}  // namespace mediapipe
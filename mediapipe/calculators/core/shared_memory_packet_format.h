@@ -0,0 +1,47 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// The layout of the packets SharedMemorySinkCalculator writes to a
+// SharedMemoryRing and SharedMemorySourceCalculator reads back.
+
+#ifndef MEDIAPIPE_CALCULATORS_CORE_SHARED_MEMORY_PACKET_FORMAT_H_
+#define MEDIAPIPE_CALCULATORS_CORE_SHARED_MEMORY_PACKET_FORMAT_H_
+
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+namespace shared_memory_packet {
+
+// The message type of each kind of packet payload.
+enum PayloadType : uint32 {
+  // The pixel data of an ImageFrame, with ImageFrameMetadata.
+  kImageFrame = 1,
+  // The bytes of a std::string, without metadata.
+  kString = 2,
+};
+
+// The metadata sent alongside ImageFrame pixel data. The pixel data is sent
+// with its row padding, so that the received frame keeps the alignment of
+// the original.
+struct ImageFrameMetadata {
+  int32 format;
+  int32 width;
+  int32 height;
+  int32 width_step;
+};
+
+}  // namespace shared_memory_packet
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_CALCULATORS_CORE_SHARED_MEMORY_PACKET_FORMAT_H_
@@ -0,0 +1,139 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+#include <memory>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "mediapipe/calculators/core/shared_memory_packet_format.h"
+#include "mediapipe/calculators/core/shared_memory_sink_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/util/shared_memory_ring.h"
+
+namespace mediapipe {
+
+// Writes packets to a shared memory segment, from which
+// SharedMemorySourceCalculators in other processes on the same machine emit
+// them at the same timestamps, without serializing them. Each packet is
+// copied into the segment once, and the receiving graphs read it in place.
+//
+// Packets are written as they arrive, so the timestamps of the packets of
+// each input stream keep increasing. If the slot of the next packet is still
+// held by a receiver, the packet waits up to max_wait_usec and is then
+// dropped. Dropped packets are counted in the "Dropped Packets" counter.
+//
+// Inputs (at least one):
+//   IMAGE: An ImageFrame.
+//   DATA: A std::string, such as a serialized proto.
+//
+// Example config:
+//   node {
+//     calculator: "SharedMemorySinkCalculator"
+//     input_stream: "IMAGE:camera_frames"
+//     options {
+//       [mediapipe.SharedMemorySinkCalculatorOptions.ext] {
+//         segment_name: "/camera_frames"
+//         max_payload_size: 6220800  # 1920x1080 SRGB
+//       }
+//     }
+//   }
+class SharedMemorySinkCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    RET_CHECK(cc->Inputs().HasTag("IMAGE") || cc->Inputs().HasTag("DATA"));
+    if (cc->Inputs().HasTag("IMAGE")) {
+      cc->Inputs().Tag("IMAGE").Set<ImageFrame>();
+    }
+    if (cc->Inputs().HasTag("DATA")) {
+      cc->Inputs().Tag("DATA").Set<std::string>();
+    }
+    // Each packet is written as soon as it arrives.
+    cc->SetInputStreamHandler("ImmediateInputStreamHandler");
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    const auto& options = cc->Options<SharedMemorySinkCalculatorOptions>();
+    RET_CHECK(!options.segment_name().empty());
+    RET_CHECK_GT(options.max_payload_size(), 0);
+    RET_CHECK_GE(options.max_wait_usec(), 0);
+    ASSIGN_OR_RETURN(
+        ring_, SharedMemoryRing::Create(options.segment_name(),
+                                        options.num_slots(),
+                                        options.max_payload_size()));
+    max_wait_ = absl::Microseconds(options.max_wait_usec());
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    if (cc->Inputs().HasTag("IMAGE") && !cc->Inputs().Tag("IMAGE").IsEmpty()) {
+      const auto& frame = cc->Inputs().Tag("IMAGE").Get<ImageFrame>();
+      shared_memory_packet::ImageFrameMetadata metadata;
+      metadata.format = frame.Format();
+      metadata.width = frame.Width();
+      metadata.height = frame.Height();
+      metadata.width_step = frame.WidthStep();
+      const size_t size = frame.WidthStep() * frame.Height();
+      MP_RETURN_IF_ERROR(WritePacket(
+          cc, shared_memory_packet::kImageFrame,
+          absl::string_view(reinterpret_cast<const char*>(&metadata),
+                            sizeof(metadata)),
+          frame.PixelData(), size));
+    }
+    if (cc->Inputs().HasTag("DATA") && !cc->Inputs().Tag("DATA").IsEmpty()) {
+      const auto& data = cc->Inputs().Tag("DATA").Get<std::string>();
+      MP_RETURN_IF_ERROR(WritePacket(
+          cc, shared_memory_packet::kString, absl::string_view(),
+          reinterpret_cast<const uint8*>(data.data()), data.size()));
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Close(CalculatorContext* cc) override {
+    // Lets the sources finish once they have read the last packet.
+    ring_.reset();
+    return ::mediapipe::OkStatus();
+  }
+
+ private:
+  ::mediapipe::Status WritePacket(CalculatorContext* cc, uint32 type,
+                                  absl::string_view metadata,
+                                  const uint8* payload, size_t size) {
+    RET_CHECK_LE(size, ring_->max_data_size())
+        << "The payload of the packet at " << cc->InputTimestamp()
+        << " exceeds max_payload_size.";
+    ASSIGN_OR_RETURN(
+        bool written,
+        ring_->Write(cc->InputTimestamp().Value(), type, metadata, size,
+                     [payload, size](uint8* data) {
+                       memcpy(data, payload, size);
+                     },
+                     max_wait_));
+    if (!written) {
+      cc->GetCounter("Dropped Packets")->Increment();
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  std::unique_ptr<SharedMemoryRing> ring_;
+  absl::Duration max_wait_;
+};
+REGISTER_CALCULATOR(SharedMemorySinkCalculator);
+
+}  // namespace mediapipe
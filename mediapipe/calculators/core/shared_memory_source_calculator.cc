@@ -0,0 +1,158 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "absl/memory/memory.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/calculators/core/shared_memory_packet_format.h"
+#include "mediapipe/calculators/core/shared_memory_source_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/tool/status_util.h"
+#include "mediapipe/util/shared_memory_ring.h"
+
+namespace mediapipe {
+
+namespace {
+
+// How often Open() checks whether the segment has been created.
+constexpr absl::Duration kOpenRetryInterval = absl::Milliseconds(10);
+
+}  // namespace
+
+// Emits the packets a SharedMemorySinkCalculator in another process writes
+// to a shared memory segment, at their original timestamps. Only packets
+// written after Open() are emitted, and the graph's input ends when the sink
+// closes.
+//
+// Output ImageFrames use the pixel data in the segment directly, and hold its
+// slot until they are destroyed, so the sink's max_wait_usec and num_slots
+// bound how long and how many of them downstream calculators may keep. The
+// pixel data is mapped read-only, and must not be modified in place. Packets
+// the reader fell too far behind to read are counted in the "Skipped
+// Packets" counter.
+//
+// Outputs (at least one, matching the inputs of the sink; packets for a
+// missing output are discarded):
+//   IMAGE: An ImageFrame.
+//   DATA: A std::string.
+//
+// Example config:
+//   node {
+//     calculator: "SharedMemorySourceCalculator"
+//     output_stream: "IMAGE:camera_frames"
+//     options {
+//       [mediapipe.SharedMemorySourceCalculatorOptions.ext] {
+//         segment_name: "/camera_frames"
+//         open_timeout_usec: 5000000
+//       }
+//     }
+//   }
+class SharedMemorySourceCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    RET_CHECK(cc->Outputs().HasTag("IMAGE") || cc->Outputs().HasTag("DATA"));
+    if (cc->Outputs().HasTag("IMAGE")) {
+      cc->Outputs().Tag("IMAGE").Set<ImageFrame>();
+    }
+    if (cc->Outputs().HasTag("DATA")) {
+      cc->Outputs().Tag("DATA").Set<std::string>();
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    const auto& options = cc->Options<SharedMemorySourceCalculatorOptions>();
+    RET_CHECK(!options.segment_name().empty());
+    poll_timeout_ = absl::Microseconds(options.poll_timeout_usec());
+    const absl::Time deadline =
+        absl::Now() + absl::Microseconds(options.open_timeout_usec());
+    auto ring = SharedMemoryRing::Open(options.segment_name());
+    while (ring.status().code() == ::mediapipe::StatusCode::kUnavailable &&
+           absl::Now() < deadline) {
+      absl::SleepFor(kOpenRetryInterval);
+      ring = SharedMemoryRing::Open(options.segment_name());
+    }
+    MP_RETURN_IF_ERROR(ring.status());
+    ring_ = std::move(ring.ValueOrDie());
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    ASSIGN_OR_RETURN(std::shared_ptr<const SharedMemoryRing::Message> message,
+                     ring_->Read(poll_timeout_));
+    const int64 skipped_count = ring_->skipped_count();
+    if (skipped_count > reported_skipped_count_) {
+      cc->GetCounter("Skipped Packets")
+          ->IncrementBy(skipped_count - reported_skipped_count_);
+      reported_skipped_count_ = skipped_count;
+    }
+    if (!message) {
+      return ring_->Finished() ? tool::StatusStop() : ::mediapipe::OkStatus();
+    }
+
+    const Timestamp timestamp = Timestamp(message->timestamp);
+    switch (message->type) {
+      case shared_memory_packet::kImageFrame:
+        if (cc->Outputs().HasTag("IMAGE")) {
+          MP_RETURN_IF_ERROR(OutputImageFrame(cc, message, timestamp));
+        }
+        break;
+      case shared_memory_packet::kString:
+        if (cc->Outputs().HasTag("DATA")) {
+          cc->Outputs().Tag("DATA").Add(
+              new std::string(reinterpret_cast<const char*>(message->data),
+                              message->data_size),
+              timestamp);
+        }
+        break;
+      default:
+        RET_CHECK_FAIL() << "Unknown payload type " << message->type;
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+ private:
+  ::mediapipe::Status OutputImageFrame(
+      CalculatorContext* cc,
+      const std::shared_ptr<const SharedMemoryRing::Message>& message,
+      Timestamp timestamp) {
+    shared_memory_packet::ImageFrameMetadata metadata;
+    RET_CHECK_EQ(message->metadata.size(), sizeof(metadata));
+    memcpy(&metadata, message->metadata.data(), sizeof(metadata));
+    RET_CHECK_EQ(message->data_size,
+                 static_cast<size_t>(metadata.width_step) * metadata.height);
+    // The frame holds the message, and so its slot, until it is destroyed.
+    auto frame = absl::make_unique<ImageFrame>(
+        static_cast<ImageFormat::Format>(metadata.format), metadata.width,
+        metadata.height, metadata.width_step,
+        const_cast<uint8*>(message->data), [message](uint8*) {});
+    cc->Outputs().Tag("IMAGE").Add(frame.release(), timestamp);
+    return ::mediapipe::OkStatus();
+  }
+
+  std::unique_ptr<SharedMemoryRing> ring_;
+  absl::Duration poll_timeout_;
+  int64 reported_skipped_count_ = 0;
+};
+REGISTER_CALCULATOR(SharedMemorySourceCalculator);
+
+}  // namespace mediapipe
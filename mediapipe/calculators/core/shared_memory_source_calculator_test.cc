@@ -0,0 +1,146 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/substitute.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+bool IsNotEmpty(std::vector<Packet>* packets) { return !packets->empty(); }
+
+// Runs a SharedMemorySinkCalculator and a SharedMemorySourceCalculator in two
+// graphs, as they would in two processes.
+TEST(SharedMemorySourceCalculatorTest, ReceivesPacketsFromSink) {
+  const std::string segment_name =
+      absl::StrCat("/mediapipe_source_calculator_test_", getpid());
+  CalculatorGraph sink_graph(ParseTextProtoOrDie<CalculatorGraphConfig>(
+      absl::Substitute(R"(
+        input_stream: "images"
+        input_stream: "strings"
+        node {
+          calculator: "SharedMemorySinkCalculator"
+          input_stream: "IMAGE:images"
+          input_stream: "DATA:strings"
+          options {
+            [mediapipe.SharedMemorySinkCalculatorOptions.ext] {
+              segment_name: "$0"
+              num_slots: 4
+              max_payload_size: 4096
+              max_wait_usec: 1000000
+            }
+          }
+        })",
+                       segment_name)));
+  CalculatorGraph source_graph(ParseTextProtoOrDie<CalculatorGraphConfig>(
+      absl::Substitute(R"(
+        node {
+          calculator: "SharedMemorySourceCalculator"
+          output_stream: "IMAGE:images"
+          output_stream: "DATA:strings"
+          options {
+            [mediapipe.SharedMemorySourceCalculatorOptions.ext] {
+              segment_name: "$0"
+              open_timeout_usec: 10000000
+              poll_timeout_usec: 10000
+            }
+          }
+        })",
+                       segment_name)));
+  absl::Mutex mutex;
+  std::vector<Packet> image_packets;
+  std::vector<Packet> string_packets;
+  MP_ASSERT_OK(source_graph.ObserveOutputStream(
+      "images", [&](const Packet& packet) {
+        absl::MutexLock lock(&mutex);
+        image_packets.push_back(packet);
+        return ::mediapipe::OkStatus();
+      }));
+  MP_ASSERT_OK(source_graph.ObserveOutputStream(
+      "strings", [&](const Packet& packet) {
+        absl::MutexLock lock(&mutex);
+        string_packets.push_back(packet);
+        return ::mediapipe::OkStatus();
+      }));
+  MP_ASSERT_OK(sink_graph.StartRun({}));
+  MP_ASSERT_OK(source_graph.StartRun({}));
+
+  // The source only emits the packets written after it opened the segment,
+  // so probe until it has.
+  int64 timestamp = 0;
+  bool source_open = false;
+  while (!source_open) {
+    MP_ASSERT_OK(sink_graph.AddPacketToInputStream(
+        "strings",
+        MakePacket<std::string>("probe").At(Timestamp(++timestamp))));
+    absl::MutexLock lock(&mutex);
+    source_open = mutex.AwaitWithTimeout(
+        absl::Condition(&IsNotEmpty, &string_packets), absl::Milliseconds(50));
+  }
+
+  // A frame with padded rows.
+  auto frame = absl::make_unique<ImageFrame>(ImageFormat::SRGB, 5, 3,
+                                             /*alignment_boundary=*/16);
+  for (int y = 0; y < frame->Height(); ++y) {
+    uint8* row = frame->MutablePixelData() + y * frame->WidthStep();
+    for (int x = 0; x < frame->Width() * frame->NumberOfChannels(); ++x) {
+      row[x] = y * 16 + x;
+    }
+  }
+  const Packet frame_packet = Adopt(frame.release()).At(Timestamp(++timestamp));
+  MP_ASSERT_OK(sink_graph.AddPacketToInputStream("images", frame_packet));
+  MP_ASSERT_OK(sink_graph.AddPacketToInputStream(
+      "strings", MakePacket<std::string>("payload").At(Timestamp(timestamp))));
+  MP_ASSERT_OK(sink_graph.CloseAllInputStreams());
+  MP_ASSERT_OK(sink_graph.WaitUntilDone());
+  // The source stops once the sink has closed the segment.
+  MP_ASSERT_OK(source_graph.WaitUntilDone());
+
+  ASSERT_EQ(image_packets.size(), 1);
+  EXPECT_EQ(image_packets[0].Timestamp(), Timestamp(timestamp));
+  const auto& sent = frame_packet.Get<ImageFrame>();
+  const auto& received = image_packets[0].Get<ImageFrame>();
+  ASSERT_EQ(received.Format(), sent.Format());
+  ASSERT_EQ(received.Width(), sent.Width());
+  ASSERT_EQ(received.Height(), sent.Height());
+  ASSERT_EQ(received.WidthStep(), sent.WidthStep());
+  EXPECT_NE(received.PixelData(), sent.PixelData());
+  for (int y = 0; y < sent.Height(); ++y) {
+    EXPECT_EQ(memcmp(received.PixelData() + y * received.WidthStep(),
+                     sent.PixelData() + y * sent.WidthStep(),
+                     sent.Width() * sent.NumberOfChannels()),
+              0)
+        << "row " << y;
+  }
+  ASSERT_FALSE(string_packets.empty());
+  EXPECT_EQ(string_packets.back().Get<std::string>(), "payload");
+  EXPECT_EQ(string_packets.back().Timestamp(), Timestamp(timestamp));
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -15,6 +15,8 @@
 #ifndef MEDIAPIPE_CALCULATORS_CORE_SPLIT_VECTOR_CALCULATOR_H_
 #define MEDIAPIPE_CALCULATORS_CORE_SPLIT_VECTOR_CALCULATOR_H_
 
+#include <algorithm>
+#include <iterator>
 #include <vector>
 
 #include "mediapipe/calculators/core/split_vector_calculator.pb.h"
@@ -37,6 +39,8 @@ namespace mediapipe {
 // be of type std::vector<T>.
 // To use this class for a particular type T, register a calculator using
 // SplitVectorCalculator<T>.
+// If the ranges do not overlap and the input vector is not shared with other
+// readers, the input is consumed and its elements are moved rather than copied.
 template <typename T>
 class SplitVectorCalculator : public CalculatorBase {
  public:
@@ -88,12 +92,30 @@ class SplitVectorCalculator : public CalculatorBase {
       max_range_end_ = std::max(max_range_end_, range.end());
     }
 
+    // Elements can only be moved to a single output.
+    std::vector<std::pair<int32, int32>> sorted_ranges = ranges_;
+    std::sort(sorted_ranges.begin(), sorted_ranges.end());
+    ranges_overlap_ = false;
+    for (int i = 1; i < sorted_ranges.size(); ++i) {
+      if (sorted_ranges[i].first < sorted_ranges[i - 1].second) {
+        ranges_overlap_ = true;
+      }
+    }
+
     element_only_ = options.element_only();
 
     return ::mediapipe::OkStatus();
   }
 
   ::mediapipe::Status Process(CalculatorContext* cc) override {
+    if (!ranges_overlap_) {
+      auto consumed =
+          cc->Inputs().Index(0).Value().template Consume<std::vector<T>>();
+      if (consumed.ok()) {
+        return ProcessConsumed(cc, consumed.ConsumeValueOrDie().get());
+      }
+    }
+
     const auto& input = cc->Inputs().Index(0).Get<std::vector<T>>();
     RET_CHECK_GE(input.size(), max_range_end_);
 
@@ -115,9 +137,34 @@ class SplitVectorCalculator : public CalculatorBase {
   }
 
  private:
+  // Same as Process, but moves the elements out of an input that has been
+  // consumed.
+  ::mediapipe::Status ProcessConsumed(CalculatorContext* cc,
+                                      std::vector<T>* input) {
+    RET_CHECK_GE(input->size(), max_range_end_);
+
+    if (element_only_) {
+      for (int i = 0; i < ranges_.size(); ++i) {
+        cc->Outputs().Index(i).AddPacket(
+            MakePacket<T>(std::move((*input)[ranges_[i].first]))
+                .At(cc->InputTimestamp()));
+      }
+    } else {
+      for (int i = 0; i < ranges_.size(); ++i) {
+        auto output = absl::make_unique<std::vector<T>>(
+            std::make_move_iterator(input->begin() + ranges_[i].first),
+            std::make_move_iterator(input->begin() + ranges_[i].second));
+        cc->Outputs().Index(i).Add(output.release(), cc->InputTimestamp());
+      }
+    }
+
+    return ::mediapipe::OkStatus();
+  }
+
   std::vector<std::pair<int32, int32>> ranges_;
   int32 max_range_end_ = -1;
   bool element_only_ = false;
+  bool ranges_overlap_ = false;
 };
 
 }  // namespace mediapipe
@@ -67,6 +67,9 @@ enum { ATTRIB_VERTEX, ATTRIB_TEXTURE_POSITION, NUM_ATTRIBUTES };
 //   sigma_space: Pixel radius: use (sigma_space*2+1)x(sigma_space*2+1) window.
 //                This should be set based on output image pixel space.
 //   sigma_color: Color variance: normalized [0-1] color difference allowed.
+//   algorithm: FULL_KERNEL (default) or SEPARABLE. On GPU, SEPARABLE runs a
+//              horizontal and a vertical 1D pass instead of the full 2D
+//              window, which keeps large radii affordable.
 //
 // Notes:
 //   * When GUIDE is present, the output image is same size as GUIDE image;
@@ -94,6 +97,7 @@ class BilateralFilterCalculator : public CalculatorBase {
 
   ::mediapipe::Status GlSetup(CalculatorContext* cc);
   void GlRender(CalculatorContext* cc);
+  ::mediapipe::Status GlSetupSeparable();
 
   mediapipe::BilateralFilterCalculatorOptions options_;
   float sigma_color_ = -1.f;
@@ -105,6 +109,9 @@ class BilateralFilterCalculator : public CalculatorBase {
   mediapipe::GlCalculatorHelper gpu_helper_;
   GLuint program_ = 0;
   GLuint program_joint_ = 0;
+  // 1D programs for the SEPARABLE algorithm, run once per direction.
+  GLuint program_separable_ = 0;
+  GLuint program_joint_separable_ = 0;
 #endif  // __ANDROID__ || __EMSCRIPTEN__
 };
 REGISTER_CALCULATOR(BilateralFilterCalculator);
@@ -215,6 +222,10 @@ REGISTER_CALCULATOR(BilateralFilterCalculator);
     program_ = 0;
     if (program_joint_) glDeleteProgram(program_joint_);
     program_joint_ = 0;
+    if (program_separable_) glDeleteProgram(program_separable_);
+    program_separable_ = 0;
+    if (program_joint_separable_) glDeleteProgram(program_joint_separable_);
+    program_joint_separable_ = 0;
   });
 #endif  // __ANDROID__ || __EMSCRIPTEN__
 
@@ -273,7 +284,50 @@ REGISTER_CALCULATOR(BilateralFilterCalculator);
                                !cc->Inputs().Tag(kInputGuideTagGpu).IsEmpty();
 
   // Setup textures and Update image in GPU shader.
-  if (has_guide_image) {
+  if (options_.algorithm() ==
+      mediapipe::BilateralFilterCalculatorOptions::SEPARABLE) {
+    // Horizontal pass into an intermediate texture, then vertical pass into
+    // the output. Both run at the output (guide) resolution.
+    const GLuint program =
+        has_guide_image ? program_joint_separable_ : program_separable_;
+    mediapipe::GlTexture guide_texture;
+    int width = input_frame.width();
+    int height = input_frame.height();
+    if (has_guide_image) {
+      const auto& guide_image =
+          cc->Inputs().Tag(kInputGuideTagGpu).Get<mediapipe::GpuBuffer>();
+      guide_texture = gpu_helper_.CreateSourceTexture(guide_image);
+      width = guide_image.width();
+      height = guide_image.height();
+      glActiveTexture(GL_TEXTURE2);
+      glBindTexture(GL_TEXTURE_2D, guide_texture.name());
+    }
+    glUseProgram(program);
+    const GLint texel_step = glGetUniformLocation(program, "texel_step");
+
+    auto horizontal_texture = gpu_helper_.CreateDestinationTexture(
+        width, height, mediapipe::GpuBufferFormat::kBGRA32);
+    gpu_helper_.BindFramebuffer(horizontal_texture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, input_texture.name());
+    glUniform2f(texel_step, 1.0 / width, 0.0);
+    GlRender(cc);
+
+    output_texture = gpu_helper_.CreateDestinationTexture(
+        width, height, mediapipe::GpuBufferFormat::kBGRA32);
+    gpu_helper_.BindFramebuffer(output_texture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, horizontal_texture.name());
+    glUniform2f(texel_step, 0.0, 1.0 / height);
+    GlRender(cc);
+
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    horizontal_texture.Release();
+    if (has_guide_image) guide_texture.Release();
+  } else if (has_guide_image) {
     // joint bilateral filter
     glUseProgram(program_joint_);
     const auto& guide_image =
@@ -545,6 +599,111 @@ void BilateralFilterCalculator::GlRender(CalculatorContext* cc) {
   glUniform1i(glGetUniformLocation(program_joint_, "input_frame"), 1);
   glUniform1i(glGetUniformLocation(program_joint_, "guide_frame"), 2);
 
+  if (options_.algorithm() ==
+      mediapipe::BilateralFilterCalculatorOptions::SEPARABLE) {
+    MP_RETURN_IF_ERROR(GlSetupSeparable());
+  }
+#endif  // __ANDROID__ || __EMSCRIPTEN__
+
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status BilateralFilterCalculator::GlSetupSeparable() {
+#if defined(__ANDROID__) || defined(__EMSCRIPTEN__)
+  const GLint attr_location[NUM_ATTRIBUTES] = {
+      ATTRIB_VERTEX,
+      ATTRIB_TEXTURE_POSITION,
+  };
+  const GLchar* attr_name[NUM_ATTRIBUTES] = {
+      "position",
+      "texture_coordinate",
+  };
+
+  std::string sigma_options_string =
+      "const float sigma_space = " + std::to_string(sigma_space_) +
+      "; const float sigma_color = " + std::to_string(sigma_color_) + ";\n";
+
+  // 1D bilateral filter along texel_step, so a horizontal and a vertical pass
+  // approximate the 2D window. The spatial weight uses the same scale as the
+  // 2D shaders. With JOINT defined, color weights come from the guide image.
+  const std::string frag_body = R"(
+  #if __VERSION__ < 130
+    #define in varying
+  #endif  // __VERSION__ < 130
+
+  #ifdef GL_ES
+    #define fragColor gl_FragColor
+    precision highp float;
+  #else
+    #define lowp
+    #define mediump
+    #define highp
+    #define texture2D texture
+    out vec4 fragColor;
+  #endif  // defined(GL_ES)
+
+    in vec2 sample_coordinate;
+    uniform sampler2D input_frame;
+  #ifdef JOINT
+    uniform sampler2D guide_frame;
+  #else
+    #define guide_frame input_frame
+  #endif  // JOINT
+)" + sigma_options_string + R"(
+    uniform vec2 texel_step;  // One texel along the filtering direction.
+
+    const float kSparsityFactor = 0.66;  // Higher is more sparse.
+    const float sparsity = max(1.0, sqrt(sigma_space) * kSparsityFactor);
+    const float step = sparsity;
+    const float radius = sigma_space;
+    const float offset = (step > 1.0) ? (step * 0.5) : (0.0);
+
+    float gaussian(float x, float sigma) {
+      float coeff = -0.5 / (sigma * sigma * 4.0 + 1.0e-6);
+      return exp((x * x) * coeff);
+    }
+
+    void main() {
+      vec2 center_uv = sample_coordinate;
+      vec3 center_val = texture2D(guide_frame, center_uv).rgb;
+      vec3 new_val = vec3(0.0);
+      float total_weight = 0.0;
+
+      for (float i = -radius+offset; i <= radius; i+=step) {
+        vec2 uv = center_uv + i * texel_step;
+        vec3 guide_val = texture2D(guide_frame, uv).rgb;
+        vec3 out_val = texture2D(input_frame, uv).rgb;
+
+        float weight = gaussian(i, sigma_space) *
+                       gaussian(distance(center_val, guide_val), sigma_color);
+        total_weight += weight;
+        new_val += vec3(weight) * out_val;
+      }
+      new_val /= vec3(total_weight);
+
+      fragColor = vec4(new_val, 1.0);
+    }
+  )";
+
+  const std::string frag_src = GLES_VERSION_COMPAT + frag_body;
+  mediapipe::GlhCreateProgram(mediapipe::kBasicVertexShader, frag_src.c_str(),
+                              NUM_ATTRIBUTES, (const GLchar**)&attr_name[0],
+                              attr_location, &program_separable_);
+  RET_CHECK(program_separable_) << "Problem initializing the program.";
+  glUseProgram(program_separable_);
+  glUniform1i(glGetUniformLocation(program_separable_, "input_frame"), 1);
+
+  const std::string joint_frag_src =
+      std::string(GLES_VERSION_COMPAT) + "#define JOINT\n" + frag_body;
+  mediapipe::GlhCreateProgram(
+      mediapipe::kBasicVertexShader, joint_frag_src.c_str(), NUM_ATTRIBUTES,
+      (const GLchar**)&attr_name[0], attr_location, &program_joint_separable_);
+  RET_CHECK(program_joint_separable_) << "Problem initializing the program.";
+  glUseProgram(program_joint_separable_);
+  glUniform1i(glGetUniformLocation(program_joint_separable_, "input_frame"),
+              1);
+  glUniform1i(glGetUniformLocation(program_joint_separable_, "guide_frame"),
+              2);
 #endif  // __ANDROID__ || __EMSCRIPTEN__
 
   return ::mediapipe::OkStatus();
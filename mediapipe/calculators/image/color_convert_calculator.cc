@@ -12,34 +12,78 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "libyuv/convert_argb.h"
+#include "libyuv/convert_from_argb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
-#include "mediapipe/framework/port/integral_types.h"
-#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/formats/image_frame_pool.h"
 #include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/source_location.h"
 #include "mediapipe/framework/port/status_builder.h"
+#include "mediapipe/util/simd_image_util.h"
 
 namespace mediapipe {
 namespace {
-void SetColorChannel(int channel, uint8 value, cv::Mat* mat) {
-  CHECK(mat->depth() == CV_8U);
-  CHECK(channel < mat->channels());
-  const int step = mat->channels();
-  for (int r = 0; r < mat->rows; ++r) {
-    uint8* row_ptr = mat->ptr<uint8>(r);
-    for (int offset = channel; offset < mat->cols * step; offset += step) {
-      row_ptr[offset] = value;
-    }
+// Converts "input" into "output", which has the same dimensions, in a single
+// pass over the pixels. libyuv picks SIMD row kernels (SSSE3, AVX2 or NEON)
+// for the running CPU. Note that libyuv names formats by their little endian
+// word layout: its "ARGB" is B, G, R, A in memory, "RGB24" is B, G, R and
+// "RAW" is R, G, B.
+void ConvertColor(const cv::Mat& input, int open_cv_convert_code,
+                  cv::Mat* output) {
+#if defined(__wasm_simd128__)
+  // libyuv has no WebAssembly SIMD row kernels.
+  switch (open_cv_convert_code) {
+    case cv::COLOR_RGB2RGBA:
+    case cv::COLOR_RGB2BGRA:
+      simd_image_util::ThreeToFourChannels(
+          input, open_cv_convert_code == cv::COLOR_RGB2BGRA, output);
+      return;
+    case cv::COLOR_RGBA2RGB:
+    case cv::COLOR_BGRA2RGB:
+      simd_image_util::FourToThreeChannels(
+          input, open_cv_convert_code == cv::COLOR_BGRA2RGB, output);
+      return;
+    default:
+      break;
+  }
+#endif  // __wasm_simd128__
+  const int input_step = static_cast<int>(input.step);
+  const int output_step = static_cast<int>(output->step);
+  switch (open_cv_convert_code) {
+    case cv::COLOR_RGB2RGBA:
+      // Keeps the byte order and sets alpha to 255, unlike cv::cvtColor,
+      // which may leave alpha set to 0.
+      libyuv::RGB24ToARGB(input.data, input_step, output->data, output_step,
+                          input.cols, input.rows);
+      return;
+    case cv::COLOR_RGBA2RGB:
+      libyuv::ARGBToRGB24(input.data, input_step, output->data, output_step,
+                          input.cols, input.rows);
+      return;
+    case cv::COLOR_RGB2BGRA:
+      libyuv::RAWToARGB(input.data, input_step, output->data, output_step,
+                        input.cols, input.rows);
+      return;
+    case cv::COLOR_BGRA2RGB:
+      libyuv::ARGBToRAW(input.data, input_step, output->data, output_step,
+                        input.cols, input.rows);
+      return;
+    default:
+      // The gray conversions are single pass SIMD kernels in OpenCV.
+      cv::cvtColor(input, *output, open_cv_convert_code);
+      return;
   }
 }
 
 constexpr char kRgbaInTag[] = "RGBA_IN";
+constexpr char kBgraInTag[] = "BGRA_IN";
 constexpr char kRgbInTag[] = "RGB_IN";
 constexpr char kGrayInTag[] = "GRAY_IN";
 constexpr char kRgbaOutTag[] = "RGBA_OUT";
+constexpr char kBgraOutTag[] = "BGRA_OUT";
 constexpr char kRgbOutTag[] = "RGB_OUT";
 constexpr char kGrayOutTag[] = "GRAY_OUT";
 }  // namespace
@@ -53,6 +97,12 @@ constexpr char kGrayOutTag[] = "GRAY_OUT";
 //   GRAY -> RGB
 //   RGB  -> GRAY
 //   RGB  -> RGBA
+//   BGRA -> RGB
+//   RGB  -> BGRA
+//
+// The conversions between RGB and RGBA or BGRA make a single pass over the
+// pixels using SIMD kernels. ColorConvertGpuCalculator does the same
+// conversions on GpuBuffers.
 //
 // This calculator only supports a single input stream and output stream at a
 // time. If more than one input stream or output stream is present, the
@@ -62,11 +112,16 @@ constexpr char kGrayOutTag[] = "GRAY_OUT";
 //
 // Input streams:
 //   RGBA_IN:       The input video stream (ImageFrame, SRGBA).
+//   BGRA_IN:       The input video stream (ImageFrame, SRGBA with the bytes
+//                  of each pixel in B, G, R, A order, as some cameras and
+//                  platform image buffers provide them).
 //   RGB_IN:        The input video stream (ImageFrame, SRGB).
 //   GRAY_IN:       The input video stream (ImageFrame, GRAY8).
 //
 // Output streams:
 //   RGBA_OUT:      The output video stream (ImageFrame, SRGBA).
+//   BGRA_OUT:      The output video stream (ImageFrame, SRGBA with the bytes
+//                  of each pixel in B, G, R, A order).
 //   RGB_OUT:       The output video stream (ImageFrame, SRGB).
 //   GRAY_OUT:      The output video stream (ImageFrame, GRAY8).
 class ColorConvertCalculator : public CalculatorBase {
@@ -100,6 +155,10 @@ REGISTER_CALCULATOR(ColorConvertCalculator);
     cc->Inputs().Tag(kRgbaInTag).Set<ImageFrame>();
   }
 
+  if (cc->Inputs().HasTag(kBgraInTag)) {
+    cc->Inputs().Tag(kBgraInTag).Set<ImageFrame>();
+  }
+
   if (cc->Inputs().HasTag(kGrayInTag)) {
     cc->Inputs().Tag(kGrayInTag).Set<ImageFrame>();
   }
@@ -120,6 +179,11 @@ REGISTER_CALCULATOR(ColorConvertCalculator);
     cc->Outputs().Tag(kRgbaOutTag).Set<ImageFrame>();
   }
 
+  if (cc->Outputs().HasTag(kBgraOutTag)) {
+    cc->Outputs().Tag(kBgraOutTag).Set<ImageFrame>();
+  }
+
+  cc->UseService(kImageFramePoolService).Optional();
   return ::mediapipe::OkStatus();
 }
 
@@ -129,16 +193,12 @@ REGISTER_CALCULATOR(ColorConvertCalculator);
     CalculatorContext* cc) {
   const cv::Mat& input_mat =
       formats::MatView(&cc->Inputs().Tag(input_tag).Get<ImageFrame>());
-  std::unique_ptr<ImageFrame> output_frame(
-      new ImageFrame(output_format, input_mat.cols, input_mat.rows));
+  auto pool = cc->Service(kImageFramePoolService);
+  std::unique_ptr<ImageFrame> output_frame = ImageFramePool::AllocateFrame(
+      pool.IsAvailable() ? &pool.GetObject() : nullptr, output_format,
+      input_mat.cols, input_mat.rows);
   cv::Mat output_mat = formats::MatView(output_frame.get());
-  cv::cvtColor(input_mat, output_mat, open_cv_convert_code);
-
-  // cv::cvtColor will leave the alpha channel set to 0, which is a bizarre
-  // design choice. Instead, let's set alpha to 255.
-  if (open_cv_convert_code == cv::COLOR_RGB2RGBA) {
-    SetColorChannel(3, 255, &output_mat);
-  }
+  ConvertColor(input_mat, open_cv_convert_code, &output_mat);
   cc->Outputs()
       .Tag(output_tag)
       .Add(output_frame.release(), cc->InputTimestamp());
@@ -166,6 +226,16 @@ REGISTER_CALCULATOR(ColorConvertCalculator);
     return ConvertAndOutput(kRgbInTag, kRgbaOutTag, ImageFormat::SRGBA,
                             cv::COLOR_RGB2RGBA, cc);
   }
+  // BGRA -> RGB
+  if (cc->Inputs().HasTag(kBgraInTag) && cc->Outputs().HasTag(kRgbOutTag)) {
+    return ConvertAndOutput(kBgraInTag, kRgbOutTag, ImageFormat::SRGB,
+                            cv::COLOR_BGRA2RGB, cc);
+  }
+  // RGB -> BGRA
+  if (cc->Inputs().HasTag(kRgbInTag) && cc->Outputs().HasTag(kBgraOutTag)) {
+    return ConvertAndOutput(kRgbInTag, kBgraOutTag, ImageFormat::SRGBA,
+                            cv::COLOR_RGB2BGRA, cc);
+  }
 
   return ::mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
          << "Unsupported image format conversion.";
@@ -0,0 +1,151 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/substitute.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+
+namespace {
+
+// An odd width exercises the scalar tails of the SIMD row kernels.
+constexpr int kWidth = 37;
+constexpr int kHeight = 5;
+
+// Returns a frame whose channel c of pixel (x, y) is 10 * c + x + y.
+Packet TestFrame(ImageFormat::Format format) {
+  auto frame = absl::make_unique<ImageFrame>(format, kWidth, kHeight);
+  cv::Mat mat = formats::MatView(frame.get());
+  for (int y = 0; y < kHeight; ++y) {
+    uint8* row = mat.ptr<uint8>(y);
+    for (int x = 0; x < kWidth; ++x) {
+      for (int c = 0; c < mat.channels(); ++c) {
+        row[x * mat.channels() + c] = 10 * c + x + y;
+      }
+    }
+  }
+  return Adopt(frame.release()).At(Timestamp(0));
+}
+
+// Runs a ColorConvertCalculator from "input_tag" to "output_tag" on "input"
+// and returns the output packet.
+Packet Convert(const std::string& input_tag, const std::string& output_tag,
+               const Packet& input) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(
+      absl::Substitute(R"(
+        calculator: "ColorConvertCalculator"
+        input_stream: "$0:input"
+        output_stream: "$1:output"
+      )",
+                       input_tag, output_tag)));
+  runner.MutableInputs()->Tag(input_tag).packets.push_back(input);
+  MP_EXPECT_OK(runner.Run());
+  const std::vector<Packet>& packets = runner.Outputs().Tag(output_tag).packets;
+  EXPECT_EQ(1, packets.size());
+  return packets.empty() ? Packet() : packets[0];
+}
+
+// Expects channel "channel" of "frame" to equal channel "source_channel" of
+// "source", or "value" if "source_channel" is -1.
+void ExpectChannel(const ImageFrame& frame, int channel,
+                   const ImageFrame& source, int source_channel,
+                   int value = 0) {
+  const cv::Mat mat = formats::MatView(&frame);
+  const cv::Mat source_mat = formats::MatView(&source);
+  for (int y = 0; y < kHeight; ++y) {
+    for (int x = 0; x < kWidth; ++x) {
+      const int expected =
+          source_channel < 0
+              ? value
+              : source_mat.ptr<uint8>(
+                    y)[x * source_mat.channels() + source_channel];
+      ASSERT_EQ(expected, mat.ptr<uint8>(y)[x * mat.channels() + channel])
+          << "at " << x << ", " << y << ", channel " << channel;
+    }
+  }
+}
+
+TEST(ColorConvertCalculatorTest, RgbToRgbaSetsOpaqueAlpha) {
+  Packet input = TestFrame(ImageFormat::SRGB);
+  Packet result = Convert("RGB_IN", "RGBA_OUT", input);
+  const ImageFrame& output = result.Get<ImageFrame>();
+  ASSERT_EQ(ImageFormat::SRGBA, output.Format());
+  const ImageFrame& rgb = input.Get<ImageFrame>();
+  ExpectChannel(output, 0, rgb, 0);
+  ExpectChannel(output, 1, rgb, 1);
+  ExpectChannel(output, 2, rgb, 2);
+  ExpectChannel(output, 3, rgb, -1, 255);
+}
+
+TEST(ColorConvertCalculatorTest, RgbaToRgb) {
+  Packet input = TestFrame(ImageFormat::SRGBA);
+  Packet result = Convert("RGBA_IN", "RGB_OUT", input);
+  const ImageFrame& output = result.Get<ImageFrame>();
+  ASSERT_EQ(ImageFormat::SRGB, output.Format());
+  const ImageFrame& rgba = input.Get<ImageFrame>();
+  ExpectChannel(output, 0, rgba, 0);
+  ExpectChannel(output, 1, rgba, 1);
+  ExpectChannel(output, 2, rgba, 2);
+}
+
+TEST(ColorConvertCalculatorTest, BgraToRgb) {
+  Packet input = TestFrame(ImageFormat::SRGBA);
+  Packet result = Convert("BGRA_IN", "RGB_OUT", input);
+  const ImageFrame& output = result.Get<ImageFrame>();
+  ASSERT_EQ(ImageFormat::SRGB, output.Format());
+  const ImageFrame& bgra = input.Get<ImageFrame>();
+  ExpectChannel(output, 0, bgra, 2);
+  ExpectChannel(output, 1, bgra, 1);
+  ExpectChannel(output, 2, bgra, 0);
+}
+
+TEST(ColorConvertCalculatorTest, RgbToBgra) {
+  Packet input = TestFrame(ImageFormat::SRGB);
+  Packet result = Convert("RGB_IN", "BGRA_OUT", input);
+  const ImageFrame& output = result.Get<ImageFrame>();
+  ASSERT_EQ(ImageFormat::SRGBA, output.Format());
+  const ImageFrame& rgb = input.Get<ImageFrame>();
+  ExpectChannel(output, 0, rgb, 2);
+  ExpectChannel(output, 1, rgb, 1);
+  ExpectChannel(output, 2, rgb, 0);
+  ExpectChannel(output, 3, rgb, -1, 255);
+}
+
+TEST(ColorConvertCalculatorTest, RgbToGrayMatchesOpenCv) {
+  Packet input = TestFrame(ImageFormat::SRGB);
+  Packet result = Convert("RGB_IN", "GRAY_OUT", input);
+  const ImageFrame& output = result.Get<ImageFrame>();
+  ASSERT_EQ(ImageFormat::GRAY8, output.Format());
+  cv::Mat expected;
+  cv::cvtColor(formats::MatView(&input.Get<ImageFrame>()), expected,
+               cv::COLOR_RGB2GRAY);
+  EXPECT_EQ(0, cv::norm(expected, formats::MatView(&output), cv::NORM_INF));
+}
+
+}  // namespace
+
+}  // namespace mediapipe
@@ -0,0 +1,199 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/calculators/image/color_convert_gpu_calculator.pb.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/gpu/gl_simple_calculator.h"
+#include "mediapipe/gpu/gl_simple_shaders.h"
+#include "mediapipe/gpu/shader_util.h"
+
+enum { ATTRIB_VERTEX, ATTRIB_TEXTURE_POSITION, NUM_ATTRIBUTES };
+
+namespace mediapipe {
+
+namespace {
+
+// Returns the GLSL statements that set fragColor from the input "color".
+const char* ConversionBody(ColorConvertGpuCalculatorOptions::Conversion c) {
+  switch (c) {
+    case ColorConvertGpuCalculatorOptions::SWAP_RED_BLUE:
+      return "fragColor = color.bgra;";
+    case ColorConvertGpuCalculatorOptions::RGB_TO_GRAY:
+      // The weights of cv::COLOR_RGB2GRAY, so that both paths agree.
+      return "fragColor = vec4(dot(color.rgb, vec3(0.299, 0.587, 0.114)));";
+    case ColorConvertGpuCalculatorOptions::GRAY_TO_RGB:
+      return "fragColor = vec4(color.rrr, 1.0);";
+    case ColorConvertGpuCalculatorOptions::RGBA_TO_RGB:
+    default:
+      return "fragColor = vec4(color.rgb, 1.0);";
+  }
+}
+
+}  // namespace
+
+// The GPU counterpart of ColorConvertCalculator, so that graphs which keep
+// frames on the GPU need not copy them to the CPU to convert them. The
+// conversion is done by a single fragment shader pass.
+// See GlSimpleCalculator for inputs, outputs and input side packets.
+//
+// Example config:
+//   node {
+//     calculator: "ColorConvertGpuCalculator"
+//     input_stream: "input_video"
+//     output_stream: "gray_video"
+//     options {
+//       [mediapipe.ColorConvertGpuCalculatorOptions.ext] {
+//         conversion: RGB_TO_GRAY
+//       }
+//     }
+//   }
+class ColorConvertGpuCalculator : public GlSimpleCalculator {
+ public:
+  ::mediapipe::Status Open(CalculatorContext* cc) override;
+  ::mediapipe::Status GlSetup() override;
+  ::mediapipe::Status GlRender(const GlTexture& src,
+                               const GlTexture& dst) override;
+  ::mediapipe::Status GlTeardown() override;
+  GpuBufferFormat GetOutputFormat() override;
+
+ private:
+  ColorConvertGpuCalculatorOptions options_;
+  GLuint program_ = 0;
+  GLint frame_;
+};
+REGISTER_CALCULATOR(ColorConvertGpuCalculator);
+
+::mediapipe::Status ColorConvertGpuCalculator::Open(CalculatorContext* cc) {
+  options_ = cc->Options<ColorConvertGpuCalculatorOptions>();
+  return GlSimpleCalculator::Open(cc);
+}
+
+GpuBufferFormat ColorConvertGpuCalculator::GetOutputFormat() {
+  return options_.conversion() == ColorConvertGpuCalculatorOptions::RGB_TO_GRAY
+             ? GpuBufferFormat::kOneComponent8
+             : GpuBufferFormat::kBGRA32;
+}
+
+::mediapipe::Status ColorConvertGpuCalculator::GlSetup() {
+  // Load vertex and fragment shaders
+  const GLint attr_location[NUM_ATTRIBUTES] = {
+      ATTRIB_VERTEX,
+      ATTRIB_TEXTURE_POSITION,
+  };
+  const GLchar* attr_name[NUM_ATTRIBUTES] = {
+      "position",
+      "texture_coordinate",
+  };
+
+  const char* frag_header = GLES_VERSION_COMPAT R"(
+#if __VERSION__ < 130
+  #define in varying
+#endif  // __VERSION__ < 130
+
+#ifdef GL_ES
+  #define fragColor gl_FragColor
+  precision highp float;
+#else
+  #define lowp
+  #define mediump
+  #define highp
+  #define texture2D texture
+  out vec4 fragColor;
+#endif  // defined(GL_ES)
+
+  in vec2 sample_coordinate;
+  uniform sampler2D video_frame;
+
+  void main() {
+    vec4 color = texture2D(video_frame, sample_coordinate);
+  )";
+  const std::string frag_src = absl::StrCat(
+      frag_header, ConversionBody(options_.conversion()), "\n}\n");
+
+  // shader program
+  GlhCreateCachedProgram(kBasicVertexShader, frag_src.c_str(), NUM_ATTRIBUTES,
+                         (const GLchar**)&attr_name[0], attr_location,
+                         &program_);
+  RET_CHECK(program_) << "Problem initializing the program.";
+  frame_ = glGetUniformLocation(program_, "video_frame");
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status ColorConvertGpuCalculator::GlRender(const GlTexture& src,
+                                                        const GlTexture& dst) {
+  static const GLfloat square_vertices[] = {
+      -1.0f, -1.0f,  // bottom left
+      1.0f,  -1.0f,  // bottom right
+      -1.0f, 1.0f,   // top left
+      1.0f,  1.0f,   // top right
+  };
+  static const GLfloat texture_vertices[] = {
+      0.0f, 0.0f,  // bottom left
+      1.0f, 0.0f,  // bottom right
+      0.0f, 1.0f,  // top left
+      1.0f, 1.0f,  // top right
+  };
+
+  // program
+  glUseProgram(program_);
+  glUniform1i(frame_, 1);
+
+  // vertex storage
+  GLuint vbo[2];
+  glGenBuffers(2, vbo);
+  GLuint vao;
+  glGenVertexArrays(1, &vao);
+  glBindVertexArray(vao);
+
+  // vbo 0
+  glBindBuffer(GL_ARRAY_BUFFER, vbo[0]);
+  glBufferData(GL_ARRAY_BUFFER, 4 * 2 * sizeof(GLfloat), square_vertices,
+               GL_STATIC_DRAW);
+  glEnableVertexAttribArray(ATTRIB_VERTEX);
+  glVertexAttribPointer(ATTRIB_VERTEX, 2, GL_FLOAT, 0, 0, nullptr);
+
+  // vbo 1
+  glBindBuffer(GL_ARRAY_BUFFER, vbo[1]);
+  glBufferData(GL_ARRAY_BUFFER, 4 * 2 * sizeof(GLfloat), texture_vertices,
+               GL_STATIC_DRAW);
+  glEnableVertexAttribArray(ATTRIB_TEXTURE_POSITION);
+  glVertexAttribPointer(ATTRIB_TEXTURE_POSITION, 2, GL_FLOAT, 0, 0, nullptr);
+
+  // draw
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+  // cleanup
+  glDisableVertexAttribArray(ATTRIB_VERTEX);
+  glDisableVertexAttribArray(ATTRIB_TEXTURE_POSITION);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+  glDeleteVertexArrays(1, &vao);
+  glDeleteBuffers(2, vbo);
+
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status ColorConvertGpuCalculator::GlTeardown() {
+  if (program_) {
+    GlhReleaseCachedProgram(program_);
+    program_ = 0;
+  }
+  return ::mediapipe::OkStatus();
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,77 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/substitute.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/util/calculator_benchmark.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kNumFrames = 30;
+constexpr int64 kFramePeriodUsec = 33333;
+
+// Returns a generator of camera sized frames in "format".
+std::function<Packet(int)> FrameGenerator(ImageFormat::Format format) {
+  return [format](int i) {
+    auto frame = absl::make_unique<ImageFrame>(format, 1280, 720);
+    frame->SetToZero();
+    return Adopt(frame.release());
+  };
+}
+
+// Resizes camera frames to a typical model input size. The argument is
+// whether single_pass_cpu is set.
+void BM_ImageTransformationResize(benchmark::State& state) {
+  CalculatorBenchmark benchmark(absl::Substitute(
+      R"(
+      calculator: "ImageTransformationCalculator"
+      input_stream: "IMAGE:input"
+      output_stream: "IMAGE:output"
+      options {
+        [mediapipe.ImageTransformationCalculatorOptions.ext] {
+          output_width: 256
+          output_height: 256
+          scale_mode: FIT
+          single_pass_cpu: $0
+        }
+      })",
+      state.range(0) != 0));
+  benchmark.GenerateInputs("IMAGE", 0, kNumFrames, kFramePeriodUsec,
+                           FrameGenerator(ImageFormat::SRGB));
+  benchmark.Run(state);
+}
+BENCHMARK(BM_ImageTransformationResize)->Arg(0)->Arg(1);
+
+void BM_ColorConvertRgbaToRgb(benchmark::State& state) {
+  CalculatorBenchmark benchmark(R"(
+      calculator: "ColorConvertCalculator"
+      input_stream: "RGBA_IN:input"
+      output_stream: "RGB_OUT:output")");
+  benchmark.GenerateInputs("RGBA_IN", 0, kNumFrames, kFramePeriodUsec,
+                           FrameGenerator(ImageFormat::SRGBA));
+  benchmark.Run(state);
+}
+BENCHMARK(BM_ColorConvertRgbaToRgb);
+
+}  // namespace
+}  // namespace mediapipe
@@ -12,17 +12,25 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <cmath>
+#include <string>
+#include <vector>
 
+#include "absl/memory/memory.h"
 #include "mediapipe/calculators/image/image_cropping_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/formats/image_frame_pool.h"
 #include "mediapipe/framework/formats/rect.pb.h"
+#include "mediapipe/framework/formats/yuv_image.h"
 #include "mediapipe/framework/port/opencv_core_inc.h"
 #include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/util/encoded_image_decoder.h"
+#include "mediapipe/util/image_frame_util.h"
 
 #if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
 #include "mediapipe/gpu/gl_calculator_helper.h"
@@ -33,6 +41,74 @@
 
 namespace {
 enum { ATTRIB_VERTEX, ATTRIB_TEXTURE_POSITION, NUM_ATTRIBUTES };
+
+// Full viewport quad, as a triangle strip.
+constexpr float kSquareVertices[] = {
+    -1.0f, -1.0f,  // bottom left
+    1.0f,  -1.0f,  // bottom right
+    -1.0f, 1.0f,   // top left
+    1.0f,  1.0f,   // top right
+};
+
+// Computes the corners of a cropping rectangle of the given center, size and
+// rotation (in radians) in normalized texture coordinates of a
+// src_width x src_height image, in the vertex order of kSquareVertices.
+void ComputeTextureCorners(float x_center, float y_center, float crop_width,
+                           float crop_height, float rotation, int src_width,
+                           int src_height, float* corners) {
+  const float half_width = crop_width / 2.0f;
+  const float half_height = crop_height / 2.0f;
+  const float offsets[] = {-half_width, -half_height, half_width, -half_height,
+                           -half_width, half_height,  half_width, half_height};
+
+  for (int i = 0; i < 4; ++i) {
+    const float rotated_x = std::cos(rotation) * offsets[i * 2] -
+                            std::sin(rotation) * offsets[i * 2 + 1];
+    const float rotated_y = std::sin(rotation) * offsets[i * 2] +
+                            std::cos(rotation) * offsets[i * 2 + 1];
+
+    corners[i * 2] = ((rotated_x + x_center) / src_width);
+    corners[i * 2 + 1] = ((rotated_y + y_center) / src_height);
+  }
+}
+
+// Returns the cropping rectangle described by "rect" in pixels of a
+// width x height image, or the whole image if "rect" is not valid.
+cv::RotatedRect NormRectToRotatedRect(const mediapipe::NormalizedRect& rect,
+                                      int width, int height) {
+  if (rect.width() > 0.0 && rect.height() > 0.0 && rect.x_center() >= 0.0 &&
+      rect.y_center() >= 0.0) {
+    return cv::RotatedRect(
+        cv::Point2f(std::round(rect.x_center() * width),
+                    std::round(rect.y_center() * height)),
+        cv::Size2f(std::round(rect.width() * width),
+                   std::round(rect.height() * height)),
+        rect.rotation() * 180.f / M_PI);
+  }
+  return cv::RotatedRect(cv::Point2f(width / 2.0f, height / 2.0f),
+                         cv::Size2f(width, height), 0.f);
+}
+
+// Warps the region of "input" covered by "rect" into "output", which must be
+// allocated with the desired output size.
+void WarpRotatedRect(const cv::Mat& input, const cv::RotatedRect& rect,
+                     cv::Mat* output) {
+  cv::Mat src_points;
+  cv::boxPoints(rect, src_points);
+
+  float dst_corners[8] = {0,
+                          output->rows - 1.f,
+                          0,
+                          0,
+                          output->cols - 1.f,
+                          0,
+                          output->cols - 1.f,
+                          output->rows - 1.f};
+  cv::Mat dst_points = cv::Mat(4, 2, CV_32F, dst_corners);
+  cv::Mat projection_matrix =
+      cv::getPerspectiveTransform(src_points, dst_points);
+  cv::warpPerspective(input, *output, projection_matrix, output->size());
+}
 }  // namespace
 
 namespace mediapipe {
@@ -47,9 +123,16 @@ namespace mediapipe {
 // be in radian, see rect.proto for detail.
 //
 // Input:
-//   One of the following two tags:
+//   One of the following four tags:
 //   IMAGE - ImageFrame representing the input image.
 //   IMAGE_GPU - GpuBuffer representing the input image.
+//   YUV_IMAGE - I420, NV12 or NV21 YUVImage representing the input image. Only
+//               the bounding box of the cropping rectangle is converted to
+//               SRGB, and the output is an SRGB ImageFrame.
+//   ENCODED_IMAGE - std::string with an encoded (e.g. JPEG) image. It is
+//                   decoded lazily: for JPEG only the bounding box of the
+//                   cropping rectangle(s) is decoded. The output is an SRGB
+//                   or GRAY8 ImageFrame.
 //   One of the following two tags (optional if WIDTH/HEIGHT is specified):
 //   RECT - A Rect proto specifying the width/height and location of the
 //          cropping rectangle.
@@ -61,10 +144,20 @@ namespace mediapipe {
 //   HEIGHT - The desired height of the output cropped image,
 //            based on image center
 //
+//   Alternative to all of the above, to crop several regions at once:
+//   NORM_RECTS - A std::vector<NormalizedRect>, one rectangle per crop.
+//
 // Output:
-//   One of the following two tags:
-//   IMAGE - Cropped ImageFrame
-//   IMAGE_GPU - Cropped GpuBuffer.
+//   One of the following three tags:
+//   IMAGE - Cropped ImageFrame (for IMAGE or YUV_IMAGE input).
+//   IMAGES - A std::vector<ImageFrame> with one crop per NORM_RECTS
+//            rectangle (for IMAGE or YUV_IMAGE input).
+//   IMAGE_GPU - Cropped GpuBuffer. With NORM_RECTS, the crops are rendered in
+//               a single pass into one atlas texture of roi_output_width x
+//               (roi_output_height * number of rectangles), where crop i
+//               occupies rows [i * roi_output_height,
+//               (i + 1) * roi_output_height). This is the layout expected by
+//               models that take a batch of crops.
 //
 // Note: input_stream values take precedence over options defined in the graph.
 //
@@ -80,9 +173,13 @@ class ImageCroppingCalculator : public CalculatorBase {
 
  private:
   ::mediapipe::Status RenderCpu(CalculatorContext* cc);
+  ::mediapipe::Status RenderCpuMulti(CalculatorContext* cc);
   ::mediapipe::Status RenderGpu(CalculatorContext* cc);
+  ::mediapipe::Status RenderGpuMulti(CalculatorContext* cc);
   ::mediapipe::Status InitGpu(CalculatorContext* cc);
-  void GlRender();
+  // Draws num_quads triangle strip quads of 4 vertices each.
+  void GlRender(const float* vertices, const float* texture_vertices,
+                int num_quads);
   void GetOutputDimensions(CalculatorContext* cc, int src_width, int src_height,
                            int* dst_width, int* dst_height);
 
@@ -101,13 +198,37 @@ REGISTER_CALCULATOR(ImageCroppingCalculator);
 
 ::mediapipe::Status ImageCroppingCalculator::GetContract(
     CalculatorContract* cc) {
-  RET_CHECK(cc->Inputs().HasTag("IMAGE") ^ cc->Inputs().HasTag("IMAGE_GPU"));
-  RET_CHECK(cc->Outputs().HasTag("IMAGE") ^ cc->Outputs().HasTag("IMAGE_GPU"));
+  RET_CHECK_EQ(cc->Inputs().HasTag("IMAGE") + cc->Inputs().HasTag("IMAGE_GPU") +
+                   cc->Inputs().HasTag("YUV_IMAGE") +
+                   cc->Inputs().HasTag("ENCODED_IMAGE"),
+               1);
+  RET_CHECK_EQ(cc->Outputs().HasTag("IMAGE") + cc->Outputs().HasTag("IMAGES") +
+                   cc->Outputs().HasTag("IMAGE_GPU"),
+               1);
+  const bool multi_roi = cc->Inputs().HasTag("NORM_RECTS");
+  if (multi_roi) {
+    RET_CHECK(!cc->Inputs().HasTag("RECT") && !cc->Inputs().HasTag("NORM_RECT"))
+        << "NORM_RECTS cannot be combined with RECT or NORM_RECT.";
+    cc->Inputs().Tag("NORM_RECTS").Set<std::vector<NormalizedRect>>();
+  }
 
-  if (cc->Inputs().HasTag("IMAGE")) {
-    RET_CHECK(cc->Outputs().HasTag("IMAGE"));
-    cc->Inputs().Tag("IMAGE").Set<ImageFrame>();
-    cc->Outputs().Tag("IMAGE").Set<ImageFrame>();
+  if (cc->Inputs().HasTag("IMAGE") || cc->Inputs().HasTag("YUV_IMAGE") ||
+      cc->Inputs().HasTag("ENCODED_IMAGE")) {
+    if (cc->Inputs().HasTag("IMAGE")) {
+      cc->Inputs().Tag("IMAGE").Set<ImageFrame>();
+    } else if (cc->Inputs().HasTag("YUV_IMAGE")) {
+      cc->Inputs().Tag("YUV_IMAGE").Set<YUVImage>();
+    } else {
+      cc->Inputs().Tag("ENCODED_IMAGE").Set<std::string>();
+    }
+    if (multi_roi) {
+      RET_CHECK(cc->Outputs().HasTag("IMAGES"));
+      cc->Outputs().Tag("IMAGES").Set<std::vector<ImageFrame>>();
+    } else {
+      RET_CHECK(cc->Outputs().HasTag("IMAGE"));
+      cc->Outputs().Tag("IMAGE").Set<ImageFrame>();
+      cc->UseService(kImageFramePoolService).Optional();
+    }
   }
 #if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
   if (cc->Inputs().HasTag("IMAGE_GPU")) {
@@ -146,6 +267,13 @@ REGISTER_CALCULATOR(ImageCroppingCalculator);
 
   options_ = cc->Options<mediapipe::ImageCroppingCalculatorOptions>();
 
+  if (use_gpu_ && cc->Inputs().HasTag("NORM_RECTS")) {
+    RET_CHECK(options_.roi_output_width() > 0 &&
+              options_.roi_output_height() > 0)
+        << "roi_output_width and roi_output_height are required to crop "
+           "NORM_RECTS on GPU.";
+  }
+
   if (use_gpu_) {
 #if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
     MP_RETURN_IF_ERROR(gpu_helper_.Open(cc));
@@ -189,14 +317,35 @@ REGISTER_CALCULATOR(ImageCroppingCalculator);
 }
 
 ::mediapipe::Status ImageCroppingCalculator::RenderCpu(CalculatorContext* cc) {
-  const auto& input_img = cc->Inputs().Tag("IMAGE").Get<ImageFrame>();
-  cv::Mat input_mat = formats::MatView(&input_img);
+  if (cc->Inputs().HasTag("NORM_RECTS")) {
+    return RenderCpuMulti(cc);
+  }
+  const YUVImage* yuv_image = nullptr;
+  const ImageFrame* input_img = nullptr;
+  EncodedImageDecoder decoder;
+  const bool encoded = cc->Inputs().HasTag("ENCODED_IMAGE");
+  int input_width;
+  int input_height;
+  if (cc->Inputs().HasTag("YUV_IMAGE")) {
+    yuv_image = &cc->Inputs().Tag("YUV_IMAGE").Get<YUVImage>();
+    input_width = yuv_image->width();
+    input_height = yuv_image->height();
+  } else if (encoded) {
+    MP_RETURN_IF_ERROR(
+        decoder.Open(cc->Inputs().Tag("ENCODED_IMAGE").Get<std::string>()));
+    input_width = decoder.width();
+    input_height = decoder.height();
+  } else {
+    input_img = &cc->Inputs().Tag("IMAGE").Get<ImageFrame>();
+    input_width = input_img->Width();
+    input_height = input_img->Height();
+  }
 
-  float rect_center_x = input_img.Width() / 2.0f;
-  float rect_center_y = input_img.Height() / 2.0f;
+  float rect_center_x = input_width / 2.0f;
+  float rect_center_y = input_height / 2.0f;
   float rotation = 0.0f;
-  int target_width = input_img.Width();
-  int target_height = input_img.Height();
+  int target_width = input_width;
+  int target_height = input_height;
   if (cc->Inputs().HasTag("RECT")) {
     const auto& rect = cc->Inputs().Tag("RECT").Get<Rect>();
     if (rect.width() > 0 && rect.height() > 0 && rect.x_center() >= 0 &&
@@ -211,10 +360,10 @@ REGISTER_CALCULATOR(ImageCroppingCalculator);
     const auto& rect = cc->Inputs().Tag("NORM_RECT").Get<NormalizedRect>();
     if (rect.width() > 0.0 && rect.height() > 0.0 && rect.x_center() >= 0.0 &&
         rect.y_center() >= 0.0) {
-      rect_center_x = std::round(rect.x_center() * input_img.Width());
-      rect_center_y = std::round(rect.y_center() * input_img.Height());
-      target_width = std::round(rect.width() * input_img.Width());
-      target_height = std::round(rect.height() * input_img.Height());
+      rect_center_x = std::round(rect.x_center() * input_width);
+      rect_center_y = std::round(rect.y_center() * input_height);
+      target_width = std::round(rect.width() * input_width);
+      target_height = std::round(rect.height() * input_height);
       rotation = rect.rotation();
     }
   } else {
@@ -228,39 +377,134 @@ REGISTER_CALCULATOR(ImageCroppingCalculator);
     rotation = options_.rotation();
   }
 
+  ImageFrame converted_img;
+  if (yuv_image) {
+    // Convert only the part of the image covered by the cropping rectangle,
+    // starting on even coordinates to match the chroma subsampling.
+    const cv::Rect bounds =
+        cv::RotatedRect(cv::Point2f(rect_center_x, rect_center_y),
+                        cv::Size2f(target_width, target_height),
+                        rotation * 180.f / M_PI)
+            .boundingRect() &
+        cv::Rect(0, 0, input_width, input_height);
+    RET_CHECK(!bounds.empty()) << "Cropping rectangle is outside the image.";
+    const int left = bounds.x & ~1;
+    const int top = bounds.y & ~1;
+    const int width = bounds.x + bounds.width - left;
+    const int height = bounds.y + bounds.height - top;
+    image_frame_util::YUVImageRegionToImageFrame(*yuv_image, left, top, width,
+                                                 height, width, height,
+                                                 &converted_img);
+    rect_center_x -= left;
+    rect_center_y -= top;
+    input_img = &converted_img;
+  } else if (encoded) {
+    // Decode only the part of the image covered by the cropping rectangle.
+    const cv::Rect bounds =
+        cv::RotatedRect(cv::Point2f(rect_center_x, rect_center_y),
+                        cv::Size2f(target_width, target_height),
+                        rotation * 180.f / M_PI)
+            .boundingRect() &
+        cv::Rect(0, 0, input_width, input_height);
+    RET_CHECK(!bounds.empty()) << "Cropping rectangle is outside the image.";
+    MP_RETURN_IF_ERROR(decoder.DecodeRegion(bounds, 1, &converted_img));
+    rect_center_x -= bounds.x;
+    rect_center_y -= bounds.y;
+    input_img = &converted_img;
+  }
+  cv::Mat input_mat = formats::MatView(input_img);
+
   const cv::RotatedRect min_rect(cv::Point2f(rect_center_x, rect_center_y),
                                  cv::Size2f(target_width, target_height),
                                  rotation * 180.f / M_PI);
-  cv::Mat src_points;
-  cv::boxPoints(min_rect, src_points);
-
-  float dst_corners[8] = {0,
-                          min_rect.size.height - 1,
-                          0,
-                          0,
-                          min_rect.size.width - 1,
-                          0,
-                          min_rect.size.width - 1,
-                          min_rect.size.height - 1};
-  cv::Mat dst_points = cv::Mat(4, 2, CV_32F, dst_corners);
-  cv::Mat projection_matrix =
-      cv::getPerspectiveTransform(src_points, dst_points);
-  cv::Mat cropped_image;
-  cv::warpPerspective(input_mat, cropped_image, projection_matrix,
-                      cv::Size(min_rect.size.width, min_rect.size.height));
 
-  std::unique_ptr<ImageFrame> output_frame(new ImageFrame(
-      input_img.Format(), cropped_image.cols, cropped_image.rows));
+  auto pool = cc->Service(kImageFramePoolService);
+  std::unique_ptr<ImageFrame> output_frame = ImageFramePool::AllocateFrame(
+      pool.IsAvailable() ? &pool.GetObject() : nullptr, input_img->Format(),
+      min_rect.size.width, min_rect.size.height);
   cv::Mat output_mat = formats::MatView(output_frame.get());
-  cropped_image.copyTo(output_mat);
+  WarpRotatedRect(input_mat, min_rect, &output_mat);
   cc->Outputs().Tag("IMAGE").Add(output_frame.release(), cc->InputTimestamp());
   return ::mediapipe::OkStatus();
 }
 
+::mediapipe::Status ImageCroppingCalculator::RenderCpuMulti(
+    CalculatorContext* cc) {
+  if (cc->Inputs().Tag("NORM_RECTS").IsEmpty()) {
+    return ::mediapipe::OkStatus();
+  }
+  const auto& rects =
+      cc->Inputs().Tag("NORM_RECTS").Get<std::vector<NormalizedRect>>();
+
+  // YUVImage inputs are converted once and shared by all crops. Encoded
+  // inputs only decode the bounding box of all crops.
+  ImageFrame converted_img;
+  const ImageFrame* input_img;
+  int input_width;
+  int input_height;
+  cv::Point2f origin(0.f, 0.f);
+  if (cc->Inputs().HasTag("YUV_IMAGE")) {
+    image_frame_util::YUVImageToImageFrame(
+        cc->Inputs().Tag("YUV_IMAGE").Get<YUVImage>(), &converted_img);
+    input_img = &converted_img;
+    input_width = input_img->Width();
+    input_height = input_img->Height();
+  } else if (cc->Inputs().HasTag("ENCODED_IMAGE")) {
+    if (rects.empty()) {
+      cc->Outputs().Tag("IMAGES").Add(new std::vector<ImageFrame>(),
+                                      cc->InputTimestamp());
+      return ::mediapipe::OkStatus();
+    }
+    EncodedImageDecoder decoder;
+    MP_RETURN_IF_ERROR(
+        decoder.Open(cc->Inputs().Tag("ENCODED_IMAGE").Get<std::string>()));
+    input_width = decoder.width();
+    input_height = decoder.height();
+    cv::Rect bounds;
+    for (const auto& rect : rects) {
+      bounds |= NormRectToRotatedRect(rect, input_width, input_height)
+                    .boundingRect();
+    }
+    bounds &= cv::Rect(0, 0, input_width, input_height);
+    RET_CHECK(!bounds.empty()) << "Cropping rectangles are outside the image.";
+    MP_RETURN_IF_ERROR(decoder.DecodeRegion(bounds, 1, &converted_img));
+    origin = cv::Point2f(bounds.x, bounds.y);
+    input_img = &converted_img;
+  } else {
+    input_img = &cc->Inputs().Tag("IMAGE").Get<ImageFrame>();
+    input_width = input_img->Width();
+    input_height = input_img->Height();
+  }
+  const cv::Mat input_mat = formats::MatView(input_img);
+
+  auto output_frames = absl::make_unique<std::vector<ImageFrame>>();
+  output_frames->reserve(rects.size());
+  for (const auto& rect : rects) {
+    cv::RotatedRect min_rect =
+        NormRectToRotatedRect(rect, input_width, input_height);
+    min_rect.center -= origin;
+    int width = min_rect.size.width;
+    int height = min_rect.size.height;
+    if (options_.roi_output_width() > 0 && options_.roi_output_height() > 0) {
+      width = options_.roi_output_width();
+      height = options_.roi_output_height();
+    }
+    output_frames->emplace_back(input_img->Format(), width, height);
+    cv::Mat output_mat = formats::MatView(&output_frames->back());
+    WarpRotatedRect(input_mat, min_rect, &output_mat);
+  }
+  cc->Outputs().Tag("IMAGES").Add(output_frames.release(),
+                                  cc->InputTimestamp());
+  return ::mediapipe::OkStatus();
+}
+
 ::mediapipe::Status ImageCroppingCalculator::RenderGpu(CalculatorContext* cc) {
   if (cc->Inputs().Tag("IMAGE_GPU").IsEmpty()) {
     return ::mediapipe::OkStatus();
   }
+  if (cc->Inputs().HasTag("NORM_RECTS")) {
+    return RenderGpuMulti(cc);
+  }
 #if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
   const Packet& input_packet = cc->Inputs().Tag("IMAGE_GPU").Value();
   const auto& input_buffer = input_packet.Get<mediapipe::GpuBuffer>();
@@ -278,7 +522,7 @@ REGISTER_CALCULATOR(ImageCroppingCalculator);
     glActiveTexture(GL_TEXTURE1);
     glBindTexture(src_tex.target(), src_tex.name());
 
-    GlRender();
+    GlRender(kSquareVertices, transformed_points_, 1);
 
     glActiveTexture(GL_TEXTURE2);
     glBindTexture(GL_TEXTURE_2D, 0);
@@ -297,16 +541,70 @@ REGISTER_CALCULATOR(ImageCroppingCalculator);
   return ::mediapipe::OkStatus();
 }
 
-void ImageCroppingCalculator::GlRender() {
+::mediapipe::Status ImageCroppingCalculator::RenderGpuMulti(
+    CalculatorContext* cc) {
+  if (cc->Inputs().Tag("NORM_RECTS").IsEmpty()) {
+    return ::mediapipe::OkStatus();
+  }
 #if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
-  static const GLfloat square_vertices[] = {
-      -1.0f, -1.0f,  // bottom left
-      1.0f,  -1.0f,  // bottom right
-      -1.0f, 1.0f,   // top left
-      1.0f,  1.0f,   // top right
-  };
-  const GLfloat* texture_vertices = &transformed_points_[0];
+  const auto& rects =
+      cc->Inputs().Tag("NORM_RECTS").Get<std::vector<NormalizedRect>>();
+  if (rects.empty()) {
+    return ::mediapipe::OkStatus();
+  }
+  const auto& input_buffer =
+      cc->Inputs().Tag("IMAGE_GPU").Get<mediapipe::GpuBuffer>();
+  auto src_tex = gpu_helper_.CreateSourceTexture(input_buffer);
+  const int src_width = src_tex.width();
+  const int src_height = src_tex.height();
+
+  // One quad per crop, stacked vertically in the atlas.
+  const int num_rois = rects.size();
+  std::vector<float> vertices(num_rois * 8);
+  std::vector<float> texture_vertices(num_rois * 8);
+  for (int i = 0; i < num_rois; ++i) {
+    const float bottom = -1.0f + 2.0f * i / num_rois;
+    const float top = -1.0f + 2.0f * (i + 1) / num_rois;
+    const float quad[] = {-1.0f, bottom, 1.0f, bottom, -1.0f, top, 1.0f, top};
+    std::copy(quad, quad + 8, vertices.begin() + i * 8);
+
+    const cv::RotatedRect min_rect =
+        NormRectToRotatedRect(rects[i], src_width, src_height);
+    ComputeTextureCorners(min_rect.center.x, min_rect.center.y,
+                          min_rect.size.width, min_rect.size.height,
+                          min_rect.angle * M_PI / 180.f, src_width, src_height,
+                          &texture_vertices[i * 8]);
+  }
+
+  auto dst_tex = gpu_helper_.CreateDestinationTexture(
+      options_.roi_output_width(), options_.roi_output_height() * num_rois);
+  {
+    gpu_helper_.BindFramebuffer(dst_tex);  // GL_TEXTURE0
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(src_tex.target(), src_tex.name());
+
+    GlRender(vertices.data(), texture_vertices.data(), num_rois);
 
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(src_tex.target(), 0);
+    glFlush();
+  }
+
+  auto output = dst_tex.GetFrame<mediapipe::GpuBuffer>();
+  cc->Outputs().Tag("IMAGE_GPU").Add(output.release(), cc->InputTimestamp());
+
+  src_tex.Release();
+  dst_tex.Release();
+#endif  // __ANDROID__ or iOS
+
+  return ::mediapipe::OkStatus();
+}
+
+void ImageCroppingCalculator::GlRender(const float* vertices,
+                                       const float* texture_vertices,
+                                       int num_quads) {
+#if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
   // program
   glUseProgram(program_);
 
@@ -319,20 +617,22 @@ void ImageCroppingCalculator::GlRender() {
 
   // vbo 0
   glBindBuffer(GL_ARRAY_BUFFER, vbo[0]);
-  glBufferData(GL_ARRAY_BUFFER, 4 * 2 * sizeof(GLfloat), square_vertices,
+  glBufferData(GL_ARRAY_BUFFER, num_quads * 4 * 2 * sizeof(GLfloat), vertices,
                GL_STATIC_DRAW);
   glEnableVertexAttribArray(ATTRIB_VERTEX);
   glVertexAttribPointer(ATTRIB_VERTEX, 2, GL_FLOAT, 0, 0, nullptr);
 
   // vbo 1
   glBindBuffer(GL_ARRAY_BUFFER, vbo[1]);
-  glBufferData(GL_ARRAY_BUFFER, 4 * 2 * sizeof(GLfloat), texture_vertices,
-               GL_STATIC_DRAW);
+  glBufferData(GL_ARRAY_BUFFER, num_quads * 4 * 2 * sizeof(GLfloat),
+               texture_vertices, GL_STATIC_DRAW);
   glEnableVertexAttribArray(ATTRIB_TEXTURE_POSITION);
   glVertexAttribPointer(ATTRIB_TEXTURE_POSITION, 2, GL_FLOAT, 0, 0, nullptr);
 
-  // draw
-  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  // draw, all quads into the same framebuffer
+  for (int i = 0; i < num_quads; ++i) {
+    glDrawArrays(GL_TRIANGLE_STRIP, i * 4, 4);
+  }
 
   // cleanup
   glDisableVertexAttribArray(ATTRIB_VERTEX);
@@ -443,20 +743,8 @@ void ImageCroppingCalculator::GetOutputDimensions(CalculatorContext* cc,
     rotation = options_.rotation();
   }
 
-  const float half_width = crop_width / 2.0f;
-  const float half_height = crop_height / 2.0f;
-  const float corners[] = {-half_width, -half_height, half_width, -half_height,
-                           -half_width, half_height,  half_width, half_height};
-
-  for (int i = 0; i < 4; ++i) {
-    const float rotated_x = std::cos(rotation) * corners[i * 2] -
-                            std::sin(rotation) * corners[i * 2 + 1];
-    const float rotated_y = std::sin(rotation) * corners[i * 2] +
-                            std::cos(rotation) * corners[i * 2 + 1];
-
-    transformed_points_[i * 2] = ((rotated_x + x_center) / src_width);
-    transformed_points_[i * 2 + 1] = ((rotated_y + y_center) / src_height);
-  }
+  ComputeTextureCorners(x_center, y_center, crop_width, crop_height, rotation,
+                        src_width, src_height, transformed_points_);
 
   // Find the boundaries of the transformed rectangle.
   float col_min = transformed_points_[0];
@@ -16,11 +16,15 @@
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/formats/image_frame_pool.h"
+#include "mediapipe/framework/formats/yuv_image.h"
 #include "mediapipe/framework/port/opencv_core_inc.h"
 #include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/gpu/scale_mode.pb.h"
+#include "mediapipe/util/image_frame_util.h"
+#include "mediapipe/util/simd_image_util.h"
 
 #if defined(__ANDROID__) || defined(__APPLE__) && !TARGET_OS_OSX
 #include "mediapipe/gpu/gl_calculator_helper.h"
@@ -95,9 +99,12 @@ mediapipe::ScaleMode_Mode ParseScaleMode(
 // Scales, rotates, and flips images horizontally or vertically.
 //
 // Input:
-//   One of the following two tags:
+//   One of the following three tags:
 //   IMAGE: ImageFrame representing the input image.
 //   IMAGE_GPU: GpuBuffer representing the input image.
+//   YUV_IMAGE: I420, NV12 or NV21 YUVImage representing the input image. It
+//   is scaled before the conversion to SRGB, so only output-sized images are
+//   converted. The output is an SRGB ImageFrame.
 //
 //   ROTATION_DEGREES (optional): The counterclockwise rotation angle in
 //   degrees. This allows different rotation angles for different frames. It has
@@ -139,7 +146,9 @@ mediapipe::ScaleMode_Mode ParseScaleMode(
 // calculator options. Flipping is applied after rotation.
 //
 // Note: Only scale mode STRETCH is currently supported on CPU,
-// and flipping is not yet supported either.
+// and flipping is not yet supported either, unless single_pass_cpu is set.
+// That mode supports all scale modes and flipping for IMAGE inputs, and does
+// the whole transformation in one warp into the output frame.
 //
 class ImageTransformationCalculator : public CalculatorBase {
  public:
@@ -154,6 +163,7 @@ class ImageTransformationCalculator : public CalculatorBase {
 
  private:
   ::mediapipe::Status RenderCpu(CalculatorContext* cc);
+  ::mediapipe::Status RenderCpuSinglePass(CalculatorContext* cc);
   ::mediapipe::Status RenderGpu(CalculatorContext* cc);
   ::mediapipe::Status GlSetup();
 
@@ -182,13 +192,20 @@ REGISTER_CALCULATOR(ImageTransformationCalculator);
 // static
 ::mediapipe::Status ImageTransformationCalculator::GetContract(
     CalculatorContract* cc) {
-  RET_CHECK(cc->Inputs().HasTag("IMAGE") ^ cc->Inputs().HasTag("IMAGE_GPU"));
+  RET_CHECK_EQ(cc->Inputs().HasTag("IMAGE") + cc->Inputs().HasTag("IMAGE_GPU") +
+                   cc->Inputs().HasTag("YUV_IMAGE"),
+               1);
   RET_CHECK(cc->Outputs().HasTag("IMAGE") ^ cc->Outputs().HasTag("IMAGE_GPU"));
 
-  if (cc->Inputs().HasTag("IMAGE")) {
+  if (cc->Inputs().HasTag("IMAGE") || cc->Inputs().HasTag("YUV_IMAGE")) {
     RET_CHECK(cc->Outputs().HasTag("IMAGE"));
-    cc->Inputs().Tag("IMAGE").Set<ImageFrame>();
+    if (cc->Inputs().HasTag("IMAGE")) {
+      cc->Inputs().Tag("IMAGE").Set<ImageFrame>();
+    } else {
+      cc->Inputs().Tag("YUV_IMAGE").Set<YUVImage>();
+    }
     cc->Outputs().Tag("IMAGE").Set<ImageFrame>();
+    cc->UseService(kImageFramePoolService).Optional();
   }
 #if defined(__ANDROID__) || defined(__APPLE__) && !TARGET_OS_OSX
   if (cc->Inputs().HasTag("IMAGE_GPU")) {
@@ -302,15 +319,55 @@ REGISTER_CALCULATOR(ImageTransformationCalculator);
 
 ::mediapipe::Status ImageTransformationCalculator::RenderCpu(
     CalculatorContext* cc) {
-  int input_width = cc->Inputs().Tag("IMAGE").Get<ImageFrame>().Width();
-  int input_height = cc->Inputs().Tag("IMAGE").Get<ImageFrame>().Height();
-
-  const auto& input_img = cc->Inputs().Tag("IMAGE").Get<ImageFrame>();
-  cv::Mat input_mat = formats::MatView(&input_img);
+  if (options_.single_pass_cpu() && cc->Inputs().HasTag("IMAGE")) {
+    return RenderCpuSinglePass(cc);
+  }
+  const YUVImage* yuv_image = nullptr;
+  const ImageFrame* input_img = nullptr;
+  int input_width;
+  int input_height;
+  cv::Mat input_mat;
+  if (cc->Inputs().HasTag("YUV_IMAGE")) {
+    yuv_image = &cc->Inputs().Tag("YUV_IMAGE").Get<YUVImage>();
+    input_width = yuv_image->width();
+    input_height = yuv_image->height();
+  } else {
+    input_img = &cc->Inputs().Tag("IMAGE").Get<ImageFrame>();
+    input_width = input_img->Width();
+    input_height = input_img->Height();
+    input_mat = formats::MatView(input_img);
+  }
+  const ImageFormat::Format output_format =
+      yuv_image ? ImageFormat::SRGB : input_img->Format();
+
+  // YUVImage inputs are scaled in YUV, and only the scaled image is
+  // converted to SRGB.
+  ImageFrame converted_img;
+  auto resize_input = [&](const cv::Size& size, cv::Mat* output) {
+    if (yuv_image) {
+      // Without output dimensions the image is only converted.
+      const cv::Size target =
+          size.area() > 0 ? size : cv::Size(input_width, input_height);
+      image_frame_util::YUVImageRegionToImageFrame(
+          *yuv_image, 0, 0, input_width, input_height, target.width,
+          target.height, &converted_img);
+      *output = formats::MatView(&converted_img);
+    } else {
+#if defined(__wasm_simd128__)
+      // OpenCV's WebAssembly builds have no SIMD resize kernels.
+      if (input_mat.depth() == CV_8U && input_mat.channels() <= 4 &&
+          size.area() > 0) {
+        simd_image_util::ResizeBilinear(input_mat, size, output);
+        return;
+      }
+#endif  // __wasm_simd128__
+      cv::resize(input_mat, *output, size);
+    }
+  };
   cv::Mat scaled_mat;
 
   if (scale_mode_ == mediapipe::ScaleMode_Mode_STRETCH) {
-    cv::resize(input_mat, scaled_mat, cv::Size(output_width_, output_height_));
+    resize_input(cv::Size(output_width_, output_height_), &scaled_mat);
   } else {
     const float scale =
         std::min(static_cast<float>(output_width_) / input_width,
@@ -320,8 +377,7 @@ REGISTER_CALCULATOR(ImageTransformationCalculator);
 
     if (scale_mode_ == mediapipe::ScaleMode_Mode_FIT) {
       cv::Mat intermediate_mat;
-      cv::resize(input_mat, intermediate_mat,
-                 cv::Size(target_width, target_height));
+      resize_input(cv::Size(target_width, target_height), &intermediate_mat);
       const int top = (output_height_ - target_height) / 2;
       const int bottom = output_height_ - target_height - top;
       const int left = (output_width_ - target_width) / 2;
@@ -330,7 +386,7 @@ REGISTER_CALCULATOR(ImageTransformationCalculator);
                          options_.constant_padding() ? cv::BORDER_CONSTANT
                                                      : cv::BORDER_REPLICATE);
     } else {
-      cv::resize(input_mat, scaled_mat, cv::Size(target_width, target_height));
+      resize_input(cv::Size(target_width, target_height), &scaled_mat);
       output_width_ = target_width;
       output_height_ = target_height;
     }
@@ -360,8 +416,10 @@ REGISTER_CALCULATOR(ImageTransformationCalculator);
   cv::Mat rotation_mat = cv::getRotationMatrix2D(src_center, angle, 1.0);
   cv::warpAffine(scaled_mat, rotated_mat, rotation_mat, scaled_mat.size());
 
-  std::unique_ptr<ImageFrame> output_frame(
-      new ImageFrame(input_img.Format(), output_width, output_height));
+  auto pool = cc->Service(kImageFramePoolService);
+  std::unique_ptr<ImageFrame> output_frame = ImageFramePool::AllocateFrame(
+      pool.IsAvailable() ? &pool.GetObject() : nullptr, output_format,
+      output_width, output_height);
   cv::Mat output_mat = formats::MatView(output_frame.get());
   rotated_mat.copyTo(output_mat);
   cc->Outputs().Tag("IMAGE").Add(output_frame.release(), cc->InputTimestamp());
@@ -369,6 +427,101 @@ REGISTER_CALCULATOR(ImageTransformationCalculator);
   return ::mediapipe::OkStatus();
 }
 
+::mediapipe::Status ImageTransformationCalculator::RenderCpuSinglePass(
+    CalculatorContext* cc) {
+  const auto& input_img = cc->Inputs().Tag("IMAGE").Get<ImageFrame>();
+  const cv::Mat input_mat = formats::MatView(&input_img);
+  const int input_width = input_img.Width();
+  const int input_height = input_img.Height();
+
+  if (cc->InputSidePackets().HasTag("ROTATION_DEGREES")) {
+    rotation_ = DegreesToRotationMode(
+        cc->InputSidePackets().Tag("ROTATION_DEGREES").Get<int>());
+  }
+
+  int output_width;
+  int output_height;
+  ComputeOutputDimensions(input_width, input_height, &output_width,
+                          &output_height);
+  if (cc->Outputs().HasTag("LETTERBOX_PADDING")) {
+    auto padding = absl::make_unique<std::array<float, 4>>();
+    ComputeOutputLetterboxPadding(input_width, input_height, output_width,
+                                  output_height, padding.get());
+    cc->Outputs()
+        .Tag("LETTERBOX_PADDING")
+        .Add(padding.release(), cc->InputTimestamp());
+  }
+
+  // Dimensions of the input after rotation, which the scale mode applies to.
+  const bool swap_dimensions =
+      rotation_ == mediapipe::RotationMode_Mode_ROTATION_90 ||
+      rotation_ == mediapipe::RotationMode_Mode_ROTATION_270;
+  const int rotated_width = swap_dimensions ? input_height : input_width;
+  const int rotated_height = swap_dimensions ? input_width : input_height;
+  double scale_x = static_cast<double>(output_width) / rotated_width;
+  double scale_y = static_cast<double>(output_height) / rotated_height;
+  if (scale_mode_ == mediapipe::ScaleMode_Mode_FIT) {
+    scale_x = scale_y = std::min(scale_x, scale_y);
+  } else if (scale_mode_ == mediapipe::ScaleMode_Mode_FILL_AND_CROP) {
+    scale_x = scale_y = std::max(scale_x, scale_y);
+  }
+
+  // Forward map from input to output pixel centers: move the input center to
+  // the origin, rotate counterclockwise, flip, scale, and move to the output
+  // center. FIT leaves a letterbox and FILL_AND_CROP crops, both centered.
+  // Multiples of 90 degrees keep the rotation matrix exact.
+  double cos_angle = 1.0;
+  double sin_angle = 0.0;
+  switch (rotation_) {
+    case mediapipe::RotationMode_Mode_ROTATION_90:
+      cos_angle = 0.0;
+      sin_angle = 1.0;
+      break;
+    case mediapipe::RotationMode_Mode_ROTATION_180:
+      cos_angle = -1.0;
+      break;
+    case mediapipe::RotationMode_Mode_ROTATION_270:
+      cos_angle = 0.0;
+      sin_angle = -1.0;
+      break;
+    default:
+      break;
+  }
+  const double flip_x = options_.flip_horizontally() ? -scale_x : scale_x;
+  const double flip_y = options_.flip_vertically() ? -scale_y : scale_y;
+  const double a = flip_x * cos_angle;
+  const double b = flip_x * sin_angle;
+  const double c = -flip_y * sin_angle;
+  const double d = flip_y * cos_angle;
+  const double input_center_x = (input_width - 1) / 2.0;
+  const double input_center_y = (input_height - 1) / 2.0;
+  cv::Mat transform = (cv::Mat_<double>(2, 3) << a, b,
+                       (output_width - 1) / 2.0 - a * input_center_x -
+                           b * input_center_y,
+                       c, d,
+                       (output_height - 1) / 2.0 - c * input_center_x -
+                           d * input_center_y);
+
+  auto pool = cc->Service(kImageFramePoolService);
+  std::unique_ptr<ImageFrame> output_frame = ImageFramePool::AllocateFrame(
+      pool.IsAvailable() ? &pool.GetObject() : nullptr, input_img.Format(),
+      output_width, output_height);
+  cv::Mat output_mat = formats::MatView(output_frame.get());
+  if (output_width == input_width && output_height == input_height &&
+      a == 1.0 && d == 1.0) {
+    // Nothing to transform.
+    input_mat.copyTo(output_mat);
+  } else {
+    cv::warpAffine(input_mat, output_mat, transform, output_mat.size(),
+                   cv::INTER_LINEAR,
+                   options_.constant_padding() ? cv::BORDER_CONSTANT
+                                               : cv::BORDER_REPLICATE);
+  }
+  cc->Outputs().Tag("IMAGE").Add(output_frame.release(), cc->InputTimestamp());
+
+  return ::mediapipe::OkStatus();
+}
+
 ::mediapipe::Status ImageTransformationCalculator::RenderGpu(
     CalculatorContext* cc) {
 #if defined(__ANDROID__) || defined(__APPLE__) && !TARGET_OS_OSX
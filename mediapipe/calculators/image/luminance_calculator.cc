@@ -79,8 +79,9 @@ REGISTER_CALCULATOR(LuminanceCalculator);
   )";
 
   // shader program
-  GlhCreateProgram(kBasicVertexShader, frag_src, NUM_ATTRIBUTES,
-                   (const GLchar**)&attr_name[0], attr_location, &program_);
+  GlhCreateCachedProgram(kBasicVertexShader, frag_src, NUM_ATTRIBUTES,
+                         (const GLchar**)&attr_name[0], attr_location,
+                         &program_);
   RET_CHECK(program_) << "Problem initializing the program.";
   frame_ = glGetUniformLocation(program_, "video_frame");
   return ::mediapipe::OkStatus();
@@ -142,7 +143,7 @@ REGISTER_CALCULATOR(LuminanceCalculator);
 
 ::mediapipe::Status LuminanceCalculator::GlTeardown() {
   if (program_) {
-    glDeleteProgram(program_);
+    GlhReleaseCachedProgram(program_);
     program_ = 0;
   }
   return ::mediapipe::OkStatus();
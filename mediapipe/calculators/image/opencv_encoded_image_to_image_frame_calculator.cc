@@ -12,6 +12,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstdint>
+
+#include "mediapipe/calculators/image/opencv_encoded_image_to_image_frame_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
 #include "mediapipe/framework/port/opencv_imgcodecs_inc.h"
@@ -21,10 +24,75 @@
 
 namespace mediapipe {
 
+namespace {
+
+// Reads the dimensions and number of components from the frame header of a
+// JPEG stream. Returns false if "contents" is not a JPEG or the header could
+// not be found.
+bool ReadJpegHeader(const std::string& contents, int* width, int* height,
+                    int* num_components) {
+  const auto* data = reinterpret_cast<const uint8_t*>(contents.data());
+  const size_t size = contents.size();
+  if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) return false;
+  size_t pos = 2;
+  while (pos + 4 <= size) {
+    if (data[pos] != 0xFF) return false;
+    const uint8_t marker = data[pos + 1];
+    if (marker == 0xFF) {  // Fill byte.
+      ++pos;
+      continue;
+    }
+    const size_t length = (data[pos + 2] << 8) | data[pos + 3];
+    // SOF0..SOF15, except DHT (C4), JPG (C8) and DAC (CC).
+    if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 &&
+        marker != 0xC8 && marker != 0xCC) {
+      if (pos + 10 > size) return false;
+      *height = (data[pos + 5] << 8) | data[pos + 6];
+      *width = (data[pos + 7] << 8) | data[pos + 8];
+      *num_components = data[pos + 9];
+      return true;
+    }
+    if (marker == 0xDA || marker == 0xD9) return false;  // SOS or EOI.
+    pos += 2 + length;
+  }
+  return false;
+}
+
+// Returns the cv::imdecode() flags for "contents", decoding JPEGs at the
+// smallest DCT scale that still covers min_width x min_height.
+int DecodeFlags(const std::string& contents, int min_width, int min_height) {
+  constexpr int kUnchanged = -1;  // Return the loaded image as-is.
+  int width, height, num_components;
+  if ((min_width <= 0 && min_height <= 0) ||
+      !ReadJpegHeader(contents, &width, &height, &num_components)) {
+    return kUnchanged;
+  }
+  // libjpeg rounds the scaled size up.
+  auto covers = [&](int denom) {
+    return (width + denom - 1) / denom >= min_width &&
+           (height + denom - 1) / denom >= min_height;
+  };
+  const bool gray = num_components == 1;
+  if (covers(8)) {
+    return gray ? cv::IMREAD_REDUCED_GRAYSCALE_8 : cv::IMREAD_REDUCED_COLOR_8;
+  } else if (covers(4)) {
+    return gray ? cv::IMREAD_REDUCED_GRAYSCALE_4 : cv::IMREAD_REDUCED_COLOR_4;
+  } else if (covers(2)) {
+    return gray ? cv::IMREAD_REDUCED_GRAYSCALE_2 : cv::IMREAD_REDUCED_COLOR_2;
+  }
+  return kUnchanged;
+}
+
+}  // namespace
+
 // Takes in an encoded image std::string, decodes it by OpenCV, and converts to
 // an ImageFrame. Note that this calculator only supports grayscale and RGB
 // images for now.
 //
+// With min_output_width/min_output_height set in the options, JPEG images
+// are decoded directly at a reduced size (see
+// opencv_encoded_image_to_image_frame_calculator.proto).
+//
 // Example config:
 // node {
 //   calculator: "OpenCvEncodedImageToImageFrameCalculator"
@@ -34,7 +102,11 @@ namespace mediapipe {
 class OpenCvEncodedImageToImageFrameCalculator : public CalculatorBase {
  public:
   static ::mediapipe::Status GetContract(CalculatorContract* cc);
+  ::mediapipe::Status Open(CalculatorContext* cc) override;
   ::mediapipe::Status Process(CalculatorContext* cc) override;
+
+ private:
+  mediapipe::OpenCvEncodedImageToImageFrameCalculatorOptions options_;
 };
 
 ::mediapipe::Status OpenCvEncodedImageToImageFrameCalculator::GetContract(
@@ -44,12 +116,26 @@ class OpenCvEncodedImageToImageFrameCalculator : public CalculatorBase {
   return ::mediapipe::OkStatus();
 }
 
+::mediapipe::Status OpenCvEncodedImageToImageFrameCalculator::Open(
+    CalculatorContext* cc) {
+  options_ =
+      cc->Options<mediapipe::OpenCvEncodedImageToImageFrameCalculatorOptions>();
+  return ::mediapipe::OkStatus();
+}
+
 ::mediapipe::Status OpenCvEncodedImageToImageFrameCalculator::Process(
     CalculatorContext* cc) {
   const std::string& contents = cc->Inputs().Index(0).Get<std::string>();
-  const std::vector<char> contents_vector(contents.begin(), contents.end());
-  cv::Mat decoded_mat =
-      cv::imdecode(contents_vector, -1 /* return the loaded image as-is */);
+  // Decode straight from the packet contents, without an extra copy.
+  const cv::Mat contents_mat(1, contents.size(), CV_8UC1,
+                             const_cast<char*>(contents.data()));
+  cv::Mat decoded_mat = cv::imdecode(
+      contents_mat, DecodeFlags(contents, options_.min_output_width(),
+                                options_.min_output_height()));
+  if (decoded_mat.empty()) {
+    return ::mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+           << "Failed to decode the image.";
+  }
 
   ImageFormat::Format image_format = ImageFormat::UNKNOWN;
   cv::Mat output_mat;
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "absl/strings/substitute.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_runner.h"
 #include "mediapipe/framework/deps/file_path.h"
@@ -102,5 +103,43 @@ TEST(OpenCvEncodedImageToImageFrameCalculatorTest, TestGrayscaleJpeg) {
   EXPECT_LE(max_val, 10);
 }
 
+TEST(OpenCvEncodedImageToImageFrameCalculatorTest, TestReducedSizeJpeg) {
+  std::string contents;
+  MP_ASSERT_OK(file::GetContents(
+      file::JoinPath("./", "/mediapipe/calculators/image/testdata/dino.jpg"),
+      &contents));
+  const cv::Mat input_mat = cv::imread(
+      file::JoinPath("./", "/mediapipe/calculators/image/testdata/dino.jpg"));
+  // Requests a little less than half of the size, so the decoder can scale
+  // by 1/2 but not by 1/4.
+  const int min_width = input_mat.cols * 2 / 5;
+  const int min_height = input_mat.rows * 2 / 5;
+
+  CalculatorGraphConfig::Node node_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig::Node>(absl::Substitute(
+          R"(
+        calculator: "OpenCvEncodedImageToImageFrameCalculator"
+        input_stream: "encoded_image"
+        output_stream: "image_frame"
+        options {
+          [mediapipe.OpenCvEncodedImageToImageFrameCalculatorOptions.ext] {
+            min_output_width: $0
+            min_output_height: $1
+          }
+        }
+      )",
+          min_width, min_height));
+  CalculatorRunner runner(node_config);
+  runner.MutableInputs()->Index(0).packets.push_back(
+      MakePacket<std::string>(contents).At(Timestamp(0)));
+  MP_ASSERT_OK(runner.Run());
+  const std::vector<Packet>& packets = runner.Outputs().Index(0).packets;
+  ASSERT_EQ(1, packets.size());
+  const ImageFrame& output_frame = packets[0].Get<ImageFrame>();
+  EXPECT_EQ((input_mat.cols + 1) / 2, output_frame.Width());
+  EXPECT_EQ((input_mat.rows + 1) / 2, output_frame.Height());
+  EXPECT_EQ(ImageFormat::SRGB, output_frame.Format());
+}
+
 }  // namespace
 }  // namespace mediapipe
@@ -17,11 +17,13 @@
 #include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/port/status_builder.h"
+#include "mediapipe/util/glyph_atlas_text_renderer.h"
 
 namespace mediapipe {
 
-// Takes in a std::string, draws the text std::string by cv::putText(), and
-// outputs an ImageFrame.
+// Takes in a std::string, draws the text std::string as cv::putText() would,
+// and outputs an ImageFrame. The glyphs of the text are rendered once and
+// reused for later packets.
 //
 // Example config:
 // node {
@@ -34,6 +36,9 @@ class OpenCvPutTextCalculator : public CalculatorBase {
  public:
   static ::mediapipe::Status GetContract(CalculatorContract* cc);
   ::mediapipe::Status Process(CalculatorContext* cc) override;
+
+ private:
+  GlyphAtlasTextRenderer text_renderer_;
 };
 
 ::mediapipe::Status OpenCvPutTextCalculator::GetContract(
@@ -45,12 +50,13 @@ class OpenCvPutTextCalculator : public CalculatorBase {
 
 ::mediapipe::Status OpenCvPutTextCalculator::Process(CalculatorContext* cc) {
   const std::string& text_content = cc->Inputs().Index(0).Get<std::string>();
-  cv::Mat mat = cv::Mat::zeros(640, 640, CV_8UC4);
-  cv::putText(mat, text_content, cv::Point(15, 70), cv::FONT_HERSHEY_PLAIN, 3,
-              cv::Scalar(255, 255, 0, 255), 4);
-  std::unique_ptr<ImageFrame> output_frame = absl::make_unique<ImageFrame>(
-      ImageFormat::SRGBA, mat.size().width, mat.size().height);
-  mat.copyTo(formats::MatView(output_frame.get()));
+  std::unique_ptr<ImageFrame> output_frame =
+      absl::make_unique<ImageFrame>(ImageFormat::SRGBA, 640, 640);
+  output_frame->SetToZero();
+  cv::Mat mat = formats::MatView(output_frame.get());
+  text_renderer_.PutText(&mat, text_content, cv::Point(15, 70),
+                         cv::FONT_HERSHEY_PLAIN, 3,
+                         cv::Scalar(255, 255, 0, 255), 4);
   cc->Outputs().Index(0).Add(output_frame.release(), cc->InputTimestamp());
   return ::mediapipe::OkStatus();
 }
@@ -12,24 +12,46 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <string>
 #include <vector>
 
+#include "absl/memory/memory.h"
 #include "mediapipe/calculators/image/recolor_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/util/color.pb.h"
+#include "mediapipe/util/parallel_for_rows.h"
 
-#if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
+#if defined(__ANDROID__)
 #include "mediapipe/gpu/gl_calculator_helper.h"
 #include "mediapipe/gpu/gl_simple_shaders.h"
 #include "mediapipe/gpu/gpu_buffer.h"
 #include "mediapipe/gpu/shader_util.h"
+#elif defined(__APPLE__) && !TARGET_OS_OSX  // iOS
+#import <Metal/Metal.h>
+#include <simd/simd.h>
+
+#import "mediapipe/gpu/MPPMetalHelper.h"
+#include "mediapipe/gpu/gpu_buffer.h"
 #endif  // __ANDROID__ or iOS
 
 namespace {
 enum { ATTRIB_VERTEX, ATTRIB_TEXTURE_POSITION, NUM_ATTRIBUTES };
+
+// Minimum rows per band when splitting the CPU path across threads.
+constexpr int kMinRowsPerBand = 16;
+
+#if defined(__APPLE__) && !TARGET_OS_OSX  // iOS
+constexpr int kWorkgroupSize = 8;  // Block size for Metal compute shaders.
+
+int NumGroups(const int size, const int group_size) {  // NOLINT
+  return (size + group_size - 1) / group_size;
+}
+#endif  // iOS
 }  // namespace
 
 namespace mediapipe {
@@ -40,7 +62,10 @@ namespace mediapipe {
 // The luminance of the input image is used to adjust the blending weight,
 // to help preserve image textures.
 //
-// TODO implement cpu support.
+// On iOS the recoloring runs as a Metal compute shader directly on the
+// CVPixelBuffer-backed textures, without going through GL/Metal interop.
+//
+// The CPU path splits the image into row bands that run in parallel.
 //
 // Inputs:
 //   One of the following IMAGE tags:
@@ -95,9 +120,12 @@ class RecolorCalculator : public CalculatorBase {
   mediapipe::RecolorCalculatorOptions::MaskChannel mask_channel_;
 
   bool use_gpu_ = false;
-#if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
+#if defined(__ANDROID__)
   mediapipe::GlCalculatorHelper gpu_helper_;
   GLuint program_ = 0;
+#elif defined(__APPLE__) && !TARGET_OS_OSX  // iOS
+  MPPMetalHelper* gpu_helper_ = nullptr;
+  id<MTLComputePipelineState> pipeline_state_;
 #endif  // __ANDROID__ or iOS
 };
 REGISTER_CALCULATOR(RecolorCalculator);
@@ -134,8 +162,10 @@ REGISTER_CALCULATOR(RecolorCalculator);
     cc->Outputs().Tag("IMAGE").Set<ImageFrame>();
   }
 
-#if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
+#if defined(__ANDROID__)
   MP_RETURN_IF_ERROR(mediapipe::GlCalculatorHelper::UpdateContract(cc));
+#elif defined(__APPLE__) && !TARGET_OS_OSX  // iOS
+  MP_RETURN_IF_ERROR([MPPMetalHelper updateContract:cc]);
 #endif  // __ANDROID__ or iOS
 
   return ::mediapipe::OkStatus();
@@ -146,8 +176,11 @@ REGISTER_CALCULATOR(RecolorCalculator);
 
   if (cc->Inputs().HasTag("IMAGE_GPU")) {
     use_gpu_ = true;
-#if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
+#if defined(__ANDROID__)
     MP_RETURN_IF_ERROR(gpu_helper_.Open(cc));
+#elif defined(__APPLE__) && !TARGET_OS_OSX  // iOS
+    gpu_helper_ = [[MPPMetalHelper alloc] initWithCalculatorContext:cc];
+    RET_CHECK(gpu_helper_);
 #endif  // __ANDROID__ or iOS
   }
 
@@ -158,7 +191,7 @@ REGISTER_CALCULATOR(RecolorCalculator);
 
 ::mediapipe::Status RecolorCalculator::Process(CalculatorContext* cc) {
   if (use_gpu_) {
-#if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
+#if defined(__ANDROID__)
     MP_RETURN_IF_ERROR(
         gpu_helper_.RunInGlContext([this, &cc]() -> ::mediapipe::Status {
           if (!initialized_) {
@@ -168,6 +201,12 @@ REGISTER_CALCULATOR(RecolorCalculator);
           MP_RETURN_IF_ERROR(RenderGpu(cc));
           return ::mediapipe::OkStatus();
         }));
+#elif defined(__APPLE__) && !TARGET_OS_OSX  // iOS
+    if (!initialized_) {
+      MP_RETURN_IF_ERROR(InitGpu(cc));
+      initialized_ = true;
+    }
+    MP_RETURN_IF_ERROR(RenderGpu(cc));
 #endif  // __ANDROID__ or iOS
   } else {
     MP_RETURN_IF_ERROR(RenderCpu(cc));
@@ -176,25 +215,80 @@ REGISTER_CALCULATOR(RecolorCalculator);
 }
 
 ::mediapipe::Status RecolorCalculator::Close(CalculatorContext* cc) {
-#if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
+#if defined(__ANDROID__)
   gpu_helper_.RunInGlContext([this] {
     if (program_) glDeleteProgram(program_);
     program_ = 0;
   });
+#elif defined(__APPLE__) && !TARGET_OS_OSX  // iOS
+  pipeline_state_ = nil;
 #endif  // __ANDROID__ or iOS
 
   return ::mediapipe::OkStatus();
 }
 
 ::mediapipe::Status RecolorCalculator::RenderCpu(CalculatorContext* cc) {
-  return ::mediapipe::UnimplementedError("CPU support is not implemented yet.");
+  if (cc->Inputs().Tag("MASK").IsEmpty()) {
+    return ::mediapipe::OkStatus();
+  }
+  // Get inputs and setup output.
+  const auto& input_frame = cc->Inputs().Tag("IMAGE").Get<ImageFrame>();
+  const auto& mask_frame = cc->Inputs().Tag("MASK").Get<ImageFrame>();
+  const cv::Mat input_mat = formats::MatView(&input_frame);
+  const cv::Mat mask_mat = formats::MatView(&mask_frame);
+  RET_CHECK(input_mat.type() == CV_8UC3 || input_mat.type() == CV_8UC4)
+      << "Only 3 or 4 channel 8-bit input image supported";
+  RET_CHECK_EQ(mask_mat.depth(), CV_8U);
+  RET_CHECK_EQ(input_mat.rows, mask_mat.rows);
+  RET_CHECK_EQ(input_mat.cols, mask_mat.cols);
+
+  int mask_component = 0;
+  if (mask_channel_ == mediapipe::RecolorCalculatorOptions_MaskChannel_ALPHA) {
+    RET_CHECK_EQ(mask_mat.channels(), 4) << "ALPHA mask requires RGBA mask.";
+    mask_component = 3;
+  }
+
+  auto output_frame = absl::make_unique<ImageFrame>(
+      input_frame.Format(), input_mat.cols, input_mat.rows);
+  cv::Mat output_mat = formats::MatView(output_frame.get());
+
+  // Same blend as the shaders: mix towards the opaque recolor color, weighted
+  // by the mask value times the input luminance.
+  const float recolor[4] = {color_[0] * 255.f, color_[1] * 255.f,
+                            color_[2] * 255.f, 255.f};
+  const int num_channels = input_mat.channels();
+  const int mask_channels = mask_mat.channels();
+  ParallelForRows(output_mat.rows, kMinRowsPerBand, [&](int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      const uchar* in_ptr = input_mat.ptr<uchar>(i);
+      const uchar* mask_ptr = mask_mat.ptr<uchar>(i) + mask_component;
+      uchar* out_ptr = output_mat.ptr<uchar>(i);
+      for (int j = 0; j < output_mat.cols; ++j) {
+        const float luminance =
+            (0.299f * in_ptr[0] + 0.587f * in_ptr[1] + 0.114f * in_ptr[2]) /
+            (255.f * 255.f);
+        const float mix_value = *mask_ptr * luminance;
+        for (int c = 0; c < num_channels; ++c) {
+          out_ptr[c] = static_cast<uchar>(
+              in_ptr[c] + (recolor[c] - in_ptr[c]) * mix_value + 0.5f);
+        }
+        in_ptr += num_channels;
+        mask_ptr += mask_channels;
+        out_ptr += num_channels;
+      }
+    }
+  });
+
+  cc->Outputs().Tag("IMAGE").Add(output_frame.release(), cc->InputTimestamp());
+
+  return ::mediapipe::OkStatus();
 }
 
 ::mediapipe::Status RecolorCalculator::RenderGpu(CalculatorContext* cc) {
   if (cc->Inputs().Tag("MASK_GPU").IsEmpty()) {
     return ::mediapipe::OkStatus();
   }
-#if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
+#if defined(__ANDROID__)
   // Get inputs and setup output.
   const Packet& input_packet = cc->Inputs().Tag("IMAGE_GPU").Value();
   const Packet& mask_packet = cc->Inputs().Tag("MASK_GPU").Value();
@@ -233,13 +327,57 @@ REGISTER_CALCULATOR(RecolorCalculator);
   img_tex.Release();
   mask_tex.Release();
   dst_tex.Release();
+#elif defined(__APPLE__) && !TARGET_OS_OSX  // iOS
+  const auto& input_buffer =
+      cc->Inputs().Tag("IMAGE_GPU").Get<mediapipe::GpuBuffer>();
+  const auto& mask_buffer =
+      cc->Inputs().Tag("MASK_GPU").Get<mediapipe::GpuBuffer>();
+  mediapipe::GpuBuffer output_buffer = [gpu_helper_
+      mediapipeGpuBufferWithWidth:input_buffer.width()
+                           height:input_buffer.height()];
+
+  // Run recolor shader on GPU.
+  {
+    id<MTLTexture> img_tex =
+        [gpu_helper_ metalTextureWithGpuBuffer:input_buffer];
+    id<MTLTexture> mask_tex =
+        [gpu_helper_ metalTextureWithGpuBuffer:mask_buffer];
+    id<MTLTexture> dst_tex =
+        [gpu_helper_ metalTextureWithGpuBuffer:output_buffer];
+    const vector_float3 recolor = {color_[0], color_[1], color_[2]};
+
+    id<MTLCommandBuffer> command_buffer = [gpu_helper_ commandBuffer];
+    command_buffer.label = @"RecolorCalculator";
+    id<MTLComputeCommandEncoder> compute_encoder =
+        [command_buffer computeCommandEncoder];
+    [compute_encoder setComputePipelineState:pipeline_state_];
+    [compute_encoder setTexture:img_tex atIndex:0];
+    [compute_encoder setTexture:mask_tex atIndex:1];
+    [compute_encoder setTexture:dst_tex atIndex:2];
+    [compute_encoder setBytes:&recolor length:sizeof(recolor) atIndex:0];
+    MTLSize threads_per_group = MTLSizeMake(kWorkgroupSize, kWorkgroupSize, 1);
+    MTLSize threadgroups =
+        MTLSizeMake(NumGroups(input_buffer.width(), kWorkgroupSize),
+                    NumGroups(input_buffer.height(), kWorkgroupSize), 1);
+    [compute_encoder dispatchThreadgroups:threadgroups
+                    threadsPerThreadgroup:threads_per_group];
+    [compute_encoder endEncoding];
+    [command_buffer commit];
+    [command_buffer waitUntilCompleted];
+  }
+
+  // Send result image in GPU packet.
+  cc->Outputs()
+      .Tag("IMAGE_GPU")
+      .AddPacket(MakePacket<mediapipe::GpuBuffer>(output_buffer)
+                     .At(cc->InputTimestamp()));
 #endif  // __ANDROID__ or iOS
 
   return ::mediapipe::OkStatus();
 }
 
 void RecolorCalculator::GlRender() {
-#if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
+#if defined(__ANDROID__)
   static const GLfloat square_vertices[] = {
       -1.0f, -1.0f,  // bottom left
       1.0f,  -1.0f,  // bottom right
@@ -305,16 +443,6 @@ void RecolorCalculator::GlRender() {
 }
 
 ::mediapipe::Status RecolorCalculator::InitGpu(CalculatorContext* cc) {
-#if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
-  const GLint attr_location[NUM_ATTRIBUTES] = {
-      ATTRIB_VERTEX,
-      ATTRIB_TEXTURE_POSITION,
-  };
-  const GLchar* attr_name[NUM_ATTRIBUTES] = {
-      "position",
-      "texture_coordinate",
-  };
-
   std::string mask_component;
   switch (mask_channel_) {
     case mediapipe::RecolorCalculatorOptions_MaskChannel_UNKNOWN:
@@ -326,6 +454,16 @@ void RecolorCalculator::GlRender() {
       break;
   }
 
+#if defined(__ANDROID__)
+  const GLint attr_location[NUM_ATTRIBUTES] = {
+      ATTRIB_VERTEX,
+      ATTRIB_TEXTURE_POSITION,
+  };
+  const GLchar* attr_name[NUM_ATTRIBUTES] = {
+      "position",
+      "texture_coordinate",
+  };
+
   // A shader to blend a color onto an image where the mask > 0.
   // The blending is based on the input image luminosity.
   const std::string frag_src = R"(
@@ -374,6 +512,56 @@ void RecolorCalculator::GlRender() {
   glUniform1i(glGetUniformLocation(program_, "mask"), 2);
   glUniform3f(glGetUniformLocation(program_, "recolor"), color_[0], color_[1],
               color_[2]);
+#elif defined(__APPLE__) && !TARGET_OS_OSX  // iOS
+  // A compute shader to blend a color onto an image where the mask > 0.
+  // The blending is based on the input image luminosity. The mask may have
+  // a different size than the image, so it is sampled in normalized
+  // coordinates like in the GL shader.
+  const std::string shader_source = R"(
+  #include <metal_stdlib>
+
+  using namespace metal;
+
+  #define MASK_COMPONENT )" + mask_component +
+                                    R"(
+
+  kernel void recolorKernel(
+      texture2d<half, access::read>   frame   [[ texture(0) ]],
+      texture2d<half, access::sample> mask    [[ texture(1) ]],
+      texture2d<half, access::write>  output  [[ texture(2) ]],
+      constant float3&                recolor [[ buffer(0) ]],
+      uint2                           gid     [[ thread_position_in_grid ]]) {
+    if (gid.x >= output.get_width() || gid.y >= output.get_height()) return;
+    constexpr sampler mask_sampler(coord::normalized, address::clamp_to_edge,
+                                   filter::linear);
+    const float2 coord =
+        (float2(gid) + 0.5) / float2(output.get_width(), output.get_height());
+    const half4 weight = mask.sample(mask_sampler, coord);
+    const half4 color1 = frame.read(gid);
+    const half4 color2 = half4(half3(recolor), 1.0h);
+
+    const half luminance = dot(color1.rgb, half3(0.299h, 0.587h, 0.114h));
+    const half mix_value = weight.MASK_COMPONENT * luminance;
+
+    output.write(mix(color1, color2, mix_value), gid);
+  }
+  )";
+
+  id<MTLDevice> device = gpu_helper_.mtlDevice;
+  NSString* library_source =
+      [NSString stringWithUTF8String:shader_source.c_str()];
+  NSError* error = nil;
+  id<MTLLibrary> library =
+      [device newLibraryWithSource:library_source options:nullptr error:&error];
+  RET_CHECK(library != nil) << "Couldn't create shader library "
+                            << [[error localizedDescription] UTF8String];
+  id<MTLFunction> kernel_func = [library newFunctionWithName:@"recolorKernel"];
+  RET_CHECK(kernel_func != nil) << "Couldn't create kernel function.";
+  pipeline_state_ =
+      [device newComputePipelineStateWithFunction:kernel_func error:&error];
+  RET_CHECK(pipeline_state_ != nil)
+      << "Couldn't create pipeline state "
+      << [[error localizedDescription] UTF8String];
 #endif  // __ANDROID__ or iOS
 
   return ::mediapipe::OkStatus();
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <memory>
+#include <string>
 
 #include "mediapipe/calculators/image/set_alpha_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
@@ -24,12 +25,18 @@
 #include "mediapipe/framework/port/opencv_core_inc.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/port/vector.h"
+#include "mediapipe/util/alpha_blend_util.h"
 
-#if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
+#if defined(__ANDROID__)
 #include "mediapipe/gpu/gl_calculator_helper.h"
 #include "mediapipe/gpu/gl_simple_shaders.h"
 #include "mediapipe/gpu/gpu_buffer.h"
 #include "mediapipe/gpu/shader_util.h"
+#elif defined(__APPLE__) && !TARGET_OS_OSX  // iOS
+#import <Metal/Metal.h>
+
+#import "mediapipe/gpu/MPPMetalHelper.h"
+#include "mediapipe/gpu/gpu_buffer.h"
 #endif  // __ANDROID__ or iOS
 
 namespace mediapipe {
@@ -44,9 +51,15 @@ constexpr char kInputFrameTagGpu[] = "IMAGE_GPU";
 constexpr char kInputAlphaTagGpu[] = "ALPHA_GPU";
 constexpr char kOutputFrameTagGpu[] = "IMAGE_GPU";
 
-constexpr int kNumChannelsRGBA = 4;
-
 enum { ATTRIB_VERTEX, ATTRIB_TEXTURE_POSITION, NUM_ATTRIBUTES };
+
+#if defined(__APPLE__) && !TARGET_OS_OSX  // iOS
+constexpr int kWorkgroupSize = 8;  // Block size for Metal compute shaders.
+
+int NumGroups(const int size, const int group_size) {  // NOLINT
+  return (size + group_size - 1) / group_size;
+}
+#endif  // iOS
 }  // namespace
 
 // A calculator for setting the alpha channel of an RGBA image.
@@ -82,6 +95,7 @@ enum { ATTRIB_VERTEX, ATTRIB_TEXTURE_POSITION, NUM_ATTRIBUTES };
 // Notes:
 //   Either alpha_value option or ALPHA (or ALPHA_GPU) must be set.
 //   All CPU inputs must have the same image dimensions and data type.
+//   On iOS the GPU path is a Metal compute shader.
 //
 class SetAlphaCalculator : public CalculatorBase {
  public:
@@ -101,15 +115,19 @@ class SetAlphaCalculator : public CalculatorBase {
 
   ::mediapipe::Status GlSetup(CalculatorContext* cc);
   void GlRender(CalculatorContext* cc);
+  ::mediapipe::Status MetalSetup(CalculatorContext* cc);
 
   mediapipe::SetAlphaCalculatorOptions options_;
   float alpha_value_ = -1.f;
 
   bool use_gpu_ = false;
   bool gpu_initialized_ = false;
-#if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
+#if defined(__ANDROID__)
   mediapipe::GlCalculatorHelper gpu_helper_;
   GLuint program_ = 0;
+#elif defined(__APPLE__) && !TARGET_OS_OSX  // iOS
+  MPPMetalHelper* gpu_helper_ = nullptr;
+  id<MTLComputePipelineState> pipeline_state_;
 #endif  // __ANDROID__ or iOS
 };
 REGISTER_CALCULATOR(SetAlphaCalculator);
@@ -156,8 +174,10 @@ REGISTER_CALCULATOR(SetAlphaCalculator);
     cc->Outputs().Tag(kOutputFrameTag).Set<ImageFrame>();
   }
 
-#if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
+#if defined(__ANDROID__)
   MP_RETURN_IF_ERROR(mediapipe::GlCalculatorHelper::UpdateContract(cc));
+#elif defined(__APPLE__) && !TARGET_OS_OSX  // iOS
+  MP_RETURN_IF_ERROR([MPPMetalHelper updateContract:cc]);
 #endif  // __ANDROID__ or iOS
 
   return ::mediapipe::OkStatus();
@@ -187,8 +207,11 @@ REGISTER_CALCULATOR(SetAlphaCalculator);
     RET_CHECK_FAIL() << "Must use either image mask or options alpha value.";
 
   if (use_gpu_) {
-#if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
+#if defined(__ANDROID__)
     MP_RETURN_IF_ERROR(gpu_helper_.Open(cc));
+#elif defined(__APPLE__) && !TARGET_OS_OSX  // iOS
+    gpu_helper_ = [[MPPMetalHelper alloc] initWithCalculatorContext:cc];
+    RET_CHECK(gpu_helper_);
 #endif
   }
 
@@ -197,7 +220,7 @@ REGISTER_CALCULATOR(SetAlphaCalculator);
 
 ::mediapipe::Status SetAlphaCalculator::Process(CalculatorContext* cc) {
   if (use_gpu_) {
-#if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
+#if defined(__ANDROID__)
     MP_RETURN_IF_ERROR(
         gpu_helper_.RunInGlContext([this, cc]() -> ::mediapipe::Status {
           if (!gpu_initialized_) {
@@ -207,6 +230,12 @@ REGISTER_CALCULATOR(SetAlphaCalculator);
           MP_RETURN_IF_ERROR(RenderGpu(cc));
           return ::mediapipe::OkStatus();
         }));
+#elif defined(__APPLE__) && !TARGET_OS_OSX  // iOS
+    if (!gpu_initialized_) {
+      MP_RETURN_IF_ERROR(MetalSetup(cc));
+      gpu_initialized_ = true;
+    }
+    MP_RETURN_IF_ERROR(RenderGpu(cc));
 #endif  // __ANDROID__ or iOS
   } else {
     MP_RETURN_IF_ERROR(RenderCpu(cc));
@@ -216,11 +245,13 @@ REGISTER_CALCULATOR(SetAlphaCalculator);
 }
 
 ::mediapipe::Status SetAlphaCalculator::Close(CalculatorContext* cc) {
-#if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
+#if defined(__ANDROID__)
   gpu_helper_.RunInGlContext([this] {
     if (program_) glDeleteProgram(program_);
     program_ = 0;
   });
+#elif defined(__APPLE__) && !TARGET_OS_OSX  // iOS
+  pipeline_state_ = nil;
 #endif  // __ANDROID__ or iOS
 
   return ::mediapipe::OkStatus();
@@ -234,9 +265,8 @@ REGISTER_CALCULATOR(SetAlphaCalculator);
   // Setup source image
   const auto& input_frame = cc->Inputs().Tag(kInputFrameTag).Get<ImageFrame>();
   const cv::Mat input_mat = mediapipe::formats::MatView(&input_frame);
-  if (!(input_mat.type() == CV_8UC3 || input_mat.type() == CV_8UC4)) {
-    LOG(ERROR) << "Only 3 or 4 channel 8-bit input image supported";
-  }
+  RET_CHECK(input_mat.type() == CV_8UC3 || input_mat.type() == CV_8UC4)
+      << "Only 3 or 4 channel 8-bit input image supported";
 
   // Setup destination image
   auto output_frame = absl::make_unique<ImageFrame>(
@@ -254,34 +284,11 @@ REGISTER_CALCULATOR(SetAlphaCalculator);
     RET_CHECK_EQ(input_mat.rows, alpha_mat.rows);
     RET_CHECK_EQ(input_mat.cols, alpha_mat.cols);
 
-    for (int i = 0; i < output_mat.rows; ++i) {
-      const uchar* in_ptr = input_mat.ptr<uchar>(i);
-      uchar* alpha_ptr = alpha_mat.ptr<uchar>(i);
-      uchar* out_ptr = output_mat.ptr<uchar>(i);
-      for (int j = 0; j < output_mat.cols; ++j) {
-        const int out_idx = j * kNumChannelsRGBA;
-        const int in_idx = j * input_mat.channels();
-        const int alpha_idx = j * alpha_mat.channels();
-        out_ptr[out_idx + 0] = in_ptr[in_idx + 0];
-        out_ptr[out_idx + 1] = in_ptr[in_idx + 1];
-        out_ptr[out_idx + 2] = in_ptr[in_idx + 2];
-        out_ptr[out_idx + 3] = alpha_ptr[alpha_idx + 0];  // channel 0 of mask
-      }
-    }
+    // Channel 0 of the mask becomes the alpha channel.
+    alpha_blend_util::SetAlphaFromMask(input_mat, alpha_mat, &output_mat);
   } else {
     const uchar alpha_value = std::min(std::max(0.0f, alpha_value_), 255.0f);
-    for (int i = 0; i < output_mat.rows; ++i) {
-      const uchar* in_ptr = input_mat.ptr<uchar>(i);
-      uchar* out_ptr = output_mat.ptr<uchar>(i);
-      for (int j = 0; j < output_mat.cols; ++j) {
-        const int out_idx = j * kNumChannelsRGBA;
-        const int in_idx = j * input_mat.channels();
-        out_ptr[out_idx + 0] = in_ptr[in_idx + 0];
-        out_ptr[out_idx + 1] = in_ptr[in_idx + 1];
-        out_ptr[out_idx + 2] = in_ptr[in_idx + 2];
-        out_ptr[out_idx + 3] = alpha_value;  // use value from options
-      }
-    }
+    alpha_blend_util::SetAlphaFromValue(input_mat, alpha_value, &output_mat);
   }
 
   cc->Outputs()
@@ -295,7 +302,7 @@ REGISTER_CALCULATOR(SetAlphaCalculator);
   if (cc->Inputs().Tag(kInputFrameTagGpu).IsEmpty()) {
     return ::mediapipe::OkStatus();
   }
-#if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
+#if defined(__ANDROID__)
   // Setup source texture.
   const auto& input_frame =
       cc->Inputs().Tag(kInputFrameTagGpu).Get<mediapipe::GpuBuffer>();
@@ -348,13 +355,71 @@ REGISTER_CALCULATOR(SetAlphaCalculator);
   // Cleanup
   input_texture.Release();
   output_texture.Release();
+#elif defined(__APPLE__) && !TARGET_OS_OSX  // iOS
+  const auto& input_frame =
+      cc->Inputs().Tag(kInputFrameTagGpu).Get<mediapipe::GpuBuffer>();
+  RET_CHECK(input_frame.format() == mediapipe::GpuBufferFormat::kBGRA32)
+      << "Only RGBA input image supported";
+  mediapipe::GpuBuffer output_frame =
+      [gpu_helper_ mediapipeGpuBufferWithWidth:input_frame.width()
+                                        height:input_frame.height()
+                                        format:mediapipe::GpuBufferFormat::
+                                                   kBGRA32];
+
+  const bool has_alpha_mask = cc->Inputs().HasTag(kInputAlphaTagGpu) &&
+                              !cc->Inputs().Tag(kInputAlphaTagGpu).IsEmpty();
+
+  // Update image in GPU shader.
+  {
+    id<MTLTexture> input_texture =
+        [gpu_helper_ metalTextureWithGpuBuffer:input_frame];
+    id<MTLTexture> output_texture =
+        [gpu_helper_ metalTextureWithGpuBuffer:output_frame];
+    // Without a mask the shader uses alpha_value, and the input texture is
+    // bound in its place to keep the argument table complete.
+    id<MTLTexture> alpha_texture =
+        has_alpha_mask
+            ? [gpu_helper_
+                  metalTextureWithGpuBuffer:cc->Inputs()
+                                                .Tag(kInputAlphaTagGpu)
+                                                .Get<mediapipe::GpuBuffer>()]
+            : input_texture;
+    const float alpha_value = has_alpha_mask ? -1.f : alpha_value_;
+
+    id<MTLCommandBuffer> command_buffer = [gpu_helper_ commandBuffer];
+    command_buffer.label = @"SetAlphaCalculator";
+    id<MTLComputeCommandEncoder> compute_encoder =
+        [command_buffer computeCommandEncoder];
+    [compute_encoder setComputePipelineState:pipeline_state_];
+    [compute_encoder setTexture:input_texture atIndex:0];
+    [compute_encoder setTexture:alpha_texture atIndex:1];
+    [compute_encoder setTexture:output_texture atIndex:2];
+    [compute_encoder setBytes:&alpha_value
+                       length:sizeof(alpha_value)
+                      atIndex:0];
+    MTLSize threads_per_group = MTLSizeMake(kWorkgroupSize, kWorkgroupSize, 1);
+    MTLSize threadgroups =
+        MTLSizeMake(NumGroups(input_frame.width(), kWorkgroupSize),
+                    NumGroups(input_frame.height(), kWorkgroupSize), 1);
+    [compute_encoder dispatchThreadgroups:threadgroups
+                    threadsPerThreadgroup:threads_per_group];
+    [compute_encoder endEncoding];
+    [command_buffer commit];
+    [command_buffer waitUntilCompleted];
+  }
+
+  // Send out image as GPU packet.
+  cc->Outputs()
+      .Tag(kOutputFrameTagGpu)
+      .AddPacket(MakePacket<mediapipe::GpuBuffer>(output_frame)
+                     .At(cc->InputTimestamp()));
 #endif  // __ANDROID__ or iOS
 
   return ::mediapipe::OkStatus();
 }
 
 void SetAlphaCalculator::GlRender(CalculatorContext* cc) {
-#if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
+#if defined(__ANDROID__)
   static const GLfloat square_vertices[] = {
       -1.0f, -1.0f,  // bottom left
       1.0f,  -1.0f,  // bottom right
@@ -407,7 +472,7 @@ void SetAlphaCalculator::GlRender(CalculatorContext* cc) {
 }
 
 ::mediapipe::Status SetAlphaCalculator::GlSetup(CalculatorContext* cc) {
-#if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
+#if defined(__ANDROID__)
   const GLint attr_location[NUM_ATTRIBUTES] = {
       ATTRIB_VERTEX,
       ATTRIB_TEXTURE_POSITION,
@@ -465,4 +530,52 @@ void SetAlphaCalculator::GlRender(CalculatorContext* cc) {
   return ::mediapipe::OkStatus();
 }
 
+::mediapipe::Status SetAlphaCalculator::MetalSetup(CalculatorContext* cc) {
+#if defined(__APPLE__) && !TARGET_OS_OSX  // iOS
+  // Same as the GL shader, as a compute kernel. The alpha mask is sampled in
+  // normalized coordinates since it may differ in size from the input image.
+  const std::string shader_source = R"(
+  #include <metal_stdlib>
+
+  using namespace metal;
+
+  kernel void setAlphaKernel(
+      texture2d<half, access::read>   input_frame  [[ texture(0) ]],
+      texture2d<half, access::sample> alpha_mask   [[ texture(1) ]],
+      texture2d<half, access::write>  output_frame [[ texture(2) ]],
+      constant float&                 alpha_value  [[ buffer(0) ]],
+      uint2                           gid [[ thread_position_in_grid ]]) {
+    if (gid.x >= output_frame.get_width() ||
+        gid.y >= output_frame.get_height()) return;
+    constexpr sampler mask_sampler(coord::normalized, address::clamp_to_edge,
+                                   filter::linear);
+    const float2 coord = (float2(gid) + 0.5) /
+        float2(output_frame.get_width(), output_frame.get_height());
+    const half3 image_pix = input_frame.read(gid).rgb;
+    half alpha = half(alpha_value);
+    if (alpha_value < 0.0) alpha = alpha_mask.sample(mask_sampler, coord).r;
+    output_frame.write(half4(image_pix, alpha), gid);
+  }
+  )";
+
+  id<MTLDevice> device = gpu_helper_.mtlDevice;
+  NSString* library_source =
+      [NSString stringWithUTF8String:shader_source.c_str()];
+  NSError* error = nil;
+  id<MTLLibrary> library =
+      [device newLibraryWithSource:library_source options:nullptr error:&error];
+  RET_CHECK(library != nil) << "Couldn't create shader library "
+                            << [[error localizedDescription] UTF8String];
+  id<MTLFunction> kernel_func = [library newFunctionWithName:@"setAlphaKernel"];
+  RET_CHECK(kernel_func != nil) << "Couldn't create kernel function.";
+  pipeline_state_ =
+      [device newComputePipelineStateWithFunction:kernel_func error:&error];
+  RET_CHECK(pipeline_state_ != nil)
+      << "Couldn't create pipeline state "
+      << [[error localizedDescription] UTF8String];
+#endif  // iOS
+
+  return ::mediapipe::OkStatus();
+}
+
 }  // namespace mediapipe
@@ -160,8 +160,9 @@ REGISTER_CALCULATOR(SobelEdgesCalculator);
   )";
 
   // shader program
-  GlhCreateProgram(vert_src, frag_src, NUM_ATTRIBUTES,
-                   (const GLchar**)&attr_name[0], attr_location, &program_);
+  GlhCreateCachedProgram(vert_src, frag_src, NUM_ATTRIBUTES,
+                         (const GLchar**)&attr_name[0], attr_location,
+                         &program_);
   RET_CHECK(program_) << "Problem initializing the program.";
   frame_ = glGetUniformLocation(program_, "inputImage");
   pixel_w_ = glGetUniformLocation(program_, "pixelW");
@@ -230,7 +231,7 @@ REGISTER_CALCULATOR(SobelEdgesCalculator);
 
 ::mediapipe::Status SobelEdgesCalculator::GlTeardown() {
   if (program_) {
-    glDeleteProgram(program_);
+    GlhReleaseCachedProgram(program_);
     program_ = 0;
   }
   return ::mediapipe::OkStatus();
@@ -13,8 +13,11 @@
 // limitations under the License.
 
 #include <memory>
+#include <vector>
 
+#include "Eigen/Core"
 #include "mediapipe/calculators/tensorflow/image_frame_to_tensor_calculator.pb.h"
+#include "mediapipe/calculators/tensorflow/tensor_batch_allocator.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/port/ret_check.h"
@@ -30,26 +33,45 @@ namespace tf = tensorflow;
 
 namespace {
 // Convert the ImageFrame into Tensor with floating point value type.
-// The value will be normalized based on mean and stddev.
+// The value will be normalized based on mean and stddev, and the channels
+// reordered as listed in channel_order, unless it is empty. The conversion
+// runs on whole rows of pixels with Eigen, so that it is vectorized.
 std::unique_ptr<tf::Tensor> ImageFrameToNormalizedTensor(
-    const ImageFrame& image_frame, float mean, float stddev) {
+    CalculatorContext* cc, const ImageFrame& image_frame, float mean,
+    float stddev, const std::vector<int>& channel_order) {
+  // Both maps hold one pixel per column and one channel per row.
+  using PixelsMap =
+      Eigen::Map<const Eigen::Array<uint8, Eigen::Dynamic, Eigen::Dynamic>>;
+  using ValuesMap =
+      Eigen::Map<Eigen::Array<float, Eigen::Dynamic, Eigen::Dynamic>>;
+
   const int cols = image_frame.Width();
   const int rows = image_frame.Height();
   const int channels = image_frame.NumberOfChannels();
-  const uint8* pixel = image_frame.PixelData();
-  const int width_padding = image_frame.WidthStep() - cols * channels;
-  auto tensor = ::absl::make_unique<tf::Tensor>(
-      tf::DT_FLOAT, tf::TensorShape({rows, cols, channels}));
-  auto tensor_data = tensor->tensor<float, 3>();
-
-  for (int row = 0; row < rows; ++row) {
-    for (int col = 0; col < cols; ++col) {
-      for (int channel = 0; channel < channels; ++channel) {
-        tensor_data(row, col, channel) = (pixel[channel] - mean) / stddev;
+  const int output_channels =
+      channel_order.empty() ? channels : channel_order.size();
+  auto tensor = NewOutputTensor(cc, tf::DT_FLOAT,
+                                tf::TensorShape({rows, cols, output_channels}));
+
+  // A frame without padding is converted as a single row.
+  const bool is_packed = image_frame.WidthStep() == cols * channels;
+  const int num_rows = is_packed ? 1 : rows;
+  const int row_pixels = is_packed ? rows * cols : cols;
+  for (int row = 0; row < num_rows; ++row) {
+    PixelsMap pixels(image_frame.PixelData() + row * image_frame.WidthStep(),
+                     channels, row_pixels);
+    ValuesMap values(
+        tensor->flat<float>().data() + row * row_pixels * output_channels,
+        output_channels, row_pixels);
+    if (channel_order.empty()) {
+      values = (pixels.cast<float>() - mean) / stddev;
+    } else {
+      for (int channel = 0; channel < output_channels; ++channel) {
+        values.row(channel) =
+            (pixels.row(channel_order[channel]).cast<float>() - mean) /
+            stddev;
       }
-      pixel += channels;
     }
-    pixel += width_padding;
   }
   return tensor;
 }
@@ -70,6 +92,13 @@ std::unique_ptr<tf::Tensor> ImageFrameToNormalizedTensor(
 // The ImageFrame data can be packed or padded. The pixel data will be copied
 // to the Tensor in row-major order.
 //
+// With data_type set to DT_FLOAT, 8-bit pixels are normalized by mean and
+// stddev and optionally reordered by channel_order in a single pass.
+//
+// If the optional BATCH_ALLOCATOR input side packet is given, the output
+// tensors are written directly into the slots of a batch tensor, which a
+// TensorFlowInferenceCalculator sharing the allocator runs without copying.
+//
 // Example config:
 //  node {
 //    calculator: "ImageFrameToTensorCalculator"
@@ -101,6 +130,13 @@ REGISTER_CALCULATOR(ImageFrameToTensorCalculator);
   cc->Outputs().Index(0).Set<tf::Tensor>(
       // Output TensorFlow Tensor.
   );
+  if (cc->InputSidePackets().HasTag("BATCH_ALLOCATOR")) {
+    // Allocates the output tensors as slices of batches for a
+    // TensorFlowInferenceCalculator.
+    cc->InputSidePackets()
+        .Tag("BATCH_ALLOCATOR")
+        .Set<std::shared_ptr<TensorBatchAllocator>>();
+  }
   return ::mediapipe::OkStatus();
 }
 
@@ -129,9 +165,17 @@ REGISTER_CALCULATOR(ImageFrameToTensorCalculator);
     RET_CHECK_EQ(data_type, tf::DT_FLOAT)
         << "Unsupported data type " << data_type;
     RET_CHECK_GT(options_.stddev(), 0.0f);
-    tensor = ImageFrameToNormalizedTensor(video_frame, options_.mean(),
-                                          options_.stddev());
+    const std::vector<int> channel_order(options_.channel_order().begin(),
+                                         options_.channel_order().end());
+    for (int channel : channel_order) {
+      RET_CHECK(channel >= 0 && channel < video_frame.NumberOfChannels())
+          << "Invalid channel in channel_order: " << channel;
+    }
+    tensor = ImageFrameToNormalizedTensor(cc, video_frame, options_.mean(),
+                                          options_.stddev(), channel_order);
   } else {
+    RET_CHECK_EQ(options_.channel_order_size(), 0)
+        << "channel_order requires data_type to be set.";
     const int height = video_frame.Height();
     const int width = video_frame.Width();
     const int num_channels = video_frame.NumberOfChannels();
@@ -158,7 +202,7 @@ REGISTER_CALCULATOR(ImageFrameToTensorCalculator);
         << ")";
 
     // Create the output tensor.
-    tensor = ::absl::make_unique<tf::Tensor>(data_type, tensor_shape);
+    tensor = NewOutputTensor(cc, data_type, tensor_shape);
 
     // Copy pixel data from the ImageFrame to the tensor.
     if (data_type == tf::DT_UINT8) {
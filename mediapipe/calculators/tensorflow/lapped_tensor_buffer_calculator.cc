@@ -12,6 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <cstring>
 #include <vector>
 
 #include "absl/memory/memory.h"
@@ -20,6 +22,7 @@
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_macros.h"
 #include "mediapipe/framework/profiler/circular_buffer.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
@@ -46,6 +49,12 @@ namespace tf = tensorflow;
 // output tensor will have the timestamp of the first input.). This behavior can
 // be adjusted by the timestamp_offset option.
 //
+// Input tensors of the same shape and a memcpy-able type are appended to a
+// preallocated window as they arrive, so that each output is a slice of the
+// window rather than a new concatenation of all buffer_size inputs. The window
+// holds several outputs' worth of inputs, and only the inputs overlapping the
+// next output are copied when it is reallocated.
+//
 // Example config:
 // node {
 //   calculator: "LappedTensorBufferCalculator"
@@ -71,7 +80,28 @@ class LappedTensorBufferCalculator : public CalculatorBase {
   // options.
   ::mediapipe::Status AddBatchDimension(tf::Tensor* input_tensor);
 
+  // Copies the input tensor into the next slot of window_, starting a new
+  // window when it is full or cannot hold the input tensor.
+  void AppendToWindow(const tf::Tensor& input_tensor);
+
+  // Returns the latest buffer_size inputs as one tensor: a slice of window_
+  // if possible, or their concatenation otherwise.
+  ::mediapipe::Status GetLappedTensor(tf::Tensor* lapped_tensor);
+
+  // The number of outputs' worth of inputs held by each window.
+  static constexpr int kWindowCapacityFactor = 4;
+
   int steps_until_output_;
+  // The preallocated window holding the latest inputs contiguously, sliced
+  // into the outputs. Slices which were output keep the window alive, so a
+  // new window is allocated rather than overwriting it.
+  tf::Tensor window_;
+  // The shape of each input tensor in window_.
+  tf::TensorShape window_input_shape_;
+  // The number of input tensors written into window_.
+  int window_size_ = 0;
+  // The number of latest inputs held in window_, at most buffer_size.
+  int window_valid_inputs_ = 0;
   std::unique_ptr<CircularBuffer<Timestamp>> timestamp_buffer_;
   std::unique_ptr<CircularBuffer<tf::Tensor>> buffer_;
   LappedTensorBufferCalculatorOptions options_;
@@ -117,16 +147,13 @@ REGISTER_CALCULATOR(LappedTensorBufferCalculator);
     RET_CHECK_OK(AddBatchDimension(&input_tensor));
   }
   buffer_->push_back(input_tensor);
+  AppendToWindow(input_tensor);
   timestamp_buffer_->push_back(cc->InputTimestamp());
   --steps_until_output_;
 
   if (steps_until_output_ <= 0) {
     auto concatenated = ::absl::make_unique<tf::Tensor>();
-
-    const tf::Status concat_status = tf::tensor::Concat(
-        std::vector<tf::Tensor>(buffer_->begin(), buffer_->end()),
-        concatenated.get());
-    RET_CHECK(concat_status.ok()) << concat_status.ToString();
+    MP_RETURN_IF_ERROR(GetLappedTensor(concatenated.get()));
 
     cc->Outputs().Index(0).Add(
         concatenated.release(),
@@ -151,4 +178,70 @@ REGISTER_CALCULATOR(LappedTensorBufferCalculator);
   return ::mediapipe::OkStatus();
 }
 
+void LappedTensorBufferCalculator::AppendToWindow(
+    const tf::Tensor& input_tensor) {
+  // Inputs whose size is not a multiple of the alignment would only give
+  // unaligned slices, which have to be copied anyway.
+  if (!tf::DataTypeCanUseMemcpy(input_tensor.dtype()) ||
+      input_tensor.dims() == 0 ||
+      (EIGEN_MAX_ALIGN_BYTES > 0 &&
+       input_tensor.TotalBytes() % EIGEN_MAX_ALIGN_BYTES != 0)) {
+    window_valid_inputs_ = 0;
+    return;
+  }
+  if (!window_.IsInitialized() || window_.dtype() != input_tensor.dtype() ||
+      window_input_shape_ != input_tensor.shape()) {
+    window_ = tf::Tensor();
+    window_input_shape_ = input_tensor.shape();
+    window_size_ = 0;
+    window_valid_inputs_ = 0;
+  }
+  const int capacity = kWindowCapacityFactor * options_.buffer_size();
+  const size_t input_bytes = input_tensor.TotalBytes();
+  if (!window_.IsInitialized() || window_size_ == capacity) {
+    tf::TensorShape window_shape(window_input_shape_);
+    window_shape.set_dim(0, window_shape.dim_size(0) * capacity);
+    tf::Tensor new_window(input_tensor.dtype(), window_shape);
+    // Carries over the inputs overlapping the next output.
+    const int num_kept =
+        std::min(window_valid_inputs_, options_.buffer_size() - 1);
+    if (num_kept > 0) {
+      std::memcpy(const_cast<char*>(new_window.tensor_data().data()),
+                  window_.tensor_data().data() +
+                      (window_size_ - num_kept) * input_bytes,
+                  num_kept * input_bytes);
+    }
+    window_ = new_window;
+    window_size_ = num_kept;
+    window_valid_inputs_ = num_kept;
+  }
+  // The slot has not been output yet, so it can be written in place.
+  std::memcpy(const_cast<char*>(window_.tensor_data().data()) +
+                  window_size_ * input_bytes,
+              input_tensor.tensor_data().data(), input_bytes);
+  ++window_size_;
+  window_valid_inputs_ =
+      std::min(window_valid_inputs_ + 1, options_.buffer_size());
+}
+
+::mediapipe::Status LappedTensorBufferCalculator::GetLappedTensor(
+    tf::Tensor* lapped_tensor) {
+  if (window_valid_inputs_ == options_.buffer_size()) {
+    const int64 input_rows = window_input_shape_.dim_size(0);
+    *lapped_tensor =
+        window_.Slice((window_size_ - options_.buffer_size()) * input_rows,
+                      window_size_ * input_rows);
+    // Slices which are not aligned for Eigen have to be copied.
+    if (!lapped_tensor->IsAligned()) {
+      *lapped_tensor = tf::tensor::DeepCopy(*lapped_tensor);
+    }
+    return ::mediapipe::OkStatus();
+  }
+  const tf::Status concat_status = tf::tensor::Concat(
+      std::vector<tf::Tensor>(buffer_->begin(), buffer_->end()),
+      lapped_tensor);
+  RET_CHECK(concat_status.ok()) << concat_status.ToString();
+  return ::mediapipe::OkStatus();
+}
+
 }  // namespace mediapipe
@@ -236,5 +236,43 @@ TEST_F(LappedTensorBufferCalculatorTest, OneToThreeBatchTimestampOffset) {
   }
 }
 
+TEST_F(LappedTensorBufferCalculatorTest, OutputsSlicesOfWindow) {
+  int buffer_size = 3;
+  int overlap = 2;
+  bool add_dim = true;
+  SetUpCalculator(buffer_size, overlap, add_dim, 0);
+  // Enough inputs to fill several windows. Each input is 64 floats, so that
+  // the output slices are aligned.
+  int num_timesteps = 40;
+  int input_size = 64;
+  for (int i = 0; i < num_timesteps; ++i) {
+    auto input = ::absl::make_unique<tensorflow::Tensor>(
+        tensorflow::DT_FLOAT, tensorflow::TensorShape({input_size}));
+    for (int k = 0; k < input_size; ++k) {
+      input->tensor<float, 1>()(k) = i * input_size + k;
+    }
+    runner_->MutableInputs()->Index(0).packets.push_back(
+        Adopt(input.release()).At(Timestamp(i)));
+  }
+  ASSERT_TRUE(runner_->Run().ok());
+
+  const std::vector<Packet>& output_packets =
+      runner_->Outputs().Index(0).packets;
+  ASSERT_EQ(num_timesteps - buffer_size + 1, output_packets.size());
+  for (int i = 0; i < num_timesteps - buffer_size + 1; ++i) {
+    const tf::Tensor& output = output_packets[i].Get<tf::Tensor>();
+    ASSERT_EQ(tf::TensorShape({buffer_size, input_size}), output.shape());
+    for (int j = 0; j < buffer_size; ++j) {
+      for (int k = 0; k < input_size; ++k) {
+        ASSERT_NEAR((i + j) * input_size + k, output.tensor<float, 2>()(j, k),
+                    0.0001);
+      }
+    }
+  }
+  // Consecutive outputs share the window instead of being concatenated.
+  EXPECT_TRUE(output_packets[0].Get<tf::Tensor>().SharesBufferWith(
+      output_packets[1].Get<tf::Tensor>()));
+}
+
 }  // namespace
 }  // namespace mediapipe
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "mediapipe/calculators/tensorflow/matrix_to_tensor_calculator_options.pb.h"
+#include "mediapipe/calculators/tensorflow/tensor_batch_allocator.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/matrix.h"
 #include "mediapipe/framework/formats/time_series_header.pb.h"
@@ -102,6 +103,13 @@ REGISTER_CALCULATOR(MatrixToTensorCalculator);
       // TimeSeriesHeader as the input (or no header if the input has no
       // header).
   );
+  if (cc->InputSidePackets().HasTag("BATCH_ALLOCATOR")) {
+    // Allocates the output tensors as slices of batches for a
+    // TensorFlowInferenceCalculator.
+    cc->InputSidePackets()
+        .Tag("BATCH_ALLOCATOR")
+        .Set<std::shared_ptr<TensorBatchAllocator>>();
+  }
   return ::mediapipe::OkStatus();
 }
 
@@ -130,7 +138,7 @@ REGISTER_CALCULATOR(MatrixToTensorCalculator);
   } else {
     tensor_shape = tf::TensorShape({matrix.rows(), matrix.cols()});
   }
-  auto tensor = ::absl::make_unique<tf::Tensor>(tf::DT_FLOAT, tensor_shape);
+  auto tensor = NewOutputTensor(cc, tf::DT_FLOAT, tensor_shape);
 
   float* tensor_data = tensor->flat<float>().data();
   if (options_.transpose()) {
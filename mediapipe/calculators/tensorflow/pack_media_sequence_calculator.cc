@@ -61,6 +61,11 @@ namespace mpms = ::mediapipe::mediasequence;
 // each stream, which allows for multiple image streams to be included. However,
 // the default names are suppored by more tools.
 //
+// By default, the SequenceExample is output once, when the calculator is
+// closed. For long clips, max_timestamps_per_chunk instead outputs it as a
+// series of partial SequenceExamples on the output stream, so that memory use
+// does not grow with the length of the clip.
+//
 // Example config:
 // node {
 //   calculator: "PackMediaSequenceCalculator"
@@ -162,6 +167,13 @@ class PackMediaSequenceCalculator : public CalculatorBase {
           .Tag(kSequenceExampleTag)
           .Set<tf::SequenceExample>();
     }
+    if (cc->Options<PackMediaSequenceCalculatorOptions>()
+            .max_timestamps_per_chunk() > 0) {
+      RET_CHECK(cc->Outputs().HasTag(kSequenceExampleTag) &&
+                !cc->OutputSidePackets().HasTag(kSequenceExampleTag))
+          << "Chunked output requires the output stream and not the output "
+             "side packet.";
+    }
     return ::mediapipe::OkStatus();
   }
 
@@ -229,7 +241,9 @@ class PackMediaSequenceCalculator : public CalculatorBase {
       }
     }
 
-    if (cc->Outputs().HasTag(kSequenceExampleTag)) {
+    if (cc->Outputs().HasTag(kSequenceExampleTag) &&
+        cc->Options<PackMediaSequenceCalculatorOptions>()
+                .max_timestamps_per_chunk() <= 0) {
       cc->Outputs()
           .Tag(kSequenceExampleTag)
           .SetNextTimestampBound(Timestamp::Max());
@@ -253,13 +267,36 @@ class PackMediaSequenceCalculator : public CalculatorBase {
     }
   }
 
-  ::mediapipe::Status Close(CalculatorContext* cc) override {
+  ::mediapipe::Status ReconcileSequence(CalculatorContext* cc) {
     auto& options = cc->Options<PackMediaSequenceCalculatorOptions>();
     if (options.reconcile_metadata()) {
       RET_CHECK_OK(mpms::ReconcileMetadata(
           options.reconcile_bbox_annotations(),
           options.reconcile_region_annotations(), sequence_.get()));
     }
+    return ::mediapipe::OkStatus();
+  }
+
+  // Outputs the data packed since the previous chunk at "timestamp", and
+  // starts the next chunk with the same context.
+  ::mediapipe::Status OutputChunk(CalculatorContext* cc, Timestamp timestamp) {
+    // The context is copied before it is reconciled with this chunk's
+    // feature lists.
+    auto next_sequence = ::absl::make_unique<tf::SequenceExample>();
+    *next_sequence->mutable_context() = sequence_->context();
+    MP_RETURN_IF_ERROR(ReconcileSequence(cc));
+    cc->Outputs().Tag(kSequenceExampleTag).Add(sequence_.release(), timestamp);
+    sequence_ = std::move(next_sequence);
+    num_chunk_timestamps_ = 0;
+    ++num_chunks_;
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Close(CalculatorContext* cc) override {
+    auto& options = cc->Options<PackMediaSequenceCalculatorOptions>();
+    if (options.max_timestamps_per_chunk() <= 0) {
+      MP_RETURN_IF_ERROR(ReconcileSequence(cc));
+    }
 
     if (options.output_only_if_all_present()) {
       ::mediapipe::Status status = VerifySequence();
@@ -269,6 +306,17 @@ class PackMediaSequenceCalculator : public CalculatorBase {
       }
     }
 
+    if (options.max_timestamps_per_chunk() > 0) {
+      if (num_chunk_timestamps_ > 0 || num_chunks_ == 0) {
+        MP_RETURN_IF_ERROR(OutputChunk(
+            cc, last_timestamp_ == Timestamp::Unset()
+                    ? Timestamp::PostStream()
+                    : last_timestamp_.NextAllowedInStream()));
+      }
+      sequence_.reset();
+      return ::mediapipe::OkStatus();
+    }
+
     if (cc->OutputSidePackets().HasTag(kSequenceExampleTag)) {
       cc->OutputSidePackets()
           .Tag(kSequenceExampleTag)
@@ -435,11 +483,25 @@ class PackMediaSequenceCalculator : public CalculatorBase {
         }
       }
     }
+
+    const int max_timestamps_per_chunk =
+        cc->Options<PackMediaSequenceCalculatorOptions>()
+            .max_timestamps_per_chunk();
+    if (max_timestamps_per_chunk > 0) {
+      last_timestamp_ = cc->InputTimestamp();
+      if (++num_chunk_timestamps_ >= max_timestamps_per_chunk) {
+        MP_RETURN_IF_ERROR(OutputChunk(cc, cc->InputTimestamp()));
+      }
+    }
     return ::mediapipe::OkStatus();
   }
 
   std::unique_ptr<tf::SequenceExample> sequence_;
   std::map<std::string, bool> features_present_;
+  // The state of the chunked output, see max_timestamps_per_chunk.
+  int num_chunk_timestamps_ = 0;
+  int num_chunks_ = 0;
+  Timestamp last_timestamp_ = Timestamp::Unset();
 };
 REGISTER_CALCULATOR(PackMediaSequenceCalculator);
 
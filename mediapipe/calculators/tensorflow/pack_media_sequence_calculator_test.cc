@@ -43,7 +43,8 @@ class PackMediaSequenceCalculatorTest : public ::testing::Test {
   void SetUpCalculator(const std::vector<std::string>& input_streams,
                        const tf::Features& features,
                        bool output_only_if_all_present,
-                       bool replace_instead_of_append) {
+                       bool replace_instead_of_append,
+                       int max_timestamps_per_chunk = 0) {
     CalculatorGraphConfig::Node config;
     config.set_calculator("PackMediaSequenceCalculator");
     config.add_input_side_packet("SEQUENCE_EXAMPLE:input_sequence");
@@ -56,6 +57,7 @@ class PackMediaSequenceCalculatorTest : public ::testing::Test {
     *options->mutable_context_feature_map() = features;
     options->set_output_only_if_all_present(output_only_if_all_present);
     options->set_replace_data_instead_of_append(replace_instead_of_append);
+    options->set_max_timestamps_per_chunk(max_timestamps_per_chunk);
     runner_ = ::absl::make_unique<CalculatorRunner>(config);
   }
 
@@ -194,6 +196,52 @@ TEST_F(PackMediaSequenceCalculatorTest, PacksTwoFloatLists) {
   }
 }
 
+TEST_F(PackMediaSequenceCalculatorTest, PacksFloatListsInChunks) {
+  SetUpCalculator({"FLOAT_FEATURE_TEST:test"}, {}, false, true, 2);
+  auto input_sequence = ::absl::make_unique<tf::SequenceExample>();
+  std::string test_video_id = "test_video_id";
+  mpms::SetClipMediaId(test_video_id, input_sequence.get());
+
+  int num_timesteps = 5;
+  for (int i = 0; i < num_timesteps; ++i) {
+    auto vf_ptr = ::absl::make_unique<std::vector<float>>(2, 2 << i);
+    runner_->MutableInputs()
+        ->Tag("FLOAT_FEATURE_TEST")
+        .packets.push_back(Adopt(vf_ptr.release()).At(Timestamp(i)));
+  }
+
+  runner_->MutableSidePackets()->Tag("SEQUENCE_EXAMPLE") =
+      Adopt(input_sequence.release());
+
+  MP_ASSERT_OK(runner_->Run());
+
+  // Chunks of 2, 2 and 1 timesteps, the last one output after the last input.
+  const std::vector<Packet>& output_packets =
+      runner_->Outputs().Tag("SEQUENCE_EXAMPLE").packets;
+  ASSERT_EQ(3, output_packets.size());
+  const std::vector<int> chunk_sizes = {2, 2, 1};
+  const std::vector<int> chunk_timestamps = {1, 3, 5};
+  int timestep = 0;
+  for (int chunk = 0; chunk < output_packets.size(); ++chunk) {
+    const tf::SequenceExample& output_sequence =
+        output_packets[chunk].Get<tf::SequenceExample>();
+    EXPECT_EQ(Timestamp(chunk_timestamps[chunk]),
+              output_packets[chunk].Timestamp());
+    ASSERT_EQ(test_video_id, mpms::GetClipMediaId(output_sequence));
+    ASSERT_EQ(chunk_sizes[chunk],
+              mpms::GetFeatureTimestampSize("TEST", output_sequence));
+    ASSERT_EQ(chunk_sizes[chunk],
+              mpms::GetFeatureFloatsSize("TEST", output_sequence));
+    for (int i = 0; i < chunk_sizes[chunk]; ++i, ++timestep) {
+      ASSERT_EQ(timestep,
+                mpms::GetFeatureTimestampAt("TEST", output_sequence, i));
+      ASSERT_THAT(
+          mpms::GetFeatureFloatsAt("TEST", output_sequence, i),
+          ::testing::ElementsAreArray(std::vector<float>(2, 2 << timestep)));
+    }
+  }
+}
+
 TEST_F(PackMediaSequenceCalculatorTest, PacksAdditionalContext) {
   tf::Features context;
   (*context.mutable_feature())["TEST"].mutable_bytes_list()->add_value("YES");
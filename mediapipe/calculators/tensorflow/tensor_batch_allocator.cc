@@ -0,0 +1,104 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensorflow/tensor_batch_allocator.h"
+
+#include "absl/memory/memory.h"
+
+namespace mediapipe {
+
+namespace tf = ::tensorflow;
+
+std::unique_ptr<tf::Tensor> TensorBatchAllocator::Allocate(
+    const std::string& stream, tf::DataType dtype,
+    const tf::TensorShape& shape) {
+  if (batch_size_ <= 1 || !tf::DataTypeCanUseMemcpy(dtype)) {
+    return absl::make_unique<tf::Tensor>(dtype, shape);
+  }
+  tf::TensorShape batch_shape(shape);
+  batch_shape.InsertDim(0, batch_size_);
+
+  absl::MutexLock lock(&mutex_);
+  StreamBatch& stream_batch = stream_batches_[stream];
+  if (stream_batch.num_allocated == 0 ||
+      stream_batch.tensor.dtype() != dtype ||
+      stream_batch.tensor.shape() != batch_shape) {
+    stream_batch.tensor = tf::Tensor(dtype, batch_shape);
+    stream_batch.num_allocated = 0;
+  }
+  const int index = stream_batch.num_allocated++;
+  tf::Tensor slice = stream_batch.tensor.Slice(index, index + 1);
+  if (stream_batch.num_allocated == batch_size_) {
+    filled_batches_.push_back(stream_batch.tensor);
+    if (filled_batches_.size() > kMaxFilledBatches) {
+      filled_batches_.pop_front();
+    }
+    stream_batch.num_allocated = 0;
+  }
+  // Slices of rows that are not a multiple of the alignment cannot be
+  // accessed through Eigen, so such a batch is never taken.
+  if (!slice.IsAligned()) {
+    return absl::make_unique<tf::Tensor>(dtype, shape);
+  }
+  auto tensor = absl::make_unique<tf::Tensor>();
+  CHECK(tensor->CopyFrom(slice, shape));
+  return tensor;
+}
+
+bool TensorBatchAllocator::TakeBatch(const std::vector<tf::Tensor>& tensors,
+                                     tf::Tensor* batch) {
+  if (tensors.size() != batch_size_ || batch_size_ <= 1 ||
+      !tf::DataTypeCanUseMemcpy(tensors[0].dtype()) ||
+      tensors[0].dims() == 0) {
+    return false;
+  }
+  absl::MutexLock lock(&mutex_);
+  for (auto it = filled_batches_.begin(); it != filled_batches_.end(); ++it) {
+    if (!tensors[0].SharesBufferWith(*it) ||
+        tensors[0].dtype() != it->dtype()) {
+      continue;
+    }
+    const size_t slice_bytes = it->TotalBytes() / batch_size_;
+    const char* base = it->tensor_data().data();
+    for (int i = 0; i < tensors.size(); ++i) {
+      if (tensors[i].shape() != tensors[0].shape() ||
+          tensors[i].TotalBytes() != slice_bytes ||
+          tensors[i].tensor_data().data() != base + i * slice_bytes) {
+        return false;
+      }
+    }
+    tf::TensorShape batch_shape(tensors[0].shape());
+    batch_shape.set_dim(0, batch_shape.dim_size(0) * batch_size_);
+    if (!batch->CopyFrom(*it, batch_shape)) {
+      return false;
+    }
+    filled_batches_.erase(it);
+    return true;
+  }
+  return false;
+}
+
+std::unique_ptr<tf::Tensor> NewOutputTensor(CalculatorContext* cc,
+                                            tf::DataType dtype,
+                                            const tf::TensorShape& shape) {
+  if (cc->InputSidePackets().HasTag("BATCH_ALLOCATOR")) {
+    return cc->InputSidePackets()
+        .Tag("BATCH_ALLOCATOR")
+        .Get<std::shared_ptr<TensorBatchAllocator>>()
+        ->Allocate(cc->NodeName(), dtype, shape);
+  }
+  return absl::make_unique<tf::Tensor>(dtype, shape);
+}
+
+}  // namespace mediapipe
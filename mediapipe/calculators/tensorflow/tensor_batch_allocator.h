@@ -0,0 +1,90 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_TENSORFLOW_CALCULATORS_TENSOR_BATCH_ALLOCATOR_H_
+#define MEDIAPIPE_TENSORFLOW_CALCULATORS_TENSOR_BATCH_ALLOCATOR_H_
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+
+namespace mediapipe {
+
+// Allocates the tensors of a stream as consecutive slices of one batch
+// tensor, so that TensorFlowInferenceCalculator can run a batch of them
+// without concatenating them into a new tensor.
+//
+// The allocator is shared through a BATCH_ALLOCATOR input side packet of type
+// std::shared_ptr<TensorBatchAllocator> between the calculators producing the
+// tensors, such as VectorFloatToTensorCalculator, and the
+// TensorFlowInferenceCalculator batching them, which must use the same
+// batch_size.
+class TensorBatchAllocator {
+ public:
+  explicit TensorBatchAllocator(int batch_size) : batch_size_(batch_size) {}
+
+  int batch_size() const { return batch_size_; }
+
+  // Returns a tensor of "dtype" and "shape" to be filled and output on
+  // "stream". Tensors of the same stream, dtype and shape are slices of one
+  // batch tensor, until batch_size of them have been allocated. Falls back to
+  // a separate tensor when a slice would not be aligned, or "dtype" cannot be
+  // memcpy'd.
+  std::unique_ptr<tensorflow::Tensor> Allocate(
+      const std::string& stream, tensorflow::DataType dtype,
+      const tensorflow::TensorShape& shape) LOCKS_EXCLUDED(mutex_);
+
+  // If "tensors" are, in order, all the slices of one batch tensor allocated
+  // by Allocate(), sets "batch" to that tensor shaped like the concatenation
+  // of "tensors" along their 0th dimension, and returns true. Otherwise,
+  // returns false and the caller should concatenate "tensors" itself.
+  bool TakeBatch(const std::vector<tensorflow::Tensor>& tensors,
+                 tensorflow::Tensor* batch) LOCKS_EXCLUDED(mutex_);
+
+ private:
+  // The batch tensor currently being handed out for a stream.
+  struct StreamBatch {
+    tensorflow::Tensor tensor;
+    int num_allocated = 0;
+  };
+
+  // The number of fully allocated batch tensors kept for TakeBatch().
+  // Batch tensors that are not taken, because their slices were batched
+  // differently, are released once this many newer ones have been filled.
+  static constexpr int kMaxFilledBatches = 4;
+
+  const int batch_size_;
+  absl::Mutex mutex_;
+  std::map<std::string, StreamBatch> stream_batches_ GUARDED_BY(mutex_);
+  std::deque<tensorflow::Tensor> filled_batches_ GUARDED_BY(mutex_);
+};
+
+// Returns a new tensor of "dtype" and "shape" for the calculator to output on
+// its only output stream. The tensor is allocated from the BATCH_ALLOCATOR
+// input side packet if the calculator has one.
+std::unique_ptr<tensorflow::Tensor> NewOutputTensor(
+    CalculatorContext* cc, tensorflow::DataType dtype,
+    const tensorflow::TensorShape& shape);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_TENSORFLOW_CALCULATORS_TENSOR_BATCH_ALLOCATOR_H_
@@ -0,0 +1,91 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensorflow/tensor_batch_allocator.h"
+
+#include <vector>
+
+#include "mediapipe/framework/port/gtest.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+
+namespace mediapipe {
+
+namespace tf = ::tensorflow;
+
+namespace {
+
+// 64 floats, so that the slices are aligned for any Eigen alignment.
+constexpr int kSize = 64;
+
+std::vector<tf::Tensor> AllocateBatch(TensorBatchAllocator* allocator,
+                                      int num_tensors) {
+  std::vector<tf::Tensor> tensors;
+  for (int i = 0; i < num_tensors; ++i) {
+    auto tensor =
+        allocator->Allocate("stream", tf::DT_FLOAT, tf::TensorShape({kSize}));
+    auto values = tensor->flat<float>();
+    for (int j = 0; j < kSize; ++j) {
+      values(j) = i * kSize + j;
+    }
+    // Add the batch dimension like TensorFlowInferenceCalculator.
+    tf::Tensor batch_element;
+    EXPECT_TRUE(batch_element.CopyFrom(*tensor, tf::TensorShape({1, kSize})));
+    tensors.push_back(batch_element);
+  }
+  return tensors;
+}
+
+TEST(TensorBatchAllocatorTest, TakesFullBatch) {
+  TensorBatchAllocator allocator(3);
+  std::vector<tf::Tensor> tensors = AllocateBatch(&allocator, 3);
+
+  tf::Tensor batch;
+  ASSERT_TRUE(allocator.TakeBatch(tensors, &batch));
+  EXPECT_EQ(tf::TensorShape({3, kSize}), batch.shape());
+  EXPECT_TRUE(batch.SharesBufferWith(tensors[0]));
+  auto values = batch.matrix<float>();
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < kSize; ++j) {
+      EXPECT_EQ(i * kSize + j, values(i, j));
+    }
+  }
+
+  // A batch can only be taken once.
+  EXPECT_FALSE(allocator.TakeBatch(tensors, &batch));
+}
+
+TEST(TensorBatchAllocatorTest, RejectsPartialOrReorderedBatch) {
+  TensorBatchAllocator allocator(3);
+  std::vector<tf::Tensor> tensors = AllocateBatch(&allocator, 3);
+
+  tf::Tensor batch;
+  EXPECT_FALSE(allocator.TakeBatch({tensors[0], tensors[1]}, &batch));
+  EXPECT_FALSE(
+      allocator.TakeBatch({tensors[1], tensors[0], tensors[2]}, &batch));
+  EXPECT_TRUE(allocator.TakeBatch(tensors, &batch));
+}
+
+TEST(TensorBatchAllocatorTest, StartsNewBatchOnShapeChange) {
+  TensorBatchAllocator allocator(2);
+  auto first =
+      allocator.Allocate("stream", tf::DT_FLOAT, tf::TensorShape({kSize}));
+  auto second =
+      allocator.Allocate("stream", tf::DT_FLOAT, tf::TensorShape({2 * kSize}));
+  EXPECT_FALSE(first->SharesBufferWith(*second));
+}
+
+}  // namespace
+}  // namespace mediapipe
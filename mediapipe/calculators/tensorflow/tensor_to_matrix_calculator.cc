@@ -15,9 +15,13 @@
 // Calculator converts from one-dimensional Tensor of DT_FLOAT to Matrix
 // OR from (batched) two-dimensional Tensor of DT_FLOAT to Matrix.
 
+#include <memory>
+#include <utility>
+
 #include "mediapipe/calculators/tensorflow/tensor_to_matrix_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/matrix.h"
+#include "mediapipe/framework/formats/matrix_view.h"
 #include "mediapipe/framework/formats/time_series_header.pb.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
@@ -31,6 +35,7 @@ namespace tf = ::tensorflow;
 namespace {
 
 constexpr char kMatrix[] = "MATRIX";
+constexpr char kMatrixView[] = "MATRIX_VIEW";
 constexpr char kTensor[] = "TENSOR";
 constexpr char kReference[] = "REFERENCE";
 
@@ -77,6 +82,10 @@ constexpr char kReference[] = "REFERENCE";
 //   output_stream: "MATRIX:matrix"
 // }
 //
+// The output can instead be a MatrixView, with the MATRIX_VIEW tag. The
+// MatrixView aliases the values of the input Tensor, whose row-major layout
+// matches the column-major layout of the output Matrix, so no values are
+// copied.
 //
 // This calculator produces a TimeSeriesHeader header on its output stream iff
 // an input stream is supplied with the REFERENCE tag and that stream has a
@@ -144,9 +153,15 @@ REGISTER_CALCULATOR(TensorToMatrixCalculator);
   }
   RET_CHECK_EQ(cc->Outputs().NumEntries(), 1)
       << "Only one output stream is supported.";
-  cc->Outputs().Tag(kMatrix).Set<Matrix>(
-      // Output Matrix.
-  );
+  if (cc->Outputs().HasTag(kMatrixView)) {
+    cc->Outputs().Tag(kMatrixView).Set<MatrixView>(
+        // Output MatrixView aliasing the input Tensor.
+    );
+  } else {
+    cc->Outputs().Tag(kMatrix).Set<Matrix>(
+        // Output Matrix.
+    );
+  }
   return ::mediapipe::OkStatus();
 }
 
@@ -181,7 +196,9 @@ REGISTER_CALCULATOR(TensorToMatrixCalculator);
       }
     }
     header_ = *input_header;
-    cc->Outputs().Tag(kMatrix).SetHeader(Adopt(input_header.release()));
+    const char* output_tag =
+        cc->Outputs().HasTag(kMatrixView) ? kMatrixView : kMatrix;
+    cc->Outputs().Tag(output_tag).SetHeader(Adopt(input_header.release()));
   }
   cc->SetOffset(TimestampDiff(0));
   return ::mediapipe::OkStatus();
@@ -217,6 +234,16 @@ REGISTER_CALCULATOR(TensorToMatrixCalculator);
         << "The number of samples at runtime does not match the header.";
     ;
   }
+  if (cc->Outputs().HasTag(kMatrixView)) {
+    // The view shares the buffer of a copy of the input Tensor, which keeps
+    // the values alive without copying them.
+    auto owner = std::make_shared<const tf::Tensor>(input_tensor);
+    const float* data = owner->flat<float>().data();
+    cc->Outputs().Tag(kMatrixView).AddPacket(
+        MakePacket<MatrixView>(data, length, width, std::move(owner))
+            .At(cc->InputTimestamp()));
+    return ::mediapipe::OkStatus();
+  }
   auto output = absl::make_unique<Matrix>(width, length);
   *output =
       Eigen::MatrixXf::Map(input_tensor.flat<float>().data(), length, width);
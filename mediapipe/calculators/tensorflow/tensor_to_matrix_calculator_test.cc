@@ -16,6 +16,7 @@
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_runner.h"
 #include "mediapipe/framework/formats/matrix.h"
+#include "mediapipe/framework/formats/matrix_view.h"
 #include "mediapipe/framework/formats/time_series_header.pb.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -27,6 +28,7 @@ namespace tf = ::tensorflow;
 namespace {
 
 constexpr char kMatrix[] = "MATRIX";
+constexpr char kMatrixView[] = "MATRIX_VIEW";
 constexpr char kTensor[] = "TENSOR";
 
 }  // namespace
@@ -160,6 +162,44 @@ TEST_F(TensorToMatrixCalculatorTest, Converts2DTensorToMatrix) {
   }
 }
 
+TEST_F(TensorToMatrixCalculatorTest, Converts2DTensorToMatrixView) {
+  // This test views a 2 Dimensional Tensor of shape NxM as a Matrix of MxN.
+  CalculatorGraphConfig::Node config;
+  config.set_calculator("TensorToMatrixCalculator");
+  config.add_input_stream("TENSOR:input_tensor");
+  config.add_output_stream("MATRIX_VIEW:output_matrix");
+  runner_ = absl::make_unique<CalculatorRunner>(config);
+  const tf::TensorShape tensor_shape(std::vector<tf::int64>({3, 4}));
+  auto tensor = absl::make_unique<tf::Tensor>(tf::DT_FLOAT, tensor_shape);
+  auto slice = tensor->Slice(0, 1).flat<float>();
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      slice(i * 4 + j) = static_cast<float>(i * j);
+    }
+  }
+  const float* tensor_data = tensor->flat<float>().data();
+  const int64 time = 1234;
+  runner_->MutableInputs()->Tag(kTensor).packets.push_back(
+      Adopt(tensor.release()).At(Timestamp(time)));
+
+  EXPECT_TRUE(runner_->Run().ok());
+  const std::vector<Packet>& output_packets =
+      runner_->Outputs().Tag(kMatrixView).packets;
+  EXPECT_EQ(1, output_packets.size());
+  EXPECT_EQ(time, output_packets[0].Timestamp().Value());
+  const MatrixView& output_view = output_packets[0].Get<MatrixView>();
+  // The view aliases the values of the input tensor.
+  EXPECT_EQ(tensor_data, output_view.data());
+  ASSERT_EQ(3, output_view.cols());
+  EXPECT_EQ(4, output_view.rows());
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      const float expected = static_cast<float>(i * j);
+      EXPECT_EQ(expected, output_view.matrix()(i, j));
+    }
+  }
+}
+
 TEST_F(TensorToMatrixCalculatorTest, ConvertsWithReferenceTimeSeriesHeader) {
   // This test converts a 1 Dimensional Tensor of length M to a Matrix of Mx1.
   SetUpRunnerWithReference(5, 1, -1, true);
@@ -13,22 +13,27 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <deque>
 #include <map>
 #include <memory>
 #include <string>
 #include <unordered_set>
 #include <vector>
 
+#include "absl/memory/memory.h"
 #include "absl/strings/str_split.h"
 #include "absl/synchronization/mutex.h"
+#include "mediapipe/calculators/tensorflow/tensor_batch_allocator.h"
 #include "mediapipe/calculators/tensorflow/tensorflow_inference_calculator.pb.h"
 #include "mediapipe/calculators/tensorflow/tensorflow_session.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/deps/clock.h"
 #include "mediapipe/framework/deps/monotonic_clock.h"
+#include "mediapipe/framework/mediapipe_profiling.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/port/threadpool.h"
 #include "mediapipe/framework/tool/status_util.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
@@ -109,6 +114,20 @@ class SimpleSemaphore {
 // and the output tensors sent out on the output streams with timestamps
 // corresponding to the input stream packets. Setting the batch_size to 1
 // completely disables batching, but is indepdent of add_batch_dim_to_tensors.
+// Setting max_batch_delay_us runs a partial batch once its inputs span that
+// many microseconds of timestamps, padded to batch_size.
+//
+// A full batch is run without concatenating its inputs when they were
+// allocated as the slices of one batch tensor by the TensorBatchAllocator
+// passed as the optional BATCH_ALLOCATOR input side packet, which must also be
+// passed to the calculators producing them. Batched outputs are emitted as
+// slices of the output tensors rather than copies, so they keep the whole
+// output tensor alive until all of them are released.
+//
+// Setting warmup_runs runs the session that many times in Open() on the
+// std::map<std::string, tf::Tensor> passed as the WARMUP_TENSORS input side
+// packet, keyed by input tag like the input streams. The session does not
+// expose its input shapes, so placeholder inputs can't be made up here.
 //
 // The TensorFlowInferenceCalculator also support feeding states recurrently for
 // RNNs and LSTMs. Simply set the recurrent_tag_pair options to define the
@@ -239,11 +258,28 @@ class TensorFlowInferenceCalculator : public CalculatorBase {
           .Tag("RECURRENT_INIT_TENSORS")
           .Set<std::unique_ptr<std::map<std::string, tf::Tensor>>>();
     }
+    if (cc->InputSidePackets().HasTag("BATCH_ALLOCATOR")) {
+      cc->InputSidePackets()
+          .Tag("BATCH_ALLOCATOR")
+          .Set<std::shared_ptr<TensorBatchAllocator>>();
+    }
+    if (cc->InputSidePackets().HasTag("WARMUP_TENSORS")) {
+      cc->InputSidePackets()
+          .Tag("WARMUP_TENSORS")
+          .Set<std::map<std::string, tf::Tensor>>();
+    }
     return ::mediapipe::OkStatus();
   }
 
   ::mediapipe::Status Open(CalculatorContext* cc) override {
     options_ = cc->Options<TensorFlowInferenceCalculatorOptions>();
+    total_usecs_counter_ = cc->GetCounter(kTotalUsecsCounterSuffix);
+    total_processed_timestamps_counter_ =
+        cc->GetCounter(kTotalProcessedTimestampsCounterSuffix);
+    total_session_runs_time_usecs_counter_ =
+        cc->GetCounter(kTotalSessionRunsTimeUsecsCounterSuffix);
+    total_num_session_runs_counter_ =
+        cc->GetCounter(kTotalNumSessionRunsCounterSuffix);
 
     RET_CHECK(cc->InputSidePackets().HasTag("SESSION"));
     session_ = cc->InputSidePackets()
@@ -260,6 +296,14 @@ class TensorFlowInferenceCalculator : public CalculatorBase {
     RET_CHECK(options_.batch_size() == 1 ||
               options_.recurrent_tag_pair().empty())
         << "To use recurrent_tag_pairs, batch_size must be 1.";
+    RET_CHECK_GE(options_.max_batch_delay_us(), 0);
+    if (cc->InputSidePackets().HasTag("BATCH_ALLOCATOR")) {
+      batch_allocator_ = cc->InputSidePackets()
+                             .Tag("BATCH_ALLOCATOR")
+                             .Get<std::shared_ptr<TensorBatchAllocator>>();
+      RET_CHECK_EQ(batch_allocator_->batch_size(), options_.batch_size())
+          << "The BATCH_ALLOCATOR must use the batch_size of the calculator.";
+    }
     for (const auto& tag_pair : options_.recurrent_tag_pair()) {
       const std::vector<std::string> tags = absl::StrSplit(tag_pair, ':');
       RET_CHECK_EQ(tags.size(), 2)
@@ -297,9 +341,67 @@ class TensorFlowInferenceCalculator : public CalculatorBase {
           << options_.signature_name();
     }
 
-    if (options_.batch_size() == 1) {
+    if (options_.max_outstanding_batches() > 0) {
+      RET_CHECK(options_.recurrent_tag_pair().empty())
+          << "To use recurrent_tag_pairs, max_outstanding_batches must be 0.";
+      session_run_pool_ = absl::make_unique<ThreadPool>(
+          "tf_session_run", options_.max_outstanding_batches());
+      session_run_pool_->StartWorkers();
+    } else if (options_.batch_size() == 1) {
+      // Outputs are only delayed when batches are run asynchronously.
       cc->SetOffset(0);
     }
+
+    RET_CHECK_GE(options_.warmup_runs(), 0);
+    if (options_.warmup_runs() > 0) {
+      RET_CHECK(cc->InputSidePackets().HasTag("WARMUP_TENSORS"))
+          << "warmup_runs requires the WARMUP_TENSORS input side packet.";
+      MP_RETURN_IF_ERROR(WarmUp(cc));
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  // Runs the session warmup_runs times on a batch of the WARMUP_TENSORS, and
+  // reports the time taken to the graph profiler.
+  ::mediapipe::Status WarmUp(CalculatorContext* cc) {
+    const absl::Time start_time = clock_->TimeNow();
+    const auto& warmup_tensors = cc->InputSidePackets()
+                                     .Tag("WARMUP_TENSORS")
+                                     .Get<std::map<std::string, tf::Tensor>>();
+    Batch batch;
+    for (const auto& keyed_tensor : warmup_tensors) {
+      RET_CHECK(
+          ::mediapipe::ContainsKey(tag_to_tensor_map_, keyed_tensor.first))
+          << "Can't find tag '" << keyed_tensor.first << "' in signature "
+          << options_.signature_name();
+      tf::Tensor input_tensor(keyed_tensor.second);
+      RET_CHECK_OK(AddBatchDimension(&input_tensor));
+      if (options_.batch_size() > 1) {
+        // Fill every batch element, so that the session sees the batch shape
+        // of the stream inputs.
+        const std::vector<tf::Tensor> batch_elements(options_.batch_size(),
+                                                     input_tensor);
+        const tf::Status concat_status =
+            tf::tensor::Concat(batch_elements, &input_tensor);
+        RET_CHECK(concat_status.ok()) << concat_status.ToString();
+      }
+      batch.input_tensors.emplace_back(tag_to_tensor_map_[keyed_tensor.first],
+                                       input_tensor);
+    }
+    for (const std::string& tag : cc->Outputs().GetTags()) {
+      batch.output_tensor_names.emplace_back(tag_to_tensor_map_[tag]);
+    }
+    for (int i = 0; i < options_.warmup_runs(); ++i) {
+      batch.outputs.clear();
+      RunBatch(cc->NodeName(), &batch);
+      RET_CHECK(batch.status.ok())
+          << "Warm-up run failed: " << batch.status.error_message();
+    }
+    ProfilingContext* profiling_context = cc->GetProfilingContext();
+    if (profiling_context) {
+      profiling_context->AddWarmupRuntime(*cc,
+                                          clock_->TimeNow() - start_time);
+    }
     return ::mediapipe::OkStatus();
   }
 
@@ -364,36 +466,68 @@ class TensorFlowInferenceCalculator : public CalculatorBase {
           input_tensor_and_tag.second);
     }
 
-    if (batch_timestamps_.size() == options_.batch_size()) {
-      MP_RETURN_IF_ERROR(OutputBatch(cc));
+    if (batch_timestamps_.size() == options_.batch_size() ||
+        BatchDelayExceeded()) {
+      MP_RETURN_IF_ERROR(RunAndOutputBatch(cc));
+    }
+    if (session_run_pool_) {
+      MP_RETURN_IF_ERROR(OutputCompletedBatches(cc, /*num_to_wait_for=*/0));
     }
     return ::mediapipe::OkStatus();
   }
 
+  // Returns true if the pending batch spans at least max_batch_delay_us.
+  bool BatchDelayExceeded() const {
+    return options_.max_batch_delay_us() > 0 &&
+           batch_timestamps_.back() - batch_timestamps_.front() >=
+               TimestampDiff(options_.max_batch_delay_us());
+  }
+
   ::mediapipe::Status Close(CalculatorContext* cc) override {
     if (!batch_timestamps_.empty()) {
-      MP_RETURN_IF_ERROR(OutputBatch(cc));
+      MP_RETURN_IF_ERROR(RunAndOutputBatch(cc));
+    }
+    if (session_run_pool_) {
+      ::mediapipe::Status status =
+          OutputCompletedBatches(cc, NumPendingBatches());
+      // Waits for the batches left running after an error.
+      session_run_pool_.reset();
+      return status;
     }
     return ::mediapipe::OkStatus();
   }
 
-  // When a batch of input tensors is ready to be run, runs TensorFlow and
-  // outputs the output tensors. The output tensors have timestamps matching
-  // the input tensor that formed that batch element. Any requested
-  // batch_dimension is added and removed. This code takes advantage of the fact
-  // that copying a tensor shares the same reference-counted, heap allocated
-  // memory buffer. Therefore, copies are cheap and should not cause the memory
-  // buffer to fall out of scope. In contrast, concat is only used where
-  // necessary.
-  ::mediapipe::Status OutputBatch(CalculatorContext* cc) {
-    const int64 start_time = absl::ToUnixMicros(clock_->TimeNow());
+  // A batch of inputs taken out of input_tensor_batches_, and the results of
+  // running it.
+  struct Batch {
+    // The timestamps that went into the batch.
+    std::vector<Timestamp> timestamps;
     std::vector<std::pair<mediapipe::ProtoString, tf::Tensor>> input_tensors;
+    std::vector<mediapipe::ProtoString> output_tensor_names;
+    std::vector<std::string> output_name_in_signature;
+    std::vector<tf::Tensor> outputs;
+    tf::Status status;
+    // Time at which the batch was taken, and time spent in Session::Run.
+    int64 start_time = 0;
+    int64 run_time_usecs = 0;
+    // Set under mutex_ once the batch has been run on session_run_pool_.
+    bool done = false;
+  };
+
+  // Takes the pending batch of input tensors into "batch", padding it to
+  // batch_size.  This code takes advantage of the fact that copying a tensor
+  // shares the same reference-counted, heap allocated memory buffer.
+  // Therefore, copies are cheap and should not cause the memory buffer to
+  // fall out of scope. In contrast, concat is only used where necessary.
+  ::mediapipe::Status TakeBatch(CalculatorContext* cc, Batch* batch) {
+    batch->start_time = absl::ToUnixMicros(clock_->TimeNow());
+    batch->timestamps.swap(batch_timestamps_);
     for (auto& keyed_tensors : input_tensor_batches_) {
       if (options_.batch_size() == 1) {
         // Short circuit to avoid the cost of deep copying tensors in concat.
         if (!keyed_tensors.second.empty()) {
-          input_tensors.emplace_back(tag_to_tensor_map_[keyed_tensors.first],
-                                     keyed_tensors.second[0]);
+          batch->input_tensors.emplace_back(
+              tag_to_tensor_map_[keyed_tensors.first], keyed_tensors.second[0]);
         } else {
           // The input buffer can be empty for recurrent tensors.
           RET_CHECK(::mediapipe::ContainsKey(recurrent_feed_tags_,
@@ -402,36 +536,45 @@ class TensorFlowInferenceCalculator : public CalculatorBase {
               << keyed_tensors.first;
         }
       } else {
+        tf::Tensor concated;
+        if (batch_allocator_ &&
+            batch_allocator_->TakeBatch(keyed_tensors.second, &concated)) {
+          batch->input_tensors.emplace_back(
+              tag_to_tensor_map_[keyed_tensors.first], concated);
+          continue;
+        }
         // Pad by replicating the first tens  or, then ignore the values.
         keyed_tensors.second.resize(options_.batch_size());
-        std::fill(keyed_tensors.second.begin() + batch_timestamps_.size(),
+        std::fill(keyed_tensors.second.begin() + batch->timestamps.size(),
                   keyed_tensors.second.end(), keyed_tensors.second[0]);
-        tf::Tensor concated;
         const tf::Status concat_status =
             tf::tensor::Concat(keyed_tensors.second, &concated);
         CHECK(concat_status.ok()) << concat_status.ToString();
-        input_tensors.emplace_back(tag_to_tensor_map_[keyed_tensors.first],
-                                   concated);
+        batch->input_tensors.emplace_back(
+            tag_to_tensor_map_[keyed_tensors.first], concated);
       }
     }
     input_tensor_batches_.clear();
-    std::vector<mediapipe::ProtoString> output_tensor_names;
-    std::vector<std::string> output_name_in_signature;
     for (const std::string& tag : cc->Outputs().GetTags()) {
-      output_tensor_names.emplace_back(tag_to_tensor_map_[tag]);
-      output_name_in_signature.emplace_back(tag);
+      batch->output_tensor_names.emplace_back(tag_to_tensor_map_[tag]);
+      batch->output_name_in_signature.emplace_back(tag);
     }
     for (const auto& tag_pair : recurrent_fetch_tags_to_feed_tags_) {
       // Ensure that we always fetch the recurrent state tensors.
-      if (std::find(output_name_in_signature.begin(),
-                    output_name_in_signature.end(),
-                    tag_pair.first) == output_name_in_signature.end()) {
-        output_tensor_names.emplace_back(tag_to_tensor_map_[tag_pair.first]);
-        output_name_in_signature.emplace_back(tag_pair.first);
+      if (std::find(batch->output_name_in_signature.begin(),
+                    batch->output_name_in_signature.end(),
+                    tag_pair.first) == batch->output_name_in_signature.end()) {
+        batch->output_tensor_names.emplace_back(
+            tag_to_tensor_map_[tag_pair.first]);
+        batch->output_name_in_signature.emplace_back(tag_pair.first);
       }
     }
-    std::vector<tf::Tensor> outputs;
+    return ::mediapipe::OkStatus();
+  }
 
+  // Runs the TensorFlow session on "batch".  Does not access the calculator
+  // context, so that it can run on session_run_pool_.
+  void RunBatch(const std::string& node_name, Batch* batch) {
     SimpleSemaphore* session_run_throttle = nullptr;
     if (options_.max_concurrent_session_runs() > 0) {
       session_run_throttle =
@@ -439,28 +582,36 @@ class TensorFlowInferenceCalculator : public CalculatorBase {
       session_run_throttle->Acquire(1);
     }
     const int64 run_start_time = absl::ToUnixMicros(clock_->TimeNow());
-    tf::Status tf_status;
     {
 #if !defined(__ANDROID__) && !defined(__APPLE__)
-      tensorflow::profiler::TraceMe trace(absl::string_view(cc->NodeName()));
+      tensorflow::profiler::TraceMe trace(absl::string_view(node_name));
 #endif
-      tf_status = session_->Run(input_tensors, output_tensor_names,
-                                {} /* target_node_names */, &outputs);
+      batch->status =
+          session_->Run(batch->input_tensors, batch->output_tensor_names,
+                        {} /* target_node_names */, &batch->outputs);
     }
+    batch->run_time_usecs =
+        absl::ToUnixMicros(clock_->TimeNow()) - run_start_time;
 
     if (session_run_throttle != nullptr) {
       session_run_throttle->Release(1);
     }
+  }
 
+  // Outputs the output tensors of a batch that has been run. The output
+  // tensors have timestamps matching the input tensor that formed that batch
+  // element. Any requested batch_dimension is removed.
+  ::mediapipe::Status OutputBatch(CalculatorContext* cc, Batch* batch) {
     // RET_CHECK on the tf::Status object itself in order to print an
     // informative error message.
-    RET_CHECK(tf_status.ok()) << "Run failed: " << tf_status.error_message();
+    RET_CHECK(batch->status.ok())
+        << "Run failed: " << batch->status.error_message();
 
-    const int64 run_end_time = absl::ToUnixMicros(clock_->TimeNow());
-    cc->GetCounter(kTotalSessionRunsTimeUsecsCounterSuffix)
-        ->IncrementBy(run_end_time - run_start_time);
-    cc->GetCounter(kTotalNumSessionRunsCounterSuffix)->Increment();
+    total_session_runs_time_usecs_counter_->IncrementBy(batch->run_time_usecs);
+    total_num_session_runs_counter_->Increment();
 
+    const auto& output_name_in_signature = batch->output_name_in_signature;
+    const auto& outputs = batch->outputs;
     // Feed back the recurrent state.
     for (const auto& tag_pair : recurrent_fetch_tags_to_feed_tags_) {
       int pos = std::find(output_name_in_signature.begin(),
@@ -469,42 +620,100 @@ class TensorFlowInferenceCalculator : public CalculatorBase {
       input_tensor_batches_[tag_pair.second].emplace_back(outputs[pos]);
     }
 
-    // Set that we want to split on each index of the 0th dimension.
-    std::vector<tf::int64> split_vector(options_.batch_size(), 1);
-    for (int i = 0; i < output_tensor_names.size(); ++i) {
+    for (int i = 0; i < batch->output_tensor_names.size(); ++i) {
       if (options_.batch_size() == 1) {
         if (cc->Outputs().HasTag(output_name_in_signature[i])) {
           tf::Tensor output_tensor(outputs[i]);
           RET_CHECK_OK(RemoveBatchDimension(&output_tensor));
           cc->Outputs()
               .Tag(output_name_in_signature[i])
-              .Add(new tf::Tensor(output_tensor), batch_timestamps_[0]);
+              .Add(new tf::Tensor(output_tensor), batch->timestamps[0]);
         }
       } else {
-        std::vector<tf::Tensor> split_tensors;
-        const tf::Status split_status =
-            tf::tensor::Split(outputs[i], split_vector, &split_tensors);
-        CHECK(split_status.ok()) << split_status.ToString();
-        // Loop over timestamps so that we don't copy the padding.
-        for (int j = 0; j < batch_timestamps_.size(); ++j) {
-          tf::Tensor output_tensor(split_tensors[j]);
+        RET_CHECK_EQ(outputs[i].dim_size(0) % options_.batch_size(), 0)
+            << "Can't split output " << output_name_in_signature[i]
+            << " into " << options_.batch_size() << " batch elements.";
+        const int64 slice_size = outputs[i].dim_size(0) / options_.batch_size();
+        // Loop over timestamps so that we don't output the padding.
+        for (int j = 0; j < batch->timestamps.size(); ++j) {
+          // Slices share the buffer of the output tensor, but are only copied
+          // when they would not be aligned for Eigen.
+          tf::Tensor output_tensor =
+              outputs[i].Slice(j * slice_size, (j + 1) * slice_size);
+          if (!output_tensor.IsAligned()) {
+            output_tensor = tf::tensor::DeepCopy(output_tensor);
+          }
           RET_CHECK_OK(RemoveBatchDimension(&output_tensor));
           cc->Outputs()
               .Tag(output_name_in_signature[i])
-              .Add(new tf::Tensor(output_tensor), batch_timestamps_[j]);
+              .Add(new tf::Tensor(output_tensor), batch->timestamps[j]);
         }
       }
     }
     // Get end time and report.
     const int64 end_time = absl::ToUnixMicros(clock_->TimeNow());
-    cc->GetCounter(kTotalUsecsCounterSuffix)
-        ->IncrementBy(end_time - start_time);
-    cc->GetCounter(kTotalProcessedTimestampsCounterSuffix)
-        ->IncrementBy(batch_timestamps_.size());
-    batch_timestamps_.clear();
+    total_usecs_counter_->IncrementBy(end_time - batch->start_time);
+    total_processed_timestamps_counter_->IncrementBy(batch->timestamps.size());
+    return ::mediapipe::OkStatus();
+  }
+
+  // When a batch of input tensors is ready to be run, runs TensorFlow and
+  // outputs the output tensors. With max_outstanding_batches, the batch is
+  // run on session_run_pool_ instead, and output by a later call.
+  ::mediapipe::Status RunAndOutputBatch(CalculatorContext* cc) {
+    auto batch = absl::make_unique<Batch>();
+    MP_RETURN_IF_ERROR(TakeBatch(cc, batch.get()));
+    if (!session_run_pool_) {
+      RunBatch(cc->NodeName(), batch.get());
+      return OutputBatch(cc, batch.get());
+    }
+    // Bounds the number of outstanding batches by waiting for the oldest.
+    MP_RETURN_IF_ERROR(OutputCompletedBatches(
+        cc, NumPendingBatches() - options_.max_outstanding_batches() + 1));
+    Batch* batch_ptr = batch.get();
+    {
+      absl::MutexLock lock(&mutex_);
+      pending_batches_.push_back(std::move(batch));
+    }
+    const std::string node_name = cc->NodeName();
+    session_run_pool_->Schedule([this, node_name, batch_ptr] {
+      RunBatch(node_name, batch_ptr);
+      absl::MutexLock lock(&mutex_);
+      batch_ptr->done = true;
+    });
     return ::mediapipe::OkStatus();
   }
 
+  int NumPendingBatches() LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    return static_cast<int>(pending_batches_.size());
+  }
+
+  // Outputs the completed batches at the front of pending_batches_, so that
+  // outputs are emitted in timestamp order. First waits for the oldest
+  // "num_to_wait_for" batches to complete.
+  ::mediapipe::Status OutputCompletedBatches(CalculatorContext* cc,
+                                             int num_to_wait_for) {
+    for (int i = 0;; ++i) {
+      std::unique_ptr<Batch> batch;
+      {
+        absl::MutexLock lock(&mutex_);
+        if (pending_batches_.empty()) {
+          return ::mediapipe::OkStatus();
+        }
+        const bool* done = &pending_batches_.front()->done;
+        if (i < num_to_wait_for) {
+          mutex_.Await(absl::Condition(done));
+        } else if (!*done) {
+          return ::mediapipe::OkStatus();
+        }
+        batch = std::move(pending_batches_.front());
+        pending_batches_.pop_front();
+      }
+      MP_RETURN_IF_ERROR(OutputBatch(cc, batch.get()));
+    }
+  }
+
  private:
   // The Session object is provided by a packet factory and is owned by the
   // MediaPipe framework. Individual calls are thread-safe, but session state
@@ -520,6 +729,16 @@ class TensorFlowInferenceCalculator : public CalculatorBase {
   // The timestamps that go into a batch.
   std::vector<Timestamp> batch_timestamps_;
 
+  // Allocates batchable input tensors upstream, if set.
+  std::shared_ptr<TensorBatchAllocator> batch_allocator_;
+
+  // The batches running or run on session_run_pool_, oldest first.
+  absl::Mutex mutex_;
+  std::deque<std::unique_ptr<Batch>> pending_batches_ GUARDED_BY(mutex_);
+  // Runs the session asynchronously if max_outstanding_batches is set.
+  // Declared after pending_batches_, so that it is destroyed first.
+  std::unique_ptr<ThreadPool> session_run_pool_;
+
   // The options for the calculator.
   TensorFlowInferenceCalculatorOptions options_;
 
@@ -530,6 +749,12 @@ class TensorFlowInferenceCalculator : public CalculatorBase {
   // Clock used to measure the computation time in OutputBatch().
   std::unique_ptr<mediapipe::Clock> clock_;
 
+  // The counters updated in OutputBatch(), looked up once in Open().
+  Counter* total_usecs_counter_ = nullptr;
+  Counter* total_processed_timestamps_counter_ = nullptr;
+  Counter* total_session_runs_time_usecs_counter_ = nullptr;
+  Counter* total_num_session_runs_counter_ = nullptr;
+
   // The static singleton semaphore to throttle concurrent session runs.
   static SimpleSemaphore* get_session_run_throttle(
       int32 max_concurrent_session_runs) {
@@ -311,6 +311,84 @@ TEST_F(TensorflowInferenceCalculatorTest, GetCloseBatchComputed) {
                    ->Get());
 }
 
+TEST_F(TensorflowInferenceCalculatorTest, GetDelayedBatchComputed) {
+  CalculatorGraphConfig::Node config;
+  config.set_calculator("TensorFlowInferenceCalculator");
+  config.add_input_stream("A:tensor_a");
+  config.add_input_stream("B:tensor_b");
+  config.add_output_stream("MULTIPLIED:tensor_o1");
+  config.add_input_side_packet("SESSION:session");
+  CalculatorOptions options;
+  options.MutableExtension(TensorFlowInferenceCalculatorOptions::ext)
+      ->set_batch_size(4);
+  options.MutableExtension(TensorFlowInferenceCalculatorOptions::ext)
+      ->set_max_batch_delay_us(10);
+  *config.mutable_options() = options;
+
+  runner_ = absl::make_unique<CalculatorRunner>(config);
+  AddSessionInputSidePacket();
+  // The batch is run at timestamp 20, 20us after it started at timestamp 0.
+  for (int64 time : {0, 5, 20, 21}) {
+    AddVectorToInputsAsTensor({2, 2, 2}, "A", time);
+    AddVectorToInputsAsTensor({3, 4, 5}, "B", time);
+  }
+  MP_ASSERT_OK(runner_->Run());
+
+  const std::vector<Packet>& output_packets_mult =
+      runner_->Outputs().Tag("MULTIPLIED").packets;
+  ASSERT_EQ(4, output_packets_mult.size());
+  auto expected_tensor = tf::test::AsTensor<int32>({6, 8, 10});
+  for (const Packet& packet : output_packets_mult) {
+    tf::test::ExpectTensorEqual<int32>(packet.Get<tf::Tensor>(),
+                                       expected_tensor);
+  }
+  EXPECT_EQ(Timestamp(21), output_packets_mult[3].Timestamp());
+
+  EXPECT_EQ(2, runner_
+                   ->GetCounter(
+                       "TensorFlowInferenceCalculator-TotalNumSessionRuns")
+                   ->Get());
+}
+
+TEST_F(TensorflowInferenceCalculatorTest, GetAsyncBatchesComputed) {
+  CalculatorGraphConfig::Node config;
+  config.set_calculator("TensorFlowInferenceCalculator");
+  config.add_input_stream("A:tensor_a");
+  config.add_input_stream("B:tensor_b");
+  config.add_output_stream("MULTIPLIED:tensor_o1");
+  config.add_input_side_packet("SESSION:session");
+  CalculatorOptions options;
+  options.MutableExtension(TensorFlowInferenceCalculatorOptions::ext)
+      ->set_batch_size(2);
+  options.MutableExtension(TensorFlowInferenceCalculatorOptions::ext)
+      ->set_max_outstanding_batches(2);
+  *config.mutable_options() = options;
+
+  runner_ = absl::make_unique<CalculatorRunner>(config);
+  AddSessionInputSidePacket();
+  for (int time = 0; time < 5; ++time) {
+    AddVectorToInputsAsTensor({time, time, time}, "A", time);
+    AddVectorToInputsAsTensor({3, 4, 5}, "B", time);
+  }
+  MP_ASSERT_OK(runner_->Run());
+
+  const std::vector<Packet>& output_packets_mult =
+      runner_->Outputs().Tag("MULTIPLIED").packets;
+  ASSERT_EQ(5, output_packets_mult.size());
+  for (int time = 0; time < 5; ++time) {
+    EXPECT_EQ(Timestamp(time), output_packets_mult[time].Timestamp());
+    auto expected_tensor =
+        tf::test::AsTensor<int32>({3 * time, 4 * time, 5 * time});
+    tf::test::ExpectTensorEqual<int32>(
+        output_packets_mult[time].Get<tf::Tensor>(), expected_tensor);
+  }
+
+  EXPECT_EQ(3, runner_
+                   ->GetCounter(
+                       "TensorFlowInferenceCalculator-TotalNumSessionRuns")
+                   ->Get());
+}
+
 TEST_F(TensorflowInferenceCalculatorTest, TestRecurrentStates) {
   CalculatorGraphConfig::Node config;
   config.set_calculator("TensorFlowInferenceCalculator");
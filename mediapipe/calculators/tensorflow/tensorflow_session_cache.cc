@@ -0,0 +1,63 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensorflow/tensorflow_session_cache.h"
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/port/status_macros.h"
+
+namespace mediapipe {
+
+TensorFlowSessionCache* TensorFlowSessionCache::GetInstance() {
+  static TensorFlowSessionCache* cache = new TensorFlowSessionCache();
+  return cache;
+}
+
+::mediapipe::StatusOr<std::unique_ptr<TensorFlowSession>>
+TensorFlowSessionCache::GetOrLoad(const std::string& key,
+                                  const Loader& loader) {
+  // Entries are never erased, so the pointer stays valid without the lock.
+  Entry* entry;
+  {
+    absl::MutexLock lock(&mutex_);
+    entry = &entries_[key];
+    mutex_.Await(absl::Condition(
+        +[](Entry* entry) { return !entry->loading; }, entry));
+    std::shared_ptr<tensorflow::Session> session = entry->session.lock();
+    if (session) {
+      auto shared = absl::make_unique<TensorFlowSession>();
+      shared->session = std::move(session);
+      shared->tag_to_tensor_map = entry->tag_to_tensor_map;
+      return std::move(shared);
+    }
+    entry->loading = true;
+  }
+
+  // Loads without holding the lock, so that other models can be loaded
+  // concurrently.
+  auto loaded = absl::make_unique<TensorFlowSession>();
+  ::mediapipe::Status status = loader(loaded.get());
+  if (status.ok() && !loaded->session) {
+    status = ::mediapipe::InternalError("The loader did not set a session.");
+  }
+
+  absl::MutexLock lock(&mutex_);
+  entry->loading = false;
+  MP_RETURN_IF_ERROR(status);
+  entry->session = loaded->session;
+  entry->tag_to_tensor_map = loaded->tag_to_tensor_map;
+  return std::move(loaded);
+}
+
+}  // namespace mediapipe
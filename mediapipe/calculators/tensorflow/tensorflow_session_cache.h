@@ -0,0 +1,64 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_TENSORFLOW_CALCULATORS_TENSORFLOW_SESSION_CACHE_H_
+#define MEDIAPIPE_TENSORFLOW_CALCULATORS_TENSORFLOW_SESSION_CACHE_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/calculators/tensorflow/tensorflow_session.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+
+namespace mediapipe {
+
+// A process-wide cache of loaded TensorFlow sessions, which lets graphs
+// running the same model share one session and one copy of its weights.
+//
+// The cache only holds weak references: a session is released as soon as
+// the last TensorFlowSession sharing it is destroyed, and is loaded again by
+// the next graph asking for it.
+class TensorFlowSessionCache {
+ public:
+  using Loader = std::function<::mediapipe::Status(TensorFlowSession*)>;
+
+  // Returns the process-wide cache.
+  static TensorFlowSessionCache* GetInstance();
+
+  // Returns a TensorFlowSession sharing the session cached under "key", or
+  // calls "loader" to load it and caches the result. "key" must identify the
+  // model and every option used to load it. Concurrent calls for the same
+  // key wait for a single load.
+  ::mediapipe::StatusOr<std::unique_ptr<TensorFlowSession>> GetOrLoad(
+      const std::string& key, const Loader& loader) LOCKS_EXCLUDED(mutex_);
+
+ private:
+  struct Entry {
+    std::weak_ptr<tensorflow::Session> session;
+    std::map<std::string, std::string> tag_to_tensor_map;
+    // True while a call is loading the session for this entry.
+    bool loading = false;
+  };
+
+  absl::Mutex mutex_;
+  std::map<std::string, Entry> entries_ GUARDED_BY(mutex_);
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_TENSORFLOW_CALCULATORS_TENSORFLOW_SESSION_CACHE_H_
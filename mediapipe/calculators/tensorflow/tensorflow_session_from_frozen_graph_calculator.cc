@@ -21,13 +21,18 @@
 //
 // Produces a SessionBundle that TensorFlowInferenceCalculator can use.
 
+#include <memory>
 #include <string>
 
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "mediapipe/calculators/tensorflow/tensorflow_session.h"
+#include "mediapipe/calculators/tensorflow/tensorflow_session_cache.h"
 #include "mediapipe/calculators/tensorflow/tensorflow_session_from_frozen_graph_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_macros.h"
 #include "mediapipe/framework/tool/status_util.h"
 #include "tensorflow/core/public/session_options.h"
 
@@ -80,9 +85,43 @@ class TensorFlowSessionFromFrozenGraphCalculator : public CalculatorBase {
   ::mediapipe::Status Open(CalculatorContext* cc) override {
     const auto& options =
         cc->Options<TensorFlowSessionFromFrozenGraphCalculatorOptions>();
+    const PacketSet& input_side_packets = cc->InputSidePackets();
+    auto load_session = [&options,
+                         &input_side_packets](TensorFlowSession* session) {
+      return LoadSession(options, input_side_packets, session);
+    };
     // Output bundle packet.
-    auto session = ::absl::make_unique<TensorFlowSession>();
+    std::unique_ptr<TensorFlowSession> session;
+    if (options.share_session() && !input_side_packets.HasTag("STRING_MODEL")) {
+      const std::string& path =
+          input_side_packets.HasTag("STRING_MODEL_FILE_PATH")
+              ? input_side_packets.Tag("STRING_MODEL_FILE_PATH")
+                    .Get<std::string>()
+              : options.graph_proto_path();
+      ASSIGN_OR_RETURN(
+          session,
+          TensorFlowSessionCache::GetInstance()->GetOrLoad(
+              absl::StrCat("TensorFlowSessionFromFrozenGraphCalculator:", path,
+                           ":", options.SerializeAsString()),
+              load_session));
+    } else {
+      session = ::absl::make_unique<TensorFlowSession>();
+      MP_RETURN_IF_ERROR(load_session(session.get()));
+    }
+
+    cc->OutputSidePackets().Tag("SESSION").Set(Adopt(session.release()));
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    return ::mediapipe::OkStatus();
+  }
 
+ private:
+  // Creates the session of the frozen graph and initializes it.
+  static ::mediapipe::Status LoadSession(
+      const TensorFlowSessionFromFrozenGraphCalculatorOptions& options,
+      const PacketSet& input_side_packets, TensorFlowSession* session) {
     tf::SessionOptions session_options;
     session_options.config.CopyFrom(options.config());
     std::vector<mediapipe::ProtoString> initialization_op_names;
@@ -93,13 +132,12 @@ class TensorFlowSessionFromFrozenGraphCalculator : public CalculatorBase {
     session->session.reset(tf::NewSession(session_options));
 
     std::string graph_def_serialized;
-    if (cc->InputSidePackets().HasTag("STRING_MODEL")) {
+    if (input_side_packets.HasTag("STRING_MODEL")) {
       graph_def_serialized =
-          cc->InputSidePackets().Tag("STRING_MODEL").Get<std::string>();
-    } else if (cc->InputSidePackets().HasTag("STRING_MODEL_FILE_PATH")) {
-      const std::string& frozen_graph = cc->InputSidePackets()
-                                            .Tag("STRING_MODEL_FILE_PATH")
-                                            .Get<std::string>();
+          input_side_packets.Tag("STRING_MODEL").Get<std::string>();
+    } else if (input_side_packets.HasTag("STRING_MODEL_FILE_PATH")) {
+      const std::string& frozen_graph =
+          input_side_packets.Tag("STRING_MODEL_FILE_PATH").Get<std::string>();
       RET_CHECK_OK(
           mediapipe::file::GetContents(frozen_graph, &graph_def_serialized));
     } else {
@@ -122,12 +160,6 @@ class TensorFlowSessionFromFrozenGraphCalculator : public CalculatorBase {
       // informative error message.
       RET_CHECK(tf_status.ok()) << "Run failed: " << tf_status.error_message();
     }
-
-    cc->OutputSidePackets().Tag("SESSION").Set(Adopt(session.release()));
-    return ::mediapipe::OkStatus();
-  }
-
-  ::mediapipe::Status Process(CalculatorContext* cc) override {
     return ::mediapipe::OkStatus();
   }
 };
@@ -312,5 +312,29 @@ TEST_F(TensorFlowSessionFromFrozenGraphCalculatorTest,
   VerifySignatureMap(session);
 }
 
+TEST_F(TensorFlowSessionFromFrozenGraphCalculatorTest,
+       SharesSessionAcrossGraphs) {
+  calculator_options_->set_share_session(true);
+  const std::string node = absl::Substitute(R"(
+        calculator: "TensorFlowSessionFromFrozenGraphCalculator"
+        output_side_packet: "SESSION:session"
+        options {
+          [mediapipe.TensorFlowSessionFromFrozenGraphCalculatorOptions.ext]: {
+            $0
+          }
+        })",
+                                            calculator_options_->DebugString());
+  CalculatorRunner runner_1(node);
+  CalculatorRunner runner_2(node);
+  MP_ASSERT_OK(runner_1.Run());
+  MP_ASSERT_OK(runner_2.Run());
+  const TensorFlowSession& session_1 =
+      runner_1.OutputSidePackets().Tag("SESSION").Get<TensorFlowSession>();
+  const TensorFlowSession& session_2 =
+      runner_2.OutputSidePackets().Tag("SESSION").Get<TensorFlowSession>();
+  VerifySignatureMap(session_2);
+  EXPECT_EQ(session_1.session.get(), session_2.session.get());
+}
+
 }  // namespace
 }  // namespace mediapipe
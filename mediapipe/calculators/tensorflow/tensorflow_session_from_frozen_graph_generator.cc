@@ -22,14 +22,18 @@
 // See tensorflow_session_bundle_from_graph_generator.proto for options.
 // Produces a SessionBundle that TensorFlowInferenceCalculator can use.
 
+#include <memory>
 #include <string>
 
+#include "absl/strings/str_cat.h"
 #include "mediapipe/calculators/tensorflow/tensorflow_session.h"
+#include "mediapipe/calculators/tensorflow/tensorflow_session_cache.h"
 #include "mediapipe/calculators/tensorflow/tensorflow_session_from_frozen_graph_generator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/port/file_helpers.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_macros.h"
 #include "mediapipe/framework/tool/status_util.h"
 #include "tensorflow/core/public/session_options.h"
 
@@ -80,9 +84,38 @@ class TensorFlowSessionFromFrozenGraphGenerator : public PacketGenerator {
     const TensorFlowSessionFromFrozenGraphGeneratorOptions& options =
         packet_generator_options.GetExtension(
             TensorFlowSessionFromFrozenGraphGeneratorOptions::ext);
+    auto load_session = [&options,
+                         &input_side_packets](TensorFlowSession* session) {
+      return LoadSession(options, input_side_packets, session);
+    };
     // Output bundle packet.
-    auto session = ::absl::make_unique<TensorFlowSession>();
+    std::unique_ptr<TensorFlowSession> session;
+    if (options.share_session() && !input_side_packets.HasTag("STRING_MODEL")) {
+      const std::string& path =
+          input_side_packets.HasTag("STRING_MODEL_FILE_PATH")
+              ? input_side_packets.Tag("STRING_MODEL_FILE_PATH")
+                    .Get<std::string>()
+              : options.graph_proto_path();
+      ASSIGN_OR_RETURN(
+          session,
+          TensorFlowSessionCache::GetInstance()->GetOrLoad(
+              absl::StrCat("TensorFlowSessionFromFrozenGraphGenerator:", path,
+                           ":", options.SerializeAsString()),
+              load_session));
+    } else {
+      session = ::absl::make_unique<TensorFlowSession>();
+      MP_RETURN_IF_ERROR(load_session(session.get()));
+    }
+
+    output_side_packets->Tag("SESSION") = Adopt(session.release());
+    return ::mediapipe::OkStatus();
+  }
 
+ private:
+  // Creates the session of the frozen graph and initializes it.
+  static ::mediapipe::Status LoadSession(
+      const TensorFlowSessionFromFrozenGraphGeneratorOptions& options,
+      const PacketSet& input_side_packets, TensorFlowSession* session) {
     tf::SessionOptions session_options;
     session_options.config.CopyFrom(options.config());
     std::vector<mediapipe::ProtoString> initialization_op_names;
@@ -121,8 +154,6 @@ class TensorFlowSessionFromFrozenGraphGenerator : public PacketGenerator {
       // informative error message.
       RET_CHECK(tf_status.ok()) << "Run failed: " << tf_status.error_message();
     }
-
-    output_side_packets->Tag("SESSION") = Adopt(session.release());
     return ::mediapipe::OkStatus();
   }
 };
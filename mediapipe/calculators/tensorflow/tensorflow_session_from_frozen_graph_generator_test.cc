@@ -284,5 +284,42 @@ TEST_F(TensorFlowSessionFromFrozenGraphGeneratorTest,
   VerifySignatureMap(&output_side_packets);
 }
 
+TEST_F(TensorFlowSessionFromFrozenGraphGeneratorTest,
+       SharesSessionAcrossGraphs) {
+  generator_options_->set_share_session(true);
+  PacketSet input_side_packets(tool::CreateTagMap({}).ValueOrDie());
+  PacketSet output_side_packets_1(
+      tool::CreateTagMap({"SESSION:session"}).ValueOrDie());
+  PacketSet output_side_packets_2(
+      tool::CreateTagMap({"SESSION:session"}).ValueOrDie());
+  MP_ASSERT_OK(tool::RunGenerateAndValidateTypes(
+      "TensorFlowSessionFromFrozenGraphGenerator", extendable_options_,
+      input_side_packets, &output_side_packets_1));
+  MP_ASSERT_OK(tool::RunGenerateAndValidateTypes(
+      "TensorFlowSessionFromFrozenGraphGenerator", extendable_options_,
+      input_side_packets, &output_side_packets_2));
+  VerifySignatureMap(&output_side_packets_2);
+  EXPECT_EQ(output_side_packets_1.Tag("SESSION")
+                .Get<TensorFlowSession>()
+                .session.get(),
+            output_side_packets_2.Tag("SESSION")
+                .Get<TensorFlowSession>()
+                .session.get());
+
+  // Different options load a separate session.
+  generator_options_->add_initialization_op_names("multiplied:0");
+  PacketSet output_side_packets_3(
+      tool::CreateTagMap({"SESSION:session"}).ValueOrDie());
+  MP_ASSERT_OK(tool::RunGenerateAndValidateTypes(
+      "TensorFlowSessionFromFrozenGraphGenerator", extendable_options_,
+      input_side_packets, &output_side_packets_3));
+  EXPECT_NE(output_side_packets_1.Tag("SESSION")
+                .Get<TensorFlowSession>()
+                .session.get(),
+            output_side_packets_3.Tag("SESSION")
+                .Get<TensorFlowSession>()
+                .session.get());
+}
+
 }  // namespace
 }  // namespace mediapipe
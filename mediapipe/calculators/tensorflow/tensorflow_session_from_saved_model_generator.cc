@@ -17,14 +17,17 @@
 #if !defined(__ANDROID__)
 #include "mediapipe/framework/port/file_helpers.h"
 #endif
+#include "absl/strings/str_cat.h"
 #include "absl/strings/substitute.h"
 #include "mediapipe/calculators/tensorflow/tensorflow_session.h"
+#include "mediapipe/calculators/tensorflow/tensorflow_session_cache.h"
 #include "mediapipe/calculators/tensorflow/tensorflow_session_from_saved_model_generator.pb.h"
 #include "mediapipe/framework/deps/file_path.h"
 #include "mediapipe/framework/packet_generator.h"
 #include "mediapipe/framework/packet_type.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_macros.h"
 #include "mediapipe/framework/tool/status_util.h"
 #include "tensorflow/cc/saved_model/constants.h"
 #include "tensorflow/cc/saved_model/loader.h"
@@ -116,6 +119,31 @@ class TensorFlowSessionFromSavedModelGenerator : public PacketGenerator {
       RET_CHECK_OK(GetLatestDirectory(&path));
     }
 
+    auto load_session = [&options, &path](TensorFlowSession* session) {
+      return LoadSession(options, path, session);
+    };
+    std::unique_ptr<TensorFlowSession> session;
+    if (options.share_session()) {
+      ASSIGN_OR_RETURN(
+          session,
+          TensorFlowSessionCache::GetInstance()->GetOrLoad(
+              absl::StrCat("TensorFlowSessionFromSavedModelGenerator:", path,
+                           ":", options.SerializeAsString()),
+              load_session));
+    } else {
+      session = absl::make_unique<TensorFlowSession>();
+      MP_RETURN_IF_ERROR(load_session(session.get()));
+    }
+
+    output_side_packets->Tag("SESSION") = Adopt(session.release());
+    return ::mediapipe::OkStatus();
+  }
+
+ private:
+  // Loads the saved model at "path" into "session".
+  static ::mediapipe::Status LoadSession(
+      const TensorFlowSessionFromSavedModelGeneratorOptions& options,
+      const std::string& path, TensorFlowSession* session) {
     // Set user specified tags properly.
     // If no tags specified will use tensorflow::kSavedModelTagServe by default.
     std::unordered_set<std::string> tags_set;
@@ -138,7 +166,6 @@ class TensorFlowSessionFromSavedModelGenerator : public PacketGenerator {
           status.error_message());
     }
 
-    auto session = absl::make_unique<TensorFlowSession>();
     session->session = std::move(saved_model->session);
 
     RET_CHECK(!options.signature_name().empty());
@@ -152,8 +179,6 @@ class TensorFlowSessionFromSavedModelGenerator : public PacketGenerator {
       session->tag_to_tensor_map[MaybeConvertSignatureToTag(
           output_signature.first, options)] = output_signature.second.name();
     }
-
-    output_side_packets->Tag("SESSION") = Adopt(session.release());
     return ::mediapipe::OkStatus();
   }
 };
@@ -0,0 +1,248 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/calculators/tensorflow/tfrecord_reader_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/threadpool.h"
+#include "mediapipe/framework/tool/status_util.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/compression.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+
+namespace mediapipe {
+
+namespace tf = ::tensorflow;
+
+namespace {
+
+constexpr char kFilePatternTag[] = "FILE_PATTERN";
+constexpr char kSerializedRecordTag[] = "SERIALIZED_RECORD";
+constexpr char kSequenceExampleTag[] = "SEQUENCE_EXAMPLE";
+
+::mediapipe::Status FromTensorFlowStatus(const tf::Status& status) {
+  if (status.ok()) {
+    return ::mediapipe::OkStatus();
+  }
+  return ::mediapipe::Status(
+      static_cast<::mediapipe::StatusCode>(status.code()),
+      status.error_message());
+}
+
+std::string CompressionTypeString(
+    TFRecordReaderCalculatorOptions::CompressionType type) {
+  switch (type) {
+    case TFRecordReaderCalculatorOptions::ZLIB:
+      return tf::io::compression::kZlib;
+    case TFRecordReaderCalculatorOptions::GZIP:
+      return tf::io::compression::kGzip;
+    default:
+      return tf::io::compression::kNone;
+  }
+}
+
+}  // namespace
+
+// Source calculator that reads the records of a set of TFRecord files, such
+// as the shards of a dataset, and outputs them at consecutive timestamps
+// starting from 0.
+//
+// The files matching the glob in the FILE_PATTERN input side packet are read
+// on background threads, num_parallel_reads files at a time, and up to
+// prefetch_records records are buffered ahead of the graph. With a single
+// parallel read, the files are read one after the other in sorted order.
+// The records are output as strings on SERIALIZED_RECORD, parsed as
+// tf.SequenceExamples on SEQUENCE_EXAMPLE, or both.
+//
+// Example config:
+// node {
+//   calculator: "TFRecordReaderCalculator"
+//   input_side_packet: "FILE_PATTERN:input_file_pattern"
+//   output_stream: "SEQUENCE_EXAMPLE:sequence_example"
+//   options {
+//     [mediapipe.TFRecordReaderCalculatorOptions.ext]: {
+//       num_parallel_reads: 4
+//     }
+//   }
+// }
+class TFRecordReaderCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->InputSidePackets().Tag(kFilePatternTag).Set<std::string>();
+    RET_CHECK(cc->Outputs().HasTag(kSerializedRecordTag) ||
+              cc->Outputs().HasTag(kSequenceExampleTag))
+        << "At least one of SERIALIZED_RECORD and SEQUENCE_EXAMPLE must be "
+           "output.";
+    if (cc->Outputs().HasTag(kSerializedRecordTag)) {
+      cc->Outputs().Tag(kSerializedRecordTag).Set<std::string>();
+    }
+    if (cc->Outputs().HasTag(kSequenceExampleTag)) {
+      cc->Outputs().Tag(kSequenceExampleTag).Set<tf::SequenceExample>();
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    const auto& options = cc->Options<TFRecordReaderCalculatorOptions>();
+    RET_CHECK_GT(options.num_parallel_reads(), 0);
+    RET_CHECK_GT(options.prefetch_records(), 0);
+
+    const std::string& pattern =
+        cc->InputSidePackets().Tag(kFilePatternTag).Get<std::string>();
+    std::vector<std::string> paths;
+    MP_RETURN_IF_ERROR(FromTensorFlowStatus(
+        tf::Env::Default()->GetMatchingPaths(pattern, &paths)));
+    RET_CHECK(!paths.empty()) << "No file matches " << pattern;
+    std::sort(paths.begin(), paths.end());
+
+    reader_options_ = tf::io::RecordReaderOptions::CreateRecordReaderOptions(
+        CompressionTypeString(options.compression_type()));
+    if (options.read_buffer_size() > 0) {
+      reader_options_.buffer_size = options.read_buffer_size();
+    }
+    {
+      absl::MutexLock lock(&mutex_);
+      max_queued_records_ = options.prefetch_records();
+      num_files_remaining_ = paths.size();
+    }
+
+    read_pool_ = absl::make_unique<ThreadPool>(
+        "tfrecord_reader",
+        std::min<int>(options.num_parallel_reads(), paths.size()));
+    read_pool_->StartWorkers();
+    for (const std::string& path : paths) {
+      read_pool_->Schedule([this, path] { ReadFile(path); });
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    std::string record;
+    {
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(
+          this, &TFRecordReaderCalculator::RecordAvailableOrDone));
+      MP_RETURN_IF_ERROR(read_status_);
+      if (records_.empty()) {
+        return tool::StatusStop();
+      }
+      record = std::move(records_.front());
+      records_.pop_front();
+    }
+
+    const Timestamp timestamp(next_timestamp_++);
+    if (cc->Outputs().HasTag(kSequenceExampleTag)) {
+      auto example = absl::make_unique<tf::SequenceExample>();
+      RET_CHECK(example->ParseFromString(record))
+          << "Record " << timestamp.Value()
+          << " is not a serialized tf.SequenceExample.";
+      cc->Outputs()
+          .Tag(kSequenceExampleTag)
+          .Add(example.release(), timestamp);
+    }
+    if (cc->Outputs().HasTag(kSerializedRecordTag)) {
+      cc->Outputs()
+          .Tag(kSerializedRecordTag)
+          .Add(new std::string(std::move(record)), timestamp);
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Close(CalculatorContext* cc) override {
+    {
+      absl::MutexLock lock(&mutex_);
+      cancelled_ = true;
+    }
+    // Waits for the reads, which stop at their next record.
+    read_pool_.reset();
+    return ::mediapipe::OkStatus();
+  }
+
+ private:
+  bool RecordAvailableOrDone() EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return !records_.empty() || num_files_remaining_ == 0 ||
+           !read_status_.ok();
+  }
+
+  bool QueueHasRoomOrStopped() EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return records_.size() < max_queued_records_ || cancelled_ ||
+           !read_status_.ok();
+  }
+
+  // Runs on read_pool_ for each file.
+  void ReadFile(const std::string& path) LOCKS_EXCLUDED(mutex_) {
+    const ::mediapipe::Status status = ReadRecords(path);
+    absl::MutexLock lock(&mutex_);
+    if (!status.ok() && read_status_.ok()) {
+      read_status_ = status;
+    }
+    --num_files_remaining_;
+  }
+
+  // Queues the records of the file at "path" in records_, waiting while
+  // records_ is full.
+  ::mediapipe::Status ReadRecords(const std::string& path)
+      LOCKS_EXCLUDED(mutex_) {
+    std::unique_ptr<tf::RandomAccessFile> file;
+    MP_RETURN_IF_ERROR(FromTensorFlowStatus(
+        tf::Env::Default()->NewRandomAccessFile(path, &file)));
+    tf::io::RecordReader reader(file.get(), reader_options_);
+    tf::uint64 offset = 0;
+    while (true) {
+      std::string record;
+      const tf::Status status = reader.ReadRecord(&offset, &record);
+      if (tf::errors::IsOutOfRange(status)) {
+        return ::mediapipe::OkStatus();
+      }
+      MP_RETURN_IF_ERROR(FromTensorFlowStatus(status));
+
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(
+          this, &TFRecordReaderCalculator::QueueHasRoomOrStopped));
+      if (cancelled_ || !read_status_.ok()) {
+        return ::mediapipe::OkStatus();
+      }
+      records_.push_back(std::move(record));
+    }
+  }
+
+  tf::io::RecordReaderOptions reader_options_;
+  int64 next_timestamp_ = 0;
+
+  absl::Mutex mutex_;
+  std::deque<std::string> records_ GUARDED_BY(mutex_);
+  int max_queued_records_ GUARDED_BY(mutex_) = 0;
+  int num_files_remaining_ GUARDED_BY(mutex_) = 0;
+  // The first error reading a file.
+  ::mediapipe::Status read_status_ GUARDED_BY(mutex_);
+  // Set in Close() to stop the reads early.
+  bool cancelled_ GUARDED_BY(mutex_) = false;
+  // Declared after the state it uses, so that it is destroyed first.
+  std::unique_ptr<ThreadPool> read_pool_;
+};
+REGISTER_CALCULATOR(TFRecordReaderCalculator);
+
+}  // namespace mediapipe
@@ -0,0 +1,153 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+
+namespace mediapipe {
+namespace {
+
+namespace tf = ::tensorflow;
+
+constexpr int kNumShards = 3;
+constexpr int kRecordsPerShard = 10;
+
+std::string ShardPath(const std::string& prefix, int shard) {
+  return absl::StrCat(getenv("TEST_TMPDIR"), "/", prefix, "-", shard,
+                      ".tfrecord");
+}
+
+std::string RecordValue(int shard, int record) {
+  return absl::StrCat("shard ", shard, " record ", record);
+}
+
+// Writes kNumShards files of kRecordsPerShard serialized SequenceExamples,
+// each holding its RecordValue() as context feature "value".
+void WriteShards(const std::string& prefix, const std::string& compression) {
+  for (int shard = 0; shard < kNumShards; ++shard) {
+    std::unique_ptr<tf::WritableFile> file;
+    ASSERT_TRUE(
+        tf::Env::Default()->NewWritableFile(ShardPath(prefix, shard), &file)
+            .ok());
+    tf::io::RecordWriter writer(
+        file.get(),
+        tf::io::RecordWriterOptions::CreateRecordWriterOptions(compression));
+    for (int record = 0; record < kRecordsPerShard; ++record) {
+      tf::SequenceExample example;
+      (*example.mutable_context()->mutable_feature())["value"]
+          .mutable_bytes_list()
+          ->add_value(RecordValue(shard, record));
+      ASSERT_TRUE(writer.WriteRecord(example.SerializeAsString()).ok());
+    }
+    ASSERT_TRUE(writer.Close().ok());
+    ASSERT_TRUE(file->Close().ok());
+  }
+}
+
+std::string GetValue(const tf::SequenceExample& example) {
+  return example.context().feature().at("value").bytes_list().value(0);
+}
+
+TEST(TFRecordReaderCalculatorTest, ReadsShardsInOrder) {
+  WriteShards("in_order", "");
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+    calculator: "TFRecordReaderCalculator"
+    input_side_packet: "FILE_PATTERN:pattern"
+    output_stream: "SEQUENCE_EXAMPLE:examples"
+    output_stream: "SERIALIZED_RECORD:records"
+    options {
+      [mediapipe.TFRecordReaderCalculatorOptions.ext]: { prefetch_records: 2 }
+    }
+  )"));
+  runner.MutableSidePackets()->Tag("FILE_PATTERN") = MakePacket<std::string>(
+      absl::StrCat(getenv("TEST_TMPDIR"), "/in_order-*.tfrecord"));
+  MP_ASSERT_OK(runner.Run());
+
+  const std::vector<Packet>& examples =
+      runner.Outputs().Tag("SEQUENCE_EXAMPLE").packets;
+  const std::vector<Packet>& records =
+      runner.Outputs().Tag("SERIALIZED_RECORD").packets;
+  ASSERT_EQ(kNumShards * kRecordsPerShard, examples.size());
+  ASSERT_EQ(kNumShards * kRecordsPerShard, records.size());
+  for (int i = 0; i < examples.size(); ++i) {
+    EXPECT_EQ(Timestamp(i), examples[i].Timestamp());
+    const tf::SequenceExample& example = examples[i].Get<tf::SequenceExample>();
+    EXPECT_EQ(RecordValue(i / kRecordsPerShard, i % kRecordsPerShard),
+              GetValue(example));
+    EXPECT_EQ(example.SerializeAsString(), records[i].Get<std::string>());
+  }
+}
+
+TEST(TFRecordReaderCalculatorTest, ReadsCompressedShardsInParallel) {
+  WriteShards("parallel", "GZIP");
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+    calculator: "TFRecordReaderCalculator"
+    input_side_packet: "FILE_PATTERN:pattern"
+    output_stream: "SEQUENCE_EXAMPLE:examples"
+    options {
+      [mediapipe.TFRecordReaderCalculatorOptions.ext]: {
+        compression_type: GZIP
+        num_parallel_reads: 3
+      }
+    }
+  )"));
+  runner.MutableSidePackets()->Tag("FILE_PATTERN") = MakePacket<std::string>(
+      absl::StrCat(getenv("TEST_TMPDIR"), "/parallel-*.tfrecord"));
+  MP_ASSERT_OK(runner.Run());
+
+  // The shards are interleaved, but each is read in order.
+  std::vector<int> next_record(kNumShards, 0);
+  const std::vector<Packet>& examples =
+      runner.Outputs().Tag("SEQUENCE_EXAMPLE").packets;
+  for (const Packet& packet : examples) {
+    const std::string value = GetValue(packet.Get<tf::SequenceExample>());
+    bool matched = false;
+    for (int shard = 0; shard < kNumShards; ++shard) {
+      if (next_record[shard] < kRecordsPerShard &&
+          value == RecordValue(shard, next_record[shard])) {
+        ++next_record[shard];
+        matched = true;
+      }
+    }
+    EXPECT_TRUE(matched) << value;
+  }
+  EXPECT_THAT(next_record, ::testing::Each(kRecordsPerShard));
+}
+
+TEST(TFRecordReaderCalculatorTest, FailsWithoutMatchingFiles) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+    calculator: "TFRecordReaderCalculator"
+    input_side_packet: "FILE_PATTERN:pattern"
+    output_stream: "SERIALIZED_RECORD:records"
+  )"));
+  runner.MutableSidePackets()->Tag("FILE_PATTERN") = MakePacket<std::string>(
+      absl::StrCat(getenv("TEST_TMPDIR"), "/missing-*.tfrecord"));
+  EXPECT_FALSE(runner.Run().ok());
+}
+
+}  // namespace
+}  // namespace mediapipe
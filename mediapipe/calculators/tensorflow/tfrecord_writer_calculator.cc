@@ -0,0 +1,190 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+
+#include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/calculators/tensorflow/tfrecord_writer_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/threadpool.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/lib/io/compression.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+
+namespace mediapipe {
+
+namespace tf = ::tensorflow;
+
+namespace {
+
+constexpr char kFilePathTag[] = "FILE_PATH";
+constexpr char kSerializedRecordTag[] = "SERIALIZED_RECORD";
+constexpr char kSequenceExampleTag[] = "SEQUENCE_EXAMPLE";
+
+::mediapipe::Status FromTensorFlowStatus(const tf::Status& status) {
+  if (status.ok()) {
+    return ::mediapipe::OkStatus();
+  }
+  return ::mediapipe::Status(
+      static_cast<::mediapipe::StatusCode>(status.code()),
+      status.error_message());
+}
+
+std::string CompressionTypeString(
+    TFRecordWriterCalculatorOptions::CompressionType type) {
+  switch (type) {
+    case TFRecordWriterCalculatorOptions::ZLIB:
+      return tf::io::compression::kZlib;
+    case TFRecordWriterCalculatorOptions::GZIP:
+      return tf::io::compression::kGzip;
+    default:
+      return tf::io::compression::kNone;
+  }
+}
+
+}  // namespace
+
+// Sink calculator that writes each packet of its input stream as a record of
+// the TFRecord file at the FILE_PATH input side packet. The input stream is
+// either SERIALIZED_RECORD, holding the records as strings, or
+// SEQUENCE_EXAMPLE, holding tf.SequenceExamples to serialize.
+//
+// Unless max_queued_records is 0, the records are serialized and written on
+// a background thread, so that Process() only blocks once that many records
+// are waiting to be written. Write errors are then returned by a later call
+// to Process() or by Close(), which waits for all the records to be written.
+//
+// Example config:
+// node {
+//   calculator: "TFRecordWriterCalculator"
+//   input_side_packet: "FILE_PATH:output_file_path"
+//   input_stream: "SEQUENCE_EXAMPLE:sequence_example"
+//   options {
+//     [mediapipe.TFRecordWriterCalculatorOptions.ext]: {
+//       compression_type: GZIP
+//     }
+//   }
+// }
+class TFRecordWriterCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->InputSidePackets().Tag(kFilePathTag).Set<std::string>();
+    RET_CHECK(cc->Inputs().HasTag(kSerializedRecordTag) ^
+              cc->Inputs().HasTag(kSequenceExampleTag))
+        << "Exactly one of SERIALIZED_RECORD and SEQUENCE_EXAMPLE must be "
+           "input.";
+    if (cc->Inputs().HasTag(kSerializedRecordTag)) {
+      cc->Inputs().Tag(kSerializedRecordTag).Set<std::string>();
+    }
+    if (cc->Inputs().HasTag(kSequenceExampleTag)) {
+      cc->Inputs().Tag(kSequenceExampleTag).Set<tf::SequenceExample>();
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    const auto& options = cc->Options<TFRecordWriterCalculatorOptions>();
+    RET_CHECK_GE(options.max_queued_records(), 0);
+
+    const std::string& path =
+        cc->InputSidePackets().Tag(kFilePathTag).Get<std::string>();
+    MP_RETURN_IF_ERROR(FromTensorFlowStatus(
+        tf::Env::Default()->NewWritableFile(path, &file_)));
+    writer_ = absl::make_unique<tf::io::RecordWriter>(
+        file_.get(), tf::io::RecordWriterOptions::CreateRecordWriterOptions(
+                         CompressionTypeString(options.compression_type())));
+    input_tag_ = cc->Inputs().HasTag(kSerializedRecordTag)
+                     ? kSerializedRecordTag
+                     : kSequenceExampleTag;
+
+    if (options.max_queued_records() > 0) {
+      max_queued_records_ = options.max_queued_records();
+      // A single thread writes the records in FIFO order.
+      write_pool_ = absl::make_unique<ThreadPool>("tfrecord_writer", 1);
+      write_pool_->StartWorkers();
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    const Packet& packet = cc->Inputs().Tag(input_tag_).Value();
+    if (!write_pool_) {
+      return WriteRecord(packet);
+    }
+
+    absl::MutexLock lock(&mutex_);
+    mutex_.Await(
+        absl::Condition(this, &TFRecordWriterCalculator::QueueHasRoomOrFailed));
+    MP_RETURN_IF_ERROR(write_status_);
+    ++num_queued_records_;
+    // The packet keeps the record alive until it is written.
+    write_pool_->Schedule([this, packet] {
+      const ::mediapipe::Status status = WriteRecord(packet);
+      absl::MutexLock lock(&mutex_);
+      if (!status.ok() && write_status_.ok()) {
+        write_status_ = status;
+      }
+      --num_queued_records_;
+    });
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Close(CalculatorContext* cc) override {
+    // Waits for the queued records to be written.
+    write_pool_.reset();
+    {
+      absl::MutexLock lock(&mutex_);
+      MP_RETURN_IF_ERROR(write_status_);
+    }
+    MP_RETURN_IF_ERROR(FromTensorFlowStatus(writer_->Close()));
+    writer_.reset();
+    return FromTensorFlowStatus(file_->Close());
+  }
+
+ private:
+  bool QueueHasRoomOrFailed() EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return num_queued_records_ < max_queued_records_ || !write_status_.ok();
+  }
+
+  ::mediapipe::Status WriteRecord(const Packet& packet) {
+    if (input_tag_ == kSerializedRecordTag) {
+      return FromTensorFlowStatus(
+          writer_->WriteRecord(packet.Get<std::string>()));
+    }
+    std::string record;
+    RET_CHECK(packet.Get<tf::SequenceExample>().SerializeToString(&record));
+    return FromTensorFlowStatus(writer_->WriteRecord(record));
+  }
+
+  std::unique_ptr<tf::WritableFile> file_;
+  std::unique_ptr<tf::io::RecordWriter> writer_;
+  std::string input_tag_;
+
+  absl::Mutex mutex_;
+  int num_queued_records_ GUARDED_BY(mutex_) = 0;
+  int max_queued_records_ = 0;
+  // The first error writing a queued record.
+  ::mediapipe::Status write_status_ GUARDED_BY(mutex_);
+  // Declared after the state it uses, so that it is destroyed first.
+  std::unique_ptr<ThreadPool> write_pool_;
+};
+REGISTER_CALCULATOR(TFRecordWriterCalculator);
+
+}  // namespace mediapipe
@@ -0,0 +1,138 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/calculators/tensorflow/tfrecord_writer_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+
+namespace mediapipe {
+namespace {
+
+namespace tf = ::tensorflow;
+
+constexpr int kNumRecords = 50;
+
+std::vector<std::string> ReadRecords(const std::string& path,
+                                     const std::string& compression) {
+  std::vector<std::string> records;
+  std::unique_ptr<tf::RandomAccessFile> file;
+  EXPECT_TRUE(tf::Env::Default()->NewRandomAccessFile(path, &file).ok());
+  tf::io::RecordReader reader(
+      file.get(),
+      tf::io::RecordReaderOptions::CreateRecordReaderOptions(compression));
+  tf::uint64 offset = 0;
+  std::string record;
+  tf::Status status;
+  while ((status = reader.ReadRecord(&offset, &record)).ok()) {
+    records.push_back(record);
+  }
+  EXPECT_TRUE(tf::errors::IsOutOfRange(status)) << status.ToString();
+  return records;
+}
+
+class TFRecordWriterCalculatorTest : public ::testing::Test {
+ protected:
+  // Writes kNumRecords SequenceExamples to "path" and returns them
+  // serialized.
+  std::vector<std::string> WriteSequenceExamples(
+      const TFRecordWriterCalculatorOptions& options, const std::string& path) {
+    CalculatorGraphConfig::Node config;
+    config.set_calculator("TFRecordWriterCalculator");
+    config.add_input_side_packet("FILE_PATH:path");
+    config.add_input_stream("SEQUENCE_EXAMPLE:examples");
+    *config.mutable_options()->MutableExtension(
+        TFRecordWriterCalculatorOptions::ext) = options;
+    CalculatorRunner runner(config);
+    std::vector<std::string> expected;
+    for (int i = 0; i < kNumRecords; ++i) {
+      auto example = absl::make_unique<tf::SequenceExample>();
+      (*example->mutable_context()->mutable_feature())["index"]
+          .mutable_int64_list()
+          ->add_value(i);
+      expected.push_back(example->SerializeAsString());
+      runner.MutableInputs()
+          ->Tag("SEQUENCE_EXAMPLE")
+          .packets.push_back(Adopt(example.release()).At(Timestamp(i)));
+    }
+    runner.MutableSidePackets()->Tag("FILE_PATH") =
+        MakePacket<std::string>(path);
+    MP_EXPECT_OK(runner.Run());
+    return expected;
+  }
+};
+
+TEST_F(TFRecordWriterCalculatorTest, WritesRecordsAsynchronously) {
+  const std::string path =
+      absl::StrCat(getenv("TEST_TMPDIR"), "/async.tfrecord");
+  TFRecordWriterCalculatorOptions options;
+  options.set_max_queued_records(4);
+  std::vector<std::string> expected = WriteSequenceExamples(options, path);
+  EXPECT_EQ(expected, ReadRecords(path, ""));
+}
+
+TEST_F(TFRecordWriterCalculatorTest, WritesRecordsSynchronously) {
+  const std::string path =
+      absl::StrCat(getenv("TEST_TMPDIR"), "/sync.tfrecord");
+  TFRecordWriterCalculatorOptions options;
+  options.set_max_queued_records(0);
+  std::vector<std::string> expected = WriteSequenceExamples(options, path);
+  EXPECT_EQ(expected, ReadRecords(path, ""));
+}
+
+TEST_F(TFRecordWriterCalculatorTest, WritesCompressedRecords) {
+  const std::string path =
+      absl::StrCat(getenv("TEST_TMPDIR"), "/compressed.tfrecord.gz");
+  TFRecordWriterCalculatorOptions options;
+  options.set_compression_type(TFRecordWriterCalculatorOptions::GZIP);
+  std::vector<std::string> expected = WriteSequenceExamples(options, path);
+  EXPECT_EQ(expected, ReadRecords(path, "GZIP"));
+}
+
+TEST_F(TFRecordWriterCalculatorTest, WritesSerializedRecords) {
+  const std::string path =
+      absl::StrCat(getenv("TEST_TMPDIR"), "/serialized.tfrecord");
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+    calculator: "TFRecordWriterCalculator"
+    input_side_packet: "FILE_PATH:path"
+    input_stream: "SERIALIZED_RECORD:records"
+  )"));
+  std::vector<std::string> expected;
+  for (int i = 0; i < kNumRecords; ++i) {
+    expected.push_back(absl::StrCat("record ", i));
+    runner.MutableInputs()
+        ->Tag("SERIALIZED_RECORD")
+        .packets.push_back(MakePacket<std::string>(expected.back())
+                               .At(Timestamp(i)));
+  }
+  runner.MutableSidePackets()->Tag("FILE_PATH") = MakePacket<std::string>(path);
+  MP_ASSERT_OK(runner.Run());
+  EXPECT_EQ(expected, ReadRecords(path, ""));
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -12,6 +12,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
 #include "absl/strings/match.h"
 #include "mediapipe/calculators/core/packet_resampler_calculator.pb.h"
 #include "mediapipe/calculators/tensorflow/unpack_media_sequence_calculator.pb.h"
@@ -19,6 +26,7 @@
 #include "mediapipe/framework/formats/location.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_macros.h"
 #include "mediapipe/util/sequence/media_sequence.h"
 #include "tensorflow/core/example/example.pb.h"
 #include "tensorflow/core/example/feature.pb.h"
@@ -33,6 +41,7 @@ const char kForwardFlowImageTag[] = "FORWARD_FLOW_ENCODED";
 
 // Side Packets:
 const char kSequenceExampleTag[] = "SEQUENCE_EXAMPLE";
+const char kSequenceExamplePathTag[] = "SEQUENCE_EXAMPLE_PATH";
 const char kDatasetRootDirTag[] = "DATASET_ROOT";
 const char kDataPath[] = "DATA_PATH";
 const char kPacketResamplerOptions[] = "RESAMPLER_OPTIONS";
@@ -41,6 +50,253 @@ const char kImagesFrameRateTag[] = "IMAGE_FRAME_RATE";
 namespace tf = ::tensorflow;
 namespace mpms = ::mediapipe::mediasequence;
 
+namespace {
+
+// Reads a base 128 varint from "in".
+bool ReadVarint(std::istream* in, uint64* value) {
+  *value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    const int byte = in->get();
+    if (byte == std::char_traits<char>::eof()) {
+      return false;
+    }
+    *value |= static_cast<uint64>(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// A tf.SequenceExample serialized in a file, whose feature lists are read
+// from the file as they are needed rather than parsed up front.
+//
+// Opening the file only indexes the byte range of each Feature in the
+// feature lists, parsing the context and the timestamps. The skeleton holds
+// an empty Feature for every other Feature, until it is loaded. The wire
+// format is walked directly, because the file may exceed the 2GB limit of
+// the protobuf parser.
+class LazySequenceExample {
+ public:
+  // Indexes the SequenceExample at "path". If "is_tfrecord" is true, the file
+  // holds the SequenceExample as its first TFRecord.
+  ::mediapipe::Status Open(const std::string& path, bool is_tfrecord) {
+    file_.open(path, std::ios::binary);
+    RET_CHECK(file_.is_open()) << "Could not open " << path;
+    file_.seekg(0, std::ios::end);
+    const int64 file_size = file_.tellg();
+    file_.seekg(0);
+    int64 end = file_size;
+    if (is_tfrecord) {
+      // A TFRecord starts with the little-endian uint64 length of its data
+      // followed by a uint32 checksum of the length.
+      char header[12];
+      RET_CHECK(file_.read(header, sizeof(header))) << "Truncated " << path;
+      uint64 length = 0;
+      for (int i = 7; i >= 0; --i) {
+        length = (length << 8) | static_cast<uint8>(header[i]);
+      }
+      end = sizeof(header) + length;
+      RET_CHECK_LE(end, file_size) << "Truncated " << path;
+    }
+
+    while (Position() < end) {
+      int field;
+      int wire_type;
+      MP_RETURN_IF_ERROR(ReadTag(&field, &wire_type));
+      if (field == 1 && wire_type == kLengthDelimited) {
+        std::string context;
+        MP_RETURN_IF_ERROR(ReadLengthDelimited(&context));
+        RET_CHECK(skeleton_.mutable_context()->MergeFromString(context));
+      } else if (field == 2 && wire_type == kLengthDelimited) {
+        int64 length;
+        MP_RETURN_IF_ERROR(ReadLength(&length));
+        MP_RETURN_IF_ERROR(IndexFeatureLists(Position() + length));
+      } else {
+        MP_RETURN_IF_ERROR(SkipField(wire_type));
+      }
+    }
+
+    auto* feature_lists =
+        skeleton_.mutable_feature_lists()->mutable_feature_list();
+    for (const auto& key_ranges : feature_ranges_) {
+      const bool is_timestamp =
+          absl::StrContains(key_ranges.first, "/timestamp");
+      tf::FeatureList* feature_list = &(*feature_lists)[key_ranges.first];
+      for (const Range& range : key_ranges.second) {
+        tf::Feature* feature = feature_list->add_feature();
+        if (is_timestamp) {
+          MP_RETURN_IF_ERROR(ReadFeature(range, feature));
+        }
+      }
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  const tf::SequenceExample& skeleton() const { return skeleton_; }
+
+  // Loads the Features at "index" of the feature lists starting with
+  // "prefix/", such as those of the images timestamped by "prefix/timestamp".
+  ::mediapipe::Status LoadFeaturesAt(const std::string& prefix, int index) {
+    auto* feature_lists =
+        skeleton_.mutable_feature_lists()->mutable_feature_list();
+    for (const auto& key_ranges : feature_ranges_) {
+      if (IsLazyFeatureOf(key_ranges.first, prefix) &&
+          index < key_ranges.second.size()) {
+        MP_RETURN_IF_ERROR(
+            ReadFeature(key_ranges.second[index],
+                        (*feature_lists)[key_ranges.first].mutable_feature(
+                            index)));
+      }
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  // Releases the Features loaded by LoadFeaturesAt().
+  void ReleaseFeaturesAt(const std::string& prefix, int index) {
+    auto* feature_lists =
+        skeleton_.mutable_feature_lists()->mutable_feature_list();
+    for (const auto& key_ranges : feature_ranges_) {
+      if (IsLazyFeatureOf(key_ranges.first, prefix) &&
+          index < key_ranges.second.size()) {
+        (*feature_lists)[key_ranges.first].mutable_feature(index)->Clear();
+      }
+    }
+  }
+
+ private:
+  static constexpr int kLengthDelimited = 2;
+
+  // The location of a serialized Feature in the file.
+  struct Range {
+    int64 offset;
+    int64 length;
+  };
+
+  static bool IsLazyFeatureOf(const std::string& key,
+                              const std::string& prefix) {
+    return absl::StartsWith(key, prefix) && key.size() > prefix.size() &&
+           key[prefix.size()] == '/' &&
+           !absl::StrContains(key, "/timestamp");
+  }
+
+  int64 Position() { return static_cast<int64>(file_.tellg()); }
+
+  ::mediapipe::Status ReadTag(int* field, int* wire_type) {
+    uint64 tag;
+    RET_CHECK(ReadVarint(&file_, &tag)) << "Malformed SequenceExample.";
+    *field = static_cast<int>(tag >> 3);
+    *wire_type = static_cast<int>(tag & 7);
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status ReadLength(int64* length) {
+    uint64 value;
+    RET_CHECK(ReadVarint(&file_, &value)) << "Malformed SequenceExample.";
+    *length = static_cast<int64>(value);
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status ReadLengthDelimited(std::string* value) {
+    int64 length;
+    MP_RETURN_IF_ERROR(ReadLength(&length));
+    value->resize(length);
+    RET_CHECK(file_.read(&(*value)[0], length))
+        << "Malformed SequenceExample.";
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status SkipField(int wire_type) {
+    uint64 value;
+    int64 length;
+    switch (wire_type) {
+      case 0:
+        RET_CHECK(ReadVarint(&file_, &value)) << "Malformed SequenceExample.";
+        return ::mediapipe::OkStatus();
+      case 1:
+        file_.seekg(8, std::ios::cur);
+        return ::mediapipe::OkStatus();
+      case kLengthDelimited:
+        MP_RETURN_IF_ERROR(ReadLength(&length));
+        file_.seekg(length, std::ios::cur);
+        return ::mediapipe::OkStatus();
+      case 5:
+        file_.seekg(4, std::ios::cur);
+        return ::mediapipe::OkStatus();
+      default:
+        return ::mediapipe::InvalidArgumentError(
+            absl::StrCat("Unsupported wire type ", wire_type,
+                         " in SequenceExample."));
+    }
+  }
+
+  // Indexes the map entries of a FeatureLists message ending at "end".
+  ::mediapipe::Status IndexFeatureLists(int64 end) {
+    while (Position() < end) {
+      int field;
+      int wire_type;
+      MP_RETURN_IF_ERROR(ReadTag(&field, &wire_type));
+      if (field == 1 && wire_type == kLengthDelimited) {
+        int64 length;
+        MP_RETURN_IF_ERROR(ReadLength(&length));
+        MP_RETURN_IF_ERROR(IndexFeatureListEntry(Position() + length));
+      } else {
+        MP_RETURN_IF_ERROR(SkipField(wire_type));
+      }
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  // Indexes the Features of a map entry, holding the key and FeatureList,
+  // ending at "end".
+  ::mediapipe::Status IndexFeatureListEntry(int64 end) {
+    std::string key;
+    std::vector<Range> ranges;
+    while (Position() < end) {
+      int field;
+      int wire_type;
+      MP_RETURN_IF_ERROR(ReadTag(&field, &wire_type));
+      if (field == 1 && wire_type == kLengthDelimited) {
+        MP_RETURN_IF_ERROR(ReadLengthDelimited(&key));
+      } else if (field == 2 && wire_type == kLengthDelimited) {
+        int64 length;
+        MP_RETURN_IF_ERROR(ReadLength(&length));
+        const int64 feature_list_end = Position() + length;
+        while (Position() < feature_list_end) {
+          MP_RETURN_IF_ERROR(ReadTag(&field, &wire_type));
+          if (field == 1 && wire_type == kLengthDelimited) {
+            MP_RETURN_IF_ERROR(ReadLength(&length));
+            ranges.push_back({Position(), length});
+            file_.seekg(length, std::ios::cur);
+          } else {
+            MP_RETURN_IF_ERROR(SkipField(wire_type));
+          }
+        }
+      } else {
+        MP_RETURN_IF_ERROR(SkipField(wire_type));
+      }
+    }
+    feature_ranges_[key] = std::move(ranges);
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status ReadFeature(const Range& range, tf::Feature* feature) {
+    std::string serialized(range.length, '\0');
+    file_.seekg(range.offset);
+    RET_CHECK(file_.read(&serialized[0], range.length))
+        << "Malformed SequenceExample.";
+    RET_CHECK(feature->ParseFromString(serialized))
+        << "Malformed SequenceExample.";
+    return ::mediapipe::OkStatus();
+  }
+
+  std::ifstream file_;
+  tf::SequenceExample skeleton_;
+  std::map<std::string, std::vector<Range>> feature_ranges_;
+};
+
+}  // namespace
+
 // Source calculator to unpack side_packets and streams from tf.SequenceExamples
 //
 // Often, only side_packets or streams need to be output, but both can be output
@@ -49,6 +305,13 @@ namespace mpms = ::mediapipe::mediasequence;
 // media_sequence.h. This documentation will first describe the side_packets
 // the calculator can output, and then describe the streams.
 //
+// Instead of the SEQUENCE_EXAMPLE, a SEQUENCE_EXAMPLE_PATH input_side_packet
+// can give the path to a file holding the serialized SequenceExample, or
+// holding it as its first TFRecord if sequence_example_path_is_tfrecord is
+// set. The feature lists are then read from the file as their packets are
+// output, so that the images of large SequenceExamples are never all held in
+// memory. Only the context and timestamps are read when the graph starts.
+//
 // Side_packets are commonly used to specify which clip to extract data from.
 // Seeking into a video does not necessarily provide consistent timestamps when
 // resampling to a known rate. To enable consistent timestamps, we unpack the
@@ -117,8 +380,17 @@ class UnpackMediaSequenceCalculator : public CalculatorBase {
  public:
   static ::mediapipe::Status GetContract(CalculatorContract* cc) {
     const auto& options = cc->Options<UnpackMediaSequenceCalculatorOptions>();
-    RET_CHECK(cc->InputSidePackets().HasTag(kSequenceExampleTag));
-    cc->InputSidePackets().Tag(kSequenceExampleTag).Set<tf::SequenceExample>();
+    RET_CHECK(cc->InputSidePackets().HasTag(kSequenceExampleTag) !=
+              cc->InputSidePackets().HasTag(kSequenceExamplePathTag))
+        << "Exactly one of " << kSequenceExampleTag << " or "
+        << kSequenceExamplePathTag << " must be provided.";
+    if (cc->InputSidePackets().HasTag(kSequenceExampleTag)) {
+      cc->InputSidePackets()
+          .Tag(kSequenceExampleTag)
+          .Set<tf::SequenceExample>();
+    } else {
+      cc->InputSidePackets().Tag(kSequenceExamplePathTag).Set<std::string>();
+    }
     // Optional side inputs.
     if (cc->InputSidePackets().HasTag(kDatasetRootDirTag)) {
       cc->InputSidePackets().Tag(kDatasetRootDirTag).Set<std::string>();
@@ -179,9 +451,20 @@ class UnpackMediaSequenceCalculator : public CalculatorBase {
   }
 
   ::mediapipe::Status Open(CalculatorContext* cc) override {
-    // Copy the packet to copy the otherwise inaccessible shared ptr.
-    example_packet_holder_ = cc->InputSidePackets().Tag(kSequenceExampleTag);
-    sequence_ = &example_packet_holder_.Get<tf::SequenceExample>();
+    const auto& options = cc->Options<UnpackMediaSequenceCalculatorOptions>();
+    if (cc->InputSidePackets().HasTag(kSequenceExamplePathTag)) {
+      lazy_sequence_ = absl::make_unique<LazySequenceExample>();
+      const std::string& path = cc->InputSidePackets()
+                                    .Tag(kSequenceExamplePathTag)
+                                    .Get<std::string>();
+      MP_RETURN_IF_ERROR(lazy_sequence_->Open(
+          path, options.sequence_example_path_is_tfrecord()));
+      sequence_ = &lazy_sequence_->skeleton();
+    } else {
+      // Copy the packet to copy the otherwise inaccessible shared ptr.
+      example_packet_holder_ = cc->InputSidePackets().Tag(kSequenceExampleTag);
+      sequence_ = &example_packet_holder_.Get<tf::SequenceExample>();
+    }
 
     // Collect the timestamps for all streams keyed by the timestamp feature's
     // key. While creating this data structure we also identify the last
@@ -230,12 +513,11 @@ class UnpackMediaSequenceCalculator : public CalculatorBase {
           << sequence_->DebugString();
     }
     current_timestamp_index_ = 0;
+    next_indices_.clear();
+    MP_RETURN_IF_ERROR(ResolveKeyOutputs(cc));
 
     // Determine the data path and output it.
-    const auto& options = cc->Options<UnpackMediaSequenceCalculatorOptions>();
-    const auto& sequence = cc->InputSidePackets()
-                               .Tag(kSequenceExampleTag)
-                               .Get<tensorflow::SequenceExample>();
+    const auto& sequence = *sequence_;
     if (cc->OutputSidePackets().HasTag(kDataPath)) {
       std::string root_directory = "";
       if (cc->InputSidePackets().HasTag(kDatasetRootDirTag)) {
@@ -304,6 +586,68 @@ class UnpackMediaSequenceCalculator : public CalculatorBase {
     return ::mediapipe::OkStatus();
   }
 
+  // Fills key_outputs_ with the output streams of each timestamp key, and
+  // looks up the feature lists they read once, rather than for each packet.
+  ::mediapipe::Status ResolveKeyOutputs(CalculatorContext* cc) {
+    key_outputs_.clear();
+    for (const auto& map_kv : timestamps_) {
+      const std::string& key = map_kv.first;
+      KeyOutputs& outputs = key_outputs_[key];
+      outputs.lazy_prefix = key.substr(0, key.rfind("/timestamp"));
+      const std::vector<std::string> pieces = absl::StrSplit(key, '/');
+
+      if (absl::StrContains(key, mpms::GetImageTimestampKey())) {
+        std::string feature_key = "";
+        std::string possible_tag = kImageTag;
+        if (pieces[0] != "image") {
+          feature_key = pieces[0];
+          possible_tag = absl::StrCat(kImageTag, "_", feature_key);
+        }
+        if (cc->Outputs().HasTag(possible_tag)) {
+          outputs.image_tag = possible_tag;
+          outputs.images = mpms::GetImageEncodedView(feature_key, *sequence_);
+        }
+      }
+
+      if (cc->Outputs().HasTag(kForwardFlowImageTag) &&
+          key == mpms::GetForwardFlowTimestampKey()) {
+        outputs.forward_flow = true;
+        outputs.forward_flow_images =
+            mpms::GetForwardFlowEncodedView(*sequence_);
+      }
+
+      if (absl::StrContains(key, mpms::GetBBoxTimestampKey())) {
+        std::string feature_key = "";
+        std::string possible_tag = kBBoxTag;
+        if (pieces[0] != "region") {
+          feature_key = pieces[0];
+          possible_tag = absl::StrCat(kBBoxTag, "_", feature_key);
+        }
+        if (cc->Outputs().HasTag(possible_tag)) {
+          outputs.bbox_tag = possible_tag;
+          outputs.bbox_xmins = mpms::GetBBoxXMinView(feature_key, *sequence_);
+          outputs.bbox_ymins = mpms::GetBBoxYMinView(feature_key, *sequence_);
+          outputs.bbox_xmaxs = mpms::GetBBoxXMaxView(feature_key, *sequence_);
+          outputs.bbox_ymaxs = mpms::GetBBoxYMaxView(feature_key, *sequence_);
+        }
+      }
+
+      if (absl::StrContains(key, "feature")) {
+        RET_CHECK_GT(pieces.size(), 1)
+            << "Failed to parse the feature substring before / from key "
+            << key;
+        const std::string& feature_key = pieces[0];
+        std::string possible_tag = kFloatFeaturePrefixTag + feature_key;
+        if (cc->Outputs().HasTag(possible_tag)) {
+          outputs.float_feature_tag = possible_tag;
+          outputs.float_features =
+              mpms::GetFeatureFloatsView(feature_key, *sequence_);
+        }
+      }
+    }
+    return ::mediapipe::OkStatus();
+  }
+
   ::mediapipe::Status Process(CalculatorContext* cc) override {
     if (timestamps_.empty()) {
       // This occurs when we only have metadata to unpack.
@@ -329,72 +673,62 @@ class UnpackMediaSequenceCalculator : public CalculatorBase {
     }
 
     for (const auto& map_kv : timestamps_) {
-      for (int i = 0; i < map_kv.second.size(); ++i) {
-        if (map_kv.second[i] >= start_timestamp &&
-            map_kv.second[i] < end_timestamp) {
+      const KeyOutputs& outputs = key_outputs_[map_kv.first];
+      // Timestamps are sequential for each key, so the packets of this
+      // window start where the previous window ended.
+      int& next_index = next_indices_[map_kv.first];
+      for (; next_index < map_kv.second.size() &&
+             map_kv.second[next_index] < end_timestamp;
+           ++next_index) {
+        const int i = next_index;
+        if (map_kv.second[i] >= start_timestamp) {
+          if (lazy_sequence_) {
+            MP_RETURN_IF_ERROR(
+                lazy_sequence_->LoadFeaturesAt(outputs.lazy_prefix, i));
+          }
           const Timestamp current_timestamp =
               map_kv.second[i] == Timestamp::PostStream().Value()
                   ? Timestamp::PostStream()
                   : Timestamp(map_kv.second[i]);
 
-          if (absl::StrContains(map_kv.first, mpms::GetImageTimestampKey())) {
-            std::vector<std::string> pieces = absl::StrSplit(map_kv.first, '/');
-            std::string feature_key = "";
-            std::string possible_tag = kImageTag;
-            if (pieces[0] != "image") {
-              feature_key = pieces[0];
-              possible_tag = absl::StrCat(kImageTag, "_", feature_key);
-            }
-            if (cc->Outputs().HasTag(possible_tag)) {
-              cc->Outputs()
-                  .Tag(possible_tag)
-                  .Add(new std::string(
-                           mpms::GetImageEncodedAt(feature_key, *sequence_, i)),
-                       current_timestamp);
-            }
+          if (!outputs.image_tag.empty()) {
+            cc->Outputs()
+                .Tag(outputs.image_tag)
+                .Add(new std::string(outputs.images.GetBytesAt(i).Get(0)),
+                     current_timestamp);
           }
-
-          if (cc->Outputs().HasTag(kForwardFlowImageTag) &&
-              map_kv.first == mpms::GetForwardFlowTimestampKey()) {
+          if (outputs.forward_flow) {
             cc->Outputs()
                 .Tag(kForwardFlowImageTag)
                 .Add(new std::string(
-                         mpms::GetForwardFlowEncodedAt(*sequence_, i)),
+                         outputs.forward_flow_images.GetBytesAt(i).Get(0)),
                      current_timestamp);
           }
-          if (absl::StrContains(map_kv.first, mpms::GetBBoxTimestampKey())) {
-            std::vector<std::string> pieces = absl::StrSplit(map_kv.first, '/');
-            std::string feature_key = "";
-            std::string possible_tag = kBBoxTag;
-            if (pieces[0] != "region") {
-              feature_key = pieces[0];
-              possible_tag = absl::StrCat(kBBoxTag, "_", feature_key);
-            }
-            if (cc->Outputs().HasTag(possible_tag)) {
-              const auto& bboxes = mpms::GetBBoxAt(feature_key, *sequence_, i);
-              cc->Outputs()
-                  .Tag(possible_tag)
-                  .Add(new std::vector<Location>(bboxes.begin(), bboxes.end()),
-                       current_timestamp);
+          if (!outputs.bbox_tag.empty()) {
+            const auto xmins = outputs.bbox_xmins.GetFloatsAt(i);
+            const auto ymins = outputs.bbox_ymins.GetFloatsAt(i);
+            const auto xmaxs = outputs.bbox_xmaxs.GetFloatsAt(i);
+            const auto ymaxs = outputs.bbox_ymaxs.GetFloatsAt(i);
+            auto bboxes = absl::make_unique<std::vector<Location>>();
+            bboxes->reserve(xmins.size());
+            for (int j = 0; j < xmins.size(); ++j) {
+              bboxes->push_back(Location::CreateRelativeBBoxLocation(
+                  xmins[j], ymins[j], xmaxs[j] - xmins[j],
+                  ymaxs[j] - ymins[j]));
             }
+            cc->Outputs()
+                .Tag(outputs.bbox_tag)
+                .Add(bboxes.release(), current_timestamp);
           }
-
-          if (absl::StrContains(map_kv.first, "feature")) {
-            std::vector<std::string> pieces = absl::StrSplit(map_kv.first, '/');
-            RET_CHECK_GT(pieces.size(), 1)
-                << "Failed to parse the feature substring before / from key "
-                << map_kv.first;
-            std::string feature_key = pieces[0];
-            std::string possible_tag = kFloatFeaturePrefixTag + feature_key;
-            if (cc->Outputs().HasTag(possible_tag)) {
-              const auto& float_list =
-                  mpms::GetFeatureFloatsAt(feature_key, *sequence_, i);
-              cc->Outputs()
-                  .Tag(possible_tag)
-                  .Add(new std::vector<float>(float_list.begin(),
-                                              float_list.end()),
-                       current_timestamp);
-            }
+          if (!outputs.float_feature_tag.empty()) {
+            const auto floats = outputs.float_features.GetFloatsAt(i);
+            cc->Outputs()
+                .Tag(outputs.float_feature_tag)
+                .Add(new std::vector<float>(floats.begin(), floats.end()),
+                     current_timestamp);
+          }
+          if (lazy_sequence_) {
+            lazy_sequence_->ReleaseFeaturesAt(outputs.lazy_prefix, i);
           }
         }
       }
@@ -412,6 +746,8 @@ class UnpackMediaSequenceCalculator : public CalculatorBase {
   // access the SequenceExample with a handy pointer.
   const tf::SequenceExample* sequence_;
   Packet example_packet_holder_;
+  // Reads the SequenceExample from SEQUENCE_EXAMPLE_PATH, if set.
+  std::unique_ptr<LazySequenceExample> lazy_sequence_;
 
   // Store a map from the keys for each stream to the timestamps for each
   // key. This allows us to identify which packets to output for each stream
@@ -424,6 +760,28 @@ class UnpackMediaSequenceCalculator : public CalculatorBase {
   int current_timestamp_index_;
   // Store the very first timestamp, so we output everything on the first frame.
   int64 first_timestamp_seen_;
+  // Store the index of the next timestamp to output for each key.
+  std::map<std::string, int> next_indices_;
+
+  // The output streams fed by the packets of a timestamp key, and the
+  // feature lists they are read from.
+  struct KeyOutputs {
+    // The prefix of the key's features for lazy_sequence_.
+    std::string lazy_prefix;
+    // The tags of the streams to output, empty if not output.
+    std::string image_tag;
+    std::string bbox_tag;
+    std::string float_feature_tag;
+    bool forward_flow = false;
+    mpms::FeatureListView images;
+    mpms::FeatureListView forward_flow_images;
+    mpms::FeatureListView bbox_xmins;
+    mpms::FeatureListView bbox_ymins;
+    mpms::FeatureListView bbox_xmaxs;
+    mpms::FeatureListView bbox_ymaxs;
+    mpms::FeatureListView float_features;
+  };
+  std::map<std::string, KeyOutputs> key_outputs_;
 };
 REGISTER_CALCULATOR(UnpackMediaSequenceCalculator);
 }  // namespace mediapipe
@@ -14,11 +14,13 @@
 
 #include "absl/memory/memory.h"
 #include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
 #include "mediapipe/calculators/core/packet_resampler_calculator.pb.h"
 #include "mediapipe/calculators/tensorflow/unpack_media_sequence_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_runner.h"
 #include "mediapipe/framework/formats/location.h"
+#include "mediapipe/framework/port/file_helpers.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/rectangle.h"
@@ -510,5 +512,61 @@ TEST_F(UnpackMediaSequenceCalculatorTest, GetFrameRateFromExample) {
             image_frame_rate_);
 }
 
+TEST_F(UnpackMediaSequenceCalculatorTest, UnpacksFromPath) {
+  for (bool is_tfrecord : {false, true}) {
+    CalculatorGraphConfig::Node config;
+    config.set_calculator("UnpackMediaSequenceCalculator");
+    config.add_input_side_packet("SEQUENCE_EXAMPLE_PATH:input_path");
+    config.add_output_stream("IMAGE:images");
+    config.add_output_stream("FLOAT_FEATURE_TEST:test");
+    config.add_output_side_packet("DATA_PATH:data_path");
+    config.mutable_options()
+        ->MutableExtension(UnpackMediaSequenceCalculatorOptions::ext)
+        ->set_sequence_example_path_is_tfrecord(is_tfrecord);
+    runner_ = absl::make_unique<CalculatorRunner>(config);
+
+    int num_timesteps = 3;
+    for (int i = 0; i < num_timesteps; ++i) {
+      mpms::AddImageTimestamp(i, sequence_.get());
+      mpms::AddImageEncoded(absl::StrCat("image_", i), sequence_.get());
+      mpms::AddFeatureTimestamp("TEST", i, sequence_.get());
+      mpms::AddFeatureFloats("TEST", std::vector<float>(2, i),
+                             sequence_.get());
+    }
+    std::string contents = sequence_->SerializeAsString();
+    if (is_tfrecord) {
+      // The length, then placeholders for the checksums, which are not read.
+      std::string header(12, '\0');
+      for (int i = 0; i < 8; ++i) {
+        header[i] = static_cast<char>((contents.size() >> (8 * i)) & 0xff);
+      }
+      contents = header + contents + std::string(4, '\0');
+    }
+    const std::string path =
+        absl::StrCat(getenv("TEST_TMPDIR"), "/sequence_example.",
+                     is_tfrecord ? "tfrecord" : "pb");
+    MP_ASSERT_OK(file::SetContents(path, contents));
+    runner_->MutableSidePackets()->Tag("SEQUENCE_EXAMPLE_PATH") =
+        MakePacket<std::string>(path);
+
+    MP_ASSERT_OK(runner_->Run());
+
+    const std::vector<Packet>& images = runner_->Outputs().Tag("IMAGE").packets;
+    ASSERT_EQ(num_timesteps, images.size());
+    const std::vector<Packet>& floats =
+        runner_->Outputs().Tag("FLOAT_FEATURE_TEST").packets;
+    ASSERT_EQ(num_timesteps, floats.size());
+    for (int i = 0; i < num_timesteps; ++i) {
+      EXPECT_EQ(absl::StrCat("image_", i), images[i].Get<std::string>());
+      EXPECT_EQ(Timestamp(i), images[i].Timestamp());
+      EXPECT_THAT(floats[i].Get<std::vector<float>>(),
+                  ::testing::ElementsAreArray(std::vector<float>(2, i)));
+    }
+    EXPECT_EQ(data_path_,
+              runner_->OutputSidePackets().Tag("DATA_PATH").Get<std::string>());
+    SetUp();
+  }
+}
+
 }  // namespace
 }  // namespace mediapipe
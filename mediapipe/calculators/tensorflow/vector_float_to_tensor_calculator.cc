@@ -14,6 +14,7 @@
 //
 // Converts vector<float> (or vector<vector<float>>) to 1D (or 2D) tf::Tensor.
 
+#include "mediapipe/calculators/tensorflow/tensor_batch_allocator.h"
 #include "mediapipe/calculators/tensorflow/vector_float_to_tensor_calculator_options.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/port/ret_check.h"
@@ -73,6 +74,13 @@ REGISTER_CALCULATOR(VectorFloatToTensorCalculator);
   cc->Outputs().Index(0).Set<tf::Tensor>(
       // Output stream with data as tf::Tensor and the same TimeSeriesHeader.
   );
+  if (cc->InputSidePackets().HasTag("BATCH_ALLOCATOR")) {
+    // Allocates the output tensors as slices of batches for a
+    // TensorFlowInferenceCalculator.
+    cc->InputSidePackets()
+        .Tag("BATCH_ALLOCATOR")
+        .Set<std::shared_ptr<TensorBatchAllocator>>();
+  }
   return ::mediapipe::OkStatus();
 }
 
@@ -100,7 +108,7 @@ REGISTER_CALCULATOR(VectorFloatToTensorCalculator);
     } else {
       tensor_shape = tf::TensorShape({rows, cols});
     }
-    auto output = ::absl::make_unique<tf::Tensor>(tf::DT_FLOAT, tensor_shape);
+    auto output = NewOutputTensor(cc, tf::DT_FLOAT, tensor_shape);
     for (int r = 0; r < rows; ++r) {
       for (int c = 0; c < cols; ++c) {
         if (options_.transpose()) {
@@ -117,7 +125,7 @@ REGISTER_CALCULATOR(VectorFloatToTensorCalculator);
     CHECK_GE(input.size(), 1);
     const int32 length = input.size();
     tensor_shape = tf::TensorShape({length});
-    auto output = ::absl::make_unique<tf::Tensor>(tf::DT_FLOAT, tensor_shape);
+    auto output = NewOutputTensor(cc, tf::DT_FLOAT, tensor_shape);
     for (int i = 0; i < length; ++i) {
       output->tensor<float, 1>()(i) = input.at(i);
     }
@@ -13,17 +13,24 @@
 // limitations under the License.
 
 #include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "mediapipe/calculators/tflite/ssd_anchors_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/object_detection/anchor.pb.h"
 #include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/util/resource_util.h"
 
 namespace mediapipe {
 
 namespace {
 
+constexpr int kNumCoordsPerBox = 4;
+
 float CalculateScale(float min_scale, float max_scale, int stride_index,
                      int num_strides) {
   return min_scale +
@@ -32,10 +39,14 @@ float CalculateScale(float min_scale, float max_scale, int stride_index,
 
 }  // namespace
 
-// Generate anchors for SSD object detection model.
-// Output:
+// Generate anchors for SSD object detection model, or load precomputed ones
+// from options.anchors_file.
+// Output side packets:
 //   ANCHORS: A list of anchors. Model generates predictions based on the
-//   offsets of these anchors.
+//   offsets of these anchors. This is the only output when untagged.
+//   RAW_ANCHORS: The same anchors as a std::vector<float> holding 4 values per
+//   anchor in the order y_center, x_center, h, w, which
+//   TfLiteTensorsToDetectionsCalculator uses without any conversion.
 //
 // Usage example:
 // node {
@@ -68,7 +79,18 @@ float CalculateScale(float min_scale, float max_scale, int stride_index,
 class SsdAnchorsCalculator : public CalculatorBase {
  public:
   static ::mediapipe::Status GetContract(CalculatorContract* cc) {
-    cc->OutputSidePackets().Index(0).Set<std::vector<Anchor>>();
+    if (cc->OutputSidePackets().UsesTags()) {
+      RET_CHECK(cc->OutputSidePackets().HasTag("ANCHORS") ||
+                cc->OutputSidePackets().HasTag("RAW_ANCHORS"));
+      if (cc->OutputSidePackets().HasTag("ANCHORS")) {
+        cc->OutputSidePackets().Tag("ANCHORS").Set<std::vector<Anchor>>();
+      }
+      if (cc->OutputSidePackets().HasTag("RAW_ANCHORS")) {
+        cc->OutputSidePackets().Tag("RAW_ANCHORS").Set<std::vector<float>>();
+      }
+    } else {
+      cc->OutputSidePackets().Index(0).Set<std::vector<Anchor>>();
+    }
     return ::mediapipe::OkStatus();
   }
 
@@ -78,9 +100,29 @@ class SsdAnchorsCalculator : public CalculatorBase {
     const SsdAnchorsCalculatorOptions& options =
         cc->Options<SsdAnchorsCalculatorOptions>();
 
-    auto anchors = absl::make_unique<std::vector<Anchor>>();
-    MP_RETURN_IF_ERROR(GenerateAnchors(anchors.get(), options));
-    cc->OutputSidePackets().Index(0).Set(Adopt(anchors.release()));
+    auto raw_anchors = absl::make_unique<std::vector<float>>();
+    if (options.has_anchors_file()) {
+      MP_RETURN_IF_ERROR(
+          LoadAnchors(options.anchors_file(), raw_anchors.get()));
+    } else {
+      MP_RETURN_IF_ERROR(GenerateAnchors(raw_anchors.get(), options));
+    }
+
+    // Anchor protos are only built when requested, since there can be
+    // thousands of them.
+    if (!cc->OutputSidePackets().UsesTags()) {
+      cc->OutputSidePackets().Index(0).Set(
+          Adopt(ConvertToAnchors(*raw_anchors).release()));
+      return ::mediapipe::OkStatus();
+    }
+    if (cc->OutputSidePackets().HasTag("ANCHORS")) {
+      cc->OutputSidePackets().Tag("ANCHORS").Set(
+          Adopt(ConvertToAnchors(*raw_anchors).release()));
+    }
+    if (cc->OutputSidePackets().HasTag("RAW_ANCHORS")) {
+      cc->OutputSidePackets().Tag("RAW_ANCHORS").Set(
+          Adopt(raw_anchors.release()));
+    }
     return ::mediapipe::OkStatus();
   }
 
@@ -90,13 +132,50 @@ class SsdAnchorsCalculator : public CalculatorBase {
 
  private:
   static ::mediapipe::Status GenerateAnchors(
-      std::vector<Anchor>* anchors, const SsdAnchorsCalculatorOptions& options);
+      std::vector<float>* raw_anchors,
+      const SsdAnchorsCalculatorOptions& options);
+  static ::mediapipe::Status LoadAnchors(const std::string& path,
+                                         std::vector<float>* raw_anchors);
+  static std::unique_ptr<std::vector<Anchor>> ConvertToAnchors(
+      const std::vector<float>& raw_anchors);
 };
 REGISTER_CALCULATOR(SsdAnchorsCalculator);
 
+::mediapipe::Status SsdAnchorsCalculator::LoadAnchors(
+    const std::string& path, std::vector<float>* raw_anchors) {
+  ASSIGN_OR_RETURN(std::unique_ptr<ResourceMapping> mapping,
+                   GetResourceMapping(path));
+  RET_CHECK_EQ(mapping->size() % (kNumCoordsPerBox * sizeof(float)), 0)
+      << "Anchors file " << path << " has a partial anchor.";
+  raw_anchors->resize(mapping->size() / sizeof(float));
+  std::memcpy(raw_anchors->data(), mapping->data(), mapping->size());
+  return ::mediapipe::OkStatus();
+}
+
+std::unique_ptr<std::vector<Anchor>> SsdAnchorsCalculator::ConvertToAnchors(
+    const std::vector<float>& raw_anchors) {
+  auto anchors = absl::make_unique<std::vector<Anchor>>();
+  anchors->reserve(raw_anchors.size() / kNumCoordsPerBox);
+  for (int i = 0; i + kNumCoordsPerBox <= raw_anchors.size();
+       i += kNumCoordsPerBox) {
+    Anchor anchor;
+    anchor.set_y_center(raw_anchors[i + 0]);
+    anchor.set_x_center(raw_anchors[i + 1]);
+    anchor.set_h(raw_anchors[i + 2]);
+    anchor.set_w(raw_anchors[i + 3]);
+    anchors->push_back(anchor);
+  }
+  return anchors;
+}
+
 ::mediapipe::Status SsdAnchorsCalculator::GenerateAnchors(
-    std::vector<Anchor>* anchors, const SsdAnchorsCalculatorOptions& options) {
+    std::vector<float>* raw_anchors,
+    const SsdAnchorsCalculatorOptions& options) {
   // Verify the options.
+  RET_CHECK(options.has_input_size_width() &&
+            options.has_input_size_height() && options.has_min_scale() &&
+            options.has_max_scale() && options.has_num_layers())
+      << "Missing options to generate anchors.";
   if (!options.feature_map_height_size() && !options.strides_size()) {
     return ::mediapipe::InvalidArgumentError(
         "Both feature map shape and strides are missing. Must provide either "
@@ -185,18 +264,15 @@ REGISTER_CALCULATOR(SsdAnchorsCalculator);
           const float y_center =
               (y + options.anchor_offset_y()) * 1.0f / feature_map_height;
 
-          Anchor new_anchor;
-          new_anchor.set_x_center(x_center);
-          new_anchor.set_y_center(y_center);
-
+          raw_anchors->push_back(y_center);
+          raw_anchors->push_back(x_center);
           if (options.fixed_anchor_size()) {
-            new_anchor.set_w(1.0f);
-            new_anchor.set_h(1.0f);
+            raw_anchors->push_back(1.0f);
+            raw_anchors->push_back(1.0f);
           } else {
-            new_anchor.set_w(anchor_width[anchor_id]);
-            new_anchor.set_h(anchor_height[anchor_id]);
+            raw_anchors->push_back(anchor_height[anchor_id]);
+            raw_anchors->push_back(anchor_width[anchor_id]);
           }
-          anchors->push_back(new_anchor);
         }
       }
     }
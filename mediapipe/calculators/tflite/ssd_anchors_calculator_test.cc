@@ -12,6 +12,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstdlib>
+
+#include "absl/strings/str_cat.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_runner.h"
 #include "mediapipe/framework/deps/file_path.h"
@@ -147,4 +150,81 @@ TEST(SsdAnchorCalculatorTest, MobileSSDConfig) {
   CompareAnchors(anchors, anchors_golden);
 }
 
+constexpr char kFaceDetectionOptions[] = R"(
+  [mediapipe.SsdAnchorsCalculatorOptions.ext] {
+    num_layers: 5
+    min_scale: 0.1171875
+    max_scale: 0.75
+    input_size_height: 256
+    input_size_width: 256
+    anchor_offset_x: 0.5
+    anchor_offset_y: 0.5
+    strides: 8
+    strides: 16
+    strides: 32
+    strides: 32
+    strides: 32
+    aspect_ratios: 1.0
+    fixed_anchor_size: true
+  }
+)";
+
+CalculatorGraphConfig::Node MakeNode(const std::string& output_side_packets,
+                                     const std::string& options) {
+  return ParseTextProtoOrDie<CalculatorGraphConfig::Node>(
+      absl::StrCat("calculator: \"SsdAnchorsCalculator\"\n",
+                   output_side_packets, "options {", options, "}"));
+}
+
+TEST(SsdAnchorCalculatorTest, OutputsRawAnchors) {
+  CalculatorRunner runner(MakeNode(
+      "output_side_packet: \"ANCHORS:anchors\"\n"
+      "output_side_packet: \"RAW_ANCHORS:raw_anchors\"\n",
+      kFaceDetectionOptions));
+
+  MP_ASSERT_OK(runner.Run()) << "Calculator execution failed.";
+  const auto& anchors =
+      runner.OutputSidePackets().Tag("ANCHORS").Get<std::vector<Anchor>>();
+  const auto& raw_anchors =
+      runner.OutputSidePackets().Tag("RAW_ANCHORS").Get<std::vector<float>>();
+
+  ASSERT_EQ(anchors.size() * 4, raw_anchors.size());
+  for (int i = 0; i < anchors.size(); ++i) {
+    EXPECT_EQ(anchors[i].y_center(), raw_anchors[i * 4 + 0]);
+    EXPECT_EQ(anchors[i].x_center(), raw_anchors[i * 4 + 1]);
+    EXPECT_EQ(anchors[i].h(), raw_anchors[i * 4 + 2]);
+    EXPECT_EQ(anchors[i].w(), raw_anchors[i * 4 + 3]);
+  }
+}
+
+TEST(SsdAnchorCalculatorTest, LoadsAnchorsFile) {
+  CalculatorRunner generate_runner(MakeNode(
+      "output_side_packet: \"RAW_ANCHORS:raw_anchors\"\n",
+      kFaceDetectionOptions));
+  MP_ASSERT_OK(generate_runner.Run());
+  const auto& raw_anchors = generate_runner.OutputSidePackets()
+                                .Tag("RAW_ANCHORS")
+                                .Get<std::vector<float>>();
+  const std::string path =
+      absl::StrCat(getenv("TEST_TMPDIR"), "/ssd_anchors.bin");
+  MP_ASSERT_OK(mediapipe::file::SetContents(
+      path, std::string(reinterpret_cast<const char*>(raw_anchors.data()),
+                        raw_anchors.size() * sizeof(float))));
+
+  CalculatorRunner load_runner(MakeNode(
+      "output_side_packet: \"anchors\"\n",
+      absl::StrCat("[mediapipe.SsdAnchorsCalculatorOptions.ext] {",
+                   "anchors_file: \"", path, "\"}")));
+  MP_ASSERT_OK(load_runner.Run());
+  const auto& anchors =
+      load_runner.OutputSidePackets().Index(0).Get<std::vector<Anchor>>();
+
+  std::string anchors_string;
+  MP_EXPECT_OK(mediapipe::file::GetContents(
+      GetGoldenFilePath("anchor_golden_file_0.txt"), &anchors_string));
+  std::vector<Anchor> anchors_golden;
+  ParseAnchorsFromText(anchors_string, &anchors_golden);
+  CompareAnchors(anchors, anchors_golden);
+}
+
 }  // namespace mediapipe
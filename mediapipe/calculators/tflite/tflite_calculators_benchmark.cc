@@ -0,0 +1,84 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/substitute.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/matrix.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/util/calculator_benchmark.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kNumFrames = 30;
+constexpr int64 kFramePeriodUsec = 33333;
+
+// Converts frames of the size given by the two arguments into a 128x128
+// float tensor, resizing them in the converter unless they already match.
+void BM_TfLiteConverterImage(benchmark::State& state) {
+  const int width = state.range(0);
+  const int height = state.range(1);
+  CalculatorBenchmark benchmark(absl::Substitute(
+      R"(
+      calculator: "TfLiteConverterCalculator"
+      input_stream: "IMAGE:input"
+      output_stream: "TENSORS:tensors"
+      options {
+        [mediapipe.TfLiteConverterCalculatorOptions.ext] {
+          output_width: $0
+          output_height: $1
+          scale_mode: FIT
+        }
+      })",
+      width == 128 ? 0 : 128, height == 128 ? 0 : 128));
+  benchmark.GenerateInputs(
+      "IMAGE", 0, kNumFrames, kFramePeriodUsec, [width, height](int i) {
+        auto frame =
+            absl::make_unique<ImageFrame>(ImageFormat::SRGB, width, height);
+        frame->SetToZero();
+        return Adopt(frame.release());
+      });
+  benchmark.Run(state);
+}
+BENCHMARK(BM_TfLiteConverterImage)->ArgPair(128, 128)->ArgPair(1280, 720);
+
+// Converts feature matrices, as fed to audio models. The argument is whether
+// row_major_matrix is set.
+void BM_TfLiteConverterMatrix(benchmark::State& state) {
+  CalculatorBenchmark benchmark(absl::Substitute(
+      R"(
+      calculator: "TfLiteConverterCalculator"
+      input_stream: "MATRIX:input"
+      output_stream: "TENSORS:tensors"
+      options {
+        [mediapipe.TfLiteConverterCalculatorOptions.ext] {
+          row_major_matrix: $0
+        }
+      })",
+      state.range(0) != 0));
+  benchmark.GenerateInputs("MATRIX", 0, kNumFrames, kFramePeriodUsec,
+                           [](int i) {
+                             return MakePacket<Matrix>(Matrix::Random(96, 64));
+                           });
+  benchmark.Run(state);
+}
+BENCHMARK(BM_TfLiteConverterMatrix)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace mediapipe
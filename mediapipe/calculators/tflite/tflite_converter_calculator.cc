@@ -12,16 +12,26 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
 #include <string>
 #include <vector>
 
+#include "mediapipe/calculators/image/image_transformation_calculator.pb.h"
 #include "mediapipe/calculators/tflite/tflite_converter_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/matrix.h"
+#include "mediapipe/framework/formats/matrix_view.h"
+#include "mediapipe/framework/formats/yuv_image.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/gpu/scale_mode.pb.h"
+#include "mediapipe/util/image_frame_util.h"
 #include "mediapipe/util/resource_util.h"
+#include "mediapipe/util/simd_image_util.h"
 #include "tensorflow/lite/error_reporter.h"
 #include "tensorflow/lite/interpreter.h"
 
@@ -57,10 +67,37 @@ int NumGroups(const int size, const int group_size) {  // NOLINT
   return (size + group_size - 1) / group_size;
 }
 
-typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
-    RowMajorMatrixXf;
-typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor>
-    ColMajorMatrixXf;
+template <class T>
+using RowMajorMatrixX =
+    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+template <class T>
+using ColMajorMatrixX =
+    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor>;
+
+// Writes pixel / div - sub for the first channels_preserved channels of the
+// num_pixels pixels at "image_ptr" to "tensor_buffer".
+template <class T, class TensorT>
+void NormalizeRow(const T* image_ptr, int num_pixels, int channels,
+                  int channels_preserved, float div, float sub,
+                  TensorT* tensor_buffer) {
+  const int channels_ignored = channels - channels_preserved;
+  for (int j = 0; j < num_pixels; ++j) {
+    for (int c = 0; c < channels_preserved; ++c) {
+      *tensor_buffer++ = static_cast<TensorT>(*image_ptr++ / div - sub);
+    }
+    image_ptr += channels_ignored;
+  }
+}
+
+// The common case of 8-bit images and float tensors has SIMD kernels.
+template <>
+void NormalizeRow<uint8, float>(const uint8* image_ptr, int num_pixels,
+                                int channels, int channels_preserved,
+                                float div, float sub, float* tensor_buffer) {
+  ::mediapipe::simd_image_util::NormalizeRow(image_ptr, num_pixels, channels,
+                                             channels_preserved, div, sub,
+                                             tensor_buffer);
+}
 
 }  // namespace
 
@@ -72,7 +109,9 @@ using ::tflite::gpu::gl::GlProgram;
 using ::tflite::gpu::gl::GlShader;
 struct GPUData {
   int elements = 1;
-  GlBuffer buffer;
+  // The 32-bit words of the output buffer, which hold two elements each with
+  // use_fp16_tensors.
+  int words = 1;
   GlShader shader;
   GlProgram program;
 };
@@ -86,23 +125,43 @@ struct GPUData {
 
 // Calculator for normalizing and converting an ImageFrame or Matrix
 // into a TfLiteTensor (float 32) or a GpuBuffer to a tflite::gpu::GlBuffer.
+// With use_fp16_tensors, the outputs hold half-precision floats instead.
 //
 // This calculator is designed to be used with the TfLiteInferenceCalcualtor,
 // as a pre-processing step for calculator inputs.
 //
 // IMAGE and IMAGE_GPU inputs are normalized to [-1,1] (default) or [0,1],
-// specified by options (unless outputting a quantized tensor).
+// specified by options.  Quantized tensors hold the normalized values
+// quantized with the model input's scale and zero point, or the raw 8-bit
+// pixel values if no scale is given.
+//
+// On Android, an IMAGE_GPU input can also be rotated, flipped and scaled to
+// the model's input size in the same pass (see output_width in the options),
+// replacing an ImageTransformationCalculator in front of this calculator.
+// A YUV_IMAGE input can be scaled (STRETCH or FILL_AND_CROP) the same way,
+// and only the region and resolution needed by the model is converted to
+// RGB.
 //
 // Input:
 //  One of the following tags:
 //  IMAGE - ImageFrame (assumed to be 8-bit or 32-bit data).
+//  IMAGES - std::vector<ImageFrame> of equally sized images, such as the
+//    crops of ImageCroppingCalculator for NORM_RECTS, converted into one
+//    tensor batched along its first dimension.
 //  IMAGE_GPU - GpuBuffer (assumed to be RGBA or RGB GL texture).
+//  YUV_IMAGE - YUVImage (I420, NV12 or NV21), converted as an SRGB image.
 //  MATRIX - Matrix.
+//  MATRIX_VIEW - MatrixView, converted like a Matrix without first copying
+//    the viewed values into a Matrix.
 //
 // Output:
 //  One of the following tags:
-//  TENSORS - Vector of TfLiteTensor of type kTfLiteFloat32, or kTfLiteUint8.
-//  TENSORS_GPU - vector of GlBuffer.
+//  TENSORS - Vector of TfLiteTensor of type kTfLiteFloat32, kTfLiteFloat16,
+//            kTfLiteUInt8 or kTfLiteInt8.
+//  TENSORS_GPU - vector of GlBuffer, of floats or of packed halves.
+//  LETTERBOX_PADDING (optional) - std::array<float, 4>, the padding added on
+//    the [left, top, right, bottom] of the output when scale_mode is FIT, as
+//    output by ImageTransformationCalculator.
 //
 // Example use:
 // node {
@@ -133,12 +192,21 @@ class TfLiteConverterCalculator : public CalculatorBase {
  private:
   ::mediapipe::Status InitGpu(CalculatorContext* cc);
   ::mediapipe::Status LoadOptions(CalculatorContext* cc);
-  template <class T>
+  void ConvertYUVImage(const YUVImage& yuv_image, ImageFrame* image_frame);
+  // Normalizes an 8-bit or float image into a float or Eigen::half tensor.
+  template <class TensorT>
+  ::mediapipe::Status NormalizeImage(const ImageFrame& image_frame,
+                                     TensorT* tensor_buffer);
+  template <class T, class TensorT>
   ::mediapipe::Status NormalizeImage(const ImageFrame& image_frame,
                                      bool zero_center, bool flip_vertically,
-                                     float* tensor_buffer);
-  ::mediapipe::Status CopyMatrixToTensor(const Matrix& matrix,
-                                         float* tensor_buffer);
+                                     TensorT* tensor_buffer);
+  // Quantizes an 8-bit image with quantization_table_.
+  ::mediapipe::Status QuantizeImage(const ImageFrame& image_frame,
+                                    bool flip_vertically, uint8* tensor_buffer);
+  template <class TensorT>
+  ::mediapipe::Status CopyMatrixToTensor(
+      const Eigen::Ref<const Matrix>& matrix, TensorT* tensor_buffer);
   ::mediapipe::Status ProcessCPU(CalculatorContext* cc);
   ::mediapipe::Status ProcessGPU(CalculatorContext* cc);
 
@@ -158,25 +226,50 @@ class TfLiteConverterCalculator : public CalculatorBase {
   bool flip_vertically_ = false;
   bool row_major_matrix_ = false;
   bool use_quantized_tensors_ = false;
+  bool signed_quantized_tensors_ = false;
+  bool use_fp16_tensors_ = false;
+  TfLiteQuantizationParams quantization_params_ = {0.0f, 0};
+  // The quantized value of each 8-bit pixel value, stored as uint8 also for
+  // signed tensors.
+  uint8 quantization_table_[256];
+  // Whether quantization_table_ maps every value to itself.
+  bool quantization_is_identity_ = false;
   int max_num_channels_ = 3;
+  // Fused transformation of IMAGE_GPU inputs. Disabled if output_width_ is 0.
+  int output_width_ = 0;
+  int output_height_ = 0;
+  RotationMode::Mode rotation_ = RotationMode::ROTATION_0;
+  bool flip_horizontally_ = false;
+  ScaleMode::Mode scale_mode_ = ScaleMode::STRETCH;
+  std::array<float, 4> letterbox_padding_ = {0.0f, 0.0f, 0.0f, 0.0f};
 };
 REGISTER_CALCULATOR(TfLiteConverterCalculator);
 
 ::mediapipe::Status TfLiteConverterCalculator::GetContract(
     CalculatorContract* cc) {
   const bool has_image_tag = cc->Inputs().HasTag("IMAGE");
+  const bool has_images_tag = cc->Inputs().HasTag("IMAGES");
   const bool has_image_gpu_tag = cc->Inputs().HasTag("IMAGE_GPU");
   const bool has_matrix_tag = cc->Inputs().HasTag("MATRIX");
+  const bool has_matrix_view_tag = cc->Inputs().HasTag("MATRIX_VIEW");
+  const bool has_yuv_image_tag = cc->Inputs().HasTag("YUV_IMAGE");
   // Confirm only one of the input streams is present.
-  RET_CHECK(has_image_tag ^ has_image_gpu_tag ^ has_matrix_tag &&
-            !(has_image_tag && has_image_gpu_tag && has_matrix_tag));
+  RET_CHECK_EQ(has_image_tag + has_images_tag + has_image_gpu_tag +
+                   has_matrix_tag + has_matrix_view_tag + has_yuv_image_tag,
+               1);
 
   // Confirm only one of the output streams is present.
   RET_CHECK(cc->Outputs().HasTag("TENSORS") ^
             cc->Outputs().HasTag("TENSORS_GPU"));
 
   if (cc->Inputs().HasTag("IMAGE")) cc->Inputs().Tag("IMAGE").Set<ImageFrame>();
+  if (cc->Inputs().HasTag("IMAGES"))
+    cc->Inputs().Tag("IMAGES").Set<std::vector<ImageFrame>>();
   if (cc->Inputs().HasTag("MATRIX")) cc->Inputs().Tag("MATRIX").Set<Matrix>();
+  if (cc->Inputs().HasTag("MATRIX_VIEW"))
+    cc->Inputs().Tag("MATRIX_VIEW").Set<MatrixView>();
+  if (cc->Inputs().HasTag("YUV_IMAGE"))
+    cc->Inputs().Tag("YUV_IMAGE").Set<YUVImage>();
 #if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
   if (cc->Inputs().HasTag("IMAGE_GPU"))
     cc->Inputs().Tag("IMAGE_GPU").Set<mediapipe::GpuBuffer>();
@@ -188,6 +281,8 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
   if (cc->Outputs().HasTag("TENSORS_GPU"))
     cc->Outputs().Tag("TENSORS_GPU").Set<std::vector<GpuTensor>>();
 #endif
+  if (cc->Outputs().HasTag("LETTERBOX_PADDING"))
+    cc->Outputs().Tag("LETTERBOX_PADDING").Set<std::array<float, 4>>();
 
 #if defined(__ANDROID__)
   MP_RETURN_IF_ERROR(mediapipe::GlCalculatorHelper::UpdateContract(cc));
@@ -221,6 +316,10 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
               cc->Outputs().HasTag("TENSORS_GPU"));
     // Cannot use quantization.
     use_quantized_tensors_ = false;
+#if !defined(__ANDROID__)
+    RET_CHECK_EQ(output_width_, 0)
+        << "Fused image transformation is only supported on Android.";
+#endif
 #if defined(__ANDROID__)
     MP_RETURN_IF_ERROR(gpu_helper_.Open(cc));
 #elif defined(__APPLE__) && !TARGET_OS_OSX  // iOS
@@ -228,6 +327,16 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
     RET_CHECK(gpu_helper_);
 #endif
   } else {
+    if (cc->Inputs().HasTag("YUV_IMAGE")) {
+      RET_CHECK(rotation_ == RotationMode::ROTATION_0 && !flip_horizontally_ &&
+                scale_mode_ != ScaleMode::FIT)
+          << "Only STRETCH and FILL_AND_CROP scaling is supported for "
+             "YUV_IMAGE input.";
+    } else {
+      RET_CHECK_EQ(output_width_, 0)
+          << "Fused image transformation requires IMAGE_GPU or YUV_IMAGE "
+             "input.";
+    }
     interpreter_ = absl::make_unique<tflite::Interpreter>();
     interpreter_->AddTensors(1);
     interpreter_->SetInputs({0});
@@ -264,14 +373,37 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
 
 ::mediapipe::Status TfLiteConverterCalculator::ProcessCPU(
     CalculatorContext* cc) {
-  if (cc->Inputs().HasTag("IMAGE")) {
+  if (cc->Inputs().HasTag("IMAGE") || cc->Inputs().HasTag("IMAGES") ||
+      cc->Inputs().HasTag("YUV_IMAGE")) {
     // CPU ImageFrame to TfLiteTensor conversion.
 
-    const auto& image_frame = cc->Inputs().Tag("IMAGE").Get<ImageFrame>();
+    ImageFrame converted_frame;
+    // The images to convert, one per entry of the batch for IMAGES.
+    std::vector<const ImageFrame*> image_frames;
+    if (cc->Inputs().HasTag("YUV_IMAGE")) {
+      ConvertYUVImage(cc->Inputs().Tag("YUV_IMAGE").Get<YUVImage>(),
+                      &converted_frame);
+      image_frames.push_back(&converted_frame);
+    } else if (cc->Inputs().HasTag("IMAGES")) {
+      for (const auto& frame :
+           cc->Inputs().Tag("IMAGES").Get<std::vector<ImageFrame>>()) {
+        image_frames.push_back(&frame);
+      }
+      // Nothing to run inference on.
+      if (image_frames.empty()) return ::mediapipe::OkStatus();
+    } else {
+      image_frames.push_back(&cc->Inputs().Tag("IMAGE").Get<ImageFrame>());
+    }
+    const auto& image_frame = *image_frames[0];
     const int height = image_frame.Height();
     const int width = image_frame.Width();
     const int channels = image_frame.NumberOfChannels();
     const int channels_preserved = std::min(channels, max_num_channels_);
+    for (const ImageFrame* frame : image_frames) {
+      RET_CHECK(frame->Width() == width && frame->Height() == height &&
+                frame->Format() == image_frame.Format())
+          << "Batched images must have the same size and format.";
+    }
 
     if (!initialized_) {
       if (!(image_frame.Format() == mediapipe::ImageFormat::SRGBA ||
@@ -283,52 +415,50 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
       if (use_quantized_tensors_) {
         RET_CHECK(image_frame.Format() != mediapipe::ImageFormat::VEC32F1)
             << "Only 8-bit input images are supported for quantization.";
-        // Optional: Set 'quant' quantization params here if needed.
-        interpreter_->SetTensorParametersReadWrite(0, kTfLiteUInt8, "",
-                                                   {channels_preserved}, quant);
+        interpreter_->SetTensorParametersReadWrite(
+            0, signed_quantized_tensors_ ? kTfLiteInt8 : kTfLiteUInt8, "",
+            {channels_preserved}, quantization_params_);
       } else {
         // Default TfLiteQuantization used for no quantization.
-        interpreter_->SetTensorParametersReadWrite(0, kTfLiteFloat32, "",
-                                                   {channels_preserved}, quant);
+        interpreter_->SetTensorParametersReadWrite(
+            0, use_fp16_tensors_ ? kTfLiteFloat16 : kTfLiteFloat32, "",
+            {channels_preserved}, quant);
       }
       initialized_ = true;
     }
 
     const int tensor_idx = interpreter_->inputs()[0];
     TfLiteTensor* tensor = interpreter_->tensor(tensor_idx);
-    interpreter_->ResizeInputTensor(tensor_idx,
-                                    {height, width, channels_preserved});
+    if (cc->Inputs().HasTag("IMAGES")) {
+      interpreter_->ResizeInputTensor(
+          tensor_idx, {static_cast<int>(image_frames.size()), height, width,
+                       channels_preserved});
+    } else {
+      interpreter_->ResizeInputTensor(tensor_idx,
+                                      {height, width, channels_preserved});
+    }
     interpreter_->AllocateTensors();
 
-    // Copy image data into tensor.
-    if (use_quantized_tensors_) {
-      const int width_padding =
-          image_frame.WidthStep() / image_frame.ByteDepth() - width * channels;
-      const uint8* image_buffer =
-          reinterpret_cast<const uint8*>(image_frame.PixelData());
-      uint8* tensor_buffer = tensor->data.uint8;
-      RET_CHECK(tensor_buffer);
-      for (int row = 0; row < height; ++row) {
-        for (int col = 0; col < width; ++col) {
-          for (int channel = 0; channel < channels_preserved; ++channel) {
-            *tensor_buffer++ = image_buffer[channel];
-          }
-          image_buffer += channels;
-        }
-        image_buffer += width_padding;
-      }
-    } else {
-      float* tensor_buffer = tensor->data.f;
-      RET_CHECK(tensor_buffer);
-      if (image_frame.ByteDepth() == 1) {
-        MP_RETURN_IF_ERROR(NormalizeImage<uint8>(
-            image_frame, zero_center_, flip_vertically_, tensor_buffer));
-      } else if (image_frame.ByteDepth() == 4) {
-        MP_RETURN_IF_ERROR(NormalizeImage<float>(
-            image_frame, zero_center_, flip_vertically_, tensor_buffer));
+    // Copy image data into tensor, one batch entry after the other.
+    const int entry_size = height * width * channels_preserved;
+    for (int i = 0; i < image_frames.size(); ++i) {
+      const ImageFrame& frame = *image_frames[i];
+      if (use_quantized_tensors_) {
+        // Both kTfLiteUInt8 and kTfLiteInt8 data are written as bytes.
+        uint8* tensor_buffer = reinterpret_cast<uint8*>(tensor->data.raw);
+        RET_CHECK(tensor_buffer);
+        MP_RETURN_IF_ERROR(QuantizeImage(frame, flip_vertically_,
+                                         tensor_buffer + i * entry_size));
       } else {
-        return ::mediapipe::InternalError(
-            "Only byte-based (8 bit) and float (32 bit) images supported.");
+        RET_CHECK(tensor->data.raw);
+        if (use_fp16_tensors_) {
+          MP_RETURN_IF_ERROR(NormalizeImage(
+              frame, reinterpret_cast<Eigen::half*>(tensor->data.raw) +
+                         i * entry_size));
+        } else {
+          MP_RETURN_IF_ERROR(
+              NormalizeImage(frame, tensor->data.f + i * entry_size));
+        }
       }
     }
 
@@ -336,17 +466,31 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
     output_tensors->emplace_back(*tensor);
     cc->Outputs().Tag("TENSORS").Add(output_tensors.release(),
                                      cc->InputTimestamp());
-  } else if (cc->Inputs().HasTag("MATRIX")) {
+    if (cc->Outputs().HasTag("LETTERBOX_PADDING")) {
+      cc->Outputs()
+          .Tag("LETTERBOX_PADDING")
+          .AddPacket(MakePacket<std::array<float, 4>>(letterbox_padding_)
+                         .At(cc->InputTimestamp()));
+    }
+  } else if (cc->Inputs().HasTag("MATRIX") ||
+             cc->Inputs().HasTag("MATRIX_VIEW")) {
     // CPU Matrix to TfLiteTensor conversion.
 
-    const auto& matrix = cc->Inputs().Tag("MATRIX").Get<Matrix>();
+    const Eigen::Ref<const Matrix> matrix =
+        cc->Inputs().HasTag("MATRIX")
+            ? Eigen::Ref<const Matrix>(
+                  cc->Inputs().Tag("MATRIX").Get<Matrix>())
+            : Eigen::Ref<const Matrix>(
+                  cc->Inputs().Tag("MATRIX_VIEW").Get<MatrixView>().matrix());
     const int height = matrix.rows();
     const int width = matrix.cols();
     const int channels = 1;
 
     if (!initialized_) {
       interpreter_->SetTensorParametersReadWrite(
-          /*tensor_index=*/0, /*type=*/kTfLiteFloat32, /*name=*/"",
+          /*tensor_index=*/0,
+          /*type=*/use_fp16_tensors_ ? kTfLiteFloat16 : kTfLiteFloat32,
+          /*name=*/"",
           /*dims=*/{channels}, /*quantization=*/TfLiteQuantization());
       initialized_ = true;
     }
@@ -356,10 +500,13 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
     interpreter_->ResizeInputTensor(tensor_idx, {height, width, channels});
     interpreter_->AllocateTensors();
 
-    float* tensor_buffer = tensor->data.f;
-    RET_CHECK(tensor_buffer);
-
-    MP_RETURN_IF_ERROR(CopyMatrixToTensor(matrix, tensor_buffer));
+    RET_CHECK(tensor->data.raw);
+    if (use_fp16_tensors_) {
+      MP_RETURN_IF_ERROR(CopyMatrixToTensor(
+          matrix, reinterpret_cast<Eigen::half*>(tensor->data.raw)));
+    } else {
+      MP_RETURN_IF_ERROR(CopyMatrixToTensor(matrix, tensor->data.f));
+    }
 
     auto output_tensors = absl::make_unique<std::vector<TfLiteTensor>>();
     output_tensors->emplace_back(*tensor);
@@ -375,19 +522,41 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
 #if defined(__ANDROID__)
   // GpuBuffer to tflite::gpu::GlBuffer conversion.
   const auto& input = cc->Inputs().Tag("IMAGE_GPU").Get<mediapipe::GpuBuffer>();
-  MP_RETURN_IF_ERROR(
-      gpu_helper_.RunInGlContext([this, &input]() -> ::mediapipe::Status {
-        // Convert GL texture into TfLite GlBuffer (SSBO).
+  const int output_width = output_width_ ? output_width_ : input.width();
+  const int output_height = output_height_ ? output_height_ : input.height();
+  auto output_tensors = absl::make_unique<std::vector<GpuTensor>>();
+  output_tensors->resize(1);
+  MP_RETURN_IF_ERROR(gpu_helper_.RunInGlContext(
+      [this, &input, &output_tensors, output_width,
+       output_height]() -> ::mediapipe::Status {
+        // Convert GL texture directly into the output TfLite GlBuffer (SSBO).
+        GlBuffer& tensor = output_tensors->at(0);
+        using ::tflite::gpu::gl::CreateReadWriteShaderStorageBuffer;
+        auto status =
+            use_fp16_tensors_
+                ? CreateReadWriteShaderStorageBuffer<uint32_t>(
+                      gpu_data_out_->words, &tensor)
+                : CreateReadWriteShaderStorageBuffer<float>(
+                      gpu_data_out_->elements, &tensor);
+        if (!status.ok()) {
+          return ::mediapipe::InternalError(status.error_message());
+        }
         auto src = gpu_helper_.CreateSourceTexture(input);
         glActiveTexture(GL_TEXTURE0 + 0);
         glBindTexture(GL_TEXTURE_2D, src.name());
-        auto status = gpu_data_out_->buffer.BindToIndex(1);
+        status = tensor.BindToIndex(1);
         if (!status.ok()) {
           return ::mediapipe::InternalError(status.error_message());
         }
-        const tflite::gpu::uint3 workgroups = {
-            NumGroups(input.width(), kWorkgroupSize),
-            NumGroups(input.height(), kWorkgroupSize), 1};
+        tflite::gpu::uint3 workgroups = {
+            NumGroups(output_width, kWorkgroupSize),
+            NumGroups(output_height, kWorkgroupSize), 1};
+        if (use_fp16_tensors_) {
+          // One invocation per pair of output pixels.
+          const int num_pairs = NumGroups(output_width * output_height, 2);
+          workgroups = {NumGroups(num_pairs, kWorkgroupSize * kWorkgroupSize),
+                        1, 1};
+        }
         status = gpu_data_out_->program.Dispatch(workgroups);
         if (!status.ok()) {
           return ::mediapipe::InternalError(status.error_message());
@@ -398,22 +567,15 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
         return ::mediapipe::OkStatus();
       }));
 
-  // Copy into outputs.
-  auto output_tensors = absl::make_unique<std::vector<GpuTensor>>();
-  output_tensors->resize(1);
-  {
-    GlBuffer& tensor = output_tensors->at(0);
-    using ::tflite::gpu::gl::CreateReadWriteShaderStorageBuffer;
-    auto status = CreateReadWriteShaderStorageBuffer<float>(
-        gpu_data_out_->elements, &tensor);
-    if (!status.ok()) {
-      return ::mediapipe::InternalError(status.error_message());
-    }
-    tflite::gpu::gl::CopyBuffer(gpu_data_out_->buffer, tensor);
-  }
   cc->Outputs()
       .Tag("TENSORS_GPU")
       .Add(output_tensors.release(), cc->InputTimestamp());
+  if (cc->Outputs().HasTag("LETTERBOX_PADDING")) {
+    cc->Outputs()
+        .Tag("LETTERBOX_PADDING")
+        .AddPacket(MakePacket<std::array<float, 4>>(letterbox_padding_)
+                       .At(cc->InputTimestamp()));
+  }
 #elif defined(__APPLE__) && !TARGET_OS_OSX  // iOS
   // GpuBuffer to id<MTLBuffer> conversion.
   const auto& input = cc->Inputs().Tag("IMAGE_GPU").Get<mediapipe::GpuBuffer>();
@@ -443,8 +605,10 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
     id<MTLDevice> device = gpu_helper_.mtlDevice;
     id<MTLCommandBuffer> command_buffer = [gpu_helper_ commandBuffer];
     command_buffer.label = @"TfLiteConverterCalculatorCopy";
+    const int element_size =
+        use_fp16_tensors_ ? sizeof(uint16_t) : sizeof(float);
     id<MTLBuffer> tensor =
-        [device newBufferWithLength:gpu_data_out_->elements * sizeof(float)
+        [device newBufferWithLength:gpu_data_out_->elements * element_size
                             options:MTLResourceStorageModeShared];
     id<MTLBlitCommandEncoder> blit_command =
         [command_buffer blitCommandEncoder];
@@ -452,7 +616,7 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
                     sourceOffset:0
                         toBuffer:tensor
                destinationOffset:0
-                            size:gpu_data_out_->elements * sizeof(float)];
+                            size:gpu_data_out_->elements * element_size];
     [blit_command endEncoding];
     [command_buffer commit];
     [command_buffer waitUntilCompleted];
@@ -463,6 +627,12 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
   cc->Outputs()
       .Tag("TENSORS_GPU")
       .Add(output_tensors.release(), cc->InputTimestamp());
+  if (cc->Outputs().HasTag("LETTERBOX_PADDING")) {
+    cc->Outputs()
+        .Tag("LETTERBOX_PADDING")
+        .AddPacket(MakePacket<std::array<float, 4>>(letterbox_padding_)
+                       .At(cc->InputTimestamp()));
+  }
 #else
   RET_CHECK_FAIL() << "GPU processing is for Android and iOS only.";
 #endif
@@ -477,7 +647,16 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
   mediapipe::ImageFormat::Format format =
       mediapipe::ImageFormatForGpuBufferFormat(input.format());
   gpu_data_out_ = absl::make_unique<GPUData>();
-  gpu_data_out_->elements = input.height() * input.width() * max_num_channels_;
+  const int output_width = output_width_ ? output_width_ : input.width();
+  const int output_height = output_height_ ? output_height_ : input.height();
+  gpu_data_out_->elements = output_height * output_width * max_num_channels_;
+#if defined(__ANDROID__)
+  // Every pair of pixels is packed into one word per channel.
+  gpu_data_out_->words =
+      use_fp16_tensors_
+          ? NumGroups(output_height * output_width, 2) * max_num_channels_
+          : gpu_data_out_->elements;
+#endif
   const bool include_alpha = (max_num_channels_ == 4);
   if (!(format == mediapipe::ImageFormat::SRGB ||
         format == mediapipe::ImageFormat::SRGBA))
@@ -487,11 +666,66 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
 #endif
 
 #if defined(__ANDROID__)
-  // Device memory.
-  auto status = ::tflite::gpu::gl::CreateReadWriteShaderStorageBuffer<float>(
-      gpu_data_out_->elements, &gpu_data_out_->buffer);
-  if (!status.ok()) {
-    return ::mediapipe::InternalError(status.error_message());
+  // The pixel fetch, which either reads the input texel at gid, or samples
+  // the input at the rotated, flipped and scaled position of gid.
+  std::string pixel_fetch =
+      include_alpha ? "vec4 pixel = texelFetch(input_texture, gid, 0);"
+                    : "vec3 pixel = texelFetch(input_texture, gid, 0).xyz;";
+  if (output_width_) {
+    int rotated_width = input.width();
+    int rotated_height = input.height();
+    if (rotation_ == RotationMode::ROTATION_90 ||
+        rotation_ == RotationMode::ROTATION_270) {
+      std::swap(rotated_width, rotated_height);
+    }
+    // Scales output coordinates around the center to rotated input ones.
+    const float input_aspect_ratio =
+        static_cast<float>(rotated_width) / rotated_height;
+    const float output_aspect_ratio =
+        static_cast<float>(output_width_) / output_height_;
+    float scale_x = 1.0f;
+    float scale_y = 1.0f;
+    if (scale_mode_ == ScaleMode::FIT) {
+      if (input_aspect_ratio < output_aspect_ratio) {
+        scale_x = output_aspect_ratio / input_aspect_ratio;
+        letterbox_padding_[0] = (1.f - 1.f / scale_x) / 2.f;
+        letterbox_padding_[2] = letterbox_padding_[0];
+      } else {
+        scale_y = input_aspect_ratio / output_aspect_ratio;
+        letterbox_padding_[1] = (1.f - 1.f / scale_y) / 2.f;
+        letterbox_padding_[3] = letterbox_padding_[1];
+      }
+    } else if (scale_mode_ == ScaleMode::FILL_AND_CROP) {
+      if (input_aspect_ratio > output_aspect_ratio) {
+        scale_x = output_aspect_ratio / input_aspect_ratio;
+      } else {
+        scale_y = input_aspect_ratio / output_aspect_ratio;
+      }
+    }
+    // Maps a position in the counterclockwise rotated input to the input.
+    std::string unrotate = "position";
+    if (rotation_ == RotationMode::ROTATION_90) {
+      unrotate = "vec2(1.0 - position.y, position.x)";
+    } else if (rotation_ == RotationMode::ROTATION_180) {
+      unrotate = "vec2(1.0) - position";
+    } else if (rotation_ == RotationMode::ROTATION_270) {
+      unrotate = "vec2(position.y, 1.0 - position.x)";
+    }
+    pixel_fetch = absl::Substitute(
+        R"(
+            vec2 position = (vec2(gid) + 0.5) / vec2(width_height);
+            position = (position - 0.5) * vec2($0, $1) + 0.5;
+            $2
+            $3 pixel = texture(input_texture, $4).$5;
+            // Letterbox with black.
+            if (any(lessThan(position, vec2(0.0))) ||
+                any(greaterThan(position, vec2(1.0)))) {
+              pixel = $3(0.0);
+            })",
+        /*$0=*/scale_x, /*$1=*/scale_y,
+        /*$2=*/flip_horizontally_ ? "position.x = 1.0 - position.x;" : "",
+        /*$3=*/include_alpha ? "vec4" : "vec3", /*$4=*/unrotate,
+        /*$5=*/include_alpha ? "xyzw" : "xyz");
   }
 
   // Shader to convert GL Texture to Shader Storage Buffer Object (SSBO),
@@ -513,17 +747,60 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
             output_data.elements[linear_index + 2] = pixel.z;
             $6  // alpha channel
           })",
-      /*$0=*/kWorkgroupSize, /*$1=*/input.width(), /*$2=*/input.height(),
+      /*$0=*/kWorkgroupSize, /*$1=*/output_width, /*$2=*/output_height,
       /*$3=*/zero_center_ ? "pixel = (pixel - 0.5) * 2.0;" : "",
       /*$4=*/flip_vertically_ ? "(width_height.y - 1 - gid.y)" : "gid.y",
-      /*$5=*/
-      include_alpha ? "vec4 pixel = texelFetch(input_texture, gid, 0);"
-                    : "vec3 pixel = texelFetch(input_texture, gid, 0).xyz;",
+      /*$5=*/pixel_fetch,
       /*$6=*/
       include_alpha ? "output_data.elements[linear_index + 3] = pixel.w;" : "",
       /*$7=*/include_alpha ? 4 : 3);
-  status = GlShader::CompileShader(GL_COMPUTE_SHADER, shader_source,
-                                   &gpu_data_out_->shader);
+  // With use_fp16_tensors, each invocation converts a pair of consecutive
+  // output pixels and packs their channels two halves per word, so that
+  // every word is written whole by one invocation.
+  const std::string fp16_shader_source = absl::Substitute(
+      R"( #version 310 es
+          layout(local_size_x = $0) in;
+          layout(binding = 0) uniform sampler2D input_texture;
+          layout(std430, binding = 1) buffer Output {uint elements[];} output_data;
+          ivec2 width_height = ivec2($1, $2);
+          $6 FetchPixel(int index) {
+            int row = index / width_height.x;
+            ivec2 gid = ivec2(index - row * width_height.x, $4);
+            $5  // pixel fetch
+            $3  // normalize [-1,1]
+            return pixel;
+          }
+          void main() {
+            int pair = int(gl_GlobalInvocationID.x);
+            int num_pixels = width_height.x * width_height.y;
+            if (2 * pair >= num_pixels) return;
+            $6 pixel0 = FetchPixel(2 * pair);
+            $6 pixel1 = 2 * pair + 1 < num_pixels ? FetchPixel(2 * pair + 1)
+                                                  : $6(0.0);
+            int linear_index = $7 * pair;
+            $8
+          })",
+      /*$0=*/kWorkgroupSize * kWorkgroupSize, /*$1=*/output_width,
+      /*$2=*/output_height,
+      /*$3=*/zero_center_ ? "pixel = (pixel - 0.5) * 2.0;" : "",
+      /*$4=*/flip_vertically_ ? "width_height.y - 1 - row" : "row",
+      /*$5=*/pixel_fetch, /*$6=*/include_alpha ? "vec4" : "vec3",
+      /*$7=*/include_alpha ? 4 : 3,
+      /*$8=*/
+      include_alpha
+          ? R"(
+            output_data.elements[linear_index + 0] = packHalf2x16(pixel0.xy);
+            output_data.elements[linear_index + 1] = packHalf2x16(pixel0.zw);
+            output_data.elements[linear_index + 2] = packHalf2x16(pixel1.xy);
+            output_data.elements[linear_index + 3] = packHalf2x16(pixel1.zw);)"
+          : R"(
+            output_data.elements[linear_index + 0] = packHalf2x16(pixel0.xy);
+            output_data.elements[linear_index + 1] =
+                packHalf2x16(vec2(pixel0.z, pixel1.x));
+            output_data.elements[linear_index + 2] = packHalf2x16(pixel1.yz);)");
+  auto status = GlShader::CompileShader(
+      GL_COMPUTE_SHADER, use_fp16_tensors_ ? fp16_shader_source : shader_source,
+      &gpu_data_out_->shader);
   if (!status.ok()) {
     return ::mediapipe::InternalError(status.error_message());
   }
@@ -538,8 +815,10 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
 
   // Device memory.
   id<MTLDevice> device = gpu_helper_.mtlDevice;
+  const int element_size =
+      use_fp16_tensors_ ? sizeof(uint16_t) : sizeof(float);
   gpu_data_out_->buffer =
-      [device newBufferWithLength:gpu_data_out_->elements * sizeof(float)
+      [device newBufferWithLength:gpu_data_out_->elements * element_size
                           options:MTLResourceStorageModeShared];
 
   // Shader to convert GL Texture to Metal Buffer,
@@ -554,7 +833,7 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
 
   kernel void convertKernel(
       texture2d<half, access::sample> in_tex  [[ texture(0) ]],
-      device float*                   out_buf [[ buffer(1) ]],
+      device $6*                      out_buf [[ buffer(1) ]],
       uint2                           gid     [[ thread_position_in_grid ]]) {
     if (gid.x >= in_tex.get_width() || gid.y >= in_tex.get_height()) return;
     constexpr sampler texture_sampler(coord::pixel, address::clamp_to_edge);
@@ -562,9 +841,9 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
     $0 pixel = $0(in_tex.sample(texture_sampler, coord).$1);
     $2   // normalize [-1,1]
     const int linear_index = $4 * ($3 * in_tex.get_width() + gid.x);
-    out_buf[linear_index + 0] = pixel.x;
-    out_buf[linear_index + 1] = pixel.y;
-    out_buf[linear_index + 2] = pixel.z;
+    out_buf[linear_index + 0] = $6(pixel.x);
+    out_buf[linear_index + 1] = $6(pixel.y);
+    out_buf[linear_index + 2] = $6(pixel.z);
     $5  // alpha channel
   }
       )",
@@ -573,7 +852,12 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
       /*$2=*/zero_center_ ? "pixel = (pixel - 0.5) * 2.0;" : "",
       /*$3=*/flip_vertically_ ? "(in_tex.get_height() - 1 - gid.y)" : "gid.y",
       /*$4=*/include_alpha ? 4 : 3,
-      /*$5=*/include_alpha ? "out_buf[linear_index + 3] = pixel.w;" : "");
+      /*$5=*/
+      include_alpha ? (use_fp16_tensors_
+                           ? "out_buf[linear_index + 3] = half(pixel.w);"
+                           : "out_buf[linear_index + 3] = float(pixel.w);")
+                    : "",
+      /*$6=*/use_fp16_tensors_ ? "half" : "float");
 
   NSString* library_source =
       [NSString stringWithUTF8String:shader_source.c_str()];
@@ -595,6 +879,35 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
   return ::mediapipe::OkStatus();
 }
 
+void TfLiteConverterCalculator::ConvertYUVImage(const YUVImage& yuv_image,
+                                                ImageFrame* image_frame) {
+  const int input_width = yuv_image.width();
+  const int input_height = yuv_image.height();
+  if (!output_width_) {
+    image_frame_util::YUVImageToImageFrame(yuv_image, image_frame);
+    return;
+  }
+  // For FILL_AND_CROP, only the center region with the output aspect ratio
+  // is scaled and converted.
+  int crop_width = input_width;
+  int crop_height = input_height;
+  if (scale_mode_ == ScaleMode::FILL_AND_CROP) {
+    const float input_aspect_ratio =
+        static_cast<float>(input_width) / input_height;
+    const float output_aspect_ratio =
+        static_cast<float>(output_width_) / output_height_;
+    if (input_aspect_ratio > output_aspect_ratio) {
+      crop_width = std::round(input_height * output_aspect_ratio);
+    } else {
+      crop_height = std::round(input_width / output_aspect_ratio);
+    }
+  }
+  image_frame_util::YUVImageRegionToImageFrame(
+      yuv_image, (input_width - crop_width) / 2,
+      (input_height - crop_height) / 2, crop_width, crop_height, output_width_,
+      output_height_, image_frame);
+}
+
 ::mediapipe::Status TfLiteConverterCalculator::LoadOptions(
     CalculatorContext* cc) {
   // Get calculator options specified in the graph.
@@ -610,6 +923,20 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
   // Get row_major_matrix mode.
   row_major_matrix_ = options.row_major_matrix();
 
+  // Get the fused image transformation.
+  RET_CHECK_EQ(options.output_width() > 0, options.output_height() > 0)
+      << "output_width and output_height must be set together.";
+  output_width_ = options.output_width();
+  output_height_ = options.output_height();
+  if (options.has_rotation_mode() &&
+      options.rotation_mode() != RotationMode::UNKNOWN) {
+    rotation_ = options.rotation_mode();
+  }
+  flip_horizontally_ = options.flip_horizontally();
+  if (options.has_scale_mode() && options.scale_mode() != ScaleMode::DEFAULT) {
+    scale_mode_ = options.scale_mode();
+  }
+
   // Get desired way to handle input channels.
   max_num_channels_ = options.max_num_channels();
   // Currently only alpha channel toggling is suppored.
@@ -624,19 +951,67 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
 
   // Get tensor type, float or quantized.
   use_quantized_tensors_ = options.use_quantized_tensors();
+  signed_quantized_tensors_ = options.signed_quantized_tensors();
+  RET_CHECK(use_quantized_tensors_ || !signed_quantized_tensors_)
+      << "signed_quantized_tensors requires use_quantized_tensors.";
+  use_fp16_tensors_ = options.use_fp16_tensors();
+  RET_CHECK(!(use_fp16_tensors_ && use_quantized_tensors_))
+      << "use_fp16_tensors and use_quantized_tensors are exclusive.";
+
+  // Tabulate the quantized value of each 8-bit pixel value, so that images
+  // are quantized without any float arithmetic per pixel.
+  RET_CHECK_GE(options.quantization_scale(), 0.0f);
+  const int min_value = signed_quantized_tensors_ ? -128 : 0;
+  const int max_value = signed_quantized_tensors_ ? 127 : 255;
+  if (options.quantization_scale() > 0.0f) {
+    RET_CHECK(options.quantization_zero_point() >= min_value &&
+              options.quantization_zero_point() <= max_value)
+        << "quantization_zero_point is out of range.";
+    quantization_params_.scale = options.quantization_scale();
+    quantization_params_.zero_point = options.quantization_zero_point();
+  }
+  quantization_is_identity_ = !signed_quantized_tensors_;
+  for (int value = 0; value < 256; ++value) {
+    int quantized_value;
+    if (quantization_params_.scale > 0.0f) {
+      const float real_value =
+          zero_center_ ? value / 127.5f - 1.0f : value / 255.0f;
+      quantized_value = static_cast<int>(
+          std::round(real_value / quantization_params_.scale) +
+          quantization_params_.zero_point);
+    } else {
+      quantized_value = value + min_value;
+    }
+    quantized_value = std::min(std::max(quantized_value, min_value), max_value);
+    quantization_table_[value] = static_cast<uint8>(quantized_value);
+    quantization_is_identity_ &= quantization_table_[value] == value;
+  }
 
   return ::mediapipe::OkStatus();
 }
 
-template <class T>
+template <class TensorT>
+::mediapipe::Status TfLiteConverterCalculator::NormalizeImage(
+    const ImageFrame& image_frame, TensorT* tensor_buffer) {
+  if (image_frame.ByteDepth() == 1) {
+    return NormalizeImage<uint8>(image_frame, zero_center_, flip_vertically_,
+                                 tensor_buffer);
+  } else if (image_frame.ByteDepth() == 4) {
+    return NormalizeImage<float>(image_frame, zero_center_, flip_vertically_,
+                                 tensor_buffer);
+  }
+  return ::mediapipe::InternalError(
+      "Only byte-based (8 bit) and float (32 bit) images supported.");
+}
+
+template <class T, class TensorT>
 ::mediapipe::Status TfLiteConverterCalculator::NormalizeImage(
     const ImageFrame& image_frame, bool zero_center, bool flip_vertically,
-    float* tensor_buffer) {
+    TensorT* tensor_buffer) {
   const int height = image_frame.Height();
   const int width = image_frame.Width();
   const int channels = image_frame.NumberOfChannels();
   const int channels_preserved = std::min(channels, max_num_channels_);
-  const int channels_ignored = channels - channels_preserved;
 
   float div, sub;
   if (zero_center) {
@@ -653,27 +1028,58 @@ template <class T>
     const T* image_ptr = reinterpret_cast<const T*>(
         image_frame.PixelData() +
         (flip_vertically ? height - 1 - i : i) * image_frame.WidthStep());
-    for (int j = 0; j < width; ++j) {
-      for (int c = 0; c < channels_preserved; ++c) {
-        *tensor_buffer++ = *image_ptr++ / div - sub;
+    NormalizeRow(image_ptr, width, channels, channels_preserved, div, sub,
+                 tensor_buffer);
+    tensor_buffer += width * channels_preserved;
+  }
+
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status TfLiteConverterCalculator::QuantizeImage(
+    const ImageFrame& image_frame, bool flip_vertically, uint8* tensor_buffer) {
+  const int height = image_frame.Height();
+  const int width = image_frame.Width();
+  const int channels = image_frame.NumberOfChannels();
+  const int channels_preserved = std::min(channels, max_num_channels_);
+  const int channels_ignored = channels - channels_preserved;
+  const int row_size = width * channels;
+
+  for (int i = 0; i < height; ++i) {
+    const uint8* image_ptr =
+        image_frame.PixelData() +
+        (flip_vertically ? height - 1 - i : i) * image_frame.WidthStep();
+    if (channels_ignored == 0 && quantization_is_identity_) {
+      std::memcpy(tensor_buffer, image_ptr, row_size);
+      tensor_buffer += row_size;
+    } else if (channels_ignored == 0) {
+      for (int j = 0; j < row_size; ++j) {
+        *tensor_buffer++ = quantization_table_[*image_ptr++];
+      }
+    } else {
+      for (int j = 0; j < width; ++j) {
+        for (int c = 0; c < channels_preserved; ++c) {
+          *tensor_buffer++ = quantization_table_[*image_ptr++];
+        }
+        image_ptr += channels_ignored;
       }
-      image_ptr += channels_ignored;
     }
   }
 
   return ::mediapipe::OkStatus();
 }
 
+template <class TensorT>
 ::mediapipe::Status TfLiteConverterCalculator::CopyMatrixToTensor(
-    const Matrix& matrix, float* tensor_buffer) {
+    const Eigen::Ref<const Matrix>& matrix, TensorT* tensor_buffer) {
   if (row_major_matrix_) {
-    auto matrix_map = Eigen::Map<RowMajorMatrixXf>(tensor_buffer, matrix.rows(),
-                                                   matrix.cols());
-    matrix_map = matrix;
+    auto matrix_map = Eigen::Map<RowMajorMatrixX<TensorT>>(
+        tensor_buffer, matrix.rows(), matrix.cols());
+    matrix_map = matrix.cast<TensorT>();
   } else {
-    auto matrix_map = Eigen::Map<ColMajorMatrixXf>(tensor_buffer, matrix.rows(),
-                                                   matrix.cols());
-    matrix_map = matrix;
+    auto matrix_map = Eigen::Map<ColMajorMatrixX<TensorT>>(
+        tensor_buffer, matrix.rows(), matrix.cols());
+    matrix_map = matrix.cast<TensorT>();
   }
 
   return ::mediapipe::OkStatus();
@@ -12,19 +12,25 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <random>
+#include <string>
 #include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/substitute.h"
 #include "mediapipe/calculators/tflite/tflite_converter_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/matrix.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/parse_text_proto.h"
 #include "mediapipe/framework/port/status_matchers.h"  // NOLINT
 #include "mediapipe/framework/tool/validate_type.h"
+#include "mediapipe/util/tflite/fp16_util.h"
 #include "tensorflow/lite/interpreter.h"
 
 namespace mediapipe {
@@ -71,9 +77,183 @@ class TfLiteConverterCalculatorTest : public ::testing::Test {
         "matrix", Adopt(matrix.release()).At(Timestamp(0))));
   }
 
+  // Converts a one-row image holding "pixels" and returns the bytes of the
+  // quantized tensor.
+  std::vector<uint8> QuantizeImage(ImageFormat::Format format,
+                                   const std::vector<uint8>& pixels,
+                                   const std::string& options,
+                                   TfLiteTensor* tensor_out) {
+    CalculatorGraphConfig graph_config =
+        ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(
+            absl::Substitute(R"(
+              input_stream: "image"
+              node {
+                calculator: "TfLiteConverterCalculator"
+                input_stream: "IMAGE:image"
+                output_stream: "TENSORS:tensor"
+                options {
+                  [mediapipe.TfLiteConverterCalculatorOptions.ext] {
+                    use_quantized_tensors: true
+                    $0
+                  }
+                }
+              }
+            )",
+                             options));
+    std::vector<Packet> output_packets;
+    tool::AddVectorSink("tensor", &graph_config, &output_packets);
+    graph_ = absl::make_unique<CalculatorGraph>();
+    MP_EXPECT_OK(graph_->Initialize(graph_config));
+    MP_EXPECT_OK(graph_->StartRun({}));
+
+    auto image_frame = absl::make_unique<ImageFrame>(format, /*width=*/2,
+                                                     /*height=*/1);
+    std::copy(pixels.begin(), pixels.end(), image_frame->MutablePixelData());
+    MP_EXPECT_OK(graph_->AddPacketToInputStream(
+        "image", Adopt(image_frame.release()).At(Timestamp(0))));
+    MP_EXPECT_OK(graph_->WaitUntilIdle());
+    EXPECT_EQ(1, output_packets.size());
+
+    const TfLiteTensor& tensor =
+        output_packets[0].Get<std::vector<TfLiteTensor>>()[0];
+    *tensor_out = tensor;
+    std::vector<uint8> data(tensor.data.uint8,
+                            tensor.data.uint8 + tensor.bytes);
+
+    MP_EXPECT_OK(graph_->CloseInputStream("image"));
+    MP_EXPECT_OK(graph_->WaitUntilDone());
+    graph_.reset();
+    return data;
+  }
+
   std::unique_ptr<CalculatorGraph> graph_;
 };
 
+TEST_F(TfLiteConverterCalculatorTest, QuantizedImage) {
+  TfLiteTensor tensor;
+  // real_value = pixel / 255 = 2 / 255 * (quantized_value - 10).
+  std::vector<uint8> data = QuantizeImage(
+      ImageFormat::SRGB, {0, 2, 100, 254, 4, 6}, R"(
+        zero_center: false
+        quantization_scale: 0.00784313725
+        quantization_zero_point: 10
+      )",
+      &tensor);
+  EXPECT_EQ(kTfLiteUInt8, tensor.type);
+  EXPECT_FLOAT_EQ(0.00784313725f, tensor.params.scale);
+  EXPECT_EQ(10, tensor.params.zero_point);
+  EXPECT_EQ(std::vector<uint8>({10, 11, 60, 137, 12, 13}), data);
+}
+
+TEST_F(TfLiteConverterCalculatorTest, SignedQuantizedImage) {
+  TfLiteTensor tensor;
+  // Without a scale, pixels are offset by -128, and alpha is dropped.
+  std::vector<uint8> data = QuantizeImage(
+      ImageFormat::SRGBA, {0, 128, 255, 7, 1, 2, 3, 7},
+      "signed_quantized_tensors: true", &tensor);
+  EXPECT_EQ(kTfLiteInt8, tensor.type);
+  std::vector<int8> expected = {-128, 0, 127, -127, -126, -125};
+  ASSERT_EQ(expected.size(), data.size());
+  for (int i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i], static_cast<int8>(data[i])) << "at i = " << i;
+  }
+}
+
+TEST_F(TfLiteConverterCalculatorTest, Fp16Image) {
+  CalculatorGraphConfig graph_config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "image"
+        node {
+          calculator: "TfLiteConverterCalculator"
+          input_stream: "IMAGE:image"
+          output_stream: "TENSORS:tensor"
+          options {
+            [mediapipe.TfLiteConverterCalculatorOptions.ext] {
+              use_fp16_tensors: true
+            }
+          }
+        }
+      )");
+  std::vector<Packet> output_packets;
+  tool::AddVectorSink("tensor", &graph_config, &output_packets);
+  graph_ = absl::make_unique<CalculatorGraph>();
+  MP_ASSERT_OK(graph_->Initialize(graph_config));
+  MP_ASSERT_OK(graph_->StartRun({}));
+
+  auto image_frame = absl::make_unique<ImageFrame>(ImageFormat::SRGB,
+                                                   /*width=*/2, /*height=*/1);
+  const std::vector<uint8> pixels = {0, 51, 102, 153, 204, 255};
+  std::copy(pixels.begin(), pixels.end(), image_frame->MutablePixelData());
+  MP_ASSERT_OK(graph_->AddPacketToInputStream(
+      "image", Adopt(image_frame.release()).At(Timestamp(0))));
+  MP_ASSERT_OK(graph_->WaitUntilIdle());
+  ASSERT_EQ(1, output_packets.size());
+
+  // The pixels are normalized to [-1,1] and stored as halves.
+  const TfLiteTensor& tensor =
+      output_packets[0].Get<std::vector<TfLiteTensor>>()[0];
+  EXPECT_EQ(kTfLiteFloat16, tensor.type);
+  ASSERT_EQ(pixels.size() * sizeof(uint16), tensor.bytes);
+  const uint16* halves = reinterpret_cast<const uint16*>(tensor.data.raw);
+  for (int i = 0; i < pixels.size(); ++i) {
+    EXPECT_NEAR(pixels[i] / 127.5f - 1.0f, HalfToFloat(halves[i]), 1e-3f)
+        << "at i = " << i;
+  }
+
+  MP_ASSERT_OK(graph_->CloseInputStream("image"));
+  MP_ASSERT_OK(graph_->WaitUntilDone());
+  graph_.reset();
+}
+
+TEST_F(TfLiteConverterCalculatorTest, BatchedImages) {
+  CalculatorGraphConfig graph_config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "images"
+        node {
+          calculator: "TfLiteConverterCalculator"
+          input_stream: "IMAGES:images"
+          output_stream: "TENSORS:tensor"
+          options {
+            [mediapipe.TfLiteConverterCalculatorOptions.ext] {
+              zero_center: false
+            }
+          }
+        }
+      )");
+  std::vector<Packet> output_packets;
+  tool::AddVectorSink("tensor", &graph_config, &output_packets);
+  graph_ = absl::make_unique<CalculatorGraph>();
+  MP_ASSERT_OK(graph_->Initialize(graph_config));
+  MP_ASSERT_OK(graph_->StartRun({}));
+
+  auto images = absl::make_unique<std::vector<ImageFrame>>();
+  for (uint8 value : {51, 102}) {
+    images->emplace_back(ImageFormat::SRGB, /*width=*/2, /*height=*/1);
+    std::fill(images->back().MutablePixelData(),
+              images->back().MutablePixelData() + 6, value);
+  }
+  MP_ASSERT_OK(graph_->AddPacketToInputStream(
+      "images", Adopt(images.release()).At(Timestamp(0))));
+  MP_ASSERT_OK(graph_->WaitUntilIdle());
+  ASSERT_EQ(1, output_packets.size());
+
+  // The images are stacked along a leading batch dimension.
+  const TfLiteTensor& tensor =
+      output_packets[0].Get<std::vector<TfLiteTensor>>()[0];
+  ASSERT_EQ(4, tensor.dims->size);
+  EXPECT_EQ(2, tensor.dims->data[0]);
+  EXPECT_EQ(1, tensor.dims->data[1]);
+  EXPECT_EQ(2, tensor.dims->data[2]);
+  EXPECT_EQ(3, tensor.dims->data[3]);
+  for (int i = 0; i < 12; ++i) {
+    EXPECT_FLOAT_EQ(i < 6 ? 0.2f : 0.4f, tensor.data.f[i]) << "at i = " << i;
+  }
+
+  MP_ASSERT_OK(graph_->CloseInputStream("images"));
+  MP_ASSERT_OK(graph_->WaitUntilDone());
+  graph_.reset();
+}
+
 TEST_F(TfLiteConverterCalculatorTest, RandomMatrixColMajor) {
   for (int size_index = 0; size_index < kNumSizes; ++size_index) {
     const int num_rows = sizes[size_index][0];
@@ -12,13 +12,30 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "mediapipe/calculators/tflite/tflite_inference_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/mediapipe_profiling.h"
 #include "mediapipe/framework/port/ret_check.h"
-#include "mediapipe/util/resource_util.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/port/threadpool.h"
+#include "mediapipe/util/cpu_util.h"
+#include "mediapipe/util/tflite/fp16_util.h"
+#include "mediapipe/util/tflite/tflite_inference_service.h"
+#include "mediapipe/util/tflite/tflite_model_cache.h"
+#include "mediapipe/util/tflite/tflite_model_update_service.h"
 #include "tensorflow/lite/error_reporter.h"
 #include "tensorflow/lite/interpreter.h"
 #include "tensorflow/lite/kernels/register.h"
@@ -27,6 +44,8 @@
 #if defined(__ANDROID__)
 #include "mediapipe/gpu/gl_calculator_helper.h"
 #include "mediapipe/gpu/gpu_buffer.h"
+#include "mediapipe/util/tflite/cached_gl_delegate.h"
+#include "mediapipe/util/tflite/gl_buffer_readback.h"
 #include "tensorflow/lite/delegates/gpu/gl/gl_buffer.h"
 #include "tensorflow/lite/delegates/gpu/gl/gl_program.h"
 #include "tensorflow/lite/delegates/gpu/gl/gl_shader.h"
@@ -62,6 +81,14 @@ struct GPUData {
   int elements = 1;
   GlBuffer buffer;
 };
+// The programs converting fp16 TENSORS_GPU inputs and outputs, which hold two
+// halves per word, to and from the float buffers bound to the delegate.
+struct Fp16Programs {
+  GlShader unpack_shader;
+  GlProgram unpack_program;
+  GlShader pack_shader;
+  GlProgram pack_program;
+};
 #elif defined(__APPLE__) && !TARGET_OS_OSX  // iOS
 struct GPUData {
   int elements = 1;
@@ -69,6 +96,112 @@ struct GPUData {
 };
 #endif
 
+namespace {
+
+// The alignment TfLite kernels expect of tensor buffers.
+constexpr uintptr_t kTensorAlignment = 16;
+
+// The number of inferences whose GPU outputs can be read back at once with
+// gpu_async_readback: the outputs of one inference are copied while the next
+// one runs.
+constexpr int kNumReadbackSlots = 2;
+
+// Returns true if the interpreter input "local_tensor" can read the data of
+// "input_tensor" in place, rather than from a copy.
+bool CanBindInputTensor(const TfLiteTensor& input_tensor,
+                        const TfLiteTensor& local_tensor) {
+  return input_tensor.type == local_tensor.type &&
+         input_tensor.bytes == local_tensor.bytes &&
+         local_tensor.allocation_type == kTfLiteArenaRw &&
+         reinterpret_cast<uintptr_t>(input_tensor.data.raw) %
+                 kTensorAlignment ==
+             0;
+}
+
+struct TfLiteIntArrayDeleter {
+  void operator()(TfLiteIntArray* array) const { TfLiteIntArrayFree(array); }
+};
+
+#if defined(__ANDROID__)
+// Block size of the fp16 conversion shaders, each invocation of which
+// converts one pair of elements.
+constexpr int kFp16WorkgroupSize = 64;
+
+// Unpacks num_elements halves into floats.
+constexpr char kUnpackHalvesShader[] = R"( #version 310 es
+    layout(local_size_x = 64) in;
+    layout(location = 0) uniform int num_elements;
+    layout(std430, binding = 0) readonly buffer Input {uint elements[];} input_data;
+    layout(std430, binding = 1) writeonly buffer Output {float elements[];} output_data;
+    void main() {
+      int index = 2 * int(gl_GlobalInvocationID.x);
+      if (index >= num_elements) return;
+      vec2 values = unpackHalf2x16(input_data.elements[index / 2]);
+      output_data.elements[index] = values.x;
+      if (index + 1 < num_elements) output_data.elements[index + 1] = values.y;
+    })";
+
+// Packs num_elements floats into halves, padding an odd count with 0.
+constexpr char kPackHalvesShader[] = R"( #version 310 es
+    layout(local_size_x = 64) in;
+    layout(location = 0) uniform int num_elements;
+    layout(std430, binding = 0) readonly buffer Input {float elements[];} input_data;
+    layout(std430, binding = 1) writeonly buffer Output {uint elements[];} output_data;
+    void main() {
+      int index = 2 * int(gl_GlobalInvocationID.x);
+      if (index >= num_elements) return;
+      vec2 values = vec2(input_data.elements[index],
+                         index + 1 < num_elements
+                             ? input_data.elements[index + 1] : 0.0);
+      output_data.elements[index / 2] = packHalf2x16(values);
+    })";
+
+::mediapipe::Status CompileComputeProgram(const std::string& source,
+                                          GlShader* shader,
+                                          GlProgram* program) {
+  auto status = GlShader::CompileShader(GL_COMPUTE_SHADER, source, shader);
+  if (!status.ok()) {
+    return ::mediapipe::InternalError(status.error_message());
+  }
+  status = GlProgram::CreateWithShader(*shader, program);
+  if (!status.ok()) {
+    return ::mediapipe::InternalError(status.error_message());
+  }
+  return ::mediapipe::OkStatus();
+}
+
+// Runs one of the fp16 conversion programs over num_elements elements of
+// "input", writing "output". Must be called in the GL context.
+::mediapipe::Status RunFp16Program(const GlProgram& program, int num_elements,
+                                   const GlBuffer& input,
+                                   const GlBuffer& output) {
+  glUseProgram(program.id());
+  glUniform1i(0, num_elements);
+  auto status = input.BindToIndex(0);
+  if (!status.ok()) {
+    return ::mediapipe::InternalError(status.error_message());
+  }
+  status = output.BindToIndex(1);
+  if (!status.ok()) {
+    return ::mediapipe::InternalError(status.error_message());
+  }
+  const int num_pairs = (num_elements + 1) / 2;
+  status = program.Dispatch(
+      {static_cast<unsigned int>(
+           (num_pairs + kFp16WorkgroupSize - 1) / kFp16WorkgroupSize),
+       1, 1});
+  if (!status.ok()) {
+    return ::mediapipe::InternalError(status.error_message());
+  }
+  // Makes the writes visible to the shaders reading "output" next.
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  return ::mediapipe::OkStatus();
+}
+#endif  // __ANDROID__
+
+}  // namespace
+
 // Calculator Header Section
 
 // Runs inference on the provided input TFLite tensors and TFLite model.
@@ -85,8 +218,10 @@ struct GPUData {
 // GPU.
 //
 // Input:
-//  TENSORS - Vector of TfLiteTensor of type kTfLiteFloat32 or kTfLiteUInt8
-//  TENSORS_GPU - Vector of GlBuffer or MTLBuffer
+//  TENSORS - Vector of TfLiteTensor of type kTfLiteFloat32 or kTfLiteUInt8,
+//            or kTfLiteFloat16 for a float model input
+//  TENSORS_GPU - Vector of GlBuffer or MTLBuffer, of halves with
+//                use_fp16_tensors
 //
 // Output:
 //  TENSORS - Vector of TfLiteTensor of type kTfLiteFloat32 or kTfLiteUInt8
@@ -95,6 +230,10 @@ struct GPUData {
 // Input side packet:
 //  CUSTOM_OP_RESOLVER (optional) - Use a custom op resolver,
 //                                  instead of the builtin one.
+//  WARMUP_TENSORS (optional) - Vector of TfLiteTensor matching the model
+//                              inputs, run warmup_invocations times in
+//                              Open() instead of zero-filled inputs. Not
+//                              used with TENSORS_GPU input.
 //
 // Example use:
 // node {
@@ -112,10 +251,40 @@ struct GPUData {
 // IMPORTANT Notes:
 //  Tensors are assumed to be ordered correctly (sequentially added to model).
 //  Input tensors are assumed to be of the correct size and already normalized.
+//  For CPU inference, an input tensor differing from the model input only in
+//  its first dimension, such as a batch of N ROIs from
+//  TfLiteConverterCalculator, resizes the model input, and the model runs once
+//  for the whole batch.
+//  For CPU inference, aligned input tensors of the model's input type and
+//  size are read in place rather than copied, so their data must not change
+//  while the packet is being processed.
 //  All output TfLiteTensors will be destroyed when the graph closes,
 //  (i.e. after calling graph.WaitUntilDone()).
 //  GPU tensors are currently only supported on Android and iOS.
 //  This calculator uses FixedSizeInputStreamHandler by default.
+//  With num_interpreters other than 1, CPU inference runs on several
+//  timestamps at once, on a pool of interpreters sharing one model, and the
+//  node's outputs are still delivered in order.
+//  With batch_size greater than 1, the outputs of a timestamp are sent once
+//  its batch has run, and point into the interpreter outputs until the next
+//  batch runs.  Upstream flow limiting must then let at least batch_size
+//  timestamps in flight.
+//  With use_inference_service, the model runs on the graph's
+//  TfLiteInferenceService, together with the requests of other nodes using
+//  the same model, and the outputs stay valid until the next Process() call.
+//  With warmup_invocations, every interpreter runs that many inferences in
+//  Open().  Nodes are opened in parallel on the graph's executor, so the
+//  warm-up of several models overlaps.
+//  With gpu_async_readback, the CPU outputs of GPU inference on Android are
+//  sent one timestamp late, when the next input is processed or the graph
+//  closes, and stay valid until the outputs of the timestamp after that are
+//  sent.
+//  With allow_model_updates, CPU inference switches to the model that the
+//  graph's TfLiteModelUpdateService names for model_path, without stopping
+//  the graph. The new model and its interpreters are loaded and warmed up on
+//  a background thread while the old model keeps running, and the switch
+//  happens between two timestamps. The interpreters of the previous model
+//  are kept until the next switch, so that its last outputs stay valid.
 //
 class TfLiteInferenceCalculator : public CalculatorBase {
  public:
@@ -129,15 +298,103 @@ class TfLiteInferenceCalculator : public CalculatorBase {
   ::mediapipe::Status LoadOptions(CalculatorContext* cc);
   ::mediapipe::Status LoadModel(CalculatorContext* cc);
   ::mediapipe::Status LoadDelegate(CalculatorContext* cc);
+  // Runs num_invocations inferences on each interpreter, on WARMUP_TENSORS or
+  // on zero-filled inputs, and reports their time to the graph profiler.
+  ::mediapipe::Status WarmUp(CalculatorContext* cc, int num_invocations);
+  // Copies "warmup_tensors" into the inputs of "interpreter", or zero-fills
+  // them if it is null.
+  ::mediapipe::Status FillWarmupInputs(
+      const std::vector<TfLiteTensor>* warmup_tensors,
+      tflite::Interpreter* interpreter);
+  // Resizes and allocates the interpreter tensors to hold batch_size_
+  // timestamps.
+  ::mediapipe::Status ResizeForBatching();
+  // Runs the pending batch and sends the outputs of each of its timestamps.
+  ::mediapipe::Status RunBatch(CalculatorContext* cc);
+  // Resizes the inputs of a CPU interpreter whose batch dimension differs
+  // from that of the matching input tensor, such as a tensor holding a
+  // variable number of ROIs.
+  ::mediapipe::Status ResizeInputsToMatch(
+      const std::vector<TfLiteTensor>& input_tensors,
+      tflite::Interpreter* interpreter);
+  // Applies the CPU options to an interpreter that runs on CPU.
+  ::mediapipe::Status ConfigureCpuInterpreter(
+      const ::mediapipe::TfLiteInferenceCalculatorOptions& options,
+      tflite::Interpreter* interpreter);
+
+  // A model loaded for an update, with interpreters configured and warmed up
+  // as those of LoadModel.
+  struct ModelInterpreters {
+    std::string model_path;
+    std::shared_ptr<tflite::FlatBufferModel> model;
+    std::unique_ptr<tflite::Interpreter> interpreter;
+    std::vector<std::unique_ptr<tflite::Interpreter>> extra_interpreters;
+  };
+  // Starts loading the model that model_updates_ names for model_path_ if it
+  // changed, and switches to a model that finished loading.
+  ::mediapipe::Status CheckModelUpdate(CalculatorContext* cc);
+  // Loads "loaded->model_path" and builds its interpreters. Runs on
+  // model_loader_.
+  ::mediapipe::Status LoadModelInterpreters(ModelInterpreters* loaded);
+  // Replaces the running interpreters with those of loaded_model_.
+  void SwitchModel(CalculatorContext* cc)
+      EXCLUSIVE_LOCKS_REQUIRED(model_update_mutex_);
+
+#if defined(__ANDROID__)
+  // Binds an SSBO to a tensor of delegate_, whichever GL delegate it is.
+  TfLiteStatus BindBufferToTensor(GLuint buffer, int tensor_index);
+  // Starts reading back the outputs of the inference of the current
+  // timestamp, unless "finish_all" is set, and sends the outputs of the
+  // earlier timestamps whose reads must be completed: all of them if
+  // "finish_all" is set, and those beyond kNumReadbackSlots - 1 otherwise.
+  ::mediapipe::Status ReadBackOutputs(CalculatorContext* cc, bool finish_all);
+#elif defined(__APPLE__) && !TARGET_OS_OSX  // iOS
+  // The size of the elements of the Metal buffers bound to delegate_.
+  int GpuElementSize() const {
+    return use_fp16_tensors_ ? sizeof(uint16_t) : sizeof(float);
+  }
+#endif
+
+  using InterpreterHandle =
+      std::unique_ptr<tflite::Interpreter,
+                      std::function<void(tflite::Interpreter*)>>;
+
+  // Takes an interpreter from free_interpreters_, waiting for one if needed,
+  // and gives it back when the returned handle is destroyed.
+  InterpreterHandle AcquireInterpreter();
+  bool HasFreeInterpreter() const EXCLUSIVE_LOCKS_REQUIRED(interpreter_mutex_) {
+    return !free_interpreters_.empty();
+  }
+  bool AllInterpretersFree() const
+      EXCLUSIVE_LOCKS_REQUIRED(interpreter_mutex_) {
+    return free_interpreters_.size() == 1 + extra_interpreters_.size();
+  }
 
   std::unique_ptr<tflite::Interpreter> interpreter_;
-  std::unique_ptr<tflite::FlatBufferModel> model_;
+  // The additional CPU interpreters requested by num_interpreters.  They are
+  // built from model_, which owns the weights shared by all interpreters.
+  // model_ itself is shared through TfLiteModelCache with the other nodes and
+  // graphs running the same model file.
+  std::vector<std::unique_ptr<tflite::Interpreter>> extra_interpreters_;
+  absl::Mutex interpreter_mutex_;
+  std::vector<tflite::Interpreter*> free_interpreters_
+      GUARDED_BY(interpreter_mutex_);
+  std::shared_ptr<tflite::FlatBufferModel> model_;
   TfLiteDelegate* delegate_ = nullptr;
 
 #if defined(__ANDROID__)
   mediapipe::GlCalculatorHelper gpu_helper_;
   std::unique_ptr<GPUData> gpu_data_in_;
   std::vector<std::unique_ptr<GPUData>> gpu_data_out_;
+  // Whether delegate_ was created with CreateCachedGlDelegate, as requested
+  // by gpu_program_cache_dir, rather than TfLiteGpuDelegateCreate.
+  bool use_cached_gl_delegate_ = false;
+  // Reads the SSBOs of gpu_data_out_ back with gpu_async_readback, and the
+  // slots and timestamps of the reads in flight, oldest first.
+  std::unique_ptr<GlBufferReadback> gpu_readback_;
+  std::deque<std::pair<int, Timestamp>> pending_readbacks_;
+  // Set with use_fp16_tensors, for GPU inputs or outputs.
+  std::unique_ptr<Fp16Programs> fp16_programs_;
 #elif defined(__APPLE__) && !TARGET_OS_OSX  // iOS
   MPPMetalHelper* gpu_helper_ = nullptr;
   std::unique_ptr<GPUData> gpu_data_in_;
@@ -145,10 +402,58 @@ class TfLiteInferenceCalculator : public CalculatorBase {
 #endif
 
   std::string model_path_ = "";
+  // The path of the model running, which differs from model_path_ after a
+  // model update.
+  std::string current_model_path_;
+  ::mediapipe::TfLiteInferenceCalculatorOptions options_;
+  // The CUSTOM_OP_RESOLVER side packet, if any.
+  const tflite::ops::builtin::BuiltinOpResolver* custom_op_resolver_ = nullptr;
+  // The WARMUP_TENSORS side packet, if any.
+  const std::vector<TfLiteTensor>* warmup_tensors_ = nullptr;
+  int num_interpreters_ = 1;
+  // The number of threads per CPU interpreter, or -1 for the TF Lite default.
+  int cpu_num_threads_ = -1;
+
+  int batch_size_ = 1;
+  absl::Duration batch_timeout_ = absl::ZeroDuration();
+  // The input packets and timestamps of the pending batch.
+  std::vector<Packet> batch_inputs_;
+  std::vector<Timestamp> batch_timestamps_;
+  absl::Time batch_start_time_;
+  // The dimensions of one timestamp's slice of each batched output.
+  std::vector<std::unique_ptr<TfLiteIntArray, TfLiteIntArrayDeleter>>
+      batch_output_dims_;
+
+  // The shared service running the model, if use_inference_service is set,
+  // and the outputs of the last request.
+  TfLiteInferenceService* inference_service_ = nullptr;
+  TfLiteInferenceResult inference_result_;
   bool gpu_inference_ = false;
   bool gpu_input_ = false;
   bool gpu_output_ = false;
+  // Whether the CPU outputs of GPU inference are read back asynchronously.
+  bool gpu_async_readback_ = false;
   bool use_quantized_tensors_ = false;
+  // Whether GPU input and output tensors hold halves.
+  bool use_fp16_tensors_ = false;
+
+  // The model update service, if allow_model_updates is set.
+  TfLiteModelUpdateService* model_updates_ = nullptr;
+  // The generation of model_updates_ last acted on.
+  std::atomic<int64> model_update_generation_{0};
+  absl::Mutex model_update_mutex_;
+  // Whether model_loader_ is loading a model.
+  bool loading_model_ GUARDED_BY(model_update_mutex_) = false;
+  // Set by model_loader_ once it has filled loaded_model_, which is null if
+  // the model failed to load.
+  std::atomic<bool> model_loaded_{false};
+  std::unique_ptr<ModelInterpreters> loaded_model_;
+  // The interpreters of the model before the latest switch, whose outputs
+  // may still be in use downstream.
+  std::unique_ptr<ModelInterpreters> retired_model_;
+  // Loads updated models in the background. Declared last, so that it is
+  // destroyed, and its load finished, before the members it fills.
+  std::unique_ptr<ThreadPool> model_loader_;
 };
 REGISTER_CALCULATOR(TfLiteInferenceCalculator);
 
@@ -180,6 +485,54 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
         .Tag("CUSTOM_OP_RESOLVER")
         .Set<tflite::ops::builtin::BuiltinOpResolver>();
   }
+  if (cc->InputSidePackets().HasTag("WARMUP_TENSORS")) {
+    cc->InputSidePackets()
+        .Tag("WARMUP_TENSORS")
+        .Set<std::vector<TfLiteTensor>>();
+  }
+
+  const auto& options =
+      cc->Options<::mediapipe::TfLiteInferenceCalculatorOptions>();
+  RET_CHECK_GE(options.num_interpreters(), 0);
+  RET_CHECK_GE(options.warmup_invocations(), 0);
+  if (options.num_interpreters() != 1) {
+    RET_CHECK(!options.use_gpu() && cc->Inputs().HasTag("TENSORS") &&
+              cc->Outputs().HasTag("TENSORS"))
+        << "Multiple interpreters are only supported for CPU inference.";
+    // Each invocation uses its own interpreter.
+    cc->SetStateless(true);
+  }
+  if (options.use_inference_service()) {
+    RET_CHECK(!options.use_gpu() && options.num_interpreters() == 1 &&
+              options.batch_size() == 1 && cc->Inputs().HasTag("TENSORS") &&
+              cc->Outputs().HasTag("TENSORS") &&
+              !cc->InputSidePackets().HasTag("CUSTOM_OP_RESOLVER"))
+        << "The inference service only runs CPU inference with the builtin "
+           "op resolver.";
+    cc->UseService(kTfLiteInferenceService);
+  }
+  RET_CHECK_GE(options.batch_size(), 1);
+  RET_CHECK_GE(options.batch_timeout_usec(), 0);
+  if (options.batch_size() > 1) {
+    RET_CHECK(!options.use_gpu() && options.num_interpreters() == 1 &&
+              cc->Inputs().HasTag("TENSORS") &&
+              cc->Outputs().HasTag("TENSORS"))
+        << "Batching is only supported for CPU inference with a single "
+           "interpreter.";
+  }
+  RET_CHECK_GE(options.cpu_num_threads(), -1);
+  RET_CHECK(options.cpu_delegate() ==
+                ::mediapipe::TfLiteInferenceCalculatorOptions::NONE ||
+            (!options.use_gpu() && cc->Inputs().HasTag("TENSORS")))
+      << "CPU delegates are only supported for CPU inference.";
+  if (options.allow_model_updates()) {
+    RET_CHECK(!options.use_gpu() && !options.use_inference_service() &&
+              options.batch_size() == 1 && cc->Inputs().HasTag("TENSORS") &&
+              cc->Outputs().HasTag("TENSORS"))
+        << "Model updates are only supported for CPU inference without "
+           "batching.";
+    cc->UseService(kTfLiteModelUpdateService);
+  }
 
 #if defined(__ANDROID__)
   MP_RETURN_IF_ERROR(mediapipe::GlCalculatorHelper::UpdateContract(cc));
@@ -194,9 +547,12 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
 }
 
 ::mediapipe::Status TfLiteInferenceCalculator::Open(CalculatorContext* cc) {
-  cc->SetOffset(TimestampDiff(0));
-
   MP_RETURN_IF_ERROR(LoadOptions(cc));
+  // Batched and asynchronously read back outputs are sent after later
+  // timestamps have arrived.
+  if (batch_size_ == 1 && !gpu_async_readback_) {
+    cc->SetOffset(TimestampDiff(0));
+  }
 
   if (cc->Inputs().HasTag("TENSORS_GPU")) {
 #if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
@@ -217,8 +573,31 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
 #endif
   }
 
+  if (cc->Options<::mediapipe::TfLiteInferenceCalculatorOptions>()
+          .use_inference_service()) {
+    inference_service_ = &cc->Service(kTfLiteInferenceService).GetObject();
+    return ::mediapipe::OkStatus();
+  }
+
+  if (options_.allow_model_updates()) {
+    model_updates_ = &cc->Service(kTfLiteModelUpdateService).GetObject();
+    // An update made before the graph started is loaded right away.
+    model_update_generation_ = model_updates_->generation();
+    current_model_path_ = model_updates_->GetModelPath(model_path_);
+    model_loader_ = absl::make_unique<ThreadPool>("tflite_model_loader", 1);
+    model_loader_->StartWorkers();
+  }
+
   MP_RETURN_IF_ERROR(LoadModel(cc));
 
+  // Only the CPU outputs of GPU inference on Android are read back
+  // asynchronously.
+#if defined(__ANDROID__)
+  gpu_async_readback_ = gpu_async_readback_ && gpu_inference_ && !gpu_output_;
+#else
+  gpu_async_readback_ = false;
+#endif
+
   if (gpu_inference_) {
 #if defined(__ANDROID__)
     MP_RETURN_IF_ERROR(gpu_helper_.Open(cc));
@@ -228,12 +607,71 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
 #endif
 
     MP_RETURN_IF_ERROR(LoadDelegate(cc));
+  } else {
+    // Report the CPU configuration with the node's counters.
+    const auto& options =
+        cc->Options<::mediapipe::TfLiteInferenceCalculatorOptions>();
+    if (cpu_num_threads_ > 0) {
+      cc->GetCounter("CPU Threads")->IncrementBy(cpu_num_threads_);
+    }
+#if defined(__ANDROID__)
+    if (options.cpu_delegate() ==
+        ::mediapipe::TfLiteInferenceCalculatorOptions::NNAPI) {
+      cc->GetCounter("NNAPI Delegate")->Increment();
+    }
+#endif
+    if (options.allow_fp16_precision_loss()) {
+      cc->GetCounter("FP16 Precision Loss Allowed")->Increment();
+    }
+  }
+
+  const int warmup_invocations =
+      cc->Options<::mediapipe::TfLiteInferenceCalculatorOptions>()
+          .warmup_invocations();
+  if (warmup_invocations > 0) {
+    MP_RETURN_IF_ERROR(WarmUp(cc, warmup_invocations));
   }
 
   return ::mediapipe::OkStatus();
 }
 
 ::mediapipe::Status TfLiteInferenceCalculator::Process(CalculatorContext* cc) {
+  if (inference_service_) {
+    const auto& input_tensors =
+        cc->Inputs().Tag("TENSORS").Get<std::vector<TfLiteTensor>>();
+    MP_RETURN_IF_ERROR(inference_service_->Run(model_path_, input_tensors,
+                                               &inference_result_));
+    cc->Outputs().Tag("TENSORS").AddPacket(
+        MakePacket<std::vector<TfLiteTensor>>(inference_result_.tensors())
+            .At(cc->InputTimestamp()));
+    return ::mediapipe::OkStatus();
+  }
+
+  if (batch_size_ > 1) {
+    const absl::Time now = absl::Now();
+    if (batch_timestamps_.empty()) {
+      batch_start_time_ = now;
+    }
+    batch_inputs_.push_back(cc->Inputs().Tag("TENSORS").Value());
+    batch_timestamps_.push_back(cc->InputTimestamp());
+    if (batch_timestamps_.size() == batch_size_ ||
+        (batch_timeout_ > absl::ZeroDuration() &&
+         now - batch_start_time_ >= batch_timeout_)) {
+      MP_RETURN_IF_ERROR(RunBatch(cc));
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  if (model_updates_) {
+    MP_RETURN_IF_ERROR(CheckModelUpdate(cc));
+  }
+
+  auto interpreter = AcquireInterpreter();
+
+  // The interpreter inputs reading packet data in place, and their own
+  // buffers.
+  std::vector<std::pair<TfLiteTensor*, char*>> bound_inputs;
+
   // 1. Receive pre-processed tensor inputs.
   if (gpu_input_) {
     // Read GPU input into SSBO.
@@ -243,6 +681,12 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
     RET_CHECK_EQ(input_tensors.size(), 1);
     MP_RETURN_IF_ERROR(gpu_helper_.RunInGlContext(
         [this, &input_tensors]() -> ::mediapipe::Status {
+          if (use_fp16_tensors_) {
+            // Unpack the halves into the float buffer bound to the delegate.
+            return RunFp16Program(fp16_programs_->unpack_program,
+                                  gpu_data_in_->elements, input_tensors[0],
+                                  gpu_data_in_->buffer);
+          }
           // Explicit copy input.
           tflite::gpu::gl::CopyBuffer(input_tensors[0], gpu_data_in_->buffer);
           return ::mediapipe::OkStatus();
@@ -260,7 +704,7 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
                     sourceOffset:0
                         toBuffer:gpu_data_in_->buffer
                destinationOffset:0
-                            size:gpu_data_in_->elements * sizeof(float)];
+                            size:gpu_data_in_->elements * GpuElementSize()];
     [blit_command endEncoding];
     [command_buffer commit];
     [command_buffer waitUntilCompleted];
@@ -268,20 +712,39 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
     RET_CHECK_FAIL() << "GPU processing is for Android and iOS only.";
 #endif
   } else {
-    // Read CPU input into tensors.
+    // Read CPU input into tensors.  For CPU inference, an input buffer of the
+    // right type, size and alignment, such as the output of
+    // TfLiteConverterCalculator, is bound to the interpreter input directly
+    // until Invoke() returns, which saves copying it.
     const auto& input_tensors =
         cc->Inputs().Tag("TENSORS").Get<std::vector<TfLiteTensor>>();
     RET_CHECK_GT(input_tensors.size(), 0);
+    if (!gpu_inference_) {
+      MP_RETURN_IF_ERROR(ResizeInputsToMatch(input_tensors, interpreter.get()));
+    }
     for (int i = 0; i < input_tensors.size(); ++i) {
       const TfLiteTensor* input_tensor = &input_tensors[i];
       RET_CHECK(input_tensor->data.raw);
-      if (use_quantized_tensors_) {
+      TfLiteTensor* local_tensor =
+          interpreter->tensor(interpreter->inputs()[i]);
+      if (!gpu_inference_ && CanBindInputTensor(*input_tensor, *local_tensor)) {
+        bound_inputs.emplace_back(local_tensor, local_tensor->data.raw);
+        local_tensor->data.raw = input_tensor->data.raw;
+      } else if (input_tensor->type == kTfLiteFloat16 &&
+                 local_tensor->type == kTfLiteFloat32) {
+        // Halves, as from TfLiteConverterCalculator with use_fp16_tensors,
+        // are widened for a float model input.
+        RET_CHECK_EQ(input_tensor->bytes * 2, local_tensor->bytes);
+        HalvesToFloats(reinterpret_cast<const uint16*>(input_tensor->data.raw),
+                       local_tensor->bytes / sizeof(float),
+                       local_tensor->data.f);
+      } else if (use_quantized_tensors_) {
         const uint8* input_tensor_buffer = input_tensor->data.uint8;
-        uint8* local_tensor_buffer = interpreter_->typed_input_tensor<uint8>(i);
+        uint8* local_tensor_buffer = interpreter->typed_input_tensor<uint8>(i);
         memcpy(local_tensor_buffer, input_tensor_buffer, input_tensor->bytes);
       } else {
         const float* input_tensor_buffer = input_tensor->data.f;
-        float* local_tensor_buffer = interpreter_->typed_input_tensor<float>(i);
+        float* local_tensor_buffer = interpreter->typed_input_tensor<float>(i);
         memcpy(local_tensor_buffer, input_tensor_buffer, input_tensor->bytes);
       }
     }
@@ -299,25 +762,49 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
     RET_CHECK_EQ(interpreter_->Invoke(), kTfLiteOk);
 #endif
   } else {
-    RET_CHECK_EQ(interpreter_->Invoke(), kTfLiteOk);
+    TfLiteStatus status = interpreter->Invoke();
+    for (const auto& bound_input : bound_inputs) {
+      bound_input.first->data.raw = bound_input.second;
+    }
+    RET_CHECK_EQ(status, kTfLiteOk);
   }
 
   // 3. Output processed tensors.
-  if (gpu_output_) {
+  if (gpu_async_readback_) {
+#if defined(__ANDROID__)
+    MP_RETURN_IF_ERROR(ReadBackOutputs(cc, /*finish_all=*/false));
+#endif
+  } else if (gpu_output_) {
 #if defined(__ANDROID__)
     // Output result tensors (GPU).
     auto output_tensors = absl::make_unique<std::vector<GpuTensor>>();
     output_tensors->resize(gpu_data_out_.size());
-    for (int i = 0; i < gpu_data_out_.size(); ++i) {
-      GlBuffer& tensor = output_tensors->at(i);
-      using ::tflite::gpu::gl::CreateReadWriteShaderStorageBuffer;
-      auto status = CreateReadWriteShaderStorageBuffer<float>(
-          gpu_data_out_[i]->elements, &tensor);
-      if (!status.ok()) {
-        return ::mediapipe::InternalError(status.error_message());
-      }
-      tflite::gpu::gl::CopyBuffer(gpu_data_out_[i]->buffer, tensor);
-    }
+    MP_RETURN_IF_ERROR(gpu_helper_.RunInGlContext(
+        [this, &output_tensors]() -> ::mediapipe::Status {
+          for (int i = 0; i < gpu_data_out_.size(); ++i) {
+            GlBuffer& tensor = output_tensors->at(i);
+            const int elements = gpu_data_out_[i]->elements;
+            using ::tflite::gpu::gl::CreateReadWriteShaderStorageBuffer;
+            auto status =
+                use_fp16_tensors_
+                    ? CreateReadWriteShaderStorageBuffer<uint32_t>(
+                          (elements + 1) / 2, &tensor)
+                    : CreateReadWriteShaderStorageBuffer<float>(elements,
+                                                                &tensor);
+            if (!status.ok()) {
+              return ::mediapipe::InternalError(status.error_message());
+            }
+            if (use_fp16_tensors_) {
+              MP_RETURN_IF_ERROR(RunFp16Program(fp16_programs_->pack_program,
+                                                elements,
+                                                gpu_data_out_[i]->buffer,
+                                                tensor));
+            } else {
+              tflite::gpu::gl::CopyBuffer(gpu_data_out_[i]->buffer, tensor);
+            }
+          }
+          return ::mediapipe::OkStatus();
+        }));
     cc->Outputs()
         .Tag("TENSORS_GPU")
         .Add(output_tensors.release(), cc->InputTimestamp());
@@ -328,9 +815,9 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
     id<MTLCommandBuffer> command_buffer = [gpu_helper_ commandBuffer];
     command_buffer.label = @"TfLiteInferenceCalculatorOutput";
     for (int i = 0; i < gpu_data_out_.size(); ++i) {
-      id<MTLBuffer> tensor =
-          [device newBufferWithLength:gpu_data_out_[i]->elements * sizeof(float)
-                              options:MTLResourceStorageModeShared];
+      id<MTLBuffer> tensor = [device
+          newBufferWithLength:gpu_data_out_[i]->elements * GpuElementSize()
+                      options:MTLResourceStorageModeShared];
       id<MTLBlitCommandEncoder> blit_command =
           [command_buffer blitCommandEncoder];
       // Explicit copy input.
@@ -338,7 +825,8 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
                       sourceOffset:0
                           toBuffer:tensor
                  destinationOffset:0
-                              size:gpu_data_out_[i]->elements * sizeof(float)];
+                              size:gpu_data_out_[i]->elements *
+                                    GpuElementSize()];
       [blit_command endEncoding];
       [command_buffer commit];
       [command_buffer waitUntilCompleted];
@@ -352,10 +840,10 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
 #endif
   } else {
     // Output result tensors (CPU).
-    const auto& tensor_indexes = interpreter_->outputs();
+    const auto& tensor_indexes = interpreter->outputs();
     auto output_tensors = absl::make_unique<std::vector<TfLiteTensor>>();
     for (int i = 0; i < tensor_indexes.size(); ++i) {
-      TfLiteTensor* tensor = interpreter_->tensor(tensor_indexes[i]);
+      TfLiteTensor* tensor = interpreter->tensor(tensor_indexes[i]);
       output_tensors->emplace_back(*tensor);
     }
     cc->Outputs().Tag("TENSORS").Add(output_tensors.release(),
@@ -366,10 +854,26 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
 }
 
 ::mediapipe::Status TfLiteInferenceCalculator::Close(CalculatorContext* cc) {
+  // Waits for a model being loaded.
+  model_loader_.reset();
+  if (!batch_timestamps_.empty()) {
+    MP_RETURN_IF_ERROR(RunBatch(cc));
+  }
+#if defined(__ANDROID__)
+  if (!pending_readbacks_.empty()) {
+    MP_RETURN_IF_ERROR(ReadBackOutputs(cc, /*finish_all=*/true));
+  }
+#endif
   if (delegate_) {
 #if defined(__ANDROID__)
     MP_RETURN_IF_ERROR(gpu_helper_.RunInGlContext([this]() -> Status {
-      TfLiteGpuDelegateDelete(delegate_);
+      gpu_readback_.reset();
+      if (use_cached_gl_delegate_) {
+        DeleteCachedGlDelegate(delegate_);
+      } else {
+        TfLiteGpuDelegateDelete(delegate_);
+      }
+      fp16_programs_.reset();
       gpu_data_in_.reset();
       for (int i = 0; i < gpu_data_out_.size(); ++i) {
         gpu_data_out_[i].reset();
@@ -390,6 +894,19 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
 
 // Calculator Auxiliary Section
 
+TfLiteInferenceCalculator::InterpreterHandle
+TfLiteInferenceCalculator::AcquireInterpreter() {
+  absl::MutexLock lock(&interpreter_mutex_);
+  interpreter_mutex_.Await(absl::Condition(
+      this, &TfLiteInferenceCalculator::HasFreeInterpreter));
+  tflite::Interpreter* interpreter = free_interpreters_.back();
+  free_interpreters_.pop_back();
+  return {interpreter, [this](tflite::Interpreter* interpreter) {
+            absl::MutexLock lock(&interpreter_mutex_);
+            free_interpreters_.push_back(interpreter);
+          }};
+}
+
 ::mediapipe::Status TfLiteInferenceCalculator::LoadOptions(
     CalculatorContext* cc) {
   // Get calculator options specified in the graph.
@@ -397,52 +914,425 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
       cc->Options<::mediapipe::TfLiteInferenceCalculatorOptions>();
 
   // Get model name.
+  // The model is mapped by TfLiteModelCache through GetResourceMapping, which
+  // resolves the path itself without copying assets to the file system.
   if (!options.model_path().empty()) {
-    auto model_path = options.model_path();
-
-    ASSIGN_OR_RETURN(model_path_, mediapipe::PathToResourceAsFile(model_path));
+    model_path_ = options.model_path();
+    current_model_path_ = model_path_;
   } else {
     LOG(ERROR) << "Must specify path to TFLite model.";
     return ::mediapipe::Status(::mediapipe::StatusCode::kNotFound,
                                "Must specify path to TFLite model.");
   }
 
+  options_ = options;
+  if (cc->InputSidePackets().HasTag("CUSTOM_OP_RESOLVER")) {
+    custom_op_resolver_ = &cc->InputSidePackets()
+                               .Tag("CUSTOM_OP_RESOLVER")
+                               .Get<tflite::ops::builtin::BuiltinOpResolver>();
+  }
+  if (cc->InputSidePackets().HasTag("WARMUP_TENSORS")) {
+    warmup_tensors_ = &cc->InputSidePackets()
+                           .Tag("WARMUP_TENSORS")
+                           .Get<std::vector<TfLiteTensor>>();
+  }
+
   // Get execution modes.
   gpu_inference_ = options.use_gpu();
+  gpu_async_readback_ = options.gpu_async_readback();
+  use_fp16_tensors_ = options.use_fp16_tensors();
+  batch_size_ = options.batch_size();
+  batch_timeout_ = absl::Microseconds(options.batch_timeout_usec());
 
   return ::mediapipe::OkStatus();
 }
 
 ::mediapipe::Status TfLiteInferenceCalculator::LoadModel(
     CalculatorContext* cc) {
-  model_ = tflite::FlatBufferModel::BuildFromFile(model_path_.c_str());
-  RET_CHECK(model_);
+  ASSIGN_OR_RETURN(model_, TfLiteModelCache::GetInstance()->GetModel(
+                               current_model_path_));
 
-  if (cc->InputSidePackets().HasTag("CUSTOM_OP_RESOLVER")) {
-    const auto& op_resolver =
-        cc->InputSidePackets()
-            .Tag("CUSTOM_OP_RESOLVER")
-            .Get<tflite::ops::builtin::BuiltinOpResolver>();
-    tflite::InterpreterBuilder(*model_, op_resolver)(&interpreter_);
-  } else {
-    const tflite::ops::builtin::BuiltinOpResolver op_resolver;
-    tflite::InterpreterBuilder(*model_, op_resolver)(&interpreter_);
-  }
+  const tflite::ops::builtin::BuiltinOpResolver default_op_resolver;
+  const tflite::ops::builtin::BuiltinOpResolver& op_resolver =
+      custom_op_resolver_ ? *custom_op_resolver_ : default_op_resolver;
+  tflite::InterpreterBuilder(*model_, op_resolver)(&interpreter_);
 
   RET_CHECK(interpreter_);
 
   if (gpu_output_) {
     use_quantized_tensors_ = false;
   } else {
-    RET_CHECK_EQ(interpreter_->AllocateTensors(), kTfLiteOk);
+    if (batch_size_ > 1) {
+      MP_RETURN_IF_ERROR(ResizeForBatching());
+    } else {
+      RET_CHECK_EQ(interpreter_->AllocateTensors(), kTfLiteOk);
+    }
     use_quantized_tensors_ =
         (interpreter_->tensor(interpreter_->inputs()[0])->quantization.type ==
          kTfLiteAffineQuantization);
     if (use_quantized_tensors_) gpu_inference_ = false;
   }
 
+  const auto& options =
+      cc->Options<::mediapipe::TfLiteInferenceCalculatorOptions>();
+  num_interpreters_ = options.num_interpreters() > 0
+                          ? options.num_interpreters()
+                          : NumCPUCores();
+  cpu_num_threads_ = options.cpu_num_threads() == 0
+                         ? std::max(1, NumCPUCores() / num_interpreters_)
+                         : options.cpu_num_threads();
+  if (!gpu_inference_) {
+    MP_RETURN_IF_ERROR(ConfigureCpuInterpreter(options, interpreter_.get()));
+  }
+  for (int i = 1; i < num_interpreters_; ++i) {
+    std::unique_ptr<tflite::Interpreter> interpreter;
+    tflite::InterpreterBuilder(*model_, op_resolver)(&interpreter);
+    RET_CHECK(interpreter);
+    MP_RETURN_IF_ERROR(ConfigureCpuInterpreter(options, interpreter.get()));
+    RET_CHECK_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+    extra_interpreters_.push_back(std::move(interpreter));
+  }
+  absl::MutexLock lock(&interpreter_mutex_);
+  free_interpreters_.push_back(interpreter_.get());
+  for (const auto& interpreter : extra_interpreters_) {
+    free_interpreters_.push_back(interpreter.get());
+  }
+
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status TfLiteInferenceCalculator::WarmUp(CalculatorContext* cc,
+                                                      int num_invocations) {
+  const absl::Time start_time = absl::Now();
+  std::vector<tflite::Interpreter*> interpreters = {interpreter_.get()};
+  for (const auto& interpreter : extra_interpreters_) {
+    interpreters.push_back(interpreter.get());
+  }
+  for (tflite::Interpreter* interpreter : interpreters) {
+    // GPU inputs are read from gpu_data_in_, whose contents do not matter
+    // for warming up.
+    if (!gpu_input_) {
+      MP_RETURN_IF_ERROR(FillWarmupInputs(warmup_tensors_, interpreter));
+    }
+    if (gpu_inference_) {
+#if defined(__ANDROID__)
+      MP_RETURN_IF_ERROR(gpu_helper_.RunInGlContext(
+          [interpreter, num_invocations]() -> ::mediapipe::Status {
+            for (int i = 0; i < num_invocations; ++i) {
+              RET_CHECK_EQ(interpreter->Invoke(), kTfLiteOk);
+            }
+            return ::mediapipe::OkStatus();
+          }));
+#elif defined(__APPLE__) && !TARGET_OS_OSX  // iOS
+      for (int i = 0; i < num_invocations; ++i) {
+        RET_CHECK_EQ(interpreter->Invoke(), kTfLiteOk);
+      }
+#endif
+    } else {
+      for (int i = 0; i < num_invocations; ++i) {
+        RET_CHECK_EQ(interpreter->Invoke(), kTfLiteOk);
+      }
+    }
+  }
+  ProfilingContext* profiling_context = cc->GetProfilingContext();
+  if (profiling_context) {
+    profiling_context->AddWarmupRuntime(*cc, absl::Now() - start_time);
+  }
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status TfLiteInferenceCalculator::FillWarmupInputs(
+    const std::vector<TfLiteTensor>* warmup_tensors,
+    tflite::Interpreter* interpreter) {
+  if (warmup_tensors) {
+    RET_CHECK_EQ(warmup_tensors->size(), interpreter->inputs().size());
+    if (!gpu_inference_ && batch_size_ == 1) {
+      MP_RETURN_IF_ERROR(ResizeInputsToMatch(*warmup_tensors, interpreter));
+    }
+  }
+  for (int i = 0; i < interpreter->inputs().size(); ++i) {
+    TfLiteTensor* local_tensor = interpreter->tensor(interpreter->inputs()[i]);
+    if (warmup_tensors) {
+      const TfLiteTensor& warmup_tensor = (*warmup_tensors)[i];
+      RET_CHECK(warmup_tensor.data.raw);
+      RET_CHECK_EQ(warmup_tensor.bytes, local_tensor->bytes)
+          << "Warm-up tensor " << i << " does not match the model input.";
+      memcpy(local_tensor->data.raw, warmup_tensor.data.raw,
+             local_tensor->bytes);
+    } else {
+      memset(local_tensor->data.raw, 0, local_tensor->bytes);
+    }
+  }
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status TfLiteInferenceCalculator::CheckModelUpdate(
+    CalculatorContext* cc) {
+  // Without an update in progress, this is all each timestamp pays.
+  if (model_updates_->generation() == model_update_generation_ &&
+      !model_loaded_.load(std::memory_order_acquire)) {
+    return ::mediapipe::OkStatus();
+  }
+  absl::MutexLock lock(&model_update_mutex_);
+  if (model_loaded_.load(std::memory_order_acquire)) {
+    SwitchModel(cc);
+  }
+  // An update made while a model is loading is handled once it has loaded.
+  const int64 generation = model_updates_->generation();
+  if (loading_model_ || generation == model_update_generation_) {
+    return ::mediapipe::OkStatus();
+  }
+  model_update_generation_ = generation;
+  const std::string model_path = model_updates_->GetModelPath(model_path_);
+  if (model_path == current_model_path_) {
+    return ::mediapipe::OkStatus();
+  }
+  loading_model_ = true;
+  model_loader_->Schedule([this, model_path]() {
+    auto result = absl::make_unique<ModelInterpreters>();
+    result->model_path = model_path;
+    ::mediapipe::Status status = LoadModelInterpreters(result.get());
+    if (!status.ok()) {
+      LOG(ERROR) << "Failed to update the TF Lite model to " << model_path
+                 << ": " << status;
+      result.reset();
+    }
+    loaded_model_ = std::move(result);
+    model_loaded_.store(true, std::memory_order_release);
+  });
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status TfLiteInferenceCalculator::LoadModelInterpreters(
+    ModelInterpreters* loaded) {
+  ASSIGN_OR_RETURN(loaded->model, TfLiteModelCache::GetInstance()->GetModel(
+                                      loaded->model_path));
+  const tflite::ops::builtin::BuiltinOpResolver default_op_resolver;
+  const tflite::ops::builtin::BuiltinOpResolver& op_resolver =
+      custom_op_resolver_ ? *custom_op_resolver_ : default_op_resolver;
+  for (int i = 0; i < num_interpreters_; ++i) {
+    std::unique_ptr<tflite::Interpreter> interpreter;
+    tflite::InterpreterBuilder(*loaded->model, op_resolver)(&interpreter);
+    RET_CHECK(interpreter);
+    MP_RETURN_IF_ERROR(ConfigureCpuInterpreter(options_, interpreter.get()));
+    RET_CHECK_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+    RET_CHECK_EQ(interpreter->inputs().size(), interpreter_->inputs().size())
+        << "The updated model must take as many inputs as the running one.";
+    if (options_.warmup_invocations() > 0) {
+      MP_RETURN_IF_ERROR(FillWarmupInputs(warmup_tensors_, interpreter.get()));
+      for (int j = 0; j < options_.warmup_invocations(); ++j) {
+        RET_CHECK_EQ(interpreter->Invoke(), kTfLiteOk);
+      }
+    }
+    if (i == 0) {
+      loaded->interpreter = std::move(interpreter);
+    } else {
+      loaded->extra_interpreters.push_back(std::move(interpreter));
+    }
+  }
+  return ::mediapipe::OkStatus();
+}
+
+void TfLiteInferenceCalculator::SwitchModel(CalculatorContext* cc) {
+  std::unique_ptr<ModelInterpreters> loaded = std::move(loaded_model_);
+  model_loaded_.store(false, std::memory_order_release);
+  loading_model_ = false;
+  if (!loaded) {
+    cc->GetCounter("Failed Model Updates")->Increment();
+    return;
+  }
+  {
+    absl::MutexLock lock(&interpreter_mutex_);
+    // Waits for the inferences in flight, so that no timestamp mixes the
+    // two models.
+    interpreter_mutex_.Await(absl::Condition(
+        this, &TfLiteInferenceCalculator::AllInterpretersFree));
+    std::swap(model_, loaded->model);
+    interpreter_.swap(loaded->interpreter);
+    extra_interpreters_.swap(loaded->extra_interpreters);
+    free_interpreters_.clear();
+    free_interpreters_.push_back(interpreter_.get());
+    for (const auto& interpreter : extra_interpreters_) {
+      free_interpreters_.push_back(interpreter.get());
+    }
+    use_quantized_tensors_ =
+        (interpreter_->tensor(interpreter_->inputs()[0])->quantization.type ==
+         kTfLiteAffineQuantization);
+  }
+  std::swap(current_model_path_, loaded->model_path);
+  retired_model_ = std::move(loaded);
+  cc->GetCounter("Model Updates")->Increment();
+}
+
+::mediapipe::Status TfLiteInferenceCalculator::ResizeForBatching() {
+  for (int index : interpreter_->inputs()) {
+    const TfLiteIntArray* dims = interpreter_->tensor(index)->dims;
+    RET_CHECK_GT(dims->size, 0) << "Batching needs non-scalar model inputs.";
+    std::vector<int> batch_dims(dims->data, dims->data + dims->size);
+    batch_dims[0] *= batch_size_;
+    RET_CHECK_EQ(interpreter_->ResizeInputTensor(index, batch_dims),
+                 kTfLiteOk);
+  }
+  RET_CHECK_EQ(interpreter_->AllocateTensors(), kTfLiteOk);
+  for (int index : interpreter_->outputs()) {
+    const TfLiteIntArray* dims = interpreter_->tensor(index)->dims;
+    RET_CHECK(dims->size > 0 && dims->data[0] % batch_size_ == 0)
+        << "Model outputs must be batched along their first dimension.";
+    std::unique_ptr<TfLiteIntArray, TfLiteIntArrayDeleter> slice_dims(
+        TfLiteIntArrayCopy(dims));
+    slice_dims->data[0] /= batch_size_;
+    batch_output_dims_.push_back(std::move(slice_dims));
+  }
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status TfLiteInferenceCalculator::RunBatch(
+    CalculatorContext* cc) {
+  // Copy the inputs of each timestamp into its slice of the batch.  The
+  // slices of a partial batch past its last timestamp keep stale data, and
+  // their outputs are dropped.
+  const auto& input_indexes = interpreter_->inputs();
+  for (int j = 0; j < batch_timestamps_.size(); ++j) {
+    const auto& input_tensors =
+        batch_inputs_[j].Get<std::vector<TfLiteTensor>>();
+    RET_CHECK_EQ(input_tensors.size(), input_indexes.size());
+    for (int i = 0; i < input_tensors.size(); ++i) {
+      TfLiteTensor* local_tensor = interpreter_->tensor(input_indexes[i]);
+      const size_t slice_bytes = local_tensor->bytes / batch_size_;
+      RET_CHECK(input_tensors[i].data.raw);
+      if (input_tensors[i].type == kTfLiteFloat16 &&
+          local_tensor->type == kTfLiteFloat32) {
+        RET_CHECK_EQ(input_tensors[i].bytes * 2, slice_bytes);
+        HalvesToFloats(
+            reinterpret_cast<const uint16*>(input_tensors[i].data.raw),
+            slice_bytes / sizeof(float),
+            reinterpret_cast<float*>(local_tensor->data.raw + j * slice_bytes));
+        continue;
+      }
+      RET_CHECK_EQ(input_tensors[i].bytes, slice_bytes);
+      memcpy(local_tensor->data.raw + j * slice_bytes,
+             input_tensors[i].data.raw, slice_bytes);
+    }
+  }
+
+  RET_CHECK_EQ(interpreter_->Invoke(), kTfLiteOk);
+
+  // Split the outputs back into the slices of each timestamp.
+  const auto& output_indexes = interpreter_->outputs();
+  for (int j = 0; j < batch_timestamps_.size(); ++j) {
+    auto output_tensors = absl::make_unique<std::vector<TfLiteTensor>>();
+    for (int i = 0; i < output_indexes.size(); ++i) {
+      const TfLiteTensor* tensor = interpreter_->tensor(output_indexes[i]);
+      TfLiteTensor slice = *tensor;
+      slice.bytes = tensor->bytes / batch_size_;
+      slice.data.raw = tensor->data.raw + j * slice.bytes;
+      slice.dims = batch_output_dims_[i].get();
+      output_tensors->push_back(slice);
+    }
+    cc->Outputs().Tag("TENSORS").Add(output_tensors.release(),
+                                     batch_timestamps_[j]);
+  }
+  cc->GetCounter("Batches")->Increment();
+
+  batch_inputs_.clear();
+  batch_timestamps_.clear();
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status TfLiteInferenceCalculator::ResizeInputsToMatch(
+    const std::vector<TfLiteTensor>& input_tensors,
+    tflite::Interpreter* interpreter) {
+  bool resized = false;
+  for (int i = 0; i < input_tensors.size(); ++i) {
+    const TfLiteIntArray* dims = input_tensors[i].dims;
+    const int index = interpreter->inputs()[i];
+    const TfLiteIntArray* local_dims = interpreter->tensor(index)->dims;
+    // Only the batch dimension of a tensor of the model's rank may change.
+    if (!dims || dims->size != local_dims->size || dims->size < 2 ||
+        dims->data[0] == local_dims->data[0] ||
+        !std::equal(dims->data + 1, dims->data + dims->size,
+                    local_dims->data + 1)) {
+      continue;
+    }
+    RET_CHECK_EQ(interpreter->ResizeInputTensor(
+                     index, std::vector<int>(dims->data,
+                                             dims->data + dims->size)),
+                 kTfLiteOk);
+    resized = true;
+  }
+  if (resized) {
+    RET_CHECK_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+  }
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status TfLiteInferenceCalculator::ConfigureCpuInterpreter(
+    const ::mediapipe::TfLiteInferenceCalculatorOptions& options,
+    tflite::Interpreter* interpreter) {
+  interpreter->SetNumThreads(cpu_num_threads_);
+  interpreter->SetAllowFp16PrecisionForFp32(
+      options.allow_fp16_precision_loss());
+#if defined(__ANDROID__)
+  if (options.cpu_delegate() ==
+      ::mediapipe::TfLiteInferenceCalculatorOptions::NNAPI) {
+    interpreter->UseNNAPI(true);
+  }
+#endif
+  return ::mediapipe::OkStatus();
+}
+
+#if defined(__ANDROID__)
+TfLiteStatus TfLiteInferenceCalculator::BindBufferToTensor(GLuint buffer,
+                                                           int tensor_index) {
+  return use_cached_gl_delegate_
+             ? CachedGlDelegateBindBufferToTensor(delegate_, buffer,
+                                                  tensor_index)
+             : TfLiteGpuDelegateBindBufferToTensor(delegate_, buffer,
+                                                   tensor_index);
+}
+
+::mediapipe::Status TfLiteInferenceCalculator::ReadBackOutputs(
+    CalculatorContext* cc, bool finish_all) {
+  // The data of each finished read, with its timestamp.
+  std::vector<std::pair<Timestamp, std::vector<const void*>>> finished;
+  MP_RETURN_IF_ERROR(gpu_helper_.RunInGlContext(
+      [this, cc, finish_all, &finished]() -> ::mediapipe::Status {
+        if (!finish_all) {
+          std::vector<GLuint> buffers;
+          for (const auto& data : gpu_data_out_) {
+            buffers.push_back(data->buffer.id());
+          }
+          ASSIGN_OR_RETURN(int slot, gpu_readback_->StartRead(buffers));
+          pending_readbacks_.emplace_back(slot, cc->InputTimestamp());
+        }
+        // Finishing the oldest read only once a newer one is queued gives it
+        // the time of an inference to complete without stalling.
+        const int num_in_flight = finish_all ? 0 : kNumReadbackSlots - 1;
+        while (static_cast<int>(pending_readbacks_.size()) > num_in_flight) {
+          const std::pair<int, Timestamp> pending =
+              pending_readbacks_.front();
+          pending_readbacks_.pop_front();
+          ASSIGN_OR_RETURN(std::vector<const void*> data,
+                           gpu_readback_->FinishRead(pending.first));
+          finished.emplace_back(pending.second, std::move(data));
+        }
+        return ::mediapipe::OkStatus();
+      }));
+
+  const auto& tensor_indexes = interpreter_->outputs();
+  for (const auto& read : finished) {
+    auto output_tensors = absl::make_unique<std::vector<TfLiteTensor>>();
+    for (int i = 0; i < tensor_indexes.size(); ++i) {
+      TfLiteTensor tensor = *interpreter_->tensor(tensor_indexes[i]);
+      tensor.data.raw = static_cast<char*>(const_cast<void*>(read.second[i]));
+      tensor.bytes = gpu_data_out_[i]->elements * sizeof(float);
+      output_tensors->push_back(tensor);
+    }
+    cc->Outputs().Tag("TENSORS").Add(output_tensors.release(), read.first);
+  }
   return ::mediapipe::OkStatus();
 }
+#endif  // __ANDROID__
 
 ::mediapipe::Status TfLiteInferenceCalculator::LoadDelegate(
     CalculatorContext* cc) {
@@ -454,7 +1344,21 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
       TFLITE_GL_OBJECT_TYPE_FASTEST;
   options.compile_options.dynamic_batch_enabled = 0;
   options.compile_options.inline_parameters = 1;
-  if (!delegate_) delegate_ = TfLiteGpuDelegateCreate(&options);
+  const std::string& cache_dir =
+      cc->Options<::mediapipe::TfLiteInferenceCalculatorOptions>()
+          .gpu_program_cache_dir();
+  if (!delegate_) {
+    if (cache_dir.empty()) {
+      delegate_ = TfLiteGpuDelegateCreate(&options);
+    } else {
+      CachedGlDelegateOptions cached_options;
+      cached_options.delegate_options = options;
+      cached_options.cache_dir = cache_dir;
+      cached_options.model_token = GetModelToken(*model_);
+      delegate_ = CreateCachedGlDelegate(cached_options);
+      use_cached_gl_delegate_ = true;
+    }
+  }
 
   if (gpu_input_) {
     // Get input image sizes.
@@ -475,12 +1379,14 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
     if (!status.ok()) {
       return ::mediapipe::InternalError(status.error_message());
     }
-    RET_CHECK_EQ(TfLiteGpuDelegateBindBufferToTensor(
-                     delegate_, gpu_data_in_->buffer.id(),
+    RET_CHECK_EQ(BindBufferToTensor(
+                     gpu_data_in_->buffer.id(),
                      interpreter_->inputs()[0]),  // First tensor only
                  kTfLiteOk);
   }
-  if (gpu_output_) {
+  // With gpu_async_readback, the outputs are written to SSBOs as for GPU
+  // output, instead of being read back synchronously by Invoke().
+  if (gpu_output_ || gpu_async_readback_) {
     // Get output image sizes.
     const auto& output_indices = interpreter_->outputs();
     gpu_data_out_.resize(output_indices.size());
@@ -503,11 +1409,39 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
         return ::mediapipe::InternalError(status.error_message());
       }
       RET_CHECK_EQ(
-          TfLiteGpuDelegateBindBufferToTensor(
-              delegate_, gpu_data_out_[i]->buffer.id(), output_indices[i]),
+          BindBufferToTensor(gpu_data_out_[i]->buffer.id(), output_indices[i]),
           kTfLiteOk);
     }
   }
+  if (use_fp16_tensors_ && (gpu_input_ || gpu_output_)) {
+    MP_RETURN_IF_ERROR(
+        gpu_helper_.RunInGlContext([this]() -> ::mediapipe::Status {
+          fp16_programs_ = absl::make_unique<Fp16Programs>();
+          MP_RETURN_IF_ERROR(CompileComputeProgram(
+              kUnpackHalvesShader, &fp16_programs_->unpack_shader,
+              &fp16_programs_->unpack_program));
+          return CompileComputeProgram(kPackHalvesShader,
+                                       &fp16_programs_->pack_shader,
+                                       &fp16_programs_->pack_program);
+        }));
+  }
+  if (gpu_async_readback_) {
+    std::vector<size_t> buffer_sizes;
+    for (int i = 0; i < gpu_data_out_.size(); ++i) {
+      const TfLiteTensor* tensor =
+          interpreter_->tensor(interpreter_->outputs()[i]);
+      RET_CHECK_EQ(tensor->type, kTfLiteFloat32)
+          << "GPU outputs are read back as floats.";
+      buffer_sizes.push_back(gpu_data_out_[i]->elements * sizeof(float));
+    }
+    MP_RETURN_IF_ERROR(gpu_helper_.RunInGlContext(
+        [this, &buffer_sizes]() -> ::mediapipe::Status {
+          ASSIGN_OR_RETURN(gpu_readback_,
+                           GlBufferReadback::Create(buffer_sizes,
+                                                    kNumReadbackSlots));
+          return ::mediapipe::OkStatus();
+        }));
+  }
 
   // Must call this last.
   RET_CHECK_EQ(interpreter_->ModifyGraphWithDelegate(delegate_), kTfLiteOk);
@@ -516,7 +1450,9 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
 #if defined(__APPLE__) && !TARGET_OS_OSX  // iOS
   // Configure and create the delegate.
   GpuDelegateOptions options;
-  options.allow_precision_loss = false;  // Must match converter, F=float/T=half
+  // Must match converter, F=float/T=half. The delegate then reads and writes
+  // the bound buffers as halves.
+  options.allow_precision_loss = use_fp16_tensors_;
   options.wait_type = GpuDelegateOptions::WaitType::kActive;
   if (!delegate_) delegate_ = TFLGpuDelegateCreate(&options);
 
@@ -541,7 +1477,7 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
     // Create and bind input buffer.
     id<MTLDevice> device = gpu_helper_.mtlDevice;
     gpu_data_in_->buffer =
-        [device newBufferWithLength:gpu_data_in_->elements * sizeof(float)
+        [device newBufferWithLength:gpu_data_in_->elements * GpuElementSize()
                             options:MTLResourceStorageModeShared];
     // Must call this before TFLGpuDelegateBindMetalBufferToTensor.
     RET_CHECK_EQ(interpreter_->ModifyGraphWithDelegate(delegate_), kTfLiteOk);
@@ -568,9 +1504,9 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
     interpreter_->SetAllowBufferHandleOutput(true);
     id<MTLDevice> device = gpu_helper_.mtlDevice;
     for (int i = 0; i < gpu_data_out_.size(); ++i) {
-      gpu_data_out_[i]->buffer =
-          [device newBufferWithLength:gpu_data_out_[i]->elements * sizeof(float)
-                              options:MTLResourceStorageModeShared];
+      gpu_data_out_[i]->buffer = [device
+          newBufferWithLength:gpu_data_out_[i]->elements * GpuElementSize()
+                      options:MTLResourceStorageModeShared];
       RET_CHECK_EQ(TFLGpuDelegateBindMetalBufferToTensor(
                        delegate_, output_indices[i], gpu_data_out_[i]->buffer),
                    true);
@@ -16,6 +16,10 @@
 #include <string>
 #include <vector>
 
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "mediapipe/calculators/tflite/tflite_inference_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_runner.h"
@@ -25,7 +29,10 @@
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/parse_text_proto.h"
 #include "mediapipe/framework/port/status_matchers.h"  // NOLINT
+#include "mediapipe/framework/tool/sink.h"
 #include "mediapipe/framework/tool/validate_type.h"
+#include "mediapipe/util/tflite/tflite_inference_service.h"
+#include "mediapipe/util/tflite/tflite_model_update_service.h"
 #include "tensorflow/lite/error_reporter.h"
 #include "tensorflow/lite/interpreter.h"
 #include "tensorflow/lite/kernels/register.h"
@@ -41,38 +48,116 @@ using ::tflite::Interpreter;
 
 class TfLiteInferenceCalculatorTest : public ::testing::Test {
  protected:
+  static constexpr int kWidth = 8;
+  static constexpr int kHeight = 8;
+  static constexpr int kChannels = 3;
+
+  // Returns a packet holding an input tensor filled with ones.  The tensor
+  // data is owned by input_interpreter_.
+  Packet MakeInputPacket() {
+    input_interpreter_ = absl::make_unique<Interpreter>();
+    input_interpreter_->AddTensors(1);
+    input_interpreter_->SetInputs({0});
+    input_interpreter_->SetOutputs({0});
+    input_interpreter_->SetTensorParametersReadWrite(0, kTfLiteFloat32, "", {3},
+                                                     TfLiteQuantization());
+    int t = input_interpreter_->inputs()[0];
+    TfLiteTensor* tensor = input_interpreter_->tensor(t);
+    input_interpreter_->ResizeInputTensor(t, {kWidth, kHeight, kChannels});
+    input_interpreter_->AllocateTensors();
+
+    float* tensor_buffer = tensor->data.f;
+    EXPECT_NE(tensor_buffer, nullptr);
+    for (int i = 0; i < kWidth * kHeight * kChannels - 1; i++) {
+      tensor_buffer[i] = 1;
+    }
+
+    auto input_vec = absl::make_unique<std::vector<TfLiteTensor>>();
+    input_vec->emplace_back(*tensor);
+    return Adopt(input_vec.release());
+  }
+
+  // Checks that "packet" holds the output of the add model for
+  // MakeInputPacket().
+  void ExpectAddModelOutput(const Packet& packet) {
+    const std::vector<TfLiteTensor>& result_vec =
+        packet.Get<std::vector<TfLiteTensor>>();
+    ASSERT_EQ(1, result_vec.size());
+
+    const TfLiteTensor* result = &result_vec[0];
+    float* result_buffer = result->data.f;
+    ASSERT_NE(result_buffer, nullptr);
+    for (int i = 0; i < kWidth * kHeight * kChannels - 1; i++) {
+      ASSERT_EQ(3, result_buffer[i]);
+    }
+  }
+
+  // Runs the add model with allow_model_updates, updates it to "new_path",
+  // and sends inputs until the node reports the update in "counter_name".
+  void RunModelUpdate(const std::string& new_path,
+                      const std::string& counter_name) {
+    CalculatorGraphConfig graph_config =
+        ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(
+            R"(
+              input_stream: "tensor_in"
+              node {
+                name: "inference"
+                calculator: "TfLiteInferenceCalculator"
+                input_stream: "TENSORS:tensor_in"
+                output_stream: "TENSORS:tensor_out"
+                options {
+                  [mediapipe.TfLiteInferenceCalculatorOptions.ext] {
+                    model_path: "mediapipe/calculators/tflite/testdata/add.bin"
+                    num_interpreters: 2
+                    warmup_invocations: 1
+                    allow_model_updates: true
+                  }
+                }
+              }
+            )");
+    std::vector<Packet> output_packets;
+    tool::AddVectorSink("tensor_out", &graph_config, &output_packets);
+    auto model_updates = std::make_shared<TfLiteModelUpdateService>();
+    CalculatorGraph graph(graph_config);
+    MP_ASSERT_OK(
+        graph.SetServiceObject(kTfLiteModelUpdateService, model_updates));
+    MP_ASSERT_OK(graph.StartRun({}));
+    Counter* counter = graph.GetCounterFactory()->GetCounter(
+        absl::StrCat("inference-", counter_name));
+
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "tensor_in", MakeInputPacket().At(Timestamp(0))));
+    MP_ASSERT_OK(graph.WaitUntilIdle());
+    model_updates->UpdateModel("mediapipe/calculators/tflite/testdata/add.bin",
+                               new_path);
+    // The model loads in the background, while the old one keeps running.
+    int64 t = 1;
+    for (; t < 1000 && counter->Get() == 0; ++t) {
+      MP_ASSERT_OK(graph.AddPacketToInputStream(
+          "tensor_in", MakeInputPacket().At(Timestamp(t))));
+      MP_ASSERT_OK(graph.WaitUntilIdle());
+      absl::SleepFor(absl::Milliseconds(5));
+    }
+    EXPECT_EQ(1, counter->Get());
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "tensor_in", MakeInputPacket().At(Timestamp(t))));
+    MP_ASSERT_OK(graph.WaitUntilIdle());
+    ASSERT_EQ(t + 1, output_packets.size());
+    // The outputs of the interpreters of both models are still valid.
+    for (const Packet& packet : output_packets) {
+      ExpectAddModelOutput(packet);
+    }
+
+    MP_ASSERT_OK(graph.CloseInputStream("tensor_in"));
+    MP_ASSERT_OK(graph.WaitUntilDone());
+  }
+
+  std::unique_ptr<Interpreter> input_interpreter_;
   std::unique_ptr<CalculatorRunner> runner_ = nullptr;
 };
 
 // Tests a simple add model that adds an input tensor to itself.
 TEST_F(TfLiteInferenceCalculatorTest, SmokeTest) {
-  const int width = 8;
-  const int height = 8;
-  const int channels = 3;
-
-  // Prepare input tensor.
-  std::unique_ptr<Interpreter> interpreter(new Interpreter);
-  ASSERT_NE(interpreter, nullptr);
-
-  interpreter->AddTensors(1);
-  interpreter->SetInputs({0});
-  interpreter->SetOutputs({0});
-  interpreter->SetTensorParametersReadWrite(0, kTfLiteFloat32, "", {3},
-                                            TfLiteQuantization());
-  int t = interpreter->inputs()[0];
-  TfLiteTensor* tensor = interpreter->tensor(t);
-  interpreter->ResizeInputTensor(t, {width, height, channels});
-  interpreter->AllocateTensors();
-
-  float* tensor_buffer = tensor->data.f;
-  ASSERT_NE(tensor_buffer, nullptr);
-  for (int i = 0; i < width * height * channels - 1; i++) {
-    tensor_buffer[i] = 1;
-  }
-
-  auto input_vec = absl::make_unique<std::vector<TfLiteTensor>>();
-  input_vec->emplace_back(*tensor);
-
   // Prepare single calculator graph to and wait for packets.
   CalculatorGraphConfig graph_config =
       ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(
@@ -97,22 +182,13 @@ TEST_F(TfLiteInferenceCalculatorTest, SmokeTest) {
 
   // Push the tensor into the graph.
   MP_ASSERT_OK(graph.AddPacketToInputStream(
-      "tensor_in", Adopt(input_vec.release()).At(Timestamp(0))));
+      "tensor_in", MakeInputPacket().At(Timestamp(0))));
   // Wait until the calculator done processing.
   MP_ASSERT_OK(graph.WaitUntilIdle());
   ASSERT_EQ(1, output_packets.size());
 
   // Get and process results.
-  const std::vector<TfLiteTensor>& result_vec =
-      output_packets[0].Get<std::vector<TfLiteTensor>>();
-  ASSERT_EQ(1, result_vec.size());
-
-  const TfLiteTensor* result = &result_vec[0];
-  float* result_buffer = result->data.f;
-  ASSERT_NE(result_buffer, nullptr);
-  for (int i = 0; i < width * height * channels - 1; i++) {
-    ASSERT_EQ(3, result_buffer[i]);
-  }
+  ExpectAddModelOutput(output_packets[0]);
 
   // Fully close graph at end, otherwise calculator+tensors are destroyed
   // after calling WaitUntilDone().
@@ -120,4 +196,271 @@ TEST_F(TfLiteInferenceCalculatorTest, SmokeTest) {
   MP_ASSERT_OK(graph.WaitUntilDone());
 }
 
+// Tests the add model on a pool of interpreters running in parallel.
+TEST_F(TfLiteInferenceCalculatorTest, InterpreterPool) {
+  CalculatorGraphConfig graph_config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(
+          R"(
+            input_stream: "tensor_in"
+            node {
+              calculator: "TfLiteInferenceCalculator"
+              input_stream: "TENSORS:tensor_in"
+              output_stream: "TENSORS:tensor_out"
+              max_in_flight: 2
+              options {
+                [mediapipe.TfLiteInferenceCalculatorOptions.ext] {
+                  model_path: "mediapipe/calculators/tflite/testdata/add.bin"
+                  num_interpreters: 2
+                }
+              }
+            }
+            num_threads: 2
+          )");
+  std::vector<Packet> output_packets;
+  tool::AddVectorSink("tensor_out", &graph_config, &output_packets);
+  CalculatorGraph graph(graph_config);
+  MP_ASSERT_OK(graph.StartRun({}));
+
+  Packet input_packet = MakeInputPacket();
+  for (int i = 0; i < 4; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream("tensor_in",
+                                              input_packet.At(Timestamp(i))));
+    MP_ASSERT_OK(graph.WaitUntilIdle());
+    ASSERT_EQ(i + 1, output_packets.size());
+    EXPECT_EQ(Timestamp(i), output_packets[i].Timestamp());
+    ExpectAddModelOutput(output_packets[i]);
+  }
+
+  MP_ASSERT_OK(graph.CloseInputStream("tensor_in"));
+  MP_ASSERT_OK(graph.WaitUntilDone());
+}
+
+// Tests the add model with explicit CPU threading and precision options.
+TEST_F(TfLiteInferenceCalculatorTest, CpuOptions) {
+  CalculatorGraphConfig graph_config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(
+          R"(
+            input_stream: "tensor_in"
+            node {
+              calculator: "TfLiteInferenceCalculator"
+              input_stream: "TENSORS:tensor_in"
+              output_stream: "TENSORS:tensor_out"
+              options {
+                [mediapipe.TfLiteInferenceCalculatorOptions.ext] {
+                  model_path: "mediapipe/calculators/tflite/testdata/add.bin"
+                  cpu_num_threads: 2
+                  allow_fp16_precision_loss: true
+                }
+              }
+            }
+          )");
+  std::vector<Packet> output_packets;
+  tool::AddVectorSink("tensor_out", &graph_config, &output_packets);
+  CalculatorGraph graph(graph_config);
+  MP_ASSERT_OK(graph.StartRun({}));
+
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "tensor_in", MakeInputPacket().At(Timestamp(0))));
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+  ASSERT_EQ(1, output_packets.size());
+  ExpectAddModelOutput(output_packets[0]);
+
+  // The configuration is reported with the node's counters.
+  EXPECT_EQ(2, graph.GetCounterFactory()
+                   ->GetCounter("TfLiteInferenceCalculator-CPU Threads")
+                   ->Get());
+  EXPECT_EQ(1, graph.GetCounterFactory()
+                   ->GetCounter("TfLiteInferenceCalculator-FP16 Precision "
+                                "Loss Allowed")
+                   ->Get());
+
+  MP_ASSERT_OK(graph.CloseInputStream("tensor_in"));
+  MP_ASSERT_OK(graph.WaitUntilDone());
+}
+
+// Tests the add model running two timestamps per inference.
+TEST_F(TfLiteInferenceCalculatorTest, Batching) {
+  CalculatorGraphConfig graph_config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(
+          R"(
+            input_stream: "tensor_in"
+            node {
+              calculator: "TfLiteInferenceCalculator"
+              input_stream: "TENSORS:tensor_in"
+              output_stream: "TENSORS:tensor_out"
+              options {
+                [mediapipe.TfLiteInferenceCalculatorOptions.ext] {
+                  model_path: "mediapipe/calculators/tflite/testdata/add.bin"
+                  batch_size: 2
+                }
+              }
+            }
+          )");
+  std::vector<Packet> output_packets;
+  tool::AddVectorSink("tensor_out", &graph_config, &output_packets);
+  CalculatorGraph graph(graph_config);
+  MP_ASSERT_OK(graph.StartRun({}));
+
+  Packet input_packet = MakeInputPacket();
+  MP_ASSERT_OK(graph.AddPacketToInputStream("tensor_in",
+                                            input_packet.At(Timestamp(0))));
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+  EXPECT_EQ(0, output_packets.size());
+
+  MP_ASSERT_OK(graph.AddPacketToInputStream("tensor_in",
+                                            input_packet.At(Timestamp(1))));
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+  ASSERT_EQ(2, output_packets.size());
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ(Timestamp(i), output_packets[i].Timestamp());
+    ExpectAddModelOutput(output_packets[i]);
+  }
+  EXPECT_EQ(1, graph.GetCounterFactory()
+                   ->GetCounter("TfLiteInferenceCalculator-Batches")
+                   ->Get());
+
+  // The partial batch is run when the graph closes.
+  MP_ASSERT_OK(graph.AddPacketToInputStream("tensor_in",
+                                            input_packet.At(Timestamp(2))));
+  MP_ASSERT_OK(graph.CloseInputStream("tensor_in"));
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  ASSERT_EQ(3, output_packets.size());
+  EXPECT_EQ(Timestamp(2), output_packets[2].Timestamp());
+}
+
+// Tests two nodes running the add model on one shared inference service.
+TEST_F(TfLiteInferenceCalculatorTest, InferenceService) {
+  CalculatorGraphConfig graph_config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(
+          R"(
+            input_stream: "tensor_in"
+            node {
+              calculator: "TfLiteInferenceCalculator"
+              input_stream: "TENSORS:tensor_in"
+              output_stream: "TENSORS:tensor_out_a"
+              options {
+                [mediapipe.TfLiteInferenceCalculatorOptions.ext] {
+                  model_path: "mediapipe/calculators/tflite/testdata/add.bin"
+                  use_inference_service: true
+                }
+              }
+            }
+            node {
+              calculator: "TfLiteInferenceCalculator"
+              input_stream: "TENSORS:tensor_in"
+              output_stream: "TENSORS:tensor_out_b"
+              options {
+                [mediapipe.TfLiteInferenceCalculatorOptions.ext] {
+                  model_path: "mediapipe/calculators/tflite/testdata/add.bin"
+                  use_inference_service: true
+                }
+              }
+            }
+            num_threads: 2
+          )");
+  std::vector<Packet> output_packets_a;
+  std::vector<Packet> output_packets_b;
+  tool::AddVectorSink("tensor_out_a", &graph_config, &output_packets_a);
+  tool::AddVectorSink("tensor_out_b", &graph_config, &output_packets_b);
+  TfLiteInferenceService::Options service_options;
+  service_options.max_batch_size = 2;
+  auto service = std::make_shared<TfLiteInferenceService>(service_options);
+  CalculatorGraph graph(graph_config);
+  MP_ASSERT_OK(graph.SetServiceObject(kTfLiteInferenceService, service));
+  MP_ASSERT_OK(graph.StartRun({}));
+
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "tensor_in", MakeInputPacket().At(Timestamp(0))));
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+  ASSERT_EQ(1, output_packets_a.size());
+  ASSERT_EQ(1, output_packets_b.size());
+  ExpectAddModelOutput(output_packets_a[0]);
+  ExpectAddModelOutput(output_packets_b[0]);
+  EXPECT_EQ(1, service->NumModels());
+
+  MP_ASSERT_OK(graph.CloseInputStream("tensor_in"));
+  MP_ASSERT_OK(graph.WaitUntilDone());
+}
+
+// The inference service must be provided to the graph.
+TEST_F(TfLiteInferenceCalculatorTest, InferenceServiceRequired) {
+  CalculatorGraphConfig graph_config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(
+          R"(
+            input_stream: "tensor_in"
+            node {
+              calculator: "TfLiteInferenceCalculator"
+              input_stream: "TENSORS:tensor_in"
+              output_stream: "TENSORS:tensor_out"
+              options {
+                [mediapipe.TfLiteInferenceCalculatorOptions.ext] {
+                  model_path: "mediapipe/calculators/tflite/testdata/add.bin"
+                  use_inference_service: true
+                }
+              }
+            }
+          )");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(graph_config));
+  EXPECT_FALSE(graph.StartRun({}).ok());
+}
+
+// Tests switching to another copy of the add model while the graph runs.
+TEST_F(TfLiteInferenceCalculatorTest, ModelUpdate) {
+  RunModelUpdate("./mediapipe/calculators/tflite/testdata/add.bin",
+                 "Model Updates");
+}
+
+// A model that fails to load leaves the old one running.
+TEST_F(TfLiteInferenceCalculatorTest, FailedModelUpdate) {
+  RunModelUpdate("mediapipe/calculators/tflite/testdata/missing.bin",
+                 "Failed Model Updates");
+}
+
+// Model updates need the model update service.
+TEST_F(TfLiteInferenceCalculatorTest, ModelUpdateServiceRequired) {
+  CalculatorGraphConfig graph_config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(
+          R"(
+            input_stream: "tensor_in"
+            node {
+              calculator: "TfLiteInferenceCalculator"
+              input_stream: "TENSORS:tensor_in"
+              output_stream: "TENSORS:tensor_out"
+              options {
+                [mediapipe.TfLiteInferenceCalculatorOptions.ext] {
+                  model_path: "mediapipe/calculators/tflite/testdata/add.bin"
+                  allow_model_updates: true
+                }
+              }
+            }
+          )");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(graph_config));
+  EXPECT_FALSE(graph.StartRun({}).ok());
+}
+
+// GPU inference cannot use an interpreter pool.
+TEST_F(TfLiteInferenceCalculatorTest, InterpreterPoolRequiresCpu) {
+  CalculatorGraphConfig graph_config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(
+          R"(
+            input_stream: "tensor_in"
+            node {
+              calculator: "TfLiteInferenceCalculator"
+              input_stream: "TENSORS:tensor_in"
+              output_stream: "TENSORS:tensor_out"
+              options {
+                [mediapipe.TfLiteInferenceCalculatorOptions.ext] {
+                  model_path: "mediapipe/calculators/tflite/testdata/add.bin"
+                  use_gpu: true
+                  num_interpreters: 2
+                }
+              }
+            }
+          )");
+  CalculatorGraph graph;
+  EXPECT_FALSE(graph.Initialize(graph_config).ok());
+}
+
 }  // namespace mediapipe
@@ -12,6 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <cstring>
 #include <unordered_map>
 #include <vector>
 
@@ -20,6 +22,7 @@
 #include "mediapipe/calculators/tflite/tflite_tensors_to_detections_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/deps/file_path.h"
+#include "mediapipe/framework/formats/compact_detections.h"
 #include "mediapipe/framework/formats/detection.pb.h"
 #include "mediapipe/framework/formats/location.h"
 #include "mediapipe/framework/formats/object_detection/anchor.pb.h"
@@ -48,19 +51,6 @@ namespace {
 constexpr int kNumInputTensorsWithAnchors = 3;
 constexpr int kNumCoordsPerBox = 4;
 
-void ConvertRawValuesToAnchors(const float* raw_anchors, int num_boxes,
-                               std::vector<Anchor>* anchors) {
-  anchors->clear();
-  for (int i = 0; i < num_boxes; ++i) {
-    Anchor new_anchor;
-    new_anchor.set_y_center(raw_anchors[i * kNumCoordsPerBox + 0]);
-    new_anchor.set_x_center(raw_anchors[i * kNumCoordsPerBox + 1]);
-    new_anchor.set_h(raw_anchors[i * kNumCoordsPerBox + 2]);
-    new_anchor.set_w(raw_anchors[i * kNumCoordsPerBox + 3]);
-    anchors->push_back(new_anchor);
-  }
-}
-
 void ConvertAnchorsToRawValues(const std::vector<Anchor>& anchors,
                                int num_boxes, float* raw_anchors) {
   CHECK_EQ(anchors.size(), num_boxes);
@@ -74,6 +64,29 @@ void ConvertAnchorsToRawValues(const std::vector<Anchor>& anchors,
   }
 }
 
+#if defined(__ANDROID__)
+// Reads the first "size" elements of "buffer" into "data".  Must be called in
+// the GL context.
+template <typename T>
+::mediapipe::Status ReadBufferPrefix(const GlBuffer& buffer, size_t size,
+                                     T* data) {
+  if (size == 0) {
+    return ::mediapipe::OkStatus();
+  }
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer.id());
+  const void* mapped = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0,
+                                        size * sizeof(T), GL_MAP_READ_BIT);
+  if (!mapped) {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    return ::mediapipe::InternalError("Failed to map the GPU buffer.");
+  }
+  std::memcpy(data, mapped, size * sizeof(T));
+  glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  return ::mediapipe::OkStatus();
+}
+#endif  // ANDROID
+
 }  // namespace
 
 // Convert result TFLite tensors from object detection models into MediaPipe
@@ -88,9 +101,20 @@ void ConvertAnchorsToRawValues(const std::vector<Anchor>& anchors,
 //               optional to pass in a third tensor for anchors (e.g. for SSD
 //               models) depend on the outputs of the detection model. The size
 //               of anchor tensor must be (num_boxes * 4).
-//  TENSORS_GPU - vector of GlBuffer.
+//  TENSORS_GPU - vector of GlBuffer.  With max_gpu_candidates, boxes are
+//                decoded, scored and thresholded on the GPU, and only those
+//                passing min_score_thresh are read back, in no particular
+//                order.
 // Output:
 //  DETECTIONS - Result MediaPipe detections.
+//  COMPACT_DETECTIONS - The same detections as CompactDetections, which skips
+//                       building a Detection proto for each of them.
+//
+// Input side packets (optional, used when there is no anchor tensor):
+//  ANCHORS - std::vector<Anchor>, e.g. from SsdAnchorsCalculator.
+//  RAW_ANCHORS - The same anchors as a std::vector<float> with 4 values per
+//                anchor in the order y_center, x_center, h, w. Preferred over
+//                ANCHORS, since it is used without any conversion.
 //
 // Usage example:
 // node {
@@ -121,21 +145,22 @@ class TfLiteTensorsToDetectionsCalculator : public CalculatorBase {
 
  private:
   ::mediapipe::Status ProcessCPU(CalculatorContext* cc,
-                                 std::vector<Detection>* output_detections);
+                                 CompactDetections* output_detections);
   ::mediapipe::Status ProcessGPU(CalculatorContext* cc,
-                                 std::vector<Detection>* output_detections);
+                                 CompactDetections* output_detections);
 
   ::mediapipe::Status LoadOptions(CalculatorContext* cc);
   ::mediapipe::Status GlSetup(CalculatorContext* cc);
+  // Reads the anchors from the ANCHORS or RAW_ANCHORS input side packet.
+  ::mediapipe::Status GetSidePacketAnchors(CalculatorContext* cc,
+                                           std::vector<float>* raw_anchors);
   ::mediapipe::Status DecodeBoxes(const float* raw_boxes,
-                                  const std::vector<Anchor>& anchors,
+                                  const float* raw_anchors,
                                   std::vector<float>* boxes);
   ::mediapipe::Status ConvertToDetections(
-      const float* detection_boxes, const float* detection_scores,
-      const int* detection_classes, std::vector<Detection>* output_detections);
-  Detection ConvertToDetection(float box_ymin, float box_xmin, float box_ymax,
-                               float box_xmax, float score, int class_id,
-                               bool flip_vertically);
+      int num_boxes, const float* detection_boxes,
+      const float* detection_scores, const int* detection_classes,
+      CompactDetections* output_detections);
 
   int num_classes_ = 0;
   int num_boxes_ = 0;
@@ -143,7 +168,9 @@ class TfLiteTensorsToDetectionsCalculator : public CalculatorBase {
   std::set<int> ignore_classes_;
 
   ::mediapipe::TfLiteTensorsToDetectionsCalculatorOptions options_;
-  std::vector<Anchor> anchors_;
+  // The anchors, with kNumCoordsPerBox values per anchor in the order
+  // y_center, x_center, h, w.
+  std::vector<float> raw_anchors_;
   bool side_packet_anchors_{};
 
 #if defined(__ANDROID__)
@@ -155,6 +182,10 @@ class TfLiteTensorsToDetectionsCalculator : public CalculatorBase {
   std::unique_ptr<GlBuffer> raw_anchors_buffer_;
   std::unique_ptr<GlBuffer> scored_boxes_buffer_;
   std::unique_ptr<GlBuffer> raw_scores_buffer_;
+  // Gathers the boxes passing min_score_thresh, if max_gpu_candidates is set.
+  std::unique_ptr<GlProgram> compact_program_;
+  std::unique_ptr<GlBuffer> candidates_buffer_;
+  std::unique_ptr<GlBuffer> num_candidates_buffer_;
 #endif
 
   bool gpu_input_ = false;
@@ -180,11 +211,19 @@ REGISTER_CALCULATOR(TfLiteTensorsToDetectionsCalculator);
   if (cc->Outputs().HasTag("DETECTIONS")) {
     cc->Outputs().Tag("DETECTIONS").Set<std::vector<Detection>>();
   }
+  if (cc->Outputs().HasTag("COMPACT_DETECTIONS")) {
+    cc->Outputs().Tag("COMPACT_DETECTIONS").Set<CompactDetections>();
+  }
 
   if (cc->InputSidePackets().UsesTags()) {
+    RET_CHECK(!(cc->InputSidePackets().HasTag("ANCHORS") &&
+                cc->InputSidePackets().HasTag("RAW_ANCHORS")));
     if (cc->InputSidePackets().HasTag("ANCHORS")) {
       cc->InputSidePackets().Tag("ANCHORS").Set<std::vector<Anchor>>();
     }
+    if (cc->InputSidePackets().HasTag("RAW_ANCHORS")) {
+      cc->InputSidePackets().Tag("RAW_ANCHORS").Set<std::vector<float>>();
+    }
   }
 
 #if defined(__ANDROID__)
@@ -206,7 +245,8 @@ REGISTER_CALCULATOR(TfLiteTensorsToDetectionsCalculator);
   }
 
   MP_RETURN_IF_ERROR(LoadOptions(cc));
-  side_packet_anchors_ = cc->InputSidePackets().HasTag("ANCHORS");
+  side_packet_anchors_ = cc->InputSidePackets().HasTag("ANCHORS") ||
+                         cc->InputSidePackets().HasTag("RAW_ANCHORS");
 
   if (gpu_input_) {
     MP_RETURN_IF_ERROR(GlSetup(cc));
@@ -222,7 +262,8 @@ REGISTER_CALCULATOR(TfLiteTensorsToDetectionsCalculator);
     return ::mediapipe::OkStatus();
   }
 
-  auto output_detections = absl::make_unique<std::vector<Detection>>();
+  auto output_detections = absl::make_unique<CompactDetections>();
+  output_detections->num_keypoints = options_.num_keypoints();
 
   if (gpu_input_) {
     MP_RETURN_IF_ERROR(ProcessGPU(cc, output_detections.get()));
@@ -232,8 +273,15 @@ REGISTER_CALCULATOR(TfLiteTensorsToDetectionsCalculator);
 
   // Output
   if (cc->Outputs().HasTag("DETECTIONS")) {
+    auto detections = absl::make_unique<std::vector<Detection>>();
+    CompactDetectionsToDetections(*output_detections, detections.get());
     cc->Outputs()
         .Tag("DETECTIONS")
+        .Add(detections.release(), cc->InputTimestamp());
+  }
+  if (cc->Outputs().HasTag("COMPACT_DETECTIONS")) {
+    cc->Outputs()
+        .Tag("COMPACT_DETECTIONS")
         .Add(output_detections.release(), cc->InputTimestamp());
   }
 
@@ -241,7 +289,7 @@ REGISTER_CALCULATOR(TfLiteTensorsToDetectionsCalculator);
 }
 
 ::mediapipe::Status TfLiteTensorsToDetectionsCalculator::ProcessCPU(
-    CalculatorContext* cc, std::vector<Detection>* output_detections) {
+    CalculatorContext* cc, CompactDetections* output_detections) {
   const auto& input_tensors =
       cc->Inputs().Tag("TENSORS").Get<std::vector<TfLiteTensor>>();
 
@@ -271,18 +319,17 @@ REGISTER_CALCULATOR(TfLiteTensorsToDetectionsCalculator);
         CHECK_EQ(anchor_tensor->dims->data[0], num_boxes_);
         CHECK_EQ(anchor_tensor->dims->data[1], kNumCoordsPerBox);
         const float* raw_anchors = anchor_tensor->data.f;
-        ConvertRawValuesToAnchors(raw_anchors, num_boxes_, &anchors_);
+        raw_anchors_.assign(raw_anchors,
+                            raw_anchors + num_boxes_ * kNumCoordsPerBox);
       } else if (side_packet_anchors_) {
-        CHECK(!cc->InputSidePackets().Tag("ANCHORS").IsEmpty());
-        anchors_ =
-            cc->InputSidePackets().Tag("ANCHORS").Get<std::vector<Anchor>>();
+        MP_RETURN_IF_ERROR(GetSidePacketAnchors(cc, &raw_anchors_));
       } else {
         return ::mediapipe::UnavailableError("No anchor data available.");
       }
       anchors_init_ = true;
     }
     std::vector<float> boxes(num_boxes_ * num_coords_);
-    MP_RETURN_IF_ERROR(DecodeBoxes(raw_boxes, anchors_, &boxes));
+    MP_RETURN_IF_ERROR(DecodeBoxes(raw_boxes, raw_anchors_.data(), &boxes));
 
     std::vector<float> detection_scores(num_boxes_);
     std::vector<int> detection_classes(num_boxes_);
@@ -316,9 +363,9 @@ REGISTER_CALCULATOR(TfLiteTensorsToDetectionsCalculator);
       detection_classes[i] = class_id;
     }
 
-    MP_RETURN_IF_ERROR(
-        ConvertToDetections(boxes.data(), detection_scores.data(),
-                            detection_classes.data(), output_detections));
+    MP_RETURN_IF_ERROR(ConvertToDetections(
+        num_boxes_, boxes.data(), detection_scores.data(),
+        detection_classes.data(), output_detections));
   } else {
     // Postprocessing on CPU with postprocessing op (e.g. anchor decoding and
     // non-maximum suppression) within the model.
@@ -350,14 +397,15 @@ REGISTER_CALCULATOR(TfLiteTensorsToDetectionsCalculator);
       detection_classes[i] =
           static_cast<int>(detection_classes_tensor->data.f[i]);
     }
-    MP_RETURN_IF_ERROR(ConvertToDetections(detection_boxes, detection_scores,
+    MP_RETURN_IF_ERROR(ConvertToDetections(num_boxes_, detection_boxes,
+                                           detection_scores,
                                            detection_classes.data(),
                                            output_detections));
   }
   return ::mediapipe::OkStatus();
 }
 ::mediapipe::Status TfLiteTensorsToDetectionsCalculator::ProcessGPU(
-    CalculatorContext* cc, std::vector<Detection>* output_detections) {
+    CalculatorContext* cc, CompactDetections* output_detections) {
 #if defined(__ANDROID__)
   const auto& input_tensors =
       cc->Inputs().Tag("TENSORS_GPU").Get<std::vector<GlBuffer>>();
@@ -367,11 +415,8 @@ REGISTER_CALCULATOR(TfLiteTensorsToDetectionsCalculator);
   tflite::gpu::gl::CopyBuffer(input_tensors[1], *raw_scores_buffer_.get());
   if (!anchors_init_) {
     if (side_packet_anchors_) {
-      CHECK(!cc->InputSidePackets().Tag("ANCHORS").IsEmpty());
-      const auto& anchors =
-          cc->InputSidePackets().Tag("ANCHORS").Get<std::vector<Anchor>>();
-      std::vector<float> raw_anchors(num_boxes_ * kNumCoordsPerBox);
-      ConvertAnchorsToRawValues(anchors, num_boxes_, raw_anchors.data());
+      std::vector<float> raw_anchors;
+      MP_RETURN_IF_ERROR(GetSidePacketAnchors(cc, &raw_anchors));
       raw_anchors_buffer_->Write<float>(absl::MakeSpan(raw_anchors));
     } else {
       CHECK_EQ(input_tensors.size(), 3);
@@ -399,6 +444,56 @@ REGISTER_CALCULATOR(TfLiteTensorsToDetectionsCalculator);
         return ::mediapipe::OkStatus();
       }));
 
+  if (compact_program_) {
+    // Gather the boxes passing the score threshold, and read back only them
+    // unless there are more than the candidate buffer holds.
+    const uint32 max_candidates = options_.max_gpu_candidates();
+    const int candidate_size = num_coords_ + 2;  // score, class, coords
+    std::vector<float> candidates;
+    uint32 num_candidates = 0;
+    MP_RETURN_IF_ERROR(gpu_helper_.RunInGlContext(
+        [this, max_candidates, candidate_size, &candidates,
+         &num_candidates]() -> ::mediapipe::Status {
+          const uint32 zero = 0;
+          auto status = num_candidates_buffer_->Write<uint32>(
+              absl::Span<const uint32>(&zero, 1));
+          if (!status.ok()) {
+            return ::mediapipe::InternalError(status.error_message());
+          }
+          glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+          num_candidates_buffer_->BindToIndex(0);
+          candidates_buffer_->BindToIndex(1);
+          decoded_boxes_buffer_->BindToIndex(2);
+          scored_boxes_buffer_->BindToIndex(3);
+          const tflite::gpu::uint3 compact_workgroups = {num_boxes_, 1, 1};
+          compact_program_->Dispatch(compact_workgroups);
+          glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+          MP_RETURN_IF_ERROR(
+              ReadBufferPrefix(*num_candidates_buffer_, 1, &num_candidates));
+          if (num_candidates <= max_candidates) {
+            candidates.resize(num_candidates * candidate_size);
+            MP_RETURN_IF_ERROR(ReadBufferPrefix(
+                *candidates_buffer_, candidates.size(), candidates.data()));
+          }
+          return ::mediapipe::OkStatus();
+        }));
+    if (num_candidates <= max_candidates) {
+      std::vector<float> boxes(num_candidates * num_coords_);
+      std::vector<float> detection_scores(num_candidates);
+      std::vector<int> detection_classes(num_candidates);
+      for (int i = 0; i < num_candidates; ++i) {
+        const float* candidate = &candidates[i * candidate_size];
+        detection_scores[i] = candidate[0];
+        detection_classes[i] = static_cast<int>(candidate[1]);
+        std::copy(candidate + 2, candidate + candidate_size,
+                  &boxes[i * num_coords_]);
+      }
+      return ConvertToDetections(num_candidates, boxes.data(),
+                                 detection_scores.data(),
+                                 detection_classes.data(), output_detections);
+    }
+  }
+
   // Copy decoded boxes from GPU to CPU.
   std::vector<float> boxes(num_boxes_ * num_coords_);
   auto status = decoded_boxes_buffer_->Read(absl::MakeSpan(boxes));
@@ -419,7 +514,8 @@ REGISTER_CALCULATOR(TfLiteTensorsToDetectionsCalculator);
     detection_scores[i] = score_class_id_pairs[i * 2];
     detection_classes[i] = static_cast<int>(score_class_id_pairs[i * 2 + 1]);
   }
-  MP_RETURN_IF_ERROR(ConvertToDetections(boxes.data(), detection_scores.data(),
+  MP_RETURN_IF_ERROR(ConvertToDetections(num_boxes_, boxes.data(),
+                                         detection_scores.data(),
                                          detection_classes.data(),
                                          output_detections));
 #else
@@ -439,6 +535,9 @@ REGISTER_CALCULATOR(TfLiteTensorsToDetectionsCalculator);
     raw_anchors_buffer_.reset();
     scored_boxes_buffer_.reset();
     raw_scores_buffer_.reset();
+    compact_program_.reset();
+    candidates_buffer_.reset();
+    num_candidates_buffer_.reset();
   });
 #endif  // __ANDROID__
 
@@ -467,13 +566,40 @@ REGISTER_CALCULATOR(TfLiteTensorsToDetectionsCalculator);
     ignore_classes_.insert(options_.ignore_classes(i));
   }
 
+  RET_CHECK_GE(options_.max_gpu_candidates(), 0);
+  RET_CHECK(options_.max_gpu_candidates() == 0 ||
+            options_.has_min_score_thresh())
+      << "max_gpu_candidates requires min_score_thresh.";
+
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status TfLiteTensorsToDetectionsCalculator::GetSidePacketAnchors(
+    CalculatorContext* cc, std::vector<float>* raw_anchors) {
+  if (cc->InputSidePackets().HasTag("RAW_ANCHORS")) {
+    RET_CHECK(!cc->InputSidePackets().Tag("RAW_ANCHORS").IsEmpty());
+    *raw_anchors =
+        cc->InputSidePackets().Tag("RAW_ANCHORS").Get<std::vector<float>>();
+    RET_CHECK_EQ(raw_anchors->size(), num_boxes_ * kNumCoordsPerBox);
+    return ::mediapipe::OkStatus();
+  }
+  RET_CHECK(!cc->InputSidePackets().Tag("ANCHORS").IsEmpty());
+  const auto& anchors =
+      cc->InputSidePackets().Tag("ANCHORS").Get<std::vector<Anchor>>();
+  raw_anchors->resize(num_boxes_ * kNumCoordsPerBox);
+  ConvertAnchorsToRawValues(anchors, num_boxes_, raw_anchors->data());
   return ::mediapipe::OkStatus();
 }
 
 ::mediapipe::Status TfLiteTensorsToDetectionsCalculator::DecodeBoxes(
-    const float* raw_boxes, const std::vector<Anchor>& anchors,
+    const float* raw_boxes, const float* raw_anchors,
     std::vector<float>* boxes) {
   for (int i = 0; i < num_boxes_; ++i) {
+    const float* anchor = raw_anchors + i * kNumCoordsPerBox;
+    const float anchor_y_center = anchor[0];
+    const float anchor_x_center = anchor[1];
+    const float anchor_h = anchor[2];
+    const float anchor_w = anchor[3];
     const int box_offset = i * num_coords_ + options_.box_coord_offset();
 
     float y_center = raw_boxes[box_offset];
@@ -487,17 +613,15 @@ REGISTER_CALCULATOR(TfLiteTensorsToDetectionsCalculator);
       h = raw_boxes[box_offset + 3];
     }
 
-    x_center =
-        x_center / options_.x_scale() * anchors[i].w() + anchors[i].x_center();
-    y_center =
-        y_center / options_.y_scale() * anchors[i].h() + anchors[i].y_center();
+    x_center = x_center / options_.x_scale() * anchor_w + anchor_x_center;
+    y_center = y_center / options_.y_scale() * anchor_h + anchor_y_center;
 
     if (options_.apply_exponential_on_box_size()) {
-      h = std::exp(h / options_.h_scale()) * anchors[i].h();
-      w = std::exp(w / options_.w_scale()) * anchors[i].w();
+      h = std::exp(h / options_.h_scale()) * anchor_h;
+      w = std::exp(w / options_.w_scale()) * anchor_w;
     } else {
-      h = h / options_.h_scale() * anchors[i].h();
-      w = w / options_.w_scale() * anchors[i].w();
+      h = h / options_.h_scale() * anchor_h;
+      w = w / options_.w_scale() * anchor_w;
     }
 
     const float ymin = y_center - h / 2.f;
@@ -522,11 +646,10 @@ REGISTER_CALCULATOR(TfLiteTensorsToDetectionsCalculator);
           keypoint_y = raw_boxes[offset + 1];
         }
 
-        (*boxes)[offset] = keypoint_x / options_.x_scale() * anchors[i].w() +
-                           anchors[i].x_center();
+        (*boxes)[offset] =
+            keypoint_x / options_.x_scale() * anchor_w + anchor_x_center;
         (*boxes)[offset + 1] =
-            keypoint_y / options_.y_scale() * anchors[i].h() +
-            anchors[i].y_center();
+            keypoint_y / options_.y_scale() * anchor_h + anchor_y_center;
       }
     }
   }
@@ -534,58 +657,38 @@ REGISTER_CALCULATOR(TfLiteTensorsToDetectionsCalculator);
 }
 
 ::mediapipe::Status TfLiteTensorsToDetectionsCalculator::ConvertToDetections(
-    const float* detection_boxes, const float* detection_scores,
-    const int* detection_classes, std::vector<Detection>* output_detections) {
-  for (int i = 0; i < num_boxes_; ++i) {
+    int num_boxes, const float* detection_boxes, const float* detection_scores,
+    const int* detection_classes, CompactDetections* output_detections) {
+  const bool flip_vertically = options_.flip_vertically();
+  for (int i = 0; i < num_boxes; ++i) {
     if (options_.has_min_score_thresh() &&
         detection_scores[i] < options_.min_score_thresh()) {
       continue;
     }
     const int box_offset = i * num_coords_;
-    Detection detection = ConvertToDetection(
-        detection_boxes[box_offset + 0], detection_boxes[box_offset + 1],
-        detection_boxes[box_offset + 2], detection_boxes[box_offset + 3],
-        detection_scores[i], detection_classes[i], options_.flip_vertically());
+    const float box_ymin = detection_boxes[box_offset + 0];
+    const float box_xmin = detection_boxes[box_offset + 1];
+    const float box_ymax = detection_boxes[box_offset + 2];
+    const float box_xmax = detection_boxes[box_offset + 3];
+    const int index = output_detections->Add(
+        box_xmin, flip_vertically ? 1.f - box_ymax : box_ymin,
+        box_xmax - box_xmin, box_ymax - box_ymin, detection_scores[i],
+        detection_classes[i]);
     // Add keypoints.
-    if (options_.num_keypoints() > 0) {
-      auto* location_data = detection.mutable_location_data();
-      for (int kp_id = 0; kp_id < options_.num_keypoints() *
-                                      options_.num_values_per_keypoint();
-           kp_id += options_.num_values_per_keypoint()) {
-        auto keypoint = location_data->add_relative_keypoints();
-        const int keypoint_index =
-            box_offset + options_.keypoint_coord_offset() + kp_id;
-        keypoint->set_x(detection_boxes[keypoint_index + 0]);
-        keypoint->set_y(options_.flip_vertically()
-                            ? 1.f - detection_boxes[keypoint_index + 1]
-                            : detection_boxes[keypoint_index + 1]);
-      }
+    float* keypoints = output_detections->MutableKeypoints(index);
+    for (int kp_id = 0; kp_id < options_.num_keypoints() *
+                                    options_.num_values_per_keypoint();
+         kp_id += options_.num_values_per_keypoint()) {
+      const int keypoint_index =
+          box_offset + options_.keypoint_coord_offset() + kp_id;
+      *keypoints++ = detection_boxes[keypoint_index + 0];
+      *keypoints++ = flip_vertically ? 1.f - detection_boxes[keypoint_index + 1]
+                                     : detection_boxes[keypoint_index + 1];
     }
-    output_detections->emplace_back(detection);
   }
   return ::mediapipe::OkStatus();
 }
 
-Detection TfLiteTensorsToDetectionsCalculator::ConvertToDetection(
-    float box_ymin, float box_xmin, float box_ymax, float box_xmax, float score,
-    int class_id, bool flip_vertically) {
-  Detection detection;
-  detection.add_score(score);
-  detection.add_label_id(class_id);
-
-  LocationData* location_data = detection.mutable_location_data();
-  location_data->set_format(LocationData::RELATIVE_BOUNDING_BOX);
-
-  LocationData::RelativeBoundingBox* relative_bbox =
-      location_data->mutable_relative_bounding_box();
-
-  relative_bbox->set_xmin(box_xmin);
-  relative_bbox->set_ymin(flip_vertically ? 1.f - box_ymax : box_ymin);
-  relative_bbox->set_width(box_xmax - box_xmin);
-  relative_bbox->set_height(box_ymax - box_ymin);
-  return detection;
-}
-
 ::mediapipe::Status TfLiteTensorsToDetectionsCalculator::GlSetup(
     CalculatorContext* cc) {
 #if defined(__ANDROID__)
@@ -823,6 +926,82 @@ void main() {
     return ::mediapipe::InternalError(status.error_message());
   }
 
+  if (options_.max_gpu_candidates() > 0) {
+    // A shader to gather the boxes passing the score threshold.
+    const std::string compact_src = absl::Substitute(
+        R"( #version 310 es
+
+layout(local_size_x = 1, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) buffer Counter {
+  uint count;
+} num_candidates;
+
+layout(std430, binding = 1) writeonly buffer Output {
+  float data[];
+} candidates;
+
+layout(std430, binding = 2) readonly buffer Input0 {
+  float data[];
+} boxes;
+
+layout(std430, binding = 3) readonly buffer Input1 {
+  float data[];
+} scored_boxes;
+
+uint num_coords = uint($0);
+uint max_candidates = uint($1);
+float min_score = float($2);
+
+void main() {
+  uint g_idx = gl_GlobalInvocationID.x;  // box index
+  float score = scored_boxes.data[g_idx * uint(2) + uint(0)];
+  if (score < min_score) return;
+
+  uint slot = atomicAdd(num_candidates.count, uint(1));
+  if (slot >= max_candidates) return;
+
+  // Each candidate holds its score, class and decoded coordinates.
+  uint offset = slot * (num_coords + uint(2));
+  candidates.data[offset + uint(0)] = score;
+  candidates.data[offset + uint(1)] =
+      scored_boxes.data[g_idx * uint(2) + uint(1)];
+  for (uint i = uint(0); i < num_coords; ++i) {
+    candidates.data[offset + uint(2) + i] = boxes.data[g_idx * num_coords + i];
+  }
+})",
+        num_coords_, options_.max_gpu_candidates(),
+        options_.min_score_thresh());
+
+    GlShader compact_shader;
+    status = GlShader::CompileShader(GL_COMPUTE_SHADER, compact_src,
+                                     &compact_shader);
+    if (!status.ok()) {
+      return ::mediapipe::InternalError(status.error_message());
+    }
+    compact_program_ = absl::make_unique<GlProgram>();
+    status =
+        GlProgram::CreateWithShader(compact_shader, compact_program_.get());
+    if (!status.ok()) {
+      return ::mediapipe::InternalError(status.error_message());
+    }
+    // Outputs
+    size_t candidates_length =
+        options_.max_gpu_candidates() * (num_coords_ + 2);
+    candidates_buffer_ = absl::make_unique<GlBuffer>();
+    status = CreateReadWriteShaderStorageBuffer<float>(
+        candidates_length, candidates_buffer_.get());
+    if (!status.ok()) {
+      return ::mediapipe::InternalError(status.error_message());
+    }
+    num_candidates_buffer_ = absl::make_unique<GlBuffer>();
+    status = CreateReadWriteShaderStorageBuffer<uint32>(
+        1, num_candidates_buffer_.get());
+    if (!status.ok()) {
+      return ::mediapipe::InternalError(status.error_message());
+    }
+  }
+
 #endif  // defined(__ANDROID__)
   return ::mediapipe::OkStatus();
 }
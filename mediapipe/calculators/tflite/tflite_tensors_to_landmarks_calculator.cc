@@ -12,10 +12,16 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <array>
+
 #include "mediapipe/calculators/tflite/tflite_tensors_to_landmarks_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/compact_landmarks.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/formats/rect.pb.h"
 #include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/statusor.h"
 #include "tensorflow/lite/interpreter.h"
 
 namespace mediapipe {
@@ -27,9 +33,32 @@ namespace mediapipe {
 //  TENSORS - Vector of TfLiteTensor of type kTfLiteFloat32. Only the first
 //            tensor will be used. The size of the values must be
 //            (num_dimension x num_landmarks).
+//  LETTERBOX_PADDING(optional) - std::array<float, 4>, the letterbox padding
+//    of the model input, removed from the normalized landmarks as done by
+//    LandmarkLetterboxRemovalCalculator.
+//  NORM_RECT(optional) - NormalizedRect the model input was cropped from,
+//    onto which the normalized landmarks are then projected as done by
+//    LandmarkProjectionCalculator.
 // Output:
 //  LANDMARKS(optional) - Result MediaPipe landmarks.
 //  NORM_LANDMARKS(optional) - Result MediaPipe normalized landmarks.
+//  COMPACT_NORM_LANDMARKS(optional) - The normalized landmarks as
+//    CompactLandmarks, which spares building a proto per landmark.
+//  MULTI_LANDMARKS(optional) - std::vector<std::vector<Landmark>>, the
+//                              landmarks of each entry of a batched tensor.
+//  MULTI_NORM_LANDMARKS(optional) - The normalized landmarks of each entry of
+//    a batched tensor, as a std::vector<std::vector<NormalizedLandmark>>.
+//
+// The MULTI_ outputs split a tensor holding the landmarks of several ROIs,
+// batched along its first dimension as done by TfLiteConverterCalculator for
+// an IMAGES input, into one landmark vector per ROI. They cannot be combined
+// with the single-ROI outputs.
+//
+// Normalized landmarks are decoded into a flat array, and normalized, freed of
+// letterbox padding and projected in a single pass over it. Protos are only
+// built for NORM_LANDMARKS, so graphs that keep COMPACT_NORM_LANDMARKS
+// convert them only where a proto is needed, with
+// CompactLandmarksToLandmarksCalculator.
 //
 // Notes:
 //   To output normalized landmarks, user must provide the original input image
@@ -59,6 +88,19 @@ class TfLiteTensorsToLandmarksCalculator : public CalculatorBase {
 
  private:
   ::mediapipe::Status LoadOptions(CalculatorContext* cc);
+  // Decodes the num_landmarks_ landmarks starting at raw_landmarks.
+  void DecodeLandmarks(const float* raw_landmarks, int num_dimensions,
+                       std::vector<Landmark>* landmarks) const;
+  // Decodes and normalizes the num_landmarks_ landmarks starting at
+  // raw_landmarks with "transform".
+  void DecodeNormalizedLandmarks(const float* raw_landmarks,
+                                 int num_dimensions,
+                                 const LandmarkTransform& transform,
+                                 CompactLandmarks* landmarks) const;
+  // Returns the transformation of decoded landmarks to normalized ones, and
+  // then through the LETTERBOX_PADDING and NORM_RECT inputs.
+  ::mediapipe::StatusOr<LandmarkTransform> NormalizationTransform(
+      CalculatorContext* cc) const;
   int num_landmarks_ = 0;
 
   ::mediapipe::TfLiteTensorsToLandmarksCalculatorOptions options_;
@@ -82,6 +124,41 @@ REGISTER_CALCULATOR(TfLiteTensorsToLandmarksCalculator);
     cc->Outputs().Tag("NORM_LANDMARKS").Set<std::vector<NormalizedLandmark>>();
   }
 
+  if (cc->Outputs().HasTag("COMPACT_NORM_LANDMARKS")) {
+    cc->Outputs().Tag("COMPACT_NORM_LANDMARKS").Set<CompactLandmarks>();
+  }
+
+  if (cc->Inputs().HasTag("LETTERBOX_PADDING")) {
+    cc->Inputs().Tag("LETTERBOX_PADDING").Set<std::array<float, 4>>();
+  }
+
+  if (cc->Inputs().HasTag("NORM_RECT")) {
+    cc->Inputs().Tag("NORM_RECT").Set<NormalizedRect>();
+  }
+
+  if (cc->Outputs().HasTag("MULTI_LANDMARKS")) {
+    cc->Outputs()
+        .Tag("MULTI_LANDMARKS")
+        .Set<std::vector<std::vector<Landmark>>>();
+  }
+
+  if (cc->Outputs().HasTag("MULTI_NORM_LANDMARKS")) {
+    cc->Outputs()
+        .Tag("MULTI_NORM_LANDMARKS")
+        .Set<std::vector<std::vector<NormalizedLandmark>>>();
+  }
+
+  const bool multi = cc->Outputs().HasTag("MULTI_LANDMARKS") ||
+                     cc->Outputs().HasTag("MULTI_NORM_LANDMARKS");
+  const bool single = cc->Outputs().HasTag("LANDMARKS") ||
+                      cc->Outputs().HasTag("NORM_LANDMARKS") ||
+                      cc->Outputs().HasTag("COMPACT_NORM_LANDMARKS");
+  RET_CHECK(!(multi && single))
+      << "MULTI_ outputs cannot be combined with single-ROI outputs.";
+  RET_CHECK(!multi || !(cc->Inputs().HasTag("LETTERBOX_PADDING") ||
+                        cc->Inputs().HasTag("NORM_RECT")))
+      << "LETTERBOX_PADDING and NORM_RECT require single-ROI outputs.";
+
   return ::mediapipe::OkStatus();
 }
 
@@ -91,12 +168,16 @@ REGISTER_CALCULATOR(TfLiteTensorsToLandmarksCalculator);
 
   MP_RETURN_IF_ERROR(LoadOptions(cc));
 
-  if (cc->Outputs().HasTag("NORM_LANDMARKS")) {
+  if (cc->Outputs().HasTag("NORM_LANDMARKS") ||
+      cc->Outputs().HasTag("COMPACT_NORM_LANDMARKS") ||
+      cc->Outputs().HasTag("MULTI_NORM_LANDMARKS")) {
     RET_CHECK(options_.has_input_image_height() &&
               options_.has_input_image_width())
         << "Must provide input with/height for getting normalized landmarks.";
   }
-  if (cc->Outputs().HasTag("LANDMARKS") && options_.flip_vertically()) {
+  if ((cc->Outputs().HasTag("LANDMARKS") ||
+       cc->Outputs().HasTag("MULTI_LANDMARKS")) &&
+      options_.flip_vertically()) {
     RET_CHECK(options_.has_input_image_height() &&
               options_.has_input_image_width())
         << "Must provide input with/height for using flip_vertically option "
@@ -120,16 +201,102 @@ REGISTER_CALCULATOR(TfLiteTensorsToLandmarksCalculator);
   for (int i = 0; i < raw_tensor->dims->size; ++i) {
     num_values *= raw_tensor->dims->data[i];
   }
+  const float* raw_landmarks = raw_tensor->data.f;
+
+  if (cc->Outputs().HasTag("MULTI_LANDMARKS") ||
+      cc->Outputs().HasTag("MULTI_NORM_LANDMARKS")) {
+    RET_CHECK_GT(raw_tensor->dims->size, 0);
+    const int num_rois = raw_tensor->dims->data[0];
+    const int values_per_roi = num_rois > 0 ? num_values / num_rois : 0;
+    const int num_dimensions = values_per_roi / num_landmarks_;
+    RET_CHECK(num_rois == 0 || (num_dimensions > 0 && num_dimensions <= 3))
+        << "Unexpected landmark tensor size " << values_per_roi
+        << " per ROI for " << num_landmarks_ << " landmarks.";
+    if (cc->Outputs().HasTag("MULTI_NORM_LANDMARKS")) {
+      ASSIGN_OR_RETURN(const LandmarkTransform transform,
+                       NormalizationTransform(cc));
+      auto multi_norm_landmarks = absl::make_unique<
+          std::vector<std::vector<NormalizedLandmark>>>(num_rois);
+      CompactLandmarks norm_landmarks;
+      for (int i = 0; i < num_rois; ++i) {
+        DecodeNormalizedLandmarks(raw_landmarks + i * values_per_roi,
+                                  num_dimensions, transform, &norm_landmarks);
+        CompactLandmarksToNormalizedLandmarks(norm_landmarks,
+                                              &(*multi_norm_landmarks)[i]);
+      }
+      cc->Outputs()
+          .Tag("MULTI_NORM_LANDMARKS")
+          .Add(multi_norm_landmarks.release(), cc->InputTimestamp());
+    }
+    if (cc->Outputs().HasTag("MULTI_LANDMARKS")) {
+      auto multi_landmarks =
+          absl::make_unique<std::vector<std::vector<Landmark>>>(num_rois);
+      for (int i = 0; i < num_rois; ++i) {
+        DecodeLandmarks(raw_landmarks + i * values_per_roi, num_dimensions,
+                        &(*multi_landmarks)[i]);
+      }
+      cc->Outputs()
+          .Tag("MULTI_LANDMARKS")
+          .Add(multi_landmarks.release(), cc->InputTimestamp());
+    }
+    return ::mediapipe::OkStatus();
+  }
+
   const int num_dimensions = num_values / num_landmarks_;
   // Landmarks must have less than 3 dimensions. Otherwise please consider
   // using matrix.
   CHECK_LE(num_dimensions, 3);
   CHECK_GT(num_dimensions, 0);
 
-  const float* raw_landmarks = raw_tensor->data.f;
+  // Output normalized landmarks if required.
+  if (cc->Outputs().HasTag("NORM_LANDMARKS") ||
+      cc->Outputs().HasTag("COMPACT_NORM_LANDMARKS")) {
+    ASSIGN_OR_RETURN(const LandmarkTransform transform,
+                     NormalizationTransform(cc));
+    auto compact_landmarks = absl::make_unique<CompactLandmarks>();
+    DecodeNormalizedLandmarks(raw_landmarks, num_dimensions, transform,
+                              compact_landmarks.get());
+    if (cc->Outputs().HasTag("NORM_LANDMARKS")) {
+      auto output_norm_landmarks =
+          absl::make_unique<std::vector<NormalizedLandmark>>();
+      CompactLandmarksToNormalizedLandmarks(*compact_landmarks,
+                                            output_norm_landmarks.get());
+      cc->Outputs()
+          .Tag("NORM_LANDMARKS")
+          .Add(output_norm_landmarks.release(), cc->InputTimestamp());
+    }
+    if (cc->Outputs().HasTag("COMPACT_NORM_LANDMARKS")) {
+      cc->Outputs()
+          .Tag("COMPACT_NORM_LANDMARKS")
+          .Add(compact_landmarks.release(), cc->InputTimestamp());
+    }
+  }
+  // Output absolute landmarks.
+  if (cc->Outputs().HasTag("LANDMARKS")) {
+    auto output_landmarks = absl::make_unique<std::vector<Landmark>>();
+    DecodeLandmarks(raw_landmarks, num_dimensions, output_landmarks.get());
+    cc->Outputs()
+        .Tag("LANDMARKS")
+        .Add(output_landmarks.release(), cc->InputTimestamp());
+  }
 
-  auto output_landmarks = absl::make_unique<std::vector<Landmark>>();
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status TfLiteTensorsToLandmarksCalculator::LoadOptions(
+    CalculatorContext* cc) {
+  // Get calculator options specified in the graph.
+  options_ =
+      cc->Options<::mediapipe::TfLiteTensorsToLandmarksCalculatorOptions>();
+  num_landmarks_ = options_.num_landmarks();
 
+  return ::mediapipe::OkStatus();
+}
+
+void TfLiteTensorsToLandmarksCalculator::DecodeLandmarks(
+    const float* raw_landmarks, int num_dimensions,
+    std::vector<Landmark>* landmarks) const {
+  landmarks->reserve(num_landmarks_);
   for (int ld = 0; ld < num_landmarks_; ++ld) {
     const int offset = ld * num_dimensions;
     Landmark landmark;
@@ -145,44 +312,54 @@ REGISTER_CALCULATOR(TfLiteTensorsToLandmarksCalculator);
     if (num_dimensions > 2) {
       landmark.set_z(raw_landmarks[offset + 2]);
     }
-    output_landmarks->push_back(landmark);
+    landmarks->push_back(landmark);
   }
+}
 
-  // Output normalized landmarks if required.
-  if (cc->Outputs().HasTag("NORM_LANDMARKS")) {
-    auto output_norm_landmarks =
-        absl::make_unique<std::vector<NormalizedLandmark>>();
-    for (const auto& landmark : *output_landmarks) {
-      NormalizedLandmark norm_landmark;
-      norm_landmark.set_x(static_cast<float>(landmark.x()) /
-                          options_.input_image_width());
-      norm_landmark.set_y(static_cast<float>(landmark.y()) /
-                          options_.input_image_height());
-      norm_landmark.set_z(landmark.z() / options_.normalize_z());
-
-      output_norm_landmarks->push_back(norm_landmark);
+void TfLiteTensorsToLandmarksCalculator::DecodeNormalizedLandmarks(
+    const float* raw_landmarks, int num_dimensions,
+    const LandmarkTransform& transform, CompactLandmarks* landmarks) const {
+  landmarks->Resize(num_landmarks_);
+  if (num_dimensions == 3) {
+    std::copy(raw_landmarks, raw_landmarks + 3 * num_landmarks_,
+              landmarks->coordinates.begin());
+  } else {
+    for (int ld = 0; ld < num_landmarks_; ++ld) {
+      float* coordinates = landmarks->MutableLandmark(ld);
+      for (int d = 0; d < 3; ++d) {
+        coordinates[d] = d < num_dimensions ? *raw_landmarks++ : 0.0f;
+      }
     }
-    cc->Outputs()
-        .Tag("NORM_LANDMARKS")
-        .Add(output_norm_landmarks.release(), cc->InputTimestamp());
   }
-  // Output absolute landmarks.
-  if (cc->Outputs().HasTag("LANDMARKS")) {
-    cc->Outputs()
-        .Tag("LANDMARKS")
-        .Add(output_landmarks.release(), cc->InputTimestamp());
-  }
-
-  return ::mediapipe::OkStatus();
+  transform.Apply(landmarks);
 }
 
-::mediapipe::Status TfLiteTensorsToLandmarksCalculator::LoadOptions(
-    CalculatorContext* cc) {
-  // Get calculator options specified in the graph.
-  options_ =
-      cc->Options<::mediapipe::TfLiteTensorsToLandmarksCalculatorOptions>();
-  num_landmarks_ = options_.num_landmarks();
-
-  return ::mediapipe::OkStatus();
+::mediapipe::StatusOr<LandmarkTransform>
+TfLiteTensorsToLandmarksCalculator::NormalizationTransform(
+    CalculatorContext* cc) const {
+  const float height = options_.input_image_height();
+  LandmarkTransform transform;
+  if (options_.flip_vertically()) {
+    transform = LandmarkTransform::Scale(1.0f, -1.0f, 1.0f)
+                    .Then(LandmarkTransform::Translate(0.0f, height));
+  }
+  transform = transform.Then(
+      LandmarkTransform::Scale(1.0f / options_.input_image_width(),
+                               1.0f / height, 1.0f / options_.normalize_z()));
+  if (cc->Inputs().HasTag("LETTERBOX_PADDING")) {
+    RET_CHECK(!cc->Inputs().Tag("LETTERBOX_PADDING").IsEmpty())
+        << "Missing LETTERBOX_PADDING for the landmarks.";
+    transform = transform.Then(LandmarkTransform::RemoveLetterbox(
+        cc->Inputs().Tag("LETTERBOX_PADDING").Get<std::array<float, 4>>()));
+  }
+  if (cc->Inputs().HasTag("NORM_RECT")) {
+    RET_CHECK(!cc->Inputs().Tag("NORM_RECT").IsEmpty())
+        << "Missing NORM_RECT for the landmarks.";
+    transform = transform.Then(LandmarkTransform::Project(
+        cc->Inputs().Tag("NORM_RECT").Get<NormalizedRect>(),
+        options_.ignore_rotation()));
+  }
+  return transform;
 }
+
 }  // namespace mediapipe
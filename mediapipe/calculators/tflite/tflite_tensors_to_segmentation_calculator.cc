@@ -78,11 +78,13 @@ using ::tflite::gpu::gl::GlShader;
 //                                   used only for output dimensions.
 //   One of the following PREV_MASK tags:
 //   PREV_MASK (optional): An ImageFrame input mask, Gray, RGB or RGBA, [0-255].
-//   PREV_MASK_GPU (optional): A GpuBuffer input mask, RGBA, [0-1].
+//   PREV_MASK_GPU (optional): A GpuBuffer input mask, RGBA or single channel,
+//                             [0-1].
 // Output:
 //   One of the following MASK tags:
 //   MASK: An ImageFrame output mask, RGBA.
-//   MASK_GPU: A GpuBuffer output mask, RGBA.
+//   MASK_GPU: A GpuBuffer output mask, RGBA, or single channel if
+//             single_channel_gpu_output is set.
 //
 // Options:
 //   See tflite_segmentation_calculator.proto
@@ -268,82 +270,94 @@ REGISTER_CALCULATOR(TfLiteTensorsToSegmentationCalculator);
   }
   RET_CHECK_EQ(input_tensors.size(), 1);
 
-  // Create initial working mask.
-  cv::Mat small_mask_mat(cv::Size(tensor_width_, tensor_height_), CV_8UC4);
+  // The mask is computed and upsampled as a single channel, which is then
+  // written into both the R and A channels of the output.
+  cv::Mat small_mask_mat(cv::Size(tensor_width_, tensor_height_), CV_8UC1);
 
-  // Get input previous mask.
+  // Get input previous mask. Only its first channel is used.
   cv::Mat input_mask_mat;
   if (has_prev_mask) {
     cv::Mat temp_mask_mat = formats::MatView(&input_mask);
-    if (temp_mask_mat.channels() != 4) {
-      cv::Mat converted_mat;
-      cv::cvtColor(temp_mask_mat, converted_mat,
-                   temp_mask_mat.channels() == 1 ? cv::COLOR_GRAY2RGBA
-                                                 : cv::COLOR_RGB2RGBA);
-      temp_mask_mat = converted_mat.clone();
+    if (temp_mask_mat.channels() != 1) {
+      cv::Mat first_channel_mat;
+      cv::extractChannel(temp_mask_mat, first_channel_mat, 0);
+      temp_mask_mat = first_channel_mat;
+    }
+    if (temp_mask_mat.size() == small_mask_mat.size()) {
+      input_mask_mat = temp_mask_mat;
+    } else {
+      cv::resize(temp_mask_mat, input_mask_mat, small_mask_mat.size());
     }
-    cv::resize(temp_mask_mat, input_mask_mat, small_mask_mat.size());
   }
 
-  // Copy input tensor.
+  // Read the input tensor in place.
   const TfLiteTensor* raw_input_tensor = &input_tensors[0];
+  RET_CHECK_EQ(raw_input_tensor->bytes,
+               tensor_width_ * tensor_height_ * tensor_channels_ *
+                   sizeof(float));
   const float* raw_input_data = raw_input_tensor->data.f;
-  cv::Mat tensor_mat(cv::Size(tensor_width_, tensor_height_),
-                     CV_MAKETYPE(CV_32F, tensor_channels_));
-  float* tensor_mat_ptr = tensor_mat.ptr<float>();
-  memcpy(tensor_mat_ptr, raw_input_data, raw_input_tensor->bytes);
 
   // Process mask tensor.
   // Run softmax over tensor output and blend with previous mask.
+  // Only two channel input tensors are supported, for which the softmax of one
+  // channel is the logistic function of the difference between the two.
   const int output_layer_index = options_.output_layer_index();
+  const int other_layer_index = 1 - output_layer_index;
   const float combine_with_prev_ratio = options_.combine_with_previous_ratio();
+  const float inv_log_2 = 1.0f / std::log(2.0f);
   for (int i = 0; i < tensor_height_; ++i) {
+    const float* input_row =
+        raw_input_data + i * tensor_width_ * tensor_channels_;
+    const uchar* prev_mask_row =
+        has_prev_mask ? input_mask_mat.ptr<uchar>(i) : nullptr;
+    uchar* mask_row = small_mask_mat.ptr<uchar>(i);
     for (int j = 0; j < tensor_width_; ++j) {
-      // Only two channel input tensor is supported.
-      const cv::Vec2f input_pix = tensor_mat.at<cv::Vec2f>(i, j);
-      const float shift = std::max(input_pix[0], input_pix[1]);
-      const float softmax_denom =
-          std::exp(input_pix[0] - shift) + std::exp(input_pix[1] - shift);
+      const float* input_pix = input_row + j * tensor_channels_;
       float new_mask_value =
-          std::exp(input_pix[output_layer_index] - shift) / softmax_denom;
+          1.0f / (1.0f + std::exp(input_pix[other_layer_index] -
+                                  input_pix[output_layer_index]));
       // Combine previous value with current using uncertainty^2 as mixing coeff
       if (has_prev_mask) {
-        const float prev_mask_value =
-            input_mask_mat.at<cv::Vec4b>(i, j)[0] / 255.0f;
+        const float prev_mask_value = prev_mask_row[j] / 255.0f;
         const float eps = 0.001;
         float uncertainty_alpha =
-            1.0 +
+            1.0f +
             (new_mask_value * std::log(new_mask_value + eps) +
-             (1.0 - new_mask_value) * std::log(1.0 - new_mask_value + eps)) /
-                std::log(2.0f);
+             (1.0f - new_mask_value) * std::log(1.0f - new_mask_value + eps)) *
+                inv_log_2;
         uncertainty_alpha = Clamp(uncertainty_alpha, 0.0f, 1.0f);
         // Equivalent to: a = 1 - (1 - a) * (1 - a);  (squaring the uncertainty)
-        uncertainty_alpha *= 2.0 - uncertainty_alpha;
+        uncertainty_alpha *= 2.0f - uncertainty_alpha;
         const float mixed_mask_value =
             new_mask_value * uncertainty_alpha +
             prev_mask_value * (1.0f - uncertainty_alpha);
         new_mask_value = mixed_mask_value * combine_with_prev_ratio +
                          (1.0f - combine_with_prev_ratio) * new_mask_value;
       }
-      const uchar mask_value = static_cast<uchar>(new_mask_value * 255);
-      // Set both R and A channels for convenience.
-      const cv::Vec4b out_value = {mask_value, 0, 0, mask_value};
-      small_mask_mat.at<cv::Vec4b>(i, j) = out_value;
+      mask_row[j] = static_cast<uchar>(new_mask_value * 255);
     }
   }
 
   if (options_.flip_vertically()) cv::flip(small_mask_mat, small_mask_mat, 0);
 
-  // Upsample small mask into output.
+  // Upsample small mask.
   cv::Mat large_mask_mat;
-  cv::resize(small_mask_mat, large_mask_mat,
-             cv::Size(output_width, output_height));
+  if (output_width == tensor_width_ && output_height == tensor_height_) {
+    large_mask_mat = small_mask_mat;
+  } else {
+    cv::resize(small_mask_mat, large_mask_mat,
+               cv::Size(output_width, output_height));
+  }
 
-  // Send out image as CPU packet.
+  // Send out image as CPU packet, setting both R and A channels for
+  // convenience.
   std::unique_ptr<ImageFrame> output_mask = absl::make_unique<ImageFrame>(
       ImageFormat::SRGBA, output_width, output_height);
   cv::Mat output_mat = formats::MatView(output_mask.get());
-  large_mask_mat.copyTo(output_mat);
+  const cv::Mat zero_mat = cv::Mat::zeros(large_mask_mat.size(), CV_8UC1);
+  const cv::Mat channels[] = {large_mask_mat, zero_mat, zero_mat,
+                              large_mask_mat};
+  cv::merge(channels, 4, output_mat);
   cc->Outputs().Tag("MASK").Add(output_mask.release(), cc->InputTimestamp());
 
   return ::mediapipe::OkStatus();
@@ -415,9 +429,12 @@ REGISTER_CALCULATOR(TfLiteTensorsToSegmentationCalculator);
   }
 
   // Upsample small mask into output.
+  const mediapipe::GpuBufferFormat output_format =
+      options_.single_channel_gpu_output()
+          ? mediapipe::GpuBufferFormat::kGrayHalf16  // GL_R16F
+          : mediapipe::GpuBufferFormat::kBGRA32;     // actually GL_RGBA8
   mediapipe::GlTexture output_texture = gpu_helper_.CreateDestinationTexture(
-      output_width, output_height,
-      mediapipe::GpuBufferFormat::kBGRA32);  // actually GL_RGBA8
+      output_width, output_height, output_format);
 
   // Run shader, upsample result.
   {
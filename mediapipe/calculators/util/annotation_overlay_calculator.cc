@@ -12,19 +12,23 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstddef>
 #include <memory>
+#include <vector>
 
 #include "mediapipe/calculators/util/annotation_overlay_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_options.pb.h"
 #include "mediapipe/framework/formats/image_format.pb.h"
 #include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_opencv.h"
 #include "mediapipe/framework/formats/video_stream_header.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/opencv_core_inc.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/port/vector.h"
 #include "mediapipe/util/annotation_renderer.h"
+#include "mediapipe/util/annotation_tessellator.h"
 #include "mediapipe/util/color.pb.h"
 
 #if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
@@ -45,6 +49,9 @@ constexpr char kInputFrameTagGpu[] = "INPUT_FRAME_GPU";
 constexpr char kOutputFrameTagGpu[] = "OUTPUT_FRAME_GPU";
 
 enum { ATTRIB_VERTEX, ATTRIB_TEXTURE_POSITION, NUM_ATTRIBUTES };
+// The program drawing tessellated annotations reads a color per vertex in
+// place of the texture position.
+constexpr int kAttribColor = ATTRIB_TEXTURE_POSITION;
 
 // Round up n to next multiple of m.
 size_t RoundUp(size_t n, size_t m) { return ((n + m - 1) / m) * m; }  // NOLINT
@@ -119,9 +126,13 @@ class AnnotationOverlayCalculator : public CalculatorBase {
   ::mediapipe::Status Close(CalculatorContext* cc) override;
 
  private:
-  ::mediapipe::Status CreateRenderTargetCpu(CalculatorContext* cc,
-                                            std::unique_ptr<cv::Mat>& image_mat,
-                                            ImageFormat::Format* target_format);
+  // Creates the render target.  If the annotations can be drawn directly onto
+  // the input frame, takes the input frame into "output_frame", copying it
+  // only if another calculator still reads it, and views it in "image_mat".
+  ::mediapipe::Status CreateRenderTargetCpu(
+      CalculatorContext* cc, std::unique_ptr<cv::Mat>& image_mat,
+      ImageFormat::Format* target_format,
+      std::unique_ptr<ImageFrame>* output_frame);
   ::mediapipe::Status CreateRenderTargetGpu(
       CalculatorContext* cc, std::unique_ptr<cv::Mat>& image_mat);
   ::mediapipe::Status RenderToGpu(CalculatorContext* cc, uchar* overlay_image);
@@ -129,7 +140,14 @@ class AnnotationOverlayCalculator : public CalculatorBase {
                                   const ImageFormat::Format& target_format,
                                   uchar* data_image);
 
-  ::mediapipe::Status GlRender(CalculatorContext* cc);
+  // Appends the tessellated annotations of all the render streams to
+  // "vertices". Returns false if any of them cannot be tessellated.
+  bool TessellateRenderStreams(CalculatorContext* cc,
+                               std::vector<AnnotationVertex>* vertices);
+  // Draws "vertices" over a copy of the input frame, and outputs it.
+  ::mediapipe::Status RenderVerticesToGpu(
+      CalculatorContext* cc, const std::vector<AnnotationVertex>& vertices);
+
   ::mediapipe::Status GlSetup(CalculatorContext* cc);
 
   // Options for the calculator.
@@ -144,12 +162,22 @@ class AnnotationOverlayCalculator : public CalculatorBase {
   // Indicates if image frame is available as input.
   bool image_frame_available_ = false;
 
+  // The canvas drawn onto on the CPU when no image frame is available.
+  cv::Mat canvas_;
+
   bool use_gpu_ = false;
   bool gpu_initialized_ = false;
 #if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
+  // Draws the full frame quad with "program".
+  ::mediapipe::Status GlRender(CalculatorContext* cc, GLuint program);
+
   mediapipe::GlCalculatorHelper gpu_helper_;
   GLuint program_ = 0;
   GLuint image_mat_tex_ = 0;  // Overlay drawing image for GPU.
+  // Programs copying the input frame and drawing tessellated annotations,
+  // used with gpu_tessellation.
+  GLuint copy_program_ = 0;
+  GLuint color_program_ = 0;
   int width_ = 0;
   int height_ = 0;
 #endif  // __ANDROID__ or iOS
@@ -259,6 +287,7 @@ REGISTER_CALCULATOR(AnnotationOverlayCalculator);
   // Initialize render target, drawn with OpenCV.
   std::unique_ptr<cv::Mat> image_mat;
   ImageFormat::Format target_format;
+  std::unique_ptr<ImageFrame> output_frame;
   if (use_gpu_) {
 #if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
     if (!gpu_initialized_) {
@@ -269,10 +298,20 @@ REGISTER_CALCULATOR(AnnotationOverlayCalculator);
           }));
       gpu_initialized_ = true;
     }
+    if (options_.gpu_tessellation()) {
+      std::vector<AnnotationVertex> vertices;
+      if (TessellateRenderStreams(cc, &vertices)) {
+        return gpu_helper_.RunInGlContext(
+            [this, cc, &vertices]() -> ::mediapipe::Status {
+              return RenderVerticesToGpu(cc, vertices);
+            });
+      }
+    }
 #endif  // __ANDROID__ or iOS
     MP_RETURN_IF_ERROR(CreateRenderTargetGpu(cc, image_mat));
   } else {
-    MP_RETURN_IF_ERROR(CreateRenderTargetCpu(cc, image_mat, &target_format));
+    MP_RETURN_IF_ERROR(
+        CreateRenderTargetCpu(cc, image_mat, &target_format, &output_frame));
   }
 
   // Reset the renderer with the image_mat. No copy here.
@@ -297,6 +336,11 @@ REGISTER_CALCULATOR(AnnotationOverlayCalculator);
           return ::mediapipe::OkStatus();
         }));
 #endif  // __ANDROID__ or iOS
+  } else if (output_frame) {
+    // The annotations were drawn onto the output frame.
+    cc->Outputs()
+        .Tag(kOutputFrameTag)
+        .Add(output_frame.release(), cc->InputTimestamp());
   } else {
     // Copy the rendered image to output.
     uchar* image_mat_ptr = image_mat->data;
@@ -313,6 +357,10 @@ REGISTER_CALCULATOR(AnnotationOverlayCalculator);
     program_ = 0;
     if (image_mat_tex_) glDeleteTextures(1, &image_mat_tex_);
     image_mat_tex_ = 0;
+    if (copy_program_) glDeleteProgram(copy_program_);
+    copy_program_ = 0;
+    if (color_program_) glDeleteProgram(color_program_);
+    color_program_ = 0;
   });
 #endif  // __ANDROID__ or iOS
 
@@ -372,7 +420,7 @@ REGISTER_CALCULATOR(AnnotationOverlayCalculator);
     glActiveTexture(GL_TEXTURE2);
     glBindTexture(GL_TEXTURE_2D, image_mat_tex_);
 
-    MP_RETURN_IF_ERROR(GlRender(cc));
+    MP_RETURN_IF_ERROR(GlRender(cc, program_));
 
     glActiveTexture(GL_TEXTURE2);
     glBindTexture(GL_TEXTURE_2D, 0);
@@ -395,55 +443,133 @@ REGISTER_CALCULATOR(AnnotationOverlayCalculator);
   return ::mediapipe::OkStatus();
 }
 
+bool AnnotationOverlayCalculator::TessellateRenderStreams(
+    CalculatorContext* cc, std::vector<AnnotationVertex>* vertices) {
+#if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
+  for (int i = 0; i < num_render_streams_; ++i) {
+    if (cc->Inputs().Index(i).IsEmpty()) {
+      continue;
+    }
+    const RenderData& render_data = cc->Inputs().Index(i).Get<RenderData>();
+    if (!TessellateRenderData(render_data, width_, height_, vertices)) {
+      return false;
+    }
+  }
+  return true;
+#else
+  return false;
+#endif  // __ANDROID__ or iOS
+}
+
+::mediapipe::Status AnnotationOverlayCalculator::RenderVerticesToGpu(
+    CalculatorContext* cc, const std::vector<AnnotationVertex>& vertices) {
+#if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
+  const auto& input_frame =
+      cc->Inputs().Tag(kInputFrameTagGpu).Get<mediapipe::GpuBuffer>();
+  auto input_texture = gpu_helper_.CreateSourceTexture(input_frame);
+  auto output_texture = gpu_helper_.CreateDestinationTexture(
+      width_, height_, mediapipe::GpuBufferFormat::kBGRA32);
+  gpu_helper_.BindFramebuffer(output_texture);  // GL_TEXTURE0
+
+  // Copy the input frame.
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, input_texture.name());
+  MP_RETURN_IF_ERROR(GlRender(cc, copy_program_));
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  // Draw the annotations over it.
+  if (!vertices.empty()) {
+    glUseProgram(color_program_);
+    GLuint vbo;
+    glGenBuffers(1, &vbo);
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(AnnotationVertex),
+                 vertices.data(), GL_STREAM_DRAW);
+    glEnableVertexAttribArray(ATTRIB_VERTEX);
+    glVertexAttribPointer(
+        ATTRIB_VERTEX, 2, GL_FLOAT, GL_FALSE, sizeof(AnnotationVertex),
+        reinterpret_cast<const GLvoid*>(offsetof(AnnotationVertex, x)));
+    glEnableVertexAttribArray(kAttribColor);
+    glVertexAttribPointer(
+        kAttribColor, 3, GL_FLOAT, GL_FALSE, sizeof(AnnotationVertex),
+        reinterpret_cast<const GLvoid*>(offsetof(AnnotationVertex, r)));
+    glDrawArrays(GL_TRIANGLES, 0, vertices.size());
+    glDisableVertexAttribArray(ATTRIB_VERTEX);
+    glDisableVertexAttribArray(kAttribColor);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+  }
+  glFlush();
+
+  auto output_frame = output_texture.GetFrame<mediapipe::GpuBuffer>();
+  cc->Outputs()
+      .Tag(kOutputFrameTagGpu)
+      .Add(output_frame.release(), cc->InputTimestamp());
+
+  input_texture.Release();
+  output_texture.Release();
+#endif  // __ANDROID__ or iOS
+
+  return ::mediapipe::OkStatus();
+}
+
 ::mediapipe::Status AnnotationOverlayCalculator::CreateRenderTargetCpu(
     CalculatorContext* cc, std::unique_ptr<cv::Mat>& image_mat,
-    ImageFormat::Format* target_format) {
+    ImageFormat::Format* target_format,
+    std::unique_ptr<ImageFrame>* output_frame) {
   if (image_frame_available_) {
     const auto& input_frame =
         cc->Inputs().Tag(kInputFrameTag).Get<ImageFrame>();
-
-    int target_mat_type;
     switch (input_frame.Format()) {
       case ImageFormat::SRGBA:
-        *target_format = ImageFormat::SRGBA;
-        target_mat_type = CV_8UC4;
-        break;
       case ImageFormat::SRGB:
-        *target_format = ImageFormat::SRGB;
-        target_mat_type = CV_8UC3;
-        break;
+        // Draw onto the input frame itself, which is copied only if it is
+        // still read by other nodes.
+        *target_format = input_frame.Format();
+        ASSIGN_OR_RETURN(
+            *output_frame,
+            cc->Inputs().Tag(kInputFrameTag).ConsumeOrCopy<ImageFrame>());
+        image_mat =
+            absl::make_unique<cv::Mat>(formats::MatView(output_frame->get()));
+        return ::mediapipe::OkStatus();
       case ImageFormat::GRAY8:
         *target_format = ImageFormat::SRGB;
-        target_mat_type = CV_8UC3;
         break;
       default:
         return ::mediapipe::UnknownError("Unexpected image frame format.");
         break;
     }
 
-    image_mat = absl::make_unique<cv::Mat>(
-        input_frame.Height(), input_frame.Width(), target_mat_type);
-    if (input_frame.Format() == ImageFormat::GRAY8) {
-      const int target_num_channels =
-          ImageFrame::NumberOfChannelsForFormat(*target_format);
-      for (int i = 0; i < input_frame.PixelDataSize(); i++) {
-        const auto& pix = input_frame.PixelData()[i];
-        for (int c = 0; c < target_num_channels; c++) {
-          image_mat->data[i * target_num_channels + c] = pix;
-        }
+    image_mat = absl::make_unique<cv::Mat>(input_frame.Height(),
+                                           input_frame.Width(), CV_8UC3);
+    const int target_num_channels =
+        ImageFrame::NumberOfChannelsForFormat(*target_format);
+    for (int i = 0; i < input_frame.PixelDataSize(); i++) {
+      const auto& pix = input_frame.PixelData()[i];
+      for (int c = 0; c < target_num_channels; c++) {
+        image_mat->data[i * target_num_channels + c] = pix;
       }
-    } else {
-      // Make of a copy since the input frame may be consumed by other nodes.
-      const int buffer_size =
-          input_frame.Height() * input_frame.Width() *
-          ImageFrame::NumberOfChannelsForFormat(*target_format);
-      input_frame.CopyToBuffer(image_mat->data, buffer_size);
     }
   } else {
-    image_mat = absl::make_unique<cv::Mat>(
-        options_.canvas_height_px(), options_.canvas_width_px(), CV_8UC3,
-        cv::Scalar(options_.canvas_color().r(), options_.canvas_color().g(),
-                   options_.canvas_color().b()));
+    // The canvas is kept across frames, and only the regions drawn onto for
+    // the previous frame are cleared.
+    const cv::Scalar canvas_color(options_.canvas_color().r(),
+                                  options_.canvas_color().g(),
+                                  options_.canvas_color().b());
+    if (canvas_.empty()) {
+      canvas_ = cv::Mat(options_.canvas_height_px(), options_.canvas_width_px(),
+                        CV_8UC3, canvas_color);
+    } else {
+      for (const cv::Rect& region : renderer_->DrawnRegions()) {
+        canvas_(region).setTo(canvas_color);
+      }
+    }
+    image_mat = absl::make_unique<cv::Mat>(canvas_);
   }
 
   return ::mediapipe::OkStatus();
@@ -476,9 +602,9 @@ REGISTER_CALCULATOR(AnnotationOverlayCalculator);
   return ::mediapipe::OkStatus();
 }
 
-::mediapipe::Status AnnotationOverlayCalculator::GlRender(
-    CalculatorContext* cc) {
 #if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
+::mediapipe::Status AnnotationOverlayCalculator::GlRender(
+    CalculatorContext* cc, GLuint program) {
   static const GLfloat square_vertices[] = {
       -1.0f, -1.0f,  // bottom left
       1.0f,  -1.0f,  // bottom right
@@ -493,7 +619,7 @@ REGISTER_CALCULATOR(AnnotationOverlayCalculator);
   };
 
   // program
-  glUseProgram(program_);
+  glUseProgram(program);
 
   // vertex storage
   GLuint vbo[2];
@@ -526,10 +652,10 @@ REGISTER_CALCULATOR(AnnotationOverlayCalculator);
   glBindVertexArray(0);
   glDeleteVertexArrays(1, &vao);
   glDeleteBuffers(2, vbo);
-#endif  // __ANDROID__ or iOS
 
   return ::mediapipe::OkStatus();
 }
+#endif  // __ANDROID__ or iOS
 
 ::mediapipe::Status AnnotationOverlayCalculator::GlSetup(
     CalculatorContext* cc) {
@@ -590,6 +716,67 @@ REGISTER_CALCULATOR(AnnotationOverlayCalculator);
               kAnnotationBackgroundColor[1] / 255.0,
               kAnnotationBackgroundColor[2] / 255.0);
 
+  if (options_.gpu_tessellation()) {
+    mediapipe::GlhCreateProgram(
+        mediapipe::kBasicVertexShader, mediapipe::kBasicTexturedFragmentShader,
+        NUM_ATTRIBUTES, (const GLchar**)&attr_name[0], attr_location,
+        &copy_program_);
+    RET_CHECK(copy_program_) << "Problem initializing the copy program.";
+    glUseProgram(copy_program_);
+    glUniform1i(glGetUniformLocation(copy_program_, "video_frame"), 1);
+
+    // Shaders drawing triangles with a color per vertex, given in pixels.
+    const GLchar* color_vert_src = GLES_VERSION_COMPAT
+        R"(
+  #if __VERSION__ < 130
+    #define in attribute
+    #define out varying
+  #endif  // __VERSION__ < 130
+
+  #ifndef GL_ES
+    #define lowp
+  #endif  // !defined(GL_ES)
+
+    in vec4 position;
+    in lowp vec4 color;
+    uniform vec2 image_size;
+    out lowp vec3 vertex_color;
+
+    void main() {
+      gl_Position = vec4(position.xy / image_size * 2.0 - 1.0, 0.0, 1.0);
+      vertex_color = color.rgb;
+    }
+  )";
+    const GLchar* color_frag_src = GLES_VERSION_COMPAT
+        R"(
+  #if __VERSION__ < 130
+    #define in varying
+  #endif  // __VERSION__ < 130
+
+  #ifdef GL_ES
+    #define fragColor gl_FragColor
+    precision highp float;
+  #else
+    #define lowp
+    out vec4 fragColor;
+  #endif  // defined(GL_ES)
+
+    in lowp vec3 vertex_color;
+
+    void main() {
+      fragColor = vec4(vertex_color, 1.0);
+    }
+  )";
+    const GLchar* color_attr_name[NUM_ATTRIBUTES] = {
+        "position",
+        "color",
+    };
+    mediapipe::GlhCreateProgram(color_vert_src, color_frag_src, NUM_ATTRIBUTES,
+                                (const GLchar**)&color_attr_name[0],
+                                attr_location, &color_program_);
+    RET_CHECK(color_program_) << "Problem initializing the color program.";
+  }
+
   // Init texture for opencv rendered frame.
   const auto& input_frame =
       cc->Inputs().Tag(kInputFrameTagGpu).Get<mediapipe::GpuBuffer>();
@@ -598,6 +785,11 @@ REGISTER_CALCULATOR(AnnotationOverlayCalculator);
       RoundUp(input_frame.width(), ImageFrame::kGlDefaultAlignmentBoundary);
   height_ =
       RoundUp(input_frame.height(), ImageFrame::kGlDefaultAlignmentBoundary);
+  if (color_program_) {
+    glUseProgram(color_program_);
+    glUniform2f(glGetUniformLocation(color_program_, "image_size"), width_,
+                height_);
+  }
   {
     glGenTextures(1, &image_mat_tex_);
     glBindTexture(GL_TEXTURE_2D, image_mat_tex_);
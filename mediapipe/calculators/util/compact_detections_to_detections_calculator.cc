@@ -0,0 +1,80 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/compact_detections.h"
+#include "mediapipe/framework/formats/detection.pb.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+
+namespace mediapipe {
+
+namespace {
+
+constexpr char kDetectionsTag[] = "DETECTIONS";
+constexpr char kCompactDetectionsTag[] = "COMPACT_DETECTIONS";
+
+}  // namespace
+
+// Converts CompactDetections into a vector of Detection protos with
+// RELATIVE_BOUNDING_BOX location data, for calculators and clients that only
+// accept Detection protos.
+//
+// Input:
+//   COMPACT_DETECTIONS: CompactDetections.
+//
+// Output:
+//   DETECTIONS: An std::vector<Detection> holding the same detections.
+//
+// Usage example:
+// node {
+//   calculator: "CompactDetectionsToDetectionsCalculator"
+//   input_stream: "COMPACT_DETECTIONS:compact_detections"
+//   output_stream: "DETECTIONS:detections"
+// }
+class CompactDetectionsToDetectionsCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    RET_CHECK(cc->Inputs().HasTag(kCompactDetectionsTag));
+    RET_CHECK(cc->Outputs().HasTag(kDetectionsTag));
+    cc->Inputs().Tag(kCompactDetectionsTag).Set<CompactDetections>();
+    cc->Outputs().Tag(kDetectionsTag).Set<std::vector<Detection>>();
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    cc->SetOffset(TimestampDiff(0));
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    if (cc->Inputs().Tag(kCompactDetectionsTag).IsEmpty()) {
+      return ::mediapipe::OkStatus();
+    }
+    auto detections = absl::make_unique<std::vector<Detection>>();
+    CompactDetectionsToDetections(
+        cc->Inputs().Tag(kCompactDetectionsTag).Get<CompactDetections>(),
+        detections.get());
+    cc->Outputs()
+        .Tag(kDetectionsTag)
+        .Add(detections.release(), cc->InputTimestamp());
+    return ::mediapipe::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(CompactDetectionsToDetectionsCalculator);
+
+}  // namespace mediapipe
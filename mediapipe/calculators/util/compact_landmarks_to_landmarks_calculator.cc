@@ -0,0 +1,80 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/compact_landmarks.h"
+#include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+
+namespace mediapipe {
+
+namespace {
+
+constexpr char kLandmarksTag[] = "NORM_LANDMARKS";
+constexpr char kCompactLandmarksTag[] = "COMPACT_NORM_LANDMARKS";
+
+}  // namespace
+
+// Converts CompactLandmarks into a vector of NormalizedLandmark protos, for
+// calculators and clients that only accept landmark protos.
+//
+// Input:
+//   COMPACT_NORM_LANDMARKS: CompactLandmarks.
+//
+// Output:
+//   NORM_LANDMARKS: An std::vector<NormalizedLandmark> holding the same
+//                   landmarks.
+//
+// Usage example:
+// node {
+//   calculator: "CompactLandmarksToLandmarksCalculator"
+//   input_stream: "COMPACT_NORM_LANDMARKS:compact_landmarks"
+//   output_stream: "NORM_LANDMARKS:landmarks"
+// }
+class CompactLandmarksToLandmarksCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    RET_CHECK(cc->Inputs().HasTag(kCompactLandmarksTag));
+    RET_CHECK(cc->Outputs().HasTag(kLandmarksTag));
+    cc->Inputs().Tag(kCompactLandmarksTag).Set<CompactLandmarks>();
+    cc->Outputs().Tag(kLandmarksTag).Set<std::vector<NormalizedLandmark>>();
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    cc->SetOffset(TimestampDiff(0));
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    if (cc->Inputs().Tag(kCompactLandmarksTag).IsEmpty()) {
+      return ::mediapipe::OkStatus();
+    }
+    auto landmarks = absl::make_unique<std::vector<NormalizedLandmark>>();
+    CompactLandmarksToNormalizedLandmarks(
+        cc->Inputs().Tag(kCompactLandmarksTag).Get<CompactLandmarks>(),
+        landmarks.get());
+    cc->Outputs()
+        .Tag(kLandmarksTag)
+        .Add(landmarks.release(), cc->InputTimestamp());
+    return ::mediapipe::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(CompactLandmarksToLandmarksCalculator);
+
+}  // namespace mediapipe
@@ -30,6 +30,7 @@
 #include <vector>
 
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/compact_detections.h"
 #include "mediapipe/framework/formats/detection.pb.h"
 #include "mediapipe/framework/formats/location.h"
 #include "mediapipe/framework/port/ret_check.h"
@@ -39,6 +40,7 @@ namespace mediapipe {
 namespace {
 
 constexpr char kDetectionsTag[] = "DETECTIONS";
+constexpr char kCompactDetectionsTag[] = "COMPACT_DETECTIONS";
 constexpr char kLetterboxPaddingTag[] = "LETTERBOX_PADDING";
 
 }  // namespace
@@ -53,6 +55,8 @@ constexpr char kLetterboxPaddingTag[] = "LETTERBOX_PADDING";
 //   DETECTIONS: An std::vector<Detection> representing detections on an
 //   letterboxed image.
 //
+//   COMPACT_DETECTIONS: CompactDetections, as an alternative to DETECTIONS.
+//
 //   LETTERBOX_PADDING: An std::array<float, 4> representing the letterbox
 //   padding from the 4 sides ([left, top, right, bottom]) of the letterboxed
 //   image, normalized to [0.f, 1.f] by the letterboxed image dimensions.
@@ -61,6 +65,9 @@ constexpr char kLetterboxPaddingTag[] = "LETTERBOX_PADDING";
 //   DETECTIONS: An std::vector<Detection> representing detections with their
 //   locations adjusted to the letterbox-removed (non-padded) image.
 //
+//   COMPACT_DETECTIONS: CompactDetections, output instead of DETECTIONS if the
+//   input is CompactDetections.
+//
 // Usage example:
 // node {
 //   calculator: "DetectionLetterboxRemovalCalculator"
@@ -71,15 +78,22 @@ constexpr char kLetterboxPaddingTag[] = "LETTERBOX_PADDING";
 class DetectionLetterboxRemovalCalculator : public CalculatorBase {
  public:
   static ::mediapipe::Status GetContract(CalculatorContract* cc) {
-    RET_CHECK(cc->Inputs().HasTag(kDetectionsTag) &&
-              cc->Inputs().HasTag(kLetterboxPaddingTag))
+    RET_CHECK(cc->Inputs().HasTag(kDetectionsTag) ^
+              cc->Inputs().HasTag(kCompactDetectionsTag))
+        << "Exactly one of DETECTIONS and COMPACT_DETECTIONS must be "
+           "specified.";
+    RET_CHECK(cc->Inputs().HasTag(kLetterboxPaddingTag))
         << "Missing one or more input streams.";
 
-    cc->Inputs().Tag(kDetectionsTag).Set<std::vector<Detection>>();
+    if (cc->Inputs().HasTag(kCompactDetectionsTag)) {
+      cc->Inputs().Tag(kCompactDetectionsTag).Set<CompactDetections>();
+      cc->Outputs().Tag(kCompactDetectionsTag).Set<CompactDetections>();
+    } else {
+      cc->Inputs().Tag(kDetectionsTag).Set<std::vector<Detection>>();
+      cc->Outputs().Tag(kDetectionsTag).Set<std::vector<Detection>>();
+    }
     cc->Inputs().Tag(kLetterboxPaddingTag).Set<std::array<float, 4>>();
 
-    cc->Outputs().Tag(kDetectionsTag).Set<std::vector<Detection>>();
-
     return ::mediapipe::OkStatus();
   }
 
@@ -90,13 +104,20 @@ class DetectionLetterboxRemovalCalculator : public CalculatorBase {
   }
 
   ::mediapipe::Status Process(CalculatorContext* cc) override {
+    if (cc->Inputs().HasTag(kCompactDetectionsTag)) {
+      return ProcessCompactDetections(cc);
+    }
     // Only process if there's input detections.
     if (cc->Inputs().Tag(kDetectionsTag).IsEmpty()) {
       return ::mediapipe::OkStatus();
     }
 
-    const auto& input_detections =
-        cc->Inputs().Tag(kDetectionsTag).Get<std::vector<Detection>>();
+    // The detections are adjusted in place, without a copy if this calculator
+    // is their last reader.
+    ASSIGN_OR_RETURN(auto output_detections,
+                     cc->Inputs()
+                         .Tag(kDetectionsTag)
+                         .ConsumeOrCopy<std::vector<Detection>>());
     const auto& letterbox_padding =
         cc->Inputs().Tag(kLetterboxPaddingTag).Get<std::array<float, 4>>();
 
@@ -105,42 +126,28 @@ class DetectionLetterboxRemovalCalculator : public CalculatorBase {
     const float left_and_right = letterbox_padding[0] + letterbox_padding[2];
     const float top_and_bottom = letterbox_padding[1] + letterbox_padding[3];
 
-    auto output_detections = absl::make_unique<std::vector<Detection>>();
-    for (const auto& detection : input_detections) {
-      Detection new_detection;
-      new_detection.CopyFrom(detection);
+    for (auto& detection : *output_detections) {
       LocationData::RelativeBoundingBox* relative_bbox =
-          new_detection.mutable_location_data()
-              ->mutable_relative_bounding_box();
-
-      relative_bbox->set_xmin(
-          (detection.location_data().relative_bounding_box().xmin() - left) /
-          (1.0f - left_and_right));
-      relative_bbox->set_ymin(
-          (detection.location_data().relative_bounding_box().ymin() - top) /
-          (1.0f - top_and_bottom));
+          detection.mutable_location_data()->mutable_relative_bounding_box();
+
+      relative_bbox->set_xmin((relative_bbox->xmin() - left) /
+                              (1.0f - left_and_right));
+      relative_bbox->set_ymin((relative_bbox->ymin() - top) /
+                              (1.0f - top_and_bottom));
       // The size of the bounding box will change as well.
-      relative_bbox->set_width(
-          detection.location_data().relative_bounding_box().width() /
-          (1.0f - left_and_right));
-      relative_bbox->set_height(
-          detection.location_data().relative_bounding_box().height() /
-          (1.0f - top_and_bottom));
+      relative_bbox->set_width(relative_bbox->width() /
+                               (1.0f - left_and_right));
+      relative_bbox->set_height(relative_bbox->height() /
+                                (1.0f - top_and_bottom));
 
       // Adjust keypoints as well.
-      for (int i = 0;
-           i < new_detection.mutable_location_data()->relative_keypoints_size();
-           ++i) {
-        auto* keypoint =
-            new_detection.mutable_location_data()->mutable_relative_keypoints(
-                i);
-        const float new_x = (keypoint->x() - left) / (1.0f - left_and_right);
-        const float new_y = (keypoint->y() - top) / (1.0f - top_and_bottom);
-        keypoint->set_x(new_x);
-        keypoint->set_y(new_y);
+      for (auto& keypoint :
+           *detection.mutable_location_data()->mutable_relative_keypoints()) {
+        const float new_x = (keypoint.x() - left) / (1.0f - left_and_right);
+        const float new_y = (keypoint.y() - top) / (1.0f - top_and_bottom);
+        keypoint.set_x(new_x);
+        keypoint.set_y(new_y);
       }
-
-      output_detections->emplace_back(new_detection);
     }
 
     cc->Outputs()
@@ -148,6 +155,41 @@ class DetectionLetterboxRemovalCalculator : public CalculatorBase {
         .Add(output_detections.release(), cc->InputTimestamp());
     return ::mediapipe::OkStatus();
   }
+
+ private:
+  // Adjusts the boxes and keypoints of CompactDetections in a single pass
+  // over each array.
+  ::mediapipe::Status ProcessCompactDetections(CalculatorContext* cc) {
+    if (cc->Inputs().Tag(kCompactDetectionsTag).IsEmpty()) {
+      return ::mediapipe::OkStatus();
+    }
+    const auto& letterbox_padding =
+        cc->Inputs().Tag(kLetterboxPaddingTag).Get<std::array<float, 4>>();
+    const float left = letterbox_padding[0];
+    const float top = letterbox_padding[1];
+    const float x_scale =
+        1.0f / (1.0f - letterbox_padding[0] - letterbox_padding[2]);
+    const float y_scale =
+        1.0f / (1.0f - letterbox_padding[1] - letterbox_padding[3]);
+
+    ASSIGN_OR_RETURN(auto output, cc->Inputs()
+                                      .Tag(kCompactDetectionsTag)
+                                      .ConsumeOrCopy<CompactDetections>());
+    for (int i = 0; i < output->size(); ++i) {
+      output->xmin[i] = (output->xmin[i] - left) * x_scale;
+      output->ymin[i] = (output->ymin[i] - top) * y_scale;
+      output->width[i] *= x_scale;
+      output->height[i] *= y_scale;
+    }
+    for (int i = 0; i < output->keypoints.size(); i += 2) {
+      output->keypoints[i] = (output->keypoints[i] - left) * x_scale;
+      output->keypoints[i + 1] = (output->keypoints[i + 1] - top) * y_scale;
+    }
+    cc->Outputs()
+        .Tag(kCompactDetectionsTag)
+        .Add(output.release(), cc->InputTimestamp());
+    return ::mediapipe::OkStatus();
+  }
 };
 REGISTER_CALCULATOR(DetectionLetterboxRemovalCalculator);
 
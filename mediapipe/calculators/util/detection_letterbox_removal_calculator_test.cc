@@ -14,6 +14,7 @@
 
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/formats/compact_detections.h"
 #include "mediapipe/framework/formats/detection.pb.h"
 #include "mediapipe/framework/formats/location.h"
 #include "mediapipe/framework/port/gmock.h"
@@ -155,4 +156,46 @@ TEST(DetectionLetterboxRemovalCalculatorTest, PaddingTopBottom) {
               testing::FloatNear(0.5f, 1e-5));
 }
 
+TEST(DetectionLetterboxRemovalCalculatorTest, CompactDetections) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+    calculator: "DetectionLetterboxRemovalCalculator"
+    input_stream: "COMPACT_DETECTIONS:detections"
+    input_stream: "LETTERBOX_PADDING:letterbox_padding"
+    output_stream: "COMPACT_DETECTIONS:adjusted_detections"
+  )"));
+
+  auto detections = absl::make_unique<CompactDetections>();
+  detections->num_keypoints = 1;
+  const int index = detections->Add(0.25f, 0.25f, 0.25f, 0.25f, 0.3f, 1);
+  detections->MutableKeypoints(index)[0] = 0.5f;
+  detections->MutableKeypoints(index)[1] = 0.5f;
+  runner.MutableInputs()
+      ->Tag("COMPACT_DETECTIONS")
+      .packets.push_back(
+          Adopt(detections.release()).At(Timestamp::PostStream()));
+
+  auto padding = absl::make_unique<std::array<float, 4>>(
+      std::array<float, 4>{0.2f, 0.f, 0.3f, 0.f});
+  runner.MutableInputs()
+      ->Tag("LETTERBOX_PADDING")
+      .packets.push_back(Adopt(padding.release()).At(Timestamp::PostStream()));
+
+  MP_ASSERT_OK(runner.Run()) << "Calculator execution failed.";
+  const std::vector<Packet>& output =
+      runner.Outputs().Tag("COMPACT_DETECTIONS").packets;
+  ASSERT_EQ(1, output.size());
+  const auto& output_detections = output[0].Get<CompactDetections>();
+  ASSERT_EQ(output_detections.size(), 1);
+  EXPECT_EQ(output_detections.label_id[0], 1);
+  EXPECT_EQ(output_detections.score[0], 0.3f);
+  EXPECT_THAT(output_detections.xmin[0], testing::FloatNear(0.1f, 1e-5));
+  EXPECT_THAT(output_detections.ymin[0], testing::FloatNear(0.25f, 1e-5));
+  EXPECT_THAT(output_detections.width[0], testing::FloatNear(0.5f, 1e-5));
+  EXPECT_THAT(output_detections.height[0], testing::FloatNear(0.25f, 1e-5));
+  EXPECT_THAT(output_detections.Keypoints(0)[0],
+              testing::FloatNear(0.6f, 1e-5));
+  EXPECT_THAT(output_detections.Keypoints(0)[1],
+              testing::FloatNear(0.5f, 1e-5));
+}
+
 }  // namespace mediapipe
@@ -0,0 +1,254 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/calculators/util/detection_tracker_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/detection.pb.h"
+#include "mediapipe/framework/formats/location_data.pb.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+
+namespace mediapipe {
+
+namespace {
+
+constexpr char kTickTag[] = "TICK";
+constexpr char kDetectionsTag[] = "DETECTIONS";
+constexpr char kRedetectTag[] = "REDETECT";
+
+bool HasRelativeBox(const Detection& detection) {
+  return detection.location_data().has_relative_bounding_box();
+}
+
+float IntersectionOverUnion(const LocationData::RelativeBoundingBox& box1,
+                            const LocationData::RelativeBoundingBox& box2) {
+  const float x1 = std::max(box1.xmin(), box2.xmin());
+  const float y1 = std::max(box1.ymin(), box2.ymin());
+  const float x2 =
+      std::min(box1.xmin() + box1.width(), box2.xmin() + box2.width());
+  const float y2 =
+      std::min(box1.ymin() + box1.height(), box2.ymin() + box2.height());
+  if (x2 <= x1 || y2 <= y1) return 0.0f;
+  const float intersection = (x2 - x1) * (y2 - y1);
+  const float union_area = box1.width() * box1.height() +
+                           box2.width() * box2.height() - intersection;
+  return union_area > 0.0f ? intersection / union_area : 0.0f;
+}
+
+}  // namespace
+
+// Propagates detections between the frames on which a detector runs, so that
+// the detector can be skipped on most frames. Detections are moved with the
+// constant velocity observed between the last two detector results, and their
+// scores decay on every frame without a detector result.
+//
+// The REDETECT output tells whether the detector should run on the next frame:
+// it is true when redetection_interval frames have passed since the last
+// detector result, when nothing is tracked, or when the score of a tracked
+// detection has dropped below min_score. Fed back through a
+// PreviousLoopbackCalculator into a GateCalculator, it gates the detector
+// input. Only detections with relative bounding boxes move; others are held in
+// place.
+//
+// Inputs:
+//   TICK: Any packet, typically the input frame, at every frame.
+//   DETECTIONS: std::vector<Detection> from the detector, at the frames on
+//     which it ran. The detector graph must propagate timestamp bounds on the
+//     frames it skips, e.g. by setting offsets, so that this calculator does
+//     not wait for them.
+// Outputs:
+//   DETECTIONS: std::vector<Detection> at every frame.
+//   REDETECT (optional): bool, whether to run the detector on the next frame.
+//
+// Example config:
+// node {
+//   calculator: "PreviousLoopbackCalculator"
+//   input_stream: "MAIN:input_video"
+//   input_stream: "LOOP:redetect"
+//   input_stream_info: { tag_index: "LOOP" back_edge: true }
+//   output_stream: "PREV_LOOP:prev_redetect"
+// }
+// node {
+//   calculator: "GateCalculator"
+//   input_stream: "input_video"
+//   input_stream: "ALLOW:prev_redetect"
+//   output_stream: "detector_input_video"
+//   options: {
+//     [mediapipe.GateCalculatorOptions.ext] { empty_packets_as_allow: true }
+//   }
+// }
+// ... detector subgraph from detector_input_video to detections ...
+// node {
+//   calculator: "DetectionTrackerCalculator"
+//   input_stream: "TICK:input_video"
+//   input_stream: "DETECTIONS:detections"
+//   output_stream: "DETECTIONS:tracked_detections"
+//   output_stream: "REDETECT:redetect"
+//   options: {
+//     [mediapipe.DetectionTrackerCalculatorOptions.ext] {
+//       redetection_interval: 5
+//     }
+//   }
+// }
+class DetectionTrackerCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc);
+  ::mediapipe::Status Open(CalculatorContext* cc) override;
+  ::mediapipe::Status Process(CalculatorContext* cc) override;
+
+ private:
+  struct Track {
+    Detection detection;
+    // Box center at the last detector result, in relative coordinates.
+    float detected_center_x = 0.0f;
+    float detected_center_y = 0.0f;
+    // Motion per frame, in relative coordinates.
+    float velocity_x = 0.0f;
+    float velocity_y = 0.0f;
+  };
+
+  // Replaces the tracks with new detector results, matching them with the
+  // current tracks to estimate their velocity.
+  void UpdateTracks(const std::vector<Detection>& detections);
+  // Moves the tracks by one frame.
+  void PropagateTracks();
+  bool ShouldRedetect() const;
+
+  DetectionTrackerCalculatorOptions options_;
+  std::vector<Track> tracks_;
+  int frames_since_detection_ = 0;
+};
+REGISTER_CALCULATOR(DetectionTrackerCalculator);
+
+::mediapipe::Status DetectionTrackerCalculator::GetContract(
+    CalculatorContract* cc) {
+  RET_CHECK(cc->Inputs().HasTag(kTickTag));
+  RET_CHECK(cc->Inputs().HasTag(kDetectionsTag));
+  cc->Inputs().Tag(kTickTag).SetAny();
+  cc->Inputs().Tag(kDetectionsTag).Set<std::vector<Detection>>();
+  cc->Outputs().Tag(kDetectionsTag).Set<std::vector<Detection>>();
+  if (cc->Outputs().HasTag(kRedetectTag)) {
+    cc->Outputs().Tag(kRedetectTag).Set<bool>();
+  }
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status DetectionTrackerCalculator::Open(CalculatorContext* cc) {
+  cc->SetOffset(TimestampDiff(0));
+  options_ = cc->Options<DetectionTrackerCalculatorOptions>();
+  RET_CHECK_GT(options_.redetection_interval(), 0);
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status DetectionTrackerCalculator::Process(CalculatorContext* cc) {
+  if (!cc->Inputs().Tag(kDetectionsTag).IsEmpty()) {
+    UpdateTracks(
+        cc->Inputs().Tag(kDetectionsTag).Get<std::vector<Detection>>());
+    frames_since_detection_ = 0;
+  } else if (!cc->Inputs().Tag(kTickTag).IsEmpty()) {
+    PropagateTracks();
+    ++frames_since_detection_;
+  } else {
+    return ::mediapipe::OkStatus();
+  }
+
+  auto output = absl::make_unique<std::vector<Detection>>();
+  output->reserve(tracks_.size());
+  for (const Track& track : tracks_) {
+    output->push_back(track.detection);
+  }
+  cc->Outputs()
+      .Tag(kDetectionsTag)
+      .Add(output.release(), cc->InputTimestamp());
+  if (cc->Outputs().HasTag(kRedetectTag)) {
+    cc->Outputs()
+        .Tag(kRedetectTag)
+        .AddPacket(MakePacket<bool>(ShouldRedetect()).At(cc->InputTimestamp()));
+  }
+  return ::mediapipe::OkStatus();
+}
+
+void DetectionTrackerCalculator::UpdateTracks(
+    const std::vector<Detection>& detections) {
+  // The number of frames over which the matched tracks have moved.
+  const int frames = frames_since_detection_ + 1;
+  std::vector<Track> new_tracks;
+  new_tracks.reserve(detections.size());
+  for (const Detection& detection : detections) {
+    Track new_track;
+    new_track.detection = detection;
+    if (HasRelativeBox(detection)) {
+      const auto& box = detection.location_data().relative_bounding_box();
+      new_track.detected_center_x = box.xmin() + box.width() / 2;
+      new_track.detected_center_y = box.ymin() + box.height() / 2;
+      const Track* match = nullptr;
+      float best_iou = options_.min_match_iou();
+      for (const Track& track : tracks_) {
+        if (!HasRelativeBox(track.detection)) continue;
+        const float iou = IntersectionOverUnion(
+            box, track.detection.location_data().relative_bounding_box());
+        if (iou >= best_iou) {
+          best_iou = iou;
+          match = &track;
+        }
+      }
+      if (match) {
+        new_track.velocity_x =
+            (new_track.detected_center_x - match->detected_center_x) / frames;
+        new_track.velocity_y =
+            (new_track.detected_center_y - match->detected_center_y) / frames;
+      }
+    }
+    new_tracks.push_back(std::move(new_track));
+  }
+  tracks_ = std::move(new_tracks);
+}
+
+void DetectionTrackerCalculator::PropagateTracks() {
+  for (Track& track : tracks_) {
+    Detection& detection = track.detection;
+    for (int i = 0; i < detection.score_size(); ++i) {
+      detection.set_score(i, detection.score(i) * options_.score_decay());
+    }
+    if (!HasRelativeBox(detection)) continue;
+    LocationData* location_data = detection.mutable_location_data();
+    auto* box = location_data->mutable_relative_bounding_box();
+    box->set_xmin(box->xmin() + track.velocity_x);
+    box->set_ymin(box->ymin() + track.velocity_y);
+    for (auto& keypoint : *location_data->mutable_relative_keypoints()) {
+      keypoint.set_x(keypoint.x() + track.velocity_x);
+      keypoint.set_y(keypoint.y() + track.velocity_y);
+    }
+  }
+}
+
+bool DetectionTrackerCalculator::ShouldRedetect() const {
+  if (tracks_.empty()) return true;
+  if (frames_since_detection_ + 1 >= options_.redetection_interval()) {
+    return true;
+  }
+  for (const Track& track : tracks_) {
+    for (float score : track.detection.score()) {
+      if (score < options_.min_score()) return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,136 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/formats/detection.pb.h"
+#include "mediapipe/framework/formats/location_data.pb.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+Detection DetectionAt(float xmin, float ymin, float score) {
+  Detection detection;
+  detection.add_score(score);
+  LocationData* location_data = detection.mutable_location_data();
+  location_data->set_format(LocationData::RELATIVE_BOUNDING_BOX);
+  auto* box = location_data->mutable_relative_bounding_box();
+  box->set_xmin(xmin);
+  box->set_ymin(ymin);
+  box->set_width(0.4);
+  box->set_height(0.4);
+  return detection;
+}
+
+TEST(DetectionTrackerCalculatorTest, PropagatesDetectionsWithVelocity) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+    calculator: "DetectionTrackerCalculator"
+    input_stream: "TICK:tick"
+    input_stream: "DETECTIONS:detections"
+    output_stream: "DETECTIONS:tracked_detections"
+    output_stream: "REDETECT:redetect"
+    options {
+      [mediapipe.DetectionTrackerCalculatorOptions.ext] {
+        redetection_interval: 3
+        score_decay: 0.5
+        min_score: 0.2
+      }
+    }
+  )"));
+  for (int i = 0; i < 4; ++i) {
+    runner.MutableInputs()->Tag("TICK").packets.push_back(
+        MakePacket<int>(i).At(Timestamp(i)));
+  }
+  runner.MutableInputs()->Tag("DETECTIONS").packets.push_back(
+      MakePacket<std::vector<Detection>>(
+          std::vector<Detection>{DetectionAt(0.1, 0.3, 0.9)})
+          .At(Timestamp(0)));
+  runner.MutableInputs()->Tag("DETECTIONS").packets.push_back(
+      MakePacket<std::vector<Detection>>(
+          std::vector<Detection>{DetectionAt(0.2, 0.3, 0.9)})
+          .At(Timestamp(1)));
+  MP_ASSERT_OK(runner.Run());
+
+  const std::vector<Packet>& detections =
+      runner.Outputs().Tag("DETECTIONS").packets;
+  ASSERT_EQ(4, detections.size());
+  const std::vector<float> expected_xmin = {0.1, 0.2, 0.3, 0.4};
+  const std::vector<float> expected_score = {0.9, 0.9, 0.45, 0.225};
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(Timestamp(i), detections[i].Timestamp());
+    const auto& output = detections[i].Get<std::vector<Detection>>();
+    ASSERT_EQ(1, output.size());
+    const auto& box = output[0].location_data().relative_bounding_box();
+    EXPECT_NEAR(expected_xmin[i], box.xmin(), 1e-5);
+    EXPECT_NEAR(0.3, box.ymin(), 1e-5);
+    EXPECT_NEAR(expected_score[i], output[0].score(0), 1e-5);
+  }
+
+  const std::vector<Packet>& redetect =
+      runner.Outputs().Tag("REDETECT").packets;
+  ASSERT_EQ(4, redetect.size());
+  EXPECT_FALSE(redetect[0].Get<bool>());
+  EXPECT_FALSE(redetect[1].Get<bool>());
+  EXPECT_FALSE(redetect[2].Get<bool>());
+  // The interval is reached on the next frame.
+  EXPECT_TRUE(redetect[3].Get<bool>());
+}
+
+TEST(DetectionTrackerCalculatorTest, RedetectsOnLowScoreAndWhenEmpty) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+    calculator: "DetectionTrackerCalculator"
+    input_stream: "TICK:tick"
+    input_stream: "DETECTIONS:detections"
+    output_stream: "DETECTIONS:tracked_detections"
+    output_stream: "REDETECT:redetect"
+    options {
+      [mediapipe.DetectionTrackerCalculatorOptions.ext] {
+        redetection_interval: 10
+        min_score: 0.5
+      }
+    }
+  )"));
+  runner.MutableInputs()->Tag("TICK").packets.push_back(
+      MakePacket<int>(0).At(Timestamp(0)));
+  runner.MutableInputs()->Tag("TICK").packets.push_back(
+      MakePacket<int>(1).At(Timestamp(1)));
+  runner.MutableInputs()->Tag("DETECTIONS").packets.push_back(
+      MakePacket<std::vector<Detection>>(
+          std::vector<Detection>{DetectionAt(0.1, 0.3, 0.4)})
+          .At(Timestamp(0)));
+  runner.MutableInputs()->Tag("DETECTIONS").packets.push_back(
+      MakePacket<std::vector<Detection>>(std::vector<Detection>())
+          .At(Timestamp(1)));
+  MP_ASSERT_OK(runner.Run());
+
+  const std::vector<Packet>& redetect =
+      runner.Outputs().Tag("REDETECT").packets;
+  ASSERT_EQ(2, redetect.size());
+  EXPECT_TRUE(redetect[0].Get<bool>());
+  EXPECT_TRUE(redetect[1].Get<bool>());
+  EXPECT_TRUE(runner.Outputs()
+                  .Tag("DETECTIONS")
+                  .packets[1]
+                  .Get<std::vector<Detection>>()
+                  .empty());
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,81 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/compact_detections.h"
+#include "mediapipe/framework/formats/detection.pb.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+
+namespace mediapipe {
+
+namespace {
+
+constexpr char kDetectionsTag[] = "DETECTIONS";
+constexpr char kCompactDetectionsTag[] = "COMPACT_DETECTIONS";
+
+}  // namespace
+
+// Converts a vector of Detection protos into CompactDetections, which the
+// detection calculators accept on their COMPACT_DETECTIONS streams. Only the
+// top scoring label id of each detection is kept. The detections must have
+// relative bounding boxes and the same number of keypoints.
+//
+// Input:
+//   DETECTIONS: An std::vector<Detection>.
+//
+// Output:
+//   COMPACT_DETECTIONS: CompactDetections holding the same detections.
+//
+// Usage example:
+// node {
+//   calculator: "DetectionsToCompactDetectionsCalculator"
+//   input_stream: "DETECTIONS:detections"
+//   output_stream: "COMPACT_DETECTIONS:compact_detections"
+// }
+class DetectionsToCompactDetectionsCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    RET_CHECK(cc->Inputs().HasTag(kDetectionsTag));
+    RET_CHECK(cc->Outputs().HasTag(kCompactDetectionsTag));
+    cc->Inputs().Tag(kDetectionsTag).Set<std::vector<Detection>>();
+    cc->Outputs().Tag(kCompactDetectionsTag).Set<CompactDetections>();
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    cc->SetOffset(TimestampDiff(0));
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    if (cc->Inputs().Tag(kDetectionsTag).IsEmpty()) {
+      return ::mediapipe::OkStatus();
+    }
+    auto compact_detections = absl::make_unique<CompactDetections>();
+    MP_RETURN_IF_ERROR(DetectionsToCompactDetections(
+        cc->Inputs().Tag(kDetectionsTag).Get<std::vector<Detection>>(),
+        compact_detections.get()));
+    cc->Outputs()
+        .Tag(kCompactDetectionsTag)
+        .Add(compact_detections.release(), cc->InputTimestamp());
+    return ::mediapipe::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(DetectionsToCompactDetectionsCalculator);
+
+}  // namespace mediapipe
@@ -11,16 +11,22 @@
 // WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 // See the License for the specific language governing permissions and
 // limitations under the License.
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <string>
 
 #include "mediapipe/calculators/util/detections_to_rects_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_options.pb.h"
+#include "mediapipe/framework/formats/compact_detections.h"
 #include "mediapipe/framework/formats/detection.pb.h"
 #include "mediapipe/framework/formats/location_data.pb.h"
 #include "mediapipe/framework/formats/rect.pb.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/tool/calculator_fusion.h"
+#include "mediapipe/framework/tool/validate_name.h"
 
 namespace mediapipe {
 
@@ -30,7 +36,9 @@ namespace {
 
 constexpr char kDetectionTag[] = "DETECTION";
 constexpr char kDetectionsTag[] = "DETECTIONS";
+constexpr char kCompactDetectionsTag[] = "COMPACT_DETECTIONS";
 constexpr char kImageSizeTag[] = "IMAGE_SIZE";
+constexpr char kLetterboxPaddingTag[] = "LETTERBOX_PADDING";
 constexpr char kRectTag[] = "RECT";
 constexpr char kNormRectTag[] = "NORM_RECT";
 constexpr char kRectsTag[] = "RECTS";
@@ -63,11 +71,64 @@ constexpr char kNormRectsTag[] = "NORM_RECTS";
   return ::mediapipe::OkStatus();
 }
 
+// Sets "rect" to the bounding box of detection "index" of "detections".
+void DetectionToNormalizedRect(const CompactDetections& detections, int index,
+                               NormalizedRect* rect) {
+  rect->set_x_center(detections.xmin[index] + detections.width[index] / 2);
+  rect->set_y_center(detections.ymin[index] + detections.height[index] / 2);
+  rect->set_width(detections.width[index]);
+  rect->set_height(detections.height[index]);
+}
+
 // Wraps around an angle in radians to within -M_PI and M_PI.
 inline float NormalizeRadians(float angle) {
   return angle - 2 * M_PI * std::floor((angle - (-M_PI)) / (2 * M_PI));
 }
 
+// Fuses a DetectionLetterboxRemovalCalculator into the
+// DetectionsToRectsCalculator reading its detections, which then removes the
+// letterbox from the rects it outputs rather than from every detection.
+bool FuseLetterboxRemoval(const CalculatorGraphConfig::Node& producer,
+                          const CalculatorGraphConfig::Node& consumer,
+                          CalculatorGraphConfig::Node* fused) {
+  // The letterbox removal only adjusts relative coordinates.
+  bool normalized_output = false;
+  for (const auto& output_stream : consumer.output_stream()) {
+    std::string tag, name;
+    if (!tool::ParseTagAndName(output_stream, &tag, &name).ok()) {
+      return false;
+    }
+    normalized_output |= tag == kNormRectTag || tag == kNormRectsTag;
+  }
+  std::string detections_tag, detections_name;
+  if (!normalized_output ||
+      !tool::ParseTagAndName(producer.output_stream(0), &detections_tag,
+                             &detections_name)
+           .ok()) {
+    return false;
+  }
+
+  *fused = consumer;
+  fused->clear_input_stream();
+  for (const auto& input_stream : consumer.input_stream()) {
+    std::string tag, name;
+    if (!tool::ParseTagAndName(input_stream, &tag, &name).ok() ||
+        tag == kLetterboxPaddingTag) {
+      return false;
+    }
+    if (name != detections_name) {
+      fused->add_input_stream(input_stream);
+    } else if (tag != detections_tag) {
+      return false;
+    }
+  }
+  // Read the detections and the padding of the letterbox removal instead.
+  for (const auto& input_stream : producer.input_stream()) {
+    fused->add_input_stream(input_stream);
+  }
+  return true;
+}
+
 }  // namespace
 
 // A calculator that converts Detection proto to Rect proto.
@@ -89,11 +150,19 @@ inline float NormalizeRadians(float angle) {
 // One of the following:
 // DETECTION: A Detection proto.
 // DETECTIONS: An std::vector<Detection>.
+// COMPACT_DETECTIONS: CompactDetections, which only have relative bounding
+//   boxes and so can only be converted to NORM_RECT or NORM_RECTS.
 //
 // IMAGE_SIZE (optional): A std::pair<int, int> represention image width and
 //   height. This is required only when rotation needs to be computed (see
 //   calculator options).
 //
+// LETTERBOX_PADDING (optional): A std::array<float, 4> with the letterbox
+//   padding of the detections, as for DetectionLetterboxRemovalCalculator. The
+//   letterbox is then removed from the NORM_RECT or NORM_RECTS output. This
+//   input is added when a DetectionLetterboxRemovalCalculator is fused into
+//   this calculator by CalculatorGraphConfig.fuse_calculators.
+//
 // Output:
 // One of the following:
 // RECT: A Rect proto.
@@ -124,8 +193,19 @@ class DetectionsToRectsCalculator : public CalculatorBase {
   ::mediapipe::Status Process(CalculatorContext* cc) override;
 
  private:
+  ::mediapipe::Status ProcessCompactDetections(
+      CalculatorContext* cc, const std::pair<int, int>& image_size);
+  // Outputs a zero RECT or NORM_RECT, if requested for empty detections.
+  void AddZeroRect(CalculatorContext* cc);
   float ComputeRotation(const Detection& detection,
                         const std::pair<int, int> image_size);
+  float ComputeRotation(const CompactDetections& detections, int index,
+                        const std::pair<int, int> image_size);
+  // Returns the rotation of the vector between two relative keypoints.
+  float ComputeRotation(float x0, float y0, float x1, float y1,
+                        const std::pair<int, int> image_size);
+  // Maps "rect" from the letterboxed image to the image without letterbox.
+  void RemoveLetterbox(NormalizedRect* rect);
 
   DetectionsToRectsCalculatorOptions options_;
   int start_keypoint_index_;
@@ -133,15 +213,29 @@ class DetectionsToRectsCalculator : public CalculatorBase {
   float target_angle_;  // In radians.
   bool rotate_;
   bool output_zero_rect_for_empty_detections_;
+  // The letterbox removal of the current input, which maps a relative
+  // coordinate x to (x - left) * x_scale.
+  float letterbox_left_ = 0.0f;
+  float letterbox_top_ = 0.0f;
+  float letterbox_x_scale_ = 1.0f;
+  float letterbox_y_scale_ = 1.0f;
 };
 REGISTER_CALCULATOR(DetectionsToRectsCalculator);
+REGISTER_CALCULATOR_FUSION(DetectionLetterboxRemovalCalculator,
+                           DetectionsToRectsCalculator, FuseLetterboxRemoval);
 
 ::mediapipe::Status DetectionsToRectsCalculator::GetContract(
     CalculatorContract* cc) {
-  RET_CHECK(cc->Inputs().HasTag(kDetectionTag) ^
-            cc->Inputs().HasTag(kDetectionsTag))
-      << "Exactly one of DETECTION or DETECTIONS input stream should be "
-         "provided.";
+  RET_CHECK_EQ((cc->Inputs().HasTag(kDetectionTag) ? 1 : 0) +
+                   (cc->Inputs().HasTag(kDetectionsTag) ? 1 : 0) +
+                   (cc->Inputs().HasTag(kCompactDetectionsTag) ? 1 : 0),
+               1)
+      << "Exactly one of DETECTION, DETECTIONS or COMPACT_DETECTIONS input "
+         "stream should be provided.";
+  RET_CHECK(!cc->Inputs().HasTag(kCompactDetectionsTag) ||
+            cc->Outputs().HasTag(kNormRectTag) ||
+            cc->Outputs().HasTag(kNormRectsTag))
+      << "COMPACT_DETECTIONS can only be converted to NORM_RECT or NORM_RECTS.";
   RET_CHECK_EQ((cc->Outputs().HasTag(kNormRectTag) ? 1 : 0) +
                    (cc->Outputs().HasTag(kRectTag) ? 1 : 0) +
                    (cc->Outputs().HasTag(kNormRectsTag) ? 1 : 0) +
@@ -156,9 +250,18 @@ REGISTER_CALCULATOR(DetectionsToRectsCalculator);
   if (cc->Inputs().HasTag(kDetectionsTag)) {
     cc->Inputs().Tag(kDetectionsTag).Set<std::vector<Detection>>();
   }
+  if (cc->Inputs().HasTag(kCompactDetectionsTag)) {
+    cc->Inputs().Tag(kCompactDetectionsTag).Set<CompactDetections>();
+  }
   if (cc->Inputs().HasTag(kImageSizeTag)) {
     cc->Inputs().Tag(kImageSizeTag).Set<std::pair<int, int>>();
   }
+  if (cc->Inputs().HasTag(kLetterboxPaddingTag)) {
+    RET_CHECK(cc->Outputs().HasTag(kNormRectTag) ||
+              cc->Outputs().HasTag(kNormRectsTag))
+        << "LETTERBOX_PADDING requires a NORM_RECT or NORM_RECTS output.";
+    cc->Inputs().Tag(kLetterboxPaddingTag).Set<std::array<float, 4>>();
+  }
 
   if (cc->Outputs().HasTag(kRectTag)) {
     cc->Outputs().Tag(kRectTag).Set<Rect>();
@@ -214,6 +317,30 @@ REGISTER_CALCULATOR(DetectionsToRectsCalculator);
       cc->Inputs().Tag(kDetectionsTag).IsEmpty()) {
     return ::mediapipe::OkStatus();
   }
+  if (cc->Inputs().HasTag(kCompactDetectionsTag) &&
+      cc->Inputs().Tag(kCompactDetectionsTag).IsEmpty()) {
+    return ::mediapipe::OkStatus();
+  }
+
+  std::pair<int, int> image_size;
+  if (rotate_) {
+    RET_CHECK(!cc->Inputs().Tag(kImageSizeTag).IsEmpty());
+    image_size = cc->Inputs().Tag(kImageSizeTag).Get<std::pair<int, int>>();
+  }
+  if (cc->Inputs().HasTag(kLetterboxPaddingTag)) {
+    RET_CHECK(!cc->Inputs().Tag(kLetterboxPaddingTag).IsEmpty());
+    const auto& letterbox_padding =
+        cc->Inputs().Tag(kLetterboxPaddingTag).Get<std::array<float, 4>>();
+    letterbox_left_ = letterbox_padding[0];
+    letterbox_top_ = letterbox_padding[1];
+    letterbox_x_scale_ =
+        1.0f / (1.0f - letterbox_padding[0] - letterbox_padding[2]);
+    letterbox_y_scale_ =
+        1.0f / (1.0f - letterbox_padding[1] - letterbox_padding[3]);
+  }
+  if (cc->Inputs().HasTag(kCompactDetectionsTag)) {
+    return ProcessCompactDetections(cc, image_size);
+  }
 
   std::vector<Detection> detections;
   if (cc->Inputs().HasTag(kDetectionTag)) {
@@ -222,27 +349,11 @@ REGISTER_CALCULATOR(DetectionsToRectsCalculator);
   if (cc->Inputs().HasTag(kDetectionsTag)) {
     detections = cc->Inputs().Tag(kDetectionsTag).Get<std::vector<Detection>>();
     if (detections.empty()) {
-      if (output_zero_rect_for_empty_detections_) {
-        if (cc->Outputs().HasTag(kRectTag)) {
-          cc->Outputs().Tag(kRectTag).AddPacket(
-              MakePacket<Rect>().At(cc->InputTimestamp()));
-        }
-        if (cc->Outputs().HasTag(kNormRectTag)) {
-          cc->Outputs()
-              .Tag(kNormRectTag)
-              .AddPacket(MakePacket<NormalizedRect>().At(cc->InputTimestamp()));
-        }
-      }
+      AddZeroRect(cc);
       return ::mediapipe::OkStatus();
     }
   }
 
-  std::pair<int, int> image_size;
-  if (rotate_) {
-    RET_CHECK(!cc->Inputs().Tag(kImageSizeTag).IsEmpty());
-    image_size = cc->Inputs().Tag(kImageSizeTag).Get<std::pair<int, int>>();
-  }
-
   if (cc->Outputs().HasTag(kRectTag)) {
     auto output_rect = absl::make_unique<Rect>();
     MP_RETURN_IF_ERROR(DetectionToRect(detections[0], output_rect.get()));
@@ -256,6 +367,7 @@ REGISTER_CALCULATOR(DetectionsToRectsCalculator);
     auto output_rect = absl::make_unique<NormalizedRect>();
     MP_RETURN_IF_ERROR(
         DetectionToNormalizedRect(detections[0], output_rect.get()));
+    RemoveLetterbox(output_rect.get());
     if (rotate_) {
       output_rect->set_rotation(ComputeRotation(detections[0], image_size));
     }
@@ -282,6 +394,7 @@ REGISTER_CALCULATOR(DetectionsToRectsCalculator);
     for (int i = 0; i < detections.size(); ++i) {
       MP_RETURN_IF_ERROR(
           DetectionToNormalizedRect(detections[i], &(output_rects->at(i))));
+      RemoveLetterbox(&(output_rects->at(i)));
       if (rotate_) {
         output_rects->at(i).set_rotation(
             ComputeRotation(detections[i], image_size));
@@ -295,21 +408,98 @@ REGISTER_CALCULATOR(DetectionsToRectsCalculator);
   return ::mediapipe::OkStatus();
 }
 
+::mediapipe::Status DetectionsToRectsCalculator::ProcessCompactDetections(
+    CalculatorContext* cc, const std::pair<int, int>& image_size) {
+  const auto& detections =
+      cc->Inputs().Tag(kCompactDetectionsTag).Get<CompactDetections>();
+  if (detections.empty()) {
+    AddZeroRect(cc);
+    return ::mediapipe::OkStatus();
+  }
+  if (rotate_) {
+    RET_CHECK_LT(std::max(start_keypoint_index_, end_keypoint_index_),
+                 detections.num_keypoints);
+  }
+  if (cc->Outputs().HasTag(kNormRectTag)) {
+    auto output_rect = absl::make_unique<NormalizedRect>();
+    DetectionToNormalizedRect(detections, 0, output_rect.get());
+    RemoveLetterbox(output_rect.get());
+    if (rotate_) {
+      output_rect->set_rotation(ComputeRotation(detections, 0, image_size));
+    }
+    cc->Outputs()
+        .Tag(kNormRectTag)
+        .Add(output_rect.release(), cc->InputTimestamp());
+  }
+  if (cc->Outputs().HasTag(kNormRectsTag)) {
+    auto output_rects =
+        absl::make_unique<std::vector<NormalizedRect>>(detections.size());
+    for (int i = 0; i < detections.size(); ++i) {
+      DetectionToNormalizedRect(detections, i, &(*output_rects)[i]);
+      RemoveLetterbox(&(*output_rects)[i]);
+      if (rotate_) {
+        (*output_rects)[i].set_rotation(
+            ComputeRotation(detections, i, image_size));
+      }
+    }
+    cc->Outputs()
+        .Tag(kNormRectsTag)
+        .Add(output_rects.release(), cc->InputTimestamp());
+  }
+  return ::mediapipe::OkStatus();
+}
+
+void DetectionsToRectsCalculator::AddZeroRect(CalculatorContext* cc) {
+  if (!output_zero_rect_for_empty_detections_) {
+    return;
+  }
+  if (cc->Outputs().HasTag(kRectTag)) {
+    cc->Outputs().Tag(kRectTag).AddPacket(
+        MakePacket<Rect>().At(cc->InputTimestamp()));
+  }
+  if (cc->Outputs().HasTag(kNormRectTag)) {
+    cc->Outputs()
+        .Tag(kNormRectTag)
+        .AddPacket(MakePacket<NormalizedRect>().At(cc->InputTimestamp()));
+  }
+}
+
 float DetectionsToRectsCalculator::ComputeRotation(
     const Detection& detection, const std::pair<int, int> image_size) {
   const auto& location_data = detection.location_data();
-  const float x0 = location_data.relative_keypoints(start_keypoint_index_).x() *
-                   image_size.first;
-  const float y0 = location_data.relative_keypoints(start_keypoint_index_).y() *
-                   image_size.second;
-  const float x1 = location_data.relative_keypoints(end_keypoint_index_).x() *
-                   image_size.first;
-  const float y1 = location_data.relative_keypoints(end_keypoint_index_).y() *
-                   image_size.second;
+  const auto& start = location_data.relative_keypoints(start_keypoint_index_);
+  const auto& end = location_data.relative_keypoints(end_keypoint_index_);
+  return ComputeRotation(start.x(), start.y(), end.x(), end.y(), image_size);
+}
+
+float DetectionsToRectsCalculator::ComputeRotation(
+    const CompactDetections& detections, int index,
+    const std::pair<int, int> image_size) {
+  const float* keypoints = detections.Keypoints(index);
+  return ComputeRotation(keypoints[2 * start_keypoint_index_],
+                         keypoints[2 * start_keypoint_index_ + 1],
+                         keypoints[2 * end_keypoint_index_],
+                         keypoints[2 * end_keypoint_index_ + 1], image_size);
+}
+
+float DetectionsToRectsCalculator::ComputeRotation(
+    float x0, float y0, float x1, float y1,
+    const std::pair<int, int> image_size) {
+  x0 = (x0 - letterbox_left_) * letterbox_x_scale_ * image_size.first;
+  y0 = (y0 - letterbox_top_) * letterbox_y_scale_ * image_size.second;
+  x1 = (x1 - letterbox_left_) * letterbox_x_scale_ * image_size.first;
+  y1 = (y1 - letterbox_top_) * letterbox_y_scale_ * image_size.second;
 
   float rotation = target_angle_ - std::atan2(-(y1 - y0), x1 - x0);
 
   return NormalizeRadians(rotation);
 }
 
+void DetectionsToRectsCalculator::RemoveLetterbox(NormalizedRect* rect) {
+  rect->set_x_center((rect->x_center() - letterbox_left_) * letterbox_x_scale_);
+  rect->set_y_center((rect->y_center() - letterbox_top_) * letterbox_y_scale_);
+  rect->set_width(rect->width() * letterbox_x_scale_);
+  rect->set_height(rect->height() * letterbox_y_scale_);
+}
+
 }  // namespace mediapipe
@@ -12,10 +12,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <array>
+
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_runner.h"
 #include "mediapipe/framework/deps/message_matchers.h"
+#include "mediapipe/framework/formats/compact_detections.h"
 #include "mediapipe/framework/formats/detection.pb.h"
 #include "mediapipe/framework/formats/location_data.pb.h"
 #include "mediapipe/framework/formats/rect.pb.h"
@@ -216,6 +219,38 @@ TEST(DetectionsToRectsCalculatorTest, DetectionsToNormalizedRects) {
   EXPECT_FLOAT_EQ(rects[1].y_center(), 0.55);
 }
 
+TEST(DetectionsToRectsCalculatorTest, CompactDetectionsToNormalizedRects) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+    calculator: "DetectionsToRectsCalculator"
+    input_stream: "COMPACT_DETECTIONS:detections"
+    output_stream: "NORM_RECTS:rect"
+  )"));
+
+  auto detections = absl::make_unique<CompactDetections>();
+  detections->Add(0.1, 0.2, 0.3, 0.4, /*score=*/1.0, /*label_id=*/0);
+  detections->Add(0.2, 0.3, 0.4, 0.5, /*score=*/1.0, /*label_id=*/0);
+
+  runner.MutableInputs()
+      ->Tag("COMPACT_DETECTIONS")
+      .packets.push_back(
+          Adopt(detections.release()).At(Timestamp::PostStream()));
+
+  MP_ASSERT_OK(runner.Run()) << "Calculator execution failed.";
+  const std::vector<Packet>& output =
+      runner.Outputs().Tag("NORM_RECTS").packets;
+  ASSERT_EQ(1, output.size());
+  const auto& rects = output[0].Get<std::vector<NormalizedRect>>();
+  EXPECT_EQ(rects.size(), 2);
+  EXPECT_FLOAT_EQ(rects[0].width(), 0.3);
+  EXPECT_FLOAT_EQ(rects[0].height(), 0.4);
+  EXPECT_FLOAT_EQ(rects[0].x_center(), 0.25);
+  EXPECT_FLOAT_EQ(rects[0].y_center(), 0.4);
+  EXPECT_FLOAT_EQ(rects[1].width(), 0.4);
+  EXPECT_FLOAT_EQ(rects[1].height(), 0.5);
+  EXPECT_FLOAT_EQ(rects[1].x_center(), 0.4);
+  EXPECT_FLOAT_EQ(rects[1].y_center(), 0.55);
+}
+
 TEST(DetectionsToRectsCalculatorTest, DetectionToRects) {
   CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
     calculator: "DetectionsToRectsCalculator"
@@ -269,6 +304,38 @@ TEST(DetectionsToRectsCalculatorTest, DetectionToNormalizedRects) {
   EXPECT_FLOAT_EQ(rects[0].y_center(), 0.4);
 }
 
+TEST(DetectionsToRectsCalculatorTest, RemovesLetterboxFromNormalizedRect) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+    calculator: "DetectionsToRectsCalculator"
+    input_stream: "DETECTIONS:detections"
+    input_stream: "LETTERBOX_PADDING:letterbox_padding"
+    output_stream: "NORM_RECT:rect"
+  )"));
+
+  auto detections(absl::make_unique<std::vector<Detection>>());
+  detections->push_back(
+      DetectionWithRelativeLocationData(0.25, 0.25, 0.5, 0.5));
+  auto padding = absl::make_unique<std::array<float, 4>>(
+      std::array<float, 4>{0.1f, 0.2f, 0.1f, 0.2f});
+
+  runner.MutableInputs()
+      ->Tag("DETECTIONS")
+      .packets.push_back(
+          Adopt(detections.release()).At(Timestamp::PostStream()));
+  runner.MutableInputs()
+      ->Tag("LETTERBOX_PADDING")
+      .packets.push_back(Adopt(padding.release()).At(Timestamp::PostStream()));
+
+  MP_ASSERT_OK(runner.Run()) << "Calculator execution failed.";
+  const std::vector<Packet>& output = runner.Outputs().Tag("NORM_RECT").packets;
+  ASSERT_EQ(1, output.size());
+  const auto& rect = output[0].Get<NormalizedRect>();
+  EXPECT_THAT(rect.x_center(), testing::FloatNear(0.5, 1e-5));
+  EXPECT_THAT(rect.y_center(), testing::FloatNear(0.5, 1e-5));
+  EXPECT_THAT(rect.width(), testing::FloatNear(0.625, 1e-5));
+  EXPECT_THAT(rect.height(), testing::FloatNear(0.5 / 0.6, 1e-5));
+}
+
 TEST(DetectionsToRectsCalculatorTest, WrongInputToRect) {
   CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
     calculator: "DetectionsToRectsCalculator"
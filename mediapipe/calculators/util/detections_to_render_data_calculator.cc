@@ -18,6 +18,7 @@
 #include "mediapipe/calculators/util/detections_to_render_data_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_options.pb.h"
+#include "mediapipe/framework/formats/compact_detections.h"
 #include "mediapipe/framework/formats/detection.pb.h"
 #include "mediapipe/framework/formats/location_data.pb.h"
 #include "mediapipe/framework/port/ret_check.h"
@@ -29,6 +30,7 @@ namespace {
 
 constexpr char kDetectionsTag[] = "DETECTIONS";
 constexpr char kDetectionListTag[] = "DETECTION_LIST";
+constexpr char kCompactDetectionsTag[] = "COMPACT_DETECTIONS";
 constexpr char kRenderDataTag[] = "RENDER_DATA";
 
 constexpr char kSceneLabelLabel[] = "LABEL";
@@ -40,13 +42,22 @@ constexpr char kKeypointLabel[] = "KEYPOINT";
 // box.
 constexpr double kLabelToBoundingBoxRatio = 0.1;
 
+// The batched annotations shared by the detections of one packet, added to the
+// render data when first needed.
+struct BatchedLocations {
+  RenderAnnotation* rectangles = nullptr;
+  RenderAnnotation* relative_rectangles = nullptr;
+  RenderAnnotation* keypoints = nullptr;
+};
+
 }  // namespace
 
 // A calculator that converts Detection proto to RenderData proto for
 // visualization.
 //
 // Detection is the format for encoding one or more detections in an image.
-// The input can be std::vector<Detection> or DetectionList.
+// The input can be std::vector<Detection>, DetectionList or
+// CompactDetections.
 //
 // Please note that only Location Data formats of BOUNDING_BOX and
 // RELATIVE_BOUNDING_BOX are supported. Normalized coordinates for
@@ -111,17 +122,31 @@ class DetectionsToRenderDataCalculator : public CalculatorBase {
       const Detection& detection,
       const DetectionsToRenderDataCalculatorOptions& options,
       RenderData* render_data);
+  // Adds the bounding box and the keypoints of the detection to the batched
+  // annotations.
+  static void AddBatchedLocationData(
+      const Detection& detection,
+      const DetectionsToRenderDataCalculatorOptions& options,
+      BatchedLocations* batched, RenderData* render_data);
+  // Returns "*annotation", after setting it to a new annotation if null.
+  static RenderAnnotation* GetOrAddBatchedAnnotation(
+      const char* scene_tag,
+      const DetectionsToRenderDataCalculatorOptions& options,
+      RenderAnnotation** annotation, RenderData* render_data);
+  // Adds the detection to the render data, with its location in "batched"
+  // unless it is null.
   static void AddDetectionToRenderData(
       const Detection& detection,
       const DetectionsToRenderDataCalculatorOptions& options,
-      RenderData* render_data);
+      BatchedLocations* batched, RenderData* render_data);
 };
 REGISTER_CALCULATOR(DetectionsToRenderDataCalculator);
 
 ::mediapipe::Status DetectionsToRenderDataCalculator::GetContract(
     CalculatorContract* cc) {
   RET_CHECK(cc->Inputs().HasTag(kDetectionListTag) ||
-            cc->Inputs().HasTag(kDetectionsTag))
+            cc->Inputs().HasTag(kDetectionsTag) ||
+            cc->Inputs().HasTag(kCompactDetectionsTag))
       << "None of the input streams are provided.";
 
   if (cc->Inputs().HasTag(kDetectionListTag)) {
@@ -130,6 +155,9 @@ REGISTER_CALCULATOR(DetectionsToRenderDataCalculator);
   if (cc->Inputs().HasTag(kDetectionsTag)) {
     cc->Inputs().Tag(kDetectionsTag).Set<std::vector<Detection>>();
   }
+  if (cc->Inputs().HasTag(kCompactDetectionsTag)) {
+    cc->Inputs().Tag(kCompactDetectionsTag).Set<CompactDetections>();
+  }
   cc->Outputs().Tag(kRenderDataTag).Set<RenderData>();
   return ::mediapipe::OkStatus();
 }
@@ -153,8 +181,14 @@ REGISTER_CALCULATOR(DetectionsToRenderDataCalculator);
   const bool has_detection_from_vector =
       cc->Inputs().HasTag(kDetectionsTag) &&
       !cc->Inputs().Tag(kDetectionsTag).Get<std::vector<Detection>>().empty();
+  const bool has_compact_detections =
+      cc->Inputs().HasTag(kCompactDetectionsTag) &&
+      !cc->Inputs()
+           .Tag(kCompactDetectionsTag)
+           .Get<CompactDetections>()
+           .empty();
   if (!options.produce_empty_packet() && !has_detection_from_list &&
-      !has_detection_from_vector) {
+      !has_detection_from_vector && !has_compact_detections) {
     return ::mediapipe::OkStatus();
   }
 
@@ -162,16 +196,30 @@ REGISTER_CALCULATOR(DetectionsToRenderDataCalculator);
   // DetectionsToRenderDataCalculatorOptions.
   auto render_data = absl::make_unique<RenderData>();
   render_data->set_scene_class(options.scene_class());
+  BatchedLocations batched_locations;
+  BatchedLocations* batched =
+      options.batch_annotations() ? &batched_locations : nullptr;
   if (has_detection_from_list) {
     for (const auto& detection :
          cc->Inputs().Tag(kDetectionListTag).Get<DetectionList>().detection()) {
-      AddDetectionToRenderData(detection, options, render_data.get());
+      AddDetectionToRenderData(detection, options, batched, render_data.get());
     }
   }
   if (has_detection_from_vector) {
     for (const auto& detection :
          cc->Inputs().Tag(kDetectionsTag).Get<std::vector<Detection>>()) {
-      AddDetectionToRenderData(detection, options, render_data.get());
+      AddDetectionToRenderData(detection, options, batched, render_data.get());
+    }
+  }
+  if (has_compact_detections) {
+    // The render data is made of protos anyway, so the detections are
+    // rendered through the same Detection protos.
+    std::vector<Detection> detections;
+    CompactDetectionsToDetections(
+        cc->Inputs().Tag(kCompactDetectionsTag).Get<CompactDetections>(),
+        &detections);
+    for (const auto& detection : detections) {
+      AddDetectionToRenderData(detection, options, batched, render_data.get());
     }
   }
   cc->Outputs()
@@ -336,10 +384,68 @@ void DetectionsToRenderDataCalculator::AddLocationData(
   }
 }
 
+RenderAnnotation* DetectionsToRenderDataCalculator::GetOrAddBatchedAnnotation(
+    const char* scene_tag,
+    const DetectionsToRenderDataCalculatorOptions& options,
+    RenderAnnotation** annotation, RenderData* render_data) {
+  if (*annotation == nullptr) {
+    *annotation = render_data->add_render_annotations();
+    (*annotation)->set_scene_tag(scene_tag);
+    SetRenderAnnotationColorThickness(options, *annotation);
+  }
+  return *annotation;
+}
+
+void DetectionsToRenderDataCalculator::AddBatchedLocationData(
+    const Detection& detection,
+    const DetectionsToRenderDataCalculatorOptions& options,
+    BatchedLocations* batched, RenderData* render_data) {
+  const auto& location_data = detection.location_data();
+  const bool normalized = location_data.format() != LocationData::BOUNDING_BOX;
+  RenderAnnotation::Rectangle rect;
+  if (normalized) {
+    SetRectCoordinate(true, location_data.relative_bounding_box().xmin(),
+                      location_data.relative_bounding_box().ymin(),
+                      location_data.relative_bounding_box().width(),
+                      location_data.relative_bounding_box().height(), &rect);
+  } else {
+    SetRectCoordinate(false, location_data.bounding_box().xmin(),
+                      location_data.bounding_box().ymin(),
+                      location_data.bounding_box().width(),
+                      location_data.bounding_box().height(), &rect);
+  }
+  // SetRectCoordinate() leaves the rectangle unset if it is out of the image.
+  if (rect.has_left()) {
+    auto* rectangles =
+        GetOrAddBatchedAnnotation(kSceneLocationLabel, options,
+                                  normalized ? &batched->relative_rectangles
+                                             : &batched->rectangles,
+                                  render_data)
+            ->mutable_rectangles();
+    rectangles->set_normalized(normalized);
+    rectangles->add_coordinates(rect.left());
+    rectangles->add_coordinates(rect.top());
+    rectangles->add_coordinates(rect.right());
+    rectangles->add_coordinates(rect.bottom());
+  }
+  // Keypoints are only supported in normalized/relative coordinates.
+  if (normalized && location_data.relative_keypoints_size()) {
+    auto* keypoints =
+        GetOrAddBatchedAnnotation(kKeypointLabel, options, &batched->keypoints,
+                                  render_data)
+            ->mutable_points();
+    keypoints->set_normalized(true);
+    for (const auto& keypoint : location_data.relative_keypoints()) {
+      keypoints->add_xy(keypoint.x());
+      keypoints->add_xy(keypoint.y());
+    }
+  }
+}
+
 void DetectionsToRenderDataCalculator::AddDetectionToRenderData(
     const Detection& detection,
     const DetectionsToRenderDataCalculatorOptions& options,
-    RenderData* render_data) {
+    BatchedLocations* batched, RenderData* render_data) {
   CHECK(detection.location_data().format() == LocationData::BOUNDING_BOX ||
         detection.location_data().format() ==
             LocationData::RELATIVE_BOUNDING_BOX)
@@ -360,6 +466,10 @@ void DetectionsToRenderDataCalculator::AddDetectionToRenderData(
   }
   AddLabels(detection, options, text_line_height, render_data);
   AddFeatureTag(detection, options, text_line_height, render_data);
-  AddLocationData(detection, options, render_data);
+  if (batched != nullptr) {
+    AddBatchedLocationData(detection, options, batched, render_data);
+  } else {
+    AddLocationData(detection, options, render_data);
+  }
 }
 }  // namespace mediapipe
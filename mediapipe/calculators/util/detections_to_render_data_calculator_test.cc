@@ -192,6 +192,56 @@ TEST(DetectionsToRenderDataCalculatorTest, BothDetecctionListAndVector) {
       "feature_tag2");
 }
 
+TEST(DetectionsToRenderDataCalculatorTest, BatchesLocations) {
+  CalculatorRunner runner{ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+    calculator: "DetectionsToRenderDataCalculator"
+    input_stream: "DETECTIONS:detections"
+    output_stream: "RENDER_DATA:render_data"
+    options {
+      [mediapipe.DetectionsToRenderDataCalculatorOptions.ext] {
+        batch_annotations: true
+        thickness: 2
+      }
+    }
+  )")};
+
+  auto detections(absl::make_unique<std::vector<Detection>>());
+  for (double offset : {0.0, 0.5}) {
+    LocationData location_data =
+        CreateRelativeLocationData(offset, 0.2, 0.3, 0.4);
+    auto* keypoint = location_data.add_relative_keypoints();
+    keypoint->set_x(offset + 0.1);
+    keypoint->set_y(0.3);
+    detections->push_back(
+        CreateDetection({"label"}, {}, {0.5}, location_data, "feature_tag"));
+  }
+
+  runner.MutableInputs()
+      ->Tag("DETECTIONS")
+      .packets.push_back(
+          Adopt(detections.release()).At(Timestamp::PostStream()));
+
+  MP_ASSERT_OK(runner.Run()) << "Calculator execution failed.";
+  const std::vector<Packet>& output =
+      runner.Outputs().Tag("RENDER_DATA").packets;
+  ASSERT_EQ(1, output.size());
+  const auto& actual = output[0].Get<RenderData>();
+  // Two labels and two feature tags, plus the batched boxes and keypoints.
+  ASSERT_EQ(actual.render_annotations_size(), 6);
+  const auto& rectangles = actual.render_annotations(2);
+  EXPECT_EQ(rectangles.thickness(), 2);
+  EXPECT_TRUE(rectangles.rectangles().normalized());
+  EXPECT_THAT(rectangles.rectangles().coordinates(),
+              testing::Pointwise(DoubleNear(kErrorTolerance),
+                                 std::vector<double>{0.0, 0.2, 0.3, 0.6, 0.5,
+                                                     0.2, 0.8, 0.6}));
+  const auto& keypoints = actual.render_annotations(3);
+  EXPECT_TRUE(keypoints.points().normalized());
+  EXPECT_THAT(keypoints.points().xy(),
+              testing::Pointwise(DoubleNear(kErrorTolerance),
+                                 std::vector<double>{0.1, 0.3, 0.6, 0.3}));
+}
+
 TEST(DetectionsToRenderDataCalculatorTest, ProduceEmptyPacket) {
   // Check when produce_empty_packet is false.
   CalculatorRunner runner1{ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
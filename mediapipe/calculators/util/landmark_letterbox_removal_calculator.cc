@@ -30,6 +30,7 @@
 #include <vector>
 
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/compact_landmarks.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
 #include "mediapipe/framework/port/ret_check.h"
 
@@ -38,6 +39,7 @@ namespace mediapipe {
 namespace {
 
 constexpr char kLandmarksTag[] = "LANDMARKS";
+constexpr char kCompactLandmarksTag[] = "COMPACT_LANDMARKS";
 constexpr char kLetterboxPaddingTag[] = "LETTERBOX_PADDING";
 
 }  // namespace
@@ -60,6 +62,9 @@ constexpr char kLetterboxPaddingTag[] = "LETTERBOX_PADDING";
 //   LANDMARKS: An std::vector<NormalizedLandmark> representing landmarks with
 //   their locations adjusted to the letterbox-removed (non-padded) image.
 //
+// CompactLandmarks are adjusted in a single pass instead with a
+// COMPACT_LANDMARKS input and output in place of LANDMARKS.
+//
 // Usage example:
 // node {
 //   calculator: "LandmarkLetterboxRemovalCalculator"
@@ -70,6 +75,15 @@ constexpr char kLetterboxPaddingTag[] = "LETTERBOX_PADDING";
 class LandmarkLetterboxRemovalCalculator : public CalculatorBase {
  public:
   static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    if (cc->Inputs().HasTag(kCompactLandmarksTag)) {
+      RET_CHECK(cc->Inputs().HasTag(kLetterboxPaddingTag))
+          << "Missing one or more input streams.";
+      cc->Inputs().Tag(kCompactLandmarksTag).Set<CompactLandmarks>();
+      cc->Inputs().Tag(kLetterboxPaddingTag).Set<std::array<float, 4>>();
+      cc->Outputs().Tag(kCompactLandmarksTag).Set<CompactLandmarks>();
+      return ::mediapipe::OkStatus();
+    }
+
     RET_CHECK(cc->Inputs().HasTag(kLandmarksTag) &&
               cc->Inputs().HasTag(kLetterboxPaddingTag))
         << "Missing one or more input streams.";
@@ -89,13 +103,20 @@ class LandmarkLetterboxRemovalCalculator : public CalculatorBase {
   }
 
   ::mediapipe::Status Process(CalculatorContext* cc) override {
+    if (cc->Inputs().HasTag(kCompactLandmarksTag)) {
+      return ProcessCompact(cc);
+    }
     // Only process if there's input landmarks.
     if (cc->Inputs().Tag(kLandmarksTag).IsEmpty()) {
       return ::mediapipe::OkStatus();
     }
 
-    const auto& input_landmarks =
-        cc->Inputs().Tag(kLandmarksTag).Get<std::vector<NormalizedLandmark>>();
+    // The landmarks are adjusted in place, without a copy if this calculator
+    // is their last reader.
+    ASSIGN_OR_RETURN(auto output_landmarks,
+                     cc->Inputs()
+                         .Tag(kLandmarksTag)
+                         .ConsumeOrCopy<std::vector<NormalizedLandmark>>());
     const auto& letterbox_padding =
         cc->Inputs().Tag(kLetterboxPaddingTag).Get<std::array<float, 4>>();
 
@@ -104,19 +125,13 @@ class LandmarkLetterboxRemovalCalculator : public CalculatorBase {
     const float left_and_right = letterbox_padding[0] + letterbox_padding[2];
     const float top_and_bottom = letterbox_padding[1] + letterbox_padding[3];
 
-    auto output_landmarks =
-        absl::make_unique<std::vector<NormalizedLandmark>>();
-    for (const auto& landmark : input_landmarks) {
-      NormalizedLandmark new_landmark;
+    for (auto& landmark : *output_landmarks) {
       const float new_x = (landmark.x() - left) / (1.0f - left_and_right);
       const float new_y = (landmark.y() - top) / (1.0f - top_and_bottom);
 
-      new_landmark.set_x(new_x);
-      new_landmark.set_y(new_y);
+      landmark.set_x(new_x);
+      landmark.set_y(new_y);
       // Keep z-coord as is.
-      new_landmark.set_z(landmark.z());
-
-      output_landmarks->emplace_back(new_landmark);
     }
 
     cc->Outputs()
@@ -124,6 +139,24 @@ class LandmarkLetterboxRemovalCalculator : public CalculatorBase {
         .Add(output_landmarks.release(), cc->InputTimestamp());
     return ::mediapipe::OkStatus();
   }
+
+ private:
+  ::mediapipe::Status ProcessCompact(CalculatorContext* cc) {
+    if (cc->Inputs().Tag(kCompactLandmarksTag).IsEmpty()) {
+      return ::mediapipe::OkStatus();
+    }
+    ASSIGN_OR_RETURN(auto output_landmarks,
+                     cc->Inputs()
+                         .Tag(kCompactLandmarksTag)
+                         .ConsumeOrCopy<CompactLandmarks>());
+    LandmarkTransform::RemoveLetterbox(
+        cc->Inputs().Tag(kLetterboxPaddingTag).Get<std::array<float, 4>>())
+        .Apply(output_landmarks.get());
+    cc->Outputs()
+        .Tag(kCompactLandmarksTag)
+        .Add(output_landmarks.release(), cc->InputTimestamp());
+    return ::mediapipe::OkStatus();
+  }
 };
 REGISTER_CALCULATOR(LandmarkLetterboxRemovalCalculator);
 
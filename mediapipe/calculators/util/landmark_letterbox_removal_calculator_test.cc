@@ -14,6 +14,7 @@
 
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/formats/compact_landmarks.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
@@ -108,4 +109,42 @@ TEST(LandmarkLetterboxRemovalCalculatorTest, PaddingTopBottom) {
   EXPECT_THAT(output_landmarks[2].y(), testing::FloatNear(1.0f, 1e-5));
 }
 
+TEST(LandmarkLetterboxRemovalCalculatorTest, CompactLandmarks) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+    calculator: "LandmarkLetterboxRemovalCalculator"
+    input_stream: "COMPACT_LANDMARKS:landmarks"
+    input_stream: "LETTERBOX_PADDING:letterbox_padding"
+    output_stream: "COMPACT_LANDMARKS:adjusted_landmarks"
+  )"));
+
+  auto landmarks = absl::make_unique<CompactLandmarks>();
+  landmarks->Resize(2);
+  landmarks->MutableLandmark(0)[0] = 0.5f;
+  landmarks->MutableLandmark(0)[1] = 0.5f;
+  landmarks->MutableLandmark(1)[0] = 0.2f;
+  landmarks->MutableLandmark(1)[1] = 0.2f;
+  runner.MutableInputs()
+      ->Tag("COMPACT_LANDMARKS")
+      .packets.push_back(
+          Adopt(landmarks.release()).At(Timestamp::PostStream()));
+
+  auto padding = absl::make_unique<std::array<float, 4>>(
+      std::array<float, 4>{0.2f, 0.0f, 0.3f, 0.0f});
+  runner.MutableInputs()
+      ->Tag("LETTERBOX_PADDING")
+      .packets.push_back(Adopt(padding.release()).At(Timestamp::PostStream()));
+
+  MP_ASSERT_OK(runner.Run()) << "Calculator execution failed.";
+  const std::vector<Packet>& output =
+      runner.Outputs().Tag("COMPACT_LANDMARKS").packets;
+  ASSERT_EQ(1, output.size());
+  const auto& output_landmarks = output[0].Get<CompactLandmarks>();
+
+  ASSERT_EQ(output_landmarks.size(), 2);
+  EXPECT_THAT(output_landmarks.Landmark(0)[0], testing::FloatNear(0.6f, 1e-5));
+  EXPECT_THAT(output_landmarks.Landmark(0)[1], testing::FloatNear(0.5f, 1e-5));
+  EXPECT_THAT(output_landmarks.Landmark(1)[0], testing::FloatNear(0.0f, 1e-5));
+  EXPECT_THAT(output_landmarks.Landmark(1)[1], testing::FloatNear(0.2f, 1e-5));
+}
+
 }  // namespace mediapipe
@@ -31,6 +31,7 @@
 
 #include "mediapipe/calculators/util/landmark_projection_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/compact_landmarks.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
 #include "mediapipe/framework/formats/rect.pb.h"
 #include "mediapipe/framework/port/ret_check.h"
@@ -41,6 +42,28 @@ namespace {
 
 constexpr char kLandmarksTag[] = "NORM_LANDMARKS";
 constexpr char kRectTag[] = "NORM_RECT";
+constexpr char kMultiLandmarksTag[] = "MULTI_NORM_LANDMARKS";
+constexpr char kRectsTag[] = "NORM_RECTS";
+constexpr char kCompactLandmarksTag[] = "COMPACT_NORM_LANDMARKS";
+
+// Projects landmarks in place from rect to the image.
+void ProjectLandmarks(const NormalizedRect& rect, bool ignore_rotation,
+                      std::vector<NormalizedLandmark>* landmarks) {
+  const float angle = ignore_rotation ? 0 : rect.rotation();
+  for (auto& landmark : *landmarks) {
+    const float x = landmark.x() - 0.5f;
+    const float y = landmark.y() - 0.5f;
+    float new_x = std::cos(angle) * x - std::sin(angle) * y;
+    float new_y = std::sin(angle) * x + std::cos(angle) * y;
+
+    new_x = new_x * rect.width() + rect.x_center();
+    new_y = new_y * rect.height() + rect.y_center();
+
+    landmark.set_x(new_x);
+    landmark.set_y(new_y);
+    // Keep z-coord as is.
+  }
+}
 
 }  // namespace
 
@@ -56,6 +79,15 @@ constexpr char kRectTag[] = "NORM_RECT";
 //   NORM_LANDMARKS: An std::vector<NormalizedLandmark> representing landmarks
 //                   with their locations adjusted to the image.
 //
+// Alternatively, the landmarks of several rectangles, such as those decoded
+// from a batched landmark model, are projected with:
+//   MULTI_NORM_LANDMARKS: An std::vector<std::vector<NormalizedLandmark>>,
+//                         input and output, with one entry per rectangle.
+//   NORM_RECTS: An std::vector<NormalizedRect> of the same size.
+//
+// CompactLandmarks are projected in a single pass instead with a
+// COMPACT_NORM_LANDMARKS input and output in place of NORM_LANDMARKS.
+//
 // Usage example:
 // node {
 //   calculator: "LandmarkProjectionCalculator"
@@ -66,6 +98,28 @@ constexpr char kRectTag[] = "NORM_RECT";
 class LandmarkProjectionCalculator : public CalculatorBase {
  public:
   static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    if (cc->Inputs().HasTag(kMultiLandmarksTag)) {
+      RET_CHECK(cc->Inputs().HasTag(kRectsTag))
+          << "MULTI_NORM_LANDMARKS requires NORM_RECTS.";
+      cc->Inputs()
+          .Tag(kMultiLandmarksTag)
+          .Set<std::vector<std::vector<NormalizedLandmark>>>();
+      cc->Inputs().Tag(kRectsTag).Set<std::vector<NormalizedRect>>();
+      cc->Outputs()
+          .Tag(kMultiLandmarksTag)
+          .Set<std::vector<std::vector<NormalizedLandmark>>>();
+      return ::mediapipe::OkStatus();
+    }
+
+    if (cc->Inputs().HasTag(kCompactLandmarksTag)) {
+      RET_CHECK(cc->Inputs().HasTag(kRectTag))
+          << "Missing one or more input streams.";
+      cc->Inputs().Tag(kCompactLandmarksTag).Set<CompactLandmarks>();
+      cc->Inputs().Tag(kRectTag).Set<NormalizedRect>();
+      cc->Outputs().Tag(kCompactLandmarksTag).Set<CompactLandmarks>();
+      return ::mediapipe::OkStatus();
+    }
+
     RET_CHECK(cc->Inputs().HasTag(kLandmarksTag) &&
               cc->Inputs().HasTag(kRectTag))
         << "Missing one or more input streams.";
@@ -87,39 +141,73 @@ class LandmarkProjectionCalculator : public CalculatorBase {
   ::mediapipe::Status Process(CalculatorContext* cc) override {
     const auto& options =
         cc->Options<::mediapipe::LandmarkProjectionCalculatorOptions>();
+    if (cc->Inputs().HasTag(kMultiLandmarksTag)) {
+      return ProcessMulti(cc, options.ignore_rotation());
+    }
+    if (cc->Inputs().HasTag(kCompactLandmarksTag)) {
+      return ProcessCompact(cc, options.ignore_rotation());
+    }
     // Only process if there's input landmarks.
     if (cc->Inputs().Tag(kLandmarksTag).IsEmpty()) {
       return ::mediapipe::OkStatus();
     }
 
-    const auto& input_landmarks =
-        cc->Inputs().Tag(kLandmarksTag).Get<std::vector<NormalizedLandmark>>();
+    // The landmarks are projected in place, without a copy if this calculator
+    // is their last reader.
+    ASSIGN_OR_RETURN(auto output_landmarks,
+                     cc->Inputs()
+                         .Tag(kLandmarksTag)
+                         .ConsumeOrCopy<std::vector<NormalizedLandmark>>());
     const auto& input_rect = cc->Inputs().Tag(kRectTag).Get<NormalizedRect>();
+    ProjectLandmarks(input_rect, options.ignore_rotation(),
+                     output_landmarks.get());
 
-    auto output_landmarks =
-        absl::make_unique<std::vector<NormalizedLandmark>>();
-    for (const auto& landmark : input_landmarks) {
-      NormalizedLandmark new_landmark;
-
-      const float x = landmark.x() - 0.5f;
-      const float y = landmark.y() - 0.5f;
-      const float angle = options.ignore_rotation() ? 0 : input_rect.rotation();
-      float new_x = std::cos(angle) * x - std::sin(angle) * y;
-      float new_y = std::sin(angle) * x + std::cos(angle) * y;
-
-      new_x = new_x * input_rect.width() + input_rect.x_center();
-      new_y = new_y * input_rect.height() + input_rect.y_center();
+    cc->Outputs()
+        .Tag(kLandmarksTag)
+        .Add(output_landmarks.release(), cc->InputTimestamp());
+    return ::mediapipe::OkStatus();
+  }
 
-      new_landmark.set_x(new_x);
-      new_landmark.set_y(new_y);
-      // Keep z-coord as is.
-      new_landmark.set_z(landmark.z());
+ private:
+  ::mediapipe::Status ProcessCompact(CalculatorContext* cc,
+                                     bool ignore_rotation) {
+    if (cc->Inputs().Tag(kCompactLandmarksTag).IsEmpty()) {
+      return ::mediapipe::OkStatus();
+    }
+    ASSIGN_OR_RETURN(auto output_landmarks,
+                     cc->Inputs()
+                         .Tag(kCompactLandmarksTag)
+                         .ConsumeOrCopy<CompactLandmarks>());
+    LandmarkTransform::Project(cc->Inputs().Tag(kRectTag).Get<NormalizedRect>(),
+                               ignore_rotation)
+        .Apply(output_landmarks.get());
+    cc->Outputs()
+        .Tag(kCompactLandmarksTag)
+        .Add(output_landmarks.release(), cc->InputTimestamp());
+    return ::mediapipe::OkStatus();
+  }
 
-      output_landmarks->emplace_back(new_landmark);
+  ::mediapipe::Status ProcessMulti(CalculatorContext* cc,
+                                   bool ignore_rotation) {
+    if (cc->Inputs().Tag(kMultiLandmarksTag).IsEmpty()) {
+      return ::mediapipe::OkStatus();
+    }
+    ASSIGN_OR_RETURN(
+        auto output_landmarks,
+        cc->Inputs()
+            .Tag(kMultiLandmarksTag)
+            .ConsumeOrCopy<std::vector<std::vector<NormalizedLandmark>>>());
+    const auto& input_rects =
+        cc->Inputs().Tag(kRectsTag).Get<std::vector<NormalizedRect>>();
+    RET_CHECK_EQ(output_landmarks->size(), input_rects.size())
+        << "MULTI_NORM_LANDMARKS and NORM_RECTS sizes differ.";
+    for (int i = 0; i < input_rects.size(); ++i) {
+      ProjectLandmarks(input_rects[i], ignore_rotation,
+                       &(*output_landmarks)[i]);
     }
 
     cc->Outputs()
-        .Tag(kLandmarksTag)
+        .Tag(kMultiLandmarksTag)
         .Add(output_landmarks.release(), cc->InputTimestamp());
     return ::mediapipe::OkStatus();
   }
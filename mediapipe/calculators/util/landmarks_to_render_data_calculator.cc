@@ -121,6 +121,15 @@ class LandmarksToRenderDataCalculator : public CalculatorBase {
       const LandmarksToRenderDataCalculatorOptions& options, bool normalized,
       int gray_val1, int gray_val2, RenderData* render_data);
 
+  // Adds one annotation per landmark and per connection.
+  template <class LandmarkType>
+  void AddLandmarks(const std::vector<LandmarkType>& landmarks,
+                    bool normalized, bool visualize_depth, float z_min,
+                    float z_max, RenderData* render_data);
+  // Adds all landmarks and all connections as two batched annotations.
+  template <class LandmarkType>
+  void AddBatchedLandmarks(const std::vector<LandmarkType>& landmarks,
+                           bool normalized, RenderData* render_data);
   template <class LandmarkType>
   void AddConnections(const std::vector<LandmarkType>& landmarks,
                       bool normalized, RenderData* render_data);
@@ -178,23 +187,11 @@ REGISTER_CALCULATOR(LandmarksToRenderDataCalculator);
     }
     // Only change rendering if there are actually z values other than 0.
     visualize_depth &= ((z_max - z_min) > 1e-3);
-    for (const auto& landmark : landmarks) {
-      auto* landmark_data_render =
-          AddPointRenderData(options_, render_data.get());
-      if (visualize_depth) {
-        SetColorSizeValueFromZ(landmark.z(), z_min, z_max,
-                               landmark_data_render);
-      }
-      auto* landmark_data = landmark_data_render->mutable_point();
-      landmark_data->set_normalized(false);
-      landmark_data->set_x(landmark.x());
-      landmark_data->set_y(landmark.y());
-    }
-    if (visualize_depth) {
-      AddConnectionsWithDepth(landmarks, /*normalized=*/false, z_min, z_max,
-                              render_data.get());
+    if (options_.batch_annotations() && !visualize_depth) {
+      AddBatchedLandmarks(landmarks, /*normalized=*/false, render_data.get());
     } else {
-      AddConnections(landmarks, /*normalized=*/false, render_data.get());
+      AddLandmarks(landmarks, /*normalized=*/false, visualize_depth, z_min,
+                   z_max, render_data.get());
     }
   }
 
@@ -209,23 +206,11 @@ REGISTER_CALCULATOR(LandmarksToRenderDataCalculator);
     }
     // Only change rendering if there are actually z values other than 0.
     visualize_depth &= ((z_max - z_min) > 1e-3);
-    for (const auto& landmark : landmarks) {
-      auto* landmark_data_render =
-          AddPointRenderData(options_, render_data.get());
-      if (visualize_depth) {
-        SetColorSizeValueFromZ(landmark.z(), z_min, z_max,
-                               landmark_data_render);
-      }
-      auto* landmark_data = landmark_data_render->mutable_point();
-      landmark_data->set_normalized(true);
-      landmark_data->set_x(landmark.x());
-      landmark_data->set_y(landmark.y());
-    }
-    if (visualize_depth) {
-      AddConnectionsWithDepth(landmarks, /*normalized=*/true, z_min, z_max,
-                              render_data.get());
+    if (options_.batch_annotations() && !visualize_depth) {
+      AddBatchedLandmarks(landmarks, /*normalized=*/true, render_data.get());
     } else {
-      AddConnections(landmarks, /*normalized=*/true, render_data.get());
+      AddLandmarks(landmarks, /*normalized=*/true, visualize_depth, z_min,
+                   z_max, render_data.get());
     }
   }
 
@@ -235,6 +220,59 @@ REGISTER_CALCULATOR(LandmarksToRenderDataCalculator);
   return ::mediapipe::OkStatus();
 }
 
+template <class LandmarkType>
+void LandmarksToRenderDataCalculator::AddLandmarks(
+    const std::vector<LandmarkType>& landmarks, bool normalized,
+    bool visualize_depth, float z_min, float z_max, RenderData* render_data) {
+  for (const auto& landmark : landmarks) {
+    auto* landmark_data_render = AddPointRenderData(options_, render_data);
+    if (visualize_depth) {
+      SetColorSizeValueFromZ(landmark.z(), z_min, z_max, landmark_data_render);
+    }
+    auto* landmark_data = landmark_data_render->mutable_point();
+    landmark_data->set_normalized(normalized);
+    landmark_data->set_x(landmark.x());
+    landmark_data->set_y(landmark.y());
+  }
+  if (visualize_depth) {
+    AddConnectionsWithDepth(landmarks, normalized, z_min, z_max, render_data);
+  } else {
+    AddConnections(landmarks, normalized, render_data);
+  }
+}
+
+template <class LandmarkType>
+void LandmarksToRenderDataCalculator::AddBatchedLandmarks(
+    const std::vector<LandmarkType>& landmarks, bool normalized,
+    RenderData* render_data) {
+  auto* points = AddPointRenderData(options_, render_data)->mutable_points();
+  points->set_normalized(normalized);
+  points->mutable_xy()->Reserve(2 * landmarks.size());
+  for (const auto& landmark : landmarks) {
+    points->add_xy(landmark.x());
+    points->add_xy(landmark.y());
+  }
+  if (options_.landmark_connections_size() == 0) {
+    return;
+  }
+
+  auto* connection_annotation = render_data->add_render_annotations();
+  SetColor(connection_annotation, options_.connection_color());
+  connection_annotation->set_thickness(options_.thickness());
+  auto* lines = connection_annotation->mutable_lines();
+  lines->set_normalized(normalized);
+  lines->mutable_coordinates()->Reserve(2 *
+                                        options_.landmark_connections_size());
+  for (int i = 0; i < options_.landmark_connections_size(); i += 2) {
+    const auto& ld0 = landmarks[options_.landmark_connections(i)];
+    const auto& ld1 = landmarks[options_.landmark_connections(i + 1)];
+    lines->add_coordinates(ld0.x());
+    lines->add_coordinates(ld0.y());
+    lines->add_coordinates(ld1.x());
+    lines->add_coordinates(ld1.y());
+  }
+}
+
 template <class LandmarkType>
 void LandmarksToRenderDataCalculator::AddConnectionsWithDepth(
     const std::vector<LandmarkType>& landmarks, bool normalized, float min_z,
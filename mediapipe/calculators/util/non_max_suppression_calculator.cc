@@ -13,18 +13,22 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <cmath>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/memory/memory.h"
 #include "mediapipe/calculators/util/non_max_suppression_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/compact_detections.h"
 #include "mediapipe/framework/formats/detection.pb.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/location.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/rectangle.h"
+#include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
 
 namespace mediapipe {
@@ -35,6 +39,10 @@ typedef std::vector<std::pair<int, float>> IndexedScores;
 namespace {
 
 constexpr char kImageTag[] = "IMAGE";
+constexpr char kCompactDetectionsTag[] = "COMPACT_DETECTIONS";
+
+// The most grid cells per side chosen automatically.
+constexpr int kMaxGridCellsPerSide = 32;
 
 bool SortBySecond(const std::pair<int, float>& indexed_score_0,
                   const std::pair<int, float>& indexed_score_1) {
@@ -72,52 +80,157 @@ bool RetainMaxScoringLabelOnly(Detection* detection) {
   return true;
 }
 
-// Computes an overlap similarity between two rectangles. Similarity measure is
-// defined by overlap_type parameter.
-float OverlapSimilarity(
+// The coordinates and areas of a set of rectangles, stored as one array per
+// field so that a rectangle can be compared with all of them in a single
+// vectorizable loop.
+struct BoxArrays {
+  void Add(const Rectangle_f& rect) {
+    xmin.push_back(rect.xmin());
+    ymin.push_back(rect.ymin());
+    xmax.push_back(rect.xmax());
+    ymax.push_back(rect.ymax());
+    area.push_back(rect.Area());
+  }
+
+  int size() const { return xmin.size(); }
+
+  std::vector<float> xmin;
+  std::vector<float> ymin;
+  std::vector<float> xmax;
+  std::vector<float> ymax;
+  std::vector<float> area;
+};
+
+// Computes the overlap similarity of each rectangle in "boxes" with "rect",
+// as defined by kOverlapType.  Rectangles that do not intersect have a
+// similarity of 0.  The loop has no data dependent branches, so that the
+// compiler can vectorize it.
+template <NonMaxSuppressionCalculatorOptions::OverlapType kOverlapType>
+void ComputeOverlapSimilarities(const BoxArrays& boxes, const Rectangle_f& rect,
+                                float* similarities) {
+  const float* xmin = boxes.xmin.data();
+  const float* ymin = boxes.ymin.data();
+  const float* xmax = boxes.xmax.data();
+  const float* ymax = boxes.ymax.data();
+  const float* area = boxes.area.data();
+  const float rect_area = rect.Area();
+  const int num_boxes = boxes.size();
+  for (int i = 0; i < num_boxes; ++i) {
+    const float width = std::min(xmax[i], rect.xmax()) -
+                        std::max(xmin[i], rect.xmin());
+    const float height = std::min(ymax[i], rect.ymax()) -
+                         std::max(ymin[i], rect.ymin());
+    const float intersection_area =
+        std::max(width, 0.0f) * std::max(height, 0.0f);
+    float normalization;
+    switch (kOverlapType) {
+      case NonMaxSuppressionCalculatorOptions::JACCARD:
+        // The area of the bounding box of both rectangles.
+        normalization = (std::max(xmax[i], rect.xmax()) -
+                         std::min(xmin[i], rect.xmin())) *
+                        (std::max(ymax[i], rect.ymax()) -
+                         std::min(ymin[i], rect.ymin()));
+        break;
+      case NonMaxSuppressionCalculatorOptions::MODIFIED_JACCARD:
+        normalization = rect_area;
+        break;
+      default:
+        normalization = area[i] + rect_area - intersection_area;
+        break;
+    }
+    const float similarity =
+        intersection_area / (normalization > 0.0f ? normalization : 1.0f);
+    similarities[i] = normalization > 0.0f ? similarity : 0.0f;
+  }
+}
+
+// Computes the overlap similarity of each rectangle in "boxes" with "rect",
+// which is the rectangle being checked for suppression.
+void ComputeOverlapSimilarities(
     const NonMaxSuppressionCalculatorOptions::OverlapType overlap_type,
-    const Rectangle_f& rect1, const Rectangle_f& rect2) {
-  if (!rect1.Intersects(rect2)) return 0.0f;
-  const float intersection_area = Rectangle_f(rect1).Intersect(rect2).Area();
-  float normalization;
+    const BoxArrays& boxes, const Rectangle_f& rect,
+    std::vector<float>* similarities) {
+  similarities->resize(boxes.size());
   switch (overlap_type) {
     case NonMaxSuppressionCalculatorOptions::JACCARD:
-      normalization = Rectangle_f(rect1).Union(rect2).Area();
+      ComputeOverlapSimilarities<NonMaxSuppressionCalculatorOptions::JACCARD>(
+          boxes, rect, similarities->data());
       break;
     case NonMaxSuppressionCalculatorOptions::MODIFIED_JACCARD:
-      normalization = rect2.Area();
+      ComputeOverlapSimilarities<
+          NonMaxSuppressionCalculatorOptions::MODIFIED_JACCARD>(
+          boxes, rect, similarities->data());
       break;
     case NonMaxSuppressionCalculatorOptions::INTERSECTION_OVER_UNION:
-      normalization = rect1.Area() + rect2.Area() - intersection_area;
+      ComputeOverlapSimilarities<
+          NonMaxSuppressionCalculatorOptions::INTERSECTION_OVER_UNION>(
+          boxes, rect, similarities->data());
       break;
     default:
       LOG(FATAL) << "Unrecognized overlap type: " << overlap_type;
   }
-  return normalization > 0.0f ? intersection_area / normalization : 0.0f;
 }
 
-// Computes an overlap similarity between two locations by first extracting the
-// relative box (dimension normalized by frame width/height) from the location.
-float OverlapSimilarity(
-    const int frame_width, const int frame_height,
-    const NonMaxSuppressionCalculatorOptions::OverlapType overlap_type,
-    const Location& location1, const Location& location2) {
-  const auto rect1 = location1.ConvertToRelativeBBox(frame_width, frame_height);
-  const auto rect2 = location2.ConvertToRelativeBBox(frame_width, frame_height);
-  return OverlapSimilarity(overlap_type, rect1, rect2);
-}
+// Buckets rectangles on a uniform grid over the unit square, so that finding
+// the rectangles which may intersect a query rectangle only visits the cells
+// it covers.  Coordinates outside the unit square fall into the border cells.
+// Empty rectangles intersect nothing, so they are only bucketed on a grid of a
+// single cell, which holds every rectangle.
+class RectangleGrid {
+ public:
+  // The rectangles bucketed in one cell, and their ids.
+  struct Cell {
+    std::vector<int> ids;
+    BoxArrays boxes;
+  };
+
+  explicit RectangleGrid(int cells_per_side)
+      : cells_per_side_(cells_per_side),
+        cells_(cells_per_side * cells_per_side) {}
+
+  void Insert(int id, const Rectangle_f& rect) {
+    ForEachCell(rect, [id, &rect](Cell* cell) {
+      cell->ids.push_back(id);
+      cell->boxes.Add(rect);
+    });
+  }
 
-// Computes an overlap similarity between two locations by first extracting the
-// relative box from the location. It assumes that a relative-box representation
-// is already available in the location, and therefore frame width and height
-// are not needed for further normalization.
-float OverlapSimilarity(
-    const NonMaxSuppressionCalculatorOptions::OverlapType overlap_type,
-    const Location& location1, const Location& location2) {
-  const auto rect1 = location1.GetRelativeBBox();
-  const auto rect2 = location2.GetRelativeBBox();
-  return OverlapSimilarity(overlap_type, rect1, rect2);
-}
+  // Calls "visitor" on each cell covered by "rect".  A rectangle covering
+  // several of these cells is visited once per cell.
+  template <typename CellVisitor>
+  void ForEachCell(const Rectangle_f& rect, CellVisitor visitor) {
+    if (cells_per_side_ == 1) {
+      visitor(&cells_[0]);
+      return;
+    }
+    if (rect.IsEmpty()) return;
+    const int x_end = CellIndex(rect.xmax());
+    const int y_end = CellIndex(rect.ymax());
+    for (int y = CellIndex(rect.ymin()); y <= y_end; ++y) {
+      for (int x = CellIndex(rect.xmin()); x <= x_end; ++x) {
+        visitor(&cells_[y * cells_per_side_ + x]);
+      }
+    }
+  }
+
+ private:
+  int CellIndex(float coordinate) const {
+    if (!(coordinate > 0.0f)) return 0;
+    if (coordinate >= 1.0f) return cells_per_side_ - 1;
+    return std::min(static_cast<int>(coordinate * cells_per_side_),
+                    cells_per_side_ - 1);
+  }
+
+  const int cells_per_side_;
+  std::vector<Cell> cells_;
+};
+
+// A detection retained by weighted non-maximum suppression, and the
+// detections averaged into it, including itself, in decreasing score order.
+struct WeightedCluster {
+  int top_index;
+  IndexedScores candidates;
+};
 
 }  // namespace
 
@@ -129,9 +242,13 @@ float OverlapSimilarity(
 //   2. A variable number of input streams of type std::vector<Detection>. The
 //      exact number of such streams should be set via num_detection_streams
 //      field in the calculator options.
+//      Alternatively, num_detection_streams COMPACT_DETECTIONS streams of
+//      CompactDetections, which must all have the same number of keypoints.
 //
 // Outputs: a single stream of type std::vector<Detection> containing a subset
-//   of the input detections after non-maximum suppression.
+//   of the input detections after non-maximum suppression, or a
+//   COMPACT_DETECTIONS stream of CompactDetections if the inputs are
+//   CompactDetections.
 //
 // Example config:
 // node {
@@ -159,6 +276,17 @@ class NonMaxSuppressionCalculator : public CalculatorBase {
     if (cc->Inputs().HasTag(kImageTag)) {
       cc->Inputs().Tag(kImageTag).Set<ImageFrame>();
     }
+    if (cc->Inputs().HasTag(kCompactDetectionsTag)) {
+      RET_CHECK_EQ(cc->Inputs().NumEntries(kCompactDetectionsTag),
+                   options.num_detection_streams())
+          << "The number of COMPACT_DETECTIONS streams must be "
+             "num_detection_streams.";
+      for (int k = 0; k < options.num_detection_streams(); ++k) {
+        cc->Inputs().Get(kCompactDetectionsTag, k).Set<CompactDetections>();
+      }
+      cc->Outputs().Tag(kCompactDetectionsTag).Set<CompactDetections>();
+      return ::mediapipe::OkStatus();
+    }
     for (int k = 0; k < options.num_detection_streams(); ++k) {
       cc->Inputs().Index(k).Set<Detections>();
     }
@@ -180,6 +308,10 @@ class NonMaxSuppressionCalculator : public CalculatorBase {
   }
 
   ::mediapipe::Status Process(CalculatorContext* cc) override {
+    if (cc->Inputs().HasTag(kCompactDetectionsTag)) {
+      return ProcessCompactDetections(cc);
+    }
+
     // Add all input detections to the same vector.
     Detections input_detections;
     for (int i = 0; i < options_.num_detection_streams(); ++i) {
@@ -220,26 +352,46 @@ class NonMaxSuppressionCalculator : public CalculatorBase {
     IndexedScores indexed_scores;
     indexed_scores.reserve(pruned_detections.size());
     for (int index = 0; index < pruned_detections.size(); ++index) {
-      indexed_scores.push_back(
-          std::make_pair(index, pruned_detections[index].score(0)));
+      AddIndexedScore(index, pruned_detections[index].score(0),
+                      &indexed_scores);
+    }
+
+    // Extract the relative bounding box of each remaining detection once.
+    // Weighted NMS only supports relative bounding boxes.
+    const bool weighted =
+        options_.algorithm() == NonMaxSuppressionCalculatorOptions::WEIGHTED;
+    std::vector<Rectangle_f> rects(pruned_detections.size());
+    const bool use_frame_size = cc->Inputs().HasTag(kImageTag) && !weighted;
+    for (const auto& indexed_score : indexed_scores) {
+      const Location location(
+          pruned_detections[indexed_score.first].location_data());
+      if (use_frame_size) {
+        const auto& frame = cc->Inputs().Tag(kImageTag).Get<ImageFrame>();
+        rects[indexed_score.first] =
+            location.ConvertToRelativeBBox(frame.Width(), frame.Height());
+      } else {
+        rects[indexed_score.first] = location.GetRelativeBBox();
+      }
     }
-    std::sort(indexed_scores.begin(), indexed_scores.end(), SortBySecond);
 
-    const int max_num_detections =
-        (options_.max_num_detections() > -1)
-            ? options_.max_num_detections()
-            : static_cast<int>(indexed_scores.size());
     // A set of detections and locations, wrapping the location data from each
     // detection, which are retained after the non-maximum suppression.
     auto* retained_detections = new Detections();
-    retained_detections->reserve(max_num_detections);
-
-    if (options_.algorithm() == NonMaxSuppressionCalculatorOptions::WEIGHTED) {
-      WeightedNonMaxSuppression(indexed_scores, pruned_detections,
-                                max_num_detections, cc, retained_detections);
+    if (weighted) {
+      std::vector<WeightedCluster> clusters;
+      WeightedNonMaxSuppression(&indexed_scores, rects, &clusters);
+      retained_detections->reserve(clusters.size());
+      for (const auto& cluster : clusters) {
+        retained_detections->push_back(
+            WeightedDetection(pruned_detections, cluster));
+      }
     } else {
-      NonMaxSuppression(indexed_scores, pruned_detections, max_num_detections,
-                        cc, retained_detections);
+      std::vector<int> retained_indices;
+      NonMaxSuppression(&indexed_scores, rects, &retained_indices);
+      retained_detections->reserve(retained_indices.size());
+      for (int index : retained_indices) {
+        retained_detections->push_back(pruned_detections[index]);
+      }
     }
 
     cc->Outputs().Index(0).Add(retained_detections, cc->InputTimestamp());
@@ -248,125 +400,299 @@ class NonMaxSuppressionCalculator : public CalculatorBase {
   }
 
  private:
-  void NonMaxSuppression(const IndexedScores& indexed_scores,
-                         const Detections& detections, int max_num_detections,
-                         CalculatorContext* cc, Detections* output_detections) {
-    std::vector<Location> retained_locations;
-    retained_locations.reserve(max_num_detections);
+  // Performs non-maximum suppression on CompactDetections, which already
+  // have a single score and a relative bounding box each.
+  ::mediapipe::Status ProcessCompactDetections(CalculatorContext* cc) {
+    CompactDetections input_detections;
+    bool has_input = false;
+    for (int i = 0; i < options_.num_detection_streams(); ++i) {
+      const auto& detections_packet =
+          cc->Inputs().Get(kCompactDetectionsTag, i).Value();
+      if (detections_packet.IsEmpty()) {
+        continue;
+      }
+      const auto& detections = detections_packet.Get<CompactDetections>();
+      if (!has_input) {
+        input_detections.num_keypoints = detections.num_keypoints;
+        has_input = true;
+      }
+      RET_CHECK_EQ(detections.num_keypoints, input_detections.num_keypoints)
+          << "All COMPACT_DETECTIONS streams must have the same number of "
+             "keypoints.";
+      for (int index = 0; index < detections.size(); ++index) {
+        input_detections.Append(detections, index);
+      }
+    }
+
+    auto retained_detections = absl::make_unique<CompactDetections>();
+    retained_detections->num_keypoints = input_detections.num_keypoints;
+    if (input_detections.empty()) {
+      if (options_.return_empty_detections()) {
+        cc->Outputs()
+            .Tag(kCompactDetectionsTag)
+            .Add(retained_detections.release(), cc->InputTimestamp());
+      }
+      return ::mediapipe::OkStatus();
+    }
+
+    IndexedScores indexed_scores;
+    indexed_scores.reserve(input_detections.size());
+    std::vector<Rectangle_f> rects(input_detections.size());
+    for (int index = 0; index < input_detections.size(); ++index) {
+      AddIndexedScore(index, input_detections.score[index], &indexed_scores);
+      rects[index] = Rectangle_f(
+          input_detections.xmin[index], input_detections.ymin[index],
+          input_detections.width[index], input_detections.height[index]);
+    }
+
+    if (options_.algorithm() == NonMaxSuppressionCalculatorOptions::WEIGHTED) {
+      std::vector<WeightedCluster> clusters;
+      WeightedNonMaxSuppression(&indexed_scores, rects, &clusters);
+      retained_detections->Reserve(clusters.size());
+      for (const auto& cluster : clusters) {
+        AddWeightedDetection(input_detections, cluster,
+                             retained_detections.get());
+      }
+    } else {
+      std::vector<int> retained_indices;
+      NonMaxSuppression(&indexed_scores, rects, &retained_indices);
+      retained_detections->Reserve(retained_indices.size());
+      for (int index : retained_indices) {
+        retained_detections->Append(input_detections, index);
+      }
+    }
+
+    cc->Outputs()
+        .Tag(kCompactDetectionsTag)
+        .Add(retained_detections.release(), cc->InputTimestamp());
+    return ::mediapipe::OkStatus();
+  }
+
+  // Adds the score of detection "index" to "indexed_scores". Unless they are
+  // averaged into higher scoring detections by weighted NMS, detections
+  // scoring below min_score_threshold can neither be returned nor suppress
+  // others, so they are dropped before sorting.
+  void AddIndexedScore(int index, float score,
+                       IndexedScores* indexed_scores) const {
+    if (options_.algorithm() != NonMaxSuppressionCalculatorOptions::WEIGHTED &&
+        options_.min_score_threshold() > 0 &&
+        score < options_.min_score_threshold()) {
+      return;
+    }
+    indexed_scores->push_back(std::make_pair(index, score));
+  }
+
+  // Returns the number of grid cells per side for "num_detections" boxes.
+  int GridCellsPerSide(int num_detections) const {
+    // A negative threshold lets boxes which do not intersect suppress each
+    // other, so every pair must be compared.
+    if (options_.min_suppression_threshold() < 0.0f) {
+      return 1;
+    }
+    if (options_.grid_cells_per_side() > 0) {
+      return options_.grid_cells_per_side();
+    }
+    // Aim for a few boxes per cell.
+    const int cells_per_side =
+        static_cast<int>(std::sqrt(num_detections / 4.0f));
+    return std::max(1, std::min(cells_per_side, kMaxGridCellsPerSide));
+  }
+
+  // Stores the indices of the retained detections in "retained_indices", in
+  // decreasing score order. Sorts "indexed_scores" as it is traversed, since
+  // only the highest scoring detections are visited once max_num_detections
+  // are retained.
+  void NonMaxSuppression(IndexedScores* indexed_scores,
+                         const std::vector<Rectangle_f>& rects,
+                         std::vector<int>* retained_indices) {
+    const int num_detections = indexed_scores->size();
+    const int max_num_detections = options_.max_num_detections() > -1
+                                       ? options_.max_num_detections()
+                                       : num_detections;
+    retained_indices->clear();
+    // The retained boxes.
+    RectangleGrid retained_rects(GridCellsPerSide(num_detections));
+    std::vector<float> similarities;
+    int num_sorted = 0;
     // We traverse the detections by decreasing score.
-    for (const auto& indexed_score : indexed_scores) {
-      const auto& detection = detections[indexed_score.first];
-      if (options_.min_score_threshold() > 0 &&
-          detection.score(0) < options_.min_score_threshold()) {
-        break;
+    for (int rank = 0; rank < num_detections &&
+                       retained_indices->size() < max_num_detections;
+         ++rank) {
+      if (rank == num_sorted) {
+        // Sort at least twice as many detections as are left to retain.
+        const int num_to_retain =
+            max_num_detections - retained_indices->size();
+        num_sorted += std::max(num_sorted, 2 * num_to_retain);
+        num_sorted = std::min(num_sorted, num_detections);
+        std::partial_sort(indexed_scores->begin() + rank,
+                          indexed_scores->begin() + num_sorted,
+                          indexed_scores->end(), SortBySecond);
       }
-      const Location location(detection.location_data());
+      const auto& indexed_score = (*indexed_scores)[rank];
+      const Rectangle_f& rect = rects[indexed_score.first];
       bool suppressed = false;
       // The current detection is suppressed iff there exists a retained
       // detection, whose location overlaps more than the specified
       // threshold with the location of the current detection.
-      for (const auto& retained_location : retained_locations) {
-        float similarity;
-        if (cc->Inputs().HasTag(kImageTag)) {
-          const auto& frame = cc->Inputs().Tag(kImageTag).Get<ImageFrame>();
-          similarity = OverlapSimilarity(frame.Width(), frame.Height(),
-                                         options_.overlap_type(),
-                                         retained_location, location);
-        } else {
-          similarity = OverlapSimilarity(options_.overlap_type(),
-                                         retained_location, location);
-        }
-        if (similarity > options_.min_suppression_threshold()) {
-          suppressed = true;
-          break;
+      retained_rects.ForEachCell(rect, [&](RectangleGrid::Cell* cell) {
+        if (suppressed) return;
+        ComputeOverlapSimilarities(options_.overlap_type(), cell->boxes, rect,
+                                   &similarities);
+        for (float similarity : similarities) {
+          suppressed |= similarity > options_.min_suppression_threshold();
         }
-      }
+      });
       if (!suppressed) {
-        output_detections->push_back(detection);
-        retained_locations.push_back(location);
-      }
-      if (output_detections->size() >= max_num_detections) {
-        break;
+        retained_indices->push_back(indexed_score.first);
+        retained_rects.Insert(indexed_score.first, rect);
       }
     }
   }
 
-  void WeightedNonMaxSuppression(const IndexedScores& indexed_scores,
-                                 const Detections& detections,
-                                 int max_num_detections, CalculatorContext* cc,
-                                 Detections* output_detections) {
-    IndexedScores remained_indexed_scores;
-    remained_indexed_scores.assign(indexed_scores.begin(),
-                                   indexed_scores.end());
-
-    IndexedScores remained;
-    IndexedScores candidates;
-    output_detections->clear();
-    while (!remained_indexed_scores.empty()) {
-      const auto& detection = detections[remained_indexed_scores[0].first];
+  // Stores in "clusters" each retained detection, in decreasing score order,
+  // with the detections to average into it. Sorts "indexed_scores".
+  void WeightedNonMaxSuppression(IndexedScores* indexed_scores,
+                                 const std::vector<Rectangle_f>& rects,
+                                 std::vector<WeightedCluster>* clusters) {
+    std::sort(indexed_scores->begin(), indexed_scores->end(), SortBySecond);
+    // All boxes, by rank in decreasing score order.
+    const int num_detections = indexed_scores->size();
+    RectangleGrid grid(GridCellsPerSide(num_detections));
+    for (int rank = 0; rank < num_detections; ++rank) {
+      grid.Insert(rank, rects[(*indexed_scores)[rank].first]);
+    }
+    std::vector<bool> removed(num_detections, false);
+    // The last top box gathering each box, for gathering it once when it
+    // lies in several cells.
+    std::vector<int> gathered_by(num_detections, -1);
+
+    std::vector<float> similarities;
+    std::vector<int> candidate_ranks;
+    clusters->clear();
+    for (int top_rank = 0; top_rank < num_detections; ++top_rank) {
+      if (removed[top_rank]) {
+        continue;
+      }
       if (options_.min_score_threshold() > 0 &&
-          detection.score(0) < options_.min_score_threshold()) {
+          (*indexed_scores)[top_rank].second <
+              options_.min_score_threshold()) {
         break;
       }
 
-      remained.clear();
-      candidates.clear();
-      const Location location(detection.location_data());
-      // This includes the first box.
-      for (const auto& indexed_score : remained_indexed_scores) {
-        Location rest_location(detections[indexed_score.first].location_data());
-        float similarity =
-            OverlapSimilarity(options_.overlap_type(), rest_location, location);
-        if (similarity > options_.min_suppression_threshold()) {
-          candidates.push_back(indexed_score);
-        } else {
-          remained.push_back(indexed_score);
-        }
-      }
-      auto weighted_detection = detection;
-      if (!candidates.empty()) {
-        const int num_keypoints =
-            detection.location_data().relative_keypoints_size();
-        std::vector<float> keypoints(num_keypoints * 2);
-        float w_xmin = 0.0f;
-        float w_ymin = 0.0f;
-        float w_xmax = 0.0f;
-        float w_ymax = 0.0f;
-        float total_score = 0.0f;
-        for (const auto& candidate : candidates) {
-          total_score += candidate.second;
-          const auto& location_data =
-              detections[candidate.first].location_data();
-          const auto& bbox = location_data.relative_bounding_box();
-          w_xmin += bbox.xmin() * candidate.second;
-          w_ymin += bbox.ymin() * candidate.second;
-          w_xmax += (bbox.xmin() + bbox.width()) * candidate.second;
-          w_ymax += (bbox.ymin() + bbox.height()) * candidate.second;
-
-          for (int i = 0; i < num_keypoints; ++i) {
-            keypoints[i * 2] +=
-                location_data.relative_keypoints(i).x() * candidate.second;
-            keypoints[i * 2 + 1] +=
-                location_data.relative_keypoints(i).y() * candidate.second;
+      // Gather the remaining boxes overlapping the top box, including the
+      // top box itself, in decreasing score order.
+      const Rectangle_f& rect = rects[(*indexed_scores)[top_rank].first];
+      candidate_ranks.clear();
+      grid.ForEachCell(rect, [&](RectangleGrid::Cell* cell) {
+        ComputeOverlapSimilarities(options_.overlap_type(), cell->boxes, rect,
+                                   &similarities);
+        for (int i = 0; i < similarities.size(); ++i) {
+          const int rank = cell->ids[i];
+          if (!removed[rank] && gathered_by[rank] != top_rank &&
+              similarities[i] > options_.min_suppression_threshold()) {
+            gathered_by[rank] = top_rank;
+            candidate_ranks.push_back(rank);
           }
         }
-        auto* weighted_location = weighted_detection.mutable_location_data()
-                                      ->mutable_relative_bounding_box();
-        weighted_location->set_xmin(w_xmin / total_score);
-        weighted_location->set_ymin(w_ymin / total_score);
-        weighted_location->set_width((w_xmax / total_score) -
-                                     weighted_location->xmin());
-        weighted_location->set_height((w_ymax / total_score) -
-                                      weighted_location->ymin());
-        for (int i = 0; i < num_keypoints; ++i) {
-          auto* keypoint = weighted_detection.mutable_location_data()
-                               ->mutable_relative_keypoints(i);
-          keypoint->set_x(keypoints[i * 2] / total_score);
-          keypoint->set_y(keypoints[i * 2 + 1] / total_score);
-        }
+      });
+      std::sort(candidate_ranks.begin(), candidate_ranks.end());
+      clusters->push_back({(*indexed_scores)[top_rank].first, {}});
+      IndexedScores& candidates = clusters->back().candidates;
+      for (int rank : candidate_ranks) {
+        candidates.push_back((*indexed_scores)[rank]);
+        removed[rank] = true;
       }
-      remained_indexed_scores = std::move(remained);
-      output_detections->push_back(weighted_detection);
+      removed[top_rank] = true;
+    }
+  }
+
+  // Returns the top detection of "cluster" with its location replaced by the
+  // score weighted average of the locations of the cluster candidates.
+  Detection WeightedDetection(const Detections& detections,
+                              const WeightedCluster& cluster) {
+    const auto& detection = detections[cluster.top_index];
+    auto weighted_detection = detection;
+    if (cluster.candidates.empty()) {
+      return weighted_detection;
+    }
+    const int num_keypoints =
+        detection.location_data().relative_keypoints_size();
+    std::vector<float> keypoints(num_keypoints * 2);
+    float w_xmin = 0.0f;
+    float w_ymin = 0.0f;
+    float w_xmax = 0.0f;
+    float w_ymax = 0.0f;
+    float total_score = 0.0f;
+    for (const auto& candidate : cluster.candidates) {
+      total_score += candidate.second;
+      const auto& location_data = detections[candidate.first].location_data();
+      const auto& bbox = location_data.relative_bounding_box();
+      w_xmin += bbox.xmin() * candidate.second;
+      w_ymin += bbox.ymin() * candidate.second;
+      w_xmax += (bbox.xmin() + bbox.width()) * candidate.second;
+      w_ymax += (bbox.ymin() + bbox.height()) * candidate.second;
+
+      for (int i = 0; i < num_keypoints; ++i) {
+        keypoints[i * 2] +=
+            location_data.relative_keypoints(i).x() * candidate.second;
+        keypoints[i * 2 + 1] +=
+            location_data.relative_keypoints(i).y() * candidate.second;
+      }
+    }
+    auto* weighted_location = weighted_detection.mutable_location_data()
+                                  ->mutable_relative_bounding_box();
+    weighted_location->set_xmin(w_xmin / total_score);
+    weighted_location->set_ymin(w_ymin / total_score);
+    weighted_location->set_width((w_xmax / total_score) -
+                                 weighted_location->xmin());
+    weighted_location->set_height((w_ymax / total_score) -
+                                  weighted_location->ymin());
+    for (int i = 0; i < num_keypoints; ++i) {
+      auto* keypoint = weighted_detection.mutable_location_data()
+                           ->mutable_relative_keypoints(i);
+      keypoint->set_x(keypoints[i * 2] / total_score);
+      keypoint->set_y(keypoints[i * 2 + 1] / total_score);
+    }
+    return weighted_detection;
+  }
+
+  // Appends the top detection of "cluster" to "output", with its location
+  // replaced by the score weighted average of the cluster candidates.
+  void AddWeightedDetection(const CompactDetections& detections,
+                            const WeightedCluster& cluster,
+                            CompactDetections* output) {
+    output->Append(detections, cluster.top_index);
+    if (cluster.candidates.empty()) {
+      return;
+    }
+    const int index = output->size() - 1;
+    const int num_coordinates = 2 * detections.num_keypoints;
+    float* keypoints = output->MutableKeypoints(index);
+    std::fill(keypoints, keypoints + num_coordinates, 0.0f);
+    float w_xmin = 0.0f;
+    float w_ymin = 0.0f;
+    float w_xmax = 0.0f;
+    float w_ymax = 0.0f;
+    float total_score = 0.0f;
+    for (const auto& candidate : cluster.candidates) {
+      const int i = candidate.first;
+      const float score = candidate.second;
+      total_score += score;
+      w_xmin += detections.xmin[i] * score;
+      w_ymin += detections.ymin[i] * score;
+      w_xmax += (detections.xmin[i] + detections.width[i]) * score;
+      w_ymax += (detections.ymin[i] + detections.height[i]) * score;
+      const float* candidate_keypoints = detections.Keypoints(i);
+      for (int k = 0; k < num_coordinates; ++k) {
+        keypoints[k] += candidate_keypoints[k] * score;
+      }
+    }
+    output->xmin[index] = w_xmin / total_score;
+    output->ymin[index] = w_ymin / total_score;
+    output->width[index] = w_xmax / total_score - output->xmin[index];
+    output->height[index] = w_ymax / total_score - output->ymin[index];
+    for (int k = 0; k < num_coordinates; ++k) {
+      keypoints[k] /= total_score;
     }
   }
 
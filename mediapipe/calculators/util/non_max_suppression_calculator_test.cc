@@ -0,0 +1,191 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/strings/substitute.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/formats/compact_detections.h"
+#include "mediapipe/framework/formats/detection.pb.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+// Returns "num_detections" detections with random scores and relative
+// bounding boxes, some of them reaching past the unit square.
+std::vector<Detection> CreateRandomDetections(int num_detections) {
+  std::mt19937 generator(/*seed=*/17);
+  std::uniform_real_distribution<float> position(-0.1f, 1.0f);
+  std::uniform_real_distribution<float> size(0.01f, 0.2f);
+  std::uniform_real_distribution<float> score(0.0f, 1.0f);
+  std::vector<Detection> detections(num_detections);
+  for (auto& detection : detections) {
+    detection.add_score(score(generator));
+    detection.add_label_id(0);
+    auto* location_data = detection.mutable_location_data();
+    location_data->set_format(LocationData::RELATIVE_BOUNDING_BOX);
+    auto* bbox = location_data->mutable_relative_bounding_box();
+    bbox->set_xmin(position(generator));
+    bbox->set_ymin(position(generator));
+    bbox->set_width(size(generator));
+    bbox->set_height(size(generator));
+  }
+  return detections;
+}
+
+// Runs the calculator with "options" on "detections" and stores its output in
+// "retained".
+void RunNonMaxSuppression(const std::string& options,
+                          const std::vector<Detection>& detections,
+                          std::vector<Detection>* retained) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(
+      absl::Substitute(R"(
+        calculator: "NonMaxSuppressionCalculator"
+        input_stream: "detections"
+        output_stream: "retained_detections"
+        options {
+          [mediapipe.NonMaxSuppressionCalculatorOptions.ext] { $0 }
+        }
+      )",
+                       options)));
+  runner.MutableInputs()->Index(0).packets.push_back(
+      MakePacket<std::vector<Detection>>(detections).At(Timestamp(0)));
+  MP_ASSERT_OK(runner.Run());
+  const auto& packets = runner.Outputs().Index(0).packets;
+  ASSERT_EQ(1, packets.size());
+  *retained = packets[0].Get<std::vector<Detection>>();
+}
+
+void ExpectSameDetections(const std::vector<Detection>& expected,
+                          const std::vector<Detection>& actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (int i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i].SerializeAsString(), actual[i].SerializeAsString())
+        << "Detection " << i;
+  }
+}
+
+TEST(NonMaxSuppressionCalculatorTest, GridMatchesAllPairs) {
+  const std::vector<Detection> detections = CreateRandomDetections(500);
+  const std::string options = R"(
+    min_suppression_threshold: 0.3
+    overlap_type: INTERSECTION_OVER_UNION
+  )";
+  std::vector<Detection> expected;
+  RunNonMaxSuppression(options + "grid_cells_per_side: 1", detections,
+                       &expected);
+  EXPECT_LT(0, expected.size());
+  EXPECT_GT(detections.size(), expected.size());
+  std::vector<Detection> retained;
+  RunNonMaxSuppression(options + "grid_cells_per_side: 8", detections,
+                       &retained);
+  ExpectSameDetections(expected, retained);
+  // The automatic grid size.
+  RunNonMaxSuppression(options, detections, &retained);
+  ExpectSameDetections(expected, retained);
+}
+
+TEST(NonMaxSuppressionCalculatorTest, WeightedGridMatchesAllPairs) {
+  const std::vector<Detection> detections = CreateRandomDetections(500);
+  const std::string options = R"(
+    algorithm: WEIGHTED
+    min_suppression_threshold: 0.3
+    overlap_type: INTERSECTION_OVER_UNION
+  )";
+  std::vector<Detection> expected;
+  RunNonMaxSuppression(options + "grid_cells_per_side: 1", detections,
+                       &expected);
+  EXPECT_LT(0, expected.size());
+  EXPECT_GT(detections.size(), expected.size());
+  std::vector<Detection> retained;
+  RunNonMaxSuppression(options + "grid_cells_per_side: 8", detections,
+                       &retained);
+  ExpectSameDetections(expected, retained);
+  // The automatic grid size.
+  RunNonMaxSuppression(options, detections, &retained);
+  ExpectSameDetections(expected, retained);
+}
+
+TEST(NonMaxSuppressionCalculatorTest, MaxNumDetectionsKeepsHighestScores) {
+  const std::vector<Detection> detections = CreateRandomDetections(500);
+  const std::string options = "min_suppression_threshold: 0.3 ";
+  std::vector<Detection> all_retained;
+  RunNonMaxSuppression(options, detections, &all_retained);
+  ASSERT_LT(40, all_retained.size());
+  // Retaining fewer detections only sorts part of them, which must not change
+  // which detections are retained first.
+  for (int max_num_detections : {1, 5, 40}) {
+    std::vector<Detection> retained;
+    RunNonMaxSuppression(options + absl::Substitute("max_num_detections: $0",
+                                                    max_num_detections),
+                         detections, &retained);
+    ExpectSameDetections(
+        std::vector<Detection>(all_retained.begin(),
+                               all_retained.begin() + max_num_detections),
+        retained);
+  }
+}
+
+TEST(NonMaxSuppressionCalculatorTest, WeightedKeepsAllAtMaxThreshold) {
+  // No box overlaps another by more than the default threshold of 1, so every
+  // box is kept as is.
+  const std::vector<Detection> detections = CreateRandomDetections(20);
+  std::vector<Detection> retained;
+  RunNonMaxSuppression("algorithm: WEIGHTED", detections, &retained);
+  EXPECT_EQ(detections.size(), retained.size());
+}
+
+TEST(NonMaxSuppressionCalculatorTest, CompactDetectionsMatchDetections) {
+  const std::vector<Detection> detections = CreateRandomDetections(200);
+  CompactDetections compact_detections;
+  MP_ASSERT_OK(DetectionsToCompactDetections(detections, &compact_detections));
+  for (const std::string& options :
+       {"min_suppression_threshold: 0.3",
+        "min_suppression_threshold: 0.3 algorithm: WEIGHTED"}) {
+    std::vector<Detection> expected;
+    RunNonMaxSuppression(options, detections, &expected);
+
+    CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(
+        absl::Substitute(R"(
+          calculator: "NonMaxSuppressionCalculator"
+          input_stream: "COMPACT_DETECTIONS:detections"
+          output_stream: "COMPACT_DETECTIONS:retained_detections"
+          options {
+            [mediapipe.NonMaxSuppressionCalculatorOptions.ext] { $0 }
+          }
+        )",
+                         options)));
+    runner.MutableInputs()
+        ->Tag("COMPACT_DETECTIONS")
+        .packets.push_back(MakePacket<CompactDetections>(compact_detections)
+                               .At(Timestamp(0)));
+    MP_ASSERT_OK(runner.Run());
+    const auto& packets = runner.Outputs().Tag("COMPACT_DETECTIONS").packets;
+    ASSERT_EQ(1, packets.size());
+    std::vector<Detection> retained;
+    CompactDetectionsToDetections(packets[0].Get<CompactDetections>(),
+                                  &retained);
+    ExpectSameDetections(expected, retained);
+  }
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,96 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <random>
+#include <vector>
+
+#include "mediapipe/framework/formats/detection.pb.h"
+#include "mediapipe/framework/formats/location_data.pb.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/util/calculator_benchmark.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kNumFrames = 30;
+constexpr int64 kFramePeriodUsec = 33333;
+
+// Returns "num_detections" randomly placed, overlapping detections.
+std::vector<Detection> RandomDetections(int num_detections, int seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> position(0.0f, 0.8f);
+  std::uniform_real_distribution<float> size(0.05f, 0.2f);
+  std::uniform_real_distribution<float> score(0.0f, 1.0f);
+  std::vector<Detection> detections(num_detections);
+  for (Detection& detection : detections) {
+    detection.add_label_id(0);
+    detection.add_score(score(rng));
+    LocationData* location_data = detection.mutable_location_data();
+    location_data->set_format(LocationData::RELATIVE_BOUNDING_BOX);
+    LocationData::RelativeBoundingBox* box =
+        location_data->mutable_relative_bounding_box();
+    box->set_xmin(position(rng));
+    box->set_ymin(position(rng));
+    box->set_width(size(rng));
+    box->set_height(size(rng));
+  }
+  return detections;
+}
+
+// The argument is the number of detections per frame.
+void BM_NonMaxSuppression(benchmark::State& state) {
+  CalculatorBenchmark benchmark(R"(
+      calculator: "NonMaxSuppressionCalculator"
+      input_stream: "detections"
+      output_stream: "suppressed_detections"
+      options {
+        [mediapipe.NonMaxSuppressionCalculatorOptions.ext] {
+          min_suppression_threshold: 0.3
+          overlap_type: INTERSECTION_OVER_UNION
+          algorithm: WEIGHTED
+        }
+      })");
+  const int num_detections = state.range(0);
+  benchmark.GenerateInputs("", 0, kNumFrames, kFramePeriodUsec,
+                           [num_detections](int i) {
+                             return MakePacket<std::vector<Detection>>(
+                                 RandomDetections(num_detections, i));
+                           });
+  benchmark.Run(state);
+}
+BENCHMARK(BM_NonMaxSuppression)->Arg(16)->Arg(256)->Arg(2048);
+
+void BM_DetectionsToRenderData(benchmark::State& state) {
+  CalculatorBenchmark benchmark(R"(
+      calculator: "DetectionsToRenderDataCalculator"
+      input_stream: "DETECTIONS:detections"
+      output_stream: "RENDER_DATA:render_data"
+      options {
+        [mediapipe.DetectionsToRenderDataCalculatorOptions.ext] {
+          thickness: 4.0
+          color { r: 255 g: 0 b: 0 }
+        }
+      })");
+  benchmark.GenerateInputs("DETECTIONS", 0, kNumFrames, kFramePeriodUsec,
+                           [](int i) {
+                             return MakePacket<std::vector<Detection>>(
+                                 RandomDetections(16, i));
+                           });
+  benchmark.Run(state);
+}
+BENCHMARK(BM_DetectionsToRenderData);
+
+}  // namespace
+}  // namespace mediapipe
@@ -29,6 +29,7 @@
 #include "mediapipe/framework/formats/image_format.pb.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/formats/motion/compact_optical_flow_field.h"
 #include "mediapipe/framework/formats/motion/optical_flow_field.h"
 #include "mediapipe/framework/port/opencv_core_inc.h"
 #include "mediapipe/framework/port/parse_text_proto.h"
@@ -39,6 +40,8 @@ namespace mediapipe {
 // mediapipe/framework/formats/motion/optical_flow_field.h,
 // returns a VideoFrame with 2 channels (v_x and v_y), each channel is quantized
 // to 0-255.
+// Flow can also be given as a CompactOpticalFlowField on the COMPACT_FLOW input
+// stream, which is read directly without conversion to OpticalFlowField.
 //
 // Example config:
 // node {
@@ -61,11 +64,18 @@ class FlowToImageCalculator : public CalculatorBase {
   ::mediapipe::Status Process(CalculatorContext* cc) override;
 
  private:
+  void ProcessCompactFlow(const CompactOpticalFlowField& input,
+                          ImageFrame* output) const;
+
   FlowQuantizerModel model_;
 };
 
 ::mediapipe::Status FlowToImageCalculator::GetContract(CalculatorContract* cc) {
-  cc->Inputs().Index(0).Set<OpticalFlowField>();
+  if (cc->Inputs().HasTag("COMPACT_FLOW")) {
+    cc->Inputs().Tag("COMPACT_FLOW").Set<CompactOpticalFlowField>();
+  } else {
+    cc->Inputs().Index(0).Set<OpticalFlowField>();
+  }
   cc->Outputs().Index(0).Set<ImageFrame>();
 
   // Model sanity check
@@ -90,6 +100,16 @@ class FlowToImageCalculator : public CalculatorBase {
 }
 
 ::mediapipe::Status FlowToImageCalculator::Process(CalculatorContext* cc) {
+  if (cc->Inputs().HasTag("COMPACT_FLOW")) {
+    const auto& input =
+        cc->Inputs().Tag("COMPACT_FLOW").Get<CompactOpticalFlowField>();
+    std::unique_ptr<ImageFrame> output(
+        new ImageFrame(ImageFormat::SRGB, input.width(), input.height()));
+    ProcessCompactFlow(input, output.get());
+    cc->Outputs().Index(0).Add(output.release(), cc->InputTimestamp());
+    return ::mediapipe::OkStatus();
+  }
+
   const auto& input = cc->Inputs().Index(0).Get<OpticalFlowField>();
   // Input flow is 2-channel with x-dim flow and y-dim flow.
   // Convert it to a ImageFrame in SRGB space, the 3rd channel is not used (0).
@@ -109,6 +129,22 @@ class FlowToImageCalculator : public CalculatorBase {
   return ::mediapipe::OkStatus();
 }
 
+void FlowToImageCalculator::ProcessCompactFlow(
+    const CompactOpticalFlowField& input, ImageFrame* output) const {
+  cv::Mat image = ::mediapipe::formats::MatView(output);
+  const cv::Mat& flow = input.fixed_point_data();
+  const float pixels_per_step = 1.0f / input.steps_per_pixel();
+  for (int j = 0; j != input.height(); ++j) {
+    const cv::Vec2s* flow_row = flow.ptr<cv::Vec2s>(j);
+    cv::Vec3b* image_row = image.ptr<cv::Vec3b>(j);
+    for (int i = 0; i != input.width(); ++i) {
+      image_row[i] =
+          cv::Vec3b(model_.Apply(flow_row[i][0] * pixels_per_step, 0),
+                    model_.Apply(flow_row[i][1] * pixels_per_step, 1), 0);
+    }
+  }
+}
+
 REGISTER_CALCULATOR(FlowToImageCalculator);
 
 }  // namespace mediapipe
@@ -0,0 +1,184 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "mediapipe/calculators/video/motion_detection_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Returns the sum of "n" consecutive bytes.  Kept as a plain loop over bytes,
+// which compilers vectorize.
+uint32 SumBytes(const uint8* data, int n) {
+  uint32 sum = 0;
+  for (int i = 0; i < n; ++i) {
+    sum += data[i];
+  }
+  return sum;
+}
+
+}  // namespace
+
+// Detects motion in a video stream cheaply, to skip expensive processing of
+// frames that do not change, such as inference on a static camera.  Each
+// frame is reduced to the mean luminance of a coarse grid of cells, in a
+// single pass over its pixels, and compared with the last allowed frame.
+// The frame is allowed when enough cells changed, and otherwise only once
+// max_skipped_frames frames in a row were not.
+//
+// Inputs:
+//   IMAGE: An ImageFrame in SRGB, SRGBA or GRAY8 format.
+// Outputs:
+//   ALLOW: A bool, true for the frames to process.
+//   MOTION (optional): A float, the fraction of changed cells.
+//
+// To keep a continuous stream of results, the frames are gated with
+// GateCalculator, and the results are cloned at every frame timestamp with
+// PacketClonerCalculator, so that the latest results are repeated for the
+// skipped frames.
+//
+// Example config:
+//   node {
+//     calculator: "MotionDetectionCalculator"
+//     input_stream: "IMAGE:input_video"
+//     output_stream: "ALLOW:has_motion"
+//   }
+//   node {
+//     calculator: "GateCalculator"
+//     input_stream: "input_video"
+//     input_stream: "ALLOW:has_motion"
+//     output_stream: "gated_video"
+//   }
+//   ... detections from gated_video ...
+//   node {
+//     calculator: "PacketClonerCalculator"
+//     input_stream: "gated_detections"
+//     input_stream: "input_video"
+//     output_stream: "detections"
+//   }
+class MotionDetectionCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Tag("IMAGE").Set<ImageFrame>();
+    cc->Outputs().Tag("ALLOW").Set<bool>();
+    if (cc->Outputs().HasTag("MOTION")) {
+      cc->Outputs().Tag("MOTION").Set<float>();
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    cc->SetOffset(TimestampDiff(0));
+    options_ = cc->Options<MotionDetectionCalculatorOptions>();
+    RET_CHECK_GT(options_.grid_width(), 0);
+    RET_CHECK_GE(options_.max_skipped_frames(), 0);
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    const ImageFrame& frame = cc->Inputs().Tag("IMAGE").Get<ImageFrame>();
+    MP_RETURN_IF_ERROR(ComputeCellMeans(frame, &cell_means_));
+
+    bool allow = true;
+    float motion = 1.0f;
+    if (cell_means_.size() == reference_means_.size()) {
+      int num_changed = 0;
+      for (int i = 0; i < cell_means_.size(); ++i) {
+        if (std::abs(cell_means_[i] - reference_means_[i]) >
+            options_.cell_threshold()) {
+          ++num_changed;
+        }
+      }
+      motion = static_cast<float>(num_changed) / cell_means_.size();
+      allow = motion >= options_.min_changed_fraction() ||
+              (options_.max_skipped_frames() > 0 &&
+               num_skipped_frames_ >= options_.max_skipped_frames());
+    }
+    if (allow) {
+      // Later frames are compared with the last allowed one, so that slow
+      // changes add up.
+      std::swap(reference_means_, cell_means_);
+      num_skipped_frames_ = 0;
+    } else {
+      ++num_skipped_frames_;
+    }
+
+    cc->Outputs().Tag("ALLOW").AddPacket(
+        MakePacket<bool>(allow).At(cc->InputTimestamp()));
+    if (cc->Outputs().HasTag("MOTION")) {
+      cc->Outputs().Tag("MOTION").AddPacket(
+          MakePacket<float>(motion).At(cc->InputTimestamp()));
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+ private:
+  // Computes the mean luminance of each cell of the grid, row by row.  The
+  // luminance is approximated by the mean of the color channels.
+  ::mediapipe::Status ComputeCellMeans(const ImageFrame& frame,
+                                       std::vector<float>* means) {
+    const int channels = frame.NumberOfChannels();
+    RET_CHECK(frame.ByteDepth() == 1 &&
+              (channels == 1 || channels == 3 || channels == 4))
+        << "Unsupported format " << frame.Format();
+    const int grid_width = std::min(options_.grid_width(), frame.Width());
+    const int cell_size = frame.Width() / grid_width;
+    const int grid_height = std::max(1, frame.Height() / cell_size);
+    const int cell_rows = std::min(cell_size, frame.Height());
+
+    std::vector<uint32> sums(grid_width * grid_height, 0);
+    for (int y = 0; y < grid_height * cell_rows; ++y) {
+      const uint8* row = frame.PixelData() + y * frame.WidthStep();
+      uint32* row_sums = &sums[(y / cell_rows) * grid_width];
+      if (channels == 4) {
+        // Skips the alpha channel.
+        for (int x = 0; x < grid_width * cell_size; ++x) {
+          row_sums[x / cell_size] +=
+              row[4 * x] + row[4 * x + 1] + row[4 * x + 2];
+        }
+      } else {
+        for (int cx = 0; cx < grid_width; ++cx) {
+          row_sums[cx] += SumBytes(row + cx * cell_size * channels,
+                                   cell_size * channels);
+        }
+      }
+    }
+
+    const float cell_values =
+        static_cast<float>(cell_size) * cell_rows * std::min(channels, 3);
+    means->resize(sums.size());
+    for (int i = 0; i < sums.size(); ++i) {
+      (*means)[i] = sums[i] / cell_values;
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  MotionDetectionCalculatorOptions options_;
+  // The cell means of the current frame and of the last allowed frame.
+  std::vector<float> cell_means_;
+  std::vector<float> reference_means_;
+  int num_skipped_frames_ = 0;
+};
+REGISTER_CALCULATOR(MotionDetectionCalculator);
+
+}  // namespace mediapipe
@@ -0,0 +1,113 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+
+namespace {
+
+using ::testing::ElementsAre;
+
+constexpr int kWidth = 64;
+constexpr int kHeight = 48;
+
+// Returns a frame filled with "value", where the 8x8 block at the top left is
+// "block_value".
+Packet MakeFrame(ImageFormat::Format format, uint8 value, uint8 block_value) {
+  auto frame = absl::make_unique<ImageFrame>(format, kWidth, kHeight);
+  const int channels = frame->NumberOfChannels();
+  for (int y = 0; y < kHeight; ++y) {
+    uint8* row = frame->MutablePixelData() + y * frame->WidthStep();
+    memset(row, value, kWidth * channels);
+    if (y < 8) {
+      memset(row, block_value, 8 * channels);
+    }
+  }
+  return Adopt(frame.release());
+}
+
+// Runs the calculator on "frames" and returns its ALLOW output.
+std::vector<bool> RunCalculator(const std::string& options,
+                                const std::vector<Packet>& frames) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(
+      absl::StrCat(R"(
+        calculator: "MotionDetectionCalculator"
+        input_stream: "IMAGE:input_video"
+        output_stream: "ALLOW:allow"
+        options {
+          [mediapipe.MotionDetectionCalculatorOptions.ext] {)",
+                   options, "}}")));
+  for (int i = 0; i < frames.size(); ++i) {
+    runner.MutableInputs()->Tag("IMAGE").packets.push_back(
+        frames[i].At(Timestamp(i)));
+  }
+  MP_EXPECT_OK(runner.Run());
+  std::vector<bool> allow;
+  for (const Packet& packet : runner.Outputs().Tag("ALLOW").packets) {
+    allow.push_back(packet.Get<bool>());
+  }
+  return allow;
+}
+
+TEST(MotionDetectionCalculatorTest, AllowsFramesThatChange) {
+  const Packet still = MakeFrame(ImageFormat::GRAY8, 100, 100);
+  const Packet moved = MakeFrame(ImageFormat::GRAY8, 100, 150);
+  // One of the 48 cells changes, over min_changed_fraction.
+  EXPECT_THAT(RunCalculator("grid_width: 8 max_skipped_frames: 0",
+                            {still, still, moved, moved, still}),
+              ElementsAre(true, false, true, false, true));
+}
+
+TEST(MotionDetectionCalculatorTest, IgnoresSmallChanges) {
+  const Packet still = MakeFrame(ImageFormat::SRGB, 100, 100);
+  const Packet noisy = MakeFrame(ImageFormat::SRGB, 102, 104);
+  EXPECT_THAT(RunCalculator("grid_width: 8 max_skipped_frames: 0",
+                            {still, noisy, still}),
+              ElementsAre(true, false, false));
+}
+
+TEST(MotionDetectionCalculatorTest, AccumulatesSlowChanges) {
+  // Each frame differs from the previous one by less than cell_threshold,
+  // but the third one differs enough from the last allowed one.
+  EXPECT_THAT(
+      RunCalculator("grid_width: 8 max_skipped_frames: 0",
+                    {MakeFrame(ImageFormat::GRAY8, 100, 100),
+                     MakeFrame(ImageFormat::GRAY8, 100, 104),
+                     MakeFrame(ImageFormat::GRAY8, 100, 108),
+                     MakeFrame(ImageFormat::GRAY8, 100, 112)}),
+      ElementsAre(true, false, true, false));
+}
+
+TEST(MotionDetectionCalculatorTest, AllowsAfterMaxSkippedFrames) {
+  const Packet still = MakeFrame(ImageFormat::SRGBA, 100, 100);
+  EXPECT_THAT(RunCalculator("grid_width: 8 max_skipped_frames: 2",
+                            {still, still, still, still, still}),
+              ElementsAre(true, false, false, true, false));
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -12,6 +12,14 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mediapipe/calculators/core/packet_resampler_calculator.pb.h"
+#include "mediapipe/calculators/video/opencv_video_decoder_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image_format.pb.h"
 #include "mediapipe/framework/formats/image_frame.h"
@@ -20,6 +28,7 @@
 #include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/port/opencv_video_inc.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/tool/options_util.h"
 #include "mediapipe/framework/tool/status_util.h"
 
 namespace mediapipe {
@@ -45,6 +54,56 @@ ImageFormat::Format GetImageFormat(int num_channels) {
   }
   return format;
 }
+
+// cv::VideoCapture hardware acceleration was added in OpenCV 4.5.2.
+#if CV_VERSION_MAJOR > 4 ||                                  \
+    (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR > 5) || \
+    (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR == 5 && \
+     CV_VERSION_REVISION >= 2)
+#define MEDIAPIPE_OPENCV_VIDEO_ACCELERATION 1
+#endif
+
+#ifdef MEDIAPIPE_OPENCV_VIDEO_ACCELERATION
+cv::VideoAccelerationType GetVideoAccelerationType(
+    OpenCvVideoDecoderCalculatorOptions::HardwareAcceleration acceleration) {
+  switch (acceleration) {
+    case OpenCvVideoDecoderCalculatorOptions::ANY:
+      return cv::VIDEO_ACCELERATION_ANY;
+    case OpenCvVideoDecoderCalculatorOptions::VAAPI:
+      return cv::VIDEO_ACCELERATION_VAAPI;
+    case OpenCvVideoDecoderCalculatorOptions::D3D11:
+      return cv::VIDEO_ACCELERATION_D3D11;
+    case OpenCvVideoDecoderCalculatorOptions::MFX:
+      return cv::VIDEO_ACCELERATION_MFX;
+    default:
+      return cv::VIDEO_ACCELERATION_NONE;
+  }
+}
+#endif  // MEDIAPIPE_OPENCV_VIDEO_ACCELERATION
+
+// Opens the video file, with hardware decoding if requested and supported.
+std::unique_ptr<cv::VideoCapture> OpenVideoCapture(
+    const std::string& input_file_path,
+    const OpenCvVideoDecoderCalculatorOptions& options) {
+  if (options.hw_acceleration() != OpenCvVideoDecoderCalculatorOptions::NONE) {
+#ifdef MEDIAPIPE_OPENCV_VIDEO_ACCELERATION
+    auto cap = absl::make_unique<cv::VideoCapture>(
+        input_file_path, cv::CAP_FFMPEG,
+        std::vector<int>{cv::CAP_PROP_HW_ACCELERATION,
+                         GetVideoAccelerationType(options.hw_acceleration()),
+                         cv::CAP_PROP_HW_DEVICE, options.hw_device()});
+    if (cap->isOpened()) {
+      return cap;
+    }
+    LOG(WARNING) << "Fail to open video file at " << input_file_path
+                 << " with hardware acceleration, using software decoding.";
+#else
+    LOG(WARNING) << "Hardware accelerated decoding needs OpenCV 4.5.2 or "
+                    "later, using software decoding.";
+#endif  // MEDIAPIPE_OPENCV_VIDEO_ACCELERATION
+  }
+  return absl::make_unique<cv::VideoCapture>(input_file_path);
+}
 }  // namespace
 
 // This Calculator takes no input streams and produces video packets.
@@ -58,6 +117,9 @@ ImageFormat::Format GetImageFormat(int num_channels) {
 //       Timestamp::PreStream() for the corresponding stream.
 // Input Side Packets:
 //   INPUT_FILE_PATH: The input file path.
+//   RESAMPLER_OPTIONS:
+//       Optional CalculatorOptions with PacketResamplerCalculatorOptions,
+//       overriding OpenCvVideoDecoderCalculatorOptions.resampler_options.
 //
 // Example config:
 // node {
@@ -66,10 +128,29 @@ ImageFormat::Format GetImageFormat(int num_channels) {
 //   output_stream: "VIDEO:video_frames"
 //   output_stream: "VIDEO_PRESTREAM:video_header"
 // }
+//
+// To decode high resolution video on the GPU or a media engine, add
+//   node_options {
+//     [type.googleapis.com/mediapipe.OpenCvVideoDecoderCalculatorOptions]: {
+//       hw_acceleration: ANY
+//     }
+//   }
+//
+// When the frames are resampled downstream, pass the same resampler options
+// to the decoder to skip the frames PacketResamplerCalculator would drop:
+// node {
+//   calculator: "OpenCvVideoDecoderCalculator"
+//   input_side_packet: "INPUT_FILE_PATH:input_file_path"
+//   input_side_packet: "RESAMPLER_OPTIONS:packet_resampler_options"
+//   output_stream: "VIDEO:video_frames"
+// }
 class OpenCvVideoDecoderCalculator : public CalculatorBase {
  public:
   static ::mediapipe::Status GetContract(CalculatorContract* cc) {
     cc->InputSidePackets().Tag("INPUT_FILE_PATH").Set<std::string>();
+    if (cc->InputSidePackets().HasTag("RESAMPLER_OPTIONS")) {
+      cc->InputSidePackets().Tag("RESAMPLER_OPTIONS").Set<CalculatorOptions>();
+    }
     cc->Outputs().Tag("VIDEO").Set<ImageFrame>();
     if (cc->Outputs().HasTag("VIDEO_PRESTREAM")) {
       cc->Outputs().Tag("VIDEO_PRESTREAM").Set<VideoHeader>();
@@ -80,7 +161,8 @@ class OpenCvVideoDecoderCalculator : public CalculatorBase {
   ::mediapipe::Status Open(CalculatorContext* cc) override {
     const std::string& input_file_path =
         cc->InputSidePackets().Tag("INPUT_FILE_PATH").Get<std::string>();
-    cap_ = absl::make_unique<cv::VideoCapture>(input_file_path);
+    const auto& options = cc->Options<OpenCvVideoDecoderCalculatorOptions>();
+    cap_ = OpenVideoCapture(input_file_path, options);
     if (!cap_->isOpened()) {
       return ::mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
              << "Fail to open video file at " << input_file_path;
@@ -126,6 +208,32 @@ class OpenCvVideoDecoderCalculator : public CalculatorBase {
     }
     // Rewind to the very first frame.
     cap_->set(cv::CAP_PROP_POS_AVI_RATIO, 0);
+
+    const PacketResamplerCalculatorOptions resampler_options =
+        tool::RetrieveOptions(options.resampler_options(),
+                              cc->InputSidePackets(), "RESAMPLER_OPTIONS");
+    if (resampler_options.frame_rate() > 0) {
+      sample_frames_ = true;
+      output_period_us_ = Timestamp::kTimestampUnitsPerSecond /
+                          resampler_options.frame_rate();
+      // The resampler may keep the frame nearest to each output timestamp.
+      max_sample_offset_us_ = 0.5 * Timestamp::kTimestampUnitsPerSecond / fps;
+      // Without base_timestamp, the resampler aligns its output with its
+      // first input frame.
+      has_base_timestamp_ = resampler_options.has_base_timestamp();
+      base_timestamp_us_ = resampler_options.base_timestamp();
+      // The resampler may output frames up to one period outside the limits.
+      if (resampler_options.has_start_time()) {
+        first_sample_us_ = resampler_options.start_time() - output_period_us_;
+        if (first_sample_us_ > 0) {
+          // OpenCV seeks to the preceding keyframe and decodes forward.
+          cap_->set(cv::CAP_PROP_POS_MSEC, first_sample_us_ / 1000.0);
+        }
+      }
+      if (resampler_options.has_end_time()) {
+        last_sample_us_ = resampler_options.end_time() + output_period_us_;
+      }
+    }
     return ::mediapipe::OkStatus();
   }
 
@@ -134,23 +242,38 @@ class OpenCvVideoDecoderCalculator : public CalculatorBase {
                                                      /*alignment_boundary=*/1);
     // Use microsecond as the unit of time.
     Timestamp timestamp(cap_->get(cv::CAP_PROP_POS_MSEC) * 1000);
+    // grab() decodes the next frame; only the frames to output are
+    // retrieved, which converts them to BGR.
+    while (true) {
+      if (sample_frames_ && timestamp.Value() > last_sample_us_) {
+        return tool::StatusStop();
+      }
+      if (!cap_->grab()) {
+        return tool::StatusStop();
+      }
+      if (!sample_frames_ || IsSampled(timestamp.Value())) {
+        break;
+      }
+      timestamp = Timestamp(cap_->get(cv::CAP_PROP_POS_MSEC) * 1000);
+    }
     if (format_ == ImageFormat::GRAY8) {
       cv::Mat frame = formats::MatView(image_frame.get());
-      cap_->read(frame);
+      cap_->retrieve(frame);
       if (frame.empty()) {
         return tool::StatusStop();
       }
     } else {
-      cv::Mat tmp_frame;
-      cap_->read(tmp_frame);
-      if (tmp_frame.empty()) {
+      // tmp_frame_ keeps its buffer across frames, so only the color
+      // conversion into the ImageFrame touches new memory.
+      cap_->retrieve(tmp_frame_);
+      if (tmp_frame_.empty()) {
         return tool::StatusStop();
       }
       if (format_ == ImageFormat::SRGB) {
-        cv::cvtColor(tmp_frame, formats::MatView(image_frame.get()),
+        cv::cvtColor(tmp_frame_, formats::MatView(image_frame.get()),
                      cv::COLOR_BGR2RGB);
       } else if (format_ == ImageFormat::SRGBA) {
-        cv::cvtColor(tmp_frame, formats::MatView(image_frame.get()),
+        cv::cvtColor(tmp_frame_, formats::MatView(image_frame.get()),
                      cv::COLOR_BGRA2RGBA);
       }
     }
@@ -169,7 +292,7 @@ class OpenCvVideoDecoderCalculator : public CalculatorBase {
     if (cap_ && cap_->isOpened()) {
       cap_->release();
     }
-    if (decoded_frames_ != frame_count_) {
+    if (!sample_frames_ && decoded_frames_ != frame_count_) {
       LOG(WARNING) << "Not all the frames are decoded (total frames: "
                    << frame_count_ << " vs decoded frames: " << decoded_frames_
                    << ").";
@@ -178,13 +301,42 @@ class OpenCvVideoDecoderCalculator : public CalculatorBase {
   }
 
  private:
+  // Whether a frame at timestamp_us may be kept by the downstream resampler.
+  bool IsSampled(int64 timestamp_us) {
+    if (timestamp_us < first_sample_us_) {
+      return false;
+    }
+    if (!has_base_timestamp_) {
+      has_base_timestamp_ = true;
+      base_timestamp_us_ = timestamp_us;
+      return true;
+    }
+    const double nearest_output_us =
+        base_timestamp_us_ +
+        std::round((timestamp_us - base_timestamp_us_) / output_period_us_) *
+            output_period_us_;
+    return std::abs(timestamp_us - nearest_output_us) <=
+           max_sample_offset_us_ + 1;
+  }
+
   std::unique_ptr<cv::VideoCapture> cap_;
+  // Decoded BGR(A) frame, reused across Process() calls.
+  cv::Mat tmp_frame_;
   int width_;
   int height_;
   int frame_count_;
   int decoded_frames_ = 0;
   ImageFormat::Format format_;
   Timestamp prev_timestamp_ = Timestamp::Unset();
+
+  // Frame sampling for resampler_options.
+  bool sample_frames_ = false;
+  double output_period_us_ = 0;
+  double max_sample_offset_us_ = 0;
+  bool has_base_timestamp_ = false;
+  int64 base_timestamp_us_ = 0;
+  int64 first_sample_us_ = std::numeric_limits<int64>::min();
+  int64 last_sample_us_ = std::numeric_limits<int64>::max();
 };
 
 REGISTER_CALCULATOR(OpenCvVideoDecoderCalculator);
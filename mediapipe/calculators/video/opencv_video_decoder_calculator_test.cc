@@ -157,5 +157,40 @@ TEST(OpenCvVideoDecoderCalculatorTest, TestMkvVp8Video) {
   }
 }
 
+TEST(OpenCvVideoDecoderCalculatorTest, TestResamplerOptionsSkipFrames) {
+  CalculatorGraphConfig::Node node_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+        calculator: "OpenCvVideoDecoderCalculator"
+        input_side_packet: "INPUT_FILE_PATH:input_file_path"
+        output_stream: "VIDEO:video"
+        node_options {
+          [type.googleapis.com/mediapipe.OpenCvVideoDecoderCalculatorOptions]: {
+            resampler_options {
+              frame_rate: 10.0
+              base_timestamp: 0
+              start_time: 2000000
+              end_time: 4000000
+            }
+          }
+        })");
+  CalculatorRunner runner(node_config);
+  runner.MutableSidePackets()->Tag("INPUT_FILE_PATH") = MakePacket<std::string>(
+      file::JoinPath("./",
+                     "/mediapipe/calculators/video/"
+                     "testdata/format_MP4_AVC720P_AAC.video"));
+  MP_EXPECT_OK(runner.Run());
+
+  // The 30 fps video has one frame on each 10 Hz output timestamp between
+  // start_time and end_time, plus up to one output period on either side.
+  const std::vector<Packet>& packets = runner.Outputs().Tag("VIDEO").packets;
+  EXPECT_GE(packets.size(), 21);
+  EXPECT_LE(packets.size(), 23);
+  for (const Packet& packet : packets) {
+    EXPECT_GE(packet.Timestamp(), Timestamp(1900000 - 1));
+    EXPECT_LE(packet.Timestamp(), Timestamp(4100000 + 1));
+    EXPECT_EQ(1280, packet.Get<ImageFrame>().Width());
+  }
+}
+
 }  // namespace
 }  // namespace mediapipe
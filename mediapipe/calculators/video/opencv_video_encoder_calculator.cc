@@ -12,17 +12,20 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <deque>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "absl/strings/str_split.h"
+#include "absl/synchronization/mutex.h"
 #include "mediapipe/calculators/video/opencv_video_encoder_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
 #include "mediapipe/framework/formats/video_stream_header.h"
 #include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/opencv_highgui_inc.h"
 #include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/port/opencv_video_inc.h"
@@ -30,10 +33,39 @@
 #include "mediapipe/framework/port/source_location.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/port/status_builder.h"
+#include "mediapipe/framework/port/threadpool.h"
 #include "mediapipe/framework/tool/status_util.h"
 
 namespace mediapipe {
 
+namespace {
+// cv::VideoWriter hardware acceleration was added in OpenCV 4.5.2.
+#if CV_VERSION_MAJOR > 4 ||                            \
+    (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR > 5) || \
+    (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR == 5 && \
+     CV_VERSION_REVISION >= 2)
+#define MEDIAPIPE_OPENCV_VIDEO_ACCELERATION 1
+#endif
+
+#ifdef MEDIAPIPE_OPENCV_VIDEO_ACCELERATION
+cv::VideoAccelerationType GetVideoAccelerationType(
+    OpenCvVideoEncoderCalculatorOptions::HardwareAcceleration acceleration) {
+  switch (acceleration) {
+    case OpenCvVideoEncoderCalculatorOptions::ANY:
+      return cv::VIDEO_ACCELERATION_ANY;
+    case OpenCvVideoEncoderCalculatorOptions::VAAPI:
+      return cv::VIDEO_ACCELERATION_VAAPI;
+    case OpenCvVideoEncoderCalculatorOptions::D3D11:
+      return cv::VIDEO_ACCELERATION_D3D11;
+    case OpenCvVideoEncoderCalculatorOptions::MFX:
+      return cv::VIDEO_ACCELERATION_MFX;
+    default:
+      return cv::VIDEO_ACCELERATION_NONE;
+  }
+}
+#endif  // MEDIAPIPE_OPENCV_VIDEO_ACCELERATION
+}  // namespace
+
 // Encodes the input video stream and produces a media file.
 // The media file can be output to the output_file_path specified as a side
 // packet. Currently, the calculator only supports one video stream (in
@@ -53,6 +85,10 @@ namespace mediapipe {
 //     }
 //   }
 // }
+//
+// With max_queued_frames set, frames are encoded on a dedicated thread, so
+// encoding overlaps with the rest of the graph. The input packets are queued
+// without copying, and Process() only blocks while the queue is full.
 class OpenCvVideoEncoderCalculator : public CalculatorBase {
  public:
   static ::mediapipe::Status GetContract(CalculatorContract* cc);
@@ -63,9 +99,27 @@ class OpenCvVideoEncoderCalculator : public CalculatorBase {
  private:
   ::mediapipe::Status SetUpVideoWriter(float frame_rate, int width, int height);
 
+  // Converts the ImageFrame in "packet" to BGR and encodes it.
+  ::mediapipe::Status WriteFrame(const Packet& packet);
+
+  // Encodes queued frames until the input is done, on encoder_thread_.
+  void EncodeQueuedFrames();
+
   std::string output_file_path_;
   int four_cc_;
+  OpenCvVideoEncoderCalculatorOptions::HardwareAcceleration hw_acceleration_;
   std::unique_ptr<cv::VideoWriter> writer_;
+  // Reused buffer for the BGR frame.
+  cv::Mat bgr_frame_;
+
+  // Asynchronous encoding.
+  int max_queued_frames_ = 0;
+  std::unique_ptr<ThreadPool> encoder_thread_;
+  absl::Mutex mutex_;
+  std::deque<Packet> queued_frames_ GUARDED_BY(mutex_);
+  bool input_done_ GUARDED_BY(mutex_) = false;
+  // The first error from the encoder thread.
+  ::mediapipe::Status encoder_status_ GUARDED_BY(mutex_);
 };
 
 ::mediapipe::Status OpenCvVideoEncoderCalculator::GetContract(
@@ -89,6 +143,8 @@ class OpenCvVideoEncoderCalculator : public CalculatorBase {
   const char* codec_array = options.codec().c_str();
   four_cc_ = mediapipe::fourcc(codec_array[0], codec_array[1], codec_array[2],
                                codec_array[3]);
+  hw_acceleration_ = options.hw_acceleration();
+  max_queued_frames_ = options.max_queued_frames();
   RET_CHECK(!options.video_format().empty())
       << "Video format must be specified in "
          "OpenCvVideoEncoderCalculatorOptions";
@@ -118,44 +174,95 @@ class OpenCvVideoEncoderCalculator : public CalculatorBase {
                             video_header.height);
   }
 
-  const ImageFrame& image_frame =
-      cc->Inputs().Tag("VIDEO").Value().Get<ImageFrame>();
+  const Packet& packet = cc->Inputs().Tag("VIDEO").Value();
+  if (max_queued_frames_ <= 0) {
+    return WriteFrame(packet);
+  }
+  absl::MutexLock lock(&mutex_);
+  auto can_queue = [this]() EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return static_cast<int>(queued_frames_.size()) < max_queued_frames_ ||
+           !encoder_status_.ok();
+  };
+  mutex_.Await(absl::Condition(&can_queue));
+  MP_RETURN_IF_ERROR(encoder_status_);
+  queued_frames_.push_back(packet);
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status OpenCvVideoEncoderCalculator::WriteFrame(
+    const Packet& packet) {
+  const ImageFrame& image_frame = packet.Get<ImageFrame>();
   ImageFormat::Format format = image_frame.Format();
   cv::Mat frame;
   if (format == ImageFormat::GRAY8) {
     frame = formats::MatView(&image_frame);
     if (frame.empty()) {
       return ::mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
-             << "Receive empty frame at timestamp "
-             << cc->Inputs().Tag("VIDEO").Value().Timestamp()
+             << "Receive empty frame at timestamp " << packet.Timestamp()
              << " in OpenCvVideoEncoderCalculator::Process()";
     }
   } else {
     cv::Mat tmp_frame = formats::MatView(&image_frame);
     if (tmp_frame.empty()) {
       return ::mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
-             << "Receive empty frame at timestamp "
-             << cc->Inputs().Tag("VIDEO").Value().Timestamp()
+             << "Receive empty frame at timestamp " << packet.Timestamp()
              << " in OpenCvVideoEncoderCalculator::Process()";
     }
     if (format == ImageFormat::SRGB) {
-      cv::cvtColor(tmp_frame, frame, cv::COLOR_RGB2BGR);
+      cv::cvtColor(tmp_frame, bgr_frame_, cv::COLOR_RGB2BGR);
     } else if (format == ImageFormat::SRGBA) {
-      cv::cvtColor(tmp_frame, frame, cv::COLOR_RGBA2BGR);
+      cv::cvtColor(tmp_frame, bgr_frame_, cv::COLOR_RGBA2BGR);
     } else {
       return ::mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
              << "Unsupported image format: " << format;
     }
+    frame = bgr_frame_;
   }
   writer_->write(frame);
   return ::mediapipe::OkStatus();
 }
 
+void OpenCvVideoEncoderCalculator::EncodeQueuedFrames() {
+  auto has_work = [this]() EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return !queued_frames_.empty() || input_done_;
+  };
+  while (true) {
+    Packet packet;
+    {
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(&has_work));
+      if (queued_frames_.empty()) {
+        return;
+      }
+      packet = queued_frames_.front();
+    }
+    // The frame stays in the queue while it is encoded, so that it counts
+    // towards max_queued_frames.
+    ::mediapipe::Status status = WriteFrame(packet);
+    absl::MutexLock lock(&mutex_);
+    queued_frames_.pop_front();
+    if (!status.ok()) {
+      encoder_status_ = status;
+      queued_frames_.clear();
+      return;
+    }
+  }
+}
+
 ::mediapipe::Status OpenCvVideoEncoderCalculator::Close(CalculatorContext* cc) {
+  if (encoder_thread_) {
+    {
+      absl::MutexLock lock(&mutex_);
+      input_done_ = true;
+    }
+    // Waits for the queued frames to be encoded.
+    encoder_thread_.reset();
+  }
   if (writer_ && writer_->isOpened()) {
     writer_->release();
   }
-  return ::mediapipe::OkStatus();
+  absl::MutexLock lock(&mutex_);
+  return encoder_status_;
 }
 
 ::mediapipe::Status OpenCvVideoEncoderCalculator::SetUpVideoWriter(
@@ -163,12 +270,34 @@ class OpenCvVideoEncoderCalculator : public CalculatorBase {
   RET_CHECK(frame_rate > 0 && width > 0 && height > 0)
       << "Invalid video metadata: frame_rate=" << frame_rate
       << ", width=" << width << ", height=" << height;
-  writer_ = absl::make_unique<cv::VideoWriter>(
-      output_file_path_, four_cc_, frame_rate, cv::Size(width, height));
+  if (hw_acceleration_ != OpenCvVideoEncoderCalculatorOptions::NONE) {
+#ifdef MEDIAPIPE_OPENCV_VIDEO_ACCELERATION
+    writer_ = absl::make_unique<cv::VideoWriter>(
+        output_file_path_, four_cc_, frame_rate, cv::Size(width, height),
+        std::vector<int>{cv::VIDEOWRITER_PROP_HW_ACCELERATION,
+                         GetVideoAccelerationType(hw_acceleration_)});
+    if (!writer_->isOpened()) {
+      LOG(WARNING) << "Fail to open file at " << output_file_path_
+                   << " with hardware acceleration, using software encoding.";
+    }
+#else
+    LOG(WARNING) << "Hardware accelerated encoding needs OpenCV 4.5.2 or "
+                    "later, using software encoding.";
+#endif  // MEDIAPIPE_OPENCV_VIDEO_ACCELERATION
+  }
+  if (!writer_ || !writer_->isOpened()) {
+    writer_ = absl::make_unique<cv::VideoWriter>(
+        output_file_path_, four_cc_, frame_rate, cv::Size(width, height));
+  }
   if (!writer_->isOpened()) {
     return ::mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
            << "Fail to open file at " << output_file_path_;
   }
+  if (max_queued_frames_ > 0) {
+    encoder_thread_ = absl::make_unique<ThreadPool>("video_encoder", 1);
+    encoder_thread_->StartWorkers();
+    encoder_thread_->Schedule([this] { EncodeQueuedFrames(); });
+  }
   return ::mediapipe::OkStatus();
 }
 
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "absl/strings/substitute.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/deps/file_path.h"
 #include "mediapipe/framework/formats/deleting_file.h"
@@ -155,6 +156,56 @@ TEST(OpenCvVideoEncoderCalculatorTest, TestFlvH264Video) {
   //                            cap.get(cv::CAP_PROP_FPS)));
 }
 
+// Encodes the FLV test video as MJPG and returns the number of encoded frames.
+int EncodeFlvVideo(int max_queued_frames, const std::string& output_file_path) {
+  CalculatorGraphConfig config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(absl::Substitute(R"(
+    node {
+      calculator: "OpenCvVideoDecoderCalculator"
+      input_side_packet: "INPUT_FILE_PATH:input_file_path"
+      output_stream: "VIDEO:video"
+      output_stream: "VIDEO_PRESTREAM:video_prestream"
+    }
+    node {
+      calculator: "OpenCvVideoEncoderCalculator"
+      input_stream: "VIDEO:video"
+      input_stream: "VIDEO_PRESTREAM:video_prestream"
+      input_side_packet: "OUTPUT_FILE_PATH:output_file_path"
+      node_options {
+        [type.googleapis.com/mediapipe.OpenCvVideoEncoderCalculatorOptions]: {
+          codec: "MJPG"
+          video_format: "avi"
+          max_queued_frames: $0
+        }
+      }
+    }
+  )",
+                       max_queued_frames));
+  std::map<std::string, Packet> input_side_packets;
+  input_side_packets["input_file_path"] = MakePacket<std::string>(
+      file::JoinPath("./",
+                     "/mediapipe/calculators/video/"
+                     "testdata/format_FLV_H264_AAC.video"));
+  input_side_packets["output_file_path"] =
+      MakePacket<std::string>(output_file_path);
+  CalculatorGraph graph;
+  MP_EXPECT_OK(graph.Initialize(config, input_side_packets));
+  MP_EXPECT_OK(graph.Run());
+  cv::VideoCapture cap(output_file_path);
+  EXPECT_TRUE(cap.isOpened());
+  return static_cast<int>(cap.get(cv::CAP_PROP_FRAME_COUNT));
+}
+
+TEST(OpenCvVideoEncoderCalculatorTest, AsyncEncodingMatchesSync) {
+  const std::string sync_file_path = "/tmp/tmp_video_sync.avi";
+  DeletingFile deleting_sync_file(sync_file_path, true);
+  const std::string async_file_path = "/tmp/tmp_video_async.avi";
+  DeletingFile deleting_async_file(async_file_path, true);
+  const int num_frames = EncodeFlvVideo(0, sync_file_path);
+  EXPECT_GT(num_frames, 0);
+  EXPECT_EQ(num_frames, EncodeFlvVideo(4, async_file_path));
+}
+
 TEST(OpenCvVideoEncoderCalculatorTest, TestMkvVp8Video) {
   CalculatorGraphConfig config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
     node {
@@ -0,0 +1,272 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "mediapipe/calculators/video/parallel_video_decoder_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/formats/video_stream_header.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+#include "mediapipe/framework/port/opencv_video_inc.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/threadpool.h"
+#include "mediapipe/framework/tool/status_util.h"
+#include "mediapipe/util/cpu_util.h"
+
+namespace mediapipe {
+
+namespace {
+// Same as in OpenCvVideoDecoderCalculator.
+ImageFormat::Format GetImageFormat(int num_channels) {
+  switch (num_channels) {
+    case 1:
+      return ImageFormat::GRAY8;
+    case 3:
+      return ImageFormat::SRGB;
+    case 4:
+      return ImageFormat::SRGBA;
+    default:
+      return ImageFormat::UNKNOWN;
+  }
+}
+
+// Decoded frames of one segment, in decoding order.
+struct DecodedSegment {
+  std::vector<std::pair<Timestamp, std::unique_ptr<ImageFrame>>> frames;
+  // True if the video ended before the end of the segment.
+  bool reached_end = false;
+};
+}  // namespace
+
+// Decodes a video file like OpenCvVideoDecoderCalculator, but splits it into
+// segments of consecutive frames that are decoded concurrently, each with its
+// own cv::VideoCapture. Seeking to a segment decodes forward from the keyframe
+// before it, so segments much longer than the keyframe interval keep that
+// overhead small. Frames are output in timestamp order, a batch of
+// num_threads segments per Process() call. This is meant for offline
+// processing of long files where a single decoding thread is the bottleneck.
+//
+// Frame-accurate seeking relies on the video having a constant frame rate.
+//
+// Output Streams:
+//   VIDEO: Output video frames (ImageFrame).
+//   VIDEO_PRESTREAM:
+//       Optional video header information output at
+//       Timestamp::PreStream() for the corresponding stream.
+// Input Side Packets:
+//   INPUT_FILE_PATH: The input file path.
+//
+// Example config:
+// node {
+//   calculator: "ParallelVideoDecoderCalculator"
+//   input_side_packet: "INPUT_FILE_PATH:input_file_path"
+//   output_stream: "VIDEO:video_frames"
+//   output_stream: "VIDEO_PRESTREAM:video_header"
+//   node_options {
+//     [type.googleapis.com/mediapipe.ParallelVideoDecoderCalculatorOptions]: {
+//       num_threads: 8
+//       segment_frames: 128
+//     }
+//   }
+// }
+class ParallelVideoDecoderCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->InputSidePackets().Tag("INPUT_FILE_PATH").Set<std::string>();
+    cc->Outputs().Tag("VIDEO").Set<ImageFrame>();
+    if (cc->Outputs().HasTag("VIDEO_PRESTREAM")) {
+      cc->Outputs().Tag("VIDEO_PRESTREAM").Set<VideoHeader>();
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override;
+  ::mediapipe::Status Process(CalculatorContext* cc) override;
+  ::mediapipe::Status Close(CalculatorContext* cc) override;
+
+ private:
+  // Decodes up to segment_frames_ frames starting at frame first_frame.
+  void DecodeSegment(cv::VideoCapture* cap, int first_frame,
+                     DecodedSegment* segment);
+
+  // One capture per concurrently decoded segment.
+  std::vector<std::unique_ptr<cv::VideoCapture>> captures_;
+  std::unique_ptr<ThreadPool> pool_;
+  int segment_frames_;
+  int width_;
+  int height_;
+  int frame_count_;
+  ImageFormat::Format format_;
+  int next_frame_ = 0;
+  int decoded_frames_ = 0;
+  Timestamp prev_timestamp_ = Timestamp::Unset();
+};
+REGISTER_CALCULATOR(ParallelVideoDecoderCalculator);
+
+::mediapipe::Status ParallelVideoDecoderCalculator::Open(
+    CalculatorContext* cc) {
+  const auto& options = cc->Options<ParallelVideoDecoderCalculatorOptions>();
+  const std::string& input_file_path =
+      cc->InputSidePackets().Tag("INPUT_FILE_PATH").Get<std::string>();
+  RET_CHECK_GT(options.segment_frames(), 0);
+  segment_frames_ = options.segment_frames();
+  const int num_threads =
+      options.num_threads() > 0 ? options.num_threads() : NumCPUCores();
+
+  for (int i = 0; i < num_threads; ++i) {
+    auto cap = absl::make_unique<cv::VideoCapture>(input_file_path);
+    if (!cap->isOpened()) {
+      return ::mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "Fail to open video file at " << input_file_path;
+    }
+    captures_.push_back(std::move(cap));
+  }
+  cv::VideoCapture* cap = captures_[0].get();
+  width_ = static_cast<int>(cap->get(cv::CAP_PROP_FRAME_WIDTH));
+  height_ = static_cast<int>(cap->get(cv::CAP_PROP_FRAME_HEIGHT));
+  const double fps = static_cast<double>(cap->get(cv::CAP_PROP_FPS));
+  frame_count_ = static_cast<int>(cap->get(cv::CAP_PROP_FRAME_COUNT));
+  // As in OpenCvVideoDecoderCalculator, the number of channels is only known
+  // after reading a frame.
+  cv::Mat frame;
+  cap->read(frame);
+  if (frame.empty()) {
+    return ::mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+           << "Fail to read any frames from the video file at "
+           << input_file_path;
+  }
+  format_ = GetImageFormat(frame.channels());
+  if (format_ == ImageFormat::UNKNOWN) {
+    return ::mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+           << "Unsupported video format of the video file at "
+           << input_file_path;
+  }
+  if (fps <= 0 || frame_count_ <= 0 || width_ <= 0 || height_ <= 0) {
+    return ::mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+           << "Fail to make video header due to the incorrect metadata from "
+              "the video file at "
+           << input_file_path;
+  }
+  if (cc->Outputs().HasTag("VIDEO_PRESTREAM")) {
+    auto header = absl::make_unique<VideoHeader>();
+    header->format = format_;
+    header->width = width_;
+    header->height = height_;
+    header->frame_rate = fps;
+    header->duration = frame_count_ / fps;
+    cc->Outputs()
+        .Tag("VIDEO_PRESTREAM")
+        .Add(header.release(), Timestamp::PreStream());
+  }
+
+  if (num_threads > 1) {
+    pool_ = absl::make_unique<ThreadPool>("video_segments", num_threads - 1);
+    pool_->StartWorkers();
+  }
+  return ::mediapipe::OkStatus();
+}
+
+void ParallelVideoDecoderCalculator::DecodeSegment(cv::VideoCapture* cap,
+                                                   int first_frame,
+                                                   DecodedSegment* segment) {
+  cap->set(cv::CAP_PROP_POS_FRAMES, first_frame);
+  cv::Mat bgr_frame;
+  for (int i = 0; i < segment_frames_; ++i) {
+    // Use microsecond as the unit of time.
+    const Timestamp timestamp(cap->get(cv::CAP_PROP_POS_MSEC) * 1000);
+    auto image_frame = absl::make_unique<ImageFrame>(format_, width_, height_,
+                                                     /*alignment_boundary=*/1);
+    if (format_ == ImageFormat::GRAY8) {
+      cv::Mat frame = formats::MatView(image_frame.get());
+      cap->read(frame);
+      if (frame.empty()) {
+        segment->reached_end = true;
+        return;
+      }
+    } else {
+      cap->read(bgr_frame);
+      if (bgr_frame.empty()) {
+        segment->reached_end = true;
+        return;
+      }
+      cv::cvtColor(bgr_frame, formats::MatView(image_frame.get()),
+                   format_ == ImageFormat::SRGB ? cv::COLOR_BGR2RGB
+                                                : cv::COLOR_BGRA2RGBA);
+    }
+    segment->frames.emplace_back(timestamp, std::move(image_frame));
+  }
+}
+
+::mediapipe::Status ParallelVideoDecoderCalculator::Process(
+    CalculatorContext* cc) {
+  const int num_segments = captures_.size();
+  std::vector<DecodedSegment> segments(num_segments);
+  // Segment 0 is decoded on the calling thread.
+  absl::BlockingCounter pending(num_segments - 1);
+  for (int i = 1; i < num_segments; ++i) {
+    pool_->Schedule([this, &segments, &pending, i] {
+      DecodeSegment(captures_[i].get(), next_frame_ + i * segment_frames_,
+                    &segments[i]);
+      pending.DecrementCount();
+    });
+  }
+  DecodeSegment(captures_[0].get(), next_frame_, &segments[0]);
+  pending.Wait();
+  next_frame_ += num_segments * segment_frames_;
+
+  for (DecodedSegment& segment : segments) {
+    for (auto& frame : segment.frames) {
+      // As in OpenCvVideoDecoderCalculator, frames whose timestamps do not
+      // increase are discarded.
+      if (prev_timestamp_ < frame.first) {
+        cc->Outputs().Tag("VIDEO").Add(frame.second.release(), frame.first);
+        prev_timestamp_ = frame.first;
+        ++decoded_frames_;
+      }
+    }
+    if (segment.reached_end) {
+      return tool::StatusStop();
+    }
+  }
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status ParallelVideoDecoderCalculator::Close(
+    CalculatorContext* cc) {
+  // Waits for the workers to finish.
+  pool_.reset();
+  for (auto& cap : captures_) {
+    if (cap->isOpened()) {
+      cap->release();
+    }
+  }
+  if (decoded_frames_ != frame_count_) {
+    LOG(WARNING) << "Not all the frames are decoded (total frames: "
+                 << frame_count_ << " vs decoded frames: " << decoded_frames_
+                 << ").";
+  }
+  return ::mediapipe::OkStatus();
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,77 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/deps/file_path.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/formats/video_stream_header.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Decodes the test video with the given calculator and options.
+std::vector<Packet> DecodeVideo(const std::string& calculator,
+                                const std::string& options) {
+  CalculatorGraphConfig::Node node_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig::Node>(
+          "calculator: \"" + calculator + "\"" + R"(
+            input_side_packet: "INPUT_FILE_PATH:input_file_path"
+            output_stream: "VIDEO:video"
+            output_stream: "VIDEO_PRESTREAM:video_prestream")" +
+          options);
+  CalculatorRunner runner(node_config);
+  runner.MutableSidePackets()->Tag("INPUT_FILE_PATH") = MakePacket<std::string>(
+      file::JoinPath("./",
+                     "/mediapipe/calculators/video/"
+                     "testdata/format_MP4_AVC720P_AAC.video"));
+  MP_EXPECT_OK(runner.Run());
+  EXPECT_EQ(1, runner.Outputs().Tag("VIDEO_PRESTREAM").packets.size());
+  return runner.Outputs().Tag("VIDEO").packets;
+}
+
+TEST(ParallelVideoDecoderCalculatorTest, MatchesSequentialDecoder) {
+  const std::vector<Packet> expected =
+      DecodeVideo("OpenCvVideoDecoderCalculator", "");
+  // Segments shorter than the video, and a last batch that is not full.
+  const std::vector<Packet> packets =
+      DecodeVideo("ParallelVideoDecoderCalculator", R"(
+    node_options {
+      [type.googleapis.com/mediapipe.ParallelVideoDecoderCalculatorOptions]: {
+        num_threads: 4
+        segment_frames: 25
+      }
+    })");
+  ASSERT_EQ(180, expected.size());
+  ASSERT_EQ(expected.size(), packets.size());
+  for (int i = 0; i < packets.size(); ++i) {
+    EXPECT_EQ(expected[i].Timestamp(), packets[i].Timestamp());
+    const cv::Mat expected_mat =
+        formats::MatView(&expected[i].Get<ImageFrame>());
+    const cv::Mat mat = formats::MatView(&packets[i].Get<ImageFrame>());
+    ASSERT_EQ(expected_mat.size(), mat.size());
+    EXPECT_EQ(0, cv::norm(expected_mat, mat, cv::NORM_INF)) << "Frame " << i;
+  }
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -14,6 +14,7 @@
 
 #include "absl/base/macros.h"
 #include "absl/synchronization/mutex.h"
+#include "mediapipe/calculators/video/tvl1_optical_flow_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
@@ -54,6 +55,10 @@ cv::Mat ConvertToGrayscale(const cv::Mat& image) {
 // packets will be automatically ordered by timestamp before they are passed
 // along to downstream calculators.
 //
+// By default the Dual TV-L1 method is used. The DIS method, which is much
+// faster at a small cost in accuracy, can be selected in
+// Tvl1OpticalFlowCalculatorOptions.
+//
 // Inputs:
 //   FIRST_FRAME: An ImageFrame in either SRGB or GRAY8 format.
 //   SECOND_FRAME: An ImageFrame in either SRGB or GRAY8 format.
@@ -70,6 +75,11 @@ cv::Mat ConvertToGrayscale(const cv::Mat& image) {
 //     output_stream: "FORWARD_FLOW:forward_flow"
 //     output_stream: "BACKWARD_FLOW:backward_flow"
 //     max_in_flight: 10
+//     options {
+//       [mediapipe.Tvl1OpticalFlowCalculatorOptions.ext] {
+//         method: DIS
+//       }
+//     }
 //   }
 //   num_threads: 10
 class Tvl1OpticalFlowCalculator : public CalculatorBase {
@@ -82,13 +92,17 @@ class Tvl1OpticalFlowCalculator : public CalculatorBase {
   ::mediapipe::Status CalculateOpticalFlow(const ImageFrame& current_frame,
                                            const ImageFrame& next_frame,
                                            OpticalFlowField* flow);
+  // Creates a DenseOpticalFlow object for the configured method.
+  cv::Ptr<cv::DenseOpticalFlow> CreateFlowComputer() const;
+
+  Tvl1OpticalFlowCalculatorOptions options_;
   bool forward_requested_ = false;
   bool backward_requested_ = false;
   // Stores the idle DenseOpticalFlow objects.
   // cv::DenseOpticalFlow is not thread-safe. Invoking multiple
   // DenseOpticalFlow::calc() in parallel may lead to memory corruption or
   // memory leak.
-  std::list<cv::Ptr<cv::DenseOpticalFlow>> tvl1_computers_ GUARDED_BY(mutex_);
+  std::list<cv::Ptr<cv::DenseOpticalFlow>> flow_computers_ GUARDED_BY(mutex_);
   absl::Mutex mutex_;
 };
 
@@ -112,9 +126,16 @@ class Tvl1OpticalFlowCalculator : public CalculatorBase {
 }
 
 ::mediapipe::Status Tvl1OpticalFlowCalculator::Open(CalculatorContext* cc) {
+  options_ = cc->Options<Tvl1OpticalFlowCalculatorOptions>();
+#if CV_MAJOR_VERSION < 4
+  if (options_.method() == Tvl1OpticalFlowCalculatorOptions::DIS) {
+    return ::mediapipe::UnimplementedError(
+        "The DIS optical flow method requires OpenCV 4 or later.");
+  }
+#endif  // CV_MAJOR_VERSION < 4
   {
     absl::MutexLock lock(&mutex_);
-    tvl1_computers_.emplace_back(cv::createOptFlow_DualTVL1());
+    flow_computers_.emplace_back(CreateFlowComputer());
   }
   if (cc->Outputs().HasTag("FORWARD_FLOW")) {
     forward_requested_ = true;
@@ -162,30 +183,41 @@ class Tvl1OpticalFlowCalculator : public CalculatorBase {
 
   // Tries getting an idle DenseOpticalFlow object from the cache. If not,
   // creates a new DenseOpticalFlow.
-  cv::Ptr<cv::DenseOpticalFlow> tvl1_computer;
+  cv::Ptr<cv::DenseOpticalFlow> flow_computer;
   {
     absl::MutexLock lock(&mutex_);
-    if (!tvl1_computers_.empty()) {
-      std::swap(tvl1_computer, tvl1_computers_.front());
-      tvl1_computers_.pop_front();
+    if (!flow_computers_.empty()) {
+      std::swap(flow_computer, flow_computers_.front());
+      flow_computers_.pop_front();
     }
   }
-  if (tvl1_computer.empty()) {
-    tvl1_computer = cv::createOptFlow_DualTVL1();
+  if (flow_computer.empty()) {
+    flow_computer = CreateFlowComputer();
   }
 
   flow->Allocate(first.cols, first.rows);
   cv::Mat cv_flow(flow->mutable_flow_data());
-  tvl1_computer->calc(first, second, cv_flow);
+  flow_computer->calc(first, second, cv_flow);
   CHECK_EQ(flow->mutable_flow_data().data, cv_flow.data);
   // Inserts the idle DenseOpticalFlow object back to the cache for reuse.
   {
     absl::MutexLock lock(&mutex_);
-    tvl1_computers_.push_back(tvl1_computer);
+    flow_computers_.push_back(flow_computer);
   }
   return ::mediapipe::OkStatus();
 }
 
+cv::Ptr<cv::DenseOpticalFlow> Tvl1OpticalFlowCalculator::CreateFlowComputer()
+    const {
+#if CV_MAJOR_VERSION >= 4
+  if (options_.method() == Tvl1OpticalFlowCalculatorOptions::DIS) {
+    // The DisPreset values match cv::DISOpticalFlow's presets.
+    return cv::DISOpticalFlow::create(options_.dis_preset());
+  }
+#endif  // CV_MAJOR_VERSION >= 4
+  return cv::createOptFlow_DualTVL1();
+}
+
 REGISTER_CALCULATOR(Tvl1OpticalFlowCalculator);
 
 }  // namespace mediapipe
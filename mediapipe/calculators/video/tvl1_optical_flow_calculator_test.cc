@@ -57,7 +57,8 @@ void AddInputPackets(int num_packets, CalculatorGraph* graph) {
   MP_ASSERT_OK(graph->CloseAllInputStreams());
 }
 
-void RunTest(int num_input_packets, int max_in_flight) {
+void RunTest(int num_input_packets, int max_in_flight,
+             const std::string& method = "TVL1") {
   CalculatorGraphConfig config = ParseTextProtoOrDie<CalculatorGraphConfig>(
       absl::Substitute(R"(
     input_stream: "first_frames"
@@ -69,10 +70,13 @@ void RunTest(int num_input_packets, int max_in_flight) {
       output_stream: "FORWARD_FLOW:forward_flow"
       output_stream: "BACKWARD_FLOW:backward_flow"
       max_in_flight: $0
+      options {
+        [mediapipe.Tvl1OpticalFlowCalculatorOptions.ext] { method: $1 }
+      }
     }
     num_threads: $0
   )",
-                       max_in_flight));
+                       max_in_flight, method));
   CalculatorGraph graph;
   MP_ASSERT_OK(graph.Initialize(config));
   StatusOrPoller status_or_poller1 =
@@ -123,5 +127,11 @@ TEST(Tvl1OpticalFlowCalculatorTest, TestParallelExecution) {
   RunTest(/*num_input_packets=*/20, /*max_in_flight=*/10);
 }
 
+#if CV_MAJOR_VERSION >= 4
+TEST(Tvl1OpticalFlowCalculatorTest, TestDisMethod) {
+  RunTest(/*num_input_packets=*/2, /*max_in_flight=*/1, "DIS");
+}
+#endif  // CV_MAJOR_VERSION >= 4
+
 }  // namespace
 }  // namespace mediapipe
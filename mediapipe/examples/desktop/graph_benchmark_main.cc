@@ -0,0 +1,358 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// A main function to benchmark a MediaPipe graph on synthetic input frames or
+// recorded traffic. It feeds generated ImageFrames into one graph input
+// stream for a fixed duration, or plays back a packet log written by
+// PacketRecorderCalculator into the graph input streams it recorded, and
+// reports the end-to-end throughput, the per-frame latency percentiles from
+// input to output stream, and the CPU time and peak memory of the process as
+// a single line of JSON.
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/commandlineflags.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/map_util.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/util/packet_log.h"
+
+DEFINE_string(
+    calculator_graph_config_file, "",
+    "Name of file containing text format CalculatorGraphConfig proto.");
+
+DEFINE_string(input_side_packets, "",
+              "Comma-separated list of key=value pairs specifying side packets "
+              "for the CalculatorGraph. All values will be treated as the "
+              "string type even if they represent doubles, floats, etc.");
+
+DEFINE_string(input_stream, "input_video",
+              "The graph input stream that receives the generated frames.");
+
+DEFINE_string(output_stream, "output_video",
+              "The graph output stream whose packets end the frame latency.");
+
+DEFINE_string(input_generator, "image_frame:640x480",
+              "The frames to generate, as \"image_frame:WIDTHxHEIGHT\" for "
+              "SRGB frames or \"image_frame:WIDTHxHEIGHT:srgba\" for SRGBA "
+              "frames.");
+
+DEFINE_double(input_fps, 0,
+              "The rate at which frames are sent. If 0, frames are sent as "
+              "fast as the graph accepts them.");
+
+DEFINE_double(duration_seconds, 10,
+              "How long to send frames for. Ignored with input_log.");
+
+DEFINE_string(input_log, "",
+              "A packet log written by PacketRecorderCalculator to play back "
+              "instead of generating frames. Each recorded stream is sent to "
+              "the graph input stream of the same name, and frame latencies "
+              "are measured for the packets of input_stream.");
+
+DEFINE_bool(replay_realtime, false,
+            "If true, the packets of input_log are sent at the intervals at "
+            "which they were recorded. Otherwise they are sent as fast as the "
+            "graph accepts them.");
+
+DEFINE_string(report_file, "",
+              "The file to write the JSON report to. If empty, the report is "
+              "printed to stdout.");
+
+namespace mediapipe {
+
+namespace {
+
+// Parses the input_generator flag into a frame format and size.
+::mediapipe::Status ParseInputGenerator(const std::string& spec,
+                                        ImageFormat::Format* format,
+                                        int* width, int* height) {
+  std::vector<std::string> fields = absl::StrSplit(spec, ':');
+  RET_CHECK(fields.size() == 2 || fields.size() == 3)
+      << "Invalid input_generator: " << spec;
+  RET_CHECK_EQ(fields[0], "image_frame")
+      << "Unsupported input_generator type: " << fields[0];
+  std::vector<std::string> size = absl::StrSplit(fields[1], 'x');
+  RET_CHECK(size.size() == 2 && absl::SimpleAtoi(size[0], width) &&
+            absl::SimpleAtoi(size[1], height) && *width > 0 && *height > 0)
+      << "Invalid input_generator size: " << fields[1];
+  *format = ImageFormat::SRGB;
+  if (fields.size() == 3) {
+    RET_CHECK_EQ(fields[2], "srgba")
+        << "Unsupported input_generator format: " << fields[2];
+    *format = ImageFormat::SRGBA;
+  }
+  return ::mediapipe::OkStatus();
+}
+
+// Returns a frame with a gradient that moves with "frame_index", so that
+// calculators that skip unchanged frames still see new content.
+std::unique_ptr<ImageFrame> GenerateFrame(ImageFormat::Format format,
+                                          int width, int height,
+                                          int frame_index) {
+  auto frame = absl::make_unique<ImageFrame>(format, width, height);
+  const int channels = frame->NumberOfChannels();
+  for (int y = 0; y < height; ++y) {
+    uint8* row = frame->MutablePixelData() + y * frame->WidthStep();
+    for (int x = 0; x < width; ++x) {
+      for (int c = 0; c < channels; ++c) {
+        row[x * channels + c] =
+            static_cast<uint8>(x + y + frame_index + c * 64);
+      }
+    }
+  }
+  return frame;
+}
+
+// Returns the CPU time used by this process so far.
+absl::Duration ProcessCpuTime() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return absl::DurationFromTimeval(usage.ru_utime) +
+         absl::DurationFromTimeval(usage.ru_stime);
+}
+
+// Returns the peak resident memory of this process in kilobytes.
+int64 MaxResidentKilobytes() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif  // __APPLE__
+}
+
+// Returns the given percentile of the sorted "values", or 0 if empty.
+int64 Percentile(const std::vector<int64>& values, double percentile) {
+  if (values.empty()) {
+    return 0;
+  }
+  int index = static_cast<int>(percentile / 100 * (values.size() - 1) + 0.5);
+  return values[index];
+}
+
+// Sends generated frames into input_stream for duration_seconds.
+::mediapipe::Status SendGeneratedFrames(
+    CalculatorGraph* graph, ImageFormat::Format format, int width, int height,
+    absl::Time start_time,
+    const std::function<void(Timestamp)>& record_send_time) {
+  // Generate the frames up front so that the generation time is not
+  // measured. A few distinct frames are cycled through.
+  const int kNumDistinctFrames = 8;
+  std::vector<Packet> frames;
+  for (int i = 0; i < kNumDistinctFrames; ++i) {
+    frames.push_back(Adopt(GenerateFrame(format, width, height, i).release()));
+  }
+
+  const absl::Duration duration = absl::Seconds(FLAGS_duration_seconds);
+  const absl::Duration frame_interval =
+      FLAGS_input_fps > 0 ? absl::Seconds(1 / FLAGS_input_fps)
+                          : absl::ZeroDuration();
+  int64 frames_sent = 0;
+  int64 last_timestamp_usec = -1;
+  for (absl::Time now = absl::Now(); now - start_time < duration;
+       now = absl::Now()) {
+    absl::Time send_time = start_time + frame_interval * frames_sent;
+    if (send_time > now) {
+      absl::SleepFor(send_time - now);
+    }
+    // Timestamps are the microseconds since the start of the run.
+    last_timestamp_usec =
+        std::max(last_timestamp_usec + 1,
+                 absl::ToInt64Microseconds(absl::Now() - start_time));
+    Timestamp timestamp(last_timestamp_usec);
+    record_send_time(timestamp);
+    MP_RETURN_IF_ERROR(graph->AddPacketToInputStream(
+        FLAGS_input_stream,
+        frames[frames_sent % kNumDistinctFrames].At(timestamp)));
+    ++frames_sent;
+  }
+  return ::mediapipe::OkStatus();
+}
+
+// Plays input_log back into the graph input streams it recorded.
+::mediapipe::Status SendLoggedPackets(
+    CalculatorGraph* graph, const CalculatorGraphConfig& config,
+    const std::function<void(Timestamp)>& record_send_time) {
+  ASSIGN_OR_RETURN(std::unique_ptr<PacketLogReader> reader,
+                   PacketLogReader::Open(FLAGS_input_log));
+  const std::vector<std::string>& stream_names = reader->stream_names();
+  for (const std::string& name : stream_names) {
+    RET_CHECK(std::find(config.input_stream().begin(),
+                        config.input_stream().end(),
+                        name) != config.input_stream().end())
+        << "The graph has no input stream " << name << " for "
+        << FLAGS_input_log;
+  }
+  absl::Time first_arrival_time = absl::InfinitePast();
+  absl::Time replay_start_time;
+  int stream_index;
+  absl::Time arrival_time;
+  Packet packet;
+  while (true) {
+    ASSIGN_OR_RETURN(bool read,
+                     reader->Next(&stream_index, &arrival_time, &packet));
+    if (!read) {
+      break;
+    }
+    if (FLAGS_replay_realtime) {
+      const absl::Time now = absl::Now();
+      if (first_arrival_time == absl::InfinitePast()) {
+        first_arrival_time = arrival_time;
+        replay_start_time = now;
+      }
+      const absl::Time send_time =
+          replay_start_time + (arrival_time - first_arrival_time);
+      if (send_time > now) {
+        absl::SleepFor(send_time - now);
+      }
+    }
+    const std::string& name = stream_names[stream_index];
+    if (name == FLAGS_input_stream) {
+      record_send_time(packet.Timestamp());
+    }
+    MP_RETURN_IF_ERROR(graph->AddPacketToInputStream(name, packet));
+  }
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status RunGraphBenchmark() {
+  std::string calculator_graph_config_contents;
+  MP_RETURN_IF_ERROR(mediapipe::file::GetContents(
+      FLAGS_calculator_graph_config_file, &calculator_graph_config_contents));
+  CalculatorGraphConfig config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(
+          calculator_graph_config_contents);
+  std::map<std::string, Packet> input_side_packets;
+  if (!FLAGS_input_side_packets.empty()) {
+    std::vector<std::string> kv_pairs =
+        absl::StrSplit(FLAGS_input_side_packets, ',');
+    for (const std::string& kv_pair : kv_pairs) {
+      std::vector<std::string> name_and_value = absl::StrSplit(kv_pair, '=');
+      RET_CHECK(name_and_value.size() == 2);
+      RET_CHECK(!ContainsKey(input_side_packets, name_and_value[0]));
+      input_side_packets[name_and_value[0]] =
+          MakePacket<std::string>(name_and_value[1]);
+    }
+  }
+  ImageFormat::Format format = ImageFormat::SRGB;
+  int width = 0;
+  int height = 0;
+  if (FLAGS_input_log.empty()) {
+    MP_RETURN_IF_ERROR(
+        ParseInputGenerator(FLAGS_input_generator, &format, &width, &height));
+  }
+
+  CalculatorGraph graph;
+  MP_RETURN_IF_ERROR(graph.Initialize(config, input_side_packets));
+
+  // The send time of each frame that has not reached the output stream yet,
+  // and the latency of each frame that has.
+  absl::Mutex mutex;
+  std::map<int64, absl::Time> send_times;
+  std::vector<int64> latencies_usec;
+  MP_RETURN_IF_ERROR(graph.ObserveOutputStream(
+      FLAGS_output_stream, [&](const Packet& packet) {
+        absl::Time now = absl::Now();
+        absl::MutexLock lock(&mutex);
+        auto iter = send_times.find(packet.Timestamp().Value());
+        if (iter != send_times.end()) {
+          latencies_usec.push_back(
+              absl::ToInt64Microseconds(now - iter->second));
+          send_times.erase(iter);
+        }
+        return ::mediapipe::OkStatus();
+      }));
+
+  MP_RETURN_IF_ERROR(graph.StartRun({}));
+  const absl::Duration start_cpu_time = ProcessCpuTime();
+  const absl::Time start_time = absl::Now();
+  int64 frames_sent = 0;
+  // Records the send time of the packets of input_stream.
+  auto record_send_time = [&](Timestamp timestamp) {
+    absl::MutexLock lock(&mutex);
+    send_times[timestamp.Value()] = absl::Now();
+    ++frames_sent;
+  };
+  if (FLAGS_input_log.empty()) {
+    MP_RETURN_IF_ERROR(SendGeneratedFrames(&graph, format, width, height,
+                                           start_time, record_send_time));
+  } else {
+    MP_RETURN_IF_ERROR(SendLoggedPackets(&graph, config, record_send_time));
+  }
+  MP_RETURN_IF_ERROR(graph.CloseAllPacketSources());
+  MP_RETURN_IF_ERROR(graph.WaitUntilDone());
+  const absl::Duration wall_time = absl::Now() - start_time;
+  const absl::Duration cpu_time = ProcessCpuTime() - start_cpu_time;
+
+  absl::MutexLock lock(&mutex);
+  std::sort(latencies_usec.begin(), latencies_usec.end());
+  const double wall_seconds = absl::ToDoubleSeconds(wall_time);
+  std::string report = absl::StrCat(
+      "{\"graph\":\"", FLAGS_calculator_graph_config_file, "\",",
+      "\"input_generator\":\"", FLAGS_input_generator, "\",",
+      "\"input_log\":\"", FLAGS_input_log, "\",",
+      "\"wall_time_sec\":", wall_seconds, ",",
+      "\"frames_sent\":", frames_sent, ",",
+      "\"frames_received\":", latencies_usec.size(), ",",
+      "\"fps\":", latencies_usec.size() / wall_seconds, ",",
+      "\"latency_usec\":{\"p50\":", Percentile(latencies_usec, 50),
+      ",\"p90\":", Percentile(latencies_usec, 90),
+      ",\"p99\":", Percentile(latencies_usec, 99),
+      ",\"max\":", latencies_usec.empty() ? 0 : latencies_usec.back(), "},",
+      "\"cpu_time_sec\":", absl::ToDoubleSeconds(cpu_time), ",",
+      "\"cpu_utilization\":", absl::ToDoubleSeconds(cpu_time) / wall_seconds,
+      ",", "\"max_rss_kb\":", MaxResidentKilobytes(), "}\n");
+  if (FLAGS_report_file.empty()) {
+    std::fputs(report.c_str(), stdout);
+    return ::mediapipe::OkStatus();
+  }
+  return mediapipe::file::SetContents(FLAGS_report_file, report);
+}
+
+}  // namespace
+
+}  // namespace mediapipe
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  ::mediapipe::Status run_status = ::mediapipe::RunGraphBenchmark();
+  if (!run_status.ok()) {
+    LOG(ERROR) << "Failed to benchmark the graph: " << run_status.message();
+    return 1;
+  }
+  return 0;
+}
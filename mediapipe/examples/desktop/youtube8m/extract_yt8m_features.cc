@@ -15,8 +15,29 @@
 // A simple main function to run a MediaPipe graph. Input side packets are read
 // from files provided via the command line and output side packets are written
 // to disk.
+//
+// With --input_manifest, the graph is instead run once per line of the
+// manifest, on --num_graphs graph instances in parallel. Each line holds the
+// input and output side packets of one video in the format of
+// --input_side_packets and --output_side_packets, separated by whitespace:
+//
+//   input_sequence_example=/tmp/a.tfrecord output_sequence_example=/tmp/a.out
+//
+// The PCA matrices are loaded once and shared by all the runs, and so are the
+// TensorFlow sessions, which the graph loads with share_session set. The
+// aggregate throughput is logged once all the videos are processed.
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
 
+#include "absl/memory/memory.h"
 #include "absl/strings/str_split.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/matrix.h"
 #include "mediapipe/framework/port/commandlineflags.h"
@@ -24,6 +45,7 @@
 #include "mediapipe/framework/port/map_util.h"
 #include "mediapipe/framework/port/parse_text_proto.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/threadpool.h"
 
 DEFINE_string(
     calculator_graph_config_file, "",
@@ -37,68 +59,129 @@ DEFINE_string(output_side_packets, "",
               "Comma-separated list of key=value pairs specifying the output "
               "side packets and paths to write to disk for the "
               "CalculatorGraph.");
+DEFINE_string(input_manifest, "",
+              "Name of a file listing one video per line, as the input side "
+              "packets and the output side packets of its run separated by "
+              "whitespace, in the format of --input_side_packets and "
+              "--output_side_packets. If set, those flags are ignored.");
+DEFINE_int32(num_graphs, 1,
+             "The number of graph instances running videos of "
+             "--input_manifest in parallel.");
 
-::mediapipe::Status RunMPPGraph() {
-  std::string calculator_graph_config_contents;
-  MP_RETURN_IF_ERROR(mediapipe::file::GetContents(
-      FLAGS_calculator_graph_config_file, &calculator_graph_config_contents));
-  LOG(INFO) << "Get calculator graph config contents: "
-            << calculator_graph_config_contents;
-  mediapipe::CalculatorGraphConfig config =
-      mediapipe::ParseTextProtoOrDie<mediapipe::CalculatorGraphConfig>(
-          calculator_graph_config_contents);
-  std::map<std::string, ::mediapipe::Packet> input_side_packets;
-  std::vector<std::string> kv_pairs =
-      absl::StrSplit(FLAGS_input_side_packets, ',');
+namespace {
+
+// Reads the files named in "kv_pairs_flag", a comma-separated list of
+// key=value pairs, into string side packets.
+::mediapipe::Status ReadInputSidePackets(
+    const std::string& kv_pairs_flag,
+    std::map<std::string, ::mediapipe::Packet>* input_side_packets) {
+  std::vector<std::string> kv_pairs = absl::StrSplit(kv_pairs_flag, ',');
   for (const std::string& kv_pair : kv_pairs) {
     std::vector<std::string> name_and_value = absl::StrSplit(kv_pair, '=');
     RET_CHECK(name_and_value.size() == 2);
-    RET_CHECK(!::mediapipe::ContainsKey(input_side_packets, name_and_value[0]));
+    RET_CHECK(
+        !::mediapipe::ContainsKey(*input_side_packets, name_and_value[0]));
     std::string input_side_packet_contents;
     MP_RETURN_IF_ERROR(mediapipe::file::GetContents(
         name_and_value[1], &input_side_packet_contents));
-    input_side_packets[name_and_value[0]] =
+    (*input_side_packets)[name_and_value[0]] =
         ::mediapipe::MakePacket<std::string>(input_side_packet_contents);
   }
+  return ::mediapipe::OkStatus();
+}
 
-  mediapipe::MatrixData inc3_pca_mean_matrix_data,
-      inc3_pca_projection_matrix_data, vggish_pca_mean_matrix_data,
-      vggish_pca_projection_matrix_data;
-  mediapipe::Matrix inc3_pca_mean_matrix, inc3_pca_projection_matrix,
-      vggish_pca_mean_matrix, vggish_pca_projection_matrix;
+// Writes the string output side packets of "graph" to the files named in
+// "kv_pairs_flag", a comma-separated list of key=value pairs.
+::mediapipe::Status WriteOutputSidePackets(
+    const std::string& kv_pairs_flag, mediapipe::CalculatorGraph* graph) {
+  std::vector<std::string> kv_pairs = absl::StrSplit(kv_pairs_flag, ',');
+  for (const std::string& kv_pair : kv_pairs) {
+    std::vector<std::string> name_and_value = absl::StrSplit(kv_pair, '=');
+    RET_CHECK(name_and_value.size() == 2);
+    ::mediapipe::StatusOr<::mediapipe::Packet> output_packet =
+        graph->GetOutputSidePacket(name_and_value[0]);
+    RET_CHECK(output_packet.ok())
+        << "Packet " << name_and_value[0] << " was not available.";
+    const std::string& serialized_string =
+        output_packet.ValueOrDie().Get<std::string>();
+    MP_RETURN_IF_ERROR(
+        mediapipe::file::SetContents(name_and_value[1], serialized_string));
+  }
+  return ::mediapipe::OkStatus();
+}
 
+// Reads the MatrixData proto in "path" into a Matrix side packet.
+::mediapipe::Status ReadMatrixSidePacket(
+    const std::string& path, const std::string& name,
+    std::map<std::string, ::mediapipe::Packet>* input_side_packets) {
   std::string content;
-  MP_RETURN_IF_ERROR(mediapipe::file::GetContents(
-      "/tmp/mediapipe/inception3_mean_matrix_data.pb", &content));
-  inc3_pca_mean_matrix_data.ParseFromString(content);
-  mediapipe::MatrixFromMatrixDataProto(inc3_pca_mean_matrix_data,
-                                       &inc3_pca_mean_matrix);
-  input_side_packets["inception3_pca_mean_matrix"] =
-      ::mediapipe::MakePacket<mediapipe::Matrix>(inc3_pca_mean_matrix);
+  MP_RETURN_IF_ERROR(mediapipe::file::GetContents(path, &content));
+  mediapipe::MatrixData matrix_data;
+  RET_CHECK(matrix_data.ParseFromString(content)) << "Cannot parse " << path;
+  mediapipe::Matrix matrix;
+  mediapipe::MatrixFromMatrixDataProto(matrix_data, &matrix);
+  (*input_side_packets)[name] =
+      ::mediapipe::MakePacket<mediapipe::Matrix>(std::move(matrix));
+  return ::mediapipe::OkStatus();
+}
 
-  MP_RETURN_IF_ERROR(mediapipe::file::GetContents(
-      "/tmp/mediapipe/inception3_projection_matrix_data.pb", &content));
-  inc3_pca_projection_matrix_data.ParseFromString(content);
-  mediapipe::MatrixFromMatrixDataProto(inc3_pca_projection_matrix_data,
-                                       &inc3_pca_projection_matrix);
-  input_side_packets["inception3_pca_projection_matrix"] =
-      ::mediapipe::MakePacket<mediapipe::Matrix>(inc3_pca_projection_matrix);
+// Reads the PCA matrices, which all the videos share.
+::mediapipe::Status ReadPcaMatrices(
+    std::map<std::string, ::mediapipe::Packet>* input_side_packets) {
+  MP_RETURN_IF_ERROR(ReadMatrixSidePacket(
+      "/tmp/mediapipe/inception3_mean_matrix_data.pb",
+      "inception3_pca_mean_matrix", input_side_packets));
+  MP_RETURN_IF_ERROR(ReadMatrixSidePacket(
+      "/tmp/mediapipe/inception3_projection_matrix_data.pb",
+      "inception3_pca_projection_matrix", input_side_packets));
+  MP_RETURN_IF_ERROR(ReadMatrixSidePacket(
+      "/tmp/mediapipe/vggish_mean_matrix_data.pb", "vggish_pca_mean_matrix",
+      input_side_packets));
+  MP_RETURN_IF_ERROR(ReadMatrixSidePacket(
+      "/tmp/mediapipe/vggish_projection_matrix_data.pb",
+      "vggish_pca_projection_matrix", input_side_packets));
+  return ::mediapipe::OkStatus();
+}
 
+::mediapipe::StatusOr<mediapipe::CalculatorGraphConfig> ReadGraphConfig() {
+  std::string calculator_graph_config_contents;
   MP_RETURN_IF_ERROR(mediapipe::file::GetContents(
-      "/tmp/mediapipe/vggish_mean_matrix_data.pb", &content));
-  vggish_pca_mean_matrix_data.ParseFromString(content);
-  mediapipe::MatrixFromMatrixDataProto(vggish_pca_mean_matrix_data,
-                                       &vggish_pca_mean_matrix);
-  input_side_packets["vggish_pca_mean_matrix"] =
-      ::mediapipe::MakePacket<mediapipe::Matrix>(vggish_pca_mean_matrix);
+      FLAGS_calculator_graph_config_file, &calculator_graph_config_contents));
+  LOG(INFO) << "Get calculator graph config contents: "
+            << calculator_graph_config_contents;
+  return mediapipe::ParseTextProtoOrDie<mediapipe::CalculatorGraphConfig>(
+      calculator_graph_config_contents);
+}
 
-  MP_RETURN_IF_ERROR(mediapipe::file::GetContents(
-      "/tmp/mediapipe/vggish_projection_matrix_data.pb", &content));
-  vggish_pca_projection_matrix_data.ParseFromString(content);
-  mediapipe::MatrixFromMatrixDataProto(vggish_pca_projection_matrix_data,
-                                       &vggish_pca_projection_matrix);
-  input_side_packets["vggish_pca_projection_matrix"] =
-      ::mediapipe::MakePacket<mediapipe::Matrix>(vggish_pca_projection_matrix);
+// The input and output side packets of one video of the manifest.
+struct ManifestEntry {
+  std::string input_side_packets;
+  std::string output_side_packets;
+};
+
+::mediapipe::StatusOr<std::vector<ManifestEntry>> ReadManifest(
+    const std::string& path) {
+  std::string contents;
+  MP_RETURN_IF_ERROR(mediapipe::file::GetContents(path, &contents));
+  std::vector<ManifestEntry> entries;
+  for (absl::string_view line : absl::StrSplit(contents, '\n')) {
+    std::vector<std::string> fields =
+        absl::StrSplit(line, absl::ByAnyChar(" \t\r"), absl::SkipEmpty());
+    if (fields.empty() || fields[0][0] == '#') {
+      continue;
+    }
+    RET_CHECK_EQ(fields.size(), 2) << "Invalid manifest line: " << line;
+    entries.push_back({fields[0], fields[1]});
+  }
+  return entries;
+}
+
+::mediapipe::Status RunMPPGraph() {
+  ASSIGN_OR_RETURN(mediapipe::CalculatorGraphConfig config, ReadGraphConfig());
+  std::map<std::string, ::mediapipe::Packet> input_side_packets;
+  MP_RETURN_IF_ERROR(
+      ReadInputSidePackets(FLAGS_input_side_packets, &input_side_packets));
+  MP_RETURN_IF_ERROR(ReadPcaMatrices(&input_side_packets));
 
   LOG(INFO) << "Initialize the calculator graph.";
   mediapipe::CalculatorGraph graph;
@@ -106,26 +189,81 @@ DEFINE_string(output_side_packets, "",
   LOG(INFO) << "Start running the calculator graph.";
   MP_RETURN_IF_ERROR(graph.Run());
   LOG(INFO) << "Gathering output side packets.";
-  kv_pairs = absl::StrSplit(FLAGS_output_side_packets, ',');
-  for (const std::string& kv_pair : kv_pairs) {
-    std::vector<std::string> name_and_value = absl::StrSplit(kv_pair, '=');
-    RET_CHECK(name_and_value.size() == 2);
-    ::mediapipe::StatusOr<::mediapipe::Packet> output_packet =
-        graph.GetOutputSidePacket(name_and_value[0]);
-    RET_CHECK(output_packet.ok())
-        << "Packet " << name_and_value[0] << " was not available.";
-    const std::string& serialized_string =
-        output_packet.ValueOrDie().Get<std::string>();
-    MP_RETURN_IF_ERROR(
-        mediapipe::file::SetContents(name_and_value[1], serialized_string));
+  return WriteOutputSidePackets(FLAGS_output_side_packets, &graph);
+}
+
+// Runs each video of the manifest on one of FLAGS_num_graphs graphs, which
+// are initialized once with the PCA matrices and then run once per video.
+::mediapipe::Status RunManifest() {
+  RET_CHECK_GT(FLAGS_num_graphs, 0);
+  ASSIGN_OR_RETURN(mediapipe::CalculatorGraphConfig config, ReadGraphConfig());
+  ASSIGN_OR_RETURN(std::vector<ManifestEntry> entries,
+                   ReadManifest(FLAGS_input_manifest));
+  std::map<std::string, ::mediapipe::Packet> pca_side_packets;
+  MP_RETURN_IF_ERROR(ReadPcaMatrices(&pca_side_packets));
+
+  const int num_graphs =
+      std::min<int>(FLAGS_num_graphs, std::max<int>(entries.size(), 1));
+  std::vector<std::unique_ptr<mediapipe::CalculatorGraph>> graphs;
+  for (int i = 0; i < num_graphs; ++i) {
+    graphs.push_back(absl::make_unique<mediapipe::CalculatorGraph>());
+    MP_RETURN_IF_ERROR(graphs.back()->Initialize(config, pca_side_packets));
   }
+
+  LOG(INFO) << "Extracting features of " << entries.size() << " videos with "
+            << num_graphs << " graphs.";
+  std::atomic<int> next_entry(0);
+  std::atomic<int> num_failed(0);
+  const absl::Time start_time = absl::Now();
+  {
+    mediapipe::ThreadPool pool("yt8m_graphs", num_graphs);
+    pool.StartWorkers();
+    for (int i = 0; i < num_graphs; ++i) {
+      mediapipe::CalculatorGraph* graph = graphs[i].get();
+      pool.Schedule([graph, &entries, &next_entry, &num_failed]() {
+        const int num_entries = entries.size();
+        for (int index = next_entry++; index < num_entries;
+             index = next_entry++) {
+          const ManifestEntry& entry = entries[index];
+          std::map<std::string, ::mediapipe::Packet> side_packets;
+          ::mediapipe::Status status =
+              ReadInputSidePackets(entry.input_side_packets, &side_packets);
+          if (status.ok()) {
+            status = graph->Run(side_packets);
+          }
+          if (status.ok()) {
+            status = WriteOutputSidePackets(entry.output_side_packets, graph);
+          }
+          if (!status.ok()) {
+            ++num_failed;
+            LOG(ERROR) << "Failed to extract the features of "
+                       << entry.input_side_packets << ": " << status.message();
+          }
+        }
+      });
+    }
+    // The pool waits for the graphs to finish when it is destroyed.
+  }
+  const double elapsed_seconds =
+      absl::ToDoubleSeconds(absl::Now() - start_time);
+
+  const int num_succeeded = static_cast<int>(entries.size()) - num_failed;
+  LOG(INFO) << "Extracted the features of " << num_succeeded << " of "
+            << entries.size() << " videos in " << elapsed_seconds
+            << " seconds ("
+            << (elapsed_seconds > 0 ? num_succeeded / elapsed_seconds : 0)
+            << " videos per second).";
+  RET_CHECK_EQ(num_failed.load(), 0) << num_failed << " videos failed.";
   return ::mediapipe::OkStatus();
 }
 
+}  // namespace
+
 int main(int argc, char** argv) {
   google::InitGoogleLogging(argv[0]);
   gflags::ParseCommandLineFlags(&argc, &argv, true);
-  ::mediapipe::Status run_status = RunMPPGraph();
+  ::mediapipe::Status run_status =
+      FLAGS_input_manifest.empty() ? RunMPPGraph() : RunManifest();
   if (!run_status.ok()) {
     LOG(ERROR) << "Failed to run the graph: " << run_status.message();
   } else {
@@ -142,6 +142,9 @@ class CalculatorBase {
   // as it returns ::mediapipe::OkStatus().  To indicate that there is
   // no more data to be generated return tool::StatusStop().  Any other
   // status indicates an error has occurred.
+  //
+  // A non-source node waiting on I/O may return before it is done with the
+  // current inputs, see CalculatorContext::DeferCompletion().
   virtual ::mediapipe::Status Process(CalculatorContext* cc) = 0;
 
   // Is called if Open() was called and succeeded.  Is called either
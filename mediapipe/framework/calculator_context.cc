@@ -65,6 +65,27 @@ void CalculatorContext::SetOffset(TimestampDiff offset) {
   }
 }
 
+CalculatorContext::ProcessCompletion CalculatorContext::DeferCompletion() {
+  CHECK(!completion_deferred_)
+      << "DeferCompletion() may only be called once per Process() call.";
+  completion_deferred_ = true;
+  completion_refs_.store(2);
+  return [this](const ::mediapipe::Status& status) {
+    completion_status_ = status;
+    ReleaseDeferredCompletion();
+  };
+}
+
+void CalculatorContext::ReleaseDeferredCompletion() {
+  if (completion_refs_.fetch_sub(1) == 1) {
+    // The handler may recycle this context, which may then be deferred again
+    // before the handler returns.
+    std::function<void()> handler = std::move(completion_handler_);
+    completion_handler_ = nullptr;
+    handler();
+  }
+}
+
 const InputStreamSet& CalculatorContext::InputStreams() const {
   return calculator_state_->InputStreams();
 }
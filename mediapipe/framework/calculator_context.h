@@ -15,6 +15,8 @@
 #ifndef MEDIAPIPE_FRAMEWORK_CALCULATOR_CONTEXT_H_
 #define MEDIAPIPE_FRAMEWORK_CALCULATOR_CONTEXT_H_
 
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <queue>
 #include <string>
@@ -100,6 +102,24 @@ class CalculatorContext {
   // use OutputStream::SetOffset() directly.
   void SetOffset(TimestampDiff offset);
 
+  // Called with the status of a deferred Process() call, see
+  // DeferCompletion().
+  using ProcessCompletion = std::function<void(const ::mediapipe::Status&)>;
+
+  // Lets an I/O-bound calculator return from Process() before it is done with
+  // the current input set, so that the executor thread can run other nodes
+  // while the calculator waits.  Process() calls DeferCompletion(), starts
+  // the operation and returns.  Once the operation is done, the calculator
+  // adds the outputs to Outputs() and calls the returned ProcessCompletion
+  // exactly once, from any thread, with the status Process() would have
+  // returned.  Only then are the outputs propagated and the node's next
+  // invocation scheduled, on the calling thread.  The inputs remain valid
+  // until then.  With max_in_flight > 1 several invocations may be deferred
+  // at once, and the outputs are still emitted in timestamp order.  The graph
+  // run does not end while an invocation is deferred.  Not supported for
+  // source nodes or when batching input sets.
+  ProcessCompletion DeferCompletion();
+
   // Returns the status of the graph run.
   //
   // NOTE: This method should only be called during CalculatorBase::Close().
@@ -152,6 +172,11 @@ class CalculatorContext {
     graph_status_ = status;
   }
 
+  // Drops one of the two references to a deferred Process() call, held by
+  // the node and by the ProcessCompletion.  The last one runs
+  // completion_handler_.
+  void ReleaseDeferredCompletion();
+
   // Interface for the friend class Calculator.
   const InputStreamSet& InputStreams() const;
   const OutputStreamSet& OutputStreams() const;
@@ -169,8 +194,18 @@ class CalculatorContext {
   // The status of the graph run. Only used when Close() is called.
   ::mediapipe::Status graph_status_;
 
+  // The state of a Process() call whose completion was deferred.
+  bool completion_deferred_ = false;
+  std::atomic<int> completion_refs_{0};
+  ::mediapipe::Status deferred_process_status_;
+  ::mediapipe::Status completion_status_;
+  // Finishes the deferred invocation. Set by the CalculatorNode.
+  std::function<void()> completion_handler_;
+
   // Accesses CalculatorContext for setting input timestamp.
   friend class CalculatorContextManager;
+  // Finishes the deferred Process() calls.
+  friend class CalculatorNode;
 };
 
 }  // namespace mediapipe
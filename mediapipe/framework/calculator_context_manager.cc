@@ -46,8 +46,10 @@ void CalculatorContextManager::Initialize(
 void CalculatorContextManager::CleanupAfterRun() {
   default_context_ = nullptr;
   absl::MutexLock lock(&contexts_mutex_);
+  // The contexts still active after an error may hold inputs and outputs,
+  // but the idle ones are cleared and can be reused in the next run.
   active_contexts_.clear();
-  idle_contexts_.clear();
+  context_pool_prepared_ = false;
 }
 
 CalculatorContext* CalculatorContextManager::GetDefaultCalculatorContext()
@@ -65,6 +67,26 @@ CalculatorContext* CalculatorContextManager::GetFrontCalculatorContext(
   return active_contexts_.begin()->second.get();
 }
 
+CalculatorContext* CalculatorContextManager::GetNextCalculatorContext(
+    Timestamp input_timestamp, Timestamp* context_input_timestamp) {
+  CHECK(calculator_run_in_parallel_);
+  absl::MutexLock lock(&contexts_mutex_);
+  auto iter = active_contexts_.upper_bound(input_timestamp);
+  if (iter == active_contexts_.end()) {
+    return nullptr;
+  }
+  *context_input_timestamp = iter->first;
+  return iter->second.get();
+}
+
+CalculatorContext* CalculatorContextManager::GetCalculatorContext(
+    Timestamp input_timestamp) {
+  CHECK(calculator_run_in_parallel_);
+  absl::MutexLock lock(&contexts_mutex_);
+  auto iter = active_contexts_.find(input_timestamp);
+  return iter == active_contexts_.end() ? nullptr : iter->second.get();
+}
+
 CalculatorContext* CalculatorContextManager::PrepareCalculatorContext(
     Timestamp input_timestamp) {
   if (!calculator_run_in_parallel_) {
@@ -75,20 +97,34 @@ CalculatorContext* CalculatorContextManager::PrepareCalculatorContext(
       << "Multiple invocations with the same timestamps are not allowed with "
          "parallel execution, input_timestamp = "
       << input_timestamp;
-  CalculatorContext* calculator_context = nullptr;
+  if (!context_pool_prepared_) {
+    // The input stream headers are set by now, so the contexts kept from the
+    // previous run are connected to the streams again, and the pool is
+    // filled with contexts that see the same headers.
+    for (auto& idle_context : idle_contexts_) {
+      MEDIAPIPE_CHECK_OK(setup_shards_callback_(idle_context.get()));
+    }
+    while (static_cast<int>(idle_contexts_.size() + active_contexts_.size()) <
+           context_pool_size_) {
+      idle_contexts_.push_back(NewCalculatorContext());
+    }
+    context_pool_prepared_ = true;
+  }
   if (idle_contexts_.empty()) {
-    auto new_context = absl::make_unique<CalculatorContext>(
-        calculator_state_, input_tag_map_, output_tag_map_);
-    MEDIAPIPE_CHECK_OK(setup_shards_callback_(new_context.get()));
-    calculator_context = new_context.get();
-    active_contexts_.emplace(input_timestamp, std::move(new_context));
-  } else {
-    // Retrieves an inactive calculator context from idle_contexts_.
-    calculator_context = idle_contexts_.front().get();
-    active_contexts_.emplace(input_timestamp,
-                             std::move(idle_contexts_.front()));
-    idle_contexts_.pop_front();
+    idle_contexts_.push_back(NewCalculatorContext());
   }
+  // Retrieves an inactive calculator context from idle_contexts_.
+  CalculatorContext* calculator_context = idle_contexts_.front().get();
+  active_contexts_.emplace(input_timestamp, std::move(idle_contexts_.front()));
+  idle_contexts_.pop_front();
+  return calculator_context;
+}
+
+std::unique_ptr<CalculatorContext>
+CalculatorContextManager::NewCalculatorContext() {
+  auto calculator_context = absl::make_unique<CalculatorContext>(
+      calculator_state_, input_tag_map_, output_tag_map_);
+  MEDIAPIPE_CHECK_OK(setup_shards_callback_(calculator_context.get()));
   return calculator_context;
 }
 
@@ -100,6 +136,15 @@ void CalculatorContextManager::RecycleCalculatorContext() {
   active_contexts_.erase(iter);
 }
 
+void CalculatorContextManager::RecycleCalculatorContext(
+    Timestamp input_timestamp) {
+  absl::MutexLock lock(&contexts_mutex_);
+  auto iter = active_contexts_.find(input_timestamp);
+  CHECK(iter != active_contexts_.end());
+  idle_contexts_.push_back(std::move(iter->second));
+  active_contexts_.erase(iter);
+}
+
 bool CalculatorContextManager::HasActiveContexts() {
   if (!calculator_run_in_parallel_) {
     return false;
@@ -108,4 +153,12 @@ bool CalculatorContextManager::HasActiveContexts() {
   return !active_contexts_.empty();
 }
 
+int CalculatorContextManager::NumActiveContexts() {
+  if (!calculator_run_in_parallel_) {
+    return 0;
+  }
+  absl::MutexLock lock(&contexts_mutex_);
+  return active_contexts_.size();
+}
+
 }  // namespace mediapipe
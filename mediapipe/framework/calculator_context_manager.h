@@ -42,6 +42,12 @@ class CalculatorContextManager {
                   std::shared_ptr<tool::TagMap> output_tag_map,
                   bool calculator_run_in_parallel);
 
+  // Sets the number of calculator contexts constructed for parallel
+  // execution when the first one is needed, typically the max_in_flight of
+  // the node, so that invocations do not construct calculator contexts.
+  // Idle calculator contexts are also kept across graph runs.
+  void SetContextPoolSize(int pool_size) { context_pool_size_ = pool_size; }
+
   // Sets the callback that can setup the input and output stream shards in a
   // newly constructed calculator context. Then, initializes the default
   // calculator context.
@@ -68,8 +74,21 @@ class CalculatorContextManager {
   CalculatorContext* GetFrontCalculatorContext(
       Timestamp* context_input_timestamp) LOCKS_EXCLUDED(contexts_mutex_);
 
+  // Returns the context with the smallest input timestamp greater than
+  // input_timestamp in active_contexts_, or nullptr if there is none. The
+  // input timestamp of the calculator context is returned in
+  // *context_input_timestamp.
+  CalculatorContext* GetNextCalculatorContext(
+      Timestamp input_timestamp, Timestamp* context_input_timestamp)
+      LOCKS_EXCLUDED(contexts_mutex_);
+
+  // Returns the context with the given input timestamp in active_contexts_,
+  // or nullptr if there is none.
+  CalculatorContext* GetCalculatorContext(Timestamp input_timestamp)
+      LOCKS_EXCLUDED(contexts_mutex_);
+
   // For sequential execution, returns a pointer to the default calculator
-  // context. For parallel execution, creates or reuses a calculator context,
+  // context. For parallel execution, reuses or creates a calculator context,
   // and inserts the calculator context with the given input timestamp into
   // active_contexts_. Returns a pointer to the prepared calculator context.
   // The ownership of the calculator context object isn't tranferred to the
@@ -83,9 +102,17 @@ class CalculatorContextManager {
   // propagated before calling this function.
   void RecycleCalculatorContext() LOCKS_EXCLUDED(contexts_mutex_);
 
+  // Like RecycleCalculatorContext(), but for the context with the given input
+  // timestamp.
+  void RecycleCalculatorContext(Timestamp input_timestamp)
+      LOCKS_EXCLUDED(contexts_mutex_);
+
   // Returns true if active_contexts_ is non-empty.
   bool HasActiveContexts() LOCKS_EXCLUDED(contexts_mutex_);
 
+  // Returns the number of contexts in active_contexts_.
+  int NumActiveContexts() LOCKS_EXCLUDED(contexts_mutex_);
+
   int NumberOfContextTimestamps(
       const CalculatorContext& calculator_context) const {
     return calculator_context.NumberOfTimestamps();
@@ -114,6 +141,9 @@ class CalculatorContextManager {
   }
 
  private:
+  // Constructs a calculator context with its shards set up.
+  std::unique_ptr<CalculatorContext> NewCalculatorContext();
+
   CalculatorState* calculator_state_;
   std::shared_ptr<tool::TagMap> input_tag_map_;
   std::shared_ptr<tool::TagMap> output_tag_map_;
@@ -126,6 +156,9 @@ class CalculatorContextManager {
   // calculator context manager and input/output stream handlers.
   std::function<::mediapipe::Status(CalculatorContext*)> setup_shards_callback_;
 
+  // The number of calculator contexts to construct for parallel execution.
+  int context_pool_size_ = 0;
+
   // The default calculator context that is always reused for sequential
   // execution. It is also used by Open() and Close() method of a parallel
   // calculator.
@@ -139,6 +172,9 @@ class CalculatorContextManager {
   // Idle calculator contexts that are ready for reuse.
   std::deque<std::unique_ptr<CalculatorContext>> idle_contexts_
       GUARDED_BY(contexts_mutex_);
+  // True once the idle calculator contexts are set up for the current run
+  // and the pool is filled.
+  bool context_pool_prepared_ GUARDED_BY(contexts_mutex_) = false;
 };
 
 }  // namespace mediapipe
@@ -104,6 +104,26 @@ class CalculatorContract {
     return input_stream_handler_options_;
   }
 
+  // Requests that Process() be run inline on the thread that made the node
+  // ready, bypassing the scheduler queue. Intended for calculators whose
+  // Process() is trivially cheap. See CalculatorGraphConfig::Node::run_inline.
+  void SetRunInline(bool run_inline) { run_inline_ = run_inline; }
+
+  // Returns true if the calculator requested to be run inline.
+  bool RunInline() const { return run_inline_; }
+
+  // Declares that Process() keeps no state between invocations and may be
+  // called concurrently, on the same calculator object, for different input
+  // timestamps.  Unless the node config sets max_in_flight, the framework
+  // then runs up to one invocation per CPU core in parallel, and the default
+  // InOrderOutputStreamHandler delivers the outputs in timestamp order.
+  // Process() must therefore be thread-safe and must not depend on earlier
+  // invocations.
+  void SetStateless(bool stateless) { stateless_ = stateless; }
+
+  // Returns true if the calculator declared itself stateless.
+  bool IsStateless() const { return stateless_; }
+
   class GraphServiceRequest {
    public:
     // APIs that should be used by calculators.
@@ -147,6 +167,8 @@ class CalculatorContract {
   MediaPipeOptions input_stream_handler_options_;
   std::string node_name_;
   std::map<std::string, GraphServiceRequest> service_requests_;
+  bool run_inline_ = false;
+  bool stateless_ = false;
 };
 
 }  // namespace mediapipe
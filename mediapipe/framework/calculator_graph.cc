@@ -31,12 +31,15 @@
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_base.h"
 #include "mediapipe/framework/counter_factory.h"
+#include "mediapipe/framework/critical_path_estimator.h"
 #include "mediapipe/framework/delegating_executor.h"
 #include "mediapipe/framework/input_stream_manager.h"
 #include "mediapipe/framework/mediapipe_profiling.h"
+#include "mediapipe/framework/packet_arena.h"
 #include "mediapipe/framework/packet_generator.h"
 #include "mediapipe/framework/packet_generator.pb.h"
 #include "mediapipe/framework/packet_set.h"
@@ -73,6 +76,8 @@ namespace {
 // threshold.
 constexpr int kMaxNumAccumulatedErrors = 1000;
 constexpr char kApplicationThreadExecutorType[] = "ApplicationThreadExecutor";
+// How often the CRITICAL_PATH scheduling policy refreshes node priorities.
+constexpr int64 kSchedulingPriorityUpdateIntervalUsec = 1000000;
 
 }  // namespace
 
@@ -126,7 +131,10 @@ CalculatorGraph::CalculatorGraph(const CalculatorGraphConfig& config)
 // Defining the destructor here lets us use incomplete types in the header;
 // they only need to be fully visible here, where their destructor is
 // instantiated.
-CalculatorGraph::~CalculatorGraph() {}
+CalculatorGraph::~CalculatorGraph() {
+  // The profiler may be shared with calculators that outlive the graph.
+  profiler_->SetInputStreamManagers(nullptr);
+}
 
 ::mediapipe::Status CalculatorGraph::InitializePacketGeneratorGraph(
     const std::map<std::string, Packet>& side_packets) {
@@ -153,6 +161,7 @@ CalculatorGraph::~CalculatorGraph() {}
   }
   // If default_executor is nullptr, then packet_generator_graph_ will create
   // its own DelegatingExecutor to use the application thread.
+  packet_generator_graph_.SetProfiler(profiler_.get());
   return packet_generator_graph_.Initialize(validated_graph_.get(),
                                             default_executor, side_packets);
 }
@@ -169,6 +178,7 @@ CalculatorGraph::~CalculatorGraph() {}
     MP_RETURN_IF_ERROR(input_stream_managers_[index].Initialize(
         edge_info.name, edge_info.packet_type, edge_info.back_edge));
   }
+  profiler_->SetInputStreamManagers(input_stream_managers_.get());
 
   // Create and initialize the output streams.
   output_stream_managers_ = absl::make_unique<OutputStreamManager[]>(
@@ -205,6 +215,7 @@ CalculatorGraph::~CalculatorGraph() {}
     // these as regular nodes for throttling.
     graph_input_stream_node_ids_[stream_name] =
         validated_graph_->CalculatorInfos().size() + graph_input_stream_count;
+    graph_input_stream_names_.push_back(stream_name);
     ++graph_input_stream_count;
   }
 
@@ -323,6 +334,10 @@ CalculatorGraph::~CalculatorGraph() {}
 ::mediapipe::Status CalculatorGraph::InitializeDefaultExecutor(
     const ThreadPoolExecutorOptions& default_executor_options,
     bool use_application_thread) {
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+  // WebAssembly builds without pthreads cannot start threads.
+  use_application_thread = true;
+#endif  // __EMSCRIPTEN__ && !__EMSCRIPTEN_PTHREADS__
   // If specified, run synchronously on the calling thread.
   if (use_application_thread) {
     use_application_thread_ = true;
@@ -359,13 +374,23 @@ CalculatorGraph::~CalculatorGraph() {}
       << "validated_graph is not initialized.";
   validated_graph_ = std::move(validated_graph);
 
+  scheduler_.SetShardedQueues(validated_graph_->Config().scheduler_queue() ==
+                              CalculatorGraphConfig::SHARDED_QUEUE);
   MP_RETURN_IF_ERROR(InitializeExecutors());
-  MP_RETURN_IF_ERROR(InitializePacketGeneratorGraph(side_packets));
-  MP_RETURN_IF_ERROR(InitializeStreams());
-  MP_RETURN_IF_ERROR(InitializeCalculatorNodes());
 #ifdef MEDIAPIPE_PROFILER_AVAILABLE
+  // The profiler records the runtime of the packet generators run here.
   MP_RETURN_IF_ERROR(InitializeProfiler());
 #endif
+  MP_RETURN_IF_ERROR(InitializePacketGeneratorGraph(side_packets));
+  MP_RETURN_IF_ERROR(InitializeStreams());
+  MP_RETURN_IF_ERROR(InitializeCalculatorNodes());
+  if (validated_graph_->Config().scheduling_policy() ==
+      CalculatorGraphConfig::CRITICAL_PATH) {
+    critical_path_estimator_ = absl::make_unique<CriticalPathEstimator>();
+    MP_RETURN_IF_ERROR(critical_path_estimator_->Initialize(*validated_graph_));
+    scheduler_.SetProcessFinishedCallback(
+        [this]() { MaybeUpdateSchedulingPriorities(); });
+  }
 
   initialized_ = true;
   return ::mediapipe::OkStatus();
@@ -569,6 +594,8 @@ CalculatorGraph::PrepareGpu(const std::map<std::string, Packet>& side_packets) {
         gpu_resources->PrepareGpuNode(&node);
       }
     }
+    MP_RETURN_IF_ERROR(gpu_resources->PreallocateBuffers(
+        validated_graph_->Config().options()));
     for (const auto& name_executor : gpu_resources->GetGpuExecutors()) {
       MP_RETURN_IF_ERROR(
           SetExecutorInternal(name_executor.first, name_executor.second));
@@ -598,6 +625,15 @@ CalculatorGraph::PrepareGpu(const std::map<std::string, Packet>& side_packets) {
 #ifndef MEDIAPIPE_DISABLE_GPU
   ASSIGN_OR_RETURN(additional_side_packets, PrepareGpu(extra_side_packets));
 #endif  // !defined(MEDIAPIPE_DISABLE_GPU)
+  // PrepareGpu() replaces the GL context executors of GPU calculators.
+  for (const auto& node : *nodes_) {
+    if (ValidatedGraphConfig::IsGlContextExecutorName(node.Executor())) {
+      return ::mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "Calculator \"" << node.DebugName() << "\" uses the executor \""
+             << node.Executor()
+             << "\", but only GPU calculators can run in a GL context.";
+    }
+  }
 
   const std::map<std::string, Packet>* input_side_packets;
   if (!additional_side_packets.empty()) {
@@ -655,6 +691,14 @@ CalculatorGraph::PrepareGpu(const std::map<std::string, Packet>& side_packets) {
                                graph_input_streams_.size());
   }
 
+  // The arena is created on the first run and reused by later runs.
+  if (validated_graph_->Config().enable_packet_arena() &&
+      !::mediapipe::ContainsKey(service_packets_, kPacketArenaService.key)) {
+    service_packets_[kPacketArenaService.key] =
+        MakePacket<std::shared_ptr<PacketArena>>(
+            std::make_shared<PacketArena>());
+  }
+
   for (auto& item : graph_input_streams_) {
     item.second->PrepareForRun(
         std::bind(&CalculatorGraph::RecordError, this, std::placeholders::_1));
@@ -703,6 +747,10 @@ CalculatorGraph::PrepareGpu(const std::map<std::string, Packet>& side_packets) {
     return error_status;
   }
 
+  if (critical_path_estimator_) {
+    UpdateSchedulingPriorities();
+  }
+
   // Ensure that the latest value of max queue size is passed to all input
   // streams.
   for (auto& node : *nodes_) {
@@ -778,12 +826,67 @@ CalculatorGraph::PrepareGpu(const std::map<std::string, Packet>& side_packets) {
 
 ::mediapipe::Status CalculatorGraph::AddPacketToInputStream(
     const std::string& stream_name, const Packet& packet) {
-  return AddPacketToInputStreamInternal(stream_name, packet);
+  return AddPacketToInputStreamInternal(stream_name, packet,
+                                        /*may_block=*/true);
 }
 
 ::mediapipe::Status CalculatorGraph::AddPacketToInputStream(
     const std::string& stream_name, Packet&& packet) {
-  return AddPacketToInputStreamInternal(stream_name, std::move(packet));
+  return AddPacketToInputStreamInternal(stream_name, std::move(packet),
+                                        /*may_block=*/true);
+}
+
+::mediapipe::Status CalculatorGraph::TryAddPacketToInputStream(
+    const std::string& stream_name, const Packet& packet) {
+  return AddPacketToInputStreamInternal(stream_name, packet,
+                                        /*may_block=*/false);
+}
+
+::mediapipe::Status CalculatorGraph::TryAddPacketToInputStream(
+    const std::string& stream_name, Packet&& packet) {
+  return AddPacketToInputStreamInternal(stream_name, std::move(packet),
+                                        /*may_block=*/false);
+}
+
+void CalculatorGraph::SetGraphInputStreamUnthrottledCallback(
+    std::function<void(const std::string&)> callback) {
+  absl::MutexLock lock(&full_input_streams_mutex_);
+  graph_input_stream_unthrottled_callback_ = std::move(callback);
+}
+
+::mediapipe::Status CalculatorGraph::WaitUntilGraphInputStreamAcceptsPackets(
+    int node_id, bool may_block) {
+  absl::MutexLock lock(&full_input_streams_mutex_);
+  if (!may_block || graph_input_stream_add_mode_ ==
+                        GraphInputStreamAddMode::ADD_IF_NOT_FULL) {
+    if (has_error_) {
+      ::mediapipe::Status error_status;
+      GetCombinedErrors("Graph has errors: ", &error_status);
+      return error_status;
+    }
+    // Return with StatusUnavailable if this stream is being throttled.
+    if (!full_input_streams_[node_id].empty()) {
+      return ::mediapipe::UnavailableErrorBuilder(MEDIAPIPE_LOC)
+             << "Graph is throttled.";
+    }
+  } else if (graph_input_stream_add_mode_ ==
+             GraphInputStreamAddMode::WAIT_TILL_NOT_FULL) {
+    // Wait until this stream is not being throttled.
+    // TODO: instead of checking has_error_, we could just check
+    // if the graph is done. That could also be indicated by returning an
+    // error from WaitUntilGraphInputStreamUnthrottled.
+    while (!has_error_ && !full_input_streams_[node_id].empty()) {
+      // TODO: allow waiting for a specific stream?
+      scheduler_.WaitUntilGraphInputStreamUnthrottled(
+          &full_input_streams_mutex_);
+    }
+    if (has_error_) {
+      ::mediapipe::Status error_status;
+      GetCombinedErrors("Graph has errors: ", &error_status);
+      return error_status;
+    }
+  }
+  return ::mediapipe::OkStatus();
 }
 
 // We avoid having two copies of this code for AddPacketToInputStream(
@@ -792,7 +895,7 @@ CalculatorGraph::PrepareGpu(const std::map<std::string, Packet>& side_packets) {
 // std::forward will deduce the correct type as we pass along packet.
 template <typename T>
 ::mediapipe::Status CalculatorGraph::AddPacketToInputStreamInternal(
-    const std::string& stream_name, T&& packet) {
+    const std::string& stream_name, T&& packet, bool may_block) {
   std::unique_ptr<GraphInputStream>* stream =
       ::mediapipe::FindOrNull(graph_input_streams_, stream_name);
   RET_CHECK(stream).SetNoLogging() << absl::Substitute(
@@ -802,38 +905,8 @@ template <typename T>
   int node_id =
       ::mediapipe::FindOrDie(graph_input_stream_node_ids_, stream_name);
   CHECK_GE(node_id, validated_graph_->CalculatorInfos().size());
-  {
-    absl::MutexLock lock(&full_input_streams_mutex_);
-    if (graph_input_stream_add_mode_ ==
-        GraphInputStreamAddMode::ADD_IF_NOT_FULL) {
-      if (has_error_) {
-        ::mediapipe::Status error_status;
-        GetCombinedErrors("Graph has errors: ", &error_status);
-        return error_status;
-      }
-      // Return with StatusUnavailable if this stream is being throttled.
-      if (!full_input_streams_[node_id].empty()) {
-        return ::mediapipe::UnavailableErrorBuilder(MEDIAPIPE_LOC)
-               << "Graph is throttled.";
-      }
-    } else if (graph_input_stream_add_mode_ ==
-               GraphInputStreamAddMode::WAIT_TILL_NOT_FULL) {
-      // Wait until this stream is not being throttled.
-      // TODO: instead of checking has_error_, we could just check
-      // if the graph is done. That could also be indicated by returning an
-      // error from WaitUntilGraphInputStreamUnthrottled.
-      while (!has_error_ && !full_input_streams_[node_id].empty()) {
-        // TODO: allow waiting for a specific stream?
-        scheduler_.WaitUntilGraphInputStreamUnthrottled(
-            &full_input_streams_mutex_);
-      }
-      if (has_error_) {
-        ::mediapipe::Status error_status;
-        GetCombinedErrors("Graph has errors: ", &error_status);
-        return error_status;
-      }
-    }
-  }
+  MP_RETURN_IF_ERROR(
+      WaitUntilGraphInputStreamAcceptsPackets(node_id, may_block));
 
   // Adding profiling info for a new packet entering the graph.
   const std::string* stream_id = &(*stream)->GetManager()->Name();
@@ -865,6 +938,74 @@ template <typename T>
   return ::mediapipe::OkStatus();
 }
 
+::mediapipe::Status CalculatorGraph::AddPacketsToInputStream(
+    const std::string& stream_name, std::vector<Packet>&& packets) {
+  std::unique_ptr<GraphInputStream>* stream =
+      ::mediapipe::FindOrNull(graph_input_streams_, stream_name);
+  RET_CHECK(stream).SetNoLogging() << absl::Substitute(
+      "AddPacketsToInputStream called on input stream \"$0\" which is not a "
+      "graph input stream.",
+      stream_name);
+  if (packets.empty()) {
+    return ::mediapipe::OkStatus();
+  }
+  int node_id =
+      ::mediapipe::FindOrDie(graph_input_stream_node_ids_, stream_name);
+  CHECK_GE(node_id, validated_graph_->CalculatorInfos().size());
+  MP_RETURN_IF_ERROR(
+      WaitUntilGraphInputStreamAcceptsPackets(node_id, /*may_block=*/true));
+
+  const std::string* stream_id = &(*stream)->GetManager()->Name();
+  for (Packet& packet : packets) {
+    profiler_->LogEvent(TraceEvent(TraceEvent::PROCESS)
+                            .set_is_finish(true)
+                            .set_input_ts(packet.Timestamp())
+                            .set_stream_id(stream_id)
+                            .set_packet_ts(packet.Timestamp())
+                            .set_packet_data_id(&packet));
+    (*stream)->AddPacket(std::move(packet));
+  }
+  packets.clear();
+  if (has_error_) {
+    ::mediapipe::Status error_status;
+    GetCombinedErrors("Graph has errors: ", &error_status);
+    return error_status;
+  }
+  // All the packets reach the mirrors through a single MovePackets() call.
+  (*stream)->PropagateUpdatesToMirrors();
+
+  VLOG(2) << "Packets added directly to: " << stream_name;
+  scheduler_.AddedPacketToGraphInputStream();
+  return ::mediapipe::OkStatus();
+}
+
+void CalculatorGraph::UpdateSchedulingPriorities() {
+  std::vector<CalculatorProfile> profiles;
+  // Without a profiler, every node gets the same cost.
+  profiler_->GetCalculatorProfiles(&profiles).IgnoreError();
+  std::vector<int64> path_costs =
+      critical_path_estimator_->EstimatePathCosts(profiles);
+  for (int i = 0; i < nodes_->size(); ++i) {
+    (*nodes_)[i].SetSchedulingPriority(path_costs[i]);
+  }
+  next_priority_update_usec_.store(
+      absl::GetCurrentTimeNanos() / 1000 +
+      kSchedulingPriorityUpdateIntervalUsec);
+}
+
+void CalculatorGraph::MaybeUpdateSchedulingPriorities() {
+  int64 next_update_usec = next_priority_update_usec_.load();
+  int64 now_usec = absl::GetCurrentTimeNanos() / 1000;
+  if (now_usec < next_update_usec) {
+    return;
+  }
+  // Only the thread that claims this update runs it.
+  if (next_priority_update_usec_.compare_exchange_strong(
+          next_update_usec, now_usec + kSchedulingPriorityUpdateIntervalUsec)) {
+    UpdateSchedulingPriorities();
+  }
+}
+
 ::mediapipe::Status CalculatorGraph::SetInputStreamMaxQueueSize(
     const std::string& stream_name, int max_queue_size) {
   // graph_input_streams_ has not been filled in yet, so we'll check this when
@@ -1012,6 +1153,23 @@ void CalculatorGraph::CallStatusHandlers(GraphRunState graph_run_state,
 
 int CalculatorGraph::GetMaxInputStreamQueueSize() { return max_queue_size_; }
 
+std::map<std::pair<std::string, std::string>, int>
+CalculatorGraph::GetInputStreamQueueSizes() {
+  std::map<std::pair<std::string, std::string>, int> queue_sizes;
+  const auto& input_stream_infos = validated_graph_->InputStreamInfos();
+  for (int index = 0; index < input_stream_infos.size(); ++index) {
+    const EdgeInfo& edge_info = input_stream_infos[index];
+    if (edge_info.parent_node.type != NodeTypeInfo::NodeType::CALCULATOR) {
+      continue;
+    }
+    std::string node_name = CanonicalNodeName(validated_graph_->Config(),
+                                              edge_info.parent_node.index);
+    queue_sizes[{node_name, edge_info.name}] =
+        input_stream_managers_[index].QueueSize();
+  }
+  return queue_sizes;
+}
+
 void CalculatorGraph::UpdateThrottledNodes(InputStreamManager* stream,
                                            bool* stream_was_full) {
   // TODO Change the throttling code to use the index directly
@@ -1029,6 +1187,8 @@ void CalculatorGraph::UpdateThrottledNodes(InputStreamManager* stream,
   }
   CHECK(upstream_nodes);
   std::vector<CalculatorNode*> nodes_to_schedule;
+  std::vector<const std::string*> unthrottled_graph_input_streams;
+  std::function<void(const std::string&)> unthrottled_callback;
 
   {
     absl::MutexLock lock(&full_input_streams_mutex_);
@@ -1039,6 +1199,17 @@ void CalculatorGraph::UpdateThrottledNodes(InputStreamManager* stream,
     // in this function and is guarded by full_input_streams_mutex_.
     bool stream_is_full = stream->IsFull();
     if (*stream_was_full != stream_is_full) {
+      if (stream_is_full) {
+        counter_factory_->GetCounter(absl::StrCat(stream->Name(), "-Throttled"))
+            ->Increment();
+      }
+      // The queues of OutputStreamPollers are not in input_stream_managers_.
+      if (stream >= input_stream_managers_.get() &&
+          stream < input_stream_managers_.get() +
+                       validated_graph_->InputStreamInfos().size()) {
+        profiler_->SetInputStreamFull(stream - input_stream_managers_.get(),
+                                      stream_is_full);
+      }
       for (int node_id : *upstream_nodes) {
         VLOG(2) << "Stream \"" << stream->Name() << "\" is "
                 << (stream_is_full ? "throttling" : "no longer throttling")
@@ -1047,6 +1218,7 @@ void CalculatorGraph::UpdateThrottledNodes(InputStreamManager* stream,
             profiler_.get(),
             TraceEvent(stream_is_full ? TraceEvent::THROTTLED
                                       : TraceEvent::UNTHROTTLED)
+                .set_node_id(node_id)
                 .set_stream_id(&stream->Name()));
         bool was_throttled = !full_input_streams_[node_id].empty();
         if (stream_is_full) {
@@ -1058,6 +1230,9 @@ void CalculatorGraph::UpdateThrottledNodes(InputStreamManager* stream,
         }
 
         bool is_throttled = !full_input_streams_[node_id].empty();
+        if (was_throttled != is_throttled) {
+          profiler_->SetNodeThrottled(node_id, is_throttled);
+        }
         bool is_graph_input_stream =
             node_id >= validated_graph_->CalculatorInfos().size();
         if (is_graph_input_stream) {
@@ -1066,6 +1241,11 @@ void CalculatorGraph::UpdateThrottledNodes(InputStreamManager* stream,
           // Note: !is_throttled implies was_throttled, but not vice versa.
           if (!is_throttled) {
             scheduler_.UnthrottledGraphInputStream();
+            if (graph_input_stream_unthrottled_callback_) {
+              unthrottled_graph_input_streams.push_back(
+                  &graph_input_stream_names_
+                      [node_id - validated_graph_->CalculatorInfos().size()]);
+            }
           } else if (!was_throttled && is_throttled) {
             scheduler_.ThrottledGraphInputStream();
           }
@@ -1081,11 +1261,19 @@ void CalculatorGraph::UpdateThrottledNodes(InputStreamManager* stream,
       }
     }
     *stream_was_full = stream_is_full;
+    if (!unthrottled_graph_input_streams.empty()) {
+      unthrottled_callback = graph_input_stream_unthrottled_callback_;
+    }
   }
 
   if (!nodes_to_schedule.empty()) {
     scheduler_.ScheduleUnthrottledReadyNodes(nodes_to_schedule);
   }
+  // The callback is invoked without holding full_input_streams_mutex_, so
+  // that it may add packets to the graph input streams.
+  for (const std::string* stream_name : unthrottled_graph_input_streams) {
+    unthrottled_callback(*stream_name);
+  }
 }
 
 bool CalculatorGraph::IsNodeThrottled(int node_id) {
@@ -62,6 +62,8 @@ struct GpuSharedData;
 
 namespace mediapipe {
 
+class CriticalPathEstimator;
+
 typedef ::mediapipe::StatusOr<OutputStreamPoller> StatusOrPoller;
 
 // The class representing a DAG of calculator nodes.
@@ -252,6 +254,36 @@ class CalculatorGraph {
   ::mediapipe::Status AddPacketToInputStream(const std::string& stream_name,
                                              Packet&& packet);
 
+  // Adds a batch of packets to a graph input stream, in order.  This is
+  // equivalent to calling AddPacketToInputStream() for each packet, but the
+  // throttling check is done and the scheduler is notified only once per
+  // batch, which matters for streams carrying many small packets, such as
+  // audio samples.  The packets must have increasing timestamps.  Since the
+  // queue sizes are only checked before the batch is added, a batch may
+  // exceed max_queue_size.  Adding an empty batch does nothing.
+  ::mediapipe::Status AddPacketsToInputStream(const std::string& stream_name,
+                                              std::vector<Packet>&& packets);
+
+  // Adds a Packet to a graph input stream without blocking, regardless of the
+  // graph input stream add mode.  Returns StatusUnavailable, and leaves the
+  // packet untouched, if the stream is throttled.  Together with
+  // SetGraphInputStreamUnthrottledCallback(), this lets an event loop feed
+  // many graph input streams without dedicating a blocked thread to each.
+  ::mediapipe::Status TryAddPacketToInputStream(const std::string& stream_name,
+                                                const Packet& packet);
+  ::mediapipe::Status TryAddPacketToInputStream(const std::string& stream_name,
+                                                Packet&& packet);
+
+  // Sets a callback invoked with the name of a graph input stream each time
+  // it stops being throttled, so that a rejected packet may be added again.
+  // The callback runs on a graph thread with no graph locks held, and should
+  // return quickly; it may call TryAddPacketToInputStream().  It is a hint: by
+  // the time it runs the stream may be throttled again.  It is not invoked
+  // when the graph fails or is cancelled, so callers waiting for it should
+  // also watch for the end of the run.  Passing nullptr removes the callback.
+  void SetGraphInputStreamUnthrottledCallback(
+      std::function<void(const std::string&)> callback);
+
   // Sets the queue size of a graph input stream, overriding the graph default.
   ::mediapipe::Status SetInputStreamMaxQueueSize(const std::string& stream_name,
                                                  int max_queue_size);
@@ -303,6 +335,12 @@ class CalculatorGraph {
   // Returns the maximum input stream queue size.
   int GetMaxInputStreamQueueSize();
 
+  // Returns the number of packets queued in each calculator input stream,
+  // keyed by the canonical node name and the input stream name. May be called
+  // at any time after the graph has been initialized.
+  std::map<std::pair<std::string, std::string>, int>
+  GetInputStreamQueueSizes();
+
   // Get the mode for adding packets to an input stream.
   GraphInputStreamAddMode GetGraphInputStreamAddMode() const;
 
@@ -440,12 +478,30 @@ class CalculatorGraph {
       std::unique_ptr<ValidatedGraphConfig> validated_graph,
       const std::map<std::string, Packet>& side_packets);
 
+  // Waits until the graph input stream of node "node_id" may accept packets
+  // according to graph_input_stream_add_mode_.  Returns StatusUnavailable if
+  // the stream is throttled in the ADD_IF_NOT_FULL mode, or the graph errors.
+  // If |may_block| is false, behaves as in the ADD_IF_NOT_FULL mode.
+  ::mediapipe::Status WaitUntilGraphInputStreamAcceptsPackets(int node_id,
+                                                              bool may_block);
+
+  // Sets the scheduling priority of every node to its critical path cost,
+  // estimated from the profiler's Process() runtimes.  Only used with the
+  // CRITICAL_PATH scheduling policy.
+  void UpdateSchedulingPriorities();
+
+  // Calls UpdateSchedulingPriorities() if the priorities have not been
+  // updated for kSchedulingPriorityUpdateIntervalUsec.  Thread-safe.
+  void MaybeUpdateSchedulingPriorities();
+
   // AddPacketToInputStreamInternal template is called by either
   // AddPacketToInputStream(Packet&& packet) or
   // AddPacketToInputStream(const Packet& packet).
+  // If |may_block| is false, the packet is only added if the stream is not
+  // throttled.
   template <typename T>
   ::mediapipe::Status AddPacketToInputStreamInternal(
-      const std::string& stream_name, T&& packet);
+      const std::string& stream_name, T&& packet, bool may_block);
 
   // Sets the executor that will run the nodes assigned to the executor
   // named |name|.  If |name| is empty, this sets the default executor.
@@ -589,6 +645,15 @@ class CalculatorGraph {
   // Maps graph input streams to their virtual node ids.
   std::unordered_map<std::string, int> graph_input_stream_node_ids_;
 
+  // The names of the graph input streams, indexed by virtual node id minus
+  // the number of calculator nodes.
+  std::vector<std::string> graph_input_stream_names_;
+
+  // Invoked when a graph input stream stops being throttled.
+  std::function<void(const std::string&)>
+      graph_input_stream_unthrottled_callback_
+          GUARDED_BY(full_input_streams_mutex_);
+
   // Maps graph input streams to their max queue size.
   std::unordered_map<std::string, int> graph_input_stream_max_queue_size_;
 
@@ -632,6 +697,13 @@ class CalculatorGraph {
   // TODO: update this comment.
   std::atomic<unsigned int> num_closed_graph_input_streams_;
 
+  // Estimates the node priorities for the CRITICAL_PATH scheduling policy.
+  // Null with the other policies.
+  std::unique_ptr<CriticalPathEstimator> critical_path_estimator_;
+  // The earliest time of the next call to UpdateSchedulingPriorities(), in
+  // microseconds since the epoch.
+  std::atomic<int64> next_priority_update_usec_{0};
+
   // The graph tracing and profiling interface.  It is owned by the
   // CalculatorGraph using a shared_ptr in order to allow threadsafe access
   // to the ProfilingContext from clients that may outlive the CalculatorGraph
@@ -0,0 +1,116 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "mediapipe/framework/calculator_graph_pool.h"
+
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+
+namespace mediapipe {
+
+::mediapipe::StatusOr<std::unique_ptr<CalculatorGraphPool>>
+CalculatorGraphPool::Create(const CalculatorGraphConfig& config, int size,
+                            const std::vector<std::string>& output_streams,
+                            const std::map<std::string, Packet>& side_packets) {
+  RET_CHECK_GT(size, 0);
+  std::unique_ptr<CalculatorGraphPool> pool(
+      new CalculatorGraphPool(side_packets));
+  for (int i = 0; i < size; ++i) {
+    MP_RETURN_IF_ERROR(pool->AddGraph(config, output_streams));
+  }
+  return std::move(pool);
+}
+
+CalculatorGraphPool::~CalculatorGraphPool() {
+  for (auto& pooled_graph : graphs_) {
+    pooled_graph->graph.Cancel();
+    pooled_graph->graph.WaitUntilDone().IgnoreError();
+  }
+}
+
+::mediapipe::Status CalculatorGraphPool::AddGraph(
+    const CalculatorGraphConfig& config,
+    const std::vector<std::string>& output_streams) {
+  graphs_.push_back(absl::make_unique<PooledGraph>());
+  PooledGraph* pooled_graph = graphs_.back().get();
+  MP_RETURN_IF_ERROR(pooled_graph->graph.Initialize(config));
+  for (const std::string& stream_name : output_streams) {
+    MP_RETURN_IF_ERROR(pooled_graph->graph.ObserveOutputStream(
+        stream_name,
+        [pooled_graph, stream_name](const Packet& packet) {
+          OutputCallback callback;
+          {
+            absl::MutexLock lock(&pooled_graph->mutex);
+            callback = pooled_graph->callback;
+          }
+          if (!callback) {
+            return ::mediapipe::OkStatus();
+          }
+          return callback(stream_name, packet);
+        }));
+  }
+  MP_RETURN_IF_ERROR(pooled_graph->graph.StartRun(side_packets_));
+  absl::MutexLock lock(&mutex_);
+  idle_graphs_.push_back(pooled_graph);
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::StatusOr<CalculatorGraph*> CalculatorGraphPool::Acquire(
+    OutputCallback callback) {
+  PooledGraph* pooled_graph;
+  {
+    absl::MutexLock lock(&mutex_);
+    mutex_.Await(absl::Condition(
+        +[](std::vector<PooledGraph*>* idle_graphs) {
+          return !idle_graphs->empty();
+        },
+        &idle_graphs_));
+    pooled_graph = idle_graphs_.back();
+    idle_graphs_.pop_back();
+  }
+  absl::MutexLock lock(&pooled_graph->mutex);
+  pooled_graph->callback = std::move(callback);
+  return &pooled_graph->graph;
+}
+
+::mediapipe::Status CalculatorGraphPool::Release(CalculatorGraph* graph) {
+  PooledGraph* pooled_graph = nullptr;
+  for (auto& candidate : graphs_) {
+    if (&candidate->graph == graph) {
+      pooled_graph = candidate.get();
+    }
+  }
+  RET_CHECK(pooled_graph) << "The graph was not acquired from this pool.";
+
+  ::mediapipe::Status status = graph->CloseAllInputStreams();
+  status.Update(graph->WaitUntilDone());
+  {
+    absl::MutexLock lock(&pooled_graph->mutex);
+    pooled_graph->callback = nullptr;
+  }
+  ::mediapipe::Status start_status = graph->StartRun(side_packets_);
+  if (!start_status.ok()) {
+    LOG(ERROR) << "Dropping a graph from the pool: " << start_status;
+    return start_status;
+  }
+  absl::MutexLock lock(&mutex_);
+  idle_graphs_.push_back(pooled_graph);
+  return status;
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,107 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef MEDIAPIPE_FRAMEWORK_CALCULATOR_GRAPH_POOL_H_
+#define MEDIAPIPE_FRAMEWORK_CALCULATOR_GRAPH_POOL_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/calculator_graph.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+
+namespace mediapipe {
+
+// Keeps a number of graphs running the same config initialized and started,
+// so that a session can take a graph whose calculators are already open
+// instead of paying for Initialize(), StartRun() and resource loading.
+//
+// A session feeds the graph through its graph input streams, and receives
+// the packets of the output streams observed by the pool through the
+// callback passed to Acquire().  Releasing the graph closes its input
+// streams, waits for the run to finish, and starts the next run right away,
+// so the graph must be driven by its graph input streams rather than by
+// source nodes.  Example:
+//
+//   ASSIGN_OR_RETURN(auto pool, CalculatorGraphPool::Create(
+//                                   config, 4, {"output"}, side_packets));
+//   ...
+//   ASSIGN_OR_RETURN(CalculatorGraph* graph,
+//                    pool->Acquire([](const std::string& stream_name,
+//                                     const Packet& packet) { ... }));
+//   MP_RETURN_IF_ERROR(graph->AddPacketToInputStream("input", packet));
+//   ...
+//   MP_RETURN_IF_ERROR(pool->Release(graph));
+class CalculatorGraphPool {
+ public:
+  using OutputCallback = std::function<::mediapipe::Status(
+      const std::string& stream_name, const Packet& packet)>;
+
+  // Initializes "size" graphs from "config", observes "output_streams" of
+  // each, and starts their runs with "side_packets".
+  static ::mediapipe::StatusOr<std::unique_ptr<CalculatorGraphPool>> Create(
+      const CalculatorGraphConfig& config, int size,
+      const std::vector<std::string>& output_streams,
+      const std::map<std::string, Packet>& side_packets);
+
+  // Cancels and waits for the runs of all the graphs.  Graphs acquired from
+  // the pool must not be used afterwards.
+  ~CalculatorGraphPool();
+
+  // Takes a started graph from the pool, waiting for one to be released if
+  // they are all in use.  The packets of the observed output streams are sent
+  // to "callback" until the graph is released.
+  ::mediapipe::StatusOr<CalculatorGraph*> Acquire(OutputCallback callback)
+      LOCKS_EXCLUDED(mutex_);
+
+  // Closes the graph input streams of "graph", waits until its run is done,
+  // starts its next run and returns it to the pool.  Returns the status of
+  // the finished run.  If the next run cannot be started, the graph is
+  // dropped from the pool and that error is returned instead.
+  ::mediapipe::Status Release(CalculatorGraph* graph) LOCKS_EXCLUDED(mutex_);
+
+ private:
+  struct PooledGraph {
+    CalculatorGraph graph;
+    absl::Mutex mutex;
+    // The callback of the session using the graph, or null while the graph
+    // is in the pool.
+    OutputCallback callback GUARDED_BY(mutex);
+  };
+
+  explicit CalculatorGraphPool(
+      const std::map<std::string, Packet>& side_packets)
+      : side_packets_(side_packets) {}
+
+  // Initializes and starts a graph, and adds it to the pool.
+  ::mediapipe::Status AddGraph(const CalculatorGraphConfig& config,
+                               const std::vector<std::string>& output_streams)
+      LOCKS_EXCLUDED(mutex_);
+
+  const std::map<std::string, Packet> side_packets_;
+  std::vector<std::unique_ptr<PooledGraph>> graphs_;
+  absl::Mutex mutex_;
+  std::vector<PooledGraph*> idle_graphs_ GUARDED_BY(mutex_);
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_CALCULATOR_GRAPH_POOL_H_
@@ -0,0 +1,97 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "mediapipe/framework/calculator_graph_pool.h"
+
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+CalculatorGraphConfig PassThroughConfig() {
+  return ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+    input_stream: "input"
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "input"
+      output_stream: "output"
+    }
+  )");
+}
+
+// Runs one session on "pool", and returns the values it output.
+std::vector<int> RunSession(CalculatorGraphPool* pool,
+                            const std::vector<int>& values) {
+  std::vector<int> outputs;
+  auto graph_or = pool->Acquire(
+      [&outputs](const std::string& stream_name, const Packet& packet) {
+        EXPECT_EQ("output", stream_name);
+        outputs.push_back(packet.Get<int>());
+        return ::mediapipe::OkStatus();
+      });
+  EXPECT_TRUE(graph_or.ok());
+  CalculatorGraph* graph = graph_or.ValueOrDie();
+  for (int i = 0; i < values.size(); ++i) {
+    MP_EXPECT_OK(graph->AddPacketToInputStream(
+        "input", MakePacket<int>(values[i]).At(Timestamp(i))));
+  }
+  MP_EXPECT_OK(pool->Release(graph));
+  return outputs;
+}
+
+TEST(CalculatorGraphPoolTest, ReusesGraphsAcrossSessions) {
+  auto pool_or =
+      CalculatorGraphPool::Create(PassThroughConfig(), 1, {"output"}, {});
+  MP_ASSERT_OK(pool_or.status());
+  std::unique_ptr<CalculatorGraphPool> pool = std::move(pool_or.ValueOrDie());
+
+  EXPECT_THAT(RunSession(pool.get(), {1, 2}), testing::ElementsAre(1, 2));
+  EXPECT_THAT(RunSession(pool.get(), {3}), testing::ElementsAre(3));
+}
+
+TEST(CalculatorGraphPoolTest, AcquiresDistinctGraphs) {
+  auto pool_or =
+      CalculatorGraphPool::Create(PassThroughConfig(), 2, {"output"}, {});
+  MP_ASSERT_OK(pool_or.status());
+  std::unique_ptr<CalculatorGraphPool> pool = std::move(pool_or.ValueOrDie());
+
+  auto ignore = [](const std::string& stream_name, const Packet& packet) {
+    return ::mediapipe::OkStatus();
+  };
+  auto first = pool->Acquire(ignore);
+  auto second = pool->Acquire(ignore);
+  MP_ASSERT_OK(first.status());
+  MP_ASSERT_OK(second.status());
+  EXPECT_NE(first.ValueOrDie(), second.ValueOrDie());
+  MP_EXPECT_OK(pool->Release(first.ValueOrDie()));
+  MP_EXPECT_OK(pool->Release(second.ValueOrDie()));
+}
+
+TEST(CalculatorGraphPoolTest, RejectsForeignGraph) {
+  auto pool_or =
+      CalculatorGraphPool::Create(PassThroughConfig(), 1, {"output"}, {});
+  MP_ASSERT_OK(pool_or.status());
+  CalculatorGraph graph;
+  EXPECT_FALSE(pool_or.ValueOrDie()->Release(&graph).ok());
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -42,6 +42,7 @@
 #include "mediapipe/framework/output_stream_poller.h"
 #include "mediapipe/framework/packet_set.h"
 #include "mediapipe/framework/packet_type.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
@@ -58,6 +59,7 @@
 #include "mediapipe/framework/tool/sink.h"
 #include "mediapipe/framework/tool/status_util.h"
 #include "mediapipe/framework/type_map.h"
+#include "mediapipe/util/cpu_util.h"
 
 namespace mediapipe {
 
@@ -111,6 +113,29 @@ class SquareIntCalculator : public CalculatorBase {
 };
 REGISTER_CALCULATOR(SquareIntCalculator);
 
+// Takes over its int input with InputStream::ConsumeOrCopy, and outputs
+// whether the input had to be copied.
+class ConsumeOrCopyIntCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<bool>();
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) final {
+    bool was_copied;
+    ASSIGN_OR_RETURN(auto value,
+                     cc->Inputs().Index(0).ConsumeOrCopy<int>(&was_copied));
+    RET_CHECK(cc->Inputs().Index(0).IsEmpty());
+    RET_CHECK_EQ(cc->Inputs().Index(0).Value().Timestamp(),
+                 cc->InputTimestamp());
+    cc->Outputs().Index(0).Add(new bool(was_copied), cc->InputTimestamp());
+    return ::mediapipe::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(ConsumeOrCopyIntCalculator);
+
 // A Calculator that selects an output stream from "OUTPUT:0", "OUTPUT:1", ...,
 // using the integer value (0, 1, ...) in the packet on the "SELECT" input
 // stream, and passes the packet on the "INPUT" input stream to the selected
@@ -1140,6 +1165,42 @@ class PthreadSelfSourceCalculator : public CalculatorBase {
 };
 REGISTER_CALCULATOR(PthreadSelfSourceCalculator);
 
+// For each input packet, outputs a packet containing the pthread_t of the
+// thread that runs Process().
+class PthreadSelfCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).Set<pthread_t>();
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    cc->Outputs().Index(0).AddPacket(
+        MakePacket<pthread_t>(pthread_self()).At(cc->InputTimestamp()));
+    return ::mediapipe::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(PthreadSelfCalculator);
+
+// Appends the node name to the std::vector<std::string> in the input side
+// packet each time Process() runs.
+class RecordNodeNameCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->InputSidePackets().Index(0).Set<std::vector<std::string>*>();
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    cc->InputSidePackets().Index(0).Get<std::vector<std::string>*>()->push_back(
+        cc->NodeName());
+    return ::mediapipe::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(RecordNodeNameCalculator);
+
 // A source calculator for testing the Calculator::InputTimestamp() method.
 // It outputs five int packets with timestamps 0, 1, 2, 3, 4.
 class CheckInputTimestampSourceCalculator : public CalculatorBase {
@@ -1783,6 +1844,44 @@ TEST(CalculatorGraph, RunsCorrectlyOnApplicationThread) {
   RunComprehensiveTest(&graph, proto, /*define_node_5=*/true);
 }
 
+TEST(CalculatorGraph, RunsCorrectlyWithShardedSchedulerQueue) {
+  CalculatorGraph graph;
+  CalculatorGraphConfig proto = GetConfig();
+  proto.set_scheduler_queue(CalculatorGraphConfig::SHARDED_QUEUE);
+  RunComprehensiveTest(&graph, proto, /*define_node_5=*/true);
+}
+
+TEST(CalculatorGraph, RunsCorrectlyWithCriticalPathScheduling) {
+  CalculatorGraph graph;
+  CalculatorGraphConfig proto = GetConfig();
+  proto.set_scheduling_policy(CalculatorGraphConfig::CRITICAL_PATH);
+  proto.mutable_profiler_config()->set_enable_profiler(true);
+  RunComprehensiveTest(&graph, proto, /*define_node_5=*/true);
+}
+
+TEST(CalculatorGraph, RunsCorrectlyWithInlineNodes) {
+  CalculatorGraph graph;
+  CalculatorGraphConfig proto = GetConfig();
+  for (int i = 0; i < proto.node_size(); ++i) {
+    proto.mutable_node(i)->set_run_inline(true);
+  }
+  RunComprehensiveTest(&graph, proto, /*define_node_5=*/true);
+}
+
+TEST(CalculatorGraph, RunsCorrectlyWithBackgroundNodes) {
+  for (auto scheduler_queue : {CalculatorGraphConfig::PRIORITY_QUEUE,
+                               CalculatorGraphConfig::SHARDED_QUEUE}) {
+    CalculatorGraph graph;
+    CalculatorGraphConfig proto = GetConfig();
+    proto.set_scheduler_queue(scheduler_queue);
+    for (int i = 0; i < proto.node_size(); i += 2) {
+      proto.mutable_node(i)->set_priority_class(
+          CalculatorGraphConfig::Node::BACKGROUND);
+    }
+    RunComprehensiveTest(&graph, proto, /*define_node_5=*/true);
+  }
+}
+
 TEST(CalculatorGraph, RunsCorrectlyWithExternalExecutor) {
   CalculatorGraph graph;
   MP_ASSERT_OK(graph.SetExecutor("", std::make_shared<ThreadPoolExecutor>(1)));
@@ -1862,6 +1961,182 @@ TEST(CalculatorGraph, RunsCorrectlyWithMultipleExecutors) {
   RunComprehensiveTest(&graph, proto, /*define_node_5=*/true);
 }
 
+// Verifies that an inline node runs on the thread of its upstream node.
+TEST(CalculatorGraph, InlineNodeRunsOnUpstreamThread) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: 'in'
+        node {
+          calculator: 'PthreadSelfCalculator'
+          input_stream: 'in'
+          output_stream: 'upstream_thread'
+        }
+        node {
+          calculator: 'PthreadSelfCalculator'
+          input_stream: 'upstream_thread'
+          output_stream: 'inline_thread'
+          run_inline: true
+        }
+        num_threads: 4
+      )");
+  std::vector<Packet> upstream_packets;
+  std::vector<Packet> inline_packets;
+  tool::AddVectorSink("upstream_thread", &config, &upstream_packets);
+  tool::AddVectorSink("inline_thread", &config, &inline_packets);
+
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < 10; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  ASSERT_EQ(10, upstream_packets.size());
+  ASSERT_EQ(10, inline_packets.size());
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(upstream_packets[i].Timestamp(), inline_packets[i].Timestamp());
+    EXPECT_TRUE(pthread_equal(upstream_packets[i].Get<pthread_t>(),
+                              inline_packets[i].Get<pthread_t>()));
+  }
+}
+
+// Verifies that a background node runs only when no normal node is ready.
+TEST(CalculatorGraph, BackgroundNodeRunsAfterNormalNodes) {
+  for (auto scheduler_queue : {CalculatorGraphConfig::PRIORITY_QUEUE,
+                               CalculatorGraphConfig::SHARDED_QUEUE}) {
+    CalculatorGraphConfig config =
+        ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+          input_stream: 'in'
+          input_side_packet: 'order'
+          node {
+            name: 'normal'
+            calculator: 'RecordNodeNameCalculator'
+            input_stream: 'in'
+            input_side_packet: 'order'
+          }
+          node {
+            name: 'background'
+            calculator: 'RecordNodeNameCalculator'
+            input_stream: 'in'
+            input_side_packet: 'order'
+            priority_class: BACKGROUND
+            run_inline: true
+          }
+          executor { type: 'ApplicationThreadExecutor' }
+        )");
+    config.set_scheduler_queue(scheduler_queue);
+    std::vector<std::string> order;
+
+    CalculatorGraph graph;
+    MP_ASSERT_OK(graph.Initialize(config));
+    MP_ASSERT_OK(graph.StartRun(
+        {{"order", MakePacket<std::vector<std::string>*>(&order)}}));
+    // On the application thread nothing runs until WaitUntilIdle(), so both
+    // nodes have all their packets queued by then.
+    for (int i = 0; i < 5; ++i) {
+      MP_ASSERT_OK(graph.AddPacketToInputStream(
+          "in", MakePacket<int>(i).At(Timestamp(i))));
+    }
+    MP_ASSERT_OK(graph.WaitUntilIdle());
+    MP_ASSERT_OK(graph.CloseAllInputStreams());
+    MP_ASSERT_OK(graph.WaitUntilDone());
+
+    // The background node runs last even though its larger id would make it
+    // run first among normal nodes, and it is not run inline.
+    EXPECT_THAT(order, testing::ElementsAre("normal", "normal", "normal",
+                                            "normal", "normal", "background",
+                                            "background", "background",
+                                            "background", "background"));
+  }
+}
+
+// A stateless calculator that records how many of its invocations overlap.
+class StatelessSleepCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).SetSameAs(&cc->Inputs().Index(0));
+    cc->SetStateless(true);
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    int in_flight = ++num_in_flight_;
+    int max_in_flight = max_in_flight_.load();
+    while (in_flight > max_in_flight &&
+           !max_in_flight_.compare_exchange_weak(max_in_flight, in_flight)) {
+    }
+    absl::SleepFor(absl::Milliseconds(20));
+    --num_in_flight_;
+    cc->Outputs().Index(0).AddPacket(cc->Inputs().Index(0).Value());
+    return ::mediapipe::OkStatus();
+  }
+
+  static std::atomic<int> num_in_flight_;
+  static std::atomic<int> max_in_flight_;
+};
+REGISTER_CALCULATOR(StatelessSleepCalculator);
+
+std::atomic<int> StatelessSleepCalculator::num_in_flight_(0);
+std::atomic<int> StatelessSleepCalculator::max_in_flight_(0);
+
+// Runs ten packets through a StatelessSleepCalculator node and returns the
+// maximum number of overlapping invocations.
+int RunStatelessNode(const std::string& node_options) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(absl::Substitute(
+          R"(
+            input_stream: 'in'
+            node {
+              calculator: 'StatelessSleepCalculator'
+              input_stream: 'in'
+              output_stream: 'out'
+              $0
+            }
+            num_threads: 4
+          )",
+          node_options));
+  std::vector<Packet> out_packets;
+  tool::AddVectorSink("out", &config, &out_packets);
+  StatelessSleepCalculator::max_in_flight_ = 0;
+
+  CalculatorGraph graph;
+  MP_EXPECT_OK(graph.Initialize(config));
+  MP_EXPECT_OK(graph.StartRun({}));
+  for (int i = 0; i < 10; ++i) {
+    MP_EXPECT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_EXPECT_OK(graph.CloseAllInputStreams());
+  MP_EXPECT_OK(graph.WaitUntilDone());
+
+  // The outputs are delivered in timestamp order.
+  EXPECT_EQ(10, out_packets.size());
+  for (int i = 0; i < out_packets.size(); ++i) {
+    EXPECT_EQ(Timestamp(i), out_packets[i].Timestamp());
+  }
+  return StatelessSleepCalculator::max_in_flight_;
+}
+
+// Verifies that a stateless calculator runs on several timestamps at once,
+// one per CPU core.
+TEST(CalculatorGraph, StatelessCalculatorRunsInParallel) {
+  int max_in_flight = RunStatelessNode("");
+  EXPECT_LE(max_in_flight, std::min(NumCPUCores(), 4));
+  if (NumCPUCores() > 1) {
+    EXPECT_GT(max_in_flight, 1);
+  }
+}
+
+// Verifies that the node config max_in_flight overrides the stateless
+// default.
+TEST(CalculatorGraph, StatelessCalculatorHonorsMaxInFlight) {
+  EXPECT_EQ(1, RunStatelessNode("max_in_flight: 1"));
+}
+
 // Packet generator for an arbitrary unit64 packet.
 class Uint64PacketGenerator : public PacketGenerator {
  public:
@@ -2411,6 +2686,47 @@ TEST(CalculatorGraph, InputPacketLifetime) {
   MP_EXPECT_OK(graph.WaitUntilDone());
 }
 
+// Test that an input packet is only copied by InputStream::ConsumeOrCopy if
+// another reference to it is alive.
+TEST(CalculatorGraph, ConsumeOrCopyInput) {
+  CalculatorGraph graph;
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: 'in'
+        node {
+          calculator: 'SquareIntCalculator'
+          input_stream: 'in'
+          output_stream: 'squared'
+        }
+        node {
+          calculator: 'ConsumeOrCopyIntCalculator'
+          input_stream: 'squared'
+          output_stream: 'squared_copied'
+        }
+        node {
+          calculator: 'ConsumeOrCopyIntCalculator'
+          input_stream: 'in'
+          output_stream: 'in_copied'
+        }
+      )");
+  std::vector<Packet> squared_copied;
+  std::vector<Packet> in_copied;
+  tool::AddVectorSink("squared_copied", &config, &squared_copied);
+  tool::AddVectorSink("in_copied", &config, &in_copied);
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  // The graph input packet is also held here, and read by two calculators.
+  Packet input = MakePacket<int>(3).At(Timestamp(0));
+  MP_ASSERT_OK(graph.AddPacketToInputStream("in", input));
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  ASSERT_EQ(1, squared_copied.size());
+  EXPECT_FALSE(squared_copied[0].Get<bool>());
+  ASSERT_EQ(1, in_copied.size());
+  EXPECT_TRUE(in_copied[0].Get<bool>());
+  EXPECT_EQ(3, input.Get<int>());
+}
+
 // Test that SetNextTimestampBound propagates.
 TEST(CalculatorGraph, SetNextTimestampBoundPropagation) {
   CalculatorGraph graph;
@@ -3933,6 +4249,83 @@ TEST(CalculatorGraph, SetInputStreamMaxQueueSizeWorksSlowCalculator) {
   MP_ASSERT_OK(graph.WaitUntilDone());
 }
 
+TEST(CalculatorGraph, TryAddPacketToInputStreamWithUnthrottledCallback) {
+  using Semaphore = SemaphoreCalculator::Semaphore;
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        node {
+          calculator: 'SemaphoreCalculator'
+          input_stream: 'in'
+          output_stream: 'out'
+          input_side_packet: 'POST_SEM:post_sem'
+          input_side_packet: 'WAIT_SEM:wait_sem'
+        }
+        node {
+          calculator: 'SemaphoreCalculator'
+          input_stream: 'in_2'
+          output_stream: 'out_2'
+          input_side_packet: 'POST_SEM:post_sem_busy'
+          input_side_packet: 'WAIT_SEM:wait_sem_busy'
+        }
+        input_stream: 'in'
+        input_stream: 'in_2'
+        max_queue_size: 100
+      )");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  // TryAddPacketToInputStream() never blocks, even in this mode.
+  graph.SetGraphInputStreamAddMode(
+      CalculatorGraph::GraphInputStreamAddMode::WAIT_TILL_NOT_FULL);
+  MP_ASSERT_OK(graph.SetInputStreamMaxQueueSize("in", 1));
+  Semaphore in_unthrottled(0);
+  graph.SetGraphInputStreamUnthrottledCallback(
+      [&in_unthrottled](const std::string& stream_name) {
+        if (stream_name == "in") {
+          in_unthrottled.Release(1);
+        }
+      });
+
+  Semaphore calc_entered_process(0);
+  Semaphore calc_can_exit_process(0);
+  Semaphore calc_entered_process_busy(0);
+  Semaphore calc_can_exit_process_busy(0);
+  MP_ASSERT_OK(graph.StartRun({
+      {"post_sem", MakePacket<Semaphore*>(&calc_entered_process)},
+      {"wait_sem", MakePacket<Semaphore*>(&calc_can_exit_process)},
+      {"post_sem_busy", MakePacket<Semaphore*>(&calc_entered_process_busy)},
+      {"wait_sem_busy", MakePacket<Semaphore*>(&calc_can_exit_process_busy)},
+  }));
+
+  // Prevent deadlock resolution by running the "busy" SemaphoreCalculator
+  // for the duration of the test.
+  MP_EXPECT_OK(graph.TryAddPacketToInputStream(
+      "in_2", MakePacket<int>(0).At(Timestamp(0))));
+  MP_EXPECT_OK(graph.TryAddPacketToInputStream(
+      "in", MakePacket<int>(0).At(Timestamp(0))));
+  // The first packet fills the queue of "in" until the calculator takes it.
+  calc_entered_process.Acquire(1);
+  in_unthrottled.Acquire(1);
+  for (int i = 1; i < 10; ++i) {
+    // Now the calculator is stuck processing a packet. We can queue up
+    // another one, but not two.
+    MP_EXPECT_OK(graph.TryAddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+    ::mediapipe::Status status = graph.TryAddPacketToInputStream(
+        "in", MakePacket<int>(i + 1).At(Timestamp(i + 1)));
+    EXPECT_EQ(status.code(), ::mediapipe::StatusCode::kUnavailable);
+    // Once the calculator takes the queued packet, the callback reports that
+    // "in" accepts packets again.
+    calc_can_exit_process.Release(1);
+    calc_entered_process.Acquire(1);
+    in_unthrottled.Acquire(1);
+  }
+  calc_can_exit_process.Release(1);
+  calc_can_exit_process_busy.Release(1);
+
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+}
+
 // Verify the scheduler unthrottles the graph input stream to avoid a deadlock,
 // and won't enter a busy loop.
 TEST(CalculatorGraph, AddPacketNoBusyLoop) {
@@ -4027,6 +4420,65 @@ TEST(CalculatorGraph, AddPacketNoBusyLoop) {
   }
 }
 
+TEST(CalculatorGraph, AddPacketsToInputStream) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: 'in'
+        max_queue_size: 2
+        node {
+          calculator: 'PassThroughCalculator'
+          input_stream: 'in'
+          output_stream: 'out'
+        }
+      )");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  std::vector<int> out_values;
+  MP_ASSERT_OK(
+      graph.ObserveOutputStream("out", [&out_values](const Packet& packet) {
+        out_values.push_back(packet.Get<int>());
+        return ::mediapipe::OkStatus();
+      }));
+  MP_ASSERT_OK(graph.StartRun({}));
+
+  // Each batch is larger than max_queue_size.
+  for (int batch = 0; batch < 3; ++batch) {
+    std::vector<Packet> packets;
+    for (int i = 0; i < 4; ++i) {
+      int value = batch * 4 + i;
+      packets.push_back(MakePacket<int>(value).At(Timestamp(value)));
+    }
+    MP_ASSERT_OK(graph.AddPacketsToInputStream("in", std::move(packets)));
+  }
+  MP_ASSERT_OK(graph.AddPacketsToInputStream("in", {}));
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}),
+            out_values);
+}
+
+TEST(CalculatorGraph, AddPacketsToInputStreamOutOfOrder) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: 'in'
+        node {
+          calculator: 'PassThroughCalculator'
+          input_stream: 'in'
+          output_stream: 'out'
+        }
+      )");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  std::vector<Packet> packets;
+  packets.push_back(MakePacket<int>(1).At(Timestamp(1)));
+  packets.push_back(MakePacket<int>(0).At(Timestamp(0)));
+  // As with AddPacketToInputStream(), the timestamp error is reported by the
+  // graph once the packets reach the node's input stream.
+  graph.AddPacketsToInputStream("in", std::move(packets)).IgnoreError();
+  EXPECT_FALSE(graph.WaitUntilDone().ok());
+}
+
 namespace nested_ns {
 
 typedef std::function<::mediapipe::Status(const InputStreamShardSet&,
@@ -4679,6 +5131,53 @@ TEST(CalculatorGraph, ReservedNameNodeExecutor) {
                                                testing::HasSubstr("reserved")));
 }
 
+TEST(CalculatorGraph, ReservedNameGlContextExecutorConfig) {
+  // Executors named "gpu:<context name>" are created by the graph.
+  CalculatorGraph graph;
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: 'in'
+        executor {
+          name: 'gpu:xyz'
+          type: 'ThreadPoolExecutor'
+          options {
+            [mediapipe.ThreadPoolExecutorOptions.ext] { num_threads: 1 }
+          }
+        }
+        node {
+          calculator: 'PassThroughCalculator'
+          input_stream: 'in'
+          output_stream: 'out'
+        }
+      )");
+  ::mediapipe::Status status = graph.Initialize(config);
+  EXPECT_EQ(status.code(), ::mediapipe::StatusCode::kInvalidArgument);
+  EXPECT_THAT(status.message(), testing::AllOf(testing::HasSubstr("gpu:xyz"),
+                                               testing::HasSubstr("reserved")));
+}
+
+TEST(CalculatorGraph, GlContextExecutorWithoutGpu) {
+  // A GL context executor needs no ExecutorConfig, but only GPU calculators
+  // can use it.
+  CalculatorGraph graph;
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: 'in'
+        node {
+          calculator: 'PassThroughCalculator'
+          executor: 'gpu:xyz'
+          input_stream: 'in'
+          output_stream: 'out'
+        }
+      )");
+  MP_ASSERT_OK(graph.Initialize(config));
+  ::mediapipe::Status status = graph.StartRun({});
+  EXPECT_EQ(status.code(), ::mediapipe::StatusCode::kInvalidArgument);
+  EXPECT_THAT(status.message(),
+              testing::AllOf(testing::HasSubstr("gpu:xyz"),
+                             testing::HasSubstr("GL context")));
+}
+
 TEST(CalculatorGraph, NonExistentExecutor) {
   // Any executor used by a calculator node must either be created by the
   // graph (which requires an ExecutorConfig with a "type" field) or be
@@ -4863,6 +5362,63 @@ TEST(CalculatorGraph, NumThreadsAndNonDefaultExecutorConfig) {
   MP_EXPECT_OK(graph.Initialize(config));
 }
 
+// A ThreadPoolExecutor may be pinned to explicit CPU ids.
+TEST(CalculatorGraph, RunsCorrectlyWithPinnedExecutor) {
+  CalculatorGraph graph;
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        executor {
+          name: 'pinned'
+          type: 'ThreadPoolExecutor'
+          options {
+            [mediapipe.ThreadPoolExecutorOptions.ext] {
+              num_threads: 1
+              cpu_ids: 0
+            }
+          }
+        }
+        node {
+          calculator: 'PthreadSelfSourceCalculator'
+          executor: 'pinned'
+          output_stream: 'out'
+        }
+      )");
+  MP_ASSERT_OK(graph.Initialize(config));
+  Packet out_packet;
+  MP_ASSERT_OK(
+      graph.ObserveOutputStream("out", [&out_packet](const Packet& packet) {
+        out_packet = packet;
+        return ::mediapipe::OkStatus();
+      }));
+  MP_ASSERT_OK(graph.Run());
+  EXPECT_FALSE(out_packet.IsEmpty());
+}
+
+// The cpu_ids and numa_node fields of ThreadPoolExecutorOptions must not both
+// be specified.
+TEST(CalculatorGraph, CpuIdsAndNumaNodeExecutorConfig) {
+  CalculatorGraph graph;
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        executor {
+          type: 'ThreadPoolExecutor'
+          options {
+            [mediapipe.ThreadPoolExecutorOptions.ext] {
+              num_threads: 1
+              cpu_ids: 0
+              numa_node: 0
+            }
+          }
+        }
+        node { calculator: 'PthreadSelfSourceCalculator' output_stream: 'out' }
+      )");
+  ::mediapipe::Status status = graph.Initialize(config);
+  EXPECT_EQ(status.code(), ::mediapipe::StatusCode::kInvalidArgument);
+  EXPECT_THAT(status.message(),
+              testing::AllOf(testing::HasSubstr("cpu_ids"),
+                             testing::HasSubstr("numa_node")));
+}
+
 // Verifies that the application thread is used only when
 // "ApplicationThreadExecutor" is specified.  In this test
 // "ApplicationThreadExecutor" is specified in the ExecutorConfig for the
@@ -5202,6 +5758,71 @@ class FirstPacketFilterCalculator : public CalculatorBase {
 };
 REGISTER_CALCULATOR(FirstPacketFilterCalculator);
 
+// The number of OpenRendezvousCalculator nodes that have entered Open().
+std::atomic<int> open_rendezvous_count(0);
+
+// Passes its input through, and fails in Open() unless the Open() of a
+// second OpenRendezvousCalculator node starts within a second.
+class OpenRendezvousCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).SetSameAs(&cc->Inputs().Index(0));
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    cc->SetOffset(TimestampDiff(0));
+    ++open_rendezvous_count;
+    for (int i = 0; i < 100 && open_rendezvous_count.load() < 2; ++i) {
+      absl::SleepFor(absl::Milliseconds(10));
+    }
+    RET_CHECK_GE(open_rendezvous_count.load(), 2)
+        << "Open() did not overlap with another Open().";
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    cc->Outputs().Index(0).AddPacket(cc->Inputs().Index(0).Value());
+    return ::mediapipe::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(OpenRendezvousCalculator);
+
+// Tests that concurrent_open opens a node and its upstream node
+// concurrently.
+TEST(CalculatorGraph, ConcurrentOpen) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "input"
+        num_threads: 2
+        concurrent_open: true
+        node {
+          calculator: "OpenRendezvousCalculator"
+          input_stream: "input"
+          output_stream: "middle"
+        }
+        node {
+          calculator: "OpenRendezvousCalculator"
+          input_stream: "middle"
+          output_stream: "output"
+        }
+      )");
+  std::vector<Packet> output_packets;
+  tool::AddVectorSink("output", &config, &output_packets);
+  open_rendezvous_count = 0;
+
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "input", MakePacket<int>(1).At(Timestamp(0))));
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  ASSERT_EQ(1, output_packets.size());
+  EXPECT_EQ(1, output_packets[0].Get<int>());
+}
+
 TEST(CalculatorGraph, SourceLayerInversion) {
   // There are three CountingSourceCalculators, indexed 0, 1, and 2. Each of
   // them outputs 10 packets.
@@ -5497,6 +6118,73 @@ TEST(CalculatorGraph, TestOutputStreamPollerDesiredQueueSize) {
   }
 }
 
+TEST(CalculatorGraph, TestPollPacketBatches) {
+  CalculatorGraphConfig config;
+  CalculatorGraphConfig::Node* node = config.add_node();
+  node->set_calculator("CountingSourceCalculator");
+  node->add_output_stream("output");
+  node->add_input_side_packet("MAX_COUNT:max_count");
+
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  auto status_or_poller = graph.AddOutputStreamPoller("output");
+  ASSERT_TRUE(status_or_poller.ok());
+  OutputStreamPoller poller = std::move(status_or_poller.ValueOrDie());
+  MP_ASSERT_OK(
+      graph.StartRun({{"max_count", MakePacket<int>(kDefaultMaxCount)}}));
+  std::vector<Packet> packets;
+  int num_packets = 0;
+  while (poller.NextBatch(&packets, /*max_count=*/7)) {
+    EXPECT_FALSE(packets.empty());
+    EXPECT_LE(packets.size(), 7);
+    for (const Packet& packet : packets) {
+      EXPECT_EQ(num_packets, packet.Get<int>());
+      ++num_packets;
+    }
+  }
+  MP_ASSERT_OK(graph.CloseAllPacketSources());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_FALSE(poller.NextBatch(&packets));
+  EXPECT_TRUE(packets.empty());
+  EXPECT_EQ(kDefaultMaxCount, num_packets);
+}
+
+TEST(CalculatorGraph, TestPollPacketBatchWithTimeout) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: 'in'
+        node {
+          calculator: 'PassThroughCalculator'
+          input_stream: 'in'
+          output_stream: 'out'
+        }
+      )");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  auto status_or_poller = graph.AddOutputStreamPoller("out");
+  ASSERT_TRUE(status_or_poller.ok());
+  OutputStreamPoller poller = std::move(status_or_poller.ValueOrDie());
+  MP_ASSERT_OK(graph.StartRun({}));
+
+  // No packets arrive before the timeout.
+  std::vector<Packet> packets;
+  EXPECT_TRUE(poller.NextBatch(&packets, -1, absl::Milliseconds(10)));
+  EXPECT_TRUE(packets.empty());
+
+  for (int i = 0; i < 3; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+  EXPECT_TRUE(poller.NextBatch(&packets, -1, absl::Milliseconds(10)));
+  ASSERT_EQ(3, packets.size());
+  EXPECT_EQ(2, packets[2].Get<int>());
+
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_FALSE(poller.NextBatch(&packets, -1, absl::Milliseconds(10)));
+}
+
 TEST(CalculatorGraph, TestPollPacketsFromMultipleStreams) {
   CalculatorGraphConfig config;
   CalculatorGraphConfig::Node* node1 = config.add_node();
@@ -5603,5 +6291,35 @@ TEST(CalculatorGraph, SimpleMuxCalculatorWithCustomInputStreamHandler) {
           testing::HasSubstr("ImmediateInputStreamHandler class comment")));
 }
 
+// Measures the scheduler queue overhead of adding and running tasks, by
+// sending single packets through a chain of state.range(1) pass-through
+// calculators. The scheduler queue is sharded if state.range(0) is 1.
+void BM_PassThroughChain(benchmark::State& state) {
+  CalculatorGraphConfig config;
+  config.add_input_stream("in0");
+  for (int i = 0; i < state.range(1); ++i) {
+    CalculatorGraphConfig::Node* node = config.add_node();
+    node->set_calculator("PassThroughCalculator");
+    node->add_input_stream(absl::StrCat("in", i));
+    node->add_output_stream(absl::StrCat("in", i + 1));
+  }
+  if (state.range(0) == 1) {
+    config.set_scheduler_queue(CalculatorGraphConfig::SHARDED_QUEUE);
+  }
+  CalculatorGraph graph;
+  MEDIAPIPE_CHECK_OK(graph.Initialize(config));
+  MEDIAPIPE_CHECK_OK(graph.StartRun({}));
+  Packet packet = MakePacket<int>(1);
+  int64 timestamp = 0;
+  for (auto _ : state) {
+    MEDIAPIPE_CHECK_OK(graph.AddPacketToInputStream(
+        "in0", packet.At(Timestamp(timestamp++))));
+    MEDIAPIPE_CHECK_OK(graph.WaitUntilIdle());
+  }
+  MEDIAPIPE_CHECK_OK(graph.CloseAllInputStreams());
+  MEDIAPIPE_CHECK_OK(graph.WaitUntilDone());
+}
+BENCHMARK(BM_PassThroughChain)->ArgPair(0, 4)->ArgPair(1, 4);
+
 }  // namespace
 }  // namespace mediapipe
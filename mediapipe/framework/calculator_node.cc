@@ -14,6 +14,7 @@
 
 #include "mediapipe/framework/calculator_node.h"
 
+#include <algorithm>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -46,6 +47,7 @@
 #include "mediapipe/framework/tool/tag_map.h"
 #include "mediapipe/framework/tool/validate_name.h"
 #include "mediapipe/gpu/graph_support.h"
+#include "mediapipe/util/cpu_util.h"
 
 namespace mediapipe {
 
@@ -87,20 +89,37 @@ Timestamp CalculatorNode::SourceProcessOrder(
       validated_graph_->Config().node(node_id_);
   name_ = CanonicalNodeName(validated_graph_->Config(), node_id_);
 
-  max_in_flight_ = node_config.max_in_flight();
-  max_in_flight_ = max_in_flight_ ? max_in_flight_ : 1;
   if (!node_config.executor().empty()) {
     executor_ = node_config.executor();
   }
   source_layer_ = node_config.source_layer();
+  is_background_ = node_config.priority_class() ==
+                   CalculatorGraphConfig::Node::BACKGROUND;
+  concurrent_open_ = validated_graph_->Config().concurrent_open();
 
   const NodeTypeInfo& node_type_info =
       validated_graph_->CalculatorInfos()[node_id_];
 
+  // A stateless calculator with inputs runs one invocation per core, unless
+  // the node config sets its own limit.
+  max_in_flight_ = node_config.max_in_flight();
+  if (max_in_flight_ == 0 && node_type_info.Contract().IsStateless() &&
+      node_type_info.InputStreamTypes().NumEntries() > 0) {
+    max_in_flight_ = NumCPUCores();
+  }
+  max_in_flight_ = max_in_flight_ ? max_in_flight_ : 1;
+
   uses_gpu_ =
       node_type_info.InputSidePacketTypes().HasTag(kGpuSharedTagName) ||
       ContainsKey(node_type_info.Contract().ServiceRequests(), kGpuService.key);
 
+  // A node bound to a specific executor must run on that executor's threads,
+  // so it cannot run inline on an arbitrary upstream thread. A background
+  // node must wait in the scheduler queue behind the normal nodes.
+  run_inline_ =
+      (node_config.run_inline() || node_type_info.Contract().RunInline()) &&
+      executor_.empty() && !is_background_;
+
   // TODO Propagate types between calculators when SetAny is used.
 
   MP_RETURN_IF_ERROR(InitializeOutputSidePackets(
@@ -124,6 +143,9 @@ Timestamp CalculatorNode::SourceProcessOrder(
       calculator_state_.get(), node_type_info.InputStreamTypes().TagMap(),
       node_type_info.OutputStreamTypes().TagMap(),
       /*calculator_run_in_parallel=*/max_in_flight_ > 1);
+  if (max_in_flight_ > 1) {
+    calculator_context_manager_.SetContextPoolSize(max_in_flight_);
+  }
 
   // The graph specified InputStreamHandler takes priority.
   const bool graph_specified =
@@ -384,7 +406,7 @@ void CalculatorNode::SetMaxInputStreamQueueSize(int max_queue_size) {
     input_stream_headers_ready_called_ = false;
     input_side_packets_ready_called_ = false;
     input_stream_headers_ready_ =
-        (input_stream_handler_->UnsetHeaderCount() == 0);
+        concurrent_open_ || input_stream_handler_->UnsetHeaderCount() == 0;
     input_side_packets_ready_ =
         (input_side_packet_handler_.MissingInputSidePacketCount() == 0);
   }
@@ -561,6 +583,8 @@ void CalculatorNode::SchedulingLoop() {
     max_allowance = max_in_flight_ - current_in_flight_;
   }
   while (true) {
+    max_allowance =
+        std::min(max_allowance, output_stream_handler_->MaxNewInvocations());
     Timestamp input_bound;
     // input_bound is set to a meaningful value iff the latest readiness of the
     // node is kNotReady when ScheduleInvocations() returns.
@@ -591,6 +615,11 @@ bool CalculatorNode::ReadyForOpen() const {
 }
 
 void CalculatorNode::InputStreamHeadersReady() {
+  if (concurrent_open_) {
+    // The node does not wait for its input stream headers, and may already
+    // be open.
+    return;
+  }
   bool ready_for_open = false;
   {
     absl::MutexLock lock(&status_mutex_);
@@ -730,6 +759,8 @@ std::string CalculatorNode::DebugName() const {
       LegacyCalculatorSupport::Scoped<CalculatorContext> s(calculator_context);
       result = calculator_->Process(calculator_context);
     }
+    RET_CHECK(!calculator_context->completion_deferred_)
+        << "Source node " << DebugName() << " called DeferCompletion().";
 
     bool node_stopped = false;
     if (!result.ok()) {
@@ -753,6 +784,11 @@ std::string CalculatorNode::DebugName() const {
     // This is not a source Calculator.
     InputStreamShardSet* const inputs = &calculator_context->Inputs();
     OutputStreamShardSet* const outputs = &calculator_context->Outputs();
+    if (concurrent_open_) {
+      // Upstream nodes may have set their output stream headers after this
+      // node was opened. A stream's header is set before its first packet.
+      input_stream_handler_->UpdateInputShardHeaders(inputs);
+    }
     ::mediapipe::Status result =
         ::mediapipe::InternalError("Calculator context has no input packets.");
 
@@ -777,22 +813,19 @@ std::string CalculatorNode::DebugName() const {
           result = calculator_->Process(calculator_context);
         }
 
-        // Removes one packet from each shard and progresses to the next input
-        // timestamp.
-        input_stream_handler_->ClearCurrentInputs(calculator_context);
-
-        // Nodes are allowed to return StatusStop() to cause the termination
-        // of the graph. This is different from an error in that it will
-        // ensure that all sources will be closed and that packets in input
-        // streams will be processed before the graph is terminated.
-        if (!result.ok() && result != tool::StatusStop()) {
-          return ::mediapipe::StatusBuilder(result, MEDIAPIPE_LOC).SetPrepend()
-                 << absl::Substitute(
-                        "Calculator::Process() for node \"$0\" failed: ",
-                        DebugName());
+        if (calculator_context->completion_deferred_) {
+          // The scheduler calls FinishWhenCompleted() next, which reports
+          // this status if it is an error.
+          calculator_context->deferred_process_status_ =
+              num_invocations == 1
+                  ? result
+                  : ::mediapipe::UnimplementedError(
+                        "DeferCompletion() is not supported when batching "
+                        "input sets.");
+          return ::mediapipe::OkStatus();
         }
-        output_stream_handler_->PostProcess(input_timestamp);
-        if (result == tool::StatusStop()) {
+        result = FinishProcess(input_timestamp, result, calculator_context);
+        if (!result.ok()) {
           return result;
         }
       } else if (input_timestamp == Timestamp::Done()) {
@@ -814,6 +847,49 @@ std::string CalculatorNode::DebugName() const {
   }
 }
 
+::mediapipe::Status CalculatorNode::FinishProcess(
+    Timestamp input_timestamp, const ::mediapipe::Status& result,
+    CalculatorContext* calculator_context) {
+  // Removes one packet from each shard and progresses to the next input
+  // timestamp.
+  input_stream_handler_->ClearCurrentInputs(calculator_context);
+
+  // Nodes are allowed to return StatusStop() to cause the termination
+  // of the graph. This is different from an error in that it will
+  // ensure that all sources will be closed and that packets in input
+  // streams will be processed before the graph is terminated.
+  if (!result.ok() && result != tool::StatusStop()) {
+    return ::mediapipe::StatusBuilder(result, MEDIAPIPE_LOC).SetPrepend()
+           << absl::Substitute(
+                  "Calculator::Process() for node \"$0\" failed: ",
+                  DebugName());
+  }
+  output_stream_handler_->PostProcess(input_timestamp);
+  return result;
+}
+
+bool CalculatorNode::ProcessDeferred(
+    const CalculatorContext* calculator_context) const {
+  return !IsSource() && calculator_context->completion_deferred_;
+}
+
+void CalculatorNode::FinishWhenCompleted(
+    CalculatorContext* calculator_context,
+    std::function<void(const ::mediapipe::Status&)> finished) {
+  calculator_context->completion_handler_ = [this, calculator_context,
+                                             finished]() {
+    ::mediapipe::Status result =
+        calculator_context->deferred_process_status_.ok()
+            ? calculator_context->completion_status_
+            : calculator_context->deferred_process_status_;
+    calculator_context->completion_deferred_ = false;
+    // The context may be recycled from here on.
+    finished(FinishProcess(calculator_context->InputTimestamp(), result,
+                           calculator_context));
+  };
+  calculator_context->ReleaseDeferredCompletion();
+}
+
 void CalculatorNode::SetQueueSizeCallbacks(
     InputStreamManager::QueueSizeCallback becomes_full_callback,
     InputStreamManager::QueueSizeCallback becomes_not_full_callback) {
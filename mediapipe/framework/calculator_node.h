@@ -20,6 +20,7 @@
 
 #include <stddef.h>
 
+#include <atomic>
 #include <functional>
 #include <map>
 #include <memory>
@@ -97,6 +98,19 @@ class CalculatorNode {
   // Calls Process() on the Calculator corresponding to this node.
   ::mediapipe::Status ProcessNode(CalculatorContext* calculator_context);
 
+  // Returns true if the calculator deferred the completion of the Process()
+  // call ProcessNode() just returned from.  See
+  // CalculatorContext::DeferCompletion().
+  bool ProcessDeferred(const CalculatorContext* calculator_context) const;
+
+  // After ProcessNode() returns with ProcessDeferred() true, arranges for
+  // |finished| to be called, in place of the rest of ProcessNode(), with the
+  // status of the invocation once the calculator completes it.  |finished|
+  // may be called before this returns, or from another thread.
+  void FinishWhenCompleted(
+      CalculatorContext* calculator_context,
+      std::function<void(const ::mediapipe::Status&)> finished);
+
   // Initializes the node.  The buffer_size_hint argument is
   // set to the value specified in the graph proto for this field.
   // input_stream_managers/output_stream_managers is expected to point to
@@ -160,6 +174,23 @@ class CalculatorNode {
 
   int source_layer() const { return source_layer_; }
 
+  // Returns true if the node's priority_class is BACKGROUND. The scheduler
+  // runs a background node only when no other node is ready.
+  bool IsBackground() const { return is_background_; }
+
+  // The priority of the node among runnable non-source nodes; nodes with
+  // larger values run first.  Defaults to 0.  This method is thread-safe.
+  int64 SchedulingPriority() const {
+    return scheduling_priority_.load(std::memory_order_relaxed);
+  }
+  void SetSchedulingPriority(int64 priority) {
+    scheduling_priority_.store(priority, std::memory_order_relaxed);
+  }
+
+  // Returns true if Process() should be run synchronously by the thread that
+  // schedules the node, instead of going through the scheduler queue.
+  bool RunsInline() const { return run_inline_ && !IsSource(); }
+
   // Checks if the node can be scheduled; if so, increases current_in_flight_
   // and returns true; otherwise, returns false.
   // If true is returned, the scheduler must commit to executing the node, and
@@ -273,6 +304,13 @@ class CalculatorNode {
   // the latest input timestamp bound if no invocations can be scheduled.
   void SchedulingLoop();
 
+  // Clears the current input set of |calculator_context| after Process()
+  // returned |result| for |input_timestamp|, and propagates the outputs
+  // unless Process() failed.  Returns |result|, annotated on error.
+  ::mediapipe::Status FinishProcess(Timestamp input_timestamp,
+                                    const ::mediapipe::Status& result,
+                                    CalculatorContext* calculator_context);
+
   // Closes the input and output streams.
   void CloseInputStreams() LOCKS_EXCLUDED(status_mutex_);
   void CloseOutputStreams(OutputStreamShardSet* outputs)
@@ -292,6 +330,15 @@ class CalculatorNode {
   std::string executor_;
   // The layer a source calculator operates on.
   int source_layer_ = 0;
+  // True if the node's priority_class is BACKGROUND.
+  bool is_background_ = false;
+  // True if the node is opened without waiting for its input stream headers.
+  // See CalculatorGraphConfig::concurrent_open.
+  bool concurrent_open_ = false;
+  // True if the node is run inline. See RunsInline().
+  bool run_inline_ = false;
+  // See SchedulingPriority().
+  std::atomic<int64> scheduling_priority_{0};
   // The status of the current Calculator that this CalculatorNode
   // is wrapping.  kStateActive is currently used only for source nodes.
   enum NodeStatus {
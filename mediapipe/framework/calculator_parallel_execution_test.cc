@@ -22,6 +22,7 @@
 #include <memory>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <vector>
 
 #include "absl/memory/memory.h"
@@ -77,6 +78,91 @@ class SlowPlusOneCalculator : public CalculatorBase {
 
 REGISTER_CALCULATOR(SlowPlusOneCalculator);
 
+// Adds the header of the input stream to each input packet.
+class PlusHeaderCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    cc->SetOffset(mediapipe::TimestampDiff(0));
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    const InputStream& input = cc->Inputs().Index(0);
+    RET_CHECK(!input.Header().IsEmpty());
+    BusySleep(absl::Milliseconds(1));
+    cc->Outputs().Index(0).Add(
+        new int(input.Get<int>() + input.Header().Get<int>()),
+        cc->InputTimestamp());
+    return ::mediapipe::OkStatus();
+  }
+};
+
+REGISTER_CALCULATOR(PlusHeaderCalculator);
+
+// Adds one to each input on a separate thread, deferring the completion of
+// Process() until then.  Each operation first waits until kNumStarted
+// operations have started, which requires Process() to release the executor
+// thread, and the operations then complete out of order.  Negative inputs
+// fail.
+class AsyncPlusOneCalculator : public CalculatorBase {
+ public:
+  static constexpr int kNumStarted = 4;
+
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    return ::mediapipe::OkStatus();
+  }
+
+  ~AsyncPlusOneCalculator() override {
+    for (std::thread& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    cc->SetOffset(mediapipe::TimestampDiff(0));
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    CalculatorContext::ProcessCompletion done = cc->DeferCompletion();
+    const int value = cc->Inputs().Index(0).Get<int>();
+    absl::MutexLock lock(&mutex_);
+    ++num_started_;
+    threads_.emplace_back([this, cc, done, value]() {
+      {
+        absl::MutexLock lock(&mutex_);
+        mutex_.Await(absl::Condition(
+            +[](int* num_started) { return *num_started >= kNumStarted; },
+            &num_started_));
+      }
+      if (value < 0) {
+        done(::mediapipe::InvalidArgumentError("Negative input."));
+        return;
+      }
+      absl::SleepFor(absl::Milliseconds(5 * (3 - value % 4)));
+      cc->Outputs().Index(0).Add(new int(value + 1), cc->InputTimestamp());
+      done(::mediapipe::OkStatus());
+    });
+    return ::mediapipe::OkStatus();
+  }
+
+ private:
+  absl::Mutex mutex_;
+  int num_started_ GUARDED_BY(mutex_) = 0;
+  std::vector<std::thread> threads_ GUARDED_BY(mutex_);
+};
+constexpr int AsyncPlusOneCalculator::kNumStarted;
+
+REGISTER_CALCULATOR(AsyncPlusOneCalculator);
+
 class ParallelExecutionTest : public testing::Test {
  public:
   void AddThreadSafeVectorSink(const Packet& packet) {
@@ -153,5 +239,114 @@ TEST_F(ParallelExecutionTest, SlowPlusOneCalculatorsTest) {
   }
 }
 
+// The calculator contexts kept across runs see the headers of each run.
+TEST_F(ParallelExecutionTest, ReusedContextsSeeInputStreamHeaders) {
+  CalculatorGraphConfig graph_config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "input"
+        node {
+          calculator: "PlusHeaderCalculator"
+          input_stream: "input"
+          output_stream: "output"
+          max_in_flight: 4
+        }
+        node {
+          calculator: "CallbackCalculator"
+          input_stream: "output"
+          input_side_packet: "CALLBACK:callback"
+        }
+        num_threads: 4
+      )");
+
+  CalculatorGraph graph(graph_config);
+  for (int header = 1; header <= 2; ++header) {
+    MP_ASSERT_OK(graph.StartRun(
+        {{"callback", MakePacket<std::function<void(const Packet&)>>(std::bind(
+                          &ParallelExecutionTest::AddThreadSafeVectorSink, this,
+                          std::placeholders::_1))}},
+        {{"input", MakePacket<int>(header * 100)}}));
+    const int kTotalNums = 20;
+    for (int i = 0; i < kTotalNums; ++i) {
+      MP_ASSERT_OK(graph.AddPacketToInputStream(
+          "input", MakePacket<int>(i).At(Timestamp(i))));
+    }
+    MP_ASSERT_OK(graph.CloseInputStream("input"));
+    MP_ASSERT_OK(graph.WaitUntilDone());
+
+    absl::ReaderMutexLock lock(&output_packets_mutex_);
+    ASSERT_EQ(kTotalNums, output_packets_.size());
+    for (int i = 0; i < kTotalNums; ++i) {
+      EXPECT_EQ(header * 100 + i, output_packets_[i].Get<int>());
+    }
+    output_packets_.clear();
+  }
+}
+
+// Deferred Process() calls release the single executor thread, and their
+// outputs are still emitted in timestamp order.
+TEST_F(ParallelExecutionTest, DeferredCompletionReleasesExecutorThread) {
+  CalculatorGraphConfig graph_config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "input"
+        node {
+          calculator: "AsyncPlusOneCalculator"
+          input_stream: "input"
+          output_stream: "output"
+          max_in_flight: 4
+        }
+        node {
+          calculator: "CallbackCalculator"
+          input_stream: "output"
+          input_side_packet: "CALLBACK:callback"
+        }
+        num_threads: 1
+      )");
+
+  CalculatorGraph graph(graph_config);
+  MP_ASSERT_OK(graph.StartRun(
+      {{"callback", MakePacket<std::function<void(const Packet&)>>(std::bind(
+                        &ParallelExecutionTest::AddThreadSafeVectorSink, this,
+                        std::placeholders::_1))}}));
+  const int kTotalNums = 20;
+  for (int i = 0; i < kTotalNums; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "input", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.CloseInputStream("input"));
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  absl::ReaderMutexLock lock(&output_packets_mutex_);
+  ASSERT_EQ(kTotalNums, output_packets_.size());
+  for (int i = 0; i < kTotalNums; ++i) {
+    EXPECT_EQ(i + 1, output_packets_[i].Get<int>());
+    EXPECT_EQ(Timestamp(i), output_packets_[i].Timestamp());
+  }
+}
+
+TEST_F(ParallelExecutionTest, DeferredCompletionReportsErrors) {
+  CalculatorGraphConfig graph_config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "input"
+        node {
+          calculator: "AsyncPlusOneCalculator"
+          input_stream: "input"
+          output_stream: "output"
+          max_in_flight: 4
+        }
+        num_threads: 1
+      )");
+
+  CalculatorGraph graph(graph_config);
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < AsyncPlusOneCalculator::kNumStarted; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "input", MakePacket<int>(i == 0 ? -1 : i).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.CloseInputStream("input"));
+  ::mediapipe::Status status = graph.WaitUntilDone();
+  EXPECT_EQ(status.code(), ::mediapipe::StatusCode::kInvalidArgument);
+  EXPECT_THAT(status.message(), testing::HasSubstr("Negative input."));
+}
+
 }  // namespace
 }  // namespace mediapipe
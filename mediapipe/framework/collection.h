@@ -26,6 +26,7 @@
 #include "absl/base/macros.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "mediapipe/framework/collection_item_id.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/tool/tag_map.h"
@@ -123,23 +124,29 @@ class Collection {
   Collection(const std::initializer_list<std::string>& tag_names);
 
   // Access the data at a given CollectionItemId.  This is the most efficient
-  // way to access data within the collection.
+  // way to access data within the collection.  The ids of a calculator's
+  // collections do not change while the graph runs, so a calculator that
+  // accesses a tag on every packet can resolve its id once in Open() and use
+  // it in Process():
+  //   image_id_ = cc->Inputs().GetId("IMAGE", 0);
+  //   ...
+  //   const auto& image = cc->Inputs().Get(image_id_).Get<ImageFrame>();
   //
   // Do not assume that Index(2) == Get(collection.TagMap()->BeginId() + 2).
   value_type& Get(CollectionItemId id);
   const value_type& Get(CollectionItemId id) const;
 
   // Convenience functions.
-  value_type& Get(const std::string& tag, int index);
-  const value_type& Get(const std::string& tag, int index) const;
+  value_type& Get(absl::string_view tag, int index);
+  const value_type& Get(absl::string_view tag, int index) const;
 
   // Equivalent to Get("", index);
   value_type& Index(int index);
   const value_type& Index(int index) const;
 
   // Equivalent to Get(tag, 0);
-  value_type& Tag(const std::string& tag);
-  const value_type& Tag(const std::string& tag) const;
+  value_type& Tag(absl::string_view tag);
+  const value_type& Tag(absl::string_view tag) const;
 
   // These functions only exist for collections with storage ==
   // kStorePointer.  GetPtr returns the stored ptr value rather than
@@ -178,13 +185,13 @@ class Collection {
   ////////////////////////////////////////
 
   // Returns true if the provided tag is available (not necessarily set yet).
-  bool HasTag(const std::string& tag) const { return tag_map_->HasTag(tag); }
+  bool HasTag(absl::string_view tag) const { return tag_map_->HasTag(tag); }
 
   // Returns the number of entries in this collection.
   int NumEntries() const { return tag_map_->NumEntries(); }
 
   // Returns the number of entries with the provided tag.
-  int NumEntries(const std::string& tag) const {
+  int NumEntries(absl::string_view tag) const {
     return tag_map_->NumEntries(tag);
   }
 
@@ -199,7 +206,7 @@ class Collection {
   // However, be careful in using this fact, as it circumvents the
   // validity checks in GetId() (i.e. ++GetId("BLAH", 2) looks like it
   // is valid, while GetId("BLAH", 3) is not valid).
-  CollectionItemId GetId(const std::string& tag, int index) const {
+  CollectionItemId GetId(absl::string_view tag, int index) const {
     return tag_map_->GetId(tag, index);
   }
 
@@ -233,10 +240,10 @@ class Collection {
   //   for (CollectionItemId id = collection.BeginId(tag);
   //        id < collection.EndId(tag); ++id) {
   //   }
-  CollectionItemId BeginId(const std::string& tag) const {
+  CollectionItemId BeginId(absl::string_view tag) const {
     return tag_map_->BeginId(tag);
   }
-  CollectionItemId EndId(const std::string& tag) const {
+  CollectionItemId EndId(absl::string_view tag) const {
     return tag_map_->EndId(tag);
   }
 
@@ -454,21 +461,21 @@ Collection<T, storage, ErrorHandler>::GetPtr(CollectionItemId id) const {
 
 template <typename T, CollectionStorage storage, typename ErrorHandler>
 typename Collection<T, storage, ErrorHandler>::value_type&
-Collection<T, storage, ErrorHandler>::Get(const std::string& tag, int index) {
+Collection<T, storage, ErrorHandler>::Get(absl::string_view tag, int index) {
   CollectionItemId id = GetId(tag, index);
   if (!id.IsValid()) {
-    return error_handler_.GetFallback(tag, index);
+    return error_handler_.GetFallback(std::string(tag), index);
   }
   return begin()[id.value()];
 }
 
 template <typename T, CollectionStorage storage, typename ErrorHandler>
 const typename Collection<T, storage, ErrorHandler>::value_type&
-Collection<T, storage, ErrorHandler>::Get(const std::string& tag,
+Collection<T, storage, ErrorHandler>::Get(absl::string_view tag,
                                           int index) const {
   CollectionItemId id = GetId(tag, index);
   if (!id.IsValid()) {
-    return error_handler_.GetFallback(tag, index);
+    return error_handler_.GetFallback(std::string(tag), index);
   }
   return begin()[id.value()];
 }
@@ -487,13 +494,13 @@ Collection<T, storage, ErrorHandler>::Index(int index) const {
 
 template <typename T, CollectionStorage storage, typename ErrorHandler>
 typename Collection<T, storage, ErrorHandler>::value_type&
-Collection<T, storage, ErrorHandler>::Tag(const std::string& tag) {
+Collection<T, storage, ErrorHandler>::Tag(absl::string_view tag) {
   return Get(tag, 0);
 }
 
 template <typename T, CollectionStorage storage, typename ErrorHandler>
 const typename Collection<T, storage, ErrorHandler>::value_type&
-Collection<T, storage, ErrorHandler>::Tag(const std::string& tag) const {
+Collection<T, storage, ErrorHandler>::Tag(absl::string_view tag) const {
   return Get(tag, 0);
 }
 
@@ -540,21 +547,21 @@ Collection<T, storage, ErrorHandler>::end() const {
 // Returns c.HasTag(tag) && !Tag(tag)->IsEmpty() (just for convenience).
 // This version is used with Calculator.
 template <class S>
-bool HasTagValue(const internal::Collection<S*>& c, const std::string& tag) {
+bool HasTagValue(const internal::Collection<S*>& c, absl::string_view tag) {
   return c.HasTag(tag) && !c.Tag(tag)->IsEmpty();
 }
 
 // Returns c.HasTag(tag) && !Tag(tag).IsEmpty() (just for convenience).
 // This version is used with CalculatorBase.
 template <class S>
-bool HasTagValue(const internal::Collection<S>& c, const std::string& tag) {
+bool HasTagValue(const internal::Collection<S>& c, absl::string_view tag) {
   return c.HasTag(tag) && !c.Tag(tag).IsEmpty();
 }
 
 // Returns c.HasTag(tag) && !Tag(tag).IsEmpty() (just for convenience).
 // This version is used with Calculator or CalculatorBase.
 template <class C>
-bool HasTagValue(const C& c, const std::string& tag) {
+bool HasTagValue(const C& c, absl::string_view tag) {
   return HasTagValue(c->Inputs(), tag);
 }
 
@@ -15,6 +15,7 @@
 #include "mediapipe/framework/collection.h"
 
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "mediapipe/framework/packet_set.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
@@ -160,6 +161,30 @@ TEST(CollectionTest, MixedTagAndIndexUsage) {
   EXPECT_EQ("5 TAG_C 0", collection3.Get("TAG_C", 0));
 }
 
+TEST(CollectionTest, LookupByStringView) {
+  auto tags_statusor =
+      tool::CreateTagMap({"TAG_A:a", "TAG_B:0:b", "TAG_B:1:c"});
+  MP_ASSERT_OK(tags_statusor);
+
+  internal::Collection<int> collection(std::move(tags_statusor.ValueOrDie()));
+  const std::string tags = "TAG_ATAG_BTAG_C";
+  const absl::string_view tag_a = absl::string_view(tags).substr(0, 5);
+  const absl::string_view tag_b = absl::string_view(tags).substr(5, 5);
+  const absl::string_view tag_c = absl::string_view(tags).substr(10, 5);
+  collection.Tag(tag_a) = 100;
+  collection.Get(tag_b, 1) = 102;
+  EXPECT_TRUE(collection.HasTag(tag_a));
+  EXPECT_FALSE(collection.HasTag(tag_c));
+  EXPECT_EQ(2, collection.NumEntries(tag_b));
+  EXPECT_EQ(0, collection.NumEntries(tag_c));
+  EXPECT_EQ(collection.GetId("TAG_B", 1), collection.GetId(tag_b, 1));
+  EXPECT_FALSE(collection.GetId(tag_c, 0).IsValid());
+  EXPECT_EQ(collection.BeginId("TAG_B"), collection.BeginId(tag_b));
+  EXPECT_EQ(collection.EndId("TAG_B"), collection.EndId(tag_b));
+  EXPECT_EQ(100, collection.Get(collection.GetId("TAG_A", 0)));
+  EXPECT_EQ(102, collection.Get(collection.GetId("TAG_B", 1)));
+}
+
 TEST(CollectionTest, StaticEmptyCollectionHeapCheck) {
   // Ensure that static collections play nicely with the heap checker.
   // "new T[0]" returns a non-null pointer which the heap checker has
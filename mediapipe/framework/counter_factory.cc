@@ -14,6 +14,7 @@
 
 #include "mediapipe/framework/counter_factory.h"
 
+#include <atomic>
 #include <vector>
 
 #include "absl/strings/string_view.h"
@@ -49,6 +50,56 @@ class BasicCounter : public Counter {
   int64 value_ GUARDED_BY(mu_);
 };
 
+// Counter implementation for ShardedCounterFactory.
+// This class is thread safe.
+class ShardedCounter : public Counter {
+ public:
+  explicit ShardedCounter(const std::string& name) {
+    for (Shard& shard : shards_) {
+      shard.value.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  void Increment() override { IncrementBy(1); }
+
+  void IncrementBy(int amount) override {
+    shards_[ThreadShardIndex()].value.fetch_add(amount,
+                                                std::memory_order_relaxed);
+  }
+
+  int64 Get() override {
+    int64 value = 0;
+    for (const Shard& shard : shards_) {
+      value += shard.value.load(std::memory_order_relaxed);
+    }
+    return value;
+  }
+
+ private:
+  static constexpr int kNumShards = 16;
+  static constexpr int kCacheLineSize = 64;
+
+  // Padded so that the values of different shards never share a cache line.
+  struct Shard {
+    std::atomic<int64> value;
+    char padding[kCacheLineSize - sizeof(std::atomic<int64>)];
+  };
+
+  // Assigns shards to threads round-robin, so that up to kNumShards threads
+  // never share one.
+  static int ThreadShardIndex() {
+    static std::atomic<int> next_index(0);
+    static thread_local const int index =
+        next_index.fetch_add(1, std::memory_order_relaxed) % kNumShards;
+    return index;
+  }
+
+  Shard shards_[kNumShards];
+};
+
+constexpr int ShardedCounter::kNumShards;
+constexpr int ShardedCounter::kCacheLineSize;
+
 }  // namespace
 
 CounterSet::CounterSet() {}
@@ -87,4 +138,8 @@ Counter* BasicCounterFactory::GetCounter(const std::string& name) {
   return counter_set_.Emplace<BasicCounter>(name, name);
 }
 
+Counter* ShardedCounterFactory::GetCounter(const std::string& name) {
+  return counter_set_.Emplace<ShardedCounter>(name, name);
+}
+
 }  // namespace mediapipe
@@ -0,0 +1,56 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/counter_factory.h"
+
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(CounterFactoryTest, ReturnsTheSameCounterForAName) {
+  ShardedCounterFactory factory;
+  Counter* counter = factory.GetCounter("Frames");
+  EXPECT_EQ(counter, factory.GetCounter("Frames"));
+  EXPECT_NE(counter, factory.GetCounter("Drops"));
+  EXPECT_EQ(counter, factory.GetCounterSet()->Get("Frames"));
+}
+
+TEST(CounterFactoryTest, ShardedCounterSumsIncrementsFromAllThreads) {
+  constexpr int kNumThreads = 20;
+  constexpr int kNumIncrements = 1000;
+  ShardedCounterFactory factory;
+  Counter* counter = factory.GetCounter("Frames");
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([counter]() {
+      for (int j = 0; j < kNumIncrements; ++j) {
+        counter->Increment();
+      }
+      counter->IncrementBy(kNumIncrements);
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(2 * kNumThreads * kNumIncrements, counter->Get());
+  EXPECT_EQ(2 * kNumThreads * kNumIncrements,
+            factory.GetCounterSet()->GetCountersValues()["Frames"]);
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,132 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/critical_path_estimator.h"
+
+#include <algorithm>
+#include <queue>
+#include <unordered_map>
+
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/ret_check.h"
+
+namespace mediapipe {
+
+::mediapipe::Status CriticalPathEstimator::Initialize(
+    const ValidatedGraphConfig& validated_graph) {
+  using NodeType = NodeTypeInfo::NodeType;
+  const int num_nodes = validated_graph.CalculatorInfos().size();
+  node_names_.clear();
+  for (int node_id = 0; node_id < num_nodes; ++node_id) {
+    node_names_.push_back(
+        CanonicalNodeName(validated_graph.Config(), node_id));
+  }
+  downstream_nodes_.assign(num_nodes, {});
+  upstream_nodes_.assign(num_nodes, {});
+  for (const EdgeInfo& input : validated_graph.InputStreamInfos()) {
+    if (input.back_edge || input.upstream < 0 ||
+        input.parent_node.type != NodeType::CALCULATOR) {
+      continue;
+    }
+    const EdgeInfo& output =
+        validated_graph.OutputStreamInfos()[input.upstream];
+    if (output.parent_node.type != NodeType::CALCULATOR) {
+      continue;
+    }
+    downstream_nodes_[output.parent_node.index].push_back(
+        input.parent_node.index);
+    upstream_nodes_[input.parent_node.index].push_back(
+        output.parent_node.index);
+  }
+
+  // Kahn's algorithm.
+  std::vector<int> num_pending_upstream(num_nodes);
+  std::queue<int> ready;
+  for (int node_id = 0; node_id < num_nodes; ++node_id) {
+    num_pending_upstream[node_id] = upstream_nodes_[node_id].size();
+    if (num_pending_upstream[node_id] == 0) {
+      ready.push(node_id);
+    }
+  }
+  topological_order_.clear();
+  while (!ready.empty()) {
+    int node_id = ready.front();
+    ready.pop();
+    topological_order_.push_back(node_id);
+    for (int downstream : downstream_nodes_[node_id]) {
+      if (--num_pending_upstream[downstream] == 0) {
+        ready.push(downstream);
+      }
+    }
+  }
+  RET_CHECK_EQ(num_nodes, topological_order_.size())
+      << "The graph has a cycle that is not marked as a back edge.";
+  return ::mediapipe::OkStatus();
+}
+
+std::vector<int64> CriticalPathEstimator::EstimatePathCosts(
+    const std::vector<int64>& node_costs) const {
+  const int num_nodes = topological_order_.size();
+  CHECK_EQ(num_nodes, node_costs.size());
+  // The cost of the longest path ending at, and starting from, each node.
+  std::vector<int64> cost_to_node(num_nodes, 0);
+  std::vector<int64> cost_from_node(num_nodes, 0);
+  for (int node_id : topological_order_) {
+    int64 upstream_cost = 0;
+    for (int upstream : upstream_nodes_[node_id]) {
+      upstream_cost = std::max(upstream_cost, cost_to_node[upstream]);
+    }
+    cost_to_node[node_id] = upstream_cost + node_costs[node_id];
+  }
+  for (auto it = topological_order_.rbegin(); it != topological_order_.rend();
+       ++it) {
+    int64 downstream_cost = 0;
+    for (int downstream : downstream_nodes_[*it]) {
+      downstream_cost = std::max(downstream_cost, cost_from_node[downstream]);
+    }
+    cost_from_node[*it] = downstream_cost + node_costs[*it];
+  }
+  std::vector<int64> path_costs(num_nodes);
+  for (int node_id = 0; node_id < num_nodes; ++node_id) {
+    path_costs[node_id] = cost_to_node[node_id] + cost_from_node[node_id] -
+                          node_costs[node_id];
+  }
+  return path_costs;
+}
+
+std::vector<int64> CriticalPathEstimator::EstimatePathCosts(
+    const std::vector<CalculatorProfile>& profiles) const {
+  std::unordered_map<std::string, const CalculatorProfile*> profiles_by_name;
+  for (const CalculatorProfile& profile : profiles) {
+    profiles_by_name[profile.name()] = &profile;
+  }
+  std::vector<int64> node_costs(node_names_.size(), 1);
+  for (int node_id = 0; node_id < node_names_.size(); ++node_id) {
+    auto it = profiles_by_name.find(node_names_[node_id]);
+    if (it == profiles_by_name.end()) {
+      continue;
+    }
+    const TimeHistogram& runtime = it->second->process_runtime();
+    int64 num_calls = 0;
+    for (int64 count : runtime.count()) {
+      num_calls += count;
+    }
+    if (num_calls > 0) {
+      node_costs[node_id] = std::max<int64>(1, runtime.total() / num_calls);
+    }
+  }
+  return EstimatePathCosts(node_costs);
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,61 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_CRITICAL_PATH_ESTIMATOR_H_
+#define MEDIAPIPE_FRAMEWORK_CRITICAL_PATH_ESTIMATOR_H_
+
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/validated_graph_config.h"
+
+namespace mediapipe {
+
+// Estimates, for every calculator node of a graph, the cost of the longest
+// path from the graph inputs through the node to the graph outputs.  Used by
+// the CRITICAL_PATH scheduling policy: nodes whose path cost is the largest
+// bound the latency of the graph and are run first.  Back edges are ignored.
+class CriticalPathEstimator {
+ public:
+  // Records the topology of "validated_graph".
+  ::mediapipe::Status Initialize(const ValidatedGraphConfig& validated_graph);
+
+  // Returns the path cost of every calculator node, indexed by node id, given
+  // the cost of running each node once.
+  std::vector<int64> EstimatePathCosts(
+      const std::vector<int64>& node_costs) const;
+
+  // Same as above, using the mean Process() runtime in "profiles", in
+  // microseconds, as the cost of each node.  Profiles are matched to nodes by
+  // name.  A node without any recorded Process() call costs one microsecond.
+  std::vector<int64> EstimatePathCosts(
+      const std::vector<CalculatorProfile>& profiles) const;
+
+ private:
+  // The canonical name of each node, as used by the profiler.
+  std::vector<std::string> node_names_;
+  // The nodes fed by each node's output streams.
+  std::vector<std::vector<int>> downstream_nodes_;
+  // The nodes feeding each node's input streams.
+  std::vector<std::vector<int>> upstream_nodes_;
+  // All node ids, upstream nodes first.
+  std::vector<int> topological_order_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_CRITICAL_PATH_ESTIMATOR_H_
@@ -0,0 +1,120 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/critical_path_estimator.h"
+
+#include <vector>
+
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/validated_graph_config.h"
+
+namespace mediapipe {
+namespace {
+
+// Node 0 feeds the chain 1 -> 2, and node 3 is a side branch of node 0.
+CalculatorGraphConfig ForkConfig() {
+  return ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+    input_stream: "in"
+    node {
+      name: "head"
+      calculator: "PassThroughCalculator"
+      input_stream: "in"
+      output_stream: "a"
+    }
+    node {
+      name: "chain_1"
+      calculator: "PassThroughCalculator"
+      input_stream: "a"
+      output_stream: "b"
+    }
+    node {
+      name: "chain_2"
+      calculator: "PassThroughCalculator"
+      input_stream: "b"
+      output_stream: "c"
+    }
+    node {
+      name: "branch"
+      calculator: "PassThroughCalculator"
+      input_stream: "a"
+      output_stream: "d"
+    }
+  )");
+}
+
+TEST(CriticalPathEstimatorTest, EstimatesPathCosts) {
+  ValidatedGraphConfig validated_graph;
+  MP_ASSERT_OK(validated_graph.Initialize(ForkConfig()));
+  CriticalPathEstimator estimator;
+  MP_ASSERT_OK(estimator.Initialize(validated_graph));
+
+  // Every node on the longest path gets the cost of the whole path.
+  EXPECT_EQ(std::vector<int64>({21, 21, 21, 6}),
+            estimator.EstimatePathCosts(std::vector<int64>({1, 10, 10, 5})));
+  // With equal costs the path length is counted in nodes.
+  EXPECT_EQ(std::vector<int64>({3, 3, 3, 2}),
+            estimator.EstimatePathCosts(std::vector<int64>({1, 1, 1, 1})));
+}
+
+TEST(CriticalPathEstimatorTest, UsesMeanProcessRuntimes) {
+  ValidatedGraphConfig validated_graph;
+  MP_ASSERT_OK(validated_graph.Initialize(ForkConfig()));
+  CriticalPathEstimator estimator;
+  MP_ASSERT_OK(estimator.Initialize(validated_graph));
+
+  std::vector<CalculatorProfile> profiles(2);
+  profiles[0].set_name("branch");
+  profiles[0].mutable_process_runtime()->set_total(300);
+  profiles[0].mutable_process_runtime()->add_count(2);
+  profiles[0].mutable_process_runtime()->add_count(1);
+  // A node that has not run yet costs one microsecond.
+  profiles[1].set_name("chain_1");
+  profiles[1].mutable_process_runtime()->add_count(0);
+  // Cost of "branch" is 300 / 3 = 100, and the others cost 1.
+  EXPECT_EQ(std::vector<int64>({101, 3, 3, 101}),
+            estimator.EstimatePathCosts(profiles));
+}
+
+TEST(CriticalPathEstimatorTest, IgnoresBackEdges) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "in"
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "in"
+          input_stream: "loop"
+          input_stream_info: { tag_index: ":1" back_edge: true }
+          output_stream: "out"
+          output_stream: "unused"
+        }
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "out"
+          output_stream: "loop"
+        }
+      )");
+  ValidatedGraphConfig validated_graph;
+  MP_ASSERT_OK(validated_graph.Initialize(config));
+  CriticalPathEstimator estimator;
+  MP_ASSERT_OK(estimator.Initialize(validated_graph));
+  EXPECT_EQ(std::vector<int64>({7, 7}),
+            estimator.EstimatePathCosts(std::vector<int64>({3, 4})));
+}
+
+}  // namespace
+}  // namespace mediapipe
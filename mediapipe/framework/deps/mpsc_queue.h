@@ -0,0 +1,90 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// MpscQueue is an unbounded lock-free queue for many producers and a single
+// consumer. Push() is wait-free: it takes one atomic exchange and never
+// blocks on other producers or on the consumer. Pop() must only be called
+// from the consumer thread.
+//
+// The queue does not block: a consumer that needs to sleep while the queue is
+// empty must pair it with its own wakeup mechanism, e.g. a flag checked by the
+// producers after Push() (see GlContext::DedicatedThread).
+//
+// Based on Dmitry Vyukov's non-intrusive MPSC node-based queue.
+
+#ifndef MEDIAPIPE_DEPS_MPSC_QUEUE_H_
+#define MEDIAPIPE_DEPS_MPSC_QUEUE_H_
+
+#include <atomic>
+#include <utility>
+
+namespace mediapipe {
+
+template <typename T>
+class MpscQueue {
+ public:
+  MpscQueue() : head_(new Node()), tail_(head_.load()) {}
+  ~MpscQueue() {
+    T value;
+    while (Pop(&value)) {
+    }
+    delete tail_;
+  }
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  // Adds a value. Can be called from any thread.
+  void Push(T value) {
+    Node* node = new Node(std::move(value));
+    // Between the exchange and the store, the queue is not empty but the
+    // consumer cannot pop the new node yet.
+    Node* prev = head_.exchange(node);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  // Removes the oldest value into *value and returns true, or returns false
+  // if no value can be popped yet. Consumer thread only.
+  bool Pop(T* value) {
+    Node* tail = tail_;
+    Node* next = tail->next.load(std::memory_order_acquire);
+    if (next == nullptr) return false;
+    *value = std::move(next->value);
+    // next becomes the new stub node.
+    tail_ = next;
+    delete tail;
+    return true;
+  }
+
+  // Returns true if no Push() has started since the last value was popped.
+  // A false result with a failing Pop() means a Push() is in progress.
+  // Consumer thread only.
+  bool Empty() const { return head_.load() == tail_; }
+
+ private:
+  struct Node {
+    Node() = default;
+    explicit Node(T v) : value(std::move(v)) {}
+    std::atomic<Node*> next{nullptr};
+    T value;
+  };
+
+  // The most recently pushed node, updated by producers.
+  std::atomic<Node*> head_;
+  // The stub node preceding the oldest value, owned by the consumer.
+  Node* tail_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_DEPS_MPSC_QUEUE_H_
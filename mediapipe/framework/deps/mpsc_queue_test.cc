@@ -0,0 +1,80 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/deps/mpsc_queue.h"
+
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(MpscQueueTest, PopsInOrder) {
+  MpscQueue<int> queue;
+  int value = 0;
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_FALSE(queue.Pop(&value));
+  for (int i = 0; i < 5; ++i) queue.Push(i);
+  EXPECT_FALSE(queue.Empty());
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_TRUE(queue.Pop(&value));
+    EXPECT_EQ(i, value);
+  }
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_FALSE(queue.Pop(&value));
+}
+
+TEST(MpscQueueTest, DestroysRemainingValues) {
+  auto counted = std::make_shared<int>(0);
+  {
+    MpscQueue<std::shared_ptr<int>> queue;
+    queue.Push(counted);
+    queue.Push(counted);
+    EXPECT_EQ(3, counted.use_count());
+  }
+  EXPECT_EQ(1, counted.use_count());
+}
+
+TEST(MpscQueueTest, ManyProducers) {
+  constexpr int kNumProducers = 4;
+  constexpr int kValuesPerProducer = 10000;
+  MpscQueue<int> queue;
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kNumProducers; ++p) {
+    producers.emplace_back([&queue, p] {
+      for (int i = 0; i < kValuesPerProducer; ++i) {
+        queue.Push(p * kValuesPerProducer + i);
+      }
+    });
+  }
+  // Values of each producer must come out in the order they were pushed.
+  std::vector<int> last(kNumProducers, -1);
+  int num_popped = 0;
+  while (num_popped < kNumProducers * kValuesPerProducer) {
+    int value;
+    if (!queue.Pop(&value)) continue;
+    const int producer = value / kValuesPerProducer;
+    EXPECT_LT(last[producer], value % kValuesPerProducer);
+    last[producer] = value % kValuesPerProducer;
+    ++num_popped;
+  }
+  for (auto& producer : producers) producer.join();
+  EXPECT_TRUE(queue.Empty());
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -26,7 +26,8 @@ namespace mediapipe {
 // the field descriptions.
 class ThreadOptions {
  public:
-  ThreadOptions() : stack_size_(0), nice_priority_level_(0) {}
+  ThreadOptions()
+      : stack_size_(0), nice_priority_level_(0), realtime_priority_(0) {}
 
   // Set the thread stack size (in bytes).  Passing stack_size==0 resets
   // the stack size to the default value for the system. The system default
@@ -41,6 +42,13 @@ class ThreadOptions {
     return *this;
   }
 
+  // Set the SCHED_FIFO priority of the thread.  Passing 0 keeps the default
+  // time-sharing scheduling policy, which is also the default for this class.
+  ThreadOptions& set_realtime_priority(int realtime_priority) {
+    realtime_priority_ = realtime_priority;
+    return *this;
+  }
+
   ThreadOptions& set_cpu_set(const std::set<int>& cpu_set) {
     cpu_set_ = cpu_set;
     return *this;
@@ -55,6 +63,8 @@ class ThreadOptions {
 
   int nice_priority_level() const { return nice_priority_level_; }
 
+  int realtime_priority() const { return realtime_priority_; }
+
   const std::set<int>& cpu_set() const { return cpu_set_; }
 
   std::string name_prefix() const { return name_prefix_; }
@@ -62,6 +72,7 @@ class ThreadOptions {
  private:
   size_t stack_size_;        // Size of thread stack
   int nice_priority_level_;  // Nice priority level of the workers
+  int realtime_priority_;    // SCHED_FIFO priority of the workers, or 0
   std::set<int> cpu_set_;    // CPU set for affinity setting
   std::string name_prefix_;  // Name of the thread
 };
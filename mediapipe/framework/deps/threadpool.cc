@@ -20,16 +20,31 @@
 #include <sys/syscall.h>
 #include <unistd.h>
 
+#if defined(__EMSCRIPTEN__)
+#include <emscripten/threading.h>
+#endif  // __EMSCRIPTEN__
+
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "mediapipe/framework/port/logging.h"
 
 namespace mediapipe {
 
+namespace {
+
+// The thread pool and worker index of the current thread, if it is a worker
+// thread of a ThreadPool in work stealing mode.
+thread_local const void* current_thread_pool = nullptr;
+thread_local int current_worker_index = -1;
+
+}  // namespace
+
 class ThreadPool::WorkerThread {
  public:
-  // Creates and starts a thread that runs pool->RunWorker().
-  WorkerThread(ThreadPool* pool, const std::string& name_prefix);
+  // Creates and starts a thread that runs pool->RunWorker(worker_index).
+  WorkerThread(ThreadPool* pool, const std::string& name_prefix,
+               int worker_index);
 
   // REQUIRES: Join() must have been called.
   ~WorkerThread();
@@ -42,12 +57,14 @@ class ThreadPool::WorkerThread {
 
   ThreadPool* pool_;
   std::string name_prefix_;
+  int worker_index_;
   pthread_t thread_;
 };
 
 ThreadPool::WorkerThread::WorkerThread(ThreadPool* pool,
-                                       const std::string& name_prefix)
-    : pool_(pool), name_prefix_(name_prefix) {
+                                       const std::string& name_prefix,
+                                       int worker_index)
+    : pool_(pool), name_prefix_(name_prefix), worker_index_(worker_index) {
   pthread_create(&thread_, nullptr, ThreadBody, this);
 }
 
@@ -59,9 +76,16 @@ void* ThreadPool::WorkerThread::ThreadBody(void* arg) {
   auto thread = reinterpret_cast<WorkerThread*>(arg);
   int nice_priority_level =
       thread->pool_->thread_options().nice_priority_level();
+  int realtime_priority = thread->pool_->thread_options().realtime_priority();
   const std::set<int> selected_cpus = thread->pool_->thread_options().cpu_set();
+#if defined(__EMSCRIPTEN__)
+  // Web Workers have no kernel thread ids.
+  const int thread_id = thread->worker_index_;
+#else
+  const int thread_id = syscall(SYS_gettid);
+#endif  // __EMSCRIPTEN__
   const std::string name =
-      internal::CreateThreadName(thread->name_prefix_, syscall(SYS_gettid));
+      internal::CreateThreadName(thread->name_prefix_, thread_id);
 #if defined(__linux__)
   if (nice_priority_level != 0) {
     if (nice(nice_priority_level) != -1 || errno == 0) {
@@ -72,6 +96,18 @@ void* ThreadPool::WorkerThread::ThreadBody(void* arg) {
                  << nice_priority_level;
     }
   }
+  if (realtime_priority > 0) {
+    sched_param param;
+    param.sched_priority = realtime_priority;
+    int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (error == 0) {
+      VLOG(1) << "Changed the real-time priority to " << realtime_priority;
+    } else {
+      LOG(ERROR) << "Error : " << strerror(error) << std::endl
+                 << "Could not change the real-time priority to "
+                 << realtime_priority;
+    }
+  }
   if (!selected_cpus.empty()) {
     cpu_set_t cpu_set;
     CPU_ZERO(&cpu_set);
@@ -94,8 +130,17 @@ void* ThreadPool::WorkerThread::ThreadBody(void* arg) {
     LOG(ERROR) << "Error : " << strerror(error) << std::endl
                << "Failed to set name for thread: " << name;
   }
+#elif defined(__EMSCRIPTEN__)
+  // Threads are Web Workers, which the browser schedules and places.
+  if (nice_priority_level != 0 || realtime_priority > 0 ||
+      !selected_cpus.empty()) {
+    LOG(ERROR) << "Thread priority and processor affinity feature aren't "
+                  "supported on the current platform.";
+  }
+  emscripten_set_thread_name(pthread_self(), name.c_str());
 #else
-  if (nice_priority_level != 0 || !selected_cpus.empty()) {
+  if (nice_priority_level != 0 || realtime_priority > 0 ||
+      !selected_cpus.empty()) {
     LOG(ERROR) << "Thread priority and processor affinity feature aren't "
                   "supported on the current platform.";
   }
@@ -105,7 +150,7 @@ void* ThreadPool::WorkerThread::ThreadBody(void* arg) {
                << "Failed to set name for thread: " << name;
   }
 #endif
-  thread->pool_->RunWorker();
+  thread->pool_->RunWorker(thread->worker_index_);
   return nullptr;
 }
 
@@ -138,22 +183,100 @@ ThreadPool::~ThreadPool() {
   threads_.clear();
 }
 
+void ThreadPool::EnableWorkStealing() {
+  CHECK(threads_.empty()) << "EnableWorkStealing called after StartWorkers.";
+  work_stealing_ = true;
+}
+
 void ThreadPool::StartWorkers() {
+  if (work_stealing_) {
+    for (int i = 0; i < num_threads_; ++i) {
+      worker_queues_.push_back(absl::make_unique<WorkerQueue>());
+    }
+  }
   for (int i = 0; i < num_threads_; ++i) {
-    threads_.push_back(new WorkerThread(this, name_prefix_));
+    threads_.push_back(new WorkerThread(this, name_prefix_, i));
   }
 }
 
 void ThreadPool::Schedule(std::function<void()> callback) {
-  mutex_.Lock();
-  tasks_.push_back(std::move(callback));
-  condition_.Signal();
-  mutex_.Unlock();
+  if (!work_stealing_) {
+    mutex_.Lock();
+    tasks_.push_back(std::move(callback));
+    condition_.Signal();
+    mutex_.Unlock();
+    return;
+  }
+
+  // Callbacks scheduled by a worker go to the back of its own queue, which
+  // keeps related work on the same thread. Other callbacks are spread over
+  // all workers.
+  int queue_index = current_thread_pool == this
+                        ? current_worker_index
+                        : next_queue_.fetch_add(1, std::memory_order_relaxed) %
+                              num_threads_;
+  WorkerQueue* queue = worker_queues_[queue_index].get();
+  {
+    absl::MutexLock lock(&queue->mutex);
+    queue->tasks.push_back(std::move(callback));
+  }
+  num_pending_tasks_.fetch_add(1);
+  // An idle worker increments |num_idle_workers_| before it checks
+  // |num_pending_tasks_| under |mutex_|, so either it sees the new task or we
+  // see it waiting and wake it up.
+  if (num_idle_workers_.load() > 0) {
+    absl::MutexLock lock(&mutex_);
+    condition_.Signal();
+  }
 }
 
 int ThreadPool::num_threads() const { return num_threads_; }
 
-void ThreadPool::RunWorker() {
+bool ThreadPool::PopOrStealTask(int worker_index,
+                                std::function<void()>* task) {
+  for (int i = 0; i < num_threads_; ++i) {
+    WorkerQueue* queue =
+        worker_queues_[(worker_index + i) % num_threads_].get();
+    absl::MutexLock lock(&queue->mutex);
+    if (!queue->tasks.empty()) {
+      *task = std::move(queue->tasks.front());
+      queue->tasks.pop_front();
+      num_pending_tasks_.fetch_sub(1);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::RunWorkStealingWorker(int worker_index) {
+  current_thread_pool = this;
+  current_worker_index = worker_index;
+  std::function<void()> task;
+  while (true) {
+    if (PopOrStealTask(worker_index, &task)) {
+      task();
+      task = nullptr;
+      continue;
+    }
+    absl::MutexLock lock(&mutex_);
+    num_idle_workers_.fetch_add(1);
+    while (num_pending_tasks_.load() == 0 && !stopped_) {
+      condition_.Wait(&mutex_);
+    }
+    num_idle_workers_.fetch_sub(1);
+    if (num_pending_tasks_.load() == 0 && stopped_) {
+      break;
+    }
+  }
+  current_thread_pool = nullptr;
+  current_worker_index = -1;
+}
+
+void ThreadPool::RunWorker(int worker_index) {
+  if (work_stealing_) {
+    RunWorkStealingWorker(worker_index);
+    return;
+  }
   mutex_.Lock();
   while (true) {
     if (!tasks_.empty()) {
@@ -15,8 +15,10 @@
 #ifndef MEDIAPIPE_DEPS_THREADPOOL_H_
 #define MEDIAPIPE_DEPS_THREADPOOL_H_
 
+#include <atomic>
 #include <deque>
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -68,6 +70,17 @@ class ThreadPool {
   // having called StartWorkers().
   ~ThreadPool();
 
+  // REQUIRES: StartWorkers has not been called
+  // Gives each worker thread its own task queue instead of sharing a single
+  // queue among all workers. Callbacks scheduled from a worker thread are
+  // appended to that worker's queue; callbacks scheduled from other threads
+  // are distributed round-robin. A worker whose queue is empty steals from
+  // the queues of the other workers. This avoids contention on a single lock
+  // when many threads schedule and run short callbacks concurrently.
+  // With work stealing enabled, callbacks are no longer guaranteed to run in
+  // FIFO order unless num_threads is 1.
+  void EnableWorkStealing();
+
   // REQUIRES: StartWorkers has not been called
   // Actually start the worker threads.
   void StartWorkers();
@@ -80,12 +93,27 @@ class ThreadPool {
   // Provided for debugging and testing only.
   int num_threads() const;
 
+  // Returns true if EnableWorkStealing() has been called.
+  bool work_stealing() const { return work_stealing_; }
+
   // Standard thread options.  Use this accessor to get them.
   const ThreadOptions& thread_options() const;
 
  private:
   class WorkerThread;
-  void RunWorker();
+
+  // A task queue owned by a single worker thread in work stealing mode.
+  struct WorkerQueue {
+    absl::Mutex mutex;
+    std::deque<std::function<void()>> tasks GUARDED_BY(mutex);
+  };
+
+  void RunWorker(int worker_index);
+  void RunWorkStealingWorker(int worker_index);
+
+  // Pops a task from the queue of worker |worker_index|, or steals one from
+  // another worker's queue. Returns false if all queues are empty.
+  bool PopOrStealTask(int worker_index, std::function<void()>* task);
 
   std::string name_prefix_;
   std::vector<WorkerThread*> threads_;
@@ -96,6 +124,18 @@ class ThreadPool {
   bool stopped_ GUARDED_BY(mutex_) = false;
   std::deque<std::function<void()>> tasks_ GUARDED_BY(mutex_);
 
+  // Work stealing state. |worker_queues_| is only populated when
+  // EnableWorkStealing() has been called; |mutex_| and |condition_| are then
+  // only used to put idle workers to sleep and to wake them up.
+  bool work_stealing_ = false;
+  std::vector<std::unique_ptr<WorkerQueue>> worker_queues_;
+  // The number of tasks in all of |worker_queues_|.
+  std::atomic<int> num_pending_tasks_{0};
+  // The number of workers waiting on |condition_|.
+  std::atomic<int> num_idle_workers_{0};
+  // Index used to distribute tasks scheduled from non-worker threads.
+  std::atomic<unsigned int> next_queue_{0};
+
   ThreadOptions thread_options_;
 };
 
@@ -14,9 +14,13 @@
 
 #include "mediapipe/framework/deps/threadpool.h"
 
+#include <functional>
 #include <set>
+#include <vector>
 
+#include "absl/synchronization/blocking_counter.h"
 #include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/gtest.h"
 
 namespace mediapipe {
@@ -69,6 +73,74 @@ TEST(ThreadPoolTest, MultiThreads) {
   EXPECT_EQ(0, n);
 }
 
+TEST(ThreadPoolTest, WorkStealingSingleThread) {
+  absl::Mutex mu;
+  std::vector<int> order;
+  {
+    ThreadPool thread_pool("testpool", 1);
+    thread_pool.EnableWorkStealing();
+    ASSERT_TRUE(thread_pool.work_stealing());
+    thread_pool.StartWorkers();
+
+    for (int i = 0; i < 100; ++i) {
+      thread_pool.Schedule([&order, &mu, i]() {
+        absl::MutexLock l(&mu);
+        order.push_back(i);
+      });
+    }
+  }
+
+  ASSERT_EQ(100, order.size());
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(i, order[i]);
+  }
+}
+
+TEST(ThreadPoolTest, WorkStealingMultiThreads) {
+  absl::Mutex mu;
+  int n = 1000;
+  {
+    ThreadPool thread_pool("testpool", 10);
+    thread_pool.EnableWorkStealing();
+    thread_pool.StartWorkers();
+
+    for (int i = 0; i < 1000; ++i) {
+      thread_pool.Schedule([&n, &mu]() mutable {
+        absl::MutexLock l(&mu);
+        --n;
+      });
+    }
+  }
+
+  EXPECT_EQ(0, n);
+}
+
+TEST(ThreadPoolTest, WorkStealingScheduleFromWorker) {
+  absl::Mutex mu;
+  int n = 0;
+  std::function<void(int)> spawn;
+  {
+    ThreadPool thread_pool("testpool", 4);
+    thread_pool.EnableWorkStealing();
+    thread_pool.StartWorkers();
+
+    // Each task schedules two more tasks until the tree has depth 10.
+    spawn = [&](int depth) {
+      {
+        absl::MutexLock l(&mu);
+        ++n;
+      }
+      if (depth < 10) {
+        thread_pool.Schedule([&spawn, depth]() { spawn(depth + 1); });
+        thread_pool.Schedule([&spawn, depth]() { spawn(depth + 1); });
+      }
+    };
+    thread_pool.Schedule([&spawn]() { spawn(0); });
+  }
+
+  EXPECT_EQ((1 << 11) - 1, n);
+}
+
 TEST(ThreadPoolTest, CreateWithThreadOptions) {
   ThreadPool thread_pool(ThreadOptions(), "testpool", 10);
   ASSERT_EQ(10, thread_pool.num_threads());
@@ -115,4 +187,38 @@ TEST(ThreadPoolTest, CreateThreadName) {
             internal::CreateThreadName("name_prefix_lon", 1234));
 }
 
+// Schedules batches of 1000 empty tasks from outside the pool and waits for
+// them to run.
+void BM_Schedule(benchmark::State& state) {
+  ThreadPool thread_pool("testpool", state.range(0));
+  thread_pool.StartWorkers();
+  const int kNumTasks = 1000;
+  for (auto _ : state) {
+    absl::BlockingCounter done(kNumTasks);
+    for (int i = 0; i < kNumTasks; ++i) {
+      thread_pool.Schedule([&done]() { done.DecrementCount(); });
+    }
+    done.Wait();
+  }
+  state.SetItemsProcessed(state.iterations() * kNumTasks);
+}
+BENCHMARK(BM_Schedule)->Arg(1)->Arg(4);
+
+// Same as BM_Schedule, with work stealing enabled.
+void BM_ScheduleWorkStealing(benchmark::State& state) {
+  ThreadPool thread_pool("testpool", state.range(0));
+  thread_pool.EnableWorkStealing();
+  thread_pool.StartWorkers();
+  const int kNumTasks = 1000;
+  for (auto _ : state) {
+    absl::BlockingCounter done(kNumTasks);
+    for (int i = 0; i < kNumTasks; ++i) {
+      thread_pool.Schedule([&done]() { done.DecrementCount(); });
+    }
+    done.Wait();
+  }
+  state.SetItemsProcessed(state.iterations() * kNumTasks);
+}
+BENCHMARK(BM_ScheduleWorkStealing)->Arg(1)->Arg(4);
+
 }  // namespace mediapipe
@@ -0,0 +1,156 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/fair_share_executor.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/time/clock.h"
+#include "mediapipe/framework/port/logging.h"
+
+namespace mediapipe {
+
+namespace {
+
+// The weight of the latest run time in a client's expected run time.
+constexpr double kRunTimeSmoothing = 0.25;
+
+int64 NowMicros() { return absl::GetCurrentTimeNanos() / 1000; }
+
+}  // namespace
+
+FairShareExecutor::Client::Client(FairShareExecutor* executor,
+                                  const std::string& name,
+                                  const ClientOptions& options)
+    : executor_(executor), name_(name), options_(options) {}
+
+FairShareExecutor::Client::~Client() { executor_->RemoveClient(this); }
+
+void FairShareExecutor::Client::Schedule(std::function<void()> task) {
+  executor_->Enqueue(this, std::move(task));
+}
+
+FairShareExecutor::ClientStats FairShareExecutor::Client::GetStats() const {
+  absl::MutexLock lock(&executor_->mutex_);
+  return stats_;
+}
+
+FairShareExecutor::FairShareExecutor(int num_threads)
+    : num_threads_(num_threads),
+      thread_pool_("mediapipe_fair_share", num_threads) {
+  CHECK_GT(num_threads, 0);
+  thread_pool_.StartWorkers();
+  for (int i = 0; i < num_threads; ++i) {
+    thread_pool_.Schedule([this] { RunWorker(); });
+  }
+}
+
+FairShareExecutor::~FairShareExecutor() {
+  absl::MutexLock lock(&mutex_);
+  stopping_ = true;
+  task_ready_cond_var_.SignalAll();
+}
+
+std::shared_ptr<FairShareExecutor::Client> FairShareExecutor::AddClient(
+    const std::string& name, const ClientOptions& options) {
+  CHECK_GT(options.weight, 0) << name;
+  CHECK_GE(options.max_concurrency, 0) << name;
+  return std::shared_ptr<Client>(new Client(this, name, options));
+}
+
+void FairShareExecutor::Enqueue(Client* client, std::function<void()> task) {
+  absl::MutexLock lock(&mutex_);
+  if (client->tasks_.empty()) {
+    if (client->num_running_ == 0) {
+      // An idle client does not keep the credit of the time it was idle.
+      client->virtual_time_ = std::max(client->virtual_time_, virtual_time_);
+    }
+    active_clients_.push_back(client);
+  }
+  client->tasks_.push_back({std::move(task), NowMicros()});
+  task_ready_cond_var_.Signal();
+}
+
+void FairShareExecutor::RemoveClient(Client* client) {
+  absl::MutexLock lock(&mutex_);
+  // A worker may still be accounting for the last task of the client.
+  mutex_.Await(absl::Condition(
+      +[](Client* client) {
+        return client->tasks_.empty() && client->num_running_ == 0;
+      },
+      client));
+}
+
+FairShareExecutor::Client* FairShareExecutor::NextClient() {
+  Client* next = nullptr;
+  for (Client* client : active_clients_) {
+    if (client->options_.max_concurrency > 0 &&
+        client->num_running_ >= client->options_.max_concurrency) {
+      continue;
+    }
+    if (!next || client->virtual_time_ < next->virtual_time_) {
+      next = client;
+    }
+  }
+  return next;
+}
+
+void FairShareExecutor::RunWorker() {
+  absl::MutexLock lock(&mutex_);
+  while (true) {
+    Client* client = nullptr;
+    while (!stopping_ && (client = NextClient()) == nullptr) {
+      task_ready_cond_var_.Wait(&mutex_);
+    }
+    if (stopping_) {
+      return;
+    }
+    Client::QueuedTask queued_task = std::move(client->tasks_.front());
+    client->tasks_.pop_front();
+    if (client->tasks_.empty()) {
+      active_clients_.erase(
+          std::find(active_clients_.begin(), active_clients_.end(), client));
+    }
+    ++client->num_running_;
+    virtual_time_ = std::max(virtual_time_, client->virtual_time_);
+    const double charged_time =
+        client->expected_run_time_ / client->options_.weight;
+    client->virtual_time_ += charged_time;
+
+    mutex_.Unlock();
+    const int64 start_time = NowMicros();
+    queued_task.task();
+    const int64 end_time = NowMicros();
+    queued_task.task = nullptr;
+    mutex_.Lock();
+
+    const int64 run_time = end_time - start_time;
+    --client->num_running_;
+    client->virtual_time_ +=
+        run_time / client->options_.weight - charged_time;
+    client->expected_run_time_ +=
+        kRunTimeSmoothing * (run_time - client->expected_run_time_);
+    ++client->stats_.num_tasks;
+    client->stats_.run_time += run_time;
+    client->stats_.queue_time += start_time - queued_task.schedule_time;
+    if (!client->tasks_.empty()) {
+      // The client may have been held back by its max_concurrency.
+      task_ready_cond_var_.Signal();
+    }
+  }
+}
+
+}  // namespace mediapipe
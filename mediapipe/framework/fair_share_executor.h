@@ -0,0 +1,146 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_FAIR_SHARE_EXECUTOR_H_
+#define MEDIAPIPE_FRAMEWORK_FAIR_SHARE_EXECUTOR_H_
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/executor.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/threadpool.h"
+
+namespace mediapipe {
+
+// An executor shared by many graphs in one process, which divides its threads
+// among them by weighted fair queuing.  Each graph runs on its own client
+// executor, created by AddClient() and passed to
+// CalculatorGraph::SetExecutor().  While the threads are contended, every
+// client with queued tasks gets a share of the thread time proportional to its
+// weight, and a client never runs more than its max_concurrency tasks at once.
+// Tasks of one client run in FIFO order.
+//
+// Example:
+//   FairShareExecutor executor(NumCPUCores());
+//   FairShareExecutor::ClientOptions options;
+//   options.weight = 2.0;
+//   options.max_concurrency = 4;
+//   MP_RETURN_IF_ERROR(
+//       graph.SetExecutor("", executor.AddClient("tenant_a", options)));
+//
+// The FairShareExecutor must outlive its clients.
+class FairShareExecutor {
+ public:
+  struct ClientOptions {
+    // The client's share of the threads, relative to the other clients.
+    double weight = 1.0;
+    // The maximum number of tasks of the client that run at once, or 0 for
+    // no limit.
+    int max_concurrency = 0;
+  };
+
+  // The accounting of a client's tasks, in microseconds.
+  struct ClientStats {
+    int64 num_tasks = 0;
+    // Time spent running the tasks.
+    int64 run_time = 0;
+    // Time the tasks waited for a thread after they were scheduled.
+    int64 queue_time = 0;
+  };
+
+  class Client : public Executor {
+   public:
+    ~Client() override;
+    void Schedule(std::function<void()> task) override;
+
+    const std::string& name() const { return name_; }
+    // Returns the accounting of the tasks that have completed so far.
+    ClientStats GetStats() const;
+
+   private:
+    friend class FairShareExecutor;
+
+    struct QueuedTask {
+      std::function<void()> task;
+      int64 schedule_time;
+    };
+
+    Client(FairShareExecutor* executor, const std::string& name,
+           const ClientOptions& options);
+
+    FairShareExecutor* const executor_;
+    const std::string name_;
+    const ClientOptions options_;
+
+    // The rest is guarded by executor_->mutex_.
+    std::deque<QueuedTask> tasks_;
+    int num_running_ = 0;
+    // The thread time consumed so far, divided by the weight.  The client
+    // with the smallest virtual time runs next.
+    double virtual_time_ = 0;
+    // The expected run time of the next task, charged when it starts and
+    // corrected when it completes, so that a client starting several long
+    // tasks at once does not take all the threads.
+    double expected_run_time_ = 0;
+    ClientStats stats_;
+  };
+
+  explicit FairShareExecutor(int num_threads);
+  ~FairShareExecutor();
+
+  FairShareExecutor(const FairShareExecutor&) = delete;
+  FairShareExecutor& operator=(const FairShareExecutor&) = delete;
+
+  // Returns a new client executor.  The name is only used to identify the
+  // client.
+  std::shared_ptr<Client> AddClient(const std::string& name,
+                                    const ClientOptions& options);
+
+  int num_threads() const { return num_threads_; }
+
+ private:
+  void Enqueue(Client* client, std::function<void()> task)
+      LOCKS_EXCLUDED(mutex_);
+  void RemoveClient(Client* client) LOCKS_EXCLUDED(mutex_);
+
+  // Returns the client with queued tasks and room to run one that has the
+  // smallest virtual time, or nullptr if there is none.
+  Client* NextClient() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Runs the tasks of the clients until the executor is destroyed.
+  void RunWorker() LOCKS_EXCLUDED(mutex_);
+
+  const int num_threads_;
+  mutable absl::Mutex mutex_;
+  absl::CondVar task_ready_cond_var_;
+  // The clients with queued tasks.
+  std::vector<Client*> active_clients_ GUARDED_BY(mutex_);
+  // The virtual time of the latest task to start.  A client that becomes
+  // active starts from it, so that it cannot catch up on the time it was idle.
+  double virtual_time_ GUARDED_BY(mutex_) = 0;
+  bool stopping_ GUARDED_BY(mutex_) = false;
+  // Declared last, so that the workers are joined before the rest is
+  // destroyed.
+  ThreadPool thread_pool_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_FAIR_SHARE_EXECUTOR_H_
@@ -0,0 +1,196 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/fair_share_executor.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+FairShareExecutor::ClientOptions WithWeight(double weight) {
+  FairShareExecutor::ClientOptions options;
+  options.weight = weight;
+  return options;
+}
+
+TEST(FairShareExecutorTest, RunsTasksOfEveryClient) {
+  FairShareExecutor executor(2);
+  auto first = executor.AddClient("first", {});
+  auto second = executor.AddClient("second", {});
+  absl::BlockingCounter done(20);
+  for (int i = 0; i < 10; ++i) {
+    first->Schedule([&done] { done.DecrementCount(); });
+    second->Schedule([&done] { done.DecrementCount(); });
+  }
+  done.Wait();
+}
+
+TEST(FairShareExecutorTest, RunsTasksOfOneClientInOrder) {
+  FairShareExecutor executor(1);
+  auto client = executor.AddClient("client", {});
+  std::vector<int> order;
+  absl::BlockingCounter done(5);
+  for (int i = 0; i < 5; ++i) {
+    client->Schedule([&order, &done, i] {
+      order.push_back(i);
+      done.DecrementCount();
+    });
+  }
+  done.Wait();
+  EXPECT_THAT(order, testing::ElementsAre(0, 1, 2, 3, 4));
+}
+
+// With a single thread, a client of weight 3 runs three times as many equally
+// long tasks as a client of weight 1 while both have tasks queued.
+TEST(FairShareExecutorTest, SharesThreadsByWeight) {
+  FairShareExecutor executor(1);
+  auto blocker = executor.AddClient("blocker", {});
+  auto heavy = executor.AddClient("heavy", WithWeight(3.0));
+  auto light = executor.AddClient("light", WithWeight(1.0));
+
+  // Holds the thread until both clients have queued all their tasks.
+  absl::Notification start;
+  blocker->Schedule([&start] { start.WaitForNotification(); });
+
+  constexpr int kNumTasks = 40;
+  absl::Mutex mutex;
+  std::vector<std::string> order;
+  absl::BlockingCounter done(2 * kNumTasks);
+  for (int i = 0; i < kNumTasks; ++i) {
+    for (FairShareExecutor::Client* client : {heavy.get(), light.get()}) {
+      client->Schedule([client, &mutex, &order, &done] {
+        absl::SleepFor(absl::Milliseconds(1));
+        absl::MutexLock lock(&mutex);
+        order.push_back(client->name());
+        done.DecrementCount();
+      });
+    }
+  }
+  start.Notify();
+  done.Wait();
+
+  // Both clients have tasks queued during the first 40 tasks.
+  const int heavy_count =
+      std::count(order.begin(), order.begin() + kNumTasks, "heavy");
+  EXPECT_GE(heavy_count, 26);
+  EXPECT_LE(heavy_count, 34);
+}
+
+TEST(FairShareExecutorTest, LimitsConcurrencyOfClient) {
+  FairShareExecutor executor(4);
+  FairShareExecutor::ClientOptions options;
+  options.max_concurrency = 2;
+  auto client = executor.AddClient("client", options);
+
+  absl::Mutex mutex;
+  int num_running = 0;
+  int max_num_running = 0;
+  absl::BlockingCounter done(20);
+  for (int i = 0; i < 20; ++i) {
+    client->Schedule([&] {
+      {
+        absl::MutexLock lock(&mutex);
+        ++num_running;
+        max_num_running = std::max(max_num_running, num_running);
+      }
+      absl::SleepFor(absl::Milliseconds(2));
+      {
+        absl::MutexLock lock(&mutex);
+        --num_running;
+      }
+      done.DecrementCount();
+    });
+  }
+  done.Wait();
+  EXPECT_LE(max_num_running, 2);
+}
+
+TEST(FairShareExecutorTest, AccountsRunAndQueueTime) {
+  FairShareExecutor executor(1);
+  auto client = executor.AddClient("client", {});
+  absl::BlockingCounter done(2);
+  for (int i = 0; i < 2; ++i) {
+    client->Schedule([&done] {
+      absl::SleepFor(absl::Milliseconds(10));
+      done.DecrementCount();
+    });
+  }
+  done.Wait();
+  // Waits until the worker has recorded the stats of the last task.
+  absl::SleepFor(absl::Milliseconds(10));
+  FairShareExecutor::ClientStats stats = client->GetStats();
+  EXPECT_EQ(2, stats.num_tasks);
+  EXPECT_GE(stats.run_time, 20000);
+  // The second task waited for the first one.
+  EXPECT_GE(stats.queue_time, 10000);
+}
+
+TEST(FairShareExecutorTest, RunsGraphsOnClients) {
+  CalculatorGraphConfig config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+    input_stream: "input"
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "input"
+      output_stream: "output"
+    }
+  )");
+  FairShareExecutor executor(2);
+  std::vector<std::shared_ptr<FairShareExecutor::Client>> clients;
+  std::vector<std::unique_ptr<CalculatorGraph>> graphs;
+  std::vector<std::vector<Packet>> outputs(2);
+  for (int i = 0; i < 2; ++i) {
+    clients.push_back(
+        executor.AddClient(absl::StrCat("graph_", i), WithWeight(i + 1)));
+    graphs.push_back(absl::make_unique<CalculatorGraph>());
+    MP_ASSERT_OK(graphs[i]->SetExecutor("", clients[i]));
+    MP_ASSERT_OK(graphs[i]->Initialize(config));
+    MP_ASSERT_OK(graphs[i]->ObserveOutputStream(
+        "output", [&outputs, i](const Packet& packet) {
+          outputs[i].push_back(packet);
+          return ::mediapipe::OkStatus();
+        }));
+    MP_ASSERT_OK(graphs[i]->StartRun({}));
+  }
+  for (int t = 0; t < 10; ++t) {
+    for (auto& graph : graphs) {
+      MP_ASSERT_OK(graph->AddPacketToInputStream(
+          "input", MakePacket<int>(t).At(Timestamp(t))));
+    }
+  }
+  for (int i = 0; i < 2; ++i) {
+    MP_ASSERT_OK(graphs[i]->CloseAllInputStreams());
+    MP_ASSERT_OK(graphs[i]->WaitUntilDone());
+    EXPECT_EQ(10, outputs[i].size());
+    EXPECT_GT(clients[i]->GetStats().num_tasks, 0);
+  }
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,128 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/compact_detections.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "mediapipe/framework/formats/location_data.pb.h"
+#include "mediapipe/framework/port/ret_check.h"
+
+namespace mediapipe {
+
+void CompactDetections::Clear() {
+  xmin.clear();
+  ymin.clear();
+  width.clear();
+  height.clear();
+  score.clear();
+  label_id.clear();
+  keypoints.clear();
+}
+
+void CompactDetections::Reserve(int num_detections) {
+  xmin.reserve(num_detections);
+  ymin.reserve(num_detections);
+  width.reserve(num_detections);
+  height.reserve(num_detections);
+  score.reserve(num_detections);
+  label_id.reserve(num_detections);
+  keypoints.reserve(2 * num_keypoints * num_detections);
+}
+
+int CompactDetections::Add(float xmin, float ymin, float width, float height,
+                       float score, int label_id) {
+  this->xmin.push_back(xmin);
+  this->ymin.push_back(ymin);
+  this->width.push_back(width);
+  this->height.push_back(height);
+  this->score.push_back(score);
+  this->label_id.push_back(label_id);
+  keypoints.resize(keypoints.size() + 2 * num_keypoints, 0.0f);
+  return size() - 1;
+}
+
+void CompactDetections::Append(const CompactDetections& other, int index) {
+  Add(other.xmin[index], other.ymin[index], other.width[index],
+      other.height[index], other.score[index], other.label_id[index]);
+  std::copy(other.Keypoints(index), other.Keypoints(index + 1),
+            MutableKeypoints(size() - 1));
+}
+
+::mediapipe::Status DetectionsToCompactDetections(
+    const std::vector<Detection>& detections,
+    CompactDetections* compact_detections) {
+  compact_detections->Clear();
+  if (detections.empty()) {
+    return ::mediapipe::OkStatus();
+  }
+  compact_detections->num_keypoints =
+      detections[0].location_data().relative_keypoints_size();
+  compact_detections->Reserve(detections.size());
+  for (const Detection& detection : detections) {
+    const LocationData& location_data = detection.location_data();
+    RET_CHECK(location_data.has_relative_bounding_box())
+        << "Only detections with relative bounding boxes can be converted.";
+    RET_CHECK_EQ(location_data.relative_keypoints_size(),
+                 compact_detections->num_keypoints)
+        << "All detections must have the same number of keypoints.";
+    float score = 0.0f;
+    int label_id = -1;
+    for (int i = 0; i < detection.score_size(); ++i) {
+      if (i == 0 || detection.score(i) > score) {
+        score = detection.score(i);
+        label_id = i < detection.label_id_size() ? detection.label_id(i) : -1;
+      }
+    }
+    const auto& box = location_data.relative_bounding_box();
+    const int index = compact_detections->Add(
+        box.xmin(), box.ymin(), box.width(), box.height(), score, label_id);
+    float* keypoints = compact_detections->MutableKeypoints(index);
+    for (const auto& keypoint : location_data.relative_keypoints()) {
+      *keypoints++ = keypoint.x();
+      *keypoints++ = keypoint.y();
+    }
+  }
+  return ::mediapipe::OkStatus();
+}
+
+void CompactDetectionsToDetections(
+    const CompactDetections& compact_detections,
+    std::vector<Detection>* detections) {
+  detections->reserve(detections->size() + compact_detections.size());
+  for (int i = 0; i < compact_detections.size(); ++i) {
+    Detection detection;
+    detection.add_score(compact_detections.score[i]);
+    if (compact_detections.label_id[i] >= 0) {
+      detection.add_label_id(compact_detections.label_id[i]);
+    }
+    LocationData* location_data = detection.mutable_location_data();
+    location_data->set_format(LocationData::RELATIVE_BOUNDING_BOX);
+    auto* box = location_data->mutable_relative_bounding_box();
+    box->set_xmin(compact_detections.xmin[i]);
+    box->set_ymin(compact_detections.ymin[i]);
+    box->set_width(compact_detections.width[i]);
+    box->set_height(compact_detections.height[i]);
+    const float* keypoints = compact_detections.Keypoints(i);
+    for (int k = 0; k < compact_detections.num_keypoints; ++k) {
+      auto* keypoint = location_data->add_relative_keypoints();
+      keypoint->set_x(keypoints[2 * k]);
+      keypoint->set_y(keypoints[2 * k + 1]);
+    }
+    detections->push_back(std::move(detection));
+  }
+}
+
+}  // namespace mediapipe
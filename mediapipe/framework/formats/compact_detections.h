@@ -0,0 +1,93 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// A compact list of detections, stored as one array per field.
+//
+// The detection calculators can pass CompactDetections instead of a
+// std::vector<Detection>, so that a frame of detections is produced and
+// transformed without building a Detection and LocationData proto for each.
+// Each detection has a relative bounding box, a single score and label id, and
+// the same number of relative keypoints.
+
+#ifndef MEDIAPIPE_FRAMEWORK_FORMATS_COMPACT_DETECTIONS_H_
+#define MEDIAPIPE_FRAMEWORK_FORMATS_COMPACT_DETECTIONS_H_
+
+#include <vector>
+
+#include "mediapipe/framework/formats/detection.pb.h"
+#include "mediapipe/framework/port/status.h"
+
+namespace mediapipe {
+
+struct CompactDetections {
+  // The number of keypoints of each detection.
+  int num_keypoints = 0;
+
+  // The relative bounding box of each detection.
+  std::vector<float> xmin;
+  std::vector<float> ymin;
+  std::vector<float> width;
+  std::vector<float> height;
+
+  // The score and label id of each detection. The label id is -1 if unknown.
+  std::vector<float> score;
+  std::vector<int> label_id;
+
+  // The relative keypoints of all detections as (x, y) pairs. The keypoints of
+  // detection i start at index 2 * num_keypoints * i.
+  std::vector<float> keypoints;
+
+  int size() const { return score.size(); }
+  bool empty() const { return score.empty(); }
+
+  // Removes all detections, keeping num_keypoints.
+  void Clear();
+
+  // Reserves space for "num_detections" detections.
+  void Reserve(int num_detections);
+
+  // Appends a detection with its keypoints set to zero, and returns its index.
+  int Add(float xmin, float ymin, float width, float height, float score,
+          int label_id);
+
+  // Appends detection "index" of "other", which must have the same
+  // num_keypoints.
+  void Append(const CompactDetections& other, int index);
+
+  // Returns the (x, y) pairs of the keypoints of detection "index".
+  const float* Keypoints(int index) const {
+    return keypoints.data() + 2 * num_keypoints * index;
+  }
+  float* MutableKeypoints(int index) {
+    return keypoints.data() + 2 * num_keypoints * index;
+  }
+};
+
+// Converts detections with relative bounding boxes to CompactDetections. Only
+// the top scoring label id of each detection is kept, and string labels are
+// dropped. Fails if a detection has no relative bounding box, or a different
+// number of keypoints from the first detection.
+::mediapipe::Status DetectionsToCompactDetections(
+    const std::vector<Detection>& detections,
+    CompactDetections* compact_detections);
+
+// Appends the detections of "compact_detections" to "detections", with
+// RELATIVE_BOUNDING_BOX location data.
+void CompactDetectionsToDetections(
+    const CompactDetections& compact_detections,
+    std::vector<Detection>* detections);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_FORMATS_COMPACT_DETECTIONS_H_
@@ -0,0 +1,101 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/compact_detections.h"
+
+#include <vector>
+
+#include "mediapipe/framework/formats/detection.pb.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(CompactDetectionsTest, AddAndAppend) {
+  CompactDetections list;
+  list.num_keypoints = 1;
+  int index = list.Add(0.1f, 0.2f, 0.3f, 0.4f, 0.9f, 5);
+  list.MutableKeypoints(index)[0] = 0.5f;
+  list.MutableKeypoints(index)[1] = 0.6f;
+  list.Add(0.0f, 0.0f, 1.0f, 1.0f, 0.5f, 7);
+
+  CompactDetections other;
+  other.num_keypoints = 1;
+  other.Append(list, 0);
+  ASSERT_EQ(other.size(), 1);
+  EXPECT_FLOAT_EQ(other.xmin[0], 0.1f);
+  EXPECT_FLOAT_EQ(other.height[0], 0.4f);
+  EXPECT_FLOAT_EQ(other.score[0], 0.9f);
+  EXPECT_EQ(other.label_id[0], 5);
+  EXPECT_FLOAT_EQ(other.Keypoints(0)[0], 0.5f);
+  EXPECT_FLOAT_EQ(other.Keypoints(0)[1], 0.6f);
+
+  list.Clear();
+  EXPECT_TRUE(list.empty());
+  EXPECT_TRUE(list.keypoints.empty());
+  EXPECT_EQ(list.num_keypoints, 1);
+}
+
+TEST(CompactDetectionsTest, ConvertsToAndFromDetections) {
+  std::vector<Detection> detections = {
+      ParseTextProtoOrDie<Detection>(R"(
+        label_id: 1
+        label_id: 2
+        score: 0.3
+        score: 0.8
+        location_data {
+          format: RELATIVE_BOUNDING_BOX
+          relative_bounding_box { xmin: 0.1 ymin: 0.2 width: 0.3 height: 0.4 }
+          relative_keypoints { x: 0.5 y: 0.6 }
+        }
+      )")};
+  CompactDetections list;
+  MP_ASSERT_OK(DetectionsToCompactDetections(detections, &list));
+  ASSERT_EQ(list.size(), 1);
+  EXPECT_EQ(list.num_keypoints, 1);
+  EXPECT_FLOAT_EQ(list.score[0], 0.8f);
+  EXPECT_EQ(list.label_id[0], 2);
+  EXPECT_FLOAT_EQ(list.ymin[0], 0.2f);
+  EXPECT_FLOAT_EQ(list.Keypoints(0)[1], 0.6f);
+
+  std::vector<Detection> converted;
+  CompactDetectionsToDetections(list, &converted);
+  ASSERT_EQ(converted.size(), 1);
+  EXPECT_EQ(converted[0].label_id_size(), 1);
+  EXPECT_EQ(converted[0].label_id(0), 2);
+  EXPECT_FLOAT_EQ(converted[0].score(0), 0.8f);
+  EXPECT_EQ(converted[0].location_data().format(),
+            LocationData::RELATIVE_BOUNDING_BOX);
+  EXPECT_FLOAT_EQ(
+      converted[0].location_data().relative_bounding_box().width(), 0.3f);
+  EXPECT_FLOAT_EQ(converted[0].location_data().relative_keypoints(0).x(),
+                  0.5f);
+}
+
+TEST(CompactDetectionsTest, RejectsAbsoluteBoundingBoxes) {
+  std::vector<Detection> detections = {ParseTextProtoOrDie<Detection>(R"(
+    score: 0.5
+    location_data {
+      format: BOUNDING_BOX
+      bounding_box { xmin: 1 ymin: 2 width: 3 height: 4 }
+    }
+  )")};
+  CompactDetections list;
+  EXPECT_FALSE(DetectionsToCompactDetections(detections, &list).ok());
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,112 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/compact_landmarks.h"
+
+#include <cmath>
+
+namespace mediapipe {
+
+LandmarkTransform LandmarkTransform::Scale(float scale_x, float scale_y,
+                                           float scale_z) {
+  LandmarkTransform transform;
+  transform.xx_ = scale_x;
+  transform.yy_ = scale_y;
+  transform.zz_ = scale_z;
+  return transform;
+}
+
+LandmarkTransform LandmarkTransform::Translate(float x, float y) {
+  LandmarkTransform transform;
+  transform.x0_ = x;
+  transform.y0_ = y;
+  return transform;
+}
+
+LandmarkTransform LandmarkTransform::Rotate(float angle) {
+  LandmarkTransform transform;
+  transform.xx_ = std::cos(angle);
+  transform.xy_ = -std::sin(angle);
+  transform.yx_ = std::sin(angle);
+  transform.yy_ = std::cos(angle);
+  return transform;
+}
+
+LandmarkTransform LandmarkTransform::RemoveLetterbox(
+    const std::array<float, 4>& padding) {
+  return Translate(-padding[0], -padding[1])
+      .Then(Scale(1.0f / (1.0f - padding[0] - padding[2]),
+                  1.0f / (1.0f - padding[1] - padding[3]), 1.0f));
+}
+
+LandmarkTransform LandmarkTransform::Project(const NormalizedRect& rect,
+                                             bool ignore_rotation) {
+  return Translate(-0.5f, -0.5f)
+      .Then(Rotate(ignore_rotation ? 0.0f : rect.rotation()))
+      .Then(Scale(rect.width(), rect.height(), 1.0f))
+      .Then(Translate(rect.x_center(), rect.y_center()));
+}
+
+LandmarkTransform LandmarkTransform::Then(
+    const LandmarkTransform& next) const {
+  LandmarkTransform transform;
+  transform.xx_ = next.xx_ * xx_ + next.xy_ * yx_;
+  transform.xy_ = next.xx_ * xy_ + next.xy_ * yy_;
+  transform.x0_ = next.xx_ * x0_ + next.xy_ * y0_ + next.x0_;
+  transform.yx_ = next.yx_ * xx_ + next.yy_ * yx_;
+  transform.yy_ = next.yx_ * xy_ + next.yy_ * yy_;
+  transform.y0_ = next.yx_ * x0_ + next.yy_ * y0_ + next.y0_;
+  transform.zz_ = next.zz_ * zz_;
+  return transform;
+}
+
+void LandmarkTransform::Apply(CompactLandmarks* landmarks) const {
+  float* coordinates = landmarks->coordinates.data();
+  const int num_landmarks = landmarks->size();
+  for (int i = 0; i < num_landmarks; ++i, coordinates += 3) {
+    const float x = coordinates[0];
+    const float y = coordinates[1];
+    coordinates[0] = xx_ * x + xy_ * y + x0_;
+    coordinates[1] = yx_ * x + yy_ * y + y0_;
+    coordinates[2] *= zz_;
+  }
+}
+
+void NormalizedLandmarksToCompactLandmarks(
+    const std::vector<NormalizedLandmark>& landmarks,
+    CompactLandmarks* compact_landmarks) {
+  compact_landmarks->Resize(landmarks.size());
+  float* coordinates = compact_landmarks->coordinates.data();
+  for (const NormalizedLandmark& landmark : landmarks) {
+    *coordinates++ = landmark.x();
+    *coordinates++ = landmark.y();
+    *coordinates++ = landmark.z();
+  }
+}
+
+void CompactLandmarksToNormalizedLandmarks(
+    const CompactLandmarks& compact_landmarks,
+    std::vector<NormalizedLandmark>* landmarks) {
+  landmarks->reserve(landmarks->size() + compact_landmarks.size());
+  for (int i = 0; i < compact_landmarks.size(); ++i) {
+    const float* coordinates = compact_landmarks.Landmark(i);
+    NormalizedLandmark landmark;
+    landmark.set_x(coordinates[0]);
+    landmark.set_y(coordinates[1]);
+    landmark.set_z(coordinates[2]);
+    landmarks->push_back(landmark);
+  }
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,98 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// A compact list of landmarks, stored as one flat array of coordinates.
+//
+// The landmark calculators can pass CompactLandmarks instead of a
+// std::vector<NormalizedLandmark>, so that the landmarks of a frame are
+// decoded, normalized and projected without building a proto for each. The
+// steps are LandmarkTransforms, which compose into one pass over the array.
+
+#ifndef MEDIAPIPE_FRAMEWORK_FORMATS_COMPACT_LANDMARKS_H_
+#define MEDIAPIPE_FRAMEWORK_FORMATS_COMPACT_LANDMARKS_H_
+
+#include <array>
+#include <vector>
+
+#include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/formats/rect.pb.h"
+
+namespace mediapipe {
+
+struct CompactLandmarks {
+  // The (x, y, z) coordinates of all landmarks. The coordinates of landmark i
+  // start at index 3 * i. Missing coordinates are 0.
+  std::vector<float> coordinates;
+
+  int size() const { return coordinates.size() / 3; }
+  bool empty() const { return coordinates.empty(); }
+
+  // Sets the number of landmarks, zeroing those added.
+  void Resize(int num_landmarks) { coordinates.resize(3 * num_landmarks); }
+
+  // Returns the (x, y, z) coordinates of landmark "index".
+  const float* Landmark(int index) const {
+    return coordinates.data() + 3 * index;
+  }
+  float* MutableLandmark(int index) { return coordinates.data() + 3 * index; }
+};
+
+// An affine transformation of landmarks, which maps (x, y) to
+// (xx * x + xy * y + x0, yx * x + yy * y + y0) and scales z by zz.
+class LandmarkTransform {
+ public:
+  // Creates the identity.
+  LandmarkTransform() {}
+
+  static LandmarkTransform Scale(float scale_x, float scale_y, float scale_z);
+  static LandmarkTransform Translate(float x, float y);
+  // Rotates (x, y) by "angle" radians around the origin, counterclockwise in
+  // a y-up frame.
+  static LandmarkTransform Rotate(float angle);
+
+  // Removes the letterbox "padding" ([left, top, right, bottom], normalized
+  // by the letterboxed image size) from normalized landmarks, as
+  // LandmarkLetterboxRemovalCalculator does.
+  static LandmarkTransform RemoveLetterbox(
+      const std::array<float, 4>& padding);
+  // Projects normalized landmarks in "rect" to the image, as
+  // LandmarkProjectionCalculator does.
+  static LandmarkTransform Project(const NormalizedRect& rect,
+                                   bool ignore_rotation);
+
+  // Returns the transformation applying this one, then "next".
+  LandmarkTransform Then(const LandmarkTransform& next) const;
+
+  // Transforms "landmarks" in place.
+  void Apply(CompactLandmarks* landmarks) const;
+
+ private:
+  float xx_ = 1.0f, xy_ = 0.0f, x0_ = 0.0f;
+  float yx_ = 0.0f, yy_ = 1.0f, y0_ = 0.0f;
+  float zz_ = 1.0f;
+};
+
+// Converts "landmarks" to CompactLandmarks.
+void NormalizedLandmarksToCompactLandmarks(
+    const std::vector<NormalizedLandmark>& landmarks,
+    CompactLandmarks* compact_landmarks);
+
+// Appends the landmarks of "compact_landmarks" to "landmarks".
+void CompactLandmarksToNormalizedLandmarks(
+    const CompactLandmarks& compact_landmarks,
+    std::vector<NormalizedLandmark>* landmarks);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_FORMATS_COMPACT_LANDMARKS_H_
@@ -0,0 +1,89 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/compact_landmarks.h"
+
+#include <cmath>
+#include <vector>
+
+#include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/formats/rect.pb.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+
+namespace mediapipe {
+namespace {
+
+CompactLandmarks MakeLandmarks(const std::vector<float>& coordinates) {
+  CompactLandmarks landmarks;
+  landmarks.coordinates = coordinates;
+  return landmarks;
+}
+
+TEST(CompactLandmarksTest, ConvertsToAndFromNormalizedLandmarks) {
+  std::vector<NormalizedLandmark> landmarks = {
+      ParseTextProtoOrDie<NormalizedLandmark>("x: 0.1 y: 0.2 z: 0.3"),
+      ParseTextProtoOrDie<NormalizedLandmark>("x: 0.4 y: 0.5")};
+  CompactLandmarks compact_landmarks;
+  NormalizedLandmarksToCompactLandmarks(landmarks, &compact_landmarks);
+  ASSERT_EQ(2, compact_landmarks.size());
+  EXPECT_EQ(std::vector<float>({0.1f, 0.2f, 0.3f, 0.4f, 0.5f, 0.0f}),
+            compact_landmarks.coordinates);
+
+  std::vector<NormalizedLandmark> round_trip;
+  CompactLandmarksToNormalizedLandmarks(compact_landmarks, &round_trip);
+  ASSERT_EQ(2, round_trip.size());
+  EXPECT_FLOAT_EQ(0.1f, round_trip[0].x());
+  EXPECT_FLOAT_EQ(0.3f, round_trip[0].z());
+  EXPECT_FLOAT_EQ(0.5f, round_trip[1].y());
+  EXPECT_FLOAT_EQ(0.0f, round_trip[1].z());
+}
+
+TEST(CompactLandmarksTest, RemovesLetterbox) {
+  CompactLandmarks landmarks = MakeLandmarks({0.2f, 0.5f, 7.0f, 0.8f, 0.1f, 0});
+  LandmarkTransform::RemoveLetterbox({0.2f, 0.1f, 0.2f, 0.1f})
+      .Apply(&landmarks);
+  // Matches LandmarkLetterboxRemovalCalculator.
+  EXPECT_NEAR(0.0f, landmarks.Landmark(0)[0], 1e-6f);
+  EXPECT_NEAR(0.5f, landmarks.Landmark(0)[1], 1e-6f);
+  EXPECT_FLOAT_EQ(7.0f, landmarks.Landmark(0)[2]);
+  EXPECT_NEAR(1.0f, landmarks.Landmark(1)[0], 1e-6f);
+  EXPECT_NEAR(0.0f, landmarks.Landmark(1)[1], 1e-6f);
+}
+
+TEST(CompactLandmarksTest, ComposesNormalizationAndProjection) {
+  // Landmarks of a 100 x 50 model input, whose rect is rotated by 90 degrees.
+  CompactLandmarks landmarks = MakeLandmarks({75.0f, 25.0f, 10.0f});
+  NormalizedRect rect = ParseTextProtoOrDie<NormalizedRect>(R"(
+    x_center: 0.4 y_center: 0.6 width: 0.2 height: 0.4 rotation: 1.5707964
+  )");
+  LandmarkTransform::Scale(1.0f / 100, 1.0f / 50, 1.0f / 5)
+      .Then(LandmarkTransform::Project(rect, /*ignore_rotation=*/false))
+      .Apply(&landmarks);
+
+  // As LandmarkProjectionCalculator computes it for (0.75, 0.5).
+  const float x = 0.75f - 0.5f;
+  const float y = 0.5f - 0.5f;
+  const float angle = rect.rotation();
+  const float expected_x =
+      (std::cos(angle) * x - std::sin(angle) * y) * 0.2f + 0.4f;
+  const float expected_y =
+      (std::sin(angle) * x + std::cos(angle) * y) * 0.4f + 0.6f;
+  EXPECT_NEAR(expected_x, landmarks.Landmark(0)[0], 1e-6f);
+  EXPECT_NEAR(expected_y, landmarks.Landmark(0)[1], 1e-6f);
+  EXPECT_FLOAT_EQ(2.0f, landmarks.Landmark(0)[2]);
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -23,11 +23,13 @@
 #include <algorithm>
 #include <utility>
 
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "mediapipe/framework/formats/image_format.pb.h"
 #include "mediapipe/framework/port/aligned_malloc_and_free.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/proto_ns.h"
+#include "mediapipe/framework/profiler/payload_size.h"
 
 namespace mediapipe {
 
@@ -46,6 +48,10 @@ int CountOnes(uint32 n) {
 
 }  // namespace
 
+REGISTER_PAYLOAD_SIZE(ImageFrame, [](const ImageFrame& image_frame) {
+  return static_cast<int64>(image_frame.PixelDataSize());
+});
+
 const ImageFrame::Deleter ImageFrame::PixelDataDeleter::kArrayDelete =
     std::default_delete<uint8[]>();
 const ImageFrame::Deleter ImageFrame::PixelDataDeleter::kFree = free;
@@ -405,4 +411,19 @@ void ImageFrame::CopyToBuffer(float* buffer, int buffer_size) const {
                          reinterpret_cast<char*>(buffer));
   }
 }
+
+std::unique_ptr<ImageFrame> CopyPacketData(const ImageFrame& image_frame) {
+  uint32 alignment_boundary = 1;
+  for (uint32 boundary : {ImageFrame::kDefaultAlignmentBoundary,
+                          ImageFrame::kGlDefaultAlignmentBoundary}) {
+    if (image_frame.IsAligned(boundary)) {
+      alignment_boundary = boundary;
+      break;
+    }
+  }
+  auto copy = absl::make_unique<ImageFrame>();
+  copy->CopyFrom(image_frame, alignment_boundary);
+  return copy;
+}
+
 }  // namespace mediapipe
@@ -249,6 +249,12 @@ class ImageFrame {
   std::unique_ptr<uint8[], Deleter> pixel_data_;
 };
 
+// Returns a copy of "image_frame" with the same row alignment, for
+// Packet::ConsumeOrCopy<ImageFrame>() when the packet is shared.  This lets a
+// calculator modify an input frame in place, and copy it only if another
+// reader still holds it.
+std::unique_ptr<ImageFrame> CopyPacketData(const ImageFrame& image_frame);
+
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_FRAMEWORK_FORMATS_IMAGE_FRAME_H_
@@ -0,0 +1,120 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/image_frame_pool.h"
+
+#include <functional>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/port/aligned_malloc_and_free.h"
+#include "mediapipe/framework/port/logging.h"
+
+namespace mediapipe {
+
+const GraphService<ImageFramePool> kImageFramePoolService(
+    "kImageFramePoolService");
+
+constexpr int ImageFramePool::kDefaultKeepCount;
+
+size_t ImageFramePool::FrameSpecHash::operator()(const FrameSpec& spec) const {
+  size_t hash = std::hash<int>{}(spec.format);
+  hash = hash * 31 + std::hash<int>{}(spec.width);
+  hash = hash * 31 + std::hash<int>{}(spec.height);
+  return hash * 31 + std::hash<uint32>{}(spec.alignment_boundary);
+}
+
+ImageFramePool::ImageFramePool(int keep_count) : keep_count_(keep_count) {}
+
+ImageFramePool::~ImageFramePool() {
+  absl::MutexLock lock(&mutex_);
+  for (auto& spec_and_buffers : available_) {
+    for (uint8* pixel_data : spec_and_buffers.second) {
+      aligned_free(pixel_data);
+    }
+  }
+}
+
+std::unique_ptr<ImageFrame> ImageFramePool::GetFrame(
+    ImageFormat::Format format, int width, int height,
+    uint32 alignment_boundary) {
+  CHECK_NE(ImageFormat::UNKNOWN, format);
+  const FrameSpec spec{format, width, height, alignment_boundary};
+  // Same row layout as ImageFrame::Reset().
+  int width_step = width * ImageFrame::NumberOfChannelsForFormat(format) *
+                   ImageFrame::ByteDepthForFormat(format);
+  if (alignment_boundary > 1) {
+    width_step = ((width_step - 1) | (alignment_boundary - 1)) + 1;
+  }
+
+  uint8* pixel_data = nullptr;
+  {
+    absl::MutexLock lock(&mutex_);
+    auto it = available_.find(spec);
+    if (it != available_.end() && !it->second.empty()) {
+      pixel_data = it->second.back();
+      it->second.pop_back();
+    }
+  }
+  if (pixel_data == nullptr) {
+    pixel_data = reinterpret_cast<uint8*>(
+        aligned_malloc(height * width_step, alignment_boundary));
+  }
+
+  std::weak_ptr<ImageFramePool> weak_pool(shared_from_this());
+  ImageFrame::Deleter deleter = [weak_pool, spec](uint8* data) {
+    std::shared_ptr<ImageFramePool> pool = weak_pool.lock();
+    if (pool) {
+      pool->Return(spec, data);
+    } else {
+      aligned_free(data);
+    }
+  };
+  return absl::make_unique<ImageFrame>(format, width, height, width_step,
+                                       pixel_data, std::move(deleter));
+}
+
+// static
+std::unique_ptr<ImageFrame> ImageFramePool::AllocateFrame(
+    ImageFramePool* pool, ImageFormat::Format format, int width, int height,
+    uint32 alignment_boundary) {
+  if (pool) {
+    return pool->GetFrame(format, width, height, alignment_boundary);
+  }
+  return absl::make_unique<ImageFrame>(format, width, height,
+                                       alignment_boundary);
+}
+
+void ImageFramePool::Return(const FrameSpec& spec, uint8* pixel_data) {
+  {
+    absl::MutexLock lock(&mutex_);
+    std::vector<uint8*>& buffers = available_[spec];
+    if (buffers.size() < keep_count_) {
+      buffers.push_back(pixel_data);
+      return;
+    }
+  }
+  aligned_free(pixel_data);
+}
+
+int ImageFramePool::NumAvailableBuffers() {
+  absl::MutexLock lock(&mutex_);
+  int count = 0;
+  for (const auto& spec_and_buffers : available_) {
+    count += spec_and_buffers.second.size();
+  }
+  return count;
+}
+
+}  // namespace mediapipe
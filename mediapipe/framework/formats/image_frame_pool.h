@@ -0,0 +1,124 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This class lets CPU calculators allocate ImageFrames of various sizes,
+// caching and reusing their pixel buffers as needed.  It is the CPU
+// counterpart of GpuBufferMultiPool.
+
+#ifndef MEDIAPIPE_FRAMEWORK_FORMATS_IMAGE_FRAME_POOL_H_
+#define MEDIAPIPE_FRAMEWORK_FORMATS_IMAGE_FRAME_POOL_H_
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/graph_service.h"
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+
+// A thread-safe pool of ImageFrame pixel buffers, keyed by format, width,
+// height and alignment boundary.  The frames returned by GetFrame() use a
+// Deleter that gives their pixel buffer back to the pool, so a calculator
+// producing frames of a fixed geometry stops allocating once the frames it
+// has sent downstream start being released.  If the pool is destroyed
+// first, outstanding buffers are freed normally.
+//
+// Calculators get the pool through kImageFramePoolService:
+//   static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+//     cc->UseService(kImageFramePoolService).Optional();
+//     ...
+//   }
+//   ::mediapipe::Status Process(CalculatorContext* cc) {
+//     auto pool = cc->Service(kImageFramePoolService);
+//     std::unique_ptr<ImageFrame> frame = ImageFramePool::AllocateFrame(
+//         pool.IsAvailable() ? &pool.GetObject() : nullptr, format, width,
+//         height);
+//     ...
+//   }
+class ImageFramePool : public std::enable_shared_from_this<ImageFramePool> {
+ public:
+  // The default number of free buffers kept for each frame geometry.
+  static constexpr int kDefaultKeepCount = 4;
+
+  // Creates a pool that keeps up to keep_count free buffers for each frame
+  // geometry.  We enforce creation as a shared_ptr so that we can use a weak
+  // reference in the frames' deleters.
+  static std::shared_ptr<ImageFramePool> Create(
+      int keep_count = kDefaultKeepCount) {
+    return std::shared_ptr<ImageFramePool>(new ImageFramePool(keep_count));
+  }
+  ~ImageFramePool();
+
+  ImageFramePool(const ImageFramePool&) = delete;
+  ImageFramePool& operator=(const ImageFramePool&) = delete;
+
+  // Obtains a frame whose pixel buffer may either be reused or created anew.
+  // The pixel data is not initialized.  Rows are aligned to
+  // alignment_boundary as in the equivalent ImageFrame constructor.
+  std::unique_ptr<ImageFrame> GetFrame(
+      ImageFormat::Format format, int width, int height,
+      uint32 alignment_boundary = ImageFrame::kDefaultAlignmentBoundary);
+
+  // Obtains a frame from "pool", or allocates a new one if "pool" is null.
+  static std::unique_ptr<ImageFrame> AllocateFrame(
+      ImageFramePool* pool, ImageFormat::Format format, int width, int height,
+      uint32 alignment_boundary = ImageFrame::kDefaultAlignmentBoundary);
+
+  // Returns the number of free buffers held by the pool.  This method is
+  // meant for testing.
+  int NumAvailableBuffers();
+
+ private:
+  struct FrameSpec {
+    ImageFormat::Format format;
+    int width;
+    int height;
+    uint32 alignment_boundary;
+
+    bool operator==(const FrameSpec& other) const {
+      return format == other.format && width == other.width &&
+             height == other.height &&
+             alignment_boundary == other.alignment_boundary;
+    }
+  };
+
+  struct FrameSpecHash {
+    size_t operator()(const FrameSpec& spec) const;
+  };
+
+  explicit ImageFramePool(int keep_count);
+
+  // Returns a pixel buffer to the pool, or frees it if the pool already holds
+  // keep_count_ buffers of that geometry.
+  void Return(const FrameSpec& spec, uint8* pixel_data);
+
+  const int keep_count_;
+
+  absl::Mutex mutex_;
+  std::unordered_map<FrameSpec, std::vector<uint8*>, FrameSpecHash> available_
+      GUARDED_BY(mutex_);
+};
+
+// Provides an ImageFramePool to every calculator in a graph.  The pool is
+// supplied by the application with CalculatorGraph::SetServiceObject().
+extern const GraphService<ImageFramePool> kImageFramePoolService;
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_FORMATS_IMAGE_FRAME_POOL_H_
@@ -0,0 +1,85 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/image_frame_pool.h"
+
+#include <memory>
+#include <vector>
+
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(ImageFramePoolTest, ReusesReleasedBuffers) {
+  std::shared_ptr<ImageFramePool> pool = ImageFramePool::Create();
+  std::unique_ptr<ImageFrame> frame =
+      pool->GetFrame(ImageFormat::SRGB, 33, 17);
+  EXPECT_EQ(ImageFormat::SRGB, frame->Format());
+  EXPECT_EQ(33, frame->Width());
+  EXPECT_EQ(17, frame->Height());
+  EXPECT_TRUE(frame->IsAligned(ImageFrame::kDefaultAlignmentBoundary));
+  const uint8* pixel_data = frame->PixelData();
+  frame.reset();
+  EXPECT_EQ(1, pool->NumAvailableBuffers());
+
+  frame = pool->GetFrame(ImageFormat::SRGB, 33, 17);
+  EXPECT_EQ(pixel_data, frame->PixelData());
+  EXPECT_EQ(0, pool->NumAvailableBuffers());
+}
+
+TEST(ImageFramePoolTest, DoesNotShareBuffersAcrossGeometries) {
+  std::shared_ptr<ImageFramePool> pool = ImageFramePool::Create();
+  pool->GetFrame(ImageFormat::SRGB, 32, 32).reset();
+  EXPECT_EQ(1, pool->NumAvailableBuffers());
+  std::unique_ptr<ImageFrame> frame =
+      pool->GetFrame(ImageFormat::SRGBA, 32, 32);
+  EXPECT_EQ(1, pool->NumAvailableBuffers());
+  frame = pool->GetFrame(ImageFormat::SRGB, 32, 16);
+  EXPECT_EQ(2, pool->NumAvailableBuffers());
+}
+
+TEST(ImageFramePoolTest, LimitsAvailableBuffers) {
+  std::shared_ptr<ImageFramePool> pool =
+      ImageFramePool::Create(/*keep_count=*/2);
+  std::vector<std::unique_ptr<ImageFrame>> frames;
+  for (int i = 0; i < 3; ++i) {
+    frames.push_back(pool->GetFrame(ImageFormat::GRAY8, 8, 8));
+  }
+  frames.clear();
+  EXPECT_EQ(2, pool->NumAvailableBuffers());
+}
+
+TEST(ImageFramePoolTest, FramesOutliveThePool) {
+  std::shared_ptr<ImageFramePool> pool = ImageFramePool::Create();
+  std::unique_ptr<ImageFrame> frame =
+      pool->GetFrame(ImageFormat::GRAY8, 8, 8);
+  pool.reset();
+  frame->SetToZero();
+  EXPECT_EQ(0, frame->PixelData()[0]);
+  frame.reset();
+}
+
+TEST(ImageFramePoolTest, AllocateFrameWithoutPool) {
+  std::unique_ptr<ImageFrame> frame = ImageFramePool::AllocateFrame(
+      nullptr, ImageFormat::SRGB, 10, 20, /*alignment_boundary=*/1);
+  EXPECT_EQ(10, frame->Width());
+  EXPECT_EQ(20, frame->Height());
+  EXPECT_EQ(30, frame->WidthStep());
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,102 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Registers a PacketSerializer for ImageFrame, which writes the pixel data
+// straight from the frame and creates frames using a received buffer in
+// place, if the pixel data in it is aligned like that of a new ImageFrame.
+
+#include <cstdint>
+#include <memory>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/packet_serializer.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+
+namespace mediapipe {
+namespace {
+
+struct ImageFrameHeader {
+  int32 format;
+  int32 width;
+  int32 height;
+  int32 width_step;
+};
+
+class ImageFrameSerializer : public PacketSerializer {
+ public:
+  ::mediapipe::Status Serialize(const Packet& packet,
+                                SerializedPacket* output) const override {
+    const ImageFrame& frame = packet.Get<ImageFrame>();
+    ImageFrameHeader header;
+    header.format = frame.Format();
+    header.width = frame.Width();
+    header.height = frame.Height();
+    header.width_step = frame.WidthStep();
+    output->AppendValue(header);
+    // The rows are written with their padding, so that the pixel data is a
+    // single range that the receiver can use in place.
+    output->AppendReference(frame.PixelData(), frame.PixelDataSize());
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::StatusOr<Packet> Deserialize(
+      const SerializedPacketView& input) const override {
+    absl::string_view data = input.data;
+    ImageFrameHeader header;
+    RET_CHECK(ConsumeSerializedValue(&data, &header))
+        << "Truncated serialized ImageFrame.";
+    RET_CHECK(ImageFormat::Format_IsValid(header.format) &&
+              header.format != ImageFormat::UNKNOWN && header.width > 0 &&
+              header.height > 0)
+        << "Invalid serialized ImageFrame.";
+    const auto format = static_cast<ImageFormat::Format>(header.format);
+    const int64 row_size = static_cast<int64>(header.width) *
+                           ImageFrame::NumberOfChannelsForFormat(format) *
+                           ImageFrame::ByteDepthForFormat(format);
+    RET_CHECK(header.width_step >= row_size &&
+              data.size() == static_cast<size_t>(header.width_step) *
+                                 header.height)
+        << "Invalid serialized ImageFrame.";
+    uint8* pixel_data =
+        const_cast<uint8*>(reinterpret_cast<const uint8*>(data.data()));
+    if (input.owner &&
+        reinterpret_cast<uintptr_t>(pixel_data) %
+                ImageFrame::kDefaultAlignmentBoundary ==
+            0) {
+      // The frame holds the buffer until it is destroyed.
+      std::shared_ptr<const void> owner = input.owner;
+      return Adopt(new ImageFrame(format, header.width, header.height,
+                                  header.width_step, pixel_data,
+                                  [owner](uint8*) {}));
+    }
+    auto frame = absl::make_unique<ImageFrame>();
+    frame->CopyPixelData(format, header.width, header.height,
+                         header.width_step, pixel_data,
+                         ImageFrame::kDefaultAlignmentBoundary);
+    return Adopt(frame.release());
+  }
+};
+
+}  // namespace
+
+MEDIAPIPE_REGISTER_PACKET_SERIALIZER(::mediapipe::ImageFrame,
+                                     "::mediapipe::ImageFrame",
+                                     ImageFrameSerializer);
+
+}  // namespace mediapipe
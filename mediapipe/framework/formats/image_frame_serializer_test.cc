@@ -0,0 +1,101 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/packet_serializer.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+Packet MakeFramePacket() {
+  auto frame = absl::make_unique<ImageFrame>(ImageFormat::SRGB, 5, 3,
+                                             /*alignment_boundary=*/16);
+  for (int y = 0; y < frame->Height(); ++y) {
+    uint8* row = frame->MutablePixelData() + y * frame->WidthStep();
+    for (int x = 0; x < frame->Width() * frame->NumberOfChannels(); ++x) {
+      row[x] = y * 16 + x;
+    }
+  }
+  return Adopt(frame.release()).At(Timestamp(3));
+}
+
+void ExpectFramesEqual(const ImageFrame& expected, const ImageFrame& actual) {
+  ASSERT_EQ(actual.Format(), expected.Format());
+  ASSERT_EQ(actual.Width(), expected.Width());
+  ASSERT_EQ(actual.Height(), expected.Height());
+  for (int y = 0; y < expected.Height(); ++y) {
+    EXPECT_EQ(memcmp(actual.PixelData() + y * actual.WidthStep(),
+                     expected.PixelData() + y * expected.WidthStep(),
+                     expected.Width() * expected.NumberOfChannels()),
+              0)
+        << "row " << y;
+  }
+}
+
+TEST(ImageFrameSerializerTest, UsesBuffersInPlace) {
+  const Packet packet = MakeFramePacket();
+  const ImageFrame& frame = packet.Get<ImageFrame>();
+  SerializedPacket serialized;
+  MP_ASSERT_OK(SerializePacket(packet, &serialized));
+  EXPECT_EQ(serialized.chunks().back().data(),
+            reinterpret_cast<const char*>(frame.PixelData()));
+
+  auto buffer = std::make_shared<std::string>();
+  serialized.AppendTo(buffer.get());
+  SerializedPacketView view;
+  view.data = *buffer;
+  view.owner = buffer;
+  auto result_or = DeserializePacket(view);
+  MP_ASSERT_OK(result_or.status());
+  const Packet result = result_or.ValueOrDie();
+  EXPECT_EQ(result.Timestamp(), Timestamp(3));
+  const ImageFrame& received = result.Get<ImageFrame>();
+  ExpectFramesEqual(frame, received);
+  EXPECT_EQ(received.PixelData(),
+            reinterpret_cast<const uint8*>(buffer->data()) + buffer->size() -
+                frame.PixelDataSize());
+
+  // The frame keeps the buffer alive.
+  view = SerializedPacketView();
+  buffer.reset();
+  ExpectFramesEqual(frame, received);
+}
+
+TEST(ImageFrameSerializerTest, CopiesBufferWithoutOwner) {
+  const Packet packet = MakeFramePacket();
+  SerializedPacket serialized;
+  MP_ASSERT_OK(SerializePacket(packet, &serialized));
+  std::string buffer;
+  serialized.AppendTo(&buffer);
+  SerializedPacketView view;
+  view.data = buffer;
+  auto result_or = DeserializePacket(view);
+  MP_ASSERT_OK(result_or.status());
+  const ImageFrame& received = result_or.ValueOrDie().Get<ImageFrame>();
+  ExpectFramesEqual(packet.Get<ImageFrame>(), received);
+  EXPECT_NE(reinterpret_cast<const char*>(received.PixelData()),
+            buffer.data() + buffer.size() -
+                packet.Get<ImageFrame>().PixelDataSize());
+}
+
+}  // namespace
+}  // namespace mediapipe
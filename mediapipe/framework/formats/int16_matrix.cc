@@ -0,0 +1,76 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/int16_matrix.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#endif
+
+namespace mediapipe {
+
+namespace {
+
+constexpr float kInt16Scale = 1.0f / (1 << 15);
+
+}  // namespace
+
+void Int16ToFloat(const int16* src, int num_values, float* dst) {
+  int i = 0;
+#if defined(__SSE2__)
+  const __m128 scale = _mm_set1_ps(kInt16Scale);
+  for (; i + 8 <= num_values; i += 8) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    // Sign extend by unpacking into the high halves and shifting back.
+    const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+    _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+    _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+  }
+#elif defined(__ARM_NEON)
+  for (; i + 8 <= num_values; i += 8) {
+    const int16x8_t v = vld1q_s16(src + i);
+    const float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+    const float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+    vst1q_f32(dst + i, vmulq_n_f32(lo, kInt16Scale));
+    vst1q_f32(dst + i + 4, vmulq_n_f32(hi, kInt16Scale));
+  }
+#elif defined(__wasm_simd128__)
+  const v128_t scale = wasm_f32x4_splat(kInt16Scale);
+  for (; i + 8 <= num_values; i += 8) {
+    const v128_t v = wasm_v128_load(src + i);
+    const v128_t lo =
+        wasm_f32x4_convert_i32x4(wasm_i32x4_extend_low_i16x8(v));
+    const v128_t hi =
+        wasm_f32x4_convert_i32x4(wasm_i32x4_extend_high_i16x8(v));
+    wasm_v128_store(dst + i, wasm_f32x4_mul(lo, scale));
+    wasm_v128_store(dst + i + 4, wasm_f32x4_mul(hi, scale));
+  }
+#endif
+  for (; i < num_values; ++i) {
+    dst[i] = src[i] * kInt16Scale;
+  }
+}
+
+void Int16MatrixToMatrix(const Int16Matrix& pcm, Matrix* matrix) {
+  matrix->resize(pcm.rows(), pcm.cols());
+  Int16ToFloat(pcm.data(), pcm.size(), matrix->data());
+}
+
+}  // namespace mediapipe
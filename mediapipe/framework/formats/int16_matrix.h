@@ -0,0 +1,46 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Define mediapipe::Int16Matrix, 16-bit PCM audio laid out like a Matrix.
+//
+// Audio usually arrives as 16-bit samples. Passing them as an Int16Matrix
+// instead of a Matrix halves the memory and bandwidth of the ingest path;
+// the audio calculators that accept one convert to float as they first copy
+// the samples.
+
+#ifndef MEDIAPIPE_FRAMEWORK_FORMATS_INT16_MATRIX_H_
+#define MEDIAPIPE_FRAMEWORK_FORMATS_INT16_MATRIX_H_
+
+#include "Eigen/Core"
+#include "mediapipe/framework/formats/matrix.h"
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+
+// One row per channel and one column per sample, like Matrix. Since the
+// storage is column-major, the samples of the channels are interleaved, as
+// in most PCM sources. A sample value v stands for v / 32768 in a Matrix.
+typedef Eigen::Matrix<int16, Eigen::Dynamic, Eigen::Dynamic> Int16Matrix;
+
+// Writes the num_values samples at "src", scaled to [-1, 1), to "dst". Uses
+// SSE2, NEON or WebAssembly SIMD when available.
+void Int16ToFloat(const int16* src, int num_values, float* dst);
+
+// Resizes "matrix" to the shape of "pcm" and fills it with the scaled
+// samples.
+void Int16MatrixToMatrix(const Int16Matrix& pcm, Matrix* matrix);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_FORMATS_INT16_MATRIX_H_
@@ -0,0 +1,61 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/int16_matrix.h"
+
+#include <vector>
+
+#include "mediapipe/framework/formats/matrix.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(Int16MatrixTest, Int16ToFloatScalesToUnitRange) {
+  // More values than one SIMD step, and a count that leaves a scalar tail.
+  std::vector<int16> src = {0,     1,     -1,   16384, -16384,
+                            32767, -32768, 100, -100,  12345,
+                            -54,   7};
+  std::vector<float> dst(src.size());
+  Int16ToFloat(src.data(), src.size(), dst.data());
+  for (int i = 0; i < src.size(); ++i) {
+    EXPECT_EQ(src[i] / 32768.0f, dst[i]) << "at " << i;
+  }
+  EXPECT_EQ(-1.0f, dst[6]);
+  EXPECT_LT(dst[5], 1.0f);
+}
+
+TEST(Int16MatrixTest, Int16MatrixToMatrixKeepsLayout) {
+  Int16Matrix pcm(2, 9);
+  for (int sample = 0; sample < pcm.cols(); ++sample) {
+    pcm(0, sample) = sample * 1000;
+    pcm(1, sample) = -sample * 3000;
+  }
+  Matrix matrix;
+  Int16MatrixToMatrix(pcm, &matrix);
+  ASSERT_EQ(2, matrix.rows());
+  ASSERT_EQ(9, matrix.cols());
+  EXPECT_EQ((pcm.cast<float>() / 32768.0f).eval(), matrix);
+}
+
+TEST(Int16MatrixTest, Int16MatrixToMatrixHandlesEmpty) {
+  Int16Matrix pcm(3, 0);
+  Matrix matrix(1, 1);
+  Int16MatrixToMatrix(pcm, &matrix);
+  EXPECT_EQ(3, matrix.rows());
+  EXPECT_EQ(0, matrix.cols());
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -61,15 +61,50 @@ Rectangle_i MaskToRectangle(const LocationData& location_data) {
   return Rectangle_i(xmin, ymin, xmax - xmin + 1, ymax - ymin + 1);
 }
 
+// Calls "visitor" with the scanline, left_x and right_x of each interval of
+// the intersection of two rasterizations. Both rasterizations are walked once
+// in step, which requires the intervals of each scanline to be sorted by x
+// and not to overlap.
+template <typename IntervalVisitor>
+void ForEachIntersectionInterval(const Rasterization& rasterization_a,
+                                 const Rasterization& rasterization_b,
+                                 IntervalVisitor visitor) {
+  int a = 0;
+  int b = 0;
+  while (a < rasterization_a.interval_size() &&
+         b < rasterization_b.interval_size()) {
+    const auto& interval_a = rasterization_a.interval(a);
+    const auto& interval_b = rasterization_b.interval(b);
+    if (interval_a.y() != interval_b.y()) {
+      interval_a.y() < interval_b.y() ? ++a : ++b;
+      continue;
+    }
+    const int left_x = std::max(interval_a.left_x(), interval_b.left_x());
+    const int right_x = std::min(interval_a.right_x(), interval_b.right_x());
+    if (left_x <= right_x) {
+      visitor(interval_a.y(), left_x, right_x);
+    }
+    // The interval ending first cannot intersect any later interval of the
+    // other rasterization.
+    interval_a.right_x() < interval_b.right_x() ? ++a : ++b;
+  }
+}
+
 #if LOCATION_OPENCV
+// Sets the pixels of "mat" covered by "rasterization" to "value".
+template <typename T>
+void FillRasterization(const Rasterization& rasterization, T value,
+                       cv::Mat* mat) {
+  for (const auto& interval : rasterization.interval()) {
+    T* row = mat->ptr<T>(interval.y());
+    std::fill(row + interval.left_x(), row + interval.right_x() + 1, value);
+  }
+}
+
 std::unique_ptr<cv::Mat> MaskToMat(const LocationData::BinaryMask& mask) {
   auto image = absl::make_unique<cv::Mat>();
   *image = cv::Mat::zeros(cv::Size(mask.width(), mask.height()), CV_32FC1);
-  for (const auto& interval : mask.rasterization().interval()) {
-    for (int x = interval.left_x(); x <= interval.right_x(); ++x) {
-      image->at<float>(interval.y(), x) = 1.0f;
-    }
-  }
+  FillRasterization(mask.rasterization(), 1.0f, image.get());
   return image;
 }
 ::mediapipe::StatusOr<std::unique_ptr<cv::Mat>> RectangleToMat(
@@ -491,6 +526,23 @@ Location& Location::Crop(const Rectangle_i& crop_box) {
   return *this;
 }
 
+Location& Location::IntersectMask(const Location& other) {
+  CHECK_EQ(LocationData::MASK, location_data_.format());
+  CHECK_EQ(LocationData::MASK, other.location_data_.format());
+  Rasterization intersection;
+  ForEachIntersectionInterval(
+      location_data_.mask().rasterization(),
+      other.location_data_.mask().rasterization(),
+      [&intersection](int y, int left_x, int right_x) {
+        auto* interval = intersection.add_interval();
+        interval->set_y(y);
+        interval->set_left_x(left_x);
+        interval->set_right_x(right_x);
+      });
+  location_data_.mutable_mask()->mutable_rasterization()->Swap(&intersection);
+  return *this;
+}
+
 Location& Location::Crop(const Rectangle_f& crop_box) {
   switch (location_data_.format()) {
     case LocationData::GLOBAL:
@@ -622,12 +674,7 @@ std::unique_ptr<cv::Mat> Location::GetCvMask() const {
   const auto& mask = location_data_.mask();
   std::unique_ptr<cv::Mat> mat(
       new cv::Mat(mask.height(), mask.width(), CV_8UC1, cv::Scalar(0)));
-  for (const auto& interval :
-       location_data_.mask().rasterization().interval()) {
-    for (int x = interval.left_x(); x <= interval.right_x(); ++x) {
-      mat->at<uint8>(interval.y(), x) = 255;
-    }
-  }
+  FillRasterization(mask.rasterization(), static_cast<uint8>(255), mat.get());
   return mat;
 }
 
@@ -661,6 +708,36 @@ std::unique_ptr<cv::Mat> Location::ConvertToCvMask(int image_width,
 }
 #endif
 
+int64 Location::GetMaskArea() const {
+  CHECK_EQ(LocationData::MASK, location_data_.format());
+  int64 area = 0;
+  for (const auto& interval :
+       location_data_.mask().rasterization().interval()) {
+    area += interval.right_x() - interval.left_x() + 1;
+  }
+  return area;
+}
+
+int64 Location::GetMaskIntersectionArea(const Location& other) const {
+  CHECK_EQ(LocationData::MASK, location_data_.format());
+  CHECK_EQ(LocationData::MASK, other.location_data_.format());
+  int64 area = 0;
+  ForEachIntersectionInterval(location_data_.mask().rasterization(),
+                              other.location_data_.mask().rasterization(),
+                              [&area](int y, int left_x, int right_x) {
+                                area += right_x - left_x + 1;
+                              });
+  return area;
+}
+
+float Location::GetMaskIntersectionOverUnion(const Location& other) const {
+  const int64 intersection_area = GetMaskIntersectionArea(other);
+  const int64 union_area =
+      GetMaskArea() + other.GetMaskArea() - intersection_area;
+  return union_area > 0 ? static_cast<float>(intersection_area) / union_area
+                        : 0.0f;
+}
+
 std::vector<Point2_f> Location::GetRelativeKeypoints() const {
   CHECK_EQ(LocationData::RELATIVE_BOUNDING_BOX, location_data_.format());
   std::vector<Point2_f> keypoints;
@@ -27,6 +27,7 @@
 
 #include "mediapipe/framework/formats/location_data.pb.h"
 #include "mediapipe/framework/port.h"
+#include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/point2.h"
 #include "mediapipe/framework/port/rectangle.h"
 
@@ -139,6 +140,12 @@ class Location {
   // fully contained within the specified image. Returns *this.
   Location& Crop(const Rectangle_f& crop_rectangle);
 
+  // Replaces the mask with its intersection with the mask of "other", keeping
+  // the mask dimensions. Both locations must be of type MASK. The intersection
+  // is computed on the rasterizations, without materializing either mask.
+  // Returns *this.
+  Location& IntersectMask(const Location& other);
+
   // ACCESSORS.
   // Non-type converting accessor: returns the requested data only if the output
   // format is consistent with the location data type. E.g. if one requests a
@@ -155,6 +162,18 @@ class Location {
   // foreground ones.
   std::unique_ptr<cv::Mat> GetCvMask() const;
 #endif
+  // Accessors computed directly on the rasterization of a location of type
+  // MASK, without materializing it as an image. The intervals of each
+  // scanline must be sorted by x and must not overlap, as created by
+  // CreateCvMaskLocation(). The bounding box of a mask is returned by
+  // ConvertToBBox().
+  // Returns the number of foreground pixels.
+  int64 GetMaskArea() const;
+  // Returns the number of pixels in the foreground of both masks.
+  int64 GetMaskIntersectionArea(const Location& other) const;
+  // Returns the intersection over union of the foreground of both masks, or 0
+  // if both are empty.
+  float GetMaskIntersectionOverUnion(const Location& other) const;
   // Accessor for relative_keypoints in location data. Relative keypoints are
   // specified with x and y coordinates, where both x and y are relative to the
   // image width and height, respectively, and are in the range [0, 1]. Fails if
@@ -0,0 +1,72 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Registers a PacketSerializer for Matrix, which writes the coefficients
+// straight from the matrix instead of converting them to a MatrixData proto.
+
+#include <cstring>
+#include <memory>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/formats/matrix.h"
+#include "mediapipe/framework/packet_serializer.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+
+namespace mediapipe {
+namespace {
+
+struct MatrixHeader {
+  int32 rows;
+  int32 cols;
+};
+
+class MatrixSerializer : public PacketSerializer {
+ public:
+  ::mediapipe::Status Serialize(const Packet& packet,
+                                SerializedPacket* output) const override {
+    const Matrix& matrix = packet.Get<Matrix>();
+    MatrixHeader header;
+    header.rows = matrix.rows();
+    header.cols = matrix.cols();
+    output->AppendValue(header);
+    // The coefficients, in column-major order.
+    output->AppendReference(matrix.data(), matrix.size() * sizeof(float));
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::StatusOr<Packet> Deserialize(
+      const SerializedPacketView& input) const override {
+    absl::string_view data = input.data;
+    MatrixHeader header;
+    RET_CHECK(ConsumeSerializedValue(&data, &header) && header.rows >= 0 &&
+              header.cols >= 0 &&
+              data.size() == static_cast<size_t>(header.rows) * header.cols *
+                                 sizeof(float))
+        << "Invalid serialized Matrix.";
+    // A Matrix owns its coefficients, so they are copied once.
+    auto matrix = absl::make_unique<Matrix>(header.rows, header.cols);
+    memcpy(matrix->data(), data.data(), data.size());
+    return Adopt(matrix.release());
+  }
+};
+
+}  // namespace
+
+MEDIAPIPE_REGISTER_PACKET_SERIALIZER(::mediapipe::Matrix, "::mediapipe::Matrix",
+                                     MatrixSerializer);
+
+}  // namespace mediapipe
@@ -0,0 +1,58 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "mediapipe/framework/formats/matrix.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/packet_serializer.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(MatrixSerializerTest, RoundTripsMatrix) {
+  Matrix matrix(2, 3);
+  matrix << 1, 2, 3, 4, 5, 6;
+  const Packet packet = MakePacket<Matrix>(matrix).At(Timestamp(9));
+  SerializedPacket serialized;
+  MP_ASSERT_OK(SerializePacket(packet, &serialized));
+  EXPECT_EQ(serialized.chunks().back().data(),
+            reinterpret_cast<const char*>(packet.Get<Matrix>().data()));
+
+  std::string buffer;
+  serialized.AppendTo(&buffer);
+  SerializedPacketView view;
+  view.data = buffer;
+  auto result_or = DeserializePacket(view);
+  MP_ASSERT_OK(result_or.status());
+  EXPECT_EQ(result_or.ValueOrDie().Timestamp(), Timestamp(9));
+  EXPECT_EQ(result_or.ValueOrDie().Get<Matrix>(), matrix);
+}
+
+TEST(MatrixSerializerTest, RejectsSizeMismatch) {
+  const Packet packet = MakePacket<Matrix>(Matrix::Zero(2, 2));
+  SerializedPacket serialized;
+  MP_ASSERT_OK(SerializePacket(packet, &serialized));
+  std::string buffer;
+  serialized.AppendTo(&buffer);
+  buffer.resize(buffer.size() - sizeof(float));
+  SerializedPacketView view;
+  view.data = buffer;
+  EXPECT_FALSE(DeserializePacket(view).ok());
+}
+
+}  // namespace
+}  // namespace mediapipe
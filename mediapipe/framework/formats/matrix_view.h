@@ -0,0 +1,74 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Define mediapipe::MatrixView, a read-only Matrix whose values are stored in
+// a buffer owned by another object, such as a tensor. A MatrixView lets a
+// Matrix be passed between calculators without copying the values out of the
+// buffer they were produced in.
+
+#ifndef MEDIAPIPE_FRAMEWORK_FORMATS_MATRIX_VIEW_H_
+#define MEDIAPIPE_FRAMEWORK_FORMATS_MATRIX_VIEW_H_
+
+#include <memory>
+#include <utility>
+
+#include "Eigen/Core"
+#include "mediapipe/framework/formats/matrix.h"
+
+namespace mediapipe {
+
+class MatrixView {
+ public:
+  typedef Eigen::Map<const Matrix> ConstMap;
+
+  // Creates an empty view.
+  MatrixView() = default;
+
+  // Views the "rows" x "cols" values at "data", stored in column-major order
+  // like a Matrix. The values must stay valid and unchanged for as long as
+  // "owner" is alive; the view shares the ownership of "owner".
+  MatrixView(const float* data, int rows, int cols,
+             std::shared_ptr<const void> owner)
+      : owner_(std::move(owner)), data_(data), rows_(rows), cols_(cols) {}
+
+  // Views the values of "matrix", sharing its ownership.
+  explicit MatrixView(std::shared_ptr<const Matrix> matrix)
+      : data_(matrix->data()),
+        rows_(matrix->rows()),
+        cols_(matrix->cols()) {
+    owner_ = std::move(matrix);
+  }
+
+  int rows() const { return rows_; }
+  int cols() const { return cols_; }
+  const float* data() const { return data_; }
+
+  // Returns an Eigen expression of the viewed values, which can be used
+  // wherever a const Matrix& is accepted through Eigen::Ref or templates, and
+  // assigned to a Matrix to copy the values.
+  ConstMap matrix() const { return ConstMap(data_, rows_, cols_); }
+
+  // Returns a copy of the viewed values.
+  Matrix ToMatrix() const { return matrix(); }
+
+ private:
+  std::shared_ptr<const void> owner_;
+  const float* data_ = nullptr;
+  int rows_ = 0;
+  int cols_ = 0;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_FORMATS_MATRIX_VIEW_H_
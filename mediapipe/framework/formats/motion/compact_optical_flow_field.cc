@@ -0,0 +1,39 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "mediapipe/framework/formats/motion/compact_optical_flow_field.h"
+
+#include "mediapipe/framework/port/logging.h"
+
+namespace mediapipe {
+
+constexpr float CompactOpticalFlowField::kDefaultStepsPerPixel;
+
+CompactOpticalFlowField::CompactOpticalFlowField(const OpticalFlowField& flow,
+                                                 float steps_per_pixel)
+    : steps_per_pixel_(steps_per_pixel) {
+  CHECK_GT(steps_per_pixel, 0.0f);
+  flow.flow_data().convertTo(fixed_point_data_, CV_16SC2, steps_per_pixel);
+}
+
+void CompactOpticalFlowField::ConvertToOpticalFlowField(
+    OpticalFlowField* flow) const {
+  CHECK(flow);
+  flow->Allocate(width(), height());
+  cv::Mat& flow_data = flow->mutable_flow_data();
+  fixed_point_data_.convertTo(flow_data, CV_32FC2, 1.0f / steps_per_pixel_);
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,69 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A dense optical flow field stored as 16-bit fixed-point displacements, which
+// takes half the memory of OpticalFlowField. It is meant for passing flow
+// between calculators and to storage; use ConvertToOpticalFlowField for the
+// analysis functions of OpticalFlowField.
+
+#ifndef MEDIAPIPE_FRAMEWORK_FORMATS_MOTION_COMPACT_OPTICAL_FLOW_FIELD_H_
+#define MEDIAPIPE_FRAMEWORK_FORMATS_MOTION_COMPACT_OPTICAL_FLOW_FIELD_H_
+
+#include "mediapipe/framework/formats/motion/optical_flow_field.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+
+namespace mediapipe {
+
+class CompactOpticalFlowField {
+ public:
+  // The default number of fixed-point steps per pixel. It gives a resolution
+  // of 1/32 pixel and a range of +-1024 pixels.
+  static constexpr float kDefaultStepsPerPixel = 32.0f;
+
+  CompactOpticalFlowField() {}
+  // Converts a float flow field. Displacements are rounded to the nearest
+  // step, and saturate outside of the representable range.
+  explicit CompactOpticalFlowField(
+      const OpticalFlowField& flow,
+      float steps_per_pixel = kDefaultStepsPerPixel);
+
+  CompactOpticalFlowField(const CompactOpticalFlowField&) = delete;
+  CompactOpticalFlowField& operator=(const CompactOpticalFlowField&) = delete;
+
+  int width() const { return fixed_point_data_.cols; }
+  int height() const { return fixed_point_data_.rows; }
+  float steps_per_pixel() const { return steps_per_pixel_; }
+
+  // Returns the raw data, a CV_16SC2 cv::Mat holding dx and dy multiplied by
+  // steps_per_pixel().
+  const cv::Mat& fixed_point_data() const { return fixed_point_data_; }
+
+  // Returns the displacement in pixels at (x, y).
+  cv::Point2f FlowAt(int x, int y) const {
+    const cv::Vec2s& value = fixed_point_data_.at<cv::Vec2s>(y, x);
+    return cv::Point2f(value[0] / steps_per_pixel_,
+                       value[1] / steps_per_pixel_);
+  }
+
+  // Converts to a float flow field, reallocating its storage.
+  void ConvertToOpticalFlowField(OpticalFlowField* flow) const;
+
+ private:
+  cv::Mat fixed_point_data_;
+  float steps_per_pixel_ = kDefaultStepsPerPixel;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_FORMATS_MOTION_COMPACT_OPTICAL_FLOW_FIELD_H_
@@ -0,0 +1,58 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/motion/compact_optical_flow_field.h"
+
+#include "mediapipe/framework/formats/motion/optical_flow_field.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(CompactOpticalFlowField, RoundTripsWithinResolution) {
+  cv::Mat_<cv::Point2f> original_flow(31, 15);
+  for (int r = 0; r < original_flow.rows; ++r) {
+    for (int c = 0; c < original_flow.cols; ++c) {
+      original_flow(r, c) = cv::Point2f(r * c / 7.0, -r * c / 3.0);
+    }
+  }
+  OpticalFlowField flow(original_flow);
+  CompactOpticalFlowField compact(flow);
+  ASSERT_EQ(flow.width(), compact.width());
+  ASSERT_EQ(flow.height(), compact.height());
+
+  OpticalFlowField converted;
+  compact.ConvertToOpticalFlowField(&converted);
+  const float margin = 0.5f / compact.steps_per_pixel() + 1e-6f;
+  EXPECT_TRUE(flow.AllWithinMargin(converted, margin));
+  for (int r = 0; r < original_flow.rows; ++r) {
+    for (int c = 0; c < original_flow.cols; ++c) {
+      EXPECT_EQ(converted.flow_data().at<cv::Point2f>(r, c),
+                compact.FlowAt(c, r));
+    }
+  }
+}
+
+TEST(CompactOpticalFlowField, SaturatesOutOfRangeValues) {
+  cv::Mat_<cv::Point2f> original_flow(1, 2);
+  original_flow(0, 0) = cv::Point2f(5000.0f, -5000.0f);
+  original_flow(0, 1) = cv::Point2f(1.0f, 2.0f);
+  CompactOpticalFlowField compact(OpticalFlowField(original_flow),
+                                  /*steps_per_pixel=*/32.0f);
+  EXPECT_EQ(cv::Point2f(32767 / 32.0f, -32768 / 32.0f), compact.FlowAt(0, 0));
+  EXPECT_EQ(cv::Point2f(1.0f, 2.0f), compact.FlowAt(1, 0));
+}
+
+}  // namespace
+}  // namespace mediapipe
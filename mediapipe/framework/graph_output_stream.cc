@@ -162,5 +162,37 @@ bool OutputStreamPollerImpl::Next(Packet* packet) {
   return true;
 }
 
+bool OutputStreamPollerImpl::NextBatch(std::vector<Packet>* packets,
+                                       int max_count, absl::Duration timeout) {
+  CHECK(packets);
+  CHECK(max_count == -1 || max_count > 0)
+      << "max_count must be either -1 or positive.";
+  packets->clear();
+  bool empty_queue = true;
+  Timestamp min_timestamp = Timestamp::Unset();
+  const absl::Time deadline = absl::Now() + timeout;
+  mutex_.Lock();
+  while (true) {
+    min_timestamp = input_stream_->MinTimestampOrBound(&empty_queue);
+    if (graph_has_error_ || !empty_queue ||
+        min_timestamp == Timestamp::Done()) {
+      break;
+    }
+    if (handler_condvar_.WaitWithDeadline(&mutex_, deadline)) {
+      // Timed out.  Packets may have arrived without a notification.
+      min_timestamp = input_stream_->MinTimestampOrBound(&empty_queue);
+      break;
+    }
+  }
+  const bool graph_has_error = graph_has_error_;
+  mutex_.Unlock();
+  if (empty_queue) {
+    return !graph_has_error && min_timestamp != Timestamp::Done();
+  }
+  bool stream_is_done = false;
+  input_stream_->PopPackets(max_count, packets, &stream_is_done);
+  return true;
+}
+
 }  // namespace internal
 }  // namespace mediapipe
@@ -24,6 +24,7 @@
 #include "absl/base/thread_annotations.h"
 #include "absl/strings/substitute.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "mediapipe/framework/input_stream_handler.h"
 #include "mediapipe/framework/input_stream_manager.h"
 #include "mediapipe/framework/output_stream_manager.h"
@@ -161,6 +162,15 @@ class OutputStreamPollerImpl : public GraphOutputStream {
   // done).  Returns true if successful.
   ABSL_MUST_USE_RESULT bool Next(Packet* packet);
 
+  // Replaces the contents of "packets" with up to "max_count" packets, or all
+  // the available packets if "max_count" is -1, blocking until at least one
+  // packet is available, the stream is done, or "timeout" expires.  Returns
+  // false if the stream is done or the graph has failed and no packets are
+  // left.  Returns true otherwise, in which case "packets" is empty if the
+  // timeout expired.
+  ABSL_MUST_USE_RESULT bool NextBatch(std::vector<Packet>* packets,
+                                      int max_count, absl::Duration timeout);
+
  private:
   absl::Mutex mutex_;
   absl::CondVar handler_condvar_ GUARDED_BY(mutex_);
@@ -18,11 +18,13 @@
 #ifndef MEDIAPIPE_FRAMEWORK_INPUT_STREAM_H_
 #define MEDIAPIPE_FRAMEWORK_INPUT_STREAM_H_
 
+#include <memory>
 #include <string>
 
 #include "absl/base/macros.h"
 #include "mediapipe/framework/packet.h"
 #include "mediapipe/framework/port.h"
+#include "mediapipe/framework/port/statusor.h"
 
 namespace mediapipe {
 
@@ -48,6 +50,23 @@ class InputStream {
   // Syntactic sugar for checking if the input is empty.
   bool IsEmpty() const { return Value().IsEmpty(); }
 
+  // Returns the typed value for the calculator to modify and output in place.
+  // If this stream holds the only reference to the packet data, as it does
+  // when the calculator is the last reader of the upstream output, the data is
+  // taken over without a copy. Otherwise the data is copied. Either way the
+  // input is empty afterwards, but keeps its timestamp. If was_copied is not
+  // nullptr, it is set to indicate whether the data was copied.
+  // Example usage:
+  //   ASSIGN_OR_RETURN(auto detections,
+  //                    cc->Inputs()
+  //                        .Tag("DETECTIONS")
+  //                        .ConsumeOrCopy<std::vector<Detection>>());
+  template <typename T>
+  ::mediapipe::StatusOr<std::unique_ptr<T>> ConsumeOrCopy(
+      bool* was_copied = nullptr) {
+    return Value().ConsumeOrCopy<T>(was_copied);
+  }
+
   // Returns true iff the Inputstream has been closed and there are no remaining
   // Packets queued for processing. (Note that there may currently be a Packet
   // available from the stream inside a Calculator's Process() function.)
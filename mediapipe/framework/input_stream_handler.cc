@@ -42,9 +42,13 @@ InputStreamManager* InputStreamHandler::GetInputStreamManager(
   for (CollectionItemId id = input_stream_managers_.BeginId();
        id < input_stream_managers_.EndId(); ++id) {
     const auto& manager = input_stream_managers_.Get(id);
-    // Invokes InputStreamShard's private method to set name and header.
+    // Invokes InputStreamShard's private methods to set name, header and
+    // packet type, and to clear the shard of a calculator context kept from a
+    // previous run.
+    input_shards->Get(id).Reset();
     input_shards->Get(id).SetName(&manager->Name());
     input_shards->Get(id).SetHeader(manager->Header());
+    input_shards->Get(id).SetPacketType(manager->GetPacketType());
   }
   return ::mediapipe::OkStatus();
 }
@@ -229,7 +233,7 @@ void InputStreamHandler::FinalizeInputSet(Timestamp timestamp,
 }
 
 void InputStreamHandler::AddPackets(CollectionItemId id,
-                                    const std::list<Packet>& packets) {
+                                    const PacketRingBuffer& packets) {
   bool notify = false;
   ::mediapipe::Status result =
       input_stream_managers_.Get(id)->AddPackets(packets, &notify);
@@ -242,7 +246,7 @@ void InputStreamHandler::AddPackets(CollectionItemId id,
 }
 
 void InputStreamHandler::MovePackets(CollectionItemId id,
-                                     std::list<Packet>* packets) {
+                                     PacketRingBuffer* packets) {
   bool notify = false;
   ::mediapipe::Status result =
       input_stream_managers_.Get(id)->MovePackets(packets, &notify);
@@ -17,7 +17,6 @@
 
 #include <atomic>
 #include <functional>
-#include <list>
 #include <memory>
 #include <string>
 #include <utility>
@@ -33,6 +32,7 @@
 #include "mediapipe/framework/input_stream_shard.h"
 #include "mediapipe/framework/mediapipe_options.pb.h"
 #include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/packet_ring_buffer.h"
 #include "mediapipe/framework/packet_set.h"
 #include "mediapipe/framework/packet_type.h"
 #include "mediapipe/framework/port/status.h"
@@ -135,10 +135,10 @@ class InputStreamHandler {
 
   // Add packets into a particular stream.
   virtual void AddPackets(CollectionItemId id,
-                          const std::list<Packet>& packets);
+                          const PacketRingBuffer& packets);
 
   // Moves packets into a particular stream.
-  virtual void MovePackets(CollectionItemId id, std::list<Packet>* packets);
+  virtual void MovePackets(CollectionItemId id, PacketRingBuffer* packets);
 
   // Sets next timestamp bound in a particular stream.
   void SetNextTimestampBound(CollectionItemId id, Timestamp bound);
@@ -14,6 +14,7 @@
 
 #include "mediapipe/framework/input_stream_manager.h"
 
+#include <algorithm>
 #include <type_traits>
 #include <utility>
 
@@ -23,6 +24,7 @@
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/source_location.h"
 #include "mediapipe/framework/port/status_builder.h"
+#include "mediapipe/framework/profiler/payload_size.h"
 #include "mediapipe/framework/tool/status_util.h"
 
 namespace mediapipe {
@@ -47,7 +49,10 @@ void InputStreamManager::SetQueueSizeCallbacks(
 
 void InputStreamManager::PrepareForRun() {
   absl::MutexLock stream_lock(&stream_mutex_);
+  ++min_timestamp_or_bound_version_;
   queue_.clear();
+  queue_size_.store(0, std::memory_order_release);
+  queue_size_high_water_mark_ = 0;
   last_reported_stream_full_ = false;
   num_packets_added_ = 0;
   next_timestamp_bound_ = Timestamp::PreStream();
@@ -56,12 +61,13 @@ void InputStreamManager::PrepareForRun() {
   header_ = Packet();
 }
 
-bool InputStreamManager::IsEmpty() const {
-  absl::MutexLock stream_lock(&stream_mutex_);
-  return queue_.empty();
-}
+bool InputStreamManager::IsEmpty() const { return QueueSize() == 0; }
 
 Packet InputStreamManager::QueueHead() const {
+  // An empty queue is reported without locking the stream.
+  if (IsEmpty()) {
+    return Packet();
+  }
   absl::MutexLock stream_lock(&stream_mutex_);
   if (queue_.empty()) {
     return Packet();
@@ -75,10 +81,16 @@ Packet InputStreamManager::QueueHead() const {
            << "Headers must not have a timestamp.  Stream: \"" << name_
            << "\".";
   }
+  absl::MutexLock stream_lock(&stream_mutex_);
   header_ = header;
   return ::mediapipe::OkStatus();
 }
 
+Packet InputStreamManager::Header() const {
+  absl::MutexLock stream_lock(&stream_mutex_);
+  return header_;
+}
+
 ::mediapipe::Status InputStreamManager::AddPackets(
     const std::list<Packet>& container, bool* notify) {
   return AddOrMovePacketsInternal<const std::list<Packet>&>(container, notify);
@@ -89,6 +101,16 @@ Packet InputStreamManager::QueueHead() const {
   return AddOrMovePacketsInternal<std::list<Packet>&>(*container, notify);
 }
 
+::mediapipe::Status InputStreamManager::AddPackets(
+    const PacketRingBuffer& container, bool* notify) {
+  return AddOrMovePacketsInternal<const PacketRingBuffer&>(container, notify);
+}
+
+::mediapipe::Status InputStreamManager::MovePackets(
+    PacketRingBuffer* container, bool* notify) {
+  return AddOrMovePacketsInternal<PacketRingBuffer&>(*container, notify);
+}
+
 template <typename Container>
 ::mediapipe::Status InputStreamManager::AddOrMovePacketsInternal(
     Container container, bool* notify) {
@@ -106,6 +128,9 @@ template <typename Container>
         (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
     // Check if the queue becomes non-empty.
     queue_became_non_empty = queue_.empty() && !container.empty();
+    if (queue_became_non_empty) {
+      ++min_timestamp_or_bound_version_;
+    }
     for (auto& packet : container) {
       ::mediapipe::Status result = packet_type_->Validate(packet);
       if (!result.ok()) {
@@ -160,9 +185,12 @@ template <typename Container>
       } else {
         queue_.emplace_back(std::move(packet));
       }
+      PublishQueueSize();
     }
     queue_became_full = (!was_queue_full && max_queue_size_ != -1 &&
                          queue_.size() >= max_queue_size_);
+    queue_size_high_water_mark_ = std::max(queue_size_high_water_mark_,
+                                           static_cast<int>(queue_.size()));
     VLOG_IF(2, queue_.size() > 1)
         << "Queue size greater than 1: stream name: " << name_
         << " queue_size: " << queue_.size();
@@ -205,6 +233,7 @@ template <typename Container>
       if (queue_.empty()) {
         // If the queue was not empty then a change to the next_timestamp_bound_
         // is not detectable by the consumer.
+        ++min_timestamp_or_bound_version_;
         *notify = true;
       }
     }
@@ -219,6 +248,7 @@ void InputStreamManager::Close() {
   if (closed_) {
     return;
   }
+  ++min_timestamp_or_bound_version_;
   next_timestamp_bound_ = Timestamp::Done();
   last_select_timestamp_ = Timestamp::Done();
   closed_ = true;
@@ -245,6 +275,7 @@ Packet InputStreamManager::PopPacketAtTimestamp(Timestamp timestamp,
     // Make sure timestamp didn't decrease from last time.
     CHECK_LE(last_select_timestamp_, timestamp);
     last_select_timestamp_ = timestamp;
+    ++min_timestamp_or_bound_version_;
 
     // Make sure AddPacket and SetNextTimestampBound are not called with
     // timestamps we have already passed.
@@ -269,6 +300,7 @@ Packet InputStreamManager::PopPacketAtTimestamp(Timestamp timestamp,
       current_timestamp = packet.Timestamp();
       ++(*num_packets_dropped);
     }
+    PublishQueueSize();
     // Clear value_ if it doesn't have exactly the right timestamp.
     if (current_timestamp != timestamp) {
       packet = Packet();
@@ -296,6 +328,7 @@ Packet InputStreamManager::PopQueueHead(bool* stream_is_done) {
     absl::MutexLock stream_lock(&stream_mutex_);
 
     VLOG(2) << "Input stream " << name_ << " selecting at queue head";
+    ++min_timestamp_or_bound_version_;
 
     // Check if queue is full.
     bool was_queue_full =
@@ -304,6 +337,7 @@ Packet InputStreamManager::PopQueueHead(bool* stream_is_done) {
     if (!queue_.empty()) {
       packet = std::move(queue_.front());
       queue_.pop_front();
+      PublishQueueSize();
     } else {
       packet = Packet();
     }
@@ -320,14 +354,62 @@ Packet InputStreamManager::PopQueueHead(bool* stream_is_done) {
   return packet;
 }
 
+int InputStreamManager::PopPackets(int max_count, std::vector<Packet>* packets,
+                                   bool* stream_is_done) {
+  CHECK(packets);
+  *stream_is_done = false;
+  bool queue_became_non_full = false;
+  int num_popped = 0;
+  {
+    absl::MutexLock stream_lock(&stream_mutex_);
+    ++min_timestamp_or_bound_version_;
+    bool was_queue_full =
+        (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
+    while (!queue_.empty() && (max_count == -1 || num_popped < max_count)) {
+      packets->push_back(std::move(queue_.front()));
+      queue_.pop_front();
+      ++num_popped;
+    }
+    PublishQueueSize();
+    if (num_popped > 0 && enable_timestamps_) {
+      const Timestamp timestamp = packets->back().Timestamp();
+      last_select_timestamp_ = timestamp;
+      if (next_timestamp_bound_ <= timestamp) {
+        next_timestamp_bound_ = timestamp.NextAllowedInStream();
+      }
+    }
+    VLOG(2) << "Input stream removed " << num_popped << " packets:" << name_
+            << " Size:" << queue_.size();
+    queue_became_non_full = (was_queue_full && queue_.size() < max_queue_size_);
+    *stream_is_done = IsDone();
+  }
+  if (queue_became_non_full) {
+    VLOG(2) << "Queue became non-full: " << Name();
+    becomes_not_full_callback_(this, &last_reported_stream_full_);
+  }
+  return num_popped;
+}
+
 int InputStreamManager::QueueSize() const {
+  return queue_size_.load(std::memory_order_acquire);
+}
+
+int InputStreamManager::QueueSizeHighWaterMark() const {
   absl::MutexLock lock(&stream_mutex_);
-  return static_cast<int>(queue_.size());
+  return queue_size_high_water_mark_;
 }
 
-int InputStreamManager::MaxQueueSize() const {
+int64 InputStreamManager::QueuePayloadBytes() const {
   absl::MutexLock lock(&stream_mutex_);
-  return max_queue_size_;
+  int64 bytes = 0;
+  for (const Packet& packet : queue_) {
+    bytes += PayloadBytes(packet);
+  }
+  return bytes;
+}
+
+int InputStreamManager::MaxQueueSize() const {
+  return max_queue_size_.load(std::memory_order_acquire);
 }
 
 void InputStreamManager::SetMaxQueueSize(int max_queue_size) {
@@ -336,7 +418,10 @@ void InputStreamManager::SetMaxQueueSize(int max_queue_size) {
   {
     absl::MutexLock lock(&stream_mutex_);
     was_full = (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
-    max_queue_size_ = max_queue_size;
+    max_queue_size_.store(max_queue_size, std::memory_order_release);
+    if (max_queue_size_ > 0) {
+      queue_.reserve(max_queue_size_);
+    }
     is_full = (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
   }
 
@@ -351,8 +436,8 @@ void InputStreamManager::SetMaxQueueSize(int max_queue_size) {
 }
 
 bool InputStreamManager::IsFull() const {
-  absl::MutexLock lock(&stream_mutex_);
-  return max_queue_size_ != -1 && queue_.size() >= max_queue_size_;
+  int max_queue_size = MaxQueueSize();
+  return max_queue_size != -1 && QueueSize() >= max_queue_size;
 }
 
 Timestamp InputStreamManager::GetMinTimestampAmongNLatest(int n) const {
@@ -363,17 +448,21 @@ Timestamp InputStreamManager::GetMinTimestampAmongNLatest(int n) const {
   return (queue_.cend() - std::min((size_t)n, queue_.size()))->Timestamp();
 }
 
-void InputStreamManager::ErasePacketsEarlierThan(Timestamp timestamp) {
+int InputStreamManager::ErasePacketsEarlierThan(Timestamp timestamp) {
   bool queue_became_non_full = false;
+  int num_erased = 0;
   {
     absl::MutexLock lock(&stream_mutex_);
+    ++min_timestamp_or_bound_version_;
     // Checks if queue is full.
     bool was_queue_full =
         (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
 
     while (!queue_.empty() && queue_.front().Timestamp() < timestamp) {
       queue_.pop_front();
+      ++num_erased;
     }
+    PublishQueueSize();
 
     VLOG(2) << "Input stream removed packets:" << name_
             << " Size:" << queue_.size();
@@ -383,6 +472,7 @@ void InputStreamManager::ErasePacketsEarlierThan(Timestamp timestamp) {
     VLOG(2) << "Queue became non-full: " << Name();
     becomes_not_full_callback_(this, &last_reported_stream_full_);
   }
+  return num_erased;
 }
 
 bool InputStreamManager::IsDone() const {
@@ -15,14 +15,16 @@
 #ifndef MEDIAPIPE_FRAMEWORK_INPUT_STREAM_MANAGER_H_
 #define MEDIAPIPE_FRAMEWORK_INPUT_STREAM_MANAGER_H_
 
-#include <deque>
+#include <atomic>
 #include <functional>
 #include <list>
 #include <string>
+#include <vector>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/packet_ring_buffer.h"
 #include "mediapipe/framework/packet_type.h"
 #include "mediapipe/framework/port.h"
 #include "mediapipe/framework/port/integral_types.h"
@@ -66,10 +68,16 @@ class InputStreamManager {
   // Returns true if the input stream is a back edge.
   bool BackEdge() const { return back_edge_; }
 
+  // Returns the type every packet added to the stream is validated against.
+  const PacketType* GetPacketType() const { return packet_type_; }
+
   // Sets the header Packet.
-  ::mediapipe::Status SetHeader(const Packet& header);
+  ::mediapipe::Status SetHeader(const Packet& header)
+      LOCKS_EXCLUDED(stream_mutex_);
 
-  const Packet& Header() const { return header_; }
+  // Returns the header Packet. The header may be set concurrently by the
+  // upstream node's Open() when the graph sets concurrent_open.
+  Packet Header() const LOCKS_EXCLUDED(stream_mutex_);
 
   // Reset the input stream for another run of the graph (i.e. another
   // image/video/audio).
@@ -95,6 +103,13 @@ class InputStreamManager {
   // move, all packets in the container must be empty.
   ::mediapipe::Status MovePackets(std::list<Packet>* container, bool* notify);
 
+  // Same as above, for the packet queue of an OutputStreamShard.  These
+  // overloads are used on the packet propagation path and do not allocate
+  // per packet.
+  ::mediapipe::Status AddPackets(const PacketRingBuffer& container,
+                                 bool* notify);
+  ::mediapipe::Status MovePackets(PacketRingBuffer* container, bool* notify);
+
   // Closes the input stream.  This function can be called multiple times.
   void Close() LOCKS_EXCLUDED(stream_mutex_);
 
@@ -113,11 +128,19 @@ class InputStreamManager {
   Timestamp MinTimestampOrBound(bool* is_empty) const
       LOCKS_EXCLUDED(stream_mutex_);
 
+  // Returns a counter that changes whenever the result of
+  // MinTimestampOrBound() may have changed. An input stream handler can cache
+  // that result together with the counter read before it, and reuse it
+  // without locking the stream while the counter is unchanged.
+  int64 MinTimestampOrBoundVersion() const {
+    return min_timestamp_or_bound_version_.load(std::memory_order_acquire);
+  }
+
   // Turns off the use of packet timestamps.
   void DisableTimestamps();
 
-  // Returns true iff the queue is empty.
-  bool IsEmpty() const LOCKS_EXCLUDED(stream_mutex_);
+  // Returns true iff the queue is empty.  Does not lock the stream.
+  bool IsEmpty() const;
 
   // If the queue is not empty, returns the packet at the front of the queue.
   // Otherwise, returns an empty packet.
@@ -141,18 +164,37 @@ class InputStreamManager {
   // Timestamp::Done() after the pop.
   Packet PopQueueHead(bool* stream_is_done) LOCKS_EXCLUDED(stream_mutex_);
 
-  // Returns the number of packets in the queue.
-  int QueueSize() const LOCKS_EXCLUDED(stream_mutex_);
+  // Pops up to "max_count" packets from the head of the queue, or all of them
+  // if "max_count" is -1, and appends them to "packets", holding the stream
+  // lock only once.  Time advances to the timestamp of the last packet popped,
+  // as with PopPacketAtTimestamp().  Returns the number of packets popped.
+  // Sets "stream_is_done" if the next timestamp bound reaches
+  // Timestamp::Done() after the pop.
+  int PopPackets(int max_count, std::vector<Packet>* packets,
+                 bool* stream_is_done) LOCKS_EXCLUDED(stream_mutex_);
 
-  // Returns true iff the queue is full.
-  bool IsFull() const LOCKS_EXCLUDED(stream_mutex_);
+  // Returns the number of packets in the queue.  Does not lock the stream, so
+  // that the scheduler and the stream handlers can poll the queue size
+  // without contending with the producer and the consumer of the stream.
+  int QueueSize() const;
+
+  // Returns the largest number of packets in the queue during this run.
+  int QueueSizeHighWaterMark() const LOCKS_EXCLUDED(stream_mutex_);
+
+  // Returns the approximate bytes held by the payloads of the packets in the
+  // queue. See PayloadBytes().
+  int64 QueuePayloadBytes() const LOCKS_EXCLUDED(stream_mutex_);
+
+  // Returns true iff the queue is full.  Does not lock the stream.
+  bool IsFull() const;
 
   // Returns the max queue size. -1 indicates that there is no maximum.
-  int MaxQueueSize() const LOCKS_EXCLUDED(stream_mutex_);
+  int MaxQueueSize() const;
 
   // Sets the maximum queue size for the stream. Used to determine when the
   // callbacks for becomes_full and becomes_not_full should be invoked. A value
-  // of -1 means that there is no maximum queue size.
+  // of -1 means that there is no maximum queue size.  The packet queue
+  // reserves room for max_queue_size packets.
   void SetMaxQueueSize(int max_queue_size) LOCKS_EXCLUDED(stream_mutex_);
 
   // If there are equal to or more than n packets in the queue, this function
@@ -163,9 +205,10 @@ class InputStreamManager {
   Timestamp GetMinTimestampAmongNLatest(int n) const
       LOCKS_EXCLUDED(stream_mutex_);
 
-  // pop_front()s packets that are earlier than the given timestamp.
+  // pop_front()s packets that are earlier than the given timestamp, and
+  // returns the number of packets erased.
   // NOTE: This is a public API intended for FixedSizeInputStreamHandler only.
-  void ErasePacketsEarlierThan(Timestamp timestamp)
+  int ErasePacketsEarlierThan(Timestamp timestamp)
       LOCKS_EXCLUDED(stream_mutex_);
 
   // If a maximum queue size is specified (!= -1), these callbacks that are
@@ -189,8 +232,16 @@ class InputStreamManager {
   // Returns true if the next timestamp bound reaches Timestamp::Done().
   bool IsDone() const EXCLUSIVE_LOCKS_REQUIRED(stream_mutex_);
 
+  // Publishes the size of queue_ to the readers of QueueSize().
+  void PublishQueueSize() EXCLUSIVE_LOCKS_REQUIRED(stream_mutex_) {
+    queue_size_.store(static_cast<int>(queue_.size()),
+                      std::memory_order_release);
+  }
+
   mutable absl::Mutex stream_mutex_;
-  std::deque<Packet> queue_ GUARDED_BY(stream_mutex_);
+  PacketRingBuffer queue_ GUARDED_BY(stream_mutex_);
+  // The size of queue_, written under stream_mutex_ and read without it.
+  std::atomic<int> queue_size_{0};
   // The number of packets added to queue_.  Used to verify a packet at
   // Timestamp::PostStream() is the only Packet in the stream.
   int64 num_packets_added_ GUARDED_BY(stream_mutex_);
@@ -199,16 +250,23 @@ class InputStreamManager {
   // Ignored if enable_timestamps_ is false.
   Timestamp last_select_timestamp_ GUARDED_BY(stream_mutex_);
   bool closed_ GUARDED_BY(stream_mutex_);
+  // Incremented under stream_mutex_ by every change to the queue head, the
+  // queue emptiness, or the next timestamp bound of an empty queue.
+  std::atomic<int64> min_timestamp_or_bound_version_{0};
   // True if packet timestamps are used.
   bool enable_timestamps_ = true;
   std::string name_;
   const PacketType* packet_type_;
   bool back_edge_;
   // The header packet of the input stream.
-  Packet header_;
+  Packet header_ GUARDED_BY(stream_mutex_);
+
+  // The maximum queue size for this stream if set.  Written under
+  // stream_mutex_ and read without it by MaxQueueSize() and IsFull().
+  std::atomic<int> max_queue_size_{-1};
 
-  // The maximum queue size for this stream if set.
-  int max_queue_size_ GUARDED_BY(stream_mutex_) = -1;
+  // The largest size of queue_ since PrepareForRun().
+  int queue_size_high_water_mark_ GUARDED_BY(stream_mutex_) = 0;
 
   // Callback to notify the framework that we have hit the maximum queue size.
   QueueSizeCallback becomes_full_callback_;
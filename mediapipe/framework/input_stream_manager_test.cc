@@ -15,11 +15,15 @@
 #include "mediapipe/framework/input_stream_manager.h"
 
 #include <memory>
+#include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "mediapipe/framework/input_stream_shard.h"
 #include "mediapipe/framework/lifetime_tracker.h"
 #include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/packet_ring_buffer.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/status_matchers.h"
@@ -125,6 +129,32 @@ TEST_F(InputStreamManagerTest, MovePackets) {
   }
 }
 
+TEST_F(InputStreamManagerTest, MovePacketsFromRingBuffer) {
+  PacketRingBuffer packets;
+  packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
+  packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
+  EXPECT_TRUE(input_stream_manager_->IsEmpty());
+
+  MP_ASSERT_OK(
+      input_stream_manager_->MovePackets(&packets, &notify_));  // Notification
+  EXPECT_TRUE(notify_);
+  EXPECT_EQ(2, input_stream_manager_->QueueSize());
+  for (const Packet& orignial_packet : packets) {
+    EXPECT_TRUE(orignial_packet.IsEmpty());
+  }
+
+  packets.clear();
+  packets.push_back(MakePacket<std::string>("packet 3").At(Timestamp(30)));
+  MP_ASSERT_OK(input_stream_manager_->AddPackets(packets, &notify_));
+  EXPECT_FALSE(notify_);
+  EXPECT_FALSE(packets.front().IsEmpty());
+  EXPECT_EQ(3, input_stream_manager_->QueueSize());
+  EXPECT_EQ(Timestamp(10),
+            input_stream_manager_->GetMinTimestampAmongNLatest(5));
+  EXPECT_EQ(Timestamp(20),
+            input_stream_manager_->GetMinTimestampAmongNLatest(2));
+}
+
 // InputStreamManager should reject the four timestamps that are not allowed in
 // a stream: Timestamp::Unset(), Timestamp::Unstarted(),
 // Timestamp::OneOverPostStream(), and Timestamp::Done().
@@ -393,6 +423,33 @@ TEST_F(InputStreamManagerTest, PopQueueHead) {
   EXPECT_TRUE(stream_is_done_);
 }
 
+TEST_F(InputStreamManagerTest, PopPackets) {
+  std::list<Packet> packets;
+  for (int i = 1; i <= 3; ++i) {
+    packets.push_back(MakePacket<std::string>(absl::StrCat("packet ", i))
+                          .At(Timestamp(i * 10)));
+  }
+  MP_ASSERT_OK(input_stream_manager_->AddPackets(packets, &notify_));
+  EXPECT_TRUE(notify_);
+
+  std::vector<Packet> popped_packets;
+  EXPECT_EQ(2, input_stream_manager_->PopPackets(2, &popped_packets,
+                                                 &stream_is_done_));
+  EXPECT_FALSE(stream_is_done_);
+  ASSERT_EQ(2, popped_packets.size());
+  EXPECT_EQ(Timestamp(10), popped_packets[0].Timestamp());
+  EXPECT_EQ(Timestamp(20), popped_packets[1].Timestamp());
+  EXPECT_EQ(1, input_stream_manager_->QueueSize());
+
+  input_stream_manager_->Close();
+  EXPECT_EQ(1, input_stream_manager_->PopPackets(-1, &popped_packets,
+                                                 &stream_is_done_));
+  EXPECT_TRUE(stream_is_done_);
+  ASSERT_EQ(3, popped_packets.size());
+  EXPECT_EQ("packet 3", popped_packets[2].Get<std::string>());
+  EXPECT_TRUE(input_stream_manager_->IsEmpty());
+}
+
 TEST_F(InputStreamManagerTest, BadPacketType) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<int>(10).At(Timestamp(10)));
@@ -746,6 +803,46 @@ TEST_F(InputStreamManagerTest, TimestampBound) {
             input_stream_manager_->MinTimestampOrBound(&is_empty));
 }
 
+TEST_F(InputStreamManagerTest, MinTimestampOrBoundVersion) {
+  int64 version = input_stream_manager_->MinTimestampOrBoundVersion();
+
+  // Adding packets to an empty queue changes its head.
+  std::list<Packet> packets;
+  packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
+  MP_ASSERT_OK(input_stream_manager_->AddPackets(packets, &notify_));
+  EXPECT_NE(version, input_stream_manager_->MinTimestampOrBoundVersion());
+  version = input_stream_manager_->MinTimestampOrBoundVersion();
+
+  // Adding packets behind the head, or advancing the bound of a non-empty
+  // queue, does not change MinTimestampOrBound().
+  packets.clear();
+  packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
+  MP_ASSERT_OK(input_stream_manager_->AddPackets(packets, &notify_));
+  MP_ASSERT_OK(
+      input_stream_manager_->SetNextTimestampBound(Timestamp(30), &notify_));
+  EXPECT_EQ(version, input_stream_manager_->MinTimestampOrBoundVersion());
+  EXPECT_EQ(Timestamp(10), input_stream_manager_->MinTimestampOrBound(nullptr));
+
+  // Popping changes the head.
+  popped_packet_ = input_stream_manager_->PopPacketAtTimestamp(
+      Timestamp(10), &num_packets_dropped_, &stream_is_done_);
+  EXPECT_NE(version, input_stream_manager_->MinTimestampOrBoundVersion());
+  version = input_stream_manager_->MinTimestampOrBoundVersion();
+  popped_packet_ = input_stream_manager_->PopPacketAtTimestamp(
+      Timestamp(20), &num_packets_dropped_, &stream_is_done_);
+  EXPECT_NE(version, input_stream_manager_->MinTimestampOrBoundVersion());
+  version = input_stream_manager_->MinTimestampOrBoundVersion();
+
+  // Advancing the bound of an empty queue changes it.
+  MP_ASSERT_OK(
+      input_stream_manager_->SetNextTimestampBound(Timestamp(40), &notify_));
+  EXPECT_NE(version, input_stream_manager_->MinTimestampOrBoundVersion());
+  version = input_stream_manager_->MinTimestampOrBoundVersion();
+
+  input_stream_manager_->Close();
+  EXPECT_NE(version, input_stream_manager_->MinTimestampOrBoundVersion());
+}
+
 TEST_F(InputStreamManagerTest, QueueSizeTest) {
   std::list<Packet> packets;
   int max_queue_size = 2;
@@ -922,5 +1019,34 @@ TEST_F(InputStreamManagerTest, BackwardsInTimeUntimed) {
   EXPECT_TRUE(notify_);
 }
 
+// Adds batches of state.range(0) packets to a stream and pops them again, so
+// that the queue stays small.
+void BM_AddPackets(benchmark::State& state) {
+  PacketType packet_type;
+  packet_type.Set<int>();
+  InputStreamManager input_stream_manager;
+  MEDIAPIPE_CHECK_OK(input_stream_manager.Initialize("a_test", &packet_type,
+                                                     /*back_edge=*/false));
+  input_stream_manager.PrepareForRun();
+  Packet packet = MakePacket<int>(1);
+  PacketRingBuffer packets;
+  int64 timestamp = 0;
+  bool notify;
+  bool stream_is_done;
+  for (auto _ : state) {
+    packets.clear();
+    for (int i = 0; i < state.range(0); ++i) {
+      packets.push_back(packet.At(Timestamp(timestamp++)));
+    }
+    MEDIAPIPE_CHECK_OK(input_stream_manager.AddPackets(packets, &notify));
+    for (int i = 0; i < state.range(0); ++i) {
+      benchmark::DoNotOptimize(
+          input_stream_manager.PopQueueHead(&stream_is_done));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_AddPackets)->Arg(1)->Arg(16);
+
 }  // namespace
 }  // namespace mediapipe
@@ -24,6 +24,10 @@
 
 namespace mediapipe {
 
+class PacketType;
+template <typename T>
+class TypedInputStream;
+
 // For testing
 class MediaPipeProfilerTestPeer;
 
@@ -69,6 +73,17 @@ class InputStreamShard : public InputStream {
 
   void SetHeader(const Packet& header) { header_ = header; }
 
+  void SetPacketType(const PacketType* packet_type) {
+    packet_type_ = packet_type;
+  }
+
+  // Removes the packets and clears the done state, so that the shard can be
+  // reused in another graph run.
+  void Reset() {
+    packet_queue_ = std::queue<Packet>();
+    is_done_ = false;
+  }
+
   void AddPacket(Packet&& value, bool is_done);
 
   // Packet storage for batch processing.
@@ -78,9 +93,14 @@ class InputStreamShard : public InputStream {
   // Pointer to the name std::string of the InputStreamManager.
   const std::string* name_;
   bool is_done_;
+  // The type the packets were validated against by the InputStreamManager.
+  const PacketType* packet_type_ = nullptr;
 
   // Accesses InputStreamShard for setting data.
   friend class InputStreamHandler;
+  // Accesses the packet type.
+  template <typename T>
+  friend class TypedInputStream;
 };
 
 }  // namespace mediapipe
@@ -16,6 +16,7 @@
 #define MEDIAPIPE_FRAMEWORK_OUTPUT_STREAM_HANDLER_H_
 
 #include <functional>
+#include <limits>
 #include <memory>
 #include <set>
 #include <string>
@@ -111,6 +112,10 @@ class OutputStreamHandler {
   // Invoked after a call to Calculator::Process() function.
   void PostProcess(Timestamp input_timestamp) LOCKS_EXCLUDED(timestamp_mutex_);
 
+  // Returns how many more invocations the node may start, in addition to the
+  // limit set by its max_in_flight. By default there is no other limit.
+  virtual int MaxNewInvocations() { return std::numeric_limits<int>::max(); }
+
   // Propagates the output shards and closes all managed output streams.
   void Close(OutputStreamShardSet* output_shards);
 
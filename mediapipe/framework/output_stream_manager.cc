@@ -159,20 +159,27 @@ Timestamp OutputStreamManager::ComputeOutputTimestampBound(
 void OutputStreamManager::PropagateUpdatesToMirrors(
     Timestamp next_timestamp_bound, OutputStreamShard* output_stream_shard) {
   CHECK(output_stream_shard);
+  Timestamp previous_bound;
   {
     absl::MutexLock lock(&stream_mutex_);
+    previous_bound = next_timestamp_bound_;
     next_timestamp_bound_ = next_timestamp_bound;
   }
-  std::list<Packet>* packets_to_propagate = output_stream_shard->OutputQueue();
+  PacketRingBuffer* packets_to_propagate = output_stream_shard->OutputQueue();
   VLOG(2) << "Output stream: " << Name()
           << " queue size: " << packets_to_propagate->size();
   VLOG(2) << "Output stream: " << Name()
           << " next timestamp: " << next_timestamp_bound;
   bool add_packets = !packets_to_propagate->empty();
+  // The mirrors already hold the previous bound, so a bound that did not move
+  // is not sent again. This keeps calculators that produce no output for an
+  // input, and repeated offset propagation of the same bound, from locking
+  // every downstream input stream.
   bool set_bound =
-      !add_packets ||
-      packets_to_propagate->back().Timestamp().NextAllowedInStream() !=
-          next_timestamp_bound;
+      add_packets
+          ? packets_to_propagate->back().Timestamp().NextAllowedInStream() !=
+                next_timestamp_bound
+          : next_timestamp_bound != previous_bound;
   int mirror_count = mirrors_.size();
   for (int idx = 0; idx < mirror_count; ++idx) {
     const Mirror& mirror = mirrors_[idx];
@@ -92,7 +92,7 @@ const Packet& OutputStreamShard::Header() const {
 // binary.  This function can be defined in the .cc file because only two
 // versions are ever instantiated, and all call sites are within this .cc file.
 template <typename T>
-Status OutputStreamShard::AddPacketInternal(T&& packet) {
+Status OutputStreamShard::AddPacketInternal(T&& packet, bool check_type) {
   if (IsClosed()) {
     return ::mediapipe::FailedPreconditionErrorBuilder(MEDIAPIPE_LOC)
            << "Packet sent to closed stream \"" << Name() << "\".";
@@ -111,11 +111,13 @@ Status OutputStreamShard::AddPacketInternal(T&& packet) {
            << timestamp.DebugString();
   }
 
-  Status result = output_stream_spec_->packet_type->Validate(packet);
-  if (!result.ok()) {
-    return StatusBuilder(result, MEDIAPIPE_LOC).SetPrepend() << absl::StrCat(
-               "Packet type mismatch on calculator outputting to stream \"",
-               Name(), "\": ");
+  if (check_type) {
+    Status result = output_stream_spec_->packet_type->Validate(packet);
+    if (!result.ok()) {
+      return StatusBuilder(result, MEDIAPIPE_LOC).SetPrepend() << absl::StrCat(
+                 "Packet type mismatch on calculator outputting to stream \"",
+                 Name(), "\": ");
+    }
   }
 
   // Adds the packet to output_queue_ if it's a const lvalue reference.
@@ -129,14 +131,21 @@ Status OutputStreamShard::AddPacketInternal(T&& packet) {
 }
 
 void OutputStreamShard::AddPacket(const Packet& packet) {
-  Status status = AddPacketInternal(packet);
+  Status status = AddPacketInternal(packet, /*check_type=*/true);
   if (!status.ok()) {
     output_stream_spec_->TriggerErrorCallback(status);
   }
 }
 
 void OutputStreamShard::AddPacket(Packet&& packet) {
-  Status status = AddPacketInternal(std::move(packet));
+  Status status = AddPacketInternal(std::move(packet), /*check_type=*/true);
+  if (!status.ok()) {
+    output_stream_spec_->TriggerErrorCallback(status);
+  }
+}
+
+void OutputStreamShard::AddPacketOfCheckedType(Packet&& packet) {
+  Status status = AddPacketInternal(std::move(packet), /*check_type=*/false);
   if (!status.ok()) {
     output_stream_spec_->TriggerErrorCallback(status);
   }
@@ -15,11 +15,11 @@
 #ifndef MEDIAPIPE_FRAMEWORK_OUTPUT_STREAM_SHARD_H_
 #define MEDIAPIPE_FRAMEWORK_OUTPUT_STREAM_SHARD_H_
 
-#include <list>
 #include <string>
 
 #include "mediapipe/framework/output_stream.h"
 #include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/packet_ring_buffer.h"
 #include "mediapipe/framework/packet_type.h"
 #include "mediapipe/framework/port.h"
 #include "mediapipe/framework/timestamp.h"
@@ -27,6 +27,8 @@
 namespace mediapipe {
 
 class OutputStreamManager;
+template <typename T>
+class TypedOutputStream;
 
 // The output stream spec shared across all output stream shards and their
 // output stream manager.
@@ -102,11 +104,15 @@ class OutputStreamShard : public OutputStream {
   // AddPacketInternal template is called by either AddPacket(Packet&& packet)
   // or AddPacket(const Packet& packet).
   template <typename T>
-  ::mediapipe::Status AddPacketInternal(T&& packet);
+  ::mediapipe::Status AddPacketInternal(T&& packet, bool check_type);
+
+  // Adds a packet that is known to match the packet type of the stream,
+  // skipping the type validation.
+  void AddPacketOfCheckedType(Packet&& packet);
 
   // Returns a pointer to the output queue.
-  std::list<Packet>* OutputQueue() { return &output_queue_; }
-  const std::list<Packet>* OutputQueue() const { return &output_queue_; }
+  PacketRingBuffer* OutputQueue() { return &output_queue_; }
+  const PacketRingBuffer* OutputQueue() const { return &output_queue_; }
 
   // Resets data members.
   void Reset(Timestamp next_timestamp_bound, bool close);
@@ -114,7 +120,9 @@ class OutputStreamShard : public OutputStream {
   // A pointer to the output stream spec object, which is owned by the output
   // stream manager.
   OutputStreamSpec* output_stream_spec_;
-  std::list<Packet> output_queue_;
+  // The buffer is reused across invocations, so adding packets does not
+  // allocate once the queue has reached its steady-state length.
+  PacketRingBuffer output_queue_;
   bool closed_;
   Timestamp next_timestamp_bound_;
 
@@ -124,6 +132,9 @@ class OutputStreamShard : public OutputStream {
   friend class GraphTracer;
   // Accesses OutputStreamShard for post processing.
   friend class OutputStreamManager;
+  // Accesses the packet type and adds packets of the checked type.
+  template <typename T>
+  friend class TypedOutputStream;
 };
 
 }  // namespace mediapipe
@@ -40,10 +40,20 @@ Packet Create(HolderBase* holder, Timestamp timestamp) {
   return result;
 }
 
+Packet Create(std::shared_ptr<HolderBase> holder) {
+  Packet result;
+  result.holder_ = std::move(holder);
+  return result;
+}
+
 const HolderBase* GetHolder(const Packet& packet) {
   return packet.holder_.get();
 }
 
+std::weak_ptr<HolderBase> GetWeakHolder(const Packet& packet) {
+  return packet.holder_;
+}
+
 }  // namespace packet_internal
 
 Packet Packet::At(class Timestamp timestamp) const& {
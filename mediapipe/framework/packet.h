@@ -22,6 +22,7 @@
 #include <string>
 #include <type_traits>
 #include <typeinfo>
+#include <utility>
 
 #include "absl/base/macros.h"
 #include "absl/memory/memory.h"
@@ -45,10 +46,15 @@ class Packet;
 
 namespace packet_internal {
 class HolderBase;
+template <typename T>
+class InlineHolder;
 
 Packet Create(HolderBase* holder);
 Packet Create(HolderBase* holder, Timestamp timestamp);
+Packet Create(std::shared_ptr<HolderBase> holder);
 const HolderBase* GetHolder(const Packet& packet);
+// Returns a reference to the payload of "packet" that does not keep it alive.
+std::weak_ptr<HolderBase> GetWeakHolder(const Packet& packet);
 }  // namespace packet_internal
 
 // A generic container class which can hold data of any type.  The type of
@@ -194,8 +200,12 @@ class Packet {
   friend Packet packet_internal::Create(packet_internal::HolderBase* holder);
   friend Packet packet_internal::Create(packet_internal::HolderBase* holder,
                                         class Timestamp timestamp);
+  friend Packet packet_internal::Create(
+      std::shared_ptr<packet_internal::HolderBase> holder);
   friend const packet_internal::HolderBase* packet_internal::GetHolder(
       const Packet& packet);
+  friend std::weak_ptr<packet_internal::HolderBase>
+  packet_internal::GetWeakHolder(const Packet& packet);
   std::shared_ptr<packet_internal::HolderBase> holder_;
   class Timestamp timestamp_;
 };
@@ -232,6 +242,15 @@ Packet AdoptAsUniquePtr(T* ptr) {
   return Adopt(new std::unique_ptr<T>(ptr));
 }
 
+// Returns a copy of "data" for Packet::ConsumeOrCopy().  A type that is not
+// copy constructible, such as ImageFrame, can declare an overload of
+// CopyPacketData in its own namespace, and ConsumeOrCopy finds it through
+// argument-dependent lookup.
+template <typename T>
+std::unique_ptr<T> CopyPacketData(const T& data) {
+  return absl::make_unique<T>(data);
+}
+
 // A SyncedPacket is a packet containing a reference to another packet, and the
 // reference can be updated.
 // SyncedPacket is thread-safe.
@@ -277,12 +296,15 @@ Packet AdoptAsSyncedPacket(const T* ptr) {
 // provided arguments. Similar to MakeUnique. Especially convenient for arrays,
 // since it ensures the packet gets the right type (see below).
 //
-// Version for scalars.
+// Version for scalars.  The object, its holder and the reference count are
+// placed in a single allocation, which makes this cheaper than Adopt().
 template <typename T,
           typename std::enable_if<!std::is_array<T>::value>::type* = nullptr,
           typename... Args>
 Packet MakePacket(Args&&... args) {  // NOLINT(build/c++11)
-  return Adopt(new T(std::forward<Args>(args)...));
+  return packet_internal::Create(
+      std::make_shared<packet_internal::InlineHolder<T>>(
+          std::forward<Args>(args)...));
 }
 
 // Version for arrays. We have to use reinterpret_cast because new T[N]
@@ -313,6 +335,11 @@ namespace packet_internal {
 template <typename T>
 class Holder;
 
+// The holder type id of InlineHolder<T>.  Using a separate tag keeps the type
+// check valid for types that can't be stored inline, such as abstract classes.
+template <typename T>
+struct InlineHolderTag {};
+
 class HolderBase {
  public:
   HolderBase() {}
@@ -381,6 +408,9 @@ class Holder : public HolderBase {
                               std::extent<U>::value != 0>::type* = 0) {
     // Since C++ doesn't allow virtual, templated functions, check holder
     // type here to make sure it's not upcasted from a ForeignHolder.
+    if (HolderIsOfType<InlineHolderTag<T>>()) {
+      return ReleaseInline(std::is_abstract<T>());
+    }
     if (!HolderIsOfType<Holder<T>>()) {
       return InternalError(
           "Foreign holder can't release data ptr without ownership.");
@@ -422,6 +452,13 @@ class Holder : public HolderBase {
   }
 
  private:
+  // Releases the data of an InlineHolder<T>.
+  ::mediapipe::StatusOr<std::unique_ptr<T>> ReleaseInline(std::false_type);
+  // Abstract types are never stored inline.
+  ::mediapipe::StatusOr<std::unique_ptr<T>> ReleaseInline(std::true_type) {
+    return ::mediapipe::InternalError("Abstract types can't be held inline.");
+  }
+
   // Call delete[] if T is an array, delete otherwise.
   template <typename U = T>
   inline void delete_helper(
@@ -458,9 +495,51 @@ class ForeignHolder : public Holder<T> {
   }
 };
 
+// Like Holder, but stores the data in the holder itself.  This is used by
+// MakePacket(), together with std::make_shared, so that the data, the holder
+// and the reference count share a single allocation.
+template <typename T>
+class InlineHolder : public Holder<T> {
+ public:
+  template <typename... Args>
+  explicit InlineHolder(Args&&... args)
+      : Holder<T>(nullptr), data_(std::forward<Args>(args)...) {
+    this->ptr_ = &data_;
+    this->template SetHolderTypeId<InlineHolderTag<T>>();
+  }
+  ~InlineHolder() override {
+    // Null out ptr_ so it doesn't get deleted by ~Holder.
+    this->ptr_ = nullptr;
+  }
+  // The data can't be handed to a std::unique_ptr in place, so it is moved
+  // into a new heap object instead.
+  ::mediapipe::StatusOr<std::unique_ptr<T>> Release() {
+    return MoveToHeap(std::is_move_constructible<T>());
+  }
+
+ private:
+  ::mediapipe::StatusOr<std::unique_ptr<T>> MoveToHeap(std::true_type) {
+    return absl::make_unique<T>(std::move(data_));
+  }
+  ::mediapipe::StatusOr<std::unique_ptr<T>> MoveToHeap(std::false_type) {
+    return ::mediapipe::InternalError(
+        "Can't release data that is not move-constructible from an inline "
+        "holder.");
+  }
+
+  T data_;
+};
+
+template <typename T>
+::mediapipe::StatusOr<std::unique_ptr<T>> Holder<T>::ReleaseInline(
+    std::false_type) {
+  return static_cast<InlineHolder<T>*>(this)->Release();
+}
+
 template <typename T>
 Holder<T>* HolderBase::As() {
-  if (HolderIsOfType<Holder<T>>() || HolderIsOfType<ForeignHolder<T>>()) {
+  if (HolderIsOfType<Holder<T>>() || HolderIsOfType<InlineHolderTag<T>>() ||
+      HolderIsOfType<ForeignHolder<T>>()) {
     return static_cast<Holder<T>*>(this);
   }
   // Does not hold a T.
@@ -469,7 +548,8 @@ Holder<T>* HolderBase::As() {
 
 template <typename T>
 const Holder<T>* HolderBase::As() const {
-  if (HolderIsOfType<Holder<T>>() || HolderIsOfType<ForeignHolder<T>>()) {
+  if (HolderIsOfType<Holder<T>>() || HolderIsOfType<InlineHolderTag<T>>() ||
+      HolderIsOfType<ForeignHolder<T>>()) {
     return static_cast<const Holder<T>*>(this);
   }
   // Does not hold a T.
@@ -535,7 +615,7 @@ inline ::mediapipe::StatusOr<std::unique_ptr<T>> Packet::ConsumeOrCopy(
     return release_result;
   }
   VLOG(1) << "Copying the data of " << DebugString();
-  std::unique_ptr<T> data_ptr = absl::make_unique<T>(Get<T>());
+  std::unique_ptr<T> data_ptr = CopyPacketData(Get<T>());
   VLOG(1) << "Setting " << DebugString() << " to empty.";
   holder_.reset();
   if (was_copied) {
@@ -0,0 +1,102 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/packet_arena.h"
+
+namespace mediapipe {
+
+const GraphService<PacketArena> kPacketArenaService("kPacketArenaService");
+
+constexpr size_t PacketArena::kMinBlockSize;
+constexpr size_t PacketArena::kMaxBlockSize;
+constexpr int PacketArena::kNumSizeClasses;
+
+PacketArena::PacketArena(int max_cached_blocks_per_size)
+    : max_cached_blocks_per_size_(max_cached_blocks_per_size),
+      num_heap_allocations_(0) {
+  static_assert(kMinBlockSize << (kNumSizeClasses - 1) == kMaxBlockSize,
+                "kNumSizeClasses must span kMinBlockSize to kMaxBlockSize");
+  for (FreeList& free_list : free_lists_) {
+    absl::MutexLock lock(&free_list.mutex);
+    free_list.blocks.reserve(max_cached_blocks_per_size_);
+  }
+}
+
+PacketArena::~PacketArena() {
+  for (FreeList& free_list : free_lists_) {
+    absl::MutexLock lock(&free_list.mutex);
+    for (void* block : free_list.blocks) {
+      ::operator delete(block);
+    }
+  }
+}
+
+int PacketArena::SizeClass(size_t size) {
+  if (size > kMaxBlockSize) {
+    return -1;
+  }
+  int size_class = 0;
+  size_t block_size = kMinBlockSize;
+  while (block_size < size) {
+    block_size <<= 1;
+    ++size_class;
+  }
+  return size_class;
+}
+
+void* PacketArena::Allocate(size_t size) {
+  int size_class = SizeClass(size);
+  if (size_class < 0) {
+    ++num_heap_allocations_;
+    return ::operator new(size);
+  }
+  {
+    FreeList& free_list = free_lists_[size_class];
+    absl::MutexLock lock(&free_list.mutex);
+    if (!free_list.blocks.empty()) {
+      void* block = free_list.blocks.back();
+      free_list.blocks.pop_back();
+      return block;
+    }
+  }
+  ++num_heap_allocations_;
+  return ::operator new(kMinBlockSize << size_class);
+}
+
+void PacketArena::Deallocate(void* block, size_t size) {
+  if (block == nullptr) {
+    return;
+  }
+  int size_class = SizeClass(size);
+  if (size_class >= 0) {
+    FreeList& free_list = free_lists_[size_class];
+    absl::MutexLock lock(&free_list.mutex);
+    if (free_list.blocks.size() < max_cached_blocks_per_size_) {
+      free_list.blocks.push_back(block);
+      return;
+    }
+  }
+  ::operator delete(block);
+}
+
+int PacketArena::NumCachedBlocks() const {
+  int num_blocks = 0;
+  for (const FreeList& free_list : free_lists_) {
+    absl::MutexLock lock(&free_list.mutex);
+    num_blocks += free_list.blocks.size();
+  }
+  return num_blocks;
+}
+
+}  // namespace mediapipe
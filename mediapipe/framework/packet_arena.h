@@ -0,0 +1,165 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Defines PacketArena, a block recycler for packet payloads, and
+// MakeArenaPacket(), which allocates a packet from it.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PACKET_ARENA_H_
+#define MEDIAPIPE_FRAMEWORK_PACKET_ARENA_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/graph_service.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+
+// A thread-safe cache of memory blocks for packet payloads.
+//
+// Blocks are grouped into power-of-two size classes.  A block released by the
+// last Packet referring to it, i.e. once every consumer has moved past its
+// timestamp, goes back to the free list of its size class and is handed out to
+// the next allocation of that class, so a graph producing the same payloads
+// for every frame stops calling malloc and free once it reaches steady state.
+// Blocks larger than kMaxBlockSize, and requests for over-aligned types, go
+// straight to the heap.
+//
+// A PacketArena can be shared by all calculators in a graph through
+// kPacketArenaService, and must be owned by a std::shared_ptr.  Packets
+// allocated from an arena keep it alive.
+//
+// Example:
+//   static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+//     cc->UseService(kPacketArenaService).Optional();
+//     ...
+//   }
+//   ::mediapipe::Status Process(CalculatorContext* cc) {
+//     auto arena = cc->Service(kPacketArenaService);
+//     Packet packet = arena.IsAvailable()
+//         ? MakeArenaPacket<Detections>(&arena.GetObject())
+//         : MakePacket<Detections>();
+//     ...
+//   }
+class PacketArena : public std::enable_shared_from_this<PacketArena> {
+ public:
+  // The smallest and the largest block sizes that are recycled.
+  static constexpr size_t kMinBlockSize = 64;
+  static constexpr size_t kMaxBlockSize = 64 * 1024;
+
+  // Creates an arena that caches up to "max_cached_blocks_per_size" free
+  // blocks for each size class.
+  explicit PacketArena(int max_cached_blocks_per_size = 64);
+  ~PacketArena();
+
+  PacketArena(const PacketArena&) = delete;
+  PacketArena& operator=(const PacketArena&) = delete;
+
+  // Returns a block of at least "size" bytes, aligned for any scalar type.
+  void* Allocate(size_t size);
+  // Returns a block obtained from Allocate(size) to the arena.
+  void Deallocate(void* block, size_t size);
+
+  // Returns the number of free blocks held by the arena.
+  int NumCachedBlocks() const;
+  // Returns the number of blocks the arena has requested from the heap.
+  int64 NumHeapAllocations() const { return num_heap_allocations_; }
+
+ private:
+  static constexpr int kNumSizeClasses = 11;
+
+  // Returns the size class for "size", or -1 if blocks of that size are not
+  // recycled.
+  static int SizeClass(size_t size);
+
+  struct FreeList {
+    mutable absl::Mutex mutex;
+    std::vector<void*> blocks GUARDED_BY(mutex);
+  };
+
+  const int max_cached_blocks_per_size_;
+  FreeList free_lists_[kNumSizeClasses];
+  std::atomic<int64> num_heap_allocations_;
+};
+
+// A standard allocator drawing from a PacketArena.  Copies of the allocator
+// share ownership of the arena.
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  explicit ArenaAllocator(std::shared_ptr<PacketArena> arena)
+      : arena_(std::move(arena)) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena()) {}
+
+  T* allocate(size_t n) {
+    if (alignof(T) > alignof(std::max_align_t)) {
+      return std::allocator<T>().allocate(n);
+    }
+    return static_cast<T*>(arena_->Allocate(n * sizeof(T)));
+  }
+  void deallocate(T* p, size_t n) {
+    if (alignof(T) > alignof(std::max_align_t)) {
+      std::allocator<T>().deallocate(p, n);
+      return;
+    }
+    arena_->Deallocate(p, n * sizeof(T));
+  }
+
+  const std::shared_ptr<PacketArena>& arena() const { return arena_; }
+
+ private:
+  std::shared_ptr<PacketArena> arena_;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return a.arena() == b.arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return !(a == b);
+}
+
+// Like MakePacket<T>(), but takes the packet's single allocation from
+// "arena".  The arena must be owned by a std::shared_ptr.
+template <typename T,
+          typename std::enable_if<!std::is_array<T>::value>::type* = nullptr,
+          typename... Args>
+Packet MakeArenaPacket(PacketArena* arena, Args&&... args) {
+  return packet_internal::Create(
+      std::allocate_shared<packet_internal::InlineHolder<T>>(
+          ArenaAllocator<packet_internal::InlineHolder<T>>(
+              arena->shared_from_this()),
+          std::forward<Args>(args)...));
+}
+
+// Provides a PacketArena to every calculator in a graph.  The graph creates
+// one if CalculatorGraphConfig.enable_packet_arena is set and the application
+// has not supplied its own.
+extern const GraphService<PacketArena> kPacketArenaService;
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PACKET_ARENA_H_
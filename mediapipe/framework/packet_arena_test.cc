@@ -0,0 +1,167 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/packet_arena.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(PacketArenaTest, RecyclesBlocksBySizeClass) {
+  auto arena = std::make_shared<PacketArena>();
+  void* block = arena->Allocate(100);
+  EXPECT_EQ(1, arena->NumHeapAllocations());
+  arena->Deallocate(block, 100);
+  EXPECT_EQ(1, arena->NumCachedBlocks());
+
+  // Any size in the same class reuses the block.
+  EXPECT_EQ(block, arena->Allocate(128));
+  EXPECT_EQ(1, arena->NumHeapAllocations());
+  EXPECT_EQ(0, arena->NumCachedBlocks());
+  arena->Deallocate(block, 128);
+
+  // A different size class needs a new block.
+  void* small_block = arena->Allocate(8);
+  EXPECT_EQ(2, arena->NumHeapAllocations());
+  arena->Deallocate(small_block, 8);
+  EXPECT_EQ(2, arena->NumCachedBlocks());
+}
+
+TEST(PacketArenaTest, DoesNotCacheLargeBlocks) {
+  auto arena = std::make_shared<PacketArena>();
+  void* block = arena->Allocate(PacketArena::kMaxBlockSize + 1);
+  arena->Deallocate(block, PacketArena::kMaxBlockSize + 1);
+  EXPECT_EQ(0, arena->NumCachedBlocks());
+}
+
+TEST(PacketArenaTest, LimitsCachedBlocks) {
+  auto arena = std::make_shared<PacketArena>(/*max_cached_blocks_per_size=*/2);
+  std::vector<void*> blocks;
+  for (int i = 0; i < 3; ++i) {
+    blocks.push_back(arena->Allocate(64));
+  }
+  for (void* block : blocks) {
+    arena->Deallocate(block, 64);
+  }
+  EXPECT_EQ(2, arena->NumCachedBlocks());
+}
+
+TEST(PacketArenaTest, MakeArenaPacketReusesMemory) {
+  auto arena = std::make_shared<PacketArena>();
+  const void* first_data;
+  {
+    Packet packet = MakeArenaPacket<std::string>(arena.get(), "frame 1");
+    EXPECT_EQ("frame 1", packet.Get<std::string>());
+    first_data = &packet.Get<std::string>();
+    EXPECT_EQ(0, arena->NumCachedBlocks());
+  }
+  EXPECT_EQ(1, arena->NumCachedBlocks());
+  Packet packet = MakeArenaPacket<std::string>(arena.get(), "frame 2");
+  EXPECT_EQ(first_data, &packet.Get<std::string>());
+  EXPECT_EQ(1, arena->NumHeapAllocations());
+}
+
+TEST(PacketArenaTest, PacketsKeepArenaAlive) {
+  auto arena = std::make_shared<PacketArena>();
+  Packet packet = MakeArenaPacket<int>(arena.get(), 7);
+  std::weak_ptr<PacketArena> weak_arena = arena;
+  arena.reset();
+  EXPECT_FALSE(weak_arena.expired());
+  EXPECT_EQ(7, packet.Get<int>());
+  packet = Packet();
+  EXPECT_TRUE(weak_arena.expired());
+}
+
+// Outputs the input value, offset by one, allocated from the graph's arena.
+class ArenaIncrementCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    cc->UseService(kPacketArenaService);
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) final {
+    PacketArena& arena = cc->Service(kPacketArenaService).GetObject();
+    cc->Outputs().Index(0).AddPacket(
+        MakeArenaPacket<int>(&arena, cc->Inputs().Index(0).Get<int>() + 1)
+            .At(cc->InputTimestamp()));
+    return ::mediapipe::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(ArenaIncrementCalculator);
+
+TEST(PacketArenaTest, GraphProvidesArena) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "in"
+        enable_packet_arena: true
+        node {
+          calculator: "ArenaIncrementCalculator"
+          input_stream: "in"
+          output_stream: "out"
+        }
+      )");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  std::vector<int> outputs;
+  MP_ASSERT_OK(graph.ObserveOutputStream("out", [&outputs](const Packet& p) {
+    outputs.push_back(p.Get<int>());
+    return ::mediapipe::OkStatus();
+  }));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < 10; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+    MP_ASSERT_OK(graph.WaitUntilIdle());
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_EQ(std::vector<int>({1, 2, 3, 4, 5, 6, 7, 8, 9, 10}), outputs);
+
+  std::shared_ptr<PacketArena> arena =
+      graph.GetServiceObject(kPacketArenaService);
+  ASSERT_NE(nullptr, arena);
+  // Each output is released by the observer before the next one is made.
+  EXPECT_EQ(1, arena->NumHeapAllocations());
+}
+
+TEST(PacketArenaTest, GraphRequiresArenaService) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "in"
+        node {
+          calculator: "ArenaIncrementCalculator"
+          input_stream: "in"
+          output_stream: "out"
+        }
+      )");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  EXPECT_FALSE(graph.StartRun({}).ok());
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -22,8 +22,10 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "mediapipe/framework/delegating_executor.h"
 #include "mediapipe/framework/executor.h"
+#include "mediapipe/framework/mediapipe_profiling.h"
 #include "mediapipe/framework/packet_generator.h"
 #include "mediapipe/framework/packet_type.h"
 #include "mediapipe/framework/port.h"
@@ -124,10 +126,12 @@ class GeneratorScheduler {
   // "initial" must be set to true for the first pass and false for subsequent
   // passes. If "initial" is false, non_base_generators contains the non-base
   // PacketGenerators (those not run at initialize time due to missing
-  // dependencies).
+  // dependencies). If "profiler" is not null, the runtime of each generator
+  // is recorded in it.
   GeneratorScheduler(const ValidatedGraphConfig* validated_graph,
                      ::mediapipe::Executor* executor,
-                     const std::vector<int>& non_base_generators, bool initial);
+                     const std::vector<int>& non_base_generators, bool initial,
+                     ProfilingContext* profiler);
 
   // Run a PacketGenerator on a given executor on the provided input
   // side packets.  After running the generator, schedule any generators
@@ -162,6 +166,7 @@ class GeneratorScheduler {
 
   const ValidatedGraphConfig* const validated_graph_;
   ::mediapipe::Executor* executor_;
+  ProfilingContext* const profiler_;
 
   mutable absl::Mutex mutex_;
   // The number of pending tasks.
@@ -184,9 +189,11 @@ class GeneratorScheduler {
 GeneratorScheduler::GeneratorScheduler(
     const ValidatedGraphConfig* validated_graph,
     ::mediapipe::Executor* executor,
-    const std::vector<int>& non_base_generators, bool initial)
+    const std::vector<int>& non_base_generators, bool initial,
+    ProfilingContext* profiler)
     : validated_graph_(validated_graph),
       executor_(executor),
+      profiler_(profiler),
       scheduled_generators_(validated_graph_->Config().packet_generator_size(),
                             !initial) {
   if (!executor_) {
@@ -220,9 +227,15 @@ void GeneratorScheduler::GenerateAndScheduleNext(
           .OutputSidePacketTypes()
           .TagMap());
   VLOG(1) << "Running generator " << generator_index;
+  const absl::Time start_time =
+      profiler_ ? profiler_->TimeNow() : absl::InfinitePast();
   ::mediapipe::Status status =
       Generate(*validated_graph_, generator_index, *input_side_packet_set,
                &output_side_packet_set);
+  if (profiler_) {
+    profiler_->AddPacketGeneratorSample(generator_index, start_time,
+                                        profiler_->TimeNow());
+  }
 
   {
     absl::MutexLock lock(&mutex_);
@@ -410,7 +423,7 @@ PacketGeneratorGraph::~PacketGeneratorGraph() {}
   // The ValidatedGraphConfig object is expected to already have sorted
   // generators in topological order.
   GeneratorScheduler scheduler(validated_graph_, executor_,
-                               non_base_generators_, initial);
+                               non_base_generators_, initial, profiler_);
   scheduler.ScheduleAllRunnableGenerators(output_side_packets);
   // Do not return early if scheduler encountered an error.  The lambdas
   // in the executor must run in order to free resources.
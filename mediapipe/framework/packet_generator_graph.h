@@ -31,6 +31,8 @@
 
 namespace mediapipe {
 
+class ProfilingContext;
+
 // A graph of packet generators.
 //
 // Initialize runs all the generators which it can (i.e. whose input
@@ -42,6 +44,10 @@ namespace mediapipe {
 // output side packets.  Initialize should only be called once.
 // RunGraphSetup may be called any number of times.
 //
+// The generators whose input side packets are available run concurrently on
+// the executor, so independent generators, such as ones loading different
+// models, do not wait for each other.
+//
 // This class is thread compatible.
 class PacketGeneratorGraph {
  public:
@@ -56,6 +62,10 @@ class PacketGeneratorGraph {
   // See b/17412838.
   virtual ~PacketGeneratorGraph();
 
+  // Sets the profiler which records the runtime of each generator.  Must be
+  // called before Initialize.  The profiler must outlive this object.
+  void SetProfiler(ProfilingContext* profiler) { profiler_ = profiler; }
+
   // Initialize the PacketGeneratorGraph with the validated graph config
   // and executor to use.  If executor is nullptr, then the application
   // thread is used.
@@ -113,6 +123,10 @@ class PacketGeneratorGraph {
   // An object to own the executor if it needs to be deleted.
   std::unique_ptr<::mediapipe::Executor> executor_owner_;
 
+  // The profiler recording the runtime of the generators, or nullptr.  We do
+  // not own the profiler.
+  ProfilingContext* profiler_ = nullptr;
+
   // The base level packets available after initialization.
   std::map<std::string, Packet> base_packets_;
   // The non-base level generators in the graph, excluding those already
@@ -0,0 +1,247 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PACKET_RING_BUFFER_H_
+#define MEDIAPIPE_FRAMEWORK_PACKET_RING_BUFFER_H_
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/logging.h"
+
+namespace mediapipe {
+
+// A FIFO queue of packets stored in a contiguous circular buffer.
+//
+// The first kInlineCapacity packets are stored inline, since nearly every
+// calculator outputs at most one packet per stream per call, so most output
+// stream shards and input stream queues never touch the heap.  The buffer
+// keeps its storage across clear() and pop_front(), so a stream whose queue
+// length stays below the reserved capacity performs no heap allocation per
+// packet.  If a push_back() finds the buffer full, the capacity is doubled;
+// max_queue_size is only a soft limit, so the queue must be able to grow past
+// it.
+//
+// The method names follow the standard containers this class replaces.
+// PacketRingBuffer is not thread-safe.
+class PacketRingBuffer {
+ private:
+  template <typename BufferT, typename PacketT>
+  class IteratorImpl {
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = Packet;
+    using difference_type = std::ptrdiff_t;
+    using pointer = PacketT*;
+    using reference = PacketT&;
+
+    IteratorImpl(BufferT* buffer, size_t index)
+        : buffer_(buffer), index_(index) {}
+
+    reference operator*() const { return (*buffer_)[index_]; }
+    pointer operator->() const { return &(*buffer_)[index_]; }
+    IteratorImpl& operator++() {
+      ++index_;
+      return *this;
+    }
+    IteratorImpl& operator--() {
+      --index_;
+      return *this;
+    }
+    IteratorImpl operator+(difference_type n) const {
+      return IteratorImpl(buffer_, index_ + n);
+    }
+    IteratorImpl operator-(difference_type n) const {
+      return IteratorImpl(buffer_, index_ - n);
+    }
+    difference_type operator-(const IteratorImpl& other) const {
+      return static_cast<difference_type>(index_) -
+             static_cast<difference_type>(other.index_);
+    }
+    bool operator==(const IteratorImpl& other) const {
+      return buffer_ == other.buffer_ && index_ == other.index_;
+    }
+    bool operator!=(const IteratorImpl& other) const {
+      return !(*this == other);
+    }
+
+   private:
+    BufferT* buffer_;
+    size_t index_;
+  };
+
+ public:
+  using value_type = Packet;
+  using iterator = IteratorImpl<PacketRingBuffer, Packet>;
+  using const_iterator = IteratorImpl<const PacketRingBuffer, const Packet>;
+
+  // The number of packets stored without a heap allocation.
+  static constexpr size_t kInlineCapacity = 2;
+
+  PacketRingBuffer() = default;
+  // Creates a buffer that holds at least "capacity" packets before growing.
+  explicit PacketRingBuffer(size_t capacity) { reserve(capacity); }
+
+  PacketRingBuffer(const PacketRingBuffer& other) { *this = other; }
+  PacketRingBuffer& operator=(const PacketRingBuffer& other) {
+    if (this != &other) {
+      clear();
+      reserve(other.size_);
+      for (const Packet& packet : other) {
+        push_back(packet);
+      }
+    }
+    return *this;
+  }
+  PacketRingBuffer(PacketRingBuffer&& other) { *this = std::move(other); }
+  PacketRingBuffer& operator=(PacketRingBuffer&& other) {
+    if (this == &other) {
+      return *this;
+    }
+    clear();
+    if (other.heap_slots_) {
+      // Takes over the heap storage, leaving "other" with its inline slots.
+      heap_slots_ = std::move(other.heap_slots_);
+      slots_ = heap_slots_.get();
+      capacity_ = other.capacity_;
+      head_ = other.head_;
+      size_ = other.size_;
+      other.slots_ = other.inline_slots_;
+      other.capacity_ = kInlineCapacity;
+      other.head_ = 0;
+      other.size_ = 0;
+    } else {
+      for (Packet& packet : other) {
+        push_back(std::move(packet));
+      }
+      other.clear();
+    }
+    return *this;
+  }
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+  // Returns the number of packets the buffer can hold without reallocating.
+  size_t capacity() const { return capacity_; }
+
+  // Returns the i-th packet counting from the front of the queue.
+  Packet& operator[](size_t i) { return slots_[Slot(i)]; }
+  const Packet& operator[](size_t i) const { return slots_[Slot(i)]; }
+
+  Packet& front() {
+    DCHECK(!empty());
+    return slots_[head_];
+  }
+  const Packet& front() const {
+    DCHECK(!empty());
+    return slots_[head_];
+  }
+  Packet& back() {
+    DCHECK(!empty());
+    return slots_[Slot(size_ - 1)];
+  }
+  const Packet& back() const {
+    DCHECK(!empty());
+    return slots_[Slot(size_ - 1)];
+  }
+
+  void push_back(const Packet& packet) {
+    GrowIfFull();
+    slots_[Slot(size_)] = packet;
+    ++size_;
+  }
+  void push_back(Packet&& packet) {
+    GrowIfFull();
+    slots_[Slot(size_)] = std::move(packet);
+    ++size_;
+  }
+  template <typename... Args>
+  void emplace_back(Args&&... args) {
+    push_back(Packet(std::forward<Args>(args)...));
+  }
+
+  // Removes the packet at the front of the queue and releases its payload.
+  void pop_front() {
+    DCHECK(!empty());
+    slots_[head_] = Packet();
+    head_ = (head_ + 1) & (capacity_ - 1);
+    --size_;
+  }
+
+  // Removes all packets.  The capacity is retained.
+  void clear() {
+    while (!empty()) {
+      pop_front();
+    }
+    head_ = 0;
+  }
+
+  // Ensures the buffer can hold "capacity" packets without reallocating.
+  // The capacity is rounded up to a power of two and never shrinks.
+  void reserve(size_t capacity) {
+    if (capacity <= capacity_) {
+      return;
+    }
+    size_t new_capacity = capacity_;
+    while (new_capacity < capacity) {
+      new_capacity *= 2;
+    }
+    std::unique_ptr<Packet[]> new_slots =
+        absl::make_unique<Packet[]>(new_capacity);
+    for (size_t i = 0; i < size_; ++i) {
+      new_slots[i] = std::move(slots_[Slot(i)]);
+    }
+    heap_slots_ = std::move(new_slots);
+    slots_ = heap_slots_.get();
+    capacity_ = new_capacity;
+    head_ = 0;
+  }
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, size_); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, size_); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+ private:
+  // Maps a queue position to an index into slots_.  The capacity is always a
+  // power of two, so the wrap-around is a mask.
+  size_t Slot(size_t i) const { return (head_ + i) & (capacity_ - 1); }
+
+  void GrowIfFull() {
+    if (size_ == capacity_) {
+      reserve(capacity_ * 2);
+    }
+  }
+
+  Packet inline_slots_[kInlineCapacity];
+  // The storage once the queue has outgrown inline_slots_.
+  std::unique_ptr<Packet[]> heap_slots_;
+  // Points to inline_slots_ or heap_slots_.
+  Packet* slots_ = inline_slots_;
+  size_t capacity_ = kInlineCapacity;
+  // The index in slots_ of the front of the queue.
+  size_t head_ = 0;
+  // The number of packets in the queue.
+  size_t size_ = 0;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PACKET_RING_BUFFER_H_
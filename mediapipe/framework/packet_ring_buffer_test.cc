@@ -0,0 +1,141 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/packet_ring_buffer.h"
+
+#include <utility>
+
+#include "mediapipe/framework/lifetime_tracker.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/timestamp.h"
+
+namespace mediapipe {
+namespace {
+
+Packet IntPacket(int value) {
+  return MakePacket<int>(value).At(Timestamp(value));
+}
+
+TEST(PacketRingBufferTest, PushAndPopInOrder) {
+  PacketRingBuffer queue;
+  EXPECT_TRUE(queue.empty());
+  for (int i = 0; i < 10; ++i) {
+    queue.push_back(IntPacket(i));
+  }
+  EXPECT_EQ(10, queue.size());
+  EXPECT_EQ(9, queue.back().Get<int>());
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_FALSE(queue.empty());
+    EXPECT_EQ(i, queue.front().Get<int>());
+    queue.pop_front();
+  }
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(PacketRingBufferTest, WrapsAroundWithoutGrowing) {
+  PacketRingBuffer queue(4);
+  EXPECT_EQ(4, queue.capacity());
+  int next = 0;
+  for (int i = 0; i < 3; ++i) {
+    queue.push_back(IntPacket(next++));
+  }
+  // Keep three packets in flight for many rounds; the storage is reused.
+  for (int round = 0; round < 100; ++round) {
+    EXPECT_EQ(next - 3, queue.front().Get<int>());
+    queue.pop_front();
+    queue.push_back(IntPacket(next++));
+    EXPECT_EQ(next - 1, queue.back().Get<int>());
+  }
+  EXPECT_EQ(4, queue.capacity());
+  EXPECT_EQ(3, queue.size());
+}
+
+TEST(PacketRingBufferTest, GrowsPreservingOrder) {
+  PacketRingBuffer queue(4);
+  queue.push_back(IntPacket(0));
+  queue.push_back(IntPacket(1));
+  queue.pop_front();
+  // The head is now in the middle of the storage when the buffer grows.
+  for (int i = 2; i < 20; ++i) {
+    queue.push_back(IntPacket(i));
+  }
+  EXPECT_EQ(32, queue.capacity());
+  int expected = 1;
+  for (const Packet& packet : queue) {
+    EXPECT_EQ(expected++, packet.Get<int>());
+  }
+  EXPECT_EQ(20, expected);
+  EXPECT_EQ(15, (queue.cend() - 5)->Get<int>());
+}
+
+TEST(PacketRingBufferTest, PopAndClearReleasePayloads) {
+  LifetimeTracker tracker;
+  PacketRingBuffer queue;
+  for (int i = 0; i < 3; ++i) {
+    queue.push_back(Adopt(tracker.MakeObject().release()).At(Timestamp(i)));
+  }
+  EXPECT_EQ(3, tracker.live_count());
+  queue.pop_front();
+  EXPECT_EQ(2, tracker.live_count());
+  queue.clear();
+  EXPECT_EQ(0, tracker.live_count());
+}
+
+TEST(PacketRingBufferTest, MoveLeavesSlotsEmpty) {
+  PacketRingBuffer queue;
+  queue.push_back(IntPacket(1));
+  queue.push_back(IntPacket(2));
+  for (Packet& packet : queue) {
+    Packet taken = std::move(packet);
+    EXPECT_FALSE(taken.IsEmpty());
+  }
+  for (const Packet& packet : queue) {
+    EXPECT_TRUE(packet.IsEmpty());
+  }
+  queue.clear();
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(2, queue.capacity());
+}
+
+TEST(PacketRingBufferTest, MovesInlineAndHeapStorage) {
+  PacketRingBuffer inline_queue;
+  inline_queue.push_back(IntPacket(1));
+  PacketRingBuffer heap_queue;
+  for (int i = 0; i < 5; ++i) {
+    heap_queue.push_back(IntPacket(i));
+  }
+
+  PacketRingBuffer moved_inline(std::move(inline_queue));
+  EXPECT_TRUE(inline_queue.empty());
+  ASSERT_EQ(1, moved_inline.size());
+  EXPECT_EQ(1, moved_inline.front().Get<int>());
+
+  PacketRingBuffer moved_heap(std::move(heap_queue));
+  EXPECT_TRUE(heap_queue.empty());
+  EXPECT_EQ(2, heap_queue.capacity());
+  EXPECT_EQ(8, moved_heap.capacity());
+  ASSERT_EQ(5, moved_heap.size());
+  EXPECT_EQ(4, moved_heap.back().Get<int>());
+
+  // Both buffers remain usable after the moves.
+  heap_queue.push_back(IntPacket(7));
+  EXPECT_EQ(7, heap_queue.front().Get<int>());
+  PacketRingBuffer copy = moved_heap;
+  EXPECT_EQ(5, copy.size());
+  EXPECT_EQ(0, copy.front().Get<int>());
+}
+
+}  // namespace
+}  // namespace mediapipe
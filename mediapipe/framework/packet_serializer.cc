@@ -0,0 +1,247 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/packet_serializer.h"
+
+#include <map>
+
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/status_macros.h"
+
+namespace mediapipe {
+
+namespace {
+
+struct RegisteredSerializer {
+  std::string type_name;
+  std::unique_ptr<PacketSerializer> serializer;
+};
+
+class SerializerMap {
+ public:
+  static SerializerMap* Get() {
+    static SerializerMap* instance = new SerializerMap();
+    return instance;
+  }
+
+  void Register(size_t type_id, const std::string& type_name,
+                std::unique_ptr<PacketSerializer> serializer) {
+    absl::MutexLock lock(&mutex_);
+    CHECK(by_type_id_.find(type_id) == by_type_id_.end())
+        << "A packet serializer is already registered for " << type_name
+        << ".";
+    CHECK(by_type_name_.find(type_name) == by_type_name_.end())
+        << "A packet serializer is already registered under " << type_name
+        << ".";
+    auto& registered = by_type_id_[type_id];
+    registered.type_name = type_name;
+    registered.serializer = std::move(serializer);
+    by_type_name_[type_name] = registered.serializer.get();
+  }
+
+  const PacketSerializer* Find(size_t type_id, std::string* type_name) {
+    absl::ReaderMutexLock lock(&mutex_);
+    auto it = by_type_id_.find(type_id);
+    if (it == by_type_id_.end()) {
+      return nullptr;
+    }
+    *type_name = it->second.type_name;
+    return it->second.serializer.get();
+  }
+
+  const PacketSerializer* Find(const std::string& type_name) {
+    absl::ReaderMutexLock lock(&mutex_);
+    auto it = by_type_name_.find(type_name);
+    return it == by_type_name_.end() ? nullptr : it->second;
+  }
+
+ private:
+  absl::Mutex mutex_;
+  std::map<size_t, RegisteredSerializer> by_type_id_ GUARDED_BY(mutex_);
+  std::map<std::string, const PacketSerializer*> by_type_name_
+      GUARDED_BY(mutex_);
+};
+
+constexpr char kTruncatedPacket[] = "Truncated serialized packet.";
+
+// Serializes the string in place.
+class StringSerializer : public PacketSerializer {
+ public:
+  ::mediapipe::Status Serialize(const Packet& packet,
+                                SerializedPacket* output) const override {
+    const std::string& value = packet.Get<std::string>();
+    output->AppendReference(value.data(), value.size());
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::StatusOr<Packet> Deserialize(
+      const SerializedPacketView& input) const override {
+    return MakePacket<std::string>(std::string(input.data));
+  }
+};
+
+// Serializes the elements in place.
+class FloatVectorSerializer : public PacketSerializer {
+ public:
+  ::mediapipe::Status Serialize(const Packet& packet,
+                                SerializedPacket* output) const override {
+    const auto& value = packet.Get<std::vector<float>>();
+    output->AppendReference(value.data(), value.size() * sizeof(float));
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::StatusOr<Packet> Deserialize(
+      const SerializedPacketView& input) const override {
+    RET_CHECK_EQ(input.data.size() % sizeof(float), 0) << kTruncatedPacket;
+    auto value = absl::make_unique<std::vector<float>>(input.data.size() /
+                                                       sizeof(float));
+    memcpy(value->data(), input.data.data(), input.data.size());
+    return Adopt(value.release());
+  }
+};
+
+}  // namespace
+
+uint8* SerializedPacket::AppendBuffer(size_t size) {
+  buffers_.emplace_back(size, '\0');
+  std::string& buffer = buffers_.back();
+  chunks_.emplace_back(buffer.data(), size);
+  size_ += size;
+  return reinterpret_cast<uint8*>(&buffer[0]);
+}
+
+void SerializedPacket::AppendReference(const void* data, size_t size) {
+  chunks_.emplace_back(static_cast<const char*>(data), size);
+  size_ += size;
+}
+
+void SerializedPacket::AppendTo(std::string* output) const {
+  output->reserve(output->size() + size_);
+  for (const absl::string_view chunk : chunks_) {
+    output->append(chunk.data(), chunk.size());
+  }
+}
+
+void SerializedPacket::CopyTo(uint8* output) const {
+  for (const absl::string_view chunk : chunks_) {
+    memcpy(output, chunk.data(), chunk.size());
+    output += chunk.size();
+  }
+}
+
+bool PacketSerializerRegistry::Register(
+    size_t type_id, const std::string& type_name,
+    std::unique_ptr<PacketSerializer> serializer) {
+  SerializerMap::Get()->Register(type_id, type_name, std::move(serializer));
+  return true;
+}
+
+const PacketSerializer* PacketSerializerRegistry::GetSerializer(
+    size_t type_id, std::string* type_name) {
+  return SerializerMap::Get()->Find(type_id, type_name);
+}
+
+const PacketSerializer* PacketSerializerRegistry::GetSerializer(
+    const std::string& type_name) {
+  return SerializerMap::Get()->Find(type_name);
+}
+
+constexpr size_t SerializedPacket::kContentsAlignment;
+
+namespace {
+
+// The padding after a type name of "type_name_size" bytes, which aligns the
+// contents that follow the timestamp.
+size_t TypeNamePadding(size_t type_name_size) {
+  const size_t header_size = sizeof(uint32) + type_name_size + sizeof(int64);
+  const size_t alignment = SerializedPacket::kContentsAlignment;
+  return (alignment - header_size % alignment) % alignment;
+}
+
+}  // namespace
+
+// A serialized packet is the size and name of its type, zero padding, its
+// timestamp and the contents written by the type's serializer.
+::mediapipe::Status SerializePacket(const Packet& packet,
+                                    SerializedPacket* output) {
+  RET_CHECK(!packet.IsEmpty()) << "Cannot serialize an empty packet.";
+  std::string type_name;
+  const PacketSerializer* serializer =
+      PacketSerializerRegistry::GetSerializer(packet.GetTypeId(), &type_name);
+  const MediaPipeTypeData* type_data = nullptr;
+  if (!serializer) {
+    type_data = PacketTypeIdToMediaPipeTypeData::GetValue(packet.GetTypeId());
+    RET_CHECK(type_data && type_data->serialize_fn)
+        << "No serializer is registered for " << packet.DebugTypeName()
+        << ".";
+    type_name = type_data->type_string;
+  }
+  output->AppendValue<uint32>(type_name.size());
+  output->AppendCopy(type_name.data(), type_name.size());
+  const size_t padding = TypeNamePadding(type_name.size());
+  if (padding > 0) {
+    memset(output->AppendBuffer(padding), 0, padding);
+  }
+  output->AppendValue<int64>(packet.Timestamp().Value());
+  if (serializer) {
+    output->Retain(packet);
+    return serializer->Serialize(packet, output);
+  }
+  std::string encoding;
+  MP_RETURN_IF_ERROR(
+      type_data->serialize_fn(*packet_internal::GetHolder(packet), &encoding));
+  output->AppendCopy(encoding.data(), encoding.size());
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::StatusOr<Packet> DeserializePacket(
+    const SerializedPacketView& input) {
+  absl::string_view data = input.data;
+  uint32 type_name_size;
+  RET_CHECK(ConsumeSerializedValue(&data, &type_name_size) &&
+            data.size() >= type_name_size + TypeNamePadding(type_name_size))
+      << kTruncatedPacket;
+  const std::string type_name(data.substr(0, type_name_size));
+  data.remove_prefix(type_name_size + TypeNamePadding(type_name_size));
+  int64 timestamp;
+  RET_CHECK(ConsumeSerializedValue(&data, &timestamp)) << kTruncatedPacket;
+
+  Packet packet;
+  const PacketSerializer* serializer =
+      PacketSerializerRegistry::GetSerializer(type_name);
+  if (serializer) {
+    SerializedPacketView contents;
+    contents.data = data;
+    contents.owner = input.owner;
+    ASSIGN_OR_RETURN(packet, serializer->Deserialize(contents));
+  } else {
+    const MediaPipeTypeData* type_data =
+        PacketTypeStringToMediaPipeTypeData::GetValue(type_name);
+    RET_CHECK(type_data && type_data->deserialize_fn)
+        << "No serializer is registered for " << type_name << ".";
+    std::unique_ptr<packet_internal::HolderBase> holder;
+    MP_RETURN_IF_ERROR(type_data->deserialize_fn(std::string(data), &holder));
+    packet = packet_internal::Create(holder.release());
+  }
+  return packet.At(Timestamp::CreateNoErrorChecking(timestamp));
+}
+
+MEDIAPIPE_REGISTER_PACKET_SERIALIZER(::std::string, "::std::string",
+                                     StringSerializer);
+MEDIAPIPE_REGISTER_PACKET_SERIALIZER(::std::vector<float>,
+                                     "::std::vector<float>",
+                                     FloatVectorSerializer);
+
+}  // namespace mediapipe
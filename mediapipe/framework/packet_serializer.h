@@ -0,0 +1,225 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// A registry of binary serializers for packets, for recording packets or
+// passing them between processes and hosts. Unlike the serialize functions
+// of MEDIAPIPE_REGISTER_TYPE, a PacketSerializer can refer to the packet's
+// own data instead of copying it into a string, and can create packets that
+// use a received buffer in place.
+//
+// Serializers for std::string and std::vector<float> are always registered.
+// Linking //mediapipe/framework/formats:image_frame_serializer and
+// //mediapipe/framework/formats:matrix_serializer registers serializers for
+// ImageFrame and Matrix. Protocol buffer types can be registered with
+// MEDIAPIPE_REGISTER_PROTO_PACKET_SERIALIZER. Packets of other types fall
+// back to the serialize functions of MEDIAPIPE_REGISTER_TYPE.
+//
+// Values are serialized in host byte order, so serialized packets should only
+// be exchanged between hosts of the same endianness.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PACKET_SERIALIZER_H_
+#define MEDIAPIPE_FRAMEWORK_PACKET_SERIALIZER_H_
+
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/proto_ns.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mediapipe/framework/tool/type_util.h"
+#include "mediapipe/framework/type_map.h"
+
+namespace mediapipe {
+
+// The serialized form of a packet, as a sequence of byte ranges. Ranges added
+// with AppendReference() point into the packet's own data, so that large
+// payloads such as pixel data are only copied when the ranges are written
+// out, e.g. with writev() or into a shared memory segment.
+class SerializedPacket {
+ public:
+  // SerializePacket() starts the serializer's contents at a multiple of this
+  // many bytes from the start of the serialized packet, so that a buffer
+  // holding the serialized packet at an aligned address can hold e.g. pixel
+  // data suitably aligned for use in place.
+  static constexpr size_t kContentsAlignment = 16;
+
+  SerializedPacket() = default;
+  SerializedPacket(SerializedPacket&&) = default;
+  SerializedPacket& operator=(SerializedPacket&&) = default;
+  SerializedPacket(const SerializedPacket&) = delete;
+  SerializedPacket& operator=(const SerializedPacket&) = delete;
+
+  // Appends "size" bytes of storage owned by this object and returns it.
+  uint8* AppendBuffer(size_t size);
+
+  // Appends a copy of "size" bytes at "data".
+  void AppendCopy(const void* data, size_t size) {
+    memcpy(AppendBuffer(size), data, size);
+  }
+
+  // Appends a copy of a trivially copyable value.
+  template <typename T>
+  void AppendValue(const T& value) {
+    AppendCopy(&value, sizeof(value));
+  }
+
+  // Appends "size" bytes at "data" without copying them. The data must stay
+  // unchanged while this object is used, which holds for the data of the
+  // packet passed to SerializePacket().
+  void AppendReference(const void* data, size_t size);
+
+  // Keeps "packet" alive as long as this object, for the ranges appended
+  // with AppendReference().
+  void Retain(const Packet& packet) { retained_packets_.push_back(packet); }
+
+  // The byte ranges, in order.
+  const std::vector<absl::string_view>& chunks() const { return chunks_; }
+
+  // The total size in bytes.
+  size_t size() const { return size_; }
+
+  // Appends the bytes to "output".
+  void AppendTo(std::string* output) const;
+
+  // Copies the bytes to "output", which must have room for size() bytes.
+  void CopyTo(uint8* output) const;
+
+ private:
+  std::vector<absl::string_view> chunks_;
+  size_t size_ = 0;
+  // The storage of AppendBuffer(). A deque never moves its elements when
+  // growing, so the chunks pointing into them stay valid.
+  std::deque<std::string> buffers_;
+  std::vector<Packet> retained_packets_;
+};
+
+// A serialized packet received into one buffer. Deserializers may share
+// "owner", which keeps "data" alive, with the packets they create so that
+// those use "data" in place. The data must not change afterwards.
+struct SerializedPacketView {
+  absl::string_view data;
+  std::shared_ptr<const void> owner;
+};
+
+// Serializes and deserializes packets of one type. Implementations must be
+// thread-safe.
+class PacketSerializer {
+ public:
+  virtual ~PacketSerializer() = default;
+
+  // Appends the contents of "packet", which holds the registered type, to
+  // "output". The packet outlives "output".
+  virtual ::mediapipe::Status Serialize(const Packet& packet,
+                                        SerializedPacket* output) const = 0;
+
+  // Creates a packet, without timestamp, from contents written by
+  // Serialize().
+  virtual ::mediapipe::StatusOr<Packet> Deserialize(
+      const SerializedPacketView& input) const = 0;
+};
+
+class PacketSerializerRegistry {
+ public:
+  // Registers "serializer" for the type with "type_id", under "type_name",
+  // which identifies the type in serialized packets. Each type and name can
+  // only be registered once. Returns true, for use in static initializers.
+  static bool Register(size_t type_id, const std::string& type_name,
+                       std::unique_ptr<PacketSerializer> serializer);
+
+  // Returns the serializer of a type and sets "type_name" to its name, or
+  // returns null if there is none.
+  static const PacketSerializer* GetSerializer(size_t type_id,
+                                               std::string* type_name);
+
+  // Returns the serializer registered under "type_name", or null.
+  static const PacketSerializer* GetSerializer(const std::string& type_name);
+};
+
+// Serializes "packet" and its timestamp into "output", which keeps the packet
+// alive. Fails if there is neither a PacketSerializer nor
+// MEDIAPIPE_REGISTER_TYPE serialize functions for the packet's type.
+::mediapipe::Status SerializePacket(const Packet& packet,
+                                    SerializedPacket* output);
+
+// Deserializes a packet serialized by SerializePacket().
+::mediapipe::StatusOr<Packet> DeserializePacket(
+    const SerializedPacketView& input);
+
+// Reads a trivially copyable value from the front of "data" and removes it.
+// Returns false if "data" is too short.
+template <typename T>
+bool ConsumeSerializedValue(absl::string_view* data, T* value) {
+  if (data->size() < sizeof(T)) {
+    return false;
+  }
+  memcpy(value, data->data(), sizeof(T));
+  data->remove_prefix(sizeof(T));
+  return true;
+}
+
+// Serializes protocol buffer messages of type T directly into the output,
+// without an intermediate string.
+template <typename T>
+class ProtoPacketSerializer : public PacketSerializer {
+ public:
+  ::mediapipe::Status Serialize(const Packet& packet,
+                                SerializedPacket* output) const override {
+    const T& message = packet.Get<T>();
+    const size_t size = message.ByteSizeLong();
+    message.SerializeWithCachedSizesToArray(output->AppendBuffer(size));
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::StatusOr<Packet> Deserialize(
+      const SerializedPacketView& input) const override {
+    auto message = absl::make_unique<T>();
+    RET_CHECK(message->ParseFromArray(input.data.data(), input.data.size()))
+        << "Could not parse " << message->GetTypeName() << ".";
+    return Adopt(message.release());
+  }
+};
+
+// Registers "serializer", a PacketSerializer subclass, for "type". As with
+// MEDIAPIPE_REGISTER_TYPE, "type_name" should be the C++ reference of the
+// type with a leading double colon, and a type containing commas should be
+// passed through a macro.
+#define MEDIAPIPE_REGISTER_PACKET_SERIALIZER(type, type_name, serializer) \
+  static const bool MEDIAPIPE_STRING_CONCAT(packet_serializer_, __LINE__, \
+                                            __COUNTER__) =               \
+      ::mediapipe::PacketSerializerRegistry::Register(                    \
+          ::mediapipe::tool::GetTypeHash<                                 \
+              ::mediapipe::type_map_internal::ReflectType<void(           \
+                  type*)>::Type>(),                                       \
+          type_name, ::absl::make_unique<serializer>());
+
+// Registers a ProtoPacketSerializer for the protocol buffer message "type",
+// under its full message name, such as "mediapipe.Detection".
+#define MEDIAPIPE_REGISTER_PROTO_PACKET_SERIALIZER(type)                   \
+  static const bool MEDIAPIPE_STRING_CONCAT(packet_serializer_, __LINE__,  \
+                                            __COUNTER__) =                \
+      ::mediapipe::PacketSerializerRegistry::Register(                     \
+          ::mediapipe::tool::GetTypeHash<type>(), type().GetTypeName(),     \
+          ::absl::make_unique<::mediapipe::ProtoPacketSerializer<type>>());
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PACKET_SERIALIZER_H_
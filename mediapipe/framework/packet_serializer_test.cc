@@ -0,0 +1,152 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/packet_serializer.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/packet_test.pb.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/type_map.h"
+
+namespace mediapipe {
+
+// A type serialized with the functions of MEDIAPIPE_REGISTER_TYPE.
+struct TypeMapSerializedStruct {
+  int value;
+};
+
+namespace {
+
+::mediapipe::Status SerializeStruct(
+    const packet_internal::HolderBase& holder_base, std::string* output) {
+  *output = std::to_string(
+      holder_base.As<TypeMapSerializedStruct>()->data().value);
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status DeserializeStruct(
+    const std::string& encoding,
+    std::unique_ptr<packet_internal::HolderBase>* holder_base) {
+  auto value = absl::make_unique<TypeMapSerializedStruct>();
+  value->value = std::stoi(encoding);
+  *holder_base =
+      absl::make_unique<packet_internal::Holder<TypeMapSerializedStruct>>(
+          value.release());
+  return ::mediapipe::OkStatus();
+}
+
+}  // namespace
+
+MEDIAPIPE_REGISTER_TYPE(::mediapipe::TypeMapSerializedStruct,
+                        "::mediapipe::TypeMapSerializedStruct",
+                        SerializeStruct, DeserializeStruct);
+MEDIAPIPE_REGISTER_PROTO_PACKET_SERIALIZER(::mediapipe::PacketTestProto);
+
+namespace {
+
+struct UnregisteredStruct {};
+
+// Serializes "packet" into a new buffer and deserializes it.
+Packet RoundTrip(const Packet& packet) {
+  SerializedPacket serialized;
+  MP_EXPECT_OK(SerializePacket(packet, &serialized));
+  auto buffer = std::make_shared<std::string>();
+  serialized.AppendTo(buffer.get());
+  EXPECT_EQ(buffer->size(), serialized.size());
+  SerializedPacketView view;
+  view.data = *buffer;
+  view.owner = buffer;
+  auto packet_or = DeserializePacket(view);
+  MP_EXPECT_OK(packet_or.status());
+  return packet_or.ok() ? packet_or.ValueOrDie() : Packet();
+}
+
+TEST(PacketSerializerTest, RoundTripsString) {
+  const Packet packet =
+      MakePacket<std::string>(std::string("a\0b", 3)).At(Timestamp(7));
+  const Packet result = RoundTrip(packet);
+  EXPECT_EQ(result.Timestamp(), Timestamp(7));
+  EXPECT_EQ(result.Get<std::string>(), std::string("a\0b", 3));
+}
+
+TEST(PacketSerializerTest, ReferencesFloatVectorInPlace) {
+  const Packet packet =
+      MakePacket<std::vector<float>>(std::vector<float>{1.5f, -2.0f, 3.25f})
+          .At(Timestamp::PostStream());
+  SerializedPacket serialized;
+  MP_ASSERT_OK(SerializePacket(packet, &serialized));
+  const auto& value = packet.Get<std::vector<float>>();
+  EXPECT_EQ(serialized.chunks().back().data(),
+            reinterpret_cast<const char*>(value.data()));
+
+  const Packet result = RoundTrip(packet);
+  EXPECT_EQ(result.Timestamp(), Timestamp::PostStream());
+  EXPECT_EQ(result.Get<std::vector<float>>(), value);
+}
+
+TEST(PacketSerializerTest, KeepsPacketAlive) {
+  SerializedPacket serialized;
+  {
+    const Packet packet = MakePacket<std::string>(std::string(1000, 'x'));
+    MP_ASSERT_OK(SerializePacket(packet, &serialized));
+  }
+  std::string flattened;
+  serialized.AppendTo(&flattened);
+  EXPECT_EQ(flattened.substr(flattened.size() - 1000), std::string(1000, 'x'));
+}
+
+TEST(PacketSerializerTest, RoundTripsRegisteredProto) {
+  PacketTestProto proto;
+  proto.add_x(123);
+  proto.add_y(456);
+  const Packet result =
+      RoundTrip(MakePacket<PacketTestProto>(proto).At(Timestamp(1)));
+  EXPECT_EQ(result.Get<PacketTestProto>().SerializeAsString(),
+            proto.SerializeAsString());
+}
+
+TEST(PacketSerializerTest, FallsBackToTypeMapSerializeFunctions) {
+  const Packet result = RoundTrip(
+      MakePacket<TypeMapSerializedStruct>(TypeMapSerializedStruct{42}));
+  EXPECT_EQ(result.Get<TypeMapSerializedStruct>().value, 42);
+}
+
+TEST(PacketSerializerTest, FailsForUnregisteredType) {
+  SerializedPacket serialized;
+  EXPECT_FALSE(
+      SerializePacket(MakePacket<UnregisteredStruct>(), &serialized).ok());
+  EXPECT_FALSE(SerializePacket(Packet(), &serialized).ok());
+}
+
+TEST(PacketSerializerTest, FailsForTruncatedPacket) {
+  SerializedPacket serialized;
+  MP_ASSERT_OK(SerializePacket(
+      MakePacket<std::vector<float>>(std::vector<float>{1.0f}), &serialized));
+  std::string buffer;
+  serialized.AppendTo(&buffer);
+  SerializedPacketView view;
+  view.data = absl::string_view(buffer).substr(0, buffer.size() - 1);
+  EXPECT_FALSE(DeserializePacket(view).ok());
+  view.data = absl::string_view(buffer).substr(0, 6);
+  EXPECT_FALSE(DeserializePacket(view).ok());
+}
+
+}  // namespace
+}  // namespace mediapipe
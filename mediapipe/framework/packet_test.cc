@@ -20,8 +20,12 @@
 #include <utility>
 #include <vector>
 
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/packet_test.pb.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/core_proto_inc.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
@@ -339,6 +343,66 @@ TEST(PacketTest, TestPacketConsumeOrCopy) {
   EXPECT_TRUE(packet3.IsEmpty());
 }
 
+TEST(PacketTest, TestPacketConsumeOrCopyImageFrame) {
+  // ImageFrame is not copy constructible, and is copied by CopyPacketData().
+  auto frame = absl::make_unique<ImageFrame>(ImageFormat::SRGB, 4, 3);
+  frame->SetToZero();
+  frame->MutablePixelData()[0] = 7;
+  const uint8* pixel_data = frame->PixelData();
+  Packet packet1 = Adopt(frame.release());
+  Packet packet_copy = packet1;
+  bool was_copied = false;
+  ::mediapipe::StatusOr<std::unique_ptr<ImageFrame>> result1 =
+      packet_copy.ConsumeOrCopy<ImageFrame>(&was_copied);
+  ASSERT_TRUE(result1.ok());
+  EXPECT_TRUE(was_copied);
+  const auto& copy = result1.ValueOrDie();
+  EXPECT_NE(pixel_data, copy->PixelData());
+  EXPECT_EQ(7, copy->PixelData()[0]);
+  EXPECT_EQ(4, copy->Width());
+  EXPECT_EQ(3, copy->Height());
+  EXPECT_TRUE(copy->IsAligned(ImageFrame::kDefaultAlignmentBoundary));
+
+  // packet1 is now the sole owner, and its frame is taken without a copy.
+  ::mediapipe::StatusOr<std::unique_ptr<ImageFrame>> result2 =
+      packet1.ConsumeOrCopy<ImageFrame>(&was_copied);
+  ASSERT_TRUE(result2.ok());
+  EXPECT_FALSE(was_copied);
+  const auto& consumed = result2.ValueOrDie();
+  EXPECT_EQ(pixel_data, consumed->PixelData());
+  EXPECT_TRUE(packet1.IsEmpty());
+}
+
+TEST(PacketTest, TestConsumeMakePacketMovesData) {
+  // MakePacket stores the data inline, so Consume() moves it out.
+  Packet packet = MakePacket<std::unique_ptr<int>>(absl::make_unique<int>(7));
+  const int* data = packet.Get<std::unique_ptr<int>>().get();
+  ::mediapipe::StatusOr<std::unique_ptr<std::unique_ptr<int>>> result =
+      packet.Consume<std::unique_ptr<int>>();
+  MP_ASSERT_OK(result);
+  EXPECT_EQ(data, result.ValueOrDie()->get());
+  EXPECT_EQ(7, **result.ValueOrDie());
+  EXPECT_TRUE(packet.IsEmpty());
+
+  // Adopt keeps the caller's allocation and hands back the same pointer.
+  int* adopted = new int(8);
+  Packet adopted_packet = Adopt(adopted);
+  ::mediapipe::StatusOr<std::unique_ptr<int>> adopted_result =
+      adopted_packet.Consume<int>();
+  MP_ASSERT_OK(adopted_result);
+  EXPECT_EQ(adopted, adopted_result.ValueOrDie().get());
+}
+
+TEST(PacketTest, TestConsumeMakePacketNotMovable) {
+  Packet packet = MakePacket<absl::Mutex>();
+  ::mediapipe::StatusOr<std::unique_ptr<absl::Mutex>> result =
+      packet.Consume<absl::Mutex>();
+  EXPECT_FALSE(result.ok());
+  EXPECT_THAT(result.status().message(),
+              testing::HasSubstr("not move-constructible"));
+  EXPECT_FALSE(packet.IsEmpty());
+}
+
 TEST(PacketTest, TestConsumeForeignHolder) {
   std::unique_ptr<int> data(new int(33));
   Packet packet = PointToForeign(data.get());
@@ -455,5 +519,40 @@ TEST(PacketTest, TestConsumeOrCopyBoundedArray) {
   EXPECT_TRUE(packet2.IsEmpty());
 }
 
+void BM_MakePacket(benchmark::State& state) {
+  for (auto _ : state) {
+    Packet packet = MakePacket<int>(1);
+    benchmark::DoNotOptimize(packet);
+  }
+}
+BENCHMARK(BM_MakePacket);
+
+void BM_AdoptPacket(benchmark::State& state) {
+  for (auto _ : state) {
+    Packet packet = Adopt(new int(1));
+    benchmark::DoNotOptimize(packet);
+  }
+}
+BENCHMARK(BM_AdoptPacket);
+
+void BM_PacketAt(benchmark::State& state) {
+  Packet packet = MakePacket<int>(1);
+  int64 timestamp = 0;
+  for (auto _ : state) {
+    Packet timestamped = packet.At(Timestamp(timestamp++));
+    benchmark::DoNotOptimize(timestamped);
+  }
+}
+BENCHMARK(BM_PacketAt);
+
+void BM_PacketCopy(benchmark::State& state) {
+  Packet packet = MakePacket<int>(1).At(Timestamp(0));
+  for (auto _ : state) {
+    Packet copy = packet;
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK(BM_PacketCopy);
+
 }  // namespace
 }  // namespace mediapipe
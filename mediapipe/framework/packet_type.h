@@ -77,6 +77,10 @@ class PacketType {
   bool IsAny() const;
   // Returns true if this PacketType allows nothing.
   bool IsNone() const;
+  // Returns true if this PacketType was set with Set<T>(), directly or
+  // through SetSameAs(), so that every packet it validates holds a T.
+  template <typename T>
+  bool IsExactType() const;
   bool IsOptional() const { return optional_; }
 
   // Returns true iff this and other are consistent, meaning they do
@@ -236,6 +240,13 @@ PacketType& PacketType::Set() {
   return *this;
 }
 
+template <typename T>
+bool PacketType::IsExactType() const {
+  const PacketType* root = GetSameAs();
+  return root->initialized_ && !root->no_packets_allowed_ &&
+         root->validate_method_ == &Packet::ValidateAsType<T>;
+}
+
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_FRAMEWORK_PACKET_TYPE_H_
@@ -0,0 +1,170 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/chrome_trace_writer.h"
+
+#include <map>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+
+namespace mediapipe {
+
+namespace {
+
+// The trace event process ids of the CPU and GPU tracks.
+constexpr int kCpuPid = 1;
+constexpr int kGpuPid = 2;
+
+// Where an event is drawn in the trace viewer.
+struct TrackPoint {
+  int pid;
+  int tid;
+  int64 ts;
+};
+
+// Returns "value" as a quoted JSON string.
+std::string JsonString(const std::string& value) {
+  std::string result = "\"";
+  for (char c : value) {
+    switch (c) {
+      case '"':
+        result += "\\\"";
+        break;
+      case '\\':
+        result += "\\\\";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          absl::StrAppendFormat(&result, "\\u%04x", static_cast<int>(c));
+        } else {
+          result += c;
+        }
+    }
+  }
+  result += "\"";
+  return result;
+}
+
+bool IsGpuEvent(GraphTrace::EventType event_type) {
+  return event_type == GraphTrace::GPU_TASK ||
+         event_type == GraphTrace::GPU_CALIBRATION;
+}
+
+// Returns true for the input stream handler events, which mark a moment
+// rather than the start or finish of a task.
+bool IsInstantEvent(GraphTrace::EventType event_type) {
+  return event_type >= GraphTrace::NOT_READY &&
+         event_type <= GraphTrace::UNTHROTTLED;
+}
+
+// Returns the track and time at which a CalculatorTrace is drawn.
+TrackPoint GetTrackPoint(const GraphTrace& trace,
+                         const GraphTrace::CalculatorTrace& event) {
+  int64 time =
+      event.has_start_time() ? event.start_time() : event.finish_time();
+  return {IsGpuEvent(event.event_type()) ? kGpuPid : kCpuPid,
+          event.thread_id(), trace.base_time() + time};
+}
+
+// Appends the fields common to all trace events.
+void AppendEventFields(const std::string& name, const std::string& category,
+                       const char* phase, const TrackPoint& point,
+                       std::string* output) {
+  absl::StrAppend(output, "{\"name\":", JsonString(name),
+                  ",\"cat\":", JsonString(category), ",\"ph\":\"", phase,
+                  "\",\"pid\":", point.pid, ",\"tid\":", point.tid,
+                  ",\"ts\":", point.ts);
+}
+
+}  // namespace
+
+std::string ChromeTraceWriter::FileHeader() {
+  std::string result = "[\n";
+  for (const auto& process :
+       {std::make_pair(kCpuPid, "CPU"), std::make_pair(kGpuPid, "GPU")}) {
+    absl::StrAppend(&result,
+                    "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":",
+                    process.first, ",\"args\":{\"name\":\"", process.second,
+                    "\"}},\n");
+  }
+  return result;
+}
+
+void ChromeTraceWriter::AppendTrace(
+    const GraphTrace& trace, const std::vector<std::string>& calculator_names,
+    std::string* output) {
+  // Index the output packets by stream and timestamp, to find the producer
+  // of each input packet.
+  std::map<std::pair<int32, int64>, TrackPoint> producers;
+  for (const auto& event : trace.calculator_trace()) {
+    for (const auto& stream_trace : event.output_trace()) {
+      producers[{stream_trace.stream_id(), stream_trace.packet_timestamp()}] =
+          GetTrackPoint(trace, event);
+    }
+  }
+
+  for (const auto& event : trace.calculator_trace()) {
+    const GraphTrace::EventType event_type = event.event_type();
+    const std::string category = GraphTrace::EventType_Name(event_type);
+    const int node_id = event.node_id();
+    const std::string name =
+        (node_id >= 0 && node_id < static_cast<int>(calculator_names.size()))
+            ? calculator_names[node_id]
+            : category;
+    const TrackPoint point = GetTrackPoint(trace, event);
+
+    const char* phase;
+    if (event.has_start_time() && event.has_finish_time()) {
+      phase = "X";
+    } else if (IsInstantEvent(event_type)) {
+      phase = "i";
+    } else {
+      phase = event.has_start_time() ? "B" : "E";
+    }
+    AppendEventFields(name, category, phase, point, output);
+    if (*phase == 'X') {
+      absl::StrAppend(output, ",\"dur\":",
+                      event.finish_time() - event.start_time());
+    } else if (*phase == 'i') {
+      absl::StrAppend(output, ",\"s\":\"t\"");
+    }
+    if (event.has_input_timestamp()) {
+      absl::StrAppend(output, ",\"args\":{\"input_timestamp\":",
+                      trace.base_timestamp() + event.input_timestamp(), "}");
+    }
+    absl::StrAppend(output, "},\n");
+
+    // Link each input packet to the event that produced it.
+    for (const auto& stream_trace : event.input_trace()) {
+      auto producer = producers.find(
+          {stream_trace.stream_id(), stream_trace.packet_timestamp()});
+      if (producer == producers.end()) {
+        continue;
+      }
+      const std::string stream_name =
+          stream_trace.stream_id() < trace.stream_name_size()
+              ? trace.stream_name(stream_trace.stream_id())
+              : "packet";
+      const int64 flow_id = next_flow_id_++;
+      AppendEventFields(stream_name, "packet", "s", producer->second, output);
+      absl::StrAppend(output, ",\"id\":", flow_id, "},\n");
+      AppendEventFields(stream_name, "packet", "f", point, output);
+      absl::StrAppend(output, ",\"bp\":\"e\",\"id\":", flow_id, "},\n");
+    }
+  }
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,54 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PROFILER_CHROME_TRACE_WRITER_H_
+#define MEDIAPIPE_FRAMEWORK_PROFILER_CHROME_TRACE_WRITER_H_
+
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+
+// Converts GraphTraces into the Chrome trace event JSON format, which
+// chrome://tracing and ui.perfetto.dev load directly.
+//
+// CPU events are placed on one track per tracer thread id, and GPU_TASK and
+// GPU_CALIBRATION events on a separate "GPU" process. Each input packet whose
+// producing event is in the same GraphTrace is linked to it by a flow arrow.
+//
+// The output is a JSON array that is never closed, so that successive
+// GraphTraces can be appended to the same file as they are recorded. Both
+// trace viewers accept such a truncated array.
+class ChromeTraceWriter {
+ public:
+  // Returns the start of a trace file, including the track names.
+  static std::string FileHeader();
+
+  // Appends the events of "trace" to "output", one JSON object per line.
+  // "calculator_names" is indexed by CalculatorTrace::node_id.
+  void AppendTrace(const GraphTrace& trace,
+                   const std::vector<std::string>& calculator_names,
+                   std::string* output);
+
+ private:
+  // The id of the next flow arrow, unique within a trace file.
+  int64 next_flow_id_ = 0;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PROFILER_CHROME_TRACE_WRITER_H_
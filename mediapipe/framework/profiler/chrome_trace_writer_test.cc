@@ -0,0 +1,127 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/chrome_trace_writer.h"
+
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(ChromeTraceWriterTest, FileHeaderNamesTracks) {
+  EXPECT_EQ(
+      "[\n"
+      R"({"name":"process_name","ph":"M","pid":1,"args":{"name":"CPU"}},)"
+      "\n"
+      R"({"name":"process_name","ph":"M","pid":2,"args":{"name":"GPU"}},)"
+      "\n",
+      ChromeTraceWriter::FileHeader());
+}
+
+TEST(ChromeTraceWriterTest, TraceWithFlowsAndGpuTasks) {
+  GraphTrace trace = ParseTextProtoOrDie<GraphTrace>(R"(
+    base_time: 1000
+    base_timestamp: 5000
+    stream_name: ""
+    stream_name: "frames"
+    calculator_trace {
+      node_id: 0
+      input_timestamp: 0
+      event_type: PROCESS
+      start_time: 0
+      finish_time: 100
+      output_trace { packet_timestamp: 0 stream_id: 1 }
+      thread_id: 1
+    }
+    calculator_trace {
+      node_id: 1
+      input_timestamp: 0
+      event_type: PROCESS
+      start_time: 150
+      finish_time: 300
+      input_trace {
+        start_time: 100
+        finish_time: 150
+        packet_timestamp: 0
+        stream_id: 1
+        packet_id: 0
+      }
+      thread_id: 2
+    }
+    calculator_trace {
+      node_id: 1
+      input_timestamp: 0
+      event_type: GPU_TASK
+      start_time: 200
+      finish_time: 400
+      thread_id: 2
+    }
+  )");
+  ChromeTraceWriter writer;
+  std::string output;
+  writer.AppendTrace(trace, {"source", "sink"}, &output);
+  EXPECT_EQ(
+      R"({"name":"source","cat":"PROCESS","ph":"X","pid":1,"tid":1,)"
+      R"("ts":1000,"dur":100,"args":{"input_timestamp":5000}},)"
+      "\n"
+      R"({"name":"sink","cat":"PROCESS","ph":"X","pid":1,"tid":2,)"
+      R"("ts":1150,"dur":150,"args":{"input_timestamp":5000}},)"
+      "\n"
+      R"({"name":"frames","cat":"packet","ph":"s","pid":1,"tid":1,)"
+      R"("ts":1000,"id":0},)"
+      "\n"
+      R"({"name":"frames","cat":"packet","ph":"f","pid":1,"tid":2,)"
+      R"("ts":1150,"bp":"e","id":0},)"
+      "\n"
+      R"({"name":"sink","cat":"GPU_TASK","ph":"X","pid":2,"tid":2,)"
+      R"("ts":1200,"dur":200,"args":{"input_timestamp":5000}},)"
+      "\n",
+      output);
+
+  // Flow ids continue across traces.
+  output.clear();
+  writer.AppendTrace(trace, {"source", "sink"}, &output);
+  EXPECT_NE(std::string::npos, output.find(R"("id":1})"));
+}
+
+TEST(ChromeTraceWriterTest, LogWithDurationAndInstantEvents) {
+  GraphTrace trace = ParseTextProtoOrDie<GraphTrace>(R"(
+    base_time: 1000
+    calculator_trace { node_id: 0 event_type: PROCESS start_time: 10 }
+    calculator_trace { node_id: 0 event_type: NOT_READY start_time: 15 }
+    calculator_trace { node_id: 0 event_type: PROCESS finish_time: 20 }
+  )");
+  ChromeTraceWriter writer;
+  std::string output;
+  writer.AppendTrace(trace, {"a \"quoted\" name"}, &output);
+  EXPECT_EQ(
+      R"({"name":"a \"quoted\" name","cat":"PROCESS","ph":"B","pid":1,)"
+      R"("tid":0,"ts":1010},)"
+      "\n"
+      R"({"name":"a \"quoted\" name","cat":"NOT_READY","ph":"i","pid":1,)"
+      R"("tid":0,"ts":1015,"s":"t"},)"
+      "\n"
+      R"({"name":"a \"quoted\" name","cat":"PROCESS","ph":"E","pid":1,)"
+      R"("tid":0,"ts":1020},)"
+      "\n",
+      output);
+}
+
+}  // namespace
+}  // namespace mediapipe
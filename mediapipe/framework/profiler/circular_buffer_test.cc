@@ -15,6 +15,7 @@
 #include "mediapipe/framework/profiler/circular_buffer.h"
 
 #include "absl/time/time.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/threadpool.h"
 
@@ -106,4 +107,24 @@ TEST_F(CircularBufferTest, SequentialGetWraps) {
   }
 }
 
+void BM_PushBack(benchmark::State& state) {
+  mediapipe::CircularBuffer<int64> buffer(1000);
+  int64 value = 0;
+  for (auto _ : state) {
+    buffer.push_back(value++);
+  }
+}
+BENCHMARK(BM_PushBack);
+
+// Pushes from several threads at once, as the profiler does when calculators
+// run in parallel.
+void BM_PushBackThreaded(benchmark::State& state) {
+  static auto* buffer = new mediapipe::CircularBuffer<int64>(1000);
+  int64 value = 0;
+  for (auto _ : state) {
+    buffer->push_back(value++);
+  }
+}
+BENCHMARK(BM_PushBackThreaded)->ThreadRange(1, 8);
+
 }  // namespace
@@ -0,0 +1,215 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/compact_graph_trace.h"
+
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+
+namespace {
+
+// The bits of CompactGraphTrace::field_mask.
+enum CalculatorTraceField {
+  kInputTimestamp = 1,
+  kStartTime = 2,
+  kFinishTime = 4,
+  kThreadId = 8,
+};
+
+// The bits of CompactGraphTrace::stream_field_mask.
+enum StreamTraceField {
+  kStreamId = 1,
+  kPacketTimestamp = 2,
+  kStreamStartTime = 4,
+  kStreamFinishTime = 8,
+  kPacketId = 16,
+};
+
+// The previous values the deltas are taken from.
+struct DeltaState {
+  int64 input_timestamp = 0;
+  int64 time = 0;
+  int64 packet_id = 0;
+};
+
+void CompactStreamTrace(const GraphTrace::StreamTrace& stream_trace,
+                        DeltaState* state, CompactGraphTrace* result) {
+  uint32 mask = 0;
+  if (stream_trace.has_stream_id()) {
+    mask |= kStreamId;
+    result->add_stream_id(stream_trace.stream_id());
+  }
+  if (stream_trace.has_packet_timestamp()) {
+    mask |= kPacketTimestamp;
+    result->add_packet_timestamp_delta(stream_trace.packet_timestamp() -
+                                       state->input_timestamp);
+  }
+  if (stream_trace.has_start_time()) {
+    mask |= kStreamStartTime;
+    result->add_stream_time_delta(stream_trace.start_time() - state->time);
+  }
+  if (stream_trace.has_finish_time()) {
+    mask |= kStreamFinishTime;
+    result->add_stream_time_delta(stream_trace.finish_time() - state->time);
+  }
+  if (stream_trace.has_packet_id()) {
+    mask |= kPacketId;
+    result->add_packet_id_delta(stream_trace.packet_id() - state->packet_id);
+    state->packet_id = stream_trace.packet_id();
+  }
+  result->add_stream_field_mask(mask);
+}
+
+// Reads the columns of a CompactGraphTrace in order.
+class CompactTraceReader {
+ public:
+  explicit CompactTraceReader(const CompactGraphTrace& compact)
+      : compact_(compact) {}
+
+  void ReadCalculatorTrace(int index, GraphTrace::CalculatorTrace* result) {
+    const uint32 mask = compact_.field_mask(index);
+    result->set_node_id(compact_.node_id(index));
+    result->set_event_type(
+        static_cast<GraphTrace::EventType>(compact_.event_type(index)));
+    if (mask & kThreadId) {
+      result->set_thread_id(compact_.thread_id(thread_id_index_++));
+    }
+    if (mask & kInputTimestamp) {
+      state_.input_timestamp +=
+          compact_.input_timestamp_delta(input_timestamp_index_++);
+      result->set_input_timestamp(state_.input_timestamp);
+    }
+    if (mask & kStartTime) {
+      state_.time += compact_.time_delta(time_index_++);
+      result->set_start_time(state_.time);
+    }
+    if (mask & kFinishTime) {
+      state_.time += compact_.time_delta(time_index_++);
+      result->set_finish_time(state_.time);
+    }
+    for (int i = 0; i < compact_.num_input_traces(index); ++i) {
+      ReadStreamTrace(result->add_input_trace());
+    }
+    for (int i = 0; i < compact_.num_output_traces(index); ++i) {
+      ReadStreamTrace(result->add_output_trace());
+    }
+  }
+
+ private:
+  void ReadStreamTrace(GraphTrace::StreamTrace* result) {
+    const uint32 mask = compact_.stream_field_mask(stream_index_++);
+    if (mask & kStreamId) {
+      result->set_stream_id(compact_.stream_id(stream_id_index_++));
+    }
+    if (mask & kPacketTimestamp) {
+      result->set_packet_timestamp(
+          state_.input_timestamp +
+          compact_.packet_timestamp_delta(packet_timestamp_index_++));
+    }
+    if (mask & kStreamStartTime) {
+      result->set_start_time(state_.time +
+                             compact_.stream_time_delta(stream_time_index_++));
+    }
+    if (mask & kStreamFinishTime) {
+      result->set_finish_time(
+          state_.time + compact_.stream_time_delta(stream_time_index_++));
+    }
+    if (mask & kPacketId) {
+      state_.packet_id += compact_.packet_id_delta(packet_id_index_++);
+      result->set_packet_id(state_.packet_id);
+    }
+  }
+
+  const CompactGraphTrace& compact_;
+  DeltaState state_;
+  int thread_id_index_ = 0;
+  int input_timestamp_index_ = 0;
+  int time_index_ = 0;
+  int stream_index_ = 0;
+  int stream_id_index_ = 0;
+  int packet_timestamp_index_ = 0;
+  int stream_time_index_ = 0;
+  int packet_id_index_ = 0;
+};
+
+}  // namespace
+
+void CompactTrace(const GraphTrace& trace, CompactGraphTrace* result) {
+  result->Clear();
+  if (trace.has_base_time()) result->set_base_time(trace.base_time());
+  if (trace.has_base_timestamp()) {
+    result->set_base_timestamp(trace.base_timestamp());
+  }
+  *result->mutable_calculator_name() = trace.calculator_name();
+  *result->mutable_stream_name() = trace.stream_name();
+  DeltaState state;
+  for (const GraphTrace::CalculatorTrace& record : trace.calculator_trace()) {
+    uint32 mask = 0;
+    result->add_node_id(record.node_id());
+    result->add_event_type(record.event_type());
+    if (record.has_thread_id()) {
+      mask |= kThreadId;
+      result->add_thread_id(record.thread_id());
+    }
+    if (record.has_input_timestamp()) {
+      mask |= kInputTimestamp;
+      result->add_input_timestamp_delta(record.input_timestamp() -
+                                        state.input_timestamp);
+      state.input_timestamp = record.input_timestamp();
+    }
+    if (record.has_start_time()) {
+      mask |= kStartTime;
+      result->add_time_delta(record.start_time() - state.time);
+      state.time = record.start_time();
+    }
+    if (record.has_finish_time()) {
+      mask |= kFinishTime;
+      result->add_time_delta(record.finish_time() - state.time);
+      state.time = record.finish_time();
+    }
+    result->add_field_mask(mask);
+    result->add_num_input_traces(record.input_trace_size());
+    result->add_num_output_traces(record.output_trace_size());
+    for (const GraphTrace::StreamTrace& input : record.input_trace()) {
+      CompactStreamTrace(input, &state, result);
+    }
+    for (const GraphTrace::StreamTrace& output : record.output_trace()) {
+      CompactStreamTrace(output, &state, result);
+    }
+  }
+}
+
+void ExpandTrace(const CompactGraphTrace& compact, GraphTrace* result) {
+  result->Clear();
+  if (compact.has_base_time()) result->set_base_time(compact.base_time());
+  if (compact.has_base_timestamp()) {
+    result->set_base_timestamp(compact.base_timestamp());
+  }
+  *result->mutable_calculator_name() = compact.calculator_name();
+  *result->mutable_stream_name() = compact.stream_name();
+  CompactTraceReader reader(compact);
+  for (int i = 0; i < compact.field_mask_size(); ++i) {
+    reader.ReadCalculatorTrace(i, result->add_calculator_trace());
+  }
+}
+
+void ExpandTraces(GraphProfile* profile) {
+  for (const CompactGraphTrace& compact : profile->compact_graph_trace()) {
+    ExpandTrace(compact, profile->add_graph_trace());
+  }
+  profile->clear_compact_graph_trace();
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,36 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PROFILER_COMPACT_GRAPH_TRACE_H_
+#define MEDIAPIPE_FRAMEWORK_PROFILER_COMPACT_GRAPH_TRACE_H_
+
+#include "mediapipe/framework/calculator_profile.pb.h"
+
+namespace mediapipe {
+
+// Converts "trace" into the delta encoded, column-wise CompactGraphTrace
+// written by the COMPACT_BINARYPB trace log format. The conversion is
+// lossless: ExpandTrace() restores "trace" exactly.
+void CompactTrace(const GraphTrace& trace, CompactGraphTrace* result);
+
+// Converts "compact" back into a GraphTrace.
+void ExpandTrace(const CompactGraphTrace& compact, GraphTrace* result);
+
+// Moves the compact_graph_traces of "profile", as read from a
+// COMPACT_BINARYPB trace log, into its graph_traces, after any present.
+void ExpandTraces(GraphProfile* profile);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PROFILER_COMPACT_GRAPH_TRACE_H_
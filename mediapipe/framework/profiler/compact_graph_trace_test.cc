@@ -0,0 +1,111 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/compact_graph_trace.h"
+
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+
+namespace mediapipe {
+namespace {
+
+GraphTrace SampleTrace() {
+  return ParseTextProtoOrDie<GraphTrace>(R"(
+    base_time: 1570000000000000
+    base_timestamp: 1000000
+    calculator_name: "source"
+    calculator_name: "sink"
+    stream_name: ""
+    stream_name: "frames"
+    calculator_trace {
+      node_id: 0
+      input_timestamp: 0
+      event_type: PROCESS
+      start_time: 10
+      finish_time: 110
+      output_trace { packet_timestamp: 0 stream_id: 1 }
+      thread_id: 3
+    }
+    calculator_trace {
+      node_id: 1
+      input_timestamp: 0
+      event_type: PROCESS
+      start_time: 150
+      input_trace {
+        start_time: 110
+        finish_time: 150
+        packet_timestamp: 0
+        stream_id: 1
+        packet_id: 7
+      }
+      thread_id: 4
+    }
+    calculator_trace {
+      node_id: 1
+      input_timestamp: 33333
+      event_type: PROCESS
+      finish_time: 90
+      thread_id: 4
+    }
+    calculator_trace { node_id: 1 event_type: GPU_TASK start_time: 95 }
+  )");
+}
+
+TEST(CompactGraphTraceTest, RoundTrip) {
+  GraphTrace trace = SampleTrace();
+  CompactGraphTrace compact;
+  CompactTrace(trace, &compact);
+  EXPECT_EQ(4, compact.field_mask_size());
+  EXPECT_EQ(2, compact.stream_field_mask_size());
+
+  GraphTrace expanded;
+  ExpandTrace(compact, &expanded);
+  EXPECT_EQ(trace.DebugString(), expanded.DebugString());
+}
+
+TEST(CompactGraphTraceTest, ExpandTracesInProfile) {
+  GraphProfile profile;
+  CompactTrace(SampleTrace(), profile.add_compact_graph_trace());
+  ExpandTraces(&profile);
+  EXPECT_EQ(0, profile.compact_graph_trace_size());
+  ASSERT_EQ(1, profile.graph_trace_size());
+  EXPECT_EQ(SampleTrace().DebugString(), profile.graph_trace(0).DebugString());
+}
+
+TEST(CompactGraphTraceTest, SmallerThanGraphTrace) {
+  GraphTrace trace;
+  trace.set_base_time(1570000000000000);
+  for (int i = 0; i < 1000; ++i) {
+    GraphTrace::CalculatorTrace* record = trace.add_calculator_trace();
+    record->set_node_id(i % 4);
+    record->set_event_type(GraphTrace::PROCESS);
+    record->set_input_timestamp(i * 33333);
+    record->set_start_time(i * 33333 + 100);
+    record->set_finish_time(i * 33333 + 2100);
+    record->set_thread_id(1);
+    GraphTrace::StreamTrace* input = record->add_input_trace();
+    input->set_stream_id(i % 4);
+    input->set_packet_timestamp(i * 33333);
+    input->set_start_time(i * 33333 + 50);
+    input->set_finish_time(i * 33333 + 100);
+    input->set_packet_id(i);
+  }
+  CompactGraphTrace compact;
+  CompactTrace(trace, &compact);
+  EXPECT_LT(compact.ByteSizeLong() * 2, trace.ByteSizeLong());
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,226 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/critical_path_analyzer.h"
+
+#include <algorithm>
+#include <set>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "mediapipe/framework/profiler/compact_graph_trace.h"
+
+namespace mediapipe {
+
+void CriticalPathAnalyzer::AddProfile(const GraphProfile& profile) {
+  if (profile.config().node_size() > 0) {
+    node_names_.clear();
+    for (const auto& node : profile.config().node()) {
+      node_names_.push_back(node.name());
+    }
+  }
+  for (const GraphTrace& trace : profile.graph_trace()) {
+    AddTrace(trace);
+  }
+  for (const CompactGraphTrace& compact : profile.compact_graph_trace()) {
+    GraphTrace trace;
+    ExpandTrace(compact, &trace);
+    AddTrace(trace);
+  }
+}
+
+void CriticalPathAnalyzer::AddTrace(const GraphTrace& trace) {
+  const int64 base_time = trace.base_time();
+  const int64 base_timestamp = trace.base_timestamp();
+  for (const GraphTrace::CalculatorTrace& record : trace.calculator_trace()) {
+    const CallKey key(record.node_id(),
+                      record.input_timestamp() + base_timestamp);
+    if (record.event_type() == GraphTrace::GPU_TASK) {
+      if (record.has_start_time() && record.has_finish_time()) {
+        gpu_usec_[key] += record.finish_time() - record.start_time();
+      } else if (record.has_start_time()) {
+        gpu_task_starts_[key] = record.start_time() + base_time;
+      } else if (record.has_finish_time()) {
+        auto start = gpu_task_starts_.find(key);
+        if (start != gpu_task_starts_.end()) {
+          gpu_usec_[key] += record.finish_time() + base_time - start->second;
+          gpu_task_starts_.erase(start);
+        }
+      }
+      continue;
+    }
+    if (record.event_type() != GraphTrace::PROCESS) {
+      continue;
+    }
+    Call& call = calls_[key];
+    call.node_id = key.first;
+    call.input_timestamp = key.second;
+    if (record.has_start_time()) {
+      const int64 start_time = record.start_time() + base_time;
+      call.start_time = call.start_time < 0
+                            ? start_time
+                            : std::min(call.start_time, start_time);
+    }
+    if (record.has_finish_time()) {
+      call.finish_time =
+          std::max(call.finish_time, record.finish_time() + base_time);
+    }
+    for (const GraphTrace::StreamTrace& input : record.input_trace()) {
+      call.inputs.emplace_back(input.stream_id(),
+                               input.packet_timestamp() + base_timestamp);
+    }
+    for (const GraphTrace::StreamTrace& output : record.output_trace()) {
+      producers_[PacketKey(output.stream_id(),
+                           output.packet_timestamp() + base_timestamp)] = key;
+    }
+  }
+}
+
+std::vector<CriticalPathAnalyzer::CriticalPath>
+CriticalPathAnalyzer::CriticalPaths() const {
+  // The last call to finish for each input timestamp.
+  std::map<int64, const Call*> last_calls;
+  for (const auto& entry : calls_) {
+    const Call& call = entry.second;
+    if (call.start_time < 0 || call.finish_time < 0) continue;
+    const Call*& last = last_calls[call.input_timestamp];
+    if (last == nullptr || call.finish_time > last->finish_time) {
+      last = &call;
+    }
+  }
+
+  std::vector<CriticalPath> paths;
+  for (const auto& entry : last_calls) {
+    CriticalPath path;
+    path.input_timestamp = entry.first;
+    std::set<CallKey> visited;
+    const Call* call = entry.second;
+    int64 first_arrival = call->start_time;
+    while (call != nullptr) {
+      visited.insert(CallKey(call->node_id, call->input_timestamp));
+      // Finds the call that output the last arriving input packet.
+      const Call* producer = nullptr;
+      for (const PacketKey& input : call->inputs) {
+        auto producer_key = producers_.find(input);
+        if (producer_key == producers_.end() ||
+            visited.count(producer_key->second) > 0) {
+          continue;
+        }
+        auto candidate = calls_.find(producer_key->second);
+        if (candidate == calls_.end() || candidate->second.start_time < 0 ||
+            candidate->second.finish_time < 0 ||
+            candidate->second.finish_time > call->start_time) {
+          continue;
+        }
+        if (producer == nullptr ||
+            candidate->second.finish_time > producer->finish_time) {
+          producer = &candidate->second;
+        }
+      }
+
+      Step step;
+      step.node_id = call->node_id;
+      step.input_timestamp = call->input_timestamp;
+      step.process_usec = call->finish_time - call->start_time;
+      const CallKey key(call->node_id, call->input_timestamp);
+      auto gpu_usec = gpu_usec_.find(key);
+      if (gpu_usec != gpu_usec_.end()) {
+        step.gpu_usec = gpu_usec->second;
+      }
+      if (producer != nullptr) {
+        step.queue_usec = call->start_time - producer->finish_time;
+      }
+      first_arrival = call->start_time - step.queue_usec;
+      path.steps.push_back(step);
+      call = producer;
+    }
+    std::reverse(path.steps.begin(), path.steps.end());
+    path.latency_usec = entry.second->finish_time - first_arrival;
+    paths.push_back(std::move(path));
+  }
+  return paths;
+}
+
+std::vector<CriticalPathAnalyzer::NodeStats>
+CriticalPathAnalyzer::NodeStatistics() const {
+  std::map<int, NodeStats> stats_by_node;
+  for (const CriticalPath& path : CriticalPaths()) {
+    std::set<int> nodes_on_path;
+    for (const Step& step : path.steps) {
+      NodeStats& stats = stats_by_node[step.node_id];
+      if (nodes_on_path.insert(step.node_id).second) {
+        ++stats.num_paths;
+      }
+      stats.queue_usec += step.queue_usec;
+      stats.process_usec += step.process_usec;
+      stats.gpu_usec += step.gpu_usec;
+    }
+    if (!path.steps.empty()) {
+      ++stats_by_node[path.steps.back().node_id].num_last;
+    }
+  }
+
+  std::vector<NodeStats> result;
+  for (auto& entry : stats_by_node) {
+    entry.second.name = NodeName(entry.first);
+    result.push_back(std::move(entry.second));
+  }
+  std::stable_sort(result.begin(), result.end(),
+                   [](const NodeStats& a, const NodeStats& b) {
+                     return a.queue_usec + a.process_usec >
+                            b.queue_usec + b.process_usec;
+                   });
+  return result;
+}
+
+std::string CriticalPathAnalyzer::Summary() const {
+  const std::vector<CriticalPath> paths = CriticalPaths();
+  int64 total_latency_usec = 0;
+  for (const CriticalPath& path : paths) {
+    total_latency_usec += path.latency_usec;
+  }
+  std::string result = absl::StrFormat(
+      "%d input timestamps, mean critical path latency %.1f ms\n",
+      paths.size(),
+      paths.empty() ? 0.0 : total_latency_usec / 1000.0 / paths.size());
+  absl::StrAppendFormat(&result, "%-40s %8s %8s %10s %10s %10s %8s\n", "node",
+                        "on_path", "last", "queue_ms", "process_ms", "gpu_ms",
+                        "share");
+  for (const NodeStats& stats : NodeStatistics()) {
+    // The means are over the paths the node is on.
+    const double num_paths = std::max<int64>(stats.num_paths, 1);
+    const double share =
+        total_latency_usec == 0
+            ? 0.0
+            : 100.0 * (stats.queue_usec + stats.process_usec) /
+                  total_latency_usec;
+    absl::StrAppendFormat(
+        &result, "%-40s %7.1f%% %7.1f%% %10.2f %10.2f %10.2f %7.1f%%\n",
+        stats.name, 100.0 * stats.num_paths / paths.size(),
+        100.0 * stats.num_last / paths.size(),
+        stats.queue_usec / 1000.0 / num_paths,
+        stats.process_usec / 1000.0 / num_paths,
+        stats.gpu_usec / 1000.0 / num_paths, share);
+  }
+  return result;
+}
+
+std::string CriticalPathAnalyzer::NodeName(int node_id) const {
+  if (node_id >= 0 && node_id < node_names_.size()) {
+    return node_names_[node_id];
+  }
+  return absl::StrCat("node_", node_id);
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,125 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PROFILER_CRITICAL_PATH_ANALYZER_H_
+#define MEDIAPIPE_FRAMEWORK_PROFILER_CRITICAL_PATH_ANALYZER_H_
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+
+// Reconstructs, from the GraphTraces written to trace_log_path, the chain of
+// Process() calls that determined the latency of each input timestamp, and
+// aggregates how often and how long each node is on these critical paths.
+//
+// The critical path of an input timestamp ends with the last Process() call
+// to finish for that timestamp. Each call on the path is preceded by the call
+// that produced its last arriving input packet, until a call whose inputs
+// were not produced by a traced call, such as one fed by a graph input
+// stream. Each step is split into the time its inputs waited in the queue,
+// its Process() time, and the GPU time of the GL tasks it issued, if traced
+// with enable_gpu_timer_queries.
+//
+// Both the default traces and the trace_log_duration_events logs are
+// accepted. Calls split across successive GraphTraces are merged.
+class CriticalPathAnalyzer {
+ public:
+  // One Process() call on a critical path. Times are in microseconds.
+  struct Step {
+    int node_id = 0;
+    int64 input_timestamp = 0;
+    // From the arrival of the last input packet to the start of Process().
+    int64 queue_usec = 0;
+    int64 process_usec = 0;
+    int64 gpu_usec = 0;
+  };
+
+  // The critical path of one input timestamp, upstream steps first.
+  struct CriticalPath {
+    int64 input_timestamp = 0;
+    // From the arrival of the first step's inputs, or its start if unknown,
+    // to the finish of the last step.
+    int64 latency_usec = 0;
+    std::vector<Step> steps;
+  };
+
+  // The critical path statistics of one node.
+  struct NodeStats {
+    std::string name;
+    // The number of critical paths the node is on.
+    int64 num_paths = 0;
+    // The number of critical paths the node ends.
+    int64 num_last = 0;
+    // The times the node spent on critical paths.
+    int64 queue_usec = 0;
+    int64 process_usec = 0;
+    int64 gpu_usec = 0;
+  };
+
+  // Adds the GraphTraces and CompactGraphTraces of "profile", as read from a
+  // trace log file, and takes the node names from its config if present.
+  void AddProfile(const GraphProfile& profile);
+
+  // Adds the calls traced in "trace". Times and timestamps are reported
+  // with the base_time and base_timestamp of the trace added back.
+  void AddTrace(const GraphTrace& trace);
+
+  // Returns the critical path of every traced input timestamp, in timestamp
+  // order.
+  std::vector<CriticalPath> CriticalPaths() const;
+
+  // Returns the statistics of the nodes on at least one critical path, the
+  // nodes with the most time on critical paths first.
+  std::vector<NodeStats> NodeStatistics() const;
+
+  // Returns a human-readable table of NodeStatistics().
+  std::string Summary() const;
+
+  // Returns the name of node "node_id", or "node_<id>" if unknown.
+  std::string NodeName(int node_id) const;
+
+ private:
+  // A Process() call, possibly assembled from several trace records.
+  struct Call {
+    int node_id = 0;
+    int64 input_timestamp = 0;
+    int64 start_time = -1;
+    int64 finish_time = -1;
+    // The (stream_id, packet_timestamp) of the input packets.
+    std::vector<std::pair<int, int64>> inputs;
+  };
+  // Identifies a call or GPU task by node id and input timestamp.
+  using CallKey = std::pair<int, int64>;
+  // Identifies a packet by stream id and packet timestamp.
+  using PacketKey = std::pair<int, int64>;
+
+  std::map<CallKey, Call> calls_;
+  // The total GPU time of the GPU tasks of each call.
+  std::map<CallKey, int64> gpu_usec_;
+  // The partially traced GPU tasks, with their start times.
+  std::map<CallKey, int64> gpu_task_starts_;
+  // The call that output each packet.
+  std::map<PacketKey, CallKey> producers_;
+  std::vector<std::string> node_names_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PROFILER_CRITICAL_PATH_ANALYZER_H_
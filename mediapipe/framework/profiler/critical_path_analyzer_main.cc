@@ -0,0 +1,78 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A command line utility that reads the GraphProfile trace logs written to
+// trace_log_path, and prints which nodes are on the critical path of the
+// traced input timestamps, and how often.
+//
+// Example:
+//   critical_path_analyzer_main --trace_log_files=/tmp/mediapipe_trace_0.binarypb
+//   --print_paths
+
+#include <stdlib.h>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/advanced_proto_inc.h"
+#include "mediapipe/framework/port/commandlineflags.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/profiler/critical_path_analyzer.h"
+
+DEFINE_string(trace_log_files, "",
+              "Comma-separated binary GraphProfile trace log files, in the "
+              "order they were written.");
+DEFINE_bool(print_paths, false,
+            "Whether to also print the critical path of every input "
+            "timestamp.");
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  mediapipe::CriticalPathAnalyzer analyzer;
+  for (const std::string& path :
+       absl::StrSplit(FLAGS_trace_log_files, ',', absl::SkipEmpty())) {
+    // Successive GraphProfiles appended to one file parse as one.
+    std::ifstream ifs(path, std::ios::binary);
+    mediapipe::proto_ns::io::IstreamInputStream in(&ifs);
+    mediapipe::GraphProfile profile;
+    if (!ifs || !profile.ParseFromZeroCopyStream(&in)) {
+      LOG(ERROR) << "Could not read binary GraphProfile: " << path;
+      return EXIT_FAILURE;
+    }
+    analyzer.AddProfile(profile);
+  }
+
+  if (FLAGS_print_paths) {
+    for (const auto& critical_path : analyzer.CriticalPaths()) {
+      std::vector<std::string> steps;
+      for (const auto& step : critical_path.steps) {
+        steps.push_back(absl::StrCat(
+            analyzer.NodeName(step.node_id), " (queue ", step.queue_usec,
+            " process ", step.process_usec, " gpu ", step.gpu_usec, ")"));
+      }
+      std::cout << critical_path.input_timestamp << " "
+                << critical_path.latency_usec << "us: "
+                << absl::StrJoin(steps, " -> ") << "\n";
+    }
+  }
+  std::cout << analyzer.Summary();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,183 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/critical_path_analyzer.h"
+
+#include <vector>
+
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::HasSubstr;
+
+// A source node 0 feeding nodes 1 and 2, which both feed node 3. Node 1 is
+// slower at timestamp 0, and node 2 at timestamp 1.
+constexpr char kDiamondTrace[] = R"(
+  base_time: 1000
+  base_timestamp: 0
+  stream_name: ""
+  stream_name: "a"
+  stream_name: "b"
+  stream_name: "c"
+  calculator_trace {
+    node_id: 0 input_timestamp: 0 event_type: PROCESS
+    start_time: 0 finish_time: 100
+    output_trace { stream_id: 1 packet_timestamp: 0 }
+  }
+  calculator_trace {
+    node_id: 1 input_timestamp: 0 event_type: PROCESS
+    start_time: 150 finish_time: 300
+    input_trace { stream_id: 1 packet_timestamp: 0 }
+    output_trace { stream_id: 2 packet_timestamp: 0 }
+  }
+  calculator_trace {
+    node_id: 1 input_timestamp: 0 event_type: GPU_TASK
+    start_time: 160 finish_time: 240
+  }
+  calculator_trace {
+    node_id: 2 input_timestamp: 0 event_type: PROCESS
+    start_time: 110 finish_time: 200
+    input_trace { stream_id: 1 packet_timestamp: 0 }
+    output_trace { stream_id: 3 packet_timestamp: 0 }
+  }
+  calculator_trace {
+    node_id: 3 input_timestamp: 0 event_type: PROCESS
+    start_time: 320 finish_time: 400
+    input_trace { stream_id: 2 packet_timestamp: 0 }
+    input_trace { stream_id: 3 packet_timestamp: 0 }
+  }
+  calculator_trace {
+    node_id: 0 input_timestamp: 1 event_type: PROCESS
+    start_time: 1000 finish_time: 1100
+    output_trace { stream_id: 1 packet_timestamp: 1 }
+  }
+  calculator_trace {
+    node_id: 1 input_timestamp: 1 event_type: PROCESS
+    start_time: 1100 finish_time: 1150
+    input_trace { stream_id: 1 packet_timestamp: 1 }
+    output_trace { stream_id: 2 packet_timestamp: 1 }
+  }
+  calculator_trace {
+    node_id: 2 input_timestamp: 1 event_type: PROCESS
+    start_time: 1110 finish_time: 1400
+    input_trace { stream_id: 1 packet_timestamp: 1 }
+    output_trace { stream_id: 3 packet_timestamp: 1 }
+  }
+  calculator_trace {
+    node_id: 3 input_timestamp: 1 event_type: PROCESS
+    start_time: 1400 finish_time: 1450
+    input_trace { stream_id: 2 packet_timestamp: 1 }
+    input_trace { stream_id: 3 packet_timestamp: 1 }
+  }
+)";
+
+TEST(CriticalPathAnalyzerTest, FollowsLastArrivingInputs) {
+  CriticalPathAnalyzer analyzer;
+  analyzer.AddTrace(ParseTextProtoOrDie<GraphTrace>(kDiamondTrace));
+
+  std::vector<CriticalPathAnalyzer::CriticalPath> paths =
+      analyzer.CriticalPaths();
+  ASSERT_EQ(paths.size(), 2);
+  EXPECT_EQ(paths[0].input_timestamp, 0);
+  EXPECT_EQ(paths[0].latency_usec, 400);
+  ASSERT_EQ(paths[0].steps.size(), 3);
+  EXPECT_EQ(paths[0].steps[0].node_id, 0);
+  EXPECT_EQ(paths[0].steps[1].node_id, 1);
+  EXPECT_EQ(paths[0].steps[1].queue_usec, 50);
+  EXPECT_EQ(paths[0].steps[1].process_usec, 150);
+  EXPECT_EQ(paths[0].steps[1].gpu_usec, 80);
+  EXPECT_EQ(paths[0].steps[2].node_id, 3);
+  EXPECT_EQ(paths[0].steps[2].queue_usec, 20);
+
+  EXPECT_EQ(paths[1].input_timestamp, 1);
+  EXPECT_EQ(paths[1].latency_usec, 450);
+  ASSERT_EQ(paths[1].steps.size(), 3);
+  EXPECT_EQ(paths[1].steps[1].node_id, 2);
+  EXPECT_EQ(paths[1].steps[1].queue_usec, 10);
+}
+
+TEST(CriticalPathAnalyzerTest, AggregatesNodeStatistics) {
+  CriticalPathAnalyzer analyzer;
+  GraphProfile profile;
+  *profile.add_graph_trace() = ParseTextProtoOrDie<GraphTrace>(kDiamondTrace);
+  for (const char* name : {"source", "left", "right", "merge"}) {
+    profile.mutable_config()->add_node()->set_name(name);
+  }
+  analyzer.AddProfile(profile);
+
+  std::vector<CriticalPathAnalyzer::NodeStats> stats =
+      analyzer.NodeStatistics();
+  ASSERT_EQ(stats.size(), 4);
+  // "right" spends 300 usec on paths, "source" and "left" 200, and "merge"
+  // 150.
+  EXPECT_EQ(stats[0].name, "right");
+  EXPECT_EQ(stats[0].num_paths, 1);
+  EXPECT_EQ(stats[3].name, "merge");
+  EXPECT_EQ(stats[3].num_paths, 2);
+  EXPECT_EQ(stats[3].num_last, 2);
+  EXPECT_EQ(stats[3].queue_usec, 20);
+  EXPECT_THAT(analyzer.Summary(), HasSubstr("2 input timestamps"));
+}
+
+// Tests that calls logged as separate start and finish events, as with
+// trace_log_duration_events, and split across traces, are merged.
+TEST(CriticalPathAnalyzerTest, MergesDurationEvents) {
+  CriticalPathAnalyzer analyzer;
+  analyzer.AddTrace(ParseTextProtoOrDie<GraphTrace>(R"(
+    base_time: 1000
+    base_timestamp: 5000
+    calculator_trace {
+      node_id: 0 input_timestamp: 0 event_type: PROCESS start_time: 0
+    }
+    calculator_trace {
+      node_id: 0 input_timestamp: 0 event_type: PROCESS finish_time: 100
+      output_trace { stream_id: 1 packet_timestamp: 0 }
+    }
+    calculator_trace {
+      node_id: 1 input_timestamp: 0 event_type: PROCESS start_time: 130
+      input_trace { stream_id: 1 packet_timestamp: 0 }
+    }
+    calculator_trace {
+      node_id: 1 input_timestamp: 0 event_type: GPU_TASK start_time: 140
+    }
+  )"));
+  analyzer.AddTrace(ParseTextProtoOrDie<GraphTrace>(R"(
+    base_time: 1000
+    base_timestamp: 5000
+    calculator_trace {
+      node_id: 1 input_timestamp: 0 event_type: GPU_TASK finish_time: 170
+    }
+    calculator_trace {
+      node_id: 1 input_timestamp: 0 event_type: PROCESS finish_time: 200
+    }
+  )"));
+
+  std::vector<CriticalPathAnalyzer::CriticalPath> paths =
+      analyzer.CriticalPaths();
+  ASSERT_EQ(paths.size(), 1);
+  EXPECT_EQ(paths[0].input_timestamp, 5000);
+  EXPECT_EQ(paths[0].latency_usec, 200);
+  ASSERT_EQ(paths[0].steps.size(), 2);
+  EXPECT_EQ(paths[0].steps[1].queue_usec, 30);
+  EXPECT_EQ(paths[0].steps[1].process_usec, 70);
+  EXPECT_EQ(paths[0].steps[1].gpu_usec, 30);
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,242 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/executor_planner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "mediapipe/framework/mediapipe_options.pb.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/thread_pool_executor.pb.h"
+#include "mediapipe/framework/validated_graph_config.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Returns the number of Process() calls recorded in "histogram".
+int64 NumCalls(const TimeHistogram& histogram) {
+  int64 result = 0;
+  for (int64 count : histogram.count()) {
+    result += count;
+  }
+  return result;
+}
+
+// Returns "base", or "base_<n>" for the smallest n making it unused.
+std::string UniqueName(const std::string& base, std::set<std::string>* used) {
+  std::string name = base;
+  for (int n = 1; used->count(name); ++n) {
+    name = absl::StrCat(base, "_", n);
+  }
+  used->insert(name);
+  return name;
+}
+
+// Returns the ThreadPoolExecutorOptions of "executor_config", or nullptr if
+// it is not a ThreadPoolExecutor.
+ThreadPoolExecutorOptions* ThreadPoolOptions(ExecutorConfig* executor_config) {
+  if (!executor_config->type().empty() &&
+      executor_config->type() != "ThreadPoolExecutor") {
+    return nullptr;
+  }
+  return executor_config->mutable_options()->MutableExtension(
+      ThreadPoolExecutorOptions::ext);
+}
+
+const char* NodeClassName(ExecutorPlanner::NodeClass node_class) {
+  switch (node_class) {
+    case ExecutorPlanner::HEAVY:
+      return "heavy";
+    case ExecutorPlanner::IO:
+      return "io";
+    default:
+      return "light";
+  }
+}
+
+}  // namespace
+
+void ExecutorPlanner::AddProfile(const GraphProfile& profile) {
+  if (profile.has_config()) {
+    config_ = profile.config();
+  }
+  for (const CalculatorProfile& calculator_profile :
+       profile.calculator_profiles()) {
+    profiles_[calculator_profile.name()] = calculator_profile;
+  }
+}
+
+::mediapipe::StatusOr<CalculatorGraphConfig> ExecutorPlanner::Plan() {
+  RET_CHECK_GT(config_.node_size(), 0)
+      << "No profile with a graph config was added.";
+  return Plan(config_);
+}
+
+::mediapipe::StatusOr<CalculatorGraphConfig> ExecutorPlanner::Plan(
+    const CalculatorGraphConfig& config) {
+  RET_CHECK_GT(options_.num_cores, 0);
+  CalculatorGraphConfig result = config;
+  node_plans_.clear();
+
+  // Collects the profiled nodes that may be reassigned, with their times.
+  std::vector<int> node_ids;
+  int64 total_process_usec = 0;
+  int64 total_cpu_usec = 0;
+  std::vector<int64> cpu_usec;
+  // The number of calls the default executor may run in parallel for the
+  // nodes left on it.
+  int default_parallelism = 0;
+  for (int i = 0; i < config.node_size(); ++i) {
+    const CalculatorGraphConfig::Node& node = config.node(i);
+    const std::string name = CanonicalNodeName(config, i);
+    auto iter = profiles_.find(name);
+    const int64 num_calls =
+        iter == profiles_.end() ? 0 : NumCalls(iter->second.process_runtime());
+    if (num_calls > 0) {
+      total_process_usec += iter->second.process_runtime().total();
+    }
+    if (!node.executor().empty()) {
+      continue;
+    }
+    if (num_calls == 0) {
+      ++default_parallelism;
+      continue;
+    }
+    const CalculatorProfile& profile = iter->second;
+    NodePlan plan;
+    plan.name = name;
+    plan.num_calls = num_calls;
+    plan.process_usec = profile.process_runtime().total();
+    plan.wait_usec = profile.process_wait_time().total();
+    node_plans_.push_back(plan);
+    node_ids.push_back(i);
+    cpu_usec.push_back(profile.has_process_cpu_time()
+                           ? profile.process_cpu_time().total()
+                           : plan.process_usec);
+    total_cpu_usec += cpu_usec.back();
+  }
+
+  std::set<std::string> used_names;
+  for (const ExecutorConfig& executor_config : config.executor()) {
+    used_names.insert(executor_config.name());
+  }
+  int heavy_threads = 0;
+  int io_threads = 0;
+  std::string io_executor;
+  for (int k = 0; k < static_cast<int>(node_plans_.size()); ++k) {
+    NodePlan& plan = node_plans_[k];
+    CalculatorGraphConfig::Node* node = result.mutable_node(node_ids[k]);
+    const int parallelism = std::max(1, node->max_in_flight());
+    if (plan.process_usec > 0 &&
+        plan.wait_usec >= options_.io_wait_fraction * plan.process_usec) {
+      plan.node_class = IO;
+      if (io_executor.empty()) {
+        io_executor = UniqueName("io", &used_names);
+      }
+      plan.executor = io_executor;
+      io_threads += parallelism;
+    } else if (plan.process_usec > 0 &&
+               plan.process_usec >=
+                   options_.heavy_fraction * total_process_usec) {
+      plan.node_class = HEAVY;
+      plan.executor = UniqueName("heavy", &used_names);
+      int num_threads = std::min(parallelism, options_.num_cores);
+      if (options_.objective == THROUGHPUT && total_cpu_usec > 0) {
+        // The node's share of the cores, at most the calls it may run.
+        num_threads = std::min<int>(
+            num_threads,
+            std::llround(1.0 * options_.num_cores * cpu_usec[k] /
+                         total_cpu_usec));
+      }
+      num_threads = std::max(num_threads, 1);
+      heavy_threads += num_threads;
+      ExecutorConfig* executor_config = result.add_executor();
+      executor_config->set_name(plan.executor);
+      executor_config->set_type("ThreadPoolExecutor");
+      ThreadPoolExecutorOptions* thread_pool_options =
+          ThreadPoolOptions(executor_config);
+      thread_pool_options->set_num_threads(num_threads);
+      if (options_.objective == LATENCY) {
+        thread_pool_options->set_require_processor_performance(
+            ThreadPoolExecutorOptions::HIGH);
+      }
+    } else {
+      plan.node_class = LIGHT;
+      default_parallelism += parallelism;
+      plan.run_inline = options_.objective == LATENCY &&
+                        node->input_stream_size() > 0 &&
+                        plan.process_usec <=
+                            options_.inline_max_usec * plan.num_calls;
+      if (plan.run_inline) {
+        node->set_run_inline(true);
+      }
+    }
+    node->set_executor(plan.executor);
+  }
+
+  if (!io_executor.empty()) {
+    ExecutorConfig* executor_config = result.add_executor();
+    executor_config->set_name(io_executor);
+    executor_config->set_type("ThreadPoolExecutor");
+    ThreadPoolOptions(executor_config)->set_num_threads(io_threads);
+  }
+
+  // Sizes the default executor for the light and unprofiled nodes.
+  int default_threads = std::min(default_parallelism, options_.num_cores);
+  if (options_.objective == THROUGHPUT) {
+    default_threads =
+        std::min(default_threads, options_.num_cores - heavy_threads);
+  }
+  default_threads = std::max(default_threads, 1);
+  ExecutorConfig* default_executor_config = nullptr;
+  for (ExecutorConfig& executor_config : *result.mutable_executor()) {
+    if (executor_config.name().empty()) {
+      default_executor_config = &executor_config;
+      break;
+    }
+  }
+  if (!default_executor_config) {
+    default_executor_config = result.add_executor();
+  }
+  result.clear_num_threads();
+  ThreadPoolExecutorOptions* default_options =
+      ThreadPoolOptions(default_executor_config);
+  if (default_options) {
+    default_options->set_num_threads(default_threads);
+  }
+  return result;
+}
+
+std::string ExecutorPlanner::Summary() const {
+  std::string result =
+      absl::StrFormat("%-40s %6s %-12s %6s %8s %12s %12s\n", "node", "class",
+                      "executor", "inline", "calls", "process_ms", "wait_ms");
+  for (const NodePlan& plan : node_plans_) {
+    const double num_calls = std::max<int64>(plan.num_calls, 1);
+    absl::StrAppendFormat(&result, "%-40s %6s %-12s %6s %8d %12.2f %12.2f\n",
+                          plan.name, NodeClassName(plan.node_class),
+                          plan.executor.empty() ? "default" : plan.executor,
+                          plan.run_inline ? "yes" : "no", plan.num_calls,
+                          plan.process_usec / 1000.0 / num_calls,
+                          plan.wait_usec / 1000.0 / num_calls);
+  }
+  return result;
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,109 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PROFILER_EXECUTOR_PLANNER_H_
+#define MEDIAPIPE_FRAMEWORK_PROFILER_EXECUTOR_PLANNER_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/statusor.h"
+
+namespace mediapipe {
+
+// Assigns the nodes of a graph to executors, and sizes the executors, from
+// the CalculatorProfiles of a profiled run of the graph.
+//
+// Each profiled node is classified by its Process() times:
+//   HEAVY: a node taking at least heavy_fraction of the total Process() time
+//     of the graph, such as an inference node. Each runs on its own
+//     executor, so that it never waits behind cheap nodes for a thread.
+//   IO: a node spending at least io_wait_fraction of its Process() time off
+//     the CPU, according to process_wait_time. These share an "io" executor
+//     with a thread for every call that may be in flight, since waiting
+//     threads use no cores.
+//   LIGHT: any other node. These share the default executor. With the
+//     LATENCY objective, nodes whose mean Process() time is at most
+//     inline_max_usec are also set to run_inline.
+//
+// With the THROUGHPUT objective, the cores are split between the heavy
+// executors and the default executor in proportion to their CPU time, so
+// that the pipeline stages stay balanced. With the LATENCY objective, every
+// executor gets as many threads as its nodes can use in parallel, up to the
+// number of cores, and the heavy executors ask for high performance cores.
+//
+// Nodes that already name an executor, and nodes without a profile, are left
+// unchanged. The profile must be of the same graph config, with subgraphs
+// expanded, as written to GraphProfile.config. The process_wait_time
+// statistics are only available with ProfilerConfig.enable_cpu_time.
+class ExecutorPlanner {
+ public:
+  enum Objective { THROUGHPUT, LATENCY };
+  enum NodeClass { LIGHT, HEAVY, IO };
+
+  struct Options {
+    Objective objective = THROUGHPUT;
+    // The number of cores available to the graph. Must be positive.
+    int num_cores = 1;
+    double heavy_fraction = 0.25;
+    double io_wait_fraction = 0.5;
+    int64 inline_max_usec = 20;
+  };
+
+  // The planned assignment of one profiled node.
+  struct NodePlan {
+    std::string name;
+    NodeClass node_class = LIGHT;
+    std::string executor;
+    bool run_inline = false;
+    int64 num_calls = 0;
+    int64 process_usec = 0;
+    int64 wait_usec = 0;
+  };
+
+  explicit ExecutorPlanner(const Options& options) : options_(options) {}
+
+  // Adds the CalculatorProfiles of "profile", as read from a trace log file.
+  // Since they are cumulative, a later profile of a node replaces an earlier
+  // one. Takes the graph config from "profile" if present.
+  void AddProfile(const GraphProfile& profile);
+
+  // Returns the graph config of the latest profile with the planned
+  // executors.
+  ::mediapipe::StatusOr<CalculatorGraphConfig> Plan();
+
+  // Returns "config" with the planned executors.
+  ::mediapipe::StatusOr<CalculatorGraphConfig> Plan(
+      const CalculatorGraphConfig& config);
+
+  // Returns the node assignments made by the latest Plan().
+  const std::vector<NodePlan>& node_plans() const { return node_plans_; }
+
+  // Returns a human-readable table of node_plans().
+  std::string Summary() const;
+
+ private:
+  Options options_;
+  std::map<std::string, CalculatorProfile> profiles_;
+  CalculatorGraphConfig config_;
+  std::vector<NodePlan> node_plans_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PROFILER_EXECUTOR_PLANNER_H_
@@ -0,0 +1,120 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// A command line utility that reads the GraphProfile trace logs written to
+// trace_log_path, and writes the profiled graph config with its nodes
+// assigned to executors sized for throughput or latency. The trace logs must
+// be written with ProfilerConfig.enable_cpu_time to detect I/O-bound nodes.
+//
+// Example:
+//   executor_planner_main --trace_log_files=/tmp/mediapipe_trace_0.binarypb
+//   --objective=latency --output_file=/tmp/planned_graph.pbtxt
+
+#include <stdlib.h>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/advanced_proto_inc.h"
+#include "mediapipe/framework/port/commandlineflags.h"
+#include "mediapipe/framework/port/core_proto_inc.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/profiler/executor_planner.h"
+#include "mediapipe/util/cpu_util.h"
+
+DEFINE_string(trace_log_files, "",
+              "Comma-separated binary GraphProfile trace log files, in the "
+              "order they were written.");
+DEFINE_string(calculator_graph_config_file, "",
+              "Text format CalculatorGraphConfig to plan, with subgraphs "
+              "expanded. Defaults to the config in the trace logs.");
+DEFINE_string(objective, "throughput",
+              "What to optimize for: \"throughput\" or \"latency\".");
+DEFINE_int32(num_cores, 0,
+             "The number of cores available to the graph. Defaults to the "
+             "number of cores of this machine.");
+DEFINE_string(output_file, "",
+              "Where to write the planned text format CalculatorGraphConfig. "
+              "Defaults to standard output.");
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  mediapipe::ExecutorPlanner::Options options;
+  if (FLAGS_objective == "latency") {
+    options.objective = mediapipe::ExecutorPlanner::LATENCY;
+  } else if (FLAGS_objective != "throughput") {
+    LOG(ERROR) << "Unknown objective: " << FLAGS_objective;
+    return EXIT_FAILURE;
+  }
+  options.num_cores =
+      FLAGS_num_cores > 0 ? FLAGS_num_cores : mediapipe::NumCPUCores();
+  mediapipe::ExecutorPlanner planner(options);
+  for (const absl::string_view path :
+       absl::StrSplit(FLAGS_trace_log_files, ',', absl::SkipEmpty())) {
+    // Successive GraphProfiles appended to one file parse as one.
+    std::ifstream ifs(std::string(path), std::ios::binary);
+    mediapipe::proto_ns::io::IstreamInputStream in(&ifs);
+    mediapipe::GraphProfile profile;
+    if (!ifs || !profile.ParseFromZeroCopyStream(&in)) {
+      LOG(ERROR) << "Could not read binary GraphProfile: " << path;
+      return EXIT_FAILURE;
+    }
+    planner.AddProfile(profile);
+  }
+
+  ::mediapipe::StatusOr<mediapipe::CalculatorGraphConfig> planned;
+  if (FLAGS_calculator_graph_config_file.empty()) {
+    planned = planner.Plan();
+  } else {
+    std::string contents;
+    mediapipe::CalculatorGraphConfig config;
+    ::mediapipe::Status status = mediapipe::file::GetContents(
+        FLAGS_calculator_graph_config_file, &contents);
+    if (!status.ok() ||
+        !mediapipe::proto_ns::TextFormat::ParseFromString(contents, &config)) {
+      LOG(ERROR) << "Could not read text CalculatorGraphConfig: "
+                 << FLAGS_calculator_graph_config_file << " " << status;
+      return EXIT_FAILURE;
+    }
+    planned = planner.Plan(config);
+  }
+  if (!planned.ok()) {
+    LOG(ERROR) << planned.status();
+    return EXIT_FAILURE;
+  }
+  std::cerr << planner.Summary();
+
+  std::string output;
+  mediapipe::proto_ns::TextFormat::PrintToString(planned.ValueOrDie(),
+                                                 &output);
+  if (FLAGS_output_file.empty()) {
+    std::cout << output;
+  } else {
+    ::mediapipe::Status status =
+        mediapipe::file::SetContents(FLAGS_output_file, output);
+    if (!status.ok()) {
+      LOG(ERROR) << status;
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
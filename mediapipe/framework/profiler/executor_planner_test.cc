@@ -0,0 +1,170 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/executor_planner.h"
+
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/thread_pool_executor.pb.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::HasSubstr;
+
+// A reader waiting on I/O feeds a cheap converter, a slow inference node and
+// a cheap annotator. Each ran 100 times.
+constexpr char kProfile[] = R"(
+  config {
+    num_threads: 8
+    node { name: "reader" calculator: "ReaderCalculator"
+           output_stream: "a" }
+    node { name: "convert" calculator: "ConvertCalculator"
+           input_stream: "a" output_stream: "b" }
+    node { name: "infer" calculator: "InferenceCalculator"
+           input_stream: "b" output_stream: "c" max_in_flight: 2 }
+    node { name: "annotate" calculator: "AnnotateCalculator"
+           input_stream: "c" output_stream: "d" }
+  }
+  calculator_profiles {
+    name: "reader"
+    process_runtime { total: 500000 count: 100 }
+    process_cpu_time { total: 50000 count: 100 }
+    process_wait_time { total: 450000 count: 100 }
+  }
+  calculator_profiles {
+    name: "convert"
+    process_runtime { total: 1000 count: 100 }
+    process_cpu_time { total: 1000 count: 100 }
+    process_wait_time { total: 0 count: 100 }
+  }
+  calculator_profiles {
+    name: "infer"
+    process_runtime { total: 3000000 count: 100 }
+    process_cpu_time { total: 3000000 count: 100 }
+    process_wait_time { total: 0 count: 100 }
+  }
+  calculator_profiles {
+    name: "annotate"
+    process_runtime { total: 300000 count: 100 }
+    process_cpu_time { total: 300000 count: 100 }
+    process_wait_time { total: 0 count: 100 }
+  }
+)";
+
+// Returns the num_threads of executor "name", or -1 if there is none.
+int NumThreads(const CalculatorGraphConfig& config, const std::string& name) {
+  for (const ExecutorConfig& executor : config.executor()) {
+    if (executor.name() == name) {
+      return executor.options()
+          .GetExtension(ThreadPoolExecutorOptions::ext)
+          .num_threads();
+    }
+  }
+  return -1;
+}
+
+TEST(ExecutorPlannerTest, PlansForThroughput) {
+  ExecutorPlanner::Options options;
+  options.num_cores = 4;
+  ExecutorPlanner planner(options);
+  planner.AddProfile(ParseTextProtoOrDie<GraphProfile>(kProfile));
+  auto result = planner.Plan();
+  MP_ASSERT_OK(result);
+  const CalculatorGraphConfig& config = result.ValueOrDie();
+
+  EXPECT_EQ(config.node(0).executor(), "io");
+  EXPECT_EQ(config.node(1).executor(), "");
+  EXPECT_EQ(config.node(2).executor(), "heavy");
+  EXPECT_EQ(config.node(3).executor(), "");
+  EXPECT_FALSE(config.node(1).run_inline());
+  EXPECT_EQ(config.num_threads(), 0);
+  // The inference node may run two calls, and has most of the CPU time.
+  EXPECT_EQ(NumThreads(config, "heavy"), 2);
+  EXPECT_EQ(NumThreads(config, "io"), 1);
+  // The remaining cores, at most one per light node call.
+  EXPECT_EQ(NumThreads(config, ""), 2);
+
+  ASSERT_EQ(planner.node_plans().size(), 4);
+  EXPECT_EQ(planner.node_plans()[0].node_class, ExecutorPlanner::IO);
+  EXPECT_EQ(planner.node_plans()[2].node_class, ExecutorPlanner::HEAVY);
+  EXPECT_THAT(planner.Summary(), HasSubstr("infer"));
+}
+
+TEST(ExecutorPlannerTest, PlansForLatency) {
+  ExecutorPlanner::Options options;
+  options.objective = ExecutorPlanner::LATENCY;
+  options.num_cores = 4;
+  ExecutorPlanner planner(options);
+  planner.AddProfile(ParseTextProtoOrDie<GraphProfile>(kProfile));
+  auto result = planner.Plan();
+  MP_ASSERT_OK(result);
+  const CalculatorGraphConfig& config = result.ValueOrDie();
+
+  // Only the 10 usec converter runs inline.
+  EXPECT_TRUE(config.node(1).run_inline());
+  EXPECT_FALSE(config.node(3).run_inline());
+  EXPECT_EQ(NumThreads(config, "heavy"), 2);
+  EXPECT_EQ(NumThreads(config, ""), 2);
+  for (const ExecutorConfig& executor : config.executor()) {
+    if (executor.name() == "heavy") {
+      EXPECT_EQ(executor.options()
+                    .GetExtension(ThreadPoolExecutorOptions::ext)
+                    .require_processor_performance(),
+                ThreadPoolExecutorOptions::HIGH);
+    }
+  }
+}
+
+TEST(ExecutorPlannerTest, KeepsAssignedExecutors) {
+  GraphProfile profile = ParseTextProtoOrDie<GraphProfile>(kProfile);
+  profile.mutable_config()->clear_num_threads();
+  profile.mutable_config()->mutable_node(2)->set_executor("gpu:inference");
+  *profile.mutable_config()->add_executor() =
+      ParseTextProtoOrDie<ExecutorConfig>(R"(
+        name: "io"
+        type: "ThreadPoolExecutor"
+        options {
+          [mediapipe.ThreadPoolExecutorOptions.ext] { num_threads: 3 }
+        }
+      )");
+  ExecutorPlanner::Options options;
+  options.num_cores = 4;
+  ExecutorPlanner planner(options);
+  planner.AddProfile(profile);
+  auto result = planner.Plan();
+  MP_ASSERT_OK(result);
+  const CalculatorGraphConfig& config = result.ValueOrDie();
+
+  EXPECT_EQ(config.node(2).executor(), "gpu:inference");
+  EXPECT_EQ(config.node(0).executor(), "io_1");
+  EXPECT_EQ(NumThreads(config, "io"), 3);
+  EXPECT_EQ(NumThreads(config, "io_1"), 1);
+  // The pinned inference node still counts toward the graph's total time.
+  EXPECT_EQ(config.node(3).executor(), "");
+  EXPECT_EQ(NumThreads(config, "heavy"), -1);
+  EXPECT_EQ(planner.node_plans().size(), 3);
+}
+
+TEST(ExecutorPlannerTest, RequiresConfig) {
+  ExecutorPlanner planner(ExecutorPlanner::Options{});
+  EXPECT_FALSE(planner.Plan().ok());
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,136 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/graph_metrics_exporter.h"
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/counter_factory.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/logging.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Returns "value" escaped for use as a label value.
+std::string EscapeLabelValue(const std::string& value) {
+  std::string result;
+  for (char c : value) {
+    switch (c) {
+      case '\\':
+        result += "\\\\";
+        break;
+      case '"':
+        result += "\\\"";
+        break;
+      case '\n':
+        result += "\\n";
+        break;
+      default:
+        result += c;
+    }
+  }
+  return result;
+}
+
+// Appends the HELP and TYPE lines of a metric.
+void AppendMetricHeader(const std::string& name, const std::string& type,
+                        const std::string& help, std::string* output) {
+  absl::StrAppend(output, "# HELP ", name, " ", help, "\n", "# TYPE ", name,
+                  " ", type, "\n");
+}
+
+// Appends one sample of a metric with a single label.
+void AppendSample(const std::string& name, const std::string& label,
+                  const std::string& label_value, int64 value,
+                  std::string* output) {
+  absl::StrAppend(output, name, "{", label, "=\"",
+                  EscapeLabelValue(label_value), "\"} ", value, "\n");
+}
+
+}  // namespace
+
+std::string ExportGraphMetrics(CalculatorGraph* graph) {
+  std::string output;
+
+  std::map<std::string, int64> counters =
+      graph->GetCounterFactory()->GetCounterSet()->GetCountersValues();
+  AppendMetricHeader("mediapipe_counter_total", "counter",
+                     "MediaPipe graph counters.", &output);
+  for (const auto& counter : counters) {
+    AppendSample("mediapipe_counter_total", "counter", counter.first,
+                 counter.second, &output);
+  }
+
+  AppendMetricHeader("mediapipe_input_queue_size", "gauge",
+                     "Packets queued in a calculator input stream.", &output);
+  for (const auto& queue_size : graph->GetInputStreamQueueSizes()) {
+    absl::StrAppend(&output, "mediapipe_input_queue_size{node=\"",
+                    EscapeLabelValue(queue_size.first.first), "\",stream=\"",
+                    EscapeLabelValue(queue_size.first.second), "\"} ",
+                    queue_size.second, "\n");
+  }
+
+  if (!graph->Config().profiler_config().enable_profiler()) {
+    return output;
+  }
+  std::vector<CalculatorProfile> profiles;
+  ::mediapipe::Status status =
+      graph->profiler()->GetCalculatorProfiles(&profiles);
+  if (!status.ok()) {
+    LOG(WARNING) << "Calculator profiles are not exported: " << status;
+    return output;
+  }
+  AppendMetricHeader("mediapipe_process_calls_total", "counter",
+                     "Calls to Calculator::Process().", &output);
+  for (const CalculatorProfile& profile : profiles) {
+    int64 num_calls = 0;
+    for (int64 count : profile.process_runtime().count()) {
+      num_calls += count;
+    }
+    AppendSample("mediapipe_process_calls_total", "node", profile.name(),
+                 num_calls, &output);
+  }
+  AppendMetricHeader("mediapipe_process_runtime_usec_total", "counter",
+                     "Time spent in Calculator::Process().", &output);
+  for (const CalculatorProfile& profile : profiles) {
+    AppendSample("mediapipe_process_runtime_usec_total", "node",
+                 profile.name(), profile.process_runtime().total(), &output);
+  }
+  AppendMetricHeader("mediapipe_process_runtime_usec", "gauge",
+                     "Percentiles of the Calculator::Process() runtime.",
+                     &output);
+  for (const CalculatorProfile& profile : profiles) {
+    const TimeHistogram& runtime = profile.process_runtime();
+    if (!runtime.has_p50_usec()) {
+      continue;
+    }
+    const std::string node = EscapeLabelValue(profile.name());
+    for (const auto& quantile : {std::make_pair("0.5", runtime.p50_usec()),
+                                 std::make_pair("0.95", runtime.p95_usec()),
+                                 std::make_pair("0.99", runtime.p99_usec())}) {
+      absl::StrAppend(&output, "mediapipe_process_runtime_usec{node=\"", node,
+                      "\",quantile=\"", quantile.first, "\"} ",
+                      quantile.second, "\n");
+    }
+  }
+  return output;
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,48 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PROFILER_GRAPH_METRICS_EXPORTER_H_
+#define MEDIAPIPE_FRAMEWORK_PROFILER_GRAPH_METRICS_EXPORTER_H_
+
+#include <string>
+
+#include "mediapipe/framework/calculator_graph.h"
+
+namespace mediapipe {
+
+// Returns the current statistics of "graph" in the Prometheus text exposition
+// format, which OpenMetrics scrapers also accept. The application serves the
+// result from its scrape endpoint, such as "/metrics". The metrics are:
+//
+//   mediapipe_counter_total{counter}
+//       Every counter of the graph's CounterFactory, including the
+//       "<node>-DroppedPackets" counters of FlowLimiterCalculator and
+//       FixedSizeInputStreamHandler, and the "<stream>-Throttled" counters
+//       that count how often an input stream queue became full.
+//   mediapipe_input_queue_size{node, stream}
+//       The number of packets queued in each calculator input stream.
+//   mediapipe_process_calls_total{node}
+//   mediapipe_process_runtime_usec_total{node}
+//   mediapipe_process_runtime_usec{node, quantile}
+//       The Process() calls and runtime of each node, if the profiler is
+//       enabled, and the runtime percentiles if
+//       ProfilerConfig.enable_percentiles is set.
+//
+// "graph" must be initialized. The counters and queues are read without
+// pausing the graph, so they may be slightly inconsistent with each other.
+std::string ExportGraphMetrics(CalculatorGraph* graph);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PROFILER_GRAPH_METRICS_EXPORTER_H_
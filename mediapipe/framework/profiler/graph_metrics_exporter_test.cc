@@ -0,0 +1,85 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/graph_metrics_exporter.h"
+
+#include <string>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::HasSubstr;
+using ::testing::Not;
+
+CalculatorGraphConfig PassThroughConfig(bool enable_profiler) {
+  auto config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+    input_stream: "input"
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "input"
+      output_stream: "output"
+    }
+    profiler_config { trace_log_disabled: true enable_percentiles: true }
+  )");
+  config.mutable_profiler_config()->set_enable_profiler(enable_profiler);
+  return config;
+}
+
+void RunGraph(CalculatorGraph* graph) {
+  MP_ASSERT_OK(graph->StartRun({}));
+  for (int i = 0; i < 3; ++i) {
+    MP_ASSERT_OK(graph->AddPacketToInputStream(
+        "input", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph->CloseAllInputStreams());
+  MP_ASSERT_OK(graph->WaitUntilDone());
+}
+
+TEST(GraphMetricsExporterTest, ExportsCountersQueuesAndProfiles) {
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(PassThroughConfig(/*enable_profiler=*/true)));
+  RunGraph(&graph);
+
+  std::string metrics = ExportGraphMetrics(&graph);
+  EXPECT_THAT(metrics, HasSubstr("# TYPE mediapipe_counter_total counter\n"));
+  EXPECT_THAT(metrics, HasSubstr("mediapipe_counter_total{counter="
+                                 "\"PassThroughCalculator-PassThrough\"} 3\n"));
+  EXPECT_THAT(metrics, HasSubstr("mediapipe_input_queue_size{node="
+                                 "\"PassThroughCalculator\",stream=\"input\"}"
+                                 " 0\n"));
+  EXPECT_THAT(metrics, HasSubstr("mediapipe_process_calls_total{node="
+                                 "\"PassThroughCalculator\"} 3\n"));
+  EXPECT_THAT(metrics,
+              HasSubstr("mediapipe_process_runtime_usec{node="
+                        "\"PassThroughCalculator\",quantile=\"0.99\"}"));
+}
+
+TEST(GraphMetricsExporterTest, SkipsProfilesWithoutProfiler) {
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(PassThroughConfig(/*enable_profiler=*/false)));
+  RunGraph(&graph);
+
+  std::string metrics = ExportGraphMetrics(&graph);
+  EXPECT_THAT(metrics, HasSubstr("mediapipe_counter_total{"));
+  EXPECT_THAT(metrics, Not(HasSubstr("mediapipe_process_calls_total")));
+}
+
+}  // namespace
+}  // namespace mediapipe
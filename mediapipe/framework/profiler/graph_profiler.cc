@@ -14,18 +14,23 @@
 
 #include "mediapipe/framework/profiler/graph_profiler.h"
 
-#include <fstream>
-#include <list>
+#include <time.h>
 
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <utility>
+
+#include "absl/memory/memory.h"
 #include "absl/strings/substitute.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
-#include "mediapipe/framework/port/advanced_proto_lite_inc.h"
+#include "mediapipe/framework/input_stream_manager.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/logging.h"
-#include "mediapipe/framework/port/proto_ns.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/profiler/payload_size.h"
 #include "mediapipe/framework/profiler/profiler_resource_util.h"
 #include "mediapipe/framework/tool/tag_map.h"
 #include "mediapipe/framework/tool/validate_name.h"
@@ -43,6 +48,92 @@ const char kDefaultLogFilePrefix[] = "mediapipe_trace_";
 // The number of recent timestamps tracked for each input stream.
 const int kPacketInfoRecentCount = 100;
 
+// The default interval between memory samples.
+const int64 kDefaultMemorySampleIntervalUsec = 10000;
+
+// The log-linear buckets used to estimate percentiles. Times below
+// kPercentileSubBuckets usec have a bucket each, and each larger power of two
+// up to 2^kPercentileMaxExponent usec is split into kPercentileSubBuckets.
+const int kPercentileSubBucketBits = 4;
+const int64 kPercentileSubBuckets = 1 << kPercentileSubBucketBits;
+const int kPercentileMaxExponent = 40;
+const int kNumPercentileBuckets =
+    kPercentileSubBuckets *
+    (kPercentileMaxExponent - kPercentileSubBucketBits + 1);
+
+// Returns the log-linear bucket of a non-negative time.
+int PercentileBucket(int64 time_usec) {
+  if (time_usec < kPercentileSubBuckets) {
+    return time_usec;
+  }
+  time_usec =
+      std::min<int64>(time_usec, (int64{1} << kPercentileMaxExponent) - 1);
+  int shift = std::ilogb(static_cast<double>(time_usec)) -
+              kPercentileSubBucketBits;
+  return kPercentileSubBuckets * (shift + 1) +
+         (time_usec >> shift) - kPercentileSubBuckets;
+}
+
+// Returns the time in the middle of a log-linear bucket.
+int64 PercentileBucketTime(int bucket) {
+  if (bucket < kPercentileSubBuckets) {
+    return bucket;
+  }
+  int shift = bucket / kPercentileSubBuckets - 1;
+  int64 start = (kPercentileSubBuckets + bucket % kPercentileSubBuckets)
+                << shift;
+  return start + (int64{1} << shift) / 2;
+}
+
+// Returns the time below which "fraction" of the samples fall.
+int64 EstimatePercentile(const TimeHistogram& histogram, int64 num_samples,
+                         double fraction) {
+  int64 rank = std::max<int64>(1, std::ceil(fraction * num_samples));
+  int64 count = 0;
+  for (int bucket = 0; bucket < histogram.log_linear_count_size(); ++bucket) {
+    count += histogram.log_linear_count(bucket);
+    if (count >= rank) {
+      return PercentileBucketTime(bucket);
+    }
+  }
+  return PercentileBucketTime(histogram.log_linear_count_size() - 1);
+}
+
+// Returns the TimeHistograms present in a CalculatorProfile.
+std::vector<TimeHistogram*> GetTimeHistograms(CalculatorProfile* profile) {
+  std::vector<TimeHistogram*> result;
+  if (profile->has_process_runtime()) {
+    result.push_back(profile->mutable_process_runtime());
+  }
+  if (profile->has_process_input_latency()) {
+    result.push_back(profile->mutable_process_input_latency());
+  }
+  if (profile->has_process_output_latency()) {
+    result.push_back(profile->mutable_process_output_latency());
+  }
+  for (auto& input_stream_profile : *profile->mutable_input_stream_profiles()) {
+    result.push_back(input_stream_profile.mutable_latency());
+  }
+  if (profile->has_gpu_runtime()) {
+    result.push_back(profile->mutable_gpu_runtime());
+  }
+  if (profile->has_process_cpu_time()) {
+    result.push_back(profile->mutable_process_cpu_time());
+    result.push_back(profile->mutable_process_wait_time());
+  }
+  return result;
+}
+
+// Returns true if "histogram" has any samples.
+bool HasTimeSamples(const TimeHistogram& histogram) {
+  for (int64 count : histogram.count()) {
+    if (count > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
 std::string PacketIdToString(const PacketId& packet_id) {
   return absl::Substitute("stream_name: $0, timestamp_usec: $1",
                           packet_id.stream_name, packet_id.timestamp_usec);
@@ -82,39 +173,56 @@ bool IsTraceIntervalEnabled(const ProfilerConfig& profiler_config,
          absl::ToInt64Microseconds(tracer->GetTraceLogInterval()) != -1;
 }
 
-using PacketInfoMap =
-    ShardedMap<std::string, std::list<std::pair<int64, PacketInfo>>>;
+}  // namespace
 
-// Inserts a PacketInfo into a PacketInfoMap.
-void InsertPacketInfo(PacketInfoMap* map, const PacketId& packet_id,
-                      const PacketInfo& packet_info) {
-  auto entry = map->find(packet_id.stream_name);
-  if (entry == map->end()) {
-    entry = map->insert({packet_id.stream_name, {}}).first;
+void PacketInfoStore::Initialize(const std::vector<std::string>& stream_names,
+                                 int recent_count) {
+  buffers_.clear();
+  for (const std::string& stream_name : stream_names) {
+    buffers_[stream_name] = absl::make_unique<Buffer>(recent_count);
   }
-  auto& list = entry->second;
-  list.push_back({packet_id.timestamp_usec, packet_info});
-  while (list.size() > kPacketInfoRecentCount) {
-    list.pop_front();
+}
+
+void PacketInfoStore::Insert(const PacketId& packet_id,
+                             const PacketInfo& packet_info) {
+  auto iter = buffers_.find(packet_id.stream_name);
+  if (iter == buffers_.end()) {
+    return;
   }
+  iter->second->push_back({packet_id.timestamp_usec, packet_info});
 }
 
-// Returns a PacketInfo from a PacketInfoMap.
-PacketInfo* GetPacketInfo(PacketInfoMap* map, const PacketId& packet_id) {
-  auto entry = map->find(packet_id.stream_name);
-  if (entry == map->end()) {
-    return nullptr;
+bool PacketInfoStore::Find(const PacketId& packet_id,
+                           PacketInfo* packet_info) const {
+  auto iter = buffers_.find(packet_id.stream_name);
+  if (iter == buffers_.end()) {
+    return false;
   }
-  auto& list = entry->second;
-  for (auto iter = list.rbegin(); iter != list.rend(); ++iter) {
-    if (iter->first == packet_id.timestamp_usec) {
-      return &iter->second;
+  const Buffer& buffer = *iter->second;
+  // Search from the most recent packet. A slot overwritten by a concurrent
+  // Insert() holds a newer packet, which is simply not a match.
+  const Buffer::iterator begin = buffer.begin();
+  for (int64 i = buffer.end() - begin - 1; i >= 0; --i) {
+    Buffer::iterator entry = begin;
+    entry += i;
+    std::pair<int64, PacketInfo> recent = *entry;
+    if (recent.first == packet_id.timestamp_usec) {
+      *packet_info = recent.second;
+      return true;
     }
   }
-  return nullptr;
+  return false;
 }
 
-}  // namespace
+size_t PacketInfoStore::size() const {
+  size_t result = 0;
+  for (const auto& entry : buffers_) {
+    if (entry.second->begin() != entry.second->end()) {
+      ++result;
+    }
+  }
+  return result;
+}
 
 void GraphProfiler::Initialize(
     const ValidatedGraphConfig& validated_graph_config) {
@@ -130,6 +238,7 @@ void GraphProfiler::Initialize(
   if (IsTracerEnabled(profiler_config_)) {
     packet_tracer_ = absl::make_unique<GraphTracer>(profiler_config_);
   }
+  profile_cpu_time_ = profiler_config_.enable_cpu_time();
   for (int node_id = 0;
        node_id < validated_graph_config.CalculatorInfos().size(); ++node_id) {
     std::string node_name =
@@ -138,6 +247,12 @@ void GraphProfiler::Initialize(
     profile.set_name(node_name);
     InitializeTimeHistogram(interval_size_usec, num_intervals,
                             profile.mutable_process_runtime());
+    if (profile_cpu_time_) {
+      InitializeTimeHistogram(interval_size_usec, num_intervals,
+                              profile.mutable_process_cpu_time());
+      InitializeTimeHistogram(interval_size_usec, num_intervals,
+                              profile.mutable_process_wait_time());
+    }
     if (profiler_config_.enable_stream_latency()) {
       InitializeTimeHistogram(interval_size_usec, num_intervals,
                               profile.mutable_process_input_latency());
@@ -150,11 +265,52 @@ void GraphProfiler::Initialize(
       InitializeInputStreams(node_config, interval_size_usec, num_intervals,
                              &profile);
     }
+    if (profiler_config_.enable_percentiles()) {
+      for (TimeHistogram* histogram : GetTimeHistograms(&profile)) {
+        InitializePercentiles(histogram);
+      }
+    }
 
     auto iter = calculator_profiles_.insert({node_name, profile});
     CHECK(iter.second) << absl::Substitute(
         "Calculator \"$0\" has already been added.", node_name);
+    node_indexes_[node_name] = {
+        node_id, validated_graph_config.CalculatorInfos()[node_id]
+                     .InputStreamBaseIndex()};
+    if (profiler_config_.enable_gpu_timer_queries()) {
+      absl::MutexLock gpu_lock(&gpu_mutex_);
+      TimeHistogram* gpu_runtime = &gpu_runtimes_[node_id];
+      InitializeTimeHistogram(interval_size_usec, num_intervals, gpu_runtime);
+      if (profiler_config_.enable_percentiles()) {
+        InitializePercentiles(gpu_runtime);
+      }
+    }
+  }
+  if (profiler_config_.enable_stream_latency()) {
+    std::vector<std::string> stream_names;
+    for (const EdgeInfo& output_stream :
+         validated_graph_config.OutputStreamInfos()) {
+      stream_names.push_back(output_stream.name);
+    }
+    packets_info_.Initialize(stream_names, kPacketInfoRecentCount);
+  }
+  {
+    absl::MutexLock generator_lock(&generator_mutex_);
+    const auto& generator_configs =
+        validated_graph_config.Config().packet_generator();
+    for (int index = 0; index < generator_configs.size(); ++index) {
+      PacketGeneratorProfile profile;
+      profile.set_name(generator_configs.Get(index).packet_generator());
+      profile.set_index(index);
+      InitializeTimeHistogram(interval_size_usec, num_intervals,
+                              profile.mutable_generate_runtime());
+      if (profiler_config_.enable_percentiles()) {
+        InitializePercentiles(profile.mutable_generate_runtime());
+      }
+      generator_profiles_.push_back(std::move(profile));
+    }
   }
+  num_input_streams_ = validated_graph_config.InputStreamInfos().size();
   is_initialized_ = true;
 }
 
@@ -190,11 +346,46 @@ void GraphProfiler::Reset() {
     ResetTimeHistogram(calculator_profile->mutable_process_runtime());
     ResetTimeHistogram(calculator_profile->mutable_process_input_latency());
     ResetTimeHistogram(calculator_profile->mutable_process_output_latency());
+    if (calculator_profile->has_process_cpu_time()) {
+      ResetTimeHistogram(calculator_profile->mutable_process_cpu_time());
+      ResetTimeHistogram(calculator_profile->mutable_process_wait_time());
+    }
     for (auto& input_stream_profile :
          *(calculator_profile->mutable_input_stream_profiles())) {
       ResetTimeHistogram(input_stream_profile.mutable_latency());
     }
   }
+  {
+    absl::MutexLock gpu_lock(&gpu_mutex_);
+    for (auto& entry : gpu_runtimes_) {
+      ResetTimeHistogram(&entry.second);
+    }
+  }
+  {
+    absl::MutexLock memory_lock(&memory_mutex_);
+    for (auto* stats_map : {&output_memory_, &queue_memory_}) {
+      for (auto& entry : *stats_map) {
+        entry.second.peak_bytes = entry.second.current_bytes;
+      }
+    }
+    for (auto& entry : buffer_pools_) {
+      BufferPoolProfile* profile = &entry.second.profile;
+      profile->set_peak_bytes(profile->in_use_bytes() +
+                              profile->available_bytes());
+    }
+  }
+  absl::MutexLock back_pressure_lock(&back_pressure_mutex_);
+  int64 time_now_usec = TimeNowUsec();
+  for (auto* stats_map : {&full_input_streams_, &throttled_nodes_}) {
+    for (auto& entry : *stats_map) {
+      BackPressureStats* stats = &entry.second;
+      stats->count = stats->start_time_usec >= 0 ? 1 : 0;
+      stats->total_time_usec = 0;
+      if (stats->start_time_usec >= 0) {
+        stats->start_time_usec = time_now_usec;
+      }
+    }
+  }
 }
 
 // Begins profiling for a single graph run.
@@ -225,6 +416,10 @@ void GraphProfiler::Reset() {
   // If specified, write a final profile.
   if (IsTraceLogEnabled(profiler_config_)) {
     MP_RETURN_IF_ERROR(WriteProfile());
+    absl::MutexLock lock(&trace_log_writer_mutex_);
+    if (trace_log_writer_) {
+      MP_RETURN_IF_ERROR(trace_log_writer_->Flush());
+    }
   }
   return ::mediapipe::OkStatus();
 }
@@ -232,7 +427,7 @@ void GraphProfiler::Reset() {
 void GraphProfiler::LogEvent(const TraceEvent& event) {
   // Record event info in the event trace log.
 
-  if (packet_tracer_) {
+  if (packet_tracer_ && packet_tracer_->IsSampled(event.input_ts)) {
     if (event.event_type == GraphTrace::GPU_TASK ||
         event.event_type == GraphTrace::GPU_CALIBRATION) {
       packet_tracer_->LogEvent(event);
@@ -281,12 +476,282 @@ void GraphProfiler::AddPacketInfo(const TraceEvent& packet_info) {
   absl::ReaderMutexLock lock(&profiler_mutex_);
   RET_CHECK(is_initialized_)
       << "GetCalculatorProfiles can only be called after Initialize()";
+  const int first_profile = profiles->size();
   for (auto& entry : calculator_profiles_) {
     profiles->push_back(entry.second);
+    AddGpuRuntime(node_indexes_.at(entry.first).node_id, &profiles->back());
+    if (profiler_config_.enable_percentiles()) {
+      for (TimeHistogram* histogram : GetTimeHistograms(&profiles->back())) {
+        SetPercentiles(histogram);
+      }
+    }
+    AddBackPressureStats(node_indexes_.at(entry.first), &profiles->back());
+  }
+  if (profiler_config_.enable_memory_profiling()) {
+    absl::MutexLock memory_lock(&memory_mutex_);
+    SampleMemory();
+    for (int i = first_profile; i < profiles->size(); ++i) {
+      CalculatorProfile* profile = &(*profiles)[i];
+      AddMemoryStats(node_indexes_.at(profile->name()), profile);
+    }
+  }
+  return ::mediapipe::OkStatus();
+}
+
+void GraphProfiler::AddGpuTaskSample(int node_id, Timestamp input_timestamp,
+                                     absl::Time start_time,
+                                     absl::Duration gpu_runtime) {
+  if (is_tracing_) {
+    TraceEvent event(GraphTrace::GPU_TASK);
+    event.set_node_id(node_id).set_input_ts(input_timestamp);
+    LogEvent(TraceEvent(event).set_event_time(start_time).set_is_finish(false));
+    LogEvent(TraceEvent(event)
+                 .set_event_time(start_time + gpu_runtime)
+                 .set_is_finish(true));
+  }
+  absl::ReaderMutexLock lock(&profiler_mutex_);
+  if (!is_profiling_) {
+    return;
+  }
+  absl::MutexLock gpu_lock(&gpu_mutex_);
+  auto iter = gpu_runtimes_.find(node_id);
+  if (iter != gpu_runtimes_.end()) {
+    int64 start_time_usec = ToUnixMicros(start_time);
+    AddTimeSample(start_time_usec,
+                  start_time_usec + absl::ToInt64Microseconds(gpu_runtime),
+                  &iter->second);
+  }
+}
+
+void GraphProfiler::AddPacketGeneratorSample(int generator_index,
+                                             absl::Time start_time,
+                                             absl::Time end_time) {
+  if (!is_initialized_ || !IsProfilerEnabled(profiler_config_)) {
+    return;
+  }
+  absl::MutexLock generator_lock(&generator_mutex_);
+  if (generator_index < 0 || generator_index >= generator_profiles_.size()) {
+    return;
+  }
+  AddTimeSample(
+      ToUnixMicros(start_time), ToUnixMicros(end_time),
+      generator_profiles_[generator_index].mutable_generate_runtime());
+}
+
+::mediapipe::Status GraphProfiler::GetPacketGeneratorProfiles(
+    std::vector<PacketGeneratorProfile>* profiles) const {
+  RET_CHECK(is_initialized_)
+      << "GetPacketGeneratorProfiles can only be called after Initialize()";
+  absl::MutexLock generator_lock(&generator_mutex_);
+  for (const PacketGeneratorProfile& profile : generator_profiles_) {
+    profiles->push_back(profile);
+    if (profiler_config_.enable_percentiles()) {
+      SetPercentiles(profiles->back().mutable_generate_runtime());
+    }
+  }
+  return ::mediapipe::OkStatus();
+}
+
+void GraphProfiler::AddGpuRuntime(int node_id,
+                                  CalculatorProfile* profile) const {
+  absl::MutexLock gpu_lock(&gpu_mutex_);
+  auto iter = gpu_runtimes_.find(node_id);
+  if (iter != gpu_runtimes_.end() && HasTimeSamples(iter->second)) {
+    *profile->mutable_gpu_runtime() = iter->second;
+  }
+}
+
+void GraphProfiler::SetInputStreamManagers(
+    const InputStreamManager* input_stream_managers) {
+  absl::MutexLock lock(&back_pressure_mutex_);
+  input_stream_managers_ = input_stream_managers;
+}
+
+void GraphProfiler::SetInputStreamFull(int input_stream_index, bool is_full) {
+  absl::MutexLock lock(&back_pressure_mutex_);
+  UpdateBackPressureStats(is_full, &full_input_streams_[input_stream_index]);
+}
+
+void GraphProfiler::SetNodeThrottled(int node_id, bool is_throttled) {
+  absl::MutexLock lock(&back_pressure_mutex_);
+  UpdateBackPressureStats(is_throttled, &throttled_nodes_[node_id]);
+}
+
+void GraphProfiler::UpdateBackPressureStats(bool is_started,
+                                            BackPressureStats* stats) {
+  if (!is_profiling_) {
+    // A period that ends while paused is dropped along with its start.
+    stats->start_time_usec = -1;
+    return;
+  }
+  int64 time_now_usec = TimeNowUsec();
+  if (is_started && stats->start_time_usec < 0) {
+    ++stats->count;
+    stats->start_time_usec = time_now_usec;
+  } else if (!is_started && stats->start_time_usec >= 0) {
+    stats->total_time_usec += time_now_usec - stats->start_time_usec;
+    stats->start_time_usec = -1;
+  }
+}
+
+int64 GraphProfiler::BackPressureTimeUsec(
+    const BackPressureStats& stats) const {
+  int64 result = stats.total_time_usec;
+  if (stats.start_time_usec >= 0) {
+    result += TimeNowUsec() - stats.start_time_usec;
+  }
+  return result;
+}
+
+void GraphProfiler::AddBackPressureStats(const NodeIndexes& node_indexes,
+                                         CalculatorProfile* profile) const {
+  absl::MutexLock lock(&back_pressure_mutex_);
+  auto node_iter = throttled_nodes_.find(node_indexes.node_id);
+  if (node_iter != throttled_nodes_.end()) {
+    profile->set_num_throttled(node_iter->second.count);
+    profile->set_throttled_time_usec(BackPressureTimeUsec(node_iter->second));
+  }
+  // The input stream profiles are present only with enable_stream_latency,
+  // and are ordered by input stream id.
+  for (int id = 0; id < profile->input_stream_profiles_size(); ++id) {
+    StreamProfile* stream_profile = profile->mutable_input_stream_profiles(id);
+    int input_stream_index = node_indexes.input_stream_base_index + id;
+    if (input_stream_managers_) {
+      stream_profile->set_max_queue_size(
+          input_stream_managers_[input_stream_index].QueueSizeHighWaterMark());
+    }
+    auto stream_iter = full_input_streams_.find(input_stream_index);
+    if (stream_iter != full_input_streams_.end()) {
+      stream_profile->set_num_full(stream_iter->second.count);
+      stream_profile->set_full_time_usec(
+          BackPressureTimeUsec(stream_iter->second));
+    }
+  }
+}
+
+void GraphProfiler::AddBufferPool(
+    const std::string& name,
+    std::function<void(BufferPoolProfile*)> get_usage) {
+  absl::MutexLock lock(&memory_mutex_);
+  BufferPool* pool = &buffer_pools_[name];
+  pool->get_usage = std::move(get_usage);
+  pool->profile.set_name(name);
+}
+
+void GraphProfiler::RemoveBufferPool(const std::string& name) {
+  absl::MutexLock lock(&memory_mutex_);
+  buffer_pools_.erase(name);
+}
+
+::mediapipe::Status GraphProfiler::GetBufferPoolProfiles(
+    std::vector<BufferPoolProfile>* profiles) const {
+  RET_CHECK(is_initialized_)
+      << "GetBufferPoolProfiles can only be called after Initialize()";
+  if (!profiler_config_.enable_memory_profiling()) {
+    return ::mediapipe::OkStatus();
+  }
+  absl::MutexLock lock(&memory_mutex_);
+  SampleMemory();
+  for (const auto& entry : buffer_pools_) {
+    profiles->push_back(entry.second.profile);
   }
   return ::mediapipe::OkStatus();
 }
 
+void GraphProfiler::AddOutputPayloads(
+    const CalculatorContext& calculator_context) {
+  const int node_id = calculator_context.NodeId();
+  absl::MutexLock lock(&memory_mutex_);
+  for (const OutputStreamShard& output_stream_shard :
+       calculator_context.Outputs()) {
+    for (const Packet& packet : *output_stream_shard.OutputQueue()) {
+      int64 bytes = PayloadBytes(packet);
+      if (bytes == 0) {
+        continue;
+      }
+      const packet_internal::HolderBase* holder =
+          packet_internal::GetHolder(packet);
+      auto iter = live_payloads_.find(holder);
+      if (iter != live_payloads_.end()) {
+        if (!iter->second.holder.expired()) {
+          // A forwarded payload stays with the calculator that output it
+          // first.
+          continue;
+        }
+        // The holder was released and its address reused.
+        output_memory_[iter->second.node_id].current_bytes -=
+            iter->second.bytes;
+        live_payloads_.erase(iter);
+      }
+      live_payloads_.emplace(
+          holder,
+          LivePayload{packet_internal::GetWeakHolder(packet), bytes, node_id});
+      output_memory_[node_id].current_bytes += bytes;
+    }
+  }
+  int64 interval_usec = profiler_config_.memory_sample_interval_usec() > 0
+                            ? profiler_config_.memory_sample_interval_usec()
+                            : kDefaultMemorySampleIntervalUsec;
+  if (TimeNowUsec() - last_memory_sample_usec_ >= interval_usec) {
+    SampleMemory();
+  }
+}
+
+void GraphProfiler::SampleMemory() const {
+  last_memory_sample_usec_ = TimeNowUsec();
+  for (auto iter = live_payloads_.begin(); iter != live_payloads_.end();) {
+    if (iter->second.holder.expired()) {
+      output_memory_[iter->second.node_id].current_bytes -= iter->second.bytes;
+      iter = live_payloads_.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+  for (auto& entry : output_memory_) {
+    MemoryStats* stats = &entry.second;
+    stats->peak_bytes = std::max(stats->peak_bytes, stats->current_bytes);
+  }
+  {
+    absl::MutexLock back_pressure_lock(&back_pressure_mutex_);
+    if (input_stream_managers_) {
+      for (int index = 0; index < num_input_streams_; ++index) {
+        MemoryStats* stats = &queue_memory_[index];
+        stats->current_bytes =
+            input_stream_managers_[index].QueuePayloadBytes();
+        stats->peak_bytes = std::max(stats->peak_bytes, stats->current_bytes);
+      }
+    }
+  }
+  for (auto& entry : buffer_pools_) {
+    BufferPoolProfile* profile = &entry.second.profile;
+    entry.second.get_usage(profile);
+    profile->set_peak_bytes(std::max(
+        profile->peak_bytes(),
+        profile->in_use_bytes() + profile->available_bytes()));
+  }
+}
+
+void GraphProfiler::AddMemoryStats(const NodeIndexes& node_indexes,
+                                   CalculatorProfile* profile) const {
+  auto node_iter = output_memory_.find(node_indexes.node_id);
+  if (node_iter != output_memory_.end()) {
+    profile->set_live_output_bytes(node_iter->second.current_bytes);
+    profile->set_peak_live_output_bytes(node_iter->second.peak_bytes);
+  }
+  // As with the queue sizes, the input stream profiles are present only with
+  // enable_stream_latency.
+  for (int id = 0; id < profile->input_stream_profiles_size(); ++id) {
+    auto stream_iter =
+        queue_memory_.find(node_indexes.input_stream_base_index + id);
+    if (stream_iter != queue_memory_.end()) {
+      StreamProfile* stream_profile =
+          profile->mutable_input_stream_profiles(id);
+      stream_profile->set_queue_bytes(stream_iter->second.current_bytes);
+      stream_profile->set_peak_queue_bytes(stream_iter->second.peak_bytes);
+    }
+  }
+}
+
 void GraphProfiler::InitializeTimeHistogram(int64 interval_size_usec,
                                             int64 num_intervals,
                                             TimeHistogram* histogram) {
@@ -296,6 +761,24 @@ void GraphProfiler::InitializeTimeHistogram(int64 interval_size_usec,
   ResetTimeHistogram(histogram);
 }
 
+void GraphProfiler::InitializePercentiles(TimeHistogram* histogram) {
+  histogram->mutable_log_linear_count()->Resize(kNumPercentileBuckets,
+                                                /*value=*/0);
+}
+
+void GraphProfiler::SetPercentiles(TimeHistogram* histogram) {
+  int64 num_samples = 0;
+  for (int64 count : histogram->log_linear_count()) {
+    num_samples += count;
+  }
+  if (num_samples == 0) {
+    return;
+  }
+  histogram->set_p50_usec(EstimatePercentile(*histogram, num_samples, 0.50));
+  histogram->set_p95_usec(EstimatePercentile(*histogram, num_samples, 0.95));
+  histogram->set_p99_usec(EstimatePercentile(*histogram, num_samples, 0.99));
+}
+
 void GraphProfiler::InitializeOutputStreams(
     const CalculatorGraphConfig::Node& node_config) {}
 
@@ -342,18 +825,34 @@ std::set<int> GraphProfiler::GetBackEdgeIds(
   return back_edge_ids;
 }
 
+int64 GraphProfiler::ThreadCpuTimeUsec() {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+  struct timespec time;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) == 0) {
+    return time.tv_sec * int64{1000000} + time.tv_nsec / 1000;
+  }
+#endif  // defined(CLOCK_THREAD_CPUTIME_ID)
+  return -1;
+}
+
 void GraphProfiler::ResetTimeHistogram(TimeHistogram* histogram) {
   histogram->set_total(0);
   for (auto& count : *(histogram->mutable_count())) {
     count = 0;
   }
+  for (auto& count : *(histogram->mutable_log_linear_count())) {
+    count = 0;
+  }
+  histogram->clear_p50_usec();
+  histogram->clear_p95_usec();
+  histogram->clear_p99_usec();
 }
 
 void GraphProfiler::AddPacketInfoInternal(const PacketId& packet_id,
                                           int64 production_time_usec,
                                           int64 source_process_start_usec) {
   PacketInfo packet_info = {0, production_time_usec, source_process_start_usec};
-  InsertPacketInfo(&packets_info_, packet_id, packet_info);
+  packets_info_.Insert(packet_id, packet_info);
 }
 
 void GraphProfiler::AddPacketInfoForOutputPackets(
@@ -401,6 +900,26 @@ void GraphProfiler::SetOpenRuntime(const CalculatorContext& calculator_context,
     AddStreamLatencies(calculator_context, start_time_usec, end_time_usec,
                        calculator_profile);
   }
+  if (profiler_config_.enable_memory_profiling()) {
+    AddOutputPayloads(calculator_context);
+  }
+}
+
+void GraphProfiler::AddWarmupRuntime(
+    const CalculatorContext& calculator_context,
+    absl::Duration warmup_runtime) {
+  absl::ReaderMutexLock lock(&profiler_mutex_);
+  if (!is_profiling_) {
+    return;
+  }
+  auto profile_iter = calculator_profiles_.find(calculator_context.NodeName());
+  CHECK(profile_iter != calculator_profiles_.end()) << absl::Substitute(
+      "Calculator \"$0\" has not been added during initialization.",
+      calculator_context.NodeName());
+  CalculatorProfile* calculator_profile = &profile_iter->second;
+  calculator_profile->set_warmup_runtime(
+      calculator_profile->warmup_runtime() +
+      absl::ToInt64Microseconds(warmup_runtime));
 }
 
 void GraphProfiler::SetCloseRuntime(const CalculatorContext& calculator_context,
@@ -423,6 +942,9 @@ void GraphProfiler::SetCloseRuntime(const CalculatorContext& calculator_context,
     AddStreamLatencies(calculator_context, start_time_usec, end_time_usec,
                        calculator_profile);
   }
+  if (profiler_config_.enable_memory_profiling()) {
+    AddOutputPayloads(calculator_context);
+  }
 }
 
 void GraphProfiler::AddTimeSample(int64 start_time_usec, int64 end_time_usec,
@@ -435,6 +957,11 @@ void GraphProfiler::AddTimeSample(int64 start_time_usec, int64 end_time_usec,
     interval_index = histogram->num_intervals() - 1;
   }
   histogram->set_count(interval_index, histogram->count(interval_index) + 1);
+  if (histogram->log_linear_count_size() > 0) {
+    int bucket = PercentileBucket(time_usec);
+    histogram->set_log_linear_count(bucket,
+                                    histogram->log_linear_count(bucket) + 1);
+  }
 }
 
 int64 GraphProfiler::AddInputStreamTimeSamples(
@@ -446,7 +973,9 @@ int64 GraphProfiler::AddInputStreamTimeSamples(
   for (CollectionItemId id = calculator_context.Inputs().BeginId();
        id < calculator_context.Inputs().EndId(); ++id) {
     ++input_stream_counter;
-    if (calculator_context.Inputs().Get(id).Value().IsEmpty() ||
+    // An input consumed by the calculator is empty, but keeps its timestamp.
+    if (calculator_context.Inputs().Get(id).Value().Timestamp() ==
+            Timestamp::Unset() ||
         calculator_profile->input_stream_profiles(input_stream_counter)
             .back_edge()) {
       continue;
@@ -454,8 +983,8 @@ int64 GraphProfiler::AddInputStreamTimeSamples(
 
     PacketId packet_id = {calculator_context.Inputs().Get(id).Name(),
                           input_timestamp_usec};
-    PacketInfo* packet_info = GetPacketInfo(&packets_info_, packet_id);
-    if (packet_info == nullptr) {
+    PacketInfo packet_info;
+    if (!packets_info_.Find(packet_id, &packet_info)) {
       // This is a condition rather than a failure CHECK because
       // under certain conditions the consumer calculator's Process()
       // can start before the producer calculator's Process() is finished.
@@ -464,12 +993,12 @@ int64 GraphProfiler::AddInputStreamTimeSamples(
       continue;
     }
     AddTimeSample(
-        packet_info->production_time_usec, start_time_usec,
+        packet_info.production_time_usec, start_time_usec,
         calculator_profile->mutable_input_stream_profiles(input_stream_counter)
             ->mutable_latency());
 
     min_source_process_start_usec = std::min(
-        min_source_process_start_usec, packet_info->source_process_start_usec);
+        min_source_process_start_usec, packet_info.source_process_start_usec);
   }
 
   return min_source_process_start_usec;
@@ -477,7 +1006,7 @@ int64 GraphProfiler::AddInputStreamTimeSamples(
 
 void GraphProfiler::AddProcessSample(
     const CalculatorContext& calculator_context, int64 start_time_usec,
-    int64 end_time_usec) {
+    int64 end_time_usec, int64 cpu_time_usec) {
   absl::ReaderMutexLock lock(&profiler_mutex_);
   if (!is_profiling_) {
     return;
@@ -493,6 +1022,16 @@ void GraphProfiler::AddProcessSample(
   // Update Process() runtime.
   AddTimeSample(start_time_usec, end_time_usec,
                 calculator_profile->mutable_process_runtime());
+  if (cpu_time_usec >= 0 && calculator_profile->has_process_cpu_time()) {
+    // The profiler clock may be a simulated clock, or coarser than the CPU
+    // clock, so the CPU time is capped at the runtime.
+    const int64 runtime_usec = end_time_usec - start_time_usec;
+    cpu_time_usec = std::min(cpu_time_usec, runtime_usec);
+    AddTimeSample(0, cpu_time_usec,
+                  calculator_profile->mutable_process_cpu_time());
+    AddTimeSample(cpu_time_usec, runtime_usec,
+                  calculator_profile->mutable_process_wait_time());
+  }
 
   if (profiler_config_.enable_stream_latency()) {
     int64 min_source_process_start_usec = AddStreamLatencies(
@@ -503,6 +1042,9 @@ void GraphProfiler::AddProcessSample(
     AddTimeSample(min_source_process_start_usec, end_time_usec,
                   calculator_profile->mutable_process_output_latency());
   }
+  if (profiler_config_.enable_memory_profiling()) {
+    AddOutputPayloads(calculator_context);
+  }
 }
 
 std::unique_ptr<GlProfilingHelper> GraphProfiler::CreateGlProfilingHelper() {
@@ -512,47 +1054,15 @@ std::unique_ptr<GlProfilingHelper> GraphProfiler::CreateGlProfilingHelper() {
   return absl::make_unique<mediapipe::GlProfilingHelper>(shared_from_this());
 }
 
-// A simple ZeroCopyOutputStream that writes to a std::ostream.
-class OstreamStream : public proto_ns::io::ZeroCopyOutputStream {
- public:
-  explicit OstreamStream(std::ostream* output)
-      : output_(output), buffer_used_(0), position_(0) {}
-  ~OstreamStream() override { WriteBuffer(); }
-  bool Next(void** data, int* size) override {
-    *data = buffer_;
-    *size = sizeof(buffer_);
-    return WriteBuffer();
-  }
-  void BackUp(int count) override { buffer_used_ -= count; }
-  int64_t ByteCount() const override { return position_; }
-
- private:
-  // Writes the buffer to the ostream.
-  bool WriteBuffer() {
-    output_->write(buffer_, buffer_used_);
-    position_ += buffer_used_;
-    buffer_used_ = sizeof(buffer_);
-    return output_->good();
-  }
-  std::ostream* output_;
-  char buffer_[1024];
-  int buffer_used_;
-  int position_;
-  OstreamStream(const OstreamStream&) = delete;
-  OstreamStream& operator=(const OstreamStream&) = delete;
-};
-
-// Sets the canonical node name in each CalculatorGraphConfig::Node
-// and also in GraphTrace.
-void AssignNodeNames(GraphProfile* profile) {
-  CalculatorGraphConfig* graph_config = profile->mutable_config();
-  GraphTrace* graph_trace = profile->mutable_graph_trace(0);
-  graph_trace->clear_calculator_name();
-  for (int i = 0; i < graph_config->node().size(); ++i) {
-    std::string node_name = CanonicalNodeName(*graph_config, i);
-    graph_config->mutable_node(i)->set_name(node_name);
-    graph_trace->add_calculator_name(node_name);
+// Returns the graph config with the canonical node name assigned to each
+// CalculatorGraphConfig::Node.
+CalculatorGraphConfig ConfigWithNodeNames(
+    const CalculatorGraphConfig& config) {
+  CalculatorGraphConfig result = config;
+  for (int i = 0; i < result.node().size(); ++i) {
+    result.mutable_node(i)->set_name(CanonicalNodeName(config, i));
   }
+  return result;
 }
 
 ::mediapipe::StatusOr<std::string> GraphProfiler::GetTraceLogPath() {
@@ -578,8 +1088,6 @@ void AssignNodeNames(GraphProfile* profile) {
   ASSIGN_OR_RETURN(std::string trace_log_path, GetTraceLogPath());
   // Inform the user via logging the path to the trace logs.
   LOG(INFO) << "trace_log_path: " << trace_log_path;
-  int log_interval_count = GetLogIntervalCount(profiler_config_);
-  int log_file_count = GetLogFileCount(profiler_config_);
 
   // Record the GraphTrace events since the previous WriteProfile.
   // The end_time is chosen to be trace_log_margin_usec in the past,
@@ -607,28 +1115,33 @@ void AssignNodeNames(GraphProfile* profile) {
   for (CalculatorProfile& p : profiles) {
     *profile.mutable_calculator_profiles()->Add() = std::move(p);
   }
-  this->Reset();
-
-  // Record the CalculatorGraphConfig, once per log file.
-  ++previous_log_index_;
-  bool is_new_file = (previous_log_index_ % log_interval_count == 0);
-  if (is_new_file) {
-    *profile.mutable_config() = validated_graph_->Config();
-    AssignNodeNames(&profile);
+  std::vector<BufferPoolProfile> buffer_pool_profiles;
+  status.Update(GetBufferPoolProfiles(&buffer_pool_profiles));
+  for (BufferPoolProfile& p : buffer_pool_profiles) {
+    *profile.mutable_buffer_pool_profiles()->Add() = std::move(p);
+  }
+  std::vector<PacketGeneratorProfile> generator_profiles;
+  status.Update(GetPacketGeneratorProfiles(&generator_profiles));
+  for (PacketGeneratorProfile& p : generator_profiles) {
+    *profile.mutable_packet_generator_profiles()->Add() = std::move(p);
   }
+  this->Reset();
 
-  // Write the GraphProfile to the trace_log_path.
-  int log_index = previous_log_index_ / log_interval_count % log_file_count;
-  std::string log_path = absl::StrCat(trace_log_path, log_index, ".binarypb");
-  std::ofstream ofs;
-  if (is_new_file) {
-    ofs.open(log_path, std::ofstream::out | std::ofstream::trunc);
-  } else {
-    ofs.open(log_path, std::ofstream::out | std::ofstream::app);
+  {
+    absl::MutexLock lock(&trace_log_writer_mutex_);
+    if (!trace_log_writer_) {
+      TraceLogWriter::Options options;
+      options.path_prefix = trace_log_path;
+      options.format = profiler_config_.trace_log_format();
+      options.file_count = GetLogFileCount(profiler_config_);
+      options.interval_count = GetLogIntervalCount(profiler_config_);
+      options.max_file_bytes = profiler_config_.trace_log_max_file_bytes();
+      options.queue_size = profiler_config_.trace_log_queue_size();
+      options.graph_config = ConfigWithNodeNames(validated_graph_->Config());
+      trace_log_writer_ = absl::make_unique<TraceLogWriter>(std::move(options));
+    }
+    status.Update(trace_log_writer_->Write(std::move(profile)));
   }
-  OstreamStream out(&ofs);
-  RET_CHECK(profile.SerializeToZeroCopyStream(&out))
-      << "Could not write binary GraphProfile to: " << log_path;
   return status;
 }
 
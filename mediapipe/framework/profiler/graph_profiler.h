@@ -17,9 +17,13 @@
 
 #include <atomic>
 #include <cstddef>
+#include <functional>
+#include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "absl/time/time.h"
@@ -30,13 +34,16 @@
 #include "mediapipe/framework/deps/monotonic_clock.h"
 #include "mediapipe/framework/executor.h"
 #include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/profiler/circular_buffer.h"
 #include "mediapipe/framework/profiler/graph_tracer.h"
 #include "mediapipe/framework/profiler/sharded_map.h"
+#include "mediapipe/framework/profiler/trace_log_writer.h"
 #include "mediapipe/framework/validated_graph_config.h"
 
 namespace mediapipe {
 
 class GlProfilingHelper;
+class InputStreamManager;
 
 struct PacketId {
   // Stream name, excluding TAG if available.
@@ -68,6 +75,39 @@ struct PacketInfo {
   }
 };
 
+// Stores the PacketInfo of the recent packets of each stream.
+// The streams are fixed by Initialize(), after which Insert() and Find() may be
+// called from any thread without locking. Each stream keeps its packets in a
+// lock-free CircularBuffer, so inserting costs one atomic increment.
+class PacketInfoStore {
+ public:
+  PacketInfoStore() = default;
+
+  // Not copyable or movable.
+  PacketInfoStore(const PacketInfoStore&) = delete;
+  PacketInfoStore& operator=(const PacketInfoStore&) = delete;
+
+  // Creates a buffer for the most recent "recent_count" packets of each
+  // stream in "stream_names". Must be called before any other method.
+  void Initialize(const std::vector<std::string>& stream_names,
+                  int recent_count);
+
+  // Records the PacketInfo of a packet. The packet is ignored if its stream
+  // was not passed to Initialize().
+  void Insert(const PacketId& packet_id, const PacketInfo& packet_info);
+
+  // Copies the most recent PacketInfo of a packet into "packet_info".
+  // Returns false if the packet is not among the recent packets.
+  bool Find(const PacketId& packet_id, PacketInfo* packet_info) const;
+
+  // Returns the number of streams with at least one packet.
+  size_t size() const;
+
+ private:
+  using Buffer = CircularBuffer<std::pair<int64, PacketInfo>>;
+  std::unordered_map<std::string, std::unique_ptr<Buffer>> buffers_;
+};
+
 // For testing
 class GraphProfilerTestPeer;
 
@@ -80,6 +120,9 @@ class GraphProfilerTestPeer;
 // the graph (source nodes) to reach the Calculator.
 // - Process input latency: Process input latency + process runtime for a
 // packet.
+// - Back-pressure: The input stream queue high-water marks, the number of
+// times and duration that each queue was full, and the number of times and
+// duration that each source calculator was throttled.
 //
 // The profiler can be configured in the graph definition:
 //   profiler_config {
@@ -101,10 +144,8 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
       : is_initialized_(false),
         is_profiling_(false),
         calculator_profiles_(1000),
-        packets_info_(1000),
         is_running_(false),
         previous_log_end_time_(absl::InfinitePast()),
-        previous_log_index_(-1),
         validated_graph_(nullptr) {
     clock_ = std::shared_ptr<mediapipe::Clock>(
         mediapipe::MonotonicClock::CreateSynchronizedMonotonicClock());
@@ -147,12 +188,83 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // Record a tracing event.
   void LogEvent(const TraceEvent& event);
 
+  // Sets the input stream queues of the graph, indexed by input stream index
+  // in the ValidatedGraphConfig, for reporting the queue high-water marks.
+  // The queues must remain valid until this is called again with nullptr.
+  void SetInputStreamManagers(const InputStreamManager* input_stream_managers)
+      LOCKS_EXCLUDED(back_pressure_mutex_);
+
+  // Records that the queue of an input stream, identified by its input stream
+  // index in the ValidatedGraphConfig, became full or not full.
+  void SetInputStreamFull(int input_stream_index, bool is_full)
+      LOCKS_EXCLUDED(back_pressure_mutex_);
+
+  // Records that a source calculator became throttled or unthrottled.
+  void SetNodeThrottled(int node_id, bool is_throttled)
+      LOCKS_EXCLUDED(back_pressure_mutex_);
+
+  // Returns true if the GPU-side runtime of GL tasks should be measured.
+  bool IsGpuTimerQueryEnabled() const {
+    return profiler_config_.enable_gpu_timer_queries();
+  }
+
+  // Records that the GPU spent "gpu_runtime" on a task of calculator "node_id"
+  // for "input_timestamp", which was issued at "start_time" on the profiler
+  // clock. The task is traced as a GPU_TASK from "start_time" to
+  // "start_time" + "gpu_runtime", since only its duration is measured.
+  void AddGpuTaskSample(int node_id, Timestamp input_timestamp,
+                        absl::Time start_time, absl::Duration gpu_runtime)
+      LOCKS_EXCLUDED(profiler_mutex_, gpu_mutex_);
+
+  // Returns the current time on the profiler clock.
+  absl::Time TimeNow() const { return clock_->TimeNow(); }
+
+  // Records that the calculator of "calculator_context" spent "warmup_runtime"
+  // warming up in Open(). Successive calls add up.
+  void AddWarmupRuntime(const CalculatorContext& calculator_context,
+                        absl::Duration warmup_runtime)
+      LOCKS_EXCLUDED(profiler_mutex_);
+
+  // Returns true if the memory held by packet payloads should be sampled.
+  bool IsMemoryProfilingEnabled() const {
+    return profiler_config_.enable_memory_profiling();
+  }
+
+  // Registers a buffer pool to be sampled along with the packet payloads.
+  // "get_usage" fills in the buffer counts and bytes of a BufferPoolProfile.
+  // It is called until RemoveBufferPool() is called with the same "name".
+  void AddBufferPool(const std::string& name,
+                     std::function<void(BufferPoolProfile*)> get_usage)
+      LOCKS_EXCLUDED(memory_mutex_);
+
+  // Stops sampling the buffer pool registered as "name".
+  void RemoveBufferPool(const std::string& name) LOCKS_EXCLUDED(memory_mutex_);
+
+  // Collects the current and peak occupancy of the registered buffer pools.
+  ::mediapipe::Status GetBufferPoolProfiles(
+      std::vector<BufferPoolProfile>*) const LOCKS_EXCLUDED(memory_mutex_);
+
   // Collects the runtime profile for Open(), Process(), and Close() of each
   // calculator in the graph. May be called at any time after the graph has been
   // initialized.
   ::mediapipe::Status GetCalculatorProfiles(
       std::vector<CalculatorProfile>*) const LOCKS_EXCLUDED(profiler_mutex_);
 
+  // Records that packet generator "generator_index" ran Generate() from
+  // "start_time" to "end_time" on the profiler clock. The packet generators
+  // run before the graph starts, so the sample is recorded whenever the
+  // profiler is enabled, even while profiling is paused.
+  void AddPacketGeneratorSample(int generator_index, absl::Time start_time,
+                                absl::Time end_time)
+      LOCKS_EXCLUDED(generator_mutex_);
+
+  // Collects the runtime profile for Generate() of each packet generator in
+  // the graph. May be called at any time after the graph has been
+  // initialized.
+  ::mediapipe::Status GetPacketGeneratorProfiles(
+      std::vector<PacketGeneratorProfile>*) const
+      LOCKS_EXCLUDED(generator_mutex_);
+
   // Writes recent profiling and tracing data to a file specified in the
   // ProfilerConfig.  Includes events since the previous call to WriteProfile.
   ::mediapipe::Status WriteProfile();
@@ -165,7 +277,8 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
 
   // Convenience temporary object to record scoped entry and exit.
   // Gets start_time_usec_ on construction and records process runtime on
-  // destruction. The |calculator_context| and |profiler| must not be null.
+  // destruction, along with the thread CPU time with enable_cpu_time. The
+  // |calculator_context| and |profiler| must not be null.
   class Scope {
    public:
     // Constructs a scope.
@@ -179,6 +292,10 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
           calculator_context_(*calculator_context),
           profiler_(profiler) {
       start_time_usec_ = profiler_->TimeNowUsec();
+      if (calculator_method_ == GraphTrace::PROCESS &&
+          profiler_->is_profiling_ && profiler_->profile_cpu_time_) {
+        start_cpu_time_usec_ = ThreadCpuTimeUsec();
+      }
       if (profiler_->is_tracing_) {
         absl::Time time_now = absl::FromUnixMicros(start_time_usec_);
         profiler_->packet_tracer_->LogInputEvents(
@@ -199,10 +316,15 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
                                       end_time_usec);
             break;
 
-          case GraphTrace::PROCESS:
+          case GraphTrace::PROCESS: {
+            const int64 cpu_time_usec =
+                start_cpu_time_usec_ >= 0
+                    ? ThreadCpuTimeUsec() - start_cpu_time_usec_
+                    : -1;
             profiler_->AddProcessSample(calculator_context_, start_time_usec_,
-                                        end_time_usec);
+                                        end_time_usec, cpu_time_usec);
             break;
+          }
 
           case GraphTrace::CLOSE:
             profiler_->SetCloseRuntime(calculator_context_, start_time_usec_,
@@ -224,6 +346,8 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
     const CalculatorContext& calculator_context_;
     GraphProfiler* profiler_;
     int64 start_time_usec_;
+    // The thread CPU time at construction, or -1 if not measured.
+    int64 start_cpu_time_usec_ = -1;
   };
 
  private:
@@ -239,6 +363,10 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
                                       int64 num_intervals,
                                       TimeHistogram* histogram);
   static void ResetTimeHistogram(TimeHistogram* histogram);
+  // Allocates the log-linear buckets used to estimate percentiles.
+  static void InitializePercentiles(TimeHistogram* histogram);
+  // Sets the percentiles estimated from the log-linear buckets.
+  static void SetPercentiles(TimeHistogram* histogram);
   // Add a sample to a time histogram.
   static void AddTimeSample(int64 start_time_usec, int64 end_time_usec,
                             TimeHistogram* histogram);
@@ -285,19 +413,92 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
                                   int64 start_time_usec,
                                   CalculatorProfile* calculator_profile);
 
-  // Updates the Process() data for calculator.
+  // Updates the Process() data for calculator. "cpu_time_usec" is the thread
+  // CPU time spent in Process(), or -1 if it was not measured.
   // Requires ReaderLock for is_profiling_.
   void AddProcessSample(const CalculatorContext& calculator_context,
-                        int64 start_time_usec, int64 end_time_usec)
-      LOCKS_EXCLUDED(profiler_mutex_);
+                        int64 start_time_usec, int64 end_time_usec,
+                        int64 cpu_time_usec) LOCKS_EXCLUDED(profiler_mutex_);
+
+  // Returns the CPU time consumed by the calling thread, in microseconds, or
+  // -1 where the platform does not report it.
+  static int64 ThreadCpuTimeUsec();
 
   // Helper method to get trace_log_path.  If the trace_log_path is empty and
   // tracing is enabled, this function returns a default platform dependent
   // trace_log_path.
   ::mediapipe::StatusOr<std::string> GetTraceLogPath();
 
+  // The number and duration of the periods during which an input stream
+  // queue was full or a source calculator was throttled.
+  struct BackPressureStats {
+    int64 count = 0;
+    int64 total_time_usec = 0;
+    // The start of the current period, or -1 if no period is in progress.
+    int64 start_time_usec = -1;
+  };
+
+  // Identifies a calculator and its input streams in the graph.
+  struct NodeIndexes {
+    int node_id;
+    int input_stream_base_index;
+  };
+
+  // Starts or ends a back-pressure period.
+  void UpdateBackPressureStats(bool is_started, BackPressureStats* stats)
+      EXCLUSIVE_LOCKS_REQUIRED(back_pressure_mutex_);
+
+  // Returns the total time of the back-pressure periods, including the current
+  // period, if any.
+  int64 BackPressureTimeUsec(const BackPressureStats& stats) const;
+
+  // Adds the queue high-water marks and the back-pressure periods to the
+  // profile of a calculator.
+  void AddBackPressureStats(const NodeIndexes& node_indexes,
+                            CalculatorProfile* profile) const
+      LOCKS_EXCLUDED(back_pressure_mutex_);
+
+  // Adds the GPU-side runtime of calculator "node_id" to its profile.
+  void AddGpuRuntime(int node_id, CalculatorProfile* profile) const
+      LOCKS_EXCLUDED(gpu_mutex_);
+
+  // The current and largest sampled bytes held by the packets queued in an
+  // input stream, or by the live payloads output by a calculator.
+  struct MemoryStats {
+    int64 current_bytes = 0;
+    int64 peak_bytes = 0;
+  };
+
+  // A packet payload output by a calculator, tracked until it is released.
+  struct LivePayload {
+    std::weak_ptr<packet_internal::HolderBase> holder;
+    int64 bytes;
+    int node_id;
+  };
+
+  // A registered buffer pool and its latest sample.
+  struct BufferPool {
+    std::function<void(BufferPoolProfile*)> get_usage;
+    BufferPoolProfile profile;
+  };
+
+  // Tracks the payloads output by a calculator, and samples the memory if the
+  // memory_sample_interval_usec has elapsed.
+  void AddOutputPayloads(const CalculatorContext& calculator_context)
+      LOCKS_EXCLUDED(memory_mutex_);
+
+  // Forgets the released payloads, and samples the bytes queued in the input
+  // streams and held by the buffer pools.
+  void SampleMemory() const EXCLUSIVE_LOCKS_REQUIRED(memory_mutex_);
+
+  // Adds the sampled memory of a calculator and its input streams to its
+  // profile.
+  void AddMemoryStats(const NodeIndexes& node_indexes,
+                      CalculatorProfile* profile) const
+      EXCLUSIVE_LOCKS_REQUIRED(memory_mutex_);
+
   // Helper method to get the clock time in microsecond.
-  int64 TimeNowUsec() { return ToUnixMicros(clock_->TimeNow()); }
+  int64 TimeNowUsec() const { return ToUnixMicros(clock_->TimeNow()); }
 
   // The settings for this tracer.
   ProfilerConfig profiler_config_;
@@ -312,13 +513,14 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // If true, the tracer records timing events.
   std::atomic_bool is_tracing_;
 
+  // If true, Process() calls are also measured in thread CPU time.
+  bool profile_cpu_time_ = false;
+
   // Stores all the calculator profiles with the calculator name as the key.
   using CalculatorProfileMap = ShardedMap<std::string, CalculatorProfile>;
   CalculatorProfileMap calculator_profiles_;
   // Stores the production time of a packet, based on profiler's clock.
-  using PacketInfoMap =
-      ShardedMap<std::string, std::list<std::pair<int64, PacketInfo>>>;
-  PacketInfoMap packets_info_;
+  PacketInfoStore packets_info_;
 
   // Global mutex for the profiler.
   mutable absl::Mutex profiler_mutex_;
@@ -335,12 +537,71 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // The end time of the previous output log.
   absl::Time previous_log_end_time_;
 
-  // The index number of the previous output log.
-  int previous_log_index_;
+  // Writes the trace log files, created by the first WriteProfile().
+  absl::Mutex trace_log_writer_mutex_;
+  std::unique_ptr<TraceLogWriter> trace_log_writer_
+      GUARDED_BY(trace_log_writer_mutex_);
 
   // The configuration for the graph being profiled.
   const ValidatedGraphConfig* validated_graph_;
 
+  // The indexes of each calculator, by calculator name.
+  std::map<std::string, NodeIndexes> node_indexes_;
+
+  // Guards the back-pressure statistics, which are updated when queues become
+  // full or not full rather than by the calculators themselves.
+  mutable absl::Mutex back_pressure_mutex_;
+
+  // The input stream queues of the graph, or nullptr.
+  const InputStreamManager* input_stream_managers_
+      GUARDED_BY(back_pressure_mutex_) = nullptr;
+
+  // The full periods of each input stream, by input stream index.
+  std::map<int, BackPressureStats> full_input_streams_
+      GUARDED_BY(back_pressure_mutex_);
+
+  // The throttled periods of each source calculator, by node id.
+  std::map<int, BackPressureStats> throttled_nodes_
+      GUARDED_BY(back_pressure_mutex_);
+
+  // Guards the GPU-side runtimes, which are reported from the GL threads.
+  mutable absl::Mutex gpu_mutex_;
+
+  // The GPU-side runtime of each calculator, by node id.
+  std::map<int, TimeHistogram> gpu_runtimes_ GUARDED_BY(gpu_mutex_);
+
+  // Guards the packet generator profiles, which are reported from the
+  // executor threads.
+  mutable absl::Mutex generator_mutex_;
+
+  // The profile of each packet generator, by generator index.
+  std::vector<PacketGeneratorProfile> generator_profiles_
+      GUARDED_BY(generator_mutex_);
+
+  // The number of input streams in the graph.
+  int num_input_streams_ = 0;
+
+  // Guards the memory samples. Sampling also updates them when the profiles
+  // are read, so they are mutable.
+  mutable absl::Mutex memory_mutex_;
+
+  // The tracked payloads, by their packet holder.
+  mutable std::unordered_map<const packet_internal::HolderBase*, LivePayload>
+      live_payloads_ GUARDED_BY(memory_mutex_);
+
+  // The bytes of the live payloads output by each calculator, by node id.
+  mutable std::map<int, MemoryStats> output_memory_ GUARDED_BY(memory_mutex_);
+
+  // The bytes queued in each input stream, by input stream index.
+  mutable std::map<int, MemoryStats> queue_memory_ GUARDED_BY(memory_mutex_);
+
+  // The registered buffer pools, by name.
+  mutable std::map<std::string, BufferPool> buffer_pools_
+      GUARDED_BY(memory_mutex_);
+
+  // The time of the latest memory sample.
+  mutable int64 last_memory_sample_usec_ GUARDED_BY(memory_mutex_) = 0;
+
   // For testing.
   friend GraphProfilerTestPeer;
 };
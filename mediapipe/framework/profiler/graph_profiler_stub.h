@@ -15,13 +15,21 @@
 #ifndef MEDIAPIPE_FRAMEWORK_PROFILER_MEDIAPIPE_PROFILER_STUB_H_
 #define MEDIAPIPE_FRAMEWORK_PROFILER_MEDIAPIPE_PROFILER_STUB_H_
 
+#include <functional>
+#include <string>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/timestamp.h"
 
 namespace mediapipe {
+class BufferPoolProfile;
+class CalculatorContext;
 class CalculatorProfile;
 class GraphTrace;
 class GraphProfile;
+class PacketGeneratorProfile;
 }  // namespace mediapipe
 
 namespace mediapipe {
@@ -35,6 +43,7 @@ class Packet;
 class Clock;
 class GraphTracer;
 class GlProfilingHelper;
+class InputStreamManager;
 
 class TraceEvent {
  public:
@@ -78,10 +87,37 @@ class GraphProfilerStub {
   inline void Initialize(const ValidatedGraphConfig& validated_graph_config) {}
   inline void SetClock(const std::shared_ptr<mediapipe::Clock>& clock) {}
   inline void LogEvent(const TraceEvent& event) {}
+  inline void SetInputStreamManagers(
+      const InputStreamManager* input_stream_managers) {}
+  inline void SetInputStreamFull(int input_stream_index, bool is_full) {}
+  inline void SetNodeThrottled(int node_id, bool is_throttled) {}
+  inline bool IsGpuTimerQueryEnabled() const { return false; }
+  inline void AddGpuTaskSample(int node_id, Timestamp input_timestamp,
+                               absl::Time start_time,
+                               absl::Duration gpu_runtime) {}
+  inline absl::Time TimeNow() const { return absl::Now(); }
+  inline void AddWarmupRuntime(const CalculatorContext& calculator_context,
+                               absl::Duration warmup_runtime) {}
+  inline bool IsMemoryProfilingEnabled() const { return false; }
+  inline void AddBufferPool(
+      const std::string& name,
+      std::function<void(BufferPoolProfile*)> get_usage) {}
+  inline void RemoveBufferPool(const std::string& name) {}
+  inline ::mediapipe::Status GetBufferPoolProfiles(
+      std::vector<BufferPoolProfile>*) const {
+    return mediapipe::OkStatus();
+  }
   inline ::mediapipe::Status GetCalculatorProfiles(
       std::vector<CalculatorProfile>*) const {
     return mediapipe::OkStatus();
   }
+  inline void AddPacketGeneratorSample(int generator_index,
+                                       absl::Time start_time,
+                                       absl::Time end_time) {}
+  inline ::mediapipe::Status GetPacketGeneratorProfiles(
+      std::vector<PacketGeneratorProfile>*) const {
+    return mediapipe::OkStatus();
+  }
   inline void Pause() {}
   inline void Resume() {}
   inline void Reset() {}
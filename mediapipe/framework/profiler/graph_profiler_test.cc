@@ -14,6 +14,8 @@
 
 #include "mediapipe/framework/profiler/graph_profiler.h"
 
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "mediapipe/framework/calculator_framework.h"
@@ -22,6 +24,8 @@
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/port/threadpool.h"
+#include "mediapipe/framework/profiler/payload_size.h"
 #include "mediapipe/framework/profiler/test_context_builder.h"
 #include "mediapipe/framework/tool/simulation_clock.h"
 #include "mediapipe/framework/tool/tag_map_helper.h"
@@ -35,6 +39,10 @@ namespace {
 
 constexpr char kDummyTestCalculatorName[] = "DummyTestCalculator";
 
+REGISTER_PAYLOAD_SIZE(std::string, [](const std::string& s) {
+  return static_cast<int64>(s.size());
+});
+
 CalculatorGraphConfig::Node CreateNodeConfig(
     const std::string& raw_node_config) {
   CalculatorGraphConfig::Node node_config;
@@ -69,22 +77,14 @@ TimeHistogram CreateTimeHistogram(int64 total, std::vector<int64> counts) {
   return time_histogram;
 }
 
-using PacketInfoMap =
-    ShardedMap<std::string, std::list<std::pair<int64, PacketInfo>>>;
-
-// Returns a PacketInfo from a PacketInfoMap.
-PacketInfo* GetPacketInfo(PacketInfoMap* map, const PacketId& packet_id) {
-  auto entry = map->find(packet_id.stream_name);
-  if (entry == map->end()) {
+// Returns a copy of a PacketInfo from a PacketInfoStore, or nullptr.
+std::unique_ptr<PacketInfo> GetPacketInfo(PacketInfoStore* store,
+                                          const PacketId& packet_id) {
+  auto packet_info = absl::make_unique<PacketInfo>();
+  if (!store->Find(packet_id, packet_info.get())) {
     return nullptr;
   }
-  auto& list = entry->second;
-  for (auto iter = list.rbegin(); iter != list.rend(); ++iter) {
-    if (iter->first == packet_id.timestamp_usec) {
-      return &iter->second;
-    }
-  }
-  return nullptr;
+  return packet_info;
 }
 }  // namespace
 
@@ -125,7 +125,7 @@ class GraphProfilerTestPeer : public testing::Test {
     return GetCalculatorProfilesMap()->find(expected_name)->second;
   }
 
-  GraphProfiler::PacketInfoMap* GetPacketsInfoMap() {
+  PacketInfoStore* GetPacketsInfoMap() {
     return &profiler_.packets_info_;
   }
 
@@ -141,6 +141,14 @@ class GraphProfilerTestPeer : public testing::Test {
     GraphProfiler::AddTimeSample(start_time_usec, end_time_usec, histogram);
   }
 
+  static void InitializePercentiles(TimeHistogram* histogram) {
+    GraphProfiler::InitializePercentiles(histogram);
+  }
+
+  static void SetPercentiles(TimeHistogram* histogram) {
+    GraphProfiler::SetPercentiles(histogram);
+  }
+
   void InitializeOutputStreams(const CalculatorGraphConfig::Node& node_config) {
     profiler_.InitializeOutputStreams(node_config);
   }
@@ -177,7 +185,7 @@ class GraphProfilerTestPeer : public testing::Test {
   void AddProcessSample(const CalculatorContext& calculator_context,
                         int64 start_time_usec, int64 end_time_usec) {
     profiler_.AddProcessSample(calculator_context, start_time_usec,
-                               end_time_usec);
+                               end_time_usec, /*cpu_time_usec=*/-1);
   }
 
   OutputStreamSpec CreateOutputStreamSpec(const std::string& name) {
@@ -490,6 +498,221 @@ TEST_F(GraphProfilerTestPeer, PauseResumeReset) {
   simulation_clock->ThreadFinish();
 }
 
+// Tests that full input streams and throttled nodes are reported.
+TEST_F(GraphProfilerTestPeer, BackPressure) {
+  InitializeProfilerWithGraphConfig(R"(
+    profiler_config {
+      enable_profiler: true
+      enable_stream_latency: true
+    }
+    input_stream: "input_stream"
+    node {
+      calculator: "DummyTestCalculator"
+      input_stream: "input_stream"
+      output_stream: "output_stream"
+    })");
+  std::shared_ptr<mediapipe::SimulationClock> simulation_clock(
+      new SimulationClock());
+  simulation_clock->ThreadStart();
+  profiler_.SetClock(simulation_clock);
+
+  profiler_.SetInputStreamFull(/*input_stream_index=*/0, true);
+  profiler_.SetNodeThrottled(/*node_id=*/0, true);
+  simulation_clock->Sleep(absl::Microseconds(100));
+  profiler_.SetInputStreamFull(/*input_stream_index=*/0, false);
+  profiler_.SetNodeThrottled(/*node_id=*/0, false);
+  simulation_clock->Sleep(absl::Microseconds(1000));
+  profiler_.SetInputStreamFull(/*input_stream_index=*/0, true);
+  simulation_clock->Sleep(absl::Microseconds(10));
+
+  // The current full period is included.
+  CalculatorProfile profile = Profiles()[0];
+  EXPECT_EQ(profile.num_throttled(), 1);
+  EXPECT_EQ(profile.throttled_time_usec(), 100);
+  EXPECT_EQ(profile.input_stream_profiles(0).num_full(), 2);
+  EXPECT_EQ(profile.input_stream_profiles(0).full_time_usec(), 110);
+
+  profiler_.Reset();
+  simulation_clock->Sleep(absl::Microseconds(10));
+  profile = Profiles()[0];
+  EXPECT_EQ(profile.num_throttled(), 0);
+  EXPECT_EQ(profile.input_stream_profiles(0).num_full(), 1);
+  EXPECT_EQ(profile.input_stream_profiles(0).full_time_usec(), 10);
+
+  simulation_clock->ThreadFinish();
+}
+
+// Tests that GPU-side runtimes are reported for the calculators that have them.
+TEST_F(GraphProfilerTestPeer, AddGpuTaskSample) {
+  InitializeProfilerWithGraphConfig(R"(
+    profiler_config {
+      enable_profiler: true
+      enable_gpu_timer_queries: true
+      histogram_interval_size_usec: 100
+      num_histogram_intervals: 3
+    }
+    input_stream: "input_stream"
+    node {
+      calculator: "DummyTestCalculator"
+      input_stream: "input_stream"
+      output_stream: "output_stream"
+    })");
+  ASSERT_TRUE(profiler_.IsGpuTimerQueryEnabled());
+  EXPECT_FALSE(Profiles()[0].has_gpu_runtime());
+
+  absl::Time start_time = absl::FromUnixMicros(1000);
+  profiler_.AddGpuTaskSample(/*node_id=*/0, Timestamp(100), start_time,
+                             absl::Microseconds(150));
+  profiler_.AddGpuTaskSample(/*node_id=*/0, Timestamp(200), start_time,
+                             absl::Microseconds(20));
+  EXPECT_THAT(
+      Profiles()[0].gpu_runtime(),
+      Partially(EqualsProto(CreateTimeHistogram(/*total=*/170, {1, 1, 0}))));
+
+  profiler_.Reset();
+  EXPECT_FALSE(Profiles()[0].has_gpu_runtime());
+}
+
+// Tests that the runtime of the packet generators is recorded while profiling
+// is paused, since they run before the graph starts, and is kept on Reset().
+TEST_F(GraphProfilerTestPeer, AddPacketGeneratorSample) {
+  InitializeProfilerWithGraphConfig(R"(
+    profiler_config {
+      enable_profiler: true
+      histogram_interval_size_usec: 100
+      num_histogram_intervals: 3
+    }
+    packet_generator {
+      packet_generator: "IntSplitterPacketGenerator"
+      input_side_packet: "input_value"
+      output_side_packet: "split_value"
+    })");
+  profiler_.Pause();
+  profiler_.AddPacketGeneratorSample(/*generator_index=*/0,
+                                     absl::FromUnixMicros(1000),
+                                     absl::FromUnixMicros(1150));
+  profiler_.AddPacketGeneratorSample(/*generator_index=*/0,
+                                     absl::FromUnixMicros(2000),
+                                     absl::FromUnixMicros(2020));
+  profiler_.Reset();
+
+  std::vector<PacketGeneratorProfile> profiles;
+  MP_ASSERT_OK(profiler_.GetPacketGeneratorProfiles(&profiles));
+  ASSERT_EQ(profiles.size(), 1);
+  EXPECT_EQ(profiles[0].name(), "IntSplitterPacketGenerator");
+  EXPECT_EQ(profiles[0].index(), 0);
+  EXPECT_THAT(
+      profiles[0].generate_runtime(),
+      Partially(EqualsProto(CreateTimeHistogram(/*total=*/170, {1, 1, 0}))));
+}
+
+// Tests that the output payloads are attributed to the calculator that
+// produced them until they are released, and that buffer pools are sampled
+// until they are removed.
+TEST_F(GraphProfilerTestPeer, MemoryProfiling) {
+  InitializeProfilerWithGraphConfig(R"(
+    profiler_config {
+      enable_profiler: true
+      enable_memory_profiling: true
+      memory_sample_interval_usec: 1
+    }
+    input_stream: "input_stream"
+    node {
+      calculator: "DummyTestCalculator"
+      input_stream: "input_stream"
+      output_stream: "output_stream"
+    })");
+  ASSERT_TRUE(profiler_.IsMemoryProfilingEnabled());
+
+  {
+    TestContextBuilder context(kDummyTestCalculatorName, /*node_id=*/0,
+                               {"input_stream"}, {"output_stream"});
+    context.AddInputs({MakePacket<std::string>("15").At(Timestamp(100))});
+    context.AddOutputs(
+        {{MakePacket<std::string>(std::string(1000, 'x')).At(Timestamp(100))}});
+    AddProcessSample(*context.get(), /*start_time_usec=*/100,
+                     /*end_time_usec=*/150);
+    std::vector<CalculatorProfile> profiles = Profiles();
+    ASSERT_EQ(profiles.size(), 1);
+    EXPECT_EQ(profiles[0].live_output_bytes(), 1000);
+    EXPECT_EQ(profiles[0].peak_live_output_bytes(), 1000);
+  }
+  std::vector<CalculatorProfile> profiles = Profiles();
+  EXPECT_EQ(profiles[0].live_output_bytes(), 0);
+  EXPECT_EQ(profiles[0].peak_live_output_bytes(), 1000);
+
+  profiler_.AddBufferPool("test_pool", [](BufferPoolProfile* profile) {
+    profile->set_num_in_use(2);
+    profile->set_in_use_bytes(200);
+    profile->set_available_bytes(50);
+  });
+  std::vector<BufferPoolProfile> pools;
+  MP_ASSERT_OK(profiler_.GetBufferPoolProfiles(&pools));
+  ASSERT_EQ(pools.size(), 1);
+  EXPECT_EQ(pools[0].name(), "test_pool");
+  EXPECT_EQ(pools[0].num_in_use(), 2);
+  EXPECT_EQ(pools[0].peak_bytes(), 250);
+
+  profiler_.RemoveBufferPool("test_pool");
+  pools.clear();
+  MP_ASSERT_OK(profiler_.GetBufferPoolProfiles(&pools));
+  EXPECT_TRUE(pools.empty());
+}
+
+// Tests that PacketInfoStore keeps the recent packets of the initialized
+// streams.
+TEST(PacketInfoStoreTest, InsertAndFind) {
+  PacketInfoStore store;
+  store.Initialize({"stream_1", "stream_2"}, /*recent_count=*/4);
+  EXPECT_EQ(store.size(), 0);
+
+  for (int64 t = 0; t < 10; ++t) {
+    store.Insert({"stream_1", t}, {0, t + 100, t});
+  }
+  store.Insert({"unknown_stream", 0}, {0, 100, 0});
+  EXPECT_EQ(store.size(), 1);
+
+  PacketInfo packet_info;
+  ASSERT_TRUE(store.Find({"stream_1", 9}, &packet_info));
+  PacketInfo expected_packet_info = {0, /*production_time_usec=*/109,
+                                     /*source_process_start_usec=*/9};
+  EXPECT_EQ(packet_info, expected_packet_info);
+  EXPECT_FALSE(store.Find({"stream_1", 0}, &packet_info));
+  EXPECT_FALSE(store.Find({"stream_2", 9}, &packet_info));
+  EXPECT_FALSE(store.Find({"unknown_stream", 0}, &packet_info));
+}
+
+// Tests that PacketInfoStore can be written and read by concurrent threads.
+TEST(PacketInfoStoreTest, ConcurrentInsertAndFind) {
+  const int kNumStreams = 4;
+  const int kNumPackets = 10000;
+  std::vector<std::string> stream_names;
+  for (int i = 0; i < kNumStreams; ++i) {
+    stream_names.push_back(absl::StrCat("stream_", i));
+  }
+  PacketInfoStore store;
+  store.Initialize(stream_names, /*recent_count=*/100);
+  std::atomic<int> num_found(0);
+  {
+    ThreadPool pool(kNumStreams);
+    pool.StartWorkers();
+    for (int i = 0; i < kNumStreams; ++i) {
+      pool.Schedule([&store, &stream_names, &num_found, i] {
+        for (int64 t = 0; t < kNumPackets; ++t) {
+          store.Insert({stream_names[i], t}, {0, t, t});
+          PacketInfo packet_info;
+          if (store.Find({stream_names[i], t}, &packet_info) &&
+              packet_info.production_time_usec == t) {
+            ++num_found;
+          }
+        }
+      });
+    }
+  }
+  EXPECT_EQ(num_found, kNumStreams * kNumPackets);
+  EXPECT_EQ(store.size(), kNumStreams);
+}
+
 // Tests that AddPacketInfo() uses packet timestamp when
 // use_packet_timestamp_for_added_packet is true.
 TEST_F(GraphProfilerTestPeer, AddPacketInfoUsingPacketTimestamp) {
@@ -641,6 +864,42 @@ TEST_F(GraphProfilerTestPeer, SetOpenRuntime) {
   ASSERT_EQ(GetPacketsInfoMap()->size(), 0);
 }
 
+// Tests that AddWarmupRuntime() accumulates into |warmup_runtime| and leaves
+// |open_runtime| to the OPEN scope.
+TEST_F(GraphProfilerTestPeer, AddWarmupRuntime) {
+  InitializeProfilerWithGraphConfig(R"(
+    profiler_config {
+      enable_profiler: true
+    }
+    input_stream: "input_stream"
+    node {
+      calculator: "DummyTestCalculator"
+      input_stream: "input_stream"
+      output_stream: "output_stream"
+    })");
+  std::shared_ptr<mediapipe::SimulationClock> simulation_clock(
+      new SimulationClock());
+  simulation_clock->ThreadStart();
+  profiler_.SetClock(simulation_clock);
+
+  TestContextBuilder context(kDummyTestCalculatorName, /*node_id=*/0,
+                             {"input_stream"}, {"output_stream"});
+  {
+    GraphProfiler::Scope profiler_scope(GraphTrace::OPEN, context.get(),
+                                        &profiler_);
+    simulation_clock->Sleep(absl::Microseconds(100));
+    profiler_.AddWarmupRuntime(*context.get(), absl::Microseconds(30));
+    profiler_.AddWarmupRuntime(*context.get(), absl::Microseconds(20));
+  }
+
+  std::vector<CalculatorProfile> profiles = Profiles();
+  simulation_clock->ThreadFinish();
+
+  ASSERT_EQ(profiles.size(), 1);
+  ASSERT_EQ(profiles[0].open_runtime(), 100);
+  ASSERT_EQ(profiles[0].warmup_runtime(), 50);
+}
+
 // Tests that SetOpenRuntime() updates |open_runtime| and also updates the
 // packet info map when stream latency is enabled and the calculator produces
 // output packet in Open().
@@ -839,6 +1098,34 @@ TEST_F(GraphProfilerTestPeer, AddTimeSample) {
                              /*total=*/30 + 100 + 500, {1, 1, 1}))));
 }
 
+// Tests that the percentiles are estimated within 1/16 of the true times.
+TEST_F(GraphProfilerTestPeer, SetPercentiles) {
+  TimeHistogram histogram;
+  GraphProfilerTestPeer::InitializeTimeHistogram(/*interval_size_usec=*/100,
+                                                 /*num_intervals=*/3,
+                                                 &histogram);
+  GraphProfilerTestPeer::InitializePercentiles(&histogram);
+  // Too few samples to set the percentiles.
+  GraphProfilerTestPeer::SetPercentiles(&histogram);
+  EXPECT_FALSE(histogram.has_p50_usec());
+
+  // Times 1us to 10000us, and one very long time.
+  for (int time_usec = 1; time_usec <= 10000; ++time_usec) {
+    GraphProfilerTestPeer::AddTimeSample(/*start_time_usec=*/100,
+                                         /*end_time_usec=*/100 + time_usec,
+                                         &histogram);
+  }
+  GraphProfilerTestPeer::AddTimeSample(/*start_time_usec=*/0,
+                                       /*end_time_usec=*/int64{1} << 50,
+                                       &histogram);
+  GraphProfilerTestPeer::SetPercentiles(&histogram);
+  EXPECT_NEAR(histogram.p50_usec(), 5000, 5000 / 16);
+  EXPECT_NEAR(histogram.p95_usec(), 9500, 9500 / 16);
+  EXPECT_NEAR(histogram.p99_usec(), 9900, 9900 / 16);
+  // The fixed intervals are still filled.
+  EXPECT_EQ(histogram.count(0), 99);
+}
+
 // Tests that InitializeOutputStreams adds all the outputs of a node to the
 // stream consumer count map.
 TEST_F(GraphProfilerTestPeer, InitializeOutputStreams) {
@@ -937,10 +1224,56 @@ TEST_F(GraphProfilerTestPeer, AddProcessSample) {
               Partially(EqualsProto(CreateTimeHistogram(/*total=*/150, {1}))));
   ASSERT_FALSE(profiles[0].has_open_runtime());
   ASSERT_FALSE(profiles[0].has_close_runtime());
+  ASSERT_FALSE(profiles[0].has_process_cpu_time());
   // Checks packets_info_ map hasn't changed.
   ASSERT_EQ(GetPacketsInfoMap()->size(), 0);
 }
 
+// Tests that with enable_cpu_time the Process() runtime is split into CPU
+// time and wait time.
+TEST_F(GraphProfilerTestPeer, AddProcessSampleWithCpuTime) {
+  InitializeProfilerWithGraphConfig(R"(
+    profiler_config {
+      enable_profiler: true
+      enable_cpu_time: true
+    }
+    input_stream: "input_stream"
+    node {
+      calculator: "DummyTestCalculator"
+      input_stream: "input_stream"
+      output_stream: "output_stream"
+    })");
+  std::shared_ptr<mediapipe::SimulationClock> simulation_clock(
+      new SimulationClock());
+  simulation_clock->ThreadStart();
+  profiler_.SetClock(simulation_clock);
+
+  TestContextBuilder context(kDummyTestCalculatorName, /*node_id=*/0,
+                             {"input_stream"}, {"output_stream"});
+  context.AddInputs({MakePacket<std::string>("5").At(Timestamp(100))});
+  context.AddOutputs({{MakePacket<std::string>("15").At(Timestamp(100))}});
+
+  {
+    GraphProfiler::Scope profiler_scope(GraphTrace::PROCESS, context.get(),
+                                        &profiler_);
+    // Sleeping on the simulation clock takes little CPU time.
+    simulation_clock->Sleep(absl::Microseconds(150));
+  }
+
+  std::vector<CalculatorProfile> profiles = Profiles();
+  simulation_clock->ThreadFinish();
+
+  ASSERT_EQ(profiles.size(), 1);
+  ASSERT_THAT(profiles[0].process_runtime(),
+              Partially(EqualsProto(CreateTimeHistogram(/*total=*/150, {1}))));
+  const TimeHistogram& cpu_time = profiles[0].process_cpu_time();
+  const TimeHistogram& wait_time = profiles[0].process_wait_time();
+  EXPECT_EQ(cpu_time.total() + wait_time.total(), 150);
+  EXPECT_LT(cpu_time.total(), 150);
+  EXPECT_EQ(cpu_time.count(0), 1);
+  EXPECT_EQ(wait_time.count(0), 1);
+}
+
 // Tests that AddProcessSample() updates |process_runtime| and also updates the
 // packet info map when stream latency is enabled.
 TEST_F(GraphProfilerTestPeer, AddProcessSampleWithStreamLatency) {
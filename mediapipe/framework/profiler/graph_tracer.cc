@@ -14,6 +14,8 @@
 
 #include "mediapipe/framework/profiler/graph_tracer.h"
 
+#include <limits>
+
 #include "absl/time/time.h"
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/calculator_profile.pb.h"
@@ -56,10 +58,16 @@ GraphTracer::GraphTracer(const ProfilerConfig& profiler_config)
   for (int32 event_type : profiler_config_.trace_event_types_disabled()) {
     event_types_disabled_[event_type] = true;
   }
+  sampling_threshold_ = std::numeric_limits<uint64>::max();
+  if (profiler_config_.trace_sampling_period() > 1) {
+    sampling_threshold_ /= profiler_config_.trace_sampling_period();
+  }
 }
 
 void GraphTracer::LogEvent(TraceEvent event) {
-  if (event_types_disabled_[static_cast<int>(event.event_type)]) {
+  // Both conditions are evaluated so that skipping an event is one branch.
+  if (event_types_disabled_[static_cast<int>(event.event_type)] |
+      !IsSampled(event.input_ts)) {
     return;
   }
   event.set_thread_id(GetCurrentThreadId());
@@ -70,6 +78,9 @@ void GraphTracer::LogInputEvents(GraphTrace::EventType event_type,
                                  const CalculatorContext* context,
                                  absl::Time event_time) {
   Timestamp input_ts = context->InputTimestamp();
+  if (!IsSampled(input_ts)) {
+    return;
+  }
   for (const InputStreamShard& in_stream : context->Inputs()) {
     const Packet& packet = in_stream.Value();
     if (!packet.IsEmpty()) {
@@ -93,6 +104,9 @@ void GraphTracer::LogOutputEvents(GraphTrace::EventType event_type,
   Timestamp input_ts = (context->Inputs().NumEntries() > 0)
                            ? context->InputTimestamp()
                            : GetOutputTimestamp(context);
+  if (!IsSampled(input_ts)) {
+    return;
+  }
   for (const OutputStreamShard& out_stream : context->Outputs()) {
     const std::string* stream_id = &out_stream.Name();
     for (const Packet& packet : *out_stream.OutputQueue()) {
@@ -16,10 +16,12 @@
 #define MEDIAPIPE_FRAMEWORK_PROFILER_GRAPH_TRACER_H_
 
 #include <string>
+#include <vector>
 
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/profiler/trace_buffer.h"
 #include "mediapipe/framework/profiler/trace_builder.h"
 
@@ -55,6 +57,14 @@ class GraphTracer {
   // Create a tracer to record up to |capacity| recent events.
   GraphTracer(const ProfilerConfig& profiler_config);
 
+  // Returns true if the events of input timestamp "ts" are recorded, as
+  // selected by ProfilerConfig::trace_sampling_period.
+  inline bool IsSampled(Timestamp ts) const {
+    // Fibonacci hashing spreads regularly spaced timestamps evenly.
+    return static_cast<uint64>(ts.Value()) * 0x9E3779B97F4A7C15ull <=
+           sampling_threshold_;
+  }
+
   // Append a TraceEvent to the TraceBuffer.
   void LogEvent(TraceEvent event);
 
@@ -88,6 +98,9 @@ class GraphTracer {
   // Indicates event types that will not be logged.
   std::vector<bool> event_types_disabled_;
 
+  // The largest timestamp hash that is sampled.
+  uint64 sampling_threshold_;
+
   // The circular buffer of TraceEvents.
   TraceBuffer trace_buffer_;
 
@@ -44,12 +44,9 @@
 
 namespace mediapipe {
 
-using PacketInfoMap =
-    ShardedMap<std::string, std::list<std::pair<int64, PacketInfo>>>;
-
 class GraphProfilerTestPeer {
  public:
-  static PacketInfoMap* GetPacketsInfoMap(GraphProfiler* profiler) {
+  static PacketInfoStore* GetPacketsInfoMap(GraphProfiler* profiler) {
     return &profiler->packets_info_;
   }
 };
@@ -128,6 +125,34 @@ TEST_F(GraphTracerTest, EmptyTrace) {
               )")));
 }
 
+TEST_F(GraphTracerTest, SampledTrace) {
+  ProfilerConfig profiler_config;
+  profiler_config.set_trace_enabled(true);
+  profiler_config.set_trace_sampling_period(4);
+  GraphTracer tracer(profiler_config);
+  for (int i = 0; i < 1000; ++i) {
+    Timestamp ts(start_timestamp_.Value() + i * 33333);
+    for (int node_id : {0, 1}) {
+      tracer.LogEvent(TraceEvent(TraceEvent::PROCESS)
+                          .set_event_time(start_time_)
+                          .set_node_id(node_id)
+                          .set_input_ts(ts));
+    }
+  }
+
+  // About 1 in 4 timestamps is traced, with the events of all nodes.
+  std::map<int64, int> event_counts;
+  const TraceBuffer& buffer = tracer.GetTraceBuffer();
+  for (auto iter = buffer.begin(); iter < buffer.end(); ++iter) {
+    ++event_counts[(*iter).input_ts.Value()];
+  }
+  EXPECT_GT(event_counts.size(), 200);
+  EXPECT_LT(event_counts.size(), 300);
+  for (const auto& ts_count : event_counts) {
+    EXPECT_EQ(2, ts_count.second);
+  }
+}
+
 TEST_F(GraphTracerTest, CalculatorTrace) {
   // Define the GraphTracer, the CalculatorState, and the stream specs.
   SetUpGraphTracer();
@@ -620,7 +645,11 @@ TEST_F(GraphTracerE2ETest, PassThroughGraphProfile) {
         name: "LambdaCalculator"
         open_runtime: 0
         close_runtime: 0
-        input_stream_profiles { name: "input_0" back_edge: false })");
+        input_stream_profiles {
+          name: "input_0"
+          back_edge: false
+          max_queue_size: 4
+        })");
 
   FillHistogram({20001, 20001, 20001, 20001, 20001, 20001},
                 expected.mutable_process_runtime());
@@ -934,6 +963,24 @@ TEST_F(GraphTracerE2ETest, DemuxGraphLogFile) {
   EXPECT_EQ(89, profile.graph_trace(0).calculator_trace().size());
 }
 
+TEST_F(GraphTracerE2ETest, DemuxGraphChromeTrace) {
+  std::string log_path = absl::StrCat(getenv("TEST_TMPDIR"), "/chrome_trace_");
+  SetUpDemuxInFlightGraph();
+  graph_config_.mutable_profiler_config()->set_trace_log_path(log_path);
+  graph_config_.mutable_profiler_config()->set_trace_log_interval_usec(-1);
+  graph_config_.mutable_profiler_config()->set_trace_log_format(
+      ProfilerConfig::CHROME_TRACE_JSON);
+  RunDemuxInFlightGraph();
+  std::string contents;
+  MP_ASSERT_OK(
+      file::GetContents(absl::StrCat(log_path, 0, ".json"), &contents));
+  EXPECT_EQ(0, contents.find("[\n"));
+  EXPECT_NE(std::string::npos,
+            contents.find(R"({"name":"FlowLimiterCalculator",)"));
+  EXPECT_NE(std::string::npos, contents.find(R"("ph":"s")"));
+  EXPECT_NE(std::string::npos, contents.find(R"("ph":"f")"));
+}
+
 TEST_F(GraphTracerE2ETest, DemuxGraphLogFiles) {
   std::string log_path = absl::StrCat(getenv("TEST_TMPDIR"), "/log_files_");
   SetUpDemuxInFlightGraph();
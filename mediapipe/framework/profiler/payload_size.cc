@@ -0,0 +1,66 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "mediapipe/framework/profiler/payload_size.h"
+
+#include <unordered_map>
+#include <utility>
+
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/deps/no_destructor.h"
+
+namespace mediapipe {
+
+namespace {
+
+// The registered payload size functions, by type id.
+struct PayloadSizeRegistry {
+  absl::Mutex mutex;
+  std::unordered_map<size_t, std::function<int64(const Packet&)>> functions
+      GUARDED_BY(mutex);
+};
+
+PayloadSizeRegistry* GetPayloadSizeRegistry() {
+  static NoDestructor<PayloadSizeRegistry> registry;
+  return registry.get();
+}
+
+}  // namespace
+
+int64 PayloadBytes(const Packet& packet) {
+  if (packet.IsEmpty()) {
+    return 0;
+  }
+  PayloadSizeRegistry* registry = GetPayloadSizeRegistry();
+  absl::ReaderMutexLock lock(&registry->mutex);
+  auto iter = registry->functions.find(packet.GetTypeId());
+  if (iter == registry->functions.end()) {
+    return 0;
+  }
+  return iter->second(packet);
+}
+
+namespace internal {
+
+void RegisterPayloadSize(size_t type_id,
+                         std::function<int64(const Packet&)> payload_bytes) {
+  PayloadSizeRegistry* registry = GetPayloadSizeRegistry();
+  absl::MutexLock lock(&registry->mutex);
+  registry->functions[type_id] = std::move(payload_bytes);
+}
+
+}  // namespace internal
+
+}  // namespace mediapipe
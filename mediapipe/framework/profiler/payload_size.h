@@ -0,0 +1,64 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef MEDIAPIPE_FRAMEWORK_PROFILER_PAYLOAD_SIZE_H_
+#define MEDIAPIPE_FRAMEWORK_PROFILER_PAYLOAD_SIZE_H_
+
+#include <cstddef>
+#include <functional>
+
+#include "mediapipe/framework/deps/registration.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/tool/type_util.h"
+
+namespace mediapipe {
+
+// Returns the approximate number of bytes held by the payload of "packet",
+// for memory profiling. Returns 0 if "packet" is empty or if no payload size
+// is registered for its type.
+int64 PayloadBytes(const Packet& packet);
+
+// Registers the function that returns the payload size of packets of type T.
+// Register it in the same library as T, for example:
+//
+//   REGISTER_PAYLOAD_SIZE(ImageFrame, [](const ImageFrame& frame) {
+//     return frame.PixelDataSize();
+//   });
+#define REGISTER_PAYLOAD_SIZE(T, payload_bytes)                             \
+  static ::mediapipe::internal::PayloadSizeRegistrar<T> REGISTRY_STATIC_VAR( \
+      payload_size_registrar, __LINE__)(payload_bytes)
+
+namespace internal {
+
+void RegisterPayloadSize(size_t type_id,
+                         std::function<int64(const Packet&)> payload_bytes);
+
+template <typename T>
+class PayloadSizeRegistrar {
+ public:
+  explicit PayloadSizeRegistrar(std::function<int64(const T&)> payload_bytes) {
+    RegisterPayloadSize(tool::GetTypeHash<T>(),
+                        [payload_bytes](const Packet& packet) {
+                          return payload_bytes(packet.Get<T>());
+                        });
+  }
+};
+
+}  // namespace internal
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PROFILER_PAYLOAD_SIZE_H_
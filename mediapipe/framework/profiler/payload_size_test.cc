@@ -0,0 +1,46 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "mediapipe/framework/profiler/payload_size.h"
+
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+REGISTER_PAYLOAD_SIZE(std::vector<float>, [](const std::vector<float>& v) {
+  return static_cast<int64>(v.size() * sizeof(float));
+});
+
+TEST(PayloadSizeTest, ReturnsRegisteredSize) {
+  Packet packet = MakePacket<std::vector<float>>(100, 1.0f);
+  EXPECT_EQ(400, PayloadBytes(packet));
+  EXPECT_EQ(400, PayloadBytes(packet.At(Timestamp(1))));
+}
+
+TEST(PayloadSizeTest, ReturnsZeroForUnregisteredTypes) {
+  EXPECT_EQ(0, PayloadBytes(MakePacket<std::string>("payload")));
+}
+
+TEST(PayloadSizeTest, ReturnsZeroForEmptyPackets) {
+  EXPECT_EQ(0, PayloadBytes(Packet()));
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,164 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/trace_log_writer.h"
+
+#include <fstream>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/profiler/compact_graph_trace.h"
+
+namespace mediapipe {
+
+TraceLogWriter::TraceLogWriter(Options options)
+    : options_(std::move(options)) {
+  for (const auto& node : options_.graph_config.node()) {
+    calculator_names_.push_back(node.name());
+  }
+  if (options_.queue_size > 0) {
+    writer_thread_ = std::thread([this] { RunWriterThread(); });
+  }
+}
+
+TraceLogWriter::~TraceLogWriter() {
+  if (writer_thread_.joinable()) {
+    {
+      absl::MutexLock lock(&mutex_);
+      is_stopping_ = true;
+    }
+    writer_thread_.join();
+  }
+}
+
+::mediapipe::Status TraceLogWriter::Write(GraphProfile profile) {
+  if (options_.queue_size <= 0) {
+    return WriteInterval(&profile);
+  }
+  absl::MutexLock lock(&mutex_);
+  if (queue_.size() >= static_cast<size_t>(options_.queue_size)) {
+    ++dropped_count_;
+  } else {
+    queue_.push_back(std::move(profile));
+  }
+  ::mediapipe::Status status = status_;
+  status_ = ::mediapipe::OkStatus();
+  return status;
+}
+
+::mediapipe::Status TraceLogWriter::Flush() {
+  absl::MutexLock lock(&mutex_);
+  mutex_.Await(absl::Condition(
+      +[](TraceLogWriter* writer) EXCLUSIVE_LOCKS_REQUIRED(writer->mutex_) {
+        return writer->queue_.empty() && !writer->is_writing_;
+      },
+      this));
+  if (dropped_count_ > 0) {
+    LOG(WARNING) << "Dropped " << dropped_count_
+                 << " trace log intervals while the queue was full.";
+  }
+  ::mediapipe::Status status = status_;
+  status_ = ::mediapipe::OkStatus();
+  return status;
+}
+
+int64 TraceLogWriter::dropped_count() {
+  absl::MutexLock lock(&mutex_);
+  return dropped_count_;
+}
+
+void TraceLogWriter::RunWriterThread() {
+  while (true) {
+    GraphProfile profile;
+    {
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(
+          +[](TraceLogWriter* writer) EXCLUSIVE_LOCKS_REQUIRED(writer->mutex_) {
+            return !writer->queue_.empty() || writer->is_stopping_;
+          },
+          this));
+      if (queue_.empty()) {
+        return;
+      }
+      profile = std::move(queue_.front());
+      queue_.pop_front();
+      is_writing_ = true;
+    }
+    ::mediapipe::Status status = WriteInterval(&profile);
+    absl::MutexLock lock(&mutex_);
+    status_.Update(status);
+    is_writing_ = false;
+  }
+}
+
+::mediapipe::Status TraceLogWriter::WriteInterval(GraphProfile* profile) {
+  RET_CHECK_GT(profile->graph_trace_size(), 0);
+  bool is_new_file = file_index_ < 0 ||
+                     intervals_in_file_ >= options_.interval_count ||
+                     (options_.max_file_bytes > 0 &&
+                      file_bytes_ >= options_.max_file_bytes);
+  if (is_new_file) {
+    ++file_index_;
+    intervals_in_file_ = 0;
+    file_bytes_ = 0;
+  }
+  ++intervals_in_file_;
+
+  // Record the CalculatorGraphConfig and the node names, once per log file.
+  GraphTrace* trace = profile->mutable_graph_trace(0);
+  if (is_new_file) {
+    *profile->mutable_config() = options_.graph_config;
+    trace->clear_calculator_name();
+    for (const std::string& name : calculator_names_) {
+      trace->add_calculator_name(name);
+    }
+  }
+
+  std::string output;
+  const char* extension = ".binarypb";
+  switch (options_.format) {
+    case ProfilerConfig::CHROME_TRACE_JSON:
+      extension = ".json";
+      if (is_new_file) {
+        output = ChromeTraceWriter::FileHeader();
+      }
+      chrome_trace_writer_.AppendTrace(*trace, calculator_names_, &output);
+      break;
+    case ProfilerConfig::COMPACT_BINARYPB:
+      for (const GraphTrace& graph_trace : profile->graph_trace()) {
+        CompactTrace(graph_trace, profile->add_compact_graph_trace());
+      }
+      profile->clear_graph_trace();
+      RET_CHECK(profile->SerializeToString(&output));
+      break;
+    default:
+      RET_CHECK(profile->SerializeToString(&output));
+      break;
+  }
+
+  int log_index = file_index_ % options_.file_count;
+  std::string log_path =
+      absl::StrCat(options_.path_prefix, log_index, extension);
+  std::ofstream ofs(log_path, is_new_file
+                                  ? std::ofstream::out | std::ofstream::trunc
+                                  : std::ofstream::out | std::ofstream::app);
+  ofs.write(output.data(), output.size());
+  RET_CHECK(ofs.good()) << "Could not write trace log to: " << log_path;
+  file_bytes_ += output.size();
+  return ::mediapipe::OkStatus();
+}
+
+}  // namespace mediapipe
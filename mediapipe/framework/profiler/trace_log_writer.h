@@ -0,0 +1,103 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PROFILER_TRACE_LOG_WRITER_H_
+#define MEDIAPIPE_FRAMEWORK_PROFILER_TRACE_LOG_WRITER_H_
+
+#include <deque>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/profiler/chrome_trace_writer.h"
+
+namespace mediapipe {
+
+// Writes the GraphProfiles recorded in each trace log interval to a rotating
+// set of trace log files, "<path_prefix>N.binarypb" or "<path_prefix>N.json",
+// for N from 0 to file_count - 1. A file is started after interval_count
+// intervals, or once it holds max_file_bytes, and then N wraps around so that
+// the oldest file is overwritten.
+//
+// If queue_size is greater than 0, intervals are encoded and written by a
+// background thread, and Write() drops the interval rather than block when
+// queue_size intervals are already waiting. Otherwise Write() writes the
+// interval before it returns.
+class TraceLogWriter {
+ public:
+  struct Options {
+    std::string path_prefix;
+    ProfilerConfig::TraceLogFormat format = ProfilerConfig::BINARYPB;
+    int file_count = 1;
+    int interval_count = 1;
+    int64 max_file_bytes = 0;
+    int queue_size = 0;
+    // The graph config, with canonical node names assigned. It is recorded
+    // once at the start of each file.
+    CalculatorGraphConfig graph_config;
+  };
+
+  explicit TraceLogWriter(Options options);
+
+  // Writes the remaining queued intervals.
+  ~TraceLogWriter();
+
+  TraceLogWriter(const TraceLogWriter&) = delete;
+  TraceLogWriter& operator=(const TraceLogWriter&) = delete;
+
+  // Writes the GraphProfile of one trace log interval, whose first
+  // graph_trace holds the interval's events. With a queue, an error writing
+  // an earlier interval is returned by the next call to Write() or Flush().
+  ::mediapipe::Status Write(GraphProfile profile);
+
+  // Waits until all queued intervals are written.
+  ::mediapipe::Status Flush();
+
+  // The number of intervals dropped because the queue was full.
+  int64 dropped_count();
+
+ private:
+  // Writes queued intervals until the writer is destroyed.
+  void RunWriterThread();
+
+  // Encodes "profile" in the configured format and writes it to the current
+  // file, starting a new file first if needed.
+  ::mediapipe::Status WriteInterval(GraphProfile* profile);
+
+  const Options options_;
+  std::vector<std::string> calculator_names_;
+
+  // The state of the current file, accessed only by the writing thread.
+  int file_index_ = -1;
+  int intervals_in_file_ = 0;
+  int64 file_bytes_ = 0;
+  ChromeTraceWriter chrome_trace_writer_;
+
+  absl::Mutex mutex_;
+  std::deque<GraphProfile> queue_ GUARDED_BY(mutex_);
+  bool is_writing_ GUARDED_BY(mutex_) = false;
+  bool is_stopping_ GUARDED_BY(mutex_) = false;
+  int64 dropped_count_ GUARDED_BY(mutex_) = 0;
+  ::mediapipe::Status status_ GUARDED_BY(mutex_);
+  std::thread writer_thread_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PROFILER_TRACE_LOG_WRITER_H_
@@ -0,0 +1,126 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/trace_log_writer.h"
+
+#include <stdlib.h>
+
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/profiler/compact_graph_trace.h"
+
+namespace mediapipe {
+namespace {
+
+std::string TempPathPrefix(const std::string& name) {
+  return absl::StrCat(getenv("TEST_TMPDIR") ? getenv("TEST_TMPDIR") : "/tmp",
+                      "/", name, "_");
+}
+
+TraceLogWriter::Options TestOptions(const std::string& name) {
+  TraceLogWriter::Options options;
+  options.path_prefix = TempPathPrefix(name);
+  options.file_count = 2;
+  options.interval_count = 3;
+  options.graph_config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+    node { name: "source" calculator: "SourceCalculator" }
+  )");
+  return options;
+}
+
+// Returns a GraphProfile holding one interval of "num_events" events.
+GraphProfile TestInterval(int num_events) {
+  GraphProfile profile;
+  GraphTrace* trace = profile.add_graph_trace();
+  for (int i = 0; i < num_events; ++i) {
+    GraphTrace::CalculatorTrace* record = trace->add_calculator_trace();
+    record->set_node_id(0);
+    record->set_event_type(GraphTrace::PROCESS);
+    record->set_input_timestamp(i);
+    record->set_start_time(i * 10);
+    record->set_finish_time(i * 10 + 5);
+  }
+  return profile;
+}
+
+GraphProfile ReadLog(const std::string& path) {
+  std::string contents;
+  MP_EXPECT_OK(file::GetContents(path, &contents));
+  GraphProfile profile;
+  EXPECT_TRUE(profile.ParseFromString(contents));
+  return profile;
+}
+
+TEST(TraceLogWriterTest, RotatesByIntervalCount) {
+  TraceLogWriter::Options options = TestOptions("interval_count");
+  std::string prefix = options.path_prefix;
+  TraceLogWriter writer(std::move(options));
+  for (int i = 0; i < 4; ++i) {
+    MP_ASSERT_OK(writer.Write(TestInterval(1)));
+  }
+  GraphProfile first = ReadLog(absl::StrCat(prefix, "0.binarypb"));
+  EXPECT_EQ(3, first.graph_trace_size());
+  EXPECT_EQ("source", first.config().node(0).name());
+  EXPECT_EQ("source", first.graph_trace(0).calculator_name(0));
+  EXPECT_EQ(1, ReadLog(absl::StrCat(prefix, "1.binarypb")).graph_trace_size());
+}
+
+TEST(TraceLogWriterTest, RotatesByFileSize) {
+  TraceLogWriter::Options options = TestOptions("file_size");
+  options.max_file_bytes = 1;
+  std::string prefix = options.path_prefix;
+  TraceLogWriter writer(std::move(options));
+  for (int i = 0; i < 3; ++i) {
+    MP_ASSERT_OK(writer.Write(TestInterval(i + 1)));
+  }
+  // Each interval starts a new file, and the third overwrites the first.
+  GraphProfile first = ReadLog(absl::StrCat(prefix, "0.binarypb"));
+  ASSERT_EQ(1, first.graph_trace_size());
+  EXPECT_EQ(3, first.graph_trace(0).calculator_trace_size());
+  GraphProfile second = ReadLog(absl::StrCat(prefix, "1.binarypb"));
+  ASSERT_EQ(1, second.graph_trace_size());
+  EXPECT_EQ(2, second.graph_trace(0).calculator_trace_size());
+}
+
+TEST(TraceLogWriterTest, WritesCompactTracesInBackground) {
+  TraceLogWriter::Options options = TestOptions("compact");
+  options.format = ProfilerConfig::COMPACT_BINARYPB;
+  options.queue_size = 10;
+  std::string prefix = options.path_prefix;
+  TraceLogWriter writer(std::move(options));
+  for (int i = 0; i < 2; ++i) {
+    MP_ASSERT_OK(writer.Write(TestInterval(5)));
+  }
+  MP_ASSERT_OK(writer.Flush());
+  EXPECT_EQ(0, writer.dropped_count());
+
+  GraphProfile profile = ReadLog(absl::StrCat(prefix, "0.binarypb"));
+  EXPECT_EQ(0, profile.graph_trace_size());
+  ASSERT_EQ(2, profile.compact_graph_trace_size());
+  ExpandTraces(&profile);
+  ASSERT_EQ(2, profile.graph_trace_size());
+  EXPECT_EQ(TestInterval(5).graph_trace(0).calculator_trace(4).DebugString(),
+            profile.graph_trace(1).calculator_trace(4).DebugString());
+  EXPECT_EQ("source", profile.graph_trace(0).calculator_name(0));
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -95,6 +95,7 @@ void Scheduler::SetExecutor(Executor* executor) {
       << name << "\"";
 
   SchedulerQueue* queue = inserted.first->second.get();
+  queue->SetSharded(sharded_queues_);
   queue->SetIdleCallback(std::bind(&Scheduler::QueueIdleStateChanged, this,
                                    std::placeholders::_1));
   queue->SetExecutor(executor);
@@ -102,6 +103,22 @@ void Scheduler::SetExecutor(Executor* executor) {
   return ::mediapipe::OkStatus();
 }
 
+void Scheduler::SetShardedQueues(bool sharded) {
+  CHECK_EQ(state_, STATE_NOT_STARTED)
+      << "SetShardedQueues must not be called after the scheduler has started";
+  sharded_queues_ = sharded;
+  for (auto queue : scheduler_queues_) {
+    queue->SetSharded(sharded);
+  }
+}
+
+void Scheduler::SetProcessFinishedCallback(std::function<void()> callback) {
+  CHECK_EQ(state_, STATE_NOT_STARTED)
+      << "SetProcessFinishedCallback must not be called after the scheduler "
+         "has started";
+  shared_.process_finished_callback = std::move(callback);
+}
+
 void Scheduler::SetQueuesRunning(bool running) {
   for (auto queue : scheduler_queues_) {
     queue->SetRunning(running);
@@ -59,6 +59,16 @@ class Scheduler {
   ::mediapipe::Status SetNonDefaultExecutor(const std::string& name,
                                             Executor* executor);
 
+  // Selects the sharded SchedulerQueue implementation for all current and
+  // future scheduler queues. See SchedulerQueue::SetSharded for details.
+  // Must be called before the scheduler is started.
+  void SetShardedQueues(bool sharded);
+
+  // Sets a callback invoked after every Process() call. See
+  // SchedulerShared::process_finished_callback. Must be called before the
+  // scheduler is started.
+  void SetProcessFinishedCallback(std::function<void()> callback);
+
   // Resets the data members at the beginning of each graph run.
   void Reset();
 
@@ -254,6 +264,9 @@ class Scheduler {
   // Holds pointers to all queues used by the scheduler, for convenience.
   std::vector<SchedulerQueue*> scheduler_queues_;
 
+  // True if the scheduler queues use the sharded implementation.
+  bool sharded_queues_ = false;
+
   // Priority queue of source nodes ordered by layer and then source process
   // order. This stores the set of sources that are yet to be run.
   std::priority_queue<SchedulerQueue::Item> sources_queue_
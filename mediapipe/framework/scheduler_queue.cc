@@ -14,8 +14,10 @@
 
 #include "mediapipe/framework/scheduler_queue.h"
 
+#include <functional>
 #include <memory>
 #include <queue>
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
 
 #include "absl/synchronization/mutex.h"
@@ -35,10 +37,13 @@ SchedulerQueue::Item::Item(CalculatorNode* node, CalculatorContext* cc)
   CHECK(node);
   CHECK(cc);
   is_source_ = node->IsSource();
+  is_background_ = node->IsBackground();
   id_ = node->Id();
   if (is_source_) {
     layer_ = node->source_layer();
     source_process_order_ = node->SourceProcessOrder(cc).Value();
+  } else {
+    priority_ = node->SchedulingPriority();
   }
 }
 
@@ -46,6 +51,7 @@ SchedulerQueue::Item::Item(CalculatorNode* node)
     : node_(node), cc_(nullptr), is_open_node_(true) {
   CHECK(node);
   is_source_ = node->IsSource();
+  is_background_ = node->IsBackground();
   id_ = node->Id();
   if (is_source_) {
     layer_ = node->source_layer();
@@ -63,6 +69,10 @@ bool SchedulerQueue::Item::operator<(const SchedulerQueue::Item& that) const {
     // If both are OpenNode(), higher ids run after lower ids.
     return id_ > that.id_;
   }
+  if (is_background_ != that.is_background_) {
+    // Background nodes run after all other nodes.
+    return is_background_;
+  }
   if (is_source_) {
     // Sources run after non-sources.
     if (!that.is_source_) return true;
@@ -77,6 +87,8 @@ bool SchedulerQueue::Item::operator<(const SchedulerQueue::Item& that) const {
   } else {
     // Non-sources run before sources.
     if (that.is_source_) return false;
+    // Higher priority non-sources run before lower priority ones.
+    if (priority_ != that.priority_) return priority_ < that.priority_;
     // For non-sources, higher ids run before lower ids.
     return id_ < that.id_;
   }
@@ -87,6 +99,9 @@ void SchedulerQueue::Reset() {
   num_pending_tasks_ = 0;
   num_tasks_to_add_ = 0;
   running_count_ = 0;
+  is_running_ = false;
+  num_unfinished_tasks_ = 0;
+  num_sharded_tasks_to_add_ = 0;
 }
 
 void SchedulerQueue::SetExecutor(Executor* executor) { executor_ = executor; }
@@ -101,6 +116,7 @@ void SchedulerQueue::SetRunning(bool running) {
   absl::MutexLock lock(&mutex_);
   running_count_ += running ? 1 : -1;
   DCHECK_LE(running_count_, 1);
+  is_running_ = running_count_ > 0;
 }
 
 void SchedulerQueue::AddNode(CalculatorNode* node, CalculatorContext* cc) {
@@ -116,9 +132,71 @@ void SchedulerQueue::AddNode(CalculatorNode* node, CalculatorContext* cc) {
     CHECK(node->IsSource()) << node->DebugName();
     return;
   }
+  if (node->RunsInline() && RunNodeInline(node, cc)) {
+    return;
+  }
   AddItemToQueue(Item(node, cc));
 }
 
+bool SchedulerQueue::RunNodeInline(CalculatorNode* node,
+                                   CalculatorContext* cc) {
+  bool was_idle;
+  if (sharded_) {
+    if (!is_running_.load()) {
+      return false;
+    }
+    was_idle = num_unfinished_tasks_.fetch_add(1) == 0;
+  } else {
+    absl::MutexLock lock(&mutex_);
+    if (running_count_ <= 0) {
+      return false;
+    }
+    was_idle = IsIdle();
+    ++num_pending_tasks_;
+  }
+  if (was_idle && idle_callback_) {
+    // Became not idle.
+    idle_callback_(false);
+  }
+  VLOG(4) << node->DebugName() << " is run inline.";
+
+  RunItem(node, cc, /*is_open_node=*/false);
+
+  RemovePendingTask();
+  return true;
+}
+
+void SchedulerQueue::AddPendingTask() {
+  bool was_idle;
+  if (sharded_) {
+    was_idle = num_unfinished_tasks_.fetch_add(1) == 0;
+  } else {
+    absl::MutexLock lock(&mutex_);
+    was_idle = IsIdle();
+    ++num_pending_tasks_;
+  }
+  if (was_idle && idle_callback_) {
+    // Became not idle.
+    idle_callback_(false);
+  }
+}
+
+void SchedulerQueue::RemovePendingTask() {
+  bool is_idle;
+  if (sharded_) {
+    is_idle = num_unfinished_tasks_.fetch_sub(1) == 1;
+  } else {
+    absl::MutexLock lock(&mutex_);
+    DCHECK_GT(num_pending_tasks_, 0);
+    --num_pending_tasks_;
+    is_idle = IsIdle();
+  }
+  if (is_idle && idle_callback_) {
+    // Became idle.
+    idle_callback_(true);
+  }
+}
+
 void SchedulerQueue::AddNodeForOpen(CalculatorNode* node) {
   if (shared_->has_error) {
     return;
@@ -127,6 +205,10 @@ void SchedulerQueue::AddNodeForOpen(CalculatorNode* node) {
 }
 
 void SchedulerQueue::AddItemToQueue(Item&& item) {
+  if (sharded_) {
+    AddItemToShardedQueue(std::move(item));
+    return;
+  }
   const CalculatorNode* node = item.Node();
   bool was_idle;
   int tasks_to_add = 0;
@@ -168,6 +250,10 @@ void SchedulerQueue::SubmitWaitingTasksToExecutor() {
   // If a node is added to the scheduler queue while the queue is not running,
   // we do not immediately submit tasks to the executor. Here we check for any
   // such waiting tasks, and submit them.
+  if (sharded_) {
+    SubmitWaitingShardedTasksToExecutor();
+    return;
+  }
   int tasks_to_add = 0;
   {
     absl::MutexLock lock(&mutex_);
@@ -182,6 +268,10 @@ void SchedulerQueue::SubmitWaitingTasksToExecutor() {
 }
 
 void SchedulerQueue::RunNextTask() {
+  if (sharded_) {
+    RunNextShardedTask();
+    return;
+  }
   CalculatorNode* node;
   CalculatorContext* calculator_context;
   bool is_open_node;
@@ -200,6 +290,23 @@ void SchedulerQueue::RunNextTask() {
         << "Scheduled a node that was closed. This should not happen.";
   }
 
+  RunItem(node, calculator_context, is_open_node);
+
+  bool is_idle;
+  {
+    absl::MutexLock lock(&mutex_);
+    DCHECK_GT(num_pending_tasks_, 0);
+    --num_pending_tasks_;
+    is_idle = IsIdle();
+  }
+  if (is_idle && idle_callback_) {
+    // Became idle.
+    idle_callback_(true);
+  }
+}
+
+void SchedulerQueue::RunItem(CalculatorNode* node, CalculatorContext* cc,
+                             bool is_open_node) {
   // On iOS, calculators may rely on the existence of an autorelease pool
   // (either directly, or because system code they call does). We do not
   // want to rely on executors setting up an autorelease pool for us (e.g.
@@ -207,20 +314,142 @@ void SchedulerQueue::RunNextTask() {
   // do it here to ensure all executors are covered.
   AUTORELEASEPOOL {
     if (is_open_node) {
-      DCHECK(!calculator_context);
+      DCHECK(!cc);
       OpenCalculatorNode(node);
     } else {
-      RunCalculatorNode(node, calculator_context);
+      RunCalculatorNode(node, cc);
     }
   }
+}
 
-  bool is_idle;
+void SchedulerQueue::AddItemToShardedQueue(Item&& item) {
+  const CalculatorNode* node = item.Node();
+  // Count the task before it becomes visible in a shard, so that the queue
+  // cannot appear idle while the item is queued.
+  bool was_idle = num_unfinished_tasks_.fetch_add(1) == 0;
+  Shard* shard;
+  if (item.IsOpenNode()) {
+    num_open_items_.fetch_add(1);
+    shard = &ordered_shard_;
+  } else if (node->IsBackground()) {
+    shard = &background_shard_;
+  } else if (node->IsSource()) {
+    shard = &ordered_shard_;
+  } else {
+    shard = &non_source_shards_[node->Id() % kNumNonSourceShards];
+  }
   {
-    absl::MutexLock lock(&mutex_);
-    DCHECK_GT(num_pending_tasks_, 0);
-    --num_pending_tasks_;
-    is_idle = IsIdle();
+    absl::MutexLock lock(&shard->mutex);
+    shard->items.push(item);
+    shard->size.store(shard->items.size());
+  }
+  num_sharded_tasks_to_add_.fetch_add(1);
+  VLOG(4) << node->DebugName() << " was added to the scheduler queue.";
+
+  if (was_idle && idle_callback_) {
+    // Became not idle.
+    idle_callback_(false);
+  }
+  // Note: this should be done after calling idle_callback_(false) above.
+  // See the comments on SetIdleCallback for details.
+  SubmitWaitingShardedTasksToExecutor();
+}
+
+void SchedulerQueue::SubmitWaitingShardedTasksToExecutor() {
+  // SetRunning(true) updates is_running_ before its caller calls
+  // SubmitWaitingTasksToExecutor, and AddItemToShardedQueue increments
+  // num_sharded_tasks_to_add_ before checking is_running_. So every added
+  // task is claimed by at least one of the two exchanges.
+  if (!is_running_.load()) {
+    return;
+  }
+  int tasks_to_add = num_sharded_tasks_to_add_.exchange(0);
+  while (tasks_to_add > 0) {
+    executor_->AddTask(this);
+    --tasks_to_add;
+  }
+}
+
+// static
+bool SchedulerQueue::TryPopItem(Shard* shard, CalculatorNode** node,
+                                CalculatorContext** cc, bool* is_open_node) {
+  if (shard->size.load() == 0) {
+    return false;
+  }
+  absl::MutexLock lock(&shard->mutex);
+  if (shard->items.empty()) {
+    return false;
+  }
+  *node = shard->items.top().Node();
+  *cc = shard->items.top().Context();
+  *is_open_node = shard->items.top().IsOpenNode();
+  shard->items.pop();
+  shard->size.store(shard->items.size());
+  return true;
+}
+
+void SchedulerQueue::PopShardedItem(CalculatorNode** node,
+                                    CalculatorContext** cc,
+                                    bool* is_open_node) {
+  // Start scanning the non-source shards at a per-thread offset so that
+  // concurrent workers do not all contend for the same shard.
+  static thread_local const int start_shard =
+      std::hash<std::thread::id>()(std::this_thread::get_id()) %
+      kNumNonSourceShards;
+  // Every executor task corresponds to an item that was queued before the
+  // task was submitted, so an item is always available. A scan can still come
+  // up empty if other tasks pop and push items concurrently; in that case we
+  // scan again.
+  while (true) {
+    // Open items sort before source items, so the top of ordered_shard_ is an
+    // open item whenever there are any.
+    if (num_open_items_.load() > 0 &&
+        TryPopItem(&ordered_shard_, node, cc, is_open_node)) {
+      if (*is_open_node) {
+        num_open_items_.fetch_sub(1);
+      }
+      return;
+    }
+    for (int i = 0; i < kNumNonSourceShards; ++i) {
+      Shard* shard =
+          &non_source_shards_[(start_shard + i) % kNumNonSourceShards];
+      if (TryPopItem(shard, node, cc, is_open_node)) {
+        return;
+      }
+    }
+    if (TryPopItem(&ordered_shard_, node, cc, is_open_node)) {
+      if (*is_open_node) {
+        num_open_items_.fetch_sub(1);
+      }
+      return;
+    }
+    if (TryPopItem(&background_shard_, node, cc, is_open_node)) {
+      return;
+    }
+  }
+}
+
+// static
+void SchedulerQueue::ClearShard(Shard* shard) {
+  absl::MutexLock lock(&shard->mutex);
+  while (!shard->items.empty()) {
+    shard->items.pop();
   }
+  shard->size.store(0);
+}
+
+void SchedulerQueue::RunNextShardedTask() {
+  CalculatorNode* node;
+  CalculatorContext* calculator_context;
+  bool is_open_node;
+  PopShardedItem(&node, &calculator_context, &is_open_node);
+  CHECK(!node->Closed())
+      << "Scheduled a node that was closed. This should not happen.";
+
+  RunItem(node, calculator_context, is_open_node);
+
+  DCHECK_GT(num_unfinished_tasks_.load(), 0);
+  bool is_idle = num_unfinished_tasks_.fetch_sub(1) == 1;
   if (is_idle && idle_callback_) {
     // Became idle.
     idle_callback_(true);
@@ -249,27 +478,49 @@ void SchedulerQueue::RunCalculatorNode(CalculatorNode* node,
               << " had an error while closing due to StatusStop()!";
       shared_->error_callback(result);
     }
+    VLOG(4) << "Done running " << node->DebugName();
+    node->EndScheduling();
   } else {
     // Note that we don't need a lock because only one thread can execute this
     // due to the lock on running_nodes.
     int64 start_time = shared_->timer.StartNode();
     const ::mediapipe::Status result = node->ProcessNode(cc);
     shared_->timer.EndNode(start_time);
+    if (node->ProcessDeferred(cc)) {
+      // The thread is released while the calculator completes the
+      // invocation, which remains pending until then.
+      VLOG(4) << "Deferred completion of " << node->DebugName();
+      AddPendingTask();
+      node->FinishWhenCompleted(
+          cc, [this, node](const ::mediapipe::Status& result) {
+            FinishCalculatorNode(node, result);
+            RemovePendingTask();
+          });
+      return;
+    }
+    FinishCalculatorNode(node, result);
+  }
+}
 
-    if (!result.ok()) {
-      if (result == tool::StatusStop()) {
-        // Check if StatusStop was returned by a non-source node. This means
-        // that all sources will be closed and no further sources should be
-        // scheduled. The graph will be terminated as soon as its scheduler
-        // queue becomes empty.
-        CHECK(!node->IsSource());  // ProcessNode takes care of StatusStop()
-                                   // from sources.
-        shared_->stopping = true;
-      } else {
-        // If we have an error in this calculator.
-        VLOG(3) << node->DebugName() << " had an error!";
-        shared_->error_callback(result);
-      }
+void SchedulerQueue::FinishCalculatorNode(CalculatorNode* node,
+                                          const ::mediapipe::Status& result) {
+  if (shared_->process_finished_callback) {
+    shared_->process_finished_callback();
+  }
+
+  if (!result.ok()) {
+    if (result == tool::StatusStop()) {
+      // Check if StatusStop was returned by a non-source node. This means
+      // that all sources will be closed and no further sources should be
+      // scheduled. The graph will be terminated as soon as its scheduler
+      // queue becomes empty.
+      CHECK(!node->IsSource());  // ProcessNode takes care of StatusStop()
+                                 // from sources.
+      shared_->stopping = true;
+    } else {
+      // If we have an error in this calculator.
+      VLOG(3) << node->DebugName() << " had an error!";
+      shared_->error_callback(result);
     }
   }
 
@@ -292,7 +543,24 @@ void SchedulerQueue::OpenCalculatorNode(CalculatorNode* node) {
 
 void SchedulerQueue::CleanupAfterRun() {
   bool was_idle;
-  {
+  if (sharded_) {
+    int num_queued_items =
+        ordered_shard_.size.load() + background_shard_.size.load();
+    for (Shard& shard : non_source_shards_) {
+      num_queued_items += shard.size.load();
+    }
+    was_idle = num_unfinished_tasks_.load() == 0;
+    CHECK_EQ(num_unfinished_tasks_.load(), num_queued_items);
+    CHECK_EQ(num_sharded_tasks_to_add_.load(), num_queued_items);
+    num_unfinished_tasks_ = 0;
+    num_sharded_tasks_to_add_ = 0;
+    num_open_items_ = 0;
+    ClearShard(&ordered_shard_);
+    ClearShard(&background_shard_);
+    for (Shard& shard : non_source_shards_) {
+      ClearShard(&shard);
+    }
+  } else {
     absl::MutexLock lock(&mutex_);
     was_idle = IsIdle();
     CHECK_EQ(num_pending_tasks_, 0);
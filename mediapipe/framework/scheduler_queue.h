@@ -20,6 +20,7 @@
 #include <memory>
 #include <queue>
 #include <utility>
+#include <vector>
 
 #include "absl/base/macros.h"
 #include "absl/synchronization/mutex.h"
@@ -58,30 +59,54 @@ class SchedulerQueue : public TaskQueue {
     // This comparison is meant to be used with a std::priority_queue. Since
     // the priority queue returns higher priority items first, this function
     // means "this is lower priority than that", i.e. "this runs after that".
+    // - OpenNode() calls run first.
+    // - Background nodes run after all other nodes, and are sorted among
+    //   themselves by the rules below.
     // - Non-sources have priority over sources.
     // - Sources are sorted by layer (lower layer numbers run first), then by
     //   Calculator::SourceProcessOrder (smaller values run first), then by
     //   node id: smaller ids run first, since they come earlier in the config.
-    // - Non-sources are sorted by node id: larger ids run first, because they
+    // - Non-sources are sorted by CalculatorNode::SchedulingPriority() (larger
+    //   values run first), then by node id: larger ids run first, because they
     //   are closer to the leaves.
     bool operator<(const Item& that) const;
 
    private:
     int64 source_process_order_ = 0;
+    int64 priority_ = 0;
     CalculatorNode* node_;
     CalculatorContext* cc_;
     int id_ = 0;
     int layer_ = 0;
     bool is_source_ = false;
+    bool is_background_ = false;
     bool is_open_node_ = false;  // True if the task should run OpenNode().
   };
 
+  // The number of shards used for non-source nodes in sharded mode.
+  static constexpr int kNumNonSourceShards = 8;
+
   explicit SchedulerQueue(SchedulerShared* shared) : shared_(shared) {}
 
   // Sets the executor that will run the nodes. Must be called before the
   // scheduler is started.
   void SetExecutor(Executor* executor);
 
+  // Switches the queue to sharded mode. Must be called before the scheduler
+  // is started.
+  //
+  // In sharded mode, items for non-source nodes are spread over
+  // kNumNonSourceShards priority queues by node id, each with its own lock,
+  // and the task counters are atomics. This lets calculators that run on
+  // different threads add and run tasks without serializing on a single
+  // mutex. OpenNode() and source items keep using a single priority queue, so
+  // OpenNode() calls still run first and sources still run strictly in
+  // source layer and SourceProcessOrder order after all non-sources. Within
+  // the non-sources, the "larger ids run first" order is only maintained
+  // among nodes in the same shard. Items of background nodes go to a
+  // separate priority queue that is only read when all the others are empty.
+  void SetSharded(bool sharded) { sharded_ = sharded; }
+
   // Sets the idle callback. It is called exactly once whenever the queue goes
   // from idle to active, or vice versa.
   // Note: if the queue is accessed by multiple threads, it is possible for
@@ -121,6 +146,8 @@ class SchedulerQueue : public TaskQueue {
   // not already running. Note that if the node was running, then it will be
   // rescheduled upon completion (after checking dependencies), so this call is
   // not lost.
+  // If the node runs inline and the queue is running, the node is run
+  // synchronously on the calling thread instead of being queued.
   void AddNode(CalculatorNode* node, CalculatorContext* cc)
       LOCKS_EXCLUDED(mutex_);
 
@@ -134,10 +161,28 @@ class SchedulerQueue : public TaskQueue {
 
  private:
   // Used internally by RunNextTask. Invokes ProcessNode or CloseNode, followed
-  // by EndScheduling.
+  // by EndScheduling, which is delayed if the calculator deferred the
+  // completion of Process().
   void RunCalculatorNode(CalculatorNode* node, CalculatorContext* cc)
       LOCKS_EXCLUDED(mutex_);
 
+  // Reports the |result| of running |node| and calls EndScheduling.
+  void FinishCalculatorNode(CalculatorNode* node,
+                            const ::mediapipe::Status& result)
+      LOCKS_EXCLUDED(mutex_);
+
+  // Accounts for a task that runs outside of the executor, such as an inline
+  // node or a deferred Process() call, so that the queue does not become
+  // idle until RemovePendingTask() is called.
+  void AddPendingTask() LOCKS_EXCLUDED(mutex_);
+  void RemovePendingTask() LOCKS_EXCLUDED(mutex_);
+
+  // Runs |node| synchronously on the calling thread, accounting for it as a
+  // pending task so that the queue does not become idle in the meantime.
+  // Returns false, without running the node, if the queue is not running.
+  bool RunNodeInline(CalculatorNode* node, CalculatorContext* cc)
+      LOCKS_EXCLUDED(mutex_);
+
   // Used internally by RunNextTask. Invokes OpenNode, followed by
   // CheckIfBecameReady.
   void OpenCalculatorNode(CalculatorNode* node) LOCKS_EXCLUDED(mutex_);
@@ -145,6 +190,37 @@ class SchedulerQueue : public TaskQueue {
   // Checks whether the queue has no queued nodes or pending tasks.
   bool IsIdle() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+  // A priority queue with its own lock, used in sharded mode.
+  struct Shard {
+    absl::Mutex mutex;
+    std::priority_queue<Item> items GUARDED_BY(mutex);
+    // Mirrors items.size() so that empty shards can be skipped without
+    // taking the lock.
+    std::atomic<int> size{0};
+  };
+
+  // Sharded-mode counterparts of AddItemToQueue, SubmitWaitingTasksToExecutor
+  // and RunNextTask.
+  void AddItemToShardedQueue(Item&& item);
+  void SubmitWaitingShardedTasksToExecutor();
+  void RunNextShardedTask();
+
+  // Pops the highest priority item from |shard| into the output arguments.
+  // Returns false if the shard is empty.
+  static bool TryPopItem(Shard* shard, CalculatorNode** node,
+                         CalculatorContext** cc, bool* is_open_node);
+
+  // Removes all items from |shard|.
+  static void ClearShard(Shard* shard);
+
+  // Pops the next item to run in sharded mode. Open items run first, then
+  // non-source items, then source items, then background items.
+  void PopShardedItem(CalculatorNode** node, CalculatorContext** cc,
+                      bool* is_open_node);
+
+  // Runs the task for the popped item.
+  void RunItem(CalculatorNode* node, CalculatorContext* cc, bool is_open_node);
+
   Executor* executor_ = nullptr;
 
   IdleCallback idle_callback_;
@@ -165,6 +241,25 @@ class SchedulerQueue : public TaskQueue {
   // Queue of nodes that need to be run.
   std::priority_queue<Item> queue_ GUARDED_BY(mutex_);
 
+  // Mirrors running_count_ > 0 for lock-free reads in sharded mode.
+  std::atomic<bool> is_running_{false};
+
+  // Sharded mode state. See SetSharded().
+  bool sharded_ = false;
+  // Holds OpenNode() and source items.
+  Shard ordered_shard_;
+  // Holds non-source items, keyed by node id.
+  Shard non_source_shards_[kNumNonSourceShards];
+  // Holds the items of background nodes, other than OpenNode() items.
+  Shard background_shard_;
+  // Number of OpenNode() items in ordered_shard_.
+  std::atomic<int> num_open_items_{0};
+  // Number of items added to the queue whose task has not completed yet.
+  // The queue is idle when this is zero.
+  std::atomic<int> num_unfinished_tasks_{0};
+  // Number of tasks that need to be added to the Executor.
+  std::atomic<int> num_sharded_tasks_to_add_{0};
+
   SchedulerShared* const shared_;
 
   absl::Mutex mutex_;
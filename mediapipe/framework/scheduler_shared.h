@@ -106,6 +106,10 @@ struct SchedulerShared {
   std::atomic<bool> stopping;
   std::atomic<bool> has_error;
   std::function<void(const ::mediapipe::Status& error)> error_callback;
+  // If set, called after every Process() call run by a scheduler queue, on
+  // the thread that ran it.  Must be cheap, and must be set before the
+  // scheduler is started.
+  std::function<void()> process_finished_callback;
   // Collects timing information for measuring overhead.
   internal::SchedulerTimer timer;
 };
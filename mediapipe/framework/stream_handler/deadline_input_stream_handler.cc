@@ -0,0 +1,164 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <map>
+#include <memory>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/deps/clock.h"
+#include "mediapipe/framework/stream_handler/deadline_input_stream_handler.pb.h"
+#include "mediapipe/framework/stream_handler/default_input_stream_handler.h"
+
+namespace mediapipe {
+
+// Input stream handler that discards input sets which can no longer meet a
+// latency budget.  Right before the node would process an input set, its age
+// is compared against latency_budget_usec, and every input set older than
+// the budget is dropped from all input streams.  The age is measured from the
+// arrival of the first packet of the input set at this node, or, with
+// time_source PACKET_TIMESTAMP, from the input timestamp itself.
+//
+// For example, a calculator node with the following input stream handler
+// specs:
+//
+// node {
+//   calculator: "ObjectDetectionCalculator"
+//   input_stream: "camera_frames"
+//   input_stream_handler {
+//     input_stream_handler: "DeadlineInputStreamHandler"
+//     options {
+//       [mediapipe.DeadlineInputStreamHandlerOptions.ext] {
+//         latency_budget_usec: 33000
+//       }
+//     }
+//   }
+// }
+//
+// skips the frames that have waited more than 33 ms while the calculator was
+// busy, and processes the newer ones.  Unlike FixedSizeInputStreamHandler,
+// the number of queued packets does not matter, only their age.  Once a
+// timestamp is dropped, packets arriving later at or below it are dropped as
+// well, so that each processed timestamp delivers the same packets as
+// DefaultInputStreamHandler includes.
+class DeadlineInputStreamHandler : public DefaultInputStreamHandler {
+ public:
+  DeadlineInputStreamHandler() = delete;
+  DeadlineInputStreamHandler(std::shared_ptr<tool::TagMap> tag_map,
+                             CalculatorContextManager* cc_manager,
+                             const MediaPipeOptions& options,
+                             bool calculator_run_in_parallel)
+      : DefaultInputStreamHandler(std::move(tag_map), cc_manager, options,
+                                  calculator_run_in_parallel),
+        clock_(Clock::RealClock()) {
+    const auto& ext =
+        options.GetExtension(DeadlineInputStreamHandlerOptions::ext);
+    latency_budget_usec_ = ext.latency_budget_usec();
+    use_packet_timestamp_ = ext.time_source() ==
+                            DeadlineInputStreamHandlerOptions::PACKET_TIMESTAMP;
+    drop_bound_ = Timestamp::Unset();
+  }
+
+ private:
+  // Records the arrival time of each new input timestamp.
+  void RecordArrivals(const PacketRingBuffer& packets) LOCKS_EXCLUDED(mutex_) {
+    if (use_packet_timestamp_ || packets.empty()) {
+      return;
+    }
+    int64 now_usec = absl::ToUnixMicros(clock_->TimeNow());
+    absl::MutexLock lock(&mutex_);
+    for (const Packet& packet : packets) {
+      // Keeps the earliest arrival among all input streams.
+      if (packet.Timestamp().IsRangeValue()) {
+        arrival_usec_.emplace(packet.Timestamp(), now_usec);
+      }
+    }
+  }
+
+  // Returns the largest timestamp older than the latency budget, or
+  // Timestamp::Unset() if no input set is stale.
+  Timestamp LatestStaleTimestamp() EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    int64 deadline_usec =
+        absl::ToUnixMicros(clock_->TimeNow()) - latency_budget_usec_;
+    if (use_packet_timestamp_) {
+      Timestamp deadline = Timestamp(deadline_usec);
+      return deadline > Timestamp::Min() ? deadline - 1 : Timestamp::Unset();
+    }
+    Timestamp stale = Timestamp::Unset();
+    for (const auto& arrival : arrival_usec_) {
+      if (arrival.second < deadline_usec) {
+        stale = arrival.first;
+      }
+    }
+    return stale;
+  }
+
+  // Drops every input set older than the latency budget from all streams.
+  void EraseStalePackets() EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    Timestamp stale = LatestStaleTimestamp();
+    if (stale.IsRangeValue() && stale >= drop_bound_) {
+      drop_bound_ = stale.NextAllowedInStream();
+    }
+    if (drop_bound_ == Timestamp::Unset()) {
+      return;
+    }
+    for (auto& stream : input_stream_managers_) {
+      stream->ErasePacketsEarlierThan(drop_bound_);
+    }
+    arrival_usec_.erase(arrival_usec_.begin(),
+                        arrival_usec_.lower_bound(drop_bound_));
+  }
+
+  NodeReadiness GetNodeReadiness(Timestamp* min_stream_timestamp) override {
+    DCHECK(min_stream_timestamp);
+    absl::MutexLock lock(&mutex_);
+    EraseStalePackets();
+    return DefaultInputStreamHandler::GetNodeReadiness(min_stream_timestamp);
+  }
+
+  void AddPackets(CollectionItemId id,
+                  const PacketRingBuffer& packets) override {
+    RecordArrivals(packets);
+    InputStreamHandler::AddPackets(id, packets);
+  }
+
+  void MovePackets(CollectionItemId id, PacketRingBuffer* packets) override {
+    RecordArrivals(*packets);
+    InputStreamHandler::MovePackets(id, packets);
+  }
+
+  void FillInputSet(Timestamp input_timestamp,
+                    InputStreamShardSet* input_set) override {
+    CHECK(input_set);
+    DefaultInputStreamHandler::FillInputSet(input_timestamp, input_set);
+    absl::MutexLock lock(&mutex_);
+    arrival_usec_.erase(arrival_usec_.begin(),
+                        arrival_usec_.upper_bound(input_timestamp));
+  }
+
+  Clock* const clock_;
+  int64 latency_budget_usec_;
+  bool use_packet_timestamp_;
+  absl::Mutex mutex_;
+  // The first arrival time of each queued input timestamp, in microseconds
+  // since the Unix epoch.  Unused with time_source PACKET_TIMESTAMP.
+  std::map<Timestamp, int64> arrival_usec_ GUARDED_BY(mutex_);
+  // Packets earlier than this timestamp have been dropped from every stream,
+  // and are dropped again if they arrive late on some stream.
+  Timestamp drop_bound_ GUARDED_BY(mutex_);
+};
+
+REGISTER_INPUT_STREAM_HANDLER(DeadlineInputStreamHandler);
+
+}  // namespace mediapipe
@@ -0,0 +1,157 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/stream_handler/deadline_input_stream_handler.pb.h"
+
+namespace mediapipe {
+
+namespace {
+
+ABSL_CONST_INIT absl::Mutex g_gate_mutex(absl::kConstInit);
+// Whether TestGateCalculator holds its packets.
+bool g_gate_closed GUARDED_BY(g_gate_mutex);
+// Whether TestGateCalculator is waiting in Process().
+bool g_gate_waiting GUARDED_BY(g_gate_mutex);
+
+// Passes its input through, waiting in Process() while g_gate_closed is set.
+class TestGateCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).SetSameAs(&cc->Inputs().Index(0));
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    {
+      absl::MutexLock lock(&g_gate_mutex);
+      g_gate_waiting = true;
+      g_gate_mutex.Await(absl::Condition(
+          +[](bool* closed) { return !*closed; }, &g_gate_closed));
+      g_gate_waiting = false;
+    }
+    cc->Outputs().Index(0).AddPacket(cc->Inputs().Index(0).Value());
+    return ::mediapipe::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(TestGateCalculator);
+
+class DeadlineInputStreamHandlerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    absl::MutexLock lock(&g_gate_mutex);
+    g_gate_closed = false;
+    g_gate_waiting = false;
+  }
+
+  // Runs TestGateCalculator behind a DeadlineInputStreamHandler with the
+  // given options.
+  void StartGraph(const std::string& handler_options) {
+    CalculatorGraphConfig config = ParseTextProtoOrDie<CalculatorGraphConfig>(
+        absl::StrCat(R"(
+          input_stream: "input"
+          node {
+            calculator: "TestGateCalculator"
+            input_stream: "input"
+            output_stream: "output"
+            input_stream_handler {
+              input_stream_handler: "DeadlineInputStreamHandler"
+              options {
+                [mediapipe.DeadlineInputStreamHandlerOptions.ext] {)",
+                     handler_options, "}}}}"));
+    MP_ASSERT_OK(graph_.Initialize(config));
+    MP_ASSERT_OK(graph_.ObserveOutputStream("output", [this](const Packet& p) {
+      output_timestamps_.push_back(p.Timestamp());
+      return ::mediapipe::OkStatus();
+    }));
+    MP_ASSERT_OK(graph_.StartRun({}));
+  }
+
+  void AddPacket(Timestamp timestamp) {
+    MP_ASSERT_OK(graph_.AddPacketToInputStream(
+        "input", MakePacket<int>(0).At(timestamp)));
+  }
+
+  void FinishGraph() {
+    MP_ASSERT_OK(graph_.CloseAllInputStreams());
+    MP_ASSERT_OK(graph_.WaitUntilDone());
+  }
+
+  CalculatorGraph graph_;
+  std::vector<Timestamp> output_timestamps_;
+};
+
+// Packets processed within the latency budget are all delivered.
+TEST_F(DeadlineInputStreamHandlerTest, KeepsFreshPackets) {
+  StartGraph("latency_budget_usec: 10000000");
+  for (int i = 0; i < 10; ++i) {
+    AddPacket(Timestamp(i));
+    MP_ASSERT_OK(graph_.WaitUntilIdle());
+  }
+  FinishGraph();
+  EXPECT_EQ(10, output_timestamps_.size());
+}
+
+// Packets that wait longer than the latency budget while the calculator is
+// busy are dropped.
+TEST_F(DeadlineInputStreamHandlerTest, DropsPacketsPastArrivalDeadline) {
+  StartGraph("latency_budget_usec: 100000");
+  {
+    absl::MutexLock lock(&g_gate_mutex);
+    g_gate_closed = true;
+  }
+  AddPacket(Timestamp(0));
+  {
+    absl::MutexLock lock(&g_gate_mutex);
+    g_gate_mutex.Await(absl::Condition(&g_gate_waiting));
+  }
+  AddPacket(Timestamp(1));
+  AddPacket(Timestamp(2));
+  absl::SleepFor(absl::Milliseconds(500));
+  AddPacket(Timestamp(3));
+  {
+    absl::MutexLock lock(&g_gate_mutex);
+    g_gate_closed = false;
+  }
+  FinishGraph();
+  EXPECT_EQ(std::vector<Timestamp>({Timestamp(0), Timestamp(3)}),
+            output_timestamps_);
+}
+
+// With time_source PACKET_TIMESTAMP, the age of a packet is given by its
+// timestamp in microseconds since the Unix epoch.
+TEST_F(DeadlineInputStreamHandlerTest, DropsPacketsPastTimestampDeadline) {
+  StartGraph("latency_budget_usec: 1000000 time_source: PACKET_TIMESTAMP");
+  int64 now_usec = absl::ToUnixMicros(absl::Now());
+  AddPacket(Timestamp(now_usec - 10000000));
+  AddPacket(Timestamp(now_usec - 9000000));
+  AddPacket(Timestamp(now_usec));
+  FinishGraph();
+  EXPECT_EQ(std::vector<Timestamp>({Timestamp(now_usec)}), output_timestamps_);
+}
+
+}  // namespace
+}  // namespace mediapipe
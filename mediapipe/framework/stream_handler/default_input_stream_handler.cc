@@ -38,13 +38,21 @@ NodeReadiness DefaultInputStreamHandler::GetNodeReadiness(
   DCHECK(min_stream_timestamp);
   *min_stream_timestamp = Timestamp::Done();
   Timestamp min_bound = Timestamp::Done();
-  for (const auto& stream : input_stream_managers_) {
-    bool empty;
-    Timestamp stream_timestamp = stream->MinTimestampOrBound(&empty);
-    if (empty) {
-      min_bound = std::min(min_bound, stream_timestamp);
+  stream_bounds_.resize(input_stream_managers_.NumEntries());
+  for (CollectionItemId id = input_stream_managers_.BeginId();
+       id < input_stream_managers_.EndId(); ++id) {
+    const auto& stream = input_stream_managers_.Get(id);
+    StreamBound& bound = stream_bounds_[id.value()];
+    // Only lock the streams that have changed since the last check.
+    const int64 version = stream->MinTimestampOrBoundVersion();
+    if (version != bound.version) {
+      bound.version = version;
+      bound.timestamp = stream->MinTimestampOrBound(&bound.empty);
+    }
+    if (bound.empty) {
+      min_bound = std::min(min_bound, bound.timestamp);
     }
-    *min_stream_timestamp = std::min(*min_stream_timestamp, stream_timestamp);
+    *min_stream_timestamp = std::min(*min_stream_timestamp, bound.timestamp);
   }
 
   if (*min_stream_timestamp == Timestamp::Done()) {
@@ -45,6 +45,20 @@ class DefaultInputStreamHandler : public InputStreamHandler {
   // Only invoked when associated GetNodeReadiness() returned kReadyForProcess.
   void FillInputSet(Timestamp input_timestamp,
                     InputStreamShardSet* input_set) override;
+
+ private:
+  // The last observed MinTimestampOrBound() of an input stream, and the
+  // stream's MinTimestampOrBoundVersion() read before observing it.
+  struct StreamBound {
+    int64 version = -1;
+    Timestamp timestamp;
+    bool empty = true;
+  };
+
+  // The cached bounds of the input streams, indexed by CollectionItemId.
+  // Only accessed by GetNodeReadiness(), so that a notification only locks
+  // the streams that changed since the previous readiness check.
+  std::vector<StreamBound> stream_bounds_;
 };
 
 }  // namespace mediapipe
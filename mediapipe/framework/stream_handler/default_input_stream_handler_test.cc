@@ -12,13 +12,22 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <memory>
 #include <vector>
 
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_context.h"
+#include "mediapipe/framework/calculator_context_manager.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/input_stream_handler.h"
+#include "mediapipe/framework/packet_ring_buffer.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/parse_text_proto.h"
 #include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/tool/tag_map_helper.h"
 
 namespace mediapipe {
 
@@ -279,5 +288,69 @@ TEST(DefaultInputStreamHandlerTest, DoesntPropagateTimestampWhenBatching) {
   EXPECT_EQ(4, sink.size());
 }
 
+// Measures the readiness check, input set filling and clearing that the
+// scheduler performs for every invocation of a node with state.range(0) input
+// streams, without running a graph. Each iteration adds one packet to every
+// stream and schedules the resulting invocation.
+void BM_ScheduleInvocations(benchmark::State& state) {
+  const int num_streams = state.range(0);
+  std::vector<std::string> names;
+  for (int i = 0; i < num_streams; ++i) {
+    names.push_back(absl::StrCat("input_", i));
+  }
+  std::shared_ptr<tool::TagMap> input_tag_map =
+      tool::CreateTagMap(names).ValueOrDie();
+  PacketType packet_type;
+  packet_type.Set<int>();
+  auto input_stream_managers =
+      absl::make_unique<InputStreamManager[]>(num_streams);
+  for (int i = 0; i < num_streams; ++i) {
+    MEDIAPIPE_CHECK_OK(input_stream_managers[i].Initialize(
+        names[i], &packet_type, /*back_edge=*/false));
+  }
+  CalculatorState calculator_state("Node", /*node_id=*/0, "Calculator",
+                                   CalculatorGraphConfig::Node(), nullptr);
+  CalculatorContextManager cc_manager;
+  cc_manager.Initialize(&calculator_state, input_tag_map,
+                        /*output_tag_map=*/tool::CreateTagMap(0).ValueOrDie(),
+                        /*calculator_run_in_parallel=*/false);
+  std::unique_ptr<InputStreamHandler> input_stream_handler =
+      InputStreamHandlerRegistry::CreateByName(
+          "DefaultInputStreamHandler", input_tag_map, &cc_manager,
+          MediaPipeOptions(), /*calculator_run_in_parallel=*/false)
+          .ValueOrDie();
+  MEDIAPIPE_CHECK_OK(input_stream_handler->InitializeInputStreamManagers(
+      input_stream_managers.get()));
+  MEDIAPIPE_CHECK_OK(cc_manager.PrepareForRun(
+      [](CalculatorContext*) { return ::mediapipe::OkStatus(); }));
+  CalculatorContext* cc = nullptr;
+  input_stream_handler->PrepareForRun(
+      /*headers_ready_callback=*/[]() {}, /*notification_callback=*/[]() {},
+      /*schedule_callback=*/[&cc](CalculatorContext* context) { cc = context; },
+      /*error_callback=*/[](::mediapipe::Status status) {
+        MEDIAPIPE_CHECK_OK(status);
+      });
+
+  Packet packet = MakePacket<int>(1);
+  PacketRingBuffer packets;
+  int64 timestamp = 0;
+  Timestamp input_bound;
+  for (auto _ : state) {
+    for (CollectionItemId id = input_tag_map->BeginId();
+         id < input_tag_map->EndId(); ++id) {
+      packets.clear();
+      packets.push_back(packet.At(Timestamp(timestamp)));
+      input_stream_handler->AddPackets(id, packets);
+    }
+    ++timestamp;
+    CHECK(input_stream_handler->ScheduleInvocations(/*max_allowance=*/1,
+                                                    &input_bound));
+    input_stream_handler->FinalizeInputSet(cc->InputTimestamp(),
+                                           &cc->Inputs());
+    input_stream_handler->ClearCurrentInputs(cc);
+  }
+}
+BENCHMARK(BM_ScheduleInvocations)->Arg(1)->Arg(4);
+
 }  // namespace
 }  // namespace mediapipe
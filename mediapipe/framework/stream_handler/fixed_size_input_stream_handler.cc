@@ -66,13 +66,14 @@ class FixedSizeInputStreamHandler : public DefaultInputStreamHandler {
   }
 
  private:
-  // Drops packets if all input streams exceed trigger_queue_size.
-  void EraseAllSurplus() EXCLUSIVE_LOCKS_REQUIRED(erase_mutex_) {
+  // Drops packets if all input streams exceed trigger_queue_size, and returns
+  // the number of packets dropped.
+  int EraseAllSurplus() EXCLUSIVE_LOCKS_REQUIRED(erase_mutex_) {
     Timestamp min_timestamp_all_streams = Timestamp::Max();
     for (const auto& stream : input_stream_managers_) {
       // Check whether every InputStreamImpl grew beyond trigger_queue_size.
       if (stream->QueueSize() < trigger_queue_size_) {
-        return;
+        return 0;
       }
       Timestamp min_timestamp =
           stream->GetMinTimestampAmongNLatest(target_queue_size_);
@@ -82,9 +83,11 @@ class FixedSizeInputStreamHandler : public DefaultInputStreamHandler {
       min_timestamp_all_streams =
           std::min(min_timestamp_all_streams, min_timestamp);
     }
+    int num_erased = 0;
     for (auto& stream : input_stream_managers_) {
-      stream->ErasePacketsEarlierThan(min_timestamp_all_streams);
+      num_erased += stream->ErasePacketsEarlierThan(min_timestamp_all_streams);
     }
+    return num_erased;
   }
 
   // Returns the latest timestamp allowed before a bound.
@@ -126,8 +129,9 @@ class FixedSizeInputStreamHandler : public DefaultInputStreamHandler {
 
   // Keeps only the most recent target_queue_size packets in each stream
   // exceeding trigger_queue_size.  Also, discards all packets older than the
-  // first kept timestamp on any stream.
-  void EraseAnySurplus(bool keep_one) EXCLUSIVE_LOCKS_REQUIRED(erase_mutex_) {
+  // first kept timestamp on any stream.  Returns the number of packets
+  // dropped.
+  int EraseAnySurplus(bool keep_one) EXCLUSIVE_LOCKS_REQUIRED(erase_mutex_) {
     // Record the most recent first kept timestamp on any stream.
     for (const auto& stream : input_stream_managers_) {
       int32 queue_size = (stream->QueueSize() >= trigger_queue_size_)
@@ -145,14 +149,24 @@ class FixedSizeInputStreamHandler : public DefaultInputStreamHandler {
       kept_timestamp_ =
           std::min(kept_timestamp_, PreviousAllowedInStream(MinStreamBound()));
     }
+    int num_erased = 0;
     for (auto& stream : input_stream_managers_) {
-      stream->ErasePacketsEarlierThan(kept_timestamp_);
+      num_erased += stream->ErasePacketsEarlierThan(kept_timestamp_);
     }
+    return num_erased;
   }
 
+  // Drops surplus packets, and counts them in the "DroppedPackets" counter
+  // of the node.
   void EraseSurplusPackets(bool keep_one)
       EXCLUSIVE_LOCKS_REQUIRED(erase_mutex_) {
-    return (fixed_min_size_) ? EraseAllSurplus() : EraseAnySurplus(keep_one);
+    int num_erased =
+        (fixed_min_size_) ? EraseAllSurplus() : EraseAnySurplus(keep_one);
+    if (num_erased > 0) {
+      calculator_context_manager_->GetDefaultCalculatorContext()
+          ->GetCounter("DroppedPackets")
+          ->IncrementBy(num_erased);
+    }
   }
 
   NodeReadiness GetNodeReadiness(Timestamp* min_stream_timestamp) {
@@ -182,7 +196,7 @@ class FixedSizeInputStreamHandler : public DefaultInputStreamHandler {
   }
 
   void AddPackets(CollectionItemId id,
-                  const std::list<Packet>& packets) override {
+                  const PacketRingBuffer& packets) override {
     InputStreamHandler::AddPackets(id, packets);
     absl::MutexLock lock(&erase_mutex_);
     if (!pending_) {
@@ -190,7 +204,7 @@ class FixedSizeInputStreamHandler : public DefaultInputStreamHandler {
     }
   }
 
-  void MovePackets(CollectionItemId id, std::list<Packet>* packets) override {
+  void MovePackets(CollectionItemId id, PacketRingBuffer* packets) override {
     InputStreamHandler::MovePackets(id, packets);
     absl::MutexLock lock(&erase_mutex_);
     if (!pending_) {
@@ -12,10 +12,17 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/collection_item_id.h"
 #include "mediapipe/framework/input_stream_handler.h"
+#include "mediapipe/framework/mediapipe_options.pb.h"
+#include "mediapipe/framework/packet_ring_buffer.h"
+#include "mediapipe/framework/stream_handler/immediate_input_stream_handler.pb.h"
+#include "mediapipe/framework/tool/tag_map.h"
 
 namespace mediapipe {
 
@@ -29,6 +36,32 @@ namespace mediapipe {
 // non-increasing.  Its Calculator is responsible for accumulating packets
 // with the required timetamps before processing and delivering output.
 //
+// By default every input queue is unbounded, and a slow Calculator throttles
+// its producers through the graph-level max_queue_size.  Instead, the input
+// queues can be bounded per input stream by a drop policy, which keeps
+// producers running at their own rate.  For example, to process only the
+// latest video frame while keeping every control packet:
+//
+// node {
+//   calculator: "SlowVideoCalculator"
+//   input_stream: "VIDEO:input_video"
+//   input_stream: "CONTROL:control"
+//   input_stream_handler {
+//     input_stream_handler: "ImmediateInputStreamHandler"
+//     options {
+//       [mediapipe.ImmediateInputStreamHandlerOptions.ext] {
+//         queue_policy {
+//           tag_index: "VIDEO"
+//           drop_policy: DROP_OLDEST
+//           max_queue_size: 1
+//         }
+//       }
+//     }
+//   }
+// }
+//
+// Dropped packets are counted in the "DroppedPackets" counter of the node.
+//
 class ImmediateInputStreamHandler : public InputStreamHandler {
  public:
   ImmediateInputStreamHandler() = delete;
@@ -47,8 +80,49 @@ class ImmediateInputStreamHandler : public InputStreamHandler {
   void FillInputSet(Timestamp input_timestamp,
                     InputStreamShardSet* input_set) override;
 
+  // Adds the packets, dropping packets as required by the drop policy of the
+  // input stream.
+  void AddPackets(CollectionItemId id,
+                  const PacketRingBuffer& packets) override;
+  void MovePackets(CollectionItemId id, PacketRingBuffer* packets) override;
+
+ private:
+  typedef ImmediateInputStreamHandlerOptions::DropPolicy DropPolicy;
+
+  // Returns the number of packets that can be added to the input stream
+  // without exceeding its max_queue_size under DROP_NEWEST, or -1 if the
+  // input stream does not drop its newest packets.
+  int RoomForNewest(CollectionItemId id);
+
+  // Adds the first "room" packets, and drops the others while advancing the
+  // timestamp bound past them.  "Container" is a const reference when called
+  // from AddPackets, and a non-const reference when called from MovePackets.
+  template <typename Container>
+  void AddNewestWithin(CollectionItemId id, Container packets, int room);
+
+  // Returns the node readiness, ignoring the drop policies.
+  NodeReadiness GetReadiness(Timestamp* min_stream_timestamp);
+
+  // Drops the oldest packets of the DROP_OLDEST input streams beyond their
+  // max_queue_size.
+  void DropOldest() EXCLUSIVE_LOCKS_REQUIRED(drop_mutex_);
+
+  // Counts dropped packets in the "DroppedPackets" counter of the node.
+  void CountDropped(int num_dropped);
+
   // Record of the last reported timestamp bound for each input stream.
   mediapipe::internal::Collection<Timestamp> timestamp_bounds_;
+  // The drop policy and the max queue size of each input stream.
+  mediapipe::internal::Collection<DropPolicy> drop_policies_;
+  mediapipe::internal::Collection<int> max_queue_sizes_;
+  // True if any input stream uses DROP_OLDEST.
+  bool drop_oldest_ = false;
+  // Indicates that GetNodeReadiness has returned kReadyForProcess, and the
+  // corresponding call to FillInputSet has not yet completed.  The oldest
+  // packets are not dropped meanwhile, so that the packets at the returned
+  // input timestamp remain available.
+  bool pending_ GUARDED_BY(drop_mutex_) = false;
+  absl::Mutex drop_mutex_;
 };
 REGISTER_INPUT_STREAM_HANDLER(ImmediateInputStreamHandler);
 
@@ -58,10 +132,143 @@ ImmediateInputStreamHandler::ImmediateInputStreamHandler(
     const MediaPipeOptions& options, bool calculator_run_in_parallel)
     : InputStreamHandler(tag_map, calculator_context_manager, options,
                          calculator_run_in_parallel),
-      timestamp_bounds_(std::move(tag_map)) {}
+      timestamp_bounds_(tag_map),
+      drop_policies_(tag_map),
+      max_queue_sizes_(std::move(tag_map)) {
+  const auto& ext =
+      options.GetExtension(ImmediateInputStreamHandlerOptions::ext);
+  for (CollectionItemId id = drop_policies_.BeginId();
+       id < drop_policies_.EndId(); ++id) {
+    drop_policies_.Get(id) = ext.drop_policy();
+    max_queue_sizes_.Get(id) = ext.max_queue_size();
+  }
+  for (const auto& queue_policy : ext.queue_policy()) {
+    std::string tag;
+    int index;
+    MEDIAPIPE_CHECK_OK(
+        tool::ParseTagIndex(queue_policy.tag_index(), &tag, &index));
+    CollectionItemId id = input_stream_managers_.GetId(tag, index);
+    CHECK(id.IsValid()) << "stream \"" << queue_policy.tag_index()
+                        << "\" is not found.";
+    drop_policies_.Get(id) = queue_policy.drop_policy();
+    max_queue_sizes_.Get(id) = queue_policy.max_queue_size();
+  }
+  for (CollectionItemId id = drop_policies_.BeginId();
+       id < drop_policies_.EndId(); ++id) {
+    if (drop_policies_.Get(id) !=
+        ImmediateInputStreamHandlerOptions::KEEP_ALL) {
+      CHECK_LT(0, max_queue_sizes_.Get(id))
+          << "max_queue_size must be positive to drop packets.";
+    }
+    if (drop_policies_.Get(id) ==
+        ImmediateInputStreamHandlerOptions::DROP_OLDEST) {
+      drop_oldest_ = true;
+    }
+  }
+}
+
+void ImmediateInputStreamHandler::CountDropped(int num_dropped) {
+  if (num_dropped > 0) {
+    calculator_context_manager_->GetDefaultCalculatorContext()
+        ->GetCounter("DroppedPackets")
+        ->IncrementBy(num_dropped);
+  }
+}
+
+void ImmediateInputStreamHandler::DropOldest() {
+  int num_dropped = 0;
+  for (CollectionItemId id = input_stream_managers_.BeginId();
+       id < input_stream_managers_.EndId(); ++id) {
+    if (drop_policies_.Get(id) !=
+        ImmediateInputStreamHandlerOptions::DROP_OLDEST) {
+      continue;
+    }
+    auto& stream = input_stream_managers_.Get(id);
+    if (stream->QueueSize() > max_queue_sizes_.Get(id)) {
+      num_dropped += stream->ErasePacketsEarlierThan(
+          stream->GetMinTimestampAmongNLatest(max_queue_sizes_.Get(id)));
+    }
+  }
+  CountDropped(num_dropped);
+}
+
+int ImmediateInputStreamHandler::RoomForNewest(CollectionItemId id) {
+  if (drop_policies_.Get(id) !=
+      ImmediateInputStreamHandlerOptions::DROP_NEWEST) {
+    return -1;
+  }
+  // Only this producer adds packets to the stream, so the room can only grow
+  // until the packets are added.
+  int queue_size = input_stream_managers_.Get(id)->QueueSize();
+  return std::max(0, max_queue_sizes_.Get(id) - queue_size);
+}
+
+template <typename Container>
+void ImmediateInputStreamHandler::AddNewestWithin(CollectionItemId id,
+                                                  Container packets, int room) {
+  PacketRingBuffer kept(room);
+  for (int i = 0; i < room; ++i) {
+    kept.push_back(std::move(packets[i]));
+  }
+  Timestamp bound = packets.back().Timestamp().NextAllowedInStream();
+  CountDropped(packets.size() - room);
+  if (!kept.empty()) {
+    InputStreamHandler::MovePackets(id, &kept);
+  }
+  // The dropped packets still advance the timestamp bound, as they would
+  // have if they had been queued and consumed.
+  SetNextTimestampBound(id, bound);
+}
+
+void ImmediateInputStreamHandler::AddPackets(CollectionItemId id,
+                                             const PacketRingBuffer& packets) {
+  int room = RoomForNewest(id);
+  if (room >= 0 && room < packets.size()) {
+    AddNewestWithin<const PacketRingBuffer&>(id, packets, room);
+  } else {
+    InputStreamHandler::AddPackets(id, packets);
+  }
+  if (drop_oldest_) {
+    absl::MutexLock lock(&drop_mutex_);
+    if (!pending_) {
+      DropOldest();
+    }
+  }
+}
+
+void ImmediateInputStreamHandler::MovePackets(CollectionItemId id,
+                                              PacketRingBuffer* packets) {
+  int room = RoomForNewest(id);
+  if (room >= 0 && room < packets->size()) {
+    AddNewestWithin<PacketRingBuffer&>(id, *packets, room);
+    packets->clear();
+  } else {
+    InputStreamHandler::MovePackets(id, packets);
+  }
+  if (drop_oldest_) {
+    absl::MutexLock lock(&drop_mutex_);
+    if (!pending_) {
+      DropOldest();
+    }
+  }
+}
 
 NodeReadiness ImmediateInputStreamHandler::GetNodeReadiness(
     Timestamp* min_stream_timestamp) {
+  if (!drop_oldest_) {
+    return GetReadiness(min_stream_timestamp);
+  }
+  absl::MutexLock lock(&drop_mutex_);
+  if (!pending_) {
+    DropOldest();
+  }
+  NodeReadiness result = GetReadiness(min_stream_timestamp);
+  pending_ = (result == NodeReadiness::kReadyForProcess);
+  return result;
+}
+
+NodeReadiness ImmediateInputStreamHandler::GetReadiness(
+    Timestamp* min_stream_timestamp) {
   *min_stream_timestamp = Timestamp::Done();
   Timestamp input_timestamp = Timestamp::Done();
   bool stream_became_done = false;
@@ -120,6 +327,10 @@ void ImmediateInputStreamHandler::FillInputSet(Timestamp input_timestamp,
       AddPacketToShard(&input_set->Get(id), Packet(), is_done);
     }
   }
+  if (drop_oldest_) {
+    absl::MutexLock lock(&drop_mutex_);
+    pending_ = false;
+  }
 }
 
 }  // namespace mediapipe
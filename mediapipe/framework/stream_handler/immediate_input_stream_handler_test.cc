@@ -13,7 +13,6 @@
 // limitations under the License.
 
 #include <functional>
-#include <list>
 #include <memory>
 #include <vector>
 
@@ -21,10 +20,15 @@
 #include "absl/memory/memory.h"
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/calculator_context_manager.h"
+#include "mediapipe/framework/counter_factory.h"
 #include "mediapipe/framework/input_stream_handler.h"
+#include "mediapipe/framework/mediapipe_options.pb.h"
+#include "mediapipe/framework/packet_ring_buffer.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
 #include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/stream_handler/immediate_input_stream_handler.pb.h"
 #include "mediapipe/framework/tool/tag_map.h"
 #include "mediapipe/framework/tool/tag_map_helper.h"
 
@@ -56,27 +60,29 @@ class ImmediateInputStreamHandlerTest : public ::testing::Test {
         std::bind(&ImmediateInputStreamHandlerTest::ReportQueueNoOp, this,
                   std::placeholders::_1, std::placeholders::_2);
 
-    std::shared_ptr<tool::TagMap> input_tag_map =
+    input_tag_map_ =
         tool::CreateTagMap({"input_a", "input_b", "input_c"}).ValueOrDie();
 
     input_stream_managers_.reset(
-        new InputStreamManager[input_tag_map->NumEntries()]);
-    const std::vector<std::string>& names = input_tag_map->Names();
-    for (CollectionItemId id = input_tag_map->BeginId();
-         id < input_tag_map->EndId(); ++id) {
+        new InputStreamManager[input_tag_map_->NumEntries()]);
+    const std::vector<std::string>& names = input_tag_map_->Names();
+    for (CollectionItemId id = input_tag_map_->BeginId();
+         id < input_tag_map_->EndId(); ++id) {
       const std::string& stream_name = names[id.value()];
       name_to_id_[stream_name] = id;
       MEDIAPIPE_CHECK_OK(input_stream_managers_[id.value()].Initialize(
           stream_name, &packet_type_, /*back_edge=*/false));
     }
-    SetupInputStreamHandler(input_tag_map);
+    SetupInputStreamHandler(input_tag_map_, MediaPipeOptions());
   }
 
   void SetupInputStreamHandler(
-      const std::shared_ptr<tool::TagMap>& input_tag_map) {
+      const std::shared_ptr<tool::TagMap>& input_tag_map,
+      const MediaPipeOptions& options) {
     calculator_state_ = absl::make_unique<CalculatorState>(
         "Node", /*node_id=*/0, "Calculator", CalculatorGraphConfig::Node(),
         nullptr);
+    calculator_state_->SetCounterFactory(&counter_factory_);
     cc_manager_.Initialize(
         calculator_state_.get(), input_tag_map,
         /*output_tag_map=*/tool::CreateTagMap({"output_a"}).ValueOrDie(),
@@ -85,7 +91,7 @@ class ImmediateInputStreamHandlerTest : public ::testing::Test {
     mediapipe::StatusOr<std::unique_ptr<mediapipe::InputStreamHandler>>
         status_or_handler = InputStreamHandlerRegistry::CreateByName(
             "ImmediateInputStreamHandler", input_tag_map, &cc_manager_,
-            MediaPipeOptions(),
+            options,
             /*calculator_run_in_parallel=*/false);
     ASSERT_TRUE(status_or_handler.ok());
     input_stream_handler_ = std::move(status_or_handler.ValueOrDie());
@@ -145,6 +151,8 @@ class ImmediateInputStreamHandlerTest : public ::testing::Test {
   // Vector of errors encountered while using the stream.
   std::vector<::mediapipe::Status> errors_;
 
+  std::shared_ptr<tool::TagMap> input_tag_map_;
+  BasicCounterFactory counter_factory_;
   std::unique_ptr<CalculatorState> calculator_state_;
   CalculatorContextManager cc_manager_;
   CalculatorContext* cc_;
@@ -165,7 +173,7 @@ TEST_F(ImmediateInputStreamHandlerTest, EmptyPacketsNotReady) {
 // input streams has a packet available.
 TEST_F(ImmediateInputStreamHandlerTest, AnyPacketsReady) {
   Timestamp min_stream_timestamp;
-  std::list<Packet> packets;
+  PacketRingBuffer packets;
   packets.push_back(Adopt(new std::string("packet 1")).At(Timestamp(10)));
   input_stream_handler_->AddPackets(name_to_id_["input_a"], packets);
   ASSERT_TRUE(input_stream_handler_->ScheduleInvocations(
@@ -177,7 +185,7 @@ TEST_F(ImmediateInputStreamHandlerTest, AnyPacketsReady) {
 // input streams has become done.
 TEST_F(ImmediateInputStreamHandlerTest, StreamDoneReady) {
   Timestamp min_stream_timestamp;
-  std::list<Packet> packets;
+  PacketRingBuffer packets;
 
   // One packet arrives, ready for process.
   packets.push_back(Adopt(new std::string("packet 1")).At(Timestamp(10)));
@@ -230,7 +238,7 @@ TEST_F(ImmediateInputStreamHandlerTest, StreamDoneReady) {
 // This test checks that when any stream is done, the state is ready to close.
 TEST_F(ImmediateInputStreamHandlerTest, ReadyForClose) {
   Timestamp min_stream_timestamp;
-  std::list<Packet> packets;
+  PacketRingBuffer packets;
   packets.push_back(Adopt(new std::string("packet 1")).At(Timestamp(1)));
   input_stream_handler_->AddPackets(name_to_id_["input_b"], packets);
   input_stream_handler_->SetNextTimestampBound(name_to_id_["input_b"],
@@ -266,7 +274,7 @@ TEST_F(ImmediateInputStreamHandlerTest, ReadyForClose) {
 // stream handler and the associated input streams.
 TEST_F(ImmediateInputStreamHandlerTest, SimulateProcessNode) {
   Timestamp min_stream_timestamp;
-  std::list<Packet> packets;
+  PacketRingBuffer packets;
   packets.push_back(Adopt(new std::string("packet 1")).At(Timestamp(10)));
   packets.push_back(Adopt(new std::string("packet 2")).At(Timestamp(30)));
   packets.push_back(Adopt(new std::string("packet 3")).At(Timestamp(40)));
@@ -339,5 +347,61 @@ TEST_F(ImmediateInputStreamHandlerTest, SimulateProcessNode) {
   EXPECT_TRUE(errors_.empty());
 }
 
+// This test checks that the drop policies bound the input queues: input_a
+// keeps only its latest packet, and input_b keeps only its oldest packet.
+TEST_F(ImmediateInputStreamHandlerTest, DropPolicies) {
+  SetupInputStreamHandler(
+      input_tag_map_, ParseTextProtoOrDie<MediaPipeOptions>(R"(
+        [mediapipe.ImmediateInputStreamHandlerOptions.ext] {
+          queue_policy { tag_index: ":0" drop_policy: DROP_OLDEST }
+          queue_policy { tag_index: ":1" drop_policy: DROP_NEWEST }
+        }
+      )"));
+  Timestamp min_stream_timestamp;
+  PacketRingBuffer packets;
+  packets.push_back(Adopt(new std::string("packet 1")).At(Timestamp(10)));
+  packets.push_back(Adopt(new std::string("packet 2")).At(Timestamp(20)));
+  packets.push_back(Adopt(new std::string("packet 3")).At(Timestamp(30)));
+  input_stream_handler_->AddPackets(name_to_id_["input_a"], packets);
+  input_stream_handler_->AddPackets(name_to_id_["input_b"], packets);
+  input_stream_handler_->AddPackets(name_to_id_["input_c"], packets);
+  EXPECT_EQ(1, input_stream_handler_
+                   ->GetInputStreamManager(name_to_id_["input_a"])
+                   ->QueueSize());
+  EXPECT_EQ(1, input_stream_handler_
+                   ->GetInputStreamManager(name_to_id_["input_b"])
+                   ->QueueSize());
+  EXPECT_EQ(3, input_stream_handler_
+                   ->GetInputStreamManager(name_to_id_["input_c"])
+                   ->QueueSize());
+  EXPECT_EQ(4, counter_factory_.GetCounter("Node-DroppedPackets")->Get());
+
+  ASSERT_TRUE(input_stream_handler_->ScheduleInvocations(
+      /*max_allowance=*/1, &min_stream_timestamp));
+  ExpectPackets(cc_->Inputs(),
+                {{"input_b", "packet 1"}, {"input_c", "packet 1"}});
+  input_stream_handler_->ClearCurrentInputs(cc_);
+
+  // The packets dropped from input_b still advance its timestamp bound.
+  bool empty;
+  EXPECT_EQ(Timestamp(31),
+            input_stream_handler_->GetInputStreamManager(name_to_id_["input_b"])
+                ->MinTimestampOrBound(&empty));
+  EXPECT_TRUE(empty);
+
+  ASSERT_TRUE(input_stream_handler_->ScheduleInvocations(
+      /*max_allowance=*/1, &min_stream_timestamp));
+  ExpectPackets(cc_->Inputs(), {{"input_c", "packet 2"}});
+  input_stream_handler_->ClearCurrentInputs(cc_);
+
+  ASSERT_TRUE(input_stream_handler_->ScheduleInvocations(
+      /*max_allowance=*/1, &min_stream_timestamp));
+  ExpectPackets(cc_->Inputs(),
+                {{"input_a", "packet 3"}, {"input_c", "packet 3"}});
+  input_stream_handler_->ClearCurrentInputs(cc_);
+
+  EXPECT_TRUE(errors_.empty());
+}
+
 }  // namespace
 }  // namespace mediapipe
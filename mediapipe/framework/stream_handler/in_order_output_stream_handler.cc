@@ -14,23 +14,111 @@
 
 #include "mediapipe/framework/stream_handler/in_order_output_stream_handler.h"
 
+#include <algorithm>
+#include <limits>
+
+#include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/collection.h"
 #include "mediapipe/framework/collection_item_id.h"
 #include "mediapipe/framework/output_stream_shard.h"
+#include "mediapipe/framework/port/map_util.h"
 
 namespace mediapipe {
 
 REGISTER_OUTPUT_STREAM_HANDLER(InOrderOutputStreamHandler);
 
+InOrderOutputStreamHandler::InOrderOutputStreamHandler(
+    std::shared_ptr<tool::TagMap> tag_map,
+    CalculatorContextManager* calculator_context_manager,
+    const MediaPipeOptions& options, bool calculator_run_in_parallel)
+    : OutputStreamHandler(std::move(tag_map), calculator_context_manager,
+                          options, calculator_run_in_parallel),
+      max_reorder_depth_(
+          options.GetExtension(InOrderOutputStreamHandlerOptions::ext)
+              .max_reorder_depth()),
+      overflow_policy_(
+          options.GetExtension(InOrderOutputStreamHandlerOptions::ext)
+              .overflow_policy()) {}
+
+int InOrderOutputStreamHandler::MaxNewInvocations() {
+  if (max_reorder_depth_ <= 0 ||
+      overflow_policy_ != InOrderOutputStreamHandlerOptions::BLOCK) {
+    return std::numeric_limits<int>::max();
+  }
+  // With at most max_reorder_depth_ + 1 invocations pending, at most
+  // max_reorder_depth_ completed ones can wait for the earliest.
+  return std::max(0, max_reorder_depth_ + 1 -
+                         calculator_context_manager_->NumActiveContexts());
+}
+
+CalculatorContext* InOrderOutputStreamHandler::GetFrontContext(
+    Timestamp* context_timestamp) {
+  CalculatorContext* default_context =
+      calculator_context_manager_->GetDefaultCalculatorContext();
+  // Drops the outputs of the late invocations that have completed.
+  for (auto iter = late_input_timestamps_.begin();
+       iter != late_input_timestamps_.end();) {
+    if (completed_input_timestamps_.erase(*iter) == 0) {
+      ++iter;
+      continue;
+    }
+    CalculatorContext* late_context =
+        calculator_context_manager_->GetCalculatorContext(*iter);
+    CHECK(late_context);
+    PrepareOutputs(*iter, &late_context->Outputs());
+    calculator_context_manager_->RecycleCalculatorContext(*iter);
+    default_context->GetCounter("Late Invocations Dropped")->Increment();
+    iter = late_input_timestamps_.erase(iter);
+  }
+  if (!calculator_context_manager_->HasActiveContexts()) {
+    return nullptr;
+  }
+
+  CalculatorContext* calculator_context =
+      calculator_context_manager_->GetFrontCalculatorContext(
+          context_timestamp);
+  while (calculator_context &&
+         ::mediapipe::ContainsKey(late_input_timestamps_, *context_timestamp)) {
+    calculator_context = calculator_context_manager_->GetNextCalculatorContext(
+        *context_timestamp, context_timestamp);
+  }
+  // The reorder depth is the number of completed invocations waiting for an
+  // earlier one.
+  int reorder_depth = completed_input_timestamps_.size();
+  if (calculator_context &&
+      ::mediapipe::ContainsKey(completed_input_timestamps_,
+                               *context_timestamp)) {
+    --reorder_depth;
+  }
+  if (reorder_depth > max_reorder_depth_seen_) {
+    default_context->GetCounter("Max Reorder Depth")
+        ->IncrementBy(reorder_depth - max_reorder_depth_seen_);
+    max_reorder_depth_seen_ = reorder_depth;
+  }
+  if (max_reorder_depth_ <= 0 ||
+      overflow_policy_ != InOrderOutputStreamHandlerOptions::DROP_LATE ||
+      reorder_depth <= max_reorder_depth_) {
+    return calculator_context;
+  }
+  // Gives up on the earliest invocations, up to the first completed one,
+  // whose outputs can then be propagated right away.
+  while (calculator_context &&
+         !::mediapipe::ContainsKey(completed_input_timestamps_,
+                                   *context_timestamp)) {
+    late_input_timestamps_.insert(*context_timestamp);
+    calculator_context = calculator_context_manager_->GetNextCalculatorContext(
+        *context_timestamp, context_timestamp);
+  }
+  return calculator_context;
+}
+
 void InOrderOutputStreamHandler::PropagationLoop() {
   CHECK_EQ(propagation_state_, kIdle);
   Timestamp context_timestamp;
-  CalculatorContext* calculator_context;
-  if (!calculator_context_manager_->HasActiveContexts()) {
+  CalculatorContext* calculator_context = GetFrontContext(&context_timestamp);
+  if (!calculator_context) {
     propagation_state_ = kPropagatingBound;
   } else {
-    calculator_context = calculator_context_manager_->GetFrontCalculatorContext(
-        &context_timestamp);
     if (!completed_input_timestamps_.empty()) {
       Timestamp completed_timestamp = *completed_input_timestamps_.begin();
       if (context_timestamp != completed_timestamp) {
@@ -54,31 +142,42 @@ void InOrderOutputStreamHandler::PropagationLoop() {
 void InOrderOutputStreamHandler::PropagatePackets(
     CalculatorContext** calculator_context, Timestamp* context_timestamp) {
   timestamp_mutex_.Unlock();
+  OutputStreamShardSet* output_shards = &(*calculator_context)->Outputs();
+  // The output shards were reset when the context was prepared, possibly
+  // before the outputs of earlier contexts were propagated. Raises their
+  // bounds so that a context without outputs doesn't move the bounds back.
+  for (CollectionItemId id = output_stream_managers_.BeginId();
+       id < output_stream_managers_.EndId(); ++id) {
+    OutputStreamManager* manager = output_stream_managers_.Get(id);
+    OutputStreamShard& shard = output_shards->Get(id);
+    if (!manager->IsClosed() && !shard.IsClosed() &&
+        shard.NextTimestampBound() < manager->NextTimestampBound()) {
+      shard.SetNextTimestampBound(manager->NextTimestampBound());
+    }
+  }
   // Propagates packets without holding timestamp_mutex_.
-  PropagateOutputPackets(*context_timestamp, &(*calculator_context)->Outputs());
-  calculator_context_manager_->RecycleCalculatorContext();
+  PropagateOutputPackets(*context_timestamp, output_shards);
+  calculator_context_manager_->RecycleCalculatorContext(*context_timestamp);
   timestamp_mutex_.Lock();
-  completed_input_timestamps_.erase(completed_input_timestamps_.begin());
-  // The first check is for performance reasons (it's cheaper).
+  completed_input_timestamps_.erase(*context_timestamp);
+  const Timestamp propagated_timestamp = *context_timestamp;
   // Note that completed_input_timestamps_ is a subset of the input
-  // timestamps of the active contexts. Therefore, the second check
-  // covers the first check.
-  if (completed_input_timestamps_.empty() &&
-      !calculator_context_manager_->HasActiveContexts()) {
+  // timestamps of the active contexts. Therefore, if no active context is
+  // left whose outputs are to be propagated, no completed one is left either.
+  *calculator_context = GetFrontContext(context_timestamp);
+  if (!*calculator_context) {
     // If task_timestamp_bound_ is not greater than context_timestamp + 1,
     // timestamp propagation isn't necessary since the bound of the
     // downstream input streams has been updated to a larger value
     // already. Timestamp propagation will be skipped, and the
     // propagation process is completed.
-    if (task_timestamp_bound_ <= context_timestamp->NextAllowedInStream()) {
+    if (task_timestamp_bound_ <= propagated_timestamp.NextAllowedInStream()) {
       propagation_state_ = kIdle;
       return;
     }
     propagation_state_ = kPropagatingBound;
     return;
   }
-  *calculator_context =
-      calculator_context_manager_->GetFrontCalculatorContext(context_timestamp);
   if (!completed_input_timestamps_.empty() &&
       *context_timestamp == *completed_input_timestamps_.begin()) {
     // Continues propagating output packets if the smallest completed
@@ -109,13 +208,14 @@ void InOrderOutputStreamHandler::PropagationBound(
   // task_timestamp_bound_ was updated while the propagation thread was
   // doing timestamp propagation. This thread will redo timestamp
   // propagation for the new task_timestamp_bound_.
-  if (!calculator_context_manager_->HasActiveContexts()) {
-    CHECK_LT(bound_to_propagate, task_timestamp_bound_);
-    propagation_state_ = kPropagatingBound;
+  *calculator_context = GetFrontContext(context_timestamp);
+  if (!*calculator_context) {
+    // Only a late invocation may have completed, without a new bound.
+    propagation_state_ = bound_to_propagate < task_timestamp_bound_
+                             ? kPropagatingBound
+                             : kIdle;
     return;
   }
-  *calculator_context =
-      calculator_context_manager_->GetFrontCalculatorContext(context_timestamp);
   if (completed_input_timestamps_.empty() ||
       *context_timestamp != *completed_input_timestamps_.begin()) {
     // If there is no newly completed invocation or the newly arrived packets
@@ -16,12 +16,14 @@
 #define MEDIAPIPE_FRAMEWORK_STREAM_HANDLER_IN_ORDER_OUTPUT_STREAM_HANDLER_H_
 
 #include <memory>
+#include <set>
 #include <utility>
 
 // TODO: Move protos in another CL after the C++ code migration.
 #include "mediapipe/framework/mediapipe_options.pb.h"
 #include "mediapipe/framework/output_stream_handler.h"
 #include "mediapipe/framework/packet_set.h"
+#include "mediapipe/framework/stream_handler/in_order_output_stream_handler.pb.h"
 #include "mediapipe/framework/timestamp.h"
 #include "mediapipe/framework/tool/tag_map.h"
 
@@ -30,14 +32,45 @@ namespace mediapipe {
 // InOrderOutputStreamHandler supports both sequential and parallel processing
 // of input packets, and will deliver the output packets in increasing timestamp
 // order.
+//
+// With parallel processing, the outputs of an invocation wait until every
+// earlier invocation has completed, so one slow invocation holds back the
+// outputs of all later ones. InOrderOutputStreamHandlerOptions can bound the
+// reorder depth, the number of completed invocations whose outputs wait for
+// an earlier one. When the bound is reached, the BLOCK policy starts no new
+// invocation until the earliest one completes, which also limits the node to
+// max_reorder_depth + 1 invocations in flight. The DROP_LATE policy instead
+// gives up on the earliest invocation: the outputs waiting for it are
+// delivered, and its own outputs are dropped when it completes.
+//
+// The highest reorder depth reached is reported in the "Max Reorder Depth"
+// counter of the node, and the invocations given up on in the "Late
+// Invocations Dropped" counter.
+//
+// Example config:
+//   node {
+//     calculator: "SlowCalculator"
+//     input_stream: "input"
+//     output_stream: "output"
+//     max_in_flight: 8
+//     output_stream_handler {
+//       output_stream_handler: "InOrderOutputStreamHandler"
+//       options {
+//         [mediapipe.InOrderOutputStreamHandlerOptions.ext] {
+//           max_reorder_depth: 4
+//           overflow_policy: DROP_LATE
+//         }
+//       }
+//     }
+//   }
 class InOrderOutputStreamHandler : public OutputStreamHandler {
  public:
   InOrderOutputStreamHandler(
       std::shared_ptr<tool::TagMap> tag_map,
       CalculatorContextManager* calculator_context_manager,
-      const MediaPipeOptions& options, bool calculator_run_in_parallel)
-      : OutputStreamHandler(std::move(tag_map), calculator_context_manager,
-                            options, calculator_run_in_parallel) {}
+      const MediaPipeOptions& options, bool calculator_run_in_parallel);
+
+  int MaxNewInvocations() override;
 
  private:
   void PropagationLoop() EXCLUSIVE_LOCKS_REQUIRED(timestamp_mutex_) final;
@@ -49,6 +82,22 @@ class InOrderOutputStreamHandler : public OutputStreamHandler {
   void PropagationBound(CalculatorContext** calculator_context,
                         Timestamp* context_timestamp)
       EXCLUSIVE_LOCKS_REQUIRED(timestamp_mutex_);
+
+  // Returns the active calculator context with the smallest input timestamp
+  // whose outputs are not dropped, or nullptr if there is none. Before that,
+  // drops the outputs of the completed invocations given up on, updates the
+  // reorder depth counter, and with DROP_LATE gives up on the earliest
+  // invocations while the reorder depth exceeds max_reorder_depth_.
+  CalculatorContext* GetFrontContext(Timestamp* context_timestamp)
+      EXCLUSIVE_LOCKS_REQUIRED(timestamp_mutex_);
+
+  const int max_reorder_depth_;
+  const InOrderOutputStreamHandlerOptions::OverflowPolicy overflow_policy_;
+  // The highest reorder depth reported so far.
+  int max_reorder_depth_seen_ GUARDED_BY(timestamp_mutex_) = 0;
+  // The input timestamps of the invocations given up on by DROP_LATE that
+  // have not completed yet.
+  std::set<Timestamp> late_input_timestamps_ GUARDED_BY(timestamp_mutex_);
 };
 }  // namespace mediapipe
 
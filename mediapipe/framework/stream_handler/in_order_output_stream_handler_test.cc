@@ -0,0 +1,161 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/stream_handler/in_order_output_stream_handler.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "absl/strings/substitute.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+
+typedef std::function<::mediapipe::Status(const InputStreamShardSet&,
+                                          OutputStreamShardSet*)>
+    ProcessFunction;
+
+// Runs a node with 4 invocations in flight, whose invocation for timestamp 1
+// blocks until released.
+class InOrderOutputStreamHandlerTest : public ::testing::Test {
+ protected:
+  void StartGraph(const std::string& handler_options) {
+    ProcessFunction process = [this](const InputStreamShardSet& inputs,
+                                     OutputStreamShardSet* outputs) {
+      const Packet& packet = inputs.Index(0).Value();
+      {
+        absl::MutexLock lock(&mutex_);
+        started_.push_back(packet.Timestamp().Value());
+      }
+      if (packet.Timestamp() == Timestamp(1)) {
+        release_.WaitForNotification();
+      }
+      outputs->Index(0).AddPacket(packet);
+      return ::mediapipe::OkStatus();
+    };
+    const std::string config_text = absl::Substitute(R"(
+          input_stream: "input"
+          num_threads: 4
+          node {
+            name: "slow"
+            calculator: "LambdaCalculator"
+            input_side_packet: "process"
+            input_stream: "input"
+            output_stream: "output"
+            max_in_flight: 4
+            output_stream_handler {
+              output_stream_handler: "InOrderOutputStreamHandler"
+              options {
+                [mediapipe.InOrderOutputStreamHandlerOptions.ext] { $0 }
+              }
+            }
+          })",
+                                                     handler_options);
+    MP_ASSERT_OK(graph_.Initialize(
+        ParseTextProtoOrDie<CalculatorGraphConfig>(config_text),
+        {{"process", MakePacket<ProcessFunction>(process)}}));
+    MP_ASSERT_OK(graph_.ObserveOutputStream("output", [this](const Packet& p) {
+      absl::MutexLock lock(&mutex_);
+      outputs_.push_back(p.Timestamp().Value());
+      return ::mediapipe::OkStatus();
+    }));
+    MP_ASSERT_OK(graph_.StartRun({}));
+  }
+
+  void AddPackets(int count) {
+    for (int i = 1; i <= count; ++i) {
+      MP_ASSERT_OK(graph_.AddPacketToInputStream(
+          "input", MakePacket<int>(i).At(Timestamp(i))));
+    }
+  }
+
+  int64 GetCounter(const std::string& name) {
+    return graph_.GetCounterFactory()->GetCounter("slow-" + name)->Get();
+  }
+
+  CalculatorGraph graph_;
+  absl::Notification release_;
+  absl::Mutex mutex_;
+  std::vector<int64> started_ GUARDED_BY(mutex_);
+  std::vector<int64> outputs_ GUARDED_BY(mutex_);
+};
+
+TEST_F(InOrderOutputStreamHandlerTest, BlocksNewInvocationsWhenWindowIsFull) {
+  StartGraph("max_reorder_depth: 1 overflow_policy: BLOCK");
+  AddPackets(4);
+  // Only one invocation may complete while the one for timestamp 1 blocks.
+  absl::SleepFor(absl::Milliseconds(100));
+  {
+    absl::MutexLock lock(&mutex_);
+    EXPECT_THAT(started_, ElementsAre(1, 2));
+    EXPECT_TRUE(outputs_.empty());
+  }
+  release_.Notify();
+  MP_ASSERT_OK(graph_.CloseAllInputStreams());
+  MP_ASSERT_OK(graph_.WaitUntilDone());
+  absl::MutexLock lock(&mutex_);
+  EXPECT_THAT(outputs_, ElementsAre(1, 2, 3, 4));
+  EXPECT_EQ(GetCounter("Max Reorder Depth"), 1);
+}
+
+TEST_F(InOrderOutputStreamHandlerTest, DropsLateInvocationWhenWindowIsFull) {
+  StartGraph("max_reorder_depth: 1 overflow_policy: DROP_LATE");
+  AddPackets(3);
+  // The outputs for timestamps 2 and 3 do not wait for timestamp 1.
+  {
+    absl::MutexLock lock(&mutex_);
+    mutex_.Await(absl::Condition(
+        +[](std::vector<int64>* outputs) { return outputs->size() == 2; },
+        &outputs_));
+    EXPECT_THAT(outputs_, ElementsAre(2, 3));
+  }
+  release_.Notify();
+  MP_ASSERT_OK(graph_.CloseAllInputStreams());
+  MP_ASSERT_OK(graph_.WaitUntilDone());
+  absl::MutexLock lock(&mutex_);
+  EXPECT_THAT(outputs_, ElementsAre(2, 3));
+  EXPECT_EQ(GetCounter("Late Invocations Dropped"), 1);
+  EXPECT_EQ(GetCounter("Max Reorder Depth"), 2);
+}
+
+TEST_F(InOrderOutputStreamHandlerTest, BuffersWithoutLimitByDefault) {
+  StartGraph("");
+  AddPackets(4);
+  {
+    absl::MutexLock lock(&mutex_);
+    mutex_.Await(absl::Condition(
+        +[](std::vector<int64>* started) { return started->size() == 4; },
+        &started_));
+  }
+  release_.Notify();
+  MP_ASSERT_OK(graph_.CloseAllInputStreams());
+  MP_ASSERT_OK(graph_.WaitUntilDone());
+  absl::MutexLock lock(&mutex_);
+  EXPECT_THAT(outputs_, ElementsAre(1, 2, 3, 4));
+}
+
+}  // namespace
+}  // namespace mediapipe
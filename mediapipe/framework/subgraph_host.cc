@@ -0,0 +1,167 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/subgraph_host.h"
+
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/port/canonical_errors.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/thread_pool_executor.h"
+#include "mediapipe/framework/tool/validate_name.h"
+#include "mediapipe/util/cpu_util.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Returns the stream or side packet name of a "TAG:index:name" field.
+::mediapipe::StatusOr<std::string> ParseName(const std::string& field) {
+  std::string tag;
+  int index;
+  std::string name;
+  MP_RETURN_IF_ERROR(tool::ParseTagIndexName(field, &tag, &index, &name));
+  return name;
+}
+
+}  // namespace
+
+SubgraphHost::~SubgraphHost() {
+  absl::MutexLock lock(&mutex_);
+  for (auto& instance : instances_) {
+    if (instance.second) {
+      instance.second->Cancel();
+      instance.second->WaitUntilDone().IgnoreError();
+    }
+  }
+}
+
+::mediapipe::Status SubgraphHost::SetExecutor(
+    const std::string& name, std::shared_ptr<Executor> executor) {
+  absl::MutexLock lock(&mutex_);
+  RET_CHECK(!started_) << "SetExecutor() must be called before AddInstance().";
+  RET_CHECK(executor);
+  executors_[name] = std::move(executor);
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status SubgraphHost::SetServicePacket(
+    const GraphServiceBase& service, Packet packet) {
+  absl::MutexLock lock(&mutex_);
+  RET_CHECK(!started_)
+      << "SetServiceObject() must be called before AddInstance().";
+  service_packets_.push_back({&service, std::move(packet)});
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::StatusOr<CalculatorGraph*> SubgraphHost::AddInstance(
+    const std::string& instance_name, const CalculatorGraphConfig::Node& node,
+    OutputCallback callback,
+    const std::map<std::string, Packet>& side_packets) {
+  RET_CHECK(callback);
+  std::map<std::string, std::shared_ptr<Executor>> executors;
+  std::vector<ServicePacket> service_packets;
+  {
+    absl::MutexLock lock(&mutex_);
+    if (instances_.count(instance_name)) {
+      return ::mediapipe::AlreadyExistsError(
+          "SubgraphHost already has an instance named \"" + instance_name +
+          "\".");
+    }
+    if (!executors_.count("")) {
+      executors_[""] =
+          std::make_shared<ThreadPoolExecutor>(::mediapipe::NumCPUCores());
+    }
+    started_ = true;
+    executors = executors_;
+    service_packets = service_packets_;
+    // Reserves the name while the instance is started outside the lock.
+    instances_[instance_name] = nullptr;
+  }
+
+  auto graph = absl::make_unique<CalculatorGraph>();
+  ::mediapipe::Status status = [&]() -> ::mediapipe::Status {
+    CalculatorGraphConfig config;
+    for (const std::string& field : node.input_stream()) {
+      ASSIGN_OR_RETURN(std::string name, ParseName(field));
+      config.add_input_stream(name);
+    }
+    *config.add_node() = node;
+    for (const auto& executor : executors) {
+      if (!executor.first.empty()) {
+        config.add_executor()->set_name(executor.first);
+      }
+      MP_RETURN_IF_ERROR(graph->SetExecutor(executor.first, executor.second));
+    }
+    for (const ServicePacket& service_packet : service_packets) {
+      MP_RETURN_IF_ERROR(graph->SetServicePacket(*service_packet.service,
+                                                 service_packet.packet));
+    }
+    MP_RETURN_IF_ERROR(graph->Initialize(config));
+    for (const std::string& field : node.output_stream()) {
+      ASSIGN_OR_RETURN(std::string name, ParseName(field));
+      MP_RETURN_IF_ERROR(graph->ObserveOutputStream(
+          name, [callback, name](const Packet& packet) {
+            return callback(name, packet);
+          }));
+    }
+    std::map<std::string, Packet> run_side_packets = side_packets;
+    run_side_packets.insert(side_packets_.begin(), side_packets_.end());
+    return graph->StartRun(run_side_packets);
+  }();
+
+  absl::MutexLock lock(&mutex_);
+  if (!status.ok()) {
+    instances_.erase(instance_name);
+    return status;
+  }
+  CalculatorGraph* result = graph.get();
+  instances_[instance_name] = std::move(graph);
+  return result;
+}
+
+::mediapipe::Status SubgraphHost::RemoveInstance(
+    const std::string& instance_name) {
+  std::unique_ptr<CalculatorGraph> graph;
+  {
+    absl::MutexLock lock(&mutex_);
+    auto iter = instances_.find(instance_name);
+    if (iter == instances_.end()) {
+      return ::mediapipe::NotFoundError(
+          "SubgraphHost has no instance named \"" + instance_name + "\".");
+    }
+    RET_CHECK(iter->second)
+        << "Instance \"" << instance_name << "\" is still being added.";
+    graph = std::move(iter->second);
+    instances_.erase(iter);
+  }
+  ::mediapipe::Status status = graph->CloseAllInputStreams();
+  status.Update(graph->WaitUntilDone());
+  return status;
+}
+
+std::vector<std::string> SubgraphHost::InstanceNames() const {
+  absl::MutexLock lock(&mutex_);
+  std::vector<std::string> names;
+  for (const auto& instance : instances_) {
+    if (instance.second) {
+      names.push_back(instance.first);
+    }
+  }
+  return names;
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,130 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_SUBGRAPH_HOST_H_
+#define MEDIAPIPE_FRAMEWORK_SUBGRAPH_HOST_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/calculator_graph.h"
+#include "mediapipe/framework/executor.h"
+#include "mediapipe/framework/graph_service.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+
+namespace mediapipe {
+
+// Runs instances of registered subgraphs that are added and removed while the
+// application keeps running, e.g. one instance per camera of a multi-camera
+// server.  Every instance runs on the executors, service objects and side
+// packets of the host, so the shared state (the thread pools, a
+// TfLiteInferenceService holding the models) stays up while instances come
+// and go, and adding an instance only opens the calculators of that instance.
+//
+// An instance is described by a node whose calculator is usually a subgraph
+// registered with REGISTER_MEDIAPIPE_GRAPH.  The input streams of the node
+// become graph input streams of the instance, and the packets of its output
+// streams are sent to the callback passed to AddInstance().  Example:
+//
+//   SubgraphHost host({{"model_path", model_path_packet}});
+//   MP_RETURN_IF_ERROR(host.SetServiceObject(kTfLiteInferenceService,
+//                                            inference_service));
+//   CalculatorGraphConfig::Node node;
+//   node.set_calculator("FaceDetectionSubgraph");
+//   node.add_input_stream("IMAGE:frames");
+//   node.add_output_stream("DETECTIONS:detections");
+//   ASSIGN_OR_RETURN(CalculatorGraph* graph,
+//                    host.AddInstance("camera_1", node, callback));
+//   MP_RETURN_IF_ERROR(graph->AddPacketToInputStream("frames", packet));
+//   ...
+//   MP_RETURN_IF_ERROR(host.RemoveInstance("camera_1"));
+//
+// All the methods are thread-safe.
+class SubgraphHost {
+ public:
+  using OutputCallback = std::function<::mediapipe::Status(
+      const std::string& stream_name, const Packet& packet)>;
+
+  // "side_packets" are passed to every instance.
+  explicit SubgraphHost(const std::map<std::string, Packet>& side_packets = {})
+      : side_packets_(side_packets) {}
+
+  // Cancels and waits for the runs of all the remaining instances.
+  ~SubgraphHost();
+
+  // Sets the executor that runs the nodes assigned to the executor named
+  // "name" in every instance.  If "name" is empty, this sets the default
+  // executor; without one, the host creates a thread pool with a thread per
+  // CPU core for its instances.  Must be called before the first instance is
+  // added.
+  ::mediapipe::Status SetExecutor(const std::string& name,
+                                  std::shared_ptr<Executor> executor)
+      LOCKS_EXCLUDED(mutex_);
+
+  // Provides "object" as "service" to every instance.  Must be called before
+  // the first instance is added.
+  template <typename T>
+  ::mediapipe::Status SetServiceObject(const GraphService<T>& service,
+                                       std::shared_ptr<T> object) {
+    return SetServicePacket(service,
+                            MakePacket<std::shared_ptr<T>>(std::move(object)));
+  }
+  ::mediapipe::Status SetServicePacket(const GraphServiceBase& service,
+                                       Packet packet) LOCKS_EXCLUDED(mutex_);
+
+  // Initializes and starts an instance named "instance_name" running "node",
+  // with the host's side packets and "side_packets", which take precedence.
+  // Returns the graph of the instance, which stays valid until the instance
+  // is removed.
+  ::mediapipe::StatusOr<CalculatorGraph*> AddInstance(
+      const std::string& instance_name, const CalculatorGraphConfig::Node& node,
+      OutputCallback callback,
+      const std::map<std::string, Packet>& side_packets = {})
+      LOCKS_EXCLUDED(mutex_);
+
+  // Closes the graph input streams of the instance, waits until its run is
+  // done and destroys it.  Returns the status of the run.
+  ::mediapipe::Status RemoveInstance(const std::string& instance_name)
+      LOCKS_EXCLUDED(mutex_);
+
+  // Returns the names of the instances, in alphabetical order.
+  std::vector<std::string> InstanceNames() const LOCKS_EXCLUDED(mutex_);
+
+ private:
+  struct ServicePacket {
+    const GraphServiceBase* service;
+    Packet packet;
+  };
+
+  const std::map<std::string, Packet> side_packets_;
+  mutable absl::Mutex mutex_;
+  std::map<std::string, std::shared_ptr<Executor>> executors_
+      GUARDED_BY(mutex_);
+  std::vector<ServicePacket> service_packets_ GUARDED_BY(mutex_);
+  // Set once the first instance is added.
+  bool started_ GUARDED_BY(mutex_) = false;
+  std::map<std::string, std::unique_ptr<CalculatorGraph>> instances_
+      GUARDED_BY(mutex_);
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_SUBGRAPH_HOST_H_
@@ -0,0 +1,181 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/subgraph_host.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/subgraph.h"
+#include "mediapipe/framework/thread_pool_executor.h"
+
+namespace mediapipe {
+namespace {
+
+class PassThroughSubgraph : public Subgraph {
+ public:
+  ::mediapipe::StatusOr<CalculatorGraphConfig> GetConfig(
+      const SubgraphOptions& options) override {
+    return ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+      input_stream: "IN:in"
+      output_stream: "OUT:out"
+      node {
+        calculator: "PassThroughCalculator"
+        input_stream: "in"
+        output_stream: "middle"
+      }
+      node {
+        calculator: "PassThroughCalculator"
+        input_stream: "middle"
+        output_stream: "out"
+      }
+    )");
+  }
+};
+REGISTER_MEDIAPIPE_GRAPH(PassThroughSubgraph);
+
+// Collects the values an instance outputs.
+class Outputs {
+ public:
+  SubgraphHost::OutputCallback Callback() {
+    return [this](const std::string& stream_name, const Packet& packet) {
+      EXPECT_EQ("output", stream_name);
+      absl::MutexLock lock(&mutex_);
+      values_.push_back(packet.Get<int>());
+      return ::mediapipe::OkStatus();
+    };
+  }
+
+  std::vector<int> values() {
+    absl::MutexLock lock(&mutex_);
+    return values_;
+  }
+
+ private:
+  absl::Mutex mutex_;
+  std::vector<int> values_;
+};
+
+// An executor that counts the tasks it runs.
+class CountingExecutor : public Executor {
+ public:
+  void Schedule(std::function<void()> task) override {
+    ++num_tasks_;
+    thread_pool_.Schedule(std::move(task));
+  }
+
+  int num_tasks() const { return num_tasks_; }
+
+ private:
+  ThreadPoolExecutor thread_pool_{2};
+  std::atomic<int> num_tasks_{0};
+};
+
+CalculatorGraphConfig::Node PassThroughNode() {
+  return ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+    calculator: "PassThroughSubgraph"
+    input_stream: "IN:input"
+    output_stream: "OUT:output"
+  )");
+}
+
+void AddValues(CalculatorGraph* graph, int first, int last) {
+  for (int i = first; i <= last; ++i) {
+    MP_EXPECT_OK(graph->AddPacketToInputStream(
+        "input", MakePacket<int>(i).At(Timestamp(i))));
+  }
+}
+
+TEST(SubgraphHostTest, AddsAndRemovesInstancesWhileOthersRun) {
+  SubgraphHost host;
+  Outputs a_outputs;
+  Outputs b_outputs;
+  Outputs c_outputs;
+  auto a_or = host.AddInstance("a", PassThroughNode(), a_outputs.Callback());
+  auto b_or = host.AddInstance("b", PassThroughNode(), b_outputs.Callback());
+  MP_ASSERT_OK(a_or.status());
+  MP_ASSERT_OK(b_or.status());
+  EXPECT_THAT(host.InstanceNames(), testing::ElementsAre("a", "b"));
+
+  AddValues(a_or.ValueOrDie(), 1, 2);
+  AddValues(b_or.ValueOrDie(), 10, 11);
+  MP_ASSERT_OK(host.RemoveInstance("a"));
+  EXPECT_THAT(a_outputs.values(), testing::ElementsAre(1, 2));
+
+  // "b" keeps running, and a new instance starts next to it.
+  auto c_or = host.AddInstance("c", PassThroughNode(), c_outputs.Callback());
+  MP_ASSERT_OK(c_or.status());
+  EXPECT_THAT(host.InstanceNames(), testing::ElementsAre("b", "c"));
+  AddValues(b_or.ValueOrDie(), 12, 12);
+  AddValues(c_or.ValueOrDie(), 20, 20);
+  MP_ASSERT_OK(host.RemoveInstance("b"));
+  MP_ASSERT_OK(host.RemoveInstance("c"));
+  EXPECT_THAT(b_outputs.values(), testing::ElementsAre(10, 11, 12));
+  EXPECT_THAT(c_outputs.values(), testing::ElementsAre(20));
+  EXPECT_TRUE(host.InstanceNames().empty());
+}
+
+TEST(SubgraphHostTest, InstancesShareExecutor) {
+  SubgraphHost host;
+  auto executor = std::make_shared<CountingExecutor>();
+  MP_ASSERT_OK(host.SetExecutor("", executor));
+  Outputs a_outputs;
+  Outputs b_outputs;
+  auto a_or = host.AddInstance("a", PassThroughNode(), a_outputs.Callback());
+  auto b_or = host.AddInstance("b", PassThroughNode(), b_outputs.Callback());
+  MP_ASSERT_OK(a_or.status());
+  MP_ASSERT_OK(b_or.status());
+  // Executors cannot change once instances run on them.
+  EXPECT_FALSE(
+      host.SetExecutor("", std::make_shared<CountingExecutor>()).ok());
+
+  AddValues(a_or.ValueOrDie(), 1, 3);
+  MP_ASSERT_OK(host.RemoveInstance("a"));
+  const int a_tasks = executor->num_tasks();
+  EXPECT_GT(a_tasks, 0);
+  AddValues(b_or.ValueOrDie(), 1, 3);
+  MP_ASSERT_OK(host.RemoveInstance("b"));
+  EXPECT_GT(executor->num_tasks(), a_tasks);
+  EXPECT_THAT(b_outputs.values(), testing::ElementsAre(1, 2, 3));
+}
+
+TEST(SubgraphHostTest, RejectsDuplicateAndUnknownInstances) {
+  SubgraphHost host;
+  Outputs outputs;
+  MP_ASSERT_OK(
+      host.AddInstance("a", PassThroughNode(), outputs.Callback()).status());
+  EXPECT_EQ(::mediapipe::StatusCode::kAlreadyExists,
+            host.AddInstance("a", PassThroughNode(), outputs.Callback())
+                .status()
+                .code());
+  EXPECT_EQ(::mediapipe::StatusCode::kNotFound,
+            host.RemoveInstance("b").code());
+
+  // A node that fails to initialize does not leave an instance behind.
+  CalculatorGraphConfig::Node unknown_node;
+  unknown_node.set_calculator("NoSuchSubgraph");
+  EXPECT_FALSE(host.AddInstance("b", unknown_node, outputs.Callback()).ok());
+  EXPECT_THAT(host.InstanceNames(), testing::ElementsAre("a"));
+}
+
+}  // namespace
+}  // namespace mediapipe
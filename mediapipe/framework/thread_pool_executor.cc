@@ -14,6 +14,7 @@
 
 #include "mediapipe/framework/thread_pool_executor.h"
 
+#include <set>
 #include <utility>
 
 #include "mediapipe/framework/port/canonical_errors.h"
@@ -27,6 +28,11 @@ namespace mediapipe {
 // static
 ::mediapipe::StatusOr<Executor*> ThreadPoolExecutor::Create(
     const MediaPipeOptions& extendable_options) {
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+  return ::mediapipe::UnimplementedError(
+      "ThreadPoolExecutor requires a WebAssembly build with pthreads "
+      "(--config=wasm).");
+#endif  // __EMSCRIPTEN__ && !__EMSCRIPTEN_PTHREADS__
   auto& options =
       extendable_options.GetExtension(ThreadPoolExecutorOptions::ext);
   if (!options.has_num_threads()) {
@@ -59,19 +65,56 @@ namespace mediapipe {
   if (options.has_thread_name_prefix()) {
     thread_options.set_name_prefix(options.thread_name_prefix());
   }
-#if defined(__linux__)
-  switch (options.require_processor_performance()) {
-    case ThreadPoolExecutorOptions::LOW:
-      thread_options.set_cpu_set(InferLowerCoreIds());
-      break;
-    case ThreadPoolExecutorOptions::HIGH:
-      thread_options.set_cpu_set(InferHigherCoreIds());
-      break;
-    default:
-      break;
+  if (options.has_realtime_priority()) {
+    if (options.realtime_priority() < 0) {
+      return ::mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "The realtime_priority field in ThreadPoolExecutorOptions "
+                "should not be negative but is "
+             << options.realtime_priority();
+    }
+    thread_options.set_realtime_priority(options.realtime_priority());
   }
+  if (options.cpu_ids_size() > 0 && options.has_numa_node()) {
+    return ::mediapipe::InvalidArgumentError(
+        "The cpu_ids and numa_node fields in ThreadPoolExecutorOptions must "
+        "not both be specified.");
+  }
+  if (options.cpu_ids_size() > 0) {
+    std::set<int> cpu_ids;
+    for (int cpu : options.cpu_ids()) {
+      if (cpu < 0) {
+        return ::mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+               << "The cpu_ids field in ThreadPoolExecutorOptions should only "
+                  "contain non-negative values but contains "
+               << cpu;
+      }
+      cpu_ids.insert(cpu);
+    }
+    thread_options.set_cpu_set(cpu_ids);
+  } else if (options.has_numa_node()) {
+    std::set<int> cpu_ids = GetNumaNodeCoreIds(options.numa_node());
+    if (cpu_ids.empty()) {
+      return ::mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "No CPUs found for the numa_node " << options.numa_node()
+             << " in ThreadPoolExecutorOptions.";
+    }
+    thread_options.set_cpu_set(cpu_ids);
+  } else {
+#if defined(__linux__)
+    switch (options.require_processor_performance()) {
+      case ThreadPoolExecutorOptions::LOW:
+        thread_options.set_cpu_set(InferLowerCoreIds());
+        break;
+      case ThreadPoolExecutorOptions::HIGH:
+        thread_options.set_cpu_set(InferHigherCoreIds());
+        break;
+      default:
+        break;
+    }
 #endif
-  return new ThreadPoolExecutor(thread_options, options.num_threads());
+  }
+  return new ThreadPoolExecutor(thread_options, options.num_threads(),
+                                options.enable_work_stealing());
 }
 
 ThreadPoolExecutor::ThreadPoolExecutor(int num_threads)
@@ -80,12 +123,15 @@ ThreadPoolExecutor::ThreadPoolExecutor(int num_threads)
 }
 
 ThreadPoolExecutor::ThreadPoolExecutor(const ThreadOptions& thread_options,
-                                       int num_threads)
+                                       int num_threads, bool work_stealing)
     : thread_pool_(thread_options,
                    thread_options.name_prefix().empty()
                        ? "mediapipe"
                        : thread_options.name_prefix(),
                    num_threads) {
+  if (work_stealing) {
+    thread_pool_.EnableWorkStealing();
+  }
   Start();
 }
 
@@ -101,7 +147,8 @@ void ThreadPoolExecutor::Start() {
   stack_size_ = thread_pool_.thread_options().stack_size();
   thread_pool_.StartWorkers();
   VLOG(2) << "Started thread pool with " << thread_pool_.num_threads()
-          << " threads.";
+          << " threads"
+          << (thread_pool_.work_stealing() ? " using work stealing." : ".");
 }
 
 REGISTER_EXECUTOR(ThreadPoolExecutor);
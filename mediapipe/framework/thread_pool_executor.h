@@ -36,9 +36,12 @@ class ThreadPoolExecutor : public Executor {
   int num_threads() const { return thread_pool_.num_threads(); }
   // Returns the thread stack size (in bytes).
   size_t stack_size() const { return stack_size_; }
+  // Returns true if the thread pool uses per-thread work stealing queues.
+  bool work_stealing() const { return thread_pool_.work_stealing(); }
 
  private:
-  ThreadPoolExecutor(const ThreadOptions& thread_options, int num_threads);
+  ThreadPoolExecutor(const ThreadOptions& thread_options, int num_threads,
+                     bool work_stealing);
 
   // Saves the value of the stack size option and starts the thread pool.
   void Start();
@@ -0,0 +1,118 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "mediapipe/framework/tool/calculator_fusion.h"
+
+#include <map>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mediapipe/framework/tool/validate_name.h"
+
+namespace mediapipe {
+namespace tool {
+
+namespace {
+
+// Returns the name of the stream in "tag_index_name".
+::mediapipe::StatusOr<std::string> StreamName(
+    const std::string& tag_index_name) {
+  std::string tag;
+  int index;
+  std::string name;
+  MP_RETURN_IF_ERROR(ParseTagIndexName(tag_index_name, &tag, &index, &name));
+  return name;
+}
+
+// Fuses one pair of nodes of "config", and sets "fused" to whether any were.
+::mediapipe::Status FuseOnePair(CalculatorGraphConfig* config, bool* fused) {
+  *fused = false;
+  auto* nodes = config->mutable_node();
+
+  // Graph output streams are counted as readers, so that they are kept.
+  std::map<std::string, int> num_readers;
+  for (const auto& node : *nodes) {
+    for (const auto& input_stream : node.input_stream()) {
+      ASSIGN_OR_RETURN(std::string name, StreamName(input_stream));
+      ++num_readers[name];
+    }
+  }
+  for (const auto& output_stream : config->output_stream()) {
+    ASSIGN_OR_RETURN(std::string name, StreamName(output_stream));
+    ++num_readers[name];
+  }
+
+  std::map<std::string, int> producers;
+  for (int i = 0; i < nodes->size(); ++i) {
+    const auto& node = nodes->Get(i);
+    if (node.output_stream_size() == 1 && node.output_side_packet_size() == 0) {
+      ASSIGN_OR_RETURN(std::string name, StreamName(node.output_stream(0)));
+      producers[name] = i;
+    }
+  }
+
+  for (int consumer = 0; consumer < nodes->size(); ++consumer) {
+    for (const auto& input_stream : nodes->Get(consumer).input_stream()) {
+      ASSIGN_OR_RETURN(std::string name, StreamName(input_stream));
+      auto iter = producers.find(name);
+      if (iter == producers.end() || num_readers[name] != 1) {
+        continue;
+      }
+      const int producer = iter->second;
+      const auto& producer_node = nodes->Get(producer);
+      const auto& consumer_node = nodes->Get(consumer);
+      const std::string fusion = CalculatorFusionName(
+          producer_node.calculator(), consumer_node.calculator());
+      if (producer == consumer ||
+          producer_node.executor() != consumer_node.executor() ||
+          !CalculatorFusionRegistry::IsRegistered(fusion)) {
+        continue;
+      }
+      CalculatorGraphConfig::Node fused_node;
+      ASSIGN_OR_RETURN(bool is_fused,
+                       CalculatorFusionRegistry::CreateByName(
+                           fusion, producer_node, consumer_node, &fused_node));
+      if (!is_fused) {
+        continue;
+      }
+      VLOG(1) << "Fused " << producer_node.calculator() << " into "
+              << consumer_node.calculator();
+      nodes->Mutable(consumer)->Swap(&fused_node);
+      nodes->DeleteSubrange(producer, 1);
+      *fused = true;
+      return ::mediapipe::OkStatus();
+    }
+  }
+  return ::mediapipe::OkStatus();
+}
+
+}  // namespace
+
+std::string CalculatorFusionName(const std::string& producer_calculator,
+                                 const std::string& consumer_calculator) {
+  return absl::StrCat(producer_calculator, "_", consumer_calculator);
+}
+
+::mediapipe::Status FuseCalculators(CalculatorGraphConfig* config) {
+  bool fused = true;
+  while (fused) {
+    MP_RETURN_IF_ERROR(FuseOnePair(config, &fused));
+  }
+  return ::mediapipe::OkStatus();
+}
+
+}  // namespace tool
+}  // namespace mediapipe
@@ -0,0 +1,66 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef MEDIAPIPE_FRAMEWORK_TOOL_CALCULATOR_FUSION_H_
+#define MEDIAPIPE_FRAMEWORK_TOOL_CALCULATOR_FUSION_H_
+
+#include <string>
+
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/deps/registration.h"
+#include "mediapipe/framework/port/status.h"
+
+namespace mediapipe {
+namespace tool {
+
+// Fuses a "producer" node into the "consumer" node reading its only output
+// stream.  Sets "fused" to a single node computing the outputs of "consumer"
+// from the inputs of both nodes, and returns true, or returns false if these
+// particular nodes cannot be fused, e.g. because of their options.
+using CalculatorFusionRegistry =
+    GlobalFactoryRegistry<bool, const CalculatorGraphConfig::Node&,
+                          const CalculatorGraphConfig::Node&,
+                          CalculatorGraphConfig::Node*>;
+
+// Returns the name under which the fusion of "producer_calculator" into
+// "consumer_calculator" is registered.
+std::string CalculatorFusionName(const std::string& producer_calculator,
+                                 const std::string& consumer_calculator);
+
+// Replaces adjacent nodes of "config" by fused nodes, using the fusions
+// registered with REGISTER_CALCULATOR_FUSION, until no more nodes can be
+// fused.  A producer is only fused if it has a single output stream, no output
+// side packet and the same executor as its consumer, and if its output stream
+// is read by the consumer only and is not a graph output stream.
+::mediapipe::Status FuseCalculators(CalculatorGraphConfig* config);
+
+}  // namespace tool
+}  // namespace mediapipe
+
+// Registers "fuse_function", a CalculatorFusionRegistry function, to fuse a
+// node running calculator "producer" into a node running calculator
+// "consumer".  For example:
+//   REGISTER_CALCULATOR_FUSION(DetectionLetterboxRemovalCalculator,
+//                              DetectionsToRectsCalculator,
+//                              FuseLetterboxRemoval);
+#define REGISTER_CALCULATOR_FUSION(producer, consumer, fuse_function) \
+  static auto* REGISTRY_STATIC_VAR(calculator_fusion_registration,    \
+                                   __LINE__) =                        \
+      new ::mediapipe::RegistrationToken(                             \
+          ::mediapipe::tool::CalculatorFusionRegistry::Register(      \
+              ::mediapipe::tool::CalculatorFusionName(#producer,      \
+                                                      #consumer),     \
+              fuse_function))
+
+#endif  // MEDIAPIPE_FRAMEWORK_TOOL_CALCULATOR_FUSION_H_
@@ -0,0 +1,130 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "mediapipe/framework/tool/calculator_fusion.h"
+
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/deps/message_matchers.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+// Fuses a ScaleCalculator into an OffsetCalculator, unless the scale node
+// has the name "unfusable".
+bool FuseScaleAndOffset(const CalculatorGraphConfig::Node& producer,
+                        const CalculatorGraphConfig::Node& consumer,
+                        CalculatorGraphConfig::Node* fused) {
+  if (producer.name() == "unfusable") {
+    return false;
+  }
+  fused->set_calculator("ScaleAndOffsetCalculator");
+  *fused->mutable_input_stream() = producer.input_stream();
+  *fused->mutable_output_stream() = consumer.output_stream();
+  return true;
+}
+REGISTER_CALCULATOR_FUSION(ScaleCalculator, OffsetCalculator,
+                           FuseScaleAndOffset);
+
+TEST(CalculatorFusionTest, FusesRegisteredPair) {
+  CalculatorGraphConfig config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "input"
+        output_stream: "output"
+        node {
+          calculator: "OffsetCalculator"
+          input_stream: "VALUE:scaled"
+          output_stream: "output"
+        }
+        node {
+          calculator: "ScaleCalculator"
+          input_stream: "input"
+          output_stream: "VALUE:scaled"
+        }
+      )");
+  CalculatorGraphConfig expected =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "input"
+        output_stream: "output"
+        node {
+          calculator: "ScaleAndOffsetCalculator"
+          input_stream: "input"
+          output_stream: "output"
+        }
+      )");
+  MP_ASSERT_OK(tool::FuseCalculators(&config));
+  EXPECT_THAT(config, EqualsProto(expected));
+}
+
+TEST(CalculatorFusionTest, KeepsStreamsWithOtherReaders) {
+  CalculatorGraphConfig config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "input"
+        output_stream: "scaled"
+        node {
+          calculator: "ScaleCalculator"
+          input_stream: "input"
+          output_stream: "scaled"
+        }
+        node {
+          calculator: "OffsetCalculator"
+          input_stream: "scaled"
+          output_stream: "output"
+        }
+        node {
+          calculator: "ScaleCalculator"
+          input_stream: "input"
+          output_stream: "scaled_2"
+        }
+        node {
+          calculator: "OffsetCalculator"
+          input_stream: "scaled_2"
+          output_stream: "output_2"
+        }
+        node {
+          calculator: "SinkCalculator"
+          input_stream: "scaled_2"
+        }
+      )");
+  CalculatorGraphConfig expected = config;
+  MP_ASSERT_OK(tool::FuseCalculators(&config));
+  EXPECT_THAT(config, EqualsProto(expected));
+}
+
+TEST(CalculatorFusionTest, KeepsNodesRejectedByFusion) {
+  CalculatorGraphConfig config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "input"
+        node {
+          name: "unfusable"
+          calculator: "ScaleCalculator"
+          input_stream: "input"
+          output_stream: "scaled"
+        }
+        node {
+          calculator: "OffsetCalculator"
+          input_stream: "scaled"
+          output_stream: "output"
+        }
+      )");
+  CalculatorGraphConfig expected = config;
+  MP_ASSERT_OK(tool::FuseCalculators(&config));
+  EXPECT_THAT(config, EqualsProto(expected));
+}
+
+}  // namespace
+}  // namespace mediapipe
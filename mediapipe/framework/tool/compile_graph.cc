@@ -0,0 +1,86 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// A command line utility to compile a text graph config ahead of time.
+//
+// The graph is validated as CalculatorGraph::Initialize would, and the
+// resulting canonical config is written as a binary proto: subgraphs and
+// templates are expanded, graph-level defaults are applied to the nodes, and
+// nodes are topologically sorted. Initializing a graph from this config
+// skips the subgraph expansion and the sorting, since there is nothing left
+// to expand or to reorder. The calculators, packet generators and subgraphs
+// used by the graph must be linked into the utility.
+
+#include <stdlib.h>
+
+#include <string>
+
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/port/advanced_proto_inc.h"
+#include "mediapipe/framework/port/commandlineflags.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/validated_graph_config.h"
+
+DEFINE_string(proto_source, "",
+              "The source file containing CalculatorGraphConfig protobuf "
+              "text.");
+DEFINE_string(proto_output, "",
+              "An output file with the compiled CalculatorGraphConfig in "
+              "binary form.");
+
+#define EXIT_IF_ERROR(status) \
+  if (!status.ok()) {         \
+    LOG(ERROR) << status;     \
+    return EXIT_FAILURE;      \
+  }
+
+namespace mediapipe {
+
+::mediapipe::Status CompileGraph(const std::string& proto_source,
+                                 const std::string& proto_output) {
+  std::string text;
+  MP_RETURN_IF_ERROR(file::GetContents(proto_source, &text));
+  CalculatorGraphConfig config;
+  RET_CHECK(proto_ns::TextFormat::ParseFromString(text, &config))
+      << "could not parse text proto: " << proto_source;
+
+  ValidatedGraphConfig validated_graph;
+  MP_RETURN_IF_ERROR(validated_graph.Initialize(config));
+  std::string binary;
+  RET_CHECK(validated_graph.Config().SerializeToString(&binary))
+      << "could not serialize compiled graph: " << proto_source;
+  return file::SetContents(proto_output, binary);
+}
+
+}  // namespace mediapipe
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  // Validate command line options.
+  if (FLAGS_proto_source.empty()) {
+    LOG(ERROR) << "--proto_source must be specified";
+    return EXIT_FAILURE;
+  }
+  if (FLAGS_proto_output.empty()) {
+    LOG(ERROR) << "--proto_output must be specified";
+    return EXIT_FAILURE;
+  }
+  EXIT_IF_ERROR(
+      mediapipe::CompileGraph(FLAGS_proto_source, FLAGS_proto_output));
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "mediapipe/framework/tool/graph_pruning.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mediapipe/framework/tool/validate_name.h"
+
+namespace mediapipe {
+namespace tool {
+
+namespace {
+
+// Returns the stream or side packet name in "tag_index_name".
+::mediapipe::StatusOr<std::string> PacketName(
+    const std::string& tag_index_name) {
+  std::string tag;
+  int index;
+  std::string name;
+  MP_RETURN_IF_ERROR(ParseTagIndexName(tag_index_name, &tag, &index, &name));
+  return name;
+}
+
+}  // namespace
+
+::mediapipe::Status PruneUnobservedNodes(CalculatorGraphConfig* config) {
+  auto* nodes = config->mutable_node();
+
+  // Maps each stream and side packet to the node outputting it.  Streams and
+  // side packets share one map, as a side packet is prefixed with "|".
+  std::map<std::string, int> producers;
+  std::vector<int> pending;
+  for (int i = 0; i < nodes->size(); ++i) {
+    const auto& node = nodes->Get(i);
+    if (node.output_stream_size() == 0 && node.output_side_packet_size() == 0) {
+      pending.push_back(i);
+    }
+    for (const auto& output_stream : node.output_stream()) {
+      ASSIGN_OR_RETURN(std::string name, PacketName(output_stream));
+      producers[name] = i;
+    }
+    for (const auto& output_side_packet : node.output_side_packet()) {
+      ASSIGN_OR_RETURN(std::string name, PacketName(output_side_packet));
+      producers["|" + name] = i;
+    }
+  }
+
+  // Marks the producers of the graph outputs, then of the inputs of every
+  // marked node.
+  std::set<int> kept;
+  auto keep_producer = [&](const std::string& name) {
+    auto iter = producers.find(name);
+    if (iter != producers.end() && kept.count(iter->second) == 0) {
+      pending.push_back(iter->second);
+    }
+  };
+  for (const auto& output_stream : config->output_stream()) {
+    ASSIGN_OR_RETURN(std::string name, PacketName(output_stream));
+    keep_producer(name);
+  }
+  for (const auto& output_side_packet : config->output_side_packet()) {
+    ASSIGN_OR_RETURN(std::string name, PacketName(output_side_packet));
+    keep_producer("|" + name);
+  }
+  while (!pending.empty()) {
+    const int i = pending.back();
+    pending.pop_back();
+    if (!kept.insert(i).second) {
+      continue;
+    }
+    const auto& node = nodes->Get(i);
+    for (const auto& input_stream : node.input_stream()) {
+      ASSIGN_OR_RETURN(std::string name, PacketName(input_stream));
+      keep_producer(name);
+    }
+    for (const auto& input_side_packet : node.input_side_packet()) {
+      ASSIGN_OR_RETURN(std::string name, PacketName(input_side_packet));
+      keep_producer("|" + name);
+    }
+  }
+
+  int num_kept = 0;
+  for (int i = 0; i < nodes->size(); ++i) {
+    if (kept.count(i) == 0) {
+      VLOG(1) << "Pruned unobserved node " << nodes->Get(i).calculator();
+      continue;
+    }
+    if (num_kept != i) {
+      nodes->SwapElements(num_kept, i);
+    }
+    ++num_kept;
+  }
+  nodes->DeleteSubrange(num_kept, nodes->size() - num_kept);
+  return ::mediapipe::OkStatus();
+}
+
+}  // namespace tool
+}  // namespace mediapipe
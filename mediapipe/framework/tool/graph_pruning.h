@@ -0,0 +1,34 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef MEDIAPIPE_FRAMEWORK_TOOL_GRAPH_PRUNING_H_
+#define MEDIAPIPE_FRAMEWORK_TOOL_GRAPH_PRUNING_H_
+
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/port/status.h"
+
+namespace mediapipe {
+namespace tool {
+
+// Removes the nodes of "config" that do not contribute to any graph
+// output_stream or output_side_packet.  A node is kept if it has no output
+// streams and no output side packets, if it outputs a graph output stream or
+// output side packet, or if a kept node reads one of its output streams or
+// output side packets.  Packet generators are always kept.
+::mediapipe::Status PruneUnobservedNodes(CalculatorGraphConfig* config);
+
+}  // namespace tool
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_TOOL_GRAPH_PRUNING_H_
@@ -0,0 +1,110 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "mediapipe/framework/tool/graph_pruning.h"
+
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/deps/message_matchers.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(GraphPruningTest, PrunesUnobservedBranch) {
+  CalculatorGraphConfig config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "input"
+        output_stream: "rects"
+        node {
+          calculator: "DetectionCalculator"
+          input_stream: "IMAGE:input"
+          output_stream: "DETECTIONS:detections"
+        }
+        node {
+          calculator: "DetectionsToRenderDataCalculator"
+          input_stream: "detections"
+          output_stream: "render_data"
+        }
+        node {
+          calculator: "AnnotationOverlayCalculator"
+          input_stream: "input"
+          input_stream: "render_data"
+          output_stream: "annotated"
+        }
+        node {
+          calculator: "DetectionsToRectsCalculator"
+          input_stream: "DETECTIONS:detections"
+          output_stream: "NORM_RECTS:rects"
+        }
+      )");
+  CalculatorGraphConfig expected =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "input"
+        output_stream: "rects"
+        node {
+          calculator: "DetectionCalculator"
+          input_stream: "IMAGE:input"
+          output_stream: "DETECTIONS:detections"
+        }
+        node {
+          calculator: "DetectionsToRectsCalculator"
+          input_stream: "DETECTIONS:detections"
+          output_stream: "NORM_RECTS:rects"
+        }
+      )");
+  MP_ASSERT_OK(tool::PruneUnobservedNodes(&config));
+  EXPECT_THAT(config, EqualsProto(expected));
+}
+
+TEST(GraphPruningTest, KeepsSinksAndSidePacketProducers) {
+  CalculatorGraphConfig config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "input"
+        output_side_packet: "model"
+        node {
+          calculator: "ModelLoaderCalculator"
+          output_side_packet: "MODEL:model"
+        }
+        node {
+          calculator: "ThresholdCalculator"
+          input_side_packet: "threshold"
+          output_side_packet: "threshold_value"
+        }
+        node {
+          calculator: "EncoderCalculator"
+          input_stream: "encoded_input"
+          input_side_packet: "threshold_value"
+        }
+        node {
+          calculator: "ScaleCalculator"
+          input_stream: "input"
+          output_stream: "encoded_input"
+        }
+        node {
+          calculator: "ScaleCalculator"
+          input_stream: "input"
+          output_stream: "unobserved"
+        }
+      )");
+  CalculatorGraphConfig expected = config;
+  expected.mutable_node()->RemoveLast();
+  MP_ASSERT_OK(tool::PruneUnobservedNodes(&config));
+  EXPECT_THAT(config, EqualsProto(expected));
+}
+
+}  // namespace
+}  // namespace mediapipe
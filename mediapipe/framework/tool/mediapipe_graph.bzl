@@ -1,7 +1,9 @@
 """Provides BUILD macros for MediaPipe graphs.
 
 mediapipe_binary_graph() converts a graph from text format to serialized binary
-format.
+format. With compile = True, it also validates the graph and writes its
+canonical config, with subgraphs expanded and nodes sorted, so that graph
+initialization can skip these steps.
 
 Example:
   mediapipe_binary_graph(
@@ -19,8 +21,19 @@ load("//mediapipe/framework:encode_binary_proto.bzl", "encode_binary_proto", "ge
 load("//mediapipe/framework:transitive_protos.bzl", "transitive_protos")
 load("//mediapipe/framework/deps:expand_template.bzl", "expand_template")
 
-def mediapipe_binary_graph(name, graph = None, output_name = None, deps = [], testonly = False, **kwargs):
-    """Converts a graph from text format to binary format."""
+def mediapipe_binary_graph(name, graph = None, output_name = None, deps = [], testonly = False, compile = False, **kwargs):
+    """Converts a graph from text format to binary format.
+
+    Args:
+      name: name of the rule.
+      graph: the BUILD label of a text-format MediaPipe graph.
+      output_name: the name of the binary graph file.
+      deps: the protos used by the graph options, and with compile = True, the
+          calculators, packet generators and subgraphs used by the graph.
+      testonly: pass 1 if the graph is to be used only for tests.
+      compile: whether to output the validated canonical config of the graph.
+      **kwargs: unused.
+    """
 
     if not graph:
         fail("No input graph file specified.")
@@ -34,14 +47,19 @@ def mediapipe_binary_graph(name, graph = None, output_name = None, deps = [], te
         testonly = testonly,
     )
 
-    # Compile a simple proto parser binary using the deps.
+    # Compile a simple proto parser binary using the deps, or a graph compiler
+    # binary linking the deps themselves.
+    if compile:
+        tool_deps = ["//mediapipe/framework/tool:compile_graph"] + deps
+    else:
+        tool_deps = [
+            "//mediapipe/framework/tool:text_to_binary_graph",
+            name + "_gather_cc_protos",
+        ]
     native.cc_binary(
         name = name + "_text_to_binary_graph",
         visibility = ["//visibility:private"],
-        deps = [
-            "//mediapipe/framework/tool:text_to_binary_graph",
-            name + "_gather_cc_protos",
-        ],
+        deps = tool_deps,
         tags = ["manual"],
         testonly = testonly,
     )
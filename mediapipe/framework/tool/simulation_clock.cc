@@ -14,6 +14,8 @@
 
 #include "mediapipe/framework/tool/simulation_clock.h"
 
+#include <algorithm>
+
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/port/logging.h"
 
@@ -35,14 +37,17 @@ void SimulationClock::SleepUntil(absl::Time wakeup_time) {
 }
 
 void SimulationClock::SleepInternal(absl::Time wakeup_time) {
+  if (!serialize_wakeups_ && wakeup_time <= time_) {
+    return;
+  }
   Waiter waiter;
   waiters_.insert({wakeup_time, &waiter});
   num_running_--;
   TryAdvanceTime();
+  // The thread is counted as running again when it is woken.
   while (waiter.sleeping) {
     waiter.cond.Wait(&time_mutex_);
   }
-  num_running_++;
 }
 
 void SimulationClock::ThreadStart() {
@@ -60,11 +65,18 @@ void SimulationClock::TryAdvanceTime() {
   if (num_running_ == 0 && !waiters_.empty()) {
     VLOG(2) << "Advance time from: " << absl::ToUnixMicros(time_)
             << " to: " << absl::ToUnixMicros(waiters_.begin()->first);
-    time_ = waiters_.begin()->first;
-    Waiter* waiter = waiters_.begin()->second;
-    waiters_.erase(waiters_.begin());
-    waiter->sleeping = false;
-    waiter->cond.Signal();
+    // A thread that slept until a past time does not move the clock back.
+    time_ = std::max(time_, waiters_.begin()->first);
+    // Woken threads are counted as running right away, so that the time
+    // cannot advance again before they get to run.
+    do {
+      Waiter* waiter = waiters_.begin()->second;
+      waiters_.erase(waiters_.begin());
+      waiter->sleeping = false;
+      num_running_++;
+      waiter->cond.Signal();
+    } while (!serialize_wakeups_ && !waiters_.empty() &&
+             waiters_.begin()->first <= time_);
   }
 }
 
@@ -36,9 +36,35 @@ namespace mediapipe {
 // to continue until all earlier threads have finished or entered Sleep.
 // The result is a single well-defined order of events.  Any desired
 // order of events can be defined by adjusting the precise sleep times.
+// A Clock whose time only advances when every thread using it is idle, and
+// then jumps straight to the earliest time a sleeping thread waits for. A
+// graph run with a SimulationClockExecutor, whose clock is passed to its
+// clock-driven calculators in their CLOCK input side packets, keeps the
+// timing of a real-time run, but runs as fast as its work allows. This is
+// useful both for deterministic tests and to process recorded streams
+// offline.
+//
+// Threads other than those of a SimulationClockExecutor, such as one feeding
+// the graph's input streams, must call ThreadStart() before and
+// ThreadFinish() after using the clock.
 class SimulationClock : public mediapipe::Clock {
  public:
+  struct Options {
+    // The simulated time when the clock is created.
+    absl::Time start_time = absl::UnixEpoch();
+    // If true, threads woken at the same simulated time run one at a time, in
+    // the order they went to sleep, and sleeping until the current time
+    // yields to the other threads, which makes runs deterministic. If false,
+    // threads woken at the same time run concurrently, and sleeping until the
+    // current time or earlier returns immediately, which makes offline runs
+    // faster on multiple cores.
+    bool serialize_wakeups = true;
+  };
+
   SimulationClock() {}
+  explicit SimulationClock(const Options& options)
+      : time_(options.start_time),
+        serialize_wakeups_(options.serialize_wakeups) {}
   ~SimulationClock() override {}
 
   // Returns the simulated time.
@@ -60,7 +86,8 @@ class SimulationClock : public mediapipe::Clock {
   // Queue up wake up waiter.
   void SleepInternal(absl::Time wakeup_time)
       EXCLUSIVE_LOCKS_REQUIRED(time_mutex_);
-  // Advances to the next wake up time if no related threads are running.
+  // Advances to the next wake up time if no related threads are running,
+  // and wakes the threads waiting for it.
   void TryAdvanceTime() EXCLUSIVE_LOCKS_REQUIRED(time_mutex_);
 
   // Represents a thread blocked in SleepUntil.
@@ -71,9 +98,10 @@ class SimulationClock : public mediapipe::Clock {
 
  protected:
   absl::Mutex time_mutex_;
-  absl::Time time_ GUARDED_BY(time_mutex_);
+  absl::Time time_ GUARDED_BY(time_mutex_) = absl::UnixEpoch();
   std::multimap<absl::Time, Waiter*> waiters_ GUARDED_BY(time_mutex_);
   int num_running_ GUARDED_BY(time_mutex_) = 0;
+  const bool serialize_wakeups_ = true;
 };
 
 }  // namespace mediapipe
@@ -21,6 +21,11 @@ namespace mediapipe {
 SimulationClockExecutor::SimulationClockExecutor(int num_threads)
     : ThreadPoolExecutor(num_threads), clock_(new SimulationClock()) {}
 
+SimulationClockExecutor::SimulationClockExecutor(
+    int num_threads, const SimulationClock::Options& clock_options)
+    : ThreadPoolExecutor(num_threads),
+      clock_(new SimulationClock(clock_options)) {}
+
 void SimulationClockExecutor::Schedule(std::function<void()> task) {
   clock_->ThreadStart();
   ThreadPoolExecutor::Schedule([this, task] {
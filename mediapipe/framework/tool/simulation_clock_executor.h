@@ -23,9 +23,25 @@ namespace mediapipe {
 // Simulation clock multithreaded executor. This is intended to be used with
 // graphs that are using SimulationClock class to emulate various parts of the
 // graph taking specific time to process the incoming packets.
+// A ThreadPoolExecutor whose tasks run on a SimulationClock. The clock does
+// not advance while any task is scheduled or running.
+//
+// To process recorded streams offline at full speed, with the timing of a
+// real-time run:
+//   SimulationClock::Options clock_options;
+//   clock_options.start_time = recording_start_time;
+//   clock_options.serialize_wakeups = false;
+//   auto executor = std::make_shared<SimulationClockExecutor>(
+//       num_threads, clock_options);
+//   MP_RETURN_IF_ERROR(graph.SetExecutor("", executor));
+//   std::shared_ptr<Clock> clock = executor->GetClock();
+//   MP_RETURN_IF_ERROR(
+//       graph.Run({{"clock", MakePacket<std::shared_ptr<Clock>>(clock)}}));
 class SimulationClockExecutor : public ThreadPoolExecutor {
  public:
   explicit SimulationClockExecutor(int num_threads);
+  SimulationClockExecutor(int num_threads,
+                          const SimulationClock::Options& clock_options);
   void Schedule(std::function<void()> task) override;
 
   // Returns a pointer to the instance of SimulationClock used by
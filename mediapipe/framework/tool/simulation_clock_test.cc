@@ -21,6 +21,7 @@
 #include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/executor.h"
 #include "mediapipe/framework/input_stream.h"
@@ -176,6 +177,35 @@ TEST_F(SimulationClockTest, DuplicateWakeTimes) {
   EXPECT_THAT(start_counts, ElementsAre(3, 2, 3, 1, 2, 3, 1, 2, 1));
 }
 
+// Wakes threads sleeping until the same time together, without serializing
+// them, when serialize_wakeups is false.
+TEST_F(SimulationClockTest, ConcurrentWakeups) {
+  SimulationClock::Options clock_options;
+  clock_options.start_time = absl::FromUnixMicros(5000);
+  clock_options.serialize_wakeups = false;
+  auto executor = std::make_shared<SimulationClockExecutor>(3, clock_options);
+  simulation_clock_ = executor->GetClock();
+  clock_ = simulation_clock_.get();
+  absl::Mutex mutex;
+  std::vector<absl::Time> wake_times;
+  int num_waiting = 0;
+  simulation_clock_->ThreadStart();
+  for (int i = 0; i < 3; ++i) {
+    executor->Schedule([&] {
+      clock_->Sleep(absl::Microseconds(10000));
+      absl::MutexLock lock(&mutex);
+      wake_times.push_back(clock_->TimeNow());
+      // Only returns if all three threads are running at once.
+      ++num_waiting;
+      mutex.Await(absl::Condition(
+          +[](int* num_waiting) { return *num_waiting == 3; }, &num_waiting));
+    });
+  }
+  clock_->Sleep(absl::Microseconds(100000));
+  simulation_clock_->ThreadFinish();
+  EXPECT_THAT(TimeValues(wake_times), ElementsAre(15000, 15000, 15000));
+}
+
 // A Calculator::Process callback function.
 typedef std::function<::mediapipe::Status(const InputStreamShardSet&,
                                           OutputStreamShardSet*)>
@@ -31,6 +31,7 @@
 #include "mediapipe/framework/status_handler.h"
 #include "mediapipe/framework/subgraph.h"
 #include "mediapipe/framework/tool/node_chain_subgraph.pb.h"
+#include "mediapipe/framework/validated_graph_config.h"
 
 namespace mediapipe {
 
@@ -524,5 +525,41 @@ TEST(SubgraphExpansionTest, ExecutorFieldOfNodeInSubgraphPreserved) {
   EXPECT_THAT(supergraph, mediapipe::EqualsProto(expected_graph));
 }
 
+// A compiled graph, as written by compile_graph, is validated again without
+// any subgraph registered and without changes.
+TEST(SubgraphExpansionTest, CompiledGraphNeedsNoExpansion) {
+  CalculatorGraphConfig supergraph =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "input"
+        executor {
+          name: "custom_thread_pool"
+          type: "ThreadPoolExecutor"
+          options {
+            [mediapipe.ThreadPoolExecutorOptions.ext] { num_threads: 4 }
+          }
+        }
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "middle"
+          output_stream: "output"
+        }
+        node {
+          calculator: "EnclosingSubgraph"
+          input_stream: "IN:input"
+          output_stream: "OUT:middle"
+        }
+      )");
+  ValidatedGraphConfig compiled_graph;
+  MP_ASSERT_OK(compiled_graph.Initialize(supergraph));
+
+  FunctionRegistry<std::unique_ptr<Subgraph>> no_subgraphs;
+  GraphRegistry graph_registry(&no_subgraphs);
+  ValidatedGraphConfig validated_graph;
+  MP_ASSERT_OK(
+      validated_graph.Initialize(compiled_graph.Config(), &graph_registry));
+  EXPECT_THAT(validated_graph.Config(),
+              mediapipe::EqualsProto(compiled_graph.Config()));
+}
+
 }  // namespace
 }  // namespace mediapipe
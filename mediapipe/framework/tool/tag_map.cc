@@ -215,11 +215,11 @@ std::string TagMap::ShortDebugString() const {
   return output;
 }
 
-bool TagMap::HasTag(const std::string& tag) const {
+bool TagMap::HasTag(absl::string_view tag) const {
   return mapping_.find(tag) != mapping_.end();
 }
 
-int TagMap::NumEntries(const std::string& tag) const {
+int TagMap::NumEntries(absl::string_view tag) const {
   const auto it = mapping_.find(tag);
   if (it == mapping_.end()) {
     return 0;
@@ -227,7 +227,7 @@ int TagMap::NumEntries(const std::string& tag) const {
   return it->second.count;
 }
 
-CollectionItemId TagMap::GetId(const std::string& tag, int index) const {
+CollectionItemId TagMap::GetId(absl::string_view tag, int index) const {
   const auto it = mapping_.find(tag);
   if (it == mapping_.end()) {
     return CollectionItemId::GetInvalid();
@@ -248,11 +248,11 @@ std::pair<std::string, int> TagMap::TagAndIndexFromId(
   return {"", -1};
 }
 
-CollectionItemId TagMap::BeginId(const std::string& tag) const {
+CollectionItemId TagMap::BeginId(absl::string_view tag) const {
   return GetId(tag, 0);
 }
 
-CollectionItemId TagMap::EndId(const std::string& tag) const {
+CollectionItemId TagMap::EndId(absl::string_view tag) const {
   const auto it = mapping_.find(tag);
   if (it == mapping_.end()) {
     return CollectionItemId::GetInvalid();
@@ -15,11 +15,13 @@
 #ifndef MEDIAPIPE_FRAMEWORK_TOOL_TAG_MAP_H_
 #define MEDIAPIPE_FRAMEWORK_TOOL_TAG_MAP_H_
 
+#include <functional>
 #include <map>
 #include <string>
 #include <vector>
 
 #include "absl/base/macros.h"
+#include "absl/strings/string_view.h"
 #include "mediapipe/framework/collection_item_id.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/core_proto_inc.h"
@@ -71,8 +73,12 @@ class TagMap {
     return std::move(output);
   }
 
+  // Mapping from tag to tag data. The comparator is transparent, so that a
+  // tag can be looked up without constructing a std::string.
+  typedef std::map<std::string, TagData, std::less<>> TagMapping;
+
   // Returns a reference to the mapping from tag to tag data.
-  const std::map<std::string, TagData>& Mapping() const { return mapping_; }
+  const TagMapping& Mapping() const { return mapping_; }
 
   // Returns the vector of names (indexed by CollectionItemId).
   const std::vector<std::string>& Names() const { return names_; }
@@ -91,16 +97,16 @@ class TagMap {
 
   // The following functions are directly utilized by collection.h see
   // that file for comments.
-  bool HasTag(const std::string& tag) const;
+  bool HasTag(absl::string_view tag) const;
   int NumEntries() const { return num_entries_; }
-  int NumEntries(const std::string& tag) const;
-  CollectionItemId GetId(const std::string& tag, int index) const;
+  int NumEntries(absl::string_view tag) const;
+  CollectionItemId GetId(absl::string_view tag, int index) const;
   std::set<std::string> GetTags() const;
   std::pair<std::string, int> TagAndIndexFromId(CollectionItemId id) const;
   CollectionItemId BeginId() const { return CollectionItemId(0); }
   CollectionItemId EndId() const { return CollectionItemId(num_entries_); }
-  CollectionItemId BeginId(const std::string& tag) const;
-  CollectionItemId EndId(const std::string& tag) const;
+  CollectionItemId BeginId(absl::string_view tag) const;
+  CollectionItemId EndId(absl::string_view tag) const;
 
  private:
   // Use static factory function TagMap::Create().
@@ -122,7 +128,7 @@ class TagMap {
   // The total number of entries under all tags.
   int num_entries_;
   // Mapping from tag to tag data.
-  std::map<std::string, TagData> mapping_;
+  TagMapping mapping_;
   // The names of the data (indexed by CollectionItemId).
   std::vector<std::string> names_;
 };
@@ -28,9 +28,12 @@ namespace tool {
 // Note that std::type_info may still generate the same hash code for different
 // types, although the c++ standard recommends that implementations avoid this
 // as much as possible.
+// The hash code is computed once per type, since std::type_info::hash_code()
+// may hash the type name on every call.
 template <typename T>
 size_t GetTypeHash() {
-  return typeid(T).hash_code();
+  static const size_t hash_code = typeid(T).hash_code();
+  return hash_code;
 }
 
 }  // namespace tool
@@ -0,0 +1,166 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_TYPED_STREAM_H_
+#define MEDIAPIPE_FRAMEWORK_TYPED_STREAM_H_
+
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_context.h"
+#include "mediapipe/framework/collection_item_id.h"
+#include "mediapipe/framework/input_stream_shard.h"
+#include "mediapipe/framework/output_stream_shard.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/packet_type.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mediapipe/framework/timestamp.h"
+#include "mediapipe/framework/type_map.h"
+
+namespace mediapipe {
+
+// Typed handles to the input and output streams of a calculator. The type of
+// a stream is checked once, when its handle is created in Open(), against the
+// type the calculator set for it in GetContract(). Reading an input packet
+// then costs a pointer cast, instead of the type validation of
+// Packet::Get<T>(), and adding an output packet skips the validation of
+// OutputStream::AddPacket().
+//
+// A handle only holds the id of its stream, so it can be used with the
+// CalculatorContext of every Process() call, including parallel ones.
+//
+// Example:
+//   class DoubleCalculator : public CalculatorBase {
+//    public:
+//     static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+//       cc->Inputs().Index(0).Set<float>();
+//       cc->Outputs().Index(0).Set<float>();
+//       return ::mediapipe::OkStatus();
+//     }
+//
+//     ::mediapipe::Status Open(CalculatorContext* cc) override {
+//       ASSIGN_OR_RETURN(input_, TypedInputStream<float>::Create(
+//                                    cc, cc->Inputs().BeginId()));
+//       ASSIGN_OR_RETURN(output_, TypedOutputStream<float>::Create(
+//                                     cc, cc->Outputs().BeginId()));
+//       return ::mediapipe::OkStatus();
+//     }
+//
+//     ::mediapipe::Status Process(CalculatorContext* cc) override {
+//       if (!input_.IsEmpty(cc)) {
+//         output_.Add(cc, input_.Get(cc) * 2, cc->InputTimestamp());
+//       }
+//       return ::mediapipe::OkStatus();
+//     }
+//
+//    private:
+//     TypedInputStream<float> input_;
+//     TypedOutputStream<float> output_;
+//   };
+template <typename T>
+class TypedInputStream {
+ public:
+  // Creates an unusable handle, to be assigned the result of Create().
+  TypedInputStream() = default;
+
+  // Returns a handle to the input stream "id" of the calculator, or an error
+  // if the stream does not accept exactly the packets holding a T, as with
+  // an input stream set with SetAny().
+  static ::mediapipe::StatusOr<TypedInputStream<T>> Create(
+      CalculatorContext* cc, CollectionItemId id) {
+    if (!id.IsValid() || id >= cc->Inputs().EndId()) {
+      return ::mediapipe::InvalidArgumentError(
+          absl::StrCat("Invalid input stream id: ", id.value()));
+    }
+    const InputStreamShard& input = cc->Inputs().Get(id);
+    RET_CHECK(input.packet_type_) << "The input stream is not set up.";
+    if (!input.packet_type_->template IsExactType<T>()) {
+      return ::mediapipe::InvalidArgumentError(absl::StrCat(
+          "Input stream \"", input.Name(), "\" does not have type \"",
+          MediaPipeTypeStringOrDemangled<T>(), "\"."));
+    }
+    return TypedInputStream<T>(id);
+  }
+
+  // Returns true if the stream has no packet at the input timestamp.
+  bool IsEmpty(CalculatorContext* cc) const {
+    return cc->Inputs().Get(id_).IsEmpty();
+  }
+
+  // Returns the object in the packet at the input timestamp, which must not
+  // be empty.
+  const T& Get(CalculatorContext* cc) const {
+    const Packet& packet = cc->Inputs().Get(id_).Value();
+    CHECK(!packet.IsEmpty()) << "No packet in input stream \""
+                             << cc->Inputs().Get(id_).Name() << "\".";
+    // The input stream manager validated the packet against the type T.
+    return static_cast<const packet_internal::Holder<T>*>(
+               packet_internal::GetHolder(packet))
+        ->data();
+  }
+
+ private:
+  explicit TypedInputStream(CollectionItemId id) : id_(id) {}
+
+  CollectionItemId id_;
+};
+
+template <typename T>
+class TypedOutputStream {
+ public:
+  // Creates an unusable handle, to be assigned the result of Create().
+  TypedOutputStream() = default;
+
+  // Returns a handle to the output stream "id" of the calculator, or an
+  // error if the stream does not accept the packets holding a T.
+  static ::mediapipe::StatusOr<TypedOutputStream<T>> Create(
+      CalculatorContext* cc, CollectionItemId id) {
+    if (!id.IsValid() || id >= cc->Outputs().EndId()) {
+      return ::mediapipe::InvalidArgumentError(
+          absl::StrCat("Invalid output stream id: ", id.value()));
+    }
+    const OutputStreamShard& output = cc->Outputs().Get(id);
+    const PacketType* packet_type =
+        output.output_stream_spec_->packet_type->GetSameAs();
+    if (!packet_type->IsAny() && !packet_type->template IsExactType<T>()) {
+      return ::mediapipe::InvalidArgumentError(absl::StrCat(
+          "Output stream \"", output.Name(), "\" does not have type \"",
+          MediaPipeTypeStringOrDemangled<T>(), "\"."));
+    }
+    return TypedOutputStream<T>(id);
+  }
+
+  // Adds a packet owning "ptr" at the given timestamp.
+  void Add(CalculatorContext* cc, T* ptr, Timestamp timestamp) const {
+    cc->Outputs().Get(id_).AddPacketOfCheckedType(Adopt(ptr).At(timestamp));
+  }
+
+  // Adds a packet holding "value" at the given timestamp.
+  void Add(CalculatorContext* cc, T value, Timestamp timestamp) const {
+    cc->Outputs().Get(id_).AddPacketOfCheckedType(
+        MakePacket<T>(std::move(value)).At(timestamp));
+  }
+
+ private:
+  explicit TypedOutputStream(CollectionItemId id) : id_(id) {}
+
+  CollectionItemId id_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_TYPED_STREAM_H_
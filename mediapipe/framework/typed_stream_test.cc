@@ -0,0 +1,172 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/typed_stream.h"
+
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/tool/sink.h"
+
+namespace mediapipe {
+namespace {
+
+// Outputs each input integer plus one, and skips empty inputs.
+class TypedPlusOneCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Inputs().Index(1).Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    ASSIGN_OR_RETURN(input_,
+                     TypedInputStream<int>::Create(cc, cc->Inputs().BeginId()));
+    ASSIGN_OR_RETURN(output_, TypedOutputStream<int>::Create(
+                                  cc, cc->Outputs().BeginId()));
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    if (!input_.IsEmpty(cc)) {
+      output_.Add(cc, input_.Get(cc) + 1, cc->InputTimestamp());
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+ private:
+  TypedInputStream<int> input_;
+  TypedOutputStream<int> output_;
+};
+REGISTER_CALCULATOR(TypedPlusOneCalculator);
+
+// Requests a typed handle to an input stream that accepts any type.
+class TypedAnyInputCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    return TypedInputStream<int>::Create(cc, cc->Inputs().BeginId()).status();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    return ::mediapipe::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(TypedAnyInputCalculator);
+
+// Requests a typed handle of the wrong type to an output stream.
+class TypedWrongOutputCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    return TypedOutputStream<float>::Create(cc, cc->Outputs().BeginId())
+        .status();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    return ::mediapipe::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(TypedWrongOutputCalculator);
+
+TEST(TypedStreamTest, ReadsAndWritesPackets) {
+  CalculatorGraphConfig config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "a"
+        input_stream: "b"
+        node {
+          calculator: "TypedPlusOneCalculator"
+          input_stream: "a"
+          input_stream: "b"
+          output_stream: "out"
+          max_in_flight: 2
+        }
+        num_threads: 2
+      )");
+  std::vector<Packet> out_packets;
+  tool::AddVectorSink("out", &config, &out_packets);
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < 10; ++i) {
+    // Only the even timestamps have a packet in stream "a".
+    if (i % 2 == 0) {
+      MP_ASSERT_OK(graph.AddPacketToInputStream(
+          "a", MakePacket<int>(i).At(Timestamp(i))));
+    }
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "b", MakePacket<int>(0).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  ASSERT_EQ(5, out_packets.size());
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(Timestamp(2 * i), out_packets[i].Timestamp());
+    EXPECT_EQ(2 * i + 1, out_packets[i].Get<int>());
+  }
+}
+
+TEST(TypedStreamTest, RejectsInputStreamOfAnyType) {
+  CalculatorGraphConfig config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "in"
+        node { calculator: "TypedAnyInputCalculator" input_stream: "in" }
+      )");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  ::mediapipe::Status status = graph.WaitUntilDone();
+  EXPECT_FALSE(status.ok());
+  EXPECT_THAT(status.message(), testing::HasSubstr("does not have type"));
+}
+
+TEST(TypedStreamTest, RejectsOutputStreamOfOtherType) {
+  CalculatorGraphConfig config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "in"
+        node {
+          calculator: "TypedWrongOutputCalculator"
+          input_stream: "in"
+          output_stream: "out"
+        }
+      )");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  ::mediapipe::Status status = graph.WaitUntilDone();
+  EXPECT_FALSE(status.ok());
+  EXPECT_THAT(status.message(), testing::HasSubstr("does not have type"));
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -40,6 +40,8 @@
 #include "mediapipe/framework/status_handler.h"
 #include "mediapipe/framework/stream_handler.pb.h"
 #include "mediapipe/framework/thread_pool_executor.pb.h"
+#include "mediapipe/framework/tool/calculator_fusion.h"
+#include "mediapipe/framework/tool/graph_pruning.h"
 #include "mediapipe/framework/tool/status_util.h"
 #include "mediapipe/framework/tool/subgraph_expansion.h"
 #include "mediapipe/framework/tool/validate.h"
@@ -148,6 +150,12 @@ std::string DebugName(const CalculatorGraphConfig& config,
   *output_graph_config = input_graph_config;
   MP_RETURN_IF_ERROR(
       tool::ExpandSubgraphs(output_graph_config, graph_registry));
+  if (output_graph_config->fuse_calculators()) {
+    MP_RETURN_IF_ERROR(tool::FuseCalculators(output_graph_config));
+  }
+  if (output_graph_config->prune_unobserved_nodes()) {
+    MP_RETURN_IF_ERROR(tool::PruneUnobservedNodes(output_graph_config));
+  }
 
   MP_RETURN_IF_ERROR(AddPredefinedExecutorConfigs(output_graph_config));
 
@@ -957,6 +965,10 @@ NodeTypeInfo::NodeRef ValidatedGraphConfig::NodeForSorterIndex(
       continue;
     }
     const ProtoString& executor_name = node_config.executor();
+    // GL context executors are created when the graph sets up the GPU.
+    if (IsGlContextExecutorName(executor_name)) {
+      continue;
+    }
     if (IsReservedExecutorName(executor_name)) {
       // TODO: We may want to allow this. For example, we may want to run
       // a non-GPU calculator on the GPU thread for efficiency reasons.
@@ -975,7 +987,14 @@ NodeTypeInfo::NodeRef ValidatedGraphConfig::NodeForSorterIndex(
 
 // static
 bool ValidatedGraphConfig::IsReservedExecutorName(const std::string& name) {
-  return name == "default" || name == "gpu" || absl::StartsWith(name, "__");
+  return name == "default" || name == "gpu" || absl::StartsWith(name, "__") ||
+         absl::StartsWith(name, kGlContextExecutorPrefix);
+}
+
+// static
+bool ValidatedGraphConfig::IsGlContextExecutorName(const std::string& name) {
+  return absl::StartsWith(name, kGlContextExecutorPrefix) &&
+         name.size() > sizeof(kGlContextExecutorPrefix) - 1;
 }
 
 ::mediapipe::Status ValidatedGraphConfig::ValidateRequiredSidePackets(
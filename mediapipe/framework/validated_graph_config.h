@@ -31,6 +31,10 @@
 
 namespace mediapipe {
 
+// The prefix of node executor names that run a GPU calculator in a named GL
+// context, such as "gpu:face_detection".
+constexpr char kGlContextExecutorPrefix[] = "gpu:";
+
 class ValidatedGraphConfig;
 
 // Returns a short unique name for a Node in a CalculatorGraphConfig.
@@ -336,6 +340,10 @@ class ValidatedGraphConfig {
   // Returns true if |name| is a reserved executor name.
   static bool IsReservedExecutorName(const std::string& name);
 
+  // Returns true if |name| is a node executor name that selects a GL context,
+  // of the form "gpu:<context name>".
+  static bool IsGlContextExecutorName(const std::string& name);
+
  private:
   // Initialize the PacketGenerator information.
   ::mediapipe::Status InitializeGeneratorInfo();
@@ -22,6 +22,7 @@
 
 #import "mediapipe/gpu/MPPGraphGPUData.h"
 #import "mediapipe/gpu/gpu_shared_data_internal.h"
+#import "mediapipe/gpu/pixel_buffer_pool_registry.h"
 
 @interface MPPGraphGPUDataTests : XCTestCase {
 }
@@ -83,4 +84,32 @@
   }
 }
 
+// This test verifies that the buffer pools of one graph are reused by the
+// next graph.
+- (void)testPixelBufferPoolsSharedAcrossGraphs {
+  mediapipe::PixelBufferPoolRegistry& registry = mediapipe::PixelBufferPoolRegistry::Get();
+  registry.Clear();
+  CFHolder<CVPixelBufferPoolRef> first_pool;
+  {
+    mediapipe::GpuSharedData gpu_shared;
+    mediapipe::GpuBuffer buffer = gpu_shared.gpu_buffer_pool.GetBuffer(64, 32);
+    XCTAssertEqual(buffer.width(), 64);
+    first_pool.reset(**registry.GetPool(64, 32, kCVPixelFormatType_32BGRA));
+  }
+  {
+    mediapipe::GpuSharedData gpu_shared;
+    mediapipe::GpuBuffer buffer = gpu_shared.gpu_buffer_pool.GetBuffer(64, 32);
+    XCTAssertEqual(**registry.GetPool(64, 32, kCVPixelFormatType_32BGRA), *first_pool);
+  }
+  XCTAssertEqual(registry.Prewarm(16, 16, kCVPixelFormatType_32BGRA, 3), kCVReturnSuccess);
+
+  // Pools past their retention are dropped once no graph uses them.
+  mediapipe::PixelBufferPoolRegistry::Options options;
+  options.retention = absl::ZeroDuration();
+  registry.SetOptions(options);
+  XCTAssertNotEqual(**registry.GetPool(64, 32, kCVPixelFormatType_32BGRA), *first_pool);
+  registry.SetOptions(mediapipe::PixelBufferPoolRegistry::Options());
+  registry.Clear();
+}
+
 @end
@@ -94,6 +94,22 @@ void GlCalculatorHelper::InitializeForTest(GpuResources* gpu_resources) {
   return impl_->RunInGlContext(gl_func, calculator_context);
 }
 
+::mediapipe::Status GlCalculatorHelper::RunBatchInGlContext(
+    const std::vector<std::function<::mediapipe::Status(void)>>& gl_funcs) {
+  return RunInGlContext([&gl_funcs]() -> ::mediapipe::Status {
+    for (const auto& gl_func : gl_funcs) {
+      MP_RETURN_IF_ERROR(gl_func());
+    }
+    return ::mediapipe::OkStatus();
+  });
+}
+
+::mediapipe::Status GlCalculatorHelper::RunInGlContextAsync(
+    std::function<::mediapipe::Status(void)> gl_func) {
+  if (!impl_) return ::mediapipe::InternalError("helper not initialized");
+  return impl_->RunInGlContextAsync(std::move(gl_func));
+}
+
 GLuint GlCalculatorHelper::framebuffer() const { return impl_->framebuffer(); }
 
 void GlCalculatorHelper::BindFramebuffer(const GlTexture& dst) {
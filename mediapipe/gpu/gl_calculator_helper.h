@@ -16,6 +16,7 @@
 #define MEDIAPIPE_GPU_GL_CALCULATOR_HELPER_H_
 
 #include <memory>
+#include <vector>
 
 #include "absl/memory/memory.h"
 #include "mediapipe/framework/calculator_context.h"
@@ -90,6 +91,24 @@ class GlCalculatorHelper {
   ::mediapipe::Status RunInGlContext(
       std::function<::mediapipe::Status(void)> gl_func);
 
+  // Like RunInGlContext, but queues the function on the GL context and returns
+  // without waiting for it to run, so that CPU work in the calculator can
+  // overlap with GL work. Jobs on a context run in order, so later calls to
+  // RunInGlContext, and GL calculators sharing the context, see the results.
+  // Textures released by the function get a producer sync token as usual, so
+  // consumers on other contexts wait on the GPU rather than the CPU.
+  // The function cannot capture anything by reference from the caller's stack.
+  // An error returned by it is reported by the next call to RunInGlContext or
+  // RunInGlContextAsync on this helper.
+  ::mediapipe::Status RunInGlContextAsync(
+      std::function<::mediapipe::Status(void)> gl_func);
+
+  // Like RunInGlContext, but runs several functions, in order, in a single
+  // handoff to the GL context's thread, which saves a thread round trip per
+  // function. Stops at the first error and returns it.
+  ::mediapipe::Status RunBatchInGlContext(
+      const std::vector<std::function<::mediapipe::Status(void)>>& gl_funcs);
+
   // Convenience version of RunInGlContext for arguments with a void result
   // type. As with the ::mediapipe::Status version, this also waits for the
   // function to finish executing before returning.
@@ -15,6 +15,7 @@
 #ifndef MEDIAPIPE_GPU_GL_CALCULATOR_HELPER_IMPL_H_
 #define MEDIAPIPE_GPU_GL_CALCULATOR_HELPER_IMPL_H_
 
+#include "absl/synchronization/mutex.h"
 #include "mediapipe/gpu/gl_calculator_helper.h"
 #include "mediapipe/gpu/gpu_shared_data_internal.h"
 
@@ -41,6 +42,9 @@ class GlCalculatorHelperImpl {
       std::function<::mediapipe::Status(void)> gl_func,
       CalculatorContext* calculator_context);
 
+  ::mediapipe::Status RunInGlContextAsync(
+      std::function<::mediapipe::Status(void)> gl_func);
+
   GlTexture CreateSourceTexture(const ImageFrame& image_frame);
   GlTexture CreateSourceTexture(const GpuBuffer& pixel_buffer);
 
@@ -78,11 +82,18 @@ class GlCalculatorHelperImpl {
   // Create the framebuffer for rendering.
   void CreateFramebuffer();
 
+  // Returns the first error from functions run by RunInGlContextAsync since
+  // the last call, and resets it.
+  ::mediapipe::Status TakeAsyncStatus();
+
   std::shared_ptr<GlContext> gl_context_;
 
   GLuint framebuffer_ = 0;
 
   GpuResources& gpu_resources_;
+
+  absl::Mutex async_status_mutex_;
+  ::mediapipe::Status async_status_ GUARDED_BY(async_status_mutex_);
 };
 
 }  // namespace mediapipe
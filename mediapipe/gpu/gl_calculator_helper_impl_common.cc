@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "mediapipe/framework/port/status_macros.h"
 #include "mediapipe/gpu/gl_calculator_helper_impl.h"
 #include "mediapipe/gpu/gpu_shared_data_internal.h"
 
@@ -41,12 +42,37 @@ GlContext& GlCalculatorHelperImpl::GetGlContext() const { return *gl_context_; }
 ::mediapipe::Status GlCalculatorHelperImpl::RunInGlContext(
     std::function<::mediapipe::Status(void)> gl_func,
     CalculatorContext* calculator_context) {
+  ::mediapipe::Status status;
   if (calculator_context) {
-    return gl_context_->Run(std::move(gl_func), calculator_context->NodeId(),
-                            calculator_context->InputTimestamp());
+    status = gl_context_->Run(std::move(gl_func), calculator_context->NodeId(),
+                              calculator_context->InputTimestamp());
   } else {
-    return gl_context_->Run(std::move(gl_func));
+    status = gl_context_->Run(std::move(gl_func));
   }
+  // Run waits for the jobs queued before it, so all earlier asynchronous
+  // functions have finished at this point.
+  MP_RETURN_IF_ERROR(TakeAsyncStatus());
+  return status;
+}
+
+::mediapipe::Status GlCalculatorHelperImpl::RunInGlContextAsync(
+    std::function<::mediapipe::Status(void)> gl_func) {
+  MP_RETURN_IF_ERROR(TakeAsyncStatus());
+  gl_context_->RunWithoutWaiting([this, gl_func] {
+    ::mediapipe::Status status = gl_func();
+    if (!status.ok()) {
+      absl::MutexLock lock(&async_status_mutex_);
+      if (async_status_.ok()) async_status_ = std::move(status);
+    }
+  });
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status GlCalculatorHelperImpl::TakeAsyncStatus() {
+  absl::MutexLock lock(&async_status_mutex_);
+  ::mediapipe::Status status = std::move(async_status_);
+  async_status_ = ::mediapipe::OkStatus();
+  return status;
 }
 
 void GlCalculatorHelperImpl::CreateFramebuffer() {
@@ -16,6 +16,7 @@
 
 #include <sys/types.h>
 
+#include <atomic>
 #include <cmath>
 #include <memory>
 #include <string>
@@ -23,6 +24,8 @@
 
 #include "absl/base/dynamic_annotations.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/ret_check.h"
@@ -35,6 +38,10 @@
 #include "mediapipe/gpu/gl_thread_collector.h"
 #endif
 
+#if HAS_EGL
+#include <EGL/eglext.h>
+#endif  // HAS_EGL
+
 #ifndef GL_MAJOR_VERSION
 #define GL_MAJOR_VERSION 0x821B
 #endif
@@ -87,20 +94,36 @@ void GlContext::DedicatedThread::SelfDestruct() {
   PutJob({});
 }
 
+// The number of times a thread polls for a job, or for a job's completion,
+// before going to sleep. Jobs submitted back to back by a calculator are then
+// handed over without waking up a sleeping thread.
+static constexpr int kNumSpinsBeforeWaiting = 1000;
+
 GlContext::DedicatedThread::Job GlContext::DedicatedThread::GetJob() {
-  absl::MutexLock lock(&mutex_);
-  while (jobs_.empty()) {
-    has_jobs_cv_.Wait(&mutex_);
+  Job job;
+  int num_spins = 0;
+  while (!jobs_.Pop(&job)) {
+    // A non-empty queue that cannot be popped has a push in progress.
+    if (++num_spins < kNumSpinsBeforeWaiting || !jobs_.Empty()) continue;
+    absl::MutexLock lock(&mutex_);
+    // PutJob checks gl_thread_waiting_ after pushing, so either it sees the
+    // flag set, or the queue is seen non-empty here.
+    gl_thread_waiting_ = true;
+    while (jobs_.Empty()) {
+      has_jobs_cv_.Wait(&mutex_);
+    }
+    gl_thread_waiting_ = false;
+    num_spins = 0;
   }
-  Job job = std::move(jobs_.front());
-  jobs_.pop_front();
   return job;
 }
 
 void GlContext::DedicatedThread::PutJob(Job job) {
-  absl::MutexLock lock(&mutex_);
-  jobs_.push_back(std::move(job));
-  has_jobs_cv_.SignalAll();
+  jobs_.Push(std::move(job));
+  if (gl_thread_waiting_) {
+    absl::MutexLock lock(&mutex_);
+    has_jobs_cv_.Signal();
+  }
 }
 
 void* GlContext::DedicatedThread::ThreadBody(void* instance) {
@@ -144,19 +167,28 @@ void GlContext::DedicatedThread::ThreadBody() {
   if (IsCurrentThread()) {
     return gl_func();
   }
-  bool done = false;  // Guarded by mutex_ after initialization.
+  std::atomic<bool> done{false};
   ::mediapipe::Status status;
   PutJob([this, gl_func, &done, &status]() {
     status = gl_func();
-    absl::MutexLock lock(&mutex_);
+    // This is the last access to the caller's stack: the caller may return as
+    // soon as it sees done.
     done = true;
-    gl_job_done_cv_.SignalAll();
+    if (num_done_waiters_ > 0) {
+      absl::MutexLock lock(&mutex_);
+      gl_job_done_cv_.SignalAll();
+    }
   });
 
+  for (int i = 0; i < kNumSpinsBeforeWaiting; ++i) {
+    if (done) return status;
+  }
   absl::MutexLock lock(&mutex_);
+  ++num_done_waiters_;
   while (!done) {
     gl_job_done_cv_.Wait(&mutex_);
   }
+  --num_done_waiters_;
   return status;
 }
 
@@ -270,6 +302,10 @@ void GlContext::SetProfilingContext(
   if (!profiling_helper_ && profiling_context) {
     profiling_helper_ = profiling_context->CreateGlProfilingHelper();
   }
+  if (!timer_queries_ && profiling_context &&
+      profiling_context->IsGpuTimerQueryEnabled()) {
+    timer_queries_ = absl::make_unique<GlTimerQueries>(profiling_context);
+  }
 }
 
 ::mediapipe::Status GlContext::Run(GlStatusFunction gl_func, int node_id,
@@ -283,7 +319,13 @@ void GlContext::SetProfilingContext(
             profiling_helper_->MarkTimestamp(node_id, input_timestamp,
                                              /*is_finish=*/false);
           }
+          if (timer_queries_ && node_id >= 0) {
+            timer_queries_->Begin(node_id, input_timestamp);
+          }
           auto status = gl_func();
+          if (timer_queries_ && node_id >= 0) {
+            timer_queries_->End();
+          }
           if (profiling_helper_) {
             profiling_helper_->MarkTimestamp(node_id, input_timestamp,
                                              /*is_finish=*/true);
@@ -299,7 +341,13 @@ void GlContext::SetProfilingContext(
       profiling_helper_->MarkTimestamp(node_id, input_timestamp,
                                        /*is_finish=*/false);
     }
+    if (timer_queries_ && node_id >= 0) {
+      timer_queries_->Begin(node_id, input_timestamp);
+    }
     status = gl_func();
+    if (timer_queries_ && node_id >= 0) {
+      timer_queries_->End();
+    }
     if (profiling_helper_) {
       profiling_helper_->MarkTimestamp(node_id, input_timestamp,
                                        /*is_finish=*/true);
@@ -310,6 +358,19 @@ void GlContext::SetProfilingContext(
   return status;
 }
 
+::mediapipe::Status GlContext::RunBatch(
+    const std::vector<GlStatusFunction>& gl_funcs, int node_id,
+    Timestamp input_timestamp) {
+  return Run(
+      [&gl_funcs]() -> ::mediapipe::Status {
+        for (const auto& gl_func : gl_funcs) {
+          MP_RETURN_IF_ERROR(gl_func());
+        }
+        return ::mediapipe::OkStatus();
+      },
+      node_id, input_timestamp);
+}
+
 void GlContext::RunWithoutWaiting(GlVoidFunction gl_func) {
   if (thread_) {
     // Add ref to keep the context alive while the task is executing.
@@ -414,16 +475,66 @@ void GlContext::GlFinishCalled() {
   wait_for_gl_finish_cv_.SignalAll();
 }
 
+namespace {
+
+enum SyncCounter {
+  kGlFenceTokens,
+  kEglFenceTokens,
+  kGlFinishTokens,
+  kGpuWaits,
+  kSameContextWaits,
+  kCpuWaits,
+  kGlFinishCalls,
+  kNumSyncCounters,
+};
+
+std::atomic<int64_t> sync_counts[kNumSyncCounters];
+
+void CountSync(SyncCounter counter) {
+  sync_counts[counter].fetch_add(1, std::memory_order_relaxed);
+}
+
+// Whether the calling thread runs gl_context, whose commands are then
+// executed after those of any sync point created on it.
+bool IsCurrentContext(const std::shared_ptr<GlContext>& gl_context) {
+  return GlContext::GetCurrent() == gl_context;
+}
+
+}  // namespace
+
+GlContext::SyncCounts GlContext::GetSyncCounts() {
+  SyncCounts counts;
+  counts.gl_fence_tokens = sync_counts[kGlFenceTokens];
+  counts.egl_fence_tokens = sync_counts[kEglFenceTokens];
+  counts.gl_finish_tokens = sync_counts[kGlFinishTokens];
+  counts.gpu_waits = sync_counts[kGpuWaits];
+  counts.same_context_waits = sync_counts[kSameContextWaits];
+  counts.cpu_waits = sync_counts[kCpuWaits];
+  counts.gl_finish_calls = sync_counts[kGlFinishCalls];
+  return counts;
+}
+
 class GlFinishSyncPoint : public GlSyncPoint {
  public:
   explicit GlFinishSyncPoint(const std::shared_ptr<GlContext>& gl_context)
       : GlSyncPoint(gl_context),
-        gl_finish_count_(gl_context_->gl_finish_count()) {}
+        gl_finish_count_(gl_context_->gl_finish_count()) {
+    CountSync(kGlFinishTokens);
+  }
 
   void Wait() override {
+    CountSync(kCpuWaits);
     gl_context_->WaitForGlFinishCountPast(gl_finish_count_);
   }
 
+  void WaitOnGpu() override {
+    if (IsCurrentContext(gl_context_)) {
+      CountSync(kSameContextWaits);
+      return;
+    }
+    Wait();
+  }
+
   bool IsReady() override {
     return gl_context_->gl_finish_count() > gl_finish_count_;
   }
@@ -437,6 +548,7 @@ class GlFenceSyncPoint : public GlSyncPoint {
  public:
   explicit GlFenceSyncPoint(const std::shared_ptr<GlContext>& gl_context)
       : GlSyncPoint(gl_context) {
+    CountSync(kGlFenceTokens);
     gl_context_->Run([this] {
       sync_ = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
       glFlush();
@@ -455,6 +567,7 @@ class GlFenceSyncPoint : public GlSyncPoint {
 
   void Wait() override {
     if (!sync_) return;
+    CountSync(kCpuWaits);
     gl_context_->Run([this] {
       GLenum result =
           glClientWaitSync(sync_, 0, std::numeric_limits<uint64_t>::max());
@@ -468,7 +581,11 @@ class GlFenceSyncPoint : public GlSyncPoint {
 
   void WaitOnGpu() override {
     if (!sync_) return;
-    // TODO: do not wait if we are already on the same context?
+    if (IsCurrentContext(gl_context_)) {
+      CountSync(kSameContextWaits);
+      return;
+    }
+    CountSync(kGpuWaits);
     glWaitSync(sync_, 0, GL_TIMEOUT_IGNORED);
   }
 
@@ -491,6 +608,128 @@ class GlFenceSyncPoint : public GlSyncPoint {
   GLsync sync_;
 };
 
+#if HAS_EGL
+// The EGL_KHR_fence_sync and EGL_KHR_wait_sync entry points. These are
+// extensions, so they are looked up at runtime, and are null if the display
+// does not support them.
+struct EglSyncFunctions {
+  PFNEGLCREATESYNCKHRPROC create_sync = nullptr;
+  PFNEGLDESTROYSYNCKHRPROC destroy_sync = nullptr;
+  PFNEGLCLIENTWAITSYNCKHRPROC client_wait_sync = nullptr;
+  PFNEGLWAITSYNCKHRPROC wait_sync = nullptr;
+};
+
+static bool HasEglExtension(EGLDisplay display, absl::string_view extension) {
+  const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+  if (!extensions) return false;
+  for (absl::string_view name : absl::StrSplit(extensions, ' ')) {
+    if (name == extension) return true;
+  }
+  return false;
+}
+
+// MediaPipe contexts all use the default display, so the functions are looked
+// up once.
+static const EglSyncFunctions& GetEglSyncFunctions(EGLDisplay display) {
+  static const EglSyncFunctions functions = [display] {
+    EglSyncFunctions functions;
+    if (HasEglExtension(display, "EGL_KHR_fence_sync")) {
+      functions.create_sync = reinterpret_cast<PFNEGLCREATESYNCKHRPROC>(
+          eglGetProcAddress("eglCreateSyncKHR"));
+      functions.destroy_sync = reinterpret_cast<PFNEGLDESTROYSYNCKHRPROC>(
+          eglGetProcAddress("eglDestroySyncKHR"));
+      functions.client_wait_sync =
+          reinterpret_cast<PFNEGLCLIENTWAITSYNCKHRPROC>(
+              eglGetProcAddress("eglClientWaitSyncKHR"));
+      if (!functions.create_sync || !functions.destroy_sync ||
+          !functions.client_wait_sync) {
+        return EglSyncFunctions();
+      }
+    }
+    if (functions.create_sync &&
+        HasEglExtension(display, "EGL_KHR_wait_sync")) {
+      functions.wait_sync = reinterpret_cast<PFNEGLWAITSYNCKHRPROC>(
+          eglGetProcAddress("eglWaitSyncKHR"));
+    }
+    return functions;
+  }();
+  return functions;
+}
+
+// A sync point using an EGL fence, for contexts without GL fences (GLES 2).
+// Unlike GL fences, EGL syncs belong to the display, so waiting on the CPU
+// does not need to run on the producer's context, and with EGL_KHR_wait_sync
+// consumers wait on the GPU instead of the CPU.
+class GlEglFenceSyncPoint : public GlSyncPoint {
+ public:
+  GlEglFenceSyncPoint(const std::shared_ptr<GlContext>& gl_context,
+                      const EglSyncFunctions& egl)
+      : GlSyncPoint(gl_context),
+        egl_(egl),
+        display_(gl_context->egl_display()) {
+    CountSync(kEglFenceTokens);
+    gl_context_->Run([this] {
+      sync_ = egl_.create_sync(display_, EGL_SYNC_FENCE_KHR, nullptr);
+      // The fence must be flushed before other contexts can wait for it.
+      glFlush();
+    });
+  }
+
+  ~GlEglFenceSyncPoint() override {
+    if (sync_ != EGL_NO_SYNC_KHR) egl_.destroy_sync(display_, sync_);
+  }
+
+  GlEglFenceSyncPoint(const GlEglFenceSyncPoint&) = delete;
+  GlEglFenceSyncPoint& operator=(const GlEglFenceSyncPoint&) = delete;
+
+  void Wait() override {
+    absl::MutexLock lock(&mutex_);
+    if (sync_ == EGL_NO_SYNC_KHR) return;
+    CountSync(kCpuWaits);
+    EGLint result =
+        egl_.client_wait_sync(display_, sync_, 0, EGL_FOREVER_KHR);
+    if (result == EGL_CONDITION_SATISFIED_KHR) ReleaseSync();
+  }
+
+  void WaitOnGpu() override {
+    if (IsCurrentContext(gl_context_)) {
+      CountSync(kSameContextWaits);
+      return;
+    }
+    if (!egl_.wait_sync) {
+      Wait();
+      return;
+    }
+    absl::MutexLock lock(&mutex_);
+    if (sync_ == EGL_NO_SYNC_KHR) return;
+    CountSync(kGpuWaits);
+    egl_.wait_sync(display_, sync_, 0);
+  }
+
+  bool IsReady() override {
+    absl::MutexLock lock(&mutex_);
+    if (sync_ == EGL_NO_SYNC_KHR) return true;
+    if (egl_.client_wait_sync(display_, sync_, 0, 0) !=
+        EGL_CONDITION_SATISFIED_KHR) {
+      return false;
+    }
+    ReleaseSync();
+    return true;
+  }
+
+ private:
+  void ReleaseSync() EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    egl_.destroy_sync(display_, sync_);
+    sync_ = EGL_NO_SYNC_KHR;
+  }
+
+  const EglSyncFunctions& egl_;
+  EGLDisplay display_;
+  absl::Mutex mutex_;
+  EGLSyncKHR sync_ GUARDED_BY(mutex_) = EGL_NO_SYNC_KHR;
+};
+#endif  // HAS_EGL
+
 void GlMultiSyncPoint::Add(std::shared_ptr<GlSyncPoint> new_sync) {
   for (auto& sync : syncs_) {
     if (&sync->GetContext() == &new_sync->GetContext()) {
@@ -547,9 +786,16 @@ std::shared_ptr<GlSyncPoint> GlContext::CreateSyncToken() {
 #else
   if (SymbolAvailable(&glWaitSync)) {
     token.reset(new GlFenceSyncPoint(shared_from_this()));
-  } else {
-    token.reset(new GlFinishSyncPoint(shared_from_this()));
+    return token;
+  }
+#if HAS_EGL
+  const EglSyncFunctions& egl = GetEglSyncFunctions(display_);
+  if (egl.create_sync) {
+    token.reset(new GlEglFenceSyncPoint(shared_from_this(), egl));
+    return token;
   }
+#endif  // HAS_EGL
+  token.reset(new GlFinishSyncPoint(shared_from_this()));
 #endif
   return token;
 }
@@ -574,6 +820,7 @@ void GlContext::WaitForGlFinishCountPast(int64_t count_to_pass) {
     // is used for documentation and sanity-checking purposes.
     DCHECK(gl_finish_count_ >= count_to_pass);
     if (gl_finish_count_ == count_to_pass) {
+      CountSync(kGlFinishCalls);
       glFinish();
       GlFinishCalled();
     }
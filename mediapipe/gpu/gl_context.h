@@ -20,6 +20,7 @@
 #include <atomic>
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/executor.h"
@@ -29,6 +30,7 @@
 #include "mediapipe/framework/port/threadpool.h"
 #include "mediapipe/framework/timestamp.h"
 #include "mediapipe/gpu/gl_base.h"
+#include "mediapipe/gpu/gl_timer_queries.h"
 
 #ifdef __APPLE__
 #include <CoreVideo/CoreVideo.h>
@@ -174,7 +176,9 @@ class GlContext : public std::enable_shared_from_this<GlContext> {
   // Initializes this GlContext with the graph tracing and profiling interface.
   // Also initializes the GlProfilingHelper object for this GlContext if the
   // GlProfilingHelper is uninitialized. This ensures that the GlProfilingHelper
-  // is unique to and only initialized once per GlContext object.
+  // is unique to and only initialized once per GlContext object. If
+  // ProfilerConfig.enable_gpu_timer_queries is set, the GPU-side runtime of
+  // each Run() call for a calculator is also measured with timer queries.
   void SetProfilingContext(
       std::shared_ptr<mediapipe::ProfilingContext> profiling_context);
 
@@ -186,6 +190,13 @@ class GlContext : public std::enable_shared_from_this<GlContext> {
   // Like Run, but does not wait.
   void RunWithoutWaiting(GlVoidFunction gl_func);
 
+  // Like Run, but executes several functions, in order, in a single handoff
+  // to the GL thread. Stops at the first function returning an error, and
+  // returns that error.
+  ::mediapipe::Status RunBatch(const std::vector<GlStatusFunction>& gl_funcs,
+                               int node_id = -1,
+                               Timestamp input_timestamp = Timestamp::Unset());
+
   // Returns a synchronization token.
   // This should not be called outside of the GlContext thread.
   std::shared_ptr<GlSyncPoint> CreateSyncToken();
@@ -268,6 +279,28 @@ class GlContext : public std::enable_shared_from_this<GlContext> {
     }).IgnoreError();
   }
 
+  // Process-wide counts of how sync tokens are created and waited on, to tell
+  // how often cross-context synchronization stalls the CPU.
+  struct SyncCounts {
+    // Tokens backed by a GL fence (GLES 3 or GL_ARB_sync).
+    int64_t gl_fence_tokens = 0;
+    // Tokens backed by an EGL_KHR_fence_sync fence, for contexts without GL
+    // fences.
+    int64_t egl_fence_tokens = 0;
+    // Tokens falling back to glFinish.
+    int64_t gl_finish_tokens = 0;
+    // WaitOnGpu calls served by a GPU-side wait, without blocking the CPU.
+    int64_t gpu_waits = 0;
+    // WaitOnGpu calls skipped because the consumer runs on the producer's
+    // context, where commands already execute in order.
+    int64_t same_context_waits = 0;
+    // Waits that blocked the CPU until the sync point was reached.
+    int64_t cpu_waits = 0;
+    // glFinish calls made to satisfy a wait.
+    int64_t gl_finish_calls = 0;
+  };
+  static SyncCounts GetSyncCounts();
+
   // These are used for testing specific SyncToken implementations. Do not use
   // outside of tests.
   enum class SyncTokenTypeForTest {
@@ -382,6 +415,9 @@ class GlContext : public std::enable_shared_from_this<GlContext> {
   absl::CondVar wait_for_gl_finish_cv_ GUARDED_BY(mutex_);
 
   std::unique_ptr<mediapipe::GlProfilingHelper> profiling_helper_ = nullptr;
+
+  // Measures the GPU-side runtime of calculator tasks, if enabled.
+  std::unique_ptr<GlTimerQueries> timer_queries_;
 };
 
 }  // namespace mediapipe
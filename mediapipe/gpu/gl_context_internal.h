@@ -15,7 +15,10 @@
 #ifndef MEDIAPIPE_GPU_GL_CONTEXT_INTERNAL_H_
 #define MEDIAPIPE_GPU_GL_CONTEXT_INTERNAL_H_
 
+#include <atomic>
+
 #include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/deps/mpsc_queue.h"
 #ifdef __APPLE__
 #if TARGET_OS_OSX
 #import <AppKit/NSOpenGL.h>
@@ -50,13 +53,21 @@ class GlContext::DedicatedThread {
   Job GetJob();
   void PutJob(Job job);
 
+  // Jobs are handed to the GL thread through a lock-free queue. The mutex and
+  // condition variables are only used when the GL thread, or a thread waiting
+  // in Run(), has gone to sleep after spinning for a while, and the flags
+  // below tell the other side whether it must take the mutex to wake it up.
   absl::Mutex mutex_;
   // Used to wait for a job's completion.
   absl::CondVar gl_job_done_cv_ GUARDED_BY(mutex_);
+  // The number of threads sleeping on gl_job_done_cv_.
+  std::atomic<int> num_done_waiters_{0};
   pthread_t gl_thread_id_;
 
-  std::deque<Job> jobs_ GUARDED_BY(mutex_);
+  MpscQueue<Job> jobs_;
   absl::CondVar has_jobs_cv_ GUARDED_BY(mutex_);
+  // Whether the GL thread is sleeping on has_jobs_cv_.
+  std::atomic<bool> gl_thread_waiting_{false};
 
   bool self_destruct_ = false;
 };
@@ -71,8 +71,9 @@ FrameRotation FrameRotationFromDegrees(int degrees_ccw) {
       "texture_coordinate",
   };
 
-  GlhCreateProgram(kScaledVertexShader, custom_frag_shader, NUM_ATTRIBUTES,
-                   &attr_name[0], attr_location, &program_);
+  GlhCreateCachedProgram(kScaledVertexShader, custom_frag_shader,
+                         NUM_ATTRIBUTES, &attr_name[0], attr_location,
+                         &program_);
   RET_CHECK(program_) << "Problem initializing the program.";
 
   frame_unifs_.resize(custom_frame_uniforms.size());
@@ -89,7 +90,7 @@ FrameRotation FrameRotationFromDegrees(int degrees_ccw) {
 
 void QuadRenderer::GlTeardown() {
   if (program_) {
-    glDeleteProgram(program_);
+    GlhReleaseCachedProgram(program_);
     program_ = 0;
   }
 }
@@ -23,10 +23,24 @@
 #include "mediapipe/gpu/gl_surface_sink_calculator.pb.h"
 #include "mediapipe/gpu/shader_util.h"
 
+#ifdef __ANDROID__
+#include <EGL/eglext.h>
+#endif  // __ANDROID__
+
 namespace mediapipe {
 
 enum { kAttribVertex, kAttribTexturePosition, kNumberOfAttributes };
 
+#ifdef __ANDROID__
+// eglPresentationTimeANDROID is an extension, so it is resolved at runtime.
+PFNEGLPRESENTATIONTIMEANDROIDPROC GetPresentationTimeFunction() {
+  static PFNEGLPRESENTATIONTIMEANDROIDPROC function =
+      reinterpret_cast<PFNEGLPRESENTATIONTIMEANDROIDPROC>(
+          eglGetProcAddress("eglPresentationTimeANDROID"));
+  return function;
+}
+#endif  // __ANDROID__
+
 // Receives GpuBuffers and renders them to an EGL surface.
 // Can be used to render to an Android SurfaceTexture.
 //
@@ -53,6 +67,11 @@ class GlSurfaceSinkCalculator : public CalculatorBase {
   bool initialized_;
   std::unique_ptr<QuadRenderer> renderer_;
   FrameScaleMode scale_mode_ = FrameScaleMode::kFillAndCrop;
+  bool set_presentation_time_ = false;
+  int64 presentation_latency_us_ = 0;
+  int swap_interval_ = -1;
+  // The surface on which swap_interval_ was last applied.
+  EGLSurface swap_interval_surface_ = EGL_NO_SURFACE;
 };
 REGISTER_CALCULATOR(GlSurfaceSinkCalculator);
 
@@ -74,9 +93,12 @@ REGISTER_CALCULATOR(GlSurfaceSinkCalculator);
                         .Get<std::unique_ptr<EglSurfaceHolder>>()
                         .get();
 
-  scale_mode_ = FrameScaleModeFromProto(
-      cc->Options<GlSurfaceSinkCalculatorOptions>().frame_scale_mode(),
-      FrameScaleMode::kFillAndCrop);
+  const auto& options = cc->Options<GlSurfaceSinkCalculatorOptions>();
+  scale_mode_ = FrameScaleModeFromProto(options.frame_scale_mode(),
+                                        FrameScaleMode::kFillAndCrop);
+  set_presentation_time_ = options.set_presentation_time();
+  presentation_latency_us_ = options.presentation_latency_us();
+  swap_interval_ = options.swap_interval();
 
   // Let the helper access the GL context information.
   return helper_.Open(cc);
@@ -110,6 +132,14 @@ REGISTER_CALCULATOR(GlSurfaceSinkCalculator);
     EGLBoolean success = eglMakeCurrent(display, surface, surface, context);
     RET_CHECK(success) << "failed to make surface current";
 
+    // The swap interval is a property of the surface, so it only needs to be
+    // set again when the application provides a new one.
+    if (swap_interval_ >= 0 && surface != swap_interval_surface_) {
+      success = eglSwapInterval(display, swap_interval_);
+      RET_CHECK(success) << "failed to set swap interval";
+      swap_interval_surface_ = surface;
+    }
+
     EGLint dst_width;
     success = eglQuerySurface(display, surface, EGL_WIDTH, &dst_width);
     RET_CHECK(success) << "failed to query surface width";
@@ -132,6 +162,17 @@ REGISTER_CALCULATOR(GlSurfaceSinkCalculator);
 
     glBindTexture(src.target(), 0);
 
+#ifdef __ANDROID__
+    if (set_presentation_time_ && GetPresentationTimeFunction()) {
+      const int64 presentation_time_ns =
+          (cc->InputTimestamp().Microseconds() + presentation_latency_us_) *
+          1000;
+      success = GetPresentationTimeFunction()(display, surface,
+                                              presentation_time_ns);
+      RET_CHECK(success) << "failed to set presentation time";
+    }
+#endif  // __ANDROID__
+
     success = eglSwapBuffers(display, surface);
     RET_CHECK(success) << "failed to swap buffers";
 
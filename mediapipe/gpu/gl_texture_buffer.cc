@@ -14,8 +14,151 @@
 
 #include "mediapipe/gpu/gl_texture_buffer.h"
 
+#if MEDIAPIPE_GPU_BUFFER_USE_AHWB
+#include <dlfcn.h>
+#endif  // MEDIAPIPE_GPU_BUFFER_USE_AHWB
+
 namespace mediapipe {
 
+#if MEDIAPIPE_GPU_BUFFER_USE_AHWB
+namespace {
+
+// The NDK and extension entry points needed to import AHardwareBuffers.
+struct HardwareBufferFunctions {
+  int (*allocate)(const AHardwareBuffer_Desc*, AHardwareBuffer**) = nullptr;
+  void (*acquire)(AHardwareBuffer*) = nullptr;
+  void (*release)(AHardwareBuffer*) = nullptr;
+  void (*describe)(const AHardwareBuffer*, AHardwareBuffer_Desc*) = nullptr;
+  PFNEGLGETNATIVECLIENTBUFFERANDROIDPROC get_native_client_buffer = nullptr;
+  PFNEGLCREATEIMAGEKHRPROC create_image = nullptr;
+  PFNEGLDESTROYIMAGEKHRPROC destroy_image = nullptr;
+  PFNGLEGLIMAGETARGETTEXTURE2DOESPROC image_target_texture = nullptr;
+
+  bool available() const {
+    return allocate && acquire && release && describe &&
+           get_native_client_buffer && create_image && destroy_image &&
+           image_target_texture;
+  }
+};
+
+template <typename T>
+void LoadSymbol(void* library, const char* name, T* symbol) {
+  *symbol = reinterpret_cast<T>(dlsym(library, name));
+}
+
+template <typename T>
+void LoadEglSymbol(const char* name, T* symbol) {
+  *symbol = reinterpret_cast<T>(eglGetProcAddress(name));
+}
+
+const HardwareBufferFunctions& GetHardwareBufferFunctions() {
+  static const HardwareBufferFunctions* functions = [] {
+    auto* f = new HardwareBufferFunctions;
+    // AHardwareBuffer is available from API level 26.
+    void* library = dlopen("libandroid.so", RTLD_NOW);
+    if (library) {
+      LoadSymbol(library, "AHardwareBuffer_allocate", &f->allocate);
+      LoadSymbol(library, "AHardwareBuffer_acquire", &f->acquire);
+      LoadSymbol(library, "AHardwareBuffer_release", &f->release);
+      LoadSymbol(library, "AHardwareBuffer_describe", &f->describe);
+    }
+    LoadEglSymbol("eglGetNativeClientBufferANDROID",
+                  &f->get_native_client_buffer);
+    LoadEglSymbol("eglCreateImageKHR", &f->create_image);
+    LoadEglSymbol("eglDestroyImageKHR", &f->destroy_image);
+    LoadEglSymbol("glEGLImageTargetTexture2DOES", &f->image_target_texture);
+    return f;
+  }();
+  return *functions;
+}
+
+// Returns kUnknown for formats that GL cannot sample as a GL_TEXTURE_2D.
+GpuBufferFormat GpuBufferFormatForHardwareBufferFormat(uint32_t format) {
+  switch (format) {
+    case AHARDWAREBUFFER_FORMAT_R8G8B8A8_UNORM:
+    case AHARDWAREBUFFER_FORMAT_R8G8B8X8_UNORM:
+      return GpuBufferFormat::kBGRA32;
+    case AHARDWAREBUFFER_FORMAT_R8G8B8_UNORM:
+      return GpuBufferFormat::kRGB24;
+    case AHARDWAREBUFFER_FORMAT_R16G16B16A16_FLOAT:
+      return GpuBufferFormat::kRGBAHalf64;
+    default:
+      return GpuBufferFormat::kUnknown;
+  }
+}
+
+// Returns 0 for formats that have no AHardwareBuffer equivalent.
+uint32_t HardwareBufferFormatForGpuBufferFormat(GpuBufferFormat format) {
+  switch (format) {
+    case GpuBufferFormat::kBGRA32:
+      return AHARDWAREBUFFER_FORMAT_R8G8B8A8_UNORM;
+    case GpuBufferFormat::kRGB24:
+      return AHARDWAREBUFFER_FORMAT_R8G8B8_UNORM;
+    case GpuBufferFormat::kRGBAHalf64:
+      return AHARDWAREBUFFER_FORMAT_R16G16B16A16_FLOAT;
+    default:
+      return 0;
+  }
+}
+
+}  // namespace
+
+// static
+bool GlTextureBuffer::HardwareBuffersSupported() {
+  return GetHardwareBufferFunctions().available();
+}
+
+std::unique_ptr<GlTextureBuffer> GlTextureBuffer::WrapHardwareBuffer(
+    AHardwareBuffer* hardware_buffer, DeletionCallback deletion_callback) {
+  const HardwareBufferFunctions& functions = GetHardwareBufferFunctions();
+  if (!functions.available()) return nullptr;
+
+  AHardwareBuffer_Desc desc;
+  functions.describe(hardware_buffer, &desc);
+  GpuBufferFormat format = GpuBufferFormatForHardwareBufferFormat(desc.format);
+  GLenum target = GL_TEXTURE_2D;
+  if (format == GpuBufferFormat::kUnknown) {
+    // YUV and implementation-defined buffers can only be sampled through
+    // samplerExternalOES, which converts them to RGBA.
+    target = GL_TEXTURE_EXTERNAL_OES;
+    format = GpuBufferFormat::kBGRA32;
+  }
+  auto buf = absl::make_unique<GlTextureBuffer>(
+      target, 0, desc.width, desc.height, format, std::move(deletion_callback));
+  if (!buf->ImportHardwareBuffer(hardware_buffer)) {
+    return nullptr;
+  }
+  return buf;
+}
+
+std::unique_ptr<GlTextureBuffer> GlTextureBuffer::CreateHardwareBacked(
+    int width, int height, GpuBufferFormat format) {
+  const HardwareBufferFunctions& functions = GetHardwareBufferFunctions();
+  const uint32_t hardware_format =
+      HardwareBufferFormatForGpuBufferFormat(format);
+  if (!functions.available() || hardware_format == 0) return nullptr;
+
+  AHardwareBuffer_Desc desc = {};
+  desc.width = width;
+  desc.height = height;
+  desc.layers = 1;
+  desc.format = hardware_format;
+  desc.usage = AHARDWAREBUFFER_USAGE_GPU_SAMPLED_IMAGE |
+               AHARDWAREBUFFER_USAGE_GPU_COLOR_OUTPUT |
+               AHARDWAREBUFFER_USAGE_CPU_READ_RARELY;
+  AHardwareBuffer* hardware_buffer = nullptr;
+  if (functions.allocate(&desc, &hardware_buffer) != 0) return nullptr;
+
+  auto buf = absl::make_unique<GlTextureBuffer>(GL_TEXTURE_2D, 0, width,
+                                                height, format, nullptr);
+  const bool imported = buf->ImportHardwareBuffer(hardware_buffer);
+  // The GlTextureBuffer holds its own reference to the hardware buffer.
+  functions.release(hardware_buffer);
+  if (!imported) return nullptr;
+  return buf;
+}
+#endif  // MEDIAPIPE_GPU_BUFFER_USE_AHWB
+
 std::unique_ptr<GlTextureBuffer> GlTextureBuffer::Wrap(
     GLenum target, GLuint name, int width, int height, GpuBufferFormat format,
     DeletionCallback deletion_callback) {
@@ -85,6 +228,122 @@ bool GlTextureBuffer::CreateInternal(const void* data) {
   return true;
 }
 
+#if MEDIAPIPE_GPU_BUFFER_USE_AHWB
+bool GlTextureBuffer::ImportHardwareBuffer(AHardwareBuffer* hardware_buffer) {
+  const HardwareBufferFunctions& functions = GetHardwareBufferFunctions();
+  auto context = GlContext::GetCurrent();
+  if (!context) return false;
+
+  EGLClientBuffer client_buffer =
+      functions.get_native_client_buffer(hardware_buffer);
+  if (!client_buffer) return false;
+  const EGLint image_attr[] = {EGL_IMAGE_PRESERVED_KHR, EGL_TRUE, EGL_NONE};
+  EGLDisplay display = context->egl_display();
+  EGLImageKHR image =
+      functions.create_image(display, EGL_NO_CONTEXT, EGL_NATIVE_BUFFER_ANDROID,
+                             client_buffer, image_attr);
+  if (image == EGL_NO_IMAGE_KHR) return false;
+
+  glGenTextures(1, &name_);
+  if (!name_) {
+    functions.destroy_image(display, image);
+    return false;
+  }
+  glBindTexture(target_, name_);
+  functions.image_target_texture(target_, static_cast<GLeglImageOES>(image));
+  glBindTexture(target_, 0);
+
+  functions.acquire(hardware_buffer);
+  hardware_buffer_ = hardware_buffer;
+
+  // Delete the texture and the image on the context that created them, then
+  // let the owner of the hardware buffer know that it can be reused.
+  GLuint name_to_delete = name_;
+  DeletionCallback owner_callback = std::move(deletion_callback_);
+  deletion_callback_ = [context, display, image, hardware_buffer,
+                        name_to_delete, owner_callback](
+                           std::shared_ptr<GlSyncPoint> sync_token) {
+    context->RunWithoutWaiting(
+        [display, image, hardware_buffer, name_to_delete, sync_token]() {
+          const HardwareBufferFunctions& functions =
+              GetHardwareBufferFunctions();
+          sync_token->WaitOnGpu();
+          glDeleteTextures(1, &name_to_delete);
+          functions.destroy_image(display, image);
+          functions.release(hardware_buffer);
+        });
+    if (owner_callback) {
+      owner_callback(std::move(sync_token));
+    }
+  };
+  return true;
+}
+#endif  // MEDIAPIPE_GPU_BUFFER_USE_AHWB
+
+#if MEDIAPIPE_GPU_BUFFER_USE_CUDA
+cudaArray_t GlTextureBuffer::MapForCuda(cudaStream_t stream, bool read_only) {
+  if (target_ != GL_TEXTURE_2D) {
+    LOG(ERROR) << "Only GL_TEXTURE_2D textures can be mapped into CUDA.";
+    return nullptr;
+  }
+  cudaError_t error;
+  if (!cuda_resource_) {
+    error = cudaGraphicsGLRegisterImage(&cuda_resource_, name_, target_,
+                                        cudaGraphicsRegisterFlagsNone);
+    if (error != cudaSuccess) {
+      LOG(ERROR) << "cudaGraphicsGLRegisterImage failed: "
+                 << cudaGetErrorString(error);
+      cuda_resource_ = nullptr;
+      return nullptr;
+    }
+  }
+  error = cudaGraphicsResourceSetMapFlags(
+      cuda_resource_, read_only ? cudaGraphicsMapFlagsReadOnly
+                                : cudaGraphicsMapFlagsNone);
+  if (error != cudaSuccess) {
+    LOG(ERROR) << "cudaGraphicsResourceSetMapFlags failed: "
+               << cudaGetErrorString(error);
+    return nullptr;
+  }
+  // Mapping only orders CUDA work after the GL commands of the current
+  // context, so the producer's commands must be waited on here.
+  WaitOnGpu();
+  error = cudaGraphicsMapResources(1, &cuda_resource_, stream);
+  if (error != cudaSuccess) {
+    LOG(ERROR) << "cudaGraphicsMapResources failed: "
+               << cudaGetErrorString(error);
+    return nullptr;
+  }
+  cudaArray_t array = nullptr;
+  error = cudaGraphicsSubResourceGetMappedArray(&array, cuda_resource_,
+                                                /*arrayIndex=*/0,
+                                                /*mipLevel=*/0);
+  if (error != cudaSuccess) {
+    LOG(ERROR) << "cudaGraphicsSubResourceGetMappedArray failed: "
+               << cudaGetErrorString(error);
+    cudaGraphicsUnmapResources(1, &cuda_resource_, stream);
+    return nullptr;
+  }
+  return array;
+}
+
+bool GlTextureBuffer::UnmapFromCuda(cudaStream_t stream) {
+  CHECK(cuda_resource_) << "UnmapFromCuda called before MapForCuda.";
+  cudaError_t error = cudaGraphicsUnmapResources(1, &cuda_resource_, stream);
+  if (error != cudaSuccess) {
+    LOG(ERROR) << "cudaGraphicsUnmapResources failed: "
+               << cudaGetErrorString(error);
+    return false;
+  }
+  // The CUDA work counts as a consumer, so that the buffer is not reused
+  // before it is done.
+  auto context = GlContext::GetCurrent();
+  CHECK(context) << "UnmapFromCuda requires a current GlContext.";
+  DidRead(context->CreateSyncToken());
+  return true;
+}
+#endif  // MEDIAPIPE_GPU_BUFFER_USE_CUDA
+
 void GlTextureBuffer::Reuse() {
   WaitForConsumersOnGpu();
   // TODO: should we just do this inside WaitForConsumersOnGpu?
@@ -105,6 +364,12 @@ void GlTextureBuffer::DidRead(std::shared_ptr<GlSyncPoint> cons_token) {
 }
 
 GlTextureBuffer::~GlTextureBuffer() {
+#if MEDIAPIPE_GPU_BUFFER_USE_CUDA
+  // The texture must stay alive until it is unregistered.
+  if (cuda_resource_) {
+    cudaGraphicsUnregisterResource(cuda_resource_);
+  }
+#endif  // MEDIAPIPE_GPU_BUFFER_USE_CUDA
   if (deletion_callback_) {
     deletion_callback_(std::move(consumer_multi_sync_));
   }
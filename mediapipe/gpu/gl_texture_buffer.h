@@ -25,6 +25,20 @@
 #include "mediapipe/gpu/gl_context.h"
 #include "mediapipe/gpu/gpu_buffer_format.h"
 
+#ifdef __ANDROID__
+// AHardwareBuffer entry points are resolved at runtime, so that this also
+// builds for API levels below 26.
+#define MEDIAPIPE_GPU_BUFFER_USE_AHWB 1
+#include <EGL/eglext.h>
+#include <android/hardware_buffer.h>
+#endif  // __ANDROID__
+
+// MEDIAPIPE_GPU_BUFFER_USE_CUDA is defined by building with
+// --define MEDIAPIPE_CUDA_GL_INTEROP=1.
+#if MEDIAPIPE_GPU_BUFFER_USE_CUDA
+#include <cuda_runtime_api.h>
+#endif  // MEDIAPIPE_GPU_BUFFER_USE_CUDA
+
 namespace mediapipe {
 
 class GlCalculatorHelperImpl;
@@ -57,6 +71,27 @@ class GlTextureBuffer {
                                                  GpuBufferFormat format,
                                                  const void* data = nullptr);
 
+#if MEDIAPIPE_GPU_BUFFER_USE_AHWB
+  // Returns true if AHardwareBuffers can be imported into GL on this device.
+  static bool HardwareBuffersSupported();
+
+  // Wraps an AHardwareBuffer without copying it, by binding an EGLImage of it
+  // to a new texture. The GlTextureBuffer keeps a reference to the hardware
+  // buffer until it is released; deletion_callback is then invoked, so the
+  // caller knows that the buffer is no longer in use. Buffers that GL cannot
+  // sample as RGBA, such as camera YUV buffers, get the target
+  // GL_TEXTURE_EXTERNAL_OES. A GlContext must be current when this is called.
+  // The commands producing the buffer are assumed to be completed at the time
+  // of this call. If not, call Updated on the result.
+  static std::unique_ptr<GlTextureBuffer> WrapHardwareBuffer(
+      AHardwareBuffer* hardware_buffer, DeletionCallback deletion_callback);
+
+  // Like Create, but backs the texture with a newly allocated AHardwareBuffer,
+  // which other APIs can then access without a copy.
+  static std::unique_ptr<GlTextureBuffer> CreateHardwareBacked(
+      int width, int height, GpuBufferFormat format);
+#endif  // MEDIAPIPE_GPU_BUFFER_USE_AHWB
+
   // Wraps an existing texture, but does not take ownership of it.
   // deletion_callback is invoked when the GlTextureBuffer is released, so
   // the caller knows that the texture is no longer in use.
@@ -73,6 +108,27 @@ class GlTextureBuffer {
   int width() const { return width_; }
   int height() const { return height_; }
   GpuBufferFormat format() const { return format_; }
+#if MEDIAPIPE_GPU_BUFFER_USE_AHWB
+  // The AHardwareBuffer backing this texture, or nullptr if there is none.
+  AHardwareBuffer* hardware_buffer() const { return hardware_buffer_; }
+#endif  // MEDIAPIPE_GPU_BUFFER_USE_AHWB
+
+#if MEDIAPIPE_GPU_BUFFER_USE_CUDA
+  // Maps the texture into CUDA, so that CUDA kernels can access it without a
+  // round trip through host memory, and returns the CUDA array holding it, or
+  // nullptr on failure. Work issued to stream afterwards sees the current
+  // contents of the texture. The texture is registered with CUDA on first use
+  // and stays registered while the buffer lives, so buffers recycled by
+  // GpuBufferMultiPool only pay for the registration once. Only GL_TEXTURE_2D
+  // textures can be mapped. A GlContext must be current.
+  cudaArray_t MapForCuda(cudaStream_t stream, bool read_only = true);
+
+  // Unmaps the texture once the CUDA work using it has been issued to stream.
+  // GL commands issued afterwards, including those of a later Reuse, run
+  // after that work. Must be called on the context that mapped the texture
+  // before GL uses it again. Returns true on success.
+  bool UnmapFromCuda(cudaStream_t stream);
+#endif  // MEDIAPIPE_GPU_BUFFER_USE_CUDA
 
   // If this texture is going to be used outside of the context that produced
   // it, this method should be called to ensure that its updated contents are
@@ -118,6 +174,12 @@ class GlTextureBuffer {
   // Returns true on success.
   bool CreateInternal(const void* data = nullptr);
 
+#if MEDIAPIPE_GPU_BUFFER_USE_AHWB
+  // Binds hardware_buffer to a new texture through an EGLImage, and chains
+  // the release of both to the deletion callback. Returns true on success.
+  bool ImportHardwareBuffer(AHardwareBuffer* hardware_buffer);
+#endif  // MEDIAPIPE_GPU_BUFFER_USE_AHWB
+
   friend class GlCalculatorHelperImpl;
 
   GLuint name_ = 0;
@@ -131,6 +193,13 @@ class GlTextureBuffer {
   std::unique_ptr<GlMultiSyncPoint> consumer_multi_sync_ =
       absl::make_unique<GlMultiSyncPoint>();
   DeletionCallback deletion_callback_;
+#if MEDIAPIPE_GPU_BUFFER_USE_AHWB
+  AHardwareBuffer* hardware_buffer_ = nullptr;
+#endif  // MEDIAPIPE_GPU_BUFFER_USE_AHWB
+#if MEDIAPIPE_GPU_BUFFER_USE_CUDA
+  // The CUDA registration of the texture, created by the first MapForCuda.
+  cudaGraphicsResource_t cuda_resource_ = nullptr;
+#endif  // MEDIAPIPE_GPU_BUFFER_USE_CUDA
 };
 
 using GlTextureBufferSharedPtr = std::shared_ptr<GlTextureBuffer>;
@@ -14,23 +14,40 @@
 
 #include "mediapipe/gpu/gl_texture_buffer_pool.h"
 
+#include <algorithm>
+
 #include "absl/synchronization/mutex.h"
 
 namespace mediapipe {
 
 GlTextureBufferPool::GlTextureBufferPool(int width, int height,
-                                         GpuBufferFormat format, int keep_count)
+                                         GpuBufferFormat format, int keep_count,
+                                         bool use_hardware_buffers)
     : width_(width),
       height_(height),
       format_(format),
+      use_hardware_buffers_(use_hardware_buffers),
+      buffer_size_(GpuBufferSize(format, width, height)),
       keep_count_(keep_count) {}
 
+std::unique_ptr<GlTextureBuffer> GlTextureBufferPool::CreateBuffer() {
+#if MEDIAPIPE_GPU_BUFFER_USE_AHWB
+  if (use_hardware_buffers_) {
+    auto buffer =
+        GlTextureBuffer::CreateHardwareBacked(width_, height_, format_);
+    // Fall back to a plain texture for formats without a hardware equivalent.
+    if (buffer) return buffer;
+  }
+#endif  // MEDIAPIPE_GPU_BUFFER_USE_AHWB
+  return GlTextureBuffer::Create(width_, height_, format_);
+}
+
 GlTextureBufferSharedPtr GlTextureBufferPool::GetBuffer() {
   absl::MutexLock lock(&mutex_);
 
   std::unique_ptr<GlTextureBuffer> buffer;
   if (available_.empty()) {
-    buffer = GlTextureBuffer::Create(width_, height_, format_);
+    buffer = CreateBuffer();
     if (!buffer) return nullptr;
   } else {
     buffer = std::move(available_.back());
@@ -39,6 +56,7 @@ GlTextureBufferSharedPtr GlTextureBufferPool::GetBuffer() {
   }
 
   ++in_use_count_;
+  max_in_use_count_ = std::max(max_in_use_count_, in_use_count_);
 
   // Return a shared_ptr with a custom deleter that adds the buffer back
   // to our available list.
@@ -59,6 +77,29 @@ std::pair<int, int> GlTextureBufferPool::GetInUseAndAvailableCounts() {
   return {in_use_count_, available_.size()};
 }
 
+int GlTextureBufferPool::DropAvailable(int max_available) {
+  absl::MutexLock lock(&mutex_);
+  const int num_dropped = std::max(
+      static_cast<int>(available_.size()) - std::max(max_available, 0), 0);
+  available_.resize(available_.size() - num_dropped);
+  return num_dropped;
+}
+
+void GlTextureBufferPool::Preallocate(int count) {
+  absl::MutexLock lock(&mutex_);
+  keep_count_ = std::max(keep_count_, count);
+  while (in_use_count_ + static_cast<int>(available_.size()) < count) {
+    std::unique_ptr<GlTextureBuffer> buffer = CreateBuffer();
+    if (!buffer) return;
+    available_.push_back(std::move(buffer));
+  }
+}
+
+int GlTextureBufferPool::GetMaxInUseCount() {
+  absl::MutexLock lock(&mutex_);
+  return max_in_use_count_;
+}
+
 void GlTextureBufferPool::Return(GlTextureBuffer* buf) {
   absl::MutexLock lock(&mutex_);
   --in_use_count_;
@@ -30,14 +30,16 @@ class GlTextureBufferPool
     : public std::enable_shared_from_this<GlTextureBufferPool> {
  public:
   // Creates a pool. This pool will manage buffers of the specified dimensions,
-  // and will keep keep_count buffers around for reuse.
+  // and will keep keep_count buffers around for reuse. If
+  // use_hardware_buffers is true and the platform supports it, the textures
+  // are backed by AHardwareBuffers.
   // We enforce creation as a shared_ptr so that we can use a weak reference in
   // the buffers' deleters.
-  static std::shared_ptr<GlTextureBufferPool> Create(int width, int height,
-                                                     GpuBufferFormat format,
-                                                     int keep_count) {
-    return std::shared_ptr<GlTextureBufferPool>(
-        new GlTextureBufferPool(width, height, format, keep_count));
+  static std::shared_ptr<GlTextureBufferPool> Create(
+      int width, int height, GpuBufferFormat format, int keep_count,
+      bool use_hardware_buffers = false) {
+    return std::shared_ptr<GlTextureBufferPool>(new GlTextureBufferPool(
+        width, height, format, keep_count, use_hardware_buffers));
   }
 
   // Obtains a buffers. May either be reused or created anew.
@@ -48,12 +50,32 @@ class GlTextureBufferPool
   int height() const { return height_; }
   GpuBufferFormat format() const { return format_; }
 
-  // This method is meant for testing.
+  // Returns the approximate size of the memory used by one buffer.
+  size_t buffer_size() const { return buffer_size_; }
+
+  // Returns the number of buffers in use and the number of buffers available
+  // for reuse.
   std::pair<int, int> GetInUseAndAvailableCounts();
 
+  // Destroys the buffers available for reuse beyond the first
+  // "max_available", and returns how many were destroyed.
+  int DropAvailable(int max_available);
+
+  // Creates buffers until the pool holds at least "count" buffers, in use or
+  // available, and raises the number of buffers kept for reuse to "count".
+  // This moves the allocations of the first frames to graph startup.
+  // A GlContext must be current when this is called.
+  void Preallocate(int count);
+
+  // Returns the largest number of buffers that were in use at the same time.
+  int GetMaxInUseCount();
+
  private:
   GlTextureBufferPool(int width, int height, GpuBufferFormat format,
-                      int keep_count);
+                      int keep_count, bool use_hardware_buffers);
+
+  // Allocates a new buffer.
+  std::unique_ptr<GlTextureBuffer> CreateBuffer();
 
   // Return a buffer to the pool.
   void Return(GlTextureBuffer* buf);
@@ -65,10 +87,13 @@ class GlTextureBufferPool
   const int width_;
   const int height_;
   const GpuBufferFormat format_;
-  const int keep_count_;
+  const bool use_hardware_buffers_;
+  const size_t buffer_size_;
 
   absl::Mutex mutex_;
+  int keep_count_ GUARDED_BY(mutex_);
   int in_use_count_ GUARDED_BY(mutex_) = 0;
+  int max_in_use_count_ GUARDED_BY(mutex_) = 0;
   std::vector<std::unique_ptr<GlTextureBuffer>> available_ GUARDED_BY(mutex_);
 };
 
@@ -0,0 +1,131 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/gpu/gl_timer_queries.h"
+
+#include <string>
+#include <utility>
+
+#include "mediapipe/framework/port/logging.h"
+
+// GL_TIME_ELAPSED and GL_TIME_ELAPSED_EXT share the same value.
+#ifndef GL_TIME_ELAPSED_EXT
+#define GL_TIME_ELAPSED_EXT 0x88BF
+#endif  // GL_TIME_ELAPSED_EXT
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif  // GL_GPU_DISJOINT_EXT
+
+namespace mediapipe {
+
+GlTimerQueries::GlTimerQueries(
+    std::shared_ptr<ProfilingContext> profiling_context)
+    : profiling_context_(std::move(profiling_context)) {}
+
+bool GlTimerQueries::IsSupported() {
+  if (support_ != Support::kUnknown) {
+    return support_ != Support::kUnsupported;
+  }
+  support_ = Support::kUnsupported;
+#if !HAS_EAGL
+  // Timer queries and glGetStringi require OpenGL (ES) 3.
+  GLint major_version = 0;
+  GLint minor_version = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major_version);
+  if (glGetError() != GL_NO_ERROR || major_version < 3) {
+    return false;
+  }
+  glGetIntegerv(GL_MINOR_VERSION, &minor_version);
+#if HAS_NSGL
+  if (major_version > 3 || minor_version >= 3) {
+    support_ = Support::kTimerQuery;
+  }
+#endif  // HAS_NSGL
+  GLint num_extensions = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions);
+  for (int i = 0; i < num_extensions; ++i) {
+    const std::string extension(
+        reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)));
+    if (extension == "GL_EXT_disjoint_timer_query" ||
+        extension == "GL_EXT_disjoint_timer_query_webgl2") {
+      support_ = Support::kDisjointTimerQuery;
+      break;
+    }
+    if (extension == "GL_ARB_timer_query") {
+      support_ = Support::kTimerQuery;
+    }
+  }
+#endif  // !HAS_EAGL
+  LOG(INFO) << "GL timer queries are "
+            << (support_ == Support::kUnsupported ? "not " : "")
+            << "supported.";
+  return support_ != Support::kUnsupported;
+}
+
+void GlTimerQueries::Begin(int node_id, Timestamp input_timestamp) {
+  if (depth_++ > 0 || !IsSupported()) {
+    return;
+  }
+  CollectResults();
+  GLuint query;
+  if (free_queries_.empty()) {
+    glGenQueries(1, &query);
+  } else {
+    query = free_queries_.back();
+    free_queries_.pop_back();
+  }
+  pending_queries_.push_back(
+      {query, node_id, input_timestamp, profiling_context_->TimeNow()});
+  glBeginQuery(GL_TIME_ELAPSED_EXT, query);
+  is_timing_ = true;
+}
+
+void GlTimerQueries::End() {
+  if (--depth_ > 0 || !is_timing_) {
+    return;
+  }
+  glEndQuery(GL_TIME_ELAPSED_EXT);
+  is_timing_ = false;
+}
+
+void GlTimerQueries::CollectResults() {
+  // Reading GL_GPU_DISJOINT_EXT also clears it.
+  bool disjoint = false;
+  if (support_ == Support::kDisjointTimerQuery) {
+    GLint gpu_disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &gpu_disjoint);
+    disjoint = gpu_disjoint != 0;
+  }
+  // Queries complete in order, so stop at the first unavailable result.
+  while (!pending_queries_.empty()) {
+    const PendingQuery& pending = pending_queries_.front();
+    GLuint available = 0;
+    glGetQueryObjectuiv(pending.query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+      break;
+    }
+    GLuint elapsed_nsec = 0;
+    glGetQueryObjectuiv(pending.query, GL_QUERY_RESULT, &elapsed_nsec);
+    if (!disjoint) {
+      profiling_context_->AddGpuTaskSample(pending.node_id,
+                                           pending.input_timestamp,
+                                           pending.start_time,
+                                           absl::Nanoseconds(elapsed_nsec));
+    }
+    free_queries_.push_back(pending.query);
+    pending_queries_.pop_front();
+  }
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,87 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_GPU_GL_TIMER_QUERIES_H_
+#define MEDIAPIPE_GPU_GL_TIMER_QUERIES_H_
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "mediapipe/framework/mediapipe_profiling.h"
+#include "mediapipe/framework/timestamp.h"
+#include "mediapipe/gpu/gl_base.h"
+
+namespace mediapipe {
+
+// Measures the GPU-side runtime of the GL tasks of calculators with
+// GL_TIME_ELAPSED timer queries, and reports them to the ProfilingContext.
+//
+// Timer queries are available with OpenGL 3.3, ARB_timer_query, or
+// EXT_disjoint_timer_query on OpenGL ES 3. Elsewhere, this class does nothing.
+// The results become available a few frames later, so each call collects the
+// results of earlier tasks without waiting for the GPU.
+//
+// All methods must be called on the thread where the GL context is current.
+// The query objects are released along with the GL context.
+class GlTimerQueries {
+ public:
+  explicit GlTimerQueries(std::shared_ptr<ProfilingContext> profiling_context);
+
+  // Starts timing the GL commands of calculator "node_id" for
+  // "input_timestamp". Timer queries cannot be nested, so only the outermost
+  // task is timed.
+  void Begin(int node_id, Timestamp input_timestamp);
+
+  // Stops timing the GL commands started by the matching Begin().
+  void End();
+
+ private:
+  // A timer query that has been issued but not yet reported.
+  struct PendingQuery {
+    GLuint query;
+    int node_id;
+    Timestamp input_timestamp;
+    // The profiler clock time at which the task started.
+    absl::Time start_time;
+  };
+
+  // Returns true if timer queries are supported by the current GL context.
+  bool IsSupported();
+
+  // Reports the results of the pending queries that are available.
+  void CollectResults();
+
+  std::shared_ptr<ProfilingContext> profiling_context_;
+  // Whether timer queries are supported, once determined. Disjoint timer
+  // queries must be discarded when the GPU reports a disjoint operation.
+  enum class Support {
+    kUnknown,
+    kUnsupported,
+    kTimerQuery,
+    kDisjointTimerQuery
+  };
+  Support support_ = Support::kUnknown;
+  // The number of nested Begin() calls.
+  int depth_ = 0;
+  // True if the outermost Begin() issued a query.
+  bool is_timing_ = false;
+  std::deque<PendingQuery> pending_queries_;
+  std::vector<GLuint> free_queries_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_GPU_GL_TIMER_QUERIES_H_
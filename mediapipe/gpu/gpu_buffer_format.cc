@@ -176,6 +176,32 @@ const GlTextureInfo& GlTextureInfoForGpuBufferFormat(GpuBufferFormat format,
   return planes[plane];
 }
 
+size_t GpuBufferSize(GpuBufferFormat format, int width, int height) {
+  const size_t num_pixels = static_cast<size_t>(width) * height;
+  switch (format) {
+    case GpuBufferFormat::kOneComponent8:
+      return num_pixels;
+    case GpuBufferFormat::kBiPlanar420YpCbCr8VideoRange:
+    case GpuBufferFormat::kBiPlanar420YpCbCr8FullRange:
+      return num_pixels * 3 / 2;
+    case GpuBufferFormat::kGrayHalf16:
+      return num_pixels * 2;
+    case GpuBufferFormat::kRGB24:
+      return num_pixels * 3;
+    case GpuBufferFormat::kBGRA32:
+    case GpuBufferFormat::kGrayFloat32:
+    case GpuBufferFormat::kTwoComponentHalf16:
+      return num_pixels * 4;
+    case GpuBufferFormat::kRGBAHalf64:
+      return num_pixels * 8;
+    case GpuBufferFormat::kRGBAFloat128:
+      return num_pixels * 16;
+    case GpuBufferFormat::kUnknown:
+      return 0;
+  }
+  return 0;
+}
+
 ImageFormat::Format ImageFormatForGpuBufferFormat(GpuBufferFormat format) {
   switch (format) {
     case GpuBufferFormat::kBGRA32:
@@ -65,6 +65,10 @@ const GlTextureInfo& GlTextureInfoForGpuBufferFormat(GpuBufferFormat format,
                                                      int plane,
                                                      GlVersion gl_version);
 
+// Returns the approximate number of bytes of a buffer of "format" with
+// "width" x "height" pixels, as drivers may pad rows or planes.
+size_t GpuBufferSize(GpuBufferFormat format, int width, int height);
+
 ImageFormat::Format ImageFormatForGpuBufferFormat(GpuBufferFormat format);
 GpuBufferFormat GpuBufferFormatForImageFormat(ImageFormat::Format format);
 
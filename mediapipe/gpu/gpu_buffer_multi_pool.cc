@@ -19,6 +19,7 @@
 #include "absl/memory/memory.h"
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/profiler/payload_size.h"
 #include "mediapipe/gpu/gpu_shared_data_internal.h"
 
 #ifdef __APPLE__
@@ -30,18 +31,22 @@ namespace mediapipe {
 // Keep this many buffers allocated for a given frame size.
 static constexpr int kKeepCount = 2;
 // The maximum size of the GpuBufferMultiPool. When the limit is reached, the
-// oldest BufferSpec will be dropped.
+// least recently used BufferSpec will be dropped.
 static constexpr int kMaxPoolCount = 20;
 
+REGISTER_PAYLOAD_SIZE(GpuBuffer, [](const GpuBuffer& buffer) {
+  return static_cast<int64>(
+      GpuBufferSize(buffer.format(), buffer.width(), buffer.height()));
+});
+
 #if MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
 
 GpuBufferMultiPool::SimplePool GpuBufferMultiPool::MakeSimplePool(
     BufferSpec spec) {
   OSType cv_format = CVPixelFormatForGpuBufferFormat(spec.format);
   CHECK_NE(cv_format, -1) << "unsupported pixel format";
-  return MakeCFHolderAdopting(
-      CreateCVPixelBufferPool(spec.width, spec.height, cv_format, kKeepCount,
-                              0.1 /* max age in seconds */));
+  return PixelBufferPoolRegistry::Get().GetPool(spec.width, spec.height,
+                                                cv_format);
 }
 
 GpuBuffer GpuBufferMultiPool::GetBufferFromSimplePool(
@@ -68,7 +73,7 @@ GpuBuffer GpuBufferMultiPool::GetBufferFromSimplePool(
   static CFDictionaryRef auxAttributes =
       CreateCVPixelBufferPoolAuxiliaryAttributesForThreshold(kKeepCount);
   CVReturn err = CreateCVPixelBufferWithPool(
-      *pool, auxAttributes,
+      **pool, auxAttributes,
       [this]() {
         for (const auto& cache : texture_caches_) {
 #if TARGET_OS_OSX
@@ -88,8 +93,13 @@ GpuBuffer GpuBufferMultiPool::GetBufferFromSimplePool(
 
 GpuBufferMultiPool::SimplePool GpuBufferMultiPool::MakeSimplePool(
     BufferSpec spec) {
+#if MEDIAPIPE_GPU_BUFFER_USE_AHWB
+  return GlTextureBufferPool::Create(spec.width, spec.height, spec.format,
+                                     kKeepCount, use_hardware_buffers_);
+#else
   return GlTextureBufferPool::Create(spec.width, spec.height, spec.format,
                                      kKeepCount);
+#endif  // MEDIAPIPE_GPU_BUFFER_USE_AHWB
 }
 
 GpuBuffer GpuBufferMultiPool::GetBufferFromSimplePool(
@@ -99,26 +109,128 @@ GpuBuffer GpuBufferMultiPool::GetBufferFromSimplePool(
 
 #endif  // MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
 
-GpuBuffer GpuBufferMultiPool::GetBuffer(int width, int height,
-                                        GpuBufferFormat format) {
-  absl::MutexLock lock(&mutex_);
-  BufferSpec key(width, height, format);
+const GpuBufferMultiPool::SimplePool& GpuBufferMultiPool::GetSimplePool(
+    BufferSpec key) {
   auto pool_it = pools_.find(key);
   if (pool_it == pools_.end()) {
-    // Discard the oldest pool in order of creation.
-    // TODO: implement a better policy.
+    // Discard the least recently used pool. Its buffers in use are destroyed
+    // when released.
     if (pools_.size() >= kMaxPoolCount) {
-      auto old_spec = buffer_specs_.front();
-      buffer_specs_.pop();
-      pools_.erase(old_spec);
+      pools_.erase(use_order_.back());
+      use_order_.pop_back();
     }
-    buffer_specs_.push(key);
-    std::tie(pool_it, std::ignore) =
-        pools_.emplace(std::piecewise_construct, std::forward_as_tuple(key),
-                       std::forward_as_tuple(MakeSimplePool(key)));
+    use_order_.push_front(key);
+    std::tie(pool_it, std::ignore) = pools_.emplace(
+        key, PoolEntry{MakeSimplePool(key), use_order_.begin()});
+  } else {
+    use_order_.splice(use_order_.begin(), use_order_,
+                      pool_it->second.use_position);
+  }
+  return pool_it->second.pool;
+}
+
+GpuBuffer GpuBufferMultiPool::GetBuffer(int width, int height,
+                                        GpuBufferFormat format) {
+  absl::MutexLock lock(&mutex_);
+  BufferSpec key(width, height, format);
+  GpuBuffer buffer = GetBufferFromSimplePool(key, GetSimplePool(key));
+#if !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
+  TrimAvailable();
+#endif  // !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
+  return buffer;
+}
+
+#if !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
+void GpuBufferMultiPool::SetMaxAvailableBytes(size_t max_bytes) {
+  absl::MutexLock lock(&mutex_);
+  max_available_bytes_ = max_bytes;
+  TrimAvailable();
+}
+
+std::unordered_map<BufferSpec, std::pair<int, int>, BufferSpecHash>
+GpuBufferMultiPool::GetInUseAndAvailableCounts() {
+  absl::MutexLock lock(&mutex_);
+  std::unordered_map<BufferSpec, std::pair<int, int>, BufferSpecHash> counts;
+  for (const auto& spec_and_entry : pools_) {
+    counts.emplace(spec_and_entry.first,
+                   spec_and_entry.second.pool->GetInUseAndAvailableCounts());
+  }
+  return counts;
+}
+
+std::unordered_map<BufferSpec, int, BufferSpecHash>
+GpuBufferMultiPool::GetMaxInUseCounts() {
+  absl::MutexLock lock(&mutex_);
+  std::unordered_map<BufferSpec, int, BufferSpecHash> counts;
+  for (const auto& spec_and_entry : pools_) {
+    counts.emplace(spec_and_entry.first,
+                   spec_and_entry.second.pool->GetMaxInUseCount());
+  }
+  return counts;
+}
+
+void GpuBufferMultiPool::Preallocate(BufferSpec spec, int count) {
+  absl::MutexLock lock(&mutex_);
+  GetSimplePool(spec)->Preallocate(count);
+}
+
+size_t GpuBufferMultiPool::GetAvailableBytes() {
+  absl::MutexLock lock(&mutex_);
+  size_t available_bytes = 0;
+  for (const auto& spec_and_entry : pools_) {
+    const SimplePool& pool = spec_and_entry.second.pool;
+    available_bytes +=
+        pool->GetInUseAndAvailableCounts().second * pool->buffer_size();
+  }
+  return available_bytes;
+}
+
+size_t GpuBufferMultiPool::GetInUseBytes() {
+  absl::MutexLock lock(&mutex_);
+  size_t in_use_bytes = 0;
+  for (const auto& spec_and_entry : pools_) {
+    const SimplePool& pool = spec_and_entry.second.pool;
+    in_use_bytes +=
+        pool->GetInUseAndAvailableCounts().first * pool->buffer_size();
+  }
+  return in_use_bytes;
+}
+
+#if MEDIAPIPE_GPU_BUFFER_USE_AHWB
+void GpuBufferMultiPool::SetUseHardwareBuffers(bool use_hardware_buffers) {
+  absl::MutexLock lock(&mutex_);
+  use_hardware_buffers_ =
+      use_hardware_buffers && GlTextureBuffer::HardwareBuffersSupported();
+  pools_.clear();
+  use_order_.clear();
+}
+#endif  // MEDIAPIPE_GPU_BUFFER_USE_AHWB
+
+void GpuBufferMultiPool::TrimAvailable() {
+  if (max_available_bytes_ == std::numeric_limits<size_t>::max()) {
+    return;
+  }
+  size_t available_bytes = 0;
+  for (const auto& spec_and_entry : pools_) {
+    const SimplePool& pool = spec_and_entry.second.pool;
+    available_bytes +=
+        pool->GetInUseAndAvailableCounts().second * pool->buffer_size();
+  }
+  for (auto it = use_order_.rbegin();
+       it != use_order_.rend() && available_bytes > max_available_bytes_;
+       ++it) {
+    const SimplePool& pool = pools_.find(*it)->second.pool;
+    const size_t buffer_size = pool->buffer_size();
+    if (buffer_size == 0) continue;
+    // Keep as many of this spec's buffers as still fit.
+    const size_t excess_bytes = available_bytes - max_available_bytes_;
+    const int num_excess = (excess_bytes + buffer_size - 1) / buffer_size;
+    const int num_available = pool->GetInUseAndAvailableCounts().second;
+    available_bytes -=
+        pool->DropAvailable(num_available - num_excess) * buffer_size;
   }
-  return GetBufferFromSimplePool(pool_it->first, pool_it->second);
 }
+#endif  // !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
 
 GpuBufferMultiPool::~GpuBufferMultiPool() {
 #ifdef __APPLE__
@@ -23,8 +23,9 @@
 #define MEDIAPIPE_GPU_GPU_BUFFER_MULTI_POOL_H_
 
 #include <limits>
-#include <queue>
+#include <list>
 #include <unordered_map>
+#include <utility>
 
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/gpu/gpu_buffer.h"
@@ -33,6 +34,10 @@
 #include "mediapipe/gpu/pixel_buffer_pool_util.h"
 #endif  // __APPLE__
 
+#if MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
+#include "mediapipe/gpu/pixel_buffer_pool_registry.h"
+#endif  // MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
+
 #if !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
 #include "mediapipe/gpu/gl_texture_buffer_pool.h"
 #endif  // !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
@@ -84,6 +89,43 @@ class GpuBufferMultiPool {
   GpuBuffer GetBuffer(int width, int height,
                       GpuBufferFormat format = GpuBufferFormat::kBGRA32);
 
+#if !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
+  // Limits the memory held by the buffers kept for reuse, across all buffer
+  // specs, to about "max_bytes". When GetBuffer() finds the limit exceeded,
+  // it destroys the kept buffers of the least recently used specs first.
+  // Buffers in use are not counted. There is no limit by default.
+  void SetMaxAvailableBytes(size_t max_bytes);
+
+  // Returns the number of buffers in use and the number of buffers available
+  // for reuse, for each buffer spec in the pool.
+  std::unordered_map<BufferSpec, std::pair<int, int>, BufferSpecHash>
+  GetInUseAndAvailableCounts();
+
+  // Returns the largest number of buffers in use at the same time, for each
+  // buffer spec in the pool. After a representative run, this is the count
+  // to preallocate for each spec in the next runs.
+  std::unordered_map<BufferSpec, int, BufferSpecHash> GetMaxInUseCounts();
+
+  // Allocates buffers so that at least "count" buffers of "spec" exist, and
+  // keeps that many for reuse, instead of allocating them on first use.
+  // A GlContext must be current when this is called.
+  void Preallocate(BufferSpec spec, int count);
+
+  // Returns the approximate memory held by the buffers available for reuse.
+  size_t GetAvailableBytes();
+
+  // Returns the approximate memory held by the buffers in use.
+  size_t GetInUseBytes();
+#endif  // !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
+
+#if MEDIAPIPE_GPU_BUFFER_USE_AHWB
+  // Backs the buffers created from now on with AHardwareBuffers, which other
+  // APIs can access without a copy. Existing pools are discarded; their
+  // buffers in use are destroyed when released. Has no effect on devices
+  // that cannot import AHardwareBuffers into GL.
+  void SetUseHardwareBuffers(bool use_hardware_buffers);
+#endif  // MEDIAPIPE_GPU_BUFFER_USE_AHWB
+
 #ifdef __APPLE__
   // TODO: add tests for the texture cache registration.
 
@@ -97,20 +139,43 @@ class GpuBufferMultiPool {
 
  private:
 #if MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
-  typedef CFHolder<CVPixelBufferPoolRef> SimplePool;
+  // Shared with the other graphs through the PixelBufferPoolRegistry.
+  typedef PixelBufferPoolRegistry::Pool SimplePool;
 #else
   typedef std::shared_ptr<GlTextureBufferPool> SimplePool;
 #endif  // MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
 
-  SimplePool MakeSimplePool(BufferSpec spec);
+  // A pool for one BufferSpec, and its position in the use order.
+  struct PoolEntry {
+    SimplePool pool;
+    std::list<BufferSpec>::iterator use_position;
+  };
+
+  SimplePool MakeSimplePool(BufferSpec spec) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Returns the pool for "spec", creating it if needed, and marks it as the
+  // most recently used.
+  const SimplePool& GetSimplePool(BufferSpec spec)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
   GpuBuffer GetBufferFromSimplePool(BufferSpec spec, const SimplePool& pool);
 
+#if !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
+  // Destroys available buffers, starting with the least recently used specs,
+  // until the available buffers fit in max_available_bytes_.
+  void TrimAvailable() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+#endif  // !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
+
   absl::Mutex mutex_;
-  std::unordered_map<BufferSpec, SimplePool, BufferSpecHash> pools_
+  std::unordered_map<BufferSpec, PoolEntry, BufferSpecHash> pools_
       GUARDED_BY(mutex_);
-  // A queue of BufferSpecs to keep track of the age of each BufferSpec added to
-  // the pool.
-  std::queue<BufferSpec> buffer_specs_;
+  // The BufferSpecs in the pool, from the most to the least recently used.
+  std::list<BufferSpec> use_order_ GUARDED_BY(mutex_);
+#if !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
+  size_t max_available_bytes_ GUARDED_BY(mutex_) =
+      std::numeric_limits<size_t>::max();
+#endif  // !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
+#if MEDIAPIPE_GPU_BUFFER_USE_AHWB
+  bool use_hardware_buffers_ GUARDED_BY(mutex_) = false;
+#endif  // MEDIAPIPE_GPU_BUFFER_USE_AHWB
 
 #ifdef __APPLE__
   // Texture caches used with this pool.
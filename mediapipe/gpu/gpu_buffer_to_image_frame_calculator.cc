@@ -12,8 +12,15 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <vector>
+
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/gpu/gpu_buffer_to_image_frame_calculator.pb.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
 
@@ -24,9 +31,32 @@
 
 #include "mediapipe/gpu/gl_calculator_helper.h"
 
+// Pixel buffer objects and fences need OpenGL ES 3.0, and WebGL cannot map
+// buffers.
+#if !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER && !defined(__EMSCRIPTEN__)
+#define HAVE_ASYNC_READBACK 1
+#endif
+
 namespace mediapipe {
 
 // Convert an input image (GpuBuffer or ImageFrame) to ImageFrame.
+//
+// By default each GpuBuffer is read back synchronously, which stalls the GL
+// thread until the GPU has rendered it. With num_pending_readbacks set, the
+// calculator instead copies it into a pixel buffer object and outputs its
+// ImageFrame a few frames later, once the copy has completed.
+//
+// Example config:
+// node {
+//   calculator: "GpuBufferToImageFrameCalculator"
+//   input_stream: "input_video_gpu"
+//   output_stream: "input_video"
+//   options: {
+//     [mediapipe.GpuBufferToImageFrameCalculatorOptions.ext] {
+//       num_pending_readbacks: 1
+//     }
+//   }
+// }
 class GpuBufferToImageFrameCalculator : public CalculatorBase {
  public:
   GpuBufferToImageFrameCalculator() {}
@@ -35,11 +65,37 @@ class GpuBufferToImageFrameCalculator : public CalculatorBase {
 
   ::mediapipe::Status Open(CalculatorContext* cc) override;
   ::mediapipe::Status Process(CalculatorContext* cc) override;
+  ::mediapipe::Status Close(CalculatorContext* cc) override;
 
  private:
 #if !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
   GlCalculatorHelper helper_;
 #endif  // MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
+
+#if HAVE_ASYNC_READBACK
+  // A frame being copied into a pixel buffer object.
+  struct PendingReadback {
+    std::unique_ptr<ImageFrame> frame;
+    Timestamp timestamp;
+    GLuint pixel_buffer;
+    GLsync fence;
+  };
+
+  // Starts copying "input" into a pixel buffer object. Must be called in the
+  // GL context.
+  void StartReadback(const GpuBuffer& input, Timestamp timestamp);
+  // Waits for the oldest pending readback, and outputs its frame. Must be
+  // called in the GL context.
+  void FinishReadback(CalculatorContext* cc);
+  // Outputs the pending frames that have been copied, and waits for the oldest
+  // ones until at most "max_pending" remain. Must be called in the GL context.
+  void FinishReadbacks(CalculatorContext* cc, int max_pending);
+
+  int num_pending_readbacks_ = 0;
+  std::deque<PendingReadback> pending_readbacks_;
+  // Pixel buffer objects not used by a pending readback, with their sizes.
+  std::vector<std::pair<GLuint, GLsizeiptr>> free_pixel_buffers_;
+#endif  // HAVE_ASYNC_READBACK
 };
 REGISTER_CALCULATOR(GpuBufferToImageFrameCalculator);
 
@@ -57,18 +113,40 @@ REGISTER_CALCULATOR(GpuBufferToImageFrameCalculator);
 
 ::mediapipe::Status GpuBufferToImageFrameCalculator::Open(
     CalculatorContext* cc) {
-  // Inform the framework that we always output at the same timestamp
-  // as we receive a packet at.
-  cc->SetOffset(TimestampDiff(0));
 #if !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
   MP_RETURN_IF_ERROR(helper_.Open(cc));
 #endif  // MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
+#if HAVE_ASYNC_READBACK
+  const auto& options =
+      cc->Options<GpuBufferToImageFrameCalculatorOptions>();
+  RET_CHECK_GE(options.num_pending_readbacks(), 0);
+  if (options.num_pending_readbacks() > 0) {
+    if (helper_.GetGlContext().gl_major_version() >= 3) {
+      num_pending_readbacks_ = options.num_pending_readbacks();
+    } else {
+      LOG(WARNING) << "Asynchronous readback needs OpenGL ES 3.0, reading "
+                      "back synchronously.";
+    }
+  }
+  if (num_pending_readbacks_ > 0) {
+    return ::mediapipe::OkStatus();
+  }
+#endif  // HAVE_ASYNC_READBACK
+  // Inform the framework that we always output at the same timestamp
+  // as we receive a packet at.
+  cc->SetOffset(TimestampDiff(0));
   return ::mediapipe::OkStatus();
 }
 
 ::mediapipe::Status GpuBufferToImageFrameCalculator::Process(
     CalculatorContext* cc) {
   if (cc->Inputs().Index(0).Value().ValidateAsType<ImageFrame>().ok()) {
+#if HAVE_ASYNC_READBACK
+    // Earlier frames must be output first.
+    if (!pending_readbacks_.empty()) {
+      helper_.RunInGlContext([this, &cc]() { FinishReadbacks(cc, 0); });
+    }
+#endif  // HAVE_ASYNC_READBACK
     cc->Outputs().Index(0).AddPacket(cc->Inputs().Index(0).Value());
     return ::mediapipe::OkStatus();
   }
@@ -81,6 +159,15 @@ REGISTER_CALCULATOR(GpuBufferToImageFrameCalculator);
         CreateImageFrameForCVPixelBuffer(input.GetCVPixelBufferRef());
     cc->Outputs().Index(0).Add(frame.release(), cc->InputTimestamp());
 #else
+#if HAVE_ASYNC_READBACK
+    if (num_pending_readbacks_ > 0) {
+      helper_.RunInGlContext([this, &input, &cc]() {
+        StartReadback(input, cc->InputTimestamp());
+        FinishReadbacks(cc, num_pending_readbacks_);
+      });
+      return ::mediapipe::OkStatus();
+    }
+#endif  // HAVE_ASYNC_READBACK
     helper_.RunInGlContext([this, &input, &cc]() {
       auto src = helper_.CreateSourceTexture(input);
       std::unique_ptr<ImageFrame> frame = absl::make_unique<ImageFrame>(
@@ -103,4 +190,101 @@ REGISTER_CALCULATOR(GpuBufferToImageFrameCalculator);
                              "Input packets must be ImageFrame or GpuBuffer.");
 }
 
+::mediapipe::Status GpuBufferToImageFrameCalculator::Close(
+    CalculatorContext* cc) {
+#if HAVE_ASYNC_READBACK
+  if (num_pending_readbacks_ > 0) {
+    helper_.RunInGlContext([this, &cc]() {
+      FinishReadbacks(cc, 0);
+      for (const auto& pixel_buffer : free_pixel_buffers_) {
+        glDeleteBuffers(1, &pixel_buffer.first);
+      }
+      free_pixel_buffers_.clear();
+    });
+  }
+#endif  // HAVE_ASYNC_READBACK
+  return ::mediapipe::OkStatus();
+}
+
+#if HAVE_ASYNC_READBACK
+void GpuBufferToImageFrameCalculator::StartReadback(const GpuBuffer& input,
+                                                    Timestamp timestamp) {
+  auto src = helper_.CreateSourceTexture(input);
+  PendingReadback readback;
+  readback.frame = absl::make_unique<ImageFrame>(
+      ImageFormatForGpuBufferFormat(input.format()), src.width(), src.height(),
+      ImageFrame::kGlDefaultAlignmentBoundary);
+  readback.timestamp = timestamp;
+  const GLsizeiptr size = readback.frame->PixelDataSize();
+
+  // Reuse a free pixel buffer object, reallocating its storage if the frame
+  // size has changed.
+  GLsizeiptr allocated_size = 0;
+  if (free_pixel_buffers_.empty()) {
+    glGenBuffers(1, &readback.pixel_buffer);
+  } else {
+    readback.pixel_buffer = free_pixel_buffers_.back().first;
+    allocated_size = free_pixel_buffers_.back().second;
+    free_pixel_buffers_.pop_back();
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pixel_buffer);
+  if (allocated_size != size) {
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+  }
+
+  // With a pixel pack buffer bound, glReadPixels returns without waiting for
+  // the GPU, and the data pointer is an offset into the buffer.
+  helper_.BindFramebuffer(src);
+  const auto info = GlTextureInfoForGpuBufferFormat(input.format(), 0);
+  glReadPixels(0, 0, src.width(), src.height(), info.gl_format, info.gl_type,
+               nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  glFlush();
+  src.Release();
+  pending_readbacks_.push_back(std::move(readback));
+}
+
+void GpuBufferToImageFrameCalculator::FinishReadback(CalculatorContext* cc) {
+  PendingReadback readback = std::move(pending_readbacks_.front());
+  pending_readbacks_.pop_front();
+  glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                   std::numeric_limits<GLuint64>::max());
+  glDeleteSync(readback.fence);
+
+  const GLsizeiptr size = readback.frame->PixelDataSize();
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pixel_buffer);
+  const void* pixels =
+      glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+  if (pixels) {
+    std::memcpy(readback.frame->MutablePixelData(), pixels, size);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  } else {
+    LOG(ERROR) << "Failed to map the pixel buffer of frame at "
+               << readback.timestamp;
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  free_pixel_buffers_.emplace_back(readback.pixel_buffer, size);
+
+  if (pixels) {
+    cc->Outputs().Index(0).Add(readback.frame.release(), readback.timestamp);
+  }
+}
+
+void GpuBufferToImageFrameCalculator::FinishReadbacks(CalculatorContext* cc,
+                                                      int max_pending) {
+  while (!pending_readbacks_.empty()) {
+    if (pending_readbacks_.size() <= max_pending) {
+      // Only finish the readbacks that would not block.
+      const GLenum status =
+          glClientWaitSync(pending_readbacks_.front().fence, 0, 0);
+      if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+        break;
+      }
+    }
+    FinishReadback(cc);
+  }
+}
+#endif  // HAVE_ASYNC_READBACK
+
 }  // namespace mediapipe
@@ -14,9 +14,14 @@
 
 #include "mediapipe/gpu/gpu_shared_data_internal.h"
 
+#include <algorithm>
+
+#include "mediapipe/framework/calculator_profile.pb.h"
 #include "mediapipe/framework/deps/no_destructor.h"
 #include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/validated_graph_config.h"
 #include "mediapipe/gpu/gl_context_options.pb.h"
+#include "mediapipe/gpu/gpu_buffer_pool_options.pb.h"
 #include "mediapipe/gpu/graph_support.h"
 
 #if __APPLE__
@@ -25,6 +30,10 @@
 
 namespace mediapipe {
 
+#if !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
+static constexpr char kGpuBufferPoolName[] = "gpu_buffer_pool";
+#endif  // !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
+
 #if __APPLE__
 static constexpr bool kGlContextUseDedicatedThread = false;
 #elif defined(__EMSCRIPTEN__)
@@ -91,6 +100,13 @@ GpuResources::GpuResources(std::shared_ptr<GlContext> gl_context) {
 }
 
 GpuResources::~GpuResources() {
+#if !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
+  for (const auto& weak_profiler : pool_profilers_) {
+    if (auto profiler = weak_profiler.lock()) {
+      profiler->RemoveBufferPool(kGpuBufferPoolName);
+    }
+  }
+#endif  // !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
 #if __APPLE__
   // Note: on Apple platforms, this object contains Objective-C objects. The
   // destructor will release them, but ARC must be on.
@@ -115,8 +131,17 @@ void GpuResources::PrepareGpuNode(CalculatorNode* node) {
                           (node_type == "GpuBufferToImageFrameCalculator") ||
                           (node_type == "GlSurfaceSinkCalculator");
 
+  // A node executor of the form "gpu:<name>" selects the same context as the
+  // gl_context_name option.
+  const std::string& node_executor = node->Executor();
+  const bool uses_context_executor =
+      ValidatedGraphConfig::IsGlContextExecutorName(node_executor);
   const auto& options = node->GetCalculatorState().Options<GlContextOptions>();
-  if (options.has_gl_context_name() && !options.gl_context_name().empty()) {
+  if (uses_context_executor) {
+    context_key = absl::StrCat(
+        "user:", node_executor.substr(sizeof(kGlContextExecutorPrefix) - 1));
+  } else if (options.has_gl_context_name() &&
+             !options.gl_context_name().empty()) {
     context_key = absl::StrCat("user:", options.gl_context_name());
   } else if (gets_own_context) {
     context_key = absl::StrCat("auto:", node_type);
@@ -136,10 +161,84 @@ void GpuResources::PrepareGpuNode(CalculatorNode* node) {
           executor_name,
           std::make_shared<GlContextExecutor>(gl_context(context_key).get()));
     }
+  } else if (uses_context_executor) {
+    // Without dedicated GL threads, GPU calculators run on the default
+    // executor.
+    node->SetExecutor("");
+  }
+  const std::shared_ptr<ProfilingContext>& profiler =
+      node->GetCalculatorState().GetSharedProfilingContext();
+  gl_context(context_key)->SetProfilingContext(profiler);
+#if !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
+  // Report the pool occupancy once to each graph that profiles memory.
+  if (profiler && profiler->IsMemoryProfilingEnabled() &&
+      std::none_of(pool_profilers_.begin(), pool_profilers_.end(),
+                   [&profiler](const std::weak_ptr<ProfilingContext>& p) {
+                     return p.lock() == profiler;
+                   })) {
+    pool_profilers_.push_back(profiler);
+    profiler->AddBufferPool(
+        kGpuBufferPoolName, [this](BufferPoolProfile* profile) {
+          auto max_in_use_counts = gpu_buffer_pool_.GetMaxInUseCounts();
+          int64_t num_in_use = 0;
+          int64_t num_available = 0;
+          profile->clear_spec_occupancy();
+          for (const auto& spec_and_counts :
+               gpu_buffer_pool_.GetInUseAndAvailableCounts()) {
+            const BufferSpec& spec = spec_and_counts.first;
+            num_in_use += spec_and_counts.second.first;
+            num_available += spec_and_counts.second.second;
+            auto* occupancy = profile->add_spec_occupancy();
+            occupancy->set_width(spec.width);
+            occupancy->set_height(spec.height);
+            occupancy->set_format(static_cast<uint32_t>(spec.format));
+            occupancy->set_num_in_use(spec_and_counts.second.first);
+            occupancy->set_num_available(spec_and_counts.second.second);
+            occupancy->set_max_num_in_use(max_in_use_counts[spec]);
+          }
+          profile->set_num_in_use(num_in_use);
+          profile->set_num_available(num_available);
+          profile->set_in_use_bytes(gpu_buffer_pool_.GetInUseBytes());
+          profile->set_available_bytes(gpu_buffer_pool_.GetAvailableBytes());
+        });
+  }
+#endif  // !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
+}
+
+::mediapipe::Status GpuResources::PreallocateBuffers(
+    const MediaPipeOptions& graph_options) {
+  const auto& options = graph_options.GetExtension(GpuBufferPoolOptions::ext);
+  if (options.preallocate().empty()) return ::mediapipe::OkStatus();
+#if !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
+  return gl_context()->Run([this, &options]() -> ::mediapipe::Status {
+    for (const auto& spec : options.preallocate()) {
+      RET_CHECK(spec.width() > 0 && spec.height() > 0)
+          << "Invalid preallocated buffer size " << spec.width() << "x"
+          << spec.height();
+      gpu_buffer_pool_.Preallocate(
+          BufferSpec(spec.width(), spec.height(),
+                     static_cast<GpuBufferFormat>(spec.format())),
+          spec.count());
+    }
+    return ::mediapipe::OkStatus();
+  });
+#else
+  // The pixel buffer pools are shared by the graphs of the process, so the
+  // buffers are only allocated if no earlier graph left them in the pool.
+  for (const auto& spec : options.preallocate()) {
+    RET_CHECK(spec.width() > 0 && spec.height() > 0)
+        << "Invalid preallocated buffer size " << spec.width() << "x"
+        << spec.height();
+    OSType cv_format = CVPixelFormatForGpuBufferFormat(
+        static_cast<GpuBufferFormat>(spec.format()));
+    RET_CHECK_NE(cv_format, -1) << "Unsupported pixel format " << spec.format();
+    CVReturn err = PixelBufferPoolRegistry::Get().Prewarm(
+        spec.width(), spec.height(), cv_format, spec.count());
+    RET_CHECK_EQ(err, kCVReturnSuccess)
+        << "Failed to preallocate pixel buffers: " << err;
   }
-  gl_context(context_key)
-      ->SetProfilingContext(
-          node->GetCalculatorState().GetSharedProfilingContext());
+  return ::mediapipe::OkStatus();
+#endif  // !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
 }
 
 // TODO: expose and use an actual ID instead of using the
@@ -24,6 +24,8 @@
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/calculator_node.h"
 #include "mediapipe/framework/executor.h"
+#include "mediapipe/framework/mediapipe_options.pb.h"
+#include "mediapipe/framework/mediapipe_profiling.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/gpu/gl_base.h"
 #include "mediapipe/gpu/gl_context.h"
@@ -71,6 +73,11 @@ class GpuResources {
 
   void PrepareGpuNode(CalculatorNode* node);
 
+  // Allocates the GPU buffers listed in the GpuBufferPoolOptions of the
+  // graph-level options, so that the first frames do not wait on buffer
+  // allocation. CVPixelBuffers are allocated in the PixelBufferPoolRegistry.
+  ::mediapipe::Status PreallocateBuffers(const MediaPipeOptions& graph_options);
+
   // If the node requires custom GPU executors in the current configuration,
   // returns the executor's names and the executors themselves.
   const std::map<std::string, std::shared_ptr<Executor>>& GetGpuExecutors() {
@@ -97,6 +104,11 @@ class GpuResources {
 #endif  // defined(__APPLE__)
 
   std::map<std::string, std::shared_ptr<Executor>> named_executors_;
+
+#if !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
+  // The profilers that report the occupancy of gpu_buffer_pool_.
+  std::vector<std::weak_ptr<ProfilingContext>> pool_profilers_;
+#endif  // !MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
 };
 
 // Legacy struct to keep existing client code happy.
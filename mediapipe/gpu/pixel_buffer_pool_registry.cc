@@ -0,0 +1,101 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/gpu/pixel_buffer_pool_registry.h"
+
+#include <algorithm>
+
+#include "absl/time/clock.h"
+#include "mediapipe/framework/deps/no_destructor.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/gpu/pixel_buffer_pool_util.h"
+
+namespace mediapipe {
+
+PixelBufferPoolRegistry& PixelBufferPoolRegistry::Get() {
+  static NoDestructor<PixelBufferPoolRegistry> registry;
+  return *registry;
+}
+
+void PixelBufferPoolRegistry::SetOptions(const Options& options) {
+  absl::MutexLock lock(&mutex_);
+  options_ = options;
+  Trim();
+}
+
+PixelBufferPoolRegistry::Pool PixelBufferPoolRegistry::GetPool(
+    int width, int height, OSType pixel_format) {
+  absl::MutexLock lock(&mutex_);
+  Trim();
+  return GetPoolLocked(Key(width, height, pixel_format), options_.keep_count);
+}
+
+CVReturn PixelBufferPoolRegistry::Prewarm(int width, int height,
+                                          OSType pixel_format, int count) {
+  Pool pool;
+  {
+    absl::MutexLock lock(&mutex_);
+    Trim();
+    pool = GetPoolLocked(Key(width, height, pixel_format),
+                         std::max(count, options_.keep_count));
+  }
+  return PreallocateCVPixelBufferPoolBuffers(**pool, count, nullptr);
+}
+
+void PixelBufferPoolRegistry::Clear() {
+  absl::MutexLock lock(&mutex_);
+  pools_.clear();
+}
+
+const PixelBufferPoolRegistry::Pool& PixelBufferPoolRegistry::GetPoolLocked(
+    const Key& key, int keep_count) {
+  Entry& entry = pools_[key];
+  entry.last_used = absl::Now();
+  if (!entry.pool) {
+    CVPixelBufferPoolRef pool = CreateCVPixelBufferPool(
+        std::get<0>(key), std::get<1>(key), std::get<2>(key), keep_count,
+        options_.max_buffer_age);
+    CHECK(pool) << "Failed to create CVPixelBufferPool";
+    entry.pool = std::make_shared<CFHolder<CVPixelBufferPoolRef>>(
+        MakeCFHolderAdopting(pool));
+  }
+  return entry.pool;
+}
+
+void PixelBufferPoolRegistry::Trim() {
+  const absl::Time now = absl::Now();
+  for (auto it = pools_.begin(); it != pools_.end();) {
+    Entry& entry = it->second;
+    if (entry.pool.use_count() > 1) {
+      entry.last_used = now;
+    }
+    if (now - entry.last_used > options_.retention) {
+      it = pools_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  const size_t max_pools = std::max(options_.max_pools, 0);
+  while (pools_.size() > max_pools) {
+    auto oldest = std::min_element(
+        pools_.begin(), pools_.end(),
+        [](const std::pair<const Key, Entry>& a,
+           const std::pair<const Key, Entry>& b) {
+          return a.second.last_used < b.second.last_used;
+        });
+    pools_.erase(oldest);
+  }
+}
+
+}  // namespace mediapipe
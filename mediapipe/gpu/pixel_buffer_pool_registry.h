@@ -0,0 +1,105 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_GPU_PIXEL_BUFFER_POOL_REGISTRY_H_
+#define MEDIAPIPE_GPU_PIXEL_BUFFER_POOL_REGISTRY_H_
+
+#include <CoreVideo/CoreVideo.h>
+
+#include <map>
+#include <memory>
+#include <tuple>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "mediapipe/objc/CFHolder.h"
+
+#ifndef __APPLE__
+#error pixel_buffer_pool_registry is only for use on Apple platforms.
+#endif  // !defined(__APPLE__)
+
+namespace mediapipe {
+
+// Holds the CVPixelBufferPools of the process, one per buffer size and pixel
+// format, so that graphs run one after another (e.g. face, then hand, then
+// segmentation) reuse the pools, and the IOSurfaces they keep, instead of
+// each GpuBufferMultiPool creating its own and allocating new buffers for
+// its first frames.
+//
+// A pool stays in the registry while a graph holds it, and for the retention
+// time after that. Buffers can be allocated ahead of the first graph that
+// needs them with Prewarm().
+class PixelBufferPoolRegistry {
+ public:
+  using Pool = std::shared_ptr<CFHolder<CVPixelBufferPoolRef>>;
+
+  struct Options {
+    // The number of buffers each pool keeps for reuse.
+    int keep_count = 2;
+    // How long, in seconds, a pool keeps buffers beyond keep_count after they
+    // are released. 0 keeps them until the pool is destroyed.
+    CFTimeInterval max_buffer_age = 0.1;
+    // How long the registry keeps a pool after it was last used.
+    absl::Duration retention = absl::Seconds(10);
+    // The most pools the registry keeps; the least recently used pools are
+    // dropped first.
+    int max_pools = 20;
+  };
+
+  // Returns the registry of the process.
+  static PixelBufferPoolRegistry& Get();
+
+  // Sets the options of the pools created from now on. The retention and
+  // max_pools take effect right away.
+  void SetOptions(const Options& options) LOCKS_EXCLUDED(mutex_);
+
+  // Returns the pool for buffers of the given size and format, creating it if
+  // needed. The pool counts as used until the returned holder is destroyed.
+  Pool GetPool(int width, int height, OSType pixel_format)
+      LOCKS_EXCLUDED(mutex_);
+
+  // Allocates "count" buffers of the given size and format, and keeps them
+  // in the pool for reuse. If the pool does not exist yet, it is created to
+  // keep at least "count" buffers.
+  CVReturn Prewarm(int width, int height, OSType pixel_format, int count)
+      LOCKS_EXCLUDED(mutex_);
+
+  // Drops all the pools from the registry, e.g. on a memory warning. Pools
+  // still held by graphs are destroyed when they release them.
+  void Clear() LOCKS_EXCLUDED(mutex_);
+
+ private:
+  using Key = std::tuple<int, int, OSType>;
+  struct Entry {
+    Pool pool;
+    // The last time the pool was requested or seen held by a graph.
+    absl::Time last_used;
+  };
+
+  // Returns the pool for "key", creating it with at least "keep_count"
+  // buffers if needed.
+  const Pool& GetPoolLocked(const Key& key, int keep_count)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Drops the unused pools past their retention, and the least recently used
+  // pools beyond max_pools.
+  void Trim() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  absl::Mutex mutex_;
+  Options options_ GUARDED_BY(mutex_);
+  std::map<Key, Entry> pools_ GUARDED_BY(mutex_);
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_GPU_PIXEL_BUFFER_POOL_REGISTRY_H_
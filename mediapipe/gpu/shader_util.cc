@@ -16,7 +16,21 @@
 
 #include <stdlib.h>
 
+#include <cstring>
+#include <memory>
+
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/deps/file_path.h"
+#include "mediapipe/framework/port/file_helpers.h"
 #include "mediapipe/framework/port/logging.h"
+#include "mediapipe/gpu/gl_context.h"
+
+// glProgramBinary is available in OpenGL ES 3.0, but not in WebGL or in the
+// legacy macOS OpenGL headers.
+#if !defined(__EMSCRIPTEN__) && !HAS_NSGL
+#define MEDIAPIPE_GL_PROGRAM_BINARY 1
+#endif
 
 #if DEBUG
 #define GL_DEBUG_LOG(type, object, action)                        \
@@ -138,6 +152,207 @@ GLint GlhCreateProgram(const GLchar* vert_src, const GLchar* frag_src,
   return ok;
 }
 
+namespace {
+
+// A program shared by the callers of GlhCreateCachedProgram.
+struct CachedProgram {
+  GLuint program = 0;
+  int use_count = 0;
+};
+
+// The programs shared on one GlContext. Only accessed on that context.
+struct ContextProgramCache {
+  // Tells a live context apart from a destroyed one at the same address.
+  std::weak_ptr<GlContext> context;
+  std::unordered_map<std::string, CachedProgram> programs;
+  std::unordered_map<GLuint, std::string> keys;
+};
+
+struct ProgramCacheState {
+  absl::Mutex mutex;
+  // Entries are never erased, so pointers to them stay valid.
+  std::unordered_map<const GlContext*, ContextProgramCache> caches
+      GUARDED_BY(mutex);
+  std::string binary_directory GUARDED_BY(mutex);
+};
+
+ProgramCacheState& GetProgramCacheState() {
+  static ProgramCacheState* state = new ProgramCacheState;
+  return *state;
+}
+
+// Returns the program cache of the current GlContext, or nullptr if no
+// GlContext is current. Also returns the program binary directory.
+ContextProgramCache* GetCurrentProgramCache(std::string* binary_directory) {
+  std::shared_ptr<GlContext> context = GlContext::GetCurrent();
+  if (!context) return nullptr;
+  ProgramCacheState& state = GetProgramCacheState();
+  absl::MutexLock lock(&state.mutex);
+  ContextProgramCache& cache = state.caches[context.get()];
+  if (cache.context.lock() != context) {
+    // The programs of a destroyed context went away with it.
+    cache = ContextProgramCache();
+    cache.context = context;
+  }
+  if (binary_directory) *binary_directory = state.binary_directory;
+  return &cache;
+}
+
+// Separates the parts of a program key. Shader sources cannot contain it.
+constexpr absl::string_view kKeySeparator("\0", 1);
+
+std::string ProgramKey(const GLchar* vert_src, const GLchar* frag_src,
+                       GLsizei attr_count, const GLchar* const* attr_names,
+                       const GLint* attr_locations) {
+  std::string key = absl::StrCat(vert_src, kKeySeparator, frag_src);
+  for (int i = 0; i < attr_count; ++i) {
+    absl::StrAppend(&key, kKeySeparator, attr_names[i], "=",
+                    attr_locations[i]);
+  }
+  return key;
+}
+
+#if MEDIAPIPE_GL_PROGRAM_BINARY
+bool ProgramBinarySupported() {
+  std::shared_ptr<GlContext> context = GlContext::GetCurrent();
+  return context && context->gl_major_version() >= 3 &&
+         SymbolAvailable(&glProgramBinary) &&
+         SymbolAvailable(&glGetProgramBinary);
+}
+
+// Returns the file holding the binary of the program with "key". Binaries
+// only load on the driver that produced them, so the file name also covers
+// the renderer and its version.
+std::string ProgramBinaryPath(const std::string& directory,
+                              const std::string& key) {
+  const GLubyte* renderer = glGetString(GL_RENDERER);
+  const GLubyte* version = glGetString(GL_VERSION);
+  const std::string hashed = absl::StrCat(
+      key, kKeySeparator,
+      renderer ? reinterpret_cast<const char*>(renderer) : "",
+      kKeySeparator,
+      version ? reinterpret_cast<const char*>(version) : "");
+  // FNV-1a, which unlike std::hash is stable across builds.
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : hashed) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return file::JoinPath(
+      directory, absl::StrCat("program_", absl::Hex(hash, absl::kZeroPad16),
+                              ".bin"));
+}
+
+// Creates a program from a binary saved by SaveProgramBinary. Returns false
+// if there is none, or if the driver rejects it.
+bool LoadProgramBinary(const std::string& path, GLuint* program) {
+  std::string contents;
+  if (!file::GetContents(path, &contents).ok() ||
+      contents.size() <= sizeof(GLenum)) {
+    return false;
+  }
+  GLenum format;
+  std::memcpy(&format, contents.data(), sizeof(format));
+  *program = glCreateProgram();
+  if (*program == 0) return false;
+  glProgramBinary(*program, format, contents.data() + sizeof(format),
+                  contents.size() - sizeof(format));
+  GLint status = GL_FALSE;
+  glGetProgramiv(*program, GL_LINK_STATUS, &status);
+  if (status == GL_FALSE) {
+    glDeleteProgram(*program);
+    *program = 0;
+    return false;
+  }
+  return true;
+}
+
+// Saves the binary of a linked program, preceded by its format.
+void SaveProgramBinary(const std::string& path, GLuint program) {
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) return;
+  std::string contents(sizeof(GLenum) + length, '\0');
+  GLenum format = 0;
+  GLsizei written = 0;
+  glGetProgramBinary(program, length, &written, &format,
+                     &contents[sizeof(GLenum)]);
+  if (written <= 0) return;
+  std::memcpy(&contents[0], &format, sizeof(format));
+  contents.resize(sizeof(GLenum) + written);
+  ::mediapipe::Status status = file::SetContents(path, contents);
+  LOG_IF(WARNING, !status.ok())
+      << "Failed to save program binary " << path << ": " << status.message();
+}
+#endif  // MEDIAPIPE_GL_PROGRAM_BINARY
+
+}  // namespace
+
+GLint GlhCreateCachedProgram(const GLchar* vert_src, const GLchar* frag_src,
+                             GLsizei attr_count,
+                             const GLchar* const* attr_names,
+                             const GLint* attr_locations, GLuint* program) {
+  std::string binary_directory;
+  ContextProgramCache* cache = GetCurrentProgramCache(&binary_directory);
+  if (!cache) {
+    return GlhCreateProgram(vert_src, frag_src, attr_count, attr_names,
+                            attr_locations, program);
+  }
+
+  std::string key =
+      ProgramKey(vert_src, frag_src, attr_count, attr_names, attr_locations);
+  auto it = cache->programs.find(key);
+  if (it != cache->programs.end()) {
+    ++it->second.use_count;
+    *program = it->second.program;
+    return GL_TRUE;
+  }
+
+  GLint ok = GL_FALSE;
+#if MEDIAPIPE_GL_PROGRAM_BINARY
+  std::string binary_path;
+  if (!binary_directory.empty() && ProgramBinarySupported()) {
+    binary_path = ProgramBinaryPath(binary_directory, key);
+    ok = LoadProgramBinary(binary_path, program);
+  }
+#endif  // MEDIAPIPE_GL_PROGRAM_BINARY
+  if (!ok) {
+    ok = GlhCreateProgram(vert_src, frag_src, attr_count, attr_names,
+                          attr_locations, program);
+    if (!ok) return ok;
+#if MEDIAPIPE_GL_PROGRAM_BINARY
+    if (!binary_path.empty()) {
+      SaveProgramBinary(binary_path, *program);
+    }
+#endif  // MEDIAPIPE_GL_PROGRAM_BINARY
+  }
+
+  cache->keys[*program] = key;
+  cache->programs[std::move(key)] = {*program, 1};
+  return ok;
+}
+
+void GlhReleaseCachedProgram(GLuint program) {
+  if (program == 0) return;
+  ContextProgramCache* cache = GetCurrentProgramCache(nullptr);
+  if (cache) {
+    auto key_it = cache->keys.find(program);
+    if (key_it != cache->keys.end()) {
+      auto it = cache->programs.find(key_it->second);
+      if (--it->second.use_count > 0) return;
+      cache->programs.erase(it);
+      cache->keys.erase(key_it);
+    }
+  }
+  glDeleteProgram(program);
+}
+
+void GlhSetProgramBinaryCacheDirectory(const std::string& directory) {
+  ProgramCacheState& state = GetProgramCacheState();
+  absl::MutexLock lock(&state.mutex);
+  state.binary_directory = directory;
+}
+
 bool CompileShader(GLenum shader_type, const std::string& shader_source,
                    GLuint* shader) {
   *shader = glCreateShader(shader_type);
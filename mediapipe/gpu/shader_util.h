@@ -42,6 +42,27 @@ GLint GlhCreateProgram(const GLchar* vert_src, const GLchar* frag_src,
                        GLsizei attr_count, const GLchar* const* attr_names,
                        const GLint* attr_locations, GLuint* program);
 
+// Like GlhCreateProgram, but shares the program among all the callers that
+// pass the same sources and attribute bindings on the current GlContext, so
+// that it is compiled and linked only once. The program must be released with
+// GlhReleaseCachedProgram instead of glDeleteProgram.
+// Return GL_TRUE for success, GL_FALSE for failure.
+GLint GlhCreateCachedProgram(const GLchar* vert_src, const GLchar* frag_src,
+                             GLsizei attr_count,
+                             const GLchar* const* attr_names,
+                             const GLint* attr_locations, GLuint* program);
+
+// Releases a program obtained from GlhCreateCachedProgram. The program is
+// deleted when its last user releases it. Must be called on the GlContext
+// that created the program.
+void GlhReleaseCachedProgram(GLuint program);
+
+// Makes GlhCreateCachedProgram store the binaries of the programs it links in
+// "directory", and load them from there instead of compiling when possible,
+// so that later processes start faster. Requires glProgramBinary, i.e.
+// OpenGL ES 3.0. An empty directory, the default, disables the disk cache.
+void GlhSetProgramBinaryCacheDirectory(const std::string& directory);
+
 // Compiles a shader specified by shader_source. Returns true on success.
 bool CompileShader(GLenum shader_type, const std::string& shader_source,
                    GLuint* shader);
@@ -15,6 +15,8 @@
 package com.google.mediapipe.framework;
 
 import android.graphics.Bitmap;
+import android.hardware.HardwareBuffer;
+import android.os.Build;
 
 // TODO: use Preconditions in this file.
 /**
@@ -46,6 +48,35 @@ public class AndroidPacketCreator extends PacketCreator {
     return Packet.create(nativeCreateRgbaImageFrame(mediapipeGraph.getNativeHandle(), bitmap));
   }
 
+  /**
+   * Creates a mediapipe::GpuBuffer that wraps a {@link HardwareBuffer} without copying it.
+   *
+   * <p>The buffer must have been allocated with {@link HardwareBuffer#USAGE_GPU_SAMPLED_IMAGE}, for
+   * example by an {@link android.media.ImageReader} that receives camera frames. Unlike frames
+   * produced by {@link com.google.mediapipe.components.ExternalTextureConverter}, no copy is
+   * rendered before the graph sees the frame. Buffers in YUV or implementation-defined formats are
+   * imported as {@code GL_TEXTURE_EXTERNAL_OES} textures, which must be sampled with {@code
+   * samplerExternalOES}.
+   *
+   * <p>Requires API level 26.
+   *
+   * @param buffer the hardware buffer.
+   * @param releaseCallback a callback to be invoked when MediaPipe no longer uses the buffer, for
+   *     example to close the {@link android.media.Image} that owns it. Can be null.
+   */
+  public Packet createGpuBuffer(HardwareBuffer buffer, TextureReleaseCallback releaseCallback) {
+    if (Build.VERSION.SDK_INT < Build.VERSION_CODES.O) {
+      throw new RuntimeException("HardwareBuffer requires API level 26.");
+    }
+    long nativeHandle =
+        nativeCreateGpuBufferFromHardwareBuffer(
+            mediapipeGraph.getNativeHandle(), buffer, releaseCallback);
+    if (nativeHandle == 0) {
+      throw new RuntimeException("Failed to create a GpuBuffer from the HardwareBuffer.");
+    }
+    return Packet.create(nativeHandle);
+  }
+
   /**
    * Returns the native handle of a new internal::PacketWithContext object on success. Returns 0 on
    * failure.
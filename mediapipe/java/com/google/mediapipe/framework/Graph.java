@@ -37,6 +37,7 @@ public class Graph {
   // Hold the references to callbacks.
   private final List<PacketCallback> packetCallbacks = new ArrayList<>();
   private final List<PacketWithHeaderCallback> packetWithHeaderCallbacks = new ArrayList<>();
+  private final List<PacketListCallbackAdapter> packetListCallbacks = new ArrayList<>();
   // Side packets used for running the graph.
   private Map<String, Packet> sidePackets = new HashMap<>();
   // Stream headers used for running the graph.
@@ -176,6 +177,26 @@ public class Graph {
     nativeAddPacketWithHeaderCallback(nativeGraphHandle, streamName, callback);
   }
 
+  /**
+   * Adds a {@link PacketListCallback} receiving the packets of several streams at the same
+   * timestamp, with a single call from native code and without allocating per packet.
+   *
+   * @param streamNames The output stream names in the graph for callback.
+   * @param callback The callback for handling the packets of each timestamp.
+   * @throws MediaPipeException for any error status.
+   */
+  public synchronized void addMultiStreamCallback(
+      List<String> streamNames, PacketListCallback callback) {
+    Preconditions.checkState(
+        nativeGraphHandle != 0, "Invalid context, tearDown() might have been called already.");
+    Preconditions.checkNotNull(streamNames);
+    Preconditions.checkNotNull(callback);
+    Preconditions.checkState(!graphRunning && !startRunningGraphCalled);
+    PacketListCallbackAdapter adapter = new PacketListCallbackAdapter(callback, streamNames.size());
+    packetListCallbacks.add(adapter);
+    nativeAddMultiStreamCallback(nativeGraphHandle, streamNames.toArray(new String[0]), adapter);
+  }
+
   /**
    * Adds a {@link SurfaceOutput} for a stream producing GpuBuffers.
    *
@@ -466,6 +487,7 @@ public class Graph {
     }
     packetCallbacks.clear();
     packetWithHeaderCallbacks.clear();
+    packetListCallbacks.clear();
   }
 
   /**
@@ -605,6 +627,9 @@ public class Graph {
   private native void nativeAddPacketWithHeaderCallback(
       long context, String streamName, PacketWithHeaderCallback callback);
 
+  private native void nativeAddMultiStreamCallback(
+      long context, String[] streamNames, PacketListCallbackAdapter callback);
+
   private native long nativeAddSurfaceOutput(long context, String streamName);
 
   private native void nativeLoadBinaryGraph(long context, String path);
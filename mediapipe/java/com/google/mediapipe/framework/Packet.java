@@ -76,6 +76,12 @@ public class Packet {
     nativePacketHandle = handle;
   }
 
+  // Points this wrapper to another native packet, without releasing the current one. Used by
+  // callbacks reusing their wrappers.
+  void setNativeHandle(long handle) {
+    nativePacketHandle = handle;
+  }
+
   // Releases the native memeory.
   private native void nativeReleasePacket(long packetHandle);
 
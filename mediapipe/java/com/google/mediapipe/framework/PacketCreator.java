@@ -74,6 +74,26 @@ public class PacketCreator {
         nativeCreateAudioPacket(mediapipeGraph.getNativeHandle(), data, numChannels, numSamples));
   }
 
+  /**
+   * Create a MediaPipe audio packet that keeps the samples as 16-bit integers (an Int16Matrix).
+   *
+   * <p>The packet is half the size of one from {@link #createAudioPacket}. Send it to an
+   * INT16_MATRIX input of TimeSeriesFramerCalculator, RationalFactorResampleCalculator or
+   * SpectrogramCalculator, which convert the samples to float as they process them.
+   *
+   * @param data the raw little-endian audio data, bytes per sample is 2.
+   * @param numChannels number of channels in the raw data.
+   * @param numSamples number of samples in the data.
+   */
+  public Packet createInt16AudioPacket(byte[] data, int numChannels, int numSamples) {
+    if (numChannels * numSamples * 2 != data.length) {
+      throw new RuntimeException("Data doesn't have the correct size.");
+    }
+    return Packet.create(
+        nativeCreateInt16AudioPacket(
+            mediapipeGraph.getNativeHandle(), data, numChannels, numSamples));
+  }
+
   /**
    * Creates a 3 channel RGB ImageFrame packet from an RGBA buffer.
    *
@@ -114,6 +134,28 @@ public class PacketCreator {
         nativeCreateRgbaImageFrame(mediapipeGraph.getNativeHandle(), buffer, width, height));
   }
 
+  /**
+   * Creates an ImageFrame packet sharing the pixels of a direct buffer, without copying them.
+   *
+   * <p>The buffer is referenced until the last ImageFrame using its pixels is released, and must
+   * not be modified in the meantime. Rows start every {@code widthStep} bytes.
+   *
+   * @param numChannels 1 for a GRAY8 frame, 3 for an SRGB frame or 4 for an SRGBA frame.
+   */
+  public Packet createImageFrameWrappingBuffer(
+      ByteBuffer buffer, int width, int height, int widthStep, int numChannels) {
+    if (!buffer.isDirect()) {
+      throw new RuntimeException("The buffer must be allocated with ByteBuffer.allocateDirect.");
+    }
+    if (widthStep < width * numChannels || buffer.capacity() < widthStep * height) {
+      throw new RuntimeException(
+          "The size of the buffer should be at least: " + widthStep * height);
+    }
+    return Packet.create(
+        nativeCreateImageFrameWrappingBuffer(
+            mediapipeGraph.getNativeHandle(), buffer, width, height, widthStep, numChannels));
+  }
+
   public Packet createInt16(short value) {
     return Packet.create(nativeCreateInt16(mediapipeGraph.getNativeHandle(), value));
   }
@@ -276,6 +318,8 @@ public class PacketCreator {
   private native long nativeCreateRgbImage(long context, ByteBuffer buffer, int width, int height);
   private native long nativeCreateAudioPacket(
       long context, byte[] data, int numChannels, int numSamples);
+  private native long nativeCreateInt16AudioPacket(
+      long context, byte[] data, int numChannels, int numSamples);
   private native long nativeCreateRgbImageFromRgba(
       long context, ByteBuffer buffer, int width, int height);
 
@@ -284,6 +328,9 @@ public class PacketCreator {
 
   private native long nativeCreateRgbaImageFrame(
       long context, ByteBuffer buffer, int width, int height);
+
+  private native long nativeCreateImageFrameWrappingBuffer(
+      long context, ByteBuffer buffer, int width, int height, int widthStep, int numChannels);
   private native long nativeCreateInt16(long context, short value);
   private native long nativeCreateInt32(long context, int value);
   private native long nativeCreateInt64(long context, long value);
@@ -297,6 +344,9 @@ public class PacketCreator {
   private native long nativeCreateMatrix(long context, int rows, int cols, float[] data);
   private native long nativeCreateGpuBuffer(
       long context, int name, int width, int height, TextureReleaseCallback releaseCallback);
+  // hardwareBuffer is an android.hardware.HardwareBuffer; see AndroidPacketCreator.
+  protected native long nativeCreateGpuBufferFromHardwareBuffer(
+      long context, Object hardwareBuffer, TextureReleaseCallback releaseCallback);
   private native long nativeCreateInt32Array(long context, int[] data);
   private native long nativeCreateFloat32Array(long context, float[] data);
   private native long nativeCreateStringFromByteArray(long context, byte[] data);
@@ -114,6 +114,17 @@ public final class PacketGetter {
     return nativeGetProtoBytes(packet.getNativeHandle());
   }
 
+  /**
+   * Serializes the proto held by the packet into a direct buffer, which can be reused across
+   * packets instead of allocating a byte array for each.
+   *
+   * @return the size of the serialized proto. Nothing is written if it is larger than the capacity
+   *     of the buffer.
+   */
+  public static int getProtoBytes(final Packet packet, ByteBuffer buffer) {
+    return nativeGetProtoBytesIntoBuffer(packet.getNativeHandle(), buffer);
+  }
+
   public static short[] getInt16Vector(final Packet packet) {
     return nativeGetInt16Vector(packet.getNativeHandle());
   }
@@ -134,6 +145,22 @@ public final class PacketGetter {
     return nativeGetFloat64Vector(packet.getNativeHandle());
   }
 
+  /**
+   * Returns the coordinates of a std::vector<Landmark> packet as consecutive (x, y, z) triples,
+   * without converting the landmarks to protos.
+   */
+  public static float[] getLandmarkCoordinates(final Packet packet) {
+    return nativeGetLandmarkCoordinates(packet.getNativeHandle());
+  }
+
+  /**
+   * Returns the coordinates of a std::vector<NormalizedLandmark> packet as consecutive (x, y, z)
+   * triples, without converting the landmarks to protos.
+   */
+  public static float[] getNormalizedLandmarkCoordinates(final Packet packet) {
+    return nativeGetNormalizedLandmarkCoordinates(packet.getNativeHandle());
+  }
+
   public static int getImageWidth(final Packet packet) {
     return nativeGetImageWidth(packet.getNativeHandle());
   }
@@ -272,11 +299,15 @@ public final class PacketGetter {
   private static native String nativeGetString(long nativePacketHandle);
   private static native byte[] nativeGetBytes(long nativePacketHandle);
   private static native byte[] nativeGetProtoBytes(long nativePacketHandle);
+  private static native int nativeGetProtoBytesIntoBuffer(
+      long nativePacketHandle, ByteBuffer buffer);
   private static native short[] nativeGetInt16Vector(long nativePacketHandle);
   private static native int[] nativeGetInt32Vector(long nativePacketHandle);
   private static native long[] nativeGetInt64Vector(long nativePacketHandle);
   private static native float[] nativeGetFloat32Vector(long nativePacketHandle);
   private static native double[] nativeGetFloat64Vector(long nativePacketHandle);
+  private static native float[] nativeGetLandmarkCoordinates(long nativePacketHandle);
+  private static native float[] nativeGetNormalizedLandmarkCoordinates(long nativePacketHandle);
   private static native int nativeGetImageWidth(long nativePacketHandle);
   private static native int nativeGetImageHeight(long nativePacketHandle);
   private static native boolean nativeGetImageData(long nativePacketHandle, ByteBuffer buffer);
@@ -0,0 +1,29 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+package com.google.mediapipe.framework;
+
+import java.util.List;
+
+/** Interface for MediaPipe callback with the packets of several streams at one timestamp. */
+public interface PacketListCallback {
+  /**
+   * Receives one packet per stream, in the order the streams were given, with empty packets for
+   * streams without a packet at the timestamp.
+   *
+   * <p>The list and its packets are reused for the next call, and are only valid during this one.
+   * Use {@link Packet#copy} to keep a packet, and do not release them.
+   */
+  public void process(List<Packet> packets);
+}
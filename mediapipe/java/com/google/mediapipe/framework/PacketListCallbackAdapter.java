@@ -0,0 +1,55 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+package com.google.mediapipe.framework;
+
+import java.util.Arrays;
+import java.util.Collections;
+import java.util.List;
+
+/**
+ * Delivers the packet handles of a multi-stream callback to a {@link PacketListCallback}.
+ *
+ * <p>The native code passes all handles in one call, and the Java packets wrapping them are
+ * allocated once and reused, so that a callback does not allocate any object.
+ */
+final class PacketListCallbackAdapter {
+  private final PacketListCallback callback;
+  private final Packet[] packets;
+  private final List<Packet> packetList;
+
+  PacketListCallbackAdapter(PacketListCallback callback, int numStreams) {
+    this.callback = callback;
+    packets = new Packet[numStreams];
+    for (int i = 0; i < numStreams; ++i) {
+      packets[i] = Packet.create(0);
+    }
+    packetList = Collections.unmodifiableList(Arrays.asList(packets));
+  }
+
+  // This method is invoked by native code.
+  void process(long[] packetHandles) {
+    for (int i = 0; i < packets.length; ++i) {
+      packets[i].setNativeHandle(packetHandles[i]);
+    }
+    try {
+      callback.process(packetList);
+    } finally {
+      // The native packets are released after the call.
+      for (Packet packet : packets) {
+        packet.setNativeHandle(0);
+      }
+    }
+  }
+}
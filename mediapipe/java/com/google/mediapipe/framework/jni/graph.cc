@@ -88,6 +88,21 @@ class CallbackHandler {
                              packet, header);
   }
 
+  void PacketListCallback(const std::vector<Packet>& packets) {
+    JNIEnv* env = mediapipe::java::GetJNIEnv();
+    // Every call has one packet per stream, so the handle array is allocated
+    // once and reused.
+    if (handles_array_ == nullptr) {
+      jlongArray local_array = env->NewLongArray(packets.size());
+      handles_array_ =
+          reinterpret_cast<jlongArray>(env->NewGlobalRef(local_array));
+      env->DeleteLocalRef(local_array);
+      handles_.resize(packets.size());
+    }
+    context_->CallbackToJava(env, java_callback_, packets, handles_array_,
+                             &handles_);
+  }
+
   std::function<void(const Packet&)> CreateCallback() {
     return std::bind(&CallbackHandler::PacketCallback, this,
                      std::placeholders::_1);
@@ -98,18 +113,30 @@ class CallbackHandler {
                      std::placeholders::_1, std::placeholders::_2);
   }
 
+  std::function<void(const std::vector<Packet>&)> CreatePacketListCallback() {
+    return std::bind(&CallbackHandler::PacketListCallback, this,
+                     std::placeholders::_1);
+  }
+
   // Releases the global reference to the java callback object.
   // This is called by the Graph, since releasing of a jni object
   // requires JNIEnv object that we can not keep a copy of.
   void ReleaseCallback(JNIEnv* env) {
     env->DeleteGlobalRef(java_callback_);
     java_callback_ = nullptr;
+    if (handles_array_) {
+      env->DeleteGlobalRef(handles_array_);
+      handles_array_ = nullptr;
+    }
   }
 
  private:
   Graph* context_;
   // java callback object
   jobject java_callback_;
+  // The packet handles passed to a multi-stream callback.
+  jlongArray handles_array_ = nullptr;
+  std::vector<jlong> handles_;
 };
 }  // namespace internal
 
@@ -210,6 +237,23 @@ void Graph::EnsureMinimumExecutorStackSizeForJava() {}
   return ::mediapipe::OkStatus();
 }
 
+::mediapipe::Status Graph::AddMultiStreamCallbackHandler(
+    std::vector<std::string> output_stream_names, jobject java_callback) {
+  if (!graph_config()) {
+    return ::mediapipe::InternalError("Graph is not loaded!");
+  }
+  std::unique_ptr<internal::CallbackHandler> handler(
+      new internal::CallbackHandler(this, java_callback));
+  std::pair<std::string, Packet> side_packet;
+  tool::AddMultiStreamCallback(output_stream_names,
+                               handler->CreatePacketListCallback(),
+                               graph_config(), &side_packet);
+  EnsureMinimumExecutorStackSizeForJava();
+  side_packets_callbacks_.emplace(side_packet);
+  callback_handlers_.emplace_back(std::move(handler));
+  return ::mediapipe::OkStatus();
+}
+
 int64_t Graph::AddSurfaceOutput(const std::string& output_stream_name) {
   if (!graph_config()) {
     LOG(ERROR) << "Graph is not loaded!";
@@ -293,58 +337,81 @@ CalculatorGraphConfig Graph::GetCalculatorGraphConfig() {
 
 void Graph::CallbackToJava(JNIEnv* env, jobject java_callback_obj,
                            const Packet& packet) {
-  jclass callback_cls = env->GetObjectClass(java_callback_obj);
-  jmethodID processMethod = env->GetMethodID(
-      callback_cls, "process",
-      absl::StrFormat("(L%s;)V", std::string(Graph::kJavaPacketClassName))
-          .c_str());
-
   int64_t packet_handle = WrapPacketIntoContext(packet);
   // Creates a Java Packet.
   VLOG(2) << "Creating java packet preparing for callback to java.";
-  jobject java_packet =
-      CreateJavaPacket(env, global_java_packet_cls_, packet_handle);
+  jobject java_packet = env->CallStaticObjectMethod(
+      global_java_packet_cls_, packet_create_method_, packet_handle);
   VLOG(2) << "Calling java callback.";
-  env->CallVoidMethod(java_callback_obj, processMethod, java_packet);
+  env->CallVoidMethod(java_callback_obj, packet_callback_method_, java_packet);
   // release the packet after callback.
   RemovePacket(packet_handle);
-  env->DeleteLocalRef(callback_cls);
   env->DeleteLocalRef(java_packet);
   VLOG(2) << "Returned from java callback.";
 }
 
 void Graph::CallbackToJava(JNIEnv* env, jobject java_callback_obj,
                            const Packet& packet, const Packet& header_packet) {
-  jclass callback_cls = env->GetObjectClass(java_callback_obj);
-  jmethodID processMethod = env->GetMethodID(
-      callback_cls, "process",
-      absl::StrFormat("(L%s;L%s;)V", std::string(Graph::kJavaPacketClassName),
-                      std::string(Graph::kJavaPacketClassName))
-          .c_str());
-
   int64_t packet_handle = WrapPacketIntoContext(packet);
   int64_t header_packet_handle = WrapPacketIntoContext(header_packet);
   // Creates a Java Packet.
-  jobject java_packet =
-      CreateJavaPacket(env, global_java_packet_cls_, packet_handle);
-  jobject java_header_packet =
-      CreateJavaPacket(env, global_java_packet_cls_, header_packet_handle);
-  env->CallVoidMethod(java_callback_obj, processMethod, java_packet,
-                      java_header_packet);
+  jobject java_packet = env->CallStaticObjectMethod(
+      global_java_packet_cls_, packet_create_method_, packet_handle);
+  jobject java_header_packet = env->CallStaticObjectMethod(
+      global_java_packet_cls_, packet_create_method_, header_packet_handle);
+  env->CallVoidMethod(java_callback_obj, packet_with_header_callback_method_,
+                      java_packet, java_header_packet);
   // release the packet after callback.
   RemovePacket(packet_handle);
   RemovePacket(header_packet_handle);
-  env->DeleteLocalRef(callback_cls);
   env->DeleteLocalRef(java_packet);
   env->DeleteLocalRef(java_header_packet);
 }
 
+void Graph::CallbackToJava(JNIEnv* env, jobject java_callback_obj,
+                           const std::vector<Packet>& packets,
+                           jlongArray handles_array,
+                           std::vector<jlong>* handles) {
+  for (int i = 0; i < packets.size(); ++i) {
+    (*handles)[i] = WrapPacketIntoContext(packets[i]);
+  }
+  env->SetLongArrayRegion(handles_array, 0, handles->size(), handles->data());
+  // The adapter wraps the handles into reused Java Packets.
+  env->CallVoidMethod(java_callback_obj, packet_list_callback_method_,
+                      handles_array);
+  // release the packets after callback.
+  for (jlong handle : *handles) {
+    RemovePacket(handle);
+  }
+}
+
 void Graph::SetPacketJavaClass(JNIEnv* env) {
   if (global_java_packet_cls_ == nullptr) {
     jclass packet_cls =
         env->FindClass(mediapipe::android::Graph::kJavaPacketClassName);
     global_java_packet_cls_ =
         reinterpret_cast<jclass>(env->NewGlobalRef(packet_cls));
+    const std::string packet_type =
+        absl::StrFormat("L%s;", std::string(kJavaPacketClassName));
+    packet_create_method_ =
+        env->GetStaticMethodID(global_java_packet_cls_, "create",
+                               absl::StrCat("(J)", packet_type).c_str());
+
+    // Method IDs of interface methods apply to every implementing class.
+    jclass callback_cls = env->FindClass(kJavaPacketCallbackClassName);
+    packet_callback_method_ =
+        env->GetMethodID(callback_cls, "process",
+                         absl::StrCat("(", packet_type, ")V").c_str());
+    env->DeleteLocalRef(callback_cls);
+    callback_cls = env->FindClass(kJavaPacketWithHeaderCallbackClassName);
+    packet_with_header_callback_method_ = env->GetMethodID(
+        callback_cls, "process",
+        absl::StrCat("(", packet_type, packet_type, ")V").c_str());
+    env->DeleteLocalRef(callback_cls);
+    callback_cls = env->FindClass(kJavaPacketListCallbackAdapterClassName);
+    packet_list_callback_method_ =
+        env->GetMethodID(callback_cls, "process", "([J)V");
+    env->DeleteLocalRef(callback_cls);
   }
 }
 
@@ -46,6 +46,13 @@ class Graph {
   // The Packet java class name.
   static constexpr char const* kJavaPacketClassName =
       "com/google/mediapipe/framework/Packet";
+  // The java classes called back with output packets.
+  static constexpr char const* kJavaPacketCallbackClassName =
+      "com/google/mediapipe/framework/PacketCallback";
+  static constexpr char const* kJavaPacketWithHeaderCallbackClassName =
+      "com/google/mediapipe/framework/PacketWithHeaderCallback";
+  static constexpr char const* kJavaPacketListCallbackAdapterClassName =
+      "com/google/mediapipe/framework/PacketListCallbackAdapter";
 
   Graph();
   Graph(const Graph&) = delete;
@@ -60,6 +67,11 @@ class Graph {
   ::mediapipe::Status AddCallbackWithHeaderHandler(
       std::string output_stream_name, jobject java_callback);
 
+  // Adds a callback receiving the packets of several streams at the same
+  // timestamp. "java_callback" must be a PacketListCallbackAdapter.
+  ::mediapipe::Status AddMultiStreamCallbackHandler(
+      std::vector<std::string> output_stream_names, jobject java_callback);
+
   // Loads a binary graph from a file.
   ::mediapipe::Status LoadBinaryGraph(std::string path_to_graph);
   // Loads a binary graph from a buffer.
@@ -166,6 +178,13 @@ class Graph {
   void CallbackToJava(JNIEnv* env, jobject java_callback_obj,
                       const Packet& packet, const Packet& header_packet);
 
+  // Invokes a Java multi-stream callback with all packets in one call. The
+  // packet handles are passed through "handles_array", which must have one
+  // element per packet, using "handles" as a scratch buffer of the same size.
+  void CallbackToJava(JNIEnv* env, jobject java_callback_obj,
+                      const std::vector<Packet>& packets,
+                      jlongArray handles_array, std::vector<jlong>* handles);
+
   ProfilingContext* GetProfilingContext();
 
  private:
@@ -175,6 +194,8 @@ class Graph {
   // thread/threadpool.h uses a default stack size of 64 KB, which is too
   // small for Java's class loader. See bug 72414047.
   void EnsureMinimumExecutorStackSizeForJava();
+  // Looks up the Java classes and methods used by callbacks, which native
+  // threads cannot look up themselves.
   void SetPacketJavaClass(JNIEnv* env);
   std::map<std::string, Packet> CreateCombinedSidePackets();
   // Returns the top-level CalculatorGraphConfig, or nullptr if the top-level
@@ -202,6 +223,11 @@ class Graph {
   // used from native attached thread. This is the suggested workaround for
   // jni findclass issue.
   jclass global_java_packet_cls_;
+  // Method IDs, looked up once along with global_java_packet_cls_.
+  jmethodID packet_create_method_ = nullptr;
+  jmethodID packet_callback_method_ = nullptr;
+  jmethodID packet_with_header_callback_method_ = nullptr;
+  jmethodID packet_list_callback_method_ = nullptr;
   // All mediapipe Packet managed/referenced by the context.
   // The map is used for the Java code to be able to look up the Packet
   // based on the handler(pointer).
@@ -15,6 +15,7 @@
 #include "mediapipe/java/com/google/mediapipe/framework/jni/graph_jni.h"
 
 #include <memory>
+#include <vector>
 
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/port/canonical_errors.h"
@@ -227,6 +228,32 @@ JNIEXPORT void JNICALL GRAPH_METHOD(nativeAddPacketWithHeaderCallback)(
                         output_stream_name, global_callback_ref));
 }
 
+JNIEXPORT void JNICALL GRAPH_METHOD(nativeAddMultiStreamCallback)(
+    JNIEnv* env, jobject thiz, jlong context, jobjectArray stream_names,
+    jobject callback) {
+  mediapipe::android::Graph* mediapipe_graph =
+      reinterpret_cast<mediapipe::android::Graph*>(context);
+  std::vector<std::string> output_stream_names;
+  const jsize num_streams = env->GetArrayLength(stream_names);
+  for (jsize i = 0; i < num_streams; ++i) {
+    jstring stream_name =
+        reinterpret_cast<jstring>(env->GetObjectArrayElement(stream_names, i));
+    output_stream_names.push_back(JStringToStdString(env, stream_name));
+    env->DeleteLocalRef(stream_name);
+  }
+
+  // Create a global reference to the callback object, so that it can
+  // be accessed later.
+  jobject global_callback_ref = env->NewGlobalRef(callback);
+  if (!global_callback_ref) {
+    ThrowIfError(
+        env, ::mediapipe::InternalError("Failed to allocate packet callback"));
+    return;
+  }
+  ThrowIfError(env, mediapipe_graph->AddMultiStreamCallbackHandler(
+                        output_stream_names, global_callback_ref));
+}
+
 JNIEXPORT jlong JNICALL GRAPH_METHOD(nativeAddSurfaceOutput)(
     JNIEnv* env, jobject thiz, jlong context, jstring stream_name) {
   mediapipe::android::Graph* mediapipe_graph =
@@ -66,6 +66,10 @@ JNIEXPORT void JNICALL GRAPH_METHOD(nativeAddPacketWithHeaderCallback)(
     JNIEnv* env, jobject thiz, jlong context, jstring stream_name,
     jobject callback);
 
+JNIEXPORT void JNICALL GRAPH_METHOD(nativeAddMultiStreamCallback)(
+    JNIEnv* env, jobject thiz, jlong context, jobjectArray stream_names,
+    jobject callback);
+
 JNIEXPORT jlong JNICALL GRAPH_METHOD(nativeAddSurfaceOutput)(
     JNIEnv* env, jobject thiz, jlong context, jstring stream_name);
 
@@ -20,6 +20,7 @@
 #include "mediapipe/framework/camera_intrinsics.h"
 #include "mediapipe/framework/formats/image_format.pb.h"
 #include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/int16_matrix.h"
 #include "mediapipe/framework/formats/matrix.h"
 #include "mediapipe/framework/formats/time_series_header.pb.h"
 #include "mediapipe/framework/formats/video_stream_header.h"
@@ -29,6 +30,9 @@
 #include "mediapipe/java/com/google/mediapipe/framework/jni/jni_util.h"
 #ifndef MEDIAPIPE_DISABLE_GPU
 #include "mediapipe/gpu/gl_calculator_helper.h"
+#if MEDIAPIPE_GPU_BUFFER_USE_AHWB
+#include <dlfcn.h>
+#endif  // MEDIAPIPE_GPU_BUFFER_USE_AHWB
 #endif  // !defined(MEDIAPIPE_DISABLE_GPU)
 
 namespace {
@@ -157,6 +161,49 @@ JNIEXPORT jlong JNICALL PACKET_CREATOR_METHOD(nativeCreateRgbaImageFrame)(
   return CreatePacketWithContext(context, packet);
 }
 
+JNIEXPORT jlong JNICALL
+PACKET_CREATOR_METHOD(nativeCreateImageFrameWrappingBuffer)(
+    JNIEnv* env, jobject thiz, jlong context, jobject byte_buffer, jint width,
+    jint height, jint width_step, jint num_channels) {
+  mediapipe::ImageFormat::Format format;
+  switch (num_channels) {
+    case 1:
+      format = mediapipe::ImageFormat::GRAY8;
+      break;
+    case 3:
+      format = mediapipe::ImageFormat::SRGB;
+      break;
+    case 4:
+      format = mediapipe::ImageFormat::SRGBA;
+      break;
+    default:
+      LOG(ERROR) << "Unsupported number of channels: " << num_channels;
+      return 0L;
+  }
+  uint8* data = static_cast<uint8*>(env->GetDirectBufferAddress(byte_buffer));
+  if (data == nullptr) {
+    LOG(ERROR) << "The input image buffer must be a direct buffer.";
+    return 0L;
+  }
+  int64_t buffer_size = env->GetDirectBufferCapacity(byte_buffer);
+  if (width_step < width * num_channels ||
+      buffer_size < static_cast<int64_t>(width_step) * height) {
+    LOG(ERROR) << "Please check the input buffer size.";
+    LOG(ERROR) << "Buffer size: " << buffer_size
+               << ", Buffer size needed: " << width_step * height
+               << ", Width step: " << width_step;
+    return 0L;
+  }
+  // The frame shares the buffer's memory, so a global reference keeps the
+  // buffer alive until the frame releases it, possibly on another thread.
+  jobject buffer_ref = env->NewGlobalRef(byte_buffer);
+  mediapipe::Packet packet = mediapipe::MakePacket<mediapipe::ImageFrame>(
+      format, width, height, width_step, data, [buffer_ref](uint8*) {
+        mediapipe::java::GetJNIEnv()->DeleteGlobalRef(buffer_ref);
+      });
+  return CreatePacketWithContext(context, packet);
+}
+
 JNIEXPORT jlong JNICALL PACKET_CREATOR_METHOD(nativeCreateAudioPacket)(
     JNIEnv* env, jobject thiz, jlong context, jbyteArray data,
     jint num_channels, jint num_samples) {
@@ -188,6 +235,26 @@ JNIEXPORT jlong JNICALL PACKET_CREATOR_METHOD(nativeCreateAudioPacket)(
   return CreatePacketWithContext(context, packet);
 }
 
+JNIEXPORT jlong JNICALL PACKET_CREATOR_METHOD(nativeCreateInt16AudioPacket)(
+    JNIEnv* env, jobject thiz, jlong context, jbyteArray data,
+    jint num_channels, jint num_samples) {
+  const int num_bytes = num_channels * num_samples * 2;
+  if (env->GetArrayLength(data) != num_bytes) {
+    LOG(ERROR) << "Please check the audio data size, "
+                  "has to be num_channels * num_samples * 2 = "
+               << num_bytes;
+    return 0L;
+  }
+  std::unique_ptr<::mediapipe::Int16Matrix> matrix(
+      new ::mediapipe::Int16Matrix(num_channels, num_samples));
+  // The interleaved samples match the column-major layout of the matrix, and
+  // all Android ABIs are little-endian, so the bytes are copied as they are.
+  env->GetByteArrayRegion(data, 0, num_bytes,
+                          reinterpret_cast<jbyte*>(matrix->data()));
+  mediapipe::Packet packet = mediapipe::Adopt(matrix.release());
+  return CreatePacketWithContext(context, packet);
+}
+
 JNIEXPORT jlong JNICALL PACKET_CREATOR_METHOD(nativeCreateInt16)(JNIEnv* env,
                                                                  jobject thiz,
                                                                  jlong context,
@@ -268,14 +335,12 @@ JNIEXPORT jlong JNICALL PACKET_CREATOR_METHOD(nativeCreateMatrix)(
 
 #ifndef MEDIAPIPE_DISABLE_GPU
 
-JNIEXPORT jlong JNICALL PACKET_CREATOR_METHOD(nativeCreateGpuBuffer)(
-    JNIEnv* env, jobject thiz, jlong context, jint name, jint width,
-    jint height, jobject texture_release_callback) {
-  mediapipe::android::Graph* mediapipe_graph =
-      reinterpret_cast<mediapipe::android::Graph*>(context);
-  auto* gpu_resources = mediapipe_graph->GetGpuResources();
-  CHECK(gpu_resources) << "Cannot create a mediapipe::GpuBuffer packet on a "
-                          "graph without GPU support";
+namespace {
+
+// Returns a GlTextureBuffer deletion callback that hands the release sync
+// token to texture_release_callback, or an empty callback if that is null.
+mediapipe::GlTextureBuffer::DeletionCallback MakeTextureReleaseCallback(
+    JNIEnv* env, jobject thiz, jobject texture_release_callback) {
   mediapipe::GlTextureBuffer::DeletionCallback cc_callback;
 
   if (texture_release_callback) {
@@ -294,7 +359,7 @@ JNIEXPORT jlong JNICALL PACKET_CREATOR_METHOD(nativeCreateGpuBuffer)(
 
     jobject java_callback = env->NewGlobalRef(texture_release_callback);
     jobject packet_creator = env->NewGlobalRef(thiz);
-    cc_callback = [mediapipe_graph, packet_creator, release_method,
+    cc_callback = [packet_creator, release_method,
                    java_callback](mediapipe::GlSyncToken release_token) {
       JNIEnv* env = mediapipe::java::GetJNIEnv();
 
@@ -309,6 +374,21 @@ JNIEXPORT jlong JNICALL PACKET_CREATOR_METHOD(nativeCreateGpuBuffer)(
       env->DeleteGlobalRef(packet_creator);
     };
   }
+  return cc_callback;
+}
+
+}  // namespace
+
+JNIEXPORT jlong JNICALL PACKET_CREATOR_METHOD(nativeCreateGpuBuffer)(
+    JNIEnv* env, jobject thiz, jlong context, jint name, jint width,
+    jint height, jobject texture_release_callback) {
+  mediapipe::android::Graph* mediapipe_graph =
+      reinterpret_cast<mediapipe::android::Graph*>(context);
+  auto* gpu_resources = mediapipe_graph->GetGpuResources();
+  CHECK(gpu_resources) << "Cannot create a mediapipe::GpuBuffer packet on a "
+                          "graph without GPU support";
+  mediapipe::GlTextureBuffer::DeletionCallback cc_callback =
+      MakeTextureReleaseCallback(env, thiz, texture_release_callback);
   mediapipe::Packet packet = mediapipe::MakePacket<mediapipe::GpuBuffer>(
       mediapipe::GlTextureBuffer::Wrap(GL_TEXTURE_2D, name, width, height,
                                        mediapipe::GpuBufferFormat::kBGRA32,
@@ -316,6 +396,50 @@ JNIEXPORT jlong JNICALL PACKET_CREATOR_METHOD(nativeCreateGpuBuffer)(
   return CreatePacketWithContext(context, packet);
 }
 
+#if MEDIAPIPE_GPU_BUFFER_USE_AHWB
+JNIEXPORT jlong JNICALL
+PACKET_CREATOR_METHOD(nativeCreateGpuBufferFromHardwareBuffer)(
+    JNIEnv* env, jobject thiz, jlong context, jobject hardware_buffer,
+    jobject texture_release_callback) {
+  mediapipe::android::Graph* mediapipe_graph =
+      reinterpret_cast<mediapipe::android::Graph*>(context);
+  auto* gpu_resources = mediapipe_graph->GetGpuResources();
+  CHECK(gpu_resources) << "Cannot create a mediapipe::GpuBuffer packet on a "
+                          "graph without GPU support";
+  // AHardwareBuffer_fromHardwareBuffer is available from API level 26, which
+  // the Java side checks.
+  using FromHardwareBufferFunction = AHardwareBuffer* (*)(JNIEnv*, jobject);
+  static FromHardwareBufferFunction from_hardware_buffer =
+      reinterpret_cast<FromHardwareBufferFunction>(dlsym(
+          dlopen("libandroid.so", RTLD_NOW),
+          "AHardwareBuffer_fromHardwareBuffer"));
+  if (!from_hardware_buffer ||
+      !mediapipe::GlTextureBuffer::HardwareBuffersSupported()) {
+    LOG(ERROR) << "AHardwareBuffer import is not supported on this device.";
+    return 0L;
+  }
+  AHardwareBuffer* native_buffer = from_hardware_buffer(env, hardware_buffer);
+  mediapipe::GlTextureBuffer::DeletionCallback cc_callback =
+      MakeTextureReleaseCallback(env, thiz, texture_release_callback);
+
+  // The hardware buffer is bound to a texture on MediaPipe's own context, so
+  // the application's context does not need to be shared with it.
+  std::unique_ptr<mediapipe::GlTextureBuffer> texture_buffer;
+  gpu_resources->gl_context()->Run([&texture_buffer, native_buffer,
+                                    &cc_callback]() {
+    texture_buffer = mediapipe::GlTextureBuffer::WrapHardwareBuffer(
+        native_buffer, std::move(cc_callback));
+  });
+  if (!texture_buffer) {
+    LOG(ERROR) << "Failed to import the AHardwareBuffer into GL.";
+    return 0L;
+  }
+  mediapipe::Packet packet = mediapipe::MakePacket<mediapipe::GpuBuffer>(
+      std::move(texture_buffer));
+  return CreatePacketWithContext(context, packet);
+}
+#endif  // MEDIAPIPE_GPU_BUFFER_USE_AHWB
+
 #endif  // !defined(MEDIAPIPE_DISABLE_GPU)
 
 // TODO: Add vector creators.
@@ -35,6 +35,11 @@ JNIEXPORT jlong JNICALL PACKET_CREATOR_METHOD(nativeCreateRgbaImageFrame)(
     JNIEnv* env, jobject thiz, jlong context, jobject byte_buffer, jint width,
     jint height);
 
+JNIEXPORT jlong JNICALL
+PACKET_CREATOR_METHOD(nativeCreateImageFrameWrappingBuffer)(
+    JNIEnv* env, jobject thiz, jlong context, jobject byte_buffer, jint width,
+    jint height, jint width_step, jint num_channels);
+
 JNIEXPORT jlong JNICALL PACKET_CREATOR_METHOD(nativeCreateRgbImageFromRgba)(
     JNIEnv* env, jobject thiz, jlong context, jobject byte_buffer, jint width,
     jint height);
@@ -47,6 +52,10 @@ JNIEXPORT jlong JNICALL PACKET_CREATOR_METHOD(nativeCreateAudioPacket)(
     JNIEnv* env, jobject thiz, jlong context, jbyteArray data,
     jint num_channels, jint num_samples);
 
+JNIEXPORT jlong JNICALL PACKET_CREATOR_METHOD(nativeCreateInt16AudioPacket)(
+    JNIEnv* env, jobject thiz, jlong context, jbyteArray data,
+    jint num_channels, jint num_samples);
+
 JNIEXPORT jlong JNICALL PACKET_CREATOR_METHOD(nativeCreateInt16)(JNIEnv* env,
                                                                  jobject thiz,
                                                                  jlong context,
@@ -93,6 +102,14 @@ JNIEXPORT jlong JNICALL PACKET_CREATOR_METHOD(nativeCreateGpuBuffer)(
     JNIEnv* env, jobject thiz, jlong context, jint name, jint width,
     jint height, jobject texture_release_callback);
 
+// Wraps an android.hardware.HardwareBuffer as a GpuBuffer without copying it.
+// Returns 0 if the device cannot import hardware buffers into GL. Only
+// implemented on Android.
+JNIEXPORT jlong JNICALL
+PACKET_CREATOR_METHOD(nativeCreateGpuBufferFromHardwareBuffer)(
+    JNIEnv* env, jobject thiz, jlong context, jobject hardware_buffer,
+    jobject texture_release_callback);
+
 JNIEXPORT jlong JNICALL PACKET_CREATOR_METHOD(nativeCreateFloat32Array)(
     JNIEnv* env, jobject thiz, jlong context, jfloatArray data);
 
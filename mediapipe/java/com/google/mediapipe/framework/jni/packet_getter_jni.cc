@@ -15,6 +15,7 @@
 #include "mediapipe/java/com/google/mediapipe/framework/jni/packet_getter_jni.h"
 
 #include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/landmark.pb.h"
 #include "mediapipe/framework/formats/matrix.h"
 #include "mediapipe/framework/formats/time_series_header.pb.h"
 #include "mediapipe/framework/formats/video_stream_header.h"
@@ -31,6 +32,23 @@ template <typename T>
 const T& GetFromNativeHandle(int64_t packet_handle) {
   return mediapipe::android::Graph::GetPacketFromHandle(packet_handle).Get<T>();
 }
+
+// Returns the x, y and z coordinates of the landmarks, one after the other.
+template <typename LandmarkType>
+jfloatArray GetLandmarkCoordinates(JNIEnv* env, int64_t packet_handle) {
+  const auto& landmarks =
+      GetFromNativeHandle<std::vector<LandmarkType>>(packet_handle);
+  std::vector<float> coordinates;
+  coordinates.reserve(3 * landmarks.size());
+  for (const auto& landmark : landmarks) {
+    coordinates.push_back(landmark.x());
+    coordinates.push_back(landmark.y());
+    coordinates.push_back(landmark.z());
+  }
+  jfloatArray result = env->NewFloatArray(coordinates.size());
+  env->SetFloatArrayRegion(result, 0, coordinates.size(), coordinates.data());
+  return result;
+}
 }  // namespace
 
 JNIEXPORT jlong JNICALL PACKET_GETTER_METHOD(nativeGetPacketFromReference)(
@@ -141,6 +159,21 @@ JNIEXPORT jbyteArray JNICALL PACKET_GETTER_METHOD(nativeGetProtoBytes)(
   return data;
 }
 
+JNIEXPORT jint JNICALL PACKET_GETTER_METHOD(nativeGetProtoBytesIntoBuffer)(
+    JNIEnv* env, jobject thiz, jlong packet, jobject byte_buffer) {
+  mediapipe::Packet mediapipe_packet =
+      mediapipe::android::Graph::GetPacketFromHandle(packet);
+  const auto& proto_message = mediapipe_packet.GetProtoMessageLite();
+  const int64_t size = proto_message.ByteSizeLong();
+  void* data = env->GetDirectBufferAddress(byte_buffer);
+  // Only the size is returned when the buffer cannot hold the message, so
+  // that the caller can retry with a larger buffer.
+  if (data != nullptr && size <= env->GetDirectBufferCapacity(byte_buffer)) {
+    proto_message.SerializeToArray(data, size);
+  }
+  return size;
+}
+
 JNIEXPORT jshortArray JNICALL PACKET_GETTER_METHOD(nativeGetInt16Vector)(
     JNIEnv* env, jobject thiz, jlong packet) {
   const std::vector<int16_t>& values =
@@ -190,6 +223,19 @@ JNIEXPORT jdoubleArray JNICALL PACKET_GETTER_METHOD(nativeGetFloat64Vector)(
   return result;
 }
 
+JNIEXPORT jfloatArray JNICALL
+PACKET_GETTER_METHOD(nativeGetLandmarkCoordinates)(JNIEnv* env, jobject thiz,
+                                                   jlong packet) {
+  return GetLandmarkCoordinates<mediapipe::Landmark>(env, packet);
+}
+
+JNIEXPORT jfloatArray JNICALL
+PACKET_GETTER_METHOD(nativeGetNormalizedLandmarkCoordinates)(JNIEnv* env,
+                                                             jobject thiz,
+                                                             jlong packet) {
+  return GetLandmarkCoordinates<mediapipe::NormalizedLandmark>(env, packet);
+}
+
 JNIEXPORT jint JNICALL PACKET_GETTER_METHOD(nativeGetImageWidth)(JNIEnv* env,
                                                                  jobject thiz,
                                                                  jlong packet) {
@@ -69,6 +69,9 @@ JNIEXPORT jbyteArray JNICALL PACKET_GETTER_METHOD(nativeGetBytes)(JNIEnv* env,
 JNIEXPORT jbyteArray JNICALL PACKET_GETTER_METHOD(nativeGetProtoBytes)(
     JNIEnv* env, jobject thiz, jlong packet);
 
+JNIEXPORT jint JNICALL PACKET_GETTER_METHOD(nativeGetProtoBytesIntoBuffer)(
+    JNIEnv* env, jobject thiz, jlong packet, jobject byte_buffer);
+
 JNIEXPORT jshortArray JNICALL PACKET_GETTER_METHOD(nativeGetInt16Vector)(
     JNIEnv* env, jobject thiz, jlong packet);
 
@@ -84,6 +87,16 @@ JNIEXPORT jfloatArray JNICALL PACKET_GETTER_METHOD(nativeGetFloat32Vector)(
 JNIEXPORT jdoubleArray JNICALL PACKET_GETTER_METHOD(nativeGetFloat64Vector)(
     JNIEnv* env, jobject thiz, jlong packet);
 
+// Landmark jni functions.
+JNIEXPORT jfloatArray JNICALL
+PACKET_GETTER_METHOD(nativeGetLandmarkCoordinates)(JNIEnv* env, jobject thiz,
+                                                   jlong packet);
+
+JNIEXPORT jfloatArray JNICALL
+PACKET_GETTER_METHOD(nativeGetNormalizedLandmarkCoordinates)(JNIEnv* env,
+                                                             jobject thiz,
+                                                             jlong packet);
+
 // ImageFrame jni functions.
 JNIEXPORT jint JNICALL PACKET_GETTER_METHOD(nativeGetImageWidth)(JNIEnv* env,
                                                                  jobject thiz,
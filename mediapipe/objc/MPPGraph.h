@@ -50,6 +50,14 @@ struct GpuSharedData;
        didOutputPacket:(const mediapipe::Packet&)packet
             fromStream:(const std::string&)streamName;
 
+/// Provides the delegate with the raw packets of several streams at one
+/// timestamp, in the order of streamNames. Streams without a packet at that
+/// timestamp have an empty packet.
+@optional
+- (void)mediapipeGraph:(MPPGraph*)graph
+      didOutputPackets:(const std::vector<mediapipe::Packet>&)packets
+           fromStreams:(const std::vector<std::string>&)streamNames;
+
 @end
 
 /// Chooses the packet type used by MPPGraph to send and receive packets
@@ -88,7 +96,8 @@ typedef NS_ENUM(int, MPPPacketType) {
 /// cannot keep up with the speed of video input.
 /// This works as long as frames are sent or received using these methods:
 ///  - sendPixelBuffer:intoStream:packetType:[timestamp:]
-///  - addFrameOutputStream:outputPacketType:
+///  - addFrameOutputStream:outputPacketType:[delegateQueue:]
+///  - addMultiStreamOutput:[delegateQueue:]
 /// Set to 0 (the default) for no limit.
 @property(nonatomic) int maxFramesInFlight;
 
@@ -131,6 +140,28 @@ typedef NS_ENUM(int, MPPPacketType) {
 - (void)addFrameOutputStream:(const std::string&)outputStreamName
             outputPacketType:(MPPPacketType)packetType;
 
+/// Same as addFrameOutputStream:outputPacketType:, but calls the delegate
+/// asynchronously on the given queue instead of on the graph's thread. Streams
+/// using different queues are then delivered concurrently, and a slow delegate
+/// does not hold up the graph.
+/// @param queue The queue on which to call the delegate, or nil to call it
+///              synchronously.
+- (void)addFrameOutputStream:(const std::string&)outputStreamName
+            outputPacketType:(MPPPacketType)packetType
+               delegateQueue:(dispatch_queue_t)queue;
+
+/// Adds output streams whose raw packets are delivered to the delegate
+/// together, with one mediapipeGraph:didOutputPackets:fromStreams: call per
+/// timestamp instead of one call per packet.
+/// @param outputStreamNames The names of the output streams from which the
+///                          delegate will receive packets.
+- (void)addMultiStreamOutput:(const std::vector<std::string>&)outputStreamNames;
+
+/// Same as addMultiStreamOutput:, but calls the delegate asynchronously on the
+/// given queue, or synchronously if it is nil.
+- (void)addMultiStreamOutput:(const std::vector<std::string>&)outputStreamNames
+               delegateQueue:(dispatch_queue_t)queue;
+
 /// Starts running the graph.
 /// @return YES if successful.
 - (BOOL)startWithError:(NSError**)error;
@@ -186,6 +217,16 @@ typedef NS_ENUM(int, MPPPacketType) {
              intoStream:(const std::string&)inputName
              packetType:(MPPPacketType)packetType;
 
+/// Sends a CGImage into a graph input stream as an ImageFrame packet. The
+/// ImageFrame references the image's pixel data without copying it when the
+/// layout allows; see CreateImageFrameForCGImage. The graph must have been
+/// started before calling this. Drops frames and returns NO if
+/// maxFramesInFlight is exceeded. Returns YES if the packet was successfully
+/// sent.
+- (BOOL)sendCGImage:(CGImageRef)image
+         intoStream:(const std::string&)inputName
+          timestamp:(const mediapipe::Timestamp&)timestamp;
+
 /// Cancels a graph run. You must still call waitUntilDoneWithError: after this.
 - (void)cancel;
 
@@ -78,6 +78,12 @@
 
 - (void)addFrameOutputStream:(const std::string&)outputStreamName
             outputPacketType:(MPPPacketType)packetType {
+  [self addFrameOutputStream:outputStreamName outputPacketType:packetType delegateQueue:nil];
+}
+
+- (void)addFrameOutputStream:(const std::string&)outputStreamName
+            outputPacketType:(MPPPacketType)packetType
+               delegateQueue:(dispatch_queue_t)queue {
   std::string callbackInputName;
   mediapipe::tool::AddCallbackCalculator(outputStreamName, &_config, &callbackInputName,
                                        /*use_std_function=*/true);
@@ -86,11 +92,44 @@
   void* wrapperVoid = (__bridge void*)self;
   _inputSidePackets[callbackInputName] =
       mediapipe::MakePacket<std::function<void(const mediapipe::Packet&)>>(
-          [wrapperVoid, outputStreamName, packetType](const mediapipe::Packet& packet) {
-            CallFrameDelegate(wrapperVoid, outputStreamName, packetType, packet);
+          [wrapperVoid, outputStreamName, packetType, queue](const mediapipe::Packet& packet) {
+            if (!queue) {
+              CallFrameDelegate(wrapperVoid, outputStreamName, packetType, packet);
+              return;
+            }
+            // The block keeps the graph alive until the delegate has been called.
+            MPPGraph* wrapper = (__bridge MPPGraph*)wrapperVoid;
+            dispatch_async(queue, ^{
+              CallFrameDelegate((__bridge void*)wrapper, outputStreamName, packetType, packet);
+            });
           });
 }
 
+- (void)addMultiStreamOutput:(const std::vector<std::string>&)outputStreamNames {
+  [self addMultiStreamOutput:outputStreamNames delegateQueue:nil];
+}
+
+- (void)addMultiStreamOutput:(const std::vector<std::string>&)outputStreamNames
+               delegateQueue:(dispatch_queue_t)queue {
+  // See addFrameOutputStream:outputPacketType:delegateQueue: for why void* is used.
+  void* wrapperVoid = (__bridge void*)self;
+  std::pair<std::string, mediapipe::Packet> callbackSidePacket;
+  mediapipe::tool::AddMultiStreamCallback(
+      outputStreamNames,
+      [wrapperVoid, outputStreamNames, queue](const std::vector<mediapipe::Packet>& packets) {
+        if (!queue) {
+          CallMultiStreamDelegate(wrapperVoid, outputStreamNames, packets);
+          return;
+        }
+        MPPGraph* wrapper = (__bridge MPPGraph*)wrapperVoid;
+        dispatch_async(queue, ^{
+          CallMultiStreamDelegate((__bridge void*)wrapper, outputStreamNames, packets);
+        });
+      },
+      &_config, &callbackSidePacket);
+  _inputSidePackets[callbackSidePacket.first] = callbackSidePacket.second;
+}
+
 - (NSString *)description {
   return [NSString stringWithFormat:@"<%@: %p; framesInFlight = %d>", [self class], self,
                                     _framesInFlight.load(std::memory_order_relaxed)];
@@ -187,6 +226,17 @@ void CallFrameDelegate(void* wrapperVoid, const std::string& streamName,
   }
 }
 
+/// This is the function that gets called by the CallbackCalculator that
+/// receives the packets of a multi-stream output.
+void CallMultiStreamDelegate(void* wrapperVoid, const std::vector<std::string>& streamNames,
+                             const std::vector<mediapipe::Packet>& packets) {
+  MPPGraph* wrapper = (__bridge MPPGraph*)wrapperVoid;
+  @autoreleasepool {
+    [wrapper.delegate mediapipeGraph:wrapper didOutputPackets:packets fromStreams:streamNames];
+    wrapper->_framesInFlight--;
+  }
+}
+
 - (void)setHeaderPacket:(const mediapipe::Packet&)packet forStream:(const std::string&)streamName {
   _GTMDevAssert(!_started, @"%@ must be called before the graph is started",
                 NSStringFromSelector(_cmd));
@@ -351,6 +401,26 @@ void CallFrameDelegate(void* wrapperVoid, const std::string& streamName,
                      timestamp:_frameTimestamp];
 }
 
+- (BOOL)sendCGImage:(CGImageRef)image
+         intoStream:(const std::string&)inputName
+          timestamp:(const mediapipe::Timestamp&)timestamp {
+  if (_maxFramesInFlight && _framesInFlight >= _maxFramesInFlight) return NO;
+  std::unique_ptr<mediapipe::ImageFrame> frame;
+  ::mediapipe::Status status = CreateImageFrameForCGImage(image, &frame);
+  NSError* error;
+  BOOL success = NO;
+  if (status.ok()) {
+    success = [self movePacket:mediapipe::Adopt(frame.release()).At(timestamp)
+                    intoStream:inputName
+                         error:&error];
+  } else {
+    error = [NSError gus_errorWithStatus:status];
+  }
+  if (success) _framesInFlight++;
+  else _GTMDevLog(@"failed to send packet: %@", error);
+  return success;
+}
+
 - (void)debugPrintGlInfo {
   std::shared_ptr<mediapipe::GpuResources> gpu_resources = _graph->GetGpuResources();
   if (!gpu_resources) {
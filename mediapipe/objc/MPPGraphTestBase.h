@@ -34,6 +34,10 @@
   /// object to act as the delegate.
   void (^_packetOutputBlock)(MPPGraph* graph, const mediapipe::Packet& packet,
                              const std::string& streamName);
+
+  /// This block is used to respond to mediapipeGraph:didOutputPackets:fromStreams:.
+  void (^_packetsOutputBlock)(MPPGraph* graph, const std::vector<mediapipe::Packet>& packets,
+                              const std::vector<std::string>& streamNames);
 }
 
 /// Runs a single frame through a simple graph. The graph is expected to have an
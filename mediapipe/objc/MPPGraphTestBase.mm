@@ -179,6 +179,12 @@ static void EnsureOutputDirFor(NSString *outputFile) {
   _packetOutputBlock(graph, packet, streamName);
 }
 
+- (void)mediapipeGraph:(MPPGraph*)graph
+      didOutputPackets:(const std::vector<mediapipe::Packet>&)packets
+           fromStreams:(const std::vector<std::string>&)streamNames {
+  _packetsOutputBlock(graph, packets, streamNames);
+}
+
 - (BOOL)pixelBuffer:(CVPixelBufferRef)a isEqualTo:(CVPixelBufferRef)b {
   return [self pixelBuffer:a isCloseTo:b maxLocalDifference:0 maxAverageDifference:0];
 }
@@ -149,6 +149,48 @@ REGISTER_CALCULATOR(ErrorCalculator);
   return filteredImage;
 }
 
+/// Returns a 3x2 image of opaque pixels with distinct channel values, stored
+/// with the given bitmap info.
+- (CGImageRef)createTestCGImageWithBitmapInfo:(uint32_t)bitmapInfo CF_RETURNS_RETAINED {
+  CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+  CGContextRef context = CGBitmapContextCreate(NULL, 3, 2, 8, 0, colorSpace, bitmapInfo);
+  CGColorSpaceRelease(colorSpace);
+  for (int i = 0; i < 6; ++i) {
+    CGContextSetRGBFillColor(context, (10 * i + 5) / 255.0, (10 * i + 100) / 255.0,
+                             (10 * i + 200) / 255.0, 1.0);
+    CGContextFillRect(context, CGRectMake(i % 3, i / 3, 1, 1));
+  }
+  CGImageRef image = CGBitmapContextCreateImage(context);
+  CGContextRelease(context);
+  return image;
+}
+
+- (void)testCreateImageFrameForCGImage {
+  // RGBA is referenced directly, BGRA is drawn into a new frame.
+  for (NSNumber* bitmapInfo in @[
+         @(kCGBitmapByteOrder32Big | kCGImageAlphaPremultipliedLast),
+         @(kCGBitmapByteOrder32Little | kCGImageAlphaPremultipliedFirst)
+       ]) {
+    CGImageRef image = [self createTestCGImageWithBitmapInfo:bitmapInfo.unsignedIntValue];
+    std::unique_ptr<mediapipe::ImageFrame> frame;
+    ::mediapipe::Status status = CreateImageFrameForCGImage(image, &frame);
+    CGImageRelease(image);
+    XCTAssert(status.ok());
+    XCTAssertEqual(frame->Format(), mediapipe::ImageFormat::SRGBA);
+    XCTAssertEqual(frame->Width(), 3);
+    XCTAssertEqual(frame->Height(), 2);
+    for (int i = 0; i < 6; ++i) {
+      // Core Graphics rows go top to bottom in memory, with y pointing up.
+      const uint8* pixel =
+          frame->PixelData() + (1 - i / 3) * frame->WidthStep() + (i % 3) * 4;
+      XCTAssertEqual(pixel[0], 10 * i + 5);
+      XCTAssertEqual(pixel[1], 10 * i + 100);
+      XCTAssertEqual(pixel[2], 10 * i + 200);
+      XCTAssertEqual(pixel[3], 255);
+    }
+  }
+}
+
 - (void)testMultipleOutputs {
   mediapipe::CalculatorGraphConfig config;
   config.add_input_stream("input_frames");
@@ -339,4 +381,52 @@ REGISTER_CALCULATOR(ErrorCalculator);
   [self waitForExpectationsWithTimeout:3.0 handler:NULL];
 }
 
+- (void)testMultiStreamOutputOnQueue {
+  mediapipe::CalculatorGraphConfig config;
+  config.add_input_stream("input_ints");
+  config.add_input_stream("input_floats");
+  auto node = config.add_node();
+  node->set_calculator("PassThroughCalculator");
+  node->add_input_stream("input_ints");
+  node->add_input_stream("input_floats");
+  node->add_output_stream("output_ints");
+  node->add_output_stream("output_floats");
+
+  _graph = [[MPPGraph alloc] initWithGraphConfig:config];
+  dispatch_queue_t queue = dispatch_queue_create("delegate", DISPATCH_QUEUE_SERIAL);
+  static const char kQueueKey = 0;
+  dispatch_queue_set_specific(queue, &kQueueKey, (void*)&kQueueKey, NULL);
+  [_graph addMultiStreamOutput:{"output_ints", "output_floats"} delegateQueue:queue];
+  _graph.delegate = self;
+
+  WEAKIFY(self);
+  XCTestExpectation* outputReceived = [self expectationWithDescription:@"output received"];
+  _packetsOutputBlock = ^(MPPGraph* outputGraph, const std::vector<mediapipe::Packet>& packets,
+                          const std::vector<std::string>& outputStreamNames) {
+    STRONGIFY(self);
+    XCTAssertEqualObjects(outputGraph, _graph);
+    XCTAssert(dispatch_get_specific(&kQueueKey) != NULL);
+    XCTAssertEqual(outputStreamNames.size(), 2);
+    XCTAssertEqual(packets[0].Get<int>(), 10);
+    XCTAssertEqual(packets[1].Get<float>(), 0.5f);
+    [outputReceived fulfill];
+  };
+
+  XCTAssert([_graph startWithError:nil]);
+  XCTAssert([_graph sendPacket:mediapipe::MakePacket<int>(10).At(mediapipe::Timestamp(1))
+                    intoStream:"input_ints"
+                         error:nil]);
+  XCTAssert([_graph sendPacket:mediapipe::MakePacket<float>(0.5f).At(mediapipe::Timestamp(1))
+                    intoStream:"input_floats"
+                         error:nil]);
+  XCTAssert([_graph closeAllInputStreamsWithError:nil]);
+  XCTestExpectation* graphDone = [self expectationWithDescription:@"graph done"];
+  dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+    XCTAssert([_graph waitUntilDoneWithError:nil]);
+    [graphDone fulfill];
+  });
+
+  [self waitForExpectationsWithTimeout:3.0 handler:NULL];
+}
+
 @end
@@ -33,9 +33,13 @@
     // Necessary to ensure the video's preferred transform is respected.
     _videoItem.videoComposition = [AVVideoComposition videoCompositionWithPropertiesOfAsset:_video];
 
+    // IOSurface-backed buffers that the GL and Metal texture caches of
+    // MPPGraphGPUData can wrap, so GpuBuffer packets need no copies.
     _videoOutput = [[AVPlayerItemVideoOutput alloc] initWithPixelBufferAttributes:@{
       (id)kCVPixelBufferPixelFormatTypeKey : @(kCVPixelFormatType_32BGRA),
-      (id)kCVPixelBufferIOSurfacePropertiesKey : [NSDictionary dictionary]
+      (id)kCVPixelBufferIOSurfacePropertiesKey : [NSDictionary dictionary],
+      (id)kCVPixelBufferOpenGLESCompatibilityKey : @YES,
+      (id)kCVPixelBufferMetalCompatibilityKey : @YES,
     }];
     _videoOutput.suppressesPlayerRendering = YES;
     [_videoItem addOutput:_videoOutput];
@@ -151,6 +151,47 @@ vImageConverterRef vImageConverterForCVPixelFormats(OSType src_pixel_format,
   return converter;
 }
 
+// Returns the ImageFrame format with the memory layout of the pixels of
+// "image", or UNKNOWN if there is none.
+mediapipe::ImageFormat::Format ImageFormatForCGImage(CGImageRef image) {
+  const CGBitmapInfo bitmap_info = CGImageGetBitmapInfo(image);
+  if (CGImageGetBitsPerComponent(image) != 8 ||
+      (bitmap_info & kCGBitmapFloatComponents)) {
+    return mediapipe::ImageFormat::UNKNOWN;
+  }
+  const CGImageAlphaInfo alpha_info = CGImageGetAlphaInfo(image);
+  const CGBitmapInfo byte_order = bitmap_info & kCGBitmapByteOrderMask;
+  const size_t bits_per_pixel = CGImageGetBitsPerPixel(image);
+  switch (CGColorSpaceGetModel(CGImageGetColorSpace(image))) {
+    case kCGColorSpaceModelMonochrome:
+      if (bits_per_pixel == 8 && alpha_info == kCGImageAlphaNone) {
+        return mediapipe::ImageFormat::GRAY8;
+      }
+      break;
+
+    case kCGColorSpaceModelRGB:
+      // 32Little would store A, B, G, R.
+      if (byte_order != kCGBitmapByteOrderDefault &&
+          byte_order != kCGBitmapByteOrder32Big) {
+        break;
+      }
+      if (bits_per_pixel == 24 && alpha_info == kCGImageAlphaNone) {
+        return mediapipe::ImageFormat::SRGB;
+      }
+      if (bits_per_pixel == 32 &&
+          (alpha_info == kCGImageAlphaLast ||
+           alpha_info == kCGImageAlphaPremultipliedLast ||
+           alpha_info == kCGImageAlphaNoneSkipLast)) {
+        return mediapipe::ImageFormat::SRGBA;
+      }
+      break;
+
+    default:
+      break;
+  }
+  return mediapipe::ImageFormat::UNKNOWN;
+}
+
 }  // unnamed namespace
 
 vImage_Error vImageGrayToBGRA(const vImage_Buffer* src, vImage_Buffer* dst) {
@@ -423,6 +464,47 @@ CVPixelBufferRef CreateCVPixelBufferForImageFramePacket(
   return ::mediapipe::OkStatus();
 }
 
+::mediapipe::Status CreateImageFrameForCGImage(
+    CGImageRef image, std::unique_ptr<mediapipe::ImageFrame>* frame) {
+  RET_CHECK(image);
+  RET_CHECK(frame);
+  const size_t width = CGImageGetWidth(image);
+  const size_t height = CGImageGetHeight(image);
+
+  const mediapipe::ImageFormat::Format image_format =
+      ImageFormatForCGImage(image);
+  if (image_format != mediapipe::ImageFormat::UNKNOWN) {
+    CGDataProviderRef provider = CGImageGetDataProvider(image);
+    CFDataRef data = provider ? CGDataProviderCopyData(provider) : nullptr;
+    if (data) {
+      CGDataProviderRetain(provider);
+      *frame = absl::make_unique<mediapipe::ImageFrame>(
+          image_format, width, height, CGImageGetBytesPerRow(image),
+          const_cast<uint8*>(CFDataGetBytePtr(data)),
+          [provider, data](uint8*) {
+            CFRelease(data);
+            CGDataProviderRelease(provider);
+          });
+      return ::mediapipe::OkStatus();
+    }
+  }
+
+  auto copy = absl::make_unique<mediapipe::ImageFrame>(
+      mediapipe::ImageFormat::SRGBA, width, height);
+  CGColorSpaceRef color_space = CGColorSpaceCreateDeviceRGB();
+  CGContextRef context = CGBitmapContextCreate(
+      copy->MutablePixelData(), width, height, 8, copy->WidthStep(),
+      color_space, kCGBitmapByteOrder32Big | kCGImageAlphaPremultipliedLast);
+  CGColorSpaceRelease(color_space);
+  RET_CHECK(context) << "CGBitmapContextCreate failed";
+  CGRect rect = CGRectMake(0, 0, width, height);
+  CGContextClearRect(context, rect);
+  CGContextDrawImage(context, rect, image);
+  CGContextRelease(context);
+  *frame = std::move(copy);
+  return ::mediapipe::OkStatus();
+}
+
 std::unique_ptr<mediapipe::ImageFrame> CreateImageFrameForCVPixelBuffer(
     CVPixelBufferRef image_buffer) {
   return CreateImageFrameForCVPixelBuffer(image_buffer, false, false);
@@ -514,7 +596,7 @@ CFDictionaryRef GetCVPixelBufferAttributesForGlCompatibility() {
         kCFAllocatorDefault, NULL, NULL, 0, &kCFTypeDictionaryKeyCallBacks,
         &kCFTypeDictionaryValueCallBacks);
     // To ensure compatibility with CVOpenGLESTextureCache, these attributes
-    // should be present.
+    // should be present. The Metal key covers CVMetalTextureCache.
     const void* keys[] = {
       kCVPixelBufferIOSurfacePropertiesKey,
 #if TARGET_OS_OSX
@@ -522,8 +604,9 @@ CFDictionaryRef GetCVPixelBufferAttributesForGlCompatibility() {
 #else
       kCVPixelFormatOpenGLESCompatibility,
 #endif  // TARGET_OS_OSX
+      kCVPixelBufferMetalCompatibilityKey,
     };
-    const void* values[] = {empty_dict, kCFBooleanTrue};
+    const void* values[] = {empty_dict, kCFBooleanTrue, kCFBooleanTrue};
     attrs = CFDictionaryCreate(
         kCFAllocatorDefault, keys, values, ABSL_ARRAYSIZE(values),
         &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
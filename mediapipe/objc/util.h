@@ -87,6 +87,17 @@ void ReleaseMediaPipePacket(void* refcon, const void* base_address);
 ::mediapipe::Status CreateCGImageFromCVPixelBuffer(
     CVPixelBufferRef image_buffer, CFHolder<CGImageRef>* image);
 
+/// Creates an ImageFrame with the contents of the CGImage. If the image's
+/// pixels are 8-bit gray, RGB, or RGBA with alpha last (premultiplied or not,
+/// or skipped) in R, G, B, A byte order, the ImageFrame references the data
+/// of the image's data provider without copying it, and releases the data
+/// and the provider when it is destroyed. CGDataProviderCopyData() returns
+/// the backing store of memory-backed providers, such as those of decoded
+/// images and of CGBitmapContextCreateImage(), without copying it. Other
+/// images are drawn into a new SRGBA ImageFrame, with premultiplied alpha.
+::mediapipe::Status CreateImageFrameForCGImage(
+    CGImageRef image, std::unique_ptr<mediapipe::ImageFrame>* frame);
+
 /// DEPRECATED: use the version that returns ::mediapipe::Status instead.
 CVPixelBufferRef CreateCVPixelBufferForImageFramePacket(
     const mediapipe::Packet& image_frame_packet);
@@ -111,7 +122,8 @@ std::unique_ptr<mediapipe::ImageFrame> CreateImageFrameForCVPixelBuffer(
 
 /// Returns a CFDictionaryRef that can be passed to CVPixelBufferCreate to
 /// ensure that the pixel buffer is compatible with OpenGL ES and with
-/// CVOpenGLESTextureCacheCreateTextureFromImage.
+/// CVOpenGLESTextureCacheCreateTextureFromImage, and with
+/// CVMetalTextureCacheCreateTextureFromImage.
 /// The returned object is persistent and should not be released.
 CFDictionaryRef GetCVPixelBufferAttributesForGlCompatibility();
 
@@ -0,0 +1,130 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "mediapipe/util/alpha_blend_util.h"
+
+#include <vector>
+
+#include "libyuv/convert_argb.h"
+#include "libyuv/planar_functions.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+#include "mediapipe/util/parallel_for_rows.h"
+
+namespace mediapipe {
+namespace alpha_blend_util {
+
+namespace {
+
+// Bands smaller than this are not worth handing to another thread.
+constexpr int kMinRowsPerBand = 16;
+
+void CheckSetAlphaArgs(const cv::Mat& input, const cv::Mat& output) {
+  CHECK(input.type() == CV_8UC3 || input.type() == CV_8UC4)
+      << "Only 3 or 4 channel 8-bit input image supported";
+  CHECK_EQ(output.type(), CV_8UC4);
+  CHECK_EQ(input.rows, output.rows);
+  CHECK_EQ(input.cols, output.cols);
+}
+
+// Copies the color channels of rows [begin, end) of "input" into "output".
+// The alpha channel of "output" is left at 255 for 3 channel input, and is
+// copied from "input" otherwise. libyuv's ARGB is B, G, R, A in memory and
+// RGB24 is B, G, R, so both conversions preserve the byte order and work for
+// RGB(A) just as well.
+void CopyColorRows(const cv::Mat& input, int begin, int end, cv::Mat* output) {
+  const int num_rows = end - begin;
+  if (input.channels() == 3) {
+    libyuv::RGB24ToARGB(input.ptr<uint8>(begin), input.step, output->ptr(begin),
+                        output->step, input.cols, num_rows);
+  } else {
+    libyuv::ARGBCopy(input.ptr<uint8>(begin), input.step, output->ptr(begin),
+                     output->step, input.cols, num_rows);
+  }
+}
+
+}  // namespace
+
+void SetAlphaFromMask(const cv::Mat& input, const cv::Mat& alpha,
+                      cv::Mat* output) {
+  CheckSetAlphaArgs(input, *output);
+  CHECK_EQ(alpha.depth(), CV_8U);
+  CHECK_EQ(input.rows, alpha.rows);
+  CHECK_EQ(input.cols, alpha.cols);
+
+  cv::Mat alpha_plane = alpha;
+  if (alpha.channels() != 1) {
+    cv::extractChannel(alpha, alpha_plane, 0);
+  }
+  ParallelForRows(input.rows, kMinRowsPerBand, [&](int begin, int end) {
+    CopyColorRows(input, begin, end, output);
+    libyuv::ARGBCopyYToAlpha(alpha_plane.ptr<uint8>(begin), alpha_plane.step,
+                             output->ptr(begin), output->step, input.cols,
+                             end - begin);
+  });
+}
+
+void SetAlphaFromValue(const cv::Mat& input, uint8 alpha, cv::Mat* output) {
+  CheckSetAlphaArgs(input, *output);
+
+  // A single row of alpha values, repeated for every row with stride 0.
+  const std::vector<uint8> alpha_row(input.cols, alpha);
+  ParallelForRows(input.rows, kMinRowsPerBand, [&](int begin, int end) {
+    CopyColorRows(input, begin, end, output);
+    if (input.channels() == 4 || alpha != 255) {
+      libyuv::ARGBCopyYToAlpha(alpha_row.data(), /*src_stride_y=*/0,
+                               output->ptr(begin), output->step, input.cols,
+                               end - begin);
+    }
+  });
+}
+
+void BlendWithMask(const cv::Mat& frame0, const cv::Mat& frame1,
+                   const cv::Mat& mask, int mask_channel, cv::Mat* output) {
+  CHECK_EQ(frame0.depth(), CV_8U);
+  CHECK_EQ(frame0.type(), frame1.type());
+  CHECK_EQ(frame0.type(), output->type());
+  CHECK_EQ(mask.depth(), CV_8U);
+  CHECK(frame0.size() == frame1.size() && frame0.size() == mask.size() &&
+        frame0.size() == output->size());
+  CHECK_GE(mask_channel, 0);
+  CHECK_LT(mask_channel, mask.channels());
+
+  cv::Mat mask_plane = mask;
+  if (mask.channels() != 1) {
+    cv::extractChannel(mask, mask_plane, mask_channel);
+  }
+  const int num_channels = frame0.channels();
+  const int row_bytes = frame0.cols * num_channels;
+  ParallelForRows(frame0.rows, kMinRowsPerBand, [&](int begin, int end) {
+    // BlendPlane() takes one alpha value per byte, so replicate the mask
+    // across channels first. Done per band to keep it in cache.
+    cv::Mat band_alpha = mask_plane.rowRange(begin, end);
+    if (num_channels != 1) {
+      cv::Mat expanded;
+      cv::merge(std::vector<cv::Mat>(num_channels, band_alpha), expanded);
+      band_alpha = expanded;
+    }
+    // BlendPlane() computes (src0 * alpha + src1 * (255 - alpha) + 255) >> 8.
+    libyuv::BlendPlane(frame1.ptr<uint8>(begin), frame1.step,
+                       frame0.ptr<uint8>(begin), frame0.step,
+                       band_alpha.ptr<uint8>(0), band_alpha.step,
+                       output->ptr(begin), output->step, row_bytes,
+                       end - begin);
+  });
+}
+
+}  // namespace alpha_blend_util
+}  // namespace mediapipe
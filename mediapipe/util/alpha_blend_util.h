@@ -0,0 +1,50 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//
+// Vectorized kernels for alpha channel insertion and mask blending on 8-bit
+// interleaved images. The row kernels come from libyuv, which picks the
+// SSE/AVX/NEON variant at runtime, and rows are split across threads with
+// ParallelForRows().
+
+#ifndef MEDIAPIPE_UTIL_ALPHA_BLEND_UTIL_H_
+#define MEDIAPIPE_UTIL_ALPHA_BLEND_UTIL_H_
+
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+
+namespace mediapipe {
+namespace alpha_blend_util {
+
+// Copies the color channels of "input" (CV_8UC3 or CV_8UC4) into "output"
+// (CV_8UC4, same size) and fills the alpha channel of "output" with channel 0
+// of "alpha" (8-bit, any number of channels, same size).
+void SetAlphaFromMask(const cv::Mat& input, const cv::Mat& alpha,
+                      cv::Mat* output);
+
+// Same as above, but sets every alpha value of "output" to "alpha".
+void SetAlphaFromValue(const cv::Mat& input, uint8 alpha, cv::Mat* output);
+
+// Computes output = frame0 * (1 - mask) + frame1 * mask on every channel,
+// where mask is channel "mask_channel" of "mask" scaled to [0, 1]. This is
+// the blend done by MaskOverlayCalculator. frame0, frame1 and output are
+// 8-bit with the same size and number of channels; "output" may alias
+// either frame.
+void BlendWithMask(const cv::Mat& frame0, const cv::Mat& frame1,
+                   const cv::Mat& mask, int mask_channel, cv::Mat* output);
+
+}  // namespace alpha_blend_util
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_ALPHA_BLEND_UTIL_H_
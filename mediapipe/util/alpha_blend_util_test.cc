@@ -0,0 +1,117 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "mediapipe/util/alpha_blend_util.h"
+
+#include <cstdlib>
+
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+
+namespace mediapipe {
+namespace alpha_blend_util {
+namespace {
+
+cv::Mat MakePattern(int rows, int cols, int type, int seed) {
+  cv::Mat mat(rows, cols, type);
+  for (int row = 0; row < rows; ++row) {
+    uint8* pixel = mat.ptr<uint8>(row);
+    for (int i = 0; i < cols * mat.channels(); ++i) {
+      pixel[i] = (row * 31 + i * 7 + seed) % 256;
+    }
+  }
+  return mat;
+}
+
+TEST(AlphaBlendUtilTest, SetAlphaFromMask) {
+  for (int type : {CV_8UC3, CV_8UC4}) {
+    // Odd width so the vector kernels also run their tail.
+    const cv::Mat input = MakePattern(37, 67, type, 1);
+    const cv::Mat mask = MakePattern(37, 67, CV_8UC3, 2);
+    cv::Mat output(37, 67, CV_8UC4);
+    SetAlphaFromMask(input, mask, &output);
+    for (int row = 0; row < input.rows; ++row) {
+      for (int col = 0; col < input.cols; ++col) {
+        const uint8* in = input.ptr<uint8>(row) + col * input.channels();
+        const uint8* out = output.ptr<uint8>(row) + col * 4;
+        ASSERT_EQ(in[0], out[0]);
+        ASSERT_EQ(in[1], out[1]);
+        ASSERT_EQ(in[2], out[2]);
+        ASSERT_EQ(mask.ptr<uint8>(row)[col * 3], out[3]);
+      }
+    }
+  }
+}
+
+TEST(AlphaBlendUtilTest, SetAlphaFromValue) {
+  for (int type : {CV_8UC3, CV_8UC4}) {
+    for (int alpha : {0, 128, 255}) {
+      const cv::Mat input = MakePattern(20, 33, type, 3);
+      cv::Mat output(20, 33, CV_8UC4);
+      SetAlphaFromValue(input, alpha, &output);
+      for (int row = 0; row < input.rows; ++row) {
+        for (int col = 0; col < input.cols; ++col) {
+          const uint8* in = input.ptr<uint8>(row) + col * input.channels();
+          const uint8* out = output.ptr<uint8>(row) + col * 4;
+          ASSERT_EQ(in[0], out[0]);
+          ASSERT_EQ(in[2], out[2]);
+          ASSERT_EQ(alpha, out[3]);
+        }
+      }
+    }
+  }
+}
+
+TEST(AlphaBlendUtilTest, BlendWithMask) {
+  const cv::Mat frame0 = MakePattern(41, 65, CV_8UC4, 4);
+  const cv::Mat frame1 = MakePattern(41, 65, CV_8UC4, 5);
+  const cv::Mat mask = MakePattern(41, 65, CV_8UC4, 6);
+  cv::Mat output(41, 65, CV_8UC4);
+  BlendWithMask(frame0, frame1, mask, /*mask_channel=*/3, &output);
+  for (int row = 0; row < frame0.rows; ++row) {
+    for (int i = 0; i < frame0.cols * 4; ++i) {
+      const float m = mask.ptr<uint8>(row)[(i / 4) * 4 + 3] / 255.f;
+      const float expected =
+          frame0.ptr<uint8>(row)[i] * (1 - m) + frame1.ptr<uint8>(row)[i] * m;
+      ASSERT_LE(std::abs(expected - output.ptr<uint8>(row)[i]), 1.f);
+    }
+  }
+}
+
+void BM_SetAlphaFromMask(benchmark::State& state) {
+  const cv::Mat input = MakePattern(1080, 1920, CV_8UC3, 1);
+  const cv::Mat mask = MakePattern(1080, 1920, CV_8UC1, 2);
+  cv::Mat output(1080, 1920, CV_8UC4);
+  for (auto _ : state) {
+    SetAlphaFromMask(input, mask, &output);
+  }
+}
+BENCHMARK(BM_SetAlphaFromMask);
+
+void BM_BlendWithMask(benchmark::State& state) {
+  const cv::Mat frame0 = MakePattern(1080, 1920, CV_8UC4, 1);
+  const cv::Mat frame1 = MakePattern(1080, 1920, CV_8UC4, 2);
+  const cv::Mat mask = MakePattern(1080, 1920, CV_8UC1, 3);
+  cv::Mat output(1080, 1920, CV_8UC4);
+  for (auto _ : state) {
+    BlendWithMask(frame0, frame1, mask, 0, &output);
+  }
+}
+BENCHMARK(BM_BlendWithMask);
+
+}  // namespace
+}  // namespace alpha_blend_util
+}  // namespace mediapipe
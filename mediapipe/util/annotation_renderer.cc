@@ -16,7 +16,9 @@
 
 #include <math.h>
 
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/vector.h"
@@ -56,6 +58,17 @@ bool NormalizedtoPixelCoordinates(double normalized_x, double normalized_y,
   return true;
 }
 
+// Returns the pixel position of (x, y), which is in [0, 1] if "normalized".
+cv::Point ToPixelPoint(double x, double y, bool normalized, int image_width,
+                       int image_height) {
+  cv::Point point(static_cast<int>(x), static_cast<int>(y));
+  if (normalized) {
+    CHECK(NormalizedtoPixelCoordinates(x, y, image_width, image_height,
+                                       &point.x, &point.y));
+  }
+  return point;
+}
+
 cv::Scalar MediapipeColorToOpenCVColor(const Color& color) {
   return cv::Scalar(color.r(), color.g(), color.b());
 }
@@ -82,7 +95,12 @@ void cv_line2(cv::Mat& img, const cv::Point& start, const cv::Point& end,
 }  // namespace
 
 void AnnotationRenderer::RenderDataOnImage(const RenderData& render_data) {
+  const cv::Rect image_rect(0, 0, image_width_, image_height_);
   for (const auto& annotation : render_data.render_annotations()) {
+    const cv::Rect bounds = AnnotationBounds(annotation) & image_rect;
+    if (bounds.area() > 0) {
+      drawn_regions_.push_back(bounds);
+    }
     if (annotation.data_case() == RenderAnnotation::kRectangle) {
       DrawRectangle(annotation);
     } else if (annotation.data_case() == RenderAnnotation::kRoundedRectangle) {
@@ -106,6 +124,12 @@ void AnnotationRenderer::RenderDataOnImage(const RenderData& render_data) {
       DrawGradientLine(annotation);
     } else if (annotation.data_case() == RenderAnnotation::kArrow) {
       DrawArrow(annotation);
+    } else if (annotation.data_case() == RenderAnnotation::kPoints) {
+      DrawPoints(annotation);
+    } else if (annotation.data_case() == RenderAnnotation::kLines) {
+      DrawLines(annotation);
+    } else if (annotation.data_case() == RenderAnnotation::kRectangles) {
+      DrawRectangles(annotation);
     } else {
       LOG(FATAL) << "Unknown annotation type: " << annotation.data_case();
     }
@@ -118,6 +142,7 @@ void AnnotationRenderer::AdoptImage(cv::Mat* input_image) {
 
   // No pixel data copy here, only headers are copied.
   mat_image_ = *input_image;
+  drawn_regions_.clear();
 }
 
 int AnnotationRenderer::GetImageWidth() const { return mat_image_.cols; }
@@ -481,6 +506,48 @@ void AnnotationRenderer::DrawGradientLine(const RenderAnnotation& annotation) {
   cv_line2(mat_image_, start, end, color1, color2, thickness);
 }
 
+void AnnotationRenderer::DrawPoints(const RenderAnnotation& annotation) {
+  const auto& points = annotation.points();
+  const cv::Scalar color = MediapipeColorToOpenCVColor(annotation.color());
+  const int thickness = annotation.thickness();
+  for (int i = 0; i + 1 < points.xy_size(); i += 2) {
+    cv::circle(mat_image_,
+               ToPixelPoint(points.xy(i), points.xy(i + 1),
+                            points.normalized(), image_width_, image_height_),
+               thickness, color, thickness);
+  }
+}
+
+void AnnotationRenderer::DrawLines(const RenderAnnotation& annotation) {
+  const auto& lines = annotation.lines();
+  const cv::Scalar color = MediapipeColorToOpenCVColor(annotation.color());
+  const int thickness = annotation.thickness();
+  for (int i = 0; i + 3 < lines.coordinates_size(); i += 4) {
+    cv::line(mat_image_,
+             ToPixelPoint(lines.coordinates(i), lines.coordinates(i + 1),
+                          lines.normalized(), image_width_, image_height_),
+             ToPixelPoint(lines.coordinates(i + 2), lines.coordinates(i + 3),
+                          lines.normalized(), image_width_, image_height_),
+             color, thickness);
+  }
+}
+
+void AnnotationRenderer::DrawRectangles(const RenderAnnotation& annotation) {
+  const auto& rectangles = annotation.rectangles();
+  const cv::Scalar color = MediapipeColorToOpenCVColor(annotation.color());
+  const int thickness = annotation.thickness();
+  for (int i = 0; i + 3 < rectangles.coordinates_size(); i += 4) {
+    cv::rectangle(
+        mat_image_,
+        ToPixelPoint(rectangles.coordinates(i), rectangles.coordinates(i + 1),
+                     rectangles.normalized(), image_width_, image_height_),
+        ToPixelPoint(rectangles.coordinates(i + 2),
+                     rectangles.coordinates(i + 3), rectangles.normalized(),
+                     image_width_, image_height_),
+        color, thickness);
+  }
+}
+
 void AnnotationRenderer::DrawText(const RenderAnnotation& annotation) {
   int left = -1;
   int baseline = -1;
@@ -503,9 +570,9 @@ void AnnotationRenderer::DrawText(const RenderAnnotation& annotation) {
   const int font_face = text.font_face();
 
   const double font_scale = ComputeFontScale(font_face, font_size, thickness);
-  cv::putText(mat_image_, text.display_text(), origin, font_face, font_scale,
-              color, thickness, /*lineType=*/8,
-              /*bottomLeftOrigin=*/flip_text_vertically_);
+  text_renderer_.PutText(&mat_image_, text.display_text(), origin, font_face,
+                         font_scale, color, thickness,
+                         /*bottom_left_origin=*/flip_text_vertically_);
 }
 
 double AnnotationRenderer::ComputeFontScale(int font_face, int font_size,
@@ -542,4 +609,136 @@ double AnnotationRenderer::ComputeFontScale(int font_face, int font_size,
          (cap_line + base_line);
 }
 
+cv::Rect AnnotationRenderer::AnnotationBounds(
+    const RenderAnnotation& annotation) {
+  // The points spanning the drawn shape, and how far its pixels extend from
+  // them.
+  std::vector<cv::Point> points;
+  const int thickness = std::max(static_cast<int>(annotation.thickness()), 1);
+  int margin = thickness + 1;
+  auto add_point = [this, &points](double x, double y, bool normalized) {
+    points.push_back(
+        ToPixelPoint(x, y, normalized, image_width_, image_height_));
+  };
+  auto add_points = [&add_point](
+                        const ::google::protobuf::RepeatedField<double>& xy,
+                        bool normalized) {
+    for (int i = 0; i + 1 < xy.size(); i += 2) {
+      add_point(xy.Get(i), xy.Get(i + 1), normalized);
+    }
+  };
+  auto add_rectangle = [&add_point, &points](const Rectangle& rectangle) {
+    add_point(rectangle.left(), rectangle.top(), rectangle.normalized());
+    add_point(rectangle.right(), rectangle.bottom(), rectangle.normalized());
+    if (rectangle.rotation() != 0.0) {
+      cv::Point2f vertices[4];
+      RectangleToOpenCVRotatedRect(points[points.size() - 2].x,
+                                   points[points.size() - 2].y,
+                                   points.back().x, points.back().y,
+                                   rectangle.rotation())
+          .points(vertices);
+      for (const auto& vertex : vertices) {
+        points.push_back(vertex);
+      }
+    }
+  };
+
+  switch (annotation.data_case()) {
+    case RenderAnnotation::kRectangle:
+      add_rectangle(annotation.rectangle());
+      break;
+    case RenderAnnotation::kFilledRectangle:
+      add_rectangle(annotation.filled_rectangle().rectangle());
+      break;
+    case RenderAnnotation::kRoundedRectangle:
+      add_rectangle(annotation.rounded_rectangle().rectangle());
+      break;
+    case RenderAnnotation::kFilledRoundedRectangle:
+      add_rectangle(annotation.filled_rounded_rectangle()
+                        .rounded_rectangle()
+                        .rectangle());
+      break;
+    case RenderAnnotation::kOval:
+      add_rectangle(annotation.oval().rectangle());
+      break;
+    case RenderAnnotation::kFilledOval:
+      add_rectangle(annotation.filled_oval().oval().rectangle());
+      break;
+    case RenderAnnotation::kPoint: {
+      const auto& point = annotation.point();
+      add_point(point.x(), point.y(), point.normalized());
+      // A circle of radius "thickness".
+      margin += thickness;
+      break;
+    }
+    case RenderAnnotation::kLine: {
+      const auto& line = annotation.line();
+      add_point(line.x_start(), line.y_start(), line.normalized());
+      add_point(line.x_end(), line.y_end(), line.normalized());
+      break;
+    }
+    case RenderAnnotation::kGradientLine: {
+      const auto& line = annotation.gradient_line();
+      add_point(line.x_start(), line.y_start(), line.normalized());
+      add_point(line.x_end(), line.y_end(), line.normalized());
+      break;
+    }
+    case RenderAnnotation::kArrow: {
+      const auto& arrow = annotation.arrow();
+      add_point(arrow.x_start(), arrow.y_start(), arrow.normalized());
+      add_point(arrow.x_end(), arrow.y_end(), arrow.normalized());
+      // The arrow tips are within 0.2 * sqrt(2) of the length from the end.
+      const cv::Point delta = points[1] - points[0];
+      margin += static_cast<int>(
+          std::ceil(0.3 * std::sqrt(delta.x * delta.x + delta.y * delta.y)));
+      break;
+    }
+    case RenderAnnotation::kPoints:
+      add_points(annotation.points().xy(), annotation.points().normalized());
+      // Circles of radius "thickness".
+      margin += thickness;
+      break;
+    case RenderAnnotation::kLines:
+      add_points(annotation.lines().coordinates(),
+                 annotation.lines().normalized());
+      break;
+    case RenderAnnotation::kRectangles:
+      add_points(annotation.rectangles().coordinates(),
+                 annotation.rectangles().normalized());
+      break;
+    case RenderAnnotation::kText: {
+      const auto& text = annotation.text();
+      add_point(text.left(), text.baseline(), text.normalized());
+      const int font_size =
+          text.normalized()
+              ? static_cast<int>(round(text.font_height() * image_height_))
+              : static_cast<int>(text.font_height());
+      const double font_scale =
+          ComputeFontScale(text.font_face(), font_size, thickness);
+      int baseline_offset = 0;
+      const cv::Size size =
+          cv::getTextSize(text.display_text(), text.font_face(), font_scale,
+                          thickness, &baseline_offset);
+      // Flipped text extends below the baseline instead of above it.
+      const cv::Point origin = points[0];
+      points.push_back(origin + cv::Point(size.width, -size.height));
+      points.push_back(origin + cv::Point(size.width, size.height));
+      margin += baseline_offset;
+      break;
+    }
+    default:
+      return cv::Rect();
+  }
+
+  if (points.empty()) {
+    return cv::Rect();
+  }
+  cv::Rect bounds = cv::boundingRect(points);
+  bounds.x -= margin;
+  bounds.y -= margin;
+  bounds.width += 2 * margin;
+  bounds.height += 2 * margin;
+  return bounds;
+}
+
 }  // namespace mediapipe
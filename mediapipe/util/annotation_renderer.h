@@ -16,9 +16,11 @@
 #define MEDIAPIPE_UTIL_ANNOTATION_RENDERER_H_
 
 #include <string>
+#include <vector>
 
 #include "mediapipe/framework/port/opencv_core_inc.h"
 #include "mediapipe/framework/port/opencv_imgproc_inc.h"
+#include "mediapipe/util/glyph_atlas_text_renderer.h"
 #include "mediapipe/util/render_data.pb.h"
 
 namespace mediapipe {
@@ -65,6 +67,12 @@ class AnnotationRenderer {
   int GetImageWidth() const;
   int GetImageHeight() const;
 
+  // Returns the regions of the image, clipped to it, that RenderDataOnImage()
+  // may have drawn onto since the last AdoptImage(). A caller drawing onto the
+  // same image for every frame can restore these regions only, instead of the
+  // whole image.
+  const std::vector<cv::Rect>& DrawnRegions() const { return drawn_regions_; }
+
   // Sets whether text should be rendered upside down. This is default to false
   // and text is rendered assuming the underlying image has its origin at the
   // top-left corner. Set it to true if the image origin is at the bottom-left
@@ -96,6 +104,16 @@ class AnnotationRenderer {
   // Draws a 2-tone line segment on the image as described in the annotation.
   void DrawGradientLine(const RenderAnnotation& annotation);
 
+  // Draws a batch of points on the image as described in the annotation.
+  void DrawPoints(const RenderAnnotation& annotation);
+
+  // Draws a batch of line segments on the image as described in the
+  // annotation.
+  void DrawLines(const RenderAnnotation& annotation);
+
+  // Draws a batch of rectangles on the image as described in the annotation.
+  void DrawRectangles(const RenderAnnotation& annotation);
+
   // Draws a text on the image as described in the annotation.
   void DrawText(const RenderAnnotation& annotation);
 
@@ -118,6 +136,9 @@ class AnnotationRenderer {
   // Computes the font scale from font_face, size and thickness.
   double ComputeFontScale(int font_face, int font_size, int thickness);
 
+  // Returns a rectangle containing every pixel drawn for the annotation.
+  cv::Rect AnnotationBounds(const RenderAnnotation& annotation);
+
   // Width and Height of the image (in pixels).
   int image_width_ = -1;
   int image_height_ = -1;
@@ -127,6 +148,13 @@ class AnnotationRenderer {
 
   // See SetFlipTextVertically(bool).
   bool flip_text_vertically_ = false;
+
+  // See DrawnRegions().
+  std::vector<cv::Rect> drawn_regions_;
+
+  // Draws text annotations from cached glyphs, which are reused across
+  // images.
+  GlyphAtlasTextRenderer text_renderer_;
 };
 }  // namespace mediapipe
 
@@ -0,0 +1,130 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "mediapipe/util/annotation_renderer.h"
+
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+
+namespace mediapipe {
+namespace {
+
+// Returns the number of non-black pixels of "image" outside "regions".
+int CountPixelsOutside(const cv::Mat& image,
+                       const std::vector<cv::Rect>& regions) {
+  cv::Mat outside = image.clone();
+  for (const cv::Rect& region : regions) {
+    outside(region).setTo(cv::Scalar(0, 0, 0));
+  }
+  cv::Mat gray;
+  cv::extractChannel(outside, gray, 0);
+  return cv::countNonZero(gray);
+}
+
+TEST(AnnotationRendererTest, DrawnRegionsContainDrawnPixels) {
+  cv::Mat image(100, 200, CV_8UC3, cv::Scalar(0, 0, 0));
+  AnnotationRenderer renderer;
+  renderer.AdoptImage(&image);
+  renderer.RenderDataOnImage(ParseTextProtoOrDie<RenderData>(R"(
+    render_annotations {
+      line { x_start: 0.1 y_start: 0.2 x_end: 0.4 y_end: 0.3 normalized: true }
+      thickness: 3
+      color { r: 255 }
+    }
+    render_annotations {
+      point { x: 150 y: 50 }
+      thickness: 4
+      color { r: 255 }
+    }
+    render_annotations {
+      arrow { x_start: 20 y_start: 80 x_end: 90 y_end: 60 }
+      color { r: 255 }
+    }
+    render_annotations {
+      text { display_text: "label" left: 100 baseline: 90 font_height: 10 }
+      color { r: 255 }
+    }
+  )"));
+
+  EXPECT_EQ(4, renderer.DrawnRegions().size());
+  EXPECT_EQ(0, CountPixelsOutside(image, renderer.DrawnRegions()));
+  int drawn_area = 0;
+  for (const cv::Rect& region : renderer.DrawnRegions()) {
+    drawn_area += region.area();
+  }
+  EXPECT_LT(drawn_area, image.rows * image.cols / 2);
+
+  renderer.AdoptImage(&image);
+  EXPECT_TRUE(renderer.DrawnRegions().empty());
+}
+
+TEST(AnnotationRendererTest, DrawsBatchedAnnotationsLikeSingleOnes) {
+  cv::Mat single(100, 200, CV_8UC3, cv::Scalar(0, 0, 0));
+  AnnotationRenderer renderer;
+  renderer.AdoptImage(&single);
+  renderer.RenderDataOnImage(ParseTextProtoOrDie<RenderData>(R"(
+    render_annotations {
+      point { x: 0.1 y: 0.2 normalized: true }
+      thickness: 2
+      color { r: 255 }
+    }
+    render_annotations {
+      point { x: 0.6 y: 0.7 normalized: true }
+      thickness: 2
+      color { r: 255 }
+    }
+    render_annotations {
+      line { x_start: 10 y_start: 20 x_end: 120 y_end: 70 }
+      color { g: 255 }
+    }
+    render_annotations {
+      line { x_start: 150 y_start: 10 x_end: 190 y_end: 90 }
+      color { g: 255 }
+    }
+    render_annotations {
+      rectangle { left: 30 top: 40 right: 60 bottom: 80 }
+      color { b: 255 }
+    }
+  )"));
+
+  cv::Mat batched(100, 200, CV_8UC3, cv::Scalar(0, 0, 0));
+  renderer.AdoptImage(&batched);
+  renderer.RenderDataOnImage(ParseTextProtoOrDie<RenderData>(R"(
+    render_annotations {
+      points {
+        xy: [ 0.1, 0.2, 0.6, 0.7 ]
+        normalized: true
+      }
+      thickness: 2
+      color { r: 255 }
+    }
+    render_annotations {
+      lines { coordinates: [ 10, 20, 120, 70, 150, 10, 190, 90 ] }
+      color { g: 255 }
+    }
+    render_annotations {
+      rectangles { coordinates: [ 30, 40, 60, 80 ] }
+      color { b: 255 }
+    }
+  )"));
+
+  cv::Mat difference;
+  cv::absdiff(single, batched, difference);
+  EXPECT_EQ(0, cv::countNonZero(difference.reshape(1)));
+  EXPECT_EQ(0, CountPixelsOutside(batched, renderer.DrawnRegions()));
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,353 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "mediapipe/util/annotation_tessellator.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/vector.h"
+#include "mediapipe/util/color.pb.h"
+
+namespace mediapipe {
+namespace {
+
+using Rectangle = RenderAnnotation::Rectangle;
+
+// The number of segments approximating a full ellipse.
+constexpr int kNumEllipseSegments = 48;
+// Same as in AnnotationRenderer::DrawArrow().
+constexpr double kArrowTipLengthProportion = 0.2;
+
+// Appends triangles with the current color to a vertex vector.
+class Tessellator {
+ public:
+  Tessellator(int image_width, int image_height,
+              std::vector<AnnotationVertex>* vertices)
+      : image_width_(image_width),
+        image_height_(image_height),
+        vertices_(vertices) {}
+
+  void SetColor(const Color& color) { color_ = color; }
+
+  // Returns the pixel position of (x, y), which is in [0, 1] if "normalized".
+  Vector2_d ToPixels(double x, double y, bool normalized) const {
+    if (normalized) {
+      return Vector2_d(x * image_width_, y * image_height_);
+    }
+    return Vector2_d(x, y);
+  }
+
+  // Returns the corners of "rectangle" in clockwise order, starting with the
+  // top-left one.
+  std::vector<Vector2_d> RectangleCorners(const Rectangle& rectangle) const {
+    const Vector2_d top_left =
+        ToPixels(rectangle.left(), rectangle.top(), rectangle.normalized());
+    const Vector2_d bottom_right = ToPixels(
+        rectangle.right(), rectangle.bottom(), rectangle.normalized());
+    const Vector2_d center = (top_left + bottom_right) * 0.5;
+    const Vector2_d half_size = (bottom_right - top_left) * 0.5;
+    const double cos_rotation = std::cos(rectangle.rotation());
+    const double sin_rotation = std::sin(rectangle.rotation());
+    std::vector<Vector2_d> corners;
+    for (const Vector2_d& offset :
+         {Vector2_d(-half_size[0], -half_size[1]),
+          Vector2_d(half_size[0], -half_size[1]),
+          Vector2_d(half_size[0], half_size[1]),
+          Vector2_d(-half_size[0], half_size[1])}) {
+      const Vector2_d rotated(
+          offset[0] * cos_rotation - offset[1] * sin_rotation,
+          offset[0] * sin_rotation + offset[1] * cos_rotation);
+      corners.push_back(center + rotated);
+    }
+    return corners;
+  }
+
+  // Appends the points of the arc of the ellipse centered on "center" with
+  // radii "radii", from angle "start" to angle "end" in radians.
+  static void AppendArc(const Vector2_d& center, const Vector2_d& radii,
+                        double start, double end,
+                        std::vector<Vector2_d>* points) {
+    const int num_segments = std::max(
+        1, static_cast<int>(std::ceil(kNumEllipseSegments *
+                                      std::abs(end - start) / (2 * M_PI))));
+    for (int i = 0; i <= num_segments; ++i) {
+      const double angle = start + (end - start) * i / num_segments;
+      points->push_back(center + Vector2_d(radii[0] * std::cos(angle),
+                                           radii[1] * std::sin(angle)));
+    }
+  }
+
+  // Returns the outline of the rectangle from "top_left" to "bottom_right"
+  // with corners rounded with "corner_radius".
+  static std::vector<Vector2_d> RoundedRectangleOutline(
+      const Vector2_d& top_left, const Vector2_d& bottom_right,
+      double corner_radius) {
+    const Vector2_d radii(corner_radius, corner_radius);
+    std::vector<Vector2_d> points;
+    AppendArc(Vector2_d(top_left[0] + corner_radius,
+                        top_left[1] + corner_radius),
+              radii, M_PI, 1.5 * M_PI, &points);
+    AppendArc(Vector2_d(bottom_right[0] - corner_radius,
+                        top_left[1] + corner_radius),
+              radii, 1.5 * M_PI, 2 * M_PI, &points);
+    AppendArc(Vector2_d(bottom_right[0] - corner_radius,
+                        bottom_right[1] - corner_radius),
+              radii, 0, 0.5 * M_PI, &points);
+    AppendArc(Vector2_d(top_left[0] + corner_radius,
+                        bottom_right[1] - corner_radius),
+              radii, 0.5 * M_PI, M_PI, &points);
+    return points;
+  }
+
+  void Triangle(const Vector2_d& a, const Vector2_d& b, const Vector2_d& c) {
+    Vertex(a, color_);
+    Vertex(b, color_);
+    Vertex(c, color_);
+  }
+
+  // Appends a line of "thickness" pixels, extended by half its thickness at
+  // both ends so that consecutive lines join without gaps, and with a color
+  // going from "start_color" to "end_color".
+  void GradientLine(const Vector2_d& start, const Vector2_d& end,
+                    double thickness, const Color& start_color,
+                    const Color& end_color) {
+    const double half_thickness = std::max(thickness, 1.0) / 2;
+    Vector2_d direction = (end - start).Normalize();
+    if (direction.Norm() == 0) {
+      direction = Vector2_d(1, 0);
+    }
+    const Vector2_d along = direction * half_thickness;
+    const Vector2_d across = direction.Ortho() * half_thickness;
+    const Vector2_d a = start - along + across;
+    const Vector2_d b = start - along - across;
+    const Vector2_d c = end + along + across;
+    const Vector2_d d = end + along - across;
+    Vertex(a, start_color);
+    Vertex(b, start_color);
+    Vertex(c, end_color);
+    Vertex(c, end_color);
+    Vertex(b, start_color);
+    Vertex(d, end_color);
+  }
+
+  void Line(const Vector2_d& start, const Vector2_d& end, double thickness) {
+    GradientLine(start, end, thickness, color_, color_);
+  }
+
+  void Polyline(const std::vector<Vector2_d>& points, bool closed,
+                double thickness) {
+    for (int i = 0; i + 1 < points.size(); ++i) {
+      Line(points[i], points[i + 1], thickness);
+    }
+    if (closed && points.size() > 2) {
+      Line(points.back(), points.front(), thickness);
+    }
+  }
+
+  // Appends the outline of a circle, like AnnotationRenderer draws points.
+  void Circle(const Vector2_d& center, double radius, double thickness) {
+    std::vector<Vector2_d> points;
+    AppendArc(center, Vector2_d(radius, radius), 0, 2 * M_PI, &points);
+    points.pop_back();
+    Polyline(points, /*closed=*/true, thickness);
+  }
+
+  // Fills the convex polygon with vertices "points".
+  void ConvexPolygon(const std::vector<Vector2_d>& points) {
+    for (int i = 1; i + 1 < points.size(); ++i) {
+      Triangle(points[0], points[i], points[i + 1]);
+    }
+  }
+
+ private:
+  void Vertex(const Vector2_d& position, const Color& color) {
+    vertices_->push_back({static_cast<float>(position[0]),
+                          static_cast<float>(position[1]), color.r() / 255.f,
+                          color.g() / 255.f, color.b() / 255.f});
+  }
+
+  const int image_width_;
+  const int image_height_;
+  std::vector<AnnotationVertex>* const vertices_;
+  Color color_;
+};
+
+// Returns the outline of the ellipse inscribed in "rectangle".
+std::vector<Vector2_d> OvalOutline(const Tessellator& tessellator,
+                                   const Rectangle& rectangle) {
+  const Vector2_d top_left = tessellator.ToPixels(
+      rectangle.left(), rectangle.top(), rectangle.normalized());
+  const Vector2_d bottom_right = tessellator.ToPixels(
+      rectangle.right(), rectangle.bottom(), rectangle.normalized());
+  std::vector<Vector2_d> points;
+  Tessellator::AppendArc((top_left + bottom_right) * 0.5,
+                         (bottom_right - top_left) * 0.5, 0, 2 * M_PI,
+                         &points);
+  points.pop_back();
+  return points;
+}
+
+// Returns the outline of the rounded rectangle "rectangle".
+std::vector<Vector2_d> RoundedRectangleOutline(
+    const Tessellator& tessellator,
+    const RenderAnnotation::RoundedRectangle& rectangle) {
+  const auto& bounds = rectangle.rectangle();
+  return Tessellator::RoundedRectangleOutline(
+      tessellator.ToPixels(bounds.left(), bounds.top(), bounds.normalized()),
+      tessellator.ToPixels(bounds.right(), bounds.bottom(),
+                           bounds.normalized()),
+      rectangle.corner_radius());
+}
+
+void TessellateAnnotation(const RenderAnnotation& annotation,
+                          Tessellator* tessellator) {
+  tessellator->SetColor(annotation.color());
+  const double thickness = annotation.thickness();
+  switch (annotation.data_case()) {
+    case RenderAnnotation::kRectangle:
+      tessellator->Polyline(
+          tessellator->RectangleCorners(annotation.rectangle()),
+          /*closed=*/true, thickness);
+      break;
+    case RenderAnnotation::kFilledRectangle:
+      tessellator->ConvexPolygon(tessellator->RectangleCorners(
+          annotation.filled_rectangle().rectangle()));
+      break;
+    case RenderAnnotation::kRoundedRectangle:
+      tessellator->Polyline(
+          RoundedRectangleOutline(*tessellator, annotation.rounded_rectangle()),
+          /*closed=*/true, thickness);
+      break;
+    case RenderAnnotation::kFilledRoundedRectangle:
+      tessellator->ConvexPolygon(RoundedRectangleOutline(
+          *tessellator,
+          annotation.filled_rounded_rectangle().rounded_rectangle()));
+      break;
+    case RenderAnnotation::kOval:
+      tessellator->Polyline(
+          OvalOutline(*tessellator, annotation.oval().rectangle()),
+          /*closed=*/true, thickness);
+      break;
+    case RenderAnnotation::kFilledOval:
+      tessellator->ConvexPolygon(OvalOutline(
+          *tessellator, annotation.filled_oval().oval().rectangle()));
+      break;
+    case RenderAnnotation::kPoint: {
+      const auto& point = annotation.point();
+      tessellator->Circle(
+          tessellator->ToPixels(point.x(), point.y(), point.normalized()),
+          /*radius=*/thickness, thickness);
+      break;
+    }
+    case RenderAnnotation::kPoints: {
+      const auto& points = annotation.points();
+      for (int i = 0; i + 1 < points.xy_size(); i += 2) {
+        tessellator->Circle(tessellator->ToPixels(points.xy(i),
+                                                  points.xy(i + 1),
+                                                  points.normalized()),
+                            /*radius=*/thickness, thickness);
+      }
+      break;
+    }
+    case RenderAnnotation::kLines: {
+      const auto& lines = annotation.lines();
+      for (int i = 0; i + 3 < lines.coordinates_size(); i += 4) {
+        tessellator->Line(
+            tessellator->ToPixels(lines.coordinates(i),
+                                  lines.coordinates(i + 1),
+                                  lines.normalized()),
+            tessellator->ToPixels(lines.coordinates(i + 2),
+                                  lines.coordinates(i + 3),
+                                  lines.normalized()),
+            thickness);
+      }
+      break;
+    }
+    case RenderAnnotation::kRectangles: {
+      const auto& rectangles = annotation.rectangles();
+      Rectangle rectangle;
+      rectangle.set_normalized(rectangles.normalized());
+      for (int i = 0; i + 3 < rectangles.coordinates_size(); i += 4) {
+        rectangle.set_left(rectangles.coordinates(i));
+        rectangle.set_top(rectangles.coordinates(i + 1));
+        rectangle.set_right(rectangles.coordinates(i + 2));
+        rectangle.set_bottom(rectangles.coordinates(i + 3));
+        tessellator->Polyline(tessellator->RectangleCorners(rectangle),
+                              /*closed=*/true, thickness);
+      }
+      break;
+    }
+    case RenderAnnotation::kLine: {
+      const auto& line = annotation.line();
+      tessellator->Line(
+          tessellator->ToPixels(line.x_start(), line.y_start(),
+                                line.normalized()),
+          tessellator->ToPixels(line.x_end(), line.y_end(), line.normalized()),
+          thickness);
+      break;
+    }
+    case RenderAnnotation::kGradientLine: {
+      const auto& line = annotation.gradient_line();
+      tessellator->GradientLine(
+          tessellator->ToPixels(line.x_start(), line.y_start(),
+                                line.normalized()),
+          tessellator->ToPixels(line.x_end(), line.y_end(), line.normalized()),
+          thickness, line.color1(), line.color2());
+      break;
+    }
+    case RenderAnnotation::kArrow: {
+      const auto& arrow = annotation.arrow();
+      const Vector2_d start = tessellator->ToPixels(
+          arrow.x_start(), arrow.y_start(), arrow.normalized());
+      const Vector2_d end = tessellator->ToPixels(arrow.x_end(), arrow.y_end(),
+                                                  arrow.normalized());
+      const Vector2_d direction = (end - start).Normalize();
+      const double tip_length =
+          kArrowTipLengthProportion * (end - start).Norm();
+      tessellator->Line(start, end, thickness);
+      tessellator->Line(
+          end - tip_length * direction + tip_length * direction.Ortho(), end,
+          thickness);
+      tessellator->Line(
+          end - tip_length * direction - tip_length * direction.Ortho(), end,
+          thickness);
+      break;
+    }
+    default:
+      LOG(FATAL) << "Unknown annotation type: " << annotation.data_case();
+  }
+}
+
+}  // namespace
+
+bool TessellateRenderData(const RenderData& render_data, int image_width,
+                          int image_height,
+                          std::vector<AnnotationVertex>* vertices) {
+  for (const auto& annotation : render_data.render_annotations()) {
+    if (annotation.data_case() == RenderAnnotation::kText) {
+      return false;
+    }
+  }
+  Tessellator tessellator(image_width, image_height, vertices);
+  for (const auto& annotation : render_data.render_annotations()) {
+    TessellateAnnotation(annotation, &tessellator);
+  }
+  return true;
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,47 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef MEDIAPIPE_UTIL_ANNOTATION_TESSELLATOR_H_
+#define MEDIAPIPE_UTIL_ANNOTATION_TESSELLATOR_H_
+
+#include <vector>
+
+#include "mediapipe/util/render_data.pb.h"
+
+namespace mediapipe {
+
+// A vertex of a tessellated annotation: a position in pixels, with the origin
+// at the top-left corner of the image as in AnnotationRenderer, and a color
+// with components in [0, 1].
+struct AnnotationVertex {
+  float x;
+  float y;
+  float r;
+  float g;
+  float b;
+};
+
+// Appends the triangles covering the annotations of "render_data", drawn on an
+// image of "image_width" x "image_height" pixels, to "vertices", three
+// vertices per triangle and in drawing order, so that they can be drawn
+// directly on the GPU instead of being rasterized by AnnotationRenderer.
+// Returns false and leaves "vertices" unchanged if "render_data" contains
+// text, which only AnnotationRenderer draws.
+bool TessellateRenderData(const RenderData& render_data, int image_width,
+                          int image_height,
+                          std::vector<AnnotationVertex>* vertices);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_ANNOTATION_TESSELLATOR_H_
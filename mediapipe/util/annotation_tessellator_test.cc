@@ -0,0 +1,109 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "mediapipe/util/annotation_tessellator.h"
+
+#include <vector>
+
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(AnnotationTessellatorTest, TessellatesLineAsQuad) {
+  RenderData render_data = ParseTextProtoOrDie<RenderData>(R"(
+    render_annotations {
+      line { x_start: 10 y_start: 20 x_end: 30 y_end: 20 }
+      thickness: 2
+      color { r: 255 g: 0 b: 0 }
+    }
+  )");
+  std::vector<AnnotationVertex> vertices;
+  ASSERT_TRUE(TessellateRenderData(render_data, 100, 50, &vertices));
+  ASSERT_EQ(6, vertices.size());
+  for (const auto& vertex : vertices) {
+    EXPECT_TRUE(vertex.x == 9 || vertex.x == 31) << vertex.x;
+    EXPECT_TRUE(vertex.y == 19 || vertex.y == 21) << vertex.y;
+    EXPECT_FLOAT_EQ(1.0, vertex.r);
+    EXPECT_FLOAT_EQ(0.0, vertex.g);
+  }
+}
+
+TEST(AnnotationTessellatorTest, TessellatesNormalizedFilledRectangle) {
+  RenderData render_data = ParseTextProtoOrDie<RenderData>(R"(
+    render_annotations {
+      filled_rectangle {
+        rectangle { left: 0.1 top: 0.2 right: 0.5 bottom: 0.6 normalized: true }
+      }
+      color { r: 0 g: 255 b: 0 }
+    }
+  )");
+  std::vector<AnnotationVertex> vertices;
+  ASSERT_TRUE(TessellateRenderData(render_data, 100, 50, &vertices));
+  ASSERT_EQ(6, vertices.size());
+  for (const auto& vertex : vertices) {
+    EXPECT_THAT(vertex.x, testing::AnyOf(testing::FloatNear(10, 1e-4),
+                                         testing::FloatNear(50, 1e-4)));
+    EXPECT_THAT(vertex.y, testing::AnyOf(testing::FloatNear(10, 1e-4),
+                                         testing::FloatNear(30, 1e-4)));
+    EXPECT_FLOAT_EQ(1.0, vertex.g);
+  }
+}
+
+TEST(AnnotationTessellatorTest, TessellatesBatchedLines) {
+  RenderData render_data = ParseTextProtoOrDie<RenderData>(R"(
+    render_annotations {
+      lines { coordinates: [ 10, 20, 30, 20, 0.1, 0.2, 0.3, 0.2 ] }
+      thickness: 2
+    }
+    render_annotations {
+      lines {
+        coordinates: [ 0.1, 0.4, 0.3, 0.4 ]
+        normalized: true
+      }
+      thickness: 2
+    }
+  )");
+  std::vector<AnnotationVertex> vertices;
+  ASSERT_TRUE(TessellateRenderData(render_data, 100, 50, &vertices));
+  ASSERT_EQ(18, vertices.size());
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_TRUE(vertices[i].x == 9 || vertices[i].x == 31) << vertices[i].x;
+  }
+  for (int i = 12; i < 18; ++i) {
+    EXPECT_THAT(vertices[i].x, testing::AnyOf(testing::FloatNear(9, 1e-4),
+                                              testing::FloatNear(31, 1e-4)));
+    EXPECT_THAT(vertices[i].y, testing::AnyOf(testing::FloatNear(19, 1e-4),
+                                              testing::FloatNear(21, 1e-4)));
+  }
+}
+
+TEST(AnnotationTessellatorTest, RejectsText) {
+  RenderData render_data = ParseTextProtoOrDie<RenderData>(R"(
+    render_annotations {
+      line { x_start: 10 y_start: 20 x_end: 30 y_end: 20 }
+    }
+    render_annotations {
+      text { display_text: "label" left: 10 baseline: 20 }
+    }
+  )");
+  std::vector<AnnotationVertex> vertices;
+  EXPECT_FALSE(TessellateRenderData(render_data, 100, 50, &vertices));
+  EXPECT_TRUE(vertices.empty());
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -552,10 +552,63 @@ mediapipe::Status AudioPacketProcessor::AddAudioDataToBuffer(
              << "sample_fmt = " << avcodec_ctx_->sample_fmt;
   }
 
+  const int64 chunk_samples = options_.output_chunk_samples();
+  if (chunk_samples > 0) {
+    // Samples that do not follow the pending ones start a new chunk.
+    if (num_pending_samples_ > 0 &&
+        pending_start_sample_ + num_pending_samples_ !=
+            expected_sample_number_) {
+      OutputPendingSamples(num_pending_samples_);
+    }
+    if (num_pending_samples_ == 0) {
+      pending_start_sample_ = expected_sample_number_;
+    }
+    if (num_pending_samples_ + num_samples > pending_samples_.cols()) {
+      pending_samples_.conservativeResize(
+          num_channels_,
+          std::max(chunk_samples, num_pending_samples_ + num_samples));
+    }
+    pending_samples_.middleCols(num_pending_samples_, num_samples) =
+        *current_frame;
+    num_pending_samples_ += num_samples;
+    while (num_pending_samples_ >= chunk_samples) {
+      OutputPendingSamples(chunk_samples);
+    }
+  } else {
+    AddFrameToBuffer(std::move(current_frame), output_timestamp);
+  }
+  expected_sample_number_ += num_samples;
+
+  return mediapipe::OkStatus();
+}
+
+void AudioPacketProcessor::OutputPendingSamples(int64 num_samples) {
+  auto chunk =
+      absl::make_unique<Matrix>(pending_samples_.leftCols(num_samples));
+  const Timestamp output_timestamp(
+      av_rescale_q(pending_start_sample_, sample_time_base_,
+                   output_time_base_));
+  num_pending_samples_ -= num_samples;
+  pending_samples_.leftCols(num_pending_samples_) =
+      pending_samples_.middleCols(num_samples, num_pending_samples_).eval();
+  pending_start_sample_ += num_samples;
+  AddFrameToBuffer(std::move(chunk), output_timestamp);
+}
+
+mediapipe::Status AudioPacketProcessor::Flush() {
+  MP_RETURN_IF_ERROR(BasePacketProcessor::Flush());
+  if (num_pending_samples_ > 0) {
+    OutputPendingSamples(num_pending_samples_);
+  }
+  return mediapipe::OkStatus();
+}
+
+void AudioPacketProcessor::AddFrameToBuffer(std::unique_ptr<Matrix> frame,
+                                            const Timestamp output_timestamp) {
   if (options_.output_regressing_timestamps() ||
       last_timestamp_ == Timestamp::Unset() ||
       output_timestamp > last_timestamp_) {
-    buffer_.push_back(Adopt(current_frame.release()).At(output_timestamp));
+    buffer_.push_back(Adopt(frame.release()).At(output_timestamp));
     last_timestamp_ = output_timestamp;
     if (last_frame_time_regression_detected_) {
       last_frame_time_regression_detected_ = false;
@@ -568,9 +621,6 @@ mediapipe::Status AudioPacketProcessor::AddAudioDataToBuffer(
                   "regressed.  Was "
                << last_timestamp_ << " but got " << output_timestamp;
   }
-  expected_sample_number_ += num_samples;
-
-  return mediapipe::OkStatus();
 }
 
 mediapipe::Status AudioPacketProcessor::FillHeader(
@@ -687,6 +737,19 @@ AudioDecoder::~AudioDecoder() {
   }
   is_first_packet_.resize(avformat_ctx_->nb_streams, true);
 
+  if (options.has_start_time() && options.seek_to_start_time()) {
+    // Nothing has been decoded yet, so the codecs need no flushing. Output
+    // timestamps are in microseconds like AV_TIME_BASE, and use the same
+    // origin as the seek target.
+    const int ret = av_seek_frame(avformat_ctx_, /*stream_index=*/-1,
+                                  start_time_.Value(), AVSEEK_FLAG_BACKWARD);
+    if (ret < 0) {
+      LOG(WARNING) << "Failed to seek to " << start_time_ << " in \""
+                   << input_file << "\", decoding from the start: "
+                   << AvErrorToString(ret);
+    }
+  }
+
   decoder_closer.release();
   return ::mediapipe::OkStatus();
 }
@@ -731,7 +794,16 @@ AudioDecoder::~AudioDecoder() {
         return status;
       }
     }
-    if (flushed_) {
+    // Stop once every stream is past end_time, without demuxing the rest of
+    // the file.
+    bool all_processors_closed = true;
+    for (const auto& item : audio_processor_) {
+      if (item.second) {
+        all_processors_closed = false;
+        break;
+      }
+    }
+    if (flushed_ || all_processors_closed) {
       MP_RETURN_IF_ERROR(Close());
       return tool::StatusStop();
     }
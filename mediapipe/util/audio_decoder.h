@@ -21,6 +21,7 @@
 #include <vector>
 
 #include "absl/time/time.h"
+#include "mediapipe/framework/formats/matrix.h"
 #include "mediapipe/framework/formats/time_series_header.pb.h"
 #include "mediapipe/framework/packet.h"
 #include "mediapipe/framework/port/commandlineflags.h"
@@ -65,7 +66,7 @@ class BasePacketProcessor {
 
   // Once no more AVPackets are available in the file, each stream must
   // be flushed to get any remaining frames which the codec is buffering.
-  mediapipe::Status Flush();
+  virtual mediapipe::Status Flush();
 
   // Closes the Processor, this does not close the file.  You may not
   // call ProcessPacket() after calling Close().  Close() may be called
@@ -136,9 +137,19 @@ class AudioPacketProcessor : public BasePacketProcessor {
 
   mediapipe::Status ProcessPacket(AVPacket* packet) override;
 
+  // Also outputs the last partial chunk if output_chunk_samples is set.
+  mediapipe::Status Flush() override;
+
   mediapipe::Status FillHeader(TimeSeriesHeader* header) const;
 
  private:
+  // Adds a packet of audio to buffer_, unless its timestamp regresses.
+  void AddFrameToBuffer(std::unique_ptr<Matrix> frame,
+                        const Timestamp output_timestamp);
+
+  // Moves the first num_samples of pending_samples_ into a packet in buffer_.
+  void OutputPendingSamples(int64 num_samples);
+
   // Appends audio in buffer(s) to the output buffer (buffer_).
   mediapipe::Status AddAudioDataToBuffer(const Timestamp output_timestamp,
                                          uint8* const* raw_audio,
@@ -184,6 +195,13 @@ class AudioPacketProcessor : public BasePacketProcessor {
 
   // Options for the processor.
   AudioStreamOptions options_;
+
+  // With output_chunk_samples, the decoded samples not yet output. Only the
+  // first num_pending_samples_ columns are valid, starting at sample number
+  // pending_start_sample_.
+  Matrix pending_samples_;
+  int64 num_pending_samples_ = 0;
+  int64 pending_start_sample_ = 0;
 };
 
 // Decode the audio streams of a media file.  The AudioDecoder is responsible
@@ -0,0 +1,168 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/calculator_benchmark.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/tool/tag_map.h"
+#include "mediapipe/util/packet_log.h"
+
+namespace {
+
+std::atomic<int64> allocation_count(0);
+std::atomic<int64> allocated_bytes(0);
+
+void* CountedAllocate(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+  return malloc(size == 0 ? 1 : size);
+}
+
+void* CountedAllocateOrThrow(size_t size) {
+  void* ptr = CountedAllocate(size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+}  // namespace
+
+// Replaces the global allocation functions to count allocations. The aligned
+// variants are left alone, and so are not counted.
+void* operator new(size_t size) { return CountedAllocateOrThrow(size); }
+void* operator new[](size_t size) { return CountedAllocateOrThrow(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return CountedAllocate(size);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return CountedAllocate(size);
+}
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+  free(ptr);
+}
+
+namespace mediapipe {
+
+CalculatorBenchmark::CalculatorBenchmark(
+    const CalculatorGraphConfig::Node& node_config)
+    : runner_(node_config) {}
+
+CalculatorBenchmark::CalculatorBenchmark(const std::string& node_config_string)
+    : runner_(node_config_string) {}
+
+void CalculatorBenchmark::GenerateInputs(
+    const std::string& tag, int index, int num_packets, int64 period_usec,
+    const std::function<Packet(int)>& generator) {
+  std::vector<Packet>& packets =
+      runner_.MutableInputs()->Get(tag, index).packets;
+  int64 timestamp =
+      packets.empty() ? 0 : packets.back().Timestamp().Value() + period_usec;
+  for (int i = 0; i < num_packets; ++i) {
+    packets.push_back(generator(i).At(Timestamp(timestamp)));
+    timestamp += period_usec;
+  }
+}
+
+::mediapipe::Status CalculatorBenchmark::AddRecordedInputs(
+    const std::string& path) {
+  ASSIGN_OR_RETURN(std::unique_ptr<PacketLogReader> reader,
+                   PacketLogReader::Open(path));
+  // Maps the logged stream indices to the calculator's input streams.
+  CalculatorRunner::StreamContentsSet* inputs = runner_.MutableInputs();
+  const std::vector<std::string>& input_names = inputs->TagMap()->Names();
+  std::vector<CalculatorRunner::StreamContents*> streams;
+  for (const std::string& logged_name : reader->stream_names()) {
+    CalculatorRunner::StreamContents* stream = nullptr;
+    for (CollectionItemId id = inputs->BeginId(); id < inputs->EndId(); ++id) {
+      if (input_names[id.value()] == logged_name) {
+        stream = &inputs->Get(id);
+      }
+    }
+    streams.push_back(stream);
+  }
+
+  int stream_index;
+  absl::Time arrival_time;
+  Packet packet;
+  while (true) {
+    ASSIGN_OR_RETURN(bool has_packet,
+                     reader->Next(&stream_index, &arrival_time, &packet));
+    if (!has_packet) break;
+    RET_CHECK_LT(stream_index, streams.size());
+    if (streams[stream_index] != nullptr) {
+      streams[stream_index]->packets.push_back(packet);
+    }
+  }
+  return ::mediapipe::OkStatus();
+}
+
+void CalculatorBenchmark::Run(benchmark::State& state) {
+  const int num_packets = NumInputPackets();
+  int64 elapsed_nanos = 0;
+  const int64 start_allocation_count = AllocationCount();
+  const int64 start_allocated_bytes = AllocatedBytes();
+  for (auto _ : state) {
+    const absl::Time start = absl::Now();
+    const ::mediapipe::Status status = runner_.Run();
+    elapsed_nanos += absl::ToInt64Nanoseconds(absl::Now() - start);
+    if (!status.ok()) {
+      state.SkipWithError(status.ToString().c_str());
+      return;
+    }
+  }
+  const double num_processed =
+      static_cast<double>(state.iterations()) * std::max(num_packets, 1);
+  state.SetItemsProcessed(state.iterations() * num_packets);
+  state.counters["ns/packet"] = elapsed_nanos / num_processed;
+  state.counters["allocs/packet"] =
+      (AllocationCount() - start_allocation_count) / num_processed;
+  state.counters["alloc_bytes/packet"] =
+      (AllocatedBytes() - start_allocated_bytes) / num_processed;
+}
+
+int64 CalculatorBenchmark::AllocationCount() {
+  return allocation_count.load(std::memory_order_relaxed);
+}
+
+int64 CalculatorBenchmark::AllocatedBytes() {
+  return allocated_bytes.load(std::memory_order_relaxed);
+}
+
+int CalculatorBenchmark::NumInputPackets() {
+  const CalculatorRunner::StreamContentsSet* inputs = runner_.MutableInputs();
+  int num_packets = 0;
+  for (CollectionItemId id = inputs->BeginId(); id < inputs->EndId(); ++id) {
+    num_packets += inputs->Get(id).packets.size();
+  }
+  return num_packets;
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,97 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_UTIL_CALCULATOR_BENCHMARK_H_
+#define MEDIAPIPE_UTIL_CALCULATOR_BENCHMARK_H_
+
+#include <functional>
+#include <string>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/status.h"
+
+namespace mediapipe {
+
+// Times a single registered calculator with a CalculatorRunner, on inputs
+// that are either generated or read from a packet log. Each benchmark
+// iteration runs the calculator over all the inputs, and reports, per input
+// packet:
+//   ns/packet: the wall time.
+//   allocs/packet: the number of heap allocations.
+//   alloc_bytes/packet: the number of bytes allocated on the heap. Copies and
+//     conversions of packet payloads show up here, since every one of them
+//     writes into a fresh buffer.
+// The allocation counts cover every thread in the process, and include the
+// per run cost of starting and stopping the graph, so use enough input
+// packets to amortize it.
+//
+// Example:
+//   void BM_Resize(benchmark::State& state) {
+//     CalculatorBenchmark benchmark(R"(
+//       calculator: "ImageTransformationCalculator"
+//       input_stream: "IMAGE:input"
+//       output_stream: "IMAGE:output"
+//       options { ... })");
+//     benchmark.GenerateInputs("IMAGE", 0, 100, 33333, [](int i) {
+//       return MakePacket<ImageFrame>(ImageFormat::SRGB, 1280, 720);
+//     });
+//     benchmark.Run(state);
+//   }
+//   BENCHMARK(BM_Resize);
+class CalculatorBenchmark {
+ public:
+  explicit CalculatorBenchmark(const CalculatorGraphConfig::Node& node_config);
+  explicit CalculatorBenchmark(const std::string& node_config_string);
+
+  CalculatorBenchmark(const CalculatorBenchmark&) = delete;
+  CalculatorBenchmark& operator=(const CalculatorBenchmark&) = delete;
+
+  // The underlying runner, for setting input stream headers and side packets.
+  CalculatorRunner* runner() { return &runner_; }
+
+  // Appends "num_packets" packets returned by "generator" for the indices
+  // 0 to num_packets - 1 to the input stream "tag":"index", at timestamps
+  // spaced by "period_usec" after the last packet of the stream.
+  void GenerateInputs(const std::string& tag, int index, int num_packets,
+                      int64 period_usec,
+                      const std::function<Packet(int)>& generator);
+
+  // Appends the packets of the packet log "path" to the input streams with
+  // the same names, at their logged timestamps. Logged streams the
+  // calculator has no input for are ignored.
+  ::mediapipe::Status AddRecordedInputs(const std::string& path);
+
+  // Runs the calculator once per iteration of "state" and sets the counters
+  // above. Marks the benchmark as failed if a run fails.
+  void Run(benchmark::State& state);
+
+  // The number of heap allocations and allocated bytes made in the process
+  // so far. Only counted in binaries that link this library.
+  static int64 AllocationCount();
+  static int64 AllocatedBytes();
+
+ private:
+  // Returns the total number of input packets.
+  int NumInputPackets();
+
+  CalculatorRunner runner_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_CALCULATOR_BENCHMARK_H_
@@ -22,10 +22,13 @@
 #include <unistd.h>
 #endif
 #include <fstream>
+#include <string>
+#include <vector>
 
 #include "absl/algorithm/container.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
 #include "absl/strings/substitute.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/integral_types.h"
@@ -65,6 +68,30 @@ constexpr uint32 kBufferLength = 64;
   }
 }
 
+// Parses a sysfs CPU list such as "0-7,16-23".
+std::set<int> ParseCpuList(const std::string& cpu_list) {
+  std::set<int> cpus;
+  for (absl::string_view range :
+       absl::StrSplit(cpu_list, ',', absl::SkipWhitespace())) {
+    std::vector<absl::string_view> bounds = absl::StrSplit(range, '-');
+    int first;
+    if (!absl::SimpleAtoi(bounds[0], &first)) {
+      return {};
+    }
+    int last = first;
+    if (bounds.size() == 2 && !absl::SimpleAtoi(bounds[1], &last)) {
+      return {};
+    }
+    if (bounds.size() > 2 || first < 0 || last < first) {
+      return {};
+    }
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.insert(cpu);
+    }
+  }
+  return cpus;
+}
+
 std::set<int> InferLowerOrHigherCoreIds(bool lower) {
   std::vector<std::pair<int, uint64>> cpu_freq_pairs;
   for (int cpu = 0; cpu < NumCPUCores(); ++cpu) {
@@ -119,4 +146,17 @@ std::set<int> InferHigherCoreIds() {
   return InferLowerOrHigherCoreIds(/* lower= */ false);
 }
 
+std::set<int> GetNumaNodeCoreIds(int numa_node) {
+  if (numa_node < 0) {
+    return {};
+  }
+  std::ifstream file(absl::Substitute(
+      "/sys/devices/system/node/node$0/cpulist", numa_node));
+  std::string cpu_list;
+  if (!file.is_open() || !std::getline(file, cpu_list)) {
+    return {};
+  }
+  return ParseCpuList(cpu_list);
+}
+
 }  // namespace mediapipe.
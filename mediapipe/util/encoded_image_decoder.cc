@@ -0,0 +1,202 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "mediapipe/util/encoded_image_decoder.h"
+
+#include <algorithm>
+#include <csetjmp>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/port/opencv_imgcodecs_inc.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_builder.h"
+
+extern "C" {
+#include "jerror.h"
+#include "jpeglib.h"
+}
+
+namespace mediapipe {
+
+namespace {
+
+// libjpeg reports errors through error_exit, which must not return.
+struct JpegErrorManager {
+  jpeg_error_mgr pub;
+  jmp_buf setjmp_buffer;
+  char message[JMSG_LENGTH_MAX];
+};
+
+void JpegErrorExit(j_common_ptr cinfo) {
+  auto* error_manager = reinterpret_cast<JpegErrorManager*>(cinfo->err);
+  (*cinfo->err->format_message)(cinfo, error_manager->message);
+  longjmp(error_manager->setjmp_buffer, 1);
+}
+
+bool IsJpeg(const std::string& contents) {
+  return contents.size() >= 3 && static_cast<uint8_t>(contents[0]) == 0xFF &&
+         static_cast<uint8_t>(contents[1]) == 0xD8 &&
+         static_cast<uint8_t>(contents[2]) == 0xFF;
+}
+
+int ScaledSize(int size, int scale_denom) {
+  return (size + scale_denom - 1) / scale_denom;
+}
+
+}  // namespace
+
+::mediapipe::Status EncodedImageDecoder::Open(const std::string& contents) {
+  contents_ = &contents;
+  is_jpeg_ = IsJpeg(contents);
+  decoded_.release();
+  if (!is_jpeg_) {
+    const cv::Mat contents_mat(1, contents.size(), CV_8UC1,
+                               const_cast<char*>(contents.data()));
+    cv::Mat decoded = cv::imdecode(contents_mat, cv::IMREAD_UNCHANGED);
+    RET_CHECK(!decoded.empty()) << "Failed to decode the image.";
+    switch (decoded.channels()) {
+      case 1:
+        decoded_ = decoded;
+        break;
+      case 3:
+        cv::cvtColor(decoded, decoded_, cv::COLOR_BGR2RGB);
+        break;
+      default:
+        return ::mediapipe::UnimplementedErrorBuilder(MEDIAPIPE_LOC)
+               << "Unsupported number of channels: " << decoded.channels();
+    }
+    grayscale_ = decoded_.channels() == 1;
+    width_ = decoded_.cols;
+    height_ = decoded_.rows;
+    return ::mediapipe::OkStatus();
+  }
+
+  jpeg_decompress_struct cinfo;
+  JpegErrorManager jerr;
+  cinfo.err = jpeg_std_error(&jerr.pub);
+  jerr.pub.error_exit = JpegErrorExit;
+  if (setjmp(jerr.setjmp_buffer)) {
+    jpeg_destroy_decompress(&cinfo);
+    return ::mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+           << "Failed to read the JPEG header: " << jerr.message;
+  }
+  jpeg_create_decompress(&cinfo);
+  jpeg_mem_src(&cinfo, reinterpret_cast<const unsigned char*>(contents.data()),
+               contents.size());
+  jpeg_read_header(&cinfo, TRUE);
+  width_ = cinfo.image_width;
+  height_ = cinfo.image_height;
+  grayscale_ = cinfo.num_components == 1;
+  const bool supported = cinfo.num_components == 1 || cinfo.num_components == 3;
+  jpeg_destroy_decompress(&cinfo);
+  if (!supported) {
+    return ::mediapipe::UnimplementedErrorBuilder(MEDIAPIPE_LOC)
+           << "Unsupported number of JPEG components.";
+  }
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status EncodedImageDecoder::DecodeRegion(const cv::Rect& region,
+                                                      int scale_denom,
+                                                      ImageFrame* image_frame) {
+  RET_CHECK(contents_) << "Open() must be called first.";
+  RET_CHECK(scale_denom == 1 || scale_denom == 2 || scale_denom == 4 ||
+            scale_denom == 8);
+  RET_CHECK(!region.empty() &&
+            (region & cv::Rect(0, 0, width_, height_)) == region)
+      << "Region is outside the image.";
+  if (is_jpeg_) {
+    return DecodeJpegRegion(region, scale_denom, image_frame);
+  }
+
+  const cv::Size output_size(ScaledSize(region.width, scale_denom),
+                             ScaledSize(region.height, scale_denom));
+  image_frame->Reset(grayscale_ ? ImageFormat::GRAY8 : ImageFormat::SRGB,
+                     output_size.width, output_size.height,
+                     ImageFrame::kDefaultAlignmentBoundary);
+  cv::Mat output_mat = formats::MatView(image_frame);
+  if (scale_denom == 1) {
+    decoded_(region).copyTo(output_mat);
+  } else {
+    cv::resize(decoded_(region), output_mat, output_size, 0, 0,
+               cv::INTER_AREA);
+  }
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status EncodedImageDecoder::DecodeJpegRegion(
+    const cv::Rect& region, int scale_denom, ImageFrame* image_frame) {
+  // Region in the scaled image.
+  const int left = region.x / scale_denom;
+  const int top = region.y / scale_denom;
+  const int right = ScaledSize(region.x + region.width, scale_denom);
+  const int bottom = ScaledSize(region.y + region.height, scale_denom);
+  const int num_channels = grayscale_ ? 1 : 3;
+  image_frame->Reset(grayscale_ ? ImageFormat::GRAY8 : ImageFormat::SRGB,
+                     right - left, bottom - top,
+                     ImageFrame::kDefaultAlignmentBoundary);
+
+  jpeg_decompress_struct cinfo;
+  JpegErrorManager jerr;
+  cinfo.err = jpeg_std_error(&jerr.pub);
+  jerr.pub.error_exit = JpegErrorExit;
+  // Declared before setjmp() so it is destroyed on the error path too.
+  std::vector<JSAMPLE> row;
+  if (setjmp(jerr.setjmp_buffer)) {
+    jpeg_destroy_decompress(&cinfo);
+    return ::mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+           << "Failed to decode the JPEG image: " << jerr.message;
+  }
+  jpeg_create_decompress(&cinfo);
+  jpeg_mem_src(&cinfo,
+               reinterpret_cast<const unsigned char*>(contents_->data()),
+               contents_->size());
+  jpeg_read_header(&cinfo, TRUE);
+  cinfo.scale_num = 1;
+  cinfo.scale_denom = scale_denom;
+  cinfo.out_color_space = grayscale_ ? JCS_GRAYSCALE : JCS_RGB;
+  jpeg_start_decompress(&cinfo);
+
+  // libjpeg-turbo widens the column range to iMCU boundaries, so keep track
+  // of where the requested columns start within each decoded row.
+  JDIMENSION crop_x = left;
+  JDIMENSION crop_width = right - left;
+  jpeg_crop_scanline(&cinfo, &crop_x, &crop_width);
+  const int column_offset = (left - crop_x) * num_channels;
+  row.resize(cinfo.output_width * num_channels);
+
+  // Rows above the region are entropy decoded but skip the IDCT.
+  if (top > 0) {
+    jpeg_skip_scanlines(&cinfo, top);
+  }
+  const int row_bytes = (right - left) * num_channels;
+  for (int y = 0; y < bottom - top; ++y) {
+    JSAMPROW row_pointer = row.data();
+    jpeg_read_scanlines(&cinfo, &row_pointer, 1);
+    std::copy(row.begin() + column_offset,
+              row.begin() + column_offset + row_bytes,
+              image_frame->MutablePixelData() + y * image_frame->WidthStep());
+  }
+  // The rest of the image is never decoded.
+  jpeg_abort_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+  return ::mediapipe::OkStatus();
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,78 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//
+// Decodes regions of encoded images without decoding the rest of the image.
+
+#ifndef MEDIAPIPE_UTIL_ENCODED_IMAGE_DECODER_H_
+#define MEDIAPIPE_UTIL_ENCODED_IMAGE_DECODER_H_
+
+#include <string>
+
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/status.h"
+
+namespace mediapipe {
+
+// Decodes an encoded image lazily, so that a calculator receiving the encoded
+// bytes can decode only the part it needs once it knows its region of
+// interest.
+//
+// JPEG images are decoded with libjpeg-turbo: only the rows of the region are
+// run through the IDCT, columns outside the region are skipped at iMCU
+// granularity, and the region can be downscaled by 2, 4 or 8 in the DCT
+// domain. Other formats are fully decoded by OpenCV in Open() and the region
+// is copied out.
+//
+// Example:
+//   EncodedImageDecoder decoder;
+//   MP_RETURN_IF_ERROR(decoder.Open(contents));
+//   ImageFrame crop;
+//   MP_RETURN_IF_ERROR(decoder.DecodeRegion(
+//       cv::Rect(0, 0, decoder.width() / 2, decoder.height()), 1, &crop));
+class EncodedImageDecoder {
+ public:
+  EncodedImageDecoder() = default;
+
+  // Reads the image header. "contents" must outlive the decoder.
+  ::mediapipe::Status Open(const std::string& contents);
+
+  // Full resolution dimensions of the image, valid after Open().
+  int width() const { return width_; }
+  int height() const { return height_; }
+
+  // Decodes "region" (in full resolution pixels, and within the image) into
+  // "image_frame", scaled down by "scale_denom" which must be 1, 2, 4 or 8.
+  // The output is SRGB, or GRAY8 for grayscale images, and has the size of
+  // the region divided by scale_denom, rounded up.
+  ::mediapipe::Status DecodeRegion(const cv::Rect& region, int scale_denom,
+                                   ImageFrame* image_frame);
+
+ private:
+  ::mediapipe::Status DecodeJpegRegion(const cv::Rect& region, int scale_denom,
+                                       ImageFrame* image_frame);
+
+  const std::string* contents_ = nullptr;
+  bool is_jpeg_ = false;
+  int width_ = 0;
+  int height_ = 0;
+  bool grayscale_ = false;
+  // Fully decoded image, for formats other than JPEG.
+  cv::Mat decoded_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_ENCODED_IMAGE_DECODER_H_
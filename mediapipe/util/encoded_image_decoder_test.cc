@@ -0,0 +1,110 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "mediapipe/util/encoded_image_decoder.h"
+
+#include <string>
+
+#include "mediapipe/framework/deps/file_path.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/opencv_imgcodecs_inc.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr char kTestImage[] = "/mediapipe/calculators/image/testdata/dino.jpg";
+
+double MaxAbsDiff(const cv::Mat& a, const cv::Mat& b) {
+  cv::Mat diff;
+  cv::absdiff(a, b, diff);
+  double max_val;
+  cv::minMaxLoc(diff.reshape(1), nullptr, &max_val);
+  return max_val;
+}
+
+class EncodedImageDecoderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    MP_ASSERT_OK(
+        file::GetContents(file::JoinPath("./", kTestImage), &contents_));
+    cv::cvtColor(cv::imread(file::JoinPath("./", kTestImage)), full_image_,
+                 cv::COLOR_BGR2RGB);
+  }
+
+  std::string contents_;
+  cv::Mat full_image_;
+};
+
+TEST_F(EncodedImageDecoderTest, JpegRegionMatchesFullDecode) {
+  EncodedImageDecoder decoder;
+  MP_ASSERT_OK(decoder.Open(contents_));
+  EXPECT_EQ(full_image_.cols, decoder.width());
+  EXPECT_EQ(full_image_.rows, decoder.height());
+
+  // Deliberately not aligned to 8x8 or 16x16 blocks.
+  const cv::Rect region(decoder.width() / 3 + 3, decoder.height() / 4 + 5,
+                        decoder.width() / 3, decoder.height() / 2);
+  ImageFrame frame;
+  MP_ASSERT_OK(decoder.DecodeRegion(region, 1, &frame));
+  ASSERT_EQ(ImageFormat::SRGB, frame.Format());
+  ASSERT_EQ(region.width, frame.Width());
+  ASSERT_EQ(region.height, frame.Height());
+  // Chroma upsampling at the region border may differ slightly.
+  EXPECT_LE(MaxAbsDiff(full_image_(region), formats::MatView(&frame)), 8);
+}
+
+TEST_F(EncodedImageDecoderTest, JpegScaledRegion) {
+  EncodedImageDecoder decoder;
+  MP_ASSERT_OK(decoder.Open(contents_));
+  const cv::Rect region(0, 0, decoder.width(), decoder.height());
+  ImageFrame frame;
+  MP_ASSERT_OK(decoder.DecodeRegion(region, 4, &frame));
+  EXPECT_EQ((decoder.width() + 3) / 4, frame.Width());
+  EXPECT_EQ((decoder.height() + 3) / 4, frame.Height());
+}
+
+TEST_F(EncodedImageDecoderTest, PngRegion) {
+  std::vector<uchar> png;
+  cv::Mat bgr;
+  cv::cvtColor(full_image_, bgr, cv::COLOR_RGB2BGR);
+  cv::imencode(".png", bgr, png);
+  const std::string contents(png.begin(), png.end());
+
+  EncodedImageDecoder decoder;
+  MP_ASSERT_OK(decoder.Open(contents));
+  const cv::Rect region(10, 20, 30, 40);
+  ImageFrame frame;
+  MP_ASSERT_OK(decoder.DecodeRegion(region, 1, &frame));
+  EXPECT_EQ(0, MaxAbsDiff(full_image_(region), formats::MatView(&frame)));
+}
+
+TEST_F(EncodedImageDecoderTest, RejectsRegionOutsideImage) {
+  EncodedImageDecoder decoder;
+  MP_ASSERT_OK(decoder.Open(contents_));
+  ImageFrame frame;
+  EXPECT_FALSE(decoder
+                   .DecodeRegion(cv::Rect(decoder.width() - 1, 0, 2, 2), 1,
+                                 &frame)
+                   .ok());
+}
+
+}  // namespace
+}  // namespace mediapipe
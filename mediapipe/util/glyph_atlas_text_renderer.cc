@@ -0,0 +1,168 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/glyph_atlas_text_renderer.h"
+
+#include <vector>
+
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+
+namespace mediapipe {
+
+namespace {
+
+// The fixed point precision of cv::putText's pen position.
+constexpr int kFixedPointShift = 16;
+
+// The number of copies of a glyph measured to find its advance exactly.
+constexpr int kAdvanceSamples = 64;
+
+// Hershey glyph strokes lie within this many font units of the origin.
+constexpr int kMaxGlyphExtent = 32;
+
+// cv::putText's line type, which draws strokes without anti-aliasing.
+constexpr int kLineType = 8;
+
+int FixedPointScale(double font_scale) {
+  return cvRound(font_scale * (1 << kFixedPointShift));
+}
+
+bool IsAscii(const std::string& text) {
+  for (char c : text) {
+    if (static_cast<unsigned char>(c) >= 128) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+GlyphAtlasTextRenderer::GlyphAtlasTextRenderer(int max_interned_strings)
+    : max_interned_strings_(max_interned_strings) {}
+
+void GlyphAtlasTextRenderer::PutText(cv::Mat* image, const std::string& text,
+                                     cv::Point origin, int font_face,
+                                     double font_scale, const cv::Scalar& color,
+                                     int thickness, bool bottom_left_origin) {
+  if (text.empty()) {
+    return;
+  }
+  if (thickness <= 0 || font_scale <= 0 || !IsAscii(text)) {
+    cv::putText(*image, text, origin, font_face, font_scale, color, thickness,
+                kLineType, bottom_left_origin);
+    return;
+  }
+  const Mask& text_mask =
+      GetString(text, font_face, font_scale, thickness, bottom_left_origin);
+  if (text_mask.mask.empty()) {
+    return;
+  }
+  const cv::Rect target(origin + text_mask.offset, text_mask.mask.size());
+  const cv::Rect visible = target & cv::Rect(0, 0, image->cols, image->rows);
+  if (visible.area() == 0) {
+    return;
+  }
+  (*image)(visible).setTo(color, text_mask.mask(visible - target.tl()));
+}
+
+const GlyphAtlasTextRenderer::Glyph& GlyphAtlasTextRenderer::GetGlyph(
+    char c, int font_face, double font_scale, int thickness) {
+  const auto key = std::make_pair(
+      Style(font_face, FixedPointScale(font_scale), thickness), c);
+  auto it = glyphs_.find(key);
+  if (it != glyphs_.end()) {
+    return it->second;
+  }
+  Glyph& glyph = glyphs_[key];
+
+  // cv::getTextSize rounds the sum of the advances plus the thickness, so
+  // measuring many copies recovers the advance in whole font units.
+  int baseline = 0;
+  const int width = cv::getTextSize(std::string(kAdvanceSamples, c), font_face,
+                                    font_scale, thickness, &baseline)
+                        .width;
+  const int advance_units =
+      cvRound((width - thickness) / (kAdvanceSamples * font_scale));
+  glyph.advance =
+      static_cast<int64>(advance_units) * FixedPointScale(font_scale);
+
+  const int margin = cvCeil(kMaxGlyphExtent * font_scale) + thickness + 2;
+  cv::Mat canvas = cv::Mat::zeros(
+      2 * margin, 2 * margin + cvCeil(advance_units * font_scale), CV_8UC1);
+  cv::putText(canvas, std::string(1, c), cv::Point(margin, margin), font_face,
+              font_scale, cv::Scalar(255), thickness, kLineType);
+  if (cv::countNonZero(canvas) == 0) {
+    return glyph;
+  }
+  std::vector<cv::Point> points;
+  cv::findNonZero(canvas, points);
+  const cv::Rect bounds = cv::boundingRect(points);
+  glyph.mask.mask = canvas(bounds).clone();
+  glyph.mask.offset = bounds.tl() - cv::Point(margin, margin);
+  return glyph;
+}
+
+const GlyphAtlasTextRenderer::Mask& GlyphAtlasTextRenderer::GetString(
+    const std::string& text, int font_face, double font_scale, int thickness,
+    bool flipped) {
+  const auto key = std::make_tuple(
+      Style(font_face, FixedPointScale(font_scale), thickness), flipped, text);
+  auto it = strings_.find(key);
+  if (it != strings_.end()) {
+    return it->second;
+  }
+  if (strings_.size() >= static_cast<size_t>(max_interned_strings_)) {
+    strings_.clear();
+  }
+  Mask& result = strings_[key];
+
+  // Place each glyph at the pen position of cv::putText, rounded to the
+  // nearest pixel.
+  std::vector<std::pair<const Glyph*, cv::Point>> placed;
+  cv::Rect bounds;
+  int64 pen = 0;
+  for (char c : text) {
+    const Glyph& glyph = GetGlyph(c, font_face, font_scale, thickness);
+    if (!glyph.mask.mask.empty()) {
+      const int pen_x = static_cast<int>(
+          (pen + (1 << (kFixedPointShift - 1))) >> kFixedPointShift);
+      const cv::Point top_left = glyph.mask.offset + cv::Point(pen_x, 0);
+      const cv::Rect glyph_rect(top_left, glyph.mask.mask.size());
+      bounds = placed.empty() ? glyph_rect : (bounds | glyph_rect);
+      placed.emplace_back(&glyph, top_left);
+    }
+    pen += glyph.advance;
+  }
+  if (placed.empty()) {
+    return result;
+  }
+
+  result.mask = cv::Mat::zeros(bounds.size(), CV_8UC1);
+  for (const auto& glyph_and_position : placed) {
+    const cv::Mat& glyph_mask = glyph_and_position.first->mask.mask;
+    cv::Mat target = result.mask(
+        cv::Rect(glyph_and_position.second - bounds.tl(), glyph_mask.size()));
+    cv::max(target, glyph_mask, target);
+  }
+  result.offset = bounds.tl();
+  if (flipped) {
+    // cv::putText mirrors the text about the baseline through the origin.
+    cv::flip(result.mask, result.mask, 0);
+    result.offset.y = -bounds.y - bounds.height + 1;
+  }
+  return result;
+}
+
+}  // namespace mediapipe
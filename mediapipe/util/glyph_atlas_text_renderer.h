@@ -0,0 +1,83 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_UTIL_GLYPH_ATLAS_TEXT_RENDERER_H_
+#define MEDIAPIPE_UTIL_GLYPH_ATLAS_TEXT_RENDERER_H_
+
+#include <map>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+
+namespace mediapipe {
+
+// Draws text like cv::putText with lineType 8, but from cached masks rather
+// than by rasterizing the Hershey font strokes of every string on every
+// frame.
+//
+// Each glyph is rasterized once per font face, scale and thickness, and
+// strings are composed from the glyph masks at the pen positions cv::putText
+// uses, rounded to the nearest pixel. The composed masks of recent strings
+// are interned, so that a repeated label is drawn by a single masked fill.
+// Glyph strokes may differ from cv::putText by a pixel where cv::putText
+// would draw a glyph at a fractional position.
+//
+// Strings with non-ASCII characters are passed to cv::putText.
+// Not thread-safe.
+class GlyphAtlasTextRenderer {
+ public:
+  // At most "max_interned_strings" composed strings are kept. When more are
+  // needed, the interned strings are discarded, but not the glyphs.
+  explicit GlyphAtlasTextRenderer(int max_interned_strings = 256);
+
+  // Draws "text" onto "image" with the arguments of cv::putText.
+  void PutText(cv::Mat* image, const std::string& text, cv::Point origin,
+               int font_face, double font_scale, const cv::Scalar& color,
+               int thickness, bool bottom_left_origin = false);
+
+ private:
+  // A mask drawn with its top left corner at "offset" from the text origin.
+  struct Mask {
+    cv::Mat mask;
+    cv::Point offset;
+  };
+  struct Glyph {
+    Mask mask;
+    // The advance of the pen after the glyph, in 1/65536 pixels, as
+    // cv::putText computes it.
+    int64 advance = 0;
+  };
+  // Identifies a font face, scale and thickness.
+  using Style = std::tuple<int, int, int>;
+
+  // Returns the glyph of "c", rasterizing it if it is not cached.
+  const Glyph& GetGlyph(char c, int font_face, double font_scale,
+                        int thickness);
+
+  // Returns the mask of "text", composing it if it is not interned.
+  const Mask& GetString(const std::string& text, int font_face,
+                        double font_scale, int thickness, bool flipped);
+
+  const int max_interned_strings_;
+  std::map<std::pair<Style, char>, Glyph> glyphs_;
+  // Interned strings, by style, vertical flip and text.
+  std::map<std::tuple<Style, bool, std::string>, Mask> strings_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_GLYPH_ATLAS_TEXT_RENDERER_H_
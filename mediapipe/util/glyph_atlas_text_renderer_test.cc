@@ -0,0 +1,107 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/glyph_atlas_text_renderer.h"
+
+#include <string>
+
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+
+namespace mediapipe {
+namespace {
+
+const cv::Scalar kColor(255, 128, 0);
+
+// Returns the number of pixels that differ between "a" and "b".
+int CountDifferentPixels(const cv::Mat& a, const cv::Mat& b) {
+  cv::Mat diff;
+  cv::absdiff(a, b, diff);
+  cv::Mat gray;
+  cv::cvtColor(diff, gray, cv::COLOR_RGB2GRAY);
+  return cv::countNonZero(gray);
+}
+
+// Returns the number of non-black pixels of "image".
+int CountDrawnPixels(const cv::Mat& image) {
+  cv::Mat gray;
+  cv::cvtColor(image, gray, cv::COLOR_RGB2GRAY);
+  return cv::countNonZero(gray);
+}
+
+TEST(GlyphAtlasTextRendererTest, MatchesPutTextAtWholePixelPositions) {
+  // With an integer scale, cv::putText draws every glyph at a whole pixel
+  // position, so the glyphs are blitted exactly where it draws them.
+  for (double font_scale : {1.0, 2.0}) {
+    cv::Mat expected(120, 400, CV_8UC3, cv::Scalar(0, 0, 0));
+    cv::Mat actual = expected.clone();
+    const std::string text = "person: 0.87 (id 42)";
+    cv::putText(expected, text, cv::Point(5, 60), cv::FONT_HERSHEY_SIMPLEX,
+                font_scale, kColor, 2, 8);
+    GlyphAtlasTextRenderer renderer;
+    renderer.PutText(&actual, text, cv::Point(5, 60),
+                     cv::FONT_HERSHEY_SIMPLEX, font_scale, kColor, 2);
+    EXPECT_GT(CountDrawnPixels(expected), 0);
+    EXPECT_EQ(0, CountDifferentPixels(expected, actual)) << font_scale;
+  }
+}
+
+TEST(GlyphAtlasTextRendererTest, NearlyMatchesPutTextAtFractionalScale) {
+  cv::Mat expected(60, 300, CV_8UC3, cv::Scalar(0, 0, 0));
+  cv::Mat actual = expected.clone();
+  const std::string text = "30.1 fps";
+  cv::putText(expected, text, cv::Point(10, 40), cv::FONT_HERSHEY_PLAIN, 1.7,
+              kColor, 1, 8);
+  GlyphAtlasTextRenderer renderer;
+  renderer.PutText(&actual, text, cv::Point(10, 40), cv::FONT_HERSHEY_PLAIN,
+                   1.7, kColor, 1);
+  const int drawn_pixels = CountDrawnPixels(expected);
+  EXPECT_NEAR(drawn_pixels, CountDrawnPixels(actual), drawn_pixels / 10);
+  EXPECT_LT(CountDifferentPixels(expected, actual), drawn_pixels);
+}
+
+TEST(GlyphAtlasTextRendererTest, RepeatedTextIsDrawnIdentically) {
+  cv::Mat first(60, 200, CV_8UC3, cv::Scalar(0, 0, 0));
+  cv::Mat second = first.clone();
+  GlyphAtlasTextRenderer renderer(/*max_interned_strings=*/1);
+  renderer.PutText(&first, "label", cv::Point(10, 40),
+                   cv::FONT_HERSHEY_DUPLEX, 0.8, kColor, 1);
+  // Evicts "label" from the interned strings.
+  renderer.PutText(&second, "other", cv::Point(10, 40),
+                   cv::FONT_HERSHEY_DUPLEX, 0.8, kColor, 1);
+  second.setTo(cv::Scalar(0, 0, 0));
+  renderer.PutText(&second, "label", cv::Point(10, 40),
+                   cv::FONT_HERSHEY_DUPLEX, 0.8, kColor, 1);
+  EXPECT_GT(CountDrawnPixels(first), 0);
+  EXPECT_EQ(0, CountDifferentPixels(first, second));
+}
+
+TEST(GlyphAtlasTextRendererTest, ClipsToImageAndFlips) {
+  cv::Mat expected(40, 60, CV_8UC3, cv::Scalar(0, 0, 0));
+  cv::Mat actual = expected.clone();
+  cv::putText(expected, "clipped text", cv::Point(-10, 10),
+              cv::FONT_HERSHEY_SIMPLEX, 1.0, kColor, 1, 8,
+              /*bottomLeftOrigin=*/true);
+  GlyphAtlasTextRenderer renderer;
+  renderer.PutText(&actual, "clipped text", cv::Point(-10, 10),
+                   cv::FONT_HERSHEY_SIMPLEX, 1.0, kColor, 1,
+                   /*bottom_left_origin=*/true);
+  const int drawn_pixels = CountDrawnPixels(expected);
+  EXPECT_GT(drawn_pixels, 0);
+  EXPECT_LT(CountDifferentPixels(expected, actual), drawn_pixels / 10);
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <cmath>
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -24,8 +25,11 @@
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
 #include "libyuv/convert.h"
+#include "libyuv/convert_argb.h"
 #include "libyuv/convert_from.h"
+#include "libyuv/planar_functions.h"
 #include "libyuv/row.h"
+#include "libyuv/scale.h"
 #include "libyuv/video_common.h"
 #include "mediapipe/framework/deps/mathutil.h"
 #include "mediapipe/framework/formats/image_frame.h"
@@ -109,17 +113,15 @@ void ImageFrameToYUVImage(const ImageFrame& image_frame, YUVImage* yuv_image) {
 
 void ImageFrameToYUVNV12Image(const ImageFrame& image_frame,
                               YUVImage* yuv_nv12_image) {
-  // Create a YUV I420 image that will hold the converted RGBA image.
-  YUVImage yuv_i420_image;
-  ImageFrameToYUVImage(image_frame, &yuv_i420_image);
-
-  // Now create a YUV NV12 image and convert the I420 to NV12.
-  const int width = yuv_i420_image.width();
-  const int height = yuv_i420_image.height();
-  const int y_stride = yuv_i420_image.stride(0);
+  const int width = image_frame.Width();
+  const int height = image_frame.Height();
+  const int uv_width = (width + 1) / 2;
+  const int uv_height = (height + 1) / 2;
+  // Align y_stride on a 16-byte boundary, the interleaved UV plane has the
+  // same stride.
+  const int y_stride = (width + 15) & ~15;
   const int y_size = y_stride * height;
   const int uv_stride = y_stride;
-  const int uv_height = (height + 1) / 2;
   const int uv_size = uv_stride * uv_height;
   uint8* data = reinterpret_cast<uint8*>(aligned_malloc(y_size + uv_size, 16));
   std::function<void()> deallocate = [data] { aligned_free(data); };
@@ -127,13 +129,27 @@ void ImageFrameToYUVNV12Image(const ImageFrame& image_frame,
   uint8* uv = y + y_size;
   yuv_nv12_image->Initialize(libyuv::FOURCC_NV12, deallocate, y, y_stride, uv,
                              uv_stride, nullptr, 0, width, height);
-  const int rv = libyuv::I420ToNV12(
-      yuv_i420_image.data(0), yuv_i420_image.stride(0), yuv_i420_image.data(1),
-      yuv_i420_image.stride(1), yuv_i420_image.data(2),
-      yuv_i420_image.stride(2), yuv_nv12_image->mutable_data(0),
-      yuv_nv12_image->stride(0), yuv_nv12_image->mutable_data(1),
-      yuv_nv12_image->stride(1), width, height);
+
+  // Convert straight into the Y plane, and only stage the quarter size U and
+  // V planes before interleaving them.
+  const int planar_uv_stride = (uv_width + 15) & ~15;
+  const int planar_uv_size = planar_uv_stride * uv_height;
+  std::unique_ptr<uint8, void (*)(void*)> planar_uv(
+      reinterpret_cast<uint8*>(aligned_malloc(planar_uv_size * 2, 16)),
+      aligned_free);
+  uint8* u = planar_uv.get();
+  uint8* v = u + planar_uv_size;
+  const int rv =
+      libyuv::RAWToI420(image_frame.PixelData(), image_frame.WidthStep(),  //
+                        y, y_stride,                                       //
+                        u, planar_uv_stride,                               //
+                        v, planar_uv_stride,                               //
+                        width, height);
   CHECK_EQ(0, rv);
+  libyuv::MergeUVPlane(u, planar_uv_stride,  //
+                       v, planar_uv_stride,  //
+                       uv, uv_stride,        //
+                       uv_width, uv_height);
 }
 
 void YUVImageToImageFrame(const YUVImage& yuv_image, ImageFrame* image_frame,
@@ -144,7 +160,20 @@ void YUVImageToImageFrame(const YUVImage& yuv_image, ImageFrame* image_frame,
   image_frame->Reset(ImageFormat::SRGB, width, height, 16);
   int rv;
 
-  if (use_bt709) {
+  if (yuv_image.fourcc() == libyuv::FOURCC_NV12 ||
+      yuv_image.fourcc() == libyuv::FOURCC_NV21) {
+    // libyuv has no RAW variants of the biplanar conversions, so RGB24 is
+    // written with the chroma order swapped, which swaps R and B.
+    const libyuv::YuvConstants* yvu_constants =
+        use_bt709 ? &libyuv::kYvuH709Constants : &libyuv::kYvuI601Constants;
+    const auto convert = yuv_image.fourcc() == libyuv::FOURCC_NV12
+                             ? libyuv::NV21ToRGB24Matrix
+                             : libyuv::NV12ToRGB24Matrix;
+    rv = convert(yuv_image.data(0), yuv_image.stride(0),  //
+                 yuv_image.data(1), yuv_image.stride(1),  //
+                 image_frame->MutablePixelData(), image_frame->WidthStep(),
+                 yvu_constants, width, height);
+  } else if (use_bt709) {
     rv = libyuv::H420ToRAW(yuv_image.data(0), yuv_image.stride(0),  //
                            yuv_image.data(1), yuv_image.stride(1),  //
                            yuv_image.data(2), yuv_image.stride(2),  //
@@ -161,6 +190,87 @@ void YUVImageToImageFrame(const YUVImage& yuv_image, ImageFrame* image_frame,
   CHECK_EQ(0, rv);
 }
 
+void YUVImageRegionToImageFrame(const YUVImage& yuv_image, int left, int top,
+                                int crop_width, int crop_height,
+                                int output_width, int output_height,
+                                ImageFrame* image_frame, bool use_bt709) {
+  CHECK(image_frame);
+  const libyuv::FourCC fourcc = yuv_image.fourcc();
+  const bool biplanar =
+      fourcc == libyuv::FOURCC_NV12 || fourcc == libyuv::FOURCC_NV21;
+  CHECK(biplanar || fourcc == libyuv::FOURCC_I420)
+      << "Unsupported YUVImage fourcc " << fourcc;
+
+  left = std::max(0, left) & ~1;
+  top = std::max(0, top) & ~1;
+  crop_width = std::min(crop_width, yuv_image.width() - left);
+  crop_height = std::min(crop_height, yuv_image.height() - top);
+  CHECK_GT(crop_width, 0);
+  CHECK_GT(crop_height, 0);
+
+  // A view of the region, which shares the planes of yuv_image.
+  YUVImage region;
+  const uint8* y = yuv_image.data(0) + top * yuv_image.stride(0) + left;
+  const uint8* u = yuv_image.data(1) + (top / 2) * yuv_image.stride(1) +
+                   (biplanar ? left : left / 2);
+  const uint8* v = biplanar ? nullptr
+                            : yuv_image.data(2) +
+                                  (top / 2) * yuv_image.stride(2) + left / 2;
+  region.Initialize(fourcc, nullptr,                             //
+                    const_cast<uint8*>(y), yuv_image.stride(0),  //
+                    const_cast<uint8*>(u), yuv_image.stride(1),  //
+                    const_cast<uint8*>(v), yuv_image.stride(2),  //
+                    crop_width, crop_height);
+  if (crop_width == output_width && crop_height == output_height) {
+    YUVImageToImageFrame(region, image_frame, use_bt709);
+    return;
+  }
+
+  // Scale the region in YUV, then convert at the output resolution.
+  const int uv_width = (output_width + 1) / 2;
+  const int uv_height = (output_height + 1) / 2;
+  const int y_stride = (output_width + 15) & ~15;
+  const int y_size = y_stride * output_height;
+  // The interleaved UV plane of NV12 and NV21 has the same stride as Y.
+  const int uv_stride = biplanar ? y_stride : (uv_width + 15) & ~15;
+  const int uv_size = uv_stride * uv_height;
+  uint8* data = reinterpret_cast<uint8*>(
+      aligned_malloc(y_size + uv_size * (biplanar ? 1 : 2), 16));
+  std::function<void()> deallocate = [data] { aligned_free(data); };
+  uint8* scaled_y = data;
+  uint8* scaled_u = scaled_y + y_size;
+  uint8* scaled_v = biplanar ? nullptr : scaled_u + uv_size;
+  YUVImage scaled;
+  scaled.Initialize(fourcc, deallocate,                  //
+                    scaled_y, y_stride,                  //
+                    scaled_u, uv_stride,                 //
+                    scaled_v, biplanar ? 0 : uv_stride,  //
+                    output_width, output_height);
+  int rv;
+  if (biplanar) {
+    // The chroma order does not matter for scaling.
+    rv = libyuv::NV12Scale(y, yuv_image.stride(0),       //
+                           u, yuv_image.stride(1),       //
+                           crop_width, crop_height,      //
+                           scaled_y, y_stride,           //
+                           scaled_u, uv_stride,          //
+                           output_width, output_height,  //
+                           libyuv::kFilterBilinear);
+  } else {
+    rv = libyuv::I420Scale(y, yuv_image.stride(0),       //
+                           u, yuv_image.stride(1),       //
+                           v, yuv_image.stride(2),       //
+                           crop_width, crop_height,      //
+                           scaled_y, y_stride,           //
+                           scaled_u, uv_stride,          //
+                           scaled_v, uv_stride,          //
+                           output_width, output_height,  //
+                           libyuv::kFilterBilinear);
+  }
+  CHECK_EQ(0, rv);
+  YUVImageToImageFrame(scaled, image_frame, use_bt709);
+}
+
 void SrgbToMpegYCbCr(const uint8 r, const uint8 g, const uint8 b,  //
                      uint8* y, uint8* cb, uint8* cr) {
   // ITU-R BT.601 conversion from sRGB to YCbCr.
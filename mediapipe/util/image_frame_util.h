@@ -55,15 +55,28 @@ void ImageFrameToYUVImage(const ImageFrame& image_frame, YUVImage* yuv_image);
 void ImageFrameToYUVNV12Image(const ImageFrame& image_frame,
                               YUVImage* yuv_nv12_image);
 
-// Convert a YUVImage to an SRGB ImageFrame. If use_bt709 is set to false, this
-// function will assume that the YUV is as defined in BT.601 (standard from the
-// 1980s). Most content is using BT.709 (as of 2019), but it's likely that this
-// will no longer the case in the future, when BT.2100 will likely be dominant.
+// Convert an I420, NV12 or NV21 YUVImage to an SRGB ImageFrame. If use_bt709
+// is set to false, this function will assume that the YUV is as defined in
+// BT.601 (standard from the 1980s). Most content is using BT.709 (as of 2019),
+// but it's likely that this will no longer the case in the future, when
+// BT.2100 will likely be dominant.
 // This function needs to be changed significantly once YUVImage starts
 // supporting ICtCp.
 void YUVImageToImageFrame(const YUVImage& yuv_image, ImageFrame* image_frame,
                           bool use_bt709 = false);
 
+// Convert the crop_width x crop_height region at (left, top) of an I420, NV12
+// or NV21 YUVImage to an SRGB ImageFrame of output_width x output_height.
+// The region is cropped and scaled in YUV, so only the output pixels are
+// color converted. The region is clipped to the image, and its origin is
+// rounded down to even coordinates to stay aligned with the chroma planes.
+// See YUVImageToImageFrame() for use_bt709.
+void YUVImageRegionToImageFrame(const YUVImage& yuv_image, int left, int top,
+                                int crop_width, int crop_height,
+                                int output_width, int output_height,
+                                ImageFrame* image_frame,
+                                bool use_bt709 = false);
+
 // Convert sRGB values into MPEG YCbCr values.  Notice that MPEG YCbCr
 // values use a smaller range of values than JPEG YCbCr.  The conversion
 // values used are those from ITU-R BT.601 (which are the same as ITU-R
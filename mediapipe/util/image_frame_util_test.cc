@@ -0,0 +1,133 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/image_frame_util.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "libyuv/video_common.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/yuv_image.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+namespace image_frame_util {
+namespace {
+
+// Fills an SRGB frame with a pattern that has both smooth gradients and
+// per-pixel variation, so chroma subsampling is exercised.
+void FillTestPattern(ImageFrame* frame) {
+  for (int row = 0; row < frame->Height(); ++row) {
+    uint8* pixel = frame->MutablePixelData() + row * frame->WidthStep();
+    for (int col = 0; col < frame->Width(); ++col) {
+      *pixel++ = (col * 255) / frame->Width();
+      *pixel++ = (row * 255) / frame->Height();
+      *pixel++ = (col * 7 + row * 13) % 256;
+    }
+  }
+}
+
+// Returns the largest per-channel difference between two SRGB frames.
+int MaxAbsDiff(const ImageFrame& a, const ImageFrame& b) {
+  int max_diff = 0;
+  for (int row = 0; row < a.Height(); ++row) {
+    const uint8* pa = a.PixelData() + row * a.WidthStep();
+    const uint8* pb = b.PixelData() + row * b.WidthStep();
+    for (int i = 0; i < a.Width() * a.NumberOfChannels(); ++i) {
+      max_diff = std::max(max_diff, std::abs(pa[i] - pb[i]));
+    }
+  }
+  return max_diff;
+}
+
+TEST(ImageFrameUtilTest, NV12MatchesI420) {
+  // Odd dimensions to cover the partial chroma row and column.
+  ImageFrame frame(ImageFormat::SRGB, 65, 33);
+  FillTestPattern(&frame);
+
+  YUVImage i420;
+  ImageFrameToYUVImage(frame, &i420);
+  YUVImage nv12;
+  ImageFrameToYUVNV12Image(frame, &nv12);
+  ASSERT_EQ(libyuv::FOURCC_NV12, nv12.fourcc());
+  ASSERT_EQ(frame.Width(), nv12.width());
+  ASSERT_EQ(frame.Height(), nv12.height());
+
+  for (int row = 0; row < frame.Height(); ++row) {
+    for (int col = 0; col < frame.Width(); ++col) {
+      ASSERT_EQ(i420.data(0)[row * i420.stride(0) + col],
+                nv12.data(0)[row * nv12.stride(0) + col]);
+    }
+  }
+  for (int row = 0; row < (frame.Height() + 1) / 2; ++row) {
+    for (int col = 0; col < (frame.Width() + 1) / 2; ++col) {
+      const uint8* uv = nv12.data(1) + row * nv12.stride(1) + col * 2;
+      ASSERT_EQ(i420.data(1)[row * i420.stride(1) + col], uv[0]);
+      ASSERT_EQ(i420.data(2)[row * i420.stride(2) + col], uv[1]);
+    }
+  }
+}
+
+TEST(ImageFrameUtilTest, NV12ToImageFrameMatchesI420) {
+  ImageFrame frame(ImageFormat::SRGB, 64, 32);
+  FillTestPattern(&frame);
+
+  YUVImage i420;
+  ImageFrameToYUVImage(frame, &i420);
+  YUVImage nv12;
+  ImageFrameToYUVNV12Image(frame, &nv12);
+
+  for (bool use_bt709 : {false, true}) {
+    ImageFrame from_i420;
+    YUVImageToImageFrame(i420, &from_i420, use_bt709);
+    ImageFrame from_nv12;
+    YUVImageToImageFrame(nv12, &from_nv12, use_bt709);
+    // Both paths use the same libyuv constants, only the row functions
+    // differ.
+    EXPECT_LE(MaxAbsDiff(from_i420, from_nv12), 1) << use_bt709;
+    // The round trip stays close to the source despite chroma subsampling.
+    if (!use_bt709) {
+      EXPECT_LE(MaxAbsDiff(frame, from_nv12), 48);
+    }
+  }
+}
+
+void BM_ImageFrameToYUVNV12Image(benchmark::State& state) {
+  ImageFrame frame(ImageFormat::SRGB, 1920, 1080);
+  FillTestPattern(&frame);
+  for (auto _ : state) {
+    YUVImage nv12;
+    ImageFrameToYUVNV12Image(frame, &nv12);
+  }
+}
+BENCHMARK(BM_ImageFrameToYUVNV12Image);
+
+void BM_YUVImageToImageFrameNV12(benchmark::State& state) {
+  ImageFrame frame(ImageFormat::SRGB, 1920, 1080);
+  FillTestPattern(&frame);
+  YUVImage nv12;
+  ImageFrameToYUVNV12Image(frame, &nv12);
+  ImageFrame output;
+  for (auto _ : state) {
+    YUVImageToImageFrame(nv12, &output);
+  }
+}
+BENCHMARK(BM_YUVImageToImageFrameNV12);
+
+}  // namespace
+}  // namespace image_frame_util
+}  // namespace mediapipe
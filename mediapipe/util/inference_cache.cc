@@ -0,0 +1,209 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/inference_cache.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/packet_serializer.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/util/packet_log.h"
+
+namespace mediapipe {
+
+namespace {
+
+inline uint64 Rotate(uint64 value, int shift) {
+  return (value << shift) | (value >> (64 - shift));
+}
+
+// The finalizer of MurmurHash3.
+inline uint64 Mix(uint64 value) {
+  value ^= value >> 33;
+  value *= 0xff51afd7ed558ccdULL;
+  value ^= value >> 33;
+  value *= 0xc4ceb9fe1a85ec53ULL;
+  value ^= value >> 33;
+  return value;
+}
+
+// Computes two independent 64-bit hashes of a byte sequence, eight bytes at a
+// time, so that distinct contents practically never share a key.
+class ContentHasher {
+ public:
+  void Update(const void* data, size_t size) {
+    const uint8* bytes = static_cast<const uint8*>(data);
+    size_ += size;
+    for (; size >= sizeof(uint64); size -= sizeof(uint64)) {
+      uint64 word;
+      memcpy(&word, bytes, sizeof(word));
+      bytes += sizeof(word);
+      AddWord(word);
+    }
+    if (size > 0) {
+      uint64 word = 0;
+      memcpy(&word, bytes, size);
+      AddWord(word);
+    }
+  }
+
+  std::string HexDigest() const {
+    return absl::StrFormat("%016x%016x", Mix(high_ ^ size_),
+                           Mix(low_ + size_));
+  }
+
+ private:
+  void AddWord(uint64 word) {
+    high_ = Rotate(high_ ^ (word * 0x87c37b91114253d5ULL), 31) *
+            0x4cf5ad432745937fULL;
+    low_ = Rotate(low_ + (word * 0x9e3779b97f4a7c15ULL), 29) *
+           0xbf58476d1ce4e5b9ULL;
+  }
+
+  uint64 high_ = 0x6a09e667f3bcc908ULL;
+  uint64 low_ = 0xbb67ae8584caa73bULL;
+  uint64 size_ = 0;
+};
+
+}  // namespace
+
+InferenceCache::InferenceCache(const Options& options) : options_(options) {}
+
+::mediapipe::StatusOr<std::string> InferenceCache::ContentKey(
+    const Packet& packet) {
+  ContentHasher hasher;
+  if (packet.ValidateAsType<ImageFrame>().ok()) {
+    const ImageFrame& frame = packet.Get<ImageFrame>();
+    const int32 header[] = {0x494d4746, frame.Format(), frame.Width(),
+                            frame.Height()};
+    hasher.Update(header, sizeof(header));
+    // Skips the padding at the end of the rows.
+    const int row_size =
+        frame.Width() * frame.NumberOfChannels() * frame.ByteDepth();
+    for (int y = 0; y < frame.Height(); ++y) {
+      hasher.Update(frame.PixelData() + y * frame.WidthStep(), row_size);
+    }
+    return hasher.HexDigest();
+  }
+  SerializedPacket serialized;
+  MP_RETURN_IF_ERROR(
+      SerializePacket(packet.At(Timestamp::Unset()), &serialized));
+  for (const auto& chunk : serialized.chunks()) {
+    hasher.Update(chunk.data(), chunk.size());
+  }
+  return hasher.HexDigest();
+}
+
+::mediapipe::StatusOr<bool> InferenceCache::Lookup(
+    const std::string& key, std::vector<Packet>* outputs) {
+  {
+    absl::MutexLock lock(&mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      entries_.splice(entries_.begin(), entries_, it->second);
+      *outputs = it->second->second;
+      return true;
+    }
+  }
+  if (options_.directory.empty()) {
+    return false;
+  }
+  const std::string path = EntryPath(key);
+  if (!file::Exists(path).ok()) {
+    return false;
+  }
+  ASSIGN_OR_RETURN(std::unique_ptr<PacketLogReader> reader,
+                   PacketLogReader::Open(path));
+  outputs->assign(reader->stream_names().size(), Packet());
+  int index;
+  absl::Time arrival_time;
+  Packet packet;
+  while (true) {
+    ASSIGN_OR_RETURN(bool has_packet,
+                     reader->Next(&index, &arrival_time, &packet));
+    if (!has_packet) {
+      break;
+    }
+    (*outputs)[index] = packet;
+  }
+  absl::MutexLock lock(&mutex_);
+  InsertInMemory(key, *outputs);
+  return true;
+}
+
+::mediapipe::Status InferenceCache::Insert(
+    const std::string& key, const std::vector<Packet>& outputs) {
+  {
+    absl::MutexLock lock(&mutex_);
+    InsertInMemory(key, outputs);
+  }
+  if (options_.directory.empty()) {
+    return ::mediapipe::OkStatus();
+  }
+  std::vector<std::string> stream_names;
+  for (int i = 0; i < outputs.size(); ++i) {
+    stream_names.push_back(absl::StrCat(i));
+  }
+  // The entry is written under a unique temporary name and renamed, so that
+  // readers never see it incomplete.
+  const std::string path = EntryPath(key);
+  static std::atomic<int> num_temporary_files(0);
+  const std::string temporary_path =
+      absl::StrCat(path, ".", getpid(), ".", num_temporary_files++, ".tmp");
+  ASSIGN_OR_RETURN(std::unique_ptr<PacketLogWriter> writer,
+                   PacketLogWriter::Create(temporary_path, stream_names));
+  for (int i = 0; i < outputs.size(); ++i) {
+    if (!outputs[i].IsEmpty()) {
+      MP_RETURN_IF_ERROR(writer->Append(i, absl::UnixEpoch(), outputs[i]));
+    }
+  }
+  MP_RETURN_IF_ERROR(writer->Close());
+  RET_CHECK_EQ(rename(temporary_path.c_str(), path.c_str()), 0)
+      << "could not rename " << temporary_path << ": " << strerror(errno);
+  return ::mediapipe::OkStatus();
+}
+
+void InferenceCache::InsertInMemory(const std::string& key,
+                                    const std::vector<Packet>& outputs) {
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    entries_.erase(it->second);
+    index_.erase(it);
+  }
+  entries_.emplace_front(key, outputs);
+  index_[key] = entries_.begin();
+  while (entries_.size() > static_cast<size_t>(options_.max_entries)) {
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+}
+
+std::string InferenceCache::EntryPath(const std::string& key) const {
+  return absl::StrCat(options_.directory, "/", key, ".log");
+}
+
+}  // namespace mediapipe
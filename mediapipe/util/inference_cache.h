@@ -0,0 +1,86 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A cache of the outputs of an expensive computation, such as inference,
+// keyed by a hash of its input's contents.  Entries are kept in memory up to
+// a number of entries, evicting the least recently used, and can also be
+// stored in a directory, where they survive the process.  Entries in the
+// directory are packet logs, so the output types need a registered
+// PacketSerializer or MEDIAPIPE_REGISTER_TYPE serialize functions.
+#ifndef MEDIAPIPE_UTIL_INFERENCE_CACHE_H_
+#define MEDIAPIPE_UTIL_INFERENCE_CACHE_H_
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+
+namespace mediapipe {
+
+// Thread-safe.
+class InferenceCache {
+ public:
+  struct Options {
+    // The number of entries kept in memory.
+    int max_entries = 1024;
+    // If not empty, the directory where entries are stored and looked up.
+    std::string directory;
+  };
+
+  explicit InferenceCache(const Options& options);
+
+  InferenceCache(const InferenceCache&) = delete;
+  InferenceCache& operator=(const InferenceCache&) = delete;
+
+  // Returns the key of the contents of "packet", a hex string of a 128-bit
+  // hash that is stable across processes.  ImageFrames are hashed directly
+  // from their pixels, and other packets from their serialization.
+  static ::mediapipe::StatusOr<std::string> ContentKey(const Packet& packet);
+
+  // Looks up the outputs stored for "key", in memory and then in the
+  // directory.  Returns false if there are none.  An empty packet stands for
+  // an output that was not produced.
+  ::mediapipe::StatusOr<bool> Lookup(const std::string& key,
+                                     std::vector<Packet>* outputs);
+
+  // Stores "outputs" for "key".
+  ::mediapipe::Status Insert(const std::string& key,
+                             const std::vector<Packet>& outputs);
+
+ private:
+  using Entry = std::pair<std::string, std::vector<Packet>>;
+
+  void InsertInMemory(const std::string& key,
+                      const std::vector<Packet>& outputs)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  std::string EntryPath(const std::string& key) const;
+
+  const Options options_;
+  absl::Mutex mutex_;
+  // The entries in memory, the most recently used first.
+  std::list<Entry> entries_ GUARDED_BY(mutex_);
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_
+      GUARDED_BY(mutex_);
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_INFERENCE_CACHE_H_
@@ -0,0 +1,114 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/inference_cache.h"
+
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+std::string ContentKey(const Packet& packet) {
+  auto key_or = InferenceCache::ContentKey(packet);
+  MP_EXPECT_OK(key_or.status());
+  return key_or.ok() ? key_or.ValueOrDie() : "";
+}
+
+// Returns a GRAY8 frame with the given pixel values and row alignment.
+Packet MakeFrame(const std::vector<uint8>& pixels, int alignment) {
+  auto frame = absl::make_unique<ImageFrame>(ImageFormat::GRAY8, 3, 2,
+                                             alignment);
+  frame->SetToZero();
+  for (int i = 0; i < pixels.size(); ++i) {
+    frame->MutablePixelData()[(i / 3) * frame->WidthStep() + i % 3] =
+        pixels[i];
+  }
+  return Adopt(frame.release());
+}
+
+// Returns the value of the first output stored for "key", or "" if none.
+std::string LookupString(InferenceCache* cache, const std::string& key) {
+  std::vector<Packet> outputs;
+  auto hit_or = cache->Lookup(key, &outputs);
+  MP_EXPECT_OK(hit_or.status());
+  if (!hit_or.ok() || !hit_or.ValueOrDie()) {
+    return "";
+  }
+  return outputs[0].Get<std::string>();
+}
+
+TEST(InferenceCacheTest, KeysImageFramesByContents) {
+  const std::vector<uint8> pixels = {1, 2, 3, 4, 5, 6};
+  // The padding of the rows does not change the key.
+  EXPECT_EQ(ContentKey(MakeFrame(pixels, 1)),
+            ContentKey(MakeFrame(pixels, 16)));
+  EXPECT_NE(ContentKey(MakeFrame(pixels, 1)),
+            ContentKey(MakeFrame({1, 2, 3, 4, 5, 7}, 1)));
+  EXPECT_EQ(32, ContentKey(MakeFrame(pixels, 1)).size());
+}
+
+TEST(InferenceCacheTest, KeysSerializablePacketsByContents) {
+  EXPECT_EQ(ContentKey(MakePacket<std::string>("a").At(Timestamp(1))),
+            ContentKey(MakePacket<std::string>("a").At(Timestamp(2))));
+  EXPECT_NE(ContentKey(MakePacket<std::string>("a")),
+            ContentKey(MakePacket<std::string>("b")));
+}
+
+TEST(InferenceCacheTest, EvictsLeastRecentlyUsedEntries) {
+  InferenceCache::Options options;
+  options.max_entries = 2;
+  InferenceCache cache(options);
+  MP_ASSERT_OK(cache.Insert("a", {MakePacket<std::string>("A")}));
+  MP_ASSERT_OK(cache.Insert("b", {MakePacket<std::string>("B")}));
+  EXPECT_EQ("A", LookupString(&cache, "a"));
+  MP_ASSERT_OK(cache.Insert("c", {MakePacket<std::string>("C")}));
+  EXPECT_EQ("A", LookupString(&cache, "a"));
+  EXPECT_EQ("", LookupString(&cache, "b"));
+  EXPECT_EQ("C", LookupString(&cache, "c"));
+}
+
+TEST(InferenceCacheTest, StoresEntriesInDirectory) {
+  InferenceCache::Options options;
+  options.max_entries = 0;
+  options.directory =
+      getenv("TEST_TMPDIR") ? getenv("TEST_TMPDIR") : "/tmp";
+  const std::string key = absl::StrCat("inference_cache_test_", getpid());
+  {
+    InferenceCache cache(options);
+    MP_ASSERT_OK(
+        cache.Insert(key, {MakePacket<std::string>("A"), Packet()}));
+  }
+  InferenceCache cache(options);
+  std::vector<Packet> outputs;
+  auto hit_or = cache.Lookup(key, &outputs);
+  MP_ASSERT_OK(hit_or.status());
+  ASSERT_TRUE(hit_or.ValueOrDie());
+  ASSERT_EQ(2, outputs.size());
+  EXPECT_EQ("A", outputs[0].Get<std::string>());
+  EXPECT_TRUE(outputs[1].IsEmpty());
+  unlink(absl::StrCat(options.directory, "/", key, ".log").c_str());
+}
+
+}  // namespace
+}  // namespace mediapipe
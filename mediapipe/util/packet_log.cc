@@ -0,0 +1,243 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/packet_log.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/packet_serializer.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+
+namespace mediapipe {
+
+namespace {
+
+// The file starts with kMagic, kVersion, the number of streams and their
+// size-prefixed names. Each record then holds its size after the size
+// field, the stream index, the arrival time in microseconds since the Unix
+// epoch and the serialized packet. The file header and the records are
+// padded to kAlignment, which keeps the contents of the serialized packets
+// aligned to SerializedPacket::kContentsAlignment in the mapping. A record
+// size of 0 marks the end of the records, since the part of the file not
+// written yet reads as zeros.
+constexpr uint64 kMagic = 0x474f4c54454b4350;  // "PCKETLOG"
+constexpr uint32 kVersion = 1;
+constexpr size_t kAlignment = SerializedPacket::kContentsAlignment;
+constexpr size_t kRecordHeaderSize =
+    sizeof(uint32) + sizeof(uint32) + sizeof(int64);
+static_assert(kRecordHeaderSize % kAlignment == 0,
+              "Records must start their serialized packets aligned.");
+
+// The file grows by at least this much, to keep remapping rare.
+constexpr size_t kMinGrowth = 16 << 20;
+
+size_t RoundUp(size_t value) {
+  return (value + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+::mediapipe::Status ErrnoError(const std::string& message) {
+  return ::mediapipe::InternalError(
+      absl::StrCat(message, ": ", strerror(errno)));
+}
+
+}  // namespace
+
+::mediapipe::StatusOr<std::unique_ptr<PacketLogWriter>> PacketLogWriter::Create(
+    const std::string& path, const std::vector<std::string>& stream_names) {
+  const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return ErrnoError(absl::StrCat("could not create ", path));
+  }
+  std::unique_ptr<PacketLogWriter> writer(
+      new PacketLogWriter(fd, stream_names.size()));
+  std::string header;
+  header.append(reinterpret_cast<const char*>(&kMagic), sizeof(kMagic));
+  header.append(reinterpret_cast<const char*>(&kVersion), sizeof(kVersion));
+  const uint32 num_streams = stream_names.size();
+  header.append(reinterpret_cast<const char*>(&num_streams),
+                sizeof(num_streams));
+  for (const std::string& name : stream_names) {
+    const uint32 name_size = name.size();
+    header.append(reinterpret_cast<const char*>(&name_size),
+                  sizeof(name_size));
+    header.append(name);
+  }
+  header.resize(RoundUp(header.size()), '\0');
+  MP_RETURN_IF_ERROR(writer->Reserve(header.size()));
+  memcpy(writer->mapping_, header.data(), header.size());
+  writer->size_ = header.size();
+  return std::move(writer);
+}
+
+PacketLogWriter::PacketLogWriter(int fd, int num_streams)
+    : fd_(fd), num_streams_(num_streams) {}
+
+PacketLogWriter::~PacketLogWriter() {
+  Close().IgnoreError();
+  close(fd_);
+}
+
+::mediapipe::Status PacketLogWriter::Append(int stream_index,
+                                            absl::Time arrival_time,
+                                            const Packet& packet) {
+  RET_CHECK(stream_index >= 0 && stream_index < num_streams_);
+  SerializedPacket serialized;
+  MP_RETURN_IF_ERROR(SerializePacket(packet, &serialized));
+  const size_t record_size = kRecordHeaderSize + serialized.size();
+  RET_CHECK_LE(record_size - sizeof(uint32), uint32{0xffffffff})
+      << "The packet is too large to log.";
+  MP_RETURN_IF_ERROR(Reserve(RoundUp(record_size)));
+
+  uint8* record = mapping_ + size_;
+  const uint32 index = stream_index;
+  const int64 arrival_usec = absl::ToUnixMicros(arrival_time);
+  memcpy(record + sizeof(uint32), &index, sizeof(index));
+  memcpy(record + 2 * sizeof(uint32), &arrival_usec, sizeof(arrival_usec));
+  serialized.CopyTo(record + kRecordHeaderSize);
+  // The size goes last, so that a record cut short by a crash reads as the
+  // end of the log.
+  const uint32 size_field = record_size - sizeof(uint32);
+  memcpy(record, &size_field, sizeof(size_field));
+  size_ += RoundUp(record_size);
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status PacketLogWriter::Reserve(size_t size) {
+  if (size_ + size <= capacity_) {
+    return ::mediapipe::OkStatus();
+  }
+  const size_t capacity =
+      std::max(size_ + size, capacity_ + std::max(capacity_, kMinGrowth));
+  if (mapping_) {
+    munmap(mapping_, capacity_);
+    mapping_ = nullptr;
+  }
+  if (ftruncate(fd_, capacity) != 0) {
+    return ErrnoError("could not grow packet log");
+  }
+  void* mapping =
+      mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (mapping == MAP_FAILED) {
+    return ErrnoError("could not map packet log");
+  }
+  mapping_ = static_cast<uint8*>(mapping);
+  capacity_ = capacity;
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status PacketLogWriter::Close() {
+  if (!mapping_) {
+    return ::mediapipe::OkStatus();
+  }
+  munmap(mapping_, capacity_);
+  mapping_ = nullptr;
+  capacity_ = 0;
+  if (ftruncate(fd_, size_) != 0) {
+    return ErrnoError("could not truncate packet log");
+  }
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::StatusOr<std::unique_ptr<PacketLogReader>> PacketLogReader::Open(
+    const std::string& path) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return ErrnoError(absl::StrCat("could not open ", path));
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    close(fd);
+    return ErrnoError(absl::StrCat("could not stat ", path));
+  }
+  const size_t size = file_stat.st_size;
+  RET_CHECK_GE(size, sizeof(kMagic)) << path << " is not a packet log.";
+  // A private writable mapping lets packets used in place be modified
+  // without changing the file.
+  void* mapping =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return ErrnoError(absl::StrCat("could not map ", path));
+  }
+
+  std::unique_ptr<PacketLogReader> reader(new PacketLogReader());
+  reader->mapping_ = std::shared_ptr<const uint8>(
+      static_cast<const uint8*>(mapping),
+      [size](const uint8* data) { munmap(const_cast<uint8*>(data), size); });
+  reader->size_ = size;
+
+  absl::string_view header(reinterpret_cast<const char*>(mapping), size);
+  uint64 magic;
+  uint32 version;
+  uint32 num_streams;
+  RET_CHECK(ConsumeSerializedValue(&header, &magic) && magic == kMagic)
+      << path << " is not a packet log.";
+  RET_CHECK(ConsumeSerializedValue(&header, &version) && version == kVersion)
+      << "Unsupported packet log version in " << path;
+  RET_CHECK(ConsumeSerializedValue(&header, &num_streams))
+      << "Truncated packet log " << path;
+  for (uint32 i = 0; i < num_streams; ++i) {
+    uint32 name_size;
+    RET_CHECK(ConsumeSerializedValue(&header, &name_size) &&
+              header.size() >= name_size)
+        << "Truncated packet log " << path;
+    reader->stream_names_.emplace_back(header.substr(0, name_size));
+    header.remove_prefix(name_size);
+  }
+  reader->records_offset_ = std::min(RoundUp(size - header.size()), size);
+  reader->offset_ = reader->records_offset_;
+  return std::move(reader);
+}
+
+::mediapipe::StatusOr<bool> PacketLogReader::Next(int* stream_index,
+                                                  absl::Time* arrival_time,
+                                                  Packet* packet) {
+  absl::string_view record(
+      reinterpret_cast<const char*>(mapping_.get()) + offset_,
+      size_ - offset_);
+  uint32 size_field;
+  if (!ConsumeSerializedValue(&record, &size_field) || size_field == 0) {
+    return false;
+  }
+  RET_CHECK(size_field >= kRecordHeaderSize - sizeof(uint32) &&
+            size_field <= record.size())
+      << "Truncated packet log record.";
+  record = record.substr(0, size_field);
+  uint32 index;
+  int64 arrival_usec;
+  ConsumeSerializedValue(&record, &index);
+  ConsumeSerializedValue(&record, &arrival_usec);
+  RET_CHECK_LT(index, stream_names_.size())
+      << "Invalid stream index in packet log.";
+  SerializedPacketView view;
+  view.data = record;
+  view.owner = mapping_;
+  ASSIGN_OR_RETURN(*packet, DeserializePacket(view));
+  *stream_index = index;
+  *arrival_time = absl::FromUnixMicros(arrival_usec);
+  offset_ = std::min(offset_ + RoundUp(sizeof(uint32) + size_field), size_);
+  return true;
+}
+
+}  // namespace mediapipe
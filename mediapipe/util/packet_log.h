@@ -0,0 +1,109 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// An append-only log of packets of several streams, each with the time it
+// arrived, written through a memory mapping. Packets are stored with
+// SerializePacket(), so their types need a registered PacketSerializer or
+// MEDIAPIPE_REGISTER_TYPE serialize functions, and the reader hands out
+// packets that use the mapped file in place where their serializer allows.
+
+#ifndef MEDIAPIPE_UTIL_PACKET_LOG_H_
+#define MEDIAPIPE_UTIL_PACKET_LOG_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+
+namespace mediapipe {
+
+// Writes a packet log. The file is grown in large steps and truncated to its
+// contents by Close(). If the process dies first, the records written so far
+// can still be read. Not thread-safe.
+class PacketLogWriter {
+ public:
+  // Creates or replaces the log file "path" for the streams "stream_names".
+  static ::mediapipe::StatusOr<std::unique_ptr<PacketLogWriter>> Create(
+      const std::string& path, const std::vector<std::string>& stream_names);
+
+  // Closes the log, ignoring errors.
+  ~PacketLogWriter();
+
+  PacketLogWriter(const PacketLogWriter&) = delete;
+  PacketLogWriter& operator=(const PacketLogWriter&) = delete;
+
+  // Appends "packet" of the stream with index "stream_index", which arrived
+  // at "arrival_time".
+  ::mediapipe::Status Append(int stream_index, absl::Time arrival_time,
+                             const Packet& packet);
+
+  // Unmaps the file and truncates it to the records written.
+  ::mediapipe::Status Close();
+
+ private:
+  PacketLogWriter(int fd, int num_streams);
+
+  // Makes room for "size" more bytes after the end of the records.
+  ::mediapipe::Status Reserve(size_t size);
+
+  const int fd_;
+  const int num_streams_;
+  uint8* mapping_ = nullptr;
+  size_t capacity_ = 0;
+  // The end of the records written.
+  size_t size_ = 0;
+};
+
+// Reads a packet log through a private mapping of the file, so that packets
+// modified in place downstream do not change the file.
+class PacketLogReader {
+ public:
+  static ::mediapipe::StatusOr<std::unique_ptr<PacketLogReader>> Open(
+      const std::string& path);
+
+  PacketLogReader(const PacketLogReader&) = delete;
+  PacketLogReader& operator=(const PacketLogReader&) = delete;
+
+  // The names of the logged streams, indexed by stream index.
+  const std::vector<std::string>& stream_names() const {
+    return stream_names_;
+  }
+
+  // Reads the next packet, its stream index and arrival time. Returns false
+  // at the end of the log. The packets may keep the mapping alive after the
+  // reader is destroyed.
+  ::mediapipe::StatusOr<bool> Next(int* stream_index, absl::Time* arrival_time,
+                                   Packet* packet);
+
+  // Restarts reading from the first packet.
+  void Rewind() { offset_ = records_offset_; }
+
+ private:
+  PacketLogReader() = default;
+
+  std::shared_ptr<const uint8> mapping_;
+  size_t size_ = 0;
+  size_t records_offset_ = 0;
+  size_t offset_ = 0;
+  std::vector<std::string> stream_names_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_PACKET_LOG_H_
@@ -0,0 +1,132 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/packet_log.h"
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+std::string TestLogPath(const std::string& name) {
+  return absl::StrCat(getenv("TEST_TMPDIR") ? getenv("TEST_TMPDIR") : "/tmp",
+                      "/", name, "_", getpid(), ".log");
+}
+
+std::unique_ptr<PacketLogReader> OpenLog(const std::string& path) {
+  auto reader_or = PacketLogReader::Open(path);
+  MP_EXPECT_OK(reader_or.status());
+  return reader_or.ok() ? std::move(reader_or.ValueOrDie()) : nullptr;
+}
+
+TEST(PacketLogTest, ReadsBackPackets) {
+  const std::string path = TestLogPath("reads_back_packets");
+  const absl::Time start = absl::FromUnixSeconds(1000);
+  {
+    auto writer_or = PacketLogWriter::Create(path, {"strings", "frames"});
+    MP_ASSERT_OK(writer_or.status());
+    auto& writer = writer_or.ValueOrDie();
+    MP_ASSERT_OK(writer->Append(
+        0, start, MakePacket<std::string>("first").At(Timestamp(1))));
+    auto frame = absl::make_unique<ImageFrame>(ImageFormat::GRAY8, 4, 2);
+    frame->SetToZero();
+    frame->MutablePixelData()[1] = 7;
+    MP_ASSERT_OK(writer->Append(1, start + absl::Milliseconds(5),
+                                Adopt(frame.release()).At(Timestamp(1))));
+    MP_ASSERT_OK(writer->Append(
+        0, start + absl::Milliseconds(9),
+        MakePacket<std::string>("second").At(Timestamp(2))));
+    MP_ASSERT_OK(writer->Close());
+  }
+
+  auto reader = OpenLog(path);
+  ASSERT_TRUE(reader);
+  EXPECT_EQ(reader->stream_names(),
+            std::vector<std::string>({"strings", "frames"}));
+  for (int pass = 0; pass < 2; ++pass) {
+    int stream_index;
+    absl::Time arrival_time;
+    Packet packet;
+    ASSERT_TRUE(
+        reader->Next(&stream_index, &arrival_time, &packet).ValueOrDie());
+    EXPECT_EQ(stream_index, 0);
+    EXPECT_EQ(arrival_time, start);
+    EXPECT_EQ(packet.Get<std::string>(), "first");
+
+    ASSERT_TRUE(
+        reader->Next(&stream_index, &arrival_time, &packet).ValueOrDie());
+    EXPECT_EQ(stream_index, 1);
+    EXPECT_EQ(arrival_time, start + absl::Milliseconds(5));
+    EXPECT_EQ(packet.Timestamp(), Timestamp(1));
+    const ImageFrame& frame = packet.Get<ImageFrame>();
+    EXPECT_EQ(frame.Width(), 4);
+    EXPECT_EQ(frame.PixelData()[1], 7);
+    // The pixel data is used in place, at the alignment of a new frame.
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(frame.PixelData()) %
+                  ImageFrame::kDefaultAlignmentBoundary,
+              0);
+
+    ASSERT_TRUE(
+        reader->Next(&stream_index, &arrival_time, &packet).ValueOrDie());
+    EXPECT_EQ(packet.Get<std::string>(), "second");
+    EXPECT_EQ(packet.Timestamp(), Timestamp(2));
+    EXPECT_FALSE(
+        reader->Next(&stream_index, &arrival_time, &packet).ValueOrDie());
+    reader->Rewind();
+  }
+  unlink(path.c_str());
+}
+
+TEST(PacketLogTest, ReadsLogThatWasNotClosed) {
+  const std::string path = TestLogPath("not_closed");
+  auto writer_or = PacketLogWriter::Create(path, {"strings"});
+  MP_ASSERT_OK(writer_or.status());
+  MP_ASSERT_OK(writer_or.ValueOrDie()->Append(
+      0, absl::Now(), MakePacket<std::string>("only").At(Timestamp(1))));
+
+  // The file still has its preallocated size, as after a crash.
+  auto reader = OpenLog(path);
+  ASSERT_TRUE(reader);
+  int stream_index;
+  absl::Time arrival_time;
+  Packet packet;
+  ASSERT_TRUE(reader->Next(&stream_index, &arrival_time, &packet).ValueOrDie());
+  EXPECT_EQ(packet.Get<std::string>(), "only");
+  EXPECT_FALSE(
+      reader->Next(&stream_index, &arrival_time, &packet).ValueOrDie());
+  unlink(path.c_str());
+}
+
+TEST(PacketLogTest, RejectsOtherFiles) {
+  const std::string path = TestLogPath("other_file");
+  FILE* file = fopen(path.c_str(), "w");
+  fputs("not a packet log", file);
+  fclose(file);
+  EXPECT_FALSE(PacketLogReader::Open(path).ok());
+  unlink(path.c_str());
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,94 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/parallel_for_rows.h"
+
+#include <algorithm>
+
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/util/cpu_util.h"
+
+namespace mediapipe {
+
+namespace {
+
+absl::Mutex shared_pool_mutex;
+int shared_pool_num_threads GUARDED_BY(shared_pool_mutex) = -1;
+bool shared_pool_created GUARDED_BY(shared_pool_mutex) = false;
+ThreadPool* shared_pool GUARDED_BY(shared_pool_mutex) = nullptr;
+
+ThreadPool* GetSharedPool() {
+  absl::MutexLock lock(&shared_pool_mutex);
+  if (!shared_pool_created) {
+    shared_pool_created = true;
+    int num_threads = shared_pool_num_threads;
+    if (num_threads < 0) {
+      num_threads = NumCPUCores() - 1;
+    }
+    if (num_threads > 0) {
+      // Intentionally leaked, like other process-wide singletons, so the
+      // workers outlive any calculator that may still be using them.
+      shared_pool = new ThreadPool("image_rows", num_threads);
+      shared_pool->StartWorkers();
+    }
+  }
+  return shared_pool;
+}
+
+}  // namespace
+
+void ParallelForRows(ThreadPool* pool, int num_rows, int min_rows_per_band,
+                     const std::function<void(int, int)>& fn) {
+  if (num_rows <= 0) return;
+  const int max_bands = pool ? pool->num_threads() + 1 : 1;
+  const int max_bands_for_rows = num_rows / std::max(1, min_rows_per_band);
+  const int num_bands = std::max(1, std::min(max_bands, max_bands_for_rows));
+  if (num_bands == 1) {
+    fn(0, num_rows);
+    return;
+  }
+
+  // Spread the remainder over the first bands, so sizes differ by at most 1.
+  const int rows_per_band = num_rows / num_bands;
+  const int remainder = num_rows % num_bands;
+  auto band_begin = [rows_per_band, remainder](int band) {
+    return band * rows_per_band + std::min(band, remainder);
+  };
+  absl::BlockingCounter pending(num_bands - 1);
+  for (int band = 1; band < num_bands; ++band) {
+    const int begin = band_begin(band);
+    const int end = band_begin(band + 1);
+    pool->Schedule([&fn, &pending, begin, end] {
+      fn(begin, end);
+      pending.DecrementCount();
+    });
+  }
+  fn(0, band_begin(1));
+  pending.Wait();
+}
+
+void ParallelForRows(int num_rows, int min_rows_per_band,
+                     const std::function<void(int, int)>& fn) {
+  ParallelForRows(GetSharedPool(), num_rows, min_rows_per_band, fn);
+}
+
+bool SetParallelForRowsNumThreads(int num_threads) {
+  absl::MutexLock lock(&shared_pool_mutex);
+  if (shared_pool_created) return false;
+  shared_pool_num_threads = num_threads;
+  return true;
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,50 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Helpers for splitting per-row image processing across threads.
+
+#ifndef MEDIAPIPE_UTIL_PARALLEL_FOR_ROWS_H_
+#define MEDIAPIPE_UTIL_PARALLEL_FOR_ROWS_H_
+
+#include <functional>
+
+#include "mediapipe/framework/port/threadpool.h"
+
+namespace mediapipe {
+
+// Splits the rows [0, num_rows) into contiguous bands of at least
+// min_rows_per_band rows, and calls fn(row_begin, row_end) once per band.
+// The bands run in parallel on the workers of "pool" and on the calling
+// thread, and the call returns once all of them are done. If pool is null,
+// or the image is too small to split, fn(0, num_rows) runs inline.
+//
+// fn must be safe to call concurrently for disjoint bands, and must not call
+// ParallelForRows() on the same pool, since it waits on the pool's workers.
+void ParallelForRows(ThreadPool* pool, int num_rows, int min_rows_per_band,
+                     const std::function<void(int, int)>& fn);
+
+// Same as above, on a thread pool shared by all image calculators in the
+// process. The pool is created on first use.
+void ParallelForRows(int num_rows, int min_rows_per_band,
+                     const std::function<void(int, int)>& fn);
+
+// Sets the number of worker threads of the shared pool. The default of -1
+// uses one worker per CPU core besides the calling thread, and 0 disables
+// the pool so all bands run inline. Only takes effect if called before the
+// first use of the shared pool, and returns false otherwise.
+bool SetParallelForRowsNumThreads(int num_threads);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_PARALLEL_FOR_ROWS_H_
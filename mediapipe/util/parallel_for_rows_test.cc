@@ -0,0 +1,85 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/parallel_for_rows.h"
+
+#include <atomic>
+#include <vector>
+
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/threadpool.h"
+
+namespace mediapipe {
+namespace {
+
+// Runs ParallelForRows and checks that every row is visited exactly once.
+void ExpectAllRowsVisitedOnce(ThreadPool* pool, int num_rows,
+                              int min_rows_per_band, int* num_bands) {
+  std::vector<std::atomic<int>> visits(num_rows);
+  std::atomic<int> bands(0);
+  ParallelForRows(pool, num_rows, min_rows_per_band,
+                  [&](int row_begin, int row_end) {
+                    EXPECT_LT(row_begin, row_end);
+                    for (int row = row_begin; row < row_end; ++row) {
+                      ++visits[row];
+                    }
+                    ++bands;
+                  });
+  for (int row = 0; row < num_rows; ++row) {
+    EXPECT_EQ(1, visits[row].load()) << "row " << row;
+  }
+  *num_bands = bands.load();
+}
+
+TEST(ParallelForRowsTest, SplitsIntoBands) {
+  ThreadPool pool(3);
+  pool.StartWorkers();
+  int num_bands;
+  ExpectAllRowsVisitedOnce(&pool, 1081, 16, &num_bands);
+  // Three workers plus the calling thread.
+  EXPECT_EQ(4, num_bands);
+}
+
+TEST(ParallelForRowsTest, RespectsMinRowsPerBand) {
+  ThreadPool pool(7);
+  pool.StartWorkers();
+  int num_bands;
+  ExpectAllRowsVisitedOnce(&pool, 40, 16, &num_bands);
+  EXPECT_EQ(2, num_bands);
+  ExpectAllRowsVisitedOnce(&pool, 15, 16, &num_bands);
+  EXPECT_EQ(1, num_bands);
+}
+
+TEST(ParallelForRowsTest, RunsInlineWithoutPool) {
+  int num_bands;
+  ExpectAllRowsVisitedOnce(nullptr, 100, 1, &num_bands);
+  EXPECT_EQ(1, num_bands);
+  ExpectAllRowsVisitedOnce(nullptr, 0, 1, &num_bands);
+  EXPECT_EQ(0, num_bands);
+}
+
+TEST(ParallelForRowsTest, SharedPool) {
+  std::vector<std::atomic<int>> visits(500);
+  ParallelForRows(500, 8, [&](int row_begin, int row_end) {
+    for (int row = row_begin; row < row_end; ++row) ++visits[row];
+  });
+  for (int row = 0; row < 500; ++row) {
+    EXPECT_EQ(1, visits[row].load()) << "row " << row;
+  }
+  // The shared pool exists now, so it can no longer be resized.
+  EXPECT_FALSE(SetParallelForRowsNumThreads(2));
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,183 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/polyphase_resampler.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <limits>
+
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/ret_check.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Largest numerator or denominator of the resampling factor, which is also
+// the number of phases in the tap table.
+constexpr int64 kMaxFactor = 2000;
+
+int64 Gcd(int64 a, int64 b) {
+  while (b != 0) {
+    const int64 t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+// Zeroth order modified Bessel function of the first kind.
+double BesselI0(double x) {
+  double sum = 1.0;
+  double term = 1.0;
+  for (int k = 1; k < 50 && term > 1e-12 * sum; ++k) {
+    const double half_x_over_k = x / (2.0 * k);
+    term *= half_x_over_k * half_x_over_k;
+    sum += term;
+  }
+  return sum;
+}
+
+double Sinc(double x) {
+  if (x == 0.0) return 1.0;
+  return sin(M_PI * x) / (M_PI * x);
+}
+
+}  // namespace
+
+::mediapipe::Status PolyphaseResampler::Initialize(double input_sample_rate,
+                                                   double output_sample_rate,
+                                                   int num_channels,
+                                                   double radius, double cutoff,
+                                                   double kaiser_beta) {
+  RET_CHECK(input_sample_rate > 0 && output_sample_rate > 0 &&
+            input_sample_rate == round(input_sample_rate) &&
+            output_sample_rate == round(output_sample_rate))
+      << "Sample rates must be positive integers: " << input_sample_rate
+      << ", " << output_sample_rate;
+  RET_CHECK_GT(num_channels, 0);
+  RET_CHECK_GT(radius, 0.0);
+  RET_CHECK_GT(cutoff, 0.0);
+
+  const int64 input_rate = input_sample_rate;
+  const int64 output_rate = output_sample_rate;
+  const int64 gcd = Gcd(input_rate, output_rate);
+  up_factor_ = output_rate / gcd;
+  down_factor_ = input_rate / gcd;
+  RET_CHECK(up_factor_ <= kMaxFactor && down_factor_ <= kMaxFactor)
+      << "Resampling factor " << up_factor_ << "/" << down_factor_
+      << " is not supported.";
+  num_channels_ = num_channels;
+  half_taps_ = ceil(radius);
+
+  // The kernel is a sinc with its first zero at 1 / (2 * cutoff), in units of
+  // input samples, scaled for unit DC gain and tapered by a Kaiser window.
+  const double normalized_cutoff = 2.0 * cutoff / input_sample_rate;
+  const double window_scale = 1.0 / BesselI0(kaiser_beta);
+  taps_.resize(2 * half_taps_, up_factor_);
+  for (int phase = 0; phase < up_factor_; ++phase) {
+    const double fraction = static_cast<double>(phase) / up_factor_;
+    for (int tap = 0; tap < 2 * half_taps_; ++tap) {
+      // Distance from the output time to the input sample of this tap.
+      const double x = fraction + half_taps_ - 1 - tap;
+      const double r = x / radius;
+      double weight = 0.0;
+      if (r > -1.0 && r < 1.0) {
+        weight = normalized_cutoff * Sinc(normalized_cutoff * x) *
+                 BesselI0(kaiser_beta * sqrt(1.0 - r * r)) * window_scale;
+      }
+      taps_(tap, phase) = weight;
+    }
+  }
+
+  Reset();
+  return ::mediapipe::OkStatus();
+}
+
+void PolyphaseResampler::Reset() {
+  // The samples before the start of the input are zero.
+  buffer_.setZero(num_channels_,
+                  std::max<int64>(2 * half_taps_, buffer_.cols()));
+  buffer_start_ = 1 - half_taps_;
+  buffer_size_ = half_taps_ - 1;
+  num_input_samples_ = 0;
+  num_output_samples_ = 0;
+}
+
+void PolyphaseResampler::AppendSamples(const Matrix& samples) {
+  const int64 needed = buffer_size_ + samples.cols();
+  if (needed > buffer_.cols()) {
+    buffer_.conservativeResize(Eigen::NoChange,
+                               std::max<int64>(2 * buffer_.cols(), needed));
+  }
+  buffer_.middleCols(buffer_size_, samples.cols()) = samples;
+  buffer_size_ = needed;
+}
+
+void PolyphaseResampler::ProcessSamples(const Matrix& input, Matrix* output) {
+  CHECK_EQ(input.rows(), num_channels_);
+  AppendSamples(input);
+  num_input_samples_ += input.cols();
+  EmitOutputs(std::numeric_limits<int64>::max(), output);
+}
+
+void PolyphaseResampler::Flush(Matrix* output) {
+  // Pad with enough zeros to complete every output sample that lies within
+  // the input, like audio_dsp::Resampler::Flush().
+  AppendSamples(Matrix::Zero(num_channels_, half_taps_));
+  const int64 total_output_samples =
+      (num_input_samples_ * up_factor_ + down_factor_ - 1) / down_factor_;
+  EmitOutputs(total_output_samples, output);
+  Reset();
+}
+
+void PolyphaseResampler::EmitOutputs(int64 max_output_samples,
+                                     Matrix* output) {
+  // Output n needs input samples up to floor(n * down / up) + half_taps_.
+  const int64 last_full_input = buffer_start_ + buffer_size_ - half_taps_;
+  int64 end = 0;
+  if (last_full_input > 0) {
+    end = (last_full_input * up_factor_ + down_factor_ - 1) / down_factor_;
+  }
+  end = std::min(end, max_output_samples);
+  const int64 num_samples = std::max<int64>(0, end - num_output_samples_);
+
+  output->resize(num_channels_, num_samples);
+  for (int64 k = 0; k < num_samples; ++k) {
+    const int64 position = (num_output_samples_ + k) * down_factor_;
+    const int64 input_index = position / up_factor_;
+    const int phase = position % up_factor_;
+    output->col(k).noalias() =
+        buffer_.middleCols(input_index - half_taps_ + 1 - buffer_start_,
+                           2 * half_taps_) *
+        taps_.col(phase);
+  }
+  num_output_samples_ += num_samples;
+
+  // Drop the samples that no later output needs.
+  const int64 next_input_index =
+      num_output_samples_ * down_factor_ / up_factor_;
+  const int64 num_dropped = std::min(
+      buffer_size_, next_input_index - half_taps_ + 1 - buffer_start_);
+  if (num_dropped > 0) {
+    buffer_size_ -= num_dropped;
+    buffer_.leftCols(buffer_size_) =
+        buffer_.middleCols(num_dropped, buffer_size_).eval();
+    buffer_start_ += num_dropped;
+  }
+}
+
+}  // namespace mediapipe
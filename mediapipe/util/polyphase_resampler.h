@@ -0,0 +1,105 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Multichannel polyphase resampling of time series matrices.
+
+#ifndef MEDIAPIPE_UTIL_POLYPHASE_RESAMPLER_H_
+#define MEDIAPIPE_UTIL_POLYPHASE_RESAMPLER_H_
+
+#include "Eigen/Core"
+#include "mediapipe/framework/formats/matrix.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/status.h"
+
+namespace mediapipe {
+
+// Resamples all channels of a time series by a rational factor with a Kaiser
+// windowed sinc kernel, using a precomputed table of filter taps per output
+// phase.
+//
+// Samples are buffered as a channels x samples Matrix, i.e. interleaved by
+// channel, so each output sample is a single matrix-vector product of the
+// buffered input window with the taps of its phase, which Eigen vectorizes
+// across channels and taps.
+//
+// Like audio_dsp::RationalFactorResampler, the input is treated as starting
+// and (after Flush()) ending with zeros, and output sample n is aligned with
+// input time n * input_rate / output_rate.
+//
+// Example:
+//   PolyphaseResampler resampler;
+//   MP_RETURN_IF_ERROR(resampler.Initialize(44100, 16000, 2, radius, cutoff,
+//                                           6.0));
+//   Matrix output;
+//   resampler.ProcessSamples(input, &output);
+//   ...
+//   resampler.Flush(&output);
+class PolyphaseResampler {
+ public:
+  PolyphaseResampler() = default;
+
+  // Sets up the resampler. The sample rates must be positive integers, and
+  // their ratio in lowest terms must have a numerator and denominator of at
+  // most 2000. "radius" is the kernel radius in input samples, "cutoff" the
+  // anti-aliasing cutoff in Hertz, and "kaiser_beta" the Kaiser window
+  // parameter.
+  ::mediapipe::Status Initialize(double input_sample_rate,
+                                 double output_sample_rate, int num_channels,
+                                 double radius, double cutoff,
+                                 double kaiser_beta);
+
+  // Resamples "input" (num_channels x samples), continuing from the samples
+  // of earlier calls, and writes the output samples that are now complete to
+  // "output".
+  void ProcessSamples(const Matrix& input, Matrix* output);
+
+  // Writes the remaining output samples, as if the input ended here, and
+  // resets the resampler for a new stream.
+  void Flush(Matrix* output);
+
+  // Number of input samples that must follow an output sample's position
+  // before ProcessSamples() can emit it.
+  int latency_input_samples() const { return half_taps_; }
+
+ private:
+  // Appends "samples" to the end of buffer_.
+  void AppendSamples(const Matrix& samples);
+
+  // Writes all outputs whose taps end before the end of the buffer, up to
+  // max_output_samples, and drops the input samples they no longer need.
+  void EmitOutputs(int64 max_output_samples, Matrix* output);
+
+  void Reset();
+
+  int num_channels_ = 0;
+  // Output rate / input rate in lowest terms.
+  int64 up_factor_ = 1;
+  int64 down_factor_ = 1;
+  // Each output sample uses input samples [i - half_taps_ + 1, i + half_taps_]
+  // where i is the input sample at or before it.
+  int half_taps_ = 0;
+  // Column p holds the 2 * half_taps_ taps of phase p, oldest sample first.
+  Matrix taps_;
+
+  // Buffered input, with column 0 holding input sample buffer_start_.
+  Matrix buffer_;
+  int64 buffer_start_ = 0;
+  int64 buffer_size_ = 0;
+  int64 num_input_samples_ = 0;
+  int64 num_output_samples_ = 0;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_POLYPHASE_RESAMPLER_H_
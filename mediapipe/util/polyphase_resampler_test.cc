@@ -0,0 +1,127 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/polyphase_resampler.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "Eigen/Core"
+#include "mediapipe/framework/formats/matrix.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr double kInputRate = 44100.0;
+constexpr double kOutputRate = 16000.0;
+
+::mediapipe::Status InitializeDownsampler(int num_channels,
+                                          PolyphaseResampler* resampler) {
+  return resampler->Initialize(kInputRate, kOutputRate, num_channels,
+                               17.0 * kInputRate / kOutputRate,
+                               0.45 * kOutputRate, 6.0);
+}
+
+// Appends the columns of "more" to "all".
+void AppendColumns(const Matrix& more, Matrix* all) {
+  all->conservativeResize(more.rows(), all->cols() + more.cols());
+  all->rightCols(more.cols()) = more;
+}
+
+// Resamples "input" in packets of packet_size samples, then flushes.
+Matrix Resample(PolyphaseResampler* resampler, const Matrix& input,
+                int packet_size) {
+  Matrix all(input.rows(), 0);
+  Matrix output;
+  for (int start = 0; start < input.cols(); start += packet_size) {
+    const int size = std::min<int>(packet_size, input.cols() - start);
+    resampler->ProcessSamples(input.middleCols(start, size), &output);
+    AppendColumns(output, &all);
+  }
+  resampler->Flush(&output);
+  AppendColumns(output, &all);
+  return all;
+}
+
+TEST(PolyphaseResamplerTest, PreservesToneAndDc) {
+  const int num_samples = kInputRate;
+  Matrix input(2, num_samples);
+  for (int i = 0; i < num_samples; ++i) {
+    input(0, i) = sin(2 * M_PI * 1000.0 * i / kInputRate);
+    input(1, i) = 0.5;
+  }
+  PolyphaseResampler resampler;
+  MP_ASSERT_OK(InitializeDownsampler(2, &resampler));
+  const Matrix output = Resample(&resampler, input, 1000);
+
+  ASSERT_EQ(kOutputRate, output.cols());
+  // Away from the zero padded ends, the output samples the same signals.
+  const int margin = 100;
+  for (int n = margin; n < output.cols() - margin; ++n) {
+    EXPECT_NEAR(sin(2 * M_PI * 1000.0 * n / kOutputRate), output(0, n), 1e-3);
+    EXPECT_NEAR(0.5, output(1, n), 1e-3);
+  }
+}
+
+TEST(PolyphaseResamplerTest, OutputDoesNotDependOnPacketSize) {
+  const Matrix input = Matrix::Random(3, 5000);
+  PolyphaseResampler resampler;
+  MP_ASSERT_OK(InitializeDownsampler(3, &resampler));
+  const Matrix expected = Resample(&resampler, input, input.cols());
+  // Flush() resets the resampler, so it can be reused.
+  for (int packet_size : {1, 7, 441, 1024}) {
+    const Matrix output = Resample(&resampler, input, packet_size);
+    ASSERT_EQ(expected.cols(), output.cols());
+    EXPECT_TRUE(output.isApprox(expected)) << packet_size;
+  }
+}
+
+TEST(PolyphaseResamplerTest, ChannelsAreIndependent) {
+  const Matrix input = Matrix::Random(2, 3000);
+  PolyphaseResampler stereo;
+  MP_ASSERT_OK(InitializeDownsampler(2, &stereo));
+  const Matrix output = Resample(&stereo, input, 512);
+  for (int channel = 0; channel < 2; ++channel) {
+    PolyphaseResampler mono;
+    MP_ASSERT_OK(InitializeDownsampler(1, &mono));
+    EXPECT_TRUE(Resample(&mono, input.row(channel), 512)
+                    .isApprox(output.row(channel)));
+  }
+}
+
+TEST(PolyphaseResamplerTest, RejectsUnsupportedRates) {
+  PolyphaseResampler resampler;
+  EXPECT_FALSE(resampler.Initialize(44100.5, 16000, 1, 5, 7000, 6).ok());
+  EXPECT_FALSE(resampler.Initialize(44100, 16001, 1, 5, 7000, 6).ok());
+}
+
+void BM_Downsample(benchmark::State& state) {
+  const int num_channels = state.range(0);
+  const Matrix input = Matrix::Random(num_channels, kInputRate / 10);
+  PolyphaseResampler resampler;
+  CHECK(InitializeDownsampler(num_channels, &resampler).ok());
+  Matrix output;
+  for (auto _ : state) {
+    resampler.ProcessSamples(input, &output);
+  }
+}
+BENCHMARK(BM_Downsample)->Arg(1)->Arg(2)->Arg(8);
+
+}  // namespace
+}  // namespace mediapipe
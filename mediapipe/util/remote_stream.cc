@@ -0,0 +1,466 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/remote_stream.h"
+
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/opencv_imgcodecs_inc.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "The remote stream wire format assumes a little-endian host."
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#ifndef MSG_MORE
+#define MSG_MORE 0
+#endif
+
+namespace mediapipe {
+namespace {
+
+// The kinds of packet payloads in a serialized batch.
+enum PayloadKind : uint8 {
+  kString = 0,
+  kRawImage = 1,
+  kPngImage = 2,
+  kJpegImage = 3,
+};
+
+// A message is a 4-byte payload size, a MessageType byte and the payload.
+constexpr size_t kMessageHeaderSize = 5;
+// The largest payload accepted, to fail fast on a peer speaking another
+// protocol.
+constexpr uint32 kMaxMessageSize = 1 << 30;
+
+constexpr absl::Duration kConnectRetryInterval = absl::Milliseconds(100);
+
+constexpr char kTruncatedBatch[] = "Truncated remote stream batch.";
+
+template <typename T>
+void Append(T value, std::string* output) {
+  output->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Reads the fields of a serialized batch, checking that they are there.
+class BatchReader {
+ public:
+  explicit BatchReader(absl::string_view input) : input_(input) {}
+
+  template <typename T>
+  bool Read(T* value) {
+    if (input_.size() < sizeof(T)) {
+      return false;
+    }
+    memcpy(value, input_.data(), sizeof(T));
+    input_.remove_prefix(sizeof(T));
+    return true;
+  }
+
+  // Reads a size-prefixed byte string.
+  bool ReadBytes(absl::string_view* bytes) {
+    uint32 size;
+    if (!Read(&size) || input_.size() < size) {
+      return false;
+    }
+    *bytes = input_.substr(0, size);
+    input_.remove_prefix(size);
+    return true;
+  }
+
+  bool empty() const { return input_.empty(); }
+
+ private:
+  absl::string_view input_;
+};
+
+bool CanCompress(ImageFormat::Format format,
+                 RemoteStreamImageEncoding::Codec codec) {
+  switch (codec) {
+    case RemoteStreamImageEncoding::RAW:
+      return false;
+    case RemoteStreamImageEncoding::PNG:
+      return format == ImageFormat::SRGB || format == ImageFormat::SRGBA ||
+             format == ImageFormat::GRAY8;
+    case RemoteStreamImageEncoding::JPEG:
+      // JPEG has no alpha channel.
+      return format == ImageFormat::SRGB || format == ImageFormat::GRAY8;
+  }
+  return false;
+}
+
+int RowSize(const ImageFrame& frame) {
+  return frame.Width() * frame.NumberOfChannels() * frame.ByteDepth();
+}
+
+::mediapipe::Status AppendImageFrame(const ImageFrame& frame,
+                                     const RemoteStreamImageEncoding& encoding,
+                                     std::string* output) {
+  const bool compress = CanCompress(frame.Format(), encoding.codec);
+  if (!compress) {
+    Append<uint8>(kRawImage, output);
+  } else if (encoding.codec == RemoteStreamImageEncoding::PNG) {
+    Append<uint8>(kPngImage, output);
+  } else {
+    Append<uint8>(kJpegImage, output);
+  }
+  Append<int32>(frame.Format(), output);
+  Append<int32>(frame.Width(), output);
+  Append<int32>(frame.Height(), output);
+
+  if (!compress) {
+    // The rows are sent without their padding.
+    const int row_size = RowSize(frame);
+    Append<uint32>(row_size * frame.Height(), output);
+    for (int y = 0; y < frame.Height(); ++y) {
+      output->append(reinterpret_cast<const char*>(frame.PixelData() +
+                                                   y * frame.WidthStep()),
+                     row_size);
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  // OpenCV encodes BGR images.
+  cv::Mat image = formats::MatView(&frame);
+  cv::Mat bgr_image;
+  if (frame.Format() == ImageFormat::SRGB) {
+    cv::cvtColor(image, bgr_image, cv::COLOR_RGB2BGR);
+  } else if (frame.Format() == ImageFormat::SRGBA) {
+    cv::cvtColor(image, bgr_image, cv::COLOR_RGBA2BGRA);
+  } else {
+    bgr_image = image;
+  }
+  std::vector<uchar> encoded;
+  std::vector<int> params;
+  if (encoding.codec == RemoteStreamImageEncoding::JPEG) {
+    params = {cv::IMWRITE_JPEG_QUALITY, encoding.jpeg_quality};
+  }
+  RET_CHECK(cv::imencode(
+      encoding.codec == RemoteStreamImageEncoding::JPEG ? ".jpg" : ".png",
+      bgr_image, encoded, params))
+      << "Could not encode " << frame.Width() << "x" << frame.Height()
+      << " image.";
+  Append<uint32>(encoded.size(), output);
+  output->append(reinterpret_cast<const char*>(encoded.data()),
+                 encoded.size());
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::StatusOr<std::unique_ptr<ImageFrame>> ParseImageFrame(
+    PayloadKind kind, BatchReader* reader) {
+  int32 format;
+  int32 width;
+  int32 height;
+  absl::string_view bytes;
+  RET_CHECK(reader->Read(&format) && reader->Read(&width) &&
+            reader->Read(&height) && reader->ReadBytes(&bytes))
+      << kTruncatedBatch;
+  RET_CHECK(ImageFormat::Format_IsValid(format) &&
+            format != ImageFormat::UNKNOWN && width > 0 && height > 0)
+      << "Invalid image in remote stream batch.";
+  const auto image_format = static_cast<ImageFormat::Format>(format);
+
+  if (kind == kRawImage) {
+    const int row_size = width *
+                         ImageFrame::NumberOfChannelsForFormat(image_format) *
+                         ImageFrame::ByteDepthForFormat(image_format);
+    RET_CHECK_EQ(bytes.size(), static_cast<size_t>(row_size) * height)
+        << "Invalid image in remote stream batch.";
+    auto frame = absl::make_unique<ImageFrame>(image_format, width, height);
+    for (int y = 0; y < height; ++y) {
+      memcpy(frame->MutablePixelData() + y * frame->WidthStep(),
+             bytes.data() + y * row_size, row_size);
+    }
+    return std::move(frame);
+  }
+
+  const cv::Mat encoded(1, bytes.size(), CV_8U,
+                        const_cast<char*>(bytes.data()));
+  const cv::Mat decoded = cv::imdecode(encoded, cv::IMREAD_UNCHANGED);
+  RET_CHECK(!decoded.empty() && decoded.cols == width &&
+            decoded.rows == height && decoded.depth() == CV_8U &&
+            decoded.channels() ==
+                ImageFrame::NumberOfChannelsForFormat(image_format))
+      << "Could not decode image in remote stream batch.";
+  auto frame = absl::make_unique<ImageFrame>(image_format, width, height);
+  cv::Mat output = formats::MatView(frame.get());
+  if (image_format == ImageFormat::SRGB) {
+    cv::cvtColor(decoded, output, cv::COLOR_BGR2RGB);
+  } else if (image_format == ImageFormat::SRGBA) {
+    cv::cvtColor(decoded, output, cv::COLOR_BGRA2RGBA);
+  } else {
+    decoded.copyTo(output);
+  }
+  return std::move(frame);
+}
+
+// Sets the options of a connected socket.
+void ConfigureConnection(int fd) {
+  // Batches are sent whole, so they need not wait for more data.
+  int enable = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+#if defined(SO_NOSIGPIPE)
+  setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif
+}
+
+// Returns true once "fd" is readable, or false after "timeout".
+bool WaitReadable(int fd, absl::Duration timeout) {
+  pollfd poll_fd;
+  poll_fd.fd = fd;
+  poll_fd.events = POLLIN;
+  poll_fd.revents = 0;
+  const int64 timeout_ms =
+      absl::ToInt64Milliseconds(absl::Ceil(timeout, absl::Milliseconds(1)));
+  return poll(&poll_fd, 1, static_cast<int>(timeout_ms)) > 0;
+}
+
+::mediapipe::Status SendAll(int fd, const char* data, size_t size,
+                            int flags) {
+  while (size > 0) {
+    const ssize_t sent = send(fd, data, size, flags | MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return ::mediapipe::UnavailableError(
+          absl::StrCat("remote stream send failed: ", strerror(errno)));
+    }
+    data += sent;
+    size -= sent;
+  }
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status ReceiveAll(int fd, char* data, size_t size) {
+  while (size > 0) {
+    const ssize_t received = recv(fd, data, size, 0);
+    if (received == 0) {
+      return ::mediapipe::UnavailableError(
+          "remote stream connection closed by peer");
+    }
+    if (received < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return ::mediapipe::UnavailableError(
+          absl::StrCat("remote stream receive failed: ", strerror(errno)));
+    }
+    data += received;
+    size -= received;
+  }
+  return ::mediapipe::OkStatus();
+}
+
+}  // namespace
+
+::mediapipe::Status SerializeRemoteStreamBatch(
+    const RemoteStreamBatch& batch, const RemoteStreamImageEncoding& encoding,
+    std::string* output) {
+  output->clear();
+  Append<int64>(batch.next_timestamp_bound.Value(), output);
+  Append<uint32>(batch.packets.size(), output);
+  for (const auto& stream_and_packet : batch.packets) {
+    const Packet& packet = stream_and_packet.second;
+    Append<uint32>(stream_and_packet.first, output);
+    Append<int64>(packet.Timestamp().Value(), output);
+    if (packet.ValidateAsType<ImageFrame>().ok()) {
+      MP_RETURN_IF_ERROR(
+          AppendImageFrame(packet.Get<ImageFrame>(), encoding, output));
+    } else {
+      MP_RETURN_IF_ERROR(packet.ValidateAsType<std::string>());
+      const std::string& data = packet.Get<std::string>();
+      Append<uint8>(kString, output);
+      Append<uint32>(data.size(), output);
+      output->append(data);
+    }
+  }
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status ParseRemoteStreamBatch(absl::string_view input,
+                                           RemoteStreamBatch* batch) {
+  BatchReader reader(input);
+  int64 next_timestamp_bound;
+  uint32 num_packets;
+  RET_CHECK(reader.Read(&next_timestamp_bound) && reader.Read(&num_packets))
+      << kTruncatedBatch;
+  batch->next_timestamp_bound =
+      Timestamp::CreateNoErrorChecking(next_timestamp_bound);
+  batch->packets.clear();
+  for (uint32 i = 0; i < num_packets; ++i) {
+    uint32 stream;
+    int64 timestamp;
+    uint8 kind;
+    RET_CHECK(reader.Read(&stream) && reader.Read(&timestamp) &&
+              reader.Read(&kind))
+        << kTruncatedBatch;
+    Packet packet;
+    if (kind == kString) {
+      absl::string_view bytes;
+      RET_CHECK(reader.ReadBytes(&bytes)) << kTruncatedBatch;
+      packet = MakePacket<std::string>(std::string(bytes));
+    } else {
+      RET_CHECK(kind == kRawImage || kind == kPngImage || kind == kJpegImage)
+          << "Unknown payload kind " << static_cast<int>(kind)
+          << " in remote stream batch.";
+      ASSIGN_OR_RETURN(std::unique_ptr<ImageFrame> frame,
+                       ParseImageFrame(static_cast<PayloadKind>(kind),
+                                       &reader));
+      packet = Adopt(frame.release());
+    }
+    batch->packets.emplace_back(
+        stream, packet.At(Timestamp::CreateNoErrorChecking(timestamp)));
+  }
+  RET_CHECK(reader.empty()) << "Trailing data in remote stream batch.";
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::StatusOr<std::unique_ptr<RemoteStreamConnection>>
+RemoteStreamConnection::Connect(const std::string& host, int port,
+                                absl::Duration timeout) {
+  addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* addresses = nullptr;
+  const int resolve_error = getaddrinfo(
+      host.c_str(), std::to_string(port).c_str(), &hints, &addresses);
+  if (resolve_error != 0) {
+    return ::mediapipe::UnavailableError(absl::StrCat(
+        "could not resolve ", host, ": ", gai_strerror(resolve_error)));
+  }
+  std::unique_ptr<addrinfo, void (*)(addrinfo*)> addresses_owner(
+      addresses, freeaddrinfo);
+
+  const absl::Time deadline = absl::Now() + timeout;
+  while (true) {
+    int connect_error = 0;
+    for (const addrinfo* address = addresses; address;
+         address = address->ai_next) {
+      const int fd = socket(address->ai_family, address->ai_socktype,
+                            address->ai_protocol);
+      if (fd < 0) {
+        connect_error = errno;
+        continue;
+      }
+      if (connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+        ConfigureConnection(fd);
+        return absl::make_unique<RemoteStreamConnection>(fd);
+      }
+      connect_error = errno;
+      close(fd);
+    }
+    if (absl::Now() >= deadline) {
+      return ::mediapipe::UnavailableError(
+          absl::StrCat("could not connect to ", host, ":", port, ": ",
+                       strerror(connect_error)));
+    }
+    absl::SleepFor(kConnectRetryInterval);
+  }
+}
+
+RemoteStreamConnection::RemoteStreamConnection(int fd) : fd_(fd) {}
+
+RemoteStreamConnection::~RemoteStreamConnection() { close(fd_); }
+
+::mediapipe::Status RemoteStreamConnection::Send(MessageType type,
+                                                 absl::string_view payload) {
+  RET_CHECK_LE(payload.size(), kMaxMessageSize);
+  char header[kMessageHeaderSize];
+  const uint32 size = payload.size();
+  memcpy(header, &size, sizeof(size));
+  header[sizeof(size)] = type;
+  // Lets the header go out in the same segment as the payload.
+  MP_RETURN_IF_ERROR(SendAll(fd_, header, sizeof(header), MSG_MORE));
+  return SendAll(fd_, payload.data(), payload.size(), 0);
+}
+
+::mediapipe::StatusOr<bool> RemoteStreamConnection::Receive(
+    absl::Duration timeout, MessageType* type, std::string* payload) {
+  if (!WaitReadable(fd_, timeout)) {
+    return false;
+  }
+  char header[kMessageHeaderSize];
+  MP_RETURN_IF_ERROR(ReceiveAll(fd_, header, sizeof(header)));
+  uint32 size;
+  memcpy(&size, header, sizeof(size));
+  RET_CHECK_LE(size, kMaxMessageSize)
+      << "Invalid remote stream message header.";
+  *type = static_cast<MessageType>(header[sizeof(size)]);
+  payload->resize(size);
+  MP_RETURN_IF_ERROR(ReceiveAll(fd_, &(*payload)[0], size));
+  return true;
+}
+
+::mediapipe::StatusOr<std::unique_ptr<RemoteStreamListener>>
+RemoteStreamListener::Listen(int port) {
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  RET_CHECK_GE(fd, 0) << "could not create socket: " << strerror(errno);
+  int enable = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+  sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+  socklen_t address_size = sizeof(address);
+  if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+      listen(fd, /*backlog=*/1) != 0 ||
+      getsockname(fd, reinterpret_cast<sockaddr*>(&address), &address_size) !=
+          0) {
+    const std::string error = strerror(errno);
+    close(fd);
+    return ::mediapipe::UnavailableError(
+        absl::StrCat("could not listen on port ", port, ": ", error));
+  }
+  return absl::WrapUnique(
+      new RemoteStreamListener(fd, ntohs(address.sin_port)));
+}
+
+RemoteStreamListener::~RemoteStreamListener() { close(fd_); }
+
+::mediapipe::StatusOr<std::unique_ptr<RemoteStreamConnection>>
+RemoteStreamListener::Accept(absl::Duration timeout) {
+  if (!WaitReadable(fd_, timeout)) {
+    return std::unique_ptr<RemoteStreamConnection>();
+  }
+  const int fd = accept(fd_, nullptr, nullptr);
+  RET_CHECK_GE(fd, 0) << "could not accept connection: " << strerror(errno);
+  ConfigureConnection(fd);
+  return absl::make_unique<RemoteStreamConnection>(fd);
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,131 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// The wire format and TCP transport of the remote stream calculators, which
+// bridge streams between graphs on different hosts.
+
+#ifndef MEDIAPIPE_UTIL_REMOTE_STREAM_H_
+#define MEDIAPIPE_UTIL_REMOTE_STREAM_H_
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mediapipe/framework/timestamp.h"
+
+namespace mediapipe {
+
+// A batch of packets of one or more streams, sent as one message.
+struct RemoteStreamBatch {
+  // The packets in timestamp order, each with the index of its stream. The
+  // packets hold an ImageFrame or a std::string.
+  std::vector<std::pair<int, Packet>> packets;
+  // The timestamp bound of every stream once the batch has been received.
+  Timestamp next_timestamp_bound = Timestamp::Unset();
+};
+
+// How ImageFrame packets are compressed. SRGB, SRGBA and GRAY8 frames can be
+// compressed, other formats are always sent raw.
+struct RemoteStreamImageEncoding {
+  enum Codec { RAW, PNG, JPEG };
+  Codec codec = RAW;
+  // The JPEG quality, from 0 to 100.
+  int jpeg_quality = 90;
+};
+
+// Serializes "batch" into "output", compressing its ImageFrames as
+// requested.
+::mediapipe::Status SerializeRemoteStreamBatch(
+    const RemoteStreamBatch& batch, const RemoteStreamImageEncoding& encoding,
+    std::string* output);
+
+// Parses a batch serialized by SerializeRemoteStreamBatch.
+::mediapipe::Status ParseRemoteStreamBatch(absl::string_view input,
+                                           RemoteStreamBatch* batch);
+
+// A TCP connection carrying remote stream messages. Messages are sent
+// without authentication or encryption, so connections should only cross
+// trusted networks.
+class RemoteStreamConnection {
+ public:
+  enum MessageType : uint8 {
+    // A serialized RemoteStreamBatch.
+    kBatch = 1,
+    // The sender is done, with an empty payload.
+    kEnd = 2,
+  };
+
+  // Connects to "host" on "port", retrying until "timeout" while the host
+  // refuses the connection, so that the receiver may start later.
+  static ::mediapipe::StatusOr<std::unique_ptr<RemoteStreamConnection>>
+  Connect(const std::string& host, int port, absl::Duration timeout);
+
+  // Takes ownership of the connected socket "fd".
+  explicit RemoteStreamConnection(int fd);
+  ~RemoteStreamConnection();
+
+  RemoteStreamConnection(const RemoteStreamConnection&) = delete;
+  RemoteStreamConnection& operator=(const RemoteStreamConnection&) = delete;
+
+  // Sends a message.
+  ::mediapipe::Status Send(MessageType type, absl::string_view payload);
+
+  // Receives the next message, waiting up to "timeout" for it to arrive.
+  // Returns false if none did. Fails with kUnavailable if the peer closed
+  // the connection.
+  ::mediapipe::StatusOr<bool> Receive(absl::Duration timeout,
+                                      MessageType* type, std::string* payload);
+
+ private:
+  const int fd_;
+};
+
+// Listens for remote stream connections on a TCP port of every IPv4
+// interface.
+class RemoteStreamListener {
+ public:
+  // Listens on "port", or on a free port if 0.
+  static ::mediapipe::StatusOr<std::unique_ptr<RemoteStreamListener>> Listen(
+      int port);
+
+  ~RemoteStreamListener();
+
+  RemoteStreamListener(const RemoteStreamListener&) = delete;
+  RemoteStreamListener& operator=(const RemoteStreamListener&) = delete;
+
+  // The port listened on.
+  int port() const { return port_; }
+
+  // Accepts a connection, waiting up to "timeout" for one. Returns null if
+  // none arrived.
+  ::mediapipe::StatusOr<std::unique_ptr<RemoteStreamConnection>> Accept(
+      absl::Duration timeout);
+
+ private:
+  RemoteStreamListener(int fd, int port) : fd_(fd), port_(port) {}
+
+  const int fd_;
+  const int port_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_REMOTE_STREAM_H_
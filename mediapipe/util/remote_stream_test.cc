@@ -0,0 +1,189 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/remote_stream.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kWidth = 32;
+constexpr int kHeight = 24;
+
+// A smooth image, which JPEG can reproduce closely.
+Packet MakeImagePacket(ImageFormat::Format format, Timestamp timestamp) {
+  auto frame = absl::make_unique<ImageFrame>(format, kWidth, kHeight);
+  const int channels = frame->NumberOfChannels();
+  for (int y = 0; y < kHeight; ++y) {
+    uint8* row = frame->MutablePixelData() + y * frame->WidthStep();
+    for (int x = 0; x < kWidth * channels; ++x) {
+      row[x] = 4 * y + x / channels;
+    }
+  }
+  return Adopt(frame.release()).At(timestamp);
+}
+
+// Returns the largest difference between two images' pixel values.
+int MaxDifference(const ImageFrame& a, const ImageFrame& b) {
+  int max_difference = 0;
+  for (int y = 0; y < a.Height(); ++y) {
+    const uint8* row_a = a.PixelData() + y * a.WidthStep();
+    const uint8* row_b = b.PixelData() + y * b.WidthStep();
+    for (int x = 0; x < a.Width() * a.NumberOfChannels(); ++x) {
+      max_difference = std::max(max_difference, std::abs(row_a[x] - row_b[x]));
+    }
+  }
+  return max_difference;
+}
+
+RemoteStreamBatch RoundTrip(const RemoteStreamBatch& batch,
+                            RemoteStreamImageEncoding::Codec codec) {
+  RemoteStreamImageEncoding encoding;
+  encoding.codec = codec;
+  std::string serialized;
+  MP_EXPECT_OK(SerializeRemoteStreamBatch(batch, encoding, &serialized));
+  RemoteStreamBatch parsed;
+  MP_EXPECT_OK(ParseRemoteStreamBatch(serialized, &parsed));
+  return parsed;
+}
+
+void ExpectImagesNear(const RemoteStreamBatch& expected,
+                      const RemoteStreamBatch& actual, int max_difference) {
+  ASSERT_EQ(expected.packets.size(), actual.packets.size());
+  EXPECT_EQ(expected.next_timestamp_bound, actual.next_timestamp_bound);
+  for (int i = 0; i < expected.packets.size(); ++i) {
+    const Packet& expected_packet = expected.packets[i].second;
+    const Packet& actual_packet = actual.packets[i].second;
+    EXPECT_EQ(expected.packets[i].first, actual.packets[i].first);
+    EXPECT_EQ(expected_packet.Timestamp(), actual_packet.Timestamp());
+    const ImageFrame& expected_frame = expected_packet.Get<ImageFrame>();
+    const ImageFrame& actual_frame = actual_packet.Get<ImageFrame>();
+    ASSERT_EQ(expected_frame.Format(), actual_frame.Format());
+    ASSERT_EQ(expected_frame.Width(), actual_frame.Width());
+    ASSERT_EQ(expected_frame.Height(), actual_frame.Height());
+    EXPECT_LE(MaxDifference(expected_frame, actual_frame), max_difference);
+  }
+}
+
+RemoteStreamBatch MakeImageBatch() {
+  RemoteStreamBatch batch;
+  batch.packets.emplace_back(
+      0, MakeImagePacket(ImageFormat::SRGB, Timestamp(10)));
+  batch.packets.emplace_back(
+      1, MakeImagePacket(ImageFormat::SRGBA, Timestamp(10)));
+  batch.packets.emplace_back(
+      0, MakeImagePacket(ImageFormat::GRAY8, Timestamp(20)));
+  batch.next_timestamp_bound = Timestamp(21);
+  return batch;
+}
+
+TEST(RemoteStreamTest, RoundTripsRawImages) {
+  const RemoteStreamBatch batch = MakeImageBatch();
+  ExpectImagesNear(batch, RoundTrip(batch, RemoteStreamImageEncoding::RAW),
+                   0);
+}
+
+TEST(RemoteStreamTest, RoundTripsPngImages) {
+  const RemoteStreamBatch batch = MakeImageBatch();
+  ExpectImagesNear(batch, RoundTrip(batch, RemoteStreamImageEncoding::PNG),
+                   0);
+}
+
+TEST(RemoteStreamTest, RoundTripsJpegImagesApproximately) {
+  // The SRGBA image is sent raw, since JPEG has no alpha channel.
+  const RemoteStreamBatch batch = MakeImageBatch();
+  ExpectImagesNear(batch, RoundTrip(batch, RemoteStreamImageEncoding::JPEG),
+                   8);
+}
+
+TEST(RemoteStreamTest, RoundTripsStrings) {
+  RemoteStreamBatch batch;
+  batch.packets.emplace_back(
+      2, MakePacket<std::string>("first").At(Timestamp(5)));
+  batch.packets.emplace_back(
+      2, MakePacket<std::string>(std::string("\0second", 7)).At(Timestamp(6)));
+  batch.next_timestamp_bound = Timestamp::Done();
+
+  const RemoteStreamBatch parsed =
+      RoundTrip(batch, RemoteStreamImageEncoding::RAW);
+  ASSERT_EQ(2, parsed.packets.size());
+  EXPECT_EQ(2, parsed.packets[1].first);
+  EXPECT_EQ(Timestamp(6), parsed.packets[1].second.Timestamp());
+  EXPECT_EQ(std::string("\0second", 7),
+            parsed.packets[1].second.Get<std::string>());
+  EXPECT_EQ(Timestamp::Done(), parsed.next_timestamp_bound);
+}
+
+TEST(RemoteStreamTest, RejectsTruncatedBatch) {
+  std::string serialized;
+  MP_ASSERT_OK(SerializeRemoteStreamBatch(
+      MakeImageBatch(), RemoteStreamImageEncoding(), &serialized));
+  serialized.resize(serialized.size() - 1);
+  RemoteStreamBatch parsed;
+  EXPECT_FALSE(ParseRemoteStreamBatch(serialized, &parsed).ok());
+}
+
+TEST(RemoteStreamTest, SendsMessagesOverLoopback) {
+  auto listener_or = RemoteStreamListener::Listen(0);
+  MP_ASSERT_OK(listener_or.status());
+  std::unique_ptr<RemoteStreamListener> listener =
+      std::move(listener_or.ValueOrDie());
+
+  auto sender_or = RemoteStreamConnection::Connect(
+      "localhost", listener->port(), absl::Seconds(10));
+  MP_ASSERT_OK(sender_or.status());
+  std::unique_ptr<RemoteStreamConnection> sender =
+      std::move(sender_or.ValueOrDie());
+  auto receiver_or = listener->Accept(absl::Seconds(10));
+  MP_ASSERT_OK(receiver_or.status());
+  std::unique_ptr<RemoteStreamConnection> receiver =
+      std::move(receiver_or.ValueOrDie());
+  ASSERT_TRUE(receiver);
+
+  RemoteStreamConnection::MessageType type;
+  std::string payload;
+  auto received_or = receiver->Receive(absl::ZeroDuration(), &type, &payload);
+  MP_ASSERT_OK(received_or.status());
+  EXPECT_FALSE(received_or.ValueOrDie());
+
+  MP_ASSERT_OK(sender->Send(RemoteStreamConnection::kBatch, "payload"));
+  MP_ASSERT_OK(sender->Send(RemoteStreamConnection::kEnd, ""));
+  received_or = receiver->Receive(absl::Seconds(10), &type, &payload);
+  MP_ASSERT_OK(received_or.status());
+  ASSERT_TRUE(received_or.ValueOrDie());
+  EXPECT_EQ(RemoteStreamConnection::kBatch, type);
+  EXPECT_EQ("payload", payload);
+  received_or = receiver->Receive(absl::Seconds(10), &type, &payload);
+  MP_ASSERT_OK(received_or.status());
+  ASSERT_TRUE(received_or.ValueOrDie());
+  EXPECT_EQ(RemoteStreamConnection::kEnd, type);
+  EXPECT_TRUE(payload.empty());
+
+  sender.reset();
+  received_or = receiver->Receive(absl::Seconds(10), &type, &payload);
+  EXPECT_EQ(::mediapipe::StatusCode::kUnavailable,
+            received_or.status().code());
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,75 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/util/resource_util.h"
+
+namespace mediapipe {
+namespace internal {
+namespace {
+
+class MmapResourceMapping : public ResourceMapping {
+ public:
+  MmapResourceMapping(void* data, size_t size) : data_(data), size_(size) {}
+  ~MmapResourceMapping() override {
+    if (size_ > 0) {
+      munmap(data_, size_);
+    }
+  }
+
+  const char* data() const override {
+    return static_cast<const char*>(data_);
+  }
+  size_t size() const override { return size_; }
+
+ private:
+  void* const data_;
+  const size_t size_;
+};
+
+}  // namespace
+
+::mediapipe::StatusOr<std::unique_ptr<ResourceMapping>> MapFile(
+    const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  RET_CHECK_GE(fd, 0) << "could not open file: " << path;
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    close(fd);
+    return ::mediapipe::InternalError("could not stat file: " + path);
+  }
+  const size_t size = file_stat.st_size;
+  // mmap() fails for empty files, which are mapped to an empty range.
+  void* data = nullptr;
+  if (size > 0) {
+    data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  // The mapping stays valid after the file is closed.
+  close(fd);
+  RET_CHECK(data != MAP_FAILED) << "could not map file: " << path;
+  std::unique_ptr<ResourceMapping> mapping =
+      absl::make_unique<MmapResourceMapping>(data, size);
+  return std::move(mapping);
+}
+
+}  // namespace internal
+}  // namespace mediapipe
@@ -29,4 +29,9 @@ namespace mediapipe {
   return mediapipe::file::GetContents(path, output);
 }
 
+::mediapipe::StatusOr<std::unique_ptr<ResourceMapping>> GetResourceMapping(
+    const std::string& path) {
+  return internal::MapFile(path);
+}
+
 }  // namespace mediapipe
@@ -15,8 +15,11 @@
 #ifndef MEDIAPIPE_UTIL_RESOURCE_UTIL_H_
 #define MEDIAPIPE_UTIL_RESOURCE_UTIL_H_
 
+#include <cstddef>
+#include <memory>
 #include <string>
 
+#include "absl/strings/string_view.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/port/statusor.h"
 
@@ -47,6 +50,36 @@ namespace mediapipe {
 ::mediapipe::Status GetResourceContents(const std::string& path,
                                         std::string* output);
 
+// Read-only contents of a resource mapped into memory. The contents stay
+// valid until the ResourceMapping is destroyed.
+class ResourceMapping {
+ public:
+  virtual ~ResourceMapping() = default;
+
+  virtual const char* data() const = 0;
+  virtual size_t size() const = 0;
+
+  absl::string_view contents() const {
+    return absl::string_view(data(), size());
+  }
+};
+
+// Maps the contents of a resource into memory, without copying them. The
+// search path is as in PathToResourceAsFile, except that Android assets are
+// mapped directly from the APK instead of being copied to the file system.
+// Prefer this over GetResourceContents for large resources such as models.
+::mediapipe::StatusOr<std::unique_ptr<ResourceMapping>> GetResourceMapping(
+    const std::string& path);
+
+namespace internal {
+
+// Maps the file at "path" into memory. Used by the platform implementations
+// of GetResourceMapping.
+::mediapipe::StatusOr<std::unique_ptr<ResourceMapping>> MapFile(
+    const std::string& path);
+
+}  // namespace internal
+
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_UTIL_RESOURCE_UTIL_H_
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "absl/memory/memory.h"
 #include "absl/strings/match.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/singleton.h"
@@ -21,6 +22,26 @@
 
 namespace mediapipe {
 
+namespace {
+
+// An asset opened in buffer mode, which maps uncompressed assets directly from
+// the APK.
+class AssetResourceMapping : public ResourceMapping {
+ public:
+  explicit AssetResourceMapping(AAsset* asset) : asset_(asset) {}
+  ~AssetResourceMapping() override { AAsset_close(asset_); }
+
+  const char* data() const override {
+    return static_cast<const char*>(AAsset_getBuffer(asset_));
+  }
+  size_t size() const override { return AAsset_getLength(asset_); }
+
+ private:
+  AAsset* const asset_;
+};
+
+}  // namespace
+
 ::mediapipe::StatusOr<std::string> PathToResourceAsFile(
     const std::string& path) {
   if (absl::StartsWith(path, "/")) {
@@ -43,4 +64,23 @@ namespace mediapipe {
   return ::mediapipe::OkStatus();
 }
 
+::mediapipe::StatusOr<std::unique_ptr<ResourceMapping>> GetResourceMapping(
+    const std::string& path) {
+  if (absl::StartsWith(path, "/")) {
+    return internal::MapFile(path);
+  }
+
+  AAssetManager* asset_manager =
+      Singleton<AssetManager>::get()->GetAssetManager();
+  RET_CHECK(asset_manager) << "asset manager not initialized";
+  AAsset* asset =
+      AAssetManager_open(asset_manager, path.c_str(), AASSET_MODE_BUFFER);
+  RET_CHECK(asset) << "could not open asset: " << path;
+  std::unique_ptr<ResourceMapping> mapping =
+      absl::make_unique<AssetResourceMapping>(asset);
+  // Compressed assets are decompressed into a buffer owned by the asset.
+  RET_CHECK(AAsset_getBuffer(asset)) << "could not read asset: " << path;
+  return std::move(mapping);
+}
+
 }  // namespace mediapipe
@@ -54,4 +54,10 @@ namespace mediapipe {
   return ::mediapipe::OkStatus();
 }
 
+::mediapipe::StatusOr<std::unique_ptr<ResourceMapping>> GetResourceMapping(
+    const std::string& path) {
+  ASSIGN_OR_RETURN(std::string full_path, PathToResourceAsFile(path));
+  return internal::MapFile(full_path);
+}
+
 }  // namespace mediapipe
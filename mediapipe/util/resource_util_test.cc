@@ -0,0 +1,67 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/resource_util.h"
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+std::string WriteTempFile(const std::string& name,
+                          const std::string& contents) {
+  std::string path = absl::StrCat(getenv("TEST_TMPDIR"), "/", name);
+  MP_EXPECT_OK(file::SetContents(path, contents));
+  return path;
+}
+
+TEST(ResourceUtilTest, MapsResourceContents) {
+  const std::string contents("resource\0contents", 17);
+  std::string path = WriteTempFile("resource", contents);
+
+  auto mapping_or = GetResourceMapping(path);
+  MP_ASSERT_OK(mapping_or.status());
+  std::unique_ptr<ResourceMapping> mapping =
+      std::move(mapping_or.ValueOrDie());
+  EXPECT_EQ(contents, mapping->contents());
+
+  std::string read_contents;
+  MP_ASSERT_OK(GetResourceContents(path, &read_contents));
+  EXPECT_EQ(read_contents, mapping->contents());
+}
+
+TEST(ResourceUtilTest, MapsEmptyResource) {
+  std::string path = WriteTempFile("empty_resource", "");
+
+  auto mapping_or = GetResourceMapping(path);
+  MP_ASSERT_OK(mapping_or.status());
+  EXPECT_EQ(0, mapping_or.ValueOrDie()->size());
+}
+
+TEST(ResourceUtilTest, FailsToMapMissingResource) {
+  EXPECT_FALSE(
+      GetResourceMapping(absl::StrCat(getenv("TEST_TMPDIR"), "/missing"))
+          .ok());
+}
+
+}  // namespace
+}  // namespace mediapipe
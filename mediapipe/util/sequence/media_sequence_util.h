@@ -52,6 +52,7 @@
 //   void AddMyFeature(value, *sequence)
 //   int GetMyFeatureSize(sequence)
 //   TYPE GetMyFeatureAt(sequence)
+//   FeatureListView GetMyFeatureView(sequence)
 //
 // VECTOR_{BYTES,INT64,FLOAT}_FEATURE_LIST:
 //   std::string GetMyFeatureKey(sequence)
@@ -60,6 +61,10 @@
 //   void AddMyFeature(repeated_value, *sequence)
 //   int GetMyFeatureSize(sequence)
 //   Repeated<TYPE> GetMyFeatureAt(sequence)
+//   FeatureListView GetMyFeatureView(sequence)
+//
+// GetMyFeatureAt looks the feature list up on each call. To read many indices
+// of a feature list, get its FeatureListView once and read them from it.
 //
 // To see the exact types, please see the actual definitions, but this list
 // should be sufficient for quick reference.
@@ -92,6 +97,7 @@
 #include <string>
 #include <vector>
 
+#include "absl/types/span.h"
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/proto_ns.h"
@@ -247,6 +253,57 @@ inline const proto_ns::RepeatedPtrField<std::string>& GetBytesAt(
   return fl.feature().Get(index).bytes_list().value();
 }
 
+// A view of the feature list with the provided key that looks the key up
+// once, so that reading every index does not repeat the map lookup of
+// GetFloatsAt() and friends. The values are returned without copies, as spans
+// of the repeated fields or references to the strings in the sequence. The
+// view must not outlive the sequence, and is invalidated if the feature list
+// is erased or features are added to or removed from it.
+class FeatureListView {
+ public:
+  // A view of a missing feature list.
+  FeatureListView() = default;
+
+  FeatureListView(const tensorflow::SequenceExample& sequence,
+                  const std::string& key) {
+    const auto it = sequence.feature_lists().feature_list().find(key);
+    if (it != sequence.feature_lists().feature_list().end()) {
+      feature_list_ = &it->second;
+    }
+  }
+
+  // Returns true if the feature list is present.
+  bool present() const { return feature_list_ != nullptr; }
+
+  // Returns the size of the feature list or 0 if it is not present.
+  int size() const {
+    return feature_list_ == nullptr ? 0 : feature_list_->feature_size();
+  }
+
+  absl::Span<const float> GetFloatsAt(int index) const {
+    const auto& values = GetAt(index).float_list().value();
+    return absl::MakeConstSpan(values.data(), values.size());
+  }
+
+  absl::Span<const int64> GetInt64sAt(int index) const {
+    const auto& values = GetAt(index).int64_list().value();
+    return absl::MakeConstSpan(values.data(), values.size());
+  }
+
+  const proto_ns::RepeatedPtrField<std::string>& GetBytesAt(int index) const {
+    return GetAt(index).bytes_list().value();
+  }
+
+ private:
+  const tensorflow::Feature& GetAt(int index) const {
+    CHECK(feature_list_ != nullptr) << "The feature list is not present.";
+    CHECK_LT(index, feature_list_->feature_size());
+    return feature_list_->feature(index);
+  }
+
+  const tensorflow::FeatureList* feature_list_ = nullptr;
+};
+
 // Adds any iterable (with begin and end) to a FeatureList as a float Feature.
 template <typename TContainer>
 void AddFloatContainer(const std::string& key, const TContainer& float_list,
@@ -778,6 +835,11 @@ void AddBytesContainer(const std::string& key, const TContainer& bytes_list,
       const tensorflow::SequenceExample& sequence) {                          \
     return GetFeatureListSize(sequence, merge_prefix(prefix, key));           \
   }                                                                           \
+  inline FeatureListView CONCAT_STR3(Get, name, View)(                        \
+      const std::string& prefix,                                              \
+      const tensorflow::SequenceExample& sequence) {                          \
+    return FeatureListView(sequence, merge_prefix(prefix, key));              \
+  }                                                                           \
   inline const std::string& CONCAT_STR3(Get, name, At)(                       \
       const std::string& prefix, const tensorflow::SequenceExample& sequence, \
       int index) {                                                            \
@@ -811,6 +873,10 @@ void AddBytesContainer(const std::string& key, const TContainer& bytes_list,
       Get, name, Size)(const tensorflow::SequenceExample& sequence) {         \
     return CONCAT_STR3(Get, name, Size)(prefix, sequence);                    \
   }                                                                           \
+  inline FeatureListView CONCAT_STR3(                                         \
+      Get, name, View)(const tensorflow::SequenceExample& sequence) {         \
+    return CONCAT_STR3(Get, name, View)(prefix, sequence);                    \
+  }                                                                           \
   inline const std::string& CONCAT_STR3(Get, name, At)(                       \
       const tensorflow::SequenceExample& sequence, int index) {               \
     return CONCAT_STR3(Get, name, At)(prefix, sequence, index);               \
@@ -843,6 +909,11 @@ void AddBytesContainer(const std::string& key, const TContainer& bytes_list,
       const tensorflow::SequenceExample& sequence) {                          \
     return GetFeatureListSize(sequence, merge_prefix(prefix, key));           \
   }                                                                           \
+  inline FeatureListView CONCAT_STR3(Get, name, View)(                        \
+      const std::string& prefix,                                              \
+      const tensorflow::SequenceExample& sequence) {                          \
+    return FeatureListView(sequence, merge_prefix(prefix, key));              \
+  }                                                                           \
   inline const int64 CONCAT_STR3(Get, name, At)(                              \
       const std::string& prefix, const tensorflow::SequenceExample& sequence, \
       int index) {                                                            \
@@ -876,6 +947,10 @@ void AddBytesContainer(const std::string& key, const TContainer& bytes_list,
       Get, name, Size)(const tensorflow::SequenceExample& sequence) {         \
     return CONCAT_STR3(Get, name, Size)(prefix, sequence);                    \
   }                                                                           \
+  inline FeatureListView CONCAT_STR3(                                         \
+      Get, name, View)(const tensorflow::SequenceExample& sequence) {         \
+    return CONCAT_STR3(Get, name, View)(prefix, sequence);                    \
+  }                                                                           \
   inline const int64 CONCAT_STR3(Get, name, At)(                              \
       const tensorflow::SequenceExample& sequence, int index) {               \
     return CONCAT_STR3(Get, name, At)(prefix, sequence, index);               \
@@ -908,6 +983,11 @@ void AddBytesContainer(const std::string& key, const TContainer& bytes_list,
       const tensorflow::SequenceExample& sequence) {                          \
     return GetFeatureListSize(sequence, merge_prefix(prefix, key));           \
   }                                                                           \
+  inline FeatureListView CONCAT_STR3(Get, name, View)(                        \
+      const std::string& prefix,                                              \
+      const tensorflow::SequenceExample& sequence) {                          \
+    return FeatureListView(sequence, merge_prefix(prefix, key));              \
+  }                                                                           \
   inline const float CONCAT_STR3(Get, name, At)(                              \
       const std::string& prefix, const tensorflow::SequenceExample& sequence, \
       int index) {                                                            \
@@ -941,6 +1021,10 @@ void AddBytesContainer(const std::string& key, const TContainer& bytes_list,
       Get, name, Size)(const tensorflow::SequenceExample& sequence) {         \
     return CONCAT_STR3(Get, name, Size)(prefix, sequence);                    \
   }                                                                           \
+  inline FeatureListView CONCAT_STR3(                                         \
+      Get, name, View)(const tensorflow::SequenceExample& sequence) {         \
+    return CONCAT_STR3(Get, name, View)(prefix, sequence);                    \
+  }                                                                           \
   inline const float CONCAT_STR3(Get, name, At)(                              \
       const tensorflow::SequenceExample& sequence, int index) {               \
     return CONCAT_STR3(Get, name, At)(prefix, sequence, index);               \
@@ -974,6 +1058,11 @@ void AddBytesContainer(const std::string& key, const TContainer& bytes_list,
       const tensorflow::SequenceExample& sequence) {                           \
     return GetFeatureListSize(sequence, merge_prefix(prefix, key));            \
   }                                                                            \
+  inline FeatureListView CONCAT_STR3(Get, name, View)(                         \
+      const std::string& prefix,                                               \
+      const tensorflow::SequenceExample& sequence) {                           \
+    return FeatureListView(sequence, merge_prefix(prefix, key));               \
+  }                                                                            \
   inline const proto_ns::RepeatedPtrField<std::string>& CONCAT_STR3(           \
       Get, name, At)(const std::string& prefix,                                \
                      const tensorflow::SequenceExample& sequence, int index) { \
@@ -1010,6 +1099,10 @@ void AddBytesContainer(const std::string& key, const TContainer& bytes_list,
       Get, name, Size)(const tensorflow::SequenceExample& sequence) {          \
     return CONCAT_STR3(Get, name, Size)(prefix, sequence);                     \
   }                                                                            \
+  inline FeatureListView CONCAT_STR3(                                          \
+      Get, name, View)(const tensorflow::SequenceExample& sequence) {          \
+    return CONCAT_STR3(Get, name, View)(prefix, sequence);                     \
+  }                                                                            \
   inline const proto_ns::RepeatedPtrField<std::string>& CONCAT_STR3(           \
       Get, name, At)(const tensorflow::SequenceExample& sequence, int index) { \
     return CONCAT_STR3(Get, name, At)(prefix, sequence, index);                \
@@ -1048,6 +1141,11 @@ void AddBytesContainer(const std::string& key, const TContainer& bytes_list,
       const tensorflow::SequenceExample& sequence) {                          \
     return GetFeatureListSize(sequence, merge_prefix(prefix, key));           \
   }                                                                           \
+  inline FeatureListView CONCAT_STR3(Get, name, View)(                        \
+      const std::string& prefix,                                              \
+      const tensorflow::SequenceExample& sequence) {                          \
+    return FeatureListView(sequence, merge_prefix(prefix, key));              \
+  }                                                                           \
   inline const proto_ns::RepeatedField<int64>& CONCAT_STR3(Get, name, At)(    \
       const std::string& prefix, const tensorflow::SequenceExample& sequence, \
       int index) {                                                            \
@@ -1084,6 +1182,10 @@ void AddBytesContainer(const std::string& key, const TContainer& bytes_list,
       Get, name, Size)(const tensorflow::SequenceExample& sequence) {         \
     return CONCAT_STR3(Get, name, Size)(prefix, sequence);                    \
   }                                                                           \
+  inline FeatureListView CONCAT_STR3(                                         \
+      Get, name, View)(const tensorflow::SequenceExample& sequence) {         \
+    return CONCAT_STR3(Get, name, View)(prefix, sequence);                    \
+  }                                                                           \
   inline const proto_ns::RepeatedField<int64>& CONCAT_STR3(Get, name, At)(    \
       const tensorflow::SequenceExample& sequence, int index) {               \
     return CONCAT_STR3(Get, name, At)(prefix, sequence, index);               \
@@ -1122,6 +1224,11 @@ void AddBytesContainer(const std::string& key, const TContainer& bytes_list,
       const tensorflow::SequenceExample& sequence) {                          \
     return GetFeatureListSize(sequence, merge_prefix(prefix, key));           \
   }                                                                           \
+  inline FeatureListView CONCAT_STR3(Get, name, View)(                        \
+      const std::string& prefix,                                              \
+      const tensorflow::SequenceExample& sequence) {                          \
+    return FeatureListView(sequence, merge_prefix(prefix, key));              \
+  }                                                                           \
   inline const proto_ns::RepeatedField<float>& CONCAT_STR3(Get, name, At)(    \
       const std::string& prefix, const tensorflow::SequenceExample& sequence, \
       int index) {                                                            \
@@ -1158,6 +1265,10 @@ void AddBytesContainer(const std::string& key, const TContainer& bytes_list,
       Get, name, Size)(const tensorflow::SequenceExample& sequence) {         \
     return CONCAT_STR3(Get, name, Size)(prefix, sequence);                    \
   }                                                                           \
+  inline FeatureListView CONCAT_STR3(                                         \
+      Get, name, View)(const tensorflow::SequenceExample& sequence) {         \
+    return CONCAT_STR3(Get, name, View)(prefix, sequence);                    \
+  }                                                                           \
   inline const proto_ns::RepeatedField<float>& CONCAT_STR3(Get, name, At)(    \
       const tensorflow::SequenceExample& sequence, int index) {               \
     return CONCAT_STR3(Get, name, At)(prefix, sequence, index);               \
@@ -238,6 +238,29 @@ TEST_F(MediaSequenceUtilTest, GetBytesAt) {
   EXPECT_EQ("Helena Bonham Carter", actors1[2]);
 }
 
+TEST_F(MediaSequenceUtilTest, FeatureListView) {
+  const FeatureListView ratings(sequence_example_, "movie_ratings");
+  ASSERT_TRUE(ratings.present());
+  ASSERT_EQ(2, ratings.size());
+  EXPECT_THAT(ratings.GetFloatsAt(1),
+              testing::ElementsAre(testing::FloatEq(5.0),
+                                   testing::FloatEq(2.3)));
+  EXPECT_EQ(GetFloatsAt(sequence_example_, "movie_ratings", 1).data(),
+            ratings.GetFloatsAt(1).data());
+
+  const FeatureListView runtimes(sequence_example_, "runtimes");
+  EXPECT_THAT(runtimes.GetInt64sAt(0), testing::ElementsAre(123, 84));
+
+  const FeatureListView actors(sequence_example_, "actors");
+  EXPECT_THAT(actors.GetBytesAt(1),
+              testing::ElementsAre("Brad Pitt", "Edward Norton",
+                                   "Helena Bonham Carter"));
+
+  const FeatureListView missing(sequence_example_, "missing");
+  EXPECT_FALSE(missing.present());
+  EXPECT_EQ(0, missing.size());
+}
+
 TEST_F(MediaSequenceUtilTest, RoundTripFloatList) {
   tensorflow::SequenceExample sequence_example;
   std::string key = "key";
@@ -648,6 +671,25 @@ TEST_F(MediaSequenceUtilTest, VectorFloatFeatureList) {
   ASSERT_EQ(GetVectorFloatFeatureListKey(), "vector_float_feature_list");
 }
 
+TEST_F(MediaSequenceUtilTest, FeatureListViewAccessors) {
+  tensorflow::SequenceExample example;
+  ASSERT_FALSE(GetVectorFloatFeatureListView(example).present());
+  AddVectorFloatFeatureList(::std::vector<float>({47.f, 42.f}), &example);
+  AddVectorFloatFeatureList(::std::vector<float>({3.f, 5.f}), &example);
+  AddOneStringFeatureList("one", &example);
+
+  const FeatureListView floats = GetVectorFloatFeatureListView(example);
+  ASSERT_EQ(2, floats.size());
+  EXPECT_THAT(floats.GetFloatsAt(0), testing::ElementsAre(47.f, 42.f));
+  EXPECT_THAT(floats.GetFloatsAt(1), testing::ElementsAre(3.f, 5.f));
+
+  const FeatureListView strings = GetOneStringFeatureListView(example);
+  ASSERT_EQ(1, strings.size());
+  EXPECT_EQ("one", strings.GetBytesAt(0).Get(0));
+  EXPECT_EQ(1, GetStringFeatureListView("ONE", example).size());
+  EXPECT_FALSE(GetTwoStringFeatureListView(example).present());
+}
+
 TEST_F(MediaSequenceUtilTest, FixedPrefixStringFeature) {
   tensorflow::SequenceExample example;
   std::string test_value_1 = "one";
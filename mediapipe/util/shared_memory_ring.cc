@@ -0,0 +1,396 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/shared_memory_ring.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <new>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "mediapipe/framework/port/ret_check.h"
+
+namespace mediapipe {
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+              "SharedMemoryRing needs address-free atomics.");
+
+namespace {
+
+constexpr uint64 kMagic = 0x474e495252485350;  // "PSHRRING"
+constexpr uint32 kVersion = 1;
+
+// The slot state keeps the number of readers holding the slot in its low
+// bits.
+constexpr int kReaderBits = 16;
+constexpr uint64 kReaderMask = (uint64{1} << kReaderBits) - 1;
+
+constexpr size_t kSlotHeaderSize = 64;
+
+// How often a writer checks whether a held slot has been released.
+constexpr absl::Duration kSlotPollInterval = absl::Microseconds(100);
+
+size_t RoundUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+// Returns the CLOCK_MONOTONIC time "timeout" from now, as used by the
+// condition variable.
+timespec MonotonicDeadline(absl::Duration timeout) {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return absl::ToTimespec(absl::DurationFromTimespec(now) + timeout);
+}
+
+// Locks the ring mutex, recovering it if its owner died while holding it.
+// The mutex only guards waiting, so there is no state to repair.
+void LockRingMutex(pthread_mutex_t* mutex) {
+  if (pthread_mutex_lock(mutex) == EOWNERDEAD) {
+    pthread_mutex_consistent(mutex);
+  }
+}
+
+}  // namespace
+
+constexpr size_t SharedMemoryRing::kMaxMetadataSize;
+constexpr size_t SharedMemoryRing::kDataAlignment;
+
+// The mappings of a segment. Readers also map it read-only, to hand out
+// message data that other readers can't be affected by writing to.
+struct SharedMemoryRing::Segment {
+  Segment(uint8* base, const uint8* read_only_base, size_t size)
+      : base(base), read_only_base(read_only_base), size(size) {}
+  ~Segment() {
+    munmap(base, size);
+    if (read_only_base) {
+      munmap(const_cast<uint8*>(read_only_base), size);
+    }
+  }
+
+  uint8* const base;
+  const uint8* const read_only_base;
+  const size_t size;
+};
+
+// The start of the segment, followed by the slots.
+struct SharedMemoryRing::RingHeader {
+  // Set to kMagic once the rest of the segment is initialized.
+  std::atomic<uint64> magic;
+  uint32 version;
+  uint32 num_slots;
+  uint64 slot_size;
+  uint64 max_data_size;
+  // The number of messages written.
+  std::atomic<uint64> write_sequence;
+  // Set once the writer is gone.
+  std::atomic<uint32> closed;
+  // Signaled when a message is written or the ring is closed.
+  pthread_mutex_t mutex;
+  pthread_cond_t written;
+};
+
+// The start of a slot, followed by kMaxMetadataSize bytes of metadata and the
+// data.
+struct SharedMemoryRing::SlotHeader {
+  // The sequence number of the message in the slot plus one, or 0 while it
+  // is being written, above the number of readers holding the slot.
+  // Readers only add themselves while the slot holds the message they
+  // expect, so once the writer swaps in 0, none can until it is written.
+  std::atomic<uint64> state;
+  int64 timestamp;
+  uint32 type;
+  uint32 metadata_size;
+  uint64 data_size;
+};
+
+::mediapipe::StatusOr<std::unique_ptr<SharedMemoryRing>>
+SharedMemoryRing::Create(const std::string& name, int num_slots,
+                         size_t max_data_size) {
+  static_assert(sizeof(SlotHeader) <= kSlotHeaderSize, "");
+  RET_CHECK_GT(num_slots, 0);
+  const size_t slot_size = kSlotHeaderSize + kMaxMetadataSize +
+                           RoundUp(max_data_size, kDataAlignment);
+  const size_t size =
+      RoundUp(sizeof(RingHeader), kDataAlignment) + num_slots * slot_size;
+
+  // Readers of a segment left over from an earlier writer keep their
+  // mapping of it, but new readers open this one.
+  shm_unlink(name.c_str());
+  const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0660);
+  RET_CHECK_GE(fd, 0) << "could not create shared memory " << name << ": "
+                      << strerror(errno);
+  // The segment is zero-filled, so every slot starts out empty.
+  void* base = MAP_FAILED;
+  if (ftruncate(fd, size) == 0) {
+    base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (base == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    return ::mediapipe::InternalError(absl::StrCat(
+        "could not map shared memory ", name, ": ", strerror(errno)));
+  }
+  auto segment = std::make_shared<Segment>(static_cast<uint8*>(base),
+                                           nullptr, size);
+
+  RingHeader* header = new (base) RingHeader;
+  header->version = kVersion;
+  header->num_slots = num_slots;
+  header->slot_size = slot_size;
+  header->max_data_size = max_data_size;
+  header->write_sequence.store(0, std::memory_order_relaxed);
+  header->closed.store(0, std::memory_order_relaxed);
+  pthread_mutexattr_t mutex_attr;
+  pthread_mutexattr_init(&mutex_attr);
+  pthread_mutexattr_setpshared(&mutex_attr, PTHREAD_PROCESS_SHARED);
+  pthread_mutexattr_setrobust(&mutex_attr, PTHREAD_MUTEX_ROBUST);
+  RET_CHECK_EQ(pthread_mutex_init(&header->mutex, &mutex_attr), 0);
+  pthread_mutexattr_destroy(&mutex_attr);
+  pthread_condattr_t cond_attr;
+  pthread_condattr_init(&cond_attr);
+  pthread_condattr_setpshared(&cond_attr, PTHREAD_PROCESS_SHARED);
+  pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+  RET_CHECK_EQ(pthread_cond_init(&header->written, &cond_attr), 0);
+  pthread_condattr_destroy(&cond_attr);
+
+  auto ring = absl::WrapUnique(new SharedMemoryRing(name, segment, true));
+  for (int i = 0; i < num_slots; ++i) {
+    new (ring->slot(i)) SlotHeader;
+    ring->slot(i)->state.store(0, std::memory_order_relaxed);
+  }
+  header->magic.store(kMagic, std::memory_order_release);
+  return std::move(ring);
+}
+
+::mediapipe::StatusOr<std::unique_ptr<SharedMemoryRing>>
+SharedMemoryRing::Open(const std::string& name) {
+  const int fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    if (errno == ENOENT) {
+      return ::mediapipe::UnavailableError(
+          absl::StrCat("shared memory ", name, " does not exist yet"));
+    }
+    return ::mediapipe::InternalError(absl::StrCat(
+        "could not open shared memory ", name, ": ", strerror(errno)));
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size < sizeof(RingHeader)) {
+    close(fd);
+    return ::mediapipe::UnavailableError(
+        absl::StrCat("shared memory ", name, " is not initialized yet"));
+  }
+  const size_t size = file_stat.st_size;
+  void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  void* read_only_base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED || read_only_base == MAP_FAILED) {
+    if (base != MAP_FAILED) munmap(base, size);
+    if (read_only_base != MAP_FAILED) munmap(read_only_base, size);
+    return ::mediapipe::InternalError(absl::StrCat(
+        "could not map shared memory ", name, ": ", strerror(errno)));
+  }
+  auto segment = std::make_shared<Segment>(
+      static_cast<uint8*>(base), static_cast<const uint8*>(read_only_base),
+      size);
+
+  const RingHeader* header = reinterpret_cast<const RingHeader*>(base);
+  if (header->magic.load(std::memory_order_acquire) != kMagic) {
+    return ::mediapipe::UnavailableError(
+        absl::StrCat("shared memory ", name, " is not initialized yet"));
+  }
+  RET_CHECK_EQ(header->version, kVersion)
+      << "shared memory " << name << " has an unsupported layout";
+  RET_CHECK_EQ(size, RoundUp(sizeof(RingHeader), kDataAlignment) +
+                         header->num_slots * header->slot_size);
+  auto ring = absl::WrapUnique(new SharedMemoryRing(name, segment, false));
+  ring->next_sequence_ = header->write_sequence.load(std::memory_order_acquire);
+  return std::move(ring);
+}
+
+SharedMemoryRing::SharedMemoryRing(const std::string& name,
+                                   std::shared_ptr<Segment> segment,
+                                   bool is_writer)
+    : name_(name), segment_(std::move(segment)), is_writer_(is_writer) {}
+
+SharedMemoryRing::~SharedMemoryRing() {
+  if (!is_writer_) {
+    return;
+  }
+  RingHeader* ring_header = header();
+  LockRingMutex(&ring_header->mutex);
+  ring_header->closed.store(1, std::memory_order_release);
+  pthread_cond_broadcast(&ring_header->written);
+  pthread_mutex_unlock(&ring_header->mutex);
+  shm_unlink(name_.c_str());
+}
+
+SharedMemoryRing::RingHeader* SharedMemoryRing::header() const {
+  return reinterpret_cast<RingHeader*>(segment_->base);
+}
+
+SharedMemoryRing::SlotHeader* SharedMemoryRing::slot(uint64 sequence) const {
+  const RingHeader* ring_header = header();
+  return reinterpret_cast<SlotHeader*>(
+      segment_->base + RoundUp(sizeof(RingHeader), kDataAlignment) +
+      (sequence % ring_header->num_slots) * ring_header->slot_size);
+}
+
+int SharedMemoryRing::num_slots() const { return header()->num_slots; }
+
+size_t SharedMemoryRing::max_data_size() const {
+  return header()->max_data_size;
+}
+
+::mediapipe::StatusOr<bool> SharedMemoryRing::Write(
+    int64 timestamp, uint32 type, absl::string_view metadata,
+    size_t data_size, const std::function<void(uint8*)>& fill,
+    absl::Duration max_wait) {
+  RET_CHECK(is_writer_);
+  RingHeader* ring_header = header();
+  RET_CHECK_LE(metadata.size(), kMaxMetadataSize);
+  RET_CHECK_LE(data_size, ring_header->max_data_size);
+
+  // Takes the slot once no reader holds it.
+  SlotHeader* slot_header = slot(next_sequence_);
+  const absl::Time deadline = absl::Now() + max_wait;
+  uint64 state = slot_header->state.load(std::memory_order_relaxed);
+  while (true) {
+    if ((state & kReaderMask) != 0) {
+      if (absl::Now() >= deadline) {
+        return false;
+      }
+      absl::SleepFor(kSlotPollInterval);
+      state = slot_header->state.load(std::memory_order_relaxed);
+    } else if (slot_header->state.compare_exchange_weak(
+                   state, 0, std::memory_order_acquire,
+                   std::memory_order_relaxed)) {
+      break;
+    }
+  }
+
+  uint8* slot_data = reinterpret_cast<uint8*>(slot_header) + kSlotHeaderSize;
+  slot_header->timestamp = timestamp;
+  slot_header->type = type;
+  slot_header->metadata_size = metadata.size();
+  slot_header->data_size = data_size;
+  memcpy(slot_data, metadata.data(), metadata.size());
+  fill(slot_data + kMaxMetadataSize);
+
+  const uint64 sequence = next_sequence_++;
+  slot_header->state.store((sequence + 1) << kReaderBits,
+                           std::memory_order_release);
+  ring_header->write_sequence.store(next_sequence_,
+                                    std::memory_order_release);
+  LockRingMutex(&ring_header->mutex);
+  pthread_cond_broadcast(&ring_header->written);
+  pthread_mutex_unlock(&ring_header->mutex);
+  return true;
+}
+
+::mediapipe::StatusOr<std::shared_ptr<const SharedMemoryRing::Message>>
+SharedMemoryRing::Read(absl::Duration timeout) {
+  RET_CHECK(!is_writer_);
+  RingHeader* ring_header = header();
+  uint64 write_sequence =
+      ring_header->write_sequence.load(std::memory_order_acquire);
+  if (write_sequence <= next_sequence_) {
+    const timespec deadline = MonotonicDeadline(timeout);
+    LockRingMutex(&ring_header->mutex);
+    while (ring_header->write_sequence.load(std::memory_order_acquire) <=
+               next_sequence_ &&
+           !ring_header->closed.load(std::memory_order_acquire)) {
+      const int result = pthread_cond_timedwait(
+          &ring_header->written, &ring_header->mutex, &deadline);
+      if (result == EOWNERDEAD) {
+        pthread_mutex_consistent(&ring_header->mutex);
+      } else if (result != 0) {
+        break;
+      }
+    }
+    pthread_mutex_unlock(&ring_header->mutex);
+    write_sequence =
+        ring_header->write_sequence.load(std::memory_order_acquire);
+  }
+
+  const uint64 num_slots = ring_header->num_slots;
+  while (next_sequence_ < write_sequence) {
+    // The writer has reused the slots of messages older than the last
+    // num_slots.
+    if (write_sequence - next_sequence_ > num_slots) {
+      skipped_count_ += write_sequence - num_slots - next_sequence_;
+      next_sequence_ = write_sequence - num_slots;
+    }
+    SlotHeader* slot_header = slot(next_sequence_);
+    const uint64 expected = (next_sequence_ + 1) << kReaderBits;
+    ++next_sequence_;
+    uint64 state = slot_header->state.load(std::memory_order_relaxed);
+    bool acquired = false;
+    while ((state & ~kReaderMask) == expected &&
+           (state & kReaderMask) != kReaderMask) {
+      if (slot_header->state.compare_exchange_weak(
+              state, state + 1, std::memory_order_acquire,
+              std::memory_order_relaxed)) {
+        acquired = true;
+        break;
+      }
+    }
+    if (!acquired) {
+      // The slot is being or has been overwritten.
+      ++skipped_count_;
+      write_sequence =
+          ring_header->write_sequence.load(std::memory_order_acquire);
+      continue;
+    }
+
+    const size_t slot_offset =
+        reinterpret_cast<uint8*>(slot_header) - segment_->base;
+    const uint8* slot_data =
+        segment_->read_only_base + slot_offset + kSlotHeaderSize;
+    auto* message = new Message;
+    message->timestamp = slot_header->timestamp;
+    message->type = slot_header->type;
+    message->metadata = absl::string_view(
+        reinterpret_cast<const char*>(slot_data), slot_header->metadata_size);
+    message->data = slot_data + kMaxMetadataSize;
+    message->data_size = slot_header->data_size;
+    // The deleter keeps the segment mapped until the slot is released.
+    std::shared_ptr<Segment> segment = segment_;
+    return std::shared_ptr<const Message>(
+        message, [segment, slot_header](const Message* message) {
+          slot_header->state.fetch_sub(1, std::memory_order_release);
+          delete message;
+        });
+  }
+  return std::shared_ptr<const Message>();
+}
+
+bool SharedMemoryRing::Finished() const {
+  const RingHeader* ring_header = header();
+  return ring_header->closed.load(std::memory_order_acquire) &&
+         next_sequence_ >=
+             ring_header->write_sequence.load(std::memory_order_acquire);
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,138 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// A single-producer, multi-consumer ring of messages in a named POSIX shared
+// memory segment, for passing packets between processes on one machine.
+
+#ifndef MEDIAPIPE_UTIL_SHARED_MEMORY_RING_H_
+#define MEDIAPIPE_UTIL_SHARED_MEMORY_RING_H_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+
+namespace mediapipe {
+
+// The ring has num_slots slots of a fixed size, each holding one message: a
+// timestamp, a type chosen by the caller, up to kMaxMetadataSize bytes of
+// metadata, and a data payload. The writer copies each message into the next
+// slot once. Readers get the slot itself, and hold it until the last
+// reference to the returned message is released, so the payload can back
+// e.g. ImageFrame pixels without a copy. The writer never overwrites a held
+// slot: it waits for the slot or drops the message. A reader that falls more
+// than num_slots messages behind skips the overwritten ones.
+//
+// Slot ownership is tracked with atomics in the segment, and readers wait for
+// new messages on a process-shared condition variable, so this requires a
+// platform with POSIX shared memory and process-shared pthread objects, such
+// as Linux. Segments are named like "/camera_frames", see shm_open(3).
+//
+// Example:
+//   // Process A.
+//   ASSIGN_OR_RETURN(auto ring, SharedMemoryRing::Create("/frames", 8, size));
+//   ASSIGN_OR_RETURN(bool written, ring->Write(ts, kType, "", size, fill,
+//                                              absl::ZeroDuration()));
+//   // Process B.
+//   ASSIGN_OR_RETURN(auto ring, SharedMemoryRing::Open("/frames"));
+//   ASSIGN_OR_RETURN(auto message, ring->Read(absl::Milliseconds(100)));
+class SharedMemoryRing {
+ public:
+  // The most metadata bytes a message can carry.
+  static constexpr size_t kMaxMetadataSize = 192;
+  // The alignment of message data in the segment.
+  static constexpr size_t kDataAlignment = 64;
+
+  // A message read from the ring. The slot is released when the last
+  // shared_ptr to the message is destroyed, and the data stays valid until
+  // then, even if the ring itself has been destroyed. The data is mapped
+  // read-only in readers, since other readers share it.
+  struct Message {
+    int64 timestamp;
+    uint32 type;
+    absl::string_view metadata;
+    const uint8* data;
+    size_t data_size;
+  };
+
+  // Creates the segment "name" with num_slots slots able to hold
+  // max_data_size bytes of data each, replacing any segment of that name left
+  // over from an earlier writer. There must be a single writer per name.
+  static ::mediapipe::StatusOr<std::unique_ptr<SharedMemoryRing>> Create(
+      const std::string& name, int num_slots, size_t max_data_size);
+
+  // Opens the segment "name" for reading. Readers only see the messages
+  // written after they open it. Fails with kUnavailable if the segment has
+  // not been created yet.
+  static ::mediapipe::StatusOr<std::unique_ptr<SharedMemoryRing>> Open(
+      const std::string& name);
+
+  // Unmaps the segment. The writer also closes the ring, and removes the
+  // name, so that readers finish once they have read the last message.
+  ~SharedMemoryRing();
+
+  // Writes a message to the next slot, calling fill with the slot's data
+  // buffer of data_size bytes. Waits up to max_wait for a reader to release
+  // the slot, and returns false if the message was dropped.
+  ::mediapipe::StatusOr<bool> Write(int64 timestamp, uint32 type,
+                                    absl::string_view metadata,
+                                    size_t data_size,
+                                    const std::function<void(uint8*)>& fill,
+                                    absl::Duration max_wait);
+
+  // Returns the next message, waiting up to "timeout" for it to be written.
+  // Returns null if there is none yet, or if the ring is Finished().
+  ::mediapipe::StatusOr<std::shared_ptr<const Message>> Read(
+      absl::Duration timeout);
+
+  // Returns true once the writer has closed the ring and all of its messages
+  // have been read or skipped.
+  bool Finished() const;
+
+  // The number of messages this reader skipped because the writer had
+  // already reused their slots.
+  int64 skipped_count() const { return skipped_count_; }
+
+  int num_slots() const;
+  size_t max_data_size() const;
+
+ private:
+  struct Segment;
+  struct RingHeader;
+  struct SlotHeader;
+
+  SharedMemoryRing(const std::string& name, std::shared_ptr<Segment> segment,
+                   bool is_writer);
+
+  RingHeader* header() const;
+  SlotHeader* slot(uint64 sequence) const;
+
+  const std::string name_;
+  // Shared with the messages read from it, which keep the mapping alive.
+  std::shared_ptr<Segment> segment_;
+  const bool is_writer_;
+  // The sequence number of the next message to write or read.
+  uint64 next_sequence_ = 0;
+  int64 skipped_count_ = 0;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_SHARED_MEMORY_RING_H_
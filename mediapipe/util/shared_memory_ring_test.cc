@@ -0,0 +1,150 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/shared_memory_ring.h"
+
+#include <unistd.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr uint32 kType = 7;
+constexpr size_t kDataSize = 10;
+
+std::string UniqueName(const std::string& test_name) {
+  return absl::StrCat("/mediapipe_", test_name, "_", getpid());
+}
+
+std::function<void(uint8*)> FillWith(uint8 value) {
+  return [value](uint8* data) { memset(data, value, kDataSize); };
+}
+
+class SharedMemoryRingTest : public ::testing::Test {
+ protected:
+  void SetUpRing(const std::string& test_name, int num_slots) {
+    auto writer = SharedMemoryRing::Create(UniqueName(test_name), num_slots,
+                                           /*max_data_size=*/kDataSize);
+    MP_ASSERT_OK(writer.status());
+    writer_ = std::move(writer.ValueOrDie());
+    auto reader = SharedMemoryRing::Open(UniqueName(test_name));
+    MP_ASSERT_OK(reader.status());
+    reader_ = std::move(reader.ValueOrDie());
+  }
+
+  // Writes a message without waiting for its slot, and returns whether it was
+  // written.
+  bool Write(int64 timestamp, uint8 value) {
+    auto written = writer_->Write(timestamp, kType, "", kDataSize,
+                                  FillWith(value), absl::ZeroDuration());
+    EXPECT_TRUE(written.ok());
+    return written.ok() && written.ValueOrDie();
+  }
+
+  std::shared_ptr<const SharedMemoryRing::Message> Read() {
+    auto message = reader_->Read(absl::Milliseconds(10));
+    EXPECT_TRUE(message.ok());
+    return message.ok() ? message.ValueOrDie() : nullptr;
+  }
+
+  std::unique_ptr<SharedMemoryRing> writer_;
+  std::unique_ptr<SharedMemoryRing> reader_;
+};
+
+TEST_F(SharedMemoryRingTest, ReadsWrittenMessages) {
+  SetUpRing("read", /*num_slots=*/4);
+  EXPECT_EQ(Read(), nullptr);
+
+  auto written = writer_->Write(100, kType, "metadata", kDataSize,
+                                FillWith(42), absl::ZeroDuration());
+  MP_ASSERT_OK(written.status());
+  EXPECT_TRUE(written.ValueOrDie());
+  auto message = Read();
+  ASSERT_NE(message, nullptr);
+  EXPECT_EQ(message->timestamp, 100);
+  EXPECT_EQ(message->type, kType);
+  EXPECT_EQ(message->metadata, "metadata");
+  ASSERT_EQ(message->data_size, kDataSize);
+  EXPECT_EQ(message->data[kDataSize - 1], 42);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(message->data) %
+                SharedMemoryRing::kDataAlignment,
+            0);
+  EXPECT_EQ(Read(), nullptr);
+}
+
+TEST_F(SharedMemoryRingTest, ReaderOpenedLaterStartsAtNextMessage) {
+  SetUpRing("late", /*num_slots=*/4);
+  ASSERT_TRUE(Write(1, 1));
+  auto late_reader = SharedMemoryRing::Open(UniqueName("late"));
+  MP_ASSERT_OK(late_reader.status());
+  ASSERT_TRUE(Write(2, 2));
+
+  auto message = late_reader.ValueOrDie()->Read(absl::Milliseconds(10));
+  MP_ASSERT_OK(message.status());
+  ASSERT_NE(message.ValueOrDie(), nullptr);
+  EXPECT_EQ(message.ValueOrDie()->timestamp, 2);
+}
+
+TEST_F(SharedMemoryRingTest, WriterDoesNotOverwriteHeldSlots) {
+  SetUpRing("held", /*num_slots=*/2);
+  ASSERT_TRUE(Write(1, 1));
+  auto held = Read();
+  ASSERT_NE(held, nullptr);
+  ASSERT_TRUE(Write(2, 2));
+  // The next message goes to the held slot.
+  EXPECT_FALSE(Write(3, 3));
+  EXPECT_EQ(held->data[0], 1);
+
+  held.reset();
+  EXPECT_TRUE(Write(3, 3));
+}
+
+TEST_F(SharedMemoryRingTest, SlowReaderSkipsOverwrittenMessages) {
+  SetUpRing("slow", /*num_slots=*/2);
+  for (int i = 1; i <= 5; ++i) {
+    ASSERT_TRUE(Write(i, i));
+  }
+  auto message = Read();
+  ASSERT_NE(message, nullptr);
+  EXPECT_EQ(message->timestamp, 4);
+  EXPECT_EQ(reader_->skipped_count(), 3);
+}
+
+TEST_F(SharedMemoryRingTest, FinishesAfterWriterIsDestroyed) {
+  SetUpRing("finish", /*num_slots=*/2);
+  ASSERT_TRUE(Write(1, 1));
+  writer_.reset();
+  EXPECT_FALSE(reader_->Finished());
+
+  // A message outlives both rings.
+  auto message = Read();
+  ASSERT_NE(message, nullptr);
+  EXPECT_TRUE(reader_->Finished());
+  reader_.reset();
+  EXPECT_EQ(message->timestamp, 1);
+  EXPECT_EQ(message->data[0], 1);
+
+  auto reopened = SharedMemoryRing::Open(UniqueName("finish"));
+  EXPECT_EQ(reopened.status().code(), ::mediapipe::StatusCode::kUnavailable);
+}
+
+}  // namespace
+}  // namespace mediapipe
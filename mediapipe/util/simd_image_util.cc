@@ -0,0 +1,362 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/simd_image_util.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/util/parallel_for_rows.h"
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#endif  // __wasm_simd128__
+
+namespace mediapipe {
+namespace simd_image_util {
+
+namespace {
+
+// Bands smaller than this are not worth handing to another thread.
+constexpr int kMinRowsPerBand = 16;
+
+// Horizontal bilinear weights are in [0, 1 << kWeightBits), so interpolated
+// values fit in 15 bits. Vertical weights are Q15.
+constexpr int kWeightBits = 7;
+constexpr int kWeightOne = 1 << kWeightBits;
+constexpr int kQ15Bits = 15;
+
+#if defined(__wasm_simd128__)
+// The shuffles below take 16 output bytes from the 32 bytes of two input
+// vectors, the first of which starts at byte "base" of the input.
+
+// Index of the input byte for byte i of output vector v of
+// ThreeToFourChannelsRow(). Alpha bytes are set afterwards.
+template <bool kSwapRedBlue>
+constexpr int ThreeToFourIndex(int v, int i, int base) {
+  return i % 4 == 3 ? 0
+                    : 3 * ((16 * v + i) / 4) +
+                          (kSwapRedBlue ? 2 - i % 4 : i % 4) - base;
+}
+
+// Index of the input byte for byte i of output vector v of
+// FourToThreeChannelsRow().
+template <bool kSwapRedBlue>
+constexpr int FourToThreeIndex(int v, int i, int base) {
+  return 4 * ((16 * v + i) / 3) +
+         (kSwapRedBlue ? 2 - (16 * v + i) % 3 : (16 * v + i) % 3) - base;
+}
+
+#define MP_SHUFFLE_BYTES(a, b, index, v, base)                               \
+  wasm_i8x16_shuffle(a, b, index(v, 0, base), index(v, 1, base),             \
+                     index(v, 2, base), index(v, 3, base), index(v, 4, base), \
+                     index(v, 5, base), index(v, 6, base), index(v, 7, base), \
+                     index(v, 8, base), index(v, 9, base),                   \
+                     index(v, 10, base), index(v, 11, base),                 \
+                     index(v, 12, base), index(v, 13, base),                 \
+                     index(v, 14, base), index(v, 15, base))
+#endif  // __wasm_simd128__
+
+template <bool kSwapRedBlue>
+void ThreeToFourChannelsRow(const uint8* src, int width, uint8* dst) {
+  int x = 0;
+#if defined(__wasm_simd128__)
+  const v128_t alpha = wasm_i32x4_splat(static_cast<int32>(0xFF000000u));
+  // 16 pixels: 48 input bytes, 64 output bytes.
+  for (; x + 16 <= width; x += 16) {
+    const v128_t in0 = wasm_v128_load(src + 3 * x);
+    const v128_t in1 = wasm_v128_load(src + 3 * x + 16);
+    const v128_t in2 = wasm_v128_load(src + 3 * x + 32);
+    uint8* out = dst + 4 * x;
+    wasm_v128_store(
+        out, wasm_v128_or(MP_SHUFFLE_BYTES(in0, in1,
+                                           ThreeToFourIndex<kSwapRedBlue>,
+                                           0, 0),
+                          alpha));
+    wasm_v128_store(
+        out + 16,
+        wasm_v128_or(MP_SHUFFLE_BYTES(in0, in1,
+                                      ThreeToFourIndex<kSwapRedBlue>, 1, 0),
+                     alpha));
+    wasm_v128_store(
+        out + 32,
+        wasm_v128_or(MP_SHUFFLE_BYTES(in1, in2,
+                                      ThreeToFourIndex<kSwapRedBlue>, 2, 16),
+                     alpha));
+    wasm_v128_store(
+        out + 48,
+        wasm_v128_or(MP_SHUFFLE_BYTES(in2, in2,
+                                      ThreeToFourIndex<kSwapRedBlue>, 3, 32),
+                     alpha));
+  }
+#endif  // __wasm_simd128__
+  for (; x < width; ++x) {
+    const uint8* in = src + 3 * x;
+    uint8* out = dst + 4 * x;
+    out[0] = in[kSwapRedBlue ? 2 : 0];
+    out[1] = in[1];
+    out[2] = in[kSwapRedBlue ? 0 : 2];
+    out[3] = 255;
+  }
+}
+
+template <bool kSwapRedBlue>
+void FourToThreeChannelsRow(const uint8* src, int width, uint8* dst) {
+  int x = 0;
+#if defined(__wasm_simd128__)
+  // 16 pixels: 64 input bytes, 48 output bytes.
+  for (; x + 16 <= width; x += 16) {
+    const v128_t in0 = wasm_v128_load(src + 4 * x);
+    const v128_t in1 = wasm_v128_load(src + 4 * x + 16);
+    const v128_t in2 = wasm_v128_load(src + 4 * x + 32);
+    const v128_t in3 = wasm_v128_load(src + 4 * x + 48);
+    uint8* out = dst + 3 * x;
+    wasm_v128_store(out, MP_SHUFFLE_BYTES(in0, in1,
+                                          FourToThreeIndex<kSwapRedBlue>, 0,
+                                          0));
+    wasm_v128_store(out + 16,
+                    MP_SHUFFLE_BYTES(in1, in2, FourToThreeIndex<kSwapRedBlue>,
+                                     1, 16));
+    wasm_v128_store(out + 32,
+                    MP_SHUFFLE_BYTES(in2, in3, FourToThreeIndex<kSwapRedBlue>,
+                                     2, 32));
+  }
+#endif  // __wasm_simd128__
+  for (; x < width; ++x) {
+    const uint8* in = src + 4 * x;
+    uint8* out = dst + 3 * x;
+    out[0] = in[kSwapRedBlue ? 2 : 0];
+    out[1] = in[1];
+    out[2] = in[kSwapRedBlue ? 0 : 2];
+  }
+}
+
+#if defined(__wasm_simd128__)
+#undef MP_SHUFFLE_BYTES
+#endif  // __wasm_simd128__
+
+// Converts the rows of "input" to "output" with row_fn, in parallel.
+void ConvertRows(const cv::Mat& input,
+                 void (*row_fn)(const uint8*, int, uint8*), cv::Mat* output) {
+  ParallelForRows(input.rows, kMinRowsPerBand, [&](int begin, int end) {
+    for (int y = begin; y < end; ++y) {
+      row_fn(input.ptr<uint8>(y), input.cols, output->ptr<uint8>(y));
+    }
+  });
+}
+
+// The two source samples and the weight of the second for each destination
+// sample along one axis.
+struct BilinearTaps {
+  std::vector<int> first;
+  std::vector<int> second;
+  std::vector<int16> weight;
+};
+
+// Computes the taps for resizing src_size samples to dst_size samples, with
+// the same pixel center mapping and border replication as cv::resize(), and
+// weights with weight_bits fractional bits.
+BilinearTaps ComputeTaps(int src_size, int dst_size, int weight_bits) {
+  BilinearTaps taps;
+  taps.first.resize(dst_size);
+  taps.second.resize(dst_size);
+  taps.weight.resize(dst_size);
+  const double scale = static_cast<double>(src_size) / dst_size;
+  for (int d = 0; d < dst_size; ++d) {
+    const double position = std::max(0.0, (d + 0.5) * scale - 0.5);
+    int first = static_cast<int>(position);
+    int weight = static_cast<int>(
+        std::lround((position - first) * (1 << weight_bits)));
+    if (weight == 1 << weight_bits) {
+      ++first;
+      weight = 0;
+    }
+    if (first >= src_size - 1) {
+      first = src_size - 1;
+      weight = 0;
+    }
+    taps.first[d] = first;
+    taps.second[d] = std::min(first + 1, src_size - 1);
+    taps.weight[d] = static_cast<int16>(weight);
+  }
+  return taps;
+}
+
+// Interpolates one source row horizontally into "out", in units of
+// 1 / kWeightOne of a pixel value. The values fit in 15 bits.
+void InterpolateRow(const uint8* src, const BilinearTaps& taps, int channels,
+                    int16* out) {
+  const int width = static_cast<int>(taps.weight.size());
+  for (int x = 0; x < width; ++x) {
+    const uint8* first = src + taps.first[x] * channels;
+    const uint8* second = src + taps.second[x] * channels;
+    const int weight = taps.weight[x];
+    for (int c = 0; c < channels; ++c) {
+      *out++ = static_cast<int16>(first[c] * kWeightOne +
+                                  (second[c] - first[c]) * weight);
+    }
+  }
+}
+
+// Blends two horizontally interpolated rows of n values with the Q15 weight
+// of "row1", and rounds the results to 8 bits. The scalar loop computes
+// exactly what the SIMD loop does with i16x8.q15mulr_sat(), which rounds
+// (a * b + 2^14) >> 15.
+void BlendRows(const int16* row0, const int16* row1, int q15_weight, int n,
+               uint8* dst) {
+  int i = 0;
+#if defined(__wasm_simd128__)
+  const v128_t weights = wasm_i16x8_splat(static_cast<int16>(q15_weight));
+  const v128_t half = wasm_i16x8_splat(kWeightOne / 2);
+  for (; i + 16 <= n; i += 16) {
+    const v128_t a0 = wasm_v128_load(row0 + i);
+    const v128_t a1 = wasm_v128_load(row0 + i + 8);
+    const v128_t b0 = wasm_v128_load(row1 + i);
+    const v128_t b1 = wasm_v128_load(row1 + i + 8);
+    v128_t v0 = wasm_i16x8_add(
+        a0, wasm_i16x8_q15mulr_sat(wasm_i16x8_sub(b0, a0), weights));
+    v128_t v1 = wasm_i16x8_add(
+        a1, wasm_i16x8_q15mulr_sat(wasm_i16x8_sub(b1, a1), weights));
+    v0 = wasm_i16x8_shr(wasm_i16x8_add(v0, half), kWeightBits);
+    v1 = wasm_i16x8_shr(wasm_i16x8_add(v1, half), kWeightBits);
+    wasm_v128_store(dst + i, wasm_u8x16_narrow_i16x8(v0, v1));
+  }
+#endif  // __wasm_simd128__
+  for (; i < n; ++i) {
+    const int delta = row1[i] - row0[i];
+    const int value =
+        row0[i] + ((delta * q15_weight + (1 << (kQ15Bits - 1))) >> kQ15Bits);
+    dst[i] = static_cast<uint8>((value + kWeightOne / 2) >> kWeightBits);
+  }
+}
+
+}  // namespace
+
+void ThreeToFourChannels(const cv::Mat& input, bool swap_red_blue,
+                         cv::Mat* output) {
+  CHECK_EQ(input.type(), CV_8UC3);
+  CHECK_EQ(output->type(), CV_8UC4);
+  CHECK(input.size() == output->size());
+  ConvertRows(input,
+              swap_red_blue ? &ThreeToFourChannelsRow<true>
+                            : &ThreeToFourChannelsRow<false>,
+              output);
+}
+
+void FourToThreeChannels(const cv::Mat& input, bool swap_red_blue,
+                         cv::Mat* output) {
+  CHECK_EQ(input.type(), CV_8UC4);
+  CHECK_EQ(output->type(), CV_8UC3);
+  CHECK(input.size() == output->size());
+  ConvertRows(input,
+              swap_red_blue ? &FourToThreeChannelsRow<true>
+                            : &FourToThreeChannelsRow<false>,
+              output);
+}
+
+void ResizeBilinear(const cv::Mat& input, const cv::Size& size,
+                    cv::Mat* output) {
+  CHECK_EQ(input.depth(), CV_8U);
+  CHECK_LE(input.channels(), 4);
+  CHECK(!input.empty());
+  CHECK_GT(size.area(), 0);
+  output->create(size, input.type());
+  CHECK_NE(input.data, output->data);
+
+  const int channels = input.channels();
+  const int row_values = size.width * channels;
+  const BilinearTaps x_taps = ComputeTaps(input.cols, size.width, kWeightBits);
+  const BilinearTaps y_taps = ComputeTaps(input.rows, size.height, kQ15Bits);
+  ParallelForRows(size.height, kMinRowsPerBand, [&](int begin, int end) {
+    // The interpolated source rows, kept while consecutive output rows use
+    // them. The two rows an output row uses are adjacent, so they go to
+    // different slots, except at the border where they are the same row.
+    std::vector<int16> rows[2] = {std::vector<int16>(row_values),
+                                  std::vector<int16>(row_values)};
+    int cached_rows[2] = {-1, -1};
+    auto interpolated_row = [&](int src_y) {
+      const int slot = src_y & 1;
+      if (cached_rows[slot] != src_y) {
+        InterpolateRow(input.ptr<uint8>(src_y), x_taps, channels,
+                       rows[slot].data());
+        cached_rows[slot] = src_y;
+      }
+      return rows[slot].data();
+    };
+    for (int y = begin; y < end; ++y) {
+      const int16* row0 = interpolated_row(y_taps.first[y]);
+      const int16* row1 = interpolated_row(y_taps.second[y]);
+      BlendRows(row0, row1, y_taps.weight[y], row_values,
+                output->ptr<uint8>(y));
+    }
+  });
+}
+
+void NormalizeRow(const uint8* src, int num_pixels, int src_channels,
+                  int dst_channels, float div, float sub, float* dst) {
+  int pixel = 0;
+#if defined(__wasm_simd128__)
+  const v128_t divs = wasm_f32x4_splat(div);
+  const v128_t subs = wasm_f32x4_splat(sub);
+  // Converts 4 unsigned 32-bit lanes to floats and normalizes them.
+  auto normalize = [&divs, &subs](v128_t words) {
+    return wasm_f32x4_sub(
+        wasm_f32x4_div(wasm_f32x4_convert_u32x4(words), divs), subs);
+  };
+  if (src_channels == dst_channels) {
+    const int n = num_pixels * src_channels;
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+      const v128_t bytes = wasm_v128_load(src + i);
+      const v128_t low = wasm_u16x8_extend_low_u8x16(bytes);
+      const v128_t high = wasm_u16x8_extend_high_u8x16(bytes);
+      wasm_v128_store(dst + i, normalize(wasm_u32x4_extend_low_u16x8(low)));
+      wasm_v128_store(dst + i + 4,
+                      normalize(wasm_u32x4_extend_high_u16x8(low)));
+      wasm_v128_store(dst + i + 8,
+                      normalize(wasm_u32x4_extend_low_u16x8(high)));
+      wasm_v128_store(dst + i + 12,
+                      normalize(wasm_u32x4_extend_high_u16x8(high)));
+    }
+    pixel = i / src_channels;
+    src += pixel * src_channels;
+    dst += pixel * dst_channels;
+  } else if (src_channels == 4 && dst_channels == 3) {
+    // 4 pixels: 16 input bytes, 12 output floats.
+    for (; pixel + 4 <= num_pixels; pixel += 4) {
+      const v128_t bytes = wasm_i8x16_shuffle(
+          wasm_v128_load(src), wasm_v128_load(src), 0, 1, 2, 4, 5, 6, 8, 9,
+          10, 12, 13, 14, 0, 0, 0, 0);
+      const v128_t low = wasm_u16x8_extend_low_u8x16(bytes);
+      const v128_t high = wasm_u16x8_extend_high_u8x16(bytes);
+      wasm_v128_store(dst, normalize(wasm_u32x4_extend_low_u16x8(low)));
+      wasm_v128_store(dst + 4, normalize(wasm_u32x4_extend_high_u16x8(low)));
+      wasm_v128_store(dst + 8, normalize(wasm_u32x4_extend_low_u16x8(high)));
+      src += 16;
+      dst += 12;
+    }
+  }
+#endif  // __wasm_simd128__
+  for (; pixel < num_pixels; ++pixel) {
+    for (int c = 0; c < dst_channels; ++c) {
+      *dst++ = src[c] / div - sub;
+    }
+    src += src_channels;
+  }
+}
+
+}  // namespace simd_image_util
+}  // namespace mediapipe
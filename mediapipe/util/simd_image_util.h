@@ -0,0 +1,63 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Kernels for the CPU image conversions on the face detection path: channel
+// reordering, bilinear resizing and normalization of 8-bit pixels into float
+// tensors. They have WebAssembly SIMD (simd128) implementations, selected at
+// compile time with -msimd128, and portable scalar loops elsewhere. Native
+// builds use libyuv and OpenCV for the first two instead, which pick SSE/AVX
+// or NEON kernels at runtime but have no WebAssembly SIMD variants. Rows are
+// split across threads with ParallelForRows(), which runs on Web Workers in
+// builds with pthreads.
+
+#ifndef MEDIAPIPE_UTIL_SIMD_IMAGE_UTIL_H_
+#define MEDIAPIPE_UTIL_SIMD_IMAGE_UTIL_H_
+
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+
+namespace mediapipe {
+namespace simd_image_util {
+
+// Converts "input" (CV_8UC3) into "output" (CV_8UC4, same size), setting
+// alpha to 255. If swap_red_blue is true, channels 0 and 2 are swapped, as
+// in cv::COLOR_RGB2BGRA; otherwise the byte order is kept.
+void ThreeToFourChannels(const cv::Mat& input, bool swap_red_blue,
+                         cv::Mat* output);
+
+// Converts "input" (CV_8UC4) into "output" (CV_8UC3, same size), dropping
+// alpha. If swap_red_blue is true, channels 0 and 2 are swapped, as in
+// cv::COLOR_BGRA2RGB.
+void FourToThreeChannels(const cv::Mat& input, bool swap_red_blue,
+                         cv::Mat* output);
+
+// Resizes "input" (8-bit, 1 to 4 channels) to "size" with bilinear
+// interpolation, sampling at pixel centers and replicating the border like
+// cv::resize() with cv::INTER_LINEAR. Horizontal weights are rounded to 7
+// bits, so results may differ from OpenCV's by 1, or by 2 at sharp edges.
+// "output" is (re)allocated as needed and must not alias "input".
+void ResizeBilinear(const cv::Mat& input, const cv::Size& size,
+                    cv::Mat* output);
+
+// Writes src[c] / div - sub for the first dst_channels channels of each of
+// the num_pixels pixels at "src", which have src_channels channels each, to
+// consecutive floats at "dst". The results are identical to the scalar
+// computation.
+void NormalizeRow(const uint8* src, int num_pixels, int src_channels,
+                  int dst_channels, float div, float sub, float* dst);
+
+}  // namespace simd_image_util
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_SIMD_IMAGE_UTIL_H_
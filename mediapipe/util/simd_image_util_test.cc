@@ -0,0 +1,125 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "mediapipe/util/simd_image_util.h"
+
+#include <cstdlib>
+#include <vector>
+
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+
+namespace mediapipe {
+namespace simd_image_util {
+namespace {
+
+cv::Mat MakePattern(int rows, int cols, int type, int seed) {
+  cv::Mat mat(rows, cols, type);
+  for (int row = 0; row < rows; ++row) {
+    uint8* pixel = mat.ptr<uint8>(row);
+    for (int i = 0; i < cols * mat.channels(); ++i) {
+      pixel[i] = (row * 31 + i * 7 + seed) % 256;
+    }
+  }
+  return mat;
+}
+
+// A pattern with gradients of at most 1 per pixel, for comparing
+// interpolation results with OpenCV's.
+cv::Mat MakeSmoothPattern(int rows, int cols, int type) {
+  cv::Mat mat(rows, cols, type);
+  for (int row = 0; row < rows; ++row) {
+    uint8* pixel = mat.ptr<uint8>(row);
+    for (int col = 0; col < cols; ++col) {
+      for (int c = 0; c < mat.channels(); ++c) {
+        *pixel++ = (row + col + c * 20) % 256;
+      }
+    }
+  }
+  return mat;
+}
+
+TEST(SimdImageUtilTest, ThreeToFourChannels) {
+  // Odd width so the vector kernels also run their tail.
+  const cv::Mat input = MakePattern(37, 67, CV_8UC3, 1);
+  for (bool swap_red_blue : {false, true}) {
+    cv::Mat output(37, 67, CV_8UC4);
+    ThreeToFourChannels(input, swap_red_blue, &output);
+    for (int row = 0; row < input.rows; ++row) {
+      for (int col = 0; col < input.cols; ++col) {
+        const uint8* in = input.ptr<uint8>(row) + col * 3;
+        const uint8* out = output.ptr<uint8>(row) + col * 4;
+        ASSERT_EQ(in[swap_red_blue ? 2 : 0], out[0]);
+        ASSERT_EQ(in[1], out[1]);
+        ASSERT_EQ(in[swap_red_blue ? 0 : 2], out[2]);
+        ASSERT_EQ(255, out[3]);
+      }
+    }
+  }
+}
+
+TEST(SimdImageUtilTest, FourToThreeChannels) {
+  const cv::Mat input = MakePattern(37, 67, CV_8UC4, 2);
+  for (bool swap_red_blue : {false, true}) {
+    cv::Mat output(37, 67, CV_8UC3);
+    FourToThreeChannels(input, swap_red_blue, &output);
+    cv::Mat expected;
+    cv::cvtColor(input, expected,
+                 swap_red_blue ? cv::COLOR_BGRA2RGB : cv::COLOR_RGBA2RGB);
+    EXPECT_EQ(0, cv::norm(expected, output, cv::NORM_INF));
+  }
+}
+
+TEST(SimdImageUtilTest, ResizeBilinearMatchesOpenCv) {
+  for (int type : {CV_8UC1, CV_8UC3, CV_8UC4}) {
+    const cv::Mat input = MakeSmoothPattern(61, 83, type);
+    // Downscaling, upscaling and one of each, with odd output widths.
+    for (const cv::Size& size : {cv::Size(41, 23), cv::Size(129, 97),
+                                 cv::Size(37, 128), cv::Size(83, 61)}) {
+      cv::Mat output;
+      ResizeBilinear(input, size, &output);
+      ASSERT_EQ(size, output.size());
+      ASSERT_EQ(type, output.type());
+      cv::Mat expected;
+      cv::resize(input, expected, size, 0, 0, cv::INTER_LINEAR);
+      EXPECT_LE(cv::norm(expected, output, cv::NORM_INF), 1)
+          << "type " << type << " size " << size;
+    }
+  }
+}
+
+TEST(SimdImageUtilTest, NormalizeRow) {
+  const cv::Mat input = MakePattern(1, 67, CV_8UC4, 4);
+  const uint8* src = input.ptr<uint8>(0);
+  for (int src_channels : {3, 4}) {
+    const int num_pixels = 67 * 4 / src_channels;
+    for (int dst_channels = 1; dst_channels <= src_channels; ++dst_channels) {
+      std::vector<float> output(num_pixels * dst_channels);
+      NormalizeRow(src, num_pixels, src_channels, dst_channels, 127.5f, 1.0f,
+                   output.data());
+      for (int pixel = 0; pixel < num_pixels; ++pixel) {
+        for (int c = 0; c < dst_channels; ++c) {
+          ASSERT_EQ(src[pixel * src_channels + c] / 127.5f - 1.0f,
+                    output[pixel * dst_channels + c]);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace simd_image_util
+}  // namespace mediapipe
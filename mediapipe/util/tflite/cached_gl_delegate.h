@@ -0,0 +1,61 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_UTIL_TFLITE_CACHED_GL_DELEGATE_H_
+#define MEDIAPIPE_UTIL_TFLITE_CACHED_GL_DELEGATE_H_
+
+#include <string>
+
+#include "tensorflow/lite/delegates/gpu/gl_delegate.h"
+#include "tensorflow/lite/model.h"
+
+namespace mediapipe {
+
+struct CachedGlDelegateOptions {
+  // Options of the underlying TF Lite GL delegate.
+  TfLiteGpuDelegateOptions delegate_options = TfLiteGpuDelegateOptionsDefault();
+
+  // Directory where the compiled programs are saved, and loaded from on later
+  // runs. It must exist. Since the cached programs are only valid for the
+  // MediaPipe build that wrote them, it should be cleared on app updates, as
+  // Android does for Context.getCodeCacheDir(). If empty, nothing is cached.
+  std::string cache_dir;
+
+  // Identifies the model, e.g. as returned by GetModelToken().
+  std::string model_token;
+};
+
+// Same as TfLiteGpuDelegateCreate, but the compiled model, i.e. the generated
+// shaders with their workgroups and object layout, is saved in
+// options.cache_dir. Later delegates for the same model, options, GPU and
+// driver load it instead of transforming the graph and generating the
+// shaders again. Must be deleted with DeleteCachedGlDelegate.
+TfLiteDelegate* CreateCachedGlDelegate(const CachedGlDelegateOptions& options);
+
+// Destroys a delegate created with CreateCachedGlDelegate.
+void DeleteCachedGlDelegate(TfLiteDelegate* delegate);
+
+// Same as TfLiteGpuDelegateBindBufferToTensor, for a delegate created with
+// CreateCachedGlDelegate.
+TfLiteStatus CachedGlDelegateBindBufferToTensor(TfLiteDelegate* delegate,
+                                                GLuint buffer,
+                                                int tensor_index);
+
+// Returns a token identifying the contents of "model", to be used as
+// CachedGlDelegateOptions::model_token.
+std::string GetModelToken(const tflite::FlatBufferModel& model);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_TFLITE_CACHED_GL_DELEGATE_H_
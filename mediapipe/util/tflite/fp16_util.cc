@@ -0,0 +1,34 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/tflite/fp16_util.h"
+
+namespace mediapipe {
+
+void FloatsToHalves(const float* input, int size, uint16* output) {
+  // Eigen::half has the layout of its bits, and Eigen vectorizes the cast
+  // where the CPU converts halves natively.
+  Eigen::Map<Eigen::Array<Eigen::half, Eigen::Dynamic, 1>>(
+      reinterpret_cast<Eigen::half*>(output), size) =
+      Eigen::Map<const Eigen::ArrayXf>(input, size).cast<Eigen::half>();
+}
+
+void HalvesToFloats(const uint16* input, int size, float* output) {
+  Eigen::Map<Eigen::ArrayXf>(output, size) =
+      Eigen::Map<const Eigen::Array<Eigen::half, Eigen::Dynamic, 1>>(
+          reinterpret_cast<const Eigen::half*>(input), size)
+          .cast<float>();
+}
+
+}  // namespace mediapipe
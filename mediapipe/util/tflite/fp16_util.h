@@ -0,0 +1,41 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_UTIL_TFLITE_FP16_UTIL_H_
+#define MEDIAPIPE_UTIL_TFLITE_FP16_UTIL_H_
+
+#include "Eigen/Core"
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+
+// Returns the IEEE half-precision float nearest to "value", as stored in a
+// kTfLiteFloat16 tensor.
+inline uint16 FloatToHalf(float value) { return Eigen::half(value).x; }
+
+// Returns the value of the IEEE half-precision float "half".
+inline float HalfToFloat(uint16 half) {
+  return static_cast<float>(
+      Eigen::half(Eigen::half_impl::raw_uint16_to_half(half)));
+}
+
+// Converts "size" floats to half-precision floats.
+void FloatsToHalves(const float* input, int size, uint16* output);
+
+// Converts "size" half-precision floats to floats.
+void HalvesToFloats(const uint16* input, int size, float* output);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_TFLITE_FP16_UTIL_H_
@@ -0,0 +1,52 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/tflite/fp16_util.h"
+
+#include <cmath>
+#include <vector>
+
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(Fp16UtilTest, ConvertsValues) {
+  EXPECT_EQ(0x0000, FloatToHalf(0.0f));
+  EXPECT_EQ(0x3C00, FloatToHalf(1.0f));
+  EXPECT_EQ(0xBC00, FloatToHalf(-1.0f));
+  EXPECT_EQ(0x3800, FloatToHalf(0.5f));
+  EXPECT_EQ(0x7C00, FloatToHalf(1e6f));
+  EXPECT_EQ(1.0f, HalfToFloat(0x3C00));
+  EXPECT_EQ(-2.0f, HalfToFloat(0xC000));
+  EXPECT_TRUE(std::isinf(HalfToFloat(0x7C00)));
+}
+
+TEST(Fp16UtilTest, RoundTripsWithinHalfPrecision) {
+  std::vector<float> values;
+  for (int i = 0; i < 257; ++i) {
+    values.push_back(i / 127.5f - 1.0f);
+  }
+  std::vector<uint16> halves(values.size());
+  FloatsToHalves(values.data(), values.size(), halves.data());
+  std::vector<float> round_trip(values.size());
+  HalvesToFloats(halves.data(), halves.size(), round_trip.data());
+  for (int i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(halves[i], FloatToHalf(values[i]));
+    EXPECT_NEAR(values[i], round_trip[i], 1.0f / 1024);
+  }
+}
+
+}  // namespace
+}  // namespace mediapipe
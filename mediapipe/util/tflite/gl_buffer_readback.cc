@@ -0,0 +1,163 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/tflite/gl_buffer_readback.h"
+
+#include <cstring>
+#include <limits>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_split.h"
+#include "mediapipe/framework/port/ret_check.h"
+
+namespace mediapipe {
+
+namespace {
+
+#if HAS_EGL && defined(GL_EXT_buffer_storage)
+constexpr GLbitfield kPersistentMapFlags =
+    GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT_EXT | GL_MAP_COHERENT_BIT_EXT;
+
+// Returns glBufferStorageEXT if the context supports it, or null. As an
+// extension function, it is looked up at runtime.
+PFNGLBUFFERSTORAGEEXTPROC GetBufferStorageFunction() {
+  const char* extensions =
+      reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+  if (!extensions) {
+    return nullptr;
+  }
+  for (absl::string_view extension : absl::StrSplit(extensions, ' ')) {
+    if (extension == "GL_EXT_buffer_storage") {
+      return reinterpret_cast<PFNGLBUFFERSTORAGEEXTPROC>(
+          eglGetProcAddress("glBufferStorageEXT"));
+    }
+  }
+  return nullptr;
+}
+#endif  // HAS_EGL && defined(GL_EXT_buffer_storage)
+
+}  // namespace
+
+// static
+::mediapipe::StatusOr<std::unique_ptr<GlBufferReadback>>
+GlBufferReadback::Create(const std::vector<size_t>& buffer_sizes,
+                         int num_slots) {
+  RET_CHECK_GT(num_slots, 0);
+  bool persistent = false;
+#if HAS_EGL && defined(GL_EXT_buffer_storage)
+  persistent = GetBufferStorageFunction() != nullptr;
+#endif  // HAS_EGL && defined(GL_EXT_buffer_storage)
+  std::unique_ptr<GlBufferReadback> readback(
+      new GlBufferReadback(buffer_sizes, persistent));
+  readback->slots_.resize(num_slots);
+  for (Slot& slot : readback->slots_) {
+    MP_RETURN_IF_ERROR(readback->CreateSlot(&slot));
+  }
+  return std::move(readback);
+}
+
+::mediapipe::Status GlBufferReadback::CreateSlot(Slot* slot) {
+#if HAS_EGL && defined(GL_EXT_buffer_storage)
+  PFNGLBUFFERSTORAGEEXTPROC buffer_storage =
+      persistent_ ? GetBufferStorageFunction() : nullptr;
+#endif  // HAS_EGL && defined(GL_EXT_buffer_storage)
+  slot->buffers.resize(buffer_sizes_.size());
+  glGenBuffers(slot->buffers.size(), slot->buffers.data());
+  for (int i = 0; i < buffer_sizes_.size(); ++i) {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, slot->buffers[i]);
+#if HAS_EGL && defined(GL_EXT_buffer_storage)
+    if (persistent_) {
+      buffer_storage(GL_COPY_WRITE_BUFFER, buffer_sizes_[i], nullptr,
+                     kPersistentMapFlags);
+      const void* data = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0,
+                                          buffer_sizes_[i],
+                                          kPersistentMapFlags);
+      glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+      RET_CHECK(data) << "Cannot map readback buffer: " << glGetError();
+      slot->data.push_back(data);
+      continue;
+    }
+#endif  // HAS_EGL && defined(GL_EXT_buffer_storage)
+    glBufferData(GL_COPY_WRITE_BUFFER, buffer_sizes_[i], nullptr,
+                 GL_STREAM_READ);
+    slot->copies.push_back(absl::make_unique<char[]>(buffer_sizes_[i]));
+    slot->data.push_back(slot->copies.back().get());
+  }
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  return ::mediapipe::OkStatus();
+}
+
+GlBufferReadback::~GlBufferReadback() {
+  for (Slot& slot : slots_) {
+    if (slot.fence) {
+      glDeleteSync(slot.fence);
+    }
+    // Deleting a buffer also unmaps it.
+    glDeleteBuffers(slot.buffers.size(), slot.buffers.data());
+  }
+}
+
+::mediapipe::StatusOr<int> GlBufferReadback::StartRead(
+    const std::vector<GLuint>& buffers) {
+  RET_CHECK_EQ(buffers.size(), buffer_sizes_.size());
+  const int slot_index = next_slot_;
+  Slot& slot = slots_[slot_index];
+  RET_CHECK(!slot.fence) << "Readback slot " << slot_index
+                         << " still has a read in flight.";
+  // Makes the shader writes to the buffers visible to the copies.
+  glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+  for (int i = 0; i < buffers.size(); ++i) {
+    glBindBuffer(GL_COPY_READ_BUFFER, buffers[i]);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, slot.buffers[i]);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                        buffer_sizes_[i]);
+  }
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  RET_CHECK(slot.fence) << "Cannot create fence: " << glGetError();
+  // Submits the copies now, so that they run while the CPU goes on.
+  glFlush();
+  next_slot_ = (next_slot_ + 1) % slots_.size();
+  return slot_index;
+}
+
+::mediapipe::StatusOr<std::vector<const void*>> GlBufferReadback::FinishRead(
+    int slot_index) {
+  RET_CHECK(slot_index >= 0 && slot_index < static_cast<int>(slots_.size()));
+  Slot& slot = slots_[slot_index];
+  RET_CHECK(slot.fence) << "Readback slot " << slot_index
+                        << " has no read in flight.";
+  const GLenum result =
+      glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                       std::numeric_limits<GLuint64>::max());
+  glDeleteSync(slot.fence);
+  slot.fence = nullptr;
+  RET_CHECK(result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+      << "Waiting for readback failed: " << glGetError();
+  if (!persistent_) {
+    for (int i = 0; i < slot.buffers.size(); ++i) {
+      glBindBuffer(GL_COPY_READ_BUFFER, slot.buffers[i]);
+      const void* data = glMapBufferRange(GL_COPY_READ_BUFFER, 0,
+                                          buffer_sizes_[i], GL_MAP_READ_BIT);
+      RET_CHECK(data) << "Cannot map readback buffer: " << glGetError();
+      std::memcpy(slot.copies[i].get(), data, buffer_sizes_[i]);
+      glUnmapBuffer(GL_COPY_READ_BUFFER);
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  }
+  return slot.data;
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,87 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_UTIL_TFLITE_GL_BUFFER_READBACK_H_
+#define MEDIAPIPE_UTIL_TFLITE_GL_BUFFER_READBACK_H_
+
+#include <memory>
+#include <vector>
+
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mediapipe/gpu/gl_base.h"
+
+namespace mediapipe {
+
+// Reads GL buffers, such as the output SSBOs of the TF Lite GL delegate, back
+// to the CPU without stalling the GPU.
+//
+// StartRead() queues copies of the buffers into one of num_slots staging
+// slots, followed by a fence, and returns right away. FinishRead() waits for
+// the fence of a slot and returns the data. Starting the read of one
+// inference and finishing it after the next one has been queued lets the
+// copy overlap the GPU work instead of waiting for the whole pipeline to
+// drain, as a synchronous glMapBufferRange or GlBuffer::Read does.
+//
+// Where GL_EXT_buffer_storage is available, the slots are persistently
+// mapped coherent buffers, and FinishRead() returns pointers to the mapping
+// itself. Otherwise each slot is mapped and copied into CPU memory once its
+// fence is signaled.
+//
+// All methods, including the destructor, must be called with the GL context
+// current.
+class GlBufferReadback {
+ public:
+  // Creates slots for reading buffers of the given sizes, in bytes.
+  static ::mediapipe::StatusOr<std::unique_ptr<GlBufferReadback>> Create(
+      const std::vector<size_t>& buffer_sizes, int num_slots);
+  ~GlBufferReadback();
+
+  GlBufferReadback(const GlBufferReadback&) = delete;
+  GlBufferReadback& operator=(const GlBufferReadback&) = delete;
+
+  // Queues copies of "buffers", one per buffer size, into the next slot, and
+  // returns the slot. The slot must not have a read in flight.
+  ::mediapipe::StatusOr<int> StartRead(const std::vector<GLuint>& buffers);
+
+  // Waits for the read in "slot" to complete, and returns the data of each
+  // buffer. The data remains valid until the slot is started again.
+  ::mediapipe::StatusOr<std::vector<const void*>> FinishRead(int slot);
+
+  // Whether the slots are persistently mapped.
+  bool persistent() const { return persistent_; }
+
+ private:
+  struct Slot {
+    std::vector<GLuint> buffers;
+    // The persistent mappings of buffers, or copies of their contents.
+    std::vector<const void*> data;
+    std::vector<std::unique_ptr<char[]>> copies;
+    GLsync fence = nullptr;
+  };
+
+  GlBufferReadback(const std::vector<size_t>& buffer_sizes, bool persistent)
+      : buffer_sizes_(buffer_sizes), persistent_(persistent) {}
+
+  ::mediapipe::Status CreateSlot(Slot* slot);
+
+  const std::vector<size_t> buffer_sizes_;
+  const bool persistent_;
+  std::vector<Slot> slots_;
+  int next_slot_ = 0;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_TFLITE_GL_BUFFER_READBACK_H_
@@ -15,8 +15,14 @@
 //
 // This version has been modified by MediaPipe authors to support argmax
 // indices. Details of the modification is marked below in the code.
+// The pooling kernel itself has been rewritten to use NEON/SSE2 and multiple
+// threads.
 #include "mediapipe/util/tflite/operations/max_pool_argmax.h"
 
+#include <algorithm>
+#include <limits>
+
+#include "mediapipe/util/tflite/operations/parallel_for.h"
 #include "tensorflow/lite/kernels/internal/common.h"
 #include "tensorflow/lite/kernels/internal/tensor.h"
 #include "tensorflow/lite/kernels/padding.h"
@@ -29,18 +35,98 @@ constexpr int kDataInputTensor = 0;
 constexpr int kOutputTensor = 0;
 constexpr int kIndicesTensor = 1;
 
-// These functions were copied from the following places:
-// https://github.com/tensorflow/tensorflow/blob/master/tensorflow/lite/kernels/internal/reference/reference_ops.h
-// https://github.com/tensorflow/tensorflow/blob/master/tensorflow/lite/kernels/pooling.cc
+// Computes the max and its argmax for "count" channels of one output pixel.
+// The filter window is [filter_y_start, filter_y_end) x [filter_x_start,
+// filter_x_end), and "in" points at channel 0 of its top left corner (0, 0).
+// Ties keep the first position in row-major order, as in the reference
+// implementation.
+inline void MaxPoolArgmaxPixel(const float* in, int in_row_stride,
+                               int in_pixel_stride, int filter_y_start,
+                               int filter_y_end, int filter_x_start,
+                               int filter_x_end, int filter_width, int count,
+                               float activation_min, float activation_max,
+                               float* out, float* indices) {
+  int channel = 0;
+#if defined(MEDIAPIPE_TFLITE_OPS_USE_NEON)
+  for (; channel + 4 <= count; channel += 4) {
+    float32x4_t max = vdupq_n_f32(std::numeric_limits<float>::lowest());
+    float32x4_t argmax = vdupq_n_f32(0.0f);
+    for (int filter_y = filter_y_start; filter_y < filter_y_end; ++filter_y) {
+      const float* row = in + filter_y * in_row_stride + channel;
+      for (int filter_x = filter_x_start; filter_x < filter_x_end;
+           ++filter_x) {
+        const float32x4_t cur = vld1q_f32(row + filter_x * in_pixel_stride);
+        const uint32x4_t greater = vcgtq_f32(cur, max);
+        max = vbslq_f32(greater, cur, max);
+        argmax = vbslq_f32(
+            greater, vdupq_n_f32(filter_y * filter_width + filter_x), argmax);
+      }
+    }
+    max = vminq_f32(vmaxq_f32(max, vdupq_n_f32(activation_min)),
+                    vdupq_n_f32(activation_max));
+    vst1q_f32(out + channel, max);
+    if (indices) {
+      vst1q_f32(indices + channel, vaddq_f32(argmax, vdupq_n_f32(0.1f)));
+    }
+  }
+#elif defined(MEDIAPIPE_TFLITE_OPS_USE_SSE2)
+  for (; channel + 4 <= count; channel += 4) {
+    __m128 max = _mm_set1_ps(std::numeric_limits<float>::lowest());
+    __m128 argmax = _mm_setzero_ps();
+    for (int filter_y = filter_y_start; filter_y < filter_y_end; ++filter_y) {
+      const float* row = in + filter_y * in_row_stride + channel;
+      for (int filter_x = filter_x_start; filter_x < filter_x_end;
+           ++filter_x) {
+        const __m128 cur = _mm_loadu_ps(row + filter_x * in_pixel_stride);
+        const __m128 greater = _mm_cmpgt_ps(cur, max);
+        max = _mm_or_ps(_mm_and_ps(greater, cur), _mm_andnot_ps(greater, max));
+        const __m128 position =
+            _mm_set1_ps(static_cast<float>(filter_y * filter_width + filter_x));
+        argmax = _mm_or_ps(_mm_and_ps(greater, position),
+                           _mm_andnot_ps(greater, argmax));
+      }
+    }
+    max = _mm_min_ps(_mm_max_ps(max, _mm_set1_ps(activation_min)),
+                     _mm_set1_ps(activation_max));
+    _mm_storeu_ps(out + channel, max);
+    if (indices) {
+      _mm_storeu_ps(indices + channel, _mm_add_ps(argmax, _mm_set1_ps(0.1f)));
+    }
+  }
+#endif
+  for (; channel < count; ++channel) {
+    float max = std::numeric_limits<float>::lowest();
+    int max_x = 0;
+    int max_y = 0;
+    for (int filter_y = filter_y_start; filter_y < filter_y_end; ++filter_y) {
+      const float* row = in + filter_y * in_row_stride + channel;
+      for (int filter_x = filter_x_start; filter_x < filter_x_end;
+           ++filter_x) {
+        const float cur = row[filter_x * in_pixel_stride];
+        if (cur > max) {
+          max = cur;
+          max_x = filter_x;
+          max_y = filter_y;
+        }
+      }
+    }
+    out[channel] = ::tflite::ActivationFunctionWithMinMax(max, activation_min,
+                                                          activation_max);
+    if (indices) {
+      indices[channel] = max_y * filter_width + max_x + 0.1f;
+    }
+  }
+}
 
-inline void MaxPoolArgmax(const ::tflite::PoolParams& params,
+// Optimized version of the reference MaxPoolArgmax: the channels of each
+// output pixel are processed 4 at a time with NEON or SSE2, and the output
+// rows are split across the interpreter's CPU threads.
+inline void MaxPoolArgmax(TfLiteContext* context,
+                          const ::tflite::PoolParams& params,
                           const ::tflite::RuntimeShape& input_shape,
                           const float* input_data,
                           const ::tflite::RuntimeShape& output_shape,
                           float* output_data, float* indices_data) {
-  // Start of copy from
-  // https://github.com/tensorflow/tensorflow/blob/master/tensorflow/lite/kernels/internal/reference/reference_ops.h
-  // Start of MediaPipe modificiation.
   TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
   TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
   const int batches = MatchingDim(input_shape, 0, output_shape, 0);
@@ -51,54 +137,42 @@ inline void MaxPoolArgmax(const ::tflite::PoolParams& params,
   const int output_width = output_shape.Dims(2);
   const int stride_height = params.stride_height;
   const int stride_width = params.stride_width;
-  for (int batch = 0; batch < batches; ++batch) {
-    for (int out_y = 0; out_y < output_height; ++out_y) {
-      for (int out_x = 0; out_x < output_width; ++out_x) {
-        for (int channel = 0; channel < depth; ++channel) {
-          const int in_x_origin =
-              (out_x * stride_width) - params.padding_values.width;
+  const int in_row_stride = input_width * depth;
+
+  RunInParallel(
+      context, batches * output_height, [&](int row_begin, int row_end) {
+        for (int row = row_begin; row < row_end; ++row) {
+          const int batch = row / output_height;
+          const int out_y = row % output_height;
           const int in_y_origin =
               (out_y * stride_height) - params.padding_values.height;
           // Compute the boundaries of the filter region clamped so as to
           // ensure that the filter window fits in the input array.
-          const int filter_x_start = std::max(0, -in_x_origin);
-          const int filter_x_end =
-              std::min(params.filter_width, input_width - in_x_origin);
           const int filter_y_start = std::max(0, -in_y_origin);
           const int filter_y_end =
               std::min(params.filter_height, input_height - in_y_origin);
-          float max = std::numeric_limits<float>::lowest();
-          int max_x = 0;
-          int max_y = 0;
-          for (int filter_y = filter_y_start; filter_y < filter_y_end;
-               ++filter_y) {
-            for (int filter_x = filter_x_start; filter_x < filter_x_end;
-                 ++filter_x) {
-              const int in_x = in_x_origin + filter_x;
-              const int in_y = in_y_origin + filter_y;
-              float cur =
-                  input_data[Offset(input_shape, batch, in_y, in_x, channel)];
-              if (cur > max) {
-                max = cur;
-                max_x = filter_x;
-                max_y = filter_y;
-              }
-            }
-          }
-          output_data[Offset(output_shape, batch, out_y, out_x, channel)] =
-              ::tflite::ActivationFunctionWithMinMax(
-                  max, params.float_activation_min,
-                  params.float_activation_max);
-          if (indices_data) {
-            indices_data[Offset(output_shape, batch, out_y, out_x, channel)] =
-                max_y * params.filter_width + max_x + 0.1f;
+          for (int out_x = 0; out_x < output_width; ++out_x) {
+            const int in_x_origin =
+                (out_x * stride_width) - params.padding_values.width;
+            const int filter_x_start = std::max(0, -in_x_origin);
+            const int filter_x_end =
+                std::min(params.filter_width, input_width - in_x_origin);
+            // Points at the (possibly out of bounds) top left corner of the
+            // window; only the clamped region is ever read.
+            const float* in = input_data +
+                              (batch * input_height + in_y_origin) *
+                                  in_row_stride +
+                              in_x_origin * depth;
+            const int out_offset = Offset(output_shape, batch, out_y, out_x, 0);
+            MaxPoolArgmaxPixel(
+                in, in_row_stride, depth, filter_y_start, filter_y_end,
+                filter_x_start, filter_x_end, params.filter_width, depth,
+                params.float_activation_min, params.float_activation_max,
+                output_data + out_offset,
+                indices_data ? indices_data + out_offset : nullptr);
           }
         }
-      }
-    }
-  }
-  // End of MediaPipe modification.
-  // End of copy.
+      });
 }
 
 // Start of copy from
@@ -185,7 +259,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   op_params.padding_values.width = data_padding->width;
   op_params.float_activation_min = activation_min;
   op_params.float_activation_max = activation_max;
-  MaxPoolArgmax(op_params, ::tflite::GetTensorShape(input),
+  MaxPoolArgmax(context, op_params, ::tflite::GetTensorShape(input),
                 ::tflite::GetTensorData<float>(input),
                 ::tflite::GetTensorShape(output),
                 ::tflite::GetTensorData<float>(output),
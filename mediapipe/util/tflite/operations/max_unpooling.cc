@@ -14,6 +14,9 @@
 
 #include "mediapipe/util/tflite/operations/max_unpooling.h"
 
+#include <cstring>
+
+#include "mediapipe/util/tflite/operations/parallel_for.h"
 #include "tensorflow/lite/kernels/internal/common.h"
 #include "tensorflow/lite/kernels/internal/tensor.h"
 #include "tensorflow/lite/kernels/padding.h"
@@ -26,6 +29,73 @@ constexpr int kDataInputTensor = 0;
 constexpr int kIndicesTensor = 1;
 constexpr int kOutputTensor = 0;
 
+// Writes "count" channels of the output pixel at window position "position":
+// the input value where the argmax index equals "position", 0 elsewhere.
+inline void UnpoolPixel(const float* in, const float* indices, int position,
+                        int count, float* out) {
+  int channel = 0;
+#if defined(MEDIAPIPE_TFLITE_OPS_USE_NEON)
+  const int32x4_t position_vec = vdupq_n_s32(position);
+  for (; channel + 4 <= count; channel += 4) {
+    const uint32x4_t match =
+        vceqq_s32(vcvtq_s32_f32(vld1q_f32(indices + channel)), position_vec);
+    vst1q_f32(out + channel,
+              vreinterpretq_f32_u32(vandq_u32(
+                  match, vreinterpretq_u32_f32(vld1q_f32(in + channel)))));
+  }
+#elif defined(MEDIAPIPE_TFLITE_OPS_USE_SSE2)
+  const __m128i position_vec = _mm_set1_epi32(position);
+  for (; channel + 4 <= count; channel += 4) {
+    const __m128i match = _mm_cmpeq_epi32(
+        _mm_cvttps_epi32(_mm_loadu_ps(indices + channel)), position_vec);
+    _mm_storeu_ps(out + channel, _mm_and_ps(_mm_castsi128_ps(match),
+                                            _mm_loadu_ps(in + channel)));
+  }
+#endif
+  for (; channel < count; ++channel) {
+    out[channel] =
+        static_cast<int>(indices[channel]) == position ? in[channel] : 0.0f;
+  }
+}
+
+// Fast path for the usual case where the pooling windows tile the output
+// exactly (stride equal to the filter size and no padding). Every output
+// value is then written once, without clearing the output first and without
+// scattered stores, and the input rows are split across the interpreter's
+// CPU threads.
+inline void MaxUnpoolingNonOverlapping(
+    TfLiteContext* context, const ::tflite::PoolParams& params,
+    const ::tflite::RuntimeShape& input_shape, const float* input_data,
+    const float* indices_data, const ::tflite::RuntimeShape& output_shape,
+    float* output_data) {
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int depth = MatchingDim(input_shape, 3, output_shape, 3);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  RunInParallel(
+      context, batches * input_height, [&](int row_begin, int row_end) {
+        for (int row = row_begin; row < row_end; ++row) {
+          const int batch = row / input_height;
+          const int in_y = row % input_height;
+          for (int in_x = 0; in_x < input_width; ++in_x) {
+            const int input_offset = Offset(input_shape, batch, in_y, in_x, 0);
+            for (int filter_y = 0; filter_y < params.filter_height;
+                 ++filter_y) {
+              const int out_y = in_y * params.filter_height + filter_y;
+              for (int filter_x = 0; filter_x < params.filter_width;
+                   ++filter_x) {
+                const int out_x = in_x * params.filter_width + filter_x;
+                UnpoolPixel(
+                    input_data + input_offset, indices_data + input_offset,
+                    filter_y * params.filter_width + filter_x, depth,
+                    output_data + Offset(output_shape, batch, out_y, out_x, 0));
+              }
+            }
+          }
+        }
+      });
+}
+
 inline void MaxUnpooling(const ::tflite::PoolParams& params,
                          const ::tflite::RuntimeShape& input_shape,
                          const float* input_data, const float* indices_data,
@@ -124,11 +194,23 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   op_params.padding_values.width = data_padding->width;
   op_params.float_activation_min = activation_min;
   op_params.float_activation_max = activation_max;
-  MaxUnpooling(op_params, ::tflite::GetTensorShape(input),
-               ::tflite::GetTensorData<float>(input),
-               ::tflite::GetTensorData<float>(indices),
-               ::tflite::GetTensorShape(output),
-               ::tflite::GetTensorData<float>(output));
+  if (op_params.stride_height == op_params.filter_height &&
+      op_params.stride_width == op_params.filter_width &&
+      op_params.padding_values.height == 0 &&
+      op_params.padding_values.width == 0) {
+    MaxUnpoolingNonOverlapping(context, op_params,
+                               ::tflite::GetTensorShape(input),
+                               ::tflite::GetTensorData<float>(input),
+                               ::tflite::GetTensorData<float>(indices),
+                               ::tflite::GetTensorShape(output),
+                               ::tflite::GetTensorData<float>(output));
+  } else {
+    MaxUnpooling(op_params, ::tflite::GetTensorShape(input),
+                 ::tflite::GetTensorData<float>(input),
+                 ::tflite::GetTensorData<float>(indices),
+                 ::tflite::GetTensorShape(output),
+                 ::tflite::GetTensorData<float>(output));
+  }
   return kTfLiteOk;
 }
 
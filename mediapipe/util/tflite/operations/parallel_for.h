@@ -0,0 +1,78 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Helpers shared by the optimized CPU kernels of the MediaPipe custom ops:
+// row-parallel execution on the threads of the interpreter's
+// CpuBackendContext, and the 4-lane SIMD flavor available on the target.
+
+#ifndef MEDIAPIPE_UTIL_TFLITE_OPERATIONS_PARALLEL_FOR_H_
+#define MEDIAPIPE_UTIL_TFLITE_OPERATIONS_PARALLEL_FOR_H_
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_threadpool.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define MEDIAPIPE_TFLITE_OPS_USE_NEON
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#define MEDIAPIPE_TFLITE_OPS_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace mediapipe {
+namespace tflite_operations {
+
+// Splits [0, num_rows) into contiguous ranges and calls fn(begin, end) once
+// per range, using up to the number of threads the interpreter was configured
+// with (Interpreter::SetNumThreads). Returns once all ranges are done. fn must
+// be safe to call concurrently for disjoint ranges.
+inline void RunInParallel(TfLiteContext* context, int num_rows,
+                          const std::function<void(int, int)>& fn) {
+  ::tflite::CpuBackendContext* cpu_backend_context =
+      ::tflite::CpuBackendContext::GetFromContext(context);
+  const int num_tasks =
+      std::min(num_rows, cpu_backend_context->max_num_threads());
+  if (num_tasks <= 1) {
+    fn(0, num_rows);
+    return;
+  }
+
+  struct RowsTask : ::tflite::cpu_backend_threadpool::Task {
+    RowsTask(const std::function<void(int, int)>* fn, int begin, int end)
+        : fn(fn), begin(begin), end(end) {}
+    void Run() override { (*fn)(begin, end); }
+
+    const std::function<void(int, int)>* fn;
+    int begin;
+    int end;
+  };
+  std::vector<RowsTask> tasks;
+  tasks.reserve(num_tasks);
+  for (int i = 0; i < num_tasks; ++i) {
+    tasks.emplace_back(&fn, num_rows * i / num_tasks,
+                       num_rows * (i + 1) / num_tasks);
+  }
+  ::tflite::cpu_backend_threadpool::Execute(num_tasks, tasks.data(),
+                                            cpu_backend_context);
+}
+
+}  // namespace tflite_operations
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_TFLITE_OPERATIONS_PARALLEL_FOR_H_
@@ -14,10 +14,17 @@
 // limitations under the License.
 //
 // This version has been modified by MediaPipe authors to support bias. Details
-// of the modification is marked below in the code.
+// of the modification is marked below in the code. The convolution itself has
+// been rewritten as a GEMM followed by a multithreaded col2im, in the way of
+// TFLite's optimized TransposeConvV2.
 
 #include "mediapipe/util/tflite/operations/transpose_conv_bias.h"
 
+#include <algorithm>
+
+#include "mediapipe/util/tflite/operations/parallel_for.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_gemm.h"
 #include "tensorflow/lite/kernels/internal/tensor.h"
 #include "tensorflow/lite/kernels/padding.h"
 
@@ -29,88 +36,150 @@ constexpr int kWeightsTensor = 1;
 constexpr int kBiasTensor = 2;
 constexpr int kDataInputTensor = 0;
 constexpr int kOutputTensor = 0;
+constexpr int kCol2ImTemporary = 0;
+constexpr int kTransposedWeightsTemporary = 1;
+
+struct OpData {
+  // Index of the first of the two scratch tensors added in Init; the
+  // transposed weights use the next one.
+  int col2im_id = 0;
+  // Whether the transposed weights tensor is up to date. Only stays true
+  // across Evals when the weights are constant.
+  bool weights_are_transposed = false;
+};
+
+// Adds "count" floats of "in" to "out".
+inline void AccumulateVector(const float* in, int count, float* out) {
+  int i = 0;
+#if defined(MEDIAPIPE_TFLITE_OPS_USE_NEON)
+  for (; i + 4 <= count; i += 4) {
+    vst1q_f32(out + i, vaddq_f32(vld1q_f32(out + i), vld1q_f32(in + i)));
+  }
+#elif defined(MEDIAPIPE_TFLITE_OPS_USE_SSE2)
+  for (; i + 4 <= count; i += 4) {
+    _mm_storeu_ps(out + i,
+                  _mm_add_ps(_mm_loadu_ps(out + i), _mm_loadu_ps(in + i)));
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] += in[i];
+  }
+}
 
-// These functions were copied from the following places:
-// https://github.com/tensorflow/tensorflow/blob/master/tensorflow/lite/kernels/internal/reference/reference_ops.h
-// https://github.com/tensorflow/tensorflow/blob/master/tensorflow/lite/kernels/transpose_conv.cc
+// Reorders OHWI weights to HWOI, so that a single GEMM produces, for every
+// input pixel, its contribution to each filter tap as a contiguous run of
+// output channels.
+void TransposeWeights(const TfLiteTensor* weights,
+                      TfLiteTensor* transposed_weights) {
+  const int output_depth = ::tflite::SizeOfDimension(weights, 0);
+  const int filter_height = ::tflite::SizeOfDimension(weights, 1);
+  const int filter_width = ::tflite::SizeOfDimension(weights, 2);
+  const int input_depth = ::tflite::SizeOfDimension(weights, 3);
+  const float* in = ::tflite::GetTensorData<float>(weights);
+  float* out = ::tflite::GetTensorData<float>(transposed_weights);
+  for (int out_channel = 0; out_channel < output_depth; ++out_channel) {
+    for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
+      for (int filter_x = 0; filter_x < filter_width; ++filter_x) {
+        const int out_offset =
+            ((filter_y * filter_width + filter_x) * output_depth +
+             out_channel) *
+            input_depth;
+        std::copy(in, in + input_depth, out + out_offset);
+        in += input_depth;
+      }
+    }
+  }
+}
 
+// Computes the transposed convolution with bias. For each batch, one GEMM
+// multiplies the input pixels by the HWOI weights into "col2im_data", which
+// holds for every input pixel and filter tap the contribution to the output
+// channels. The contributions are then summed into the output on top of the
+// bias. The GEMM runs on the interpreter's CpuBackendContext, and the col2im
+// step splits the output rows across the same threads: each output row only
+// reads the contributions that land on it, so the rows are independent.
 inline void TransposeConvBias(
-    const ::tflite::ConvParams& params,
+    TfLiteContext* context, const ::tflite::ConvParams& params,
     const ::tflite::RuntimeShape& input_shape, const float* input_data,
-    const ::tflite::RuntimeShape& filter_shape, const float* filter_data,
-    const ::tflite::RuntimeShape& bias_shape, const float* bias_data,
+    const ::tflite::RuntimeShape& hwoi_filter_shape,
+    const float* hwoi_filter_data, const float* bias_data,
     const ::tflite::RuntimeShape& output_shape, float* output_data,
-    const ::tflite::RuntimeShape& im2col_shape, float* im2col_data) {
-  // Start of copy from
-  // https://github.com/tensorflow/tensorflow/blob/master/tensorflow/lite/kernels/internal/reference/reference_ops.h
+    float* col2im_data) {
   const int stride_width = params.stride_width;
   const int stride_height = params.stride_height;
   const int pad_width = params.padding_values.width;
   const int pad_height = params.padding_values.height;
 
   TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
-  TFLITE_DCHECK_EQ(filter_shape.DimensionsCount(), 4);
-  TFLITE_DCHECK_EQ(bias_shape.DimensionsCount(), 1);
+  TFLITE_DCHECK_EQ(hwoi_filter_shape.DimensionsCount(), 4);
   TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
-  (void)im2col_data;   // only used in optimized code.
-  (void)im2col_shape;  // only used in optimized code.
 
   const int batches = MatchingDim(input_shape, 0, output_shape, 0);
-  const int input_depth = MatchingDim(input_shape, 3, filter_shape, 3);
-  const int output_depth = MatchingDim(filter_shape, 0, output_shape, 3);
+  const int input_depth = MatchingDim(input_shape, 3, hwoi_filter_shape, 3);
+  const int output_depth = MatchingDim(hwoi_filter_shape, 2, output_shape, 3);
   const int input_height = input_shape.Dims(1);
   const int input_width = input_shape.Dims(2);
-  const int filter_height = filter_shape.Dims(1);
-  const int filter_width = filter_shape.Dims(2);
+  const int filter_height = hwoi_filter_shape.Dims(0);
+  const int filter_width = hwoi_filter_shape.Dims(1);
   const int output_height = output_shape.Dims(1);
   const int output_width = output_shape.Dims(2);
-
-  // Start of MediaPipe modificiation.
+  const int input_image_size = input_height * input_width;
+  const int taps_size = filter_height * filter_width * output_depth;
+
+  ::tflite::cpu_backend_gemm::MatrixParams<float> lhs_params;
+  lhs_params.order = ::tflite::cpu_backend_gemm::Order::kRowMajor;
+  lhs_params.rows = taps_size;
+  lhs_params.cols = input_depth;
+  ::tflite::cpu_backend_gemm::MatrixParams<float> rhs_params;
+  rhs_params.order = ::tflite::cpu_backend_gemm::Order::kColMajor;
+  rhs_params.rows = input_depth;
+  rhs_params.cols = input_image_size;
+  ::tflite::cpu_backend_gemm::MatrixParams<float> dst_params;
+  dst_params.order = ::tflite::cpu_backend_gemm::Order::kColMajor;
+  dst_params.rows = taps_size;
+  dst_params.cols = input_image_size;
+  ::tflite::cpu_backend_gemm::GemmParams<float, float> gemm_params;
 
   for (int batch = 0; batch < batches; ++batch) {
-    for (int out_y = 0; out_y < output_height; out_y++) {
-      for (int out_x = 0; out_x < output_width; out_x++) {
-        for (int out_channel = 0; out_channel < output_depth; out_channel++) {
-          output_data[Offset(output_shape, batch, out_y, out_x, out_channel)] =
-              bias_data[out_channel];
+    ::tflite::cpu_backend_gemm::Gemm(
+        lhs_params, hwoi_filter_data, rhs_params,
+        input_data + batch * input_image_size * input_depth, dst_params,
+        col2im_data, gemm_params,
+        ::tflite::CpuBackendContext::GetFromContext(context));
+
+    RunInParallel(context, output_height, [&](int row_begin, int row_end) {
+      for (int out_y = row_begin; out_y < row_end; ++out_y) {
+        float* out_row =
+            output_data + Offset(output_shape, batch, out_y, 0, 0);
+        for (int out_x = 0; out_x < output_width; ++out_x) {
+          std::copy(bias_data, bias_data + output_depth,
+                    out_row + out_x * output_depth);
         }
-      }
-    }
-
-    for (int in_y = 0; in_y < input_height; ++in_y) {
-      for (int in_x = 0; in_x < input_width; ++in_x) {
-        for (int in_channel = 0; in_channel < input_depth; ++in_channel) {
-          // Loop through the output elements it will influence
-          const int out_x_origin = (in_x * stride_width) - pad_width;
-          const int out_y_origin = (in_y * stride_height) - pad_height;
-          for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
+        for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
+          // Finds the input row, if any, whose filter tap "filter_y" lands
+          // on this output row.
+          const int in_y_scaled = out_y + pad_height - filter_y;
+          if (in_y_scaled < 0 || in_y_scaled % stride_height != 0) continue;
+          const int in_y = in_y_scaled / stride_height;
+          if (in_y >= input_height) continue;
+          for (int in_x = 0; in_x < input_width; ++in_x) {
+            const float* taps =
+                col2im_data +
+                ((in_y * input_width + in_x) * filter_height + filter_y) *
+                    filter_width * output_depth;
+            const int out_x_origin = in_x * stride_width - pad_width;
             for (int filter_x = 0; filter_x < filter_width; ++filter_x) {
-              for (int out_channel = 0; out_channel < output_depth;
-                   ++out_channel) {
-                // Compute output element location
-                const int out_x = out_x_origin + filter_x;
-                const int out_y = out_y_origin + filter_y;
-                // We cannot accumulate out of bounds
-                if ((out_x >= 0) && (out_x < output_width) && (out_y >= 0) &&
-                    (out_y < output_height)) {
-                  float input_value = input_data[Offset(
-                      input_shape, batch, in_y, in_x, in_channel)];
-                  float filter_value =
-                      filter_data[Offset(filter_shape, out_channel, filter_y,
-                                         filter_x, in_channel)];
-                  output_data[Offset(output_shape, batch, out_y, out_x,
-                                     out_channel)] +=
-                      input_value * filter_value;
-                }
-              }
+              const int out_x = out_x_origin + filter_x;
+              // We cannot accumulate out of bounds
+              if (out_x < 0 || out_x >= output_width) continue;
+              AccumulateVector(taps + filter_x * output_depth, output_depth,
+                               out_row + out_x * output_depth);
             }
           }
         }
       }
-    }
+    });
   }
-  // End of MediaPipe modification.
-  // End of copy.
 }
 
 // Start of copy from
@@ -177,6 +246,40 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
       stride_width * (in_width - 1) + filter_width - padding_size.width;
   TF_LITE_ENSURE_OK(context,
                     context->ResizeTensor(context, output, output_shape_array));
+
+  // Scratch tensors for the GEMM based kernel.
+  auto* data = reinterpret_cast<OpData*>(node->user_data);
+  TfLiteIntArrayFree(node->temporaries);
+  node->temporaries = TfLiteIntArrayCreate(2);
+  node->temporaries->data[kCol2ImTemporary] = data->col2im_id;
+  node->temporaries->data[kTransposedWeightsTemporary] = data->col2im_id + 1;
+
+  TfLiteTensor* col2im =
+      ::tflite::GetTemporary(context, node, kCol2ImTemporary);
+  col2im->type = kTfLiteFloat32;
+  col2im->allocation_type = kTfLiteArenaRw;
+  TfLiteIntArray* col2im_shape_array = TfLiteIntArrayCreate(2);
+  col2im_shape_array->data[0] = in_height * in_width;
+  col2im_shape_array->data[1] =
+      filter_height * filter_width * ::tflite::SizeOfDimension(weights, 0);
+  TF_LITE_ENSURE_OK(
+      context, context->ResizeTensor(context, col2im, col2im_shape_array));
+
+  TfLiteTensor* transposed_weights =
+      ::tflite::GetTemporary(context, node, kTransposedWeightsTemporary);
+  transposed_weights->type = kTfLiteFloat32;
+  transposed_weights->allocation_type = kTfLiteArenaRwPersistent;
+  TfLiteIntArray* transposed_weights_shape_array = TfLiteIntArrayCreate(4);
+  transposed_weights_shape_array->data[0] = filter_height;
+  transposed_weights_shape_array->data[1] = filter_width;
+  transposed_weights_shape_array->data[2] =
+      ::tflite::SizeOfDimension(weights, 0);
+  transposed_weights_shape_array->data[3] =
+      ::tflite::SizeOfDimension(weights, 3);
+  TF_LITE_ENSURE_OK(context,
+                    context->ResizeTensor(context, transposed_weights,
+                                          transposed_weights_shape_array));
+  data->weights_are_transposed = false;
   return kTfLiteOk;
   // End of MediaPipe modification.
 }
@@ -219,21 +322,24 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       op_params.stride_width = stride_width;
       op_params.stride_height = stride_height;
 
-      TransposeConvBias(
-          op_params, ::tflite::GetTensorShape(input),
-          ::tflite::GetTensorData<float>(input),
-          ::tflite::GetTensorShape(weights),
-          ::tflite::GetTensorData<float>(weights),
-          ::tflite::GetTensorShape(bias), ::tflite::GetTensorData<float>(bias),
-          ::tflite::GetTensorShape(output),
-          ::tflite::GetTensorData<float>(output),
-          // Last two args specify im2col which reference_ops ignores.
-          // (Note this does not lead to a performance regression, as the
-          // previous optimized version was just a copy of the reference code.)
-          // TODO: Allocate im2col tensors and switch to
-          // optimized_ops.
-          ::tflite::GetTensorShape(output),
-          ::tflite::GetTensorData<float>(output));
+      auto* data = reinterpret_cast<OpData*>(node->user_data);
+      TfLiteTensor* col2im =
+          ::tflite::GetTemporary(context, node, kCol2ImTemporary);
+      TfLiteTensor* transposed_weights =
+          ::tflite::GetTemporary(context, node, kTransposedWeightsTemporary);
+      if (!data->weights_are_transposed) {
+        TransposeWeights(weights, transposed_weights);
+        data->weights_are_transposed = ::tflite::IsConstantTensor(weights);
+      }
+
+      TransposeConvBias(context, op_params, ::tflite::GetTensorShape(input),
+                        ::tflite::GetTensorData<float>(input),
+                        ::tflite::GetTensorShape(transposed_weights),
+                        ::tflite::GetTensorData<float>(transposed_weights),
+                        ::tflite::GetTensorData<float>(bias),
+                        ::tflite::GetTensorShape(output),
+                        ::tflite::GetTensorData<float>(output),
+                        ::tflite::GetTensorData<float>(col2im));
       break;
     }
     default:
@@ -251,7 +357,16 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 }  // namespace
 
 TfLiteRegistration* RegisterConvolution2DTransposeBias() {
-  static TfLiteRegistration reg = {nullptr, nullptr, Prepare, Eval};
+  static TfLiteRegistration reg = {
+      [](TfLiteContext* context, const char*, size_t) -> void* {
+        auto* data = new OpData();
+        context->AddTensors(context, 2, &data->col2im_id);
+        return data;
+      },
+      [](TfLiteContext*, void* buffer) -> void {
+        delete reinterpret_cast<OpData*>(buffer);
+      },
+      Prepare, Eval};
   return &reg;
 }
 
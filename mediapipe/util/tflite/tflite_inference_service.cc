@@ -0,0 +1,211 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/tflite/tflite_inference_service.h"
+
+#include <cstring>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/time/clock.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/util/tflite/tflite_model_cache.h"
+#include "tensorflow/lite/kernels/register.h"
+
+namespace mediapipe {
+
+const GraphService<TfLiteInferenceService> kTfLiteInferenceService(
+    "kTfLiteInferenceService");
+
+void TfLiteInferenceResult::SetTensor(int index, const TfLiteTensor& tensor,
+                                      const char* data, size_t bytes,
+                                      const TfLiteIntArray* dims) {
+  if (index >= tensors_.size()) {
+    tensors_.resize(index + 1);
+    data_.resize(index + 1);
+    dims_.resize(index + 1);
+  }
+  data_[index].assign(data, data + bytes);
+  dims_[index].reset(TfLiteIntArrayCopy(dims));
+  TfLiteTensor& copy = tensors_[index];
+  copy = tensor;
+  copy.data.raw = data_[index].data();
+  copy.bytes = bytes;
+  copy.dims = dims_[index].get();
+  copy.allocation_type = kTfLiteCustom;
+}
+
+TfLiteInferenceService::TfLiteInferenceService(const Options& options)
+    : options_(options) {
+  CHECK_GE(options_.max_batch_size, 1);
+}
+
+::mediapipe::Status TfLiteInferenceService::Run(
+    const std::string& model_path, const std::vector<TfLiteTensor>& inputs,
+    TfLiteInferenceResult* result) {
+  ASSIGN_OR_RETURN(Model * model, GetModel(model_path));
+
+  // The interpreter tensors keep their shapes once loaded.
+  const auto& input_indexes = model->interpreter->inputs();
+  RET_CHECK_EQ(inputs.size(), input_indexes.size());
+  for (int i = 0; i < inputs.size(); ++i) {
+    const TfLiteTensor* local_tensor =
+        model->interpreter->tensor(input_indexes[i]);
+    RET_CHECK(inputs[i].data.raw);
+    RET_CHECK_EQ(inputs[i].type, local_tensor->type);
+    RET_CHECK_EQ(inputs[i].bytes,
+                 local_tensor->bytes / options_.max_batch_size);
+  }
+
+  Request request;
+  request.inputs = &inputs;
+  request.result = result;
+  const absl::Time deadline = absl::Now() + options_.batch_timeout;
+  const int max_batch_size = options_.max_batch_size;
+
+  absl::MutexLock lock(&model->mutex);
+  model->pending.push_back(&request);
+  // The request is done, or this request may run a full batch.
+  auto batch_full = [model, &request, max_batch_size]() {
+    return request.done ||
+           (!model->running && model->pending.size() >= max_batch_size);
+  };
+  // The request is done, or no batch is running.
+  auto batch_done = [model, &request]() {
+    return request.done || !model->running;
+  };
+  while (!request.done) {
+    model->mutex.AwaitWithDeadline(absl::Condition(&batch_full), deadline);
+    if (request.done) {
+      break;
+    }
+    if (model->running) {
+      model->mutex.Await(absl::Condition(&batch_done));
+      continue;
+    }
+    // This request runs the batch once the batch is full or the request has
+    // waited long enough, whichever requests it ends up holding.
+    if (model->pending.size() >= max_batch_size || absl::Now() >= deadline) {
+      RunBatch(model);
+    }
+  }
+  return request.status;
+}
+
+int TfLiteInferenceService::NumModels() {
+  absl::MutexLock lock(&mutex_);
+  return models_.size();
+}
+
+::mediapipe::StatusOr<TfLiteInferenceService::Model*>
+TfLiteInferenceService::GetModel(const std::string& model_path) {
+  absl::MutexLock lock(&mutex_);
+  auto iter = models_.find(model_path);
+  if (iter != models_.end()) {
+    return iter->second.get();
+  }
+  auto model = absl::make_unique<Model>();
+  MP_RETURN_IF_ERROR(LoadModel(model_path, model.get()));
+  Model* model_ptr = model.get();
+  models_[model_path] = std::move(model);
+  return model_ptr;
+}
+
+::mediapipe::Status TfLiteInferenceService::LoadModel(
+    const std::string& model_path, Model* model) {
+  ASSIGN_OR_RETURN(model->flatbuffer,
+                   TfLiteModelCache::GetInstance()->GetModel(model_path));
+  tflite::ops::builtin::BuiltinOpResolver op_resolver;
+  tflite::InterpreterBuilder(*model->flatbuffer, op_resolver)(
+      &model->interpreter);
+  RET_CHECK(model->interpreter);
+  tflite::Interpreter* interpreter = model->interpreter.get();
+  interpreter->SetNumThreads(options_.num_threads);
+
+  const int batch_size = options_.max_batch_size;
+  if (batch_size > 1) {
+    for (int index : interpreter->inputs()) {
+      const TfLiteIntArray* dims = interpreter->tensor(index)->dims;
+      RET_CHECK_GT(dims->size, 0) << "Batching needs non-scalar model inputs.";
+      std::vector<int> batch_dims(dims->data, dims->data + dims->size);
+      batch_dims[0] *= batch_size;
+      RET_CHECK_EQ(interpreter->ResizeInputTensor(index, batch_dims),
+                   kTfLiteOk);
+    }
+  }
+  RET_CHECK_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+  for (int index : interpreter->outputs()) {
+    const TfLiteIntArray* dims = interpreter->tensor(index)->dims;
+    RET_CHECK(dims->size > 0 && dims->data[0] % batch_size == 0)
+        << "Model outputs must be batched along their first dimension.";
+    model->output_dims.emplace_back(TfLiteIntArrayCopy(dims));
+    model->output_dims.back()->data[0] /= batch_size;
+  }
+  return ::mediapipe::OkStatus();
+}
+
+void TfLiteInferenceService::RunBatch(Model* model) {
+  std::vector<Request*> batch;
+  while (!model->pending.empty() && batch.size() < options_.max_batch_size) {
+    batch.push_back(model->pending.front());
+    model->pending.pop_front();
+  }
+  model->running = true;
+  // Let other requests queue up while the interpreter runs.
+  model->mutex.Unlock();
+  ::mediapipe::Status status = InvokeBatch(model, batch);
+  model->mutex.Lock();
+  for (Request* request : batch) {
+    request->status = status;
+    request->done = true;
+  }
+  model->running = false;
+}
+
+::mediapipe::Status TfLiteInferenceService::InvokeBatch(
+    Model* model, const std::vector<Request*>& batch) {
+  tflite::Interpreter* interpreter = model->interpreter.get();
+  const int batch_size = options_.max_batch_size;
+
+  // Copy the inputs of each request into its slice of the batch.  The slices
+  // of a partial batch past its last request keep stale data, and their
+  // outputs are dropped.
+  const auto& input_indexes = interpreter->inputs();
+  for (int j = 0; j < batch.size(); ++j) {
+    const std::vector<TfLiteTensor>& inputs = *batch[j]->inputs;
+    for (int i = 0; i < inputs.size(); ++i) {
+      TfLiteTensor* local_tensor = interpreter->tensor(input_indexes[i]);
+      const size_t slice_bytes = local_tensor->bytes / batch_size;
+      std::memcpy(local_tensor->data.raw + j * slice_bytes, inputs[i].data.raw,
+                  slice_bytes);
+    }
+  }
+
+  RET_CHECK_EQ(interpreter->Invoke(), kTfLiteOk);
+
+  const auto& output_indexes = interpreter->outputs();
+  for (int j = 0; j < batch.size(); ++j) {
+    for (int i = 0; i < output_indexes.size(); ++i) {
+      const TfLiteTensor* tensor = interpreter->tensor(output_indexes[i]);
+      const size_t slice_bytes = tensor->bytes / batch_size;
+      batch[j]->result->SetTensor(i, *tensor,
+                                  tensor->data.raw + j * slice_bytes,
+                                  slice_bytes, model->output_dims[i].get());
+    }
+  }
+  return ::mediapipe::OkStatus();
+}
+
+}  // namespace mediapipe
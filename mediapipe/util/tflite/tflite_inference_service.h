@@ -0,0 +1,153 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_UTIL_TFLITE_TFLITE_INFERENCE_SERVICE_H_
+#define MEDIAPIPE_UTIL_TFLITE_TFLITE_INFERENCE_SERVICE_H_
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/graph_service.h"
+#include "mediapipe/framework/port/status.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/model.h"
+
+namespace mediapipe {
+
+// Holds copies of the output tensors of one TfLiteInferenceService request.
+// The tensors point into memory owned by the result, and stay valid until the
+// result is filled by another request.
+class TfLiteInferenceResult {
+ public:
+  TfLiteInferenceResult() = default;
+  TfLiteInferenceResult(const TfLiteInferenceResult&) = delete;
+  TfLiteInferenceResult& operator=(const TfLiteInferenceResult&) = delete;
+
+  const std::vector<TfLiteTensor>& tensors() const { return tensors_; }
+
+ private:
+  friend class TfLiteInferenceService;
+
+  struct DimsDeleter {
+    void operator()(TfLiteIntArray* dims) const { TfLiteIntArrayFree(dims); }
+  };
+
+  // Copies "bytes" bytes of "data" as the tensor at "index", described by
+  // "tensor" and "dims".
+  void SetTensor(int index, const TfLiteTensor& tensor, const char* data,
+                 size_t bytes, const TfLiteIntArray* dims);
+
+  std::vector<TfLiteTensor> tensors_;
+  std::vector<std::vector<char>> data_;
+  std::vector<std::unique_ptr<TfLiteIntArray, DimsDeleter>> dims_;
+};
+
+// Runs TF Lite models on behalf of several calculators, possibly in several
+// graphs, holding a single copy of each model and batching the requests that
+// arrive together.
+//
+// Each model is loaded on first use and kept until the service is destroyed.
+// Its interpreter runs max_batch_size requests per Invoke(): the first
+// dimension of every model input and output is scaled by max_batch_size, and
+// each request fills one slice of it.  A request waits up to batch_timeout for
+// others to fill its batch, then runs with those that have arrived.
+//
+// To share the service, the application creates one and passes it to each
+// graph with CalculatorGraph::SetServiceObject(kTfLiteInferenceService, ...)
+// before starting it.  TfLiteInferenceCalculator uses it when its
+// use_inference_service option is set.
+class TfLiteInferenceService {
+ public:
+  struct Options {
+    // The most requests run together in one inference.
+    int max_batch_size = 1;
+    // The longest a request waits for its batch to fill.
+    absl::Duration batch_timeout = absl::Milliseconds(5);
+    // The number of threads of each interpreter, or -1 for the TF Lite
+    // default.
+    int num_threads = -1;
+  };
+
+  TfLiteInferenceService() : TfLiteInferenceService(Options()) {}
+  explicit TfLiteInferenceService(const Options& options);
+  TfLiteInferenceService(const TfLiteInferenceService&) = delete;
+  TfLiteInferenceService& operator=(const TfLiteInferenceService&) = delete;
+
+  // Runs the model at "model_path" on "inputs" and stores its outputs in
+  // "result".  Blocks until the batch holding the request has run.  The
+  // inputs must match the model inputs of a single batch element.  Thread
+  // safe.
+  ::mediapipe::Status Run(const std::string& model_path,
+                          const std::vector<TfLiteTensor>& inputs,
+                          TfLiteInferenceResult* result);
+
+  // Returns the number of models loaded.
+  int NumModels();
+
+ private:
+  // A request waiting in the queue of a model.
+  struct Request {
+    const std::vector<TfLiteTensor>* inputs;
+    TfLiteInferenceResult* result;
+    bool done = false;
+    ::mediapipe::Status status;
+  };
+
+  // A loaded model and the requests waiting for it.
+  struct Model {
+    // Shared with the other users of the model through TfLiteModelCache.
+    std::shared_ptr<tflite::FlatBufferModel> flatbuffer;
+    std::unique_ptr<tflite::Interpreter> interpreter;
+    // The dimensions of one batch element of each output.
+    std::vector<std::unique_ptr<TfLiteIntArray,
+                                TfLiteInferenceResult::DimsDeleter>>
+        output_dims;
+
+    absl::Mutex mutex;
+    std::deque<Request*> pending GUARDED_BY(mutex);
+    // Whether a batch is being run.
+    bool running GUARDED_BY(mutex) = false;
+  };
+
+  // Returns the model at "model_path", loading it if needed.
+  ::mediapipe::StatusOr<Model*> GetModel(const std::string& model_path);
+  ::mediapipe::Status LoadModel(const std::string& model_path, Model* model);
+
+  // Runs the oldest pending requests of "model" as one batch.  The mutex of
+  // "model" is released while the interpreter runs.
+  void RunBatch(Model* model) EXCLUSIVE_LOCKS_REQUIRED(model->mutex);
+  // Runs a batch of requests without holding the mutex of "model".
+  ::mediapipe::Status InvokeBatch(Model* model,
+                                  const std::vector<Request*>& batch);
+
+  const Options options_;
+
+  absl::Mutex mutex_;
+  std::map<std::string, std::unique_ptr<Model>> models_ GUARDED_BY(mutex_);
+};
+
+// Provides a TfLiteInferenceService to the calculators of a graph.  The
+// service is supplied by the application with
+// CalculatorGraph::SetServiceObject().
+extern const GraphService<TfLiteInferenceService> kTfLiteInferenceService;
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_TFLITE_TFLITE_INFERENCE_SERVICE_H_
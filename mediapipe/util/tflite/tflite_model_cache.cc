@@ -0,0 +1,66 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/tflite/tflite_model_cache.h"
+
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/util/resource_util.h"
+
+namespace mediapipe {
+
+namespace {
+
+// A model built on the mapped contents of its resource, which must outlive it.
+struct MappedModel {
+  std::unique_ptr<ResourceMapping> mapping;
+  std::unique_ptr<tflite::FlatBufferModel> model;
+};
+
+}  // namespace
+
+TfLiteModelCache* TfLiteModelCache::GetInstance() {
+  static TfLiteModelCache* cache = new TfLiteModelCache();
+  return cache;
+}
+
+::mediapipe::StatusOr<std::shared_ptr<tflite::FlatBufferModel>>
+TfLiteModelCache::GetModel(const std::string& model_path) {
+  absl::MutexLock lock(&mutex_);
+  // Drops the entries of released models, so that the map does not grow with
+  // every model ever loaded.
+  for (auto it = models_.begin(); it != models_.end();) {
+    if (it->second.expired()) {
+      it = models_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  std::shared_ptr<tflite::FlatBufferModel> model = models_[model_path].lock();
+  if (model) {
+    return model;
+  }
+  // Mapping the file is cheap, so it is done under the lock, which also keeps
+  // concurrent callers from loading the same model twice.
+  auto mapped = std::make_shared<MappedModel>();
+  ASSIGN_OR_RETURN(mapped->mapping, GetResourceMapping(model_path));
+  mapped->model = tflite::FlatBufferModel::BuildFromBuffer(
+      mapped->mapping->data(), mapped->mapping->size());
+  RET_CHECK(mapped->model) << "Failed to load model " << model_path;
+  model = std::shared_ptr<tflite::FlatBufferModel>(mapped, mapped->model.get());
+  models_[model_path] = model;
+  return model;
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,55 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_UTIL_TFLITE_TFLITE_MODEL_CACHE_H_
+#define MEDIAPIPE_UTIL_TFLITE_TFLITE_MODEL_CACHE_H_
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "tensorflow/lite/model.h"
+
+namespace mediapipe {
+
+// A process-wide cache of the TF Lite models loaded from resources, which lets
+// the interpreters of every node and graph running a model share one mapping
+// of its resource instead of each mapping and verifying it again.
+//
+// The cache only holds weak references: a model is unmapped as soon as the
+// last interpreter using it is destroyed, and is loaded again by the next
+// caller asking for it.
+class TfLiteModelCache {
+ public:
+  // Returns the process-wide cache.
+  static TfLiteModelCache* GetInstance();
+
+  // Returns the model loaded from the resource at "model_path", mapping it
+  // with GetResourceMapping if no caller holds it anymore. The returned model
+  // must outlive the interpreters built from it.
+  ::mediapipe::StatusOr<std::shared_ptr<tflite::FlatBufferModel>> GetModel(
+      const std::string& model_path) LOCKS_EXCLUDED(mutex_);
+
+ private:
+  absl::Mutex mutex_;
+  std::map<std::string, std::weak_ptr<tflite::FlatBufferModel>> models_
+      GUARDED_BY(mutex_);
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_TFLITE_TFLITE_MODEL_CACHE_H_
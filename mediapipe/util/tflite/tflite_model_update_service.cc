@@ -0,0 +1,36 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/tflite/tflite_model_update_service.h"
+
+namespace mediapipe {
+
+const GraphService<TfLiteModelUpdateService> kTfLiteModelUpdateService(
+    "kTfLiteModelUpdateService");
+
+void TfLiteModelUpdateService::UpdateModel(const std::string& model_path,
+                                           const std::string& new_model_path) {
+  absl::MutexLock lock(&mutex_);
+  model_paths_[model_path] = new_model_path;
+  generation_.fetch_add(1, std::memory_order_release);
+}
+
+std::string TfLiteModelUpdateService::GetModelPath(
+    const std::string& model_path) const {
+  absl::MutexLock lock(&mutex_);
+  auto iter = model_paths_.find(model_path);
+  return iter == model_paths_.end() ? model_path : iter->second;
+}
+
+}  // namespace mediapipe
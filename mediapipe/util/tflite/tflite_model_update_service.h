@@ -0,0 +1,69 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_UTIL_TFLITE_TFLITE_MODEL_UPDATE_SERVICE_H_
+#define MEDIAPIPE_UTIL_TFLITE_TFLITE_MODEL_UPDATE_SERVICE_H_
+
+#include <atomic>
+#include <map>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/graph_service.h"
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+
+// Lets the application replace the models that TfLiteInferenceCalculator
+// nodes run while their graphs keep running, such as to roll out a new
+// version of a model without restarting the graphs.
+//
+// The application creates one and passes it to each graph with
+// CalculatorGraph::SetServiceObject(kTfLiteModelUpdateService, ...) before
+// starting it. The nodes with allow_model_updates set check the service for
+// updates as their inputs arrive. A node seeing an update for its model_path
+// loads the new model and builds its interpreters on a background thread,
+// while it keeps running the old model, and switches to the new model
+// between two timestamps once they are ready.
+class TfLiteModelUpdateService {
+ public:
+  // Makes the nodes configured with "model_path" run the model at
+  // "new_model_path" from now on. Updating a model to its own model_path
+  // restores it.
+  void UpdateModel(const std::string& model_path,
+                   const std::string& new_model_path) LOCKS_EXCLUDED(mutex_);
+
+  // Returns the path of the model that the nodes configured with
+  // "model_path" should run.
+  std::string GetModelPath(const std::string& model_path) const
+      LOCKS_EXCLUDED(mutex_);
+
+  // Returns a number that changes with every UpdateModel(), so that a node
+  // can check for updates without locking.
+  int64 generation() const {
+    return generation_.load(std::memory_order_acquire);
+  }
+
+ private:
+  mutable absl::Mutex mutex_;
+  std::map<std::string, std::string> model_paths_ GUARDED_BY(mutex_);
+  std::atomic<int64> generation_{0};
+};
+
+extern const GraphService<TfLiteModelUpdateService> kTfLiteModelUpdateService;
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_TFLITE_TFLITE_MODEL_UPDATE_SERVICE_H_